@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) 2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#pragma once
+
+#include <AK/Assertions.h>
+#include <AK/Noncopyable.h>
+#include <AK/StdLibExtras.h>
+#include <AK/Types.h>
+#include <AK/kmalloc.h>
+
+namespace AK {
+
+// A bump allocator: memory is handed out from large chunks and is only given back when the
+// arena itself is cleared or destroyed. Objects created with make() have their destructors
+// run at that point, in reverse order of creation.
+class Arena {
+    AK_MAKE_NONCOPYABLE(Arena);
+    AK_MAKE_NONMOVABLE(Arena);
+
+public:
+    static constexpr size_t default_chunk_size = 64 * 1024;
+    static constexpr size_t default_alignment = 8;
+
+    explicit Arena(size_t chunk_size = default_chunk_size)
+        : m_chunk_size(chunk_size)
+    {
+    }
+
+    ~Arena() { clear(); }
+
+    void* allocate(size_t size, size_t alignment = default_alignment)
+    {
+        ASSERT(alignment && !(alignment & (alignment - 1)));
+        FlatPtr address = ((FlatPtr)m_next + alignment - 1) & ~(FlatPtr)(alignment - 1);
+        if (!m_next || address > (FlatPtr)m_end || size > (FlatPtr)m_end - address)
+            return allocate_from_new_chunk(size, alignment);
+        m_next = (u8*)(address + size);
+        m_bytes_allocated += size;
+        return (void*)address;
+    }
+
+    template<typename T, typename... Args>
+    T& make(Args&&... args)
+    {
+        auto* object = new (allocate(sizeof(T), alignof(T))) T(forward<Args>(args)...);
+        if constexpr (!__has_trivial_destructor(T)) {
+            auto& destructor = *new (allocate(sizeof(Destructor), alignof(Destructor))) Destructor;
+            destructor.destroy = [](void* object) { static_cast<T*>(object)->~T(); };
+            destructor.object = object;
+            destructor.next = m_destructors;
+            m_destructors = &destructor;
+        }
+        return *object;
+    }
+
+    // Runs the destructors of the objects created with make() and frees all chunks.
+    void clear()
+    {
+        for (auto* destructor = m_destructors; destructor; destructor = destructor->next)
+            destructor->destroy(destructor->object);
+        m_destructors = nullptr;
+
+        while (m_chunks) {
+            auto* previous = m_chunks->previous;
+            kfree(m_chunks);
+            m_chunks = previous;
+        }
+        m_next = nullptr;
+        m_end = nullptr;
+        m_chunk_count = 0;
+        m_bytes_allocated = 0;
+    }
+
+    size_t chunk_count() const { return m_chunk_count; }
+    size_t bytes_allocated() const { return m_bytes_allocated; }
+
+private:
+    struct Chunk {
+        Chunk* previous;
+        size_t size;
+    };
+
+    struct Destructor {
+        void (*destroy)(void*);
+        void* object;
+        Destructor* next;
+    };
+
+    void* allocate_from_new_chunk(size_t size, size_t alignment)
+    {
+        size_t header_size = align_up_to(sizeof(Chunk), default_alignment);
+        size_t needed_size = header_size + size + alignment;
+        // Allocations that would waste a big part of a chunk get one of their own,
+        // and allocation from the current chunk carries on afterwards.
+        bool is_oversized = size > m_chunk_size / 4;
+        size_t chunk_size = is_oversized ? needed_size : max(m_chunk_size, needed_size);
+
+        auto* chunk = (Chunk*)kmalloc(chunk_size);
+        chunk->size = chunk_size;
+        ++m_chunk_count;
+        m_bytes_allocated += size;
+
+        u8* data = (u8*)chunk + header_size;
+        FlatPtr address = ((FlatPtr)data + alignment - 1) & ~(FlatPtr)(alignment - 1);
+        if (is_oversized && m_chunks) {
+            // Keep the current chunk at the head of the list, so it stays the one we bump from.
+            chunk->previous = m_chunks->previous;
+            m_chunks->previous = chunk;
+            return (void*)address;
+        }
+
+        chunk->previous = m_chunks;
+        m_chunks = chunk;
+        m_next = (u8*)(address + size);
+        m_end = (u8*)chunk + chunk_size;
+        return (void*)address;
+    }
+
+    size_t m_chunk_size { default_chunk_size };
+    Chunk* m_chunks { nullptr };
+    u8* m_next { nullptr };
+    u8* m_end { nullptr };
+    Destructor* m_destructors { nullptr };
+    size_t m_chunk_count { 0 };
+    size_t m_bytes_allocated { 0 };
+};
+
+}
+
+using AK::Arena;
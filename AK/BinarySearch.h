@@ -62,6 +62,24 @@ T* binary_search(T* haystack, size_t haystack_size, const T& needle, Compare com
     return nullptr;
 }
 
+// Returns the index of the first element in the sorted haystack that the needle comes before, or haystack_size
+// if there is none. The element before that index is then the last one that's not after the needle.
+template<typename T, typename Needle, typename IsBefore>
+size_t upper_bound(const T* haystack, size_t haystack_size, const Needle& needle, IsBefore is_before)
+{
+    size_t low = 0;
+    size_t high = haystack_size;
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        if (is_before(needle, haystack[middle]))
+            high = middle;
+        else
+            low = middle + 1;
+    }
+    return low;
+}
+
 }
 
 using AK::binary_search;
+using AK::upper_bound;
@@ -411,6 +411,8 @@ public:
         return m_offset == m_buffer.size();
     }
 
+    size_t remaining() const { return m_buffer.size() - m_offset; }
+
     void fill_to_end(u8 ch)
     {
         while (!at_end())
@@ -101,6 +101,7 @@ private:
 
     u8* m_data { nullptr };
     size_t m_size { 0 };
+    size_t m_capacity { 0 };
     bool m_owned { false };
 };
 
@@ -237,6 +238,7 @@ private:
 
 inline ByteBufferImpl::ByteBufferImpl(size_t size)
     : m_size(size)
+    , m_capacity(size)
 {
     m_data = static_cast<u8*>(kmalloc(size));
     m_owned = true;
@@ -244,6 +246,7 @@ inline ByteBufferImpl::ByteBufferImpl(size_t size)
 
 inline ByteBufferImpl::ByteBufferImpl(const void* data, size_t size, ConstructionMode mode)
     : m_size(size)
+    , m_capacity(size)
 {
     ASSERT(mode == Copy);
     m_data = static_cast<u8*>(kmalloc(size));
@@ -254,6 +257,7 @@ inline ByteBufferImpl::ByteBufferImpl(const void* data, size_t size, Constructio
 inline ByteBufferImpl::ByteBufferImpl(void* data, size_t size, ConstructionMode mode)
     : m_data(static_cast<u8*>(data))
     , m_size(size)
+    , m_capacity(size)
 {
     if (mode == Adopt) {
         m_owned = true;
@@ -266,12 +270,12 @@ inline void ByteBufferImpl::grow(size_t size)
 {
     ASSERT(size > m_size);
     ASSERT(m_owned);
-    u8* new_data = static_cast<u8*>(kmalloc(size));
-    __builtin_memcpy(new_data, m_data, m_size);
-    u8* old_data = m_data;
-    m_data = new_data;
+    if (size > m_capacity) {
+        // Grow geometrically, so that a series of appends doesn't copy the whole buffer every time.
+        m_capacity = max(size, m_capacity + m_capacity / 2);
+        m_data = static_cast<u8*>(krealloc(m_data, m_capacity));
+    }
     m_size = size;
-    kfree(old_data);
 }
 
 inline NonnullRefPtr<ByteBufferImpl> ByteBufferImpl::create_uninitialized(size_t size)
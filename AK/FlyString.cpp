@@ -24,6 +24,7 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <AK/Atomic.h>
 #include <AK/FlyString.h>
 #include <AK/HashTable.h>
 #include <AK/String.h>
@@ -46,17 +47,108 @@ struct FlyStringImplTraits : public AK::Traits<StringImpl*> {
     }
 };
 
-static HashTable<StringImpl*, FlyStringImplTraits>& fly_impls()
+// The intern table is split into stripes by hash, each with its own tiny spinlock, so that
+// threads interning different strings rarely wait on each other. Critical sections are a
+// single hash table operation, which is too short to be worth sleeping for.
+class FlyImplStripe {
+public:
+    void lock()
+    {
+        while (m_locked.exchange(true, AK::memory_order_acquire)) {
+            while (m_locked.load(AK::memory_order_relaxed))
+                ;
+        }
+    }
+    void unlock() { m_locked.store(false, AK::memory_order_release); }
+
+    HashTable<StringImpl*, FlyStringImplTraits>& impls() { return m_impls; }
+
+private:
+    Atomic<bool> m_locked { false };
+    HashTable<StringImpl*, FlyStringImplTraits> m_impls;
+};
+
+static constexpr size_t fly_impl_stripe_count = 16;
+
+static Atomic<FlyImplStripe*> s_fly_impl_stripes;
+static Atomic<size_t> s_intern_lookups;
+static Atomic<size_t> s_intern_hits;
+
+static FlyImplStripe& fly_impl_stripe(unsigned hash)
 {
-    static HashTable<StringImpl*, FlyStringImplTraits>* table;
-    if (!table)
-        table = new HashTable<StringImpl*, FlyStringImplTraits>;
-    return *table;
+    auto* stripes = s_fly_impl_stripes.load(AK::memory_order_acquire);
+    if (!stripes) {
+        auto* new_stripes = new FlyImplStripe[fly_impl_stripe_count];
+        if (s_fly_impl_stripes.compare_exchange_strong(stripes, new_stripes, AK::memory_order_acq_rel))
+            stripes = new_stripes;
+        else
+            delete[] new_stripes;
+    }
+    // The table itself indexes by the low bits, so pick the stripe from the high ones.
+    return stripes[(hash >> 28) % fly_impl_stripe_count];
 }
 
 void FlyString::did_destroy_impl(Badge<StringImpl>, StringImpl& impl)
 {
-    fly_impls().remove(&impl);
+    auto& stripe = fly_impl_stripe(impl.hash());
+    stripe.lock();
+    // If another thread saw this impl dying and already interned a replacement, leave that one alone.
+    auto it = stripe.impls().find(&impl);
+    if (it != stripe.impls().end() && *it == &impl)
+        stripe.impls().remove(it);
+    stripe.unlock();
+}
+
+NonnullRefPtr<StringImpl> FlyString::intern(const char* characters, size_t length, unsigned hash, StringImpl* candidate)
+{
+    // These are shared and already marked fly, so they never need to go in the table.
+    if (!length)
+        return StringImpl::the_empty_stringimpl();
+    if (length == 1)
+        return StringImpl::the_single_character_stringimpl(characters[0]);
+
+    s_intern_lookups.fetch_add(1, AK::memory_order_relaxed);
+    auto& stripe = fly_impl_stripe(hash);
+    stripe.lock();
+    auto it = stripe.impls().find(hash, [&](const StringImpl* impl) {
+        return impl->length() == length && !__builtin_memcmp(impl->characters(), characters, length);
+    });
+    if (it != stripe.impls().end()) {
+        if ((*it)->try_ref({})) {
+            auto* impl = *it;
+            stripe.unlock();
+            s_intern_hits.fetch_add(1, AK::memory_order_relaxed);
+            return adopt(*impl);
+        }
+        // Another thread just dropped the last reference and is about to remove it.
+        stripe.impls().remove(it);
+    }
+    RefPtr<StringImpl> impl = candidate;
+    if (!impl) {
+        char* buffer;
+        impl = StringImpl::create_uninitialized(length, buffer);
+        __builtin_memcpy(buffer, characters, length);
+    }
+    impl->set_fly({}, true);
+    stripe.impls().set(impl.ptr());
+    stripe.unlock();
+    return impl.release_nonnull();
+}
+
+FlyString::InternStatistics FlyString::intern_statistics()
+{
+    InternStatistics statistics;
+    statistics.lookups = s_intern_lookups.load(AK::memory_order_relaxed);
+    statistics.hits = s_intern_hits.load(AK::memory_order_relaxed);
+    if (!s_fly_impl_stripes.load(AK::memory_order_acquire))
+        return statistics;
+    for (size_t i = 0; i < fly_impl_stripe_count; ++i) {
+        auto& stripe = fly_impl_stripe(i << 28);
+        stripe.lock();
+        statistics.size += stripe.impls().size();
+        stripe.unlock();
+    }
+    return statistics;
 }
 
 FlyString::FlyString(const String& string)
@@ -67,25 +159,14 @@ FlyString::FlyString(const String& string)
         m_impl = string.impl();
         return;
     }
-    auto it = fly_impls().find(const_cast<StringImpl*>(string.impl()));
-    if (it == fly_impls().end()) {
-        fly_impls().set(const_cast<StringImpl*>(string.impl()));
-        string.impl()->set_fly({}, true);
-        m_impl = string.impl();
-    } else {
-        ASSERT((*it)->is_fly());
-        m_impl = *it;
-    }
+    m_impl = intern(string.characters(), string.length(), string.impl()->hash(), const_cast<StringImpl*>(string.impl()));
 }
 
 FlyString::FlyString(const StringView& string)
-    : FlyString(static_cast<String>(string))
-{
-}
-
-FlyString::FlyString(const char* string)
-    : FlyString(static_cast<String>(string))
 {
+    if (string.is_null())
+        return;
+    m_impl = intern(string.characters_without_null_termination(), string.length(), string_hash(string.characters_without_null_termination(), string.length()));
 }
 
 int FlyString::to_int(bool& ok) const
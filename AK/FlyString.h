@@ -43,7 +43,16 @@ public:
     }
     FlyString(const String&);
     FlyString(const StringView&);
-    FlyString(const char*);
+
+    // Inline so that for string literals, the length is folded to a constant and the hash
+    // is computed without a call; only the intern table probe remains out of line.
+    ALWAYS_INLINE FlyString(const char* string)
+    {
+        if (!string)
+            return;
+        size_t length = __builtin_strlen(string);
+        m_impl = intern(string, length, string_hash(string, length));
+    }
 
     FlyString& operator=(const FlyString& other)
     {
@@ -89,6 +98,13 @@ public:
 
     static void did_destroy_impl(Badge<StringImpl>, StringImpl&);
 
+    struct InternStatistics {
+        size_t size { 0 };
+        size_t lookups { 0 };
+        size_t hits { 0 };
+    };
+    static InternStatistics intern_statistics();
+
     template<typename T, typename... Rest>
     bool is_one_of(const T& string, Rest... rest) const
     {
@@ -97,13 +113,19 @@ public:
         return is_one_of(rest...);
     }
 
-
 private:
     bool is_one_of() const { return false; }
 
+    static NonnullRefPtr<StringImpl> intern(const char* characters, size_t length, unsigned hash, StringImpl* candidate = nullptr);
+
     RefPtr<StringImpl> m_impl;
 };
 
+template<>
+struct IsTriviallyRelocatable<FlyString> {
+    static constexpr bool value = true;
+};
+
 template<>
 struct Traits<FlyString> : public GenericTraits<FlyString> {
     static unsigned hash(const FlyString& s) { return s.hash(); }
@@ -28,32 +28,38 @@
 
 #include "Types.h"
 
-inline unsigned int_hash(u32 key)
+// All of these mix every input bit into every output bit, so keys that only differ in a few
+// bits (sequential integers, aligned pointers) still spread over both the low and high bits
+// of the hash. HashTable uses both: the low bits to tag slots and the high bits to pick groups.
+
+inline constexpr unsigned int_hash(u32 key)
 {
-    key += ~(key << 15);
-    key ^= (key >> 10);
-    key += (key << 3);
-    key ^= (key >> 6);
-    key += ~(key << 11);
-    key ^= (key >> 16);
+    key ^= key >> 16;
+    key *= 0x7feb352du;
+    key ^= key >> 15;
+    key *= 0x846ca68bu;
+    key ^= key >> 16;
     return key;
 }
 
-inline unsigned pair_int_hash(u32 key1, u32 key2)
+inline constexpr unsigned u64_hash(u64 key)
 {
-    return int_hash((int_hash(key1) * 209) ^ (int_hash(key2 * 413)));
+    key ^= key >> 30;
+    key *= 0xbf58476d1ce4e5b9ull;
+    key ^= key >> 27;
+    key *= 0x94d049bb133111ebull;
+    key ^= key >> 31;
+    return (u32)key ^ (u32)(key >> 32);
 }
 
-inline unsigned u64_hash(u64 key)
+inline constexpr unsigned pair_int_hash(u32 key1, u32 key2)
 {
-    u32 first = key & 0xFFFFFFFF;
-    u32 last = key >> 32;
-    return pair_int_hash(first, last);
+    return u64_hash(((u64)key1 << 32) | key2);
 }
 
-inline unsigned ptr_hash(FlatPtr ptr)
+inline constexpr unsigned ptr_hash(FlatPtr ptr)
 {
-    if constexpr(sizeof(ptr) == 8)
+    if constexpr (sizeof(ptr) == 8)
         return u64_hash((u64)ptr);
     else
         return int_hash((u32)ptr);
@@ -63,3 +69,55 @@ inline unsigned ptr_hash(const void* ptr)
 {
     return ptr_hash((FlatPtr)(ptr));
 }
+
+// Lowercases the ASCII letters in a word, eight bytes at a time.
+inline constexpr u64 fold_hash_word(u64 word)
+{
+    constexpr u64 high_bits = 0x8080808080808080ull;
+    u64 heptets = word & ~high_bits;
+    u64 above_z = heptets + 0x0101010101010101ull * (0x7f - 'Z');
+    u64 from_a = heptets + 0x0101010101010101ull * (0x80 - 'A');
+    u64 upper = (from_a ^ above_z) & ~word & high_bits;
+    return word | (upper >> 2);
+}
+
+// Reads count (at most 8) bytes as a little-endian word. Constant expressions can't reinterpret
+// memory, so they assemble the word byte by byte instead.
+inline constexpr u64 read_hash_word(const char* characters, size_t count)
+{
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    if (!__builtin_is_constant_evaluated() && count == 8) {
+        u64 word = 0;
+        __builtin_memcpy(&word, characters, 8);
+        return word;
+    }
+#endif
+    u64 word = 0;
+    for (size_t i = 0; i < count; ++i)
+        word |= (u64)(u8)characters[i] << (8 * i);
+    return word;
+}
+
+// Hashes eight bytes at a time, with a multiply and rotate per word and a full avalanche at the end.
+inline constexpr unsigned string_hash(const char* characters, size_t length, bool fold_case = false)
+{
+    constexpr u64 multiplier = 0x9e3779b97f4a7c15ull;
+    u64 hash = length * multiplier;
+    size_t i = 0;
+    auto mix_word = [&](u64 word) {
+        if (fold_case)
+            word = fold_hash_word(word);
+        hash ^= word * multiplier;
+        hash = ((hash << 29) | (hash >> 35)) * 0xc2b2ae3d27d4eb4full;
+    };
+    for (; i + 8 <= length; i += 8)
+        mix_word(read_hash_word(characters + i, 8));
+    if (i < length)
+        mix_word(read_hash_word(characters + i, length - i));
+    return u64_hash(hash);
+}
+
+inline constexpr unsigned case_insensitive_string_hash(const char* characters, size_t length)
+{
+    return string_hash(characters, length, true);
+}
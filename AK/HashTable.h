@@ -27,31 +27,41 @@
 #pragma once
 
 #include <AK/Assertions.h>
-#include <AK/SinglyLinkedList.h>
+#include <AK/IterationDecision.h>
 #include <AK/StdLibExtras.h>
 #include <AK/TemporaryChange.h>
 #include <AK/Traits.h>
+#include <AK/Types.h>
+#include <AK/kmalloc.h>
 
 namespace AK {
 
+/* HashTable is an open-addressing table in the style of Google's Swiss tables.
+ * Next to the element slots there is one metadata byte per slot: it is either
+ * empty, deleted (a tombstone), or holds the low 7 bits of the element's hash.
+ * Lookups probe groups of 8 metadata bytes at a time as a single u64, and only
+ * compare elements whose hash bits match, so a miss usually touches nothing but
+ * metadata. Groups are probed triangularly, which visits every group because
+ * the group count is a power of two.
+ *
+ * Removing an element only leaves a tombstone, so it never moves other
+ * elements and iterators to them stay valid. Inserting may rehash, which
+ * invalidates all iterators and references.
+ */
+
 template<typename T, typename>
 class HashTable;
 
-template<typename HashTableType, typename ElementType, typename BucketIteratorType>
+template<typename HashTableType, typename ElementType>
 class HashTableIterator {
 public:
     bool operator!=(const HashTableIterator& other) const
     {
-        if (m_is_end && other.m_is_end)
-            return false;
-        return &m_table != &other.m_table
-            || m_is_end != other.m_is_end
-            || m_bucket_index != other.m_bucket_index
-            || m_bucket_iterator != other.m_bucket_iterator;
+        return m_table != other.m_table || m_index != other.m_index;
     }
     bool operator==(const HashTableIterator& other) const { return !(*this != other); }
-    ElementType& operator*() { return *m_bucket_iterator; }
-    ElementType* operator->() { return m_bucket_iterator.operator->(); }
+    ElementType& operator*() { return m_table->slot(m_index); }
+    ElementType* operator->() { return &m_table->slot(m_index); }
     HashTableIterator& operator++()
     {
         skip_to_next();
@@ -60,50 +70,34 @@ public:
 
     void skip_to_next()
     {
-        while (!m_is_end) {
-            if (m_bucket_iterator.is_end()) {
-                ++m_bucket_index;
-                if (m_bucket_index >= m_table.capacity()) {
-                    m_is_end = true;
-                    return;
-                }
-                m_bucket_iterator = m_table.bucket(m_bucket_index).begin();
-            } else {
-                ++m_bucket_iterator;
-            }
-            if (!m_bucket_iterator.is_end())
-                return;
-        }
+        do {
+            ++m_index;
+        } while (m_index < m_table->capacity() && !m_table->is_used_slot(m_index));
     }
 
 private:
     friend HashTableType;
 
-    explicit HashTableIterator(HashTableType& table, bool is_end, BucketIteratorType bucket_iterator = {}, size_t bucket_index = 0)
-        : m_table(table)
-        , m_bucket_index(bucket_index)
-        , m_is_end(is_end)
-        , m_bucket_iterator(bucket_iterator)
+    explicit HashTableIterator(HashTableType& table, size_t index)
+        : m_table(&table)
+        , m_index(index)
     {
         ASSERT(!table.m_clearing);
         ASSERT(!table.m_rehashing);
-        if (!is_end && !m_table.is_empty() && m_bucket_iterator.is_end()) {
-            m_bucket_iterator = m_table.bucket(0).begin();
-            if (m_bucket_iterator.is_end())
-                skip_to_next();
-        }
+        if (m_index < m_table->capacity() && !m_table->is_used_slot(m_index))
+            skip_to_next();
     }
 
-    HashTableType& m_table;
-    size_t m_bucket_index { 0 };
-    bool m_is_end { false };
-    BucketIteratorType m_bucket_iterator;
+    HashTableType* m_table { nullptr };
+    size_t m_index { 0 };
 };
 
 template<typename T, typename TraitsForT>
 class HashTable {
 private:
-    using Bucket = SinglyLinkedList<T>;
+    static constexpr size_t group_size = 8;
+    static constexpr u8 empty_slot = 0x80;
+    static constexpr u8 deleted_slot = 0xfe;
 
 public:
     HashTable() {}
@@ -124,24 +118,32 @@ public:
         return *this;
     }
     HashTable(HashTable&& other)
-        : m_buckets(other.m_buckets)
+        : m_slots(other.m_slots)
+        , m_metadata(other.m_metadata)
         , m_size(other.m_size)
+        , m_deleted_count(other.m_deleted_count)
         , m_capacity(other.m_capacity)
     {
+        other.m_slots = nullptr;
+        other.m_metadata = nullptr;
         other.m_size = 0;
+        other.m_deleted_count = 0;
         other.m_capacity = 0;
-        other.m_buckets = nullptr;
     }
     HashTable& operator=(HashTable&& other)
     {
         if (this != &other) {
             clear();
-            m_buckets = other.m_buckets;
+            m_slots = other.m_slots;
+            m_metadata = other.m_metadata;
             m_size = other.m_size;
+            m_deleted_count = other.m_deleted_count;
             m_capacity = other.m_capacity;
+            other.m_slots = nullptr;
+            other.m_metadata = nullptr;
             other.m_size = 0;
+            other.m_deleted_count = 0;
             other.m_capacity = 0;
-            other.m_buckets = nullptr;
         }
         return *this;
     }
@@ -154,7 +156,8 @@ public:
     void ensure_capacity(size_t capacity)
     {
         ASSERT(capacity >= size());
-        rehash(capacity);
+        if (capacity > max_load_for(m_capacity) - m_deleted_count)
+            rehash(capacity_for(capacity));
     }
 
     void set(const T&);
@@ -162,40 +165,26 @@ public:
     bool contains(const T&) const;
     void clear();
 
-    using Iterator = HashTableIterator<HashTable, T, typename Bucket::Iterator>;
+    using Iterator = HashTableIterator<HashTable, T>;
     friend Iterator;
-    Iterator begin() { return Iterator(*this, is_empty()); }
-    Iterator end() { return Iterator(*this, true); }
+    Iterator begin() { return Iterator(*this, 0); }
+    Iterator end() { return Iterator(*this, m_capacity); }
 
-    using ConstIterator = HashTableIterator<const HashTable, const T, typename Bucket::ConstIterator>;
+    using ConstIterator = HashTableIterator<const HashTable, const T>;
     friend ConstIterator;
-    ConstIterator begin() const { return ConstIterator(*this, is_empty()); }
-    ConstIterator end() const { return ConstIterator(*this, true); }
+    ConstIterator begin() const { return ConstIterator(*this, 0); }
+    ConstIterator end() const { return ConstIterator(*this, m_capacity); }
 
     template<typename Finder>
     Iterator find(unsigned hash, Finder finder)
     {
-        if (is_empty())
-            return end();
-        size_t bucket_index;
-        auto& bucket = lookup_with_hash(hash, &bucket_index);
-        auto bucket_iterator = bucket.find(finder);
-        if (bucket_iterator != bucket.end())
-            return Iterator(*this, false, bucket_iterator, bucket_index);
-        return end();
+        return Iterator(*this, find_slot(hash, finder));
     }
 
     template<typename Finder>
     ConstIterator find(unsigned hash, Finder finder) const
     {
-        if (is_empty())
-            return end();
-        size_t bucket_index;
-        auto& bucket = lookup_with_hash(hash, &bucket_index);
-        auto bucket_iterator = bucket.find(finder);
-        if (bucket_iterator != bucket.end())
-            return ConstIterator(*this, false, bucket_iterator, bucket_index);
-        return end();
+        return ConstIterator(*this, find_slot(hash, finder));
     }
 
     Iterator find(const T& value)
@@ -218,165 +207,206 @@ public:
     void remove(Iterator);
 
 private:
-    Bucket& lookup(const T&, size_t* bucket_index = nullptr);
-    const Bucket& lookup(const T&, size_t* bucket_index = nullptr) const;
+    // Bit masks with the top bit set in every byte of a group that matches.
+    static u64 match_hash_bits(u64 group, u8 hash_bits)
+    {
+        u64 x = group ^ (0x0101010101010101ull * hash_bits);
+        // This can report a false positive next to a real match; find_slot() compares the elements anyway.
+        return (x - 0x0101010101010101ull) & ~x & 0x8080808080808080ull;
+    }
+    static u64 match_empty(u64 group) { return group & (~group << 6) & 0x8080808080808080ull; }
+    static u64 match_empty_or_deleted(u64 group) { return group & 0x8080808080808080ull; }
+    static size_t lowest_match(u64 mask) { return __builtin_ctzll(mask) / 8; }
 
-    Bucket& lookup_with_hash(unsigned hash, size_t* bucket_index)
+    static u8 hash_bits(unsigned hash) { return hash & 0x7f; }
+    static size_t max_load_for(size_t capacity) { return capacity - capacity / 8; }
+    static size_t capacity_for(size_t size)
     {
-        if (bucket_index)
-            *bucket_index = hash % m_capacity;
-        return m_buckets[hash % m_capacity];
+        size_t capacity = group_size;
+        while (max_load_for(capacity) < size)
+            capacity *= 2;
+        return capacity;
     }
 
-    const Bucket& lookup_with_hash(unsigned hash, size_t* bucket_index) const
+    bool is_used_slot(size_t index) const { return !(m_metadata[index] & 0x80); }
+    T& slot(size_t index) { return m_slots[index]; }
+    const T& slot(size_t index) const { return m_slots[index]; }
+
+    u64 group_at(size_t group_index) const
     {
-        if (bucket_index)
-            *bucket_index = hash % m_capacity;
-        return m_buckets[hash % m_capacity];
+        u64 group;
+        __builtin_memcpy(&group, m_metadata + group_index * group_size, sizeof(group));
+        return group;
     }
 
-    void rehash(size_t capacity);
-    void insert(const T&);
-    void insert(T&&);
+    template<typename Callback>
+    void for_each_probed_group(unsigned hash, Callback callback) const
+    {
+        size_t group_mask = m_capacity / group_size - 1;
+        size_t group_index = (hash >> 7) & group_mask;
+        for (size_t step = 1;; ++step) {
+            if (callback(group_index) == IterationDecision::Break)
+                return;
+            group_index = (group_index + step) & group_mask;
+        }
+    }
 
-    Bucket& bucket(size_t index) { return m_buckets[index]; }
-    const Bucket& bucket(size_t index) const { return m_buckets[index]; }
+    template<typename Finder>
+    size_t find_slot(unsigned hash, Finder& finder) const
+    {
+        if (is_empty())
+            return m_capacity;
+        size_t found_index = m_capacity;
+        u8 bits = hash_bits(hash);
+        for_each_probed_group(hash, [&](size_t group_index) {
+            u64 group = group_at(group_index);
+            for (u64 matches = match_hash_bits(group, bits); matches; matches &= matches - 1) {
+                size_t index = group_index * group_size + lowest_match(matches);
+                if (finder(m_slots[index])) {
+                    found_index = index;
+                    return IterationDecision::Break;
+                }
+            }
+            return match_empty(group) ? IterationDecision::Break : IterationDecision::Continue;
+        });
+        return found_index;
+    }
 
-    Bucket* m_buckets { nullptr };
+    size_t find_insertion_slot(unsigned hash) const
+    {
+        size_t index = 0;
+        for_each_probed_group(hash, [&](size_t group_index) {
+            u64 available = match_empty_or_deleted(group_at(group_index));
+            if (!available)
+                return IterationDecision::Continue;
+            index = group_index * group_size + lowest_match(available);
+            return IterationDecision::Break;
+        });
+        return index;
+    }
+
+    template<typename U>
+    void set_impl(U&&);
+    void insert_during_rehash(T&&);
+    void rehash(size_t capacity);
+
+    T* m_slots { nullptr };
+    u8* m_metadata { nullptr };
 
     size_t m_size { 0 };
+    size_t m_deleted_count { 0 };
     size_t m_capacity { 0 };
     bool m_clearing { false };
     bool m_rehashing { false };
 };
 
 template<typename T, typename TraitsForT>
-void HashTable<T, TraitsForT>::set(T&& value)
+template<typename U>
+void HashTable<T, TraitsForT>::set_impl(U&& value)
 {
-    if (!m_capacity)
-        rehash(1);
-    auto& bucket = lookup(value);
-    for (auto& e : bucket) {
-        if (TraitsForT::equals(e, value)) {
-            e = move(value);
-            return;
-        }
+    unsigned hash = TraitsForT::hash(value);
+    auto finder = [&](auto& other) { return TraitsForT::equals(value, other); };
+    size_t index = find_slot(hash, finder);
+    if (index != m_capacity) {
+        m_slots[index] = forward<U>(value);
+        return;
     }
-    if (size() >= capacity()) {
-        rehash(size() + 1);
-        insert(move(value));
-    } else {
-        bucket.append(move(value));
+
+    if (m_size + m_deleted_count + 1 > max_load_for(m_capacity)) {
+        // Rehashing drops tombstones, so only grow if live elements take up a good part of the table.
+        rehash(capacity_for(max(m_size + 1, m_capacity ? m_size * 2 : 1)));
     }
-    m_size++;
+
+    index = find_insertion_slot(hash);
+    if (m_metadata[index] == deleted_slot)
+        --m_deleted_count;
+    new (&m_slots[index]) T(forward<U>(value));
+    m_metadata[index] = hash_bits(hash);
+    ++m_size;
+}
+
+template<typename T, typename TraitsForT>
+void HashTable<T, TraitsForT>::set(T&& value)
+{
+    set_impl(move(value));
 }
 
 template<typename T, typename TraitsForT>
 void HashTable<T, TraitsForT>::set(const T& value)
 {
-    if (!m_capacity)
-        rehash(1);
-    auto& bucket = lookup(value);
-    for (auto& e : bucket) {
-        if (TraitsForT::equals(e, value)) {
-            e = value;
-            return;
-        }
-    }
-    if (size() >= capacity()) {
-        rehash(size() + 1);
-        insert(value);
-    } else {
-        bucket.append(value);
-    }
-    m_size++;
+    set_impl(value);
+}
+
+template<typename T, typename TraitsForT>
+void HashTable<T, TraitsForT>::insert_during_rehash(T&& value)
+{
+    unsigned hash = TraitsForT::hash(value);
+    size_t index = find_insertion_slot(hash);
+    new (&m_slots[index]) T(move(value));
+    m_metadata[index] = hash_bits(hash);
 }
 
 template<typename T, typename TraitsForT>
 void HashTable<T, TraitsForT>::rehash(size_t new_capacity)
 {
     TemporaryChange<bool> change(m_rehashing, true);
-    new_capacity *= 2;
-    auto* new_buckets = new Bucket[new_capacity];
-    auto* old_buckets = m_buckets;
+    auto* old_slots = m_slots;
+    auto* old_metadata = m_metadata;
     size_t old_capacity = m_capacity;
-    m_buckets = new_buckets;
+
+    // Slots and metadata share one allocation, with the slots first to keep them aligned.
+    auto* storage = (u8*)kmalloc(new_capacity * sizeof(T) + new_capacity);
+    m_slots = (T*)storage;
+    m_metadata = storage + new_capacity * sizeof(T);
+    __builtin_memset(m_metadata, empty_slot, new_capacity);
     m_capacity = new_capacity;
+    m_deleted_count = 0;
 
     for (size_t i = 0; i < old_capacity; ++i) {
-        for (auto& value : old_buckets[i]) {
-            insert(move(value));
-        }
+        if (old_metadata[i] & 0x80)
+            continue;
+        insert_during_rehash(move(old_slots[i]));
+        old_slots[i].~T();
     }
 
-    delete[] old_buckets;
+    kfree(old_slots);
 }
 
 template<typename T, typename TraitsForT>
 void HashTable<T, TraitsForT>::clear()
 {
     TemporaryChange<bool> change(m_clearing, true);
-    if (m_buckets) {
-        delete[] m_buckets;
-        m_buckets = nullptr;
+    if (m_slots) {
+        for (size_t i = 0; i < m_capacity; ++i) {
+            if (is_used_slot(i))
+                m_slots[i].~T();
+        }
+        kfree(m_slots);
+        m_slots = nullptr;
+        m_metadata = nullptr;
     }
     m_capacity = 0;
     m_size = 0;
-}
-
-template<typename T, typename TraitsForT>
-void HashTable<T, TraitsForT>::insert(T&& value)
-{
-    auto& bucket = lookup(value);
-    bucket.append(move(value));
-}
-
-template<typename T, typename TraitsForT>
-void HashTable<T, TraitsForT>::insert(const T& value)
-{
-    auto& bucket = lookup(value);
-    bucket.append(value);
+    m_deleted_count = 0;
 }
 
 template<typename T, typename TraitsForT>
 bool HashTable<T, TraitsForT>::contains(const T& value) const
 {
-    if (is_empty())
-        return false;
-    auto& bucket = lookup(value);
-    for (auto& e : bucket) {
-        if (TraitsForT::equals(e, value))
-            return true;
-    }
-    return false;
+    return find(value) != end();
 }
 
 template<typename T, typename TraitsForT>
 void HashTable<T, TraitsForT>::remove(Iterator it)
 {
     ASSERT(!is_empty());
-    m_buckets[it.m_bucket_index].remove(it.m_bucket_iterator);
+    ASSERT(it.m_index < m_capacity && is_used_slot(it.m_index));
+    m_slots[it.m_index].~T();
+    m_metadata[it.m_index] = deleted_slot;
+    ++m_deleted_count;
     --m_size;
 }
 
-template<typename T, typename TraitsForT>
-auto HashTable<T, TraitsForT>::lookup(const T& value, size_t* bucket_index) -> Bucket&
-{
-    unsigned hash = TraitsForT::hash(value);
-    if (bucket_index)
-        *bucket_index = hash % m_capacity;
-    return m_buckets[hash % m_capacity];
-}
-
-template<typename T, typename TraitsForT>
-auto HashTable<T, TraitsForT>::lookup(const T& value, size_t* bucket_index) const -> const Bucket&
-{
-    unsigned hash = TraitsForT::hash(value);
-    if (bucket_index)
-        *bucket_index = hash % m_capacity;
-    return m_buckets[hash % m_capacity];
-}
-
 }
 
 using AK::HashTable;
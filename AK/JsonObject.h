@@ -30,10 +30,14 @@
 #include <AK/JsonArray.h>
 #include <AK/JsonObjectSerializer.h>
 #include <AK/JsonValue.h>
+#include <AK/OwnPtr.h>
 #include <AK/String.h>
+#include <AK/Vector.h>
 
 namespace AK {
 
+// Members are kept in a flat vector in insertion order. Most objects only have a handful
+// of members, so they are found by a linear scan; larger objects get a hash index on top.
 class JsonObject {
 public:
     JsonObject() {}
@@ -42,24 +46,33 @@ public:
     JsonObject(const JsonObject& other)
         : m_members(other.m_members)
     {
+        if (other.m_index)
+            rebuild_index();
     }
 
     JsonObject(JsonObject&& other)
         : m_members(move(other.m_members))
+        , m_index(move(other.m_index))
     {
     }
 
     JsonObject& operator=(const JsonObject& other)
     {
-        if (this != &other)
+        if (this != &other) {
             m_members = other.m_members;
+            m_index = nullptr;
+            if (other.m_index)
+                rebuild_index();
+        }
         return *this;
     }
 
     JsonObject& operator=(JsonObject&& other)
     {
-        if (this != &other)
+        if (this != &other) {
             m_members = move(other.m_members);
+            m_index = move(other.m_index);
+        }
         return *this;
     }
 
@@ -80,27 +93,36 @@ public:
 
     const JsonValue* get_ptr(const String& key) const
     {
-        auto it = m_members.find(key);
-        if (it == m_members.end())
+        int index = index_of(key);
+        if (index < 0)
             return nullptr;
-        return &(*it).value;
+        return &m_members[index].value;
     }
 
     bool has(const String& key) const
     {
-        return m_members.contains(key);
+        return index_of(key) >= 0;
     }
 
     void set(const String& key, JsonValue value)
     {
-        m_members.set(key, move(value));
+        int index = index_of(key);
+        if (index >= 0) {
+            m_members[index].value = move(value);
+            return;
+        }
+        m_members.append({ key, move(value) });
+        if (m_index)
+            m_index->set(key, m_members.size() - 1);
+        else if (m_members.size() > max_members_without_index)
+            rebuild_index();
     }
 
     template<typename Callback>
     void for_each_member(Callback callback) const
     {
-        for (auto& it : m_members)
-            callback(it.key, it.value);
+        for (auto& member : m_members)
+            callback(member.key, member.value);
     }
 
     template<typename Builder>
@@ -112,7 +134,36 @@ public:
     String to_string() const { return serialized<StringBuilder>(); }
 
 private:
-    HashMap<String, JsonValue> m_members;
+    static constexpr size_t max_members_without_index = 16;
+
+    struct Member {
+        String key;
+        JsonValue value;
+    };
+
+    int index_of(const String& key) const
+    {
+        if (m_index) {
+            auto it = m_index->find(key);
+            return it == m_index->end() ? -1 : (int)(*it).value;
+        }
+        for (size_t i = 0; i < m_members.size(); ++i) {
+            if (m_members[i].key == key)
+                return i;
+        }
+        return -1;
+    }
+
+    void rebuild_index()
+    {
+        m_index = make<HashMap<String, size_t>>();
+        m_index->ensure_capacity(m_members.size());
+        for (size_t i = 0; i < m_members.size(); ++i)
+            m_index->set(m_members[i].key, i);
+    }
+
+    Vector<Member> m_members;
+    OwnPtr<HashMap<String, size_t>> m_index;
 };
 
 template<typename Builder>
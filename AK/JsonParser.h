@@ -26,6 +26,7 @@
 
 #pragma once
 
+#include <AK/JsonPullParser.h>
 #include <AK/JsonValue.h>
 
 namespace AK {
@@ -33,7 +34,7 @@ namespace AK {
 class JsonParser {
 public:
     explicit JsonParser(const StringView& input)
-        : m_input(input)
+        : m_parser(input)
     {
     }
     ~JsonParser()
@@ -43,26 +44,10 @@ public:
     JsonValue parse();
 
 private:
-    char peek() const;
-    char consume();
-    void consume_whitespace();
-    void consume_specific(char expected_ch);
-    void consume_string(const char*);
-    String consume_quoted_string();
-    JsonArray parse_array();
-    JsonObject parse_object();
-    JsonValue parse_number();
-    JsonValue parse_string();
-    JsonValue parse_false();
-    JsonValue parse_true();
-    JsonValue parse_null();
-    JsonValue parse_undefined();
+    JsonValue parse_value(JsonPullParser::Event);
+    String string_from(const StringView&);
 
-    template<typename C>
-    void consume_while(C);
-
-    StringView m_input;
-    size_t m_index { 0 };
+    JsonPullParser m_parser;
 
     String m_last_string_starting_with_character[256];
 };
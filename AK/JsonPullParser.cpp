@@ -0,0 +1,355 @@
+/*
+ * Copyright (c) 2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <AK/JsonPullParser.h>
+#include <AK/NumericLimits.h>
+#include <AK/String.h>
+
+namespace AK {
+
+static inline bool is_whitespace(char ch)
+{
+    return ch == ' ' || ch == '\n' || ch == '\t' || ch == '\v' || ch == '\r';
+}
+
+static inline bool is_number_character(char ch)
+{
+    return (ch >= '0' && ch <= '9') || ch == '-' || ch == '+' || ch == '.' || ch == 'e' || ch == 'E';
+}
+
+void JsonPullParser::consume_whitespace()
+{
+    while (m_index < m_input.length() && is_whitespace(m_input[m_index]))
+        ++m_index;
+}
+
+bool JsonPullParser::consume_literal(const char* literal)
+{
+    for (; *literal; ++literal) {
+        if (peek() != *literal)
+            return false;
+        ++m_index;
+    }
+    return true;
+}
+
+bool JsonPullParser::consume_quoted_string(Vector<char, 128>& buffer)
+{
+    ASSERT(peek() == '"');
+    size_t start = ++m_index;
+    auto* characters = m_input.characters_without_null_termination();
+
+    while (m_index < m_input.length() && characters[m_index] != '"' && characters[m_index] != '\\')
+        ++m_index;
+    if (m_index == m_input.length())
+        return false;
+    if (characters[m_index] == '"') {
+        m_text = m_input.substring_view(start, m_index - start);
+        ++m_index;
+        return true;
+    }
+
+    // The string has escape sequences, so it has to be decoded into the scratch buffer.
+    buffer.clear();
+    buffer.append(characters + start, m_index - start);
+    for (;;) {
+        if (m_index == m_input.length())
+            return false;
+        char ch = characters[m_index++];
+        if (ch == '"')
+            break;
+        if (ch != '\\') {
+            buffer.append(ch);
+            continue;
+        }
+        if (m_index == m_input.length())
+            return false;
+        char escaped_ch = characters[m_index++];
+        switch (escaped_ch) {
+        case 'n':
+            buffer.append('\n');
+            break;
+        case 'r':
+            buffer.append('\r');
+            break;
+        case 't':
+            buffer.append('\t');
+            break;
+        case 'b':
+            buffer.append('\b');
+            break;
+        case 'f':
+            buffer.append('\f');
+            break;
+        case 'u':
+            if (m_input.length() - m_index < 4)
+                return false;
+            m_index += 4;
+            // FIXME: This is obviously not correct, but we don't have non-ASCII support so meh.
+            buffer.append('?');
+            break;
+        default:
+            buffer.append(escaped_ch);
+            break;
+        }
+    }
+    m_text = StringView(buffer.data(), buffer.size());
+    return true;
+}
+
+JsonPullParser::Event JsonPullParser::fail()
+{
+    m_has_error = true;
+    m_text = {};
+    return Event::Error;
+}
+
+JsonPullParser::Event JsonPullParser::end_container(Container container)
+{
+    m_containers.take_last();
+    ++m_index;
+    did_parse_value();
+    return container == Container::Object ? Event::EndObject : Event::EndArray;
+}
+
+JsonPullParser::Event JsonPullParser::parse_value()
+{
+    switch (peek()) {
+    case '{':
+        ++m_index;
+        m_containers.append(Container::Object);
+        m_expect = Expect::FirstInContainer;
+        return Event::BeginObject;
+    case '[':
+        ++m_index;
+        m_containers.append(Container::Array);
+        m_expect = Expect::FirstInContainer;
+        return Event::BeginArray;
+    case '"':
+        if (!consume_quoted_string(m_value_buffer))
+            return fail();
+        did_parse_value();
+        return Event::String;
+    case '-':
+    case '0':
+    case '1':
+    case '2':
+    case '3':
+    case '4':
+    case '5':
+    case '6':
+    case '7':
+    case '8':
+    case '9': {
+        size_t start = m_index;
+        while (m_index < m_input.length() && is_number_character(m_input[m_index]))
+            ++m_index;
+        m_text = m_input.substring_view(start, m_index - start);
+        did_parse_value();
+        return Event::Number;
+    }
+    case 't':
+        if (!consume_literal("true"))
+            return fail();
+        did_parse_value();
+        return Event::True;
+    case 'f':
+        if (!consume_literal("false"))
+            return fail();
+        did_parse_value();
+        return Event::False;
+    case 'n':
+        if (!consume_literal("null"))
+            return fail();
+        did_parse_value();
+        return Event::Null;
+    case 'u':
+        if (!consume_literal("undefined"))
+            return fail();
+        did_parse_value();
+        return Event::Undefined;
+    }
+    return fail();
+}
+
+JsonPullParser::Event JsonPullParser::next()
+{
+    if (m_has_error)
+        return Event::Error;
+
+    consume_whitespace();
+
+    switch (m_expect) {
+    case Expect::Nothing:
+        return Event::EndOfInput;
+    case Expect::Value:
+        return parse_value();
+    case Expect::CommaOrEnd:
+        if (peek() != ',') {
+            auto container = m_containers.last();
+            if (peek() != (container == Container::Object ? '}' : ']'))
+                return fail();
+            return end_container(container);
+        }
+        ++m_index;
+        consume_whitespace();
+        // A trailing comma before the closing bracket is tolerated.
+        [[fallthrough]];
+    case Expect::FirstInContainer:
+        break;
+    }
+
+    auto container = m_containers.last();
+    if (container == Container::Array) {
+        if (peek() == ']')
+            return end_container(container);
+        return parse_value();
+    }
+    if (peek() == '}')
+        return end_container(container);
+    if (peek() != '"' || !consume_quoted_string(m_key_buffer))
+        return fail();
+    consume_whitespace();
+    if (peek() != ':')
+        return fail();
+    ++m_index;
+    m_expect = Expect::Value;
+    return Event::Key;
+}
+
+bool JsonPullParser::skip_value(Event event)
+{
+    switch (event) {
+    case Event::BeginObject:
+    case Event::BeginArray: {
+        size_t target_depth = depth() - 1;
+        while (depth() > target_depth) {
+            if (next() == Event::Error)
+                return false;
+        }
+        return true;
+    }
+    case Event::String:
+    case Event::Number:
+    case Event::True:
+    case Event::False:
+    case Event::Null:
+    case Event::Undefined:
+        return true;
+    default:
+        return false;
+    }
+}
+
+JsonValue JsonPullParser::number_value() const
+{
+    size_t index = 0;
+    bool is_negative = false;
+    if (index < m_text.length() && (m_text[index] == '-' || m_text[index] == '+'))
+        is_negative = m_text[index++] == '-';
+
+    u64 whole = 0;
+    bool overflowed = false;
+    size_t digits_start = index;
+    for (; index < m_text.length() && m_text[index] >= '0' && m_text[index] <= '9'; ++index) {
+        u64 digit = m_text[index] - '0';
+        if (whole > (NumericLimits<u64>::max() - digit) / 10)
+            overflowed = true;
+        whole = whole * 10 + digit;
+    }
+    if (index == digits_start)
+        return JsonValue();
+
+#ifdef KERNEL
+    // The kernel has no floating point, so fractions and exponents are dropped.
+    bool is_integer = true;
+#else
+    bool is_integer = index == m_text.length();
+#endif
+    if (is_integer && !overflowed) {
+        if (!is_negative) {
+            if (whole <= NumericLimits<u32>::max())
+                return JsonValue((unsigned)whole);
+            return JsonValue((long long unsigned)whole);
+        }
+        if (whole <= (u64)NumericLimits<i32>::max() + 1)
+            return JsonValue((int)-(i64)whole);
+        if (whole <= (u64)NumericLimits<i64>::max())
+            return JsonValue((long long)-(i64)whole);
+    }
+
+#ifndef KERNEL
+    double value = 0;
+    for (size_t i = digits_start; i < m_text.length() && m_text[i] >= '0' && m_text[i] <= '9'; ++i)
+        value = value * 10 + (m_text[i] - '0');
+    if (index < m_text.length() && m_text[index] == '.') {
+        double scale = 0.1;
+        for (++index; index < m_text.length() && m_text[index] >= '0' && m_text[index] <= '9'; ++index) {
+            value += (m_text[index] - '0') * scale;
+            scale /= 10;
+        }
+    }
+    if (index < m_text.length() && (m_text[index] == 'e' || m_text[index] == 'E')) {
+        ++index;
+        bool exponent_is_negative = false;
+        if (index < m_text.length() && (m_text[index] == '-' || m_text[index] == '+'))
+            exponent_is_negative = m_text[index++] == '-';
+        int exponent = 0;
+        for (; index < m_text.length() && m_text[index] >= '0' && m_text[index] <= '9'; ++index)
+            exponent = min(exponent * 10 + (m_text[index] - '0'), 1000);
+        for (int i = 0; i < exponent; ++i)
+            value = exponent_is_negative ? value / 10 : value * 10;
+    }
+    return JsonValue(is_negative ? -value : value);
+#else
+    return JsonValue();
+#endif
+}
+
+JsonValue JsonPullParser::value(Event event) const
+{
+    switch (event) {
+    case Event::String:
+        if (m_text.is_empty())
+            return String::empty();
+        return String(m_text);
+    case Event::Number:
+        return number_value();
+    case Event::True:
+        return JsonValue(true);
+    case Event::False:
+        return JsonValue(false);
+    case Event::Null:
+        return JsonValue(JsonValue::Type::Null);
+    case Event::Undefined:
+        return JsonValue(JsonValue::Type::Undefined);
+    default:
+        ASSERT_NOT_REACHED();
+    }
+}
+
+}
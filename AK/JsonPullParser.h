@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#pragma once
+
+#include <AK/JsonValue.h>
+#include <AK/StringView.h>
+#include <AK/Vector.h>
+
+namespace AK {
+
+// A pull parser that walks JSON input one token at a time without building a tree.
+// Keys, strings and numbers are handed out as StringViews into the input. A string
+// that contains escape sequences is decoded into a scratch buffer instead; its view
+// stays valid until the next token of the same kind (key or value) is parsed.
+class JsonPullParser {
+public:
+    enum class Event : u8 {
+        BeginObject,
+        EndObject,
+        BeginArray,
+        EndArray,
+        Key,
+        String,
+        Number,
+        True,
+        False,
+        Null,
+        Undefined,
+        EndOfInput,
+        Error,
+    };
+
+    explicit JsonPullParser(const StringView& input)
+        : m_input(input)
+    {
+    }
+
+    Event next();
+
+    // Skips over the value that follows a Key event (or the container that was just
+    // begun), so callers can ignore members they don't care about.
+    bool skip_value(Event);
+    bool skip_value() { return skip_value(next()); }
+
+    StringView text() const { return m_text; }
+    bool has_error() const { return m_has_error; }
+    size_t depth() const { return m_containers.size(); }
+
+    // Materializes the current scalar token (String, Number, True, False, Null or Undefined).
+    JsonValue value(Event) const;
+    JsonValue number_value() const;
+
+private:
+    enum class Container : u8 {
+        Object,
+        Array,
+    };
+
+    enum class Expect : u8 {
+        Value,
+        FirstInContainer,
+        CommaOrEnd,
+        Nothing,
+    };
+
+    char peek() const { return m_index < m_input.length() ? m_input[m_index] : '\0'; }
+    void consume_whitespace();
+    bool consume_literal(const char*);
+    bool consume_quoted_string(Vector<char, 128>& buffer);
+    Event parse_value();
+    Event end_container(Container);
+    void did_parse_value() { m_expect = m_containers.is_empty() ? Expect::Nothing : Expect::CommaOrEnd; }
+    Event fail();
+
+    StringView m_input;
+    size_t m_index { 0 };
+    StringView m_text;
+    Vector<char, 128> m_key_buffer;
+    Vector<char, 128> m_value_buffer;
+    Vector<Container, 32> m_containers;
+    Expect m_expect { Expect::Value };
+    bool m_has_error { false };
+};
+
+}
+
+using AK::JsonPullParser;
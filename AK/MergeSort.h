@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2018-2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/QuickSort.h>
+#include <AK/StdLibExtras.h>
+#include <AK/Vector.h>
+
+namespace AK {
+
+/* A stable sort: elements that compare equal keep their relative order. Runs
+ * of up to quick_sort_insertion_threshold elements are insertion sorted, then
+ * merged pairwise. Only the left half of each merge is moved out to a scratch
+ * buffer, so the extra memory is at most half the collection.
+ */
+template<typename Collection, typename LessThan, typename Buffer>
+void merge_sort(Collection& col, size_t start, size_t end, LessThan& less_than, Buffer& buffer)
+{
+    if (end - start <= quick_sort_insertion_threshold) {
+        insertion_sort(col, start, end, less_than);
+        return;
+    }
+
+    size_t middle = start + (end - start) / 2;
+    merge_sort(col, start, middle, less_than, buffer);
+    merge_sort(col, middle, end, less_than, buffer);
+
+    // Already in order, which is common for partially sorted input.
+    if (!less_than(col[middle], col[middle - 1]))
+        return;
+
+    buffer.clear_with_capacity();
+    for (size_t i = start; i < middle; ++i)
+        buffer.unchecked_append(move(col[i]));
+
+    // Take from the left half unless the right element is strictly smaller; that is what keeps the sort stable.
+    size_t left = 0;
+    size_t right = middle;
+    size_t out = start;
+    while (left < buffer.size() && right < end) {
+        if (less_than(col[right], buffer[left]))
+            col[out++] = move(col[right++]);
+        else
+            col[out++] = move(buffer[left++]);
+    }
+    while (left < buffer.size())
+        col[out++] = move(buffer[left++]);
+}
+
+template<typename Collection, typename LessThan>
+void merge_sort(Collection& collection, LessThan less_than)
+{
+    size_t size = collection.size();
+    if (size <= quick_sort_insertion_threshold) {
+        insertion_sort(collection, 0, size, less_than);
+        return;
+    }
+    Vector<typename RemoveReference<decltype(collection[0])>::Type> buffer;
+    buffer.ensure_capacity(size - size / 2);
+    merge_sort(collection, 0, size, less_than, buffer);
+}
+
+template<typename Collection>
+void merge_sort(Collection& collection)
+{
+    merge_sort(collection, [](auto& a, auto& b) { return a < b; });
+}
+
+}
+
+using AK::merge_sort;
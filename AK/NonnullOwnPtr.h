@@ -172,6 +172,11 @@ make(Args&&... args)
     return NonnullOwnPtr<T>(NonnullOwnPtr<T>::Adopt, *new T(forward<Args>(args)...));
 }
 
+template<typename T>
+struct IsTriviallyRelocatable<NonnullOwnPtr<T>> {
+    static constexpr bool value = true;
+};
+
 template<typename T>
 struct Traits<NonnullOwnPtr<T>> : public GenericTraits<NonnullOwnPtr<T>> {
     using PeekType = const T*;
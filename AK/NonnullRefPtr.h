@@ -254,6 +254,11 @@ inline void swap(NonnullRefPtr<T>& a, NonnullRefPtr<U>& b)
     a.swap(b);
 }
 
+template<typename T>
+struct IsTriviallyRelocatable<NonnullRefPtr<T>> {
+    static constexpr bool value = true;
+};
+
 }
 
 using AK::adopt;
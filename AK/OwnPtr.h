@@ -208,6 +208,11 @@ inline void swap(OwnPtr<T>& a, OwnPtr<U>& b)
     a.swap(b);
 }
 
+template<typename T>
+struct IsTriviallyRelocatable<OwnPtr<T>> {
+    static constexpr bool value = true;
+};
+
 template<typename T>
 struct Traits<OwnPtr<T>> : public GenericTraits<OwnPtr<T>> {
     using PeekType = const T*;
@@ -27,88 +27,143 @@
 #pragma once
 
 #include <AK/StdLibExtras.h>
+#include <AK/Types.h>
 
 namespace AK {
 
-/* This is a dual pivot quick sort. It is quite a bit faster than the single
- * pivot quick_sort below. The other quick_sort below should only be used when
- * you are stuck with simple iterators to a container and you don't have access
- * to the container itself.
+/* This is an introsort: a quick sort that picks a median-of-three pivot, hands
+ * short ranges to insertion sort, and falls back to heap sort when it recurses
+ * too deeply. That keeps it O(n log n) on sorted, reversed and all-equal input,
+ * which a naive pivot turns quadratic. It is not stable; use merge_sort() from
+ * <AK/MergeSort.h> if equal elements have to keep their order.
+ *
+ * Everything works on a collection indexed by [start, end). The iterator
+ * overloads below wrap their range in an IteratorCollection.
  */
+
+static constexpr size_t quick_sort_insertion_threshold = 16;
+
 template<typename Collection, typename LessThan>
-void dual_pivot_quick_sort(Collection& col, int start, int end, LessThan less_than)
+void insertion_sort(Collection& col, size_t start, size_t end, LessThan& less_than)
 {
-    if (start >= end) {
-        return;
+    for (size_t i = start + 1; i < end; ++i) {
+        for (size_t j = i; j > start && less_than(col[j], col[j - 1]); --j)
+            swap(col[j], col[j - 1]);
     }
+}
 
-    int left_pointer, right_pointer;
-    if (!less_than(col[start], col[end])) {
-        swap(col[start], col[end]);
+template<typename Collection, typename LessThan>
+void heap_sort_sift_down(Collection& col, size_t start, size_t root, size_t size, LessThan& less_than)
+{
+    for (;;) {
+        size_t child = 2 * root + 1;
+        if (child >= size)
+            return;
+        if (child + 1 < size && less_than(col[start + child], col[start + child + 1]))
+            ++child;
+        if (!less_than(col[start + root], col[start + child]))
+            return;
+        swap(col[start + root], col[start + child]);
+        root = child;
     }
+}
 
-    int j = start + 1;
-    int k = start + 1;
-    int g = end - 1;
-
-    auto left_pivot = col[start];
-    auto right_pivot = col[end];
-
-    while (k <= g) {
-        if (less_than(col[k], left_pivot)) {
-            swap(col[k], col[j]);
-            j++;
-        } else if (!less_than(col[k], right_pivot)) {
-            while (!less_than(col[g], right_pivot) && k < g) {
-                g--;
-            }
-            swap(col[k], col[g]);
-            g--;
-            if (less_than(col[k], left_pivot)) {
-                swap(col[k], col[j]);
-                j++;
-            }
-        }
-        k++;
+template<typename Collection, typename LessThan>
+void heap_sort(Collection& col, size_t start, size_t end, LessThan& less_than)
+{
+    size_t size = end - start;
+    for (size_t i = size / 2; i-- > 0;)
+        heap_sort_sift_down(col, start, i, size, less_than);
+    for (size_t i = size; i-- > 1;) {
+        swap(col[start], col[start + i]);
+        heap_sort_sift_down(col, start, 0, i, less_than);
     }
-    j--;
-    g++;
-
-    swap(col[start], col[j]);
-    swap(col[end], col[g]);
+}
 
-    left_pointer = j;
-    right_pointer = g;
+template<typename Collection, typename LessThan>
+void introsort(Collection& col, size_t start, size_t end, size_t depth_limit, LessThan& less_than)
+{
+    while (end - start > quick_sort_insertion_threshold) {
+        if (depth_limit-- == 0) {
+            heap_sort(col, start, end, less_than);
+            return;
+        }
 
-    dual_pivot_quick_sort(col, start, left_pointer - 1, less_than);
-    dual_pivot_quick_sort(col, left_pointer + 1, right_pointer - 1, less_than);
-    dual_pivot_quick_sort(col, right_pointer + 1, end, less_than);
+        // Move the median of the first, middle and last elements to the front and
+        // partition around it in place, so elements never have to be copied.
+        size_t middle = start + (end - start) / 2;
+        size_t last = end - 1;
+        if (less_than(col[middle], col[start]))
+            swap(col[middle], col[start]);
+        if (less_than(col[last], col[middle])) {
+            swap(col[last], col[middle]);
+            if (less_than(col[middle], col[start]))
+                swap(col[middle], col[start]);
+        }
+        swap(col[start], col[middle]);
+
+        // Both scans stop on elements equal to the pivot, which splits runs of
+        // equal elements evenly instead of piling them up on one side.
+        auto& pivot = col[start];
+        size_t i = start;
+        size_t j = end;
+        for (;;) {
+            do {
+                ++i;
+            } while (i < end && less_than(col[i], pivot));
+            do {
+                --j;
+            } while (less_than(pivot, col[j]));
+            if (i >= j)
+                break;
+            swap(col[i], col[j]);
+        }
+        swap(col[start], col[j]);
+
+        // Recurse into the smaller half and loop on the larger one to bound the stack depth.
+        if (j - start < end - j - 1) {
+            introsort(col, start, j, depth_limit, less_than);
+            start = j + 1;
+        } else {
+            introsort(col, j + 1, end, depth_limit, less_than);
+            end = j;
+        }
+    }
+    insertion_sort(col, start, end, less_than);
 }
 
-template<typename Iterator, typename LessThan>
-void quick_sort(Iterator start, Iterator end, LessThan less_than)
+template<typename Collection, typename LessThan>
+void introsort(Collection& col, size_t start, size_t end, LessThan& less_than)
 {
-    int size = end - start;
-    if (size <= 1)
+    if (end - start <= 1)
         return;
+    size_t depth_limit = 0;
+    for (size_t size = end - start; size > 1; size >>= 1)
+        depth_limit += 2;
+    introsort(col, start, end, depth_limit, less_than);
+}
 
-    int pivot_point = size / 2;
-    auto pivot = *(start + pivot_point);
+template<typename Iterator>
+class IteratorCollection {
+public:
+    IteratorCollection(Iterator start)
+        : m_start(start)
+    {
+    }
 
-    if (pivot_point)
-        swap(*(start + pivot_point), *start);
+    decltype(auto) operator[](size_t index) { return *(m_start + index); }
 
-    int i = 1;
-    for (int j = 1; j < size; ++j) {
-        if (less_than(*(start + j), pivot)) {
-            swap(*(start + j), *(start + i));
-            ++i;
-        }
-    }
+private:
+    Iterator m_start;
+};
 
-    swap(*start, *(start + i - 1));
-    quick_sort(start, start + i - 1, less_than);
-    quick_sort(start + i, end, less_than);
+template<typename Iterator, typename LessThan>
+void quick_sort(Iterator start, Iterator end, LessThan less_than)
+{
+    if (end - start <= 1)
+        return;
+    IteratorCollection<Iterator> collection(start);
+    introsort(collection, 0, end - start, less_than);
 }
 
 template<typename Iterator>
@@ -120,14 +175,13 @@ void quick_sort(Iterator start, Iterator end)
 template<typename Collection, typename LessThan>
 void quick_sort(Collection& collection, LessThan less_than)
 {
-    dual_pivot_quick_sort(collection, 0, collection.size() - 1, move(less_than));
+    introsort(collection, 0, collection.size(), less_than);
 }
 
 template<typename Collection>
 void quick_sort(Collection& collection)
 {
-    dual_pivot_quick_sort(collection, 0, collection.size() - 1,
-        [](auto& a, auto& b) { return a < b; });
+    quick_sort(collection, [](auto& a, auto& b) { return a < b; });
 }
 
 }
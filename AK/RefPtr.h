@@ -275,6 +275,11 @@ inline const LogStream& operator<<(const LogStream& stream, const RefPtr<T>& val
     return stream << value.ptr();
 }
 
+template<typename T>
+struct IsTriviallyRelocatable<RefPtr<T>> {
+    static constexpr bool value = true;
+};
+
 template<typename T>
 struct Traits<RefPtr<T>> : public GenericTraits<RefPtr<T>> {
     using PeekType = const T*;
@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <AK/Memory.h>
+#include <AK/PrintfImplementation.h>
+#include <AK/SegmentedStringBuilder.h>
+#include <AK/StdLibExtras.h>
+#include <AK/String.h>
+
+namespace AK {
+
+void SegmentedStringBuilder::add_segment(size_t minimum_size)
+{
+    // Segments double in size up to a limit, so small outputs stay small
+    // and large ones are held in a modest number of segments.
+    size_t size = m_segments.is_empty() ? minimum_segment_size : min(m_segments.last().size() * 2, maximum_segment_size);
+    m_segments.append(ByteBuffer::create_uninitialized(max(size, minimum_size)));
+    m_last_segment_size = 0;
+}
+
+void SegmentedStringBuilder::append(const StringView& string)
+{
+    if (string.is_empty())
+        return;
+    auto* characters = string.characters_without_null_termination();
+    size_t remaining = string.length();
+    m_length += remaining;
+
+    if (!m_segments.is_empty()) {
+        auto& segment = m_segments.last();
+        size_t size = min(remaining, segment.size() - m_last_segment_size);
+        memcpy(segment.data() + m_last_segment_size, characters, size);
+        m_last_segment_size += size;
+        characters += size;
+        remaining -= size;
+    }
+    if (!remaining)
+        return;
+
+    add_segment(remaining);
+    memcpy(m_segments.last().data(), characters, remaining);
+    m_last_segment_size = remaining;
+}
+
+void SegmentedStringBuilder::append(char ch)
+{
+    if (m_segments.is_empty() || m_last_segment_size == m_segments.last().size())
+        add_segment(1);
+    m_segments.last()[m_last_segment_size++] = ch;
+    ++m_length;
+}
+
+void SegmentedStringBuilder::appendvf(const char* fmt, va_list ap)
+{
+    printf_internal([this](char*&, char ch) {
+        append(ch);
+    },
+        nullptr, fmt, ap);
+}
+
+void SegmentedStringBuilder::appendf(const char* fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    appendvf(fmt, ap);
+    va_end(ap);
+}
+
+void SegmentedStringBuilder::copy_to(char* buffer) const
+{
+    for_each_segment([&](const StringView& segment) {
+        memcpy(buffer, segment.characters_without_null_termination(), segment.length());
+        buffer += segment.length();
+    });
+}
+
+String SegmentedStringBuilder::to_string() const
+{
+    if (is_empty())
+        return String::empty();
+    char* buffer;
+    auto impl = StringImpl::create_uninitialized(m_length, buffer);
+    copy_to(buffer);
+    return String(move(impl));
+}
+
+String SegmentedStringBuilder::build() const
+{
+    return to_string();
+}
+
+ByteBuffer SegmentedStringBuilder::to_byte_buffer() const
+{
+    auto buffer = ByteBuffer::create_uninitialized(m_length);
+    copy_to((char*)buffer.data());
+    return buffer;
+}
+
+void SegmentedStringBuilder::clear()
+{
+    m_segments.clear();
+    m_last_segment_size = 0;
+    m_length = 0;
+}
+
+}
@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#pragma once
+
+#include <AK/ByteBuffer.h>
+#include <AK/Forward.h>
+#include <AK/StringView.h>
+#include <AK/Vector.h>
+#include <stdarg.h>
+
+namespace AK {
+
+// Like StringBuilder, but appends into a chain of segments instead of one buffer that has to
+// be copied every time it grows. The contents only become contiguous when they are built into
+// a String or ByteBuffer; for_each_segment() hands them out without flattening them at all.
+class SegmentedStringBuilder {
+public:
+    using OutputType = String;
+
+    static constexpr size_t minimum_segment_size = 256;
+    static constexpr size_t maximum_segment_size = 64 * KB;
+
+    SegmentedStringBuilder() { }
+    ~SegmentedStringBuilder() { }
+
+    void append(const StringView&);
+    void append(char);
+    void append(const char* characters, size_t length) { append(StringView { characters, length }); }
+    void appendf(const char*, ...);
+    void appendvf(const char*, va_list);
+
+    String build() const;
+    String to_string() const;
+    ByteBuffer to_byte_buffer() const;
+
+    template<typename Callback>
+    void for_each_segment(Callback callback) const
+    {
+        for (size_t i = 0; i < m_segments.size(); ++i) {
+            size_t size = i == m_segments.size() - 1 ? m_last_segment_size : m_segments[i].size();
+            callback(StringView { (const char*)m_segments[i].data(), size });
+        }
+    }
+
+    void clear();
+
+    size_t length() const { return m_length; }
+    bool is_empty() const { return m_length == 0; }
+    size_t segment_count() const { return m_segments.size(); }
+
+    template<class SeparatorType, class CollectionType>
+    void join(const SeparatorType& separator, const CollectionType& collection)
+    {
+        bool first = true;
+        for (auto& item : collection) {
+            if (first)
+                first = false;
+            else
+                append(separator);
+            append(item);
+        }
+    }
+
+private:
+    void copy_to(char* buffer) const;
+    void add_segment(size_t minimum_size);
+
+    Vector<ByteBuffer> m_segments;
+    size_t m_last_segment_size { 0 };
+    size_t m_length { 0 };
+};
+
+}
+
+using AK::SegmentedStringBuilder;
@@ -55,6 +55,16 @@ bool SharedBuffer::share_with(pid_t peer)
     return true;
 }
 
+bool SharedBuffer::hand_over_to(pid_t peer)
+{
+    int ret = shbuf_hand_over(shbuf_id(), peer);
+    if (ret < 0) {
+        perror("shbuf_hand_over");
+        return false;
+    }
+    return true;
+}
+
 bool SharedBuffer::share_globally()
 {
     int ret = shbuf_allow_all(shbuf_id());
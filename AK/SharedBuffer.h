@@ -41,6 +41,9 @@ public:
 
     bool share_globally();
     bool share_with(pid_t);
+    // Shares the buffer with the peer, and keeps it alive for them until they've mapped it,
+    // so it can be dropped on this side right after telling the peer about it.
+    bool hand_over_to(pid_t);
     int shbuf_id() const { return m_shbuf_id; }
     void seal();
     int size() const { return m_size; }
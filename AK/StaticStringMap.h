@@ -0,0 +1,151 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/HashFunctions.h>
+#include <AK/StringUtils.h>
+#include <AK/StringView.h>
+#include <AK/Types.h>
+
+namespace AK {
+
+template<typename Value>
+struct StaticStringMapEntry {
+    const char* key;
+    Value value;
+};
+
+// A string-keyed hash table that is built entirely at compile time, so it lives in
+// read-only data and needs no initialization at startup:
+//
+//     static constexpr auto s_keywords = make_static_string_map<TokenType>({ { "if", TokenType::If }, ... });
+//
+// The entries are kept in their original order, with an open-addressing index of
+// 16-bit entry numbers on top. The index is at most half full.
+template<typename Value, size_t EntryCount, size_t Capacity>
+class StaticStringMap {
+    static_assert(EntryCount < Capacity, "StaticStringMap needs at least one empty slot");
+    static_assert(Capacity <= 65536, "StaticStringMap indexes entries with 16 bits");
+    static_assert((Capacity & (Capacity - 1)) == 0, "StaticStringMap capacity must be a power of two");
+
+public:
+    using Entry = StaticStringMapEntry<Value>;
+
+    constexpr StaticStringMap(const Entry (&entries)[EntryCount], CaseSensitivity case_sensitivity)
+        : m_case_sensitivity(case_sensitivity)
+    {
+        for (size_t i = 0; i < EntryCount; ++i) {
+            m_entries[i] = entries[i];
+            size_t length = 0;
+            while (entries[i].key[length])
+                ++length;
+            m_key_lengths[i] = length;
+            if (length > m_max_key_length)
+                m_max_key_length = length;
+
+            size_t slot = hash(entries[i].key, length) & (Capacity - 1);
+            while (m_slots[slot])
+                slot = (slot + 1) & (Capacity - 1);
+            m_slots[slot] = i + 1;
+        }
+    }
+
+    const Entry* find(const StringView& key) const
+    {
+        if (key.length() > m_max_key_length)
+            return nullptr;
+        auto* characters = key.characters_without_null_termination();
+        for (size_t slot = hash(characters, key.length()) & (Capacity - 1);; slot = (slot + 1) & (Capacity - 1)) {
+            size_t index = m_slots[slot];
+            if (!index)
+                return nullptr;
+            auto& entry = m_entries[index - 1];
+            if (m_key_lengths[index - 1] == key.length() && equals(entry.key, characters, key.length()))
+                return &entry;
+        }
+    }
+
+    const Value* get(const StringView& key) const
+    {
+        auto* entry = find(key);
+        return entry ? &entry->value : nullptr;
+    }
+
+    bool contains(const StringView& key) const { return get(key); }
+
+    constexpr size_t size() const { return EntryCount; }
+    constexpr size_t max_key_length() const { return m_max_key_length; }
+    constexpr const Entry& entry_at(size_t index) const { return m_entries[index]; }
+
+private:
+    constexpr char fold(char ch) const
+    {
+        if (m_case_sensitivity == CaseSensitivity::CaseInsensitive && ch >= 'A' && ch <= 'Z')
+            return ch + ('a' - 'A');
+        return ch;
+    }
+
+    constexpr u32 hash(const char* characters, size_t length) const
+    {
+        return string_hash(characters, length, m_case_sensitivity == CaseSensitivity::CaseInsensitive);
+    }
+
+    bool equals(const char* entry_key, const char* characters, size_t length) const
+    {
+        for (size_t i = 0; i < length; ++i) {
+            if (fold(entry_key[i]) != fold(characters[i]))
+                return false;
+        }
+        return true;
+    }
+
+    Entry m_entries[EntryCount] {};
+    u16 m_key_lengths[EntryCount] {};
+    u16 m_slots[Capacity] {};
+    size_t m_max_key_length { 0 };
+    CaseSensitivity m_case_sensitivity { CaseSensitivity::CaseSensitive };
+};
+
+constexpr size_t static_string_map_capacity(size_t entry_count)
+{
+    size_t capacity = 1;
+    while (capacity < entry_count * 2)
+        capacity *= 2;
+    return capacity;
+}
+
+template<typename Value, size_t EntryCount>
+constexpr StaticStringMap<Value, EntryCount, static_string_map_capacity(EntryCount)> make_static_string_map(const StaticStringMapEntry<Value> (&entries)[EntryCount], CaseSensitivity case_sensitivity = CaseSensitivity::CaseSensitive)
+{
+    return { entries, case_sensitivity };
+}
+
+}
+
+using AK::make_static_string_map;
+using AK::StaticStringMap;
+using AK::StaticStringMapEntry;
@@ -416,6 +416,15 @@ struct MakeSigned<unsigned long long> {
     typedef long long type;
 };
 
+// A type is trivially relocatable if an object can be moved to a new address with memcpy()
+// and the old copy simply forgotten, instead of running the move constructor and destructor.
+// Trivially copyable types always are; classes that only hold pointers to memory outside
+// of themselves (like String or RefPtr) opt in by specializing this.
+template<typename T>
+struct IsTriviallyRelocatable {
+    static constexpr bool value = __is_trivially_copyable(T);
+};
+
 template<typename T, typename U = T>
 inline constexpr T exchange(T& slot, U&& value)
 {
@@ -432,6 +441,7 @@ using AK::Conditional;
 using AK::exchange;
 using AK::forward;
 using AK::IsSame;
+using AK::IsTriviallyRelocatable;
 using AK::MakeSigned;
 using AK::MakeUnsigned;
 using AK::max;
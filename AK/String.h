@@ -238,13 +238,18 @@ private:
     RefPtr<StringImpl> m_impl;
 };
 
+template<>
+struct IsTriviallyRelocatable<String> {
+    static constexpr bool value = true;
+};
+
 template<>
 struct Traits<String> : public GenericTraits<String> {
     static unsigned hash(const String& s) { return s.impl() ? s.impl()->hash() : 0; }
 };
 
 struct CaseInsensitiveStringTraits : public AK::Traits<String> {
-    static unsigned hash(const String& s) { return s.impl() ? s.to_lowercase().impl()->hash() : 0; }
+    static unsigned hash(const String& s) { return s.impl() ? case_insensitive_string_hash(s.characters(), s.length()) : 0; }
     static bool equals(const String& a, const String& b) { return a.to_lowercase() == b.to_lowercase(); }
 };
 
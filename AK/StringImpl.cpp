@@ -51,13 +51,43 @@ namespace AK {
 
 static StringImpl* s_the_empty_stringimpl = nullptr;
 
+// These shared impls are published with a compare-and-swap so that racing threads agree on a
+// single one, which FlyString relies on for comparing by pointer. They're marked fly, which
+// makes their reference counts atomic, and are never freed.
+static StringImpl& publish_shared_stringimpl(StringImpl*& slot, StringImpl& new_stringimpl)
+{
+    StringImpl* expected = nullptr;
+    if (__atomic_compare_exchange_n(&slot, &expected, &new_stringimpl, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+        return new_stringimpl;
+    kfree(&new_stringimpl);
+    return *expected;
+}
+
 StringImpl& StringImpl::the_empty_stringimpl()
 {
-    if (!s_the_empty_stringimpl) {
-        void* slot = kmalloc(sizeof(StringImpl) + sizeof(char));
-        s_the_empty_stringimpl = new (slot) StringImpl(ConstructTheEmptyStringImpl);
-    }
-    return *s_the_empty_stringimpl;
+    if (auto* stringimpl = __atomic_load_n(&s_the_empty_stringimpl, __ATOMIC_ACQUIRE))
+        return *stringimpl;
+    void* slot = kmalloc(sizeof(StringImpl) + sizeof(char));
+    return publish_shared_stringimpl(s_the_empty_stringimpl, *new (slot) StringImpl(ConstructTheEmptyStringImpl));
+}
+
+// Tokenizers churn out lots of one-character strings, so each of those shares one
+// StringImpl, just like the empty string.
+static StringImpl* s_single_character_stringimpls[256];
+
+StringImpl& StringImpl::the_single_character_stringimpl(char ch)
+{
+    auto*& slot = s_single_character_stringimpls[(u8)ch];
+    if (auto* stringimpl = __atomic_load_n(&slot, __ATOMIC_ACQUIRE))
+        return *stringimpl;
+    void* storage = kmalloc(sizeof(StringImpl) + 2 * sizeof(char));
+    auto* stringimpl = new (storage) StringImpl(ConstructWithInlineBuffer, 1);
+    stringimpl->m_inline_buffer[0] = ch;
+    stringimpl->m_inline_buffer[1] = '\0';
+    stringimpl->m_fly = true;
+    // FlyString::hash() only reads the cached hash, so it has to be there from the start.
+    stringimpl->compute_hash();
+    return publish_shared_stringimpl(slot, *stringimpl);
 }
 
 StringImpl::StringImpl(ConstructWithInlineBufferTag, size_t length)
@@ -118,6 +148,9 @@ RefPtr<StringImpl> StringImpl::create(const char* cstring, size_t length, Should
     if (!length)
         return the_empty_stringimpl();
 
+    if (length == 1)
+        return the_single_character_stringimpl(cstring[0]);
+
     char* buffer;
     auto new_stringimpl = create_uninitialized(length, buffer);
     memcpy(buffer, cstring, length * sizeof(char));
@@ -166,6 +199,9 @@ NonnullRefPtr<StringImpl> StringImpl::to_lowercase() const
     return const_cast<StringImpl&>(*this);
 
 slow_path:
+    if (m_length == 1)
+        return the_single_character_stringimpl(to_ascii_lowercase(characters()[0]));
+
     char* buffer;
     auto lowercased = create_uninitialized(m_length, buffer);
     for (size_t i = 0; i < m_length; ++i)
@@ -182,6 +218,9 @@ NonnullRefPtr<StringImpl> StringImpl::to_uppercase() const
     return const_cast<StringImpl&>(*this);
 
 slow_path:
+    if (m_length == 1)
+        return the_single_character_stringimpl(to_ascii_uppercase(characters()[0]));
+
     char* buffer;
     auto uppercased = create_uninitialized(m_length, buffer);
     for (size_t i = 0; i < m_length; ++i)
@@ -27,6 +27,7 @@
 #pragma once
 
 #include <AK/Badge.h>
+#include <AK/HashFunctions.h>
 #include <AK/RefCounted.h>
 #include <AK/RefPtr.h>
 #include <AK/Types.h>
@@ -52,7 +53,40 @@ public:
         kfree(ptr);
     }
 
+    // Interned (fly) impls can be shared between threads through FlyString, so their
+    // reference count is atomic. Everything else keeps the cheap unsynchronized one.
+    ALWAYS_INLINE void ref() const
+    {
+        if (m_fly) {
+            __atomic_add_fetch(&m_ref_count, 1, __ATOMIC_RELAXED);
+            return;
+        }
+        RefCountedBase::ref();
+    }
+
+    ALWAYS_INLINE void unref() const
+    {
+        if (m_fly) {
+            if (__atomic_sub_fetch(&m_ref_count, 1, __ATOMIC_ACQ_REL) == 0)
+                delete this;
+            return;
+        }
+        RefCounted::unref();
+    }
+
+    // Takes a reference unless another thread has already dropped the last one.
+    bool try_ref(Badge<FlyString>) const
+    {
+        int count = __atomic_load_n(&m_ref_count, __ATOMIC_RELAXED);
+        while (count) {
+            if (__atomic_compare_exchange_n(&m_ref_count, &count, count + 1, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+                return true;
+        }
+        return false;
+    }
+
     static StringImpl& the_empty_stringimpl();
+    static StringImpl& the_single_character_stringimpl(char);
 
     ~StringImpl();
 
@@ -103,22 +137,7 @@ private:
     char m_inline_buffer[0];
 };
 
-inline constexpr u32 string_hash(const char* characters, size_t length)
-{
-    u32 hash = 0;
-    for (size_t i = 0; i < length; ++i) {
-        hash += (u32)characters[i];
-        hash += (hash << 10);
-        hash ^= (hash >> 6);
-    }
-    hash += hash << 3;
-    hash ^= hash >> 11;
-    hash += hash << 15;
-    return hash;
-}
-
 }
 
 using AK::Chomp;
-using AK::string_hash;
 using AK::StringImpl;
@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) 2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <AK/TestSuite.h>
+
+#include <AK/Arena.h>
+#include <AK/String.h>
+#include <AK/Vector.h>
+
+TEST_CASE(allocate_aligned)
+{
+    Arena arena(1024);
+    auto* a = arena.allocate(1, 1);
+    auto* b = arena.allocate(8, 8);
+    auto* c = arena.allocate(3, 16);
+    EXPECT(a != nullptr);
+    EXPECT_EQ((FlatPtr)b % 8, 0u);
+    EXPECT_EQ((FlatPtr)c % 16, 0u);
+    EXPECT(b != a && c != b);
+    EXPECT_EQ(arena.chunk_count(), 1u);
+    EXPECT_EQ(arena.bytes_allocated(), 12u);
+}
+
+TEST_CASE(chunked_growth)
+{
+    Arena arena(1024);
+    Vector<u32*> pointers;
+    for (u32 i = 0; i < 1000; ++i) {
+        auto* pointer = (u32*)arena.allocate(sizeof(u32) * 4);
+        for (u32 j = 0; j < 4; ++j)
+            pointer[j] = i;
+        pointers.append(pointer);
+    }
+    EXPECT(arena.chunk_count() > 10u);
+    EXPECT(arena.chunk_count() < 30u);
+    for (u32 i = 0; i < 1000; ++i)
+        EXPECT_EQ(pointers[i][3], i);
+}
+
+TEST_CASE(oversized_allocation_keeps_current_chunk)
+{
+    Arena arena(1024);
+    auto* small1 = (u8*)arena.allocate(16);
+    arena.allocate(4096);
+    auto* small2 = (u8*)arena.allocate(16);
+    EXPECT_EQ(arena.chunk_count(), 2u);
+    EXPECT(small2 == small1 + 16);
+}
+
+TEST_CASE(destructors_run_in_reverse_order)
+{
+    Vector<int> destroyed;
+    struct Tracker {
+        Tracker(Vector<int>& destroyed, int id)
+            : destroyed(destroyed)
+            , id(id)
+        {
+        }
+        ~Tracker() { destroyed.append(id); }
+        Vector<int>& destroyed;
+        int id;
+    };
+
+    {
+        Arena arena;
+        for (int i = 0; i < 3; ++i)
+            arena.make<Tracker>(destroyed, i);
+        auto& string = arena.make<String>("these are not leaked");
+        EXPECT_EQ(string, "these are not leaked");
+        EXPECT(destroyed.is_empty());
+    }
+    EXPECT_EQ(destroyed.size(), 3u);
+    EXPECT_EQ(destroyed[0], 2);
+    EXPECT_EQ(destroyed[2], 0);
+}
+
+TEST_CASE(clear)
+{
+    Arena arena(256);
+    for (int i = 0; i < 100; ++i)
+        arena.make<int>(i);
+    EXPECT(arena.chunk_count() > 1u);
+    arena.clear();
+    EXPECT_EQ(arena.chunk_count(), 0u);
+    EXPECT_EQ(arena.bytes_allocated(), 0u);
+    EXPECT_EQ(arena.make<int>(42), 42);
+}
+
+BENCHMARK_CASE(build_linked_list)
+{
+    struct Node {
+        Node* left { nullptr };
+        Node* right { nullptr };
+        int value { 0 };
+    };
+    for (int round = 0; round < 10; ++round) {
+        Arena arena;
+        Node* previous = nullptr;
+        for (int i = 0; i < 100000; ++i) {
+            auto& node = arena.make<Node>();
+            node.left = previous;
+            node.value = i;
+            previous = &node;
+        }
+        EXPECT_EQ(previous->value, 99999);
+    }
+}
+
+TEST_MAIN(Arena)
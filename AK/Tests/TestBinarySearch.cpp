@@ -106,4 +106,18 @@ TEST_CASE(no_elements)
     EXPECT_EQ(test1, nullptr);
 }
 
+TEST_CASE(upper_bound_ints)
+{
+    int ints[] = { 10, 20, 20, 30 };
+    auto is_before = [](int needle, int element) { return needle < element; };
+
+    EXPECT_EQ(upper_bound(ints, 4, 5, is_before), 0u);
+    EXPECT_EQ(upper_bound(ints, 4, 10, is_before), 1u);
+    EXPECT_EQ(upper_bound(ints, 4, 15, is_before), 1u);
+    EXPECT_EQ(upper_bound(ints, 4, 20, is_before), 3u);
+    EXPECT_EQ(upper_bound(ints, 4, 30, is_before), 4u);
+    EXPECT_EQ(upper_bound(ints, 4, 99, is_before), 4u);
+    EXPECT_EQ(upper_bound(ints, 0, 10, is_before), 0u);
+}
+
 TEST_MAIN(BinarySearch)
@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <AK/TestSuite.h>
+
+#include <AK/HashFunctions.h>
+#include <AK/HashTable.h>
+#include <AK/String.h>
+#include <AK/Vector.h>
+
+// Counts how many keys land in an already occupied bucket when hashing them into twice as many
+// buckets as there are keys, using either the low or the high bits of the hash. With a random
+// function that is about 21% of the keys.
+template<typename Hasher>
+static void expect_few_collisions(size_t key_count, Hasher hasher)
+{
+    constexpr size_t bucket_bits = 14;
+    constexpr size_t bucket_count = 1 << bucket_bits;
+    ASSERT(key_count <= bucket_count / 2);
+    for (auto use_high_bits : { false, true }) {
+        HashTable<unsigned> buckets;
+        size_t collisions = 0;
+        for (size_t i = 0; i < key_count; ++i) {
+            unsigned hash = hasher(i);
+            unsigned bucket = use_high_bits ? hash >> (32 - bucket_bits) : hash & (bucket_count - 1);
+            if (buckets.contains(bucket))
+                ++collisions;
+            else
+                buckets.set(bucket);
+        }
+        EXPECT(collisions < key_count / 4);
+    }
+}
+
+TEST_CASE(sequential_integers)
+{
+    expect_few_collisions(8192, [](size_t i) { return int_hash(i); });
+    expect_few_collisions(8192, [](size_t i) { return u64_hash(i); });
+    expect_few_collisions(8192, [](size_t i) { return u64_hash((u64)i << 32); });
+}
+
+TEST_CASE(aligned_pointers)
+{
+    expect_few_collisions(8192, [](size_t i) { return ptr_hash((FlatPtr)0x10000000 + i * 16); });
+    expect_few_collisions(8192, [](size_t i) { return ptr_hash((FlatPtr)0x10000000 + i * 4096); });
+}
+
+TEST_CASE(integer_pairs)
+{
+    expect_few_collisions(8192, [](size_t i) { return pair_int_hash(i % 64, i / 64); });
+}
+
+TEST_CASE(strings)
+{
+    Vector<String> identifiers;
+    Vector<String> paths;
+    for (size_t i = 0; i < 8192; ++i) {
+        identifiers.append(String::format("m_property_%zu", i));
+        paths.append(String::format("/usr/share/res/icons/16x16/filetype-%zu.png", i));
+    }
+    expect_few_collisions(8192, [&](size_t i) { return identifiers[i].hash(); });
+    expect_few_collisions(8192, [&](size_t i) { return paths[i].hash(); });
+    expect_few_collisions(8192, [&](size_t i) { return string_hash((const char*)&i, sizeof(i)); });
+}
+
+TEST_CASE(string_hash_case_folding)
+{
+    EXPECT_EQ(string_hash("", 0), 0u);
+    EXPECT(string_hash("Content-Type", 12) != string_hash("content-type", 12));
+    EXPECT_EQ(case_insensitive_string_hash("Content-Type", 12), string_hash("content-type", 12));
+    EXPECT_EQ(CaseInsensitiveStringTraits::hash("HELLO friends"), CaseInsensitiveStringTraits::hash("hello FRIENDS"));
+    EXPECT_EQ(String("well").hash(), StringView("well").hash());
+}
+
+BENCHMARK_CASE(hash_long_strings)
+{
+    auto string = String::repeated('x', 4096);
+    unsigned total = 0;
+    for (int i = 0; i < 10000; ++i)
+        total += string_hash(string.characters(), string.length() - (i & 7));
+    EXPECT(total != 0);
+}
+
+TEST_MAIN(HashFunctions)
@@ -0,0 +1,264 @@
+/*
+ * Copyright (c) 2018-2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/TestSuite.h>
+
+#include <AK/HashMap.h>
+#include <AK/HashTable.h>
+#include <AK/SinglyLinkedList.h>
+#include <AK/String.h>
+
+TEST_CASE(construct)
+{
+    HashTable<int> table;
+    EXPECT(table.is_empty());
+    EXPECT_EQ(table.size(), 0u);
+    EXPECT(table.begin() == table.end());
+    EXPECT(!table.contains(1));
+}
+
+TEST_CASE(set_replaces_equal_element)
+{
+    HashTable<String, CaseInsensitiveStringTraits> table;
+    table.set("Well");
+    table.set("well");
+    EXPECT_EQ(table.size(), 1u);
+    EXPECT_EQ(*table.begin(), "well");
+}
+
+TEST_CASE(many_elements)
+{
+    HashTable<int> table;
+    for (int i = 0; i < 10000; ++i)
+        table.set(i * 7);
+    EXPECT_EQ(table.size(), 10000u);
+    for (int i = 0; i < 10000; ++i) {
+        EXPECT(table.contains(i * 7));
+        EXPECT(!table.contains(i * 7 + 1));
+    }
+
+    size_t count = 0;
+    for (auto& value : table) {
+        EXPECT_EQ(value % 7, 0);
+        ++count;
+    }
+    EXPECT_EQ(count, 10000u);
+}
+
+TEST_CASE(remove_and_reinsert)
+{
+    HashTable<int> table;
+    for (int i = 0; i < 1000; ++i)
+        table.set(i);
+    for (int i = 0; i < 1000; i += 2)
+        table.remove(i);
+    EXPECT_EQ(table.size(), 500u);
+    for (int i = 0; i < 1000; ++i)
+        EXPECT_EQ(table.contains(i), i % 2 == 1);
+
+    // Churning through tombstones must not grow the table without bound.
+    size_t capacity = table.capacity();
+    for (int round = 0; round < 100; ++round) {
+        for (int i = 0; i < 1000; i += 2)
+            table.set(i);
+        for (int i = 0; i < 1000; i += 2)
+            table.remove(i);
+    }
+    EXPECT_EQ(table.size(), 500u);
+    EXPECT_EQ(table.capacity(), capacity);
+}
+
+TEST_CASE(remove_while_iterating)
+{
+    HashTable<int> table;
+    for (int i = 0; i < 100; ++i)
+        table.set(i);
+    for (auto it = table.begin(); it != table.end();) {
+        auto current = it;
+        ++it;
+        if (*current % 3 == 0)
+            table.remove(current);
+    }
+    EXPECT_EQ(table.size(), 66u);
+    for (int i = 0; i < 100; ++i)
+        EXPECT_EQ(table.contains(i), i % 3 != 0);
+}
+
+TEST_CASE(copy_and_move)
+{
+    HashTable<String> table;
+    table.set("one");
+    table.set("two");
+    table.set("three");
+
+    auto copy = table;
+    EXPECT_EQ(copy.size(), 3u);
+    EXPECT(copy.contains("two"));
+
+    auto moved = move(table);
+    EXPECT_EQ(moved.size(), 3u);
+    EXPECT(table.is_empty());
+    EXPECT(!table.contains("two"));
+
+    moved.clear();
+    EXPECT(moved.is_empty());
+    EXPECT(copy.contains("three"));
+}
+
+TEST_CASE(ensure_capacity)
+{
+    HashTable<int> table;
+    table.ensure_capacity(1000);
+    size_t capacity = table.capacity();
+    EXPECT(capacity >= 1000u);
+    for (int i = 0; i < 1000; ++i)
+        table.set(i);
+    EXPECT_EQ(table.capacity(), capacity);
+}
+
+TEST_CASE(colliding_hashes)
+{
+    struct BadTraits : public GenericTraits<int> {
+        static unsigned hash(int value) { return value % 3; }
+    };
+    HashTable<int, BadTraits> table;
+    for (int i = 0; i < 100; ++i)
+        table.set(i);
+    EXPECT_EQ(table.size(), 100u);
+    for (int i = 0; i < 100; ++i)
+        EXPECT(table.contains(i));
+    table.remove(50);
+    EXPECT(!table.contains(50));
+    EXPECT(table.contains(99));
+}
+
+// A minimal version of the separate-chaining table HashTable used to be, for comparison.
+template<typename T, typename TraitsForT = Traits<T>>
+class ChainedHashTable {
+public:
+    ~ChainedHashTable() { delete[] m_buckets; }
+
+    void set(const T& value)
+    {
+        if (m_size >= m_capacity)
+            rehash(m_size + 1);
+        auto& bucket = m_buckets[TraitsForT::hash(value) % m_capacity];
+        for (auto& element : bucket) {
+            if (TraitsForT::equals(element, value)) {
+                element = value;
+                return;
+            }
+        }
+        bucket.append(value);
+        ++m_size;
+    }
+
+    bool contains(const T& value) const
+    {
+        if (!m_capacity)
+            return false;
+        auto& bucket = m_buckets[TraitsForT::hash(value) % m_capacity];
+        return bucket.find([&](auto& element) { return TraitsForT::equals(element, value); }) != bucket.end();
+    }
+
+private:
+    void rehash(size_t capacity)
+    {
+        capacity *= 2;
+        auto* new_buckets = new SinglyLinkedList<T>[capacity];
+        for (size_t i = 0; i < m_capacity; ++i) {
+            for (auto& value : m_buckets[i])
+                new_buckets[TraitsForT::hash(value) % capacity].append(move(value));
+        }
+        delete[] m_buckets;
+        m_buckets = new_buckets;
+        m_capacity = capacity;
+    }
+
+    SinglyLinkedList<T>* m_buckets { nullptr };
+    size_t m_size { 0 };
+    size_t m_capacity { 0 };
+};
+
+static constexpr int benchmark_element_count = 100000;
+
+template<typename Table>
+static void run_int_benchmark()
+{
+    Table table;
+    for (int i = 0; i < benchmark_element_count; ++i)
+        table.set(i);
+    int found = 0;
+    for (int round = 0; round < 10; ++round) {
+        for (int i = 0; i < benchmark_element_count * 2; ++i)
+            found += table.contains(i);
+    }
+    EXPECT_EQ(found, benchmark_element_count * 10);
+}
+
+template<typename Table>
+static void run_string_benchmark(const Vector<String>& strings)
+{
+    Table table;
+    for (auto& string : strings)
+        table.set(string);
+    int found = 0;
+    for (int round = 0; round < 10; ++round) {
+        for (auto& string : strings)
+            found += table.contains(string);
+    }
+    EXPECT_EQ(found, (int)strings.size() * 10);
+}
+
+static Vector<String> benchmark_strings()
+{
+    Vector<String> strings;
+    for (int i = 0; i < benchmark_element_count / 4; ++i)
+        strings.append(String::format("identifier_%d", i));
+    return strings;
+}
+
+BENCHMARK_CASE(open_addressing_ints)
+{
+    run_int_benchmark<HashTable<int>>();
+}
+
+BENCHMARK_CASE(chained_ints)
+{
+    run_int_benchmark<ChainedHashTable<int>>();
+}
+
+BENCHMARK_CASE(open_addressing_strings)
+{
+    run_string_benchmark<HashTable<String>>(benchmark_strings());
+}
+
+BENCHMARK_CASE(chained_strings)
+{
+    run_string_benchmark<ChainedHashTable<String>>(benchmark_strings());
+}
+
+TEST_MAIN(HashTable)
@@ -29,6 +29,7 @@
 #include <AK/HashMap.h>
 #include <AK/JsonArray.h>
 #include <AK/JsonObject.h>
+#include <AK/JsonPullParser.h>
 #include <AK/JsonValue.h>
 #include <AK/String.h>
 #include <AK/StringBuilder.h>
@@ -108,4 +109,84 @@ TEST_CASE(json_utf8_character)
     EXPECT_EQ(json.as_string().length(), size_t { 2 });
 }
 
+TEST_CASE(json_object_keeps_insertion_order)
+{
+    JsonObject object;
+    for (int i = 0; i < 40; ++i)
+        object.set(String::number(39 - i), i);
+    object.set("20", 100);
+    EXPECT_EQ(object.size(), 40);
+    EXPECT_EQ(object.get("20").to_i32(), 100);
+    EXPECT_EQ(object.get("39").to_i32(), 0);
+    EXPECT(!object.has("40"));
+
+    int expected = 39;
+    object.for_each_member([&](auto& key, auto&) {
+        EXPECT_EQ(key, String::number(expected--));
+    });
+
+    auto copy = object;
+    EXPECT_EQ(copy.get("0").to_i32(), 39);
+}
+
+TEST_CASE(json_pull_parser_events)
+{
+    using Event = JsonPullParser::Event;
+    StringView input = "{ \"a\": [1, -2, 3.5, 18446744073709551615, true, null],\n \"b\\n\": \"x\\ty\", \"c\": {} }";
+    JsonPullParser parser(input);
+
+    EXPECT(parser.next() == Event::BeginObject);
+    EXPECT(parser.next() == Event::Key);
+    EXPECT_EQ(parser.text(), "a");
+    EXPECT_EQ(parser.text().characters_without_null_termination(), input.characters_without_null_termination() + 3);
+    EXPECT(parser.next() == Event::BeginArray);
+    EXPECT_EQ(parser.depth(), 2u);
+
+    auto event = parser.next();
+    EXPECT(event == Event::Number);
+    EXPECT_EQ(parser.value(event).type(), JsonValue::Type::UnsignedInt32);
+    event = parser.next();
+    EXPECT_EQ(parser.value(event).to_i32(), -2);
+    event = parser.next();
+    EXPECT_EQ(parser.value(event).as_double(), 3.5);
+    event = parser.next();
+    EXPECT_EQ(parser.value(event).to_number<u64>(), 18446744073709551615ull);
+    EXPECT(parser.next() == Event::True);
+    EXPECT(parser.next() == Event::Null);
+    EXPECT(parser.next() == Event::EndArray);
+
+    EXPECT(parser.next() == Event::Key);
+    EXPECT_EQ(parser.text(), "b\n");
+    EXPECT(parser.next() == Event::String);
+    EXPECT_EQ(parser.text(), "x\ty");
+
+    EXPECT(parser.next() == Event::Key);
+    EXPECT(parser.skip_value());
+    EXPECT(parser.next() == Event::EndObject);
+    EXPECT(parser.next() == Event::EndOfInput);
+    EXPECT(!parser.has_error());
+}
+
+TEST_CASE(json_pull_parser_errors)
+{
+    using Event = JsonPullParser::Event;
+    auto last_event = [](const StringView& input) {
+        JsonPullParser parser(input);
+        Event event;
+        do {
+            event = parser.next();
+        } while (event != Event::EndOfInput && event != Event::Error);
+        return event;
+    };
+
+    EXPECT(last_event("[1, 2,]") == Event::EndOfInput);
+    EXPECT(last_event("[1 2]") == Event::Error);
+    EXPECT(last_event("{\"a\" 1}") == Event::Error);
+    EXPECT(last_event("{\"a\": 1]") == Event::Error);
+    EXPECT(last_event("\"unterminated") == Event::Error);
+    EXPECT(last_event("tru") == Event::Error);
+
+    EXPECT(JsonValue::from_string("[1, {\"a\": ]").is_null());
+}
+
 TEST_MAIN(JSON)
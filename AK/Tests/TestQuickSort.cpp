@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) 2018-2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/TestSuite.h>
+
+#include <AK/MergeSort.h>
+#include <AK/NonnullOwnPtr.h>
+#include <AK/QuickSort.h>
+#include <AK/Vector.h>
+
+static bool is_sorted(const Vector<int>& ints)
+{
+    for (size_t i = 1; i < ints.size(); ++i) {
+        if (ints[i] < ints[i - 1])
+            return false;
+    }
+    return true;
+}
+
+static Vector<int> pseudo_random_ints(size_t count)
+{
+    Vector<int> ints;
+    u32 state = 12345;
+    for (size_t i = 0; i < count; ++i) {
+        state = state * 1103515245 + 12345;
+        ints.append((state >> 16) % 1000);
+    }
+    return ints;
+}
+
+TEST_CASE(sorts_empty_and_single_element)
+{
+    Vector<int> ints;
+    quick_sort(ints);
+    merge_sort(ints);
+    EXPECT(ints.is_empty());
+
+    ints.append(42);
+    quick_sort(ints);
+    merge_sort(ints);
+    EXPECT_EQ(ints.size(), 1u);
+    EXPECT_EQ(ints[0], 42);
+}
+
+TEST_CASE(sorts_sorted_reversed_and_equal_input)
+{
+    Vector<int> sorted;
+    Vector<int> reversed;
+    Vector<int> equal;
+    for (int i = 0; i < 10000; ++i) {
+        sorted.append(i);
+        reversed.append(10000 - i);
+        equal.append(7);
+    }
+
+    quick_sort(sorted);
+    quick_sort(reversed);
+    quick_sort(equal);
+    EXPECT(is_sorted(sorted));
+    EXPECT(is_sorted(reversed));
+    EXPECT(is_sorted(equal));
+    EXPECT_EQ(reversed[0], 1);
+}
+
+TEST_CASE(sorts_random_input)
+{
+    for (size_t count : { 2, 3, 16, 17, 100, 5000 }) {
+        auto quick = pseudo_random_ints(count);
+        auto merge = quick;
+        quick_sort(quick);
+        merge_sort(merge);
+        EXPECT(is_sorted(quick));
+        EXPECT(is_sorted(merge));
+        EXPECT(quick == merge);
+    }
+}
+
+TEST_CASE(iterator_and_pointer_ranges)
+{
+    auto ints = pseudo_random_ints(1000);
+    quick_sort(ints.begin(), ints.end());
+    EXPECT(is_sorted(ints));
+
+    int array[] = { 5, 3, 9, 1, 7, 2, 8, 4, 6, 0 };
+    quick_sort(array, array + 10, [](int a, int b) { return a > b; });
+    for (int i = 0; i < 10; ++i)
+        EXPECT_EQ(array[i], 9 - i);
+}
+
+TEST_CASE(merge_sort_is_stable)
+{
+    struct Item {
+        int key;
+        size_t original_index;
+    };
+
+    Vector<Item> items;
+    auto keys = pseudo_random_ints(2000);
+    for (size_t i = 0; i < keys.size(); ++i)
+        items.append({ keys[i] % 10, i });
+
+    merge_sort(items, [](auto& a, auto& b) { return a.key < b.key; });
+
+    for (size_t i = 1; i < items.size(); ++i) {
+        EXPECT(items[i - 1].key <= items[i].key);
+        if (items[i - 1].key == items[i].key)
+            EXPECT(items[i - 1].original_index < items[i].original_index);
+    }
+}
+
+TEST_CASE(sorts_move_only_types)
+{
+    Vector<NonnullOwnPtr<int>> pointers;
+    for (int i = 0; i < 100; ++i)
+        pointers.append(make<int>((i * 37) % 100));
+
+    quick_sort(pointers, [](auto& a, auto& b) { return *a < *b; });
+    for (int i = 0; i < 100; ++i)
+        EXPECT_EQ(*pointers[i], i);
+}
+
+TEST_MAIN(QuickSort)
@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <AK/TestSuite.h>
+
+#include <AK/JsonArray.h>
+#include <AK/JsonObject.h>
+#include <AK/SegmentedStringBuilder.h>
+#include <AK/String.h>
+#include <AK/StringBuilder.h>
+
+TEST_CASE(empty)
+{
+    SegmentedStringBuilder builder;
+    EXPECT(builder.is_empty());
+    EXPECT_EQ(builder.segment_count(), 0u);
+    EXPECT(builder.to_string().is_empty());
+    EXPECT_EQ(builder.to_byte_buffer().size(), 0u);
+}
+
+TEST_CASE(append_across_segments)
+{
+    SegmentedStringBuilder builder;
+    StringBuilder expected;
+    for (int i = 0; i < 1000; ++i) {
+        builder.appendf("%d,", i);
+        expected.appendf("%d,", i);
+    }
+    builder.append('!');
+    expected.append('!');
+    EXPECT(builder.segment_count() > 1u);
+    EXPECT_EQ(builder.length(), expected.length());
+    EXPECT_EQ(builder.to_string(), expected.to_string());
+
+    size_t total = 0;
+    builder.for_each_segment([&](const StringView& segment) {
+        EXPECT(expected.string_view().substring_view(total, segment.length()) == segment);
+        total += segment.length();
+    });
+    EXPECT_EQ(total, builder.length());
+}
+
+TEST_CASE(large_append)
+{
+    SegmentedStringBuilder builder;
+    builder.append("head");
+    auto big = String::repeated('x', 100000);
+    builder.append(big);
+    builder.append("tail");
+    EXPECT_EQ(builder.length(), 100008u);
+    EXPECT_EQ(builder.segment_count(), 3u);
+    auto string = builder.to_string();
+    EXPECT(string.starts_with("headxxx"));
+    EXPECT(string.ends_with("xxxtail"));
+}
+
+TEST_CASE(clear)
+{
+    SegmentedStringBuilder builder;
+    builder.append(String::repeated('a', 1000));
+    builder.clear();
+    EXPECT(builder.is_empty());
+    builder.join(", ", Vector<String> { "one", "two" });
+    EXPECT_EQ(builder.to_string(), "one, two");
+}
+
+TEST_CASE(json_serialization)
+{
+    JsonObject object;
+    JsonArray array;
+    for (int i = 0; i < 100; ++i)
+        array.append(i);
+    object.set("numbers", move(array));
+    object.set("name", "segmented");
+    EXPECT_EQ(object.serialized<SegmentedStringBuilder>(), object.to_string());
+}
+
+BENCHMARK_CASE(build_large_output)
+{
+    for (int round = 0; round < 5; ++round) {
+        SegmentedStringBuilder builder;
+        for (int i = 0; i < 100000; ++i)
+            builder.append("some line of output\n");
+        EXPECT_EQ(builder.to_string().length(), 2000000u);
+    }
+}
+
+TEST_MAIN(SegmentedStringBuilder)
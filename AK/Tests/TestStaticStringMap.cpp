@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <AK/TestSuite.h>
+
+#include <AK/StaticStringMap.h>
+#include <AK/String.h>
+
+enum class Fruit {
+    Apple,
+    Banana,
+    Cherry,
+    Durian,
+};
+
+static constexpr auto s_fruits = make_static_string_map<Fruit>({
+    { "apple", Fruit::Apple },
+    { "banana", Fruit::Banana },
+    { "cherry", Fruit::Cherry },
+    { "durian", Fruit::Durian },
+    { "", Fruit::Apple },
+});
+
+static_assert(s_fruits.size() == 5);
+static_assert(s_fruits.max_key_length() == 6);
+
+TEST_CASE(lookup)
+{
+    EXPECT(s_fruits.get("apple") && *s_fruits.get("apple") == Fruit::Apple);
+    EXPECT(s_fruits.get("durian") && *s_fruits.get("durian") == Fruit::Durian);
+    EXPECT(s_fruits.get("") && *s_fruits.get("") == Fruit::Apple);
+    EXPECT(!s_fruits.get("appl"));
+    EXPECT(!s_fruits.get("apples"));
+    EXPECT(!s_fruits.get("Apple"));
+    EXPECT(!s_fruits.get("grapefruit"));
+
+    StringView prefix = StringView("cherry pie").substring_view(0, 6);
+    EXPECT(s_fruits.contains(prefix));
+}
+
+TEST_CASE(case_insensitive)
+{
+    static constexpr auto map = make_static_string_map<int>({ { "color", 1 }, { "background-color", 2 } }, CaseSensitivity::CaseInsensitive);
+    EXPECT(map.get("COLOR") && *map.get("COLOR") == 1);
+    EXPECT(map.get("Background-Color") && *map.get("Background-Color") == 2);
+    EXPECT(!map.get("colour"));
+}
+
+TEST_CASE(many_keys)
+{
+    // Exercise collisions and wrap-around in a table that is built at runtime.
+    static const char* const keys[] = { "a", "b", "c", "d", "e", "f", "g", "h", "aa", "ab", "ac", "ad", "ae", "af", "ag", "ah", "ba", "bb", "bc", "bd" };
+    StaticStringMapEntry<int> entries[20] {};
+    for (int i = 0; i < 20; ++i)
+        entries[i] = { keys[i], i };
+    auto map = make_static_string_map<int>(entries);
+    for (int i = 0; i < 20; ++i) {
+        auto* value = map.get(keys[i]);
+        EXPECT(value && *value == i);
+    }
+    EXPECT(!map.get("z"));
+    EXPECT(!map.get("be"));
+}
+
+TEST_MAIN(StaticStringMap)
@@ -27,8 +27,10 @@
 #include <AK/TestSuite.h>
 
 #include <AK/FlyString.h>
+#include <AK/HashTable.h>
 #include <AK/String.h>
 #include <AK/StringBuilder.h>
+#include <ctype.h>
 #include <cstring>
 
 TEST_CASE(construct_empty)
@@ -162,6 +164,32 @@ TEST_CASE(flystring)
     }
 }
 
+TEST_CASE(flystring_interning)
+{
+    auto before = FlyString::intern_statistics();
+    {
+        FlyString a("interned_once");
+        FlyString b(StringView("interned_once_and_more").substring_view(0, 13));
+        FlyString c(String("interned_once"));
+        EXPECT_EQ(a.impl(), b.impl());
+        EXPECT_EQ(a.impl(), c.impl());
+        EXPECT(a.impl()->is_fly());
+
+        auto during = FlyString::intern_statistics();
+        EXPECT_EQ(during.size, before.size + 1);
+        EXPECT_EQ(during.lookups, before.lookups + 3);
+        EXPECT_EQ(during.hits, before.hits + 2);
+    }
+
+    // Dropping the last FlyString takes the string out of the table again.
+    EXPECT_EQ(FlyString::intern_statistics().size, before.size);
+
+    FlyString x("x");
+    EXPECT_EQ(x.impl(), String("x").impl());
+    EXPECT(FlyString("").is_empty());
+    EXPECT(FlyString((const char*)nullptr).is_null());
+}
+
 TEST_CASE(replace)
 {
     String test_string = "Well, hello Friends!";
@@ -210,4 +238,70 @@ TEST_CASE(builder_zero_initial_capacity)
    EXPECT_EQ(built.length(), 0u);
 }
 
+TEST_CASE(single_character_strings_are_shared)
+{
+    String a = "x";
+    String b = StringView("xyz").substring_view(0, 1);
+    String c = String::repeated('x', 1);
+    String d = String("X").to_lowercase();
+    EXPECT_EQ(a.impl(), b.impl());
+    EXPECT_EQ(a.impl(), c.impl());
+    EXPECT_EQ(a.impl(), d.impl());
+    EXPECT_EQ(d, "x");
+    EXPECT_EQ(String("y").to_uppercase(), "Y");
+
+    FlyString fly = a;
+    EXPECT_EQ(fly.impl(), a.impl());
+}
+
+static const char* benchmark_source = "function f(a, b) { return a + b * (c - 1); } var x = f(1, 2); if (x >= 3) { x++; }";
+
+static Vector<String> tokenize_benchmark_source()
+{
+    Vector<String> tokens;
+    StringView source(benchmark_source);
+    for (size_t i = 0; i < source.length();) {
+        if (source[i] == ' ') {
+            ++i;
+            continue;
+        }
+        size_t length = 1;
+        if (isalnum(source[i])) {
+            while (i + length < source.length() && isalnum(source[i + length]))
+                ++length;
+        }
+        tokens.append(source.substring_view(i, length));
+        i += length;
+    }
+    return tokens;
+}
+
+BENCHMARK_CASE(tokenize_allocation_count)
+{
+    // Every multi-character token needs a StringImpl of its own, but one-character
+    // tokens all share one per character, so the count stays flat across rounds.
+    HashTable<const StringImpl*> single_character_impls;
+    size_t multi_character_allocations = 0;
+    for (int round = 0; round < 1000; ++round) {
+        for (auto& token : tokenize_benchmark_source()) {
+            if (token.length() == 1)
+                single_character_impls.set(token.impl());
+            else
+                ++multi_character_allocations;
+        }
+    }
+    EXPECT(single_character_impls.size() <= 20u);
+    EXPECT(multi_character_allocations > 0u);
+}
+
+BENCHMARK_CASE(tokenize_throughput)
+{
+    size_t total_length = 0;
+    for (int round = 0; round < 10000; ++round) {
+        for (auto& token : tokenize_benchmark_source())
+            total_length += token.length();
+    }
+    EXPECT(total_length > 0);
+}
+
 TEST_MAIN(String)
@@ -26,7 +26,10 @@
 
 #include <AK/TestSuite.h>
 
+#include <AK/String.h>
+#include <AK/StringBuilder.h>
 #include <AK/Utf8View.h>
+#include <AK/Vector.h>
 
 TEST_CASE(decode_ascii)
 {
@@ -88,4 +91,64 @@ TEST_CASE(validate_invalid_ut8)
     EXPECT(valid_bytes == 0);
 }
 
+TEST_CASE(validate_invalid_after_ascii_run)
+{
+    size_t valid_bytes;
+    char invalid_utf8[] = "0123456789abcdefghij\xd0\xd0";
+    Utf8View utf8 { invalid_utf8 };
+    EXPECT(!utf8.validate(valid_bytes));
+    EXPECT_EQ(valid_bytes, 20u);
+}
+
+TEST_CASE(length_in_codepoints)
+{
+    EXPECT_EQ(Utf8View { "" }.length_in_codepoints(), 0u);
+    EXPECT_EQ(Utf8View { "Hello World!11" }.length_in_codepoints(), 14u);
+    EXPECT_EQ(Utf8View { "Привет, мир! 😀 γειά σου κόσμος こんにちは世界" }.length_in_codepoints(), 38u);
+}
+
+TEST_CASE(decode_to_utf32)
+{
+    Utf8View utf8 { "ASCII prefix that is long, Привет, мир! 😀 こんにちは世界 and an ASCII tail" };
+    Vector<u32> expected;
+    for (u32 codepoint : utf8)
+        expected.append(codepoint);
+
+    Vector<u32> codepoints;
+    codepoints.resize(utf8.length_in_codepoints());
+    EXPECT_EQ(codepoints.size(), expected.size());
+    EXPECT_EQ(utf8.decode_to_utf32(codepoints.data()), expected.size());
+    for (size_t i = 0; i < expected.size(); ++i)
+        EXPECT_EQ(codepoints[i], expected[i]);
+}
+
+static String make_text(const char* line, size_t count)
+{
+    StringBuilder builder;
+    for (size_t i = 0; i < count; ++i)
+        builder.append(line);
+    return builder.to_string();
+}
+
+static void decode_repeatedly(const String& text)
+{
+    Utf8View utf8 { text };
+    Vector<u32> codepoints;
+    for (int i = 0; i < 10; ++i) {
+        EXPECT(utf8.validate());
+        codepoints.resize(utf8.length_in_codepoints());
+        utf8.decode_to_utf32(codepoints.data());
+    }
+}
+
+BENCHMARK_CASE(decode_ascii_heavy)
+{
+    decode_repeatedly(make_text("The quick brown fox jumps over the lazy dog, again and again.\n", 20000));
+}
+
+BENCHMARK_CASE(decode_cjk_heavy)
+{
+    decode_repeatedly(make_text("敏捷的棕色狐狸跳过了懒狗，一次又一次。こんにちは世界\n", 20000));
+}
+
 TEST_MAIN(UTF8)
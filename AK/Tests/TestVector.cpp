@@ -313,4 +313,140 @@ TEST_CASE(insert_trivial)
     EXPECT_EQ(ints[5], 40);
 }
 
+static_assert(IsTriviallyRelocatable<int>::value);
+static_assert(IsTriviallyRelocatable<String>::value);
+static_assert(IsTriviallyRelocatable<OwnPtr<int>>::value);
+static_assert(IsTriviallyRelocatable<Vector<String>>::value);
+static_assert(IsTriviallyRelocatable<Vector<String, 4>>::value);
+
+// Keeps a pointer to itself, so it must never be moved with memcpy().
+struct SelfPointing {
+    SelfPointing(int v)
+        : value(v)
+    {
+        ++s_alive;
+    }
+    SelfPointing(SelfPointing&& other)
+        : value(other.value)
+    {
+        ASSERT(other.self == &other);
+        ++s_alive;
+    }
+    SelfPointing(const SelfPointing& other)
+        : value(other.value)
+    {
+        ASSERT(other.self == &other);
+        ++s_alive;
+    }
+    ~SelfPointing()
+    {
+        ASSERT(self == this);
+        --s_alive;
+    }
+    SelfPointing& operator=(SelfPointing&&) = delete;
+
+    SelfPointing* self { this };
+    int value { 0 };
+    static int s_alive;
+};
+int SelfPointing::s_alive = 0;
+
+static_assert(!IsTriviallyRelocatable<SelfPointing>::value);
+
+TEST_CASE(relocate_non_relocatable_type)
+{
+    {
+        Vector<SelfPointing, 2> objects;
+        for (int i = 0; i < 20; ++i)
+            objects.append(SelfPointing(i));
+        objects.insert(0, SelfPointing(-1));
+        objects.insert(10, SelfPointing(100));
+        objects.remove(5);
+        objects.prepend(Vector<SelfPointing, 2> {});
+        EXPECT_EQ(objects.size(), 21u);
+        EXPECT_EQ(objects[0].value, -1);
+        EXPECT_EQ(objects[5].value, 5);
+        EXPECT_EQ(objects[9].value, 100);
+        EXPECT_EQ(objects.last().value, 19);
+        for (auto& object : objects)
+            EXPECT(object.self == &object);
+        EXPECT_EQ(SelfPointing::s_alive, 21);
+
+        auto moved = move(objects);
+        EXPECT_EQ(moved.size(), 21u);
+        EXPECT_EQ(SelfPointing::s_alive, 21);
+    }
+    EXPECT_EQ(SelfPointing::s_alive, 0);
+}
+
+TEST_CASE(relocate_strings)
+{
+    Vector<String, 4> strings;
+    for (int i = 0; i < 100; ++i)
+        strings.append(String::number(i));
+    strings.insert(0, "first");
+    strings.insert(50, "middle");
+    strings.remove(1);
+    EXPECT_EQ(strings.size(), 101u);
+    EXPECT_EQ(strings[0], "first");
+    EXPECT_EQ(strings[1], "1");
+    EXPECT_EQ(strings[48], "48");
+    EXPECT_EQ(strings[49], "middle");
+    EXPECT_EQ(strings[50], "49");
+    EXPECT_EQ(strings.last(), "99");
+
+    Vector<Vector<String, 4>> nested;
+    for (int i = 0; i < 20; ++i) {
+        Vector<String, 4> inner;
+        inner.append(String::number(i));
+        nested.append(move(inner));
+    }
+    nested.remove(0);
+    EXPECT_EQ(nested.size(), 19u);
+    EXPECT_EQ(nested[0][0], "1");
+    EXPECT_EQ(nested.last()[0], "19");
+}
+
+BENCHMARK_CASE(vector_append_strings)
+{
+    String string = "hello friends";
+    for (int i = 0; i < 10; ++i) {
+        Vector<String> strings;
+        for (int j = 0; j < 100000; ++j)
+            strings.append(string);
+        EXPECT_EQ(strings.size(), 100000u);
+    }
+}
+
+BENCHMARK_CASE(vector_append_bytes)
+{
+    for (int i = 0; i < 10; ++i) {
+        Vector<u8> bytes;
+        for (int j = 0; j < 1000000; ++j)
+            bytes.append((u8)j);
+        EXPECT_EQ(bytes.size(), 1000000u);
+    }
+}
+
+BENCHMARK_CASE(vector_insert_front_strings)
+{
+    String string = "hello friends";
+    Vector<String> strings;
+    for (int i = 0; i < 10000; ++i)
+        strings.insert(0, string);
+    EXPECT_EQ(strings.size(), 10000u);
+}
+
+BENCHMARK_CASE(vector_remove_front_strings)
+{
+    String string = "hello friends";
+    Vector<String> strings;
+    strings.ensure_capacity(10000);
+    for (int i = 0; i < 10000; ++i)
+        strings.unchecked_append(string);
+    while (!strings.is_empty())
+        strings.remove(0);
+    EXPECT_EQ(strings.size(), 0u);
+}
+
 TEST_MAIN(Vector)
@@ -66,6 +66,12 @@ struct Traits<u64> : public GenericTraits<u64> {
     static unsigned hash(u64 u) { return u64_hash(u); }
 };
 
+template<>
+struct Traits<u8> : public GenericTraits<u8> {
+    static constexpr bool is_trivial() { return true; }
+    static unsigned hash(u8 u) { return int_hash(u); }
+};
+
 template<>
 struct Traits<char> : public GenericTraits<char> {
     static constexpr bool is_trivial() { return true; }
@@ -74,10 +80,7 @@ struct Traits<char> : public GenericTraits<char> {
 
 template<typename T>
 struct Traits<T*> : public GenericTraits<T*> {
-    static unsigned hash(const T* p)
-    {
-        return int_hash((unsigned)(__PTRDIFF_TYPE__)p);
-    }
+    static unsigned hash(const T* p) { return ptr_hash(p); }
     static constexpr bool is_trivial() { return true; }
     static bool equals(const T* a, const T* b) { return a == b; }
 };
@@ -62,6 +62,7 @@ typedef i64 int64_t;
 typedef int pid_t;
 
 #else
+#    include <stddef.h>
 #    include <stdint.h>
 #    include <sys/types.h>
 
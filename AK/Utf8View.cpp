@@ -111,10 +111,38 @@ static inline bool decode_first_byte(
     return false;
 }
 
+// ASCII text is handled a machine word at a time: a word holds only ASCII if none of its bytes
+// have the high bit set.
+using Utf8Word = FlatPtr;
+static constexpr Utf8Word utf8_high_bits = (Utf8Word)0x8080808080808080ull;
+
+static inline Utf8Word load_word(const unsigned char* ptr)
+{
+    Utf8Word word;
+    __builtin_memcpy(&word, ptr, sizeof(word));
+    return word;
+}
+
+static inline const unsigned char* skip_ascii(const unsigned char* ptr, const unsigned char* end)
+{
+    while (end - ptr >= (ssize_t)sizeof(Utf8Word) && !(load_word(ptr) & utf8_high_bits))
+        ptr += sizeof(Utf8Word);
+    while (ptr < end && !(*ptr & 128))
+        ++ptr;
+    return ptr;
+}
+
 bool Utf8View::validate(size_t& valid_bytes) const
 {
     valid_bytes = 0;
-    for (auto ptr = begin_ptr(); ptr < end_ptr(); ptr++) {
+    auto* ptr = begin_ptr();
+    while (ptr < end_ptr()) {
+        auto* ascii_end = skip_ascii(ptr, end_ptr());
+        valid_bytes += ascii_end - ptr;
+        ptr = ascii_end;
+        if (ptr >= end_ptr())
+            break;
+
         int codepoint_length_in_bytes;
         u32 value;
         bool first_byte_makes_sense = decode_first_byte(*ptr, codepoint_length_in_bytes, value);
@@ -122,13 +150,13 @@ bool Utf8View::validate(size_t& valid_bytes) const
             return false;
 
         for (int i = 1; i < codepoint_length_in_bytes; i++) {
-            ptr++;
-            if (ptr >= end_ptr())
+            if (ptr + i >= end_ptr())
                 return false;
-            if (*ptr >> 6 != 2)
+            if (ptr[i] >> 6 != 2)
                 return false;
         }
 
+        ptr += codepoint_length_in_bytes;
         valid_bytes += codepoint_length_in_bytes;
     }
 
@@ -137,12 +165,49 @@ bool Utf8View::validate(size_t& valid_bytes) const
 
 size_t Utf8View::length_in_codepoints() const
 {
-    size_t length = 0;
-    for (auto codepoint : *this) {
-        (void)codepoint;
-        ++length;
+    // Every byte except the continuation bytes (10xxxxxx) starts a codepoint.
+    size_t continuation_bytes = 0;
+    auto* ptr = begin_ptr();
+    for (; end_ptr() - ptr >= (ssize_t)sizeof(Utf8Word); ptr += sizeof(Utf8Word)) {
+        auto word = load_word(ptr);
+        continuation_bytes += __builtin_popcountll((u64)(word & ~(word << 1) & utf8_high_bits));
+    }
+    for (; ptr < end_ptr(); ++ptr) {
+        if (*ptr >> 6 == 2)
+            ++continuation_bytes;
+    }
+    return m_string.length() - continuation_bytes;
+}
+
+size_t Utf8View::decode_to_utf32(u32* codepoints) const
+{
+    auto* out = codepoints;
+    auto* ptr = begin_ptr();
+    while (ptr < end_ptr()) {
+        if (end_ptr() - ptr >= (ssize_t)sizeof(Utf8Word) && !(load_word(ptr) & utf8_high_bits)) {
+            for (size_t i = 0; i < sizeof(Utf8Word); ++i)
+                *(out++) = ptr[i];
+            ptr += sizeof(Utf8Word);
+            continue;
+        }
+        if (!(*ptr & 128)) {
+            *(out++) = *(ptr++);
+            continue;
+        }
+
+        int codepoint_length_in_bytes = 0;
+        u32 codepoint = 0;
+        bool first_byte_makes_sense = decode_first_byte(*ptr, codepoint_length_in_bytes, codepoint);
+        ASSERT(first_byte_makes_sense);
+        ASSERT(codepoint_length_in_bytes <= end_ptr() - ptr);
+        for (int offset = 1; offset < codepoint_length_in_bytes; offset++) {
+            ASSERT(ptr[offset] >> 6 == 2);
+            codepoint = (codepoint << 6) | (ptr[offset] & 63);
+        }
+        *(out++) = codepoint;
+        ptr += codepoint_length_in_bytes;
     }
-    return length;
+    return out - codepoints;
 }
 
 Utf8CodepointIterator::Utf8CodepointIterator(const unsigned char* ptr, int length)
@@ -79,6 +79,10 @@ public:
 
     size_t length_in_codepoints() const;
 
+    // Decodes the whole view into a buffer with room for length_in_codepoints() codepoints,
+    // and returns the number of codepoints written.
+    size_t decode_to_utf32(u32* codepoints) const;
+
 private:
     const unsigned char* begin_ptr() const;
     const unsigned char* end_ptr() const;
@@ -103,6 +103,29 @@ public:
             new (&destination[i]) T(AK::move(source[i]));
     }
 
+    // Moves count objects into uninitialized memory at destination and ends the lifetime of the
+    // objects at source. The two ranges may overlap.
+    static void relocate(T* destination, T* source, size_t count)
+    {
+        if (!count || destination == source)
+            return;
+        if constexpr (IsTriviallyRelocatable<T>::value) {
+            __builtin_memmove((void*)destination, (const void*)source, count * sizeof(T));
+            return;
+        }
+        if (destination < source) {
+            for (size_t i = 0; i < count; ++i) {
+                new (&destination[i]) T(AK::move(source[i]));
+                source[i].~T();
+            }
+        } else {
+            for (size_t i = count; i > 0; --i) {
+                new (&destination[i - 1]) T(AK::move(source[i - 1]));
+                source[i - 1].~T();
+            }
+        }
+    }
+
     static void copy(T* destination, const T* source, size_t count)
     {
         if (!count)
@@ -159,12 +182,8 @@ public:
         , m_outline_buffer(other.m_outline_buffer)
     {
         if constexpr (inline_capacity > 0) {
-            if (!m_outline_buffer) {
-                for (size_t i = 0; i < m_size; ++i) {
-                    new (&inline_buffer()[i]) T(move(other.inline_buffer()[i]));
-                    other.inline_buffer()[i].~T();
-                }
-            }
+            if (!m_outline_buffer)
+                TypedTransfer<T>::relocate(inline_buffer(), other.inline_buffer(), m_size);
         }
         other.m_outline_buffer = nullptr;
         other.m_size = 0;
@@ -195,12 +214,8 @@ public:
             m_capacity = other.m_capacity;
             m_outline_buffer = other.m_outline_buffer;
             if constexpr (inline_capacity > 0) {
-                if (!m_outline_buffer) {
-                    for (size_t i = 0; i < m_size; ++i) {
-                        new (&inline_buffer()[i]) T(move(other.inline_buffer()[i]));
-                        other.inline_buffer()[i].~T();
-                    }
-                }
+                if (!m_outline_buffer)
+                    TypedTransfer<T>::relocate(inline_buffer(), other.inline_buffer(), m_size);
             }
             other.m_outline_buffer = nullptr;
             other.m_size = 0;
@@ -321,16 +336,8 @@ public:
     {
         ASSERT(index < m_size);
 
-        if constexpr (Traits<T>::is_trivial()) {
-            TypedTransfer<T>::copy(slot(index), slot(index + 1), m_size - index - 1);
-        } else {
-            at(index).~T();
-            for (size_t i = index + 1; i < m_size; ++i) {
-                new (slot(i - 1)) T(move(at(i)));
-                at(i).~T();
-            }
-        }
-
+        at(index).~T();
+        TypedTransfer<T>::relocate(slot(index), slot(index + 1), m_size - index - 1);
         --m_size;
     }
 
@@ -340,15 +347,8 @@ public:
         if (index == size())
             return append(move(value));
         grow_capacity(size() + 1);
+        TypedTransfer<T>::relocate(slot(index + 1), slot(index), m_size - index);
         ++m_size;
-        if constexpr (Traits<T>::is_trivial()) {
-            TypedTransfer<T>::move(slot(index + 1), slot(index), m_size - index - 1);
-        } else {
-            for (size_t i = size() - 1; i > index; --i) {
-                new (slot(i)) T(move(at(i - 1)));
-                at(i - 1).~T();
-            }
-        }
         new (slot(index)) T(move(value));
     }
 
@@ -492,10 +492,7 @@ public:
         auto other_size = other.size();
         grow_capacity(size() + other_size);
 
-        for (size_t i = size() + other_size - 1; i >= other.size(); --i) {
-            new (slot(i)) T(move(at(i - other_size)));
-            at(i - other_size).~T();
-        }
+        TypedTransfer<T>::relocate(slot(other_size), slot(0), size());
 
         Vector tmp = move(other);
         TypedTransfer<T>::move(slot(0), tmp.data(), tmp.size());
@@ -523,16 +520,20 @@ public:
         if (m_capacity >= needed_capacity)
             return;
         size_t new_capacity = needed_capacity;
-        auto* new_buffer = (T*)kmalloc(new_capacity * sizeof(T));
 
-        if constexpr (Traits<T>::is_trivial()) {
-            TypedTransfer<T>::copy(new_buffer, data(), m_size);
-        } else {
-            for (size_t i = 0; i < m_size; ++i) {
-                new (&new_buffer[i]) T(move(at(i)));
-                at(i).~T();
+        if constexpr (IsTriviallyRelocatable<T>::value) {
+            // The allocator can often grow the buffer in place, and otherwise copies it for us.
+            if (m_outline_buffer) {
+                m_outline_buffer = (T*)krealloc((void*)m_outline_buffer, new_capacity * sizeof(T));
+                m_capacity = new_capacity;
+                return;
             }
         }
+
+        auto* new_buffer = (T*)kmalloc(new_capacity * sizeof(T));
+        // Without an inline buffer, there's only something to move if we had an outline one already.
+        if (inline_capacity || m_outline_buffer)
+            TypedTransfer<T>::relocate(new_buffer, data(), m_size);
         if (m_outline_buffer)
             kfree(m_outline_buffer);
         m_outline_buffer = new_buffer;
@@ -629,7 +630,7 @@ private:
 
     static size_t padded_capacity(size_t capacity)
     {
-        return max(static_cast<size_t>(4), capacity + (capacity / 4) + 4);
+        return max(static_cast<size_t>(4), capacity + (capacity / 2));
     }
 
     T* slot(size_t i) { return &data()[i]; }
@@ -653,6 +654,11 @@ private:
     T* m_outline_buffer { nullptr };
 };
 
+template<typename T, size_t inline_capacity>
+struct IsTriviallyRelocatable<Vector<T, inline_capacity>> {
+    static constexpr bool value = inline_capacity == 0 || IsTriviallyRelocatable<T>::value;
+};
+
 }
 
 using AK::Vector;
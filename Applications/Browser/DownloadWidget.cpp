@@ -26,7 +26,6 @@
 
 #include "DownloadWidget.h"
 #include <AK/NumberFormat.h>
-#include <AK/SharedBuffer.h>
 #include <AK/StringBuilder.h>
 #include <LibCore/File.h>
 #include <LibCore/StandardPaths.h>
@@ -60,8 +59,11 @@ DownloadWidget::DownloadWidget(const URL& url)
     m_download->on_progress = [this](Optional<u32> total_size, u32 downloaded_size) {
         did_progress(total_size.value(), downloaded_size);
     };
-    m_download->on_finish = [this](bool success, auto& payload, auto payload_storage, auto& response_headers) {
-        did_finish(success, payload, payload_storage, response_headers);
+    m_download->on_data = [this](auto& data) {
+        did_receive_data(data);
+    };
+    m_download->on_finish = [this](bool success, auto&, auto&) {
+        did_finish(success);
     };
 
     set_fill_with_background_color(true);
@@ -160,11 +162,34 @@ void DownloadWidget::did_progress(Optional<u32> total_size, u32 downloaded_size)
     }
 }
 
-void DownloadWidget::did_finish(bool success, const ByteBuffer& payload, RefPtr<SharedBuffer> payload_storage, const HashMap<String, String, CaseInsensitiveStringTraits>& response_headers)
+bool DownloadWidget::open_destination_file()
+{
+    auto file_or_error = Core::File::open(m_destination_path, Core::IODevice::WriteOnly);
+    if (file_or_error.is_error()) {
+        m_failed_to_open_destination_file = true;
+        return false;
+    }
+    m_destination_file = file_or_error.value();
+    return true;
+}
+
+void DownloadWidget::did_receive_data(const ByteBuffer& data)
+{
+    if (m_failed_to_open_destination_file)
+        return;
+    if (!m_destination_file && !open_destination_file()) {
+        // There's no point in downloading the rest of it.
+        deferred_invoke([this](auto&) {
+            m_download->stop();
+        });
+        return;
+    }
+    bool write_success = m_destination_file->write(data.data(), data.size());
+    ASSERT(write_success);
+}
+
+void DownloadWidget::did_finish(bool success)
 {
-    (void)payload;
-    (void)payload_storage;
-    (void)response_headers;
     dbg() << "did_finish, success=" << success;
 
     m_close_button->set_enabled(true);
@@ -175,22 +200,23 @@ void DownloadWidget::did_finish(bool success, const ByteBuffer& payload, RefPtr<
     };
     m_cancel_button->update();
 
-    if (!success) {
-        GUI::MessageBox::show(String::format("Download failed for some reason"), "Download failed", GUI::MessageBox::Type::Error, GUI::MessageBox::InputType::OK, window());
+    // Even an empty download gets its file.
+    if (success && !m_destination_file && !m_failed_to_open_destination_file)
+        open_destination_file();
+
+    if (m_failed_to_open_destination_file) {
+        GUI::MessageBox::show(String::format("Cannot open %s for writing", m_destination_path.characters()), "Download failed", GUI::MessageBox::Type::Error, GUI::MessageBox::InputType::OK, window());
         window()->close();
         return;
     }
 
-    auto file_or_error = Core::File::open(m_destination_path, Core::IODevice::WriteOnly);
-    if (file_or_error.is_error()) {
-        GUI::MessageBox::show(String::format("Cannot open %s for writing", m_destination_path.characters()), "Download failed", GUI::MessageBox::Type::Error, GUI::MessageBox::InputType::OK, window());
+    if (!success) {
+        GUI::MessageBox::show(String::format("Download failed for some reason"), "Download failed", GUI::MessageBox::Type::Error, GUI::MessageBox::InputType::OK, window());
         window()->close();
         return;
     }
 
-    auto& file = *file_or_error.value();
-    bool write_success = file.write(payload.data(), payload.size());
-    ASSERT(write_success);
+    m_destination_file->close();
 }
 
 }
@@ -28,6 +28,7 @@
 
 #include <AK/URL.h>
 #include <LibCore/ElapsedTimer.h>
+#include <LibCore/Forward.h>
 #include <LibGUI/ProgressBar.h>
 #include <LibGUI/Widget.h>
 #include <LibProtocol/Download.h>
@@ -44,10 +45,15 @@ private:
     explicit DownloadWidget(const URL&);
 
     void did_progress(Optional<u32> total_size, u32 downloaded_size);
-    void did_finish(bool success, const ByteBuffer& payload, RefPtr<SharedBuffer> payload_storage, const HashMap<String, String, CaseInsensitiveStringTraits>& response_headers);
+    void did_receive_data(const ByteBuffer&);
+    void did_finish(bool success);
+    bool open_destination_file();
 
     URL m_url;
     String m_destination_path;
+    // The download goes straight into the file as it arrives.
+    RefPtr<Core::File> m_destination_file;
+    bool m_failed_to_open_destination_file { false };
     RefPtr<Protocol::Download> m_download;
     RefPtr<GUI::ProgressBar> m_progress_bar;
     RefPtr<GUI::Label> m_progress_label;
@@ -25,7 +25,10 @@
  */
 
 #include "InspectorWidget.h"
+#include "TimelineWidget.h"
+#include <LibCore/Timer.h>
 #include <LibGUI/BoxLayout.h>
+#include <LibGUI/Label.h>
 #include <LibGUI/Splitter.h>
 #include <LibGUI/TabWidget.h>
 #include <LibGUI/TableView.h>
@@ -33,6 +36,7 @@
 #include <LibWeb/DOM/Document.h>
 #include <LibWeb/DOM/Element.h>
 #include <LibWeb/DOMTreeModel.h>
+#include <LibWeb/ResourceLoader.h>
 #include <LibWeb/StylePropertiesModel.h>
 
 namespace Browser {
@@ -61,6 +65,32 @@ InspectorWidget::InspectorWidget()
 
     m_style_table_view = tab_widget.add_tab<GUI::TableView>("Styles");
     m_computed_style_table_view = tab_widget.add_tab<GUI::TableView>("Computed");
+
+    auto& cache_container = tab_widget.add_tab<GUI::Widget>("Cache");
+    cache_container.set_fill_with_background_color(true);
+    cache_container.set_layout<GUI::VerticalBoxLayout>();
+    cache_container.layout()->set_margins({ 4, 4, 4, 4 });
+    auto make_label = [&] {
+        auto& label = cache_container.add<GUI::Label>();
+        label.set_text_alignment(Gfx::TextAlignment::CenterLeft);
+        label.set_size_policy(GUI::SizePolicy::Fill, GUI::SizePolicy::Fixed);
+        label.set_preferred_size(0, 14);
+        return &label;
+    };
+    m_cache_hit_rate_label = make_label();
+    m_cache_requests_label = make_label();
+    m_cache_usage_label = make_label();
+    cache_container.layout()->add_spacer();
+
+    m_timeline_widget = tab_widget.add_tab<TimelineWidget>("Timeline");
+
+    update_cache_statistics();
+    m_cache_statistics_timer = Core::Timer::construct(
+        1000, [this] {
+            update_cache_statistics();
+            m_timeline_widget->refresh();
+        },
+        this);
 }
 
 InspectorWidget::~InspectorWidget()
@@ -73,6 +103,19 @@ void InspectorWidget::set_document(Web::Document* document)
         return;
     m_document = document;
     m_dom_tree_view->set_model(Web::DOMTreeModel::create(*document));
+    m_timeline_widget->set_document(document);
+}
+
+void InspectorWidget::update_cache_statistics()
+{
+    auto& cache = Web::ResourceLoader::the().cache();
+    auto& statistics = cache.statistics();
+    auto requests = statistics.hits + statistics.revalidated_hits + statistics.misses;
+    auto hit_rate = requests ? (statistics.hits + statistics.revalidated_hits) * 100 / requests : 0;
+
+    m_cache_hit_rate_label->set_text(String::format("Hit rate: %zu%% of %zu requests", hit_rate, requests));
+    m_cache_requests_label->set_text(String::format("Hits: %zu, revalidated: %zu, misses: %zu, from disk: %zu", statistics.hits, statistics.revalidated_hits, statistics.misses, statistics.disk_hits));
+    m_cache_usage_label->set_text(String::format("Entries: %zu, memory: %zu / %zu KB, evictions: %zu", cache.entry_count(), cache.memory_usage() / KB, cache.memory_budget() / KB, statistics.evictions));
 }
 
 }
@@ -31,6 +31,8 @@
 
 namespace Browser {
 
+class TimelineWidget;
+
 class InspectorWidget final : public GUI::Widget {
     C_OBJECT(InspectorWidget)
 public:
@@ -41,9 +43,16 @@ public:
 private:
     InspectorWidget();
 
+    void update_cache_statistics();
+
     RefPtr<GUI::TreeView> m_dom_tree_view;
     RefPtr<GUI::TableView> m_style_table_view;
     RefPtr<GUI::TableView> m_computed_style_table_view;
+    RefPtr<GUI::Label> m_cache_hit_rate_label;
+    RefPtr<GUI::Label> m_cache_requests_label;
+    RefPtr<GUI::Label> m_cache_usage_label;
+    RefPtr<Core::Timer> m_cache_statistics_timer;
+    RefPtr<TimelineWidget> m_timeline_widget;
     RefPtr<Web::Document> m_document;
 };
 
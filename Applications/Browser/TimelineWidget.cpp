@@ -0,0 +1,140 @@
+/*
+ * Copyright (c) 2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "TimelineWidget.h"
+#include <LibGUI/Painter.h>
+#include <LibGUI/ScrollBar.h>
+#include <LibGfx/Font.h>
+#include <LibGfx/Palette.h>
+#include <LibWeb/DOM/Document.h>
+
+namespace Browser {
+
+static constexpr int row_height = 16;
+static constexpr int name_column_width = 160;
+
+static Color color_for_category(Web::PerformanceTimeline::Category category)
+{
+    switch (category) {
+    case Web::PerformanceTimeline::Category::Network:
+        return Color::from_rgb(0x4d8fd6);
+    case Web::PerformanceTimeline::Category::Parse:
+        return Color::from_rgb(0x5ea35b);
+    case Web::PerformanceTimeline::Category::Style:
+        return Color::from_rgb(0x9b6bc4);
+    case Web::PerformanceTimeline::Category::Layout:
+        return Color::from_rgb(0xd79a3c);
+    case Web::PerformanceTimeline::Category::Paint:
+        return Color::from_rgb(0x4caf9f);
+    case Web::PerformanceTimeline::Category::Script:
+        return Color::from_rgb(0xd4c13a);
+    }
+    ASSERT_NOT_REACHED();
+}
+
+TimelineWidget::TimelineWidget()
+{
+    set_should_hide_unnecessary_scrollbars(true);
+}
+
+TimelineWidget::~TimelineWidget()
+{
+}
+
+void TimelineWidget::set_document(Web::Document* document)
+{
+    m_document = document;
+    m_painted_entry_count = 0;
+    refresh();
+}
+
+void TimelineWidget::refresh()
+{
+    size_t entry_count = m_document ? m_document->performance_timeline().entries().size() : 0;
+    if (entry_count == m_painted_entry_count)
+        return;
+    m_painted_entry_count = entry_count;
+    set_content_size({ 0, (int)entry_count * row_height });
+    update();
+}
+
+void TimelineWidget::paint_event(GUI::PaintEvent& event)
+{
+    GUI::Frame::paint_event(event);
+
+    GUI::Painter painter(*this);
+    painter.add_clip_rect(widget_inner_rect());
+    painter.add_clip_rect(event.rect());
+    painter.fill_rect(event.rect(), palette().base());
+
+    if (!m_document)
+        return;
+
+    using Web::PerformanceTimeline;
+    auto& timeline = m_document->performance_timeline();
+    auto& entries = timeline.entries();
+
+    double end_of_timeline = timeline.milestone(PerformanceTimeline::Milestone::DOMComplete);
+    for (auto& entry : entries)
+        end_of_timeline = max(end_of_timeline, entry.start + entry.duration);
+    if (end_of_timeline <= 0)
+        return;
+
+    auto inner_rect = widget_inner_rect();
+    int bar_area_width = max(1, inner_rect.width() - name_column_width - 4);
+    auto x_for_time = [&](double time) {
+        return inner_rect.x() + name_column_width + (int)(time * bar_area_width / end_of_timeline);
+    };
+
+    painter.translate(0, -vertical_scrollbar().value());
+
+    int first_row = vertical_scrollbar().value() / row_height;
+    int last_row = min((int)entries.size(), first_row + inner_rect.height() / row_height + 2);
+    for (int row = first_row; row < last_row; ++row) {
+        auto& entry = entries[row];
+        Gfx::Rect row_rect { inner_rect.x(), inner_rect.y() + row * row_height, inner_rect.width(), row_height };
+
+        Gfx::Rect name_rect { row_rect.x() + 2, row_rect.y(), name_column_width - 4, row_height };
+        painter.draw_text(name_rect, entry.name, Gfx::TextAlignment::CenterLeft, palette().base_text(), Gfx::TextElision::Right);
+
+        int bar_start = x_for_time(entry.start);
+        int bar_width = max(1, x_for_time(entry.start + entry.duration) - bar_start);
+        painter.fill_rect({ bar_start, row_rect.y() + 3, bar_width, row_height - 6 }, color_for_category(entry.category));
+    }
+
+    int content_bottom = inner_rect.y() + max(inner_rect.height(), (int)entries.size() * row_height);
+    auto draw_milestone = [&](PerformanceTimeline::Milestone milestone, Color color) {
+        auto time = timeline.milestone(milestone);
+        if (!time)
+            return;
+        int x = x_for_time(time);
+        painter.draw_line({ x, inner_rect.y() }, { x, content_bottom }, color);
+    };
+    draw_milestone(PerformanceTimeline::Milestone::DOMContentLoadedEventStart, Color::Blue);
+    draw_milestone(PerformanceTimeline::Milestone::DOMComplete, Color::Red);
+}
+
+}
@@ -31,6 +31,7 @@
 #include <LibCore/ArgsParser.h>
 #include <LibCore/ConfigFile.h>
 #include <LibCore/File.h>
+#include <LibCore/StandardPaths.h>
 #include <LibGUI/AboutDialog.h>
 #include <LibGUI/Application.h>
 #include <LibGUI/BoxLayout.h>
@@ -38,8 +39,10 @@
 #include <LibGUI/Window.h>
 #include <LibGfx/Bitmap.h>
 #include <LibWeb/ResourceLoader.h>
+#include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <sys/stat.h>
 
 namespace Browser {
 
@@ -105,6 +108,16 @@ int main(int argc, char** argv)
     auto m_config = Core::ConfigFile::get_for_app("Browser");
     Browser::g_home_url = m_config->read_entry("Preferences", "Home", "about:blank");
 
+    Web::ResourceLoader::the().set_max_downloads_per_origin(m_config->read_num_entry("Preferences", "MaxDownloadsPerOrigin", 6));
+
+    if (m_config->read_bool_entry("Preferences", "DiskCache", true)) {
+        auto cache_directory = String::format("%s/.cache", Core::StandardPaths::home_directory().characters());
+        if (mkdir(cache_directory.characters(), 0700) < 0 && errno != EEXIST)
+            perror("mkdir");
+        else
+            Web::ResourceLoader::the().cache().set_disk_cache_directory(String::format("%s/Browser", cache_directory.characters()));
+    }
+
     bool bookmarksbar_enabled = true;
     auto bookmarks_bar = Browser::BookmarksBarWidget::construct(Browser::bookmarks_filename, bookmarksbar_enabled);
 
@@ -29,6 +29,7 @@
 #include <LibCore/DirIterator.h>
 #include <LibGUI/MessageBox.h>
 #include <LibGUI/Painter.h>
+#include <LibGUI/ThumbnailCache.h>
 #include <LibGUI/Window.h>
 #include <LibGfx/Bitmap.h>
 #include <LibGfx/Orientation.h>
@@ -235,6 +236,8 @@ void QSWidget::load_from_file(const String& path)
         return;
     }
 
+    GUI::ThumbnailCache::did_load_image(path, *bitmap);
+
     m_path = path;
     m_bitmap = bitmap;
     m_scale = 100;
@@ -107,6 +107,14 @@ String ProcessModel::column_name(int column) const
         return "F:Zero";
     case Column::CowFaults:
         return "F:CoW";
+    case Column::RunningTime:
+        return "T:Run";
+    case Column::RunnableTime:
+        return "T:Ready";
+    case Column::BlockedTime:
+        return "T:Block";
+    case Column::BlockedReason:
+        return "Blocked On";
     case Column::IPv4SocketReadBytes:
         return "IPv4 In";
     case Column::IPv4SocketWriteBytes:
@@ -133,6 +141,11 @@ static String pretty_byte_size(size_t size)
     return String::format("%uK", size / 1024);
 }
 
+static String pretty_time(u64 ns)
+{
+    return String::format("%llu ms", ns / 1'000'000);
+}
+
 GUI::Variant ProcessModel::data(const GUI::ModelIndex& index, Role role) const
 {
     ASSERT(is_valid(index));
@@ -143,6 +156,7 @@ GUI::Variant ProcessModel::data(const GUI::ModelIndex& index, Role role) const
         case Column::Name:
         case Column::State:
         case Column::User:
+        case Column::BlockedReason:
         case Column::Pledge:
         case Column::Veil:
             return Gfx::TextAlignment::CenterLeft;
@@ -161,6 +175,9 @@ GUI::Variant ProcessModel::data(const GUI::ModelIndex& index, Role role) const
         case Column::InodeFaults:
         case Column::ZeroFaults:
         case Column::CowFaults:
+        case Column::RunningTime:
+        case Column::RunnableTime:
+        case Column::BlockedTime:
         case Column::FileReadBytes:
         case Column::FileWriteBytes:
         case Column::UnixSocketReadBytes:
@@ -216,6 +233,14 @@ GUI::Variant ProcessModel::data(const GUI::ModelIndex& index, Role role) const
             return thread.current_state.zero_faults;
         case Column::CowFaults:
             return thread.current_state.cow_faults;
+        case Column::RunningTime:
+            return (i64)thread.current_state.running_ns;
+        case Column::RunnableTime:
+            return (i64)thread.current_state.runnable_ns;
+        case Column::BlockedTime:
+            return (i64)thread.current_state.blocked_ns;
+        case Column::BlockedReason:
+            return thread.current_state.blocked_reason;
         case Column::IPv4SocketReadBytes:
             return thread.current_state.ipv4_socket_read_bytes;
         case Column::IPv4SocketWriteBytes:
@@ -285,6 +310,14 @@ GUI::Variant ProcessModel::data(const GUI::ModelIndex& index, Role role) const
             return thread.current_state.zero_faults;
         case Column::CowFaults:
             return thread.current_state.cow_faults;
+        case Column::RunningTime:
+            return pretty_time(thread.current_state.running_ns);
+        case Column::RunnableTime:
+            return pretty_time(thread.current_state.runnable_ns);
+        case Column::BlockedTime:
+            return pretty_time(thread.current_state.blocked_ns);
+        case Column::BlockedReason:
+            return thread.current_state.blocked_reason;
         case Column::IPv4SocketReadBytes:
             return thread.current_state.ipv4_socket_read_bytes;
         case Column::IPv4SocketWriteBytes:
@@ -309,7 +342,8 @@ GUI::Variant ProcessModel::data(const GUI::ModelIndex& index, Role role) const
 
 void ProcessModel::update()
 {
-    auto all_processes = Core::ProcessStatisticsReader::get_all();
+    Vector<Core::ProcessorStatistics> processors;
+    auto all_processes = Core::ProcessStatisticsReader::get_all(&processors);
 
     unsigned last_sum_times_scheduled = 0;
     for (auto& it : m_threads)
@@ -328,6 +362,17 @@ void ProcessModel::update()
             state.inode_faults = thread.inode_faults;
             state.zero_faults = thread.zero_faults;
             state.cow_faults = thread.cow_faults;
+            state.running_ns = thread.running_ns;
+            state.runnable_ns = thread.runnable_ns;
+            state.blocked_ns = thread.blocked_ns;
+            // What the thread spent the most time blocked on.
+            u64 longest_blocked_ns = 0;
+            for (auto& blocked : thread.blocked_ns_by_reason) {
+                if (blocked.value > longest_blocked_ns) {
+                    longest_blocked_ns = blocked.value;
+                    state.blocked_reason = blocked.key;
+                }
+            }
             state.unix_socket_read_bytes = thread.unix_socket_read_bytes;
             state.unix_socket_write_bytes = thread.unix_socket_write_bytes;
             state.ipv4_socket_read_bytes = thread.ipv4_socket_read_bytes;
@@ -364,7 +409,6 @@ void ProcessModel::update()
         }
     }
 
-    m_pids.clear();
     float total_cpu_percent = 0;
     Vector<PidAndTid, 16> pids_to_remove;
     for (auto& it : m_threads) {
@@ -375,16 +419,50 @@ void ProcessModel::update()
         auto& process = *it.value;
         u32 times_scheduled_diff = process.current_state.times_scheduled - process.previous_state.times_scheduled;
         process.current_state.cpu_percent = ((float)times_scheduled_diff * 100) / (float)(sum_times_scheduled - last_sum_times_scheduled);
-        if (it.key.pid != 0) {
+        if (it.key.pid != 0)
             total_cpu_percent += process.current_state.cpu_percent;
-            m_pids.append(it.key);
-        }
     }
     for (auto pid : pids_to_remove)
         m_threads.remove(pid);
 
+    // Rows keep their place from one update to the next, so views can be told just which ones went away
+    // and which are new, and keep the selection on the same threads.
+    for (int row = (int)m_pids.size() - 1; row >= 0; --row) {
+        if (m_threads.contains(m_pids[row]))
+            continue;
+        int last_dead_row = row;
+        while (row > 0 && !m_threads.contains(m_pids[row - 1]))
+            --row;
+        for (int i = last_dead_row; i >= row; --i)
+            m_pids.remove(i);
+        did_remove_rows({}, row, last_dead_row);
+    }
+
+    HashTable<PidAndTid> listed_pids;
+    for (auto& pid : m_pids)
+        listed_pids.set(pid);
+    int first_new_row = m_pids.size();
+    for (auto& it : m_threads) {
+        if (it.key.pid != 0 && !listed_pids.contains(it.key))
+            m_pids.append(it.key);
+    }
+    if ((int)m_pids.size() > first_new_row)
+        did_insert_rows({}, first_new_row, m_pids.size() - 1);
+
     if (on_new_cpu_data_point)
         on_new_cpu_data_point(total_cpu_percent);
 
-    did_update(GUI::Model::UpdateFlag::DontInvalidateIndexes);
+    if (on_new_processor_data_points && processors.size() == m_processors.size()) {
+        Vector<float> busy_percents;
+        for (size_t i = 0; i < processors.size(); ++i) {
+            unsigned busy_diff = processors[i].busy_ticks - m_processors[i].busy_ticks;
+            unsigned total_diff = busy_diff + (processors[i].idle_ticks - m_processors[i].idle_ticks);
+            busy_percents.append(total_diff ? ((float)busy_diff * 100) / (float)total_diff : 0);
+        }
+        on_new_processor_data_points(busy_percents);
+    }
+    m_processors = move(processors);
+
+    if (!m_pids.is_empty())
+        did_change_rows({}, 0, m_pids.size() - 1);
 }
@@ -29,6 +29,7 @@
 #include <AK/HashMap.h>
 #include <AK/String.h>
 #include <AK/Vector.h>
+#include <LibCore/ProcessStatisticsReader.h>
 #include <LibGUI/Model.h>
 #include <unistd.h>
 
@@ -67,6 +68,10 @@ public:
         InodeFaults,
         ZeroFaults,
         CowFaults,
+        RunningTime,
+        RunnableTime,
+        BlockedTime,
+        BlockedReason,
         FileReadBytes,
         FileWriteBytes,
         UnixSocketReadBytes,
@@ -88,6 +93,7 @@ public:
     virtual void update() override;
 
     Function<void(float)> on_new_cpu_data_point;
+    Function<void(const Vector<float>&)> on_new_processor_data_points;
 
 private:
     ProcessModel();
@@ -113,6 +119,10 @@ private:
         unsigned inode_faults;
         unsigned zero_faults;
         unsigned cow_faults;
+        u64 running_ns;
+        u64 runnable_ns;
+        u64 blocked_ns;
+        String blocked_reason;
         unsigned unix_socket_read_bytes;
         unsigned unix_socket_write_bytes;
         unsigned ipv4_socket_read_bytes;
@@ -131,6 +141,7 @@ private:
     HashMap<uid_t, String> m_usernames;
     HashMap<PidAndTid, NonnullOwnPtr<Thread>> m_threads;
     Vector<PidAndTid> m_pids;
+    Vector<Core::ProcessorStatistics> m_processors;
     RefPtr<Gfx::Bitmap> m_generic_process_icon;
     RefPtr<Gfx::Bitmap> m_high_priority_icon;
     RefPtr<Gfx::Bitmap> m_low_priority_icon;
@@ -53,6 +53,7 @@
 #include <LibGUI/ToolBar.h>
 #include <LibGUI/Widget.h>
 #include <LibGUI/Window.h>
+#include <LibGUI/WindowServerConnection.h>
 #include <LibGfx/Palette.h>
 #include <LibPCIDB/Database.h>
 #include <signal.h>
@@ -496,6 +497,31 @@ NonnullRefPtr<GUI::Widget> build_graphs_tab()
             graph->add_value(cpu_percent);
         };
 
+        Vector<Core::ProcessorStatistics> processors;
+        Core::ProcessStatisticsReader::get_all(&processors);
+        if (processors.size() > 1) {
+            auto& processors_graph_group_box = self.add<GUI::GroupBox>("Per-CPU usage");
+            processors_graph_group_box.set_layout<GUI::HorizontalBoxLayout>();
+            processors_graph_group_box.layout()->set_margins({ 6, 16, 6, 6 });
+            processors_graph_group_box.set_size_policy(GUI::SizePolicy::Fill, GUI::SizePolicy::Fixed);
+            processors_graph_group_box.set_preferred_size(0, 120);
+            Vector<GraphWidget*> processor_graphs;
+            for (size_t i = 0; i < processors.size(); ++i) {
+                auto& processor_graph = processors_graph_group_box.add<GraphWidget>();
+                processor_graph.set_max(100);
+                processor_graph.set_text_color(Color::Green);
+                processor_graph.set_graph_color(Color::from_rgb(0x00bb00));
+                processor_graph.text_formatter = [id = processors[i].id](int value, int) {
+                    return String::format("CPU%u: %d%%", id, value);
+                };
+                processor_graphs.append(&processor_graph);
+            }
+            ProcessModel::the().on_new_processor_data_points = [processor_graphs = move(processor_graphs)](const Vector<float>& busy_percents) {
+                for (size_t i = 0; i < busy_percents.size() && i < processor_graphs.size(); ++i)
+                    processor_graphs[i]->add_value(busy_percents[i]);
+            };
+        }
+
         auto& memory_graph_group_box = self.add<GUI::GroupBox>("Memory usage");
         memory_graph_group_box.set_layout<GUI::VerticalBoxLayout>();
         memory_graph_group_box.layout()->set_margins({ 6, 16, 6, 6 });
@@ -509,6 +535,33 @@ NonnullRefPtr<GUI::Widget> build_graphs_tab()
         };
 
         self.add<MemoryStatsWidget>(memory_graph);
+
+        auto& compositor_graph_group_box = self.add<GUI::GroupBox>("Compositor");
+        compositor_graph_group_box.set_layout<GUI::HorizontalBoxLayout>();
+        compositor_graph_group_box.layout()->set_margins({ 6, 16, 6, 6 });
+        compositor_graph_group_box.set_size_policy(GUI::SizePolicy::Fill, GUI::SizePolicy::Fixed);
+        compositor_graph_group_box.set_preferred_size(0, 120);
+        auto& frame_rate_graph = compositor_graph_group_box.add<GraphWidget>();
+        frame_rate_graph.set_max(60);
+        frame_rate_graph.set_text_color(Color::Green);
+        frame_rate_graph.set_graph_color(Color::from_rgb(0x00bb00));
+        frame_rate_graph.text_formatter = [](int value, int) {
+            return String::format("%d fps", value);
+        };
+        auto& compose_time_graph = compositor_graph_group_box.add<GraphWidget>();
+        // Anything past a frame's worth of time is off the chart.
+        compose_time_graph.set_max(1000000 / 60);
+        compose_time_graph.set_text_color(Color::Cyan);
+        compose_time_graph.set_graph_color(Color::from_rgb(0x00bbbb));
+        compose_time_graph.text_formatter = [](int value, int) {
+            return String::format("Compose: %d.%02d ms", value / 1000, (value % 1000) / 10);
+        };
+
+        self.add<Core::Timer>(1000, [&frame_rate_graph, &compose_time_graph] {
+            auto statistics = GUI::WindowServerConnection::the().send_sync<Messages::WindowServer::GetCompositorStatistics>();
+            frame_rate_graph.add_value(statistics->frames_per_second());
+            compose_time_graph.add_value(statistics->average_compose_microseconds());
+        });
     };
     return graphs_container;
 }
@@ -28,7 +28,6 @@
 #include <AK/Optional.h>
 #include <AK/StringBuilder.h>
 #include <AK/URL.h>
-#include <LibCore/File.h>
 #include <LibCore/MimeData.h>
 #include <LibGUI/AboutDialog.h>
 #include <LibGUI/Action.h>
@@ -498,13 +497,10 @@ void TextEditorWidget::update_title()
 
 void TextEditorWidget::open_sesame(const String& path)
 {
-    auto file = Core::File::construct(path);
-    if (!file->open(Core::IODevice::ReadOnly)) {
+    if (!m_editor->load_from_file(path)) {
         GUI::MessageBox::show(String::format("Opening \"%s\" failed: %s", path.characters(), strerror(errno)), "Error", GUI::MessageBox::Type::Error, GUI::MessageBox::InputType::OK, window());
         return;
     }
-
-    m_editor->set_text(file->read_all());
     m_document_dirty = false;
     m_document_opening = true;
 
@@ -0,0 +1,41 @@
+#!/bin/sh
+set -e
+
+# Compares two outputs of `microbench`, and exits with 1 if anything got worse by more than the threshold.
+# Latencies (ns) are better when lower, bandwidths (MB/s) when higher.
+
+if [ $# -lt 2 ] || [ $# -gt 3 ]; then
+    echo "usage: $0 <before> <after> [threshold percent, 5 by default]"
+    exit 2
+fi
+
+before="$1"
+after="$2"
+threshold="${3:-5}"
+
+awk -F '\t' -v threshold="$threshold" '
+    NR == FNR {
+        before[$1] = $2
+        next
+    }
+    {
+        name = $1
+        if (!(name in before)) {
+            printf "%-24s %12s %12s %9s\n", name, "-", $2, "new"
+            next
+        }
+        change = before[name] == 0 ? 0 : ($2 - before[name]) * 100 / before[name]
+        worse = $3 == "ns" ? change : -change
+        verdict = ""
+        if (worse > threshold) {
+            verdict = "  REGRESSION"
+            regressions++
+        } else if (worse < -threshold) {
+            verdict = "  improvement"
+        }
+        printf "%-24s %12s %12s %+8.1f%%%s\n", name, before[name], $2, change, verdict
+    }
+    END {
+        exit regressions > 0
+    }
+' "$before" "$after"
@@ -0,0 +1,417 @@
+/*
+ * Copyright (c) 2018-2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/QuickSort.h>
+#include <AK/StringView.h>
+#include <AK/Vector.h>
+#include <LibCore/ArgsParser.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+// Kernel and system microbenchmarks, in the spirit of lmbench. Every benchmark runs a few times and reports
+// the median, one per line as "name<TAB>value<TAB>unit", so that runs from before and after a change can be
+// put side by side with Benchmarks/compare-benchmarks.sh. Latencies are in nanoseconds (lower is better),
+// bandwidths in MB/s (higher is better).
+
+static constexpr size_t stream_chunk_size = 64 * KB;
+static constexpr size_t stream_total_size = 64 * MB;
+
+static u64 now_ns()
+{
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (u64)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+static u64 ns_per_iteration(u64 start, size_t iterations)
+{
+    return (now_ns() - start) / iterations;
+}
+
+static void wait_for_child(pid_t pid)
+{
+    int status;
+    if (waitpid(pid, &status, 0) < 0)
+        perror("waitpid");
+}
+
+static u64 getpid_latency()
+{
+    constexpr size_t iterations = 100000;
+    u64 start = now_ns();
+    for (size_t i = 0; i < iterations; ++i)
+        getpid();
+    return ns_per_iteration(start, iterations);
+}
+
+static u64 null_write_latency()
+{
+    constexpr size_t iterations = 100000;
+    int fd = open("/dev/null", O_WRONLY);
+    if (fd < 0) {
+        perror("open");
+        exit(1);
+    }
+    char byte = 0;
+    u64 start = now_ns();
+    for (size_t i = 0; i < iterations; ++i)
+        write(fd, &byte, 1);
+    u64 result = ns_per_iteration(start, iterations);
+    close(fd);
+    return result;
+}
+
+static u64 open_close_latency()
+{
+    constexpr size_t iterations = 10000;
+    u64 start = now_ns();
+    for (size_t i = 0; i < iterations; ++i) {
+        int fd = open("/etc/passwd", O_RDONLY);
+        if (fd < 0) {
+            perror("open");
+            exit(1);
+        }
+        close(fd);
+    }
+    return ns_per_iteration(start, iterations);
+}
+
+// Two processes bounce a byte back and forth over a pair of pipes, so this includes the cost of the pipe I/O.
+static u64 context_switch_latency()
+{
+    constexpr size_t iterations = 10000;
+    int to_child[2];
+    int to_parent[2];
+    if (pipe(to_child) < 0 || pipe(to_parent) < 0) {
+        perror("pipe");
+        exit(1);
+    }
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("fork");
+        exit(1);
+    }
+    char byte = 0;
+    if (pid == 0) {
+        close(to_child[1]);
+        close(to_parent[0]);
+        while (read(to_child[0], &byte, 1) == 1)
+            write(to_parent[1], &byte, 1);
+        _exit(0);
+    }
+
+    close(to_child[0]);
+    close(to_parent[1]);
+    u64 start = now_ns();
+    for (size_t i = 0; i < iterations; ++i) {
+        write(to_child[1], &byte, 1);
+        read(to_parent[0], &byte, 1);
+    }
+    u64 result = ns_per_iteration(start, iterations * 2);
+    close(to_child[1]);
+    close(to_parent[0]);
+    wait_for_child(pid);
+    return result;
+}
+
+// Run in a child process, to feed one of the bandwidth benchmarks.
+[[noreturn]] static void write_stream_and_exit(int fd)
+{
+    auto* buffer = (u8*)malloc(stream_chunk_size);
+    memset(buffer, 0x55, stream_chunk_size);
+    for (size_t written = 0; written < stream_total_size;) {
+        ssize_t nwritten = write(fd, buffer, min(stream_chunk_size, stream_total_size - written));
+        if (nwritten <= 0) {
+            perror("write");
+            _exit(1);
+        }
+        written += nwritten;
+    }
+    _exit(0);
+}
+
+// Reads everything the child writes into fd, and then waits for it to exit.
+static u64 read_stream_bandwidth(int fd, pid_t pid)
+{
+    auto* buffer = (u8*)malloc(stream_chunk_size);
+    size_t total_read = 0;
+    u64 start = now_ns();
+    for (;;) {
+        ssize_t nread = read(fd, buffer, stream_chunk_size);
+        if (nread < 0) {
+            perror("read");
+            exit(1);
+        }
+        if (nread == 0)
+            break;
+        total_read += nread;
+    }
+    u64 elapsed = max(now_ns() - start, (u64)1);
+    free(buffer);
+    close(fd);
+    wait_for_child(pid);
+    return (u64)total_read * 1000000000 / elapsed / MB;
+}
+
+static pid_t fork_or_die()
+{
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("fork");
+        exit(1);
+    }
+    return pid;
+}
+
+static u64 pipe_bandwidth()
+{
+    int fds[2];
+    if (pipe(fds) < 0) {
+        perror("pipe");
+        exit(1);
+    }
+    pid_t pid = fork_or_die();
+    if (pid == 0) {
+        close(fds[0]);
+        write_stream_and_exit(fds[1]);
+    }
+    close(fds[1]);
+    return read_stream_bandwidth(fds[0], pid);
+}
+
+// The connecting side runs in the child, and the listening side reads what it sends.
+static u64 socket_bandwidth(int listen_fd, const sockaddr* address, socklen_t address_length, int domain)
+{
+    pid_t pid = fork_or_die();
+    if (pid == 0) {
+        close(listen_fd);
+        int fd = socket(domain, SOCK_STREAM, 0);
+        if (fd < 0 || connect(fd, address, address_length) < 0) {
+            perror("connect");
+            _exit(1);
+        }
+        write_stream_and_exit(fd);
+    }
+
+    int fd = accept(listen_fd, nullptr, nullptr);
+    if (fd < 0) {
+        perror("accept");
+        exit(1);
+    }
+    close(listen_fd);
+    return read_stream_bandwidth(fd, pid);
+}
+
+static u64 local_socket_bandwidth()
+{
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_LOCAL;
+    snprintf(address.sun_path, sizeof(address.sun_path), "/tmp/microbench.%d", getpid());
+    unlink(address.sun_path);
+
+    int fd = socket(AF_LOCAL, SOCK_STREAM, 0);
+    if (fd < 0 || bind(fd, (const sockaddr*)&address, sizeof(address)) < 0) {
+        perror("bind");
+        exit(1);
+    }
+    if (listen(fd, 1) < 0) {
+        perror("listen");
+        exit(1);
+    }
+    u64 result = socket_bandwidth(fd, (const sockaddr*)&address, sizeof(address), AF_LOCAL);
+    unlink(address.sun_path);
+    return result;
+}
+
+static u64 tcp_loopback_bandwidth()
+{
+    sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = 0;
+
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0 || bind(fd, (const sockaddr*)&address, sizeof(address)) < 0) {
+        perror("bind");
+        exit(1);
+    }
+    // Listening picks a port, which is where the child has to connect.
+    if (listen(fd, 1) < 0) {
+        perror("listen");
+        exit(1);
+    }
+    socklen_t address_length = sizeof(address);
+    if (getsockname(fd, (sockaddr*)&address, &address_length) < 0) {
+        perror("getsockname");
+        exit(1);
+    }
+    return socket_bandwidth(fd, (const sockaddr*)&address, sizeof(address), AF_INET);
+}
+
+static u64 page_fault_latency()
+{
+    constexpr size_t page_count = 4096;
+    auto* memory = (u8*)mmap(nullptr, page_count * PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, 0, 0);
+    if (memory == MAP_FAILED) {
+        perror("mmap");
+        exit(1);
+    }
+    u64 start = now_ns();
+    for (size_t i = 0; i < page_count; ++i)
+        memory[i * PAGE_SIZE] = 1;
+    u64 result = ns_per_iteration(start, page_count);
+    munmap(memory, page_count * PAGE_SIZE);
+    return result;
+}
+
+static u64 mmap_munmap_latency()
+{
+    constexpr size_t iterations = 10000;
+    constexpr size_t size = 64 * KB;
+    u64 start = now_ns();
+    for (size_t i = 0; i < iterations; ++i) {
+        void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, 0, 0);
+        if (memory == MAP_FAILED) {
+            perror("mmap");
+            exit(1);
+        }
+        munmap(memory, size);
+    }
+    return ns_per_iteration(start, iterations);
+}
+
+static u64 fork_exit_latency()
+{
+    constexpr size_t iterations = 200;
+    u64 start = now_ns();
+    for (size_t i = 0; i < iterations; ++i) {
+        pid_t pid = fork_or_die();
+        if (pid == 0)
+            _exit(0);
+        wait_for_child(pid);
+    }
+    return ns_per_iteration(start, iterations);
+}
+
+static u64 fork_exec_latency()
+{
+    constexpr size_t iterations = 100;
+    u64 start = now_ns();
+    for (size_t i = 0; i < iterations; ++i) {
+        pid_t pid = fork_or_die();
+        if (pid == 0) {
+            execl("/bin/true", "true", nullptr);
+            perror("execl");
+            _exit(1);
+        }
+        wait_for_child(pid);
+    }
+    return ns_per_iteration(start, iterations);
+}
+
+struct Benchmark {
+    const char* name;
+    const char* unit;
+    u64 (*run)();
+};
+
+static const Benchmark benchmarks[] = {
+    { "getpid", "ns", getpid_latency },
+    { "null_write", "ns", null_write_latency },
+    { "open_close", "ns", open_close_latency },
+    { "context_switch", "ns", context_switch_latency },
+    { "pipe_bandwidth", "MB/s", pipe_bandwidth },
+    { "local_socket_bandwidth", "MB/s", local_socket_bandwidth },
+    { "tcp_loopback_bandwidth", "MB/s", tcp_loopback_bandwidth },
+    { "page_fault", "ns", page_fault_latency },
+    { "mmap_munmap", "ns", mmap_munmap_latency },
+    { "fork_exit", "ns", fork_exit_latency },
+    { "fork_exec", "ns", fork_exec_latency },
+};
+
+int main(int argc, char** argv)
+{
+    Vector<const char*> benchmark_names;
+    int runs = 5;
+    bool list = false;
+
+    Core::ArgsParser args_parser;
+    args_parser.add_option(runs, "How many times to run each benchmark (the median is reported)", "runs", 'n', "count");
+    args_parser.add_option(list, "List the benchmarks and exit", "list", 'l');
+    args_parser.add_positional_argument(benchmark_names, "Benchmarks to run (all of them by default)", "benchmarks", Core::ArgsParser::Required::No);
+    args_parser.parse(argc, argv);
+
+    if (list) {
+        for (auto& benchmark : benchmarks)
+            printf("%s\t%s\n", benchmark.name, benchmark.unit);
+        return 0;
+    }
+
+    if (runs < 1) {
+        fprintf(stderr, "microbench: At least one run is needed\n");
+        return 1;
+    }
+
+    for (auto* name : benchmark_names) {
+        bool found = false;
+        for (auto& benchmark : benchmarks)
+            found |= StringView(name) == benchmark.name;
+        if (!found) {
+            fprintf(stderr, "microbench: Unknown benchmark '%s'\n", name);
+            return 1;
+        }
+    }
+
+    for (auto& benchmark : benchmarks) {
+        bool selected = benchmark_names.is_empty();
+        for (auto* name : benchmark_names)
+            selected |= StringView(name) == benchmark.name;
+        if (!selected)
+            continue;
+
+        Vector<u64> results;
+        for (int i = 0; i < runs; ++i)
+            results.append(benchmark.run());
+        quick_sort(results);
+        printf("%s\t%llu\t%s\n", benchmark.name, results[results.size() / 2], benchmark.unit);
+        fflush(stdout);
+    }
+    return 0;
+}
@@ -26,6 +26,7 @@
 
 #include <AK/BufferStream.h>
 #include <AK/Function.h>
+#include <AK/HashFunctions.h>
 #include <AK/HashMap.h>
 #include <AK/StringBuilder.h>
 #include <LibCore/File.h>
@@ -55,6 +56,9 @@ struct Message {
     }
 };
 
+// Bump this whenever Encoder and Decoder change how they lay things out.
+static constexpr unsigned wire_format_version = 2;
+
 struct Endpoint {
     String name;
     int magic;
@@ -241,6 +245,29 @@ int main(int argc, char** argv)
     while (index < file_contents.size())
         parse_endpoint();
 
+    // The magic on the wire also covers the messages of the endpoint and the wire format,
+    // so peers built from different definitions don't try to decode each other's messages.
+    for (auto& endpoint : endpoints) {
+        StringBuilder schema;
+        schema.appendf("%u", wire_format_version);
+        auto append_parameters = [&](auto& parameters) {
+            for (auto& parameter : parameters) {
+                schema.append(' ');
+                schema.append(parameter.type);
+            }
+        };
+        for (auto& message : endpoint.messages) {
+            schema.append(';');
+            schema.append(message.name);
+            append_parameters(message.inputs);
+            if (message.is_synchronous) {
+                schema.append(" =>");
+                append_parameters(message.outputs);
+            }
+        }
+        endpoint.magic = (int)pair_int_hash(endpoint.magic, schema.to_string().hash());
+    }
+
     out() << "#pragma once";
     out() << "#include <AK/BufferStream.h>";
     out() << "#include <AK/OwnPtr.h>";
@@ -347,12 +374,12 @@ int main(int argc, char** argv)
             out() << "        size_in_bytes = stream.offset();";
             out() << "        return make<" << name << ">(" << builder.to_string() << ");";
             out() << "    }";
-            out() << "    virtual IPC::MessageBuffer encode() const override";
+            out() << "    virtual IPC::MessageBuffer encode(pid_t peer_pid) const override";
             out() << "    {";
             out() << "        IPC::MessageBuffer buffer;";
-            out() << "        IPC::Encoder stream(buffer);";
+            out() << "        IPC::Encoder stream(buffer, peer_pid);";
             out() << "        stream << endpoint_magic();";
-            out() << "        stream << (int)MessageID::" << name << ";";
+            out() << "        stream.encode_varint((int)MessageID::" << name << ");";
             for (auto& parameter : parameters) {
                 out() << "        stream << m_" << parameter.name << ";";
             }
@@ -399,8 +426,10 @@ int main(int argc, char** argv)
 #endif
         out() << "            return nullptr;";
         out() << "        }";
-        out() << "        i32 message_id = 0;";
-        out() << "        stream >> message_id;";
+        out() << "        IPC::Decoder decoder(stream);";
+        out() << "        u64 message_id = 0;";
+        out() << "        if (!decoder.decode_varint(message_id))";
+        out() << "            return nullptr;";
         out() << "        switch (message_id) {";
         for (auto& message : endpoint.messages) {
             auto do_decode_message = [&](const String& name) {
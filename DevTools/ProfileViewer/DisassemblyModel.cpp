@@ -73,6 +73,8 @@ DisassemblyModel::DisassemblyModel(Profile& profile, ProfileNode& node)
     String path;
     if (m_node.address() >= 0xc0000000)
         path = "/boot/Kernel";
+    else if (!m_node.executable_path().is_empty())
+        path = m_node.executable_path();
     else
         path = profile.executable_path();
     m_file = make<MappedFile>(path);
@@ -0,0 +1,198 @@
+/*
+ * Copyright (c) 2018-2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "FlameGraphWidget.h"
+#include "Profile.h"
+#include <LibGUI/Painter.h>
+#include <LibGfx/Font.h>
+#include <math.h>
+
+FlameGraphWidget::FlameGraphWidget(Profile& profile)
+    : m_profile(profile)
+{
+    set_background_color(Color::White);
+    set_fill_with_background_color(true);
+}
+
+FlameGraphWidget::~FlameGraphWidget()
+{
+}
+
+Gfx::Rect FlameGraphWidget::rect_for_depth(int depth, int x, int width) const
+{
+    // The outermost frames sit at the bottom, and the flames grow upwards.
+    return { x, frame_inner_rect().bottom() - (depth + 1) * bar_height + 1, width, bar_height - 1 };
+}
+
+void FlameGraphWidget::layout_children(const ProfileNode& node, const Gfx::Rect& parent_rect, int depth)
+{
+    if (rect_for_depth(depth, 0, 0).top() < frame_inner_rect().top())
+        return;
+
+    u32 count_before = 0;
+    for (auto& child : node.children()) {
+        // Work out both edges from the running count, so rounding errors don't add up across siblings.
+        int left = parent_rect.x() + (int)((u64)parent_rect.width() * count_before / node.event_count());
+        count_before += child->event_count();
+        int right = parent_rect.x() + (int)((u64)parent_rect.width() * count_before / node.event_count());
+        if (right - left < 1)
+            continue;
+        auto rect = rect_for_depth(depth, left, right - left);
+        m_bars.append({ rect, child.ptr() });
+        layout_children(*child, rect, depth + 1);
+    }
+}
+
+void FlameGraphWidget::layout_bars()
+{
+    m_bars.clear();
+    auto inner_rect = frame_inner_rect();
+
+    // Everything on the way to the frame we're zoomed in on is drawn as wide as the widget.
+    // If the tree was rebuilt and lost part of the path, we stop where it ends.
+    const Vector<NonnullRefPtr<ProfileNode>>* candidates = &m_profile.roots();
+    const ProfileNode* zoomed_node = nullptr;
+    int depth = 0;
+    for (auto& symbol : m_zoom_path) {
+        const ProfileNode* next_node = nullptr;
+        for (auto& candidate : *candidates) {
+            if (candidate->symbol() == symbol) {
+                next_node = candidate.ptr();
+                break;
+            }
+        }
+        if (!next_node)
+            break;
+        zoomed_node = next_node;
+        m_bars.append({ rect_for_depth(depth++, inner_rect.x(), inner_rect.width()), zoomed_node });
+        candidates = &zoomed_node->children();
+    }
+
+    if (zoomed_node) {
+        layout_children(*zoomed_node, m_bars.last().rect, depth);
+        return;
+    }
+
+    u32 total_count = 0;
+    for (auto& root : m_profile.roots())
+        total_count += root->event_count();
+    if (!total_count)
+        return;
+
+    u32 count_before = 0;
+    for (auto& root : m_profile.roots()) {
+        int left = inner_rect.x() + (int)((u64)inner_rect.width() * count_before / total_count);
+        count_before += root->event_count();
+        int right = inner_rect.x() + (int)((u64)inner_rect.width() * count_before / total_count);
+        if (right - left < 1)
+            continue;
+        auto rect = rect_for_depth(0, left, right - left);
+        m_bars.append({ rect, root.ptr() });
+        layout_children(*root, rect, 1);
+    }
+}
+
+Color FlameGraphWidget::color_for(const ProfileNode& node) const
+{
+    if (m_profile.baseline()) {
+        // Red for frames that take a bigger share of the samples than before, blue for smaller.
+        // Five percentage points or more get the full colour.
+        float difference = m_profile.difference_from_baseline(node);
+        u8 fade = 255 - (u8)(min(fabsf(difference) / 5.0f, 1.0f) * 200);
+        if (difference > 0)
+            return Color(255, fade, fade);
+        return Color(fade, fade, 255);
+    }
+
+    // Vary the colours a bit by symbol so that neighbouring bars are told apart,
+    // and keep them the same across repaints.
+    u32 hash = node.symbol().hash();
+    u8 r = hash & 0xff;
+    u8 g = (hash >> 8) & 0xff;
+    u8 b = (hash >> 16) & 0xff;
+    if (node.address() >= 0xc0000000)
+        return Color(200 + r % 55, g % 80, b % 80);
+    return Color(205 + r % 50, g % 230, b % 55);
+}
+
+void FlameGraphWidget::paint_event(GUI::PaintEvent& event)
+{
+    GUI::Frame::paint_event(event);
+
+    GUI::Painter painter(*this);
+    painter.add_clip_rect(event.rect());
+
+    layout_bars();
+    for (auto& bar : m_bars) {
+        painter.fill_rect(bar.rect, color_for(*bar.node));
+        if (bar.rect.width() > font().glyph_width('x') * 3)
+            painter.draw_text(bar.rect.shrunken(4, 0), bar.node->symbol(), Gfx::TextAlignment::CenterLeft, Color::Black, Gfx::TextElision::Right);
+    }
+}
+
+const FlameGraphWidget::Bar* FlameGraphWidget::bar_at(const Gfx::Point& position) const
+{
+    for (auto& bar : m_bars) {
+        if (bar.rect.contains(position))
+            return &bar;
+    }
+    return nullptr;
+}
+
+void FlameGraphWidget::mousedown_event(GUI::MouseEvent& event)
+{
+    if (event.button() != GUI::MouseButton::Left)
+        return;
+
+    auto* bar = bar_at(event.position());
+    if (!bar) {
+        if (!m_zoom_path.is_empty())
+            m_zoom_path.take_last();
+        update();
+        return;
+    }
+
+    m_zoom_path.clear();
+    for (auto* node = bar->node; node; node = node->parent())
+        m_zoom_path.prepend(node->symbol());
+    update();
+}
+
+void FlameGraphWidget::mousemove_event(GUI::MouseEvent& event)
+{
+    auto* bar = bar_at(event.position());
+    if (!bar) {
+        set_tooltip({});
+        return;
+    }
+
+    auto& node = *bar->node;
+    float percentage = m_profile.filtered_event_count() ? (float)node.event_count() * 100.0f / (float)m_profile.filtered_event_count() : 0;
+    if (m_profile.baseline())
+        set_tooltip(String::format("%s: %u samples (%.2f%%, %+.2f since baseline)", node.symbol().characters(), node.event_count(), percentage, m_profile.difference_from_baseline(node)));
+    else
+        set_tooltip(String::format("%s: %u samples (%.2f%%)", node.symbol().characters(), node.event_count(), percentage));
+}
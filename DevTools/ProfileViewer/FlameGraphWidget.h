@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2018-2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/Vector.h>
+#include <LibGUI/Frame.h>
+
+class Profile;
+class ProfileNode;
+
+// Draws the call tree as a flame graph: every frame is a bar as wide as its share
+// of the samples, on top of the frame that called it. Clicking a bar zooms in on it,
+// and clicking outside the bars zooms back out a level.
+class FlameGraphWidget final : public GUI::Frame {
+    C_OBJECT(FlameGraphWidget)
+public:
+    virtual ~FlameGraphWidget() override;
+
+private:
+    explicit FlameGraphWidget(Profile&);
+
+    virtual void paint_event(GUI::PaintEvent&) override;
+    virtual void mousedown_event(GUI::MouseEvent&) override;
+    virtual void mousemove_event(GUI::MouseEvent&) override;
+
+    struct Bar {
+        Gfx::Rect rect;
+        const ProfileNode* node { nullptr };
+    };
+
+    void layout_bars();
+    void layout_children(const ProfileNode&, const Gfx::Rect& parent_rect, int depth);
+    Gfx::Rect rect_for_depth(int depth, int x, int width) const;
+    const Bar* bar_at(const Gfx::Point&) const;
+    Color color_for(const ProfileNode&) const;
+
+    static constexpr int bar_height = 16;
+
+    Profile& m_profile;
+
+    // The call path we're zoomed in on, by symbol, so that it survives the tree being rebuilt.
+    Vector<String> m_zoom_path;
+    Vector<Bar> m_bars;
+};
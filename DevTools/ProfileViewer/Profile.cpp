@@ -27,7 +27,10 @@
 #include "Profile.h"
 #include "DisassemblyModel.h"
 #include "ProfileModel.h"
+#include <AK/Function.h>
+#include <AK/HashMap.h>
 #include <AK/HashTable.h>
+#include <AK/LexicalPath.h>
 #include <AK/MappedFile.h>
 #include <AK/QuickSort.h>
 #include <AK/RefPtr.h>
@@ -45,8 +48,9 @@ static void sort_profile_nodes(Vector<NonnullRefPtr<ProfileNode>>& nodes)
         child->sort_children();
 }
 
-Profile::Profile(String executable_path, Vector<Event> events)
+Profile::Profile(String executable_path, Vector<Event> events, Vector<Interval> intervals)
     : m_executable_path(move(executable_path))
+    , m_intervals(move(intervals))
     , m_events(move(events))
 {
     m_first_timestamp = m_events.first().timestamp;
@@ -74,16 +78,14 @@ void Profile::rebuild_tree()
 {
     u32 filtered_event_count = 0;
     Vector<NonnullRefPtr<ProfileNode>> roots;
+    HashMap<String, ProfileNode*> roots_by_symbol;
 
-    auto find_or_create_root = [&roots](const String& symbol, u32 address, u32 offset, u64 timestamp) -> ProfileNode& {
-        for (size_t i = 0; i < roots.size(); ++i) {
-            auto& root = roots[i];
-            if (root->symbol() == symbol) {
-                return root;
-            }
-        }
-        auto new_root = ProfileNode::create(symbol, address, offset, timestamp);
+    auto find_or_create_root = [&](const String& symbol, u32 address, u32 offset, u64 timestamp, const String& executable_path) -> ProfileNode& {
+        if (auto* root = roots_by_symbol.get(symbol).value_or(nullptr))
+            return *root;
+        auto new_root = ProfileNode::create(symbol, address, offset, timestamp, executable_path);
         roots.append(new_root);
+        roots_by_symbol.set(symbol, new_root.ptr());
         return new_root;
     };
 
@@ -141,9 +143,9 @@ void Profile::rebuild_tree()
                 return IterationDecision::Break;
 
             if (!node)
-                node = &find_or_create_root(symbol, address, offset, event.timestamp);
+                node = &find_or_create_root(symbol, address, offset, event.timestamp, frame.executable_path);
             else
-                node = &node->find_or_create_child(symbol, address, offset, event.timestamp);
+                node = &node->find_or_create_child(symbol, address, offset, event.timestamp, frame.executable_path);
 
             node->increment_event_count();
             if (is_innermost_frame) {
@@ -160,9 +162,53 @@ void Profile::rebuild_tree()
 
     m_filtered_event_count = filtered_event_count;
     m_roots = move(roots);
+    match_against_baseline();
     m_model->update();
 }
 
+static void match_nodes_against_baseline(Vector<NonnullRefPtr<ProfileNode>>& nodes, Function<const ProfileNode*(const String&)> find_baseline_node)
+{
+    for (auto& node : nodes) {
+        auto* baseline_node = find_baseline_node(node->symbol());
+        node->set_baseline_event_count(baseline_node ? baseline_node->event_count() : 0);
+        match_nodes_against_baseline(node->children(), [&](auto& symbol) -> const ProfileNode* {
+            return baseline_node ? baseline_node->find_child(symbol) : nullptr;
+        });
+    }
+}
+
+void Profile::match_against_baseline()
+{
+    if (!m_baseline)
+        return;
+    auto& baseline_roots = m_baseline->roots();
+    match_nodes_against_baseline(m_roots, [&](auto& symbol) -> const ProfileNode* {
+        for (auto& root : baseline_roots) {
+            if (root->symbol() == symbol)
+                return root.ptr();
+        }
+        return nullptr;
+    });
+}
+
+void Profile::set_baseline(OwnPtr<Profile>&& baseline)
+{
+    m_baseline = move(baseline);
+    if (m_baseline)
+        m_baseline->set_inverted(m_inverted);
+    match_against_baseline();
+    m_model->update();
+}
+
+float Profile::difference_from_baseline(const ProfileNode& node) const
+{
+    if (!m_baseline || !m_filtered_event_count || !m_baseline->filtered_event_count())
+        return 0;
+    float share = (float)node.event_count() / (float)m_filtered_event_count;
+    float baseline_share = (float)node.baseline_event_count() / (float)m_baseline->filtered_event_count();
+    return (share - baseline_share) * 100.0f;
+}
+
 OwnPtr<Profile> Profile::load_from_perfcore_file(const StringView& path)
 {
     auto file = Core::File::construct(path);
@@ -179,19 +225,73 @@ OwnPtr<Profile> Profile::load_from_perfcore_file(const StringView& path)
 
     auto& object = json.as_object();
     auto executable_path = object.get("executable").to_string();
+    bool is_system_wide = object.get("pid").to_i32() == -1;
+    // Profiles recorded by a language runtime (e.g. LibJS's console.profile()) carry symbol names
+    // in their stacks instead of return addresses, so there is no executable to load.
+    bool is_symbolicated = object.get("symbolicated").to_bool();
+
+    struct LoadedExecutable {
+        String path;
+        OwnPtr<MappedFile> file;
+        RefPtr<ELF::Loader> loader;
+
+        // Symbolication is a search through the ELF symbol table, but the same few return
+        // addresses show up in nearly every sample, so each one is only looked up once.
+        struct CachedSymbol {
+            String symbol;
+            u32 offset { 0 };
+        };
+        HashMap<FlatPtr, CachedSymbol> symbol_cache;
 
-    MappedFile elf_file(executable_path);
-    if (!elf_file.is_valid()) {
-        fprintf(stderr, "Unable to open executable '%s' for symbolication.\n", executable_path.characters());
-        return nullptr;
-    }
+        const CachedSymbol& symbolicate(FlatPtr address)
+        {
+            auto it = symbol_cache.find(address);
+            if (it != symbol_cache.end())
+                return it->value;
+            CachedSymbol cached;
+            cached.symbol = loader->symbolicate(address, &cached.offset);
+            symbol_cache.set(address, move(cached));
+            return symbol_cache.find(address)->value;
+        }
+    };
+
+    // A system-wide profile covers many processes, each one symbolicated against its own executable.
+    HashMap<String, NonnullOwnPtr<LoadedExecutable>> loaded_executables;
+    auto load_executable = [&](const String& path) -> LoadedExecutable* {
+        auto it = loaded_executables.find(path);
+        if (it != loaded_executables.end())
+            return it->value.ptr();
+        auto executable = make<LoadedExecutable>();
+        executable->path = path;
+        executable->file = make<MappedFile>(path);
+        if (!executable->file->is_valid()) {
+            fprintf(stderr, "Unable to open executable '%s' for symbolication.\n", path.characters());
+            return nullptr;
+        }
+        executable->loader = ELF::Loader::create(static_cast<const u8*>(executable->file->data()), executable->file->size());
+        auto* executable_ptr = executable.ptr();
+        loaded_executables.set(path, move(executable));
+        return executable_ptr;
+    };
 
-    auto elf_loader = ELF::Loader::create(static_cast<const u8*>(elf_file.data()), elf_file.size());
+    HashMap<pid_t, LoadedExecutable*> executable_for_pid;
+    LoadedExecutable* main_executable = nullptr;
+    if (is_system_wide) {
+        object.get("processes").as_array().for_each([&](auto& value) {
+            auto& process = value.as_object();
+            if (auto* executable = load_executable(process.get("executable").to_string()))
+                executable_for_pid.set(process.get("pid").to_i32(), executable);
+        });
+    } else if (!is_symbolicated) {
+        main_executable = load_executable(executable_path);
+        if (!main_executable)
+            return nullptr;
+    }
 
-    MappedFile kernel_elf_file("/boot/Kernel");
-    RefPtr<ELF::Loader> kernel_elf_loader;
-    if (kernel_elf_file.is_valid())
-        kernel_elf_loader = ELF::Loader::create(static_cast<const u8*>(kernel_elf_file.data()), kernel_elf_file.size());
+    LoadedExecutable kernel_executable;
+    kernel_executable.file = make<MappedFile>("/boot/Kernel");
+    if (kernel_executable.file->is_valid())
+        kernel_executable.loader = ELF::Loader::create(static_cast<const u8*>(kernel_executable.file->data()), kernel_executable.file->size());
 
     auto events_value = object.get("events");
     if (!events_value.is_array())
@@ -202,14 +302,96 @@ OwnPtr<Profile> Profile::load_from_perfcore_file(const StringView& path)
         return nullptr;
 
     Vector<Event> events;
+    events.ensure_capacity(perf_events.size());
+    Vector<Profile::Interval> intervals;
+    HashMap<int, Profile::Interval> switched_out_threads;
+    HashMap<int, Profile::Interval> threads_waiting_for_block_io;
+
+    // Syscalls, page faults and lock waits are measured in TSC cycles, which we convert to
+    // milliseconds once we've seen how fast the TSC ran during the profile.
+    struct TSCInterval {
+        Profile::Interval interval;
+        u64 cycles { 0 };
+    };
+    Vector<TSCInterval> tsc_intervals;
+    Optional<u64> first_tsc;
+    u64 first_tsc_timestamp = 0;
+    u64 last_tsc = 0;
+    u64 last_tsc_timestamp = 0;
 
     for (auto& perf_event_value : perf_events.values()) {
         auto& perf_event = perf_event_value.as_object();
 
+        // The kernel's events have no stack; they only mark where a thread stopped running, and why.
+        auto type = perf_event.get("type").to_string();
+        auto tid = perf_event.get("tid").to_i32();
+        auto timestamp = perf_event.get("timestamp").to_number<u64>();
+        if (perf_event.has("tsc")) {
+            auto tsc = perf_event.get("tsc").to_number<u64>();
+            if (!first_tsc.has_value()) {
+                first_tsc = tsc;
+                first_tsc_timestamp = timestamp;
+            }
+            last_tsc = tsc;
+            last_tsc_timestamp = timestamp;
+        }
+        if (type == "switch_out") {
+            switched_out_threads.set(tid, { Profile::Interval::Type::OffCPU, tid, timestamp, timestamp, perf_event.get("reason").to_string() });
+            continue;
+        }
+        if (type == "wakeup") {
+            // The rest of the time off the CPU was spent waiting to be scheduled again.
+            auto it = switched_out_threads.find(tid);
+            if (it != switched_out_threads.end()) {
+                auto interval = it->value;
+                interval.end = timestamp;
+                intervals.append(move(interval));
+                it->value = { Profile::Interval::Type::OffCPU, tid, timestamp, timestamp, "Runnable" };
+            }
+            continue;
+        }
+        if (type == "block_io_submit") {
+            threads_waiting_for_block_io.set(tid, { Profile::Interval::Type::BlockIO, tid, timestamp, timestamp, perf_event.get("is_write").to_bool() ? "Write" : "Read" });
+            continue;
+        }
+        if (type == "switch_in" || type == "block_io_complete") {
+            auto& pending_intervals = type == "switch_in" ? switched_out_threads : threads_waiting_for_block_io;
+            auto it = pending_intervals.find(tid);
+            if (it != pending_intervals.end()) {
+                auto interval = it->value;
+                interval.end = timestamp;
+                intervals.append(move(interval));
+                pending_intervals.remove(it);
+            }
+            continue;
+        }
+        if (type == "page_fault" || type == "syscall" || type == "lock_wait") {
+            Profile::Interval::Type interval_type;
+            String reason;
+            if (type == "syscall") {
+                interval_type = Profile::Interval::Type::Syscall;
+                reason = perf_event.get("function").to_string();
+            } else if (type == "page_fault") {
+                interval_type = Profile::Interval::Type::PageFault;
+                reason = perf_event.get("fault_type").to_string();
+            } else {
+                interval_type = Profile::Interval::Type::LockWait;
+                reason = perf_event.get("lock").to_string();
+            }
+            u64 cycles = perf_event.get("tsc").to_number<u64>() - perf_event.get("start_tsc").to_number<u64>();
+            tsc_intervals.append({ { interval_type, tid, timestamp, timestamp, reason }, cycles });
+            continue;
+        }
+
         Event event;
 
         event.timestamp = perf_event.get("timestamp").to_number<u64>();
         event.type = perf_event.get("type").to_string();
+        event.pid = perf_event.get("pid").to_i32();
+
+        auto* executable = main_executable;
+        if (is_system_wide)
+            executable = executable_for_pid.get(event.pid).value_or(nullptr);
 
         if (event.type == "malloc") {
             event.ptr = perf_event.get("ptr").to_number<FlatPtr>();
@@ -218,24 +400,39 @@ OwnPtr<Profile> Profile::load_from_perfcore_file(const StringView& path)
             event.ptr = perf_event.get("ptr").to_number<FlatPtr>();
         }
 
-        auto stack_array = perf_event.get("stack").as_array();
-        for (ssize_t i = stack_array.values().size() - 1; i >= 0; --i) {
+        auto* stack_value = perf_event.get_ptr("stack");
+        if (!stack_value || !stack_value->is_array())
+            continue;
+        auto& stack_array = stack_value->as_array();
+        event.frames.ensure_capacity(stack_array.size() + 1);
+        if (is_symbolicated) {
+            for (ssize_t i = stack_array.size() - 1; i >= 0; --i)
+                event.frames.append({ stack_array.at(i).to_string(), 0, 0, {} });
+            if (event.frames.is_empty())
+                continue;
+            event.in_kernel = false;
+            events.append(move(event));
+            continue;
+        }
+        for (ssize_t i = stack_array.size() - 1; i >= 0; --i) {
             auto& frame = stack_array.at(i);
             auto ptr = frame.to_number<u32>();
             u32 offset = 0;
             String symbol;
 
-            if (ptr >= 0xc0000000) {
-                if (kernel_elf_loader) {
-                    symbol = kernel_elf_loader->symbolicate(ptr, &offset);
-                } else {
-                    symbol = "??";
-                }
+            auto* frame_executable = ptr >= 0xc0000000 ? &kernel_executable : executable;
+            if (frame_executable && frame_executable->loader) {
+                auto& cached = frame_executable->symbolicate(ptr);
+                symbol = cached.symbol;
+                offset = cached.offset;
             } else {
-                symbol = elf_loader->symbolicate(ptr, &offset);
+                symbol = "??";
             }
 
-            event.frames.append({ symbol, ptr, offset });
+            String frame_executable_path;
+            if (ptr < 0xc0000000 && executable)
+                frame_executable_path = executable->path;
+            event.frames.append({ symbol, ptr, offset, frame_executable_path });
         }
 
         if (event.frames.size() < 2)
@@ -244,10 +441,25 @@ OwnPtr<Profile> Profile::load_from_perfcore_file(const StringView& path)
         FlatPtr innermost_frame_address = event.frames.at(1).address;
         event.in_kernel = innermost_frame_address >= 0xc0000000;
 
+        if (is_system_wide) {
+            // Group the samples by process so that each one gets its own subtree.
+            String process_name = executable ? LexicalPath(executable->path).basename() : "??";
+            event.frames.prepend({ String::format("%s (%d)", process_name.characters(), event.pid), 0, 0, {} });
+        }
+
         events.append(move(event));
     }
 
-    return NonnullOwnPtr<Profile>(NonnullOwnPtr<Profile>::Adopt, *new Profile(executable_path, move(events)));
+    if (first_tsc.has_value() && last_tsc_timestamp > first_tsc_timestamp) {
+        u64 cycles_per_ms = (last_tsc - first_tsc.value()) / (last_tsc_timestamp - first_tsc_timestamp);
+        for (auto& tsc_interval : tsc_intervals) {
+            auto& interval = tsc_interval.interval;
+            interval.start = interval.end - min(interval.end, tsc_interval.cycles / max(cycles_per_ms, (u64)1));
+            intervals.append(move(interval));
+        }
+    }
+
+    return NonnullOwnPtr<Profile>(NonnullOwnPtr<Profile>::Adopt, *new Profile(is_system_wide || is_symbolicated ? String() : executable_path, move(events), move(intervals)));
 }
 
 void ProfileNode::sort_children()
@@ -280,6 +492,8 @@ void Profile::set_inverted(bool inverted)
     if (m_inverted == inverted)
         return;
     m_inverted = inverted;
+    if (m_baseline)
+        m_baseline->set_inverted(inverted);
     rebuild_tree();
 }
 
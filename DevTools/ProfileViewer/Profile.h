@@ -39,12 +39,13 @@ class DisassemblyModel;
 
 class ProfileNode : public RefCounted<ProfileNode> {
 public:
-    static NonnullRefPtr<ProfileNode> create(const String& symbol, u32 address, u32 offset, u64 timestamp)
+    static NonnullRefPtr<ProfileNode> create(const String& symbol, u32 address, u32 offset, u64 timestamp, const String& executable_path = {})
     {
-        return adopt(*new ProfileNode(symbol, address, offset, timestamp));
+        return adopt(*new ProfileNode(symbol, address, offset, timestamp, executable_path));
     }
 
     const String& symbol() const { return m_symbol; }
+    const String& executable_path() const { return m_executable_path; }
     u32 address() const { return m_address; }
     u32 offset() const { return m_offset; }
     u64 timestamp() const { return m_timestamp; }
@@ -53,6 +54,7 @@ public:
     u32 self_count() const { return m_self_count; }
 
     int child_count() const { return m_children.size(); }
+    Vector<NonnullRefPtr<ProfileNode>>& children() { return m_children; }
     const Vector<NonnullRefPtr<ProfileNode>>& children() const { return m_children; }
 
     void add_child(ProfileNode& child)
@@ -64,16 +66,18 @@ public:
         m_children.append(child);
     }
 
-    ProfileNode& find_or_create_child(const String& symbol, u32 address, u32 offset, u64 timestamp)
+    ProfileNode* find_child(const String& symbol) const
+    {
+        return m_children_by_symbol.get(symbol).value_or(nullptr);
+    }
+
+    ProfileNode& find_or_create_child(const String& symbol, u32 address, u32 offset, u64 timestamp, const String& executable_path = {})
     {
-        for (size_t i = 0; i < m_children.size(); ++i) {
-            auto& child = m_children[i];
-            if (child->symbol() == symbol) {
-                return child;
-            }
-        }
-        auto new_child = ProfileNode::create(symbol, address, offset, timestamp);
+        if (auto* child = find_child(symbol))
+            return *child;
+        auto new_child = ProfileNode::create(symbol, address, offset, timestamp, executable_path);
         add_child(new_child);
+        m_children_by_symbol.set(symbol, new_child.ptr());
         return new_child;
     };
 
@@ -83,6 +87,10 @@ public:
     void increment_event_count() { ++m_event_count; }
     void increment_self_count() { ++m_self_count; }
 
+    // How many samples went through the same call path in the baseline profile, when comparing two.
+    u32 baseline_event_count() const { return m_baseline_event_count; }
+    void set_baseline_event_count(u32 count) { m_baseline_event_count = count; }
+
     void sort_children();
 
     const HashMap<FlatPtr, size_t>& events_per_address() const { return m_events_per_address; }
@@ -96,8 +104,9 @@ public:
     }
 
 private:
-    explicit ProfileNode(const String& symbol, u32 address, u32 offset, u64 timestamp)
+    explicit ProfileNode(const String& symbol, u32 address, u32 offset, u64 timestamp, const String& executable_path)
         : m_symbol(symbol)
+        , m_executable_path(executable_path)
         , m_address(address)
         , m_offset(offset)
         , m_timestamp(timestamp)
@@ -106,12 +115,15 @@ private:
 
     ProfileNode* m_parent { nullptr };
     String m_symbol;
+    String m_executable_path;
     u32 m_address { 0 };
     u32 m_offset { 0 };
     u32 m_event_count { 0 };
     u32 m_self_count { 0 };
+    u32 m_baseline_event_count { 0 };
     u64 m_timestamp { 0 };
     Vector<NonnullRefPtr<ProfileNode>> m_children;
+    HashMap<String, ProfileNode*> m_children_by_symbol;
     HashMap<FlatPtr, size_t> m_events_per_address;
 };
 
@@ -131,20 +143,40 @@ public:
         String symbol;
         u32 address { 0 };
         u32 offset { 0 };
+        String executable_path;
     };
 
     struct Event {
         u64 timestamp { 0 };
         String type;
+        pid_t pid { 0 };
         FlatPtr ptr { 0 };
         size_t size { 0 };
         bool in_kernel { false };
         Vector<Frame> frames;
     };
 
+    // A stretch of time reconstructed from the kernel's events, e.g. while a thread
+    // was switched out, waiting for a block device or a kernel lock, or inside a syscall.
+    struct Interval {
+        enum class Type {
+            OffCPU,
+            BlockIO,
+            Syscall,
+            PageFault,
+            LockWait,
+        };
+        Type type { Type::OffCPU };
+        int tid { 0 };
+        u64 start { 0 };
+        u64 end { 0 };
+        String reason;
+    };
+
     u32 filtered_event_count() const { return m_filtered_event_count; }
 
     const Vector<Event>& events() const { return m_events; }
+    const Vector<Interval>& intervals() const { return m_intervals; }
 
     u64 length_in_ms() const { return m_last_timestamp - m_first_timestamp; }
     u64 first_timestamp() const { return m_first_timestamp; }
@@ -163,14 +195,24 @@ public:
 
     const String& executable_path() const { return m_executable_path; }
 
+    // Compares this profile against an older one, e.g. from the previous build.
+    // Every node then knows how many samples the same call path had there.
+    const Profile* baseline() const { return m_baseline.ptr(); }
+    void set_baseline(OwnPtr<Profile>&&);
+
+    // The change in a node's share of all samples since the baseline, in percentage points.
+    float difference_from_baseline(const ProfileNode&) const;
+
 private:
-    Profile(String executable_path, Vector<Event>);
+    Profile(String executable_path, Vector<Event>, Vector<Interval>);
 
     void rebuild_tree();
+    void match_against_baseline();
 
     String m_executable_path;
 
     RefPtr<ProfileModel> m_model;
+    Vector<Interval> m_intervals;
     RefPtr<DisassemblyModel> m_disassembly_model;
 
     GUI::ModelIndex m_disassembly_index;
@@ -189,4 +231,6 @@ private:
     u32 m_deepest_stack_depth { 0 };
     bool m_inverted { false };
     bool m_show_percentages { false };
+
+    OwnPtr<Profile> m_baseline;
 };
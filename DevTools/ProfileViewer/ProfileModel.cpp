@@ -90,7 +90,7 @@ int ProfileModel::row_count(const GUI::ModelIndex& index) const
 
 int ProfileModel::column_count(const GUI::ModelIndex&) const
 {
-    return Column::__Count;
+    return m_profile.baseline() ? Column::__Count : Column::Difference;
 }
 
 String ProfileModel::column_name(int column) const
@@ -102,6 +102,8 @@ String ProfileModel::column_name(int column) const
         return m_profile.show_percentages() ? "% Self" : "# Self";
     case Column::StackFrame:
         return "Stack Frame";
+    case Column::Difference:
+        return "% Change";
     default:
         ASSERT_NOT_REACHED();
         return {};
@@ -112,9 +114,20 @@ GUI::Variant ProfileModel::data(const GUI::ModelIndex& index, Role role) const
 {
     auto* node = static_cast<ProfileNode*>(index.internal_data());
     if (role == Role::TextAlignment) {
-        if (index.column() == Column::SampleCount || index.column() == Column::SelfCount)
+        if (index.column() == Column::SampleCount || index.column() == Column::SelfCount || index.column() == Column::Difference)
             return Gfx::TextAlignment::CenterRight;
     }
+    if (role == Role::ForegroundColor) {
+        if (index.column() == Column::Difference) {
+            // Anything under a tenth of a percentage point is noise.
+            float difference = m_profile.difference_from_baseline(*node);
+            if (difference >= 0.1f)
+                return Color(Color::DarkRed);
+            if (difference <= -0.1f)
+                return Color(Color::DarkGreen);
+        }
+        return {};
+    }
     if (role == Role::Icon) {
         if (index.column() == Column::StackFrame) {
             if (node->address() >= 0xc0000000)
@@ -136,6 +149,8 @@ GUI::Variant ProfileModel::data(const GUI::ModelIndex& index, Role role) const
         }
         if (index.column() == Column::StackFrame)
             return node->symbol();
+        if (index.column() == Column::Difference)
+            return String::format("%+.2f", m_profile.difference_from_baseline(*node));
         return {};
     }
     return {};
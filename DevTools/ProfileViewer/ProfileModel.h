@@ -42,6 +42,8 @@ public:
         SampleCount,
         SelfCount,
         StackFrame,
+        // Only shown when comparing against a baseline profile.
+        Difference,
         __Count
     };
 
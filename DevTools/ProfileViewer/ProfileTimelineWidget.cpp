@@ -34,7 +34,9 @@ ProfileTimelineWidget::ProfileTimelineWidget(Profile& profile)
     set_background_color(Color::White);
     set_fill_with_background_color(true);
     set_size_policy(GUI::SizePolicy::Fill, GUI::SizePolicy::Fixed);
-    set_preferred_size(0, 80);
+    set_preferred_size(0, 80 + interval_lane_count * interval_lane_height);
+    // Painting goes through every sample in the profile, so don't redo that unless the selection changes.
+    set_retains_display_list(true);
 }
 
 ProfileTimelineWidget::~ProfileTimelineWidget()
@@ -49,7 +51,38 @@ void ProfileTimelineWidget::paint_event(GUI::PaintEvent& event)
     painter.add_clip_rect(event.rect());
 
     float column_width = (float)frame_inner_rect().width() / (float)m_profile.length_in_ms();
-    float frame_height = (float)frame_inner_rect().height() / (float)m_profile.deepest_stack_depth();
+
+    // The kernel's events get a lane each above the samples, so it's visible where the time went while not running.
+    int lanes_height = m_profile.intervals().is_empty() ? 0 : interval_lane_count * interval_lane_height;
+    for (auto& interval : m_profile.intervals()) {
+        if (interval.end < m_profile.first_timestamp() || interval.start > m_profile.last_timestamp())
+            continue;
+        int start_x = (int)((float)(max(interval.start, m_profile.first_timestamp()) - m_profile.first_timestamp()) * column_width);
+        int end_x = (int)((float)(min(interval.end, m_profile.last_timestamp()) - m_profile.first_timestamp()) * column_width);
+        int lane = (int)interval.type;
+        Color color;
+        switch (interval.type) {
+        case Profile::Interval::Type::OffCPU:
+            // Grey while the thread could have run, brown while it was blocked.
+            color = interval.reason == "Preempted" || interval.reason == "Runnable" ? Color::from_rgb(0xc0c0c0) : Color::from_rgb(0xc2a05a);
+            break;
+        case Profile::Interval::Type::BlockIO:
+            color = Color::from_rgb(0x5ac27a);
+            break;
+        case Profile::Interval::Type::Syscall:
+            color = Color::from_rgb(0x9a5ac2);
+            break;
+        case Profile::Interval::Type::PageFault:
+            color = Color::from_rgb(0xc25e5a);
+            break;
+        case Profile::Interval::Type::LockWait:
+            color = Color::from_rgb(0x5a8ac2);
+            break;
+        }
+        painter.fill_rect({ frame_thickness() + start_x, frame_thickness() + lane * interval_lane_height, max(1, end_x - start_x), interval_lane_height - 1 }, color);
+    }
+
+    float frame_height = (float)(frame_inner_rect().height() - lanes_height) / (float)m_profile.deepest_stack_depth();
 
     for (auto& event : m_profile.events()) {
         u64 t = event.timestamp - m_profile.first_timestamp();
@@ -57,6 +90,7 @@ void ProfileTimelineWidget::paint_event(GUI::PaintEvent& event)
         int cw = max(1, (int)column_width);
 
         int column_height = frame_inner_rect().height() - (int)((float)event.frames.size() * frame_height);
+        column_height = max(column_height, lanes_height);
 
         bool in_kernel = event.in_kernel;
         Color color = in_kernel ? Color::from_rgb(0xc25e5a) : Color::from_rgb(0x5a65c2);
@@ -45,6 +45,9 @@ private:
 
     u64 timestamp_at_x(int x) const;
 
+    static constexpr int interval_lane_count = 5;
+    static constexpr int interval_lane_height = 6;
+
     Profile& m_profile;
 
     bool m_selecting { false };
@@ -24,8 +24,10 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include "FlameGraphWidget.h"
 #include "Profile.h"
 #include "ProfileTimelineWidget.h"
+#include <LibCore/ArgsParser.h>
 #include <LibGUI/Action.h>
 #include <LibGUI/Application.h>
 #include <LibGUI/BoxLayout.h>
@@ -33,6 +35,7 @@
 #include <LibGUI/MenuBar.h>
 #include <LibGUI/Model.h>
 #include <LibGUI/Splitter.h>
+#include <LibGUI/TabWidget.h>
 #include <LibGUI/TableView.h>
 #include <LibGUI/TreeView.h>
 #include <LibGUI/Window.h>
@@ -40,12 +43,14 @@
 
 int main(int argc, char** argv)
 {
-    if (argc != 2) {
-        printf("usage: %s <profile-file>\n", argv[0]);
-        return 0;
-    }
+    const char* path = nullptr;
+    const char* baseline_path = nullptr;
+
+    Core::ArgsParser args_parser;
+    args_parser.add_option(baseline_path, "Compare against an older profile", "diff", 'd', "baseline-file");
+    args_parser.add_positional_argument(path, "Profile to show", "profile-file");
+    args_parser.parse(argc, argv);
 
-    const char* path = argv[1];
     auto profile = Profile::load_from_perfcore_file(path);
 
     if (!profile) {
@@ -53,6 +58,15 @@ int main(int argc, char** argv)
         return 1;
     }
 
+    if (baseline_path) {
+        auto baseline = Profile::load_from_perfcore_file(baseline_path);
+        if (!baseline) {
+            fprintf(stderr, "Unable to load baseline profile '%s'\n", baseline_path);
+            return 1;
+        }
+        profile->set_baseline(move(baseline));
+    }
+
     GUI::Application app(argc, argv);
 
     auto window = GUI::Window::construct();
@@ -67,10 +81,17 @@ int main(int argc, char** argv)
 
     auto& bottom_splitter = main_widget.add<GUI::VerticalSplitter>();
 
-    auto& tree_view = bottom_splitter.add<GUI::TreeView>();
+    auto& tab_widget = bottom_splitter.add<GUI::TabWidget>();
+
+    auto& tree_view = tab_widget.add_tab<GUI::TreeView>("Call Tree");
     tree_view.set_headers_visible(true);
     tree_view.set_model(profile->model());
 
+    auto& flame_graph = tab_widget.add_tab<FlameGraphWidget>("Flame Graph", *profile);
+    profile->model().on_update = [&] {
+        flame_graph.update();
+    };
+
     auto& disassembly_view = bottom_splitter.add<GUI::TableView>();
 
     tree_view.on_selection = [&](auto& index) {
@@ -281,6 +281,14 @@ struct [[gnu::packed]] MADTEntryHeader
 };
 
 namespace MADTEntries {
+struct [[gnu::packed]] ProcessorLocalAPIC
+{
+    MADTEntryHeader h;
+    u8 acpi_processor_id;
+    u8 apic_id;
+    u32 flags;
+};
+
 struct [[gnu::packed]] IOAPIC
 {
     MADTEntryHeader h;
@@ -29,6 +29,7 @@
 #include <AK/Types.h>
 #include <Kernel/Arch/i386/CPU.h>
 #include <Kernel/Arch/i386/ISRStubs.h>
+#include <Kernel/Arch/i386/SafeMem.h>
 #include <Kernel/Interrupts/APIC.h>
 #include <Kernel/Interrupts/GenericInterruptHandler.h>
 #include <Kernel/Interrupts/IRQHandler.h>
@@ -37,6 +38,8 @@
 #include <Kernel/Interrupts/SpuriousInterruptHandler.h>
 #include <Kernel/Interrupts/UnhandledInterruptHandler.h>
 #include <Kernel/KSyms.h>
+#include <Kernel/PerformanceCounters.h>
+#include <Kernel/PerformanceEventBuffer.h>
 #include <Kernel/Process.h>
 #include <Kernel/VM/MemoryManager.h>
 #include <Kernel/IO.h>
@@ -46,33 +49,27 @@
 
 namespace Kernel {
 
-struct [[gnu::packed]] DescriptorTablePointer
-{
-    u16 limit;
-    void* address;
-};
-
 static DescriptorTablePointer s_idtr;
-static DescriptorTablePointer s_gdtr;
 static Descriptor s_idt[256];
-static Descriptor s_gdt[256];
 
 static GenericInterruptHandler* s_interrupt_handler[GENERIC_INTERRUPT_HANDLERS_COUNT];
 
-static Vector<u16>* s_gdt_freelist;
-
-static u16 s_gdt_length;
+// The first few GDT entries are the same on every CPU (see Processor::initialize()),
+// the rest are handed out as TSS descriptors for threads.
+static constexpr u16 s_gdt_fixed_entry_count = 8;
+static u16 s_gdt_freelist[256];
+static u16 s_gdt_freelist_size;
 
 u16 gdt_alloc_entry()
 {
-    ASSERT(s_gdt_freelist);
-    ASSERT(!s_gdt_freelist->is_empty());
-    return s_gdt_freelist->take_last();
+    ASSERT(s_gdt_freelist_size);
+    return s_gdt_freelist[--s_gdt_freelist_size];
 }
 
 void gdt_free_entry(u16 entry)
 {
-    s_gdt_freelist->append(entry);
+    ASSERT(s_gdt_freelist_size < 256);
+    s_gdt_freelist[s_gdt_freelist_size++] = entry;
 }
 
 extern "C" void handle_interrupt(RegisterState);
@@ -92,6 +89,8 @@ extern "C" void handle_interrupt(RegisterState);
         "    mov $0x10, %ax\n"                      \
         "    mov %ax, %ds\n"                        \
         "    mov %ax, %es\n"                        \
+        "    mov $0x28, %ax\n"                      \
+        "    mov %ax, %fs\n"                        \
         "    cld\n"                                 \
         "    call " #title "_handler\n"             \
         "    add $0x4, %esp \n"                     \
@@ -119,6 +118,8 @@ extern "C" void handle_interrupt(RegisterState);
         "    mov $0x10, %ax\n"                      \
         "    mov %ax, %ds\n"                        \
         "    mov %ax, %es\n"                        \
+        "    mov $0x28, %ax\n"                      \
+        "    mov %ax, %fs\n"                        \
         "    cld\n"                                 \
         "    call " #title "_handler\n"             \
         "    add $0x4, %esp\n"                      \
@@ -134,7 +135,7 @@ static void dump(const RegisterState& regs)
 {
     u16 ss;
     u32 esp;
-    if (!Process::current || Process::current->is_ring0()) {
+    if (!Process::current() || Process::current()->is_ring0()) {
         ss = regs.ss;
         esp = regs.esp;
     } else {
@@ -160,7 +161,7 @@ static void dump(const RegisterState& regs)
         : "=a"(cr4));
     klog() << "cr0=" << String::format("%08x", cr0) << " cr2=" << String::format("%08x", cr2) << " cr3=" << String::format("%08x", cr3) << " cr4=" << String::format("%08x", cr4);
 
-    if (Process::current && Process::current->validate_read((void*)regs.eip, 8)) {
+    if (Process::current() && Process::current()->validate_read((void*)regs.eip, 8)) {
         SmapDisabler disabler;
         u8* codeptr = (u8*)regs.eip;
         klog() << "code: " << String::format("%02x", codeptr[0]) << " " << String::format("%02x", codeptr[1]) << " " << String::format("%02x", codeptr[2]) << " " << String::format("%02x", codeptr[3]) << " " << String::format("%02x", codeptr[4]) << " " << String::format("%02x", codeptr[5]) << " " << String::format("%02x", codeptr[6]) << " " << String::format("%02x", codeptr[7]);
@@ -169,32 +170,33 @@ static void dump(const RegisterState& regs)
 
 void handle_crash(RegisterState& regs, const char* description, int signal, bool out_of_memory)
 {
-    if (!Process::current) {
+    if (!Process::current()) {
         klog() << description << " with !current";
         hang();
     }
 
     // If a process crashed while inspecting another process,
     // make sure we switch back to the right page tables.
-    MM.enter_process_paging_scope(*Process::current);
+    MM.enter_process_paging_scope(*Process::current());
 
-    klog() << "CRASH: " << description << ". Ring " << (Process::current->is_ring0() ? 0 : 3) << ".";
+    klog() << "CRASH: " << description << ". Ring " << (Process::current()->is_ring0() ? 0 : 3) << ".";
     dump(regs);
 
-    if (Process::current->is_ring0()) {
+    if (Process::current()->is_ring0()) {
         klog() << "Oh shit, we've crashed in ring 0 :(";
         dump_backtrace();
         hang();
     }
 
     cli();
-    Process::current->crash(signal, regs.eip, out_of_memory);
+    Process::current()->crash(signal, regs.eip, out_of_memory);
 }
 
 EH_ENTRY_NO_CODE(6, illegal_instruction);
 void illegal_instruction_handler(RegisterState regs)
 {
     clac();
+    KernelLocker locker;
     handle_crash(regs, "Illegal instruction", SIGILL);
 }
 
@@ -202,6 +204,7 @@ EH_ENTRY_NO_CODE(0, divide_error);
 void divide_error_handler(RegisterState regs)
 {
     clac();
+    KernelLocker locker;
     handle_crash(regs, "Divide error", SIGFPE);
 }
 
@@ -209,6 +212,7 @@ EH_ENTRY(13, general_protection_fault);
 void general_protection_fault_handler(RegisterState regs)
 {
     clac();
+    KernelLocker locker;
     handle_crash(regs, "General protection fault", SIGSEGV);
 }
 
@@ -231,6 +235,8 @@ void page_fault_handler(RegisterState regs)
     asm("movl %%cr2, %%eax"
         : "=a"(fault_address));
 
+    KernelLocker locker;
+
 #ifdef PAGE_FAULT_DEBUG
     u32 fault_page_directory = read_cr3();
     dbg() << "Ring " << (regs.cs & 3)
@@ -246,18 +252,29 @@ void page_fault_handler(RegisterState regs)
 #endif
 
     bool faulted_in_userspace = (regs.cs & 3) == 3;
-    if (faulted_in_userspace && !MM.validate_user_stack(*Process::current, VirtualAddress(regs.userspace_esp))) {
+    if (faulted_in_userspace && !MM.validate_user_stack(*Process::current(), VirtualAddress(regs.userspace_esp))) {
         dbg() << "Invalid stack pointer: " << VirtualAddress(regs.userspace_esp);
         handle_crash(regs, "Bad stack on page fault", SIGSTKFLT);
         ASSERT_NOT_REACHED();
     }
 
+    u64 start_tsc = read_tsc();
     auto response = MM.handle_page_fault(PageFault(regs.exception_code, VirtualAddress(fault_address)));
 
+    // Faults on kernel addresses are left out, since the event buffer itself lives there.
+    if (Thread::current() && is_user_address(VirtualAddress(fault_address))) {
+        if (auto* kernel_event_buffer = Process::current()->kernel_event_buffer())
+            kernel_event_buffer->append_page_fault(*Thread::current(), fault_address, regs.exception_code, start_tsc);
+    }
+
     if (response == PageFaultResponse::ShouldCrash || response == PageFaultResponse::OutOfMemory) {
+        // regs is the frame we return to, so this resumes the faulting copy at its failure path.
+        if (!faulted_in_userspace && response == PageFaultResponse::ShouldCrash && handle_safe_access_fault(regs, fault_address))
+            return;
+
         if (response != PageFaultResponse::OutOfMemory) {
-            if (Thread::current->has_signal_handler(SIGSEGV)) {
-                Thread::current->send_urgent_signal_to_self(SIGSEGV);
+            if (Thread::current()->has_signal_handler(SIGSEGV)) {
+                Thread::current()->send_urgent_signal_to_self(SIGSEGV);
                 return;
             }
         }
@@ -303,7 +320,8 @@ EH_ENTRY_NO_CODE(1, debug);
 void debug_handler(RegisterState regs)
 {
     clac();
-    if (!Process::current || (regs.cs & 3) == 0) {
+    KernelLocker locker;
+    if (!Process::current() || (regs.cs & 3) == 0) {
         klog() << "Debug Exception in Ring0";
         hang();
         return;
@@ -313,25 +331,26 @@ void debug_handler(RegisterState regs)
     if (!is_reason_singlestep)
         return;
 
-    if (Thread::current->tracer()) {
-        Thread::current->tracer()->set_regs(regs);
+    if (Thread::current()->tracer()) {
+        Thread::current()->tracer()->set_regs(regs);
     }
-    Thread::current->send_urgent_signal_to_self(SIGTRAP);
+    Thread::current()->send_urgent_signal_to_self(SIGTRAP);
 }
 
 EH_ENTRY_NO_CODE(3, breakpoint);
 void breakpoint_handler(RegisterState regs)
 {
     clac();
-    if (!Process::current || (regs.cs & 3) == 0) {
+    KernelLocker locker;
+    if (!Process::current() || (regs.cs & 3) == 0) {
         klog() << "Breakpoint Trap in Ring0";
         hang();
         return;
     }
-    if (Thread::current->tracer()) {
-        Thread::current->tracer()->set_regs(regs);
+    if (Thread::current()->tracer()) {
+        Thread::current()->tracer()->set_regs(regs);
     }
-    Thread::current->send_urgent_signal_to_self(SIGTRAP);
+    Thread::current()->send_urgent_signal_to_self(SIGTRAP);
 }
 
 #define EH(i, msg)                                                                                                                                                             \
@@ -362,68 +381,359 @@ EH(12, "Stack exception")
 EH(15, "Unknown error")
 EH(16, "Coprocessor error")
 
-static void write_raw_gdt_entry(u16 selector, u32 low, u32 high)
-{
-    u16 i = (selector & 0xfffc) >> 3;
-    s_gdt[i].low = low;
-    s_gdt[i].high = high;
+Processor* Processor::s_processors[MAX_PROCESSOR_COUNT];
+u32 Processor::s_processor_count;
+Atomic<u32> Processor::s_online_count;
 
-    if (i > s_gdt_length)
-        s_gdtr.limit = (s_gdt_length + 1) * 8 - 1;
-}
+// NOTE: The bootstrap processor is set up before global constructors have run,
+//       so it lives in raw storage instead of being a global object.
+alignas(Processor) static u8 s_bsp_processor_storage[sizeof(Processor)];
 
-void write_gdt_entry(u16 selector, Descriptor& descriptor)
-{
-    write_raw_gdt_entry(selector, descriptor.low, descriptor.high);
-}
+// Holds the id + 1 of the CPU that owns the kernel, or 0 if nobody does.
+static Atomic<u32> s_kernel_lock;
+static u32 s_last_kernel_lock_owner;
 
-Descriptor& get_gdt_entry(u16 selector)
+// Bumped whenever a kernel mapping is changed. Other CPUs catch up lazily
+// by flushing their TLB the next time they take the kernel lock.
+static Atomic<u32> s_kernel_tlb_generation;
+
+Processor& Processor::bootstrap_processor()
 {
-    u16 i = (selector & 0xfffc) >> 3;
-    return *(Descriptor*)(&s_gdt[i]);
+    return *reinterpret_cast<Processor*>(s_bsp_processor_storage);
 }
 
-void flush_gdt()
+Processor& Processor::by_id(u32 cpu)
 {
-    s_gdtr.address = s_gdt;
-    s_gdtr.limit = (s_gdt_length * 8) - 1;
-    asm("lgdt %0" ::"m"(s_gdtr)
-        : "memory");
+    ASSERT(cpu < s_processor_count);
+    ASSERT(s_processors[cpu]);
+    return *s_processors[cpu];
 }
 
-void gdt_init()
+void Processor::initialize(u32 cpu)
 {
-    s_gdt_length = 5;
-
-    s_gdt_freelist = new Vector<u16>();
-    s_gdt_freelist->ensure_capacity(256);
-    for (size_t i = s_gdt_length; i < 256; ++i)
-        s_gdt_freelist->append(i * 8);
-
-    s_gdt_length = 256;
-    s_gdtr.address = s_gdt;
-    s_gdtr.limit = (s_gdt_length * 8) - 1;
+    ASSERT(cpu < MAX_PROCESSOR_COUNT);
+    m_self = this;
+    m_cpu = cpu;
+    m_current_thread = nullptr;
+    m_idle_thread = nullptr;
+    m_switching_out_thread = nullptr;
+    m_in_irq = 0;
+    m_kernel_lock_depth = 0;
+    m_in_scheduler = false;
+    m_should_stop_idling = false;
+    m_online = false;
+    m_idle_time_ns = 0;
+    m_busy_time_ns = 0;
+    m_last_accounting_time_ns = 0;
+    m_tlb_generation = s_kernel_tlb_generation.load(AK::memory_order_relaxed);
+    m_tlb_shootdown_vaddr = 0;
+    m_tlb_shootdown_page_count = 0;
+    m_tlb_shootdown_pending = false;
+
+    memset(m_gdt, 0, sizeof(m_gdt));
+    memset(&m_redirection_tss, 0, sizeof(m_redirection_tss));
 
     write_raw_gdt_entry(0x0000, 0x00000000, 0x00000000);
-    write_raw_gdt_entry(0x0008, 0x0000ffff, 0x00cf9a00);
-    write_raw_gdt_entry(0x0010, 0x0000ffff, 0x00cf9200);
-    write_raw_gdt_entry(0x0018, 0x0000ffff, 0x00cffa00);
-    write_raw_gdt_entry(0x0020, 0x0000ffff, 0x00cff200);
+    write_raw_gdt_entry(GDT_SELECTOR_CODE0, 0x0000ffff, 0x00cf9a00);
+    write_raw_gdt_entry(GDT_SELECTOR_DATA0, 0x0000ffff, 0x00cf9200);
+    write_raw_gdt_entry(GDT_SELECTOR_CODE3, 0x0000ffff, 0x00cffa00);
+    write_raw_gdt_entry(GDT_SELECTOR_DATA3, 0x0000ffff, 0x00cff200);
+
+    auto& processor_descriptor = get_gdt_entry(GDT_SELECTOR_PROC);
+    processor_descriptor.set_base(this);
+    processor_descriptor.set_limit(sizeof(Processor));
+    processor_descriptor.dpl = 0;
+    processor_descriptor.segment_present = 1;
+    processor_descriptor.granularity = 0;
+    processor_descriptor.zero = 0;
+    processor_descriptor.operation_size = 1;
+    processor_descriptor.descriptor_type = 1;
+    processor_descriptor.type = 2;
+
+    auto& redirection_descriptor = get_gdt_entry(GDT_SELECTOR_REDIRECTION_TSS);
+    redirection_descriptor.set_base(&m_redirection_tss);
+    redirection_descriptor.set_limit(sizeof(TSS32));
+    redirection_descriptor.dpl = 0;
+    redirection_descriptor.segment_present = 1;
+    redirection_descriptor.granularity = 0;
+    redirection_descriptor.zero = 0;
+    redirection_descriptor.operation_size = 1;
+    redirection_descriptor.descriptor_type = 0;
+    redirection_descriptor.type = 9;
+
+    // The base of the thread-specific descriptor is filled in on every context switch.
+    auto& tls_descriptor = get_gdt_entry(GDT_SELECTOR_TLS);
+    tls_descriptor.dpl = 3;
+    tls_descriptor.segment_present = 1;
+    tls_descriptor.granularity = 0;
+    tls_descriptor.zero = 0;
+    tls_descriptor.operation_size = 1;
+    tls_descriptor.descriptor_type = 1;
+    tls_descriptor.type = 2;
 
     flush_gdt();
 
     asm volatile(
         "mov %%ax, %%ds\n"
         "mov %%ax, %%es\n"
-        "mov %%ax, %%fs\n"
         "mov %%ax, %%gs\n"
-        "mov %%ax, %%ss\n" ::"a"(0x10)
+        "mov %%ax, %%ss\n" ::"a"(GDT_SELECTOR_DATA0)
+        : "memory");
+    asm volatile(
+        "mov %%ax, %%fs\n" ::"a"(GDT_SELECTOR_PROC)
         : "memory");
 
     // Make sure CS points to the kernel code descriptor.
     asm volatile(
-        "ljmpl $0x8, $sanity\n"
-        "sanity:\n");
+        "ljmpl $0x8, $1f\n"
+        "1:\n");
+
+    s_processors[cpu] = this;
+    if (cpu >= s_processor_count)
+        s_processor_count = cpu + 1;
+}
+
+void Processor::set_online()
+{
+    m_online = true;
+    s_online_count.fetch_add(1, AK::memory_order_release);
+}
+
+void Processor::account_time(u64 now_ns)
+{
+    // The clock starts with the first context switch on this CPU.
+    if (m_last_accounting_time_ns && now_ns > m_last_accounting_time_ns) {
+        u64 elapsed = now_ns - m_last_accounting_time_ns;
+        if (m_current_thread == m_idle_thread)
+            m_idle_time_ns += elapsed;
+        else
+            m_busy_time_ns += elapsed;
+    }
+    m_last_accounting_time_ns = now_ns;
+}
+
+u64 Processor::idle_time_ns(u64 now_ns) const
+{
+    if (!m_last_accounting_time_ns || m_current_thread != m_idle_thread || now_ns <= m_last_accounting_time_ns)
+        return m_idle_time_ns;
+    return m_idle_time_ns + (now_ns - m_last_accounting_time_ns);
+}
+
+u64 Processor::busy_time_ns(u64 now_ns) const
+{
+    if (!m_last_accounting_time_ns || m_current_thread == m_idle_thread || now_ns <= m_last_accounting_time_ns)
+        return m_busy_time_ns;
+    return m_busy_time_ns + (now_ns - m_last_accounting_time_ns);
+}
+
+void Processor::write_raw_gdt_entry(u16 selector, u32 low, u32 high)
+{
+    u16 i = (selector & 0xfffc) >> 3;
+    m_gdt[i].low = low;
+    m_gdt[i].high = high;
+}
+
+Descriptor& Processor::get_gdt_entry(u16 selector)
+{
+    u16 i = (selector & 0xfffc) >> 3;
+    return m_gdt[i];
+}
+
+void Processor::flush_gdt()
+{
+    m_gdtr.address = m_gdt;
+    m_gdtr.limit = (256 * 8) - 1;
+    asm("lgdt %0" ::"m"(m_gdtr)
+        : "memory");
+}
+
+void Processor::lock_kernel()
+{
+    bool interrupts_were_enabled = cli_and_save_interrupt_flag();
+    auto& processor = current();
+    if (processor.m_kernel_lock_depth++ == 0)
+        processor.acquire_kernel_lock();
+    processor.finish_switching_out_thread();
+    restore_interrupt_flag(interrupts_were_enabled);
+}
+
+void Processor::unlock_kernel()
+{
+    bool interrupts_were_enabled = cli_and_save_interrupt_flag();
+    auto& processor = current();
+    ASSERT(processor.m_kernel_lock_depth);
+    if (--processor.m_kernel_lock_depth == 0)
+        processor.release_kernel_lock();
+    restore_interrupt_flag(interrupts_were_enabled);
+}
+
+void Processor::set_kernel_lock_depth(u32 depth)
+{
+    ASSERT_INTERRUPTS_DISABLED();
+    ASSERT(m_kernel_lock_depth);
+    m_kernel_lock_depth = depth;
+    if (!depth)
+        release_kernel_lock();
+}
+
+u32 Processor::drop_kernel_lock()
+{
+    ASSERT_INTERRUPTS_DISABLED();
+    u32 depth = m_kernel_lock_depth;
+    ASSERT(depth);
+    m_kernel_lock_depth = 0;
+    release_kernel_lock();
+    return depth;
+}
+
+void Processor::retake_kernel_lock(u32 depth)
+{
+    ASSERT_INTERRUPTS_DISABLED();
+    ASSERT(!m_kernel_lock_depth);
+    acquire_kernel_lock();
+    m_kernel_lock_depth = depth;
+}
+
+void Processor::acquire_kernel_lock()
+{
+    ASSERT_INTERRUPTS_DISABLED();
+    for (;;) {
+        u32 expected = 0;
+        if (s_kernel_lock.compare_exchange_strong(expected, m_cpu + 1, AK::memory_order_acquire))
+            break;
+        // The owner may be waiting for us to acknowledge a TLB shootdown.
+        handle_tlb_shootdown();
+        asm volatile("pause");
+    }
+
+    handle_tlb_shootdown();
+
+    if (s_last_kernel_lock_owner != m_cpu) {
+        // The quickmap slots are shared by all CPUs, and the previous owner
+        // may have pointed them elsewhere without telling us.
+        static constexpr FlatPtr quickmap_addresses[] = { 0xffe00000, 0xffe04000, 0xffe08000 };
+        for (auto vaddr : quickmap_addresses) {
+            asm volatile("invlpg %0"
+                         :
+                         : "m"(*(char*)vaddr)
+                         : "memory");
+        }
+        s_last_kernel_lock_owner = m_cpu;
+    }
+}
+
+void Processor::release_kernel_lock()
+{
+    ASSERT(s_kernel_lock.load(AK::memory_order_relaxed) == m_cpu + 1);
+    s_kernel_lock.store(0, AK::memory_order_release);
+}
+
+void Processor::finish_switching_out_thread()
+{
+    auto* thread = m_switching_out_thread;
+    if (!thread)
+        return;
+    m_switching_out_thread = nullptr;
+    thread->set_being_switched_out(false);
+
+    // The finalizer leaves threads alone while they are being switched out,
+    // so give it another chance to pick this one up.
+    if (thread->state() == Thread::Dying) {
+        g_finalizer_has_work = true;
+        g_finalizer_wait_queue->wake_all();
+    }
+}
+
+void Processor::invalidate_page_on_other_processors(VirtualAddress vaddr, const PageDirectory* page_directory, size_t page_count)
+{
+    if (online_count() <= 1)
+        return;
+
+    InterruptDisabler disabler;
+    ASSERT(m_kernel_lock_depth);
+
+    if (vaddr.get() >= 0xc0000000) {
+        // Nobody touches kernel memory without taking the kernel lock first,
+        // so the flush can wait until then.
+        m_tlb_generation = ++s_kernel_tlb_generation;
+        return;
+    }
+
+    // Userspace keeps running on the other CPUs, so those running the affected
+    // page directory have to drop the translation right away.
+    u32 targets = 0;
+    for_each([&](Processor& processor) {
+        if (&processor == this || !processor.is_online())
+            return IterationDecision::Continue;
+        auto* thread = processor.current_thread();
+        if (!thread || thread->process().is_ring0())
+            return IterationDecision::Continue;
+        if (page_directory && &thread->process().page_directory() != page_directory)
+            return IterationDecision::Continue;
+        processor.m_tlb_shootdown_vaddr = vaddr.get();
+        processor.m_tlb_shootdown_page_count = page_count;
+        processor.m_tlb_shootdown_pending = true;
+        APIC::send_tlb_shootdown(processor.id());
+        targets |= 1 << processor.id();
+        return IterationDecision::Continue;
+    });
+
+    for_each([&](Processor& processor) {
+        if (!(targets & (1 << processor.id())))
+            return IterationDecision::Continue;
+        while (processor.m_tlb_shootdown_pending)
+            asm volatile("pause");
+        return IterationDecision::Continue;
+    });
+}
+
+void Processor::handle_tlb_shootdown()
+{
+    u32 generation = s_kernel_tlb_generation.load(AK::memory_order_acquire);
+    if (m_tlb_generation != generation) {
+        // None of our mappings are global, so reloading CR3 drops everything.
+        m_tlb_generation = generation;
+        write_cr3(read_cr3());
+    }
+
+    if (m_tlb_shootdown_pending) {
+        if (m_tlb_shootdown_page_count > tlb_flush_full_reload_threshold) {
+            write_cr3(read_cr3());
+        } else {
+            for (size_t i = 0; i < m_tlb_shootdown_page_count; ++i) {
+                asm volatile("invlpg %0"
+                             :
+                             : "m"(*(char*)(m_tlb_shootdown_vaddr + i * PAGE_SIZE))
+                             : "memory");
+            }
+        }
+        m_tlb_shootdown_pending = false;
+    }
+}
+
+void write_gdt_entry(u16 selector, Descriptor& descriptor)
+{
+    Processor::current().write_raw_gdt_entry(selector, descriptor.low, descriptor.high);
+}
+
+Descriptor& get_gdt_entry(u16 selector)
+{
+    return Processor::current().get_gdt_entry(selector);
+}
+
+void flush_gdt()
+{
+    Processor::current().flush_gdt();
+}
+
+void gdt_init()
+{
+    for (u16 i = s_gdt_fixed_entry_count; i < 256; ++i)
+        s_gdt_freelist[s_gdt_freelist_size++] = i * 8;
+
+    auto* processor = new (s_bsp_processor_storage) Processor;
+    processor->initialize(0);
+    processor->set_online();
 }
 
 static void unimp_trap()
@@ -679,18 +989,18 @@ void load_task_register(u16 selector)
     asm("ltr %0" ::"r"(selector));
 }
 
-u32 g_in_irq;
-
 void handle_interrupt(RegisterState regs)
 {
     clac();
-    ++g_in_irq;
+    KernelLocker locker;
+    auto& in_irq = Processor::current().in_irq();
+    ++in_irq;
     ASSERT(regs.isr_number >= IRQ_VECTOR_BASE && regs.isr_number <= (IRQ_VECTOR_BASE + GENERIC_INTERRUPT_HANDLERS_COUNT));
     u8 irq = (u8)(regs.isr_number - 0x50);
     ASSERT(s_interrupt_handler[irq]);
     s_interrupt_handler[irq]->handle_interrupt(regs);
     s_interrupt_handler[irq]->increment_invoking_counter();
-    --g_in_irq;
+    --in_irq;
     s_interrupt_handler[irq]->eoi();
 }
 
@@ -710,9 +1020,11 @@ bool g_cpu_supports_nx;
 bool g_cpu_supports_pae;
 bool g_cpu_supports_pge;
 bool g_cpu_supports_rdrand;
+bool g_cpu_supports_rdseed;
 bool g_cpu_supports_smap;
 bool g_cpu_supports_smep;
 bool g_cpu_supports_sse;
+bool g_cpu_supports_sse2;
 bool g_cpu_supports_tsc;
 bool g_cpu_supports_umip;
 
@@ -722,6 +1034,7 @@ void cpu_detect()
     g_cpu_supports_pae = (processor_info.edx() & (1 << 6));
     g_cpu_supports_pge = (processor_info.edx() & (1 << 13));
     g_cpu_supports_sse = (processor_info.edx() & (1 << 25));
+    g_cpu_supports_sse2 = (processor_info.edx() & (1 << 26));
     g_cpu_supports_tsc = (processor_info.edx() & (1 << 4));
     g_cpu_supports_rdrand = (processor_info.ecx() & (1 << 30));
 
@@ -729,6 +1042,7 @@ void cpu_detect()
     g_cpu_supports_nx = (extended_processor_info.edx() & (1 << 20));
 
     CPUID extended_features(0x7);
+    g_cpu_supports_rdseed = (extended_features.ebx() & (1 << 18));
     g_cpu_supports_smap = (extended_features.ebx() & (1 << 20));
     g_cpu_supports_smep = (extended_features.ebx() & (1 << 7));
     g_cpu_supports_umip = (extended_features.ecx() & (1 << 2));
@@ -812,11 +1126,15 @@ void cpu_setup()
         klog() << "x86: RDTSC support restricted";
     }
 
-    if (g_cpu_supports_rdrand) {
-        klog() << "x86: Using RDRAND for good randomness";
+    if (g_cpu_supports_rdseed) {
+        klog() << "x86: Using RDSEED to seed the random pool";
+    } else if (g_cpu_supports_rdrand) {
+        klog() << "x86: Using RDRAND to seed the random pool";
     } else {
         klog() << "x86: No RDRAND support detected. Randomness will be shitty";
     }
+
+    PerformanceCounters::initialize_processor();
 }
 
 u32 read_cr3()
@@ -852,8 +1170,8 @@ void __assertion_failed(const char* msg, const char* file, unsigned line, const
 
     // Switch back to the current process's page tables if there are any.
     // Otherwise stack walking will be a disaster.
-    if (Process::current)
-        MM.enter_process_paging_scope(*Process::current);
+    if (Process::current())
+        MM.enter_process_paging_scope(*Process::current());
 
     Kernel::dump_backtrace();
     asm volatile("hlt");
@@ -26,7 +26,9 @@
 
 #pragma once
 
+#include <AK/Atomic.h>
 #include <AK/Badge.h>
+#include <AK/IterationDecision.h>
 #include <AK/Noncopyable.h>
 #include <Kernel/PhysicalAddress.h>
 #include <Kernel/VirtualAddress.h>
@@ -35,11 +37,29 @@
 #define GENERIC_INTERRUPT_HANDLERS_COUNT 128
 #define PAGE_MASK ((FlatPtr)0xfffff000u)
 
+#define GDT_SELECTOR_CODE0 0x08
+#define GDT_SELECTOR_DATA0 0x10
+#define GDT_SELECTOR_CODE3 0x18
+#define GDT_SELECTOR_DATA3 0x20
+#define GDT_SELECTOR_PROC 0x28
+#define GDT_SELECTOR_REDIRECTION_TSS 0x30
+#define GDT_SELECTOR_TLS 0x38
+
+// NOTE: The local APIC is set up in flat logical destination mode, which limits us to 8 CPUs.
+#define MAX_PROCESSOR_COUNT 8
+
 namespace Kernel {
 
 class MemoryManager;
 class PageDirectory;
 class PageTableEntry;
+class Thread;
+
+struct [[gnu::packed]] DescriptorTablePointer
+{
+    u16 limit;
+    void* address;
+};
 
 struct [[gnu::packed]] TSS32
 {
@@ -578,9 +598,11 @@ extern bool g_cpu_supports_nx;
 extern bool g_cpu_supports_pae;
 extern bool g_cpu_supports_pge;
 extern bool g_cpu_supports_rdrand;
+extern bool g_cpu_supports_rdseed;
 extern bool g_cpu_supports_smap;
 extern bool g_cpu_supports_smep;
 extern bool g_cpu_supports_sse;
+extern bool g_cpu_supports_sse2;
 extern bool g_cpu_supports_tsc;
 extern bool g_cpu_supports_umip;
 
@@ -618,6 +640,145 @@ private:
     u32 m_flags;
 };
 
-extern u32 g_in_irq;
+// Flushing more user pages than this from the TLB is done by reloading CR3 rather than
+// with one invlpg per page.
+static constexpr size_t tlb_flush_full_reload_threshold = 32;
+
+// Per-CPU state. Each CPU finds its own Processor through the GDT_SELECTOR_PROC
+// segment, which every entry stub loads into %fs.
+//
+// The kernel itself is still serialized by a single recursive "giant" lock:
+// a CPU holds it whenever it executes kernel code, except in the idle loop.
+// This keeps all the existing InterruptDisabler-based critical sections valid.
+class Processor {
+    AK_MAKE_NONCOPYABLE(Processor);
+    AK_MAKE_NONMOVABLE(Processor);
+
+public:
+    Processor() { }
+
+    void initialize(u32 cpu);
+
+    ALWAYS_INLINE static Processor& current()
+    {
+        return *(Processor*)read_fs_u32(__builtin_offsetof(Processor, m_self));
+    }
+
+    static Processor& bootstrap_processor();
+    static Processor& by_id(u32 cpu);
+    static u32 count() { return s_processor_count; }
+    static u32 online_count() { return s_online_count.load(AK::memory_order_relaxed); }
+
+    template<typename Callback>
+    static void for_each(Callback callback)
+    {
+        for (u32 i = 0; i < s_processor_count; ++i) {
+            if (callback(*s_processors[i]) == IterationDecision::Break)
+                break;
+        }
+    }
+
+    u32 id() const { return m_cpu; }
+    bool is_bootstrap_processor() const { return m_cpu == 0; }
+    bool is_online() const { return m_online; }
+    void set_online();
+
+    Thread* current_thread() const { return m_current_thread; }
+    void set_current_thread(Thread& thread) { m_current_thread = &thread; }
+
+    Thread* idle_thread() const { return m_idle_thread; }
+    void set_idle_thread(Thread& thread) { m_idle_thread = &thread; }
+
+    // The thread this CPU switched away from, whose TSS may not have been saved yet.
+    Thread* switching_out_thread() const { return m_switching_out_thread; }
+    void set_switching_out_thread(Thread* thread) { m_switching_out_thread = thread; }
+    void finish_switching_out_thread();
+
+    u32& in_irq() { return m_in_irq; }
+    bool& in_scheduler() { return m_in_scheduler; }
+
+    bool should_stop_idling() const { return m_should_stop_idling; }
+    void set_should_stop_idling(bool b) { m_should_stop_idling = b; }
+
+    // Time spent in the idle thread and in everything else, charged at every context switch.
+    // The readers include whatever has been running since the last switch.
+    void account_time(u64 now_ns);
+    u64 idle_time_ns(u64 now_ns) const;
+    u64 busy_time_ns(u64 now_ns) const;
+
+    Descriptor& get_gdt_entry(u16 selector);
+    void write_raw_gdt_entry(u16 selector, u32 low, u32 high);
+    void flush_gdt();
+
+    TSS32& redirection_tss() { return m_redirection_tss; }
+
+    // These operate on whichever CPU the caller is running on.
+    static void lock_kernel();
+    static void unlock_kernel();
+
+    u32 kernel_lock_depth() const { return m_kernel_lock_depth; }
+    void set_kernel_lock_depth(u32);
+
+    // Lets go of the kernel lock while spinning until the condition holds (or we run out of
+    // patience), so whoever we're waiting for can get something done on another CPU.
+    template<typename Condition>
+    void spin_without_kernel_lock(u32 max_spins, Condition condition)
+    {
+        u32 depth = drop_kernel_lock();
+        for (u32 i = 0; i < max_spins && !condition(); ++i) {
+            // Someone may want us to flush a TLB entry before they can go on.
+            handle_tlb_shootdown();
+            asm volatile("pause" ::
+                             : "memory");
+        }
+        retake_kernel_lock(depth);
+    }
+
+    // Make other CPUs drop any stale translation for the given page.
+    void invalidate_page_on_other_processors(VirtualAddress, const PageDirectory* = nullptr, size_t page_count = 1);
+    void handle_tlb_shootdown();
+
+private:
+    void acquire_kernel_lock();
+    void release_kernel_lock();
+    u32 drop_kernel_lock();
+    void retake_kernel_lock(u32 depth);
+
+    Processor* m_self;
+    u32 m_cpu;
+
+    Thread* m_current_thread;
+    Thread* m_idle_thread;
+    Thread* m_switching_out_thread;
+
+    u32 m_in_irq;
+    u32 m_kernel_lock_depth;
+    bool m_in_scheduler;
+    volatile bool m_should_stop_idling;
+    volatile bool m_online;
+
+    u64 m_idle_time_ns;
+    u64 m_busy_time_ns;
+    u64 m_last_accounting_time_ns;
+
+    volatile u32 m_tlb_generation;
+    volatile FlatPtr m_tlb_shootdown_vaddr;
+    volatile size_t m_tlb_shootdown_page_count;
+    volatile bool m_tlb_shootdown_pending;
+
+    DescriptorTablePointer m_gdtr;
+    Descriptor m_gdt[256];
+    TSS32 m_redirection_tss;
+
+    static Processor* s_processors[MAX_PROCESSOR_COUNT];
+    static u32 s_processor_count;
+    static Atomic<u32> s_online_count;
+};
+
+class KernelLocker {
+public:
+    KernelLocker() { Processor::lock_kernel(); }
+    ~KernelLocker() { Processor::unlock_kernel(); }
+};
 
 }
@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2018-2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <Kernel/Arch/i386/CPU.h>
+#include <Kernel/Arch/i386/SafeMem.h>
+
+// Instead of looking up the user's regions before every copy, the copies just go ahead and let
+// the page fault handler tell them if they touched something they shouldn't have. The rep
+// instructions below are the only ones that touch the caller's memory, and a fault in one of them
+// resumes at the matching *_faulted label, which returns false.
+extern "C" u8 safe_memcpy_ins_1[];
+extern "C" u8 safe_memcpy_ins_2[];
+extern "C" u8 safe_memcpy_faulted[];
+extern "C" u8 safe_memset_ins_1[];
+extern "C" u8 safe_memset_ins_2[];
+extern "C" u8 safe_memset_faulted[];
+
+extern "C" bool safe_memcpy_impl(void* dest, const void* src, size_t);
+extern "C" bool safe_memset_impl(void* dest, u32 pattern, size_t);
+
+asm(
+    ".globl safe_memcpy_impl\n"
+    "safe_memcpy_impl:\n"
+    "    pushl %esi\n"
+    "    pushl %edi\n"
+    "    movl 12(%esp), %edi\n"
+    "    movl 16(%esp), %esi\n"
+    "    movl 20(%esp), %edx\n"
+    "    movl %edx, %ecx\n"
+    "    shrl $2, %ecx\n"
+    ".globl safe_memcpy_ins_1\n"
+    "safe_memcpy_ins_1:\n"
+    "    rep movsl\n"
+    "    movl %edx, %ecx\n"
+    "    andl $3, %ecx\n"
+    ".globl safe_memcpy_ins_2\n"
+    "safe_memcpy_ins_2:\n"
+    "    rep movsb\n"
+    "    movl $1, %eax\n"
+    "    popl %edi\n"
+    "    popl %esi\n"
+    "    ret\n"
+    ".globl safe_memcpy_faulted\n"
+    "safe_memcpy_faulted:\n"
+    "    xorl %eax, %eax\n"
+    "    popl %edi\n"
+    "    popl %esi\n"
+    "    ret\n");
+
+asm(
+    ".globl safe_memset_impl\n"
+    "safe_memset_impl:\n"
+    "    pushl %edi\n"
+    "    movl 8(%esp), %edi\n"
+    "    movl 12(%esp), %eax\n"
+    "    movl 16(%esp), %edx\n"
+    "    movl %edx, %ecx\n"
+    "    shrl $2, %ecx\n"
+    ".globl safe_memset_ins_1\n"
+    "safe_memset_ins_1:\n"
+    "    rep stosl\n"
+    "    movl %edx, %ecx\n"
+    "    andl $3, %ecx\n"
+    ".globl safe_memset_ins_2\n"
+    "safe_memset_ins_2:\n"
+    "    rep stosb\n"
+    "    movl $1, %eax\n"
+    "    popl %edi\n"
+    "    ret\n"
+    ".globl safe_memset_faulted\n"
+    "safe_memset_faulted:\n"
+    "    xorl %eax, %eax\n"
+    "    popl %edi\n"
+    "    ret\n");
+
+namespace Kernel {
+
+bool safe_memcpy(void* dest, const void* src, size_t n)
+{
+    return safe_memcpy_impl(dest, src, n);
+}
+
+bool safe_memset(void* dest, int c, size_t n)
+{
+    return safe_memset_impl(dest, explode_byte((u8)c), n);
+}
+
+bool handle_safe_access_fault(RegisterState& regs, u32 fault_address)
+{
+    // The faulting instruction is the one that gets restarted, so eip still points at it.
+    FlatPtr ip = regs.eip;
+    if (ip == (FlatPtr)safe_memcpy_ins_1 || ip == (FlatPtr)safe_memcpy_ins_2) {
+        regs.eip = (FlatPtr)safe_memcpy_faulted;
+    } else if (ip == (FlatPtr)safe_memset_ins_1 || ip == (FlatPtr)safe_memset_ins_2) {
+        regs.eip = (FlatPtr)safe_memset_faulted;
+    } else {
+        return false;
+    }
+#ifdef PAGE_FAULT_DEBUG
+    dbg() << "Safe user access at " << VirtualAddress(ip) << " faulted on " << VirtualAddress(fault_address);
+#else
+    UNUSED_PARAM(fault_address);
+#endif
+    return true;
+}
+
+}
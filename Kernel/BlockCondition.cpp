@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2018-2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <Kernel/BlockCondition.h>
+#include <Kernel/Thread.h>
+
+namespace Kernel {
+
+BlockCondition::BlockCondition()
+{
+}
+
+BlockCondition::~BlockCondition()
+{
+    ASSERT(m_threads.is_empty());
+    ASSERT(m_observers.is_empty());
+}
+
+void BlockCondition::add(Thread& thread)
+{
+    InterruptDisabler disabler;
+    ASSERT(!m_threads.contains_slow(&thread));
+    m_threads.append(&thread);
+}
+
+void BlockCondition::remove(Thread& thread)
+{
+    InterruptDisabler disabler;
+    m_threads.remove_first_matching([&](auto* entry) { return entry == &thread; });
+}
+
+void BlockCondition::add_observer(BlockConditionObserver& observer)
+{
+    InterruptDisabler disabler;
+    ASSERT(!m_observers.contains_slow(&observer));
+    m_observers.append(&observer);
+}
+
+void BlockCondition::remove_observer(BlockConditionObserver& observer)
+{
+    InterruptDisabler disabler;
+    m_observers.remove_first_matching([&](auto* entry) { return entry == &observer; });
+}
+
+void BlockCondition::unblock()
+{
+    InterruptDisabler disabler;
+    for (auto* observer : m_observers)
+        observer->block_condition_did_fire();
+
+    if (m_threads.is_empty())
+        return;
+
+    // Threads that get unblocked remove themselves from m_threads, so walk a copy.
+    auto threads = m_threads;
+    for (auto* thread : threads) {
+        if (thread->is_blocked())
+            thread->consider_unblock();
+    }
+}
+
+}
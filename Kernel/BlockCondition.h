@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2018-2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/Vector.h>
+#include <Kernel/Forward.h>
+
+namespace Kernel {
+
+// Something other than a blocked thread that wants to know when a BlockCondition fires,
+// like an EventQueue watching a File. This is called with interrupts disabled, possibly
+// from an IRQ handler, so implementations must not block or allocate.
+class BlockConditionObserver {
+public:
+    virtual ~BlockConditionObserver() { }
+    virtual void block_condition_did_fire() = 0;
+};
+
+// A BlockCondition is owned by something that blocked threads wait on, like a File
+// or a Process. Whenever the state they're waiting for may have changed, the owner
+// calls unblock() and only the threads registered here get to re-check their blocker.
+class BlockCondition {
+public:
+    BlockCondition();
+    ~BlockCondition();
+
+    void add(Thread&);
+    void remove(Thread&);
+    void unblock();
+
+    void add_observer(BlockConditionObserver&);
+    void remove_observer(BlockConditionObserver&);
+
+    bool is_empty() const { return m_threads.is_empty() && m_observers.is_empty(); }
+
+private:
+    Vector<Thread*, 2> m_threads;
+    Vector<BlockConditionObserver*> m_observers;
+};
+
+}
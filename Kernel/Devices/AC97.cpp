@@ -0,0 +1,253 @@
+/*
+ * Copyright (c) 2018-2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <AK/Memory.h>
+#include <AK/StringView.h>
+#include <Kernel/Devices/AC97.h>
+#include <Kernel/Thread.h>
+#include <Kernel/VM/MemoryManager.h>
+
+//#define AC97_DEBUG
+
+namespace Kernel {
+
+// Native audio mixer registers (BAR0)
+#define NAM_RESET 0x00
+#define NAM_MASTER_VOLUME 0x02
+#define NAM_PCM_OUT_VOLUME 0x18
+#define NAM_EXTENDED_AUDIO_ID 0x28
+#define NAM_EXTENDED_AUDIO_CONTROL 0x2A
+#define NAM_PCM_FRONT_DAC_RATE 0x2C
+
+// Native audio bus master registers (BAR1)
+#define NABM_PCM_OUT 0x10
+#define NABM_GLOBAL_CONTROL 0x2C
+#define NABM_GLOBAL_STATUS 0x30
+
+// Offsets into a bus master box such as NABM_PCM_OUT
+#define BOX_DESCRIPTOR_LIST 0x00
+#define BOX_CURRENT_INDEX 0x04
+#define BOX_LAST_VALID_INDEX 0x05
+#define BOX_STATUS 0x06
+#define BOX_CONTROL 0x0B
+
+#define EXTENDED_AUDIO_VARIABLE_RATE 0x1
+
+#define GLOBAL_CONTROL_COLD_RESET 0x2
+#define GLOBAL_STATUS_PCM_OUT_INTERRUPT 0x40
+#define GLOBAL_STATUS_PRIMARY_CODEC_READY 0x100
+
+#define BOX_STATUS_HALTED 0x1
+#define BOX_STATUS_LAST_VALID_INTERRUPT 0x4
+#define BOX_STATUS_COMPLETION_INTERRUPT 0x8
+#define BOX_STATUS_FIFO_ERROR 0x10
+
+#define BOX_CONTROL_RUN 0x1
+#define BOX_CONTROL_RESET 0x2
+#define BOX_CONTROL_COMPLETION_INTERRUPT_ENABLE 0x10
+
+#define DESCRIPTOR_INTERRUPT_ON_COMPLETION 0x8000
+
+bool AC97::detect()
+{
+    static const PCI::ID ich_ac97_id = { 0x8086, 0x2415 };
+    bool found = false;
+    PCI::enumerate([&](const PCI::Address& address, PCI::ID id) {
+        if (address.is_null() || found)
+            return;
+        if (id != ich_ac97_id)
+            return;
+        u8 irq = PCI::get_interrupt_line(address);
+        auto device = adopt(*new AC97(address, irq));
+        // A controller we couldn't bring up goes away again, leaving /dev/audio to the next driver.
+        if (!device->m_descriptor_list)
+            return;
+        (void)device.leak_ref();
+        found = true;
+    });
+    return found;
+}
+
+AC97::AC97(PCI::Address address, u8 irq)
+    : PCI::Device(address, irq)
+    , CharacterDevice(42, 42)
+    , m_mixer_io_base(PCI::get_BAR0(pci_address()) & ~1)
+    , m_bus_master_io_base(PCI::get_BAR1(pci_address()) & ~1)
+{
+    klog() << "AC97: Found @ " << pci_address();
+    klog() << "AC97: Mixer base: " << m_mixer_io_base << ", bus master base: " << m_bus_master_io_base;
+
+    enable_bus_mastering(pci_address());
+
+    if (!reset()) {
+        klog() << "AC97: Codec did not come out of reset";
+        return;
+    }
+
+    // Full volume, unmuted. Attenuation is AudioServer's business.
+    m_mixer_io_base.offset(NAM_MASTER_VOLUME).out<u16>(0);
+    m_mixer_io_base.offset(NAM_PCM_OUT_VOLUME).out<u16>(0x0808);
+
+    // AudioServer mixes at 44.1 kHz, which needs a codec with variable rate audio; the rest only do 48 kHz.
+    if (m_mixer_io_base.offset(NAM_EXTENDED_AUDIO_ID).in<u16>() & EXTENDED_AUDIO_VARIABLE_RATE) {
+        auto control = m_mixer_io_base.offset(NAM_EXTENDED_AUDIO_CONTROL).in<u16>();
+        m_mixer_io_base.offset(NAM_EXTENDED_AUDIO_CONTROL).out<u16>(control | EXTENDED_AUDIO_VARIABLE_RATE);
+        set_output_sample_rate(44100);
+    } else {
+        klog() << "AC97: Codec has a fixed 48 kHz rate, 44.1 kHz audio will play slightly fast";
+    }
+    klog() << "AC97: Output sample rate: " << m_output_sample_rate;
+
+    m_buffers = MM.allocate_contiguous_kernel_region(buffer_descriptor_count * buffer_size, "AC97 Buffers", Region::Access::Read | Region::Access::Write);
+    m_descriptor_list = MM.allocate_contiguous_kernel_region(PAGE_ROUND_UP(buffer_descriptor_count * sizeof(BufferDescriptor)), "AC97 Descriptor list", Region::Access::Read | Region::Access::Write);
+    if (!m_buffers || !m_descriptor_list) {
+        klog() << "AC97: Could not allocate DMA buffers";
+        m_descriptor_list = nullptr;
+        return;
+    }
+
+    // Each descriptor always points at its own buffer, only the length changes from one lap around the ring to the next.
+    auto* descriptors = (BufferDescriptor*)m_descriptor_list->vaddr().as_ptr();
+    for (size_t i = 0; i < buffer_descriptor_count; ++i) {
+        descriptors[i].address = m_buffers->physical_page(i * buffer_size / PAGE_SIZE)->paddr().get();
+        descriptors[i].sample_count = 0;
+        descriptors[i].flags = DESCRIPTOR_INTERRUPT_ON_COMPLETION;
+    }
+
+    auto pcm_out = m_bus_master_io_base.offset(NABM_PCM_OUT);
+    pcm_out.offset(BOX_DESCRIPTOR_LIST).out<u32>(m_descriptor_list->physical_page(0)->paddr().get());
+
+    enable_irq();
+}
+
+AC97::~AC97()
+{
+}
+
+bool AC97::reset()
+{
+    auto global_control = m_bus_master_io_base.offset(NABM_GLOBAL_CONTROL);
+    global_control.out<u32>(0);
+    IO::delay(100);
+    global_control.out<u32>(GLOBAL_CONTROL_COLD_RESET);
+
+    bool codec_ready = false;
+    for (int i = 0; i < 1000 && !codec_ready; ++i) {
+        codec_ready = m_bus_master_io_base.offset(NABM_GLOBAL_STATUS).in<u32>() & GLOBAL_STATUS_PRIMARY_CODEC_READY;
+        if (!codec_ready)
+            IO::delay(1000);
+    }
+    if (!codec_ready)
+        return false;
+
+    // Any write resets the mixer registers to their defaults.
+    m_mixer_io_base.offset(NAM_RESET).out<u16>(1);
+
+    auto control = m_bus_master_io_base.offset(NABM_PCM_OUT + BOX_CONTROL);
+    control.out<u8>(BOX_CONTROL_RESET);
+    for (int i = 0; i < 1000 && (control.in<u8>() & BOX_CONTROL_RESET); ++i)
+        IO::delay(10);
+    return true;
+}
+
+void AC97::set_output_sample_rate(u16 hz)
+{
+    auto rate = m_mixer_io_base.offset(NAM_PCM_FRONT_DAC_RATE);
+    rate.out<u16>(hz);
+    // The codec rounds to the nearest rate it supports, so read back what it settled on.
+    m_output_sample_rate = rate.in<u16>();
+}
+
+void AC97::handle_irq(const RegisterState&)
+{
+    // The line may be shared, so only acknowledge what our PCM out channel raised.
+    if (!(m_bus_master_io_base.offset(NABM_GLOBAL_STATUS).in<u32>() & GLOBAL_STATUS_PCM_OUT_INTERRUPT))
+        return;
+
+    auto status = m_bus_master_io_base.offset(NABM_PCM_OUT + BOX_STATUS);
+    status.out<u16>(BOX_STATUS_LAST_VALID_INTERRUPT | BOX_STATUS_COMPLETION_INTERRUPT | BOX_STATUS_FIFO_ERROR);
+
+    m_irq_queue.wake_all();
+}
+
+size_t AC97::buffers_in_flight()
+{
+    auto pcm_out = m_bus_master_io_base.offset(NABM_PCM_OUT);
+    if (!m_output_running || (pcm_out.offset(BOX_STATUS).in<u16>() & BOX_STATUS_HALTED))
+        return 0;
+    u8 current = pcm_out.offset(BOX_CURRENT_INDEX).in<u8>();
+    u8 last_valid = pcm_out.offset(BOX_LAST_VALID_INDEX).in<u8>();
+    return ((last_valid + buffer_descriptor_count - current) % buffer_descriptor_count) + 1;
+}
+
+void AC97::queue_buffer(const u8* data, size_t length)
+{
+    ASSERT(length <= buffer_size);
+    ASSERT(length % (2 * sizeof(i16)) == 0);
+
+    for (;;) {
+        InterruptDisabler disabler;
+        if (buffers_in_flight() < max_buffers_in_flight)
+            break;
+        Thread::current()->wait_on(m_irq_queue);
+    }
+
+    InterruptDisabler disabler;
+    auto index = m_next_descriptor;
+    memcpy(m_buffers->vaddr().offset(index * buffer_size).as_ptr(), data, length);
+    auto* descriptors = (BufferDescriptor*)m_descriptor_list->vaddr().as_ptr();
+    descriptors[index].sample_count = length / sizeof(i16);
+
+#ifdef AC97_DEBUG
+    klog() << "AC97: Queueing " << length << " bytes in descriptor " << index << ", " << buffers_in_flight() << " in flight";
+#endif
+
+    // A halted controller picks up from the descriptor after the old last valid one as soon as we move it on.
+    auto pcm_out = m_bus_master_io_base.offset(NABM_PCM_OUT);
+    pcm_out.offset(BOX_LAST_VALID_INDEX).out<u8>(index);
+    if (!m_output_running) {
+        pcm_out.offset(BOX_CONTROL).out<u8>(BOX_CONTROL_RUN | BOX_CONTROL_COMPLETION_INTERRUPT_ENABLE);
+        m_output_running = true;
+    }
+    m_next_descriptor = (index + 1) % buffer_descriptor_count;
+}
+
+ssize_t AC97::write(FileDescription&, size_t, const u8* data, ssize_t length)
+{
+    // Only whole stereo frames make it to the device.
+    size_t remaining = length & ~(2 * sizeof(i16) - 1);
+    size_t written = 0;
+    while (remaining) {
+        size_t chunk = min(remaining, buffer_size);
+        queue_buffer(data + written, chunk);
+        written += chunk;
+        remaining -= chunk;
+    }
+    return written;
+}
+
+}
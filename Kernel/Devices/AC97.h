@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2018-2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#pragma once
+
+#include <AK/OwnPtr.h>
+#include <Kernel/Devices/CharacterDevice.h>
+#include <Kernel/IO.h>
+#include <Kernel/PCI/Access.h>
+#include <Kernel/PCI/Device.h>
+#include <Kernel/WaitQueue.h>
+
+namespace Kernel {
+
+// Plays 16-bit stereo PCM written to /dev/audio through the ICH AC'97 controller's PCM out channel.
+// Every write() fills one entry of a ring of DMA buffer descriptors, which the controller walks on its own;
+// writers only block while the device already has max_buffers_in_flight buffers to play.
+class AC97 final : public PCI::Device
+    , public CharacterDevice {
+public:
+    static bool detect();
+
+    AC97(PCI::Address, u8 irq);
+    virtual ~AC97() override;
+
+    // ^CharacterDevice
+    virtual bool can_read(const FileDescription&, size_t) const override { return false; }
+    virtual ssize_t read(FileDescription&, size_t, u8*, ssize_t) override { return 0; }
+    virtual ssize_t write(FileDescription&, size_t, const u8*, ssize_t) override;
+    virtual bool can_write(const FileDescription&, size_t) const override { return true; }
+
+    virtual const char* purpose() const override { return class_name(); }
+
+private:
+    static constexpr size_t buffer_descriptor_count = 32;
+    static constexpr size_t buffer_size = PAGE_SIZE;
+    static constexpr size_t max_buffers_in_flight = 3;
+
+    struct [[gnu::packed]] BufferDescriptor
+    {
+        u32 address;
+        u16 sample_count;
+        u16 flags;
+    };
+
+    // ^IRQHandler
+    virtual void handle_irq(const RegisterState&) override;
+
+    // ^CharacterDevice
+    virtual const char* class_name() const override { return "AC97"; }
+
+    bool reset();
+    void set_output_sample_rate(u16 hz);
+    size_t buffers_in_flight();
+    void queue_buffer(const u8* data, size_t length);
+
+    IOAddress m_mixer_io_base;
+    IOAddress m_bus_master_io_base;
+    OwnPtr<Region> m_descriptor_list;
+    OwnPtr<Region> m_buffers;
+    u8 m_next_descriptor { 0 };
+    bool m_output_running { false };
+    u16 m_output_sample_rate { 48000 };
+
+    WaitQueue m_irq_queue;
+};
+}
@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2018-2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/StringView.h>
+#include <Kernel/Devices/AHCIController.h>
+#include <Kernel/Devices/AHCIDiskDevice.h>
+#include <Kernel/VM/MemoryManager.h>
+
+#define PCI_Mass_Storage_Class 0x1
+#define PCI_SATA_Controller_Subclass 0x6
+
+#define AHCI_CAP 0x00
+#define AHCI_GHC 0x04
+#define AHCI_IS 0x08
+#define AHCI_PI 0x0c
+#define AHCI_VS 0x10
+
+#define AHCI_GHC_IE (1 << 1)
+#define AHCI_GHC_AE (1u << 31)
+
+// Block devices with major 8 are SATA disks, indexed by minor in the order we find them.
+#define AHCI_DISK_MAJOR 8
+
+namespace Kernel {
+
+OwnPtr<AHCIController> AHCIController::detect()
+{
+    PCI::Address controller_address;
+    PCI::enumerate([&](const PCI::Address& address, PCI::ID id) {
+        if (!controller_address.is_null())
+            return;
+        if (PCI::get_class(address) == PCI_Mass_Storage_Class && PCI::get_subclass(address) == PCI_SATA_Controller_Subclass) {
+            controller_address = address;
+            klog() << "AHCIController: SATA controller found, ID " << id;
+        }
+    });
+    if (controller_address.is_null())
+        return nullptr;
+    return make<AHCIController>(controller_address);
+}
+
+AHCIController::AHCIController(PCI::Address address)
+    : PCI::Device(address)
+{
+    disable_irq();
+
+    PCI::enable_bus_mastering(pci_address());
+    PCI::enable_interrupt_line(pci_address());
+
+    u32 bar5 = PCI::get_BAR5(pci_address()) & 0xfffffff0;
+    size_t mmio_size = PCI::get_BAR_space_size(pci_address(), 5);
+    m_mmio_region = MM.allocate_kernel_region(PhysicalAddress(page_base_of(bar5)), PAGE_ROUND_UP(mmio_size), "AHCI MMIO", Region::Access::Read | Region::Access::Write, false, false);
+    if (!m_mmio_region) {
+        klog() << "AHCIController: Failed to map registers at " << PhysicalAddress(bar5);
+        return;
+    }
+
+    write_register(AHCI_GHC, read_register(AHCI_GHC) | AHCI_GHC_AE);
+    m_capabilities = read_register(AHCI_CAP);
+    u32 implemented_ports = read_register(AHCI_PI);
+    u32 version = read_register(AHCI_VS);
+    klog() << "AHCIController: Version " << (version >> 16) << "." << ((version >> 8) & 0xff) << ", " << command_slot_count() << " command slots, NCQ " << (supports_ncq() ? "supported" : "not supported") << ", ports " << String::format("%x", implemented_ports);
+
+    for (size_t port = 0; port < 32; ++port) {
+        if (!(implemented_ports & (1u << port)))
+            continue;
+        auto disk = AHCIDiskDevice::create(*this, port, AHCI_DISK_MAJOR, m_disks.size());
+        if (disk)
+            m_disks.append(disk.release_nonnull());
+    }
+
+    write_register(AHCI_IS, 0xffffffff);
+    write_register(AHCI_GHC, read_register(AHCI_GHC) | AHCI_GHC_IE);
+    enable_irq();
+}
+
+AHCIController::~AHCIController()
+{
+}
+
+void AHCIController::handle_irq(const RegisterState&)
+{
+    u32 pending_ports = read_register(AHCI_IS);
+    for (auto& disk : m_disks) {
+        if (pending_ports & (1u << disk.port_index()))
+            disk.handle_interrupt({});
+    }
+    // The ports' own status has to be cleared first, or they'd raise the interrupt again right away.
+    write_register(AHCI_IS, pending_ports);
+}
+
+}
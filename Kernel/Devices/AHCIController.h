@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2018-2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+//
+// Advanced Host Controller Interface (AHCI) SATA controller driver
+//
+// The controller has up to 32 ports, each of which can have a SATA disk attached.
+// Every port has its own list of 32 command slots, and disks that support native
+// command queueing (NCQ) can work on all of them at once.
+//
+// More information about AHCI can be found here:
+//      https://www.intel.com/content/www/us/en/io/serial-ata/serial-ata-ahci-spec-rev1-3-1.html
+//
+
+#pragma once
+
+#include <AK/NonnullRefPtrVector.h>
+#include <AK/OwnPtr.h>
+#include <Kernel/PCI/Access.h>
+#include <Kernel/PCI/Device.h>
+#include <Kernel/VM/Region.h>
+
+namespace Kernel {
+
+class AHCIDiskDevice;
+
+class AHCIController final : public PCI::Device {
+    friend class AHCIDiskDevice;
+    AK_MAKE_ETERNAL
+public:
+    static OwnPtr<AHCIController> detect();
+    explicit AHCIController(PCI::Address);
+    virtual ~AHCIController() override;
+
+    virtual const char* purpose() const override { return "AHCI Controller"; }
+
+    const NonnullRefPtrVector<AHCIDiskDevice>& disks() const { return m_disks; }
+
+private:
+    //^ IRQHandler
+    virtual void handle_irq(const RegisterState&) override;
+
+    u32 read_register(u32 offset) const { return *(volatile u32*)m_mmio_region->vaddr().offset(offset).as_ptr(); }
+    void write_register(u32 offset, u32 value) { *(volatile u32*)m_mmio_region->vaddr().offset(offset).as_ptr() = value; }
+
+    size_t command_slot_count() const { return ((m_capabilities >> 8) & 0x1f) + 1; }
+    bool supports_ncq() const { return m_capabilities & (1u << 30); }
+    bool supports_staggered_spin_up() const { return m_capabilities & (1u << 27); }
+
+    OwnPtr<Region> m_mmio_region;
+    u32 m_capabilities { 0 };
+    NonnullRefPtrVector<AHCIDiskDevice> m_disks;
+};
+
+}
@@ -0,0 +1,514 @@
+/*
+ * Copyright (c) 2018-2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/Memory.h>
+#include <AK/StringBuilder.h>
+#include <Kernel/Arch/i386/CPU.h>
+#include <Kernel/Devices/AHCIController.h>
+#include <Kernel/Devices/AHCIDiskDevice.h>
+#include <Kernel/FileSystem/FileDescription.h>
+#include <Kernel/IO.h>
+#include <Kernel/Thread.h>
+#include <Kernel/VM/MemoryManager.h>
+
+//#define AHCI_DEBUG
+
+#define AHCI_PORT_REGISTERS(port) (0x100 + (port)*0x80)
+
+#define AHCI_PxCLB 0x00
+#define AHCI_PxCLBU 0x04
+#define AHCI_PxFB 0x08
+#define AHCI_PxFBU 0x0c
+#define AHCI_PxIS 0x10
+#define AHCI_PxIE 0x14
+#define AHCI_PxCMD 0x18
+#define AHCI_PxTFD 0x20
+#define AHCI_PxSIG 0x24
+#define AHCI_PxSSTS 0x28
+#define AHCI_PxSERR 0x30
+#define AHCI_PxSACT 0x34
+#define AHCI_PxCI 0x38
+
+#define AHCI_PxCMD_ST (1 << 0)
+#define AHCI_PxCMD_SUD (1 << 1)
+#define AHCI_PxCMD_POD (1 << 2)
+#define AHCI_PxCMD_FRE (1 << 4)
+#define AHCI_PxCMD_FR (1 << 14)
+#define AHCI_PxCMD_CR (1 << 15)
+
+#define AHCI_PxIS_DHRS (1 << 0)
+#define AHCI_PxIS_PSS (1 << 1)
+#define AHCI_PxIS_DSS (1 << 2)
+#define AHCI_PxIS_SDBS (1 << 3)
+#define AHCI_PxIS_DPS (1 << 5)
+#define AHCI_PxIS_IFS (1 << 27)
+#define AHCI_PxIS_HBDS (1 << 28)
+#define AHCI_PxIS_HBFS (1 << 29)
+#define AHCI_PxIS_TFES (1 << 30)
+#define AHCI_PxIS_ERRORS (AHCI_PxIS_IFS | AHCI_PxIS_HBDS | AHCI_PxIS_HBFS | AHCI_PxIS_TFES)
+
+#define AHCI_PxSSTS_DET_PRESENT 0x3
+#define AHCI_SIGNATURE_ATA 0x00000101
+
+#define AHCI_FIS_TYPE_REGISTER_H2D 0x27
+#define AHCI_FIS_COMMAND (1 << 7)
+
+#define ATA_SR_BSY 0x80
+#define ATA_SR_DRQ 0x08
+#define ATA_SR_ERR 0x01
+
+#define ATA_CMD_READ_DMA_EXT 0x25
+#define ATA_CMD_WRITE_DMA_EXT 0x35
+#define ATA_CMD_READ_FPDMA_QUEUED 0x60
+#define ATA_CMD_WRITE_FPDMA_QUEUED 0x61
+#define ATA_CMD_IDENTIFY 0xEC
+
+namespace Kernel {
+
+struct DMARange {
+    PhysicalAddress paddr;
+    size_t size { 0 };
+};
+
+RefPtr<AHCIDiskDevice> AHCIDiskDevice::create(AHCIController& controller, size_t port_index, int major, int minor)
+{
+    // Look before we leap, so empty ports don't take up a device number.
+    u32 port_registers = AHCI_PORT_REGISTERS(port_index);
+    if ((controller.read_register(port_registers + AHCI_PxSSTS) & 0xf) != AHCI_PxSSTS_DET_PRESENT)
+        return nullptr;
+    u32 signature = controller.read_register(port_registers + AHCI_PxSIG);
+    if (signature != AHCI_SIGNATURE_ATA) {
+        klog() << "AHCIDiskDevice: Ignoring device with signature " << String::format("%x", signature) << " on port " << port_index;
+        return nullptr;
+    }
+
+    auto disk = adopt(*new AHCIDiskDevice(controller, port_index, major, minor));
+    if (!disk->initialize())
+        return nullptr;
+    return disk;
+}
+
+AHCIDiskDevice::AHCIDiskDevice(AHCIController& controller, size_t port_index, int major, int minor)
+    : BlockDevice(major, minor, 512)
+    , m_controller(controller)
+    , m_port_index(port_index)
+{
+}
+
+AHCIDiskDevice::~AHCIDiskDevice()
+{
+}
+
+const char* AHCIDiskDevice::class_name() const
+{
+    return "AHCIDiskDevice";
+}
+
+u32 AHCIDiskDevice::read_port_register(u32 offset) const
+{
+    return m_controller.read_register(AHCI_PORT_REGISTERS(m_port_index) + offset);
+}
+
+void AHCIDiskDevice::write_port_register(u32 offset, u32 value)
+{
+    m_controller.write_register(AHCI_PORT_REGISTERS(m_port_index) + offset, value);
+}
+
+bool AHCIDiskDevice::initialize()
+{
+    stop_command_engine();
+
+    m_command_list_page = MM.allocate_supervisor_physical_page();
+    if (!m_command_list_page)
+        return false;
+    for (size_t i = 0; i < 32 / (PAGE_SIZE / AHCI::command_table_size); ++i) {
+        auto page = MM.allocate_supervisor_physical_page();
+        if (!page)
+            return false;
+        m_command_table_pages.append(page.release_nonnull());
+    }
+    for (size_t i = 0; i < max_transfer_size / PAGE_SIZE; ++i) {
+        auto page = MM.allocate_supervisor_physical_page();
+        if (!page)
+            return false;
+        m_bounce_buffer_pages.append(page.release_nonnull());
+    }
+
+    for (size_t slot = 0; slot < 32; ++slot) {
+        auto& header = command_list()[slot];
+        header.command_table_base = command_table_paddr(slot).get();
+        header.command_table_base_upper = 0;
+    }
+
+    // The received FIS area (256 bytes) goes right after the command list (1 KiB).
+    write_port_register(AHCI_PxCLB, m_command_list_page->paddr().get());
+    write_port_register(AHCI_PxCLBU, 0);
+    write_port_register(AHCI_PxFB, m_command_list_page->paddr().offset(1024).get());
+    write_port_register(AHCI_PxFBU, 0);
+
+    write_port_register(AHCI_PxSERR, 0xffffffff);
+    write_port_register(AHCI_PxIS, 0xffffffff);
+    start_command_engine();
+
+    // We identify the disk with the port's interrupts off, and poll for it instead.
+    if (!identify())
+        return false;
+
+    write_port_register(AHCI_PxIS, 0xffffffff);
+    write_port_register(AHCI_PxIE, AHCI_PxIS_DHRS | AHCI_PxIS_PSS | AHCI_PxIS_DSS | AHCI_PxIS_SDBS | AHCI_PxIS_DPS | AHCI_PxIS_ERRORS);
+    return true;
+}
+
+void AHCIDiskDevice::stop_command_engine()
+{
+    // The controller has up to 500ms to stop each of its engines.
+    write_port_register(AHCI_PxCMD, read_port_register(AHCI_PxCMD) & ~AHCI_PxCMD_ST);
+    for (size_t i = 0; i < 500 && (read_port_register(AHCI_PxCMD) & AHCI_PxCMD_CR); ++i)
+        IO::delay(1000);
+    write_port_register(AHCI_PxCMD, read_port_register(AHCI_PxCMD) & ~AHCI_PxCMD_FRE);
+    for (size_t i = 0; i < 500 && (read_port_register(AHCI_PxCMD) & AHCI_PxCMD_FR); ++i)
+        IO::delay(1000);
+}
+
+void AHCIDiskDevice::start_command_engine()
+{
+    u32 command = read_port_register(AHCI_PxCMD) | AHCI_PxCMD_FRE;
+    if (m_controller.supports_staggered_spin_up())
+        command |= AHCI_PxCMD_SUD | AHCI_PxCMD_POD;
+    write_port_register(AHCI_PxCMD, command);
+
+    // Don't start processing commands until the device is ready for them.
+    for (size_t i = 0; i < 1000 && (read_port_register(AHCI_PxTFD) & (ATA_SR_BSY | ATA_SR_DRQ)); ++i)
+        IO::delay(1000);
+    write_port_register(AHCI_PxCMD, command | AHCI_PxCMD_ST);
+}
+
+bool AHCIDiskDevice::identify()
+{
+    auto& table = command_table(0);
+    table.prdt[0].base = m_bounce_buffer_pages[0].paddr().get();
+    table.prdt[0].base_upper = 0;
+    table.prdt[0].byte_count_and_flags = 512 - 1;
+    set_up_command(0, ATA_CMD_IDENTIFY, 0, 0, false, 1);
+
+    memory_barrier();
+    write_port_register(AHCI_PxCI, 1);
+    for (size_t i = 0; i < 1000 && (read_port_register(AHCI_PxCI) & 1); ++i) {
+        if (read_port_register(AHCI_PxIS) & AHCI_PxIS_TFES)
+            break;
+        IO::delay(1000);
+    }
+    if ((read_port_register(AHCI_PxCI) & 1) || (read_port_register(AHCI_PxTFD) & ATA_SR_ERR)) {
+        klog() << "AHCIDiskDevice: Port " << m_port_index << ": IDENTIFY DEVICE failed, task file " << String::format("%x", read_port_register(AHCI_PxTFD));
+        stop_command_engine();
+        return false;
+    }
+
+    auto* words = (const u16*)bounce_buffer_page_data(0);
+    if (words[83] & (1 << 10))
+        m_block_count = (u64)words[100] | ((u64)words[101] << 16) | ((u64)words[102] << 32) | ((u64)words[103] << 48);
+    else
+        m_block_count = (u32)words[60] | ((u32)words[61] << 16);
+
+    // Command slots are only worth having more of if the disk can work on them at the same time.
+    if (m_controller.supports_ncq() && (words[76] & (1 << 8))) {
+        m_uses_ncq = true;
+        m_slot_count = min(m_controller.command_slot_count(), (size_t)(words[75] & 0x1f) + 1);
+    }
+
+    StringBuilder model;
+    for (size_t i = 27; i <= 46; ++i) {
+        model.append((char)(words[i] >> 8));
+        model.append((char)(words[i] & 0xff));
+    }
+    klog() << "AHCIDiskDevice: Port " << m_port_index << ": Name=" << model.to_string().trim_whitespace() << ", " << m_block_count << " sectors, " << (m_uses_ncq ? "NCQ" : "no NCQ") << ", " << m_slot_count << " command slot(s)";
+    return true;
+}
+
+size_t AHCIDiskDevice::acquire_command_slot()
+{
+    for (;;) {
+        InterruptDisabler disabler;
+        for (size_t slot = 0; slot < m_slot_count; ++slot) {
+            if (!(m_busy_slots & (1u << slot))) {
+                m_busy_slots |= 1u << slot;
+                return slot;
+            }
+        }
+        Thread::current()->wait_on(m_free_slot_wait_queue);
+    }
+}
+
+void AHCIDiskDevice::release_command_slot(size_t slot)
+{
+    InterruptDisabler disabler;
+    m_busy_slots &= ~(1u << slot);
+    m_free_slot_wait_queue.wake_one();
+}
+
+static bool collect_dma_ranges(u8* buffer, size_t byte_count, bool device_writes_to_memory, NonnullRefPtrVector<PhysicalPage>& pinned_pages, Vector<DMARange, 8>& ranges)
+{
+    // The controller wants word-aligned descriptors with an even byte count.
+    if ((FlatPtr)buffer & 1)
+        return false;
+
+    // Hold on to the pages until the transfer is done, so they stay put even if the buffer gets
+    // unmapped while we wait. Physically adjacent pages share a descriptor.
+    for (size_t offset = 0; offset < byte_count;) {
+        VirtualAddress vaddr((FlatPtr)buffer + offset);
+        size_t offset_in_page = vaddr.get() & ~PAGE_MASK;
+        size_t chunk_size = min(byte_count - offset, PAGE_SIZE - offset_in_page);
+        auto page = MM.physical_page_for_dma(vaddr, device_writes_to_memory);
+        if (!page)
+            return false;
+        auto paddr = page->paddr().offset(offset_in_page);
+        pinned_pages.append(page.release_nonnull());
+        offset += chunk_size;
+
+        if (!ranges.is_empty() && ranges.last().paddr.offset(ranges.last().size) == paddr) {
+            ranges.last().size += chunk_size;
+            continue;
+        }
+        if (ranges.size() == AHCI::max_prdt_entry_count)
+            return false;
+        ranges.append({ paddr, chunk_size });
+    }
+    return true;
+}
+
+void AHCIDiskDevice::set_up_command(size_t slot, u8 command, u32 lba, u16 count, bool is_write, size_t prdt_length)
+{
+    auto& table = command_table(slot);
+    memset(table.command_fis, 0, sizeof(table.command_fis));
+    u8* fis = table.command_fis;
+    fis[0] = AHCI_FIS_TYPE_REGISTER_H2D;
+    fis[1] = AHCI_FIS_COMMAND;
+    fis[2] = command;
+    fis[4] = lba & 0xff;
+    fis[5] = (lba >> 8) & 0xff;
+    fis[6] = (lba >> 16) & 0xff;
+    fis[7] = 1 << 6; // LBA mode
+    fis[8] = (lba >> 24) & 0xff;
+    if (command == ATA_CMD_READ_FPDMA_QUEUED || command == ATA_CMD_WRITE_FPDMA_QUEUED) {
+        // Queued commands take the sector count in the features register, and their tag in the count register.
+        fis[3] = LSB(count);
+        fis[11] = MSB(count);
+        fis[12] = slot << 3;
+    } else {
+        fis[12] = LSB(count);
+        fis[13] = MSB(count);
+    }
+
+    auto& header = command_list()[slot];
+    header.flags = (5 /* FIS length in dwords */) | (is_write ? (1 << 6) : 0);
+    header.prdt_length = prdt_length;
+    header.prd_byte_count = 0;
+}
+
+bool AHCIDiskDevice::run_command(size_t slot)
+{
+    u32 bit = 1u << slot;
+    {
+        InterruptDisabler disabler;
+        m_failed_slots &= ~bit;
+        m_issued_slots |= bit;
+        memory_barrier();
+        if (m_uses_ncq)
+            write_port_register(AHCI_PxSACT, bit);
+        write_port_register(AHCI_PxCI, bit);
+    }
+    for (;;) {
+        InterruptDisabler disabler;
+        if (!(m_issued_slots & bit))
+            return !(m_failed_slots & bit);
+        Thread::current()->wait_on(m_completion_wait_queues[slot]);
+    }
+}
+
+void AHCIDiskDevice::handle_interrupt(Badge<AHCIController>)
+{
+    u32 status = read_port_register(AHCI_PxIS);
+    write_port_register(AHCI_PxIS, status);
+
+    u32 finished_slots;
+    if (status & AHCI_PxIS_ERRORS) {
+        klog() << "AHCIDiskDevice: Port " << m_port_index << ": Error, interrupt status " << String::format("%x", status) << ", task file " << String::format("%x", read_port_register(AHCI_PxTFD));
+        // The disk abandons everything it had queued up when a command fails, so fail all of it and restart the port.
+        // FIXME: Reset the device if it's still busy after this.
+        finished_slots = m_issued_slots;
+        m_failed_slots |= m_issued_slots;
+        stop_command_engine();
+        write_port_register(AHCI_PxSERR, 0xffffffff);
+        write_port_register(AHCI_PxIS, 0xffffffff);
+        start_command_engine();
+    } else {
+        u32 running_slots = read_port_register(AHCI_PxCI);
+        if (m_uses_ncq)
+            running_slots |= read_port_register(AHCI_PxSACT);
+        finished_slots = m_issued_slots & ~running_slots;
+    }
+
+    for (size_t slot = 0; slot < 32; ++slot) {
+        if (!(finished_slots & (1u << slot)))
+            continue;
+        m_issued_slots &= ~(1u << slot);
+        m_completion_wait_queues[slot].wake_all();
+    }
+}
+
+bool AHCIDiskDevice::transfer(RequestType type, u32 lba, u16 count, u8* buffer)
+{
+    size_t byte_count = count * block_size();
+    ASSERT(byte_count && byte_count <= max_transfer_size);
+    bool is_write = type == RequestType::Write;
+#ifdef AHCI_DEBUG
+    dbg() << "AHCIDiskDevice::transfer " << (is_write ? "write" : "read") << " (" << lba << " x" << count << ") " << (const void*)buffer;
+#endif
+
+    NonnullRefPtrVector<PhysicalPage> pinned_pages;
+    Vector<DMARange, 8> ranges;
+    bool is_direct = collect_dma_ranges(buffer, byte_count, !is_write, pinned_pages, ranges);
+    if (!is_direct) {
+        m_bounce_buffer_lock.lock();
+        ranges.clear();
+        for (size_t i = 0; i * PAGE_SIZE < byte_count; ++i) {
+            size_t chunk_size = min(byte_count - i * PAGE_SIZE, (size_t)PAGE_SIZE);
+            if (is_write)
+                memcpy(bounce_buffer_page_data(i), buffer + i * PAGE_SIZE, chunk_size);
+            ranges.append({ m_bounce_buffer_pages[i].paddr(), chunk_size });
+        }
+    }
+
+    size_t slot = acquire_command_slot();
+    auto& table = command_table(slot);
+    for (size_t i = 0; i < ranges.size(); ++i) {
+        table.prdt[i].base = ranges[i].paddr.get();
+        table.prdt[i].base_upper = 0;
+        table.prdt[i].reserved = 0;
+        table.prdt[i].byte_count_and_flags = ranges[i].size - 1;
+    }
+    u8 command;
+    if (m_uses_ncq)
+        command = is_write ? ATA_CMD_WRITE_FPDMA_QUEUED : ATA_CMD_READ_FPDMA_QUEUED;
+    else
+        command = is_write ? ATA_CMD_WRITE_DMA_EXT : ATA_CMD_READ_DMA_EXT;
+    set_up_command(slot, command, lba, count, is_write, ranges.size());
+    bool success = run_command(slot);
+    release_command_slot(slot);
+
+    if (!is_direct) {
+        if (success && !is_write) {
+            for (size_t i = 0; i * PAGE_SIZE < byte_count; ++i)
+                memcpy(buffer + i * PAGE_SIZE, bounce_buffer_page_data(i), min(byte_count - i * PAGE_SIZE, (size_t)PAGE_SIZE));
+        }
+        m_bounce_buffer_lock.unlock();
+    }
+    return success;
+}
+
+bool AHCIDiskDevice::read_blocks(unsigned index, u16 count, u8* out)
+{
+    return transfer(RequestType::Read, index, count, out);
+}
+
+bool AHCIDiskDevice::write_blocks(unsigned index, u16 count, const u8* data)
+{
+    return transfer(RequestType::Write, index, count, const_cast<u8*>(data));
+}
+
+ssize_t AHCIDiskDevice::read(FileDescription&, size_t offset, u8* outbuf, ssize_t len)
+{
+    unsigned index = offset / block_size();
+    u16 whole_blocks = len / block_size();
+    ssize_t remaining = len % block_size();
+
+    // Callers have to come back for whatever doesn't fit in one transfer.
+    unsigned max_blocks_per_transfer = max_transfer_size / block_size();
+    if (whole_blocks >= max_blocks_per_transfer) {
+        whole_blocks = max_blocks_per_transfer;
+        remaining = 0;
+    }
+
+    if (whole_blocks > 0) {
+        if (!read_blocks(index, whole_blocks, outbuf))
+            return -1;
+    }
+
+    off_t pos = whole_blocks * block_size();
+
+    if (remaining > 0) {
+        auto buf = ByteBuffer::create_uninitialized(block_size());
+        if (!read_blocks(index + whole_blocks, 1, buf.data()))
+            return pos;
+        memcpy(&outbuf[pos], buf.data(), remaining);
+    }
+
+    return pos + remaining;
+}
+
+bool AHCIDiskDevice::can_read(const FileDescription&, size_t offset) const
+{
+    return offset < m_block_count * block_size();
+}
+
+ssize_t AHCIDiskDevice::write(FileDescription&, size_t offset, const u8* inbuf, ssize_t len)
+{
+    unsigned index = offset / block_size();
+    u16 whole_blocks = len / block_size();
+    ssize_t remaining = len % block_size();
+
+    unsigned max_blocks_per_transfer = max_transfer_size / block_size();
+    if (whole_blocks >= max_blocks_per_transfer) {
+        whole_blocks = max_blocks_per_transfer;
+        remaining = 0;
+    }
+
+    if (whole_blocks > 0) {
+        if (!write_blocks(index, whole_blocks, inbuf))
+            return -1;
+    }
+
+    off_t pos = whole_blocks * block_size();
+
+    // Partial blocks have to be read, modified and written back whole.
+    if (remaining > 0) {
+        auto buf = ByteBuffer::create_zeroed(block_size());
+        if (!read_blocks(index + whole_blocks, 1, buf.data()))
+            return pos;
+        memcpy(buf.data(), &inbuf[pos], remaining);
+        if (!write_blocks(index + whole_blocks, 1, buf.data()))
+            return pos;
+    }
+
+    return pos + remaining;
+}
+
+bool AHCIDiskDevice::can_write(const FileDescription&, size_t offset) const
+{
+    return offset < m_block_count * block_size();
+}
+
+}
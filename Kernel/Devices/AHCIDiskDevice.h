@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) 2018-2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+//
+// A SATA disk attached to one of the ports of an AHCI controller
+//
+
+#pragma once
+
+#include <AK/Badge.h>
+#include <AK/NonnullRefPtrVector.h>
+#include <AK/RefPtr.h>
+#include <Kernel/Devices/BlockDevice.h>
+#include <Kernel/Lock.h>
+#include <Kernel/VM/PhysicalPage.h>
+#include <Kernel/WaitQueue.h>
+
+namespace Kernel {
+
+class AHCIController;
+
+namespace AHCI {
+
+struct CommandHeader {
+    u16 flags;
+    u16 prdt_length;
+    volatile u32 prd_byte_count;
+    u32 command_table_base;
+    u32 command_table_base_upper;
+    u32 reserved[4];
+} __attribute__((packed));
+
+struct PhysicalRegionDescriptor {
+    u32 base;
+    u32 base_upper;
+    u32 reserved;
+    u32 byte_count_and_flags;
+} __attribute__((packed));
+
+// Each command table gets its own kilobyte, which leaves room for well over the descriptors a maximum size transfer needs.
+static constexpr size_t command_table_size = 1024;
+static constexpr size_t max_prdt_entry_count = (command_table_size - 128) / sizeof(PhysicalRegionDescriptor);
+
+struct CommandTable {
+    u8 command_fis[64];
+    u8 atapi_command[16];
+    u8 reserved[48];
+    PhysicalRegionDescriptor prdt[max_prdt_entry_count];
+} __attribute__((packed));
+
+static_assert(sizeof(CommandTable) == command_table_size);
+
+}
+
+class AHCIDiskDevice final : public BlockDevice {
+public:
+    static RefPtr<AHCIDiskDevice> create(AHCIController&, size_t port_index, int major, int minor);
+    virtual ~AHCIDiskDevice() override;
+
+    // The most we'll transfer with one command.
+    static constexpr size_t max_transfer_size = 32 * PAGE_SIZE;
+
+    // ^BlockDevice
+    virtual bool read_blocks(unsigned index, u16 count, u8*) override;
+    virtual bool write_blocks(unsigned index, u16 count, const u8*) override;
+
+    // ^File
+    virtual ssize_t read(FileDescription&, size_t, u8*, ssize_t) override;
+    virtual bool can_read(const FileDescription&, size_t) const override;
+    virtual ssize_t write(FileDescription&, size_t, const u8*, ssize_t) override;
+    virtual bool can_write(const FileDescription&, size_t) const override;
+
+    size_t port_index() const { return m_port_index; }
+    void handle_interrupt(Badge<AHCIController>);
+
+private:
+    AHCIDiskDevice(AHCIController&, size_t port_index, int major, int minor);
+
+    // ^Device
+    virtual const char* class_name() const override;
+
+    bool initialize();
+    void stop_command_engine();
+    void start_command_engine();
+    bool identify();
+    bool transfer(RequestType, u32 lba, u16 count, u8* buffer);
+
+    size_t acquire_command_slot();
+    void release_command_slot(size_t slot);
+    void set_up_command(size_t slot, u8 command, u32 lba, u16 count, bool is_write, size_t prdt_length);
+    bool run_command(size_t slot);
+
+    u32 read_port_register(u32 offset) const;
+    void write_port_register(u32 offset, u32 value);
+
+    AHCI::CommandHeader* command_list() { return reinterpret_cast<AHCI::CommandHeader*>(m_command_list_page->paddr().offset(0xc0000000).as_ptr()); }
+    PhysicalAddress command_table_paddr(size_t slot) const { return m_command_table_pages[slot / (PAGE_SIZE / AHCI::command_table_size)].paddr().offset((slot % (PAGE_SIZE / AHCI::command_table_size)) * AHCI::command_table_size); }
+    AHCI::CommandTable& command_table(size_t slot) const { return *reinterpret_cast<AHCI::CommandTable*>(command_table_paddr(slot).offset(0xc0000000).as_ptr()); }
+    u8* bounce_buffer_page_data(size_t index) { return m_bounce_buffer_pages[index].paddr().offset(0xc0000000).as_ptr(); }
+
+    AHCIController& m_controller;
+    size_t m_port_index { 0 };
+    u64 m_block_count { 0 };
+
+    // The port's command list (1 KiB), followed by the area the controller receives FISes from the device into.
+    RefPtr<PhysicalPage> m_command_list_page;
+    NonnullRefPtrVector<PhysicalPage> m_command_table_pages;
+
+    // Transfers to buffers we can't point the controller at directly go through here, one at a time.
+    NonnullRefPtrVector<PhysicalPage> m_bounce_buffer_pages;
+    Lock m_bounce_buffer_lock { "AHCIDiskDevice" };
+
+    bool m_uses_ncq { false };
+    size_t m_slot_count { 1 };
+    u32 m_busy_slots { 0 };
+    u32 m_issued_slots { 0 };
+    u32 m_failed_slots { 0 };
+    WaitQueue m_free_slot_wait_queue;
+    WaitQueue m_completion_wait_queues[32];
+};
+
+}
@@ -24,7 +24,11 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <Kernel/Arch/i386/CPU.h>
 #include <Kernel/Devices/BlockDevice.h>
+#include <Kernel/PerformanceEventBuffer.h>
+#include <Kernel/Process.h>
+#include <Kernel/Thread.h>
 
 namespace Kernel {
 
@@ -62,4 +66,110 @@ bool BlockDevice::write_raw(u32 offset, unsigned length, const u8* in)
     return write_blocks(first_block, end_block - first_block, in);
 }
 
+bool BlockDevice::submit_request(RequestType type, unsigned index, u16 count, u8* buffer)
+{
+    ASSERT(count);
+    QueuedRequest request;
+    request.type = type;
+    request.index = index;
+    request.count = count;
+    request.buffer = buffer;
+
+    auto* kernel_event_buffer = Process::current()->kernel_event_buffer();
+    if (kernel_event_buffer)
+        kernel_event_buffer->append_block_io(PERF_EVENT_BLOCK_IO_SUBMIT, *Thread::current(), index, count, type == RequestType::Write);
+
+    {
+        InterruptDisabler disabler;
+        m_queued_requests.append(&request);
+        if (!m_is_busy)
+            start_next_request();
+    }
+    for (;;) {
+        InterruptDisabler disabler;
+        if (request.state != QueuedRequest::State::Queued)
+            break;
+        Thread::current()->wait_on(request.wait_queue);
+    }
+
+    // If our request went along with somebody else's, it's already been carried out.
+    if (request.state == QueuedRequest::State::Started)
+        run_request(request);
+    ASSERT(request.state == QueuedRequest::State::Done);
+    if (kernel_event_buffer)
+        kernel_event_buffer->append_block_io(PERF_EVENT_BLOCK_IO_COMPLETE, *Thread::current(), index, count, type == RequestType::Write);
+    return request.success;
+}
+
+void BlockDevice::start_next_request()
+{
+    ASSERT_INTERRUPTS_DISABLED();
+    if (m_queued_requests.is_empty()) {
+        m_is_busy = false;
+        return;
+    }
+
+    // Take the lowest block index at or past where the last request ended, and wrap around when there isn't one.
+    size_t next = 0;
+    for (size_t i = 1; i < m_queued_requests.size(); ++i) {
+        bool is_ahead = m_queued_requests[i]->index >= m_next_block_index;
+        bool next_is_ahead = m_queued_requests[next]->index >= m_next_block_index;
+        if (is_ahead != next_is_ahead) {
+            if (is_ahead)
+                next = i;
+            continue;
+        }
+        if (m_queued_requests[i]->index < m_queued_requests[next]->index)
+            next = i;
+    }
+
+    auto& request = *m_queued_requests.take(next);
+    request.state = QueuedRequest::State::Started;
+    m_is_busy = true;
+    request.wait_queue.wake_all();
+}
+
+void BlockDevice::run_request(QueuedRequest& request)
+{
+    ASSERT(m_is_busy);
+    RequestSegments segments;
+    segments.append({ request.buffer, request.count });
+    Vector<QueuedRequest*, 8> merged_requests;
+    unsigned end_index = request.index + request.count;
+    size_t total_count = request.count;
+
+    {
+        InterruptDisabler disabler;
+        // We carry out the requests we take along on their owners' behalf, from our own address space,
+        // so only those with buffers in kernel memory qualify.
+        for (size_t i = 0; i < m_queued_requests.size();) {
+            auto& other = *m_queued_requests[i];
+            if (other.type != request.type || other.index != end_index || (FlatPtr)other.buffer < 0xc0000000 || total_count + other.count > max_blocks_per_request()) {
+                ++i;
+                continue;
+            }
+            segments.append({ other.buffer, other.count });
+            merged_requests.append(&other);
+            m_queued_requests.remove(i);
+            end_index += other.count;
+            total_count += other.count;
+            // Whatever follows this one may be earlier in the queue, so look again from the start.
+            i = 0;
+        }
+    }
+
+    bool success = handle_request(request.type, request.index, segments);
+
+    InterruptDisabler disabler;
+    request.success = success;
+    request.state = QueuedRequest::State::Done;
+    for (auto* other : merged_requests) {
+        other->success = success;
+        other->state = QueuedRequest::State::Done;
+        other->wait_queue.wake_all();
+    }
+    m_next_block_index = end_index;
+    start_next_request();
+}
+
 }
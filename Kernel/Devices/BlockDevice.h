@@ -26,7 +26,9 @@
 
 #pragma once
 
+#include <AK/Vector.h>
 #include <Kernel/Devices/Device.h>
+#include <Kernel/WaitQueue.h>
 
 namespace Kernel {
 
@@ -45,6 +47,17 @@ public:
     virtual bool read_blocks(unsigned index, u16 count, u8*) = 0;
     virtual bool write_blocks(unsigned index, u16 count, const u8*) = 0;
 
+    enum class RequestType {
+        Read,
+        Write,
+    };
+
+    struct RequestSegment {
+        u8* buffer { nullptr };
+        u16 count { 0 };
+    };
+    typedef Vector<RequestSegment, 8> RequestSegments;
+
 protected:
     BlockDevice(unsigned major, unsigned minor, size_t block_size = PAGE_SIZE)
         : Device(major, minor)
@@ -52,10 +65,42 @@ protected:
     {
     }
 
+    // Devices that can only do one thing at a time queue their requests here. While one thread waits for the
+    // hardware, others line theirs up; they're then handed out in elevator order (ascending block index, wrapping
+    // around at the end), and queued requests for the blocks right after the one being started go along with it.
+    bool submit_request(RequestType, unsigned index, u16 count, u8* buffer);
+
+    // Carries out one or more requests for consecutive blocks as a single transfer. The segments are in block order.
+    virtual bool handle_request(RequestType, unsigned, const RequestSegments&) { ASSERT_NOT_REACHED(); }
+    virtual u16 max_blocks_per_request() const { return 1; }
+
 private:
     virtual bool is_block_device() const final { return true; }
 
+    struct QueuedRequest {
+        enum class State {
+            Queued,
+            Started,
+            Done,
+        };
+
+        RequestType type;
+        unsigned index { 0 };
+        u16 count { 0 };
+        u8* buffer { nullptr };
+        State state { State::Queued };
+        bool success { false };
+        WaitQueue wait_queue;
+    };
+
+    void start_next_request();
+    void run_request(QueuedRequest&);
+
     size_t m_block_size { 0 };
+
+    Vector<QueuedRequest*> m_queued_requests;
+    bool m_is_busy { false };
+    unsigned m_next_block_index { 0 };
 };
 
 }
@@ -38,7 +38,7 @@ class MBVGADevice final : public BlockDevice {
 public:
     static MBVGADevice& the();
 
-    MBVGADevice(PhysicalAddress addr, size_t pitch, size_t width, size_t height);
+    MBVGADevice(PhysicalAddress addr, size_t pitch, size_t width, size_t height, size_t bpp);
 
     virtual int ioctl(FileDescription&, unsigned request, FlatPtr arg) override;
     virtual KResultOr<Region*> mmap(Process&, FileDescription&, VirtualAddress preferred_vaddr, size_t offset, size_t, int prot, bool shared) override;
@@ -58,6 +58,7 @@ private:
     size_t m_framebuffer_pitch { 0 };
     size_t m_framebuffer_width { 0 };
     size_t m_framebuffer_height { 0 };
+    size_t m_framebuffer_bpp { 0 };
 };
 
 }
@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2018-2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/Memory.h>
+#include <AK/StdLibExtras.h>
+#include <Kernel/Devices/MemoryPressureDevice.h>
+#include <Kernel/FileSystem/FileDescription.h>
+#include <LibC/errno_numbers.h>
+
+namespace Kernel {
+
+static MemoryPressureDevice* s_the;
+
+MemoryPressureDevice& MemoryPressureDevice::the()
+{
+    ASSERT(s_the);
+    return *s_the;
+}
+
+MemoryPressureDevice::MemoryPressureDevice()
+    : CharacterDevice(1, 12)
+{
+    s_the = this;
+}
+
+MemoryPressureDevice::~MemoryPressureDevice()
+{
+}
+
+void MemoryPressureDevice::notify()
+{
+    InterruptDisabler disabler;
+    ++m_event_count;
+}
+
+KResultOr<NonnullRefPtr<FileDescription>> MemoryPressureDevice::open(int options)
+{
+    auto description = CharacterDevice::open(options);
+    if (description.is_error())
+        return description;
+    // The file offset tracks how many events this description has seen; start with none pending.
+    description.value()->seek(m_event_count * sizeof(u32), SEEK_SET);
+    return description;
+}
+
+bool MemoryPressureDevice::can_read(const FileDescription&, size_t offset) const
+{
+    return offset < m_event_count * sizeof(u32);
+}
+
+ssize_t MemoryPressureDevice::read(FileDescription&, size_t offset, u8* buffer, ssize_t size)
+{
+    if (offset % sizeof(u32) || size < (ssize_t)sizeof(u32))
+        return -EINVAL;
+    u32 first_event = offset / sizeof(u32);
+    u32 event_count = m_event_count;
+    ssize_t nread = 0;
+    for (u32 event = first_event; event < event_count && nread + (ssize_t)sizeof(u32) <= size; ++event) {
+        u32 event_number = event + 1;
+        memcpy(buffer + nread, &event_number, sizeof(u32));
+        nread += sizeof(u32);
+    }
+    return nread;
+}
+
+ssize_t MemoryPressureDevice::write(FileDescription&, size_t, const u8*, ssize_t)
+{
+    return -EINVAL;
+}
+
+}
@@ -165,8 +165,8 @@ void PATAChannel::initialize(bool force_pio)
     // Let's try to set up DMA transfers.
     PCI::enable_bus_mastering(pci_address());
     m_prdt_page = MM.allocate_supervisor_physical_page();
-    prdt().end_of_table = 0x8000;
-    m_dma_buffer_page = MM.allocate_supervisor_physical_page();
+    for (size_t i = 0; i < max_transfer_size / PAGE_SIZE; ++i)
+        m_dma_buffer_pages.append(MM.allocate_supervisor_physical_page().release_nonnull());
     klog() << "PATAChannel: Bus master IDE: " << m_bus_master_base;
 }
 
@@ -177,7 +177,7 @@ static void print_ide_status(u8 status)
 
 void PATAChannel::wait_for_irq()
 {
-    Thread::current->wait_on(m_irq_queue);
+    Thread::current()->wait_on(m_irq_queue);
     disable_irq();
 }
 
@@ -264,17 +264,112 @@ void PATAChannel::detect_disks()
     }
 }
 
-bool PATAChannel::ata_read_sectors_with_dma(u32 lba, u16 count, u8* outbuf, bool slave_request)
+void PATAChannel::set_up_prdt(size_t byte_count)
+{
+    ASSERT(byte_count && byte_count <= max_transfer_size);
+    // Each page of the DMA buffer gets its own descriptor, so the buffer doesn't have to be physically contiguous.
+    size_t entry_count = ceil_div(byte_count, PAGE_SIZE);
+    for (size_t i = 0; i < entry_count; ++i) {
+        auto& entry = prdt()[i];
+        entry.offset = m_dma_buffer_pages[i].paddr();
+        entry.size = min(byte_count - i * PAGE_SIZE, (size_t)PAGE_SIZE);
+        entry.end_of_table = (i == entry_count - 1) ? 0x8000 : 0;
+    }
+}
+
+bool PATAChannel::set_up_prdt_for_segments(const BlockDevice::RequestSegments& segments, bool device_writes_to_memory, NonnullRefPtrVector<PhysicalPage>& pinned_pages)
+{
+    // Point the descriptors straight at the pages behind the buffers, and hold on to them until the transfer is done,
+    // so they stay put even if a buffer gets unmapped while we wait. Physically adjacent pages share a descriptor,
+    // as long as it doesn't cross a 64 KiB boundary.
+    static constexpr size_t max_entry_count = PAGE_SIZE / sizeof(PhysicalRegionDescriptor);
+    size_t entry_count = 0;
+    for (auto& segment : segments) {
+        // The controller wants word-aligned descriptors with an even byte count; dword alignment is the safe bet.
+        if ((FlatPtr)segment.buffer & 3)
+            return false;
+        size_t byte_count = segment.count * 512;
+        for (size_t offset = 0; offset < byte_count;) {
+            VirtualAddress vaddr((FlatPtr)segment.buffer + offset);
+            size_t offset_in_page = vaddr.get() & ~PAGE_MASK;
+            size_t chunk_size = min(byte_count - offset, PAGE_SIZE - offset_in_page);
+            auto page = MM.physical_page_for_dma(vaddr, device_writes_to_memory);
+            if (!page)
+                return false;
+            auto paddr = page->paddr().offset(offset_in_page);
+            pinned_pages.append(page.release_nonnull());
+            offset += chunk_size;
+
+            if (entry_count) {
+                auto& last_entry = prdt()[entry_count - 1];
+                bool is_adjacent = last_entry.offset.get() + last_entry.size == paddr.get();
+                bool is_in_same_64k = (last_entry.offset.get() >> 16) == ((paddr.get() + chunk_size - 1) >> 16);
+                if (is_adjacent && is_in_same_64k && last_entry.size + chunk_size < 0x10000) {
+                    last_entry.size += chunk_size;
+                    continue;
+                }
+            }
+            if (entry_count == max_entry_count)
+                return false;
+            auto& entry = prdt()[entry_count++];
+            entry.offset = paddr;
+            entry.size = chunk_size;
+            entry.end_of_table = 0;
+        }
+    }
+    prdt()[entry_count - 1].end_of_table = 0x8000;
+    return true;
+}
+
+void PATAChannel::copy_from_dma_buffer(const BlockDevice::RequestSegments& segments)
+{
+    size_t offset = 0;
+    for (auto& segment : segments) {
+        for (size_t copied = 0; copied < segment.count * 512u;) {
+            size_t offset_in_page = offset % PAGE_SIZE;
+            size_t chunk_size = min(segment.count * 512u - copied, PAGE_SIZE - offset_in_page);
+            memcpy(segment.buffer + copied, dma_buffer_page_data(offset / PAGE_SIZE) + offset_in_page, chunk_size);
+            copied += chunk_size;
+            offset += chunk_size;
+        }
+    }
+}
+
+void PATAChannel::copy_to_dma_buffer(const BlockDevice::RequestSegments& segments)
+{
+    size_t offset = 0;
+    for (auto& segment : segments) {
+        for (size_t copied = 0; copied < segment.count * 512u;) {
+            size_t offset_in_page = offset % PAGE_SIZE;
+            size_t chunk_size = min(segment.count * 512u - copied, PAGE_SIZE - offset_in_page);
+            memcpy(dma_buffer_page_data(offset / PAGE_SIZE) + offset_in_page, segment.buffer + copied, chunk_size);
+            copied += chunk_size;
+            offset += chunk_size;
+        }
+    }
+}
+
+static u16 total_sector_count(const BlockDevice::RequestSegments& segments)
+{
+    size_t count = 0;
+    for (auto& segment : segments)
+        count += segment.count;
+    ASSERT(count * 512 <= PATAChannel::max_transfer_size);
+    return count;
+}
+
+bool PATAChannel::ata_read_sectors_with_dma(u32 lba, const BlockDevice::RequestSegments& segments, bool slave_request)
 {
     LOCKER(s_lock());
+    u16 count = total_sector_count(segments);
 #ifdef PATA_DEBUG
-    dbg() << "PATAChannel::ata_read_sectors_with_dma (" << lba << " x" << count << ") -> " << outbuf;
+    dbg() << "PATAChannel::ata_read_sectors_with_dma (" << lba << " x" << count << ") -> " << segments.size() << " segment(s)";
 #endif
 
-    prdt().offset = m_dma_buffer_page->paddr();
-    prdt().size = 512 * count;
-
-    ASSERT(prdt().size <= PAGE_SIZE);
+    NonnullRefPtrVector<PhysicalPage> pinned_pages;
+    bool is_direct = set_up_prdt_for_segments(segments, true, pinned_pages);
+    if (!is_direct)
+        set_up_prdt(512 * count);
 
     // Stop bus master
     m_bus_master_base.out<u8>(0);
@@ -301,12 +396,13 @@ bool PATAChannel::ata_read_sectors_with_dma(u32 lba, u16 count, u8* outbuf, bool
 
     m_io_base.offset(ATA_REG_FEATURES).out<u8>(0);
 
-    m_io_base.offset(ATA_REG_SECCOUNT0).out<u8>(0);
+    // 48-bit commands take the high bytes first, which matters once a request reaches 256 sectors.
+    m_io_base.offset(ATA_REG_SECCOUNT0).out<u8>(MSB(count));
     m_io_base.offset(ATA_REG_LBA0).out<u8>(0);
     m_io_base.offset(ATA_REG_LBA1).out<u8>(0);
     m_io_base.offset(ATA_REG_LBA2).out<u8>(0);
 
-    m_io_base.offset(ATA_REG_SECCOUNT0).out<u8>(count);
+    m_io_base.offset(ATA_REG_SECCOUNT0).out<u8>(LSB(count));
     m_io_base.offset(ATA_REG_LBA0).out<u8>((lba & 0x000000ff) >> 0);
     m_io_base.offset(ATA_REG_LBA1).out<u8>((lba & 0x0000ff00) >> 8);
     m_io_base.offset(ATA_REG_LBA2).out<u8>((lba & 0x00ff0000) >> 16);
@@ -329,26 +425,27 @@ bool PATAChannel::ata_read_sectors_with_dma(u32 lba, u16 count, u8* outbuf, bool
     if (m_device_error)
         return false;
 
-    memcpy(outbuf, m_dma_buffer_page->paddr().offset(0xc0000000).as_ptr(), 512 * count);
+    if (!is_direct)
+        copy_from_dma_buffer(segments);
 
     // I read somewhere that this may trigger a cache flush so let's do it.
     m_bus_master_base.offset(2).out<u8>(m_bus_master_base.offset(2).in<u8>() | 0x6);
     return true;
 }
 
-bool PATAChannel::ata_write_sectors_with_dma(u32 lba, u16 count, const u8* inbuf, bool slave_request)
+bool PATAChannel::ata_write_sectors_with_dma(u32 lba, const BlockDevice::RequestSegments& segments, bool slave_request)
 {
     LOCKER(s_lock());
+    u16 count = total_sector_count(segments);
 #ifdef PATA_DEBUG
-    dbg() << "PATAChannel::ata_write_sectors_with_dma (" << lba << " x" << count << ") <- " << inbuf;
+    dbg() << "PATAChannel::ata_write_sectors_with_dma (" << lba << " x" << count << ") <- " << segments.size() << " segment(s)";
 #endif
 
-    prdt().offset = m_dma_buffer_page->paddr();
-    prdt().size = 512 * count;
-
-    memcpy(m_dma_buffer_page->paddr().offset(0xc0000000).as_ptr(), inbuf, 512 * count);
-
-    ASSERT(prdt().size <= PAGE_SIZE);
+    NonnullRefPtrVector<PhysicalPage> pinned_pages;
+    if (!set_up_prdt_for_segments(segments, false, pinned_pages)) {
+        set_up_prdt(512 * count);
+        copy_to_dma_buffer(segments);
+    }
 
     // Stop bus master
     m_bus_master_base.out<u8>(0);
@@ -372,12 +469,13 @@ bool PATAChannel::ata_write_sectors_with_dma(u32 lba, u16 count, const u8* inbuf
 
     m_io_base.offset(ATA_REG_FEATURES).out<u8>(0);
 
-    m_io_base.offset(ATA_REG_SECCOUNT0).out<u8>(0);
+    // 48-bit commands take the high bytes first, which matters once a request reaches 256 sectors.
+    m_io_base.offset(ATA_REG_SECCOUNT0).out<u8>(MSB(count));
     m_io_base.offset(ATA_REG_LBA0).out<u8>(0);
     m_io_base.offset(ATA_REG_LBA1).out<u8>(0);
     m_io_base.offset(ATA_REG_LBA2).out<u8>(0);
 
-    m_io_base.offset(ATA_REG_SECCOUNT0).out<u8>(count);
+    m_io_base.offset(ATA_REG_SECCOUNT0).out<u8>(LSB(count));
     m_io_base.offset(ATA_REG_LBA0).out<u8>((lba & 0x000000ff) >> 0);
     m_io_base.offset(ATA_REG_LBA1).out<u8>((lba & 0x0000ff00) >> 8);
     m_io_base.offset(ATA_REG_LBA2).out<u8>((lba & 0x00ff0000) >> 16);
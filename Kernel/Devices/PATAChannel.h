@@ -37,8 +37,10 @@
 
 #pragma once
 
+#include <AK/NonnullRefPtrVector.h>
 #include <AK/OwnPtr.h>
 #include <AK/RefPtr.h>
+#include <Kernel/Devices/BlockDevice.h>
 #include <Kernel/IO.h>
 #include <Kernel/Lock.h>
 #include <Kernel/PCI/Access.h>
@@ -75,6 +77,9 @@ public:
 
     virtual const char* purpose() const override { return "PATA Channel"; }
 
+    // The most we'll transfer in one request, with or without DMA.
+    static constexpr size_t max_transfer_size = 32 * PAGE_SIZE;
+
 private:
     //^ IRQHandler
     virtual void handle_irq(const RegisterState&) override;
@@ -83,8 +88,8 @@ private:
     void detect_disks();
 
     void wait_for_irq();
-    bool ata_read_sectors_with_dma(u32, u16, u8*, bool);
-    bool ata_write_sectors_with_dma(u32, u16, const u8*, bool);
+    bool ata_read_sectors_with_dma(u32, const BlockDevice::RequestSegments&, bool);
+    bool ata_write_sectors_with_dma(u32, const BlockDevice::RequestSegments&, bool);
     bool ata_read_sectors(u32, u16, u8*, bool);
     bool ata_write_sectors(u32, u16, const u8*, bool);
 
@@ -98,9 +103,15 @@ private:
 
     WaitQueue m_irq_queue;
 
-    PhysicalRegionDescriptor& prdt() { return *reinterpret_cast<PhysicalRegionDescriptor*>(m_prdt_page->paddr().offset(0xc0000000).as_ptr()); }
+    PhysicalRegionDescriptor* prdt() { return reinterpret_cast<PhysicalRegionDescriptor*>(m_prdt_page->paddr().offset(0xc0000000).as_ptr()); }
+    u8* dma_buffer_page_data(size_t index) { return m_dma_buffer_pages[index].paddr().offset(0xc0000000).as_ptr(); }
+    void set_up_prdt(size_t byte_count);
+    bool set_up_prdt_for_segments(const BlockDevice::RequestSegments&, bool device_writes_to_memory, NonnullRefPtrVector<PhysicalPage>& pinned_pages);
+    void copy_from_dma_buffer(const BlockDevice::RequestSegments&);
+    void copy_to_dma_buffer(const BlockDevice::RequestSegments&);
+
     RefPtr<PhysicalPage> m_prdt_page;
-    RefPtr<PhysicalPage> m_dma_buffer_page;
+    NonnullRefPtrVector<PhysicalPage> m_dma_buffer_pages;
     IOAddress m_bus_master_base;
     Lockable<bool> m_dma_enabled;
 
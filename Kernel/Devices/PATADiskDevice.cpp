@@ -57,18 +57,38 @@ const char* PATADiskDevice::class_name() const
 
 bool PATADiskDevice::read_blocks(unsigned index, u16 count, u8* out)
 {
-    if (!m_channel.m_bus_master_base.is_null() && m_channel.m_dma_enabled.resource())
-        return read_sectors_with_dma(index, count, out);
-    return read_sectors(index, count, out);
+    return submit_request(RequestType::Read, index, count, out);
 }
 
 bool PATADiskDevice::write_blocks(unsigned index, u16 count, const u8* data)
 {
-    if (!m_channel.m_bus_master_base.is_null() && m_channel.m_dma_enabled.resource())
-        return write_sectors_with_dma(index, count, data);
-    for (unsigned i = 0; i < count; ++i) {
-        if (!write_sectors(index + i, 1, data + i * 512))
-            return false;
+    return submit_request(RequestType::Write, index, count, const_cast<u8*>(data));
+}
+
+u16 PATADiskDevice::max_blocks_per_request() const
+{
+    return PATAChannel::max_transfer_size / block_size();
+}
+
+bool PATADiskDevice::handle_request(RequestType type, unsigned index, const RequestSegments& segments)
+{
+    if (!m_channel.m_bus_master_base.is_null() && m_channel.m_dma_enabled.resource()) {
+        if (type == RequestType::Read)
+            return m_channel.ata_read_sectors_with_dma(index, segments, is_slave());
+        return m_channel.ata_write_sectors_with_dma(index, segments, is_slave());
+    }
+
+    for (auto& segment : segments) {
+        if (type == RequestType::Read) {
+            if (!read_sectors(index, segment.count, segment.buffer))
+                return false;
+        } else {
+            for (unsigned i = 0; i < segment.count; ++i) {
+                if (!write_sectors(index + i, 1, segment.buffer + i * 512))
+                    return false;
+            }
+        }
+        index += segment.count;
     }
     return true;
 }
@@ -86,12 +106,12 @@ ssize_t PATADiskDevice::read(FileDescription&, size_t offset, u8* outbuf, ssize_
     u16 whole_blocks = len / block_size();
     ssize_t remaining = len % block_size();
 
-    unsigned blocks_per_page = PAGE_SIZE / block_size();
+    unsigned max_blocks_per_request = PATAChannel::max_transfer_size / block_size();
 
-    // PATAChannel will chuck a wobbly if we try to read more than PAGE_SIZE
-    // at a time, because it uses a single page for its DMA buffer.
-    if (whole_blocks >= blocks_per_page) {
-        whole_blocks = blocks_per_page;
+    // PATAChannel will chuck a wobbly if we try to read more than its DMA buffer
+    // holds at a time. Callers have to come back for the rest.
+    if (whole_blocks >= max_blocks_per_request) {
+        whole_blocks = max_blocks_per_request;
         remaining = 0;
     }
 
@@ -127,12 +147,12 @@ ssize_t PATADiskDevice::write(FileDescription&, size_t offset, const u8* inbuf,
     u16 whole_blocks = len / block_size();
     ssize_t remaining = len % block_size();
 
-    unsigned blocks_per_page = PAGE_SIZE / block_size();
+    unsigned max_blocks_per_request = PATAChannel::max_transfer_size / block_size();
 
-    // PATAChannel will chuck a wobbly if we try to write more than PAGE_SIZE
-    // at a time, because it uses a single page for its DMA buffer.
-    if (whole_blocks >= blocks_per_page) {
-        whole_blocks = blocks_per_page;
+    // PATAChannel will chuck a wobbly if we try to write more than its DMA buffer
+    // holds at a time. Callers have to come back for the rest.
+    if (whole_blocks >= max_blocks_per_request) {
+        whole_blocks = max_blocks_per_request;
         remaining = 0;
     }
 
@@ -167,21 +187,11 @@ bool PATADiskDevice::can_write(const FileDescription&, size_t offset) const
     return offset < (m_cylinders * m_heads * m_sectors_per_track * block_size());
 }
 
-bool PATADiskDevice::read_sectors_with_dma(u32 lba, u16 count, u8* outbuf)
-{
-    return m_channel.ata_read_sectors_with_dma(lba, count, outbuf, is_slave());
-}
-
 bool PATADiskDevice::read_sectors(u32 start_sector, u16 count, u8* outbuf)
 {
     return m_channel.ata_read_sectors(start_sector, count, outbuf, is_slave());
 }
 
-bool PATADiskDevice::write_sectors_with_dma(u32 lba, u16 count, const u8* inbuf)
-{
-    return m_channel.ata_write_sectors_with_dma(lba, count, inbuf, is_slave());
-}
-
 bool PATADiskDevice::write_sectors(u32 start_sector, u16 count, const u8* inbuf)
 {
     return m_channel.ata_write_sectors(start_sector, count, inbuf, is_slave());
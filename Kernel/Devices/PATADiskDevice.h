@@ -73,9 +73,11 @@ private:
     // ^DiskDevice
     virtual const char* class_name() const override;
 
+    // ^BlockDevice
+    virtual bool handle_request(RequestType, unsigned index, const RequestSegments&) override;
+    virtual u16 max_blocks_per_request() const override;
+
     bool wait_for_irq();
-    bool read_sectors_with_dma(u32 lba, u16 count, u8*);
-    bool write_sectors_with_dma(u32 lba, u16 count, const u8*);
     bool read_sectors(u32 lba, u16 count, u8* buffer);
     bool write_sectors(u32 lba, u16 count, const u8* data);
     bool is_slave() const;
@@ -47,6 +47,10 @@ public:
     virtual bool can_write(const FileDescription&, size_t) const override;
     virtual ssize_t write(FileDescription&, size_t, const u8*, ssize_t) override;
 
+    // ^File
+    // We don't take interrupts, so the line status has to be checked over and over.
+    virtual bool readiness_needs_polling() const override { return true; }
+
     enum InterruptEnable {
         LowPowerMode = 0x01 << 5,
         SleepMode = 0x01 << 4,
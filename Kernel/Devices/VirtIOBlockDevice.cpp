@@ -0,0 +1,303 @@
+/*
+ * Copyright (c) 2018-2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/Memory.h>
+#include <AK/StringView.h>
+#include <Kernel/Devices/VirtIOBlockDevice.h>
+#include <Kernel/FileSystem/FileDescription.h>
+#include <Kernel/Thread.h>
+#include <Kernel/VM/MemoryManager.h>
+
+//#define VIRTIO_BLOCK_DEBUG
+
+#define VIRTIO_BLK_F_SEG_MAX 2
+#define VIRTIO_BLK_F_RO 5
+
+#define VIRTIO_BLK_CONFIG_CAPACITY 0
+#define VIRTIO_BLK_CONFIG_SEG_MAX 12
+
+#define VIRTIO_BLK_T_IN 0
+#define VIRTIO_BLK_T_OUT 1
+
+#define VIRTIO_BLK_S_OK 0
+
+// Block devices with major 254 are virtio disks, indexed by minor in the order we find them.
+#define VIRTIO_BLOCK_MAJOR 254
+
+namespace Kernel {
+
+NonnullRefPtrVector<VirtIOBlockDevice> VirtIOBlockDevice::detect()
+{
+    static const PCI::ID virtio_block_id = { VIRTIO_PCI_VENDOR_ID, VIRTIO_PCI_DEVICE_ID_BLOCK };
+
+    NonnullRefPtrVector<VirtIOBlockDevice> disks;
+    PCI::enumerate([&](const PCI::Address& address, PCI::ID id) {
+        if (address.is_null() || id != virtio_block_id)
+            return;
+        auto disk = adopt(*new VirtIOBlockDevice(address, disks.size()));
+        if (disk->initialize())
+            disks.append(move(disk));
+    });
+    return disks;
+}
+
+VirtIOBlockDevice::VirtIOBlockDevice(PCI::Address address, int minor)
+    : BlockDevice(VIRTIO_BLOCK_MAJOR, minor, 512)
+    , VirtIODevice(address)
+{
+}
+
+VirtIOBlockDevice::~VirtIOBlockDevice()
+{
+}
+
+bool VirtIOBlockDevice::initialize()
+{
+    u32 features = begin_initialization();
+    accept_features(features & ((1u << VIRTIO_BLK_F_SEG_MAX) | (1u << VIRTIO_BLK_F_RO)));
+    if (!setup_queues(1)) {
+        fail_initialization();
+        return false;
+    }
+
+    m_block_count = config_read64(VIRTIO_BLK_CONFIG_CAPACITY);
+    // Every request takes a descriptor for its header and one for its status, besides the ones for its data.
+    m_max_segments = queue(0).size() - 2;
+    if (is_feature_accepted(VIRTIO_BLK_F_SEG_MAX))
+        m_max_segments = min(m_max_segments, (size_t)config_read32(VIRTIO_BLK_CONFIG_SEG_MAX));
+
+    m_request_slots_region = MM.allocate_contiguous_kernel_region(PAGE_SIZE, "VirtIO Block Requests", Region::Access::Read | Region::Access::Write);
+    m_bounce_buffer_region = MM.allocate_contiguous_kernel_region(max_transfer_size, "VirtIO Block Bounce", Region::Access::Read | Region::Access::Write);
+    if (!m_request_slots_region || !m_bounce_buffer_region || !m_max_segments) {
+        fail_initialization();
+        return false;
+    }
+
+    finish_initialization();
+    klog() << "VirtIOBlockDevice: Found @ " << pci_address() << ", " << m_block_count << " sectors, queue size " << queue(0).size() << (is_feature_accepted(VIRTIO_BLK_F_RO) ? ", read-only" : "");
+    return true;
+}
+
+size_t VirtIOBlockDevice::acquire_request_slot()
+{
+    for (;;) {
+        InterruptDisabler disabler;
+        for (size_t slot = 0; slot < request_slot_count; ++slot) {
+            if (!(m_busy_slots & (1u << slot))) {
+                m_busy_slots |= 1u << slot;
+                m_completed_slots &= ~(1u << slot);
+                return slot;
+            }
+        }
+        Thread::current()->wait_on(m_free_slot_wait_queue);
+    }
+}
+
+void VirtIOBlockDevice::release_request_slot(size_t slot)
+{
+    InterruptDisabler disabler;
+    m_busy_slots &= ~(1u << slot);
+    m_free_slot_wait_queue.wake_one();
+}
+
+static bool collect_dma_buffers(u8* buffer, size_t byte_count, bool device_writes_to_memory, size_t max_segments, NonnullRefPtrVector<PhysicalPage>& pinned_pages, Vector<VirtIOBuffer, 36>& buffers)
+{
+    // Hold on to the pages until the transfer is done, so they stay put even if the buffer gets
+    // unmapped while we wait. Physically adjacent pages share a descriptor.
+    size_t first_segment = buffers.size();
+    for (size_t offset = 0; offset < byte_count;) {
+        VirtualAddress vaddr((FlatPtr)buffer + offset);
+        size_t offset_in_page = vaddr.get() & ~PAGE_MASK;
+        size_t chunk_size = min(byte_count - offset, PAGE_SIZE - offset_in_page);
+        auto page = MM.physical_page_for_dma(vaddr, device_writes_to_memory);
+        if (!page)
+            return false;
+        auto paddr = page->paddr().offset(offset_in_page);
+        pinned_pages.append(page.release_nonnull());
+        offset += chunk_size;
+
+        if (buffers.size() > first_segment && buffers.last().paddr.offset(buffers.last().length) == paddr) {
+            buffers.last().length += chunk_size;
+            continue;
+        }
+        if (buffers.size() - first_segment == max_segments)
+            return false;
+        buffers.append({ paddr, (u32)chunk_size, device_writes_to_memory });
+    }
+    return true;
+}
+
+bool VirtIOBlockDevice::transfer(RequestType type, u32 lba, u16 count, u8* buffer)
+{
+    size_t byte_count = count * block_size();
+    ASSERT(byte_count && byte_count <= max_transfer_size);
+    bool is_write = type == RequestType::Write;
+#ifdef VIRTIO_BLOCK_DEBUG
+    dbg() << "VirtIOBlockDevice::transfer " << (is_write ? "write" : "read") << " (" << lba << " x" << count << ") " << (const void*)buffer;
+#endif
+    if (is_write && is_feature_accepted(VIRTIO_BLK_F_RO))
+        return false;
+
+    size_t slot = acquire_request_slot();
+    auto& request = request_slot(slot);
+    request.header.type = is_write ? VIRTIO_BLK_T_OUT : VIRTIO_BLK_T_IN;
+    request.header.reserved = 0;
+    request.header.sector = lba;
+    request.status = 0xff;
+
+    NonnullRefPtrVector<PhysicalPage> pinned_pages;
+    Vector<VirtIOBuffer, 36> buffers;
+    buffers.append({ request_slot_paddr(slot), sizeof(RequestHeader), false });
+    bool is_direct = collect_dma_buffers(buffer, byte_count, !is_write, m_max_segments, pinned_pages, buffers);
+    if (!is_direct) {
+        m_bounce_buffer_lock.lock();
+        buffers.shrink(1);
+        if (is_write)
+            memcpy(m_bounce_buffer_region->vaddr().as_ptr(), buffer, byte_count);
+        buffers.append({ m_bounce_buffer_region->physical_page(0)->paddr(), (u32)byte_count, !is_write });
+    }
+    buffers.append({ request_slot_paddr(slot).offset(sizeof(RequestHeader)), 1, true });
+
+    // The requests of all slots share the queue's descriptors, so there may not be enough of them free right now.
+    for (;;) {
+        InterruptDisabler disabler;
+        if (queue(0).supply_buffers(buffers.data(), buffers.size(), (void*)(slot + 1))) {
+            notify_queue(0);
+            break;
+        }
+        Thread::current()->wait_on(m_free_descriptor_wait_queue);
+    }
+    for (;;) {
+        InterruptDisabler disabler;
+        if (m_completed_slots & (1u << slot))
+            break;
+        Thread::current()->wait_on(m_completion_wait_queues[slot]);
+    }
+    bool success = request.status == VIRTIO_BLK_S_OK;
+    release_request_slot(slot);
+
+    if (!is_direct) {
+        if (success && !is_write)
+            memcpy(buffer, m_bounce_buffer_region->vaddr().as_ptr(), byte_count);
+        m_bounce_buffer_lock.unlock();
+    }
+    return success;
+}
+
+void VirtIOBlockDevice::handle_queue_update()
+{
+    u32 written_length;
+    while (void* token = queue(0).pop_used_buffers(written_length)) {
+        size_t slot = (FlatPtr)token - 1;
+        m_completed_slots |= 1u << slot;
+        m_completion_wait_queues[slot].wake_all();
+    }
+    m_free_descriptor_wait_queue.wake_all();
+}
+
+bool VirtIOBlockDevice::read_blocks(unsigned index, u16 count, u8* out)
+{
+    return transfer(RequestType::Read, index, count, out);
+}
+
+bool VirtIOBlockDevice::write_blocks(unsigned index, u16 count, const u8* data)
+{
+    return transfer(RequestType::Write, index, count, const_cast<u8*>(data));
+}
+
+ssize_t VirtIOBlockDevice::read(FileDescription&, size_t offset, u8* outbuf, ssize_t len)
+{
+    unsigned index = offset / block_size();
+    u16 whole_blocks = len / block_size();
+    ssize_t remaining = len % block_size();
+
+    // Callers have to come back for whatever doesn't fit in one transfer.
+    unsigned max_blocks_per_transfer = max_transfer_size / block_size();
+    if (whole_blocks >= max_blocks_per_transfer) {
+        whole_blocks = max_blocks_per_transfer;
+        remaining = 0;
+    }
+
+    if (whole_blocks > 0) {
+        if (!read_blocks(index, whole_blocks, outbuf))
+            return -1;
+    }
+
+    off_t pos = whole_blocks * block_size();
+
+    if (remaining > 0) {
+        auto buf = ByteBuffer::create_uninitialized(block_size());
+        if (!read_blocks(index + whole_blocks, 1, buf.data()))
+            return pos;
+        memcpy(&outbuf[pos], buf.data(), remaining);
+    }
+
+    return pos + remaining;
+}
+
+bool VirtIOBlockDevice::can_read(const FileDescription&, size_t offset) const
+{
+    return offset < m_block_count * block_size();
+}
+
+ssize_t VirtIOBlockDevice::write(FileDescription&, size_t offset, const u8* inbuf, ssize_t len)
+{
+    unsigned index = offset / block_size();
+    u16 whole_blocks = len / block_size();
+    ssize_t remaining = len % block_size();
+
+    unsigned max_blocks_per_transfer = max_transfer_size / block_size();
+    if (whole_blocks >= max_blocks_per_transfer) {
+        whole_blocks = max_blocks_per_transfer;
+        remaining = 0;
+    }
+
+    if (whole_blocks > 0) {
+        if (!write_blocks(index, whole_blocks, inbuf))
+            return -1;
+    }
+
+    off_t pos = whole_blocks * block_size();
+
+    // Partial blocks have to be read, modified and written back whole.
+    if (remaining > 0) {
+        auto buf = ByteBuffer::create_zeroed(block_size());
+        if (!read_blocks(index + whole_blocks, 1, buf.data()))
+            return pos;
+        memcpy(buf.data(), &inbuf[pos], remaining);
+        if (!write_blocks(index + whole_blocks, 1, buf.data()))
+            return pos;
+    }
+
+    return pos + remaining;
+}
+
+bool VirtIOBlockDevice::can_write(const FileDescription&, size_t offset) const
+{
+    return offset < m_block_count * block_size();
+}
+
+}
@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2018-2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+//
+// A virtio-blk disk
+//
+
+#pragma once
+
+#include <AK/NonnullRefPtrVector.h>
+#include <Kernel/Devices/BlockDevice.h>
+#include <Kernel/Lock.h>
+#include <Kernel/VirtIO/VirtIO.h>
+#include <Kernel/WaitQueue.h>
+
+namespace Kernel {
+
+class VirtIOBlockDevice final : public BlockDevice
+    , public VirtIODevice {
+public:
+    static NonnullRefPtrVector<VirtIOBlockDevice> detect();
+    virtual ~VirtIOBlockDevice() override;
+
+    // The most we'll transfer with one request.
+    static constexpr size_t max_transfer_size = 32 * PAGE_SIZE;
+
+    // ^BlockDevice
+    virtual bool read_blocks(unsigned index, u16 count, u8*) override;
+    virtual bool write_blocks(unsigned index, u16 count, const u8*) override;
+
+    // ^File
+    virtual ssize_t read(FileDescription&, size_t, u8*, ssize_t) override;
+    virtual bool can_read(const FileDescription&, size_t) const override;
+    virtual ssize_t write(FileDescription&, size_t, const u8*, ssize_t) override;
+    virtual bool can_write(const FileDescription&, size_t) const override;
+
+    virtual const char* purpose() const override { return class_name(); }
+
+private:
+    VirtIOBlockDevice(PCI::Address, int minor);
+
+    // ^Device
+    virtual const char* class_name() const override { return "VirtIOBlockDevice"; }
+
+    // ^VirtIODevice
+    virtual void handle_queue_update() override;
+
+    bool initialize();
+    bool transfer(RequestType, u32 lba, u16 count, u8* buffer);
+    size_t acquire_request_slot();
+    void release_request_slot(size_t slot);
+
+    struct [[gnu::packed]] RequestHeader
+    {
+        u32 type;
+        u32 reserved;
+        u64 sector;
+    };
+
+    // What the device reads the request from and writes its status to has to live in physical memory we know the address of.
+    struct RequestSlot {
+        RequestHeader header;
+        volatile u8 status;
+        u8 padding[15];
+    };
+    static_assert(sizeof(RequestSlot) == 32);
+    static constexpr size_t request_slot_count = 32;
+
+    RequestSlot& request_slot(size_t slot) { return reinterpret_cast<RequestSlot*>(m_request_slots_region->vaddr().as_ptr())[slot]; }
+    PhysicalAddress request_slot_paddr(size_t slot) const { return m_request_slots_region->physical_page(0)->paddr().offset(slot * sizeof(RequestSlot)); }
+
+    u64 m_block_count { 0 };
+    size_t m_max_segments { 0 };
+
+    OwnPtr<Region> m_request_slots_region;
+    u32 m_busy_slots { 0 };
+    u32 m_completed_slots { 0 };
+    WaitQueue m_free_slot_wait_queue;
+    WaitQueue m_free_descriptor_wait_queue;
+    WaitQueue m_completion_wait_queues[request_slot_count];
+
+    // Transfers to buffers we can't point the device at directly go through here, one at a time.
+    OwnPtr<Region> m_bounce_buffer_region;
+    Lock m_bounce_buffer_lock { "VirtIOBlockDevice" };
+};
+
+}
@@ -42,6 +42,7 @@ public:
     bool is_empty() const { return m_empty; }
 
     size_t space_for_writing() const { return m_space_for_writing; }
+    size_t used_bytes() const { return m_used_bytes; }
 
 private:
     void flip();
@@ -61,6 +62,7 @@ private:
     size_t m_capacity { 0 };
     size_t m_read_buffer_index { 0 };
     size_t m_space_for_writing { 0 };
+    size_t m_used_bytes { 0 };
     bool m_empty { true };
     mutable Lock m_lock { "DoubleBuffer" };
 };
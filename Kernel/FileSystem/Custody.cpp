@@ -32,6 +32,8 @@
 
 namespace Kernel {
 
+DEFINE_OBJECT_CACHE(Custody);
+
 Custody::Custody(Custody* parent, const StringView& name, Inode& inode, int mount_flags)
     : m_parent(parent)
     , m_name(name)
@@ -30,14 +30,14 @@
 #include <AK/RefPtr.h>
 #include <AK/String.h>
 #include <Kernel/Forward.h>
-#include <Kernel/Heap/SlabAllocator.h>
+#include <Kernel/Heap/ObjectCache.h>
 
 namespace Kernel {
 
 // FIXME: Custody needs some locking.
 
 class Custody : public RefCounted<Custody> {
-    MAKE_SLAB_ALLOCATED(Custody)
+    MAKE_OBJECT_CACHED(Custody)
 public:
     static NonnullRefPtr<Custody> create(Custody* parent, const StringView& name, Inode& inode, int mount_flags)
     {
@@ -0,0 +1,210 @@
+/*
+ * Copyright (c) 2018-2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <Kernel/Arch/i386/CPU.h>
+#include <Kernel/FileSystem/EventQueue.h>
+#include <Kernel/FileSystem/FileDescription.h>
+
+namespace Kernel {
+
+NonnullRefPtr<EventQueue> EventQueue::create()
+{
+    return adopt(*new EventQueue);
+}
+
+EventQueue::EventQueue()
+{
+}
+
+EventQueue::~EventQueue()
+{
+    m_entries.clear();
+    ASSERT(m_ready_entries.is_empty());
+    ASSERT(!m_polled_entry_count);
+}
+
+EventQueue::Entry::Entry(EventQueue& queue, int fd, FileDescription& description, const epoll_event& event)
+    : queue(queue)
+    , fd(fd)
+    , description(description.make_weak_ptr())
+    , file(description.file())
+    , event(event)
+    , needs_polling(description.file().readiness_needs_polling())
+{
+    if (needs_polling)
+        ++queue.m_polled_entry_count;
+    file->block_condition().add_observer(*this);
+}
+
+EventQueue::Entry::~Entry()
+{
+    file->block_condition().remove_observer(*this);
+    InterruptDisabler disabler;
+    queue.dequeue(*this);
+    if (needs_polling)
+        --queue.m_polled_entry_count;
+}
+
+void EventQueue::Entry::block_condition_did_fire()
+{
+    queue.enqueue(*this);
+    queue.evaluate_block_conditions();
+}
+
+u32 EventQueue::Entry::ready_events() const
+{
+    auto* description = this->description.ptr();
+    if (!description)
+        return 0;
+    u32 ready = 0;
+    if ((event.events & EPOLLIN) && description->can_read())
+        ready |= EPOLLIN;
+    if ((event.events & EPOLLOUT) && description->can_write())
+        ready |= EPOLLOUT;
+    return ready;
+}
+
+void EventQueue::enqueue(Entry& entry)
+{
+    ASSERT_INTERRUPTS_DISABLED();
+    if (entry.is_queued)
+        return;
+    // Disarmed EPOLLONESHOT entries stay quiet until they're modified.
+    if (!(entry.event.events & (EPOLLIN | EPOLLOUT)))
+        return;
+    entry.is_queued = true;
+    m_ready_entries.append(&entry);
+}
+
+void EventQueue::dequeue(Entry& entry)
+{
+    ASSERT_INTERRUPTS_DISABLED();
+    if (!entry.is_queued)
+        return;
+    m_ready_entries.remove(&entry);
+    entry.is_queued = false;
+}
+
+KResult EventQueue::add(int fd, FileDescription& description, const epoll_event& event)
+{
+    // Watching event queues from event queues could create reference cycles, so we don't allow it.
+    if (description.file().is_event_queue())
+        return KResult(-EINVAL);
+
+    auto it = m_entries.find(fd);
+    if (it != m_entries.end()) {
+        if (it->value->description)
+            return KResult(-EEXIST);
+        // The fd was closed and has been reused for something else since.
+        m_entries.remove(it);
+    }
+
+    auto entry = make<Entry>(*this, fd, description, event);
+    auto& entry_ref = *entry;
+    m_entries.set(fd, move(entry));
+
+    // New entries are checked on the next wait, since we can't know whether they're already ready.
+    InterruptDisabler disabler;
+    enqueue(entry_ref);
+    evaluate_block_conditions();
+    return KSuccess;
+}
+
+KResult EventQueue::modify(int fd, const epoll_event& event)
+{
+    auto it = m_entries.find(fd);
+    if (it == m_entries.end() || !it->value->description)
+        return KResult(-ENOENT);
+
+    InterruptDisabler disabler;
+    auto& entry = *it->value;
+    entry.event = event;
+    enqueue(entry);
+    evaluate_block_conditions();
+    return KSuccess;
+}
+
+KResult EventQueue::remove(int fd)
+{
+    auto it = m_entries.find(fd);
+    if (it == m_entries.end())
+        return KResult(-ENOENT);
+    m_entries.remove(it);
+    return KSuccess;
+}
+
+bool EventQueue::can_read(const FileDescription&, size_t) const
+{
+    InterruptDisabler disabler;
+    for (auto* entry = m_ready_entries.head(); entry; entry = entry->next()) {
+        if (entry->ready_events())
+            return true;
+    }
+    return false;
+}
+
+void EventQueue::collect_ready_events(Vector<epoll_event, 32>& events, size_t max_events)
+{
+    // Reserve up front, we don't want to allocate with interrupts disabled.
+    events.clear();
+    events.ensure_capacity(max_events);
+
+    InterruptDisabler disabler;
+    InlineLinkedList<Entry> still_queued;
+    while (events.size() < max_events) {
+        auto* entry = m_ready_entries.remove_head();
+        if (!entry)
+            break;
+        entry->is_queued = false;
+
+        if (!entry->description) {
+            // FIXME: Entries whose description went away but whose File never fires again
+            //        linger until their fd is reused, removed, or the queue is destroyed.
+            m_entries.remove(entry->fd);
+            continue;
+        }
+
+        u32 ready = entry->ready_events();
+        bool keep_queued = entry->needs_polling;
+        if (ready) {
+            events.unchecked_append({ ready, entry->event.data });
+            if (entry->event.events & EPOLLONESHOT) {
+                entry->event.events &= EPOLLONESHOT | EPOLLET;
+                keep_queued = false;
+            } else if (!(entry->event.events & EPOLLET)) {
+                keep_queued = true;
+            }
+        }
+
+        if (keep_queued && (entry->event.events & (EPOLLIN | EPOLLOUT))) {
+            entry->is_queued = true;
+            still_queued.append(entry);
+        }
+    }
+    m_ready_entries.append(still_queued);
+}
+
+}
@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2018-2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/HashMap.h>
+#include <AK/InlineLinkedList.h>
+#include <AK/NonnullOwnPtr.h>
+#include <AK/Vector.h>
+#include <AK/WeakPtr.h>
+#include <Kernel/BlockCondition.h>
+#include <Kernel/FileSystem/File.h>
+#include <Kernel/UnixTypes.h>
+
+namespace Kernel {
+
+// An EventQueue is a persistent set of file descriptions that a process wants readiness
+// events for, backing the epoll_*() syscalls. Unlike select() and poll(), it doesn't rescan
+// every fd on each wakeup: each entry observes the block condition of its File, and only
+// entries that have fired since the last wait get their can_read()/can_write() re-checked.
+//
+// Level-triggered entries that are still ready stay queued, so they are reported again.
+// EPOLLET entries are reported once per block condition firing, and EPOLLONESHOT entries
+// are disarmed after being reported until they are modified again.
+class EventQueue final : public File {
+public:
+    static NonnullRefPtr<EventQueue> create();
+    virtual ~EventQueue() override;
+
+    KResult add(int fd, FileDescription&, const epoll_event&);
+    KResult modify(int fd, const epoll_event&);
+    KResult remove(int fd);
+
+    void collect_ready_events(Vector<epoll_event, 32>&, size_t max_events);
+
+    virtual bool can_read(const FileDescription&, size_t) const override;
+    virtual bool can_write(const FileDescription&, size_t) const override { return false; }
+    virtual ssize_t read(FileDescription&, size_t, u8*, ssize_t) override { return -EINVAL; }
+    virtual ssize_t write(FileDescription&, size_t, const u8*, ssize_t) override { return -EINVAL; }
+    virtual String absolute_path(const FileDescription&) const override { return "event-queue"; }
+    virtual const char* class_name() const override { return "EventQueue"; }
+    virtual bool is_event_queue() const override { return true; }
+    virtual bool readiness_needs_polling() const override { return m_polled_entry_count; }
+
+private:
+    class Entry final : public BlockConditionObserver
+        , public InlineLinkedListNode<Entry> {
+    public:
+        Entry(EventQueue&, int fd, FileDescription&, const epoll_event&);
+        virtual ~Entry() override;
+
+        virtual void block_condition_did_fire() override;
+
+        u32 ready_events() const;
+
+        EventQueue& queue;
+        int fd { -1 };
+        WeakPtr<FileDescription> description;
+        NonnullRefPtr<File> file;
+        epoll_event event;
+        bool needs_polling { false };
+        bool is_queued { false };
+        u32 reported_in_pass { 0 };
+
+        Entry* m_next { nullptr };
+        Entry* m_prev { nullptr };
+    };
+
+    EventQueue();
+
+    void enqueue(Entry&);
+    void dequeue(Entry&);
+
+    HashMap<int, NonnullOwnPtr<Entry>> m_entries;
+    InlineLinkedList<Entry> m_ready_entries;
+    size_t m_polled_entry_count { 0 };
+    u32 m_pass { 0 };
+};
+
+}
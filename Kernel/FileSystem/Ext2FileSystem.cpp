@@ -27,6 +27,7 @@
 #include <AK/Bitmap.h>
 #include <AK/BufferStream.h>
 #include <AK/HashMap.h>
+#include <AK/QuickSort.h>
 #include <AK/StdLibExtras.h>
 #include <AK/StringView.h>
 #include <Kernel/Devices/BlockDevice.h>
@@ -41,6 +42,8 @@
 
 namespace Kernel {
 
+DEFINE_OBJECT_CACHE(Ext2FSInode);
+
 static const size_t max_link_count = 65535;
 static const size_t max_block_size = 4096;
 static const ssize_t max_inline_symlink_length = 60;
@@ -64,6 +67,227 @@ static u8 to_ext2_file_type(mode_t mode)
     return EXT2_FT_UNKNOWN;
 }
 
+// Offsets of the dx_root_info in the first block of an indexed directory (right after the "." and ".." records),
+// and of the count/limit header in an index node (right after its empty covering record).
+static const size_t dx_root_info_offset = 24;
+static const size_t dx_node_entries_offset = 8;
+
+struct HashedDirectoryEntry {
+    u32 hash { 0 };
+    unsigned inode { 0 };
+    u8 file_type { 0 };
+    String name;
+};
+
+static ext2_dir_entry_2* find_entry_in_block(ByteBuffer& block, const StringView& name, ext2_dir_entry_2** previous = nullptr)
+{
+    ext2_dir_entry_2* previous_entry = nullptr;
+    size_t offset = 0;
+    while (offset + 8 <= block.size()) {
+        auto* entry = reinterpret_cast<ext2_dir_entry_2*>(block.data() + offset);
+        if (entry->rec_len < 8 || offset + entry->rec_len > block.size())
+            break;
+        if (entry->inode != 0 && name == StringView(entry->name, entry->name_len)) {
+            if (previous)
+                *previous = previous_entry;
+            return entry;
+        }
+        previous_entry = entry;
+        offset += entry->rec_len;
+    }
+    return nullptr;
+}
+
+static bool insert_entry_into_block(ByteBuffer& block, const StringView& name, unsigned inode, u8 file_type)
+{
+    size_t needed_length = EXT2_DIR_REC_LEN(name.length());
+    size_t offset = 0;
+    while (offset + 8 <= block.size()) {
+        auto* entry = reinterpret_cast<ext2_dir_entry_2*>(block.data() + offset);
+        if (entry->rec_len < 8 || offset + entry->rec_len > block.size())
+            return false;
+        size_t used_length = entry->inode ? EXT2_DIR_REC_LEN(entry->name_len) : 0;
+        if (entry->rec_len < used_length + needed_length) {
+            offset += entry->rec_len;
+            continue;
+        }
+        // Split the slack off the end of this record.
+        if (used_length) {
+            auto* new_entry = reinterpret_cast<ext2_dir_entry_2*>((u8*)entry + used_length);
+            new_entry->rec_len = entry->rec_len - used_length;
+            entry->rec_len = used_length;
+            entry = new_entry;
+        }
+        entry->inode = inode;
+        entry->name_len = name.length();
+        entry->file_type = file_type;
+        memcpy(entry->name, name.characters_without_null_termination(), name.length());
+        memset(entry->name + name.length(), 0, needed_length - 8 - name.length());
+        return true;
+    }
+    return false;
+}
+
+static void collect_hashed_entries(const Ext2FS& fs, ByteBuffer& block, size_t offset, u8 hash_version, Vector<HashedDirectoryEntry>& entries)
+{
+    while (offset + 8 <= block.size()) {
+        auto* entry = reinterpret_cast<const ext2_dir_entry_2*>(block.data() + offset);
+        if (entry->rec_len < 8 || offset + entry->rec_len > block.size())
+            break;
+        if (entry->inode != 0) {
+            StringView name { entry->name, entry->name_len };
+            entries.append({ fs.directory_hash(name, hash_version), entry->inode, entry->file_type, name });
+        }
+        offset += entry->rec_len;
+    }
+    quick_sort(entries, [](auto& a, auto& b) { return a.hash < b.hash; });
+}
+
+static void write_entries_to_block(ByteBuffer& block, const Vector<HashedDirectoryEntry>& entries, size_t start, size_t end)
+{
+    memset(block.data(), 0, block.size());
+    if (start == end) {
+        reinterpret_cast<ext2_dir_entry_2*>(block.data())->rec_len = block.size();
+        return;
+    }
+    size_t offset = 0;
+    for (size_t i = start; i < end; ++i) {
+        auto& entry = entries[i];
+        auto* record = reinterpret_cast<ext2_dir_entry_2*>(block.data() + offset);
+        size_t record_length = EXT2_DIR_REC_LEN(entry.name.length());
+        if (i == end - 1)
+            record_length = block.size() - offset;
+        record->inode = entry.inode;
+        record->rec_len = record_length;
+        record->name_len = entry.name.length();
+        record->file_type = entry.file_type;
+        memcpy(record->name, entry.name.characters(), entry.name.length());
+        offset += record_length;
+    }
+}
+
+// Pick a split point close to the middle that doesn't separate names with the same hash.
+static Optional<size_t> find_split_point(const Vector<HashedDirectoryEntry>& sorted_entries)
+{
+    size_t count = sorted_entries.size();
+    for (size_t distance = 0; distance <= count / 2; ++distance) {
+        size_t above = count / 2 + distance;
+        if (above > 0 && above < count && sorted_entries[above - 1].hash != sorted_entries[above].hash)
+            return above;
+        size_t below = count / 2 - distance;
+        if (below > 0 && below < count && sorted_entries[below - 1].hash != sorted_entries[below].hash)
+            return below;
+    }
+    return {};
+}
+
+static inline int hash_character(u8 character, bool is_unsigned)
+{
+    return is_unsigned ? (int)character : (int)(signed char)character;
+}
+
+static u32 dx_legacy_hash(const u8* name, size_t length, bool is_unsigned)
+{
+    u32 hash0 = 0x12a3fe2d;
+    u32 hash1 = 0x37abe8f9;
+    for (size_t i = 0; i < length; ++i) {
+        u32 hash = hash1 + (hash0 ^ (u32)(hash_character(name[i], is_unsigned) * 7152373));
+        if (hash & 0x80000000)
+            hash -= 0x7fffffff;
+        hash1 = hash0;
+        hash0 = hash;
+    }
+    return hash0 << 1;
+}
+
+static void dx_string_to_hash_buffer(const u8* name, size_t length, u32* buffer, int count, bool is_unsigned)
+{
+    u32 pad = (u32)length | ((u32)length << 8);
+    pad |= pad << 16;
+
+    u32 value = pad;
+    if (length > (size_t)count * 4)
+        length = count * 4;
+    for (size_t i = 0; i < length; ++i) {
+        value = hash_character(name[i], is_unsigned) + (value << 8);
+        if ((i % 4) == 3) {
+            *buffer++ = value;
+            value = pad;
+            --count;
+        }
+    }
+    if (--count >= 0)
+        *buffer++ = value;
+    while (--count >= 0)
+        *buffer++ = pad;
+}
+
+static inline u32 rotate_left(u32 value, unsigned shift)
+{
+    return (value << shift) | (value >> (32 - shift));
+}
+
+static void dx_half_md4_transform(u32 buffer[4], const u32 input[8])
+{
+    u32 a = buffer[0], b = buffer[1], c = buffer[2], d = buffer[3];
+
+    auto f = [](u32 x, u32 y, u32 z) { return z ^ (x & (y ^ z)); };
+    auto g = [](u32 x, u32 y, u32 z) { return (x & y) + ((x ^ y) & z); };
+    auto h = [](u32 x, u32 y, u32 z) { return x ^ y ^ z; };
+    auto round = [](auto function, u32& a, u32 b, u32 c, u32 d, u32 x, unsigned shift) {
+        a = rotate_left(a + function(b, c, d) + x, shift);
+    };
+
+    const u32 k2 = 013240474631;
+    const u32 k3 = 015666365641;
+
+    round(f, a, b, c, d, input[0], 3);
+    round(f, d, a, b, c, input[1], 7);
+    round(f, c, d, a, b, input[2], 11);
+    round(f, b, c, d, a, input[3], 19);
+    round(f, a, b, c, d, input[4], 3);
+    round(f, d, a, b, c, input[5], 7);
+    round(f, c, d, a, b, input[6], 11);
+    round(f, b, c, d, a, input[7], 19);
+
+    round(g, a, b, c, d, input[1] + k2, 3);
+    round(g, d, a, b, c, input[3] + k2, 5);
+    round(g, c, d, a, b, input[5] + k2, 9);
+    round(g, b, c, d, a, input[7] + k2, 13);
+    round(g, a, b, c, d, input[0] + k2, 3);
+    round(g, d, a, b, c, input[2] + k2, 5);
+    round(g, c, d, a, b, input[4] + k2, 9);
+    round(g, b, c, d, a, input[6] + k2, 13);
+
+    round(h, a, b, c, d, input[3] + k3, 3);
+    round(h, d, a, b, c, input[7] + k3, 9);
+    round(h, c, d, a, b, input[2] + k3, 11);
+    round(h, b, c, d, a, input[6] + k3, 15);
+    round(h, a, b, c, d, input[1] + k3, 3);
+    round(h, d, a, b, c, input[5] + k3, 9);
+    round(h, c, d, a, b, input[0] + k3, 11);
+    round(h, b, c, d, a, input[4] + k3, 15);
+
+    buffer[0] += a;
+    buffer[1] += b;
+    buffer[2] += c;
+    buffer[3] += d;
+}
+
+static void dx_tea_transform(u32 buffer[4], const u32 input[4])
+{
+    u32 sum = 0;
+    u32 b0 = buffer[0], b1 = buffer[1];
+    u32 a = input[0], b = input[1], c = input[2], d = input[3];
+    for (int n = 0; n < 16; ++n) {
+        sum += 0x9e3779b9;
+        b0 += ((b1 << 4) + a) ^ (b1 + sum) ^ ((b1 >> 5) + b);
+        b1 += ((b0 << 4) + c) ^ (b0 + sum) ^ ((b0 >> 5) + d);
+    }
+    buffer[0] += b0;
+    buffer[1] += b1;
+}
+
 NonnullRefPtr<Ext2FS> Ext2FS::create(FileDescription& file_description)
 {
     return adopt(*new Ext2FS(file_description));
@@ -327,8 +551,17 @@ bool Ext2FS::write_block_list_for_inode(InodeIndex inode_index, ext2_inode& e2in
         }
         auto* dind_block_as_pointers = (unsigned*)dind_block_contents.data();
 
+        // Indirect blocks that were full before and still are don't change when the list only grows or shrinks at the end.
+        unsigned unchanged_entries = dind_block_new ? 0 : min(old_shape.doubly_indirect_blocks, new_shape.doubly_indirect_blocks);
+
         ASSERT(indirect_block_count <= entries_per_block);
         for (unsigned i = 0; i < indirect_block_count; ++i) {
+            if ((i + 1) * entries_per_block <= unchanged_entries && dind_block_as_pointers[i]) {
+                output_block_index += entries_per_block;
+                remaining_blocks -= entries_per_block;
+                continue;
+            }
+
             bool ind_block_dirty = false;
 
             BlockIndex indirect_block_index = dind_block_as_pointers[i];
@@ -501,6 +734,7 @@ void Ext2FS::free_inode(Ext2FSInode& inode)
     inode.m_raw_inode.i_dtime = now.tv_sec;
     write_ext2_inode(inode.index(), inode.m_raw_inode);
 
+    inode.discard_preallocated_blocks();
     auto block_list = block_list_for_inode(inode.m_raw_inode, true);
 
     for (auto block_index : block_list) {
@@ -556,16 +790,24 @@ void Ext2FS::flush_writes()
     // FIXME: It would be better to keep a capped number of Inodes around.
     //        The problem is that they are quite heavy objects, and use a lot of heap memory
     //        for their (child name lookup) and (block list) caches.
+    // An inode whose page cache still holds some of its contents is worth keeping, though.
     Vector<InodeIndex> unused_inodes;
     for (auto& it : m_inode_cache) {
-        if (it.value->ref_count() != 1)
+        int page_cache_ref_count = it.value->page_cache_ref_count();
+        if (it.value->ref_count() != 1 + page_cache_ref_count)
+            continue;
+        if (page_cache_ref_count && it.value->page_cache_resident_size())
             continue;
         if (it.value->has_watchers())
             continue;
         unused_inodes.append(it.key);
     }
-    for (auto index : unused_inodes)
+    for (auto index : unused_inodes) {
+        auto it = m_inode_cache.find(index);
+        if (it != m_inode_cache.end() && it->value)
+            it->value->release_page_cache();
         uncache_inode(index);
+    }
 }
 
 Ext2FSInode::Ext2FSInode(Ext2FS& fs, unsigned index)
@@ -613,13 +855,6 @@ void Ext2FSInode::flush_metadata()
     dbg() << "Ext2FS: flush_metadata for inode " << identifier();
 #endif
     fs().write_ext2_inode(index(), m_raw_inode);
-    if (is_directory()) {
-        // Unless we're about to go away permanently, invalidate the lookup cache.
-        if (m_raw_inode.i_links_count != 0) {
-            // FIXME: This invalidation is way too hardcore. It's sad to throw away the whole cache.
-            m_lookup_cache.clear();
-        }
-    }
     set_metadata_dirty(false);
 }
 
@@ -676,7 +911,8 @@ ssize_t Ext2FSInode::read_bytes(off_t offset, ssize_t count, u8* buffer, FileDes
         return -EIO;
     }
 
-    bool allow_cache = !description || !description->is_direct();
+    // The contents of regular files are cached in their pages, so there's no point in keeping the blocks around too.
+    bool allow_cache = !is_page_cacheable() && (!description || !description->is_direct());
 
     const int block_size = fs().block_size();
 
@@ -700,6 +936,27 @@ ssize_t Ext2FSInode::read_bytes(off_t offset, ssize_t count, u8* buffer, FileDes
         ASSERT(block_index);
         size_t offset_into_block = (bi == first_block_logical_index) ? offset_into_first_block : 0;
         size_t num_bytes_to_copy = min(block_size - offset_into_block, remaining_count);
+
+        if (!allow_cache && offset_into_block == 0 && num_bytes_to_copy == (size_t)block_size) {
+            // Uncached reads of whole blocks that are next to each other on disk go out as one request.
+            size_t run_length = 1;
+            while (bi + run_length <= last_block_logical_index
+                && remaining_count >= (run_length + 1) * block_size
+                && m_block_list[bi + run_length] == block_index + run_length)
+                ++run_length;
+            if (run_length > 1) {
+                if (!fs().read_blocks(block_index, run_length, out, false)) {
+                    klog() << "ext2fs: read_bytes: read_blocks(" << block_index << " x" << run_length << ") failed (lbi: " << bi << ")";
+                    return -EIO;
+                }
+                bi += run_length - 1;
+                remaining_count -= run_length * block_size;
+                nread += run_length * block_size;
+                out += run_length * block_size;
+                continue;
+            }
+        }
+
         bool success = fs().read_block(block_index, out, num_bytes_to_copy, offset_into_block, allow_cache);
         if (!success) {
             klog() << "ext2fs: read_bytes: read_block(" << block_index << ") failed (lbi: " << bi << ")";
@@ -713,6 +970,14 @@ ssize_t Ext2FSInode::read_bytes(off_t offset, ssize_t count, u8* buffer, FileDes
     return nread;
 }
 
+void Ext2FSInode::discard_preallocated_blocks()
+{
+    LOCKER(fs().m_lock);
+    for (auto block_index : m_preallocated_blocks)
+        fs().set_block_allocation_state(block_index, false);
+    m_preallocated_blocks.clear();
+}
+
 KResult Ext2FSInode::resize(u64 new_size)
 {
     u64 old_size = size();
@@ -730,36 +995,62 @@ KResult Ext2FSInode::resize(u64 new_size)
 
     if (blocks_needed_after > blocks_needed_before) {
         u32 additional_blocks_needed = blocks_needed_after - blocks_needed_before;
-        if (additional_blocks_needed > fs().super_block().s_free_blocks_count)
+        if (additional_blocks_needed > fs().super_block().s_free_blocks_count + m_preallocated_blocks.size())
             return KResult(-ENOSPC);
     }
 
-    auto block_list = fs().block_list_for_inode(m_raw_inode);
+    // The block list is kept up to date across resizes, so we only have to walk the indirect blocks once.
+    if (m_block_list.is_empty())
+        m_block_list = fs().block_list_for_inode(m_raw_inode);
+
     if (blocks_needed_after > blocks_needed_before) {
-        auto new_blocks = fs().allocate_blocks(fs().group_index_from_inode(index()), blocks_needed_after - blocks_needed_before);
-        block_list.append(move(new_blocks));
+        size_t additional_blocks_needed = blocks_needed_after - blocks_needed_before;
+        while (additional_blocks_needed && !m_preallocated_blocks.is_empty()) {
+            m_block_list.append(m_preallocated_blocks.take_first());
+            --additional_blocks_needed;
+        }
+
+        if (additional_blocks_needed) {
+            // A file that grows is likely to keep growing, so grab a few more blocks right after the new ones
+            // while they're still free. We leave enough for the block list itself to grow.
+            size_t blocks_to_preallocate = 0;
+            size_t entries_per_block = EXT2_ADDR_PER_BLOCK(&fs().super_block());
+            size_t max_block_count = EXT2_NDIR_BLOCKS + entries_per_block + entries_per_block * entries_per_block;
+            if (is_page_cacheable() && blocks_needed_after + preallocation_block_count <= max_block_count) {
+                auto old_shape = fs().compute_block_list_shape(blocks_needed_before);
+                auto new_shape = fs().compute_block_list_shape(blocks_needed_after + preallocation_block_count);
+                size_t reserve = additional_blocks_needed + (new_shape.meta_blocks - old_shape.meta_blocks);
+                if (fs().super_block().s_free_blocks_count > reserve + preallocation_block_count)
+                    blocks_to_preallocate = preallocation_block_count;
+            }
+            unsigned goal = m_block_list.is_empty() ? 0 : m_block_list.last() + 1;
+            auto new_blocks = fs().allocate_blocks(fs().group_index_from_inode(index()), additional_blocks_needed + blocks_to_preallocate, goal);
+            for (size_t i = 0; i < additional_blocks_needed; ++i)
+                m_block_list.append(new_blocks[i]);
+            for (size_t i = additional_blocks_needed; i < new_blocks.size(); ++i)
+                m_preallocated_blocks.append(new_blocks[i]);
+        }
     } else if (blocks_needed_after < blocks_needed_before) {
 #ifdef EXT2_DEBUG
-        dbg() << "Ext2FS: Shrinking inode " << identifier() << ". Old block list is " << block_list.size() << " entries:";
-        for (auto block_index : block_list) {
+        dbg() << "Ext2FS: Shrinking inode " << identifier() << ". Old block list is " << m_block_list.size() << " entries:";
+        for (auto block_index : m_block_list) {
             dbg() << "    # " << block_index;
         }
 #endif
-        while (block_list.size() != blocks_needed_after) {
-            auto block_index = block_list.take_last();
+        discard_preallocated_blocks();
+        while (m_block_list.size() > blocks_needed_after) {
+            auto block_index = m_block_list.take_last();
             if (block_index)
                 fs().set_block_allocation_state(block_index, false);
         }
     }
 
-    bool success = fs().write_block_list_for_inode(index(), m_raw_inode, block_list);
+    bool success = fs().write_block_list_for_inode(index(), m_raw_inode, m_block_list);
     if (!success)
         return KResult(-EIO);
 
     m_raw_inode.i_size = new_size;
     set_metadata_dirty(true);
-
-    m_block_list = move(block_list);
     return KSuccess;
 }
 
@@ -935,6 +1226,357 @@ bool Ext2FSInode::write_directory(const Vector<FS::DirectoryEntry>& entries)
     return static_cast<size_t>(nwritten) == directory_data.size();
 }
 
+bool Ext2FSInode::read_directory_block(unsigned index, ByteBuffer& buffer) const
+{
+    size_t block_size = fs().block_size();
+    ASSERT(buffer.size() == block_size);
+    return read_bytes(index * block_size, block_size, buffer.data(), nullptr) == static_cast<ssize_t>(block_size);
+}
+
+bool Ext2FSInode::write_directory_block(unsigned index, const ByteBuffer& buffer)
+{
+    size_t block_size = fs().block_size();
+    ASSERT(buffer.size() == block_size);
+    return write_bytes(index * block_size, block_size, buffer.data(), nullptr) == static_cast<ssize_t>(block_size);
+}
+
+Optional<unsigned> Ext2FSInode::find_linear_entry_block(const StringView& name, ByteBuffer& block) const
+{
+    unsigned block_count = size() / fs().block_size();
+    for (unsigned i = 0; i < block_count; ++i) {
+        if (!read_directory_block(i, block))
+            return {};
+        if (find_entry_in_block(block, name))
+            return i;
+    }
+    return {};
+}
+
+bool Ext2FSInode::add_linear_entry(const StringView& name, unsigned inode, u8 file_type)
+{
+    size_t block_size = fs().block_size();
+    unsigned block_count = size() / block_size;
+    auto block = ByteBuffer::create_uninitialized(block_size);
+
+    // Try the block we last removed something from and the last block before growing the directory.
+    Vector<unsigned, 2> candidate_blocks;
+    if (m_directory_block_with_room.has_value() && m_directory_block_with_room.value() < block_count)
+        candidate_blocks.append(m_directory_block_with_room.value());
+    if (block_count && (candidate_blocks.is_empty() || candidate_blocks[0] != block_count - 1))
+        candidate_blocks.append(block_count - 1);
+
+    for (auto block_index : candidate_blocks) {
+        if (!read_directory_block(block_index, block))
+            return false;
+        if (insert_entry_into_block(block, name, inode, file_type))
+            return write_directory_block(block_index, block);
+    }
+    m_directory_block_with_room = {};
+
+    // A directory outgrowing its first block gets an index, like it would on Linux.
+    if (block_count == 1 && !(m_raw_inode.i_flags & EXT2_INDEX_FL) && fs().has_directory_index() && make_indexed_directory()) {
+        DirectoryIndexLookup index_lookup;
+        if (find_indexed_leaf(name, index_lookup))
+            return add_indexed_entry(name, inode, file_type, index_lookup);
+        drop_directory_index();
+        block_count = size() / block_size;
+    }
+
+    memset(block.data(), 0, block_size);
+    reinterpret_cast<ext2_dir_entry_2*>(block.data())->rec_len = block_size;
+    insert_entry_into_block(block, name, inode, file_type);
+    return write_directory_block(block_count, block);
+}
+
+bool Ext2FSInode::is_indexed_directory() const
+{
+    return (m_raw_inode.i_flags & EXT2_INDEX_FL) && fs().has_directory_index();
+}
+
+bool Ext2FSInode::find_indexed_leaf(const StringView& name, DirectoryIndexLookup& lookup) const
+{
+    size_t block_size = fs().block_size();
+    unsigned block_count = size() / block_size;
+    auto block = ByteBuffer::create_uninitialized(block_size);
+    if (block_count < 2 || !read_directory_block(0, block))
+        return false;
+
+    auto& root_info = *reinterpret_cast<const ext2_dx_root_info*>(block.data() + dx_root_info_offset);
+    if (root_info.reserved_zero != 0 || root_info.hash_version > EXT2_HASH_TEA || root_info.indirect_levels > 1)
+        return false;
+
+    lookup.hash_version = root_info.hash_version;
+    lookup.hash = fs().directory_hash(name, root_info.hash_version);
+    lookup.path.clear();
+
+    unsigned levels = root_info.indirect_levels;
+    unsigned block_index = 0;
+    unsigned entries_offset = dx_root_info_offset + root_info.info_length;
+    for (;;) {
+        if (entries_offset + sizeof(ext2_dx_countlimit) > block_size)
+            return false;
+        auto& count_limit = *reinterpret_cast<const ext2_dx_countlimit*>(block.data() + entries_offset);
+        auto* entries = reinterpret_cast<const ext2_dx_entry*>(block.data() + entries_offset);
+        if (count_limit.count == 0 || count_limit.count > count_limit.limit || entries_offset + count_limit.limit * sizeof(ext2_dx_entry) > block_size)
+            return false;
+
+        // Entry 0 covers every hash below that of entry 1, and has its count/limit where the hash would be.
+        unsigned low = 1;
+        unsigned high = count_limit.count;
+        while (low < high) {
+            unsigned middle = (low + high) / 2;
+            if (entries[middle].hash > lookup.hash)
+                high = middle;
+            else
+                low = middle + 1;
+        }
+        unsigned position = low - 1;
+        lookup.path.append({ block_index, entries_offset, position });
+
+        unsigned next_block = entries[position].block & 0x0fffffff;
+        if (next_block == 0 || next_block >= block_count)
+            return false;
+        if (levels-- == 0) {
+            lookup.leaf_block = next_block;
+            return true;
+        }
+        if (!read_directory_block(next_block, block))
+            return false;
+        block_index = next_block;
+        entries_offset = dx_node_entries_offset;
+    }
+}
+
+Optional<unsigned> Ext2FSInode::find_indexed_entry_block(const StringView& name, const DirectoryIndexLookup& lookup, ByteBuffer& block) const
+{
+    if (!read_directory_block(lookup.leaf_block, block))
+        return {};
+    if (find_entry_in_block(block, name))
+        return lookup.leaf_block;
+
+    // Names with colliding hashes may continue into the following leaves, whose index
+    // entries are then marked with the low hash bit.
+    auto& frame = lookup.path.last();
+    auto node = ByteBuffer::create_uninitialized(fs().block_size());
+    if (!read_directory_block(frame.block_index, node))
+        return {};
+    auto& count_limit = *reinterpret_cast<const ext2_dx_countlimit*>(node.data() + frame.entries_offset);
+    auto* entries = reinterpret_cast<const ext2_dx_entry*>(node.data() + frame.entries_offset);
+    for (unsigned i = frame.position + 1; i < count_limit.count; ++i) {
+        if (!(entries[i].hash & 1) || (entries[i].hash & ~1u) != lookup.hash)
+            break;
+        unsigned block_index = entries[i].block & 0x0fffffff;
+        if (!read_directory_block(block_index, block))
+            return {};
+        if (find_entry_in_block(block, name))
+            return block_index;
+    }
+    return {};
+}
+
+bool Ext2FSInode::add_indexed_entry(const StringView& name, unsigned inode, u8 file_type, DirectoryIndexLookup& lookup)
+{
+    auto leaf = ByteBuffer::create_uninitialized(fs().block_size());
+    if (!read_directory_block(lookup.leaf_block, leaf))
+        return false;
+    if (insert_entry_into_block(leaf, name, inode, file_type))
+        return write_directory_block(lookup.leaf_block, leaf);
+
+    if (split_indexed_leaf(lookup)) {
+        if (!read_directory_block(lookup.leaf_block, leaf))
+            return false;
+        if (insert_entry_into_block(leaf, name, inode, file_type))
+            return write_directory_block(lookup.leaf_block, leaf);
+    }
+
+    dbg() << "Ext2FSInode::add_indexed_entry(): Index of directory " << index() << " can't grow any further, dropping it";
+    drop_directory_index();
+    return add_linear_entry(name, inode, file_type);
+}
+
+bool Ext2FSInode::make_room_in_index(DirectoryIndexLookup& lookup)
+{
+    size_t block_size = fs().block_size();
+    auto& frame = lookup.path.last();
+    auto block = ByteBuffer::create_uninitialized(block_size);
+    if (!read_directory_block(frame.block_index, block))
+        return false;
+    auto& count_limit = *reinterpret_cast<ext2_dx_countlimit*>(block.data() + frame.entries_offset);
+    auto* entries = reinterpret_cast<ext2_dx_entry*>(block.data() + frame.entries_offset);
+    if (count_limit.count < count_limit.limit)
+        return true;
+
+    unsigned new_block_index = size() / block_size;
+    auto new_node = ByteBuffer::create_zeroed(block_size);
+    reinterpret_cast<ext2_dir_entry_2*>(new_node.data())->rec_len = block_size;
+    auto& new_count_limit = *reinterpret_cast<ext2_dx_countlimit*>(new_node.data() + dx_node_entries_offset);
+    auto* new_entries = reinterpret_cast<ext2_dx_entry*>(new_node.data() + dx_node_entries_offset);
+    new_count_limit.limit = (block_size - dx_node_entries_offset) / sizeof(ext2_dx_entry);
+
+    if (lookup.path.size() == 1) {
+        // The root is full: move all of its entries into a new node below it.
+        unsigned count = count_limit.count;
+        new_entries[0].block = entries[0].block;
+        for (unsigned i = 1; i < count; ++i)
+            new_entries[i] = entries[i];
+        new_count_limit.count = count;
+        if (!write_directory_block(new_block_index, new_node))
+            return false;
+
+        count_limit.count = 1;
+        entries[0].block = new_block_index;
+        reinterpret_cast<ext2_dx_root_info*>(block.data() + dx_root_info_offset)->indirect_levels = 1;
+        if (!write_directory_block(0, block))
+            return false;
+
+        unsigned position = frame.position;
+        lookup.path[0].position = 0;
+        lookup.path.append({ new_block_index, (unsigned)dx_node_entries_offset, position });
+        return true;
+    }
+
+    // A full node below the root gets split in two, which needs room in the root.
+    auto& root_frame = lookup.path[0];
+    auto root = ByteBuffer::create_uninitialized(block_size);
+    if (!read_directory_block(0, root))
+        return false;
+    auto& root_count_limit = *reinterpret_cast<ext2_dx_countlimit*>(root.data() + root_frame.entries_offset);
+    auto* root_entries = reinterpret_cast<ext2_dx_entry*>(root.data() + root_frame.entries_offset);
+    if (root_count_limit.count >= root_count_limit.limit)
+        return false;
+
+    unsigned count = count_limit.count;
+    unsigned split = count / 2;
+    u32 split_hash = entries[split].hash;
+    new_entries[0].block = entries[split].block;
+    for (unsigned i = split + 1; i < count; ++i)
+        new_entries[i - split] = entries[i];
+    new_count_limit.count = count - split;
+    if (!write_directory_block(new_block_index, new_node))
+        return false;
+
+    count_limit.count = split;
+    if (!write_directory_block(frame.block_index, block))
+        return false;
+
+    for (unsigned i = root_count_limit.count; i > root_frame.position + 1; --i)
+        root_entries[i] = root_entries[i - 1];
+    root_entries[root_frame.position + 1] = { split_hash, new_block_index };
+    ++root_count_limit.count;
+    if (!write_directory_block(0, root))
+        return false;
+
+    if (frame.position >= split) {
+        frame.block_index = new_block_index;
+        frame.position -= split;
+        ++root_frame.position;
+    }
+    return true;
+}
+
+bool Ext2FSInode::split_indexed_leaf(DirectoryIndexLookup& lookup)
+{
+    if (!make_room_in_index(lookup))
+        return false;
+
+    size_t block_size = fs().block_size();
+    auto leaf = ByteBuffer::create_uninitialized(block_size);
+    if (!read_directory_block(lookup.leaf_block, leaf))
+        return false;
+    Vector<HashedDirectoryEntry> entries;
+    collect_hashed_entries(fs(), leaf, 0, lookup.hash_version, entries);
+    auto split = find_split_point(entries);
+    if (!split.has_value())
+        return false;
+    u32 split_hash = entries[split.value()].hash;
+
+    unsigned new_block_index = size() / block_size;
+    auto new_leaf = ByteBuffer::create_uninitialized(block_size);
+    write_entries_to_block(new_leaf, entries, split.value(), entries.size());
+    if (!write_directory_block(new_block_index, new_leaf))
+        return false;
+    write_entries_to_block(leaf, entries, 0, split.value());
+    if (!write_directory_block(lookup.leaf_block, leaf))
+        return false;
+
+    auto& frame = lookup.path.last();
+    auto node = ByteBuffer::create_uninitialized(block_size);
+    if (!read_directory_block(frame.block_index, node))
+        return false;
+    auto& count_limit = *reinterpret_cast<ext2_dx_countlimit*>(node.data() + frame.entries_offset);
+    auto* dx_entries = reinterpret_cast<ext2_dx_entry*>(node.data() + frame.entries_offset);
+    for (unsigned i = count_limit.count; i > frame.position + 1; --i)
+        dx_entries[i] = dx_entries[i - 1];
+    dx_entries[frame.position + 1] = { split_hash, new_block_index };
+    ++count_limit.count;
+    if (!write_directory_block(frame.block_index, node))
+        return false;
+
+    if (lookup.hash >= split_hash) {
+        lookup.leaf_block = new_block_index;
+        ++frame.position;
+    }
+    return true;
+}
+
+bool Ext2FSInode::make_indexed_directory()
+{
+    size_t block_size = fs().block_size();
+    u8 hash_version = fs().super_block().s_def_hash_version;
+    if (size() != block_size || hash_version > EXT2_HASH_TEA)
+        return false;
+
+    auto root = ByteBuffer::create_uninitialized(block_size);
+    if (!read_directory_block(0, root))
+        return false;
+    auto* dot = reinterpret_cast<ext2_dir_entry_2*>(root.data());
+    auto* dot_dot = reinterpret_cast<ext2_dir_entry_2*>(root.data() + EXT2_DIR_REC_LEN(1));
+    if (dot->rec_len != EXT2_DIR_REC_LEN(1) || StringView(dot->name, dot->name_len) != "."
+        || dot_dot->rec_len < EXT2_DIR_REC_LEN(2) || StringView(dot_dot->name, dot_dot->name_len) != "..")
+        return false;
+
+    Vector<HashedDirectoryEntry> entries;
+    collect_hashed_entries(fs(), root, EXT2_DIR_REC_LEN(1) + dot_dot->rec_len, hash_version, entries);
+    auto split = find_split_point(entries);
+    if (!split.has_value())
+        return false;
+
+    auto leaf = ByteBuffer::create_uninitialized(block_size);
+    write_entries_to_block(leaf, entries, 0, split.value());
+    if (!write_directory_block(1, leaf))
+        return false;
+    write_entries_to_block(leaf, entries, split.value(), entries.size());
+    if (!write_directory_block(2, leaf))
+        return false;
+
+    // ".." now covers the rest of the first block, with the index root tucked away in its slack.
+    dot_dot->rec_len = block_size - EXT2_DIR_REC_LEN(1);
+    memset(root.data() + dx_root_info_offset, 0, block_size - dx_root_info_offset);
+    auto& root_info = *reinterpret_cast<ext2_dx_root_info*>(root.data() + dx_root_info_offset);
+    root_info.hash_version = hash_version;
+    root_info.info_length = sizeof(ext2_dx_root_info);
+    size_t entries_offset = dx_root_info_offset + sizeof(ext2_dx_root_info);
+    auto& count_limit = *reinterpret_cast<ext2_dx_countlimit*>(root.data() + entries_offset);
+    auto* dx_entries = reinterpret_cast<ext2_dx_entry*>(root.data() + entries_offset);
+    count_limit.limit = (block_size - entries_offset) / sizeof(ext2_dx_entry);
+    count_limit.count = 2;
+    dx_entries[0].block = 1;
+    dx_entries[1] = { entries[split.value()].hash, 2 };
+    if (!write_directory_block(0, root))
+        return false;
+
+    m_raw_inode.i_flags |= EXT2_INDEX_FL;
+    set_metadata_dirty(true);
+    return true;
+}
+
+void Ext2FSInode::drop_directory_index()
+{
+    // The index hides in empty records, so without the flag this is simply a linear directory again.
+    m_raw_inode.i_flags &= ~EXT2_INDEX_FL;
+    set_metadata_dirty(true);
+}
+
 KResult Ext2FSInode::add_child(InodeIdentifier child_id, const StringView& name, mode_t mode)
 {
     LOCKER(m_lock);
@@ -947,19 +1589,21 @@ KResult Ext2FSInode::add_child(InodeIdentifier child_id, const StringView& name,
     dbg() << "Ext2FSInode::add_child(): Adding inode " << child_id.index() << " with name '" << name << "' and mode " << mode << " to directory " << index();
 #endif
 
-    Vector<FS::DirectoryEntry> entries;
-    bool name_already_exists = false;
-    KResult result = traverse_as_directory([&](auto& entry) {
-        if (name == entry.name) {
-            name_already_exists = true;
-            return false;
-        }
-        entries.append(entry);
-        return true;
-    });
+    DirectoryIndexLookup index_lookup;
+    bool use_index = is_indexed_directory() && find_indexed_leaf(name, index_lookup);
+    if (!use_index && (m_raw_inode.i_flags & EXT2_INDEX_FL)) {
+        dbg() << "Ext2FSInode::add_child(): Can't use index of directory " << index() << ", dropping it";
+        drop_directory_index();
+    }
 
-    if (result.is_error())
-        return result;
+    bool name_already_exists;
+    if (use_index) {
+        auto block = ByteBuffer::create_uninitialized(fs().block_size());
+        name_already_exists = find_indexed_entry_block(name, index_lookup, block).has_value();
+    } else {
+        populate_lookup_cache();
+        name_already_exists = m_lookup_cache.find(name) != m_lookup_cache.end();
+    }
 
     if (name_already_exists) {
         dbg() << "Ext2FSInode::add_child(): Name '" << name << "' already exists in inode " << index();
@@ -968,15 +1612,22 @@ KResult Ext2FSInode::add_child(InodeIdentifier child_id, const StringView& name,
 
     auto child_inode = fs().get_inode(child_id);
     if (child_inode) {
-        result = child_inode->increment_link_count();
+        auto result = child_inode->increment_link_count();
         if (result.is_error())
             return result;
     }
 
-    entries.empend(name.characters_without_null_termination(), name.length(), child_id, to_ext2_file_type(mode));
-    bool success = write_directory(entries);
-    if (success)
+    auto file_type = to_ext2_file_type(mode);
+    bool success = use_index ? add_indexed_entry(name, child_id.index(), file_type, index_lookup) : add_linear_entry(name, child_id.index(), file_type);
+    if (!success) {
+        if (child_inode)
+            child_inode->decrement_link_count();
+        return KResult(-EIO);
+    }
+
+    if (!m_lookup_cache.is_empty())
         m_lookup_cache.set(name, child_id.index());
+    did_add_child(name);
     return KSuccess;
 }
 
@@ -988,39 +1639,89 @@ KResult Ext2FSInode::remove_child(const StringView& name)
 #endif
     ASSERT(is_directory());
 
-    auto it = m_lookup_cache.find(name);
-    if (it == m_lookup_cache.end())
+    auto block = ByteBuffer::create_uninitialized(fs().block_size());
+    Optional<unsigned> block_index;
+    DirectoryIndexLookup index_lookup;
+    if (is_indexed_directory() && find_indexed_leaf(name, index_lookup))
+        block_index = find_indexed_entry_block(name, index_lookup, block);
+    else
+        block_index = find_linear_entry_block(name, block);
+    if (!block_index.has_value())
         return KResult(-ENOENT);
-    auto child_inode_index = (*it).value;
 
-    InodeIdentifier child_id { fsid(), child_inode_index };
+    ext2_dir_entry_2* previous_entry = nullptr;
+    auto* entry = find_entry_in_block(block, name, &previous_entry);
+    ASSERT(entry);
+    InodeIdentifier child_id { fsid(), entry->inode };
 
 #ifdef EXT2_DEBUG
     dbg() << "Ext2FSInode::remove_child(): Removing '" << name << "' in directory " << index();
 #endif
 
-    Vector<FS::DirectoryEntry> entries;
-    KResult result = traverse_as_directory([&](auto& entry) {
-        if (name != entry.name)
-            entries.append(entry);
-        return true;
-    });
-    if (result.is_error())
-        return result;
+    // Give the record's space to the one before it, or leave an empty record at the start of the block.
+    if (previous_entry)
+        previous_entry->rec_len += entry->rec_len;
+    else
+        entry->inode = 0;
 
-    bool success = write_directory(entries);
-    if (!success) {
-        // FIXME: Plumb error from write_directory().
+    if (!write_directory_block(block_index.value(), block))
         return KResult(-EIO);
-    }
+    m_directory_block_with_room = block_index.value();
 
     m_lookup_cache.remove(name);
 
     auto child_inode = fs().get_inode(child_id);
     child_inode->decrement_link_count();
+    did_remove_child(name);
     return KSuccess;
 }
 
+u32 Ext2FS::directory_hash(const StringView& name, u8 hash_version) const
+{
+    auto& super_block = this->super_block();
+    bool is_unsigned = super_block.s_flags & EXT2_FLAGS_UNSIGNED_HASH;
+
+    u32 buffer[4] = { 0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476 };
+    for (size_t i = 0; i < 4; ++i) {
+        if (super_block.s_hash_seed[i]) {
+            memcpy(buffer, super_block.s_hash_seed, sizeof(buffer));
+            break;
+        }
+    }
+
+    auto* characters = reinterpret_cast<const u8*>(name.characters_without_null_termination());
+    size_t length = name.length();
+    u32 input[8];
+    u32 hash = 0;
+    switch (hash_version) {
+    case EXT2_HASH_LEGACY:
+        hash = dx_legacy_hash(characters, length, is_unsigned);
+        break;
+    case EXT2_HASH_HALF_MD4:
+        for (size_t offset = 0; offset < length; offset += 32) {
+            dx_string_to_hash_buffer(characters + offset, length - offset, input, 8, is_unsigned);
+            dx_half_md4_transform(buffer, input);
+        }
+        hash = buffer[1];
+        break;
+    case EXT2_HASH_TEA:
+        for (size_t offset = 0; offset < length; offset += 16) {
+            dx_string_to_hash_buffer(characters + offset, length - offset, input, 4, is_unsigned);
+            dx_tea_transform(buffer, input);
+        }
+        hash = buffer[0];
+        break;
+    default:
+        ASSERT_NOT_REACHED();
+    }
+
+    // The low bit marks hash collisions continuing into the next leaf, and the top value means end-of-directory.
+    hash &= ~1u;
+    if (hash == 0xfffffffe)
+        hash = 0xfffffffc;
+    return hash;
+}
+
 unsigned Ext2FS::inodes_per_block() const
 {
     return EXT2_INODES_PER_BLOCK(&super_block());
@@ -1050,11 +1751,11 @@ bool Ext2FS::write_ext2_inode(unsigned inode, const ext2_inode& e2inode)
     return write_block(block_index, reinterpret_cast<const u8*>(&e2inode), inode_size(), offset);
 }
 
-Vector<Ext2FS::BlockIndex> Ext2FS::allocate_blocks(GroupIndex preferred_group_index, size_t count)
+Vector<Ext2FS::BlockIndex> Ext2FS::allocate_blocks(GroupIndex preferred_group_index, size_t count, BlockIndex goal)
 {
     LOCKER(m_lock);
 #ifdef EXT2_DEBUG
-    dbg() << "Ext2FS: allocate_blocks(preferred group: " << preferred_group_index << ", count: " << count << ")";
+    dbg() << "Ext2FS: allocate_blocks(preferred group: " << preferred_group_index << ", count: " << count << ", goal: " << goal << ")";
 #endif
     if (count == 0)
         return {};
@@ -1065,6 +1766,11 @@ Vector<Ext2FS::BlockIndex> Ext2FS::allocate_blocks(GroupIndex preferred_group_in
 #endif
     blocks.ensure_capacity(count);
 
+    if (goal && (goal < first_block_index() || goal >= super_block().s_blocks_count))
+        goal = 0;
+    if (goal)
+        preferred_group_index = group_index_from_block_index(goal);
+
     GroupIndex group_index = preferred_group_index;
 
     if (!group_descriptor(preferred_group_index).bg_free_blocks_count) {
@@ -1095,8 +1801,29 @@ Vector<Ext2FS::BlockIndex> Ext2FS::allocate_blocks(GroupIndex preferred_group_in
         auto block_bitmap = Bitmap::wrap(cached_bitmap.buffer.data(), blocks_in_group);
 
         BlockIndex first_block_in_group = (group_index - 1) * blocks_per_group() + first_block_index();
+        size_t blocks_wanted = count - blocks.size();
         size_t free_region_size = 0;
-        auto first_unset_bit_index = block_bitmap.find_longest_range_of_unset_bits(count - blocks.size(), free_region_size);
+        Optional<size_t> first_unset_bit_index;
+
+        // Growing files want to stay contiguous, so we take whatever is free right at the goal first,
+        // then the nearest free run after it that fits everything, and only then the longest one in the group.
+        if (goal && goal >= first_block_in_group && goal - first_block_in_group < (size_t)blocks_in_group) {
+            size_t goal_bit_index = goal - first_block_in_group;
+            while (goal_bit_index + free_region_size < (size_t)blocks_in_group && free_region_size < blocks_wanted && !block_bitmap.get(goal_bit_index + free_region_size))
+                ++free_region_size;
+            if (free_region_size) {
+                first_unset_bit_index = goal_bit_index;
+            } else {
+                size_t start = goal_bit_index;
+                auto found_region_size = block_bitmap.find_next_range_of_unset_bits(start, blocks_wanted, blocks_wanted);
+                if (found_region_size.has_value()) {
+                    first_unset_bit_index = start;
+                    free_region_size = found_region_size.value();
+                }
+            }
+        }
+        if (!first_unset_bit_index.has_value())
+            first_unset_bit_index = block_bitmap.find_longest_range_of_unset_bits(blocks_wanted, free_region_size);
         ASSERT(first_unset_bit_index.has_value());
 #ifdef EXT2_DEBUG
         dbg() << "Ext2FS: allocating free region of size: " << free_region_size << "[" << group_index << "]";
@@ -1109,6 +1836,9 @@ Vector<Ext2FS::BlockIndex> Ext2FS::allocate_blocks(GroupIndex preferred_group_in
             dbg() << "  allocated > " << block_index;
 #endif
         }
+        goal = blocks.last() + 1;
+        if (goal >= super_block().s_blocks_count)
+            goal = 0;
     }
 
     ASSERT(blocks.size() == count);
@@ -1481,6 +2211,17 @@ void Ext2FSInode::populate_lookup_cache() const
 RefPtr<Inode> Ext2FSInode::lookup(StringView name)
 {
     ASSERT(is_directory());
+    {
+        // Indexed directories can be searched without reading them in their entirety.
+        LOCKER(m_lock);
+        DirectoryIndexLookup index_lookup;
+        if (m_lookup_cache.is_empty() && is_indexed_directory() && find_indexed_leaf(name, index_lookup)) {
+            auto block = ByteBuffer::create_uninitialized(fs().block_size());
+            if (!find_indexed_entry_block(name, index_lookup, block).has_value())
+                return {};
+            return fs().get_inode({ fsid(), find_entry_in_block(block, name)->inode });
+        }
+    }
     populate_lookup_cache();
     LOCKER(m_lock);
     auto it = m_lookup_cache.find(name.hash(), [&](auto& entry) { return entry.key == name; });
@@ -1491,6 +2232,11 @@ RefPtr<Inode> Ext2FSInode::lookup(StringView name)
 
 void Ext2FSInode::one_ref_left()
 {
+    // Nobody has the file open anymore, so it's not going to grow any further for now.
+    if (!m_preallocated_blocks.is_empty()) {
+        LOCKER(m_lock);
+        discard_preallocated_blocks();
+    }
     // FIXME: I would like to not live forever, but uncached Ext2FS is fucking painful right now.
 }
 
@@ -1543,8 +2289,10 @@ KResult Ext2FSInode::decrement_link_count()
         return KResult(-EROFS);
     ASSERT(m_raw_inode.i_links_count);
     --m_raw_inode.i_links_count;
-    if (ref_count() == 1 && m_raw_inode.i_links_count == 0)
+    if (ref_count() == 1 + page_cache_ref_count() && m_raw_inode.i_links_count == 0) {
+        release_page_cache();
         fs().uncache_inode(index());
+    }
     set_metadata_dirty(true);
     return KSuccess;
 }
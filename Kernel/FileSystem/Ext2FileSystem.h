@@ -28,9 +28,11 @@
 
 #include <AK/Bitmap.h>
 #include <AK/HashMap.h>
+#include <AK/Optional.h>
 #include <Kernel/FileSystem/FileBackedFileSystem.h>
 #include <Kernel/FileSystem/Inode.h>
 #include <Kernel/FileSystem/ext2_fs.h>
+#include <Kernel/Heap/ObjectCache.h>
 #include <Kernel/KBuffer.h>
 #include <Kernel/UnixTypes.h>
 
@@ -44,6 +46,7 @@ class Ext2FS;
 
 class Ext2FSInode final : public Inode {
     friend class Ext2FS;
+    MAKE_OBJECT_CACHED(Ext2FSInode)
 
 public:
     virtual ~Ext2FSInode() override;
@@ -58,6 +61,7 @@ public:
 private:
     // ^Inode
     virtual ssize_t read_bytes(off_t, ssize_t, u8* buffer, FileDescription*) const override;
+    virtual bool is_page_cacheable() const override { return Kernel::is_regular_file(m_raw_inode.i_mode); }
     virtual InodeMetadata metadata() const override;
     virtual KResult traverse_as_directory(Function<bool(const FS::DirectoryEntry&)>) const override;
     virtual RefPtr<Inode> lookup(StringView name) override;
@@ -77,14 +81,46 @@ private:
 
     bool write_directory(const Vector<FS::DirectoryEntry>&);
     void populate_lookup_cache() const;
+    bool read_directory_block(unsigned index, ByteBuffer&) const;
+    bool write_directory_block(unsigned index, const ByteBuffer&);
+    Optional<unsigned> find_linear_entry_block(const StringView& name, ByteBuffer&) const;
+    bool add_linear_entry(const StringView& name, unsigned inode, u8 file_type);
+
+    // dir_index (htree) support. The index lives in otherwise empty directory records,
+    // so an indexed directory is still a valid linear one.
+    struct DirectoryIndexFrame {
+        unsigned block_index { 0 };
+        unsigned entries_offset { 0 };
+        unsigned position { 0 };
+    };
+    struct DirectoryIndexLookup {
+        u8 hash_version { 0 };
+        u32 hash { 0 };
+        unsigned leaf_block { 0 };
+        Vector<DirectoryIndexFrame, 2> path;
+    };
+    bool is_indexed_directory() const;
+    bool find_indexed_leaf(const StringView& name, DirectoryIndexLookup&) const;
+    Optional<unsigned> find_indexed_entry_block(const StringView& name, const DirectoryIndexLookup&, ByteBuffer&) const;
+    bool add_indexed_entry(const StringView& name, unsigned inode, u8 file_type, DirectoryIndexLookup&);
+    bool make_room_in_index(DirectoryIndexLookup&);
+    bool split_indexed_leaf(DirectoryIndexLookup&);
+    bool make_indexed_directory();
+    void drop_directory_index();
     KResult resize(u64);
+    void discard_preallocated_blocks();
 
     Ext2FS& fs();
     const Ext2FS& fs() const;
     Ext2FSInode(Ext2FS&, unsigned index);
 
     mutable Vector<unsigned> m_block_list;
+
+    // Blocks reserved right after the end of a growing file, handed out before allocating any new ones.
+    static constexpr size_t preallocation_block_count = 16;
+    Vector<unsigned> m_preallocated_blocks;
     mutable HashMap<String, unsigned> m_lookup_cache;
+    Optional<unsigned> m_directory_block_with_room;
     ext2_inode m_raw_inode;
 };
 
@@ -105,6 +141,10 @@ public:
     virtual KResult prepare_to_unmount() const override;
 
     virtual bool supports_watchers() const override { return true; }
+    virtual bool supports_dentry_cache() const override { return true; }
+
+    bool has_directory_index() const { return super_block().s_feature_compat & EXT2_FEATURE_COMPAT_DIR_INDEX; }
+    u32 directory_hash(const StringView& name, u8 hash_version) const;
 
 private:
     typedef unsigned BlockIndex;
@@ -136,7 +176,7 @@ private:
 
     BlockIndex first_block_index() const;
     InodeIndex find_a_free_inode(GroupIndex preferred_group, off_t expected_size);
-    Vector<BlockIndex> allocate_blocks(GroupIndex preferred_group_index, size_t count);
+    Vector<BlockIndex> allocate_blocks(GroupIndex preferred_group_index, size_t count, BlockIndex goal = 0);
     GroupIndex group_index_from_inode(InodeIndex) const;
     GroupIndex group_index_from_block_index(BlockIndex) const;
 
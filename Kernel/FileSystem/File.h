@@ -30,6 +30,7 @@
 #include <AK/RefCounted.h>
 #include <AK/String.h>
 #include <AK/Types.h>
+#include <Kernel/BlockCondition.h>
 #include <Kernel/Forward.h>
 #include <Kernel/KResult.h>
 #include <Kernel/UnixTypes.h>
@@ -51,6 +52,10 @@ namespace Kernel {
 //   - Return true if read() or write() would succeed, respectively.
 //   - Note that can_read() should return true in EOF conditions,
 //     and a subsequent call to read() should return 0.
+//   - Whenever their result may have changed, call evaluate_block_conditions()
+//     so that threads blocked on this File get woken up. Files that can't tell
+//     (e.g. because the answer comes from polling hardware) should override
+//     readiness_needs_polling() to return true instead.
 //
 // ioctl()
 //
@@ -97,9 +102,18 @@ public:
     virtual bool is_block_device() const { return false; }
     virtual bool is_character_device() const { return false; }
     virtual bool is_socket() const { return false; }
+    virtual bool is_event_queue() const { return false; }
+
+    virtual bool readiness_needs_polling() const { return false; }
+
+    BlockCondition& block_condition() { return m_block_condition; }
+    void evaluate_block_conditions() { m_block_condition.unblock(); }
 
 protected:
     File();
+
+private:
+    BlockCondition m_block_condition;
 };
 
 }
@@ -24,94 +24,251 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <AK/HashMap.h>
+#include <AK/IntrusiveList.h>
+#include <AK/NonnullOwnPtr.h>
+#include <AK/QuickSort.h>
 #include <AK/StringView.h>
+#include <AK/Vector.h>
 #include <Kernel/Arch/i386/CPU.h>
 #include <Kernel/Devices/BlockDevice.h>
 #include <Kernel/FileSystem/FileBackedFileSystem.h>
 #include <Kernel/FileSystem/FileDescription.h>
 #include <Kernel/KBuffer.h>
 #include <Kernel/Process.h>
+#include <Kernel/Tasks/SyncTask.h>
+#include <Kernel/VM/MemoryManager.h>
 
 //#define FBFS_DEBUG
 
 namespace Kernel {
 
 struct CacheEntry {
-    time_t timestamp { 0 };
+    IntrusiveListNode list_node;
     u32 block_index { 0 };
     u8* data { nullptr };
     bool has_data { false };
     bool is_dirty { false };
+    bool is_mapped { false };
+    bool is_being_written { false };
 };
 
+// The cache grows in chunks while there's plenty of free memory, and gives chunks back
+// when memory gets tight. Lookups go through a hash map keyed on the block index.
+// Clean entries live on an LRU list (least recently used first), dirty entries on their
+// own list so flushing doesn't have to look at the whole cache. Entries that are being
+// written back are on neither list, so they can't be evicted until the write is done.
+struct DiskCacheChunk {
+    DiskCacheChunk(KBuffer&& data, KBuffer&& entry_storage, size_t count)
+        : block_data(move(data))
+        , entries(move(entry_storage))
+        , entry_count(count)
+    {
+    }
+
+    CacheEntry& entry(size_t index) { return ((CacheEntry*)entries.data())[index]; }
+
+    KBuffer block_data;
+    KBuffer entries;
+    size_t entry_count { 0 };
+};
+
+static constexpr size_t disk_cache_chunk_size = 1 * MB;
+static constexpr size_t disk_cache_max_size = 64 * MB;
+
 class DiskCache {
 public:
     explicit DiskCache(FileBackedFS& fs)
         : m_fs(fs)
-        , m_cached_block_data(KBuffer::create_with_size(m_entry_count * m_fs.block_size()))
-        , m_entries(KBuffer::create_with_size(m_entry_count * sizeof(CacheEntry)))
     {
-        for (size_t i = 0; i < m_entry_count; ++i) {
-            entries()[i].data = m_cached_block_data.data() + i * m_fs.block_size();
-        }
+        grow();
     }
 
-    ~DiskCache() { }
+    ~DiskCache()
+    {
+        while (!m_chunks.is_empty())
+            destroy_chunk(m_chunks.take_last());
+    }
 
-    bool is_dirty() const { return m_dirty; }
-    void set_dirty(bool b) { m_dirty = b; }
+    bool is_dirty() const { return !m_dirty_list.is_empty(); }
 
-    CacheEntry& get(u32 block_index) const
+    CacheEntry* find(u32 block_index) const
     {
-        auto now = kgettimeofday().tv_sec;
-
-        CacheEntry* oldest_clean_entry = nullptr;
-        for (size_t i = 0; i < m_entry_count; ++i) {
-            auto& entry = const_cast<CacheEntry&>(entries()[i]);
-            if (entry.block_index == block_index) {
-                entry.timestamp = now;
-                return entry;
-            }
-            if (!entry.is_dirty) {
-                if (!oldest_clean_entry)
-                    oldest_clean_entry = &entry;
-                else if (entry.timestamp < oldest_clean_entry->timestamp)
-                    oldest_clean_entry = &entry;
-            }
+        auto it = m_map.find(block_index);
+        if (it == m_map.end())
+            return nullptr;
+        return it->value;
+    }
+
+    CacheEntry& get(u32 block_index)
+    {
+        if (auto* entry = find(block_index)) {
+            ++m_hits;
+            if (!entry->is_dirty && !entry->is_being_written)
+                m_clean_list.append(*entry);
+            return *entry;
         }
-        if (!oldest_clean_entry) {
+
+        ++m_misses;
+        adapt_to_memory_pressure();
+
+        while (m_clean_list.is_empty() && !grow()) {
             // Not a single clean entry! Flush writes and try again.
             // NOTE: We want to make sure we only call FileBackedFS flush here,
             //       not some FileBackedFS subclass flush!
             m_fs.flush_writes_impl();
-            return get(block_index);
         }
 
-        // Replace the oldest clean entry.
-        auto& new_entry = *oldest_clean_entry;
-        new_entry.timestamp = now;
+        // Replace the least recently used clean entry.
+        auto& new_entry = *m_clean_list.first();
+        if (new_entry.is_mapped) {
+            m_map.remove(new_entry.block_index);
+            ++m_evictions;
+        }
         new_entry.block_index = block_index;
         new_entry.has_data = false;
-        new_entry.is_dirty = false;
+        new_entry.is_mapped = true;
+        m_map.set(block_index, &new_entry);
+        m_clean_list.append(new_entry);
         return new_entry;
     }
 
-    const CacheEntry* entries() const { return (const CacheEntry*)m_entries.data(); }
-    CacheEntry* entries() { return (CacheEntry*)m_entries.data(); }
+    void mark_dirty(CacheEntry& entry)
+    {
+        if (entry.is_dirty)
+            return;
+        entry.is_dirty = true;
+        m_dirty_list.append(entry);
+        ++m_dirty_count;
+    }
 
-    template<typename Callback>
-    void for_each_entry(Callback callback)
+    void mark_clean(CacheEntry& entry)
     {
-        for (size_t i = 0; i < m_entry_count; ++i)
-            callback(entries()[i]);
+        ASSERT(entry.is_dirty);
+        entry.is_dirty = false;
+        m_clean_list.append(entry);
+        --m_dirty_count;
+    }
+
+    // Takes every dirty entry off the dirty list, in block order.
+    Vector<CacheEntry*> begin_writeback()
+    {
+        Vector<CacheEntry*> entries;
+        entries.ensure_capacity(m_dirty_count);
+        while (auto* entry = m_dirty_list.take_first()) {
+            ASSERT(entry->is_dirty);
+            entry->is_dirty = false;
+            entry->is_being_written = true;
+            entries.append(entry);
+        }
+        m_dirty_count = 0;
+        quick_sort(entries, [](auto* a, auto* b) { return a->block_index < b->block_index; });
+        return entries;
+    }
+
+    void end_writeback(CacheEntry& entry)
+    {
+        ASSERT(entry.is_being_written);
+        entry.is_being_written = false;
+        // If it got dirtied again meanwhile, it's back on the dirty list already.
+        if (!entry.is_dirty)
+            m_clean_list.append(entry);
+    }
+
+    // Past these, the write-back task is kicked, and then writers are made to wait for it.
+    bool should_write_back() const { return m_dirty_count > m_entry_count / 4; }
+    bool is_over_dirty_limit() const { return m_dirty_count > m_entry_count / 2; }
+
+    DiskCacheStatistics statistics() const
+    {
+        DiskCacheStatistics stats;
+        stats.hits = m_hits;
+        stats.misses = m_misses;
+        stats.evictions = m_evictions;
+        stats.entry_count = m_entry_count;
+        stats.dirty_count = m_dirty_count;
+        return stats;
     }
 
 private:
+    size_t free_user_memory() const { return (MM.user_physical_pages() - MM.user_physical_pages_used()) * PAGE_SIZE; }
+    size_t total_user_memory() const { return MM.user_physical_pages() * PAGE_SIZE; }
+    size_t size() const { return m_entry_count * m_fs.block_size(); }
+
+    bool can_grow() const
+    {
+        if (m_chunks.is_empty())
+            return true;
+        if (size() + disk_cache_chunk_size > min(disk_cache_max_size, total_user_memory() / 8))
+            return false;
+        return free_user_memory() > total_user_memory() / 4;
+    }
+
+    bool grow()
+    {
+        if (!can_grow())
+            return false;
+        size_t block_size = m_fs.block_size();
+        size_t entry_count = max((size_t)1, disk_cache_chunk_size / block_size);
+        auto block_data = KBuffer::create_with_size(entry_count * block_size, Region::Access::Read | Region::Access::Write, "DiskCache");
+        auto entries = KBuffer::create_with_size(entry_count * sizeof(CacheEntry), Region::Access::Read | Region::Access::Write, "DiskCache entries");
+        auto chunk = make<DiskCacheChunk>(move(block_data), move(entries), entry_count);
+        for (size_t i = 0; i < entry_count; ++i) {
+            auto& entry = *new (&chunk->entry(i)) CacheEntry;
+            entry.data = chunk->block_data.data() + i * block_size;
+            // Fresh entries are the first ones to be handed out.
+            m_clean_list.prepend(entry);
+        }
+        m_entry_count += entry_count;
+        m_chunks.append(move(chunk));
+        return true;
+    }
+
+    void adapt_to_memory_pressure()
+    {
+        // Give back a chunk at a time while memory is tight, but always keep one around.
+        if (m_chunks.size() > 1 && free_user_memory() < total_user_memory() / 16 && !is_being_written(*m_chunks.last()))
+            destroy_chunk(m_chunks.take_last());
+    }
+
+    static bool is_being_written(DiskCacheChunk& chunk)
+    {
+        for (size_t i = 0; i < chunk.entry_count; ++i) {
+            if (chunk.entry(i).is_being_written)
+                return true;
+        }
+        return false;
+    }
+
+    void destroy_chunk(NonnullOwnPtr<DiskCacheChunk> chunk)
+    {
+        for (size_t i = 0; i < chunk->entry_count; ++i) {
+            auto& entry = chunk->entry(i);
+            if (entry.is_dirty) {
+                m_fs.write_cache_entry(entry.block_index, entry.data);
+                --m_dirty_count;
+            }
+            if (entry.is_mapped) {
+                m_map.remove(entry.block_index);
+                ++m_evictions;
+            }
+            entry.~CacheEntry();
+        }
+        m_entry_count -= chunk->entry_count;
+    }
+
+    typedef IntrusiveList<CacheEntry, &CacheEntry::list_node> EntryList;
+
     FileBackedFS& m_fs;
-    size_t m_entry_count { 10000 };
-    KBuffer m_cached_block_data;
-    KBuffer m_entries;
-    bool m_dirty { false };
+    Vector<NonnullOwnPtr<DiskCacheChunk>> m_chunks;
+    HashMap<u32, CacheEntry*> m_map;
+    EntryList m_clean_list;
+    EntryList m_dirty_list;
+    size_t m_entry_count { 0 };
+    size_t m_dirty_count { 0 };
+    u64 m_hits { 0 };
+    u64 m_misses { 0 };
+    u64 m_evictions { 0 };
 };
 
 FileBackedFS::FileBackedFS(FileDescription& file_description)
@@ -149,10 +306,9 @@ bool FileBackedFS::write_block(unsigned index, const u8* data, size_t count, siz
         read_block(index, nullptr, block_size());
     }
     memcpy(entry.data + offset, data, count);
-    entry.is_dirty = true;
     entry.has_data = true;
 
-    cache().set_dirty(true);
+    cache().mark_dirty(entry);
     return true;
 }
 
@@ -244,6 +400,25 @@ bool FileBackedFS::read_blocks(unsigned index, unsigned count, u8* buffer, bool
         return false;
     if (count == 1)
         return read_block(index, buffer, block_size(), 0, allow_cache);
+
+    if (!allow_cache) {
+        // Read the whole run with as few device requests as possible.
+        auto& self = const_cast<FileBackedFS&>(*this);
+        for (unsigned i = 0; i < count; ++i)
+            self.flush_specific_block_if_needed(index + i);
+        size_t total_size = count * block_size();
+        size_t nread_total = 0;
+        u32 base_offset = static_cast<u32>(index) * static_cast<u32>(block_size());
+        m_file_description->seek(base_offset, SEEK_SET);
+        while (nread_total < total_size) {
+            auto nread = m_file_description->read(buffer + nread_total, total_size - nread_total);
+            if (nread <= 0)
+                return false;
+            nread_total += nread;
+        }
+        return true;
+    }
+
     u8* out = buffer;
 
     for (unsigned i = 0; i < count; ++i) {
@@ -255,45 +430,114 @@ bool FileBackedFS::read_blocks(unsigned index, unsigned count, u8* buffer, bool
     return true;
 }
 
+void FileBackedFS::write_cache_entry(unsigned index, const u8* data)
+{
+    u32 base_offset = static_cast<u32>(index) * static_cast<u32>(block_size());
+    m_file_description->seek(base_offset, SEEK_SET);
+    m_file_description->write(data, block_size());
+}
+
 void FileBackedFS::flush_specific_block_if_needed(unsigned index)
 {
     LOCKER(m_lock);
-    if (!cache().is_dirty())
+    if (!m_cache)
         return;
-    cache().for_each_entry([&](CacheEntry& entry) {
-        if (entry.is_dirty && entry.block_index == index) {
-            u32 base_offset = static_cast<u32>(entry.block_index) * static_cast<u32>(block_size());
-            m_file_description->seek(base_offset, SEEK_SET);
-            m_file_description->write(entry.data, block_size());
-            entry.is_dirty = false;
-        }
-    });
+    auto* entry = cache().find(index);
+    if (entry && entry->is_being_written) {
+        // Wait for the write-back in progress, so nobody reads the block from disk before it lands.
+        LOCKER(m_flush_lock);
+        entry = cache().find(index);
+    }
+    if (!entry || !entry->is_dirty)
+        return;
+    write_cache_entry(entry->block_index, entry->data);
+    cache().mark_clean(*entry);
 }
 
+static constexpr size_t max_write_back_batch_size = 64 * KB;
+
 void FileBackedFS::flush_writes_impl()
 {
-    LOCKER(m_lock);
-    if (!cache().is_dirty())
+    // We don't hold m_lock while the writes are in flight, so others can keep using
+    // (and dirtying) the cache meanwhile. m_flush_lock keeps flushes from overlapping.
+    LOCKER(m_flush_lock);
+    if (!m_cache || !cache().is_dirty())
         return;
+
+    auto entries = cache().begin_writeback();
+    size_t batch_capacity = max((size_t)1, max_write_back_batch_size / block_size());
+    auto batch_buffer = KBuffer::create_with_size(batch_capacity * block_size(), Region::Access::Read | Region::Access::Write, "DiskCache write-back");
+
     u32 count = 0;
-    cache().for_each_entry([&](CacheEntry& entry) {
-        if (!entry.is_dirty)
-            return;
-        u32 base_offset = static_cast<u32>(entry.block_index) * static_cast<u32>(block_size());
-        m_file_description->seek(base_offset, SEEK_SET);
-        m_file_description->write(entry.data, block_size());
-        ++count;
-        entry.is_dirty = false;
-    });
-    cache().set_dirty(false);
+    for (size_t i = 0; i < entries.size();) {
+        // Coalesce a run of consecutive blocks into one write.
+        size_t run_length = 1;
+        while (i + run_length < entries.size()
+            && run_length < batch_capacity
+            && entries[i + run_length]->block_index == entries[i]->block_index + run_length)
+            ++run_length;
+
+        for (size_t j = 0; j < run_length; ++j)
+            memcpy(batch_buffer.data() + j * block_size(), entries[i + j]->data, block_size());
+        write_blocks_directly(entries[i]->block_index, run_length, batch_buffer.data());
+
+        for (size_t j = 0; j < run_length; ++j)
+            cache().end_writeback(*entries[i + j]);
+        count += run_length;
+        i += run_length;
+        m_write_back_queue.wake_all();
+    }
     dbg() << class_name() << ": Flushed " << count << " blocks to disk";
 }
 
+void FileBackedFS::write_blocks_directly(unsigned index, size_t count, const u8* data)
+{
+    size_t total_size = count * block_size();
+    size_t nwritten_total = 0;
+    u32 base_offset = static_cast<u32>(index) * static_cast<u32>(block_size());
+    m_file_description->seek(base_offset, SEEK_SET);
+    while (nwritten_total < total_size) {
+        auto nwritten = m_file_description->write(data + nwritten_total, total_size - nwritten_total);
+        if (nwritten <= 0) {
+            klog() << class_name() << ": Failed to write back " << count << " blocks at " << index;
+            return;
+        }
+        nwritten_total += nwritten;
+    }
+}
+
+void FileBackedFS::write_back_if_needed()
+{
+    if (m_cache && cache().should_write_back())
+        flush_writes_impl();
+}
+
+void FileBackedFS::throttle_writer_if_needed()
+{
+    if (!m_cache || !cache().should_write_back())
+        return;
+    SyncTask::request_write_back();
+    if (Thread::current()->process().is_ring0())
+        return;
+    while (cache().is_over_dirty_limit()) {
+        timeval timeout { 0, 100'000 };
+        Thread::current()->wait_on(m_write_back_queue, &timeout);
+        SyncTask::request_write_back();
+    }
+}
+
 void FileBackedFS::flush_writes()
 {
     flush_writes_impl();
 }
 
+DiskCacheStatistics FileBackedFS::cache_statistics() const
+{
+    if (!m_cache)
+        return {};
+    return m_cache->statistics();
+}
+
 DiskCache& FileBackedFS::cache() const
 {
     if (!m_cache)
@@ -29,9 +29,19 @@
 #include <Kernel/FileSystem/FileDescription.h>
 #include <Kernel/FileSystem/FileSystem.h>
 #include <Kernel/Forward.h>
+#include <Kernel/Lock.h>
+#include <Kernel/WaitQueue.h>
 
 namespace Kernel {
 
+struct DiskCacheStatistics {
+    u64 hits { 0 };
+    u64 misses { 0 };
+    u64 evictions { 0 };
+    size_t entry_count { 0 };
+    size_t dirty_count { 0 };
+};
+
 class FileBackedFS : public FS {
 public:
     virtual ~FileBackedFS() override;
@@ -47,6 +57,13 @@ public:
 
     size_t logical_block_size() const { return m_logical_block_size; };
 
+    DiskCacheStatistics cache_statistics() const;
+
+    // Called by the write-back task once there's a lot of dirty data.
+    void write_back_if_needed();
+    // Called after writing to a file. Makes the writer wait if more of the cache is dirty than we'd like.
+    void throttle_writer_if_needed();
+
 protected:
     explicit FileBackedFS(FileDescription&);
 
@@ -65,13 +82,20 @@ protected:
     size_t m_logical_block_size { 512 };
 
 private:
+    friend class DiskCache;
+
     virtual bool is_file_backed() const override { return true; }
 
+    void write_cache_entry(unsigned index, const u8* data);
+    void write_blocks_directly(unsigned index, size_t count, const u8* data);
+
     DiskCache& cache() const;
     void flush_specific_block_if_needed(unsigned index);
 
     mutable NonnullRefPtr<FileDescription> m_file_description;
     mutable OwnPtr<DiskCache> m_cache;
+    Lock m_flush_lock { "FileBackedFS flush" };
+    WaitQueue m_write_back_queue;
 };
 
 }
@@ -42,6 +42,8 @@
 
 namespace Kernel {
 
+DEFINE_OBJECT_CACHE(FileDescription);
+
 NonnullRefPtr<FileDescription> FileDescription::create(Custody& custody)
 {
     auto description = adopt(*new FileDescription(InodeFile::create(custody.inode())));
@@ -136,6 +138,59 @@ ssize_t FileDescription::read(u8* buffer, ssize_t count)
     return nread;
 }
 
+ssize_t FileDescription::read_at(off_t offset, u8* buffer, ssize_t count)
+{
+    LOCKER(m_lock);
+    ASSERT(m_file->is_seekable());
+    if (offset < 0)
+        return -EINVAL;
+    if ((offset + count) < 0)
+        return -EOVERFLOW;
+    SmapDisabler disabler;
+    return m_file->read(*this, offset, buffer, count);
+}
+
+ssize_t FileDescription::write_at(off_t offset, const u8* data, ssize_t size)
+{
+    LOCKER(m_lock);
+    ASSERT(m_file->is_seekable());
+    if (offset < 0)
+        return -EINVAL;
+    if ((offset + size) < 0)
+        return -EOVERFLOW;
+    SmapDisabler disabler;
+    return m_file->write(*this, offset, data, size);
+}
+
+static constexpr size_t min_readahead_window = 16 * KB;
+static constexpr size_t max_readahead_window = 128 * KB;
+
+FileDescription::ReadaheadRange FileDescription::readahead_range_for_read(off_t offset, size_t count)
+{
+    off_t end = offset + count;
+    if (offset != m_readahead_next_offset) {
+        // Not sequential, start over.
+        m_readahead_next_offset = end;
+        m_readahead_end = 0;
+        m_readahead_window = 0;
+        return {};
+    }
+    m_readahead_next_offset = end;
+
+    // Only go to the disk again once the reader is halfway through the last window.
+    if (end + (off_t)(m_readahead_window / 2) <= m_readahead_end)
+        return {};
+
+    if (!m_readahead_window)
+        m_readahead_window = min_readahead_window;
+    else
+        m_readahead_window = min(m_readahead_window * 2, max_readahead_window);
+
+    off_t start = max(offset, m_readahead_end);
+    m_readahead_end = end + m_readahead_window;
+    return { start, (size_t)(m_readahead_end - start) };
+}
+
 ssize_t FileDescription::write(const u8* data, ssize_t size)
 {
     LOCKER(m_lock);
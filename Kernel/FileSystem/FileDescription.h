@@ -29,10 +29,13 @@
 #include <AK/Badge.h>
 #include <AK/ByteBuffer.h>
 #include <AK/RefCounted.h>
+#include <AK/WeakPtr.h>
+#include <AK/Weakable.h>
 #include <Kernel/FileSystem/FIFO.h>
 #include <Kernel/FileSystem/Inode.h>
 #include <Kernel/FileSystem/InodeMetadata.h>
 #include <Kernel/FileSystem/VirtualFileSystem.h>
+#include <Kernel/Heap/ObjectCache.h>
 #include <Kernel/KBuffer.h>
 #include <Kernel/VirtualAddress.h>
 
@@ -46,8 +49,9 @@ class Region;
 class Socket;
 class TTY;
 
-class FileDescription : public RefCounted<FileDescription> {
-    MAKE_SLAB_ALLOCATED(FileDescription)
+class FileDescription : public RefCounted<FileDescription>
+    , public Weakable<FileDescription> {
+    MAKE_OBJECT_CACHED(FileDescription)
 public:
     static NonnullRefPtr<FileDescription> create(Custody&);
     static NonnullRefPtr<FileDescription> create(File&);
@@ -70,6 +74,9 @@ public:
     off_t seek(off_t, int whence);
     ssize_t read(u8*, ssize_t);
     ssize_t write(const u8* data, ssize_t);
+    // Like read() and write(), but at the given offset, and without touching the current one.
+    ssize_t read_at(off_t, u8*, ssize_t);
+    ssize_t write_at(off_t, const u8* data, ssize_t);
     KResult fstat(stat&);
 
     KResult chmod(mode_t);
@@ -136,6 +143,14 @@ public:
 
     off_t offset() const { return m_current_offset; }
 
+    struct ReadaheadRange {
+        off_t offset { 0 };
+        size_t length { 0 };
+    };
+    // Tracks sequential reads through this description. While they stay sequential,
+    // the returned range covers the read itself plus a window that doubles each time.
+    ReadaheadRange readahead_range_for_read(off_t offset, size_t count);
+
     KResult chown(uid_t, gid_t);
 
 private:
@@ -149,6 +164,10 @@ private:
 
     off_t m_current_offset { 0 };
 
+    off_t m_readahead_next_offset { 0 };
+    off_t m_readahead_end { 0 };
+    size_t m_readahead_window { 0 };
+
     Optional<KBuffer> m_generator_cache;
 
     u32 m_file_flags { 0 };
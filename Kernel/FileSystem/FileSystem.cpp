@@ -28,6 +28,7 @@
 #include <AK/HashMap.h>
 #include <AK/StringBuilder.h>
 #include <AK/StringView.h>
+#include <Kernel/FileSystem/FileBackedFileSystem.h>
 #include <Kernel/FileSystem/FileSystem.h>
 #include <Kernel/FileSystem/Inode.h>
 #include <Kernel/Net/LocalSocket.h>
@@ -100,6 +101,21 @@ void FS::sync()
         fs.flush_writes();
 }
 
+void FS::write_back_dirty_blocks()
+{
+    NonnullRefPtrVector<FS, 32> fses;
+    {
+        InterruptDisabler disabler;
+        for (auto& it : all_fses()) {
+            if (it.value->is_file_backed())
+                fses.append(*it.value);
+        }
+    }
+
+    for (auto& fs : fses)
+        static_cast<FileBackedFS&>(fs).write_back_if_needed();
+}
+
 void FS::lock_all()
 {
     for (auto& it : all_fses()) {
@@ -28,10 +28,13 @@
 #include <AK/StringBuilder.h>
 #include <AK/StringView.h>
 #include <Kernel/FileSystem/Custody.h>
+#include <Kernel/FileSystem/FileDescription.h>
 #include <Kernel/FileSystem/Inode.h>
 #include <Kernel/FileSystem/InodeWatcher.h>
 #include <Kernel/FileSystem/VirtualFileSystem.h>
 #include <Kernel/Net/LocalSocket.h>
+#include <Kernel/VM/MemoryManager.h>
+#include <Kernel/VM/PhysicalPage.h>
 #include <Kernel/VM/SharedInodeVMObject.h>
 
 namespace Kernel {
@@ -70,7 +73,7 @@ KResultOr<ByteBuffer> Inode::read_entire(FileDescription* descriptor) const
     u8 buffer[4096];
     off_t offset = 0;
     for (;;) {
-        nread = read_bytes(offset, sizeof(buffer), buffer, descriptor);
+        nread = read_bytes_through_page_cache(offset, sizeof(buffer), buffer, descriptor);
         ASSERT(nread <= (ssize_t)sizeof(buffer));
         if (nread <= 0)
             break;
@@ -87,6 +90,104 @@ KResultOr<ByteBuffer> Inode::read_entire(FileDescription* descriptor) const
     return builder.to_byte_buffer();
 }
 
+ssize_t Inode::read_bytes_through_page_cache(off_t offset, ssize_t count, u8* buffer, FileDescription* description) const
+{
+    if (!is_page_cacheable() || (description && description->is_direct()))
+        return read_bytes(offset, count, buffer, description);
+
+    ASSERT(offset >= 0);
+    auto vmobject = ensure_page_cache();
+    LOCKER(vmobject->paging_lock());
+    off_t size = this->size();
+    if (offset >= size)
+        return 0;
+
+    ssize_t remaining_count = min((off_t)count, size - offset);
+    ssize_t nread = 0;
+    u8 page_buffer[PAGE_SIZE];
+    while (remaining_count) {
+        size_t page_index = offset / PAGE_SIZE;
+        size_t offset_in_page = offset % PAGE_SIZE;
+        size_t num_bytes_to_copy = min((size_t)remaining_count, PAGE_SIZE - offset_in_page);
+        auto page_or_error = vmobject->ensure_physical_page(page_index);
+        if (page_or_error.is_error()) {
+            // The VMObject hasn't caught up with the inode growing, just read the rest directly.
+            if (page_or_error.error() == -EINVAL) {
+                auto rest = read_bytes(offset, remaining_count, buffer + nread, description);
+                if (rest < 0)
+                    return nread ? nread : rest;
+                return nread + rest;
+            }
+            return nread ? nread : (ssize_t)page_or_error.error();
+        }
+        // The buffer may be in userspace, so bounce through the stack.
+        InodeVMObject::copy_from_physical_page(*page_or_error.value(), offset_in_page, page_buffer, num_bytes_to_copy);
+        memcpy(buffer + nread, page_buffer, num_bytes_to_copy);
+        remaining_count -= num_bytes_to_copy;
+        nread += num_bytes_to_copy;
+        offset += num_bytes_to_copy;
+    }
+    return nread;
+}
+
+void Inode::readahead(off_t offset, size_t length) const
+{
+    if (!is_page_cacheable() || !length)
+        return;
+    ASSERT(offset >= 0);
+    auto vmobject = ensure_page_cache();
+    LOCKER(vmobject->paging_lock());
+    off_t size = this->size();
+    if (offset >= size)
+        return;
+    off_t end = min(offset + (off_t)length, size);
+    size_t first_page_index = offset / PAGE_SIZE;
+    size_t end_page_index = ceil_div((size_t)end, PAGE_SIZE);
+    vmobject->prefetch_physical_pages(first_page_index, end_page_index - first_page_index);
+}
+
+NonnullRefPtr<SharedInodeVMObject> Inode::ensure_page_cache() const
+{
+    LOCKER(m_lock);
+    if (!m_page_cache)
+        m_page_cache = SharedInodeVMObject::create_with_inode(const_cast<Inode&>(*this));
+    return *m_page_cache;
+}
+
+KResultOr<NonnullRefPtr<PhysicalPage>> Inode::page_cache_page(size_t page_index) const
+{
+    ASSERT(is_page_cacheable());
+    auto vmobject = ensure_page_cache();
+    LOCKER(vmobject->paging_lock());
+    return vmobject->ensure_physical_page(page_index);
+}
+
+int Inode::page_cache_ref_count() const
+{
+    // If nothing has the page cache mapped, the reference it holds to us is only there because we keep it alive.
+    InterruptDisabler disabler;
+    return m_page_cache && m_page_cache->ref_count() == 1 ? 1 : 0;
+}
+
+size_t Inode::page_cache_resident_size() const
+{
+    return m_page_cache ? m_page_cache->amount_clean() + m_page_cache->amount_dirty() : 0;
+}
+
+void Inode::release_page_cache()
+{
+    RefPtr<SharedInodeVMObject> page_cache;
+    {
+        LOCKER(m_lock);
+        page_cache = move(m_page_cache);
+    }
+}
+
+RefPtr<PhysicalPage> Inode::backing_physical_page(size_t)
+{
+    return nullptr;
+}
+
 KResultOr<NonnullRefPtr<Custody>> Inode::resolve_as_link(Custody& base, RefPtr<Custody>* out_parent, int options, int symlink_recursion_level) const
 {
     // The default implementation simply treats the stored
@@ -210,11 +311,30 @@ void Inode::set_metadata_dirty(bool metadata_dirty)
         //        We don't always end up on this particular code path, for instance when writing to an ext2fs file.
         LOCKER(m_lock);
         for (auto& watcher : m_watchers) {
-            watcher->notify_inode_event({}, InodeWatcher::Event::Type::Modified);
+            watcher->notify_inode_event({}, InodeWatcherEvent::Type::Modified);
         }
     }
 }
 
+void Inode::did_add_child(const StringView& name)
+{
+    notify_watchers_of_child_event(InodeWatcherEvent::Type::ChildAdded, name);
+}
+
+void Inode::did_remove_child(const StringView& name)
+{
+    notify_watchers_of_child_event(InodeWatcherEvent::Type::ChildRemoved, name);
+}
+
+void Inode::notify_watchers_of_child_event(InodeWatcherEvent::Type event_type, const StringView& name)
+{
+    if (name == "." || name == "..")
+        return;
+    LOCKER(m_lock);
+    for (auto& watcher : m_watchers)
+        watcher->notify_child_event({}, event_type, name);
+}
+
 KResult Inode::prepare_to_write_data()
 {
     // FIXME: It's a poor design that filesystems are expected to call this before writing out data.
@@ -36,6 +36,7 @@
 #include <Kernel/FileSystem/InodeIdentifier.h>
 #include <Kernel/FileSystem/InodeMetadata.h>
 #include <Kernel/Forward.h>
+#include <Kernel/InodeWatcherEvent.h>
 #include <Kernel/KResult.h>
 #include <Kernel/Lock.h>
 
@@ -69,6 +70,9 @@ public:
     KResultOr<ByteBuffer> read_entire(FileDescription* = nullptr) const;
 
     virtual ssize_t read_bytes(off_t, ssize_t, u8* buffer, FileDescription*) const = 0;
+    // Like read_bytes(), but served from (and filling) the pages of our shared VMObject if we're page cacheable.
+    ssize_t read_bytes_through_page_cache(off_t, ssize_t, u8* buffer, FileDescription*) const;
+    void readahead(off_t, size_t) const;
     virtual KResult traverse_as_directory(Function<bool(const FS::DirectoryEntry&)>) const = 0;
     virtual RefPtr<Inode> lookup(StringView name) = 0;
     virtual ssize_t write_bytes(off_t, ssize_t, const u8* data, FileDescription*) = 0;
@@ -103,6 +107,21 @@ public:
     SharedInodeVMObject* shared_vmobject() { return m_shared_vmobject.ptr(); }
     const SharedInodeVMObject* shared_vmobject() const { return m_shared_vmobject.ptr(); }
 
+    // File systems that read their contents off a disk let us keep them around in our shared VMObject,
+    // which then stays alive even when nothing has it mapped. Since it holds a reference to us in turn,
+    // file systems have to account for that reference when deciding whether an inode is unused.
+    virtual bool is_page_cacheable() const { return false; }
+    int page_cache_ref_count() const;
+    // Returns the page cache's copy of the given page, reading it in if needed. Private mappings
+    // start out sharing these, and only get their own copy of a page once they write to it.
+    KResultOr<NonnullRefPtr<PhysicalPage>> page_cache_page(size_t page_index) const;
+    size_t page_cache_resident_size() const;
+    void release_page_cache();
+
+    // File systems that keep their contents in physical pages anyway can hand those out to
+    // shared mappings directly, instead of having them read into a copy.
+    virtual RefPtr<PhysicalPage> backing_physical_page(size_t);
+
     static void sync();
 
     bool has_watchers() const { return !m_watchers.is_empty(); }
@@ -117,6 +136,9 @@ public:
 protected:
     Inode(FS& fs, unsigned index);
     void set_metadata_dirty(bool);
+    // For directories, to let watchers know which entries came and went.
+    void did_add_child(const StringView& name);
+    void did_remove_child(const StringView& name);
     void inode_contents_changed(off_t, ssize_t, const u8*);
     void inode_size_changed(size_t old_size, size_t new_size);
     KResult prepare_to_write_data();
@@ -124,9 +146,14 @@ protected:
     mutable Lock m_lock { "Inode" };
 
 private:
+    void notify_watchers_of_child_event(InodeWatcherEvent::Type, const StringView& name);
+
     FS& m_fs;
     unsigned m_index { 0 };
     WeakPtr<SharedInodeVMObject> m_shared_vmobject;
+    NonnullRefPtr<SharedInodeVMObject> ensure_page_cache() const;
+
+    mutable RefPtr<SharedInodeVMObject> m_page_cache;
     RefPtr<LocalSocket> m_socket;
     HashTable<InodeWatcher*> m_watchers;
     bool m_metadata_dirty { false };
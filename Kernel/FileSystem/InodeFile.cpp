@@ -25,6 +25,7 @@
  */
 
 #include <AK/StringView.h>
+#include <Kernel/FileSystem/FileBackedFileSystem.h>
 #include <Kernel/FileSystem/FileDescription.h>
 #include <Kernel/FileSystem/Inode.h>
 #include <Kernel/FileSystem/InodeFile.h>
@@ -46,9 +47,13 @@ InodeFile::~InodeFile()
 
 ssize_t InodeFile::read(FileDescription& description, size_t offset, u8* buffer, ssize_t count)
 {
-    ssize_t nread = m_inode->read_bytes(offset, count, buffer, &description);
+    if (m_inode->is_page_cacheable() && !description.is_direct() && count > 0) {
+        auto readahead = description.readahead_range_for_read(offset, count);
+        m_inode->readahead(readahead.offset, readahead.length);
+    }
+    ssize_t nread = m_inode->read_bytes_through_page_cache(offset, count, buffer, &description);
     if (nread > 0)
-        Thread::current->did_file_read(nread);
+        Thread::current()->did_file_read(nread);
     return nread;
 }
 
@@ -57,14 +62,15 @@ ssize_t InodeFile::write(FileDescription& description, size_t offset, const u8*
     ssize_t nwritten = m_inode->write_bytes(offset, count, data, &description);
     if (nwritten > 0) {
         m_inode->set_mtime(kgettimeofday().tv_sec);
-        Thread::current->did_file_write(nwritten);
+        Thread::current()->did_file_write(nwritten);
+        if (m_inode->fs().is_file_backed())
+            static_cast<FileBackedFS&>(m_inode->fs()).throttle_writer_if_needed();
     }
     return nwritten;
 }
 
 KResultOr<Region*> InodeFile::mmap(Process& process, FileDescription& description, VirtualAddress preferred_vaddr, size_t offset, size_t size, int prot, bool shared)
 {
-    ASSERT(offset == 0);
     // FIXME: If PROT_EXEC, check that the underlying file system isn't mounted noexec.
     RefPtr<InodeVMObject> vmobject;
     if (shared)
@@ -64,11 +64,24 @@ ssize_t InodeWatcher::read(FileDescription&, size_t, u8* buffer, ssize_t buffer_
     if (!m_inode)
         return 0;
 
-    // FIXME: What should we do if the output buffer is too small?
-    ASSERT(buffer_size >= (int)sizeof(Event));
-    auto event = m_queue.dequeue();
-    memcpy(buffer, &event, sizeof(event));
-    return sizeof(event);
+    // Hand out as many events as fit, so a burst of changes doesn't take a read per event.
+    ssize_t nread = 0;
+    while (!m_queue.is_empty()) {
+        auto& event = m_queue.first();
+        ssize_t event_size = sizeof(InodeWatcherEvent) + event.name.length();
+        if (event_size > buffer_size - nread)
+            break;
+        InodeWatcherEvent header;
+        header.type = event.type;
+        header.name_length = event.name.length();
+        memcpy(buffer + nread, &header, sizeof(header));
+        memcpy(buffer + nread + sizeof(header), event.name.characters(), event.name.length());
+        nread += event_size;
+        m_queue.dequeue();
+    }
+    if (!nread)
+        return -EINVAL;
+    return nread;
 }
 
 ssize_t InodeWatcher::write(FileDescription&, size_t, const u8*, ssize_t)
@@ -83,9 +96,35 @@ String InodeWatcher::absolute_path(const FileDescription&) const
     return String::format("InodeWatcher:%s", m_inode->identifier().to_string().characters());
 }
 
-void InodeWatcher::notify_inode_event(Badge<Inode>, Event::Type event_type)
+void InodeWatcher::notify_inode_event(Badge<Inode>, InodeWatcherEvent::Type event_type)
 {
-    m_queue.enqueue({ event_type });
+    enqueue({ event_type, {} });
+}
+
+void InodeWatcher::notify_child_event(Badge<Inode>, InodeWatcherEvent::Type event_type, const StringView& name)
+{
+    enqueue({ event_type, name });
+}
+
+void InodeWatcher::enqueue(Event&& event)
+{
+    // A modification that hasn't been read yet covers any later ones. Other events only fold into the
+    // last one, since what a child event means depends on the ones before it.
+    if (event.type == InodeWatcherEvent::Type::Modified) {
+        for (size_t i = 0; i < m_queue.size(); ++i) {
+            if (m_queue.at(i).type == InodeWatcherEvent::Type::Modified)
+                return;
+        }
+    } else if (!m_queue.is_empty() && m_queue.last().type == event.type && m_queue.last().name == event.name) {
+        return;
+    }
+
+    if (m_queue.size() == m_queue.capacity()) {
+        m_queue.clear();
+        event = { InodeWatcherEvent::Type::Overflowed, {} };
+    }
+    m_queue.enqueue(move(event));
+    evaluate_block_conditions();
 }
 
 }
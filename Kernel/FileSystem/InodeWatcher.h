@@ -30,6 +30,7 @@
 #include <AK/CircularQueue.h>
 #include <AK/WeakPtr.h>
 #include <Kernel/FileSystem/File.h>
+#include <Kernel/InodeWatcherEvent.h>
 
 namespace Kernel {
 
@@ -41,12 +42,9 @@ public:
     virtual ~InodeWatcher() override;
 
     struct Event {
-        enum class Type {
-            Invalid = 0,
-            Modified,
-        };
-
-        Type type { Type::Invalid };
+        InodeWatcherEvent::Type type { InodeWatcherEvent::Type::Invalid };
+        // The child's name, for child events.
+        String name;
     };
 
     virtual bool can_read(const FileDescription&, size_t) const override;
@@ -56,11 +54,14 @@ public:
     virtual String absolute_path(const FileDescription&) const override;
     virtual const char* class_name() const override { return "InodeWatcher"; };
 
-    void notify_inode_event(Badge<Inode>, Event::Type);
+    void notify_inode_event(Badge<Inode>, InodeWatcherEvent::Type);
+    void notify_child_event(Badge<Inode>, InodeWatcherEvent::Type, const StringView& name);
 
 private:
     explicit InodeWatcher(Inode&);
 
+    void enqueue(Event&&);
+
     WeakPtr<Inode> m_inode;
     CircularQueue<Event, 32> m_queue;
 };
@@ -24,6 +24,7 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <AK/Demangle.h>
 #include <AK/JsonArraySerializer.h>
 #include <AK/JsonObject.h>
 #include <AK/JsonObjectSerializer.h>
@@ -37,6 +38,7 @@
 #include <Kernel/FileSystem/FileDescription.h>
 #include <Kernel/FileSystem/ProcFS.h>
 #include <Kernel/FileSystem/VirtualFileSystem.h>
+#include <Kernel/Heap/ObjectCache.h>
 #include <Kernel/Heap/kmalloc.h>
 #include <Kernel/Interrupts/GenericInterruptHandler.h>
 #include <Kernel/Interrupts/InterruptManagement.h>
@@ -45,15 +47,20 @@
 #include <Kernel/Module.h>
 #include <Kernel/Net/LocalSocket.h>
 #include <Kernel/Net/NetworkAdapter.h>
+#include <Kernel/Net/NetworkStatistics.h>
+#include <Kernel/Net/NetworkTrace.h>
 #include <Kernel/Net/Routing.h>
 #include <Kernel/Net/TCPSocket.h>
 #include <Kernel/Net/UDPSocket.h>
 #include <Kernel/PCI/Access.h>
 #include <Kernel/Process.h>
+#include <Kernel/ProcessSnapshot.h>
 #include <Kernel/Profiling.h>
 #include <Kernel/Scheduler.h>
 #include <Kernel/StdLib.h>
+#include <Kernel/SyscallStatistics.h>
 #include <Kernel/TTY/TTY.h>
+#include <Kernel/Time/TimeManagement.h>
 #include <Kernel/VM/MemoryManager.h>
 #include <Kernel/VM/PurgeableVMObject.h>
 #include <LibC/errno_numbers.h>
@@ -79,7 +86,9 @@ enum ProcFileType {
     FI_Root_mounts,
     FI_Root_df,
     FI_Root_all,
+    FI_Root_all_bin,
     FI_Root_memstat,
+    FI_Root_slabs,
     FI_Root_cpuinfo,
     FI_Root_inodes,
     FI_Root_dmesg,
@@ -90,6 +99,8 @@ enum ProcFileType {
     FI_Root_cmdline,
     FI_Root_modules,
     FI_Root_profile,
+    FI_Root_profile_stream,
+    FI_Root_locks,
     FI_Root_self, // symlink
     FI_Root_sys,  // directory
     FI_Root_net,  // directory
@@ -102,6 +113,8 @@ enum ProcFileType {
     FI_Root_net_tcp,
     FI_Root_net_udp,
     FI_Root_net_local,
+    FI_Root_net_snmp,
+    FI_Root_net_trace,
 
     FI_PID,
 
@@ -112,6 +125,7 @@ enum ProcFileType {
     FI_PID_regs,
     FI_PID_fds,
     FI_PID_unveil,
+    FI_PID_syscalls,
     FI_PID_exe,  // symlink
     FI_PID_cwd,  // symlink
     FI_PID_root, // symlink
@@ -295,7 +309,7 @@ Optional<KBuffer> procfs$pid_vm(InodeIdentifier identifier)
     KBufferBuilder builder;
     JsonArraySerializer array { builder };
     for (auto& region : process.regions()) {
-        if (!region.is_user_accessible() && !Process::current->is_superuser())
+        if (!region.is_user_accessible() && !Process::current()->is_superuser())
             continue;
         auto region_object = array.add_object();
         region_object.add("readable", region.is_readable());
@@ -313,6 +327,9 @@ Optional<KBuffer> procfs$pid_vm(InodeIdentifier identifier)
         region_object.add("size", region.size());
         region_object.add("amount_resident", region.amount_resident());
         region_object.add("amount_dirty", region.amount_dirty());
+        auto amount_shared = region.amount_shared();
+        region_object.add("amount_shared", amount_shared);
+        region_object.add("amount_private", region.amount_resident() - amount_shared);
         region_object.add("cow_pages", region.cow_pages());
         region_object.add("name", region.name());
         region_object.add("vmobject", region.vmobject().class_name());
@@ -372,6 +389,65 @@ Optional<KBuffer> procfs$interrupts(InodeIdentifier)
     return builder.build();
 }
 
+Optional<KBuffer> procfs$locks(InodeIdentifier)
+{
+    KBufferBuilder builder;
+    JsonArraySerializer array { builder };
+    bool mask_kernel_addresses = !Process::current()->is_superuser();
+    InterruptDisabler disabler;
+    Lock::for_each_statistics([&array, mask_kernel_addresses](const LockStatistics& statistics) {
+        auto obj = array.add_object();
+        obj.add("name", statistics.name);
+        obj.add("acquisitions", statistics.acquisitions);
+        obj.add("contentions", statistics.contentions);
+        obj.add("spin_acquisitions", statistics.spin_acquisitions);
+        obj.add("blocks", statistics.blocks);
+        obj.add("total_wait_ns", statistics.total_wait_ns);
+        obj.add("max_wait_ns", statistics.max_wait_ns);
+        auto holders_array = obj.add_array("holders");
+        for (auto& sample : statistics.holder_samples) {
+            if (!sample.count)
+                continue;
+            auto holder_object = holders_array.add_object();
+            holder_object.add("count", sample.count);
+            auto backtrace_array = holder_object.add_array("backtrace");
+            for (auto address : sample.backtrace) {
+                if (!address)
+                    break;
+                auto* symbol = g_kernel_symbols_available ? symbolicate_kernel_address(address) : nullptr;
+                if (symbol)
+                    backtrace_array.add(String::format("%p  %s +%u", mask_kernel_addresses ? 0xdeadc0de : address, demangle(symbol->name).characters(), address - symbol->address));
+                else
+                    backtrace_array.add(String::format("%p", mask_kernel_addresses ? 0xdeadc0de : address));
+            }
+            backtrace_array.finish();
+            holder_object.finish();
+        }
+        holders_array.finish();
+    });
+    array.finish();
+    return builder.build();
+}
+
+Optional<KBuffer> procfs$slabs(InodeIdentifier)
+{
+    KBufferBuilder builder;
+    JsonArraySerializer array { builder };
+    InterruptDisabler disabler;
+    ObjectCache::for_each([&array](const ObjectCache& cache) {
+        auto obj = array.add_object();
+        obj.add("name", cache.name());
+        obj.add("object_size", cache.object_size());
+        obj.add("objects_per_slab", cache.objects_per_slab());
+        obj.add("slabs", cache.num_slabs());
+        obj.add("num_allocated", cache.num_allocated());
+        obj.add("num_free", cache.num_free());
+        obj.add("allocations", cache.allocations());
+    });
+    array.finish();
+    return builder.build();
+}
+
 Optional<KBuffer> procfs$devices(InodeIdentifier)
 {
     KBufferBuilder builder;
@@ -428,7 +504,7 @@ Optional<KBuffer> procfs$modules(InodeIdentifier)
     return builder.build();
 }
 
-Optional<KBuffer> procfs$profile(InodeIdentifier)
+static KBuffer build_profile(bool consume_samples)
 {
     InterruptDisabler disabler;
     KBufferBuilder builder;
@@ -437,11 +513,31 @@ Optional<KBuffer> procfs$profile(InodeIdentifier)
     object.add("pid", Profiling::pid());
     object.add("executable", Profiling::executable_path());
 
+    if (Profiling::pid() == -1) {
+        // A system-wide profile has samples from many processes, so tell the
+        // viewer which executable to symbolicate each of them against.
+        auto processes_array = object.add_array("processes");
+        auto add_process = [&](pid_t pid, const String& executable) {
+            auto process_object = processes_array.add_object();
+            process_object.add("pid", pid);
+            process_object.add("executable", executable);
+        };
+        Profiling::for_each_executable([&](pid_t pid, const String& executable) {
+            add_process(pid, executable);
+        });
+        for (auto* process : Process::all_processes()) {
+            if (process->executable())
+                add_process(process->pid(), process->executable()->absolute_path());
+        }
+        processes_array.finish();
+    }
+
     auto array = object.add_array("events");
-    bool mask_kernel_addresses = !Process::current->is_superuser();
-    Profiling::for_each_sample([&](auto& sample) {
+    bool mask_kernel_addresses = !Process::current()->is_superuser();
+    auto add_sample = [&](auto& sample) {
         auto object = array.add_object();
         object.add("type", "sample");
+        object.add("pid", sample.pid);
         object.add("tid", sample.tid);
         object.add("timestamp", sample.timestamp);
         auto frames_array = object.add_array("stack");
@@ -454,12 +550,28 @@ Optional<KBuffer> procfs$profile(InodeIdentifier)
             frames_array.add(address);
         }
         frames_array.finish();
-    });
+    };
+    if (consume_samples)
+        Profiling::consume_samples([&](auto& sample) { add_sample(sample); });
+    else
+        Profiling::for_each_sample([&](auto& sample) { add_sample(sample); });
     array.finish();
+    if (consume_samples)
+        object.add("lost_samples", Profiling::lost_sample_count());
     object.finish();
     return builder.build();
 }
 
+Optional<KBuffer> procfs$profile(InodeIdentifier)
+{
+    return build_profile(false);
+}
+
+Optional<KBuffer> procfs$profile_stream(InodeIdentifier)
+{
+    return build_profile(true);
+}
+
 Optional<KBuffer> procfs$net_adapters(InodeIdentifier)
 {
     KBufferBuilder builder;
@@ -479,6 +591,8 @@ Optional<KBuffer> procfs$net_adapters(InodeIdentifier)
         obj.add("bytes_in", adapter.bytes_in());
         obj.add("packets_out", adapter.packets_out());
         obj.add("bytes_out", adapter.bytes_out());
+        obj.add("packets_dropped", adapter.packets_dropped());
+        obj.add("receive_overruns", adapter.receive_overruns());
         obj.add("link_up", adapter.link_up());
         obj.add("mtu", adapter.mtu());
     });
@@ -517,6 +631,18 @@ Optional<KBuffer> procfs$net_tcp(InodeIdentifier)
         obj.add("bytes_in", socket.bytes_in());
         obj.add("packets_out", socket.packets_out());
         obj.add("bytes_out", socket.bytes_out());
+        obj.add("retransmissions", socket.retransmissions());
+        obj.add("congestion_window", socket.congestion_window());
+        obj.add("slow_start_threshold", socket.slow_start_threshold());
+        obj.add("smoothed_rtt_ms", socket.smoothed_round_trip_time_ms());
+        obj.add("retransmission_timeout_ms", socket.retransmission_timeout_ms());
+        obj.add("timeouts", socket.timeouts());
+        obj.add("fast_retransmits", socket.fast_retransmits());
+        obj.add("duplicate_acks", socket.duplicate_acks());
+        obj.add("out_of_order_segments", socket.out_of_order_segments());
+        obj.add("receive_buffer_drops", socket.receive_buffer_drops());
+        obj.add("send_window", socket.send_window());
+        obj.add("bytes_in_flight", socket.bytes_in_flight());
     });
     array.finish();
     return builder.build();
@@ -537,6 +663,79 @@ Optional<KBuffer> procfs$net_udp(InodeIdentifier)
     return builder.build();
 }
 
+Optional<KBuffer> procfs$net_snmp(InodeIdentifier)
+{
+    auto& statistics = network_statistics();
+    KBufferBuilder builder;
+    JsonObjectSerializer json { builder };
+    {
+        auto ipv4 = json.add_object("ipv4");
+        ipv4.add("received", statistics.ipv4.received);
+        ipv4.add("header_errors", statistics.ipv4.header_errors);
+        ipv4.add("unknown_protocols", statistics.ipv4.unknown_protocols);
+        ipv4.add("delivered", statistics.ipv4.delivered);
+        ipv4.add("sent", statistics.ipv4.sent);
+        ipv4.add("fragments_created", statistics.ipv4.fragments_created);
+        ipv4.add("reassembly_required", statistics.ipv4.reassembly_required);
+        ipv4.add("reassembled", statistics.ipv4.reassembled);
+        ipv4.add("reassembly_failures", statistics.ipv4.reassembly_failures);
+    }
+    {
+        auto icmp = json.add_object("icmp");
+        icmp.add("received", statistics.icmp.received);
+        icmp.add("fragmentation_needed", statistics.icmp.fragmentation_needed);
+        icmp.add("sent", statistics.icmp.sent);
+    }
+    {
+        auto udp = json.add_object("udp");
+        udp.add("received", statistics.udp.received);
+        udp.add("no_port", statistics.udp.no_port);
+        udp.add("receive_buffer_errors", statistics.udp.receive_buffer_errors);
+        udp.add("sent", statistics.udp.sent);
+    }
+    {
+        auto tcp = json.add_object("tcp");
+        tcp.add("active_opens", statistics.tcp.active_opens);
+        tcp.add("passive_opens", statistics.tcp.passive_opens);
+        tcp.add("listen_drops", statistics.tcp.listen_drops);
+        tcp.add("received_segments", statistics.tcp.received_segments);
+        tcp.add("sent_segments", statistics.tcp.sent_segments);
+        tcp.add("retransmitted_segments", statistics.tcp.retransmitted_segments);
+        tcp.add("timeouts", statistics.tcp.timeouts);
+        tcp.add("fast_retransmits", statistics.tcp.fast_retransmits);
+        tcp.add("bad_segments", statistics.tcp.bad_segments);
+        tcp.add("no_socket", statistics.tcp.no_socket);
+        tcp.add("out_of_order_segments", statistics.tcp.out_of_order_segments);
+        tcp.add("receive_buffer_drops", statistics.tcp.receive_buffer_drops);
+        tcp.add("sent_resets", statistics.tcp.sent_resets);
+    }
+    json.finish();
+    return builder.build();
+}
+
+Optional<KBuffer> procfs$net_trace(InodeIdentifier)
+{
+    KBufferBuilder builder;
+    JsonArraySerializer array { builder };
+    NetworkTrace::for_each([&array](auto& event) {
+        auto obj = array.add_object();
+        obj.add("type", NetworkTrace::to_string(event.type));
+        obj.add("timestamp", (u64)event.timestamp.tv_sec * 1000000 + event.timestamp.tv_usec);
+        obj.add("local_address", event.local_address.to_string());
+        obj.add("local_port", event.local_port);
+        obj.add("peer_address", event.peer_address.to_string());
+        obj.add("peer_port", event.peer_port);
+        obj.add("sequence_number", event.sequence_number);
+        obj.add("ack_number", event.ack_number);
+        obj.add("length", event.length);
+        obj.add("flags", event.flags);
+        obj.add("window", event.window);
+        obj.add("congestion_window", event.congestion_window);
+    });
+    array.finish();
+    return builder.build();
+}
+
 Optional<KBuffer> procfs$net_local(InodeIdentifier)
 {
     KBufferBuilder builder;
@@ -550,11 +749,57 @@ Optional<KBuffer> procfs$net_local(InodeIdentifier)
         obj.add("acceptor_pid", socket.acceptor_pid());
         obj.add("acceptor_uid", socket.acceptor_uid());
         obj.add("acceptor_gid", socket.acceptor_gid());
+        obj.add("bytes_queued_for_client", socket.bytes_queued_for_client());
+        obj.add("bytes_queued_for_server", socket.bytes_queued_for_server());
+        obj.add("fds_queued_for_client", socket.fds_queued_for_client());
+        obj.add("fds_queued_for_server", socket.fds_queued_for_server());
     });
     array.finish();
     return builder.build();
 }
 
+Optional<KBuffer> procfs$pid_syscalls(InodeIdentifier identifier)
+{
+    auto handle = ProcessInspectionHandle::from_pid(to_pid(identifier));
+    if (!handle)
+        return {};
+    auto& process = handle->process();
+    KBufferBuilder builder;
+    JsonObjectSerializer object { builder };
+    object.add("enabled", process.is_syscall_accounting_enabled());
+    auto array = object.add_array("syscalls");
+    if (auto* statistics = process.recorded_syscall_statistics()) {
+        statistics->for_each_entry([&](Syscall::Function function, auto& entry) {
+            auto entry_object = array.add_object();
+            entry_object.add("name", Syscall::to_string(function));
+            entry_object.add("count", entry.count);
+            entry_object.add("total_ns", entry.total_ns);
+            entry_object.add("max_ns", entry.max_ns);
+            auto histogram_array = entry_object.add_array("latency_histogram");
+            for (auto bucket_count : entry.latency_histogram)
+                histogram_array.add(bucket_count);
+            histogram_array.finish();
+            auto errors_object = entry_object.add_object("errors");
+            for (auto& it : entry.error_counts)
+                errors_object.add(String::number(it.key), it.value);
+            errors_object.finish();
+        });
+    }
+    array.finish();
+    object.finish();
+    return builder.build();
+}
+
+static ssize_t write_pid_syscalls(InodeIdentifier identifier, const ByteBuffer& data)
+{
+    if (data.is_empty() || !(data[0] == '0' || data[0] == '1'))
+        return data.size();
+    auto handle = ProcessInspectionHandle::from_pid(to_pid(identifier));
+    if (handle)
+        handle->process().set_syscall_accounting_enabled(data[0] == '1');
+    return data.size();
+}
+
 Optional<KBuffer> procfs$pid_vmobjects(InodeIdentifier identifier)
 {
     auto handle = ProcessInspectionHandle::from_pid(to_pid(identifier));
@@ -676,7 +921,7 @@ Optional<KBuffer> procfs$pid_root(InodeIdentifier identifier)
 Optional<KBuffer> procfs$self(InodeIdentifier)
 {
     char buffer[16];
-    sprintf(buffer, "%u", Process::current->pid());
+    sprintf(buffer, "%u", Process::current()->pid());
     return KBuffer::copy((const u8*)buffer, strlen(buffer));
 }
 
@@ -746,15 +991,28 @@ Optional<KBuffer> procfs$df(InodeIdentifier)
         fs_object.add("readonly", fs.is_readonly());
         fs_object.add("mount_flags", mount.flags());
 
-        if (fs.is_file_backed())
-            fs_object.add("source", static_cast<const FileBackedFS&>(fs).file_description().absolute_path());
-        else
+        if (fs.is_file_backed()) {
+            auto& file_backed_fs = static_cast<const FileBackedFS&>(fs);
+            fs_object.add("source", file_backed_fs.file_description().absolute_path());
+            auto cache_statistics = file_backed_fs.cache_statistics();
+            fs_object.add("cache_hits", cache_statistics.hits);
+            fs_object.add("cache_misses", cache_statistics.misses);
+            fs_object.add("cache_evictions", cache_statistics.evictions);
+            fs_object.add("cache_block_count", cache_statistics.entry_count);
+            fs_object.add("cache_dirty_block_count", cache_statistics.dirty_count);
+        } else {
             fs_object.add("source", "none");
+        }
     });
     array.finish();
     return builder.build();
 }
 
+static u64 ns_to_ticks(u64 ns)
+{
+    return ns / (1'000'000'000 / TimeManagement::the().ticks_per_second());
+}
+
 Optional<KBuffer> procfs$cpuinfo(InodeIdentifier)
 {
     KBufferBuilder builder;
@@ -815,6 +1073,17 @@ Optional<KBuffer> procfs$cpuinfo(InodeIdentifier)
         copy_brand_string_part_to_buffer(2);
         builder.appendf("brandstr:  \"%s\"\n", buffer);
     }
+    {
+        InterruptDisabler disabler;
+        u64 now = TimeManagement::the().monotonic_time_ns();
+        Processor::for_each([&](Processor& processor) {
+            builder.appendf("\nprocessor: %u\n", processor.id());
+            builder.appendf("online:    %s\n", processor.is_online() ? "yes" : "no");
+            builder.appendf("busy:      %Q ticks\n", ns_to_ticks(processor.busy_time_ns(now)));
+            builder.appendf("idle:      %Q ticks\n", ns_to_ticks(processor.idle_time_ns(now)));
+            return IterationDecision::Continue;
+        });
+    }
     return builder.build();
 }
 
@@ -828,6 +1097,7 @@ Optional<KBuffer> procfs$memstat(InodeIdentifier)
     json.add("kmalloc_eternal_allocated", g_kmalloc_bytes_eternal);
     json.add("user_physical_allocated", MM.user_physical_pages_used());
     json.add("user_physical_available", MM.user_physical_pages() - MM.user_physical_pages_used());
+    json.add("user_physical_zeroed", MM.zeroed_page_pool_size());
     json.add("super_physical_allocated", MM.super_physical_pages_used());
     json.add("super_physical_available", MM.super_physical_pages() - MM.super_physical_pages_used());
     json.add("kmalloc_call_count", g_kmalloc_call_count);
@@ -837,42 +1107,58 @@ Optional<KBuffer> procfs$memstat(InodeIdentifier)
         json.add(String::format("%s_num_allocated", prefix.characters()), num_allocated);
         json.add(String::format("%s_num_free", prefix.characters()), num_free);
     });
+    kmalloc_size_class_stats([&json](size_t size_class, size_t num_allocated, size_t num_free) {
+        auto prefix = String::format("kmalloc_%zu", size_class);
+        json.add(String::format("%s_num_allocated", prefix.characters()), num_allocated);
+        json.add(String::format("%s_num_free", prefix.characters()), num_free);
+    });
+    MM.for_each_physical_free_block_order([&json](size_t order, size_t user_blocks, size_t super_blocks) {
+        json.add(String::format("user_physical_free_blocks_order_%zu", order), user_blocks);
+        json.add(String::format("super_physical_free_blocks_order_%zu", order), super_blocks);
+    });
     json.finish();
     return builder.build();
 }
 
+static String pledge_string(const Process& process)
+{
+    StringBuilder pledge_builder;
+#define __ENUMERATE_PLEDGE_PROMISE(promise)      \
+    if (process.has_promised(Pledge::promise)) { \
+        pledge_builder.append(#promise " ");     \
+    }
+    ENUMERATE_PLEDGE_PROMISES
+#undef __ENUMERATE_PLEDGE_PROMISE
+    return pledge_builder.to_string();
+}
+
+static const char* veil_string(const Process& process)
+{
+    switch (process.veil_state()) {
+    case VeilState::None:
+        return "None";
+    case VeilState::Dropped:
+        return "Dropped";
+    case VeilState::Locked:
+        return "Locked";
+    }
+    ASSERT_NOT_REACHED();
+}
+
 Optional<KBuffer> procfs$all(InodeIdentifier)
 {
     InterruptDisabler disabler;
     auto processes = Process::all_processes();
     KBufferBuilder builder;
-    JsonArraySerializer array { builder };
+    JsonObjectSerializer<KBufferBuilder> json { builder };
 
-    // Keep this in sync with CProcessStatistics.
+    // Keep this in sync with CProcessStatistics, and with procfs$all_bin.
+    auto array = json.add_array("processes");
     auto build_process = [&](const Process& process) {
         auto process_object = array.add_object();
 
-        StringBuilder pledge_builder;
-#define __ENUMERATE_PLEDGE_PROMISE(promise)      \
-    if (process.has_promised(Pledge::promise)) { \
-        pledge_builder.append(#promise " ");     \
-    }
-        ENUMERATE_PLEDGE_PROMISES
-#undef __ENUMERATE_PLEDGE_PROMISE
-
-        process_object.add("pledge", pledge_builder.to_string());
-
-        switch (process.veil_state()) {
-        case VeilState::None:
-            process_object.add("veil", "None");
-            break;
-        case VeilState::Dropped:
-            process_object.add("veil", "Dropped");
-            break;
-        case VeilState::Locked:
-            process_object.add("veil", "Locked");
-            break;
-        }
+        process_object.add("pledge", pledge_string(process));
+        process_object.add("veil", veil_string(process));
 
         process_object.add("pid", process.pid());
         process_object.add("pgid", process.tty() ? process.tty()->pgid() : 0);
@@ -899,6 +1185,16 @@ Optional<KBuffer> procfs$all(InodeIdentifier)
             thread_object.add("name", thread.name());
             thread_object.add("times_scheduled", thread.times_scheduled());
             thread_object.add("ticks", thread.ticks());
+            auto state_times = thread.state_times();
+            thread_object.add("running_ns", state_times.running_ns);
+            thread_object.add("runnable_ns", state_times.runnable_ns);
+            thread_object.add("blocked_ns", state_times.blocked_ns);
+            auto blocked_object = thread_object.add_object("blocked_ns_by_reason");
+            for (auto& blocked : state_times.blocked) {
+                if (blocked.reason)
+                    blocked_object.add(blocked.reason, blocked.ns);
+            }
+            blocked_object.finish();
             thread_object.add("state", thread.state_string());
             thread_object.add("priority", thread.priority());
             thread_object.add("effective_priority", thread.effective_priority());
@@ -912,6 +1208,16 @@ Optional<KBuffer> procfs$all(InodeIdentifier)
             thread_object.add("unix_socket_write_bytes", thread.unix_socket_write_bytes());
             thread_object.add("ipv4_socket_read_bytes", thread.ipv4_socket_read_bytes());
             thread_object.add("ipv4_socket_write_bytes", thread.ipv4_socket_write_bytes());
+            auto& perf_counter_config = thread.process().perf_counter_config();
+            if (perf_counter_config.event_mask) {
+                auto counters_object = thread_object.add_object("perf_counters");
+                for (size_t i = 0; i < PerformanceCounters::event_count; ++i) {
+                    auto event = (PerformanceCounters::Event)i;
+                    if (perf_counter_config.is_counting(event))
+                        counters_object.add(PerformanceCounters::to_string(event), thread.perf_counters().counts[i]);
+                }
+                counters_object.finish();
+            }
             return IterationDecision::Continue;
         });
     };
@@ -919,6 +1225,147 @@ Optional<KBuffer> procfs$all(InodeIdentifier)
     for (auto* process : processes)
         build_process(*process);
     array.finish();
+
+    u64 now = TimeManagement::the().monotonic_time_ns();
+    auto processor_array = json.add_array("processors");
+    Processor::for_each([&](Processor& processor) {
+        auto processor_object = processor_array.add_object();
+        processor_object.add("id", processor.id());
+        processor_object.add("online", processor.is_online());
+        processor_object.add("busy_ticks", ns_to_ticks(processor.busy_time_ns(now)));
+        processor_object.add("idle_ticks", ns_to_ticks(processor.idle_time_ns(now)));
+        return IterationDecision::Continue;
+    });
+    processor_array.finish();
+    json.finish();
+    return builder.build();
+}
+
+template<typename Record>
+static void append_snapshot_record(KBufferBuilder& builder, const Record& record)
+{
+    builder.append((const char*)&record, sizeof(record));
+}
+
+// The same as procfs$all, laid out as described in Kernel/ProcessSnapshot.h.
+Optional<KBuffer> procfs$all_bin(InodeIdentifier)
+{
+    InterruptDisabler disabler;
+    auto processes = Process::all_processes();
+    KBufferBuilder builder;
+
+    u32 processor_count = 0;
+    Processor::for_each([&](Processor&) {
+        ++processor_count;
+        return IterationDecision::Continue;
+    });
+
+    ProcessSnapshotHeader header;
+    header.magic = process_snapshot_magic;
+    header.version = process_snapshot_version;
+    header.processor_count = processor_count;
+    header.process_count = processes.size() + 1;
+    append_snapshot_record(builder, header);
+
+    u64 now = TimeManagement::the().monotonic_time_ns();
+    Processor::for_each([&](Processor& processor) {
+        ProcessorSnapshot processor_snapshot;
+        processor_snapshot.id = processor.id();
+        processor_snapshot.online = processor.is_online();
+        processor_snapshot.busy_ticks = ns_to_ticks(processor.busy_time_ns(now));
+        processor_snapshot.idle_ticks = ns_to_ticks(processor.idle_time_ns(now));
+        append_snapshot_record(builder, processor_snapshot);
+        return IterationDecision::Continue;
+    });
+
+    auto build_process = [&](const Process& process) {
+        auto pledge = pledge_string(process);
+        StringView veil = veil_string(process);
+        String tty = process.tty() ? process.tty()->tty_name() : "notty";
+        u32 thread_count = 0;
+        process.for_each_thread([&](const Thread&) {
+            ++thread_count;
+            return IterationDecision::Continue;
+        });
+
+        ProcessSnapshot process_snapshot;
+        process_snapshot.pid = process.pid();
+        process_snapshot.pgid = process.tty() ? process.tty()->pgid() : 0;
+        process_snapshot.pgp = process.pgid();
+        process_snapshot.sid = process.sid();
+        process_snapshot.uid = process.uid();
+        process_snapshot.gid = process.gid();
+        process_snapshot.ppid = process.ppid();
+        process_snapshot.nfds = process.number_of_open_file_descriptors();
+        process_snapshot.amount_virtual = process.amount_virtual();
+        process_snapshot.amount_resident = process.amount_resident();
+        process_snapshot.amount_shared = process.amount_shared();
+        process_snapshot.amount_dirty_private = process.amount_dirty_private();
+        process_snapshot.amount_clean_inode = process.amount_clean_inode();
+        process_snapshot.amount_purgeable_volatile = process.amount_purgeable_volatile();
+        process_snapshot.amount_purgeable_nonvolatile = process.amount_purgeable_nonvolatile();
+        process_snapshot.icon_id = process.icon_id();
+        process_snapshot.name_length = process.name().length();
+        process_snapshot.tty_length = tty.length();
+        process_snapshot.pledge_length = pledge.length();
+        process_snapshot.veil_length = veil.length();
+        process_snapshot.thread_count = thread_count;
+        append_snapshot_record(builder, process_snapshot);
+        builder.append(process.name());
+        builder.append(tty);
+        builder.append(pledge);
+        builder.append(veil);
+
+        process.for_each_thread([&](const Thread& thread) {
+            auto state_times = thread.state_times();
+            StringView state = thread.state_string();
+
+            ThreadSnapshot thread_snapshot;
+            thread_snapshot.tid = thread.tid();
+            thread_snapshot.times_scheduled = thread.times_scheduled();
+            thread_snapshot.ticks = thread.ticks();
+            thread_snapshot.syscall_count = thread.syscall_count();
+            thread_snapshot.inode_faults = thread.inode_faults();
+            thread_snapshot.zero_faults = thread.zero_faults();
+            thread_snapshot.cow_faults = thread.cow_faults();
+            thread_snapshot.unix_socket_read_bytes = thread.unix_socket_read_bytes();
+            thread_snapshot.unix_socket_write_bytes = thread.unix_socket_write_bytes();
+            thread_snapshot.ipv4_socket_read_bytes = thread.ipv4_socket_read_bytes();
+            thread_snapshot.ipv4_socket_write_bytes = thread.ipv4_socket_write_bytes();
+            thread_snapshot.file_read_bytes = thread.file_read_bytes();
+            thread_snapshot.file_write_bytes = thread.file_write_bytes();
+            thread_snapshot.running_ns = state_times.running_ns;
+            thread_snapshot.runnable_ns = state_times.runnable_ns;
+            thread_snapshot.blocked_ns = state_times.blocked_ns;
+            thread_snapshot.priority = thread.priority();
+            thread_snapshot.effective_priority = thread.effective_priority();
+            thread_snapshot.name_length = thread.name().length();
+            thread_snapshot.state_length = state.length();
+            thread_snapshot.blocked_reason_count = 0;
+            for (auto& blocked : state_times.blocked) {
+                if (blocked.reason)
+                    ++thread_snapshot.blocked_reason_count;
+            }
+            append_snapshot_record(builder, thread_snapshot);
+            builder.append(thread.name());
+            builder.append(state);
+
+            for (auto& blocked : state_times.blocked) {
+                if (!blocked.reason)
+                    continue;
+                StringView reason = blocked.reason;
+                BlockedReasonSnapshot blocked_snapshot;
+                blocked_snapshot.ns = blocked.ns;
+                blocked_snapshot.reason_length = reason.length();
+                append_snapshot_record(builder, blocked_snapshot);
+                builder.append(reason);
+            }
+            return IterationDecision::Continue;
+        });
+    };
+    build_process(*Scheduler::colonel());
+    for (auto* process : processes)
+        build_process(*process);
     return builder.build();
 }
 
@@ -1166,6 +1613,9 @@ InodeMetadata ProcFSInode::metadata() const
     case FI_PID_fd:
         metadata.mode = 040500;
         break;
+    case FI_PID_syscalls:
+        metadata.mode = 0100644;
+        break;
     default:
         metadata.mode = 0100444;
         break;
@@ -1298,6 +1748,8 @@ KResult ProcFSInode::traverse_as_directory(Function<bool(const FS::DirectoryEntr
         callback({ "tcp", 3, to_identifier(fsid(), PDI_Root_net, 0, FI_Root_net_tcp), 0 });
         callback({ "udp", 3, to_identifier(fsid(), PDI_Root_net, 0, FI_Root_net_udp), 0 });
         callback({ "local", 5, to_identifier(fsid(), PDI_Root_net, 0, FI_Root_net_local), 0 });
+        callback({ "snmp", 4, to_identifier(fsid(), PDI_Root_net, 0, FI_Root_net_snmp), 0 });
+        callback({ "trace", 5, to_identifier(fsid(), PDI_Root_net, 0, FI_Root_net_trace), 0 });
         break;
 
     case FI_PID: {
@@ -1390,6 +1842,10 @@ RefPtr<Inode> ProcFSInode::lookup(StringView name)
             return fs().get_inode(to_identifier(fsid(), PDI_Root, 0, FI_Root_net_udp));
         if (name == "local")
             return fs().get_inode(to_identifier(fsid(), PDI_Root, 0, FI_Root_net_local));
+        if (name == "snmp")
+            return fs().get_inode(to_identifier(fsid(), PDI_Root, 0, FI_Root_net_snmp));
+        if (name == "trace")
+            return fs().get_inode(to_identifier(fsid(), PDI_Root, 0, FI_Root_net_trace));
         return {};
     }
 
@@ -1465,7 +1921,7 @@ ssize_t ProcFSInode::write_bytes(off_t offset, ssize_t size, const u8* buffer, F
         write_callback = &directory_entry->write_callback;
     }
 
-    ASSERT(is_persistent_inode(identifier()));
+    ASSERT(is_persistent_inode(identifier()) || is_process_related_file(identifier()));
     // FIXME: Being able to write into ProcFS at a non-zero offset seems like something we should maybe support..
     ASSERT(offset == 0);
     bool success = (*write_callback)(identifier(), ByteBuffer::wrap(buffer, size));
@@ -1622,7 +2078,9 @@ ProcFS::ProcFS()
     m_entries[FI_Root_mounts] = { "mounts", FI_Root_mounts, false, procfs$mounts };
     m_entries[FI_Root_df] = { "df", FI_Root_df, false, procfs$df };
     m_entries[FI_Root_all] = { "all", FI_Root_all, false, procfs$all };
+    m_entries[FI_Root_all_bin] = { "all.bin", FI_Root_all_bin, false, procfs$all_bin };
     m_entries[FI_Root_memstat] = { "memstat", FI_Root_memstat, false, procfs$memstat };
+    m_entries[FI_Root_slabs] = { "slabs", FI_Root_slabs, false, procfs$slabs };
     m_entries[FI_Root_cpuinfo] = { "cpuinfo", FI_Root_cpuinfo, false, procfs$cpuinfo };
     m_entries[FI_Root_inodes] = { "inodes", FI_Root_inodes, true, procfs$inodes };
     m_entries[FI_Root_dmesg] = { "dmesg", FI_Root_dmesg, true, procfs$dmesg };
@@ -1634,6 +2092,8 @@ ProcFS::ProcFS()
     m_entries[FI_Root_cmdline] = { "cmdline", FI_Root_cmdline, true, procfs$cmdline };
     m_entries[FI_Root_modules] = { "modules", FI_Root_modules, true, procfs$modules };
     m_entries[FI_Root_profile] = { "profile", FI_Root_profile, false, procfs$profile };
+    m_entries[FI_Root_profile_stream] = { "profile_stream", FI_Root_profile_stream, false, procfs$profile_stream };
+    m_entries[FI_Root_locks] = { "locks", FI_Root_locks, false, procfs$locks };
     m_entries[FI_Root_sys] = { "sys", FI_Root_sys, true };
     m_entries[FI_Root_net] = { "net", FI_Root_net, false };
 
@@ -1642,6 +2102,8 @@ ProcFS::ProcFS()
     m_entries[FI_Root_net_tcp] = { "tcp", FI_Root_net_tcp, false, procfs$net_tcp };
     m_entries[FI_Root_net_udp] = { "udp", FI_Root_net_udp, false, procfs$net_udp };
     m_entries[FI_Root_net_local] = { "local", FI_Root_net_local, false, procfs$net_local };
+    m_entries[FI_Root_net_snmp] = { "snmp", FI_Root_net_snmp, false, procfs$net_snmp };
+    m_entries[FI_Root_net_trace] = { "trace", FI_Root_net_trace, false, procfs$net_trace };
 
     m_entries[FI_PID_vm] = { "vm", FI_PID_vm, false, procfs$pid_vm };
     m_entries[FI_PID_vmobjects] = { "vmobjects", FI_PID_vmobjects, true, procfs$pid_vmobjects };
@@ -1651,6 +2113,7 @@ ProcFS::ProcFS()
     m_entries[FI_PID_exe] = { "exe", FI_PID_exe, false, procfs$pid_exe };
     m_entries[FI_PID_cwd] = { "cwd", FI_PID_cwd, false, procfs$pid_cwd };
     m_entries[FI_PID_unveil] = { "unveil", FI_PID_unveil, false, procfs$pid_unveil };
+    m_entries[FI_PID_syscalls] = { "syscalls", FI_PID_syscalls, false, procfs$pid_syscalls, write_pid_syscalls };
     m_entries[FI_PID_root] = { "root", FI_PID_root, false, procfs$pid_root };
     m_entries[FI_PID_fd] = { "fd", FI_PID_fd, false };
 }
@@ -24,9 +24,11 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <AK/StringView.h>
 #include <Kernel/FileSystem/TmpFS.h>
 #include <Kernel/Process.h>
 #include <Kernel/Thread.h>
+#include <Kernel/VM/MemoryManager.h>
 
 namespace Kernel {
 
@@ -181,6 +183,34 @@ KResult TmpFSInode::traverse_as_directory(Function<bool(const FS::DirectoryEntry
     return KSuccess;
 }
 
+void TmpFSInode::copy_from_page(const PhysicalPage& page, size_t offset_in_page, u8* buffer, size_t size)
+{
+    // The destination may be a userspace buffer that faults, so don't touch it while the page is quickmapped.
+    u8 bounce_buffer[PAGE_SIZE];
+    {
+        InterruptDisabler disabler;
+        memcpy(bounce_buffer, MM.quickmap_page(const_cast<PhysicalPage&>(page)) + offset_in_page, size);
+        MM.unquickmap_page();
+    }
+    memcpy(buffer, bounce_buffer, size);
+}
+
+void TmpFSInode::copy_to_page(PhysicalPage& page, size_t offset_in_page, const u8* buffer, size_t size)
+{
+    u8 bounce_buffer[PAGE_SIZE];
+    memcpy(bounce_buffer, buffer, size);
+    InterruptDisabler disabler;
+    memcpy(MM.quickmap_page(page) + offset_in_page, bounce_buffer, size);
+    MM.unquickmap_page();
+}
+
+void TmpFSInode::zero_fill_page(PhysicalPage& page, size_t offset_in_page, size_t size)
+{
+    InterruptDisabler disabler;
+    memset(MM.quickmap_page(page) + offset_in_page, 0, size);
+    MM.unquickmap_page();
+}
+
 ssize_t TmpFSInode::read_bytes(off_t offset, ssize_t size, u8* buffer, FileDescription*) const
 {
     LOCKER(m_lock, Lock::Mode::Shared);
@@ -188,17 +218,24 @@ ssize_t TmpFSInode::read_bytes(off_t offset, ssize_t size, u8* buffer, FileDescr
     ASSERT(size >= 0);
     ASSERT(offset >= 0);
 
-    if (!m_content.has_value())
-        return 0;
-
     if (offset >= m_metadata.size)
         return 0;
 
     if (static_cast<off_t>(size) > m_metadata.size - offset)
         size = m_metadata.size - offset;
 
-    memcpy(buffer, m_content.value().data() + offset, size);
-    return size;
+    ssize_t nread = 0;
+    while (nread < size) {
+        size_t page_index = (offset + nread) / PAGE_SIZE;
+        size_t offset_in_page = (offset + nread) % PAGE_SIZE;
+        size_t chunk_size = min(static_cast<size_t>(size - nread), PAGE_SIZE - offset_in_page);
+        if (auto& page = m_pages[page_index])
+            copy_from_page(*page, offset_in_page, buffer + nread, chunk_size);
+        else
+            memset(buffer + nread, 0, chunk_size);
+        nread += chunk_size;
+    }
+    return nread;
 }
 
 ssize_t TmpFSInode::write_bytes(off_t offset, ssize_t size, const u8* buffer, FileDescription*)
@@ -211,38 +248,53 @@ ssize_t TmpFSInode::write_bytes(off_t offset, ssize_t size, const u8* buffer, Fi
     if (result.is_error())
         return result;
 
+    // Pages are added as the file grows, so appending never has to move the existing contents.
+    size_t needed_page_count = PAGE_ROUND_UP(offset + size) / PAGE_SIZE;
+    if (m_pages.size() < needed_page_count)
+        m_pages.resize(needed_page_count);
+
+    ssize_t nwritten = 0;
+    while (nwritten < size) {
+        size_t page_index = (offset + nwritten) / PAGE_SIZE;
+        size_t offset_in_page = (offset + nwritten) % PAGE_SIZE;
+        size_t chunk_size = min(static_cast<size_t>(size - nwritten), PAGE_SIZE - offset_in_page);
+        auto& page = m_pages[page_index];
+        if (!page) {
+            page = MM.allocate_user_physical_page(MemoryManager::ShouldZeroFill::Yes);
+            if (!page)
+                break;
+        }
+        copy_to_page(*page, offset_in_page, buffer + nwritten, chunk_size);
+        nwritten += chunk_size;
+    }
+
     off_t old_size = m_metadata.size;
-    off_t new_size = m_metadata.size;
-    if ((offset + size) > new_size)
-        new_size = offset + size;
+    off_t new_size = max(old_size, offset + nwritten);
+    m_pages.resize(PAGE_ROUND_UP(new_size) / PAGE_SIZE);
+    if (nwritten == 0 && size > 0)
+        return -ENOMEM;
 
     if (new_size > old_size) {
-        if (m_content.has_value() && m_content.value().capacity() >= (size_t)new_size) {
-            m_content.value().set_size(new_size);
-        } else {
-            // Grow the content buffer 2x the new sizeto accomodate repeating write() calls.
-            // Note that we're not actually committing physical memory to the buffer
-            // until it's needed. We only grow VM here.
-
-            // FIXME: Fix this so that no memcpy() is necessary, and we can just grow the
-            //        KBuffer and it will add physical pages as needed while keeping the
-            //        existing ones.
-            auto tmp = KBuffer::create_with_size(new_size * 2);
-            tmp.set_size(new_size);
-            if (m_content.has_value())
-                memcpy(tmp.data(), m_content.value().data(), old_size);
-            m_content = move(tmp);
-        }
         m_metadata.size = new_size;
         set_metadata_dirty(true);
         set_metadata_dirty(false);
         inode_size_changed(old_size, new_size);
     }
 
-    memcpy(m_content.value().data() + offset, buffer, size);
-    inode_contents_changed(offset, size, buffer);
+    inode_contents_changed(offset, nwritten, buffer);
+    return nwritten;
+}
 
-    return size;
+RefPtr<PhysicalPage> TmpFSInode::backing_physical_page(size_t page_index)
+{
+    LOCKER(m_lock);
+    if (page_index >= m_pages.size())
+        return nullptr;
+    // Holes get a page of their own now, so that writes through the mapping end up in the file.
+    auto& page = m_pages[page_index];
+    if (!page)
+        page = MM.allocate_user_physical_page(MemoryManager::ShouldZeroFill::Yes);
+    return page;
 }
 
 RefPtr<Inode> TmpFSInode::lookup(StringView name)
@@ -313,6 +365,7 @@ KResult TmpFSInode::add_child(InodeIdentifier child_id, const StringView& name,
     m_children.set(owned_name, { entry, move(child) });
     set_metadata_dirty(true);
     set_metadata_dirty(false);
+    did_add_child(name);
     return KSuccess;
 }
 
@@ -330,6 +383,7 @@ KResult TmpFSInode::remove_child(const StringView& name)
     m_children.remove(it);
     set_metadata_dirty(true);
     set_metadata_dirty(false);
+    did_remove_child(name);
     return KSuccess;
 }
 
@@ -338,31 +392,23 @@ KResult TmpFSInode::truncate(u64 size)
     LOCKER(m_lock);
     ASSERT(!is_directory());
 
-    if (size == 0)
-        m_content.clear();
-    else if (!m_content.has_value()) {
-        m_content = KBuffer::create_with_size(size);
-    } else if (static_cast<size_t>(size) < m_content.value().capacity()) {
-        size_t prev_size = m_metadata.size;
-        m_content.value().set_size(size);
-        if (prev_size < static_cast<size_t>(size))
-            memset(m_content.value().data() + prev_size, 0, size - prev_size);
-    } else {
-        size_t prev_size = m_metadata.size;
-        KBuffer tmp = KBuffer::create_with_size(size);
-        memcpy(tmp.data(), m_content.value().data(), prev_size);
-        m_content = move(tmp);
+    size_t old_size = m_metadata.size;
+    if (size < old_size) {
+        // Whatever is left of the last page past the new end has to read as zeroes if the file grows again.
+        size_t offset_in_page = size % PAGE_SIZE;
+        size_t page_index = size / PAGE_SIZE;
+        if (offset_in_page && page_index < m_pages.size() && m_pages[page_index])
+            zero_fill_page(*m_pages[page_index], offset_in_page, PAGE_SIZE - offset_in_page);
     }
+    m_pages.resize(PAGE_ROUND_UP(size) / PAGE_SIZE);
 
-    size_t old_size = m_metadata.size;
     m_metadata.size = size;
     set_metadata_dirty(true);
     set_metadata_dirty(false);
 
     if (old_size != (size_t)size) {
         inode_size_changed(old_size, size);
-        if (m_content.has_value())
-            inode_contents_changed(0, size, m_content.value().data());
+        inode_contents_changed(0, size, nullptr);
     }
 
     return KSuccess;
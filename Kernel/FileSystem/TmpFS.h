@@ -30,7 +30,7 @@
 #include <AK/Optional.h>
 #include <Kernel/FileSystem/FileSystem.h>
 #include <Kernel/FileSystem/Inode.h>
-#include <Kernel/KBuffer.h>
+#include <Kernel/VM/PhysicalPage.h>
 
 namespace Kernel {
 
@@ -93,16 +93,22 @@ public:
     virtual int set_ctime(time_t) override;
     virtual int set_mtime(time_t) override;
     virtual void one_ref_left() override;
+    virtual RefPtr<PhysicalPage> backing_physical_page(size_t) override;
 
 private:
     TmpFSInode(TmpFS& fs, InodeMetadata metadata, InodeIdentifier parent);
     static NonnullRefPtr<TmpFSInode> create(TmpFS&, InodeMetadata metadata, InodeIdentifier parent);
     static NonnullRefPtr<TmpFSInode> create_root(TmpFS&);
 
+    static void copy_from_page(const PhysicalPage&, size_t offset_in_page, u8* buffer, size_t size);
+    static void copy_to_page(PhysicalPage&, size_t offset_in_page, const u8* buffer, size_t size);
+    static void zero_fill_page(PhysicalPage&, size_t offset_in_page, size_t size);
+
     InodeMetadata m_metadata;
     InodeIdentifier m_parent;
 
-    Optional<KBuffer> m_content;
+    // File contents, one physical page at a time. Pages that were never written to are null and read as zeroes.
+    Vector<RefPtr<PhysicalPage>> m_pages;
     struct Child {
         FS::DirectoryEntry entry;
         NonnullRefPtr<TmpFSInode> inode;
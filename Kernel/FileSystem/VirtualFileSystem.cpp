@@ -77,6 +77,7 @@ KResult VFS::mount(FS& file_system, Custody& mount_point, int flags)
     // FIXME: check that this is not already a mount point
     Mount mount { file_system, &mount_point, flags };
     m_mounts.append(move(mount));
+    invalidate_dentry_cache();
     return KSuccess;
 }
 
@@ -88,6 +89,7 @@ KResult VFS::bind_mount(Custody& source, Custody& mount_point, int flags)
     // FIXME: check that this is not already a mount point
     Mount mount { source.inode(), mount_point, flags };
     m_mounts.append(move(mount));
+    invalidate_dentry_cache();
     return KSuccess;
 }
 
@@ -102,6 +104,7 @@ KResult VFS::remount(Custody& mount_point, int new_flags)
         return KResult(-ENODEV);
 
     mount->set_flags(new_flags);
+    invalidate_dentry_cache();
     return KSuccess;
 }
 
@@ -120,6 +123,7 @@ KResult VFS::unmount(InodeIdentifier guest_inode_id)
             }
             dbg() << "VFS: found fs " << mount.guest_fs().fsid() << " at mount index " << i << "! Unmounting...";
             m_mounts.unstable_remove(i);
+            invalidate_dentry_cache();
             return KSuccess;
         }
     }
@@ -201,7 +205,7 @@ KResult VFS::utime(StringView path, Custody& base, time_t atime, time_t mtime)
         return custody_or_error.error();
     auto& custody = *custody_or_error.value();
     auto& inode = custody.inode();
-    if (!Process::current->is_superuser() && inode.metadata().uid != Process::current->euid())
+    if (!Process::current()->is_superuser() && inode.metadata().uid != Process::current()->euid())
         return KResult(-EACCES);
     if (custody.is_readonly())
         return KResult(-EROFS);
@@ -253,18 +257,18 @@ KResultOr<NonnullRefPtr<FileDescription>> VFS::open(StringView path, int options
 
     bool should_truncate_file = false;
 
-    if ((options & O_RDONLY) && !metadata.may_read(*Process::current))
+    if ((options & O_RDONLY) && !metadata.may_read(*Process::current()))
         return KResult(-EACCES);
 
     if (options & O_WRONLY) {
-        if (!metadata.may_write(*Process::current))
+        if (!metadata.may_write(*Process::current()))
             return KResult(-EACCES);
         if (metadata.is_directory())
             return KResult(-EISDIR);
         should_truncate_file = options & O_TRUNC;
     }
     if (options & O_EXEC) {
-        if (!metadata.may_execute(*Process::current) || (custody.mount_flags() & MS_NOEXEC))
+        if (!metadata.may_execute(*Process::current()) || (custody.mount_flags() & MS_NOEXEC))
             return KResult(-EACCES);
     }
 
@@ -314,14 +318,16 @@ KResult VFS::mknod(StringView path, mode_t mode, dev_t dev, Custody& base)
     if (existing_file_or_error.error() != -ENOENT)
         return existing_file_or_error.error();
     auto& parent_inode = parent_custody->inode();
-    if (!parent_inode.metadata().may_write(*Process::current))
+    if (!parent_inode.metadata().may_write(*Process::current()))
         return KResult(-EACCES);
     if (parent_custody->is_readonly())
         return KResult(-EROFS);
 
     LexicalPath p(path);
     dbg() << "VFS::mknod: '" << p.basename() << "' mode=" << mode << " dev=" << dev << " in " << parent_inode.identifier();
-    return parent_inode.fs().create_inode(parent_inode.identifier(), p.basename(), mode, 0, dev, Process::current->uid(), Process::current->gid()).result();
+    auto result = parent_inode.fs().create_inode(parent_inode.identifier(), p.basename(), mode, 0, dev, Process::current()->uid(), Process::current()->gid()).result();
+    invalidate_dentry(parent_inode, p.basename());
+    return result;
 }
 
 KResultOr<NonnullRefPtr<FileDescription>> VFS::create(StringView path, int options, mode_t mode, Custody& parent_custody, Optional<UidAndGid> owner)
@@ -336,7 +342,7 @@ KResultOr<NonnullRefPtr<FileDescription>> VFS::create(StringView path, int optio
     }
 
     auto& parent_inode = parent_custody.inode();
-    if (!parent_inode.metadata().may_write(*Process::current))
+    if (!parent_inode.metadata().may_write(*Process::current()))
         return KResult(-EACCES);
     if (parent_custody.is_readonly())
         return KResult(-EROFS);
@@ -345,9 +351,10 @@ KResultOr<NonnullRefPtr<FileDescription>> VFS::create(StringView path, int optio
 #ifdef VFS_DEBUG
     dbg() << "VFS::create: '" << p.basename() << "' in " << parent_inode.identifier();
 #endif
-    uid_t uid = owner.has_value() ? owner.value().uid : Process::current->uid();
-    gid_t gid = owner.has_value() ? owner.value().gid : Process::current->gid();
+    uid_t uid = owner.has_value() ? owner.value().uid : Process::current()->uid();
+    gid_t gid = owner.has_value() ? owner.value().gid : Process::current()->gid();
     auto inode_or_error = parent_inode.fs().create_inode(parent_inode.identifier(), p.basename(), mode, 0, 0, uid, gid);
+    invalidate_dentry(parent_inode, p.basename());
     if (inode_or_error.is_error())
         return inode_or_error.error();
 
@@ -377,7 +384,7 @@ KResult VFS::mkdir(StringView path, mode_t mode, Custody& base)
         return result.error();
 
     auto& parent_inode = parent_custody->inode();
-    if (!parent_inode.metadata().may_write(*Process::current))
+    if (!parent_inode.metadata().may_write(*Process::current()))
         return KResult(-EACCES);
     if (parent_custody->is_readonly())
         return KResult(-EROFS);
@@ -386,7 +393,9 @@ KResult VFS::mkdir(StringView path, mode_t mode, Custody& base)
 #ifdef VFS_DEBUG
     dbg() << "VFS::mkdir: '" << p.basename() << "' in " << parent_inode.identifier();
 #endif
-    return parent_inode.fs().create_directory(parent_inode.identifier(), p.basename(), mode, Process::current->uid(), Process::current->gid());
+    auto create_result = parent_inode.fs().create_directory(parent_inode.identifier(), p.basename(), mode, Process::current()->uid(), Process::current()->gid());
+    invalidate_dentry(parent_inode, p.basename());
+    return create_result;
 }
 
 KResult VFS::access(StringView path, int mode, Custody& base)
@@ -398,17 +407,17 @@ KResult VFS::access(StringView path, int mode, Custody& base)
     auto& inode = custody.inode();
     auto metadata = inode.metadata();
     if (mode & R_OK) {
-        if (!metadata.may_read(*Process::current))
+        if (!metadata.may_read(*Process::current()))
             return KResult(-EACCES);
     }
     if (mode & W_OK) {
-        if (!metadata.may_write(*Process::current))
+        if (!metadata.may_write(*Process::current()))
             return KResult(-EACCES);
         if (custody.is_readonly())
             return KResult(-EROFS);
     }
     if (mode & X_OK) {
-        if (!metadata.may_execute(*Process::current))
+        if (!metadata.may_execute(*Process::current()))
             return KResult(-EACCES);
     }
     return KSuccess;
@@ -423,7 +432,7 @@ KResultOr<NonnullRefPtr<Custody>> VFS::open_directory(StringView path, Custody&
     auto& inode = custody.inode();
     if (!inode.is_directory())
         return KResult(-ENOTDIR);
-    if (!inode.metadata().may_execute(*Process::current))
+    if (!inode.metadata().may_execute(*Process::current()))
         return KResult(-EACCES);
     return custody;
 }
@@ -432,7 +441,7 @@ KResult VFS::chmod(Custody& custody, mode_t mode)
 {
     auto& inode = custody.inode();
 
-    if (Process::current->euid() != inode.metadata().uid && !Process::current->is_superuser())
+    if (Process::current()->euid() != inode.metadata().uid && !Process::current()->is_superuser())
         return KResult(-EPERM);
     if (custody.is_readonly())
         return KResult(-EROFS);
@@ -473,14 +482,14 @@ KResult VFS::rename(StringView old_path, StringView new_path, Custody& base)
     if (&old_parent_inode.fs() != &new_parent_inode.fs())
         return KResult(-EXDEV);
 
-    if (!new_parent_inode.metadata().may_write(*Process::current))
+    if (!new_parent_inode.metadata().may_write(*Process::current()))
         return KResult(-EACCES);
 
-    if (!old_parent_inode.metadata().may_write(*Process::current))
+    if (!old_parent_inode.metadata().may_write(*Process::current()))
         return KResult(-EACCES);
 
     if (old_parent_inode.metadata().is_sticky()) {
-        if (!Process::current->is_superuser() && old_inode.metadata().uid != Process::current->euid())
+        if (!Process::current()->is_superuser() && old_inode.metadata().uid != Process::current()->euid())
             return KResult(-EACCES);
     }
 
@@ -496,21 +505,25 @@ KResult VFS::rename(StringView old_path, StringView new_path, Custody& base)
         if (&new_inode == &old_inode)
             return KSuccess;
         if (new_parent_inode.metadata().is_sticky()) {
-            if (!Process::current->is_superuser() && new_inode.metadata().uid != Process::current->euid())
+            if (!Process::current()->is_superuser() && new_inode.metadata().uid != Process::current()->euid())
                 return KResult(-EACCES);
         }
         if (new_inode.is_directory() && !old_inode.is_directory())
             return KResult(-EISDIR);
         auto result = new_parent_inode.remove_child(new_basename);
+        invalidate_dentry(new_parent_inode, new_basename);
         if (result.is_error())
             return result;
     }
 
     auto result = new_parent_inode.add_child(old_inode.identifier(), new_basename, old_inode.mode());
+    invalidate_dentry(new_parent_inode, new_basename);
     if (result.is_error())
         return result;
 
-    result = old_parent_inode.remove_child(LexicalPath(old_path).basename());
+    auto old_basename = LexicalPath(old_path).basename();
+    result = old_parent_inode.remove_child(old_basename);
+    invalidate_dentry(old_parent_inode, old_basename);
     if (result.is_error())
         return result;
 
@@ -522,19 +535,19 @@ KResult VFS::chown(Custody& custody, uid_t a_uid, gid_t a_gid)
     auto& inode = custody.inode();
     auto metadata = inode.metadata();
 
-    if (Process::current->euid() != metadata.uid && !Process::current->is_superuser())
+    if (Process::current()->euid() != metadata.uid && !Process::current()->is_superuser())
         return KResult(-EPERM);
 
     uid_t new_uid = metadata.uid;
     gid_t new_gid = metadata.gid;
 
     if (a_uid != (uid_t)-1) {
-        if (Process::current->euid() != a_uid && !Process::current->is_superuser())
+        if (Process::current()->euid() != a_uid && !Process::current()->is_superuser())
             return KResult(-EPERM);
         new_uid = a_uid;
     }
     if (a_gid != (gid_t)-1) {
-        if (!Process::current->in_group(a_gid) && !Process::current->is_superuser())
+        if (!Process::current()->in_group(a_gid) && !Process::current()->is_superuser())
             return KResult(-EPERM);
         new_gid = a_gid;
     }
@@ -584,7 +597,7 @@ KResult VFS::link(StringView old_path, StringView new_path, Custody& base)
     if (parent_inode.fsid() != old_inode.fsid())
         return KResult(-EXDEV);
 
-    if (!parent_inode.metadata().may_write(*Process::current))
+    if (!parent_inode.metadata().may_write(*Process::current()))
         return KResult(-EACCES);
 
     if (old_inode.is_directory())
@@ -593,7 +606,10 @@ KResult VFS::link(StringView old_path, StringView new_path, Custody& base)
     if (parent_custody->is_readonly())
         return KResult(-EROFS);
 
-    return parent_inode.add_child(old_inode.identifier(), LexicalPath(new_path).basename(), old_inode.mode());
+    auto new_basename = LexicalPath(new_path).basename();
+    auto result = parent_inode.add_child(old_inode.identifier(), new_basename, old_inode.mode());
+    invalidate_dentry(parent_inode, new_basename);
+    return result;
 }
 
 KResult VFS::unlink(StringView path, Custody& base)
@@ -614,18 +630,20 @@ KResult VFS::unlink(StringView path, Custody& base)
     ASSERT(parent_custody);
 
     auto& parent_inode = parent_custody->inode();
-    if (!parent_inode.metadata().may_write(*Process::current))
+    if (!parent_inode.metadata().may_write(*Process::current()))
         return KResult(-EACCES);
 
     if (parent_inode.metadata().is_sticky()) {
-        if (!Process::current->is_superuser() && inode.metadata().uid != Process::current->euid())
+        if (!Process::current()->is_superuser() && inode.metadata().uid != Process::current()->euid())
             return KResult(-EACCES);
     }
 
     if (parent_custody->is_readonly())
         return KResult(-EROFS);
 
-    auto result = parent_inode.remove_child(LexicalPath(path).basename());
+    auto basename = LexicalPath(path).basename();
+    auto result = parent_inode.remove_child(basename);
+    invalidate_dentry(parent_inode, basename);
     if (result.is_error())
         return result;
 
@@ -643,14 +661,15 @@ KResult VFS::symlink(StringView target, StringView linkpath, Custody& base)
     if (existing_custody_or_error.error() != -ENOENT)
         return existing_custody_or_error.error();
     auto& parent_inode = parent_custody->inode();
-    if (!parent_inode.metadata().may_write(*Process::current))
+    if (!parent_inode.metadata().may_write(*Process::current()))
         return KResult(-EACCES);
     if (parent_custody->is_readonly())
         return KResult(-EROFS);
 
     LexicalPath p(linkpath);
     dbg() << "VFS::symlink: '" << p.basename() << "' (-> '" << target << "') in " << parent_inode.identifier();
-    auto inode_or_error = parent_inode.fs().create_inode(parent_inode.identifier(), p.basename(), 0120644, 0, 0, Process::current->uid(), Process::current->gid());
+    auto inode_or_error = parent_inode.fs().create_inode(parent_inode.identifier(), p.basename(), 0120644, 0, 0, Process::current()->uid(), Process::current()->gid());
+    invalidate_dentry(parent_inode, p.basename());
     if (inode_or_error.is_error())
         return inode_or_error.error();
     auto& inode = inode_or_error.value();
@@ -681,7 +700,7 @@ KResult VFS::rmdir(StringView path, Custody& base)
 
     auto& parent_inode = parent_custody->inode();
 
-    if (!parent_inode.metadata().may_write(*Process::current))
+    if (!parent_inode.metadata().may_write(*Process::current()))
         return KResult(-EACCES);
 
     if (inode.directory_entry_count() != 2)
@@ -698,7 +717,10 @@ KResult VFS::rmdir(StringView path, Custody& base)
     if (result.is_error())
         return result;
 
-    return parent_inode.remove_child(LexicalPath(path).basename());
+    auto basename = LexicalPath(path).basename();
+    result = parent_inode.remove_child(basename);
+    invalidate_dentry(parent_inode, basename);
+    return result;
 }
 
 RefPtr<Inode> VFS::get_inode(InodeIdentifier inode_id)
@@ -759,7 +781,7 @@ Custody& VFS::root_custody()
 
 const UnveiledPath* VFS::find_matching_unveiled_path(StringView path)
 {
-    for (auto& unveiled_path : Process::current->unveiled_paths()) {
+    for (auto& unveiled_path : Process::current()->unveiled_paths()) {
         if (path == unveiled_path.path)
             return &unveiled_path;
         if (path.starts_with(unveiled_path.path) && path.length() > unveiled_path.path.length() && path[unveiled_path.path.length()] == '/')
@@ -770,7 +792,7 @@ const UnveiledPath* VFS::find_matching_unveiled_path(StringView path)
 
 KResult VFS::validate_path_against_process_veil(StringView path, int options)
 {
-    if (Process::current->veil_state() == VeilState::None)
+    if (Process::current()->veil_state() == VeilState::None)
         return KSuccess;
 
     // FIXME: Figure out a nicer way to do this.
@@ -846,7 +868,7 @@ KResultOr<NonnullRefPtr<Custody>> VFS::resolve_path_without_veil(StringView path
         return KResult(-EINVAL);
 
     auto parts = path.split_view('/', true);
-    auto& current_root = Process::current->root_directory();
+    auto& current_root = Process::current()->root_directory();
 
     NonnullRefPtr<Custody> custody = path[0] == '/' ? current_root : base;
 
@@ -856,7 +878,7 @@ KResultOr<NonnullRefPtr<Custody>> VFS::resolve_path_without_veil(StringView path
         if (!parent_metadata.is_directory())
             return KResult(-ENOTDIR);
         // Ensure the current user is allowed to resolve paths inside this directory.
-        if (!parent_metadata.may_execute(*Process::current))
+        if (!parent_metadata.may_execute(*Process::current()))
             return KResult(-EACCES);
 
         auto& part = parts[i];
@@ -872,7 +894,30 @@ KResultOr<NonnullRefPtr<Custody>> VFS::resolve_path_without_veil(StringView path
         }
 
         // Okay, let's look up this part.
-        auto child_inode = parent.inode().lookup(part);
+        RefPtr<Inode> child_inode;
+        int mount_flags_for_child = parent.mount_flags();
+        String name = part;
+        if (auto cached_entry = lookup_dentry(parent.inode(), name); cached_entry.has_value()) {
+            child_inode = cached_entry.value().inode;
+            if (cached_entry.value().mount_flags.has_value())
+                mount_flags_for_child = cached_entry.value().mount_flags.value();
+        } else {
+            u32 generation = m_dentry_cache_generation;
+            child_inode = parent.inode().lookup(part);
+            Optional<int> mount_flags;
+
+            // See if there's something mounted on the child; in that case
+            // we would need to return the guest inode, not the host inode.
+            if (child_inode) {
+                if (auto mount = find_mount_for_host(child_inode->identifier())) {
+                    child_inode = get_inode(mount->guest());
+                    mount_flags = mount->flags();
+                    mount_flags_for_child = mount->flags();
+                }
+            }
+            cache_dentry(parent.inode(), name, { child_inode, mount_flags }, generation);
+        }
+
         if (!child_inode) {
             if (out_parent) {
                 // ENOENT with a non-null parent custody signals to caller that
@@ -883,15 +928,6 @@ KResultOr<NonnullRefPtr<Custody>> VFS::resolve_path_without_veil(StringView path
             return KResult(-ENOENT);
         }
 
-        int mount_flags_for_child = parent.mount_flags();
-
-        // See if there's something mounted on the child; in that case
-        // we would need to return the guest inode, not the host inode.
-        if (auto mount = find_mount_for_host(child_inode->identifier())) {
-            child_inode = get_inode(mount->guest());
-            mount_flags_for_child = mount->flags();
-        }
-
         custody = Custody::create(&parent, part, *child_inode, mount_flags_for_child);
 
         if (child_inode->metadata().is_symlink()) {
@@ -921,4 +957,42 @@ KResultOr<NonnullRefPtr<Custody>> VFS::resolve_path_without_veil(StringView path
     return custody;
 }
 
+Optional<VFS::DentryCacheEntry> VFS::lookup_dentry(const Inode& parent, const String& name)
+{
+    if (!parent.fs().supports_dentry_cache())
+        return {};
+    LOCKER(m_dentry_cache_lock);
+    auto it = m_dentry_cache.find({ parent.identifier(), name });
+    if (it == m_dentry_cache.end())
+        return {};
+    return (*it).value;
+}
+
+void VFS::cache_dentry(const Inode& parent, const String& name, DentryCacheEntry entry, u32 generation)
+{
+    if (!parent.fs().supports_dentry_cache())
+        return;
+    LOCKER(m_dentry_cache_lock);
+    // Something changed while we were looking, so what we found may already be stale.
+    if (generation != m_dentry_cache_generation)
+        return;
+    if (m_dentry_cache.size() >= max_dentry_cache_size)
+        m_dentry_cache.remove(m_dentry_cache.begin());
+    m_dentry_cache.set({ parent.identifier(), name }, move(entry));
+}
+
+void VFS::invalidate_dentry(const Inode& parent, const StringView& name)
+{
+    LOCKER(m_dentry_cache_lock);
+    ++m_dentry_cache_generation;
+    m_dentry_cache.remove({ parent.identifier(), name });
+}
+
+void VFS::invalidate_dentry_cache()
+{
+    LOCKER(m_dentry_cache_lock);
+    ++m_dentry_cache_generation;
+    m_dentry_cache.clear();
+}
+
 }
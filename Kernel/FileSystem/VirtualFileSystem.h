@@ -50,6 +50,26 @@ struct UidAndGid {
     gid_t gid;
 };
 
+struct DentryCacheKey {
+    InodeIdentifier parent;
+    String name;
+
+    bool operator==(const DentryCacheKey& other) const { return parent == other.parent && name == other.name; }
+};
+
+}
+
+namespace AK {
+
+template<>
+struct Traits<Kernel::DentryCacheKey> : public GenericTraits<Kernel::DentryCacheKey> {
+    static unsigned hash(const Kernel::DentryCacheKey& key) { return pair_int_hash(pair_int_hash(key.parent.fsid(), key.parent.index()), key.name.hash()); }
+};
+
+}
+
+namespace Kernel {
+
 class VFS {
     AK_MAKE_ETERNAL
 public:
@@ -131,8 +151,24 @@ private:
     Mount* find_mount_for_host(InodeIdentifier);
     Mount* find_mount_for_guest(InodeIdentifier);
 
+    // What looking up a name in a directory last resolved to, mounts included. A null inode means the name doesn't exist.
+    struct DentryCacheEntry {
+        RefPtr<Inode> inode;
+        Optional<int> mount_flags;
+    };
+    static constexpr size_t max_dentry_cache_size = 1024;
+
+    Optional<DentryCacheEntry> lookup_dentry(const Inode& parent, const String& name);
+    void cache_dentry(const Inode& parent, const String& name, DentryCacheEntry, u32 generation);
+    void invalidate_dentry(const Inode& parent, const StringView& name);
+    void invalidate_dentry_cache();
+
     Lock m_lock { "VFSLock" };
 
+    Lock m_dentry_cache_lock { "VFSDentryCacheLock" };
+    HashMap<DentryCacheKey, DentryCacheEntry> m_dentry_cache;
+    u32 m_dentry_cache_generation { 0 };
+
     RefPtr<Inode> m_root_inode;
     Vector<Mount, 16> m_mounts;
     RefPtr<Custody> m_root_custody;
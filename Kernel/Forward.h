@@ -34,6 +34,7 @@ class Custody;
 class Device;
 class DiskCache;
 class DoubleBuffer;
+class EventQueue;
 class File;
 class FileDescription;
 class IPv4Socket;
@@ -45,6 +46,7 @@ class KBuffer;
 class KResult;
 class LocalSocket;
 class MappedROM;
+class PacketBuffer;
 class PageDirectory;
 class PerformanceEventBuffer;
 class PhysicalPage;
@@ -58,6 +60,7 @@ class Region;
 class Scheduler;
 class SharedBuffer;
 class Socket;
+class SyscallStatistics;
 class TCPSocket;
 class TTY;
 class Thread;
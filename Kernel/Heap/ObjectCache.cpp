@@ -0,0 +1,182 @@
+/*
+ * Copyright (c) 2018-2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/Assertions.h>
+#include <AK/Memory.h>
+#include <Kernel/Arch/i386/CPU.h>
+#include <Kernel/Heap/ObjectCache.h>
+#include <Kernel/Heap/kmalloc.h>
+
+#define SANITIZE_OBJECT_CACHES
+
+namespace Kernel {
+
+static constexpr size_t slab_size = KMALLOC_SPAN_SIZE;
+
+// Slabs are span-aligned, so the slab of an object is found by rounding its address down.
+struct ObjectCache::Slab {
+    ObjectCache* cache;
+    Slab* prev;
+    Slab* next;
+    u16 capacity;
+    u16 first_object_offset;
+    u16 free_count;
+    // The indices of the free objects, used as a stack.
+    u16 free_indices[0];
+};
+
+static ObjectCache* s_all_caches;
+
+size_t ObjectCache::objects_per_slab() const
+{
+    size_t capacity = (slab_size - sizeof(Slab)) / (m_object_size + sizeof(u16));
+    while (capacity && ((sizeof(Slab) + capacity * sizeof(u16) + 15) & ~15) + capacity * m_object_size > slab_size)
+        --capacity;
+    return capacity;
+}
+
+u8* ObjectCache::object_at(Slab& slab, size_t index) const
+{
+    return (u8*)&slab + slab.first_object_offset + index * m_object_size;
+}
+
+ObjectCache::Slab* ObjectCache::create_slab()
+{
+    size_t capacity = objects_per_slab();
+    ASSERT(capacity);
+
+    auto& slab = *(Slab*)kmalloc_span_aligned(slab_size);
+    slab.cache = this;
+    slab.prev = nullptr;
+    slab.next = nullptr;
+    slab.capacity = capacity;
+    slab.first_object_offset = (sizeof(Slab) + capacity * sizeof(u16) + 15) & ~15;
+    slab.free_count = capacity;
+    // Hand out the objects in address order, which is friendlier to the caches.
+    for (size_t i = 0; i < capacity; ++i)
+        slab.free_indices[i] = capacity - i - 1;
+
+    if (m_constructor) {
+        for (size_t i = 0; i < capacity; ++i)
+            m_constructor(object_at(slab, i));
+    }
+
+    ++m_num_slabs;
+    m_num_free += capacity;
+    return &slab;
+}
+
+void ObjectCache::destroy_slab(Slab& slab)
+{
+    ASSERT(slab.free_count == slab.capacity);
+    --m_num_slabs;
+    m_num_free -= slab.capacity;
+    kfree(&slab);
+}
+
+void ObjectCache::link_partial_slab(Slab& slab)
+{
+    slab.prev = nullptr;
+    slab.next = m_partial_slabs;
+    if (slab.next)
+        slab.next->prev = &slab;
+    m_partial_slabs = &slab;
+}
+
+void ObjectCache::unlink_partial_slab(Slab& slab)
+{
+    if (slab.prev)
+        slab.prev->next = slab.next;
+    else
+        m_partial_slabs = slab.next;
+    if (slab.next)
+        slab.next->prev = slab.prev;
+    slab.prev = nullptr;
+    slab.next = nullptr;
+}
+
+void* ObjectCache::allocate()
+{
+    InterruptDisabler disabler;
+    if (!m_is_registered) {
+        m_next_cache = s_all_caches;
+        s_all_caches = this;
+        m_is_registered = true;
+    }
+
+    if (!m_partial_slabs)
+        link_partial_slab(*create_slab());
+
+    auto& slab = *m_partial_slabs;
+    void* ptr = object_at(slab, slab.free_indices[--slab.free_count]);
+    if (!slab.free_count)
+        unlink_partial_slab(slab);
+
+    ++m_num_allocated;
+    --m_num_free;
+    ++m_allocations;
+#ifdef SANITIZE_OBJECT_CACHES
+    if (!m_constructor)
+        memset(ptr, OBJECT_CACHE_SCRUB_BYTE, m_object_size);
+#endif
+    return ptr;
+}
+
+void ObjectCache::deallocate(void* ptr)
+{
+    ASSERT(ptr);
+    InterruptDisabler disabler;
+    auto& slab = *(Slab*)((FlatPtr)ptr & ~(slab_size - 1));
+    ASSERT(slab.cache == this);
+    size_t index = ((u8*)ptr - object_at(slab, 0)) / m_object_size;
+    ASSERT(object_at(slab, index) == ptr);
+
+#ifdef SANITIZE_OBJECT_CACHES
+    if (!m_constructor)
+        memset(ptr, OBJECT_CACHE_SCRUB_BYTE, m_object_size);
+#endif
+
+    if (!slab.free_count)
+        link_partial_slab(slab);
+    slab.free_indices[slab.free_count++] = index;
+    --m_num_allocated;
+    ++m_num_free;
+
+    // Keep one empty slab around, so a cache that hovers around a slab boundary doesn't
+    // keep going back to the heap.
+    if (slab.free_count == slab.capacity && (m_partial_slabs != &slab || slab.next)) {
+        unlink_partial_slab(slab);
+        destroy_slab(slab);
+    }
+}
+
+void ObjectCache::for_each(Function<void(const ObjectCache&)> callback)
+{
+    for (auto* cache = s_all_caches; cache; cache = cache->m_next_cache)
+        callback(*cache);
+}
+
+}
@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2018-2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/Function.h>
+#include <AK/Types.h>
+
+namespace Kernel {
+
+// ObjectCache: A cache of same-sized objects of one type.
+//
+// Objects are carved out of span-sized slabs from the kernel heap. The free list of each
+// slab is kept in the slab header instead of in the free objects, so an object comes back
+// out of the cache exactly as it went in. If the cache has a constructor, it runs once for
+// every object when its slab is created, and the object is expected to be handed back in
+// its constructed state.
+//
+// Classes opt in with MAKE_OBJECT_CACHED(type) in their declaration, and
+// DEFINE_OBJECT_CACHE(type) next to their implementation.
+
+#define OBJECT_CACHE_SCRUB_BYTE 0xcd
+
+class ObjectCache {
+public:
+    using Constructor = void (*)(void*);
+
+    constexpr ObjectCache(const char* name, size_t object_size, Constructor constructor = nullptr)
+        : m_name(name)
+        , m_object_size((object_size + 15) & ~15)
+        , m_constructor(constructor)
+    {
+    }
+
+    void* allocate();
+    void deallocate(void*);
+
+    const char* name() const { return m_name; }
+    size_t object_size() const { return m_object_size; }
+    size_t objects_per_slab() const;
+    size_t num_allocated() const { return m_num_allocated; }
+    size_t num_free() const { return m_num_free; }
+    size_t num_slabs() const { return m_num_slabs; }
+    u32 allocations() const { return m_allocations; }
+
+    static void for_each(Function<void(const ObjectCache&)>);
+
+private:
+    struct Slab;
+
+    Slab* create_slab();
+    void destroy_slab(Slab&);
+    void link_partial_slab(Slab&);
+    void unlink_partial_slab(Slab&);
+    u8* object_at(Slab&, size_t index) const;
+
+    const char* m_name { nullptr };
+    size_t m_object_size { 0 };
+    Constructor m_constructor { nullptr };
+
+    // Slabs with at least one free object.
+    Slab* m_partial_slabs { nullptr };
+
+    size_t m_num_allocated { 0 };
+    size_t m_num_free { 0 };
+    size_t m_num_slabs { 0 };
+    u32 m_allocations { 0 };
+
+    // All caches that have been used, for /proc/slabs.
+    ObjectCache* m_next_cache { nullptr };
+    bool m_is_registered { false };
+};
+
+#define MAKE_OBJECT_CACHED(type)          \
+public:                                   \
+    void* operator new(size_t size)       \
+    {                                     \
+        ASSERT(size == sizeof(type));     \
+        return s_object_cache.allocate(); \
+    }                                     \
+    void operator delete(void* ptr)       \
+    {                                     \
+        s_object_cache.deallocate(ptr);   \
+    }                                     \
+                                          \
+private:                                  \
+    static ObjectCache s_object_cache;
+
+#define DEFINE_OBJECT_CACHE(type) \
+    ObjectCache type::s_object_cache { #type, sizeof(type) }
+
+}
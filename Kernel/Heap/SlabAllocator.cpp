@@ -86,8 +86,8 @@ public:
             memset(((FreeSlab*)ptr)->padding, SLAB_DEALLOC_SCRUB_BYTE, sizeof(FreeSlab::padding));
 #endif
         m_freelist = (FreeSlab*)ptr;
-        ++m_num_allocated;
-        --m_num_free;
+        --m_num_allocated;
+        ++m_num_free;
     }
 
     size_t num_allocated() const { return m_num_allocated; }
@@ -25,13 +25,23 @@
  */
 
 /*
- * Really really *really* Q&D malloc() and free() implementations
- * just to get going. Don't ever let anyone see this shit. :^)
+ * The kernel heap.
+ *
+ * Memory is handed out in 16 KiB spans, from the fixed pool we get at boot and then from
+ * a region that we commit more of as the heap grows. Small allocations are served from
+ * slabs of one size class each, which keep their free blocks on a free list, so kmalloc()
+ * and kfree() don't have to search for anything. Allocations above the largest size
+ * class get a run of spans of their own.
+ *
+ * The state of every span is kept in a table next to its arena, so there are no headers
+ * in front of allocations, and kfree() finds the owning slab with a bit of arithmetic.
  */
 
 #include <AK/Assertions.h>
 #include <AK/Bitmap.h>
+#include <AK/Function.h>
 #include <AK/Optional.h>
+#include <AK/StringView.h>
 #include <AK/Types.h>
 #include <Kernel/Arch/i386/CPU.h>
 #include <Kernel/Heap/kmalloc.h>
@@ -39,22 +49,91 @@
 #include <Kernel/Process.h>
 #include <Kernel/Scheduler.h>
 #include <Kernel/StdLib.h>
+#include <Kernel/VM/AnonymousVMObject.h>
+#include <Kernel/VM/MemoryManager.h>
+#include <Kernel/VM/PageDirectory.h>
+#include <Kernel/VM/Region.h>
 
 #define SANITIZE_KMALLOC
 
-struct AllocationHeader {
-    size_t allocation_size_in_chunks;
-    u8 data[0];
-};
-
 #define BASE_PHYSICAL (0xc0000000 + (4 * MB))
-#define CHUNK_SIZE 32
 #define POOL_SIZE (3 * MB)
 
 #define ETERNAL_BASE_PHYSICAL (0xc0000000 + (2 * MB))
 #define ETERNAL_RANGE_SIZE (2 * MB)
 
-static u8 alloc_map[POOL_SIZE / CHUNK_SIZE / 8];
+static constexpr size_t span_size = KMALLOC_SPAN_SIZE;
+// How much kernel address space the heap may grow into, beyond the boot pool.
+static constexpr size_t max_expansion_size = 64 * MB;
+static constexpr size_t max_arena_span_count = max_expansion_size / span_size;
+// When fewer spans than this are left, the finalizer commits another growth_step_size.
+static constexpr size_t low_watermark_span_count = 64;
+static constexpr size_t growth_step_size = 2 * MB;
+
+static constexpr size_t size_classes[] = { 16, 32, 48, 64, 96, 128, 192, 256, 384, 512, 768, 1024, 1536, 2048, 3072, 4096, 6144, 8192 };
+static constexpr size_t size_class_count = sizeof(size_classes) / sizeof(size_classes[0]);
+static constexpr size_t max_small_allocation_size = size_classes[size_class_count - 1];
+// Slabs of the larger classes span several spans, so they hold at least this many blocks.
+static constexpr size_t min_blocks_per_slab = 8;
+
+enum class SpanKind : u8 {
+    Free,
+    Metadata,
+    Slab,
+    Large,
+};
+
+struct FreeBlock {
+    FreeBlock* next;
+};
+
+struct Span {
+    SpanKind kind;
+    u8 size_class;
+    u16 capacity;
+    u16 used_blocks;
+    // The first span of the slab or large allocation this span is a part of.
+    Span* first;
+    // Everything below is only used in the first span.
+    size_t span_count;
+    FreeBlock* freelist;
+    // Blocks from here on haven't been handed out yet, so they're not on the free list.
+    u8* untouched;
+    // The slabs of a size class that have free blocks.
+    Span* prev;
+    Span* next;
+};
+
+struct Arena {
+    u8* base;
+    Span* spans;
+    size_t span_count;
+    size_t free_span_count;
+    u8 span_map[max_arena_span_count / 8];
+
+    bool contains(const void* ptr) const { return ptr >= base && ptr < base + span_count * span_size; }
+    Span& span_for(const void* ptr) { return spans[((const u8*)ptr - base) / span_size]; }
+    u8* address_of(const Span& span) const { return base + (&span - spans) * span_size; }
+    Bitmap map() { return Bitmap::wrap(span_map, span_count); }
+};
+
+struct SizeClass {
+    size_t size;
+    size_t span_count;
+    Span* partial_slabs;
+    size_t allocated_blocks;
+    size_t total_blocks;
+};
+
+static Arena s_boot_arena;
+static Span s_boot_spans[POOL_SIZE / span_size];
+static Arena s_expansion_arena;
+static Region* s_expansion_region;
+static bool s_is_growing;
+static bool s_growth_requested;
+
+static SizeClass s_size_classes[size_class_count];
+static u8 s_size_class_for_size[max_small_allocation_size / 16 + 1];
 
 size_t g_kmalloc_bytes_allocated = 0;
 size_t g_kmalloc_bytes_free = POOL_SIZE;
@@ -68,8 +147,28 @@ static u8* s_end_of_eternal_range;
 
 void kmalloc_init()
 {
-    memset(&alloc_map, 0, sizeof(alloc_map));
-    memset((void*)BASE_PHYSICAL, 0, POOL_SIZE);
+    memset(&s_boot_arena, 0, sizeof(s_boot_arena));
+    memset(&s_boot_spans, 0, sizeof(s_boot_spans));
+    memset(&s_expansion_arena, 0, sizeof(s_expansion_arena));
+    s_boot_arena.base = (u8*)BASE_PHYSICAL;
+    s_boot_arena.spans = s_boot_spans;
+    s_boot_arena.span_count = POOL_SIZE / span_size;
+    s_boot_arena.free_span_count = s_boot_arena.span_count;
+
+    size_t size_class = 0;
+    for (size_t i = 0; i < size_class_count; ++i) {
+        auto& it = s_size_classes[i];
+        it.size = size_classes[i];
+        it.span_count = (max(it.size * min_blocks_per_slab, span_size) + span_size - 1) / span_size;
+        it.partial_slabs = nullptr;
+        it.allocated_blocks = 0;
+        it.total_blocks = 0;
+    }
+    for (size_t i = 0; i < sizeof(s_size_class_for_size); ++i) {
+        while (size_classes[size_class] < i * 16)
+            ++size_class;
+        s_size_class_for_size[i] = size_class;
+    }
 
     g_kmalloc_bytes_eternal = 0;
     g_kmalloc_bytes_allocated = 0;
@@ -79,6 +178,236 @@ void kmalloc_init()
     s_end_of_eternal_range = s_next_eternal_ptr + ETERNAL_RANGE_SIZE;
 }
 
+void kmalloc_enable_expansion()
+{
+    auto range = MM.kernel_page_directory().range_allocator().allocate_anywhere(max_expansion_size, span_size);
+    ASSERT(range.is_valid());
+    auto vmobject = AnonymousVMObject::create_with_size(max_expansion_size);
+    auto region = MM.allocate_kernel_region_with_vmobject(range, *vmobject, "Kernel Heap", Region::Access::Read | Region::Access::Write);
+    ASSERT(region);
+
+    // The span table for the whole region lives at its start.
+    size_t table_span_count = (max_arena_span_count * sizeof(Span) + span_size - 1) / span_size;
+    for (size_t i = 0; i < table_span_count * span_size / PAGE_SIZE; ++i)
+        region->commit(i);
+
+    Kernel::InterruptDisabler disabler;
+    s_expansion_region = region.leak_ptr();
+    auto& arena = s_expansion_arena;
+    arena.base = s_expansion_region->vaddr().as_ptr();
+    arena.spans = (Span*)arena.base;
+    memset(arena.spans, 0, max_arena_span_count * sizeof(Span));
+    arena.span_count = table_span_count;
+    arena.free_span_count = 0;
+    arena.map().set_range(0, table_span_count, true);
+    for (size_t i = 0; i < table_span_count; ++i) {
+        arena.spans[i].kind = SpanKind::Metadata;
+        arena.spans[i].first = &arena.spans[0];
+    }
+}
+
+static size_t free_span_count()
+{
+    return s_boot_arena.free_span_count + s_expansion_arena.free_span_count;
+}
+
+// Commits at least the given number of spans more of the expansion region.
+static bool grow_heap(size_t span_count)
+{
+    auto& arena = s_expansion_arena;
+    size_t old_span_count;
+    size_t new_span_count;
+    {
+        Kernel::InterruptDisabler disabler;
+        if (!s_expansion_region || s_is_growing)
+            return false;
+        old_span_count = arena.span_count;
+        new_span_count = min(old_span_count + max(span_count, growth_step_size / span_size), max_arena_span_count);
+        if (new_span_count == old_span_count)
+            return false;
+        s_is_growing = true;
+    }
+
+    // Committing a page allocates a little bit from the heap, which the remaining spans
+    // have to cover while we're doing this.
+    for (size_t i = old_span_count * span_size / PAGE_SIZE; i < new_span_count * span_size / PAGE_SIZE; ++i)
+        s_expansion_region->commit(i);
+
+    Kernel::InterruptDisabler disabler;
+    arena.span_count = new_span_count;
+    arena.free_span_count += new_span_count - old_span_count;
+    g_kmalloc_bytes_free += (new_span_count - old_span_count) * span_size;
+    s_is_growing = false;
+    return true;
+}
+
+bool kmalloc_heap_needs_growth()
+{
+    return s_growth_requested;
+}
+
+void kmalloc_grow_heap()
+{
+    s_growth_requested = false;
+    if (free_span_count() < low_watermark_span_count)
+        grow_heap(0);
+}
+
+static void request_growth_if_needed()
+{
+    if (s_growth_requested || !s_expansion_region || free_span_count() >= low_watermark_span_count)
+        return;
+    if (s_expansion_arena.span_count == max_arena_span_count)
+        return;
+    s_growth_requested = true;
+    if (Kernel::g_finalizer_wait_queue)
+        Kernel::g_finalizer_wait_queue->wake_all();
+}
+
+static Span* allocate_spans_from(Arena& arena, size_t span_count, SpanKind kind)
+{
+    if (arena.free_span_count < span_count)
+        return nullptr;
+    auto map = arena.map();
+    auto start = map.find_first_fit(span_count);
+    if (!start.has_value())
+        return nullptr;
+    map.set_range(start.value(), span_count, true);
+    arena.free_span_count -= span_count;
+
+    auto& first = arena.spans[start.value()];
+    for (size_t i = 0; i < span_count; ++i) {
+        auto& span = arena.spans[start.value() + i];
+        span.kind = kind;
+        span.first = &first;
+    }
+    first.span_count = span_count;
+    return &first;
+}
+
+static Span* allocate_spans(size_t span_count, SpanKind kind, Arena*& arena)
+{
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        if (auto* span = allocate_spans_from(s_boot_arena, span_count, kind)) {
+            arena = &s_boot_arena;
+            return span;
+        }
+        if (auto* span = allocate_spans_from(s_expansion_arena, span_count, kind)) {
+            arena = &s_expansion_arena;
+            return span;
+        }
+        // The finalizer didn't get around to growing the heap in time, so we have to do it
+        // right here. That's a lot of work with interrupts disabled, but beats panicking.
+        if (!grow_heap(span_count))
+            return nullptr;
+    }
+    return nullptr;
+}
+
+static void free_spans(Arena& arena, Span& first)
+{
+    size_t start = &first - arena.spans;
+    size_t span_count = first.span_count;
+    for (size_t i = 0; i < span_count; ++i)
+        arena.spans[start + i].kind = SpanKind::Free;
+    arena.map().set_range(start, span_count, false);
+    arena.free_span_count += span_count;
+}
+
+static Arena& arena_for(const void* ptr)
+{
+    if (s_boot_arena.contains(ptr))
+        return s_boot_arena;
+    if (s_expansion_arena.contains(ptr))
+        return s_expansion_arena;
+    klog() << "kfree(): " << ptr << " is not in the kernel heap";
+    ASSERT_NOT_REACHED();
+}
+
+static void link_partial_slab(SizeClass& size_class, Span& slab)
+{
+    slab.prev = nullptr;
+    slab.next = size_class.partial_slabs;
+    if (slab.next)
+        slab.next->prev = &slab;
+    size_class.partial_slabs = &slab;
+}
+
+static void unlink_partial_slab(SizeClass& size_class, Span& slab)
+{
+    if (slab.prev)
+        slab.prev->next = slab.next;
+    else
+        size_class.partial_slabs = slab.next;
+    if (slab.next)
+        slab.next->prev = slab.prev;
+    slab.prev = nullptr;
+    slab.next = nullptr;
+}
+
+static void* allocate_block(size_t size_class_index)
+{
+    auto& size_class = s_size_classes[size_class_index];
+    auto* slab = size_class.partial_slabs;
+    if (!slab) {
+        Arena* arena = nullptr;
+        slab = allocate_spans(size_class.span_count, SpanKind::Slab, arena);
+        if (!slab)
+            return nullptr;
+        slab->size_class = size_class_index;
+        slab->capacity = size_class.span_count * span_size / size_class.size;
+        slab->used_blocks = 0;
+        slab->freelist = nullptr;
+        slab->untouched = arena->address_of(*slab);
+        size_class.total_blocks += slab->capacity;
+        link_partial_slab(size_class, *slab);
+    }
+
+    void* block;
+    if (slab->freelist) {
+        block = slab->freelist;
+        slab->freelist = slab->freelist->next;
+    } else {
+        block = slab->untouched;
+        slab->untouched += size_class.size;
+    }
+    if (++slab->used_blocks == slab->capacity)
+        unlink_partial_slab(size_class, *slab);
+    ++size_class.allocated_blocks;
+    return block;
+}
+
+static void free_block(Arena& arena, Span& slab, void* ptr)
+{
+    auto& size_class = s_size_classes[slab.size_class];
+    bool was_full = slab.used_blocks == slab.capacity;
+    auto* block = (FreeBlock*)ptr;
+    block->next = slab.freelist;
+    slab.freelist = block;
+    --slab.used_blocks;
+    --size_class.allocated_blocks;
+    if (was_full)
+        link_partial_slab(size_class, slab);
+
+    // Keep one empty slab around, so a size class that hovers around a slab boundary
+    // doesn't keep asking for new spans.
+    if (!slab.used_blocks && (size_class.partial_slabs != &slab || slab.next)) {
+        unlink_partial_slab(size_class, slab);
+        size_class.total_blocks -= slab.capacity;
+        free_spans(arena, slab);
+    }
+}
+
+static size_t allocation_size(Arena& arena, const void* ptr)
+{
+    auto& first = *arena.span_for(ptr).first;
+    if (first.kind == SpanKind::Slab)
+        return s_size_classes[first.size_class].size;
+    ASSERT(first.kind == SpanKind::Large);
+    ASSERT(ptr == arena.address_of(first));
+    return first.span_count * span_size;
+}
+
 void* kmalloc_eternal(size_t size)
 {
     void* ptr = s_next_eternal_ptr;
@@ -110,24 +439,7 @@ void* kmalloc_page_aligned(size_t size)
     return ptr;
 }
 
-inline void* kmalloc_allocate(size_t first_chunk, size_t chunks_needed)
-{
-    auto* a = (AllocationHeader*)(BASE_PHYSICAL + (first_chunk * CHUNK_SIZE));
-    u8* ptr = a->data;
-    a->allocation_size_in_chunks = chunks_needed;
-
-    Bitmap bitmap_wrapper = Bitmap::wrap(alloc_map, POOL_SIZE / CHUNK_SIZE);
-    bitmap_wrapper.set_range(first_chunk, chunks_needed, true);
-
-    g_kmalloc_bytes_allocated += a->allocation_size_in_chunks * CHUNK_SIZE;
-    g_kmalloc_bytes_free -= a->allocation_size_in_chunks * CHUNK_SIZE;
-#ifdef SANITIZE_KMALLOC
-    memset(ptr, KMALLOC_SCRUB_BYTE, (a->allocation_size_in_chunks * CHUNK_SIZE) - sizeof(AllocationHeader));
-#endif
-    return ptr;
-}
-
-void* kmalloc_impl(size_t size)
+static void* allocate(size_t size, bool span_aligned)
 {
     Kernel::InterruptDisabler disabler;
     ++g_kmalloc_call_count;
@@ -137,35 +449,43 @@ void* kmalloc_impl(size_t size)
         Kernel::dump_backtrace();
     }
 
-    // We need space for the AllocationHeader at the head of the block.
-    size_t real_size = size + sizeof(AllocationHeader);
-
-    if (g_kmalloc_bytes_free < real_size) {
-        Kernel::dump_backtrace();
-        klog() << "kmalloc(): PANIC! Out of memory (sucks, dude)\nsum_free=" << g_kmalloc_bytes_free << ", real_size=" << real_size;
-        Kernel::hang();
-    }
-
-    size_t chunks_needed = (real_size + CHUNK_SIZE - 1) / CHUNK_SIZE;
-
-    Bitmap bitmap_wrapper = Bitmap::wrap(alloc_map, POOL_SIZE / CHUNK_SIZE);
-    Optional<size_t> first_chunk;
-
-    // Choose the right politic for allocation.
-    constexpr u32 best_fit_threshold = 128;
-    if (chunks_needed < best_fit_threshold) {
-        first_chunk = bitmap_wrapper.find_first_fit(chunks_needed);
+    void* ptr;
+    size_t real_size;
+    if (size <= max_small_allocation_size && !span_aligned) {
+        size_t size_class = s_size_class_for_size[(size + 15) / 16];
+        ptr = allocate_block(size_class);
+        real_size = s_size_classes[size_class].size;
     } else {
-        first_chunk = bitmap_wrapper.find_best_fit(chunks_needed);
+        Arena* arena = nullptr;
+        size_t span_count = (max(size, (size_t)1) + span_size - 1) / span_size;
+        auto* span = allocate_spans(span_count, SpanKind::Large, arena);
+        ptr = span ? arena->address_of(*span) : nullptr;
+        real_size = span_count * span_size;
     }
 
-    if (!first_chunk.has_value()) {
+    if (!ptr) {
         klog() << "kmalloc(): PANIC! Out of memory (no suitable block for size " << size << ")";
         Kernel::dump_backtrace();
         Kernel::hang();
     }
 
-    return kmalloc_allocate(first_chunk.value(), chunks_needed);
+    g_kmalloc_bytes_allocated += real_size;
+    g_kmalloc_bytes_free -= real_size;
+#ifdef SANITIZE_KMALLOC
+    memset(ptr, KMALLOC_SCRUB_BYTE, real_size);
+#endif
+    request_growth_if_needed();
+    return ptr;
+}
+
+void* kmalloc_impl(size_t size)
+{
+    return allocate(size, false);
+}
+
+void* kmalloc_span_aligned(size_t size)
+{
+    return allocate(size, true);
 }
 
 void kfree(void* ptr)
@@ -176,18 +496,21 @@ void kfree(void* ptr)
     Kernel::InterruptDisabler disabler;
     ++g_kfree_call_count;
 
-    auto* a = (AllocationHeader*)((((u8*)ptr) - sizeof(AllocationHeader)));
-    FlatPtr start = ((FlatPtr)a - (FlatPtr)BASE_PHYSICAL) / CHUNK_SIZE;
+    auto& arena = arena_for(ptr);
+    auto& first = *arena.span_for(ptr).first;
+    size_t real_size = allocation_size(arena, ptr);
 
-    Bitmap bitmap_wrapper = Bitmap::wrap(alloc_map, POOL_SIZE / CHUNK_SIZE);
-    bitmap_wrapper.set_range(start, a->allocation_size_in_chunks, false);
-
-    g_kmalloc_bytes_allocated -= a->allocation_size_in_chunks * CHUNK_SIZE;
-    g_kmalloc_bytes_free += a->allocation_size_in_chunks * CHUNK_SIZE;
+    g_kmalloc_bytes_allocated -= real_size;
+    g_kmalloc_bytes_free += real_size;
 
 #ifdef SANITIZE_KMALLOC
-    memset(a, KFREE_SCRUB_BYTE, a->allocation_size_in_chunks * CHUNK_SIZE);
+    memset(ptr, KFREE_SCRUB_BYTE, real_size);
 #endif
+
+    if (first.kind == SpanKind::Slab)
+        free_block(arena, first, ptr);
+    else
+        free_spans(arena, first);
 }
 
 void* krealloc(void* ptr, size_t new_size)
@@ -197,10 +520,8 @@ void* krealloc(void* ptr, size_t new_size)
 
     Kernel::InterruptDisabler disabler;
 
-    auto* a = (AllocationHeader*)((((u8*)ptr) - sizeof(AllocationHeader)));
-    size_t old_size = a->allocation_size_in_chunks * CHUNK_SIZE;
-
-    if (old_size == new_size)
+    size_t old_size = allocation_size(arena_for(ptr), ptr);
+    if (new_size <= old_size && new_size > old_size / 2)
         return ptr;
 
     auto* new_ptr = kmalloc(new_size);
@@ -209,6 +530,12 @@ void* krealloc(void* ptr, size_t new_size)
     return new_ptr;
 }
 
+void kmalloc_size_class_stats(Function<void(size_t size, size_t allocated, size_t free)> callback)
+{
+    for (auto& size_class : s_size_classes)
+        callback(size_class.size, size_class.allocated_blocks, size_class.total_blocks - size_class.allocated_blocks);
+}
+
 void* operator new(size_t size)
 {
     return kmalloc(size);
@@ -26,6 +26,7 @@
 
 #pragma once
 
+#include <AK/Forward.h>
 #include <AK/Types.h>
 
 //#define KMALLOC_DEBUG_LARGE_ALLOCATIONS
@@ -33,11 +34,20 @@
 #define KMALLOC_SCRUB_BYTE 0xbb
 #define KFREE_SCRUB_BYTE 0xaa
 
+#define KMALLOC_SPAN_SIZE (16 * KB)
+
 void kmalloc_init();
+// Sets aside kernel address space for the heap to grow into. Needs the MemoryManager.
+void kmalloc_enable_expansion();
+bool kmalloc_heap_needs_growth();
+void kmalloc_grow_heap();
+void kmalloc_size_class_stats(Function<void(size_t size_class, size_t allocated, size_t free)>);
 [[gnu::malloc, gnu::returns_nonnull, gnu::alloc_size(1)]] void* kmalloc_impl(size_t);
 [[gnu::malloc, gnu::returns_nonnull, gnu::alloc_size(1)]] void* kmalloc_eternal(size_t);
 [[gnu::malloc, gnu::returns_nonnull, gnu::alloc_size(1)]] void* kmalloc_page_aligned(size_t);
 [[gnu::malloc, gnu::returns_nonnull, gnu::alloc_size(1)]] void* kmalloc_aligned(size_t, size_t alignment);
+// Starts on a KMALLOC_SPAN_SIZE boundary, and is rounded up to a multiple of it.
+[[gnu::malloc, gnu::returns_nonnull, gnu::alloc_size(1)]] void* kmalloc_span_aligned(size_t);
 void* krealloc(void*, size_t);
 void kfree(void*);
 void kfree_aligned(void*);
@@ -30,10 +30,20 @@
 #include <Kernel/Arch/i386/CPU.h>
 #include <Kernel/IO.h>
 #include <Kernel/Interrupts/APIC.h>
+#include <Kernel/Interrupts/GenericInterruptHandler.h>
 #include <Kernel/Interrupts/SpuriousInterruptHandler.h>
+#include <Kernel/PerformanceCounters.h>
+#include <Kernel/Scheduler.h>
+#include <Kernel/StdLib.h>
+#include <Kernel/Thread.h>
+#include <Kernel/Time/TimeManagement.h>
 #include <Kernel/VM/MemoryManager.h>
-#include <Kernel/VM/TypedMapping.h>
+#include <Kernel/VM/PageDirectory.h>
 
+#define IRQ_APIC_PERFORMANCE_COUNTER 0x7b
+#define IRQ_APIC_WAKEUP 0x7c
+#define IRQ_APIC_TLB_SHOOTDOWN 0x7d
+#define IRQ_APIC_TIMER 0x7e
 #define IRQ_APIC_SPURIOUS 0x7f
 
 #define APIC_BASE_MSR 0x1b
@@ -51,6 +61,12 @@
 #define APIC_REG_LVT_LINT0 0x350
 #define APIC_REG_LVT_LINT1 0x360
 #define APIC_REG_LVT_ERR 0x370
+#define APIC_REG_TIMER_INITIAL_COUNT 0x380
+#define APIC_REG_TIMER_CURRENT_COUNT 0x390
+#define APIC_REG_TIMER_DIVIDE_CONFIGURATION 0x3e0
+
+// Where the application processors start executing in real mode (the SIPI vector is this >> 12).
+#define APIC_AP_START_PADDR 0x8000
 
 namespace Kernel {
 
@@ -58,6 +74,7 @@ namespace APIC {
 
 class ICRReg {
     u32 m_reg { 0 };
+    u8 m_destination { 0 };
 
 public:
     enum DeliveryMode {
@@ -70,7 +87,7 @@ public:
     };
     enum DestinationMode {
         Physical = 0x0,
-        Logical = 0x0,
+        Logical = 0x1,
     };
     enum Level {
         DeAssert = 0x0,
@@ -87,16 +104,87 @@ public:
         AllExcludingSelf = 0x3,
     };
 
-    ICRReg(u8 vector, DeliveryMode delivery_mode, DestinationMode destination_mode, Level level, TriggerMode trigger_mode, DestinationShorthand destination)
-        : m_reg(vector | (delivery_mode << 8) | (destination_mode << 11) | (level << 14) | (static_cast<u32>(trigger_mode) << 15) | (destination << 18))
+    ICRReg(u8 vector, DeliveryMode delivery_mode, DestinationMode destination_mode, Level level, TriggerMode trigger_mode, DestinationShorthand destination_shorthand, u8 destination = 0)
+        : m_reg(vector | (delivery_mode << 8) | (destination_mode << 11) | (level << 14) | (static_cast<u32>(trigger_mode) << 15) | (destination_shorthand << 18))
+        , m_destination(destination)
     {
     }
 
     u32 low() const { return m_reg; }
-    u32 high() const { return 0; }
+    u32 high() const { return (u32)m_destination << 24; }
+};
+
+class APICInterruptHandler : public GenericInterruptHandler {
+public:
+    virtual size_t sharing_devices_count() const override { return 0; }
+    virtual bool is_shared_handler() const override { return false; }
+    virtual bool is_sharing_with_others() const override { return false; }
+
+    virtual HandlerType type() const override { return HandlerType::LocalAPICHandler; }
+    virtual const char* controller() const override { return "Local APIC"; }
+
+    virtual bool eoi() override
+    {
+        APIC::eoi();
+        return true;
+    }
+
+protected:
+    explicit APICInterruptHandler(u8 interrupt_number)
+        : GenericInterruptHandler(interrupt_number)
+    {
+    }
+};
+
+class APICTimerInterruptHandler final : public APICInterruptHandler {
+public:
+    APICTimerInterruptHandler()
+        : APICInterruptHandler(IRQ_APIC_TIMER)
+    {
+    }
+
+    // NOTE: Only the application processors use this. The BSP is driven by the system timer.
+    virtual void handle_interrupt(const RegisterState& regs) override { Scheduler::timer_tick(regs); }
+    virtual const char* purpose() const override { return "Local APIC Timer"; }
+};
+
+class APICTLBShootdownInterruptHandler final : public APICInterruptHandler {
+public:
+    APICTLBShootdownInterruptHandler()
+        : APICInterruptHandler(IRQ_APIC_TLB_SHOOTDOWN)
+    {
+    }
+
+    virtual void handle_interrupt(const RegisterState&) override { Processor::current().handle_tlb_shootdown(); }
+    virtual const char* purpose() const override { return "TLB Shootdown IPI"; }
+};
+
+class APICWakeupInterruptHandler final : public APICInterruptHandler {
+public:
+    APICWakeupInterruptHandler()
+        : APICInterruptHandler(IRQ_APIC_WAKEUP)
+    {
+    }
+
+    // NOTE: There's nothing to do here, getting the CPU out of hlt is all we wanted.
+    virtual void handle_interrupt(const RegisterState&) override { }
+    virtual const char* purpose() const override { return "Wakeup IPI"; }
+};
+
+class APICPerformanceCounterInterruptHandler final : public APICInterruptHandler {
+public:
+    APICPerformanceCounterInterruptHandler()
+        : APICInterruptHandler(IRQ_APIC_PERFORMANCE_COUNTER)
+    {
+    }
+
+    virtual void handle_interrupt(const RegisterState& regs) override { PerformanceCounters::handle_overflow_interrupt(regs); }
+    virtual const char* purpose() const override { return "Performance Counter Overflow"; }
 };
 
 static PhysicalAddress g_apic_base;
+static volatile u8* s_apic_registers;
+static u32 s_timer_ticks_per_system_tick;
 
 static PhysicalAddress get_base()
 {
@@ -116,38 +204,127 @@ static void set_base(const PhysicalAddress& base)
 
 static void write_register(u32 offset, u32 value)
 {
-    *map_typed_writable<u32>(g_apic_base.offset(offset)) = value;
+    *reinterpret_cast<volatile u32*>(s_apic_registers + offset) = value;
 }
 
 static u32 read_register(u32 offset)
 {
-    return *map_typed<u32>(g_apic_base.offset(offset));
+    return *reinterpret_cast<volatile u32*>(s_apic_registers + offset);
 }
 
 static void write_icr(const ICRReg& icr)
 {
     write_register(APIC_REG_ICR_HIGH, icr.high());
     write_register(APIC_REG_ICR_LOW, icr.low());
+
+    // Wait until the local APIC has sent the interrupt on its way.
+    while (read_register(APIC_REG_ICR_LOW) & (1 << 12))
+        asm volatile("pause");
 }
 
 #define APIC_LVT_MASKED (1 << 16)
 #define APIC_LVT_TRIGGER_LEVEL (1 << 14)
-#define APIC_LVT(iv, dm) ((iv & 0xff) | ((dm & 0x7) << 8))
+#define APIC_LVT_TIMER_PERIODIC (1 << 17)
+#define APIC_LVT(iv, dm) (((iv) & 0xff) | (((dm) & 0x7) << 8))
 
+// The application processors start out in real mode at APIC_AP_START_PADDR, with CS:IP = 0x800:0000.
+// This switches them into protected mode, turns on PAE paging with the kernel page tables
+// (the startup code is identity mapped for the occasion), and calls init_ap() on a fresh stack.
+// The variables at the end are filled in by boot_aps() in the copy that is actually executed.
 asm(
+    ".p2align 4 \n"
     ".globl apic_ap_start \n"
     ".type apic_ap_start, @function \n"
     "apic_ap_start: \n"
     ".set begin_apic_ap_start, . \n"
-    "    jmp apic_ap_start\n" // TODO: implement
+    ".code16 \n"
+    "    cli \n"
+    "    jmp $0x800, $(1f - begin_apic_ap_start) \n"
+    "1: \n"
+    "    mov %cs, %ax \n"
+    "    mov %ax, %ds \n"
+    "    movl $1, %eax \n"
+    "    lock; xaddl %eax, (ap_cpu_id - begin_apic_ap_start) \n"
+    "    movl %eax, %esi \n"
+    "    lgdtl (ap_cpu_gdtr - begin_apic_ap_start) \n"
+    "    movl %cr0, %eax \n"
+    "    orl $1, %eax \n"
+    "    movl %eax, %cr0 \n"
+    "    ljmpl $8, $(apic_ap_start32 - begin_apic_ap_start + 0x8000) \n"
+    ".code32 \n"
+    "apic_ap_start32: \n"
+    "    mov $0x10, %ax \n"
+    "    mov %ax, %ss \n"
+    "    mov %ax, %ds \n"
+    "    mov %ax, %es \n"
+    "    mov %ax, %fs \n"
+    "    mov %ax, %gs \n"
+    "    movl $0x8000, %ebp \n"
+    /* enable PAE + PSE */
+    "    movl %cr4, %eax \n"
+    "    orl $0x60, %eax \n"
+    "    movl %eax, %cr4 \n"
+    "    movl (ap_cpu_init_cr3 - begin_apic_ap_start)(%ebp), %eax \n"
+    "    movl %eax, %cr3 \n"
+    /* turn on IA32_EFER.NXE before the page tables start using NX bits on us */
+    "    cmpl $0, (ap_cpu_init_nx - begin_apic_ap_start)(%ebp) \n"
+    "    je 2f \n"
+    "    movl $0xc0000080, %ecx \n"
+    "    rdmsr \n"
+    "    orl $0x800, %eax \n"
+    "    wrmsr \n"
+    "2: \n"
+    /* enable PG */
+    "    movl %cr0, %eax \n"
+    "    orl $0x80000000, %eax \n"
+    "    movl %eax, %cr0 \n"
+    /* the arrays are indexed by cpu - 1, since the BSP doesn't need an entry */
+    "    movl (ap_cpu_init_stacks - begin_apic_ap_start - 4)(%ebp, %esi, 4), %esp \n"
+    "    movl (ap_cpu_init_processors - begin_apic_ap_start - 4)(%ebp, %esi, 4), %eax \n"
+    "    pushl %eax \n"
+    "    pushl %esi \n"
+    "    pushl $0 \n"
+    "    movl $init_ap, %eax \n"
+    "    jmp *%eax \n"
+    ".p2align 3 \n"
+    "ap_cpu_gdt: \n"
+    "    .quad 0x0000000000000000 \n"
+    "    .quad 0x00cf9a000000ffff \n"
+    "    .quad 0x00cf92000000ffff \n"
+    "ap_cpu_gdtr: \n"
+    "    .word 23 \n"
+    "    .long ap_cpu_gdt - begin_apic_ap_start + 0x8000 \n"
+    ".p2align 2 \n"
+    ".globl ap_cpu_id \n"
+    "ap_cpu_id: \n"
+    "    .long 0 \n"
+    ".globl ap_cpu_init_cr3 \n"
+    "ap_cpu_init_cr3: \n"
+    "    .long 0 \n"
+    ".globl ap_cpu_init_nx \n"
+    "ap_cpu_init_nx: \n"
+    "    .long 0 \n"
+    ".globl ap_cpu_init_stacks \n"
+    "ap_cpu_init_stacks: \n"
+    "    .fill 7, 4, 0 \n"
+    ".globl ap_cpu_init_processors \n"
+    "ap_cpu_init_processors: \n"
+    "    .fill 7, 4, 0 \n"
     ".set end_apic_ap_start, . \n"
     "\n"
     ".globl apic_ap_start_size \n"
     "apic_ap_start_size: \n"
     ".word end_apic_ap_start - begin_apic_ap_start \n");
 
+static_assert(MAX_PROCESSOR_COUNT == 8, "The AP startup code has room for 7 application processors");
+
 extern "C" void apic_ap_start(void);
 extern "C" u16 apic_ap_start_size;
+extern "C" u32 ap_cpu_id;
+extern "C" u32 ap_cpu_init_cr3;
+extern "C" u32 ap_cpu_init_nx;
+extern "C" u32 ap_cpu_init_stacks[MAX_PROCESSOR_COUNT - 1];
+extern "C" Processor* ap_cpu_init_processors[MAX_PROCESSOR_COUNT - 1];
 
 void eoi()
 {
@@ -176,9 +353,19 @@ bool init()
 
     g_apic_base = apic_base;
 
+    // Keep the registers mapped for good. Mapping them on every access would mean
+    // unmapping them again, and every unmap has to be flushed from all the CPUs.
+    auto region = MM.allocate_kernel_region(apic_base, PAGE_SIZE, "APIC", Region::Access::Read | Region::Access::Write, false, false);
+    s_apic_registers = region.leak_ptr()->vaddr().as_ptr();
+
     return true;
 }
 
+bool is_initialized()
+{
+    return s_apic_registers;
+}
+
 void enable_bsp()
 {
     // FIXME: Ensure this method can only be executed by the BSP.
@@ -187,6 +374,7 @@ void enable_bsp()
 
 void enable(u32 cpu)
 {
+    ASSERT(cpu < MAX_PROCESSOR_COUNT);
     klog() << "Enabling local APIC for cpu #" << cpu;
 
     // dummy read, apparently to avoid a bug in old CPUs.
@@ -198,9 +386,13 @@ void enable(u32 cpu)
     write_register(APIC_REG_DF, 0xf0000000);
 
     // set destination id (note that this limits it to 8 cpus)
-    write_register(APIC_REG_LD, 0);
+    write_register(APIC_REG_LD, (1 << cpu) << 24);
 
-    SpuriousInterruptHandler::initialize(IRQ_APIC_SPURIOUS);
+    if (cpu == 0) {
+        SpuriousInterruptHandler::initialize(IRQ_APIC_SPURIOUS);
+        if (PerformanceCounters::is_supported())
+            new APICPerformanceCounterInterruptHandler;
+    }
 
     write_register(APIC_REG_LVT_TIMER, APIC_LVT(0, 0) | APIC_LVT_MASKED);
     write_register(APIC_REG_LVT_THERMAL, APIC_LVT(0, 0) | APIC_LVT_MASKED);
@@ -209,21 +401,123 @@ void enable(u32 cpu)
     write_register(APIC_REG_LVT_LINT1, APIC_LVT(0, 0) | APIC_LVT_TRIGGER_LEVEL);
     write_register(APIC_REG_LVT_ERR, APIC_LVT(0, 0) | APIC_LVT_MASKED);
 
+    if (PerformanceCounters::is_supported())
+        enable_performance_counter_interrupt();
+
     write_register(APIC_REG_TPR, 0);
+}
+
+void enable_performance_counter_interrupt()
+{
+    write_register(APIC_REG_LVT_PERFORMANCE_COUNTER, APIC_LVT(IRQ_APIC_PERFORMANCE_COUNTER + IRQ_VECTOR_BASE, 0));
+}
 
-    if (cpu != 0) {
-        // INIT
-        write_icr(ICRReg(0, ICRReg::INIT, ICRReg::Physical, ICRReg::Assert, ICRReg::TriggerMode::Edge, ICRReg::AllExcludingSelf));
+static void calibrate_timer()
+{
+    // Count down from the top at 1/16 of the bus clock for a few system timer ticks' worth of time.
+    write_register(APIC_REG_TIMER_DIVIDE_CONFIGURATION, 0x3);
+    write_register(APIC_REG_LVT_TIMER, APIC_LVT(IRQ_APIC_TIMER + IRQ_VECTOR_BASE, 0) | APIC_LVT_MASKED);
+
+    auto& time_management = TimeManagement::the();
+    // Line up with the start of a tick first, in case the monotonic clock only moves with the time keeper.
+    Thread::current()->sleep(1'000'000);
+    u64 start_time = time_management.monotonic_time_ns();
+    write_register(APIC_REG_TIMER_INITIAL_COUNT, 0xffffffff);
+    Thread::current()->sleep(10'000'000);
+    u32 elapsed = 0xffffffff - read_register(APIC_REG_TIMER_CURRENT_COUNT);
+    u64 elapsed_ns = time_management.monotonic_time_ns() - start_time;
+    write_register(APIC_REG_TIMER_INITIAL_COUNT, 0);
+
+    ASSERT(elapsed_ns);
+    s_timer_ticks_per_system_tick = (u64)elapsed * 1'000'000'000 / time_management.ticks_per_second() / elapsed_ns;
+    klog() << "APIC: Timer runs at " << s_timer_ticks_per_system_tick << " ticks per system timer tick";
+}
 
-        IO::delay(10 * 1000);
+void enable_timer()
+{
+    ASSERT(s_timer_ticks_per_system_tick);
+    write_register(APIC_REG_TIMER_DIVIDE_CONFIGURATION, 0x3);
+    write_register(APIC_REG_LVT_TIMER, APIC_LVT(IRQ_APIC_TIMER + IRQ_VECTOR_BASE, 0) | APIC_LVT_TIMER_PERIODIC);
+    write_register(APIC_REG_TIMER_INITIAL_COUNT, s_timer_ticks_per_system_tick);
+}
 
-        for (int i = 0; i < 2; i++) {
-            // SIPI
-            write_icr(ICRReg(0x08, ICRReg::StartUp, ICRReg::Physical, ICRReg::Assert, ICRReg::TriggerMode::Edge, ICRReg::AllExcludingSelf)); // start execution at P8000
+void send_tlb_shootdown(u32 cpu)
+{
+    ASSERT(cpu < MAX_PROCESSOR_COUNT);
+    write_icr(ICRReg(IRQ_APIC_TLB_SHOOTDOWN + IRQ_VECTOR_BASE, ICRReg::Fixed, ICRReg::Logical, ICRReg::Assert, ICRReg::TriggerMode::Edge, ICRReg::NoShorthand, 1 << cpu));
+}
 
-            IO::delay(200);
-        }
+void send_wakeup(u32 cpu)
+{
+    ASSERT(cpu < MAX_PROCESSOR_COUNT);
+    write_icr(ICRReg(IRQ_APIC_WAKEUP + IRQ_VECTOR_BASE, ICRReg::Fixed, ICRReg::Logical, ICRReg::Assert, ICRReg::TriggerMode::Edge, ICRReg::NoShorthand, 1 << cpu));
+}
+
+template<typename T>
+static T& ap_start_variable(u8* ap_start, T& variable)
+{
+    return *reinterpret_cast<T*>(ap_start + ((FlatPtr)&variable - (FlatPtr)&apic_ap_start));
+}
+
+void boot_aps(size_t processor_count)
+{
+    ASSERT(is_initialized());
+    ASSERT(Processor::current().is_bootstrap_processor());
+
+    if (processor_count > MAX_PROCESSOR_COUNT) {
+        klog() << "APIC: Only using " << MAX_PROCESSOR_COUNT << " of " << processor_count << " processors";
+        processor_count = MAX_PROCESSOR_COUNT;
     }
+    if (processor_count <= 1)
+        return;
+    size_t ap_count = processor_count - 1;
+
+    calibrate_timer();
+    new APICTimerInterruptHandler;
+    new APICTLBShootdownInterruptHandler;
+    new APICWakeupInterruptHandler;
+
+    // Each AP needs a stack to run init_ap() on until it switches to its idle thread.
+    static constexpr size_t ap_boot_stack_size = 16 * KB;
+    auto* stacks_region = MM.allocate_kernel_region(ap_count * ap_boot_stack_size, "AP Boot Stacks", Region::Access::Read | Region::Access::Write).leak_ptr();
+
+    auto ap_start_region = MM.allocate_kernel_region(PhysicalAddress(APIC_AP_START_PADDR), PAGE_SIZE, "AP Start", Region::Access::Read | Region::Access::Write);
+    auto* ap_start = ap_start_region->vaddr().as_ptr();
+    ASSERT(apic_ap_start_size <= PAGE_SIZE);
+    memcpy(ap_start, (const void*)apic_ap_start, apic_ap_start_size);
+
+    ap_start_variable(ap_start, ap_cpu_id) = 1;
+    ap_start_variable(ap_start, ap_cpu_init_cr3) = MM.kernel_page_directory().cr3();
+    ap_start_variable(ap_start, ap_cpu_init_nx) = g_cpu_supports_nx;
+    for (size_t i = 0; i < ap_count; ++i) {
+        ap_start_variable(ap_start, ap_cpu_init_stacks)[i] = stacks_region->vaddr().offset((i + 1) * ap_boot_stack_size).get();
+        ap_start_variable(ap_start, ap_cpu_init_processors)[i] = new Processor;
+    }
+
+    // The APs turn on paging while still running the startup code, so it has to stay where it is.
+    MM.identity_map_low_page(VirtualAddress(APIC_AP_START_PADDR));
+
+    klog() << "APIC: Starting " << ap_count << " application processor(s)";
+
+    // INIT
+    write_icr(ICRReg(0, ICRReg::INIT, ICRReg::Physical, ICRReg::Assert, ICRReg::TriggerMode::Edge, ICRReg::AllExcludingSelf));
+
+    IO::delay(10 * 1000);
+
+    for (int i = 0; i < 2; i++) {
+        // SIPI
+        write_icr(ICRReg(APIC_AP_START_PADDR >> 12, ICRReg::StartUp, ICRReg::Physical, ICRReg::Assert, ICRReg::TriggerMode::Edge, ICRReg::AllExcludingSelf));
+
+        IO::delay(200);
+    }
+
+    // NOTE: The APs bump the online count before taking the kernel lock, so it's fine to hold it here.
+    // FIXME: Give up on processors that never show up.
+    while (Processor::online_count() < processor_count)
+        asm volatile("pause");
+
+    MM.unmap_low_page(VirtualAddress(APIC_AP_START_PADDR));
+    klog() << "APIC: " << Processor::online_count() << " processors online";
 }
 
 }
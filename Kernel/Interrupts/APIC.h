@@ -35,7 +35,13 @@ namespace APIC {
 void enable_bsp();
 void eoi();
 bool init();
+bool is_initialized();
 void enable(u32 cpu);
+void enable_timer();
+void enable_performance_counter_interrupt();
+void boot_aps(size_t processor_count);
+void send_tlb_shootdown(u32 cpu);
+void send_wakeup(u32 cpu);
 u8 spurious_interrupt_vector();
 }
 
@@ -206,11 +206,20 @@ void InterruptManagement::locate_apic_data()
         m_interrupt_controllers[0] = adopt(*new PIC());
         irq_controller_count++;
     }
+    size_t processor_count = 0;
     size_t entry_index = 0;
     size_t entries_length = madt->h.length - sizeof(ACPI::Structures::MADT);
     auto* madt_entry = madt->entries;
     while (entries_length > 0) {
         size_t entry_length = madt_entry->length;
+        if (madt_entry->type == (u8)ACPI::Structures::MADTEntryType::LocalAPIC) {
+            auto* local_apic_entry = (const ACPI::Structures::MADTEntries::ProcessorLocalAPIC*)madt_entry;
+            // Bit 0 of the flags tells whether the processor is usable.
+            if (local_apic_entry->flags & 1) {
+                dbg() << "Interrupts: Processor " << (u32)local_apic_entry->acpi_processor_id << " (APIC ID " << (u32)local_apic_entry->apic_id << ") found @ MADT entry " << entry_index;
+                processor_count++;
+            }
+        }
         if (madt_entry->type == (u8)ACPI::Structures::MADTEntryType::IOAPIC) {
             auto* ioapic_entry = (const ACPI::Structures::MADTEntries::IOAPIC*)madt_entry;
             dbg() << "IOAPIC found @ MADT entry " << entry_index << ", MMIO Registers @ " << PhysicalAddress(ioapic_entry->ioapic_address);
@@ -231,6 +240,8 @@ void InterruptManagement::locate_apic_data()
         entries_length -= entry_length;
         entry_index++;
     }
+    if (processor_count)
+        m_processor_count = processor_count;
 }
 
 }
@@ -74,6 +74,7 @@ public:
     virtual void switch_to_ioapic_mode();
 
     bool smp_enabled() const { return m_smp_enabled; }
+    size_t processor_count() const { return m_processor_count; }
     RefPtr<IRQController> get_responsible_irq_controller(u8 interrupt_vector);
 
     const Vector<ISAInterruptOverrideMetadata>& isa_overrides() const { return m_isa_interrupt_overrides; }
@@ -89,6 +90,7 @@ private:
     PhysicalAddress search_for_madt();
     void locate_apic_data();
     bool m_smp_enabled { false };
+    size_t m_processor_count { 1 };
     FixedArray<RefPtr<IRQController>> m_interrupt_controllers { 1 };
     Vector<ISAInterruptOverrideMetadata> m_isa_interrupt_overrides;
     Vector<PCIInterruptOverrideMetadata> m_pci_interrupt_overrides;
@@ -107,6 +107,7 @@ public:
 
     void set_size(size_t size) { m_impl->set_size(size); }
 
+    KBufferImpl& impl() { return m_impl; }
     const KBufferImpl& impl() const { return m_impl; }
 
     KBuffer(const ByteBuffer& buffer, u8 access = Region::Access::Read | Region::Access::Write, const char* name = "KBuffer")
@@ -24,6 +24,7 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <AK/BinarySearch.h>
 #include <AK/Demangle.h>
 #include <AK/TemporaryChange.h>
 #include <Kernel/FileSystem/FileDescription.h>
@@ -62,11 +63,13 @@ const KernelSymbol* symbolicate_kernel_address(u32 address)
 {
     if (address < g_lowest_kernel_symbol_address || address > g_highest_kernel_symbol_address)
         return nullptr;
-    for (unsigned i = 0; i < s_symbol_count; ++i) {
-        if (address < s_symbols[i + 1].address)
-            return &s_symbols[i];
-    }
-    return nullptr;
+    // The symbol map is generated sorted by address (nm -n).
+    size_t index = upper_bound(s_symbols, s_symbol_count, address, [](u32 address, auto& symbol) {
+        return address < symbol.address;
+    });
+    if (index == 0)
+        return nullptr;
+    return &s_symbols[index - 1];
 }
 
 static void load_kernel_sybols_from_data(const ByteBuffer& buffer)
@@ -130,8 +133,8 @@ NEVER_INLINE void dump_backtrace_impl(FlatPtr base_pointer, bool use_ksyms)
     }
 
     OwnPtr<Process::ELFBundle> elf_bundle;
-    if (Process::current)
-        elf_bundle = Process::current->elf_bundle();
+    if (Process::current())
+        elf_bundle = Process::current()->elf_bundle();
 
     struct RecognizedSymbol {
         FlatPtr address;
@@ -142,13 +145,13 @@ NEVER_INLINE void dump_backtrace_impl(FlatPtr base_pointer, bool use_ksyms)
     size_t recognized_symbol_count = 0;
     if (use_ksyms) {
         for (FlatPtr* stack_ptr = (FlatPtr*)base_pointer;
-             (Process::current ? Process::current->validate_read_from_kernel(VirtualAddress(stack_ptr), sizeof(void*) * 2) : 1) && recognized_symbol_count < max_recognized_symbol_count; stack_ptr = (FlatPtr*)*stack_ptr) {
+             (Process::current() ? Process::current()->validate_read_from_kernel(VirtualAddress(stack_ptr), sizeof(void*) * 2) : 1) && recognized_symbol_count < max_recognized_symbol_count; stack_ptr = (FlatPtr*)*stack_ptr) {
             FlatPtr retaddr = stack_ptr[1];
             recognized_symbols[recognized_symbol_count++] = { retaddr, symbolicate_kernel_address(retaddr) };
         }
     } else {
         for (FlatPtr* stack_ptr = (FlatPtr*)base_pointer;
-             (Process::current ? Process::current->validate_read_from_kernel(VirtualAddress(stack_ptr), sizeof(void*) * 2) : 1); stack_ptr = (FlatPtr*)*stack_ptr) {
+             (Process::current() ? Process::current()->validate_read_from_kernel(VirtualAddress(stack_ptr), sizeof(void*) * 2) : 1); stack_ptr = (FlatPtr*)*stack_ptr) {
             FlatPtr retaddr = stack_ptr[1];
             dbg() << String::format("%x", retaddr) << " (next: " << String::format("%x", (stack_ptr ? (u32*)*stack_ptr : 0)) << ")";
         }
@@ -26,7 +26,11 @@
 
 #include <Kernel/KSyms.h>
 #include <Kernel/Lock.h>
+#include <Kernel/PerformanceEventBuffer.h>
+#include <Kernel/Process.h>
+#include <Kernel/StdLib.h>
 #include <Kernel/Thread.h>
+#include <Kernel/Time/TimeManagement.h>
 
 namespace Kernel {
 
@@ -41,6 +45,78 @@ static bool modes_conflict(Lock::Mode mode1, Lock::Mode mode2)
     return true;
 }
 
+LockStatistics Lock::s_statistics[max_statistics_count];
+size_t Lock::s_statistics_count;
+
+LockStatistics& Lock::statistics()
+{
+    if (m_statistics)
+        return *m_statistics;
+
+    const char* name = m_name ? m_name : "(unnamed)";
+    for (size_t i = 0; i < s_statistics_count; ++i) {
+        if (s_statistics[i].name == name || !strcmp(s_statistics[i].name, name)) {
+            m_statistics = &s_statistics[i];
+            return *m_statistics;
+        }
+    }
+
+    // Once we run out of slots, everyone else shares the last one.
+    if (s_statistics_count == max_statistics_count) {
+        m_statistics = &s_statistics[max_statistics_count - 1];
+        return *m_statistics;
+    }
+    m_statistics = &s_statistics[s_statistics_count++];
+    m_statistics->name = s_statistics_count == max_statistics_count ? "(other)" : name;
+    return *m_statistics;
+}
+
+// How long we're willing to wait for a holder that's running on another CPU before going to sleep.
+static constexpr u32 max_spins_before_blocking = 2000;
+
+// Only every this many contended releases of a lock get their backtrace taken.
+static constexpr u32 holder_sample_interval = 8;
+
+static u64 now_ns()
+{
+    return TimeManagement::initialized() ? TimeManagement::the().monotonic_time_ns() : 0;
+}
+
+void Lock::sample_holder(LockStatistics& statistics)
+{
+    ASSERT_INTERRUPTS_DISABLED();
+    if (statistics.contended_releases++ % holder_sample_interval)
+        return;
+    auto* thread = Thread::current();
+    if (!thread)
+        return;
+
+    LockHolderSample sample {};
+    FlatPtr ebp;
+    asm volatile("movl %%ebp, %%eax"
+                 : "=a"(ebp));
+    size_t depth = 0;
+    while (depth < LockHolderSample::max_backtrace_depth && ebp >= thread->kernel_stack_base() && ebp + sizeof(FlatPtr) * 2 <= thread->kernel_stack_top()) {
+        auto* frame = (FlatPtr*)ebp;
+        sample.backtrace[depth++] = frame[1];
+        ebp = frame[0];
+    }
+
+    // Keep the most common backtraces: a new one that doesn't fit replaces the rarest
+    // one, and inherits its count so that it has to earn its place against the others.
+    LockHolderSample* rarest = &statistics.holder_samples[0];
+    for (auto& existing : statistics.holder_samples) {
+        if (existing.count && !memcmp(existing.backtrace, sample.backtrace, sizeof(sample.backtrace))) {
+            ++existing.count;
+            return;
+        }
+        if (existing.count < rarest->count)
+            rarest = &existing;
+    }
+    sample.count = rarest->count + 1;
+    *rarest = sample;
+}
+
 void Lock::lock(Mode mode)
 {
     ASSERT(mode != Mode::Unlocked);
@@ -50,51 +126,132 @@ void Lock::lock(Mode mode)
         dump_backtrace();
         hang();
     }
+    bool contended = false;
+    bool spun = false;
+    bool blocked = false;
+    u64 wait_start_ns = 0;
+    u64 wait_start_tsc = 0;
     for (;;) {
+        // The inner lock is only ever held with interrupts disabled, so nobody
+        // gets preempted while holding it and it's always cheap to spin on.
+        cli();
         bool expected = false;
-        if (m_lock.compare_exchange_strong(expected, true, AK::memory_order_acq_rel)) {
-            // FIXME: Do not add new readers if writers are queued.
-            bool modes_dont_conflict = !modes_conflict(m_mode, mode);
-            bool already_hold_exclusive_lock = m_mode == Mode::Exclusive && m_holder == Thread::current;
-            if (modes_dont_conflict || already_hold_exclusive_lock) {
-                // We got the lock!
-                if (!already_hold_exclusive_lock)
-                    m_mode = mode;
-                m_holder = Thread::current;
-                m_times_locked++;
-                m_lock.store(false, AK::memory_order_release);
-                return;
+        if (!m_lock.compare_exchange_strong(expected, true, AK::memory_order_acq_rel)) {
+            sti();
+            asm volatile("pause");
+            continue;
+        }
+
+        auto& statistics = this->statistics();
+        if (!contended)
+            ++statistics.acquisitions;
+
+        // FIXME: Do not add new readers if writers are queued.
+        bool modes_dont_conflict = !modes_conflict(m_mode, mode);
+        bool already_hold_exclusive_lock = m_mode == Mode::Exclusive && m_holder == Thread::current();
+        if (modes_dont_conflict || already_hold_exclusive_lock) {
+            // We got the lock!
+            if (!already_hold_exclusive_lock)
+                m_mode = mode;
+            m_holder = Thread::current();
+            m_times_locked++;
+            if (spun && !blocked)
+                ++statistics.spin_acquisitions;
+            if (contended) {
+                u64 wait_ns = now_ns() - wait_start_ns;
+                statistics.total_wait_ns += wait_ns;
+                if (wait_ns > statistics.max_wait_ns)
+                    statistics.max_wait_ns = wait_ns;
+            }
+            m_lock.store(false, AK::memory_order_release);
+            if (contended && Process::current()) {
+                if (auto* kernel_event_buffer = Process::current()->kernel_event_buffer())
+                    kernel_event_buffer->append_lock_wait(*Thread::current(), statistics.name, wait_start_tsc);
             }
-            timeval* timeout = nullptr;
-            Thread::current->wait_on(m_queue, timeout, &m_lock, m_holder, m_name);
+            sti();
+            return;
+        }
+
+        if (!contended) {
+            contended = true;
+            ++statistics.contentions;
+            wait_start_ns = now_ns();
+            wait_start_tsc = read_tsc();
+        }
+        m_contended = true;
+
+        // A holder that's running on another CPU can only be waiting for the kernel lock,
+        // and is probably going to let go of this one right after it gets it. Make way
+        // for it and wait a little, that's a lot cheaper than going to sleep.
+        Thread* holder = m_holder;
+        if (!spun && holder && holder != Thread::current() && holder->state() == Thread::Running) {
+            spun = true;
+            m_lock.store(false, AK::memory_order_release);
+            Processor::current().spin_without_kernel_lock(max_spins_before_blocking, [&] {
+                return m_mode == Mode::Unlocked || m_holder != holder;
+            });
+            sti();
+            continue;
+        }
+
+        ++statistics.blocks;
+        blocked = true;
+        if (mode == Mode::Shared)
+            ++m_shared_waiters;
+        timeval* timeout = nullptr;
+        Thread::current()->wait_on(m_queue, timeout, &m_lock, holder, m_name);
+        if (mode == Mode::Shared) {
+            InterruptDisabler disabler;
+            --m_shared_waiters;
         }
     }
 }
 
+void Lock::wake_waiters()
+{
+    // Whoever is waiting to share the lock can have it all at once, and any writers
+    // go back to sleep. Otherwise, there's only room for one.
+    if (m_shared_waiters) {
+        m_lock.store(false, AK::memory_order_release);
+        m_queue.wake_all();
+        return;
+    }
+    m_queue.wake_one(&m_lock);
+}
+
 void Lock::unlock()
 {
+    // This may be called with interrupts disabled, e.g. on the way to sleep.
+    bool interrupts_were_enabled = cli_and_save_interrupt_flag();
     for (;;) {
         bool expected = false;
-        if (m_lock.compare_exchange_strong(expected, true, AK::memory_order_acq_rel)) {
-            ASSERT(m_times_locked);
-            --m_times_locked;
-
-            ASSERT(m_mode != Mode::Unlocked);
-            if (m_mode == Mode::Exclusive)
-                ASSERT(m_holder == Thread::current);
-            if (m_holder == Thread::current && (m_mode == Mode::Shared || m_times_locked == 0))
-                m_holder = nullptr;
-
-            if (m_times_locked > 0) {
-                m_lock.store(false, AK::memory_order_release);
-                return;
-            }
-            m_mode = Mode::Unlocked;
-            m_queue.wake_one(&m_lock);
+        if (!m_lock.compare_exchange_strong(expected, true, AK::memory_order_acq_rel)) {
+            asm volatile("pause");
+            continue;
+        }
+
+        ASSERT(m_times_locked);
+        --m_times_locked;
+
+        ASSERT(m_mode != Mode::Unlocked);
+        if (m_mode == Mode::Exclusive)
+            ASSERT(m_holder == Thread::current());
+        if (m_holder == Thread::current() && (m_mode == Mode::Shared || m_times_locked == 0))
+            m_holder = nullptr;
+
+        if (m_times_locked > 0) {
+            m_lock.store(false, AK::memory_order_release);
+            restore_interrupt_flag(interrupts_were_enabled);
             return;
         }
-        // I don't know *who* is using "m_lock", so just yield.
-        Scheduler::yield();
+        m_mode = Mode::Unlocked;
+        if (m_contended) {
+            m_contended = false;
+            sample_holder(statistics());
+        }
+        wake_waiters();
+        restore_interrupt_flag(interrupts_were_enabled);
+        return;
     }
 }
 
@@ -102,13 +259,16 @@ bool Lock::force_unlock_if_locked()
 {
     ASSERT(m_mode != Mode::Shared);
     InterruptDisabler disabler;
-    if (m_holder != Thread::current)
+    if (m_holder != Thread::current())
         return false;
     ASSERT(m_times_locked == 1);
     m_holder = nullptr;
     m_mode = Mode::Unlocked;
     m_times_locked = 0;
-    m_queue.wake_one();
+    if (m_shared_waiters)
+        m_queue.wake_all();
+    else
+        m_queue.wake_one();
     return true;
 }
 
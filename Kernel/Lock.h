@@ -35,6 +35,31 @@
 
 namespace Kernel {
 
+// A kernel backtrace of whoever held a lock while others were waiting for it,
+// and how many of the sampled contended releases came from there.
+struct LockHolderSample {
+    static constexpr size_t max_backtrace_depth = 8;
+    FlatPtr backtrace[max_backtrace_depth];
+    u32 count;
+};
+
+// How much trouble all the locks sharing a name have been, see /proc/locks.
+// NOTE: This has no constructor on purpose, so that locks taken before global
+//       constructors run don't get their numbers wiped.
+struct LockStatistics {
+    static constexpr size_t max_holder_samples = 4;
+
+    const char* name;
+    u32 acquisitions;
+    u32 contentions;
+    u32 spin_acquisitions;
+    u32 blocks;
+    u64 total_wait_ns;
+    u64 max_wait_ns;
+    u32 contended_releases;
+    LockHolderSample holder_samples[max_holder_samples];
+};
+
 class Lock {
 public:
     Lock(const char* name = nullptr)
@@ -57,7 +82,22 @@ public:
 
     const char* name() const { return m_name; }
 
+    template<typename Callback>
+    static void for_each_statistics(Callback callback)
+    {
+        for (size_t i = 0; i < s_statistics_count; ++i)
+            callback(const_cast<const LockStatistics&>(s_statistics[i]));
+    }
+
 private:
+    LockStatistics& statistics();
+    void sample_holder(LockStatistics&);
+    void wake_waiters();
+
+    static constexpr size_t max_statistics_count = 128;
+    static LockStatistics s_statistics[max_statistics_count];
+    static size_t s_statistics_count;
+
     Atomic<bool> m_lock { false };
     const char* m_name { nullptr };
     WaitQueue m_queue;
@@ -73,6 +113,14 @@ private:
     // When locked exclusively, this is always the one thread that holds the
     // lock.
     Thread* m_holder { nullptr };
+
+    // Threads waiting to lock this in shared mode. They all get woken together.
+    u32 m_shared_waiters { 0 };
+
+    // Someone had to wait for the lock since it was last released.
+    bool m_contended { false };
+
+    LockStatistics* m_statistics { nullptr };
 };
 
 class Locker {
@@ -25,6 +25,9 @@
  */
 
 #include <Kernel/Net/E1000NetworkAdapter.h>
+#include <Kernel/Net/EthernetFrameHeader.h>
+#include <Kernel/Net/IPv4.h>
+#include <Kernel/Net/TCP.h>
 #include <Kernel/Thread.h>
 #include <Kernel/IO.h>
 
@@ -46,6 +49,7 @@ namespace Kernel {
 #define REG_RXDESCLEN 0x2808
 #define REG_RXDESCHEAD 0x2810
 #define REG_RXDESCTAIL 0x2818
+#define REG_MISSED_PACKET_COUNT 0x4010
 #define REG_TCTRL 0x0400
 #define REG_TXDESCLO 0x3800
 #define REG_TXDESCHI 0x3804
@@ -99,6 +103,21 @@ namespace Kernel {
 #define CMD_VLE (1 << 6)  // VLAN Packet Enable
 #define CMD_IDE (1 << 7)  // Interrupt Delay Enable
 
+// TX context and data descriptors
+#define DTYP_CONTEXT 0x0
+#define DTYP_DATA 0x1
+#define TUCMD_TCP (1 << 0)  // Packet is TCP (not UDP)
+#define TUCMD_IP (1 << 1)   // Packet is IPv4 (not IPv6)
+#define TUCMD_TSE (1 << 2)  // TCP Segmentation Enable
+#define TUCMD_DEXT (1 << 5) // Descriptor Extension
+#define DCMD_EOP (1 << 0)   // End of Packet
+#define DCMD_IFCS (1 << 1)  // Insert FCS
+#define DCMD_TSE (1 << 2)   // TCP Segmentation Enable
+#define DCMD_RS (1 << 3)    // Report Status
+#define DCMD_DEXT (1 << 5)  // Descriptor Extension
+#define POPTS_IXSM (1 << 0) // Insert IP Checksum
+#define POPTS_TXSM (1 << 1) // Insert TCP/UDP Checksum
+
 // TCTL Register
 
 #define TCTL_EN (1 << 1)      // Transmit Enable
@@ -158,6 +177,7 @@ E1000NetworkAdapter::E1000NetworkAdapter(PCI::Address address, u8 irq)
     , m_io_base(PCI::get_BAR1(pci_address()) & ~1)
     , m_rx_descriptors_region(MM.allocate_contiguous_kernel_region(PAGE_ROUND_UP(sizeof(e1000_rx_desc) * number_of_rx_descriptors + 16), "E1000 RX", Region::Access::Read | Region::Access::Write))
     , m_tx_descriptors_region(MM.allocate_contiguous_kernel_region(PAGE_ROUND_UP(sizeof(e1000_tx_desc) * number_of_tx_descriptors + 16), "E1000 TX", Region::Access::Read | Region::Access::Write))
+    , m_rx_buffers_region(MM.allocate_contiguous_kernel_region(PAGE_ROUND_UP(rx_buffer_size * number_of_rx_descriptors), "E1000 RX buffers", Region::Access::Read | Region::Access::Write))
 {
     set_interface_name("e1k");
 
@@ -177,6 +197,7 @@ E1000NetworkAdapter::E1000NetworkAdapter(PCI::Address address, u8 irq)
     detect_eeprom();
     klog() << "E1000: Has EEPROM? " << m_has_eeprom;
     read_mac_address();
+    set_offloads(TCPChecksumOffload | TCPSegmentationOffload);
     const auto& mac = mac_address();
     klog() << "E1000: MAC address: " << String::format("%b", mac[0]) << ":" << String::format("%b", mac[1]) << ":" << String::format("%b", mac[2]) << ":" << String::format("%b", mac[3]) << ":" << String::format("%b", mac[4]) << ":" << String::format("%b", mac[5]);
 
@@ -189,7 +210,7 @@ E1000NetworkAdapter::E1000NetworkAdapter(PCI::Address address, u8 irq)
     initialize_tx_descriptors();
 
     out32(REG_INTERRUPT_MASK_SET, 0x1f6dc);
-    out32(REG_INTERRUPT_MASK_SET, INTERRUPT_LSC | INTERRUPT_RXT0);
+    out32(REG_INTERRUPT_MASK_SET, INTERRUPT_LSC | INTERRUPT_RXT0 | INTERRUPT_RXO);
     in32(REG_INTERRUPT_CAUSE_READ);
 
     enable_irq();
@@ -204,12 +225,16 @@ void E1000NetworkAdapter::handle_irq(const RegisterState&)
     out32(REG_INTERRUPT_MASK_CLEAR, 0xffffffff);
 
     u32 status = in32(REG_INTERRUPT_CAUSE_READ);
-    if (status & 4) {
+    if (status & INTERRUPT_LSC) {
         u32 flags = in32(REG_CTRL);
         out32(REG_CTRL, flags | ECTRL_SLU);
     }
-    if (status & 0x80) {
-        receive();
+    if (status & INTERRUPT_RXO)
+        did_overrun();
+    if (status & (INTERRUPT_RXT0 | INTERRUPT_RXO)) {
+        // Leave the receive interrupts masked; the NetworkTask drains the ring and
+        // turns them back on once it's empty.
+        schedule_receive_poll();
     }
     if (status & 0x10) {
         // Threshold OK?
@@ -217,7 +242,10 @@ void E1000NetworkAdapter::handle_irq(const RegisterState&)
 
     m_wait_queue.wake_all();
 
-    out32(REG_INTERRUPT_MASK_SET, INTERRUPT_LSC | INTERRUPT_RXT0 | INTERRUPT_RXO);
+    u32 interrupt_mask = INTERRUPT_LSC;
+    if (!receive_poll_pending())
+        interrupt_mask |= INTERRUPT_RXT0 | INTERRUPT_RXO;
+    out32(REG_INTERRUPT_MASK_SET, interrupt_mask);
 }
 
 void E1000NetworkAdapter::detect_eeprom()
@@ -277,12 +305,10 @@ bool E1000NetworkAdapter::link_up()
 void E1000NetworkAdapter::initialize_rx_descriptors()
 {
     auto* rx_descriptors = (e1000_tx_desc*)m_rx_descriptors_region->vaddr().as_ptr();
+    ASSERT(m_rx_buffers_region);
     for (size_t i = 0; i < number_of_rx_descriptors; ++i) {
         auto& descriptor = rx_descriptors[i];
-        auto region = MM.allocate_contiguous_kernel_region(8192, "E1000 RX buffer", Region::Access::Read | Region::Access::Write);
-        ASSERT(region);
-        m_rx_buffers_regions.append(region.release_nonnull());
-        descriptor.addr = m_rx_buffers_regions[i].physical_page(0)->paddr().get();
+        descriptor.addr = m_rx_buffers_region->physical_page(0)->paddr().offset(i * rx_buffer_size).get();
         descriptor.status = 0;
     }
 
@@ -292,7 +318,7 @@ void E1000NetworkAdapter::initialize_rx_descriptors()
     out32(REG_RXDESCHEAD, 0);
     out32(REG_RXDESCTAIL, number_of_rx_descriptors - 1);
 
-    out32(REG_RCTRL, RCTL_EN | RCTL_SBP | RCTL_UPE | RCTL_MPE | RCTL_LBM_NONE | RTCL_RDMTS_HALF | RCTL_BAM | RCTL_SECRC | RCTL_BSIZE_8192);
+    out32(REG_RCTRL, RCTL_EN | RCTL_SBP | RCTL_UPE | RCTL_MPE | RCTL_LBM_NONE | RTCL_RDMTS_HALF | RCTL_BAM | RCTL_SECRC | RCTL_BSIZE_2048);
 }
 
 void E1000NetworkAdapter::initialize_tx_descriptors()
@@ -395,9 +421,11 @@ void E1000NetworkAdapter::send_raw(const u8* data, size_t length)
 #endif
     auto* tx_descriptors = (e1000_tx_desc*)m_tx_descriptors_region->vaddr().as_ptr();
     auto& descriptor = tx_descriptors[tx_current];
-    ASSERT(length <= 8192);
+    ASSERT(length <= tx_buffer_size);
     auto* vptr = (void*)m_tx_buffers_regions[tx_current].vaddr().as_ptr();
     memcpy(vptr, data, length);
+    // A context descriptor may have used this slot last, so put the buffer address back.
+    descriptor.addr = m_tx_buffers_regions[tx_current].physical_page(0)->paddr().get();
     descriptor.length = length;
     descriptor.status = 0;
     descriptor.cmd = CMD_EOP | CMD_IFCS | CMD_RS;
@@ -405,42 +433,116 @@ void E1000NetworkAdapter::send_raw(const u8* data, size_t length)
     klog() << "E1000: Using tx descriptor " << tx_current << " (head is at " << in32(REG_TXDESCHEAD) << ")";
 #endif
     tx_current = (tx_current + 1) % number_of_tx_descriptors;
+    wait_for_transmit(tx_current, descriptor.status);
+}
+
+void E1000NetworkAdapter::send_raw_with_offload(const u8* data, size_t length, const TransmitOffload& offload)
+{
+    constexpr size_t ipv4_header_offset = sizeof(EthernetFrameHeader);
+    constexpr size_t tcp_header_offset = ipv4_header_offset + sizeof(IPv4Packet);
+    ASSERT(length >= tcp_header_offset + sizeof(TCPPacket));
+    auto& tcp_packet = *(const TCPPacket*)(data + tcp_header_offset);
+    size_t header_length = tcp_header_offset + tcp_packet.header_size();
+    bool segment = offload.tcp_segment_size != 0;
+    // One context descriptor, and then as many data descriptors as it takes to hold the frame.
+    ASSERT(1 + (length + tx_buffer_size - 1) / tx_buffer_size < number_of_tx_descriptors);
+
+    disable_irq();
+    size_t tx_current = in32(REG_TXDESCTAIL) % number_of_tx_descriptors;
+#ifdef E1000_DEBUG
+    klog() << "E1000: Sending offloaded packet (" << length << " bytes, segment size " << offload.tcp_segment_size << ")";
+#endif
+    auto* tx_descriptors = (e1000_tx_desc*)m_tx_descriptors_region->vaddr().as_ptr();
+
+    auto& context = *(e1000_tx_context_desc*)&tx_descriptors[tx_current];
+    context.ipcss = ipv4_header_offset;
+    context.ipcso = ipv4_header_offset + 10;
+    context.ipcse = tcp_header_offset - 1;
+    context.tucss = tcp_header_offset;
+    context.tucso = tcp_header_offset + 16;
+    context.tucse = 0;
+    u32 tucmd = TUCMD_DEXT | TUCMD_IP | TUCMD_TCP;
+    if (segment)
+        tucmd |= TUCMD_TSE;
+    u32 payload_length = segment ? length - header_length : 0;
+    context.paylen_dtyp_tucmd = (payload_length & 0xfffff) | (DTYP_CONTEXT << 20) | (tucmd << 24);
+    context.status = 0;
+    context.hdrlen = segment ? header_length : 0;
+    context.mss = offload.tcp_segment_size;
+    tx_current = (tx_current + 1) % number_of_tx_descriptors;
+
+    e1000_tx_data_desc* last_descriptor = nullptr;
+    for (size_t offset = 0; offset < length;) {
+        size_t chunk_size = min(length - offset, tx_buffer_size);
+        memcpy(m_tx_buffers_regions[tx_current].vaddr().as_ptr(), data + offset, chunk_size);
+        offset += chunk_size;
+
+        auto& descriptor = *(e1000_tx_data_desc*)&tx_descriptors[tx_current];
+        descriptor.addr = m_tx_buffers_regions[tx_current].physical_page(0)->paddr().get();
+        u32 dcmd = DCMD_DEXT | DCMD_IFCS;
+        if (segment)
+            dcmd |= DCMD_TSE;
+        if (offset == length)
+            dcmd |= DCMD_EOP | DCMD_RS;
+        descriptor.length_dtyp_dcmd = chunk_size | (DTYP_DATA << 20) | (dcmd << 24);
+        descriptor.status = 0;
+        descriptor.popts = segment ? (POPTS_TXSM | POPTS_IXSM) : POPTS_TXSM;
+        descriptor.special = 0;
+        last_descriptor = &descriptor;
+        tx_current = (tx_current + 1) % number_of_tx_descriptors;
+    }
+    ASSERT(last_descriptor);
+    wait_for_transmit(tx_current, last_descriptor->status);
+}
+
+void E1000NetworkAdapter::wait_for_transmit(size_t tx_tail, volatile uint8_t& status)
+{
     cli();
     enable_irq();
-    out32(REG_TXDESCTAIL, tx_current);
+    out32(REG_TXDESCTAIL, tx_tail);
     for (;;) {
-        if (descriptor.status) {
+        if (status) {
             sti();
             break;
         }
-        Thread::current->wait_on(m_wait_queue);
+        Thread::current()->wait_on(m_wait_queue);
     }
 #ifdef E1000_DEBUG
-    klog() << "E1000: Sent packet, status is now " << String::format("%b", descriptor.status) << "!";
+    klog() << "E1000: Sent packet, status is now " << String::format("%b", status) << "!";
 #endif
 }
 
-void E1000NetworkAdapter::receive()
+size_t E1000NetworkAdapter::receive_from_ring(size_t budget)
 {
+    if (u32 missed_packets = in32(REG_MISSED_PACKET_COUNT))
+        did_drop_packets(missed_packets);
+
     auto* rx_descriptors = (e1000_tx_desc*)m_rx_descriptors_region->vaddr().as_ptr();
-    u32 rx_current;
-    for (;;) {
-        rx_current = in32(REG_RXDESCTAIL) % number_of_rx_descriptors;
+    size_t received = 0;
+    while (received < budget) {
+        u32 rx_current = in32(REG_RXDESCTAIL) % number_of_rx_descriptors;
         if (rx_current == (in32(REG_RXDESCHEAD) % number_of_rx_descriptors))
-            return;
+            break;
         rx_current = (rx_current + 1) % number_of_rx_descriptors;
         if (!(rx_descriptors[rx_current].status & 1))
             break;
-        auto* buffer = m_rx_buffers_regions[rx_current].vaddr().as_ptr();
+        auto* buffer = m_rx_buffers_region->vaddr().offset(rx_current * rx_buffer_size).as_ptr();
         u16 length = rx_descriptors[rx_current].length;
-        ASSERT(length <= 8192);
+        ASSERT(length <= rx_buffer_size);
 #ifdef E1000_DEBUG
         klog() << "E1000: Received 1 packet @ " << buffer << " (" << length << ") bytes!";
 #endif
         did_receive(buffer, length);
         rx_descriptors[rx_current].status = 0;
         out32(REG_RXDESCTAIL, rx_current);
+        ++received;
     }
+    return received;
+}
+
+void E1000NetworkAdapter::enable_receive_interrupts()
+{
+    out32(REG_INTERRUPT_MASK_SET, INTERRUPT_RXT0 | INTERRUPT_RXO);
 }
 
 }
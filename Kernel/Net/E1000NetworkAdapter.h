@@ -45,6 +45,7 @@ public:
     virtual ~E1000NetworkAdapter() override;
 
     virtual void send_raw(const u8*, size_t) override;
+    virtual void send_raw_with_offload(const u8*, size_t, const TransmitOffload&) override;
     virtual bool link_up() override;
 
     virtual const char* purpose() const override { return class_name(); }
@@ -74,6 +75,31 @@ private:
         volatile uint16_t special { 0 };
     };
 
+    // The TCP/IP context descriptor that tells the adapter where the headers of the
+    // following data descriptors' packet are, for checksum and segmentation offload.
+    struct [[gnu::packed]] e1000_tx_context_desc
+    {
+        volatile uint8_t ipcss { 0 };
+        volatile uint8_t ipcso { 0 };
+        volatile uint16_t ipcse { 0 };
+        volatile uint8_t tucss { 0 };
+        volatile uint8_t tucso { 0 };
+        volatile uint16_t tucse { 0 };
+        volatile uint32_t paylen_dtyp_tucmd { 0 };
+        volatile uint8_t status { 0 };
+        volatile uint8_t hdrlen { 0 };
+        volatile uint16_t mss { 0 };
+    };
+
+    struct [[gnu::packed]] e1000_tx_data_desc
+    {
+        volatile uint64_t addr { 0 };
+        volatile uint32_t length_dtyp_dcmd { 0 };
+        volatile uint8_t status { 0 };
+        volatile uint8_t popts { 0 };
+        volatile uint16_t special { 0 };
+    };
+
     void detect_eeprom();
     u32 read_eeprom(u8 address);
     void read_mac_address();
@@ -91,21 +117,26 @@ private:
     u16 in16(u16 address);
     u32 in32(u16 address);
 
-    void receive();
+    void wait_for_transmit(size_t tx_tail, volatile uint8_t& status);
+
+    virtual size_t receive_from_ring(size_t budget) override;
+    virtual void enable_receive_interrupts() override;
 
     IOAddress m_io_base;
     VirtualAddress m_mmio_base;
     OwnPtr<Region> m_rx_descriptors_region;
     OwnPtr<Region> m_tx_descriptors_region;
-    NonnullOwnPtrVector<Region> m_rx_buffers_regions;
+    OwnPtr<Region> m_rx_buffers_region;
     NonnullOwnPtrVector<Region> m_tx_buffers_regions;
     OwnPtr<Region> m_mmio_region;
     u8 m_interrupt_line { 0 };
     bool m_has_eeprom { false };
     bool m_use_mmio { false };
 
-    static const size_t number_of_rx_descriptors = 32;
-    static const size_t number_of_tx_descriptors = 8;
+    static const size_t number_of_rx_descriptors = 256;
+    static const size_t number_of_tx_descriptors = 32;
+    static const size_t rx_buffer_size = 2048;
+    static const size_t tx_buffer_size = 8192;
 
     WaitQueue m_wait_queue;
 };
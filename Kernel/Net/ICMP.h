@@ -32,10 +32,17 @@
 struct ICMPType {
     enum {
         EchoReply = 0,
+        DestinationUnreachable = 3,
         EchoRequest = 8,
     };
 };
 
+struct ICMPDestinationUnreachableCode {
+    enum {
+        FragmentationNeeded = 4,
+    };
+};
+
 class [[gnu::packed]] ICMPHeader
 {
 public:
@@ -71,3 +78,13 @@ struct [[gnu::packed]] ICMPEchoPacket
     void* payload() { return this + 1; }
     const void* payload() const { return this + 1; }
 };
+
+// A "fragmentation needed" message carries the MTU of the next hop (RFC 1191, section 4)
+// and the start of the packet that didn't fit.
+struct [[gnu::packed]] ICMPFragmentationNeededPacket
+{
+    ICMPHeader header;
+    NetworkOrdered<u16> unused;
+    NetworkOrdered<u16> next_hop_mtu;
+    Kernel::IPv4Packet original_packet;
+};
@@ -0,0 +1,249 @@
+/*
+ * Copyright (c) 2018-2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/ByteBuffer.h>
+#include <AK/HashFunctions.h>
+#include <AK/HashMap.h>
+#include <AK/Optional.h>
+#include <AK/Vector.h>
+#include <Kernel/Lock.h>
+#include <Kernel/Net/IPv4.h>
+#include <Kernel/Net/IPv4Reassembly.h>
+#include <Kernel/Net/NetworkStatistics.h>
+#include <Kernel/Net/PacketBuffer.h>
+#include <Kernel/Process.h>
+
+//#define IPV4_REASSEMBLY_DEBUG
+
+namespace Kernel {
+
+struct IPv4FragmentKey {
+    IPv4Address source;
+    IPv4Address destination;
+    u16 ident { 0 };
+    u8 protocol { 0 };
+
+    bool operator==(const IPv4FragmentKey& other) const
+    {
+        return source == other.source && destination == other.destination && ident == other.ident && protocol == other.protocol;
+    }
+};
+
+}
+
+namespace AK {
+
+template<>
+struct Traits<Kernel::IPv4FragmentKey> : public GenericTraits<Kernel::IPv4FragmentKey> {
+    static unsigned hash(const Kernel::IPv4FragmentKey& key)
+    {
+        auto h1 = pair_int_hash(key.source.to_u32(), key.destination.to_u32());
+        return pair_int_hash(h1, (key.ident << 8) | key.protocol);
+    }
+};
+
+}
+
+namespace Kernel {
+
+// RFC 1122 (section 3.3.2) asks for a timeout of a minute or two, but a packet that has
+// been missing a piece for this long isn't going to be completed.
+static constexpr time_t reassembly_timeout_seconds = 30;
+static constexpr size_t max_incomplete_packets = 64;
+static constexpr size_t max_buffered_fragment_bytes = 1 * MB;
+static constexpr size_t max_ipv4_payload_size = 0xffff - sizeof(IPv4Packet);
+
+struct IPv4Fragment {
+    size_t offset { 0 };
+    ByteBuffer data;
+};
+
+struct IPv4Reassembly {
+    // The header of the first fragment, which the whole packet inherits.
+    IPv4Packet header;
+    // Sorted by offset, and never overlapping.
+    Vector<IPv4Fragment> fragments;
+    size_t received_bytes { 0 };
+    // Known once the last fragment has arrived.
+    size_t total_size { 0 };
+    time_t expires { 0 };
+};
+
+struct ReassemblyQueue {
+    HashMap<IPv4FragmentKey, IPv4Reassembly> packets;
+    size_t buffered_bytes { 0 };
+};
+
+static Lockable<ReassemblyQueue>& reassembly_queue()
+{
+    static Lockable<ReassemblyQueue>* the;
+    if (!the)
+        the = new Lockable<ReassemblyQueue>;
+    return *the;
+}
+
+static void give_up(ReassemblyQueue& queue, const IPv4FragmentKey& key)
+{
+    auto it = queue.packets.find(key);
+    if (it == queue.packets.end())
+        return;
+#ifdef IPV4_REASSEMBLY_DEBUG
+    klog() << "IPv4Reassembly: Giving up on packet " << key.ident << " from " << key.source.to_string().characters() << " (" << it->value.received_bytes << " bytes received)";
+#endif
+    queue.buffered_bytes -= it->value.received_bytes;
+    queue.packets.remove(it);
+    network_statistics().ipv4.reassembly_failures++;
+}
+
+// Makes room for another fragment of the given packet by throwing away the incomplete
+// packets that are closest to timing out anyway.
+static void make_room(ReassemblyQueue& queue, const IPv4FragmentKey& key, size_t size)
+{
+    for (;;) {
+        bool needs_slot = !queue.packets.contains(key) && queue.packets.size() >= max_incomplete_packets;
+        if (!needs_slot && queue.buffered_bytes + size <= max_buffered_fragment_bytes)
+            return;
+
+        Optional<IPv4FragmentKey> oldest;
+        time_t oldest_expires = 0;
+        for (auto& it : queue.packets) {
+            if (it.key == key)
+                continue;
+            if (!oldest.has_value() || it.value.expires < oldest_expires) {
+                oldest = it.key;
+                oldest_expires = it.value.expires;
+            }
+        }
+        // A single packet always fits, so there's something else to throw away.
+        ASSERT(oldest.has_value());
+        give_up(queue, oldest.value());
+    }
+}
+
+RefPtr<PacketBuffer> reassemble_ipv4_fragment(const PacketBuffer& buffer)
+{
+    auto& packet = *(const IPv4Packet*)buffer.data();
+    auto& statistics = network_statistics().ipv4;
+    statistics.reassembly_required++;
+
+    size_t offset = packet.fragment_offset() * 8;
+    size_t size = packet.payload_size();
+    size_t end = offset + size;
+    // Every fragment but the last one carries a multiple of 8 bytes (RFC 791).
+    if (end > max_ipv4_payload_size || (packet.has_more_fragments() && (!size || size % 8))) {
+        statistics.reassembly_failures++;
+        return nullptr;
+    }
+
+    IPv4FragmentKey key { packet.source(), packet.destination(), packet.ident(), (u8)packet.protocol() };
+
+    LOCKER(reassembly_queue().lock());
+    auto& queue = reassembly_queue().resource();
+    make_room(queue, key, size);
+    if (!queue.packets.contains(key)) {
+        IPv4Reassembly reassembly;
+        reassembly.expires = kgettimeofday().tv_sec + reassembly_timeout_seconds;
+        queue.packets.set(key, move(reassembly));
+    }
+    auto& reassembly = queue.packets.find(key)->value;
+    auto& fragments = reassembly.fragments;
+
+    if (!packet.has_more_fragments()) {
+        bool data_beyond_end = !fragments.is_empty() && fragments.last().offset + fragments.last().data.size() > end;
+        if ((reassembly.total_size && reassembly.total_size != end) || data_beyond_end) {
+            give_up(queue, key);
+            return nullptr;
+        }
+        reassembly.total_size = end;
+    } else if (reassembly.total_size && end > reassembly.total_size) {
+        give_up(queue, key);
+        return nullptr;
+    }
+
+    size_t index = 0;
+    while (index < fragments.size() && fragments[index].offset < offset)
+        ++index;
+    if (index < fragments.size() && fragments[index].offset == offset && fragments[index].data.size() == size) {
+        // A duplicate, which we already have.
+        return nullptr;
+    }
+    // Overlapping fragments are never sent by a well-behaved host, and have been used to
+    // sneak things past firewalls, so we don't try to make sense of them.
+    bool overlaps_previous = index > 0 && fragments[index - 1].offset + fragments[index - 1].data.size() > offset;
+    bool overlaps_next = index < fragments.size() && end > fragments[index].offset;
+    if (overlaps_previous || overlaps_next) {
+        give_up(queue, key);
+        return nullptr;
+    }
+
+    if (!offset)
+        reassembly.header = packet;
+    fragments.insert(index, { offset, ByteBuffer::copy(packet.payload(), size) });
+    reassembly.received_bytes += size;
+    queue.buffered_bytes += size;
+
+    if (!reassembly.total_size || reassembly.received_bytes != reassembly.total_size)
+        return nullptr;
+
+    // Nothing overlaps, so having every byte up to the end means having the first fragment too.
+    auto whole_packet = PacketBuffer::create_with_size(sizeof(IPv4Packet) + reassembly.total_size);
+    auto& header = *(IPv4Packet*)whole_packet->data();
+    header = reassembly.header;
+    header.set_length(sizeof(IPv4Packet) + reassembly.total_size);
+    header.set_has_more_fragments(false);
+    header.set_fragment_offset(0);
+    header.set_checksum(0);
+    header.set_checksum(header.compute_checksum());
+    for (auto& fragment : fragments)
+        memcpy((u8*)header.payload() + fragment.offset, fragment.data.data(), fragment.data.size());
+
+#ifdef IPV4_REASSEMBLY_DEBUG
+    klog() << "IPv4Reassembly: Reassembled packet " << key.ident << " from " << key.source.to_string().characters() << " out of " << fragments.size() << " fragments (" << reassembly.total_size << " bytes)";
+#endif
+    queue.buffered_bytes -= reassembly.received_bytes;
+    queue.packets.remove(key);
+    statistics.reassembled++;
+    return whole_packet;
+}
+
+void expire_ipv4_fragments()
+{
+    LOCKER(reassembly_queue().lock());
+    auto& queue = reassembly_queue().resource();
+    if (queue.packets.is_empty())
+        return;
+
+    auto now = kgettimeofday().tv_sec;
+    Vector<IPv4FragmentKey> expired;
+    for (auto& it : queue.packets) {
+        if (now >= it.value.expires)
+            expired.append(it.key);
+    }
+    for (auto& key : expired)
+        give_up(queue, key);
+}
+
+}
@@ -71,9 +71,6 @@ IPv4Socket::IPv4Socket(int type, int protocol)
     dbg() << "IPv4Socket{" << this << "} created with type=" << type << ", protocol=" << protocol;
 #endif
     m_buffer_mode = type == SOCK_STREAM ? BufferMode::Bytes : BufferMode::Packets;
-    if (m_buffer_mode == BufferMode::Bytes) {
-        m_scratch_buffer = KBuffer::create_with_size(65536);
-    }
     LOCKER(all_sockets().lock());
     all_sockets().resource().set(this);
 }
@@ -111,9 +108,9 @@ KResult IPv4Socket::bind(const sockaddr* user_address, socklen_t address_size)
         return KResult(-EINVAL);
 
     auto requested_local_port = ntohs(address.sin_port);
-    if (!Process::current->is_superuser()) {
+    if (!Process::current()->is_superuser()) {
         if (requested_local_port < 1024) {
-            dbg() << "UID " << Process::current->uid() << " attempted to bind " << class_name() << " to port " << requested_local_port;
+            dbg() << "UID " << Process::current()->uid() << " attempted to bind " << class_name() << " to port " << requested_local_port;
             return KResult(-EACCES);
         }
     }
@@ -232,7 +229,7 @@ ssize_t IPv4Socket::sendto(FileDescription&, const void* data, size_t data_lengt
 
     int nsent = protocol_send(data, data_length);
     if (nsent > 0)
-        Thread::current->did_ipv4_socket_write(nsent);
+        Thread::current()->did_ipv4_socket_write(nsent);
     return nsent;
 }
 
@@ -246,7 +243,7 @@ ssize_t IPv4Socket::receive_byte_buffered(FileDescription& description, void* bu
             return -EAGAIN;
 
         locker.unlock();
-        auto res = Thread::current->block<Thread::ReadBlocker>(description);
+        auto res = Thread::current()->block<Thread::ReadBlocker>(description);
         locker.lock();
 
         if (!m_can_read) {
@@ -259,11 +256,23 @@ ssize_t IPv4Socket::receive_byte_buffered(FileDescription& description, void* bu
     }
 
     ASSERT(!m_receive_buffer.is_empty());
-    int nreceived = m_receive_buffer.read((u8*)buffer, buffer_length);
+    size_t nreceived = 0;
+    while (nreceived < buffer_length && !m_receive_buffer.is_empty()) {
+        auto& packet = *m_receive_buffer.first();
+        size_t chunk_size = min(packet.size(), buffer_length - nreceived);
+        memcpy((u8*)buffer + nreceived, packet.data(), chunk_size);
+        packet.pull(chunk_size);
+        nreceived += chunk_size;
+        if (packet.size() == 0)
+            m_receive_buffer.take_first();
+    }
+    m_receive_buffer_size -= nreceived;
     if (nreceived > 0)
-        Thread::current->did_ipv4_socket_read((size_t)nreceived);
+        Thread::current()->did_ipv4_socket_read(nreceived);
 
     m_can_read = !m_receive_buffer.is_empty();
+    if (nreceived > 0)
+        protocol_did_drain_receive_buffer();
     return nreceived;
 }
 
@@ -285,18 +294,18 @@ ssize_t IPv4Socket::receive_packet_buffered(FileDescription& description, void*
             packet = m_receive_queue.take_first();
             m_can_read = !m_receive_queue.is_empty();
 #ifdef IPV4_SOCKET_DEBUG
-            dbg() << "IPv4Socket(" << this << "): recvfrom without blocking " << packet.data.value().size() << " bytes, packets in queue: " << m_receive_queue.size_slow();
+            dbg() << "IPv4Socket(" << this << "): recvfrom without blocking " << packet.data->size() << " bytes, packets in queue: " << m_receive_queue.size_slow();
 #endif
         }
     }
-    if (!packet.data.has_value()) {
+    if (!packet.data) {
         if (protocol_is_disconnected()) {
             dbg() << "IPv4Socket{" << this << "} is protocol-disconnected, returning 0 in recvfrom!";
             return 0;
         }
 
         locker.unlock();
-        auto res = Thread::current->block<Thread::ReadBlocker>(description);
+        auto res = Thread::current()->block<Thread::ReadBlocker>(description);
         locker.lock();
 
         if (!m_can_read) {
@@ -311,11 +320,11 @@ ssize_t IPv4Socket::receive_packet_buffered(FileDescription& description, void*
         packet = m_receive_queue.take_first();
         m_can_read = !m_receive_queue.is_empty();
 #ifdef IPV4_SOCKET_DEBUG
-        dbg() << "IPv4Socket(" << this << "): recvfrom with blocking " << packet.data.value().size() << " bytes, packets in queue: " << m_receive_queue.size_slow();
+        dbg() << "IPv4Socket(" << this << "): recvfrom with blocking " << packet.data->size() << " bytes, packets in queue: " << m_receive_queue.size_slow();
 #endif
     }
-    ASSERT(packet.data.has_value());
-    auto& ipv4_packet = *(const IPv4Packet*)(packet.data.value().data());
+    ASSERT(packet.data);
+    auto& ipv4_packet = *(const IPv4Packet*)(packet.data->data());
 
     if (addr) {
 #ifdef IPV4_SOCKET_DEBUG
@@ -335,7 +344,7 @@ ssize_t IPv4Socket::receive_packet_buffered(FileDescription& description, void*
         return ipv4_packet.payload_size();
     }
 
-    return protocol_receive(packet.data.value(), buffer, buffer_length, flags);
+    return protocol_receive(*packet.data, buffer, buffer_length, flags);
 }
 
 ssize_t IPv4Socket::recvfrom(FileDescription& description, void* buffer, size_t buffer_length, int flags, sockaddr* addr, socklen_t* addr_length)
@@ -354,28 +363,38 @@ ssize_t IPv4Socket::recvfrom(FileDescription& description, void* buffer, size_t
         nreceived = receive_packet_buffered(description, buffer, buffer_length, flags, addr, addr_length);
 
     if (nreceived > 0)
-        Thread::current->did_ipv4_socket_read(nreceived);
+        Thread::current()->did_ipv4_socket_read(nreceived);
     return nreceived;
 }
 
-bool IPv4Socket::did_receive(const IPv4Address& source_address, u16 source_port, KBuffer&& packet)
+bool IPv4Socket::did_receive(const IPv4Address& source_address, u16 source_port, NonnullRefPtr<PacketBuffer> packet)
 {
     LOCKER(lock());
 
     if (is_shut_down_for_reading())
         return false;
 
-    auto packet_size = packet.size();
+    auto packet_size = packet->size();
 
     if (buffer_mode() == BufferMode::Bytes) {
-        size_t space_in_receive_buffer = m_receive_buffer.space_for_writing();
-        if (packet_size > space_in_receive_buffer) {
+        size_t payload_offset = protocol_payload_offset(*packet);
+        ASSERT(payload_offset <= packet_size);
+        size_t payload_size = packet_size - payload_offset;
+        if (payload_size > receive_buffer_space()) {
             dbg() << "IPv4Socket(" << this << "): did_receive refusing packet since buffer is full.";
             ASSERT(m_can_read);
             return false;
         }
-        int nreceived = protocol_receive(packet, m_scratch_buffer.value().data(), m_scratch_buffer.value().size(), 0);
-        m_receive_buffer.write(m_scratch_buffer.value().data(), nreceived);
+        // Small payloads are copied onto the end of the previous packet instead of pinning a
+        // whole packet buffer each, so a peer trickling in tiny segments can't eat up memory.
+        static constexpr size_t coalesce_threshold = 256;
+        if (payload_size <= coalesce_threshold && !m_receive_buffer.is_empty() && m_receive_buffer.last()->tailroom() >= payload_size) {
+            m_receive_buffer.last()->append(packet->data() + payload_offset, payload_size);
+        } else {
+            packet->pull(payload_offset);
+            m_receive_buffer.append(move(packet));
+        }
+        m_receive_buffer_size += payload_size;
         m_can_read = !m_receive_buffer.is_empty();
     } else {
         // FIXME: Maybe track the number of packets so we don't have to walk the entire packet queue to count them..
@@ -387,6 +406,7 @@ bool IPv4Socket::did_receive(const IPv4Address& source_address, u16 source_port,
         m_can_read = true;
     }
     m_bytes_received += packet_size;
+    evaluate_block_conditions();
 #ifdef IPV4_SOCKET_DEBUG
     if (buffer_mode() == BufferMode::Bytes)
         dbg() << "IPv4Socket(" << this << "): did_receive " << packet_size << " bytes, total_received=" << m_bytes_received;
@@ -468,7 +488,7 @@ int IPv4Socket::ioctl(FileDescription&, unsigned request, FlatPtr arg)
 
     auto ioctl_route = [request, arg]() {
         auto* route = (rtentry*)arg;
-        if (!Process::current->validate_read_typed(route))
+        if (!Process::current()->validate_read_typed(route))
             return -EFAULT;
 
         char namebuf[IFNAMSIZ + 1];
@@ -481,7 +501,7 @@ int IPv4Socket::ioctl(FileDescription&, unsigned request, FlatPtr arg)
 
         switch (request) {
         case SIOCADDRT:
-            if (!Process::current->is_superuser())
+            if (!Process::current()->is_superuser())
                 return -EPERM;
             if (route->rt_gateway.sa_family != AF_INET)
                 return -EAFNOSUPPORT;
@@ -500,7 +520,7 @@ int IPv4Socket::ioctl(FileDescription&, unsigned request, FlatPtr arg)
 
     auto ioctl_interface = [request, arg]() {
         auto* ifr = (ifreq*)arg;
-        if (!Process::current->validate_read_typed(ifr))
+        if (!Process::current()->validate_read_typed(ifr))
             return -EFAULT;
 
         char namebuf[IFNAMSIZ + 1];
@@ -513,7 +533,7 @@ int IPv4Socket::ioctl(FileDescription&, unsigned request, FlatPtr arg)
 
         switch (request) {
         case SIOCSIFADDR:
-            if (!Process::current->is_superuser())
+            if (!Process::current()->is_superuser())
                 return -EPERM;
             if (ifr->ifr_addr.sa_family != AF_INET)
                 return -EAFNOSUPPORT;
@@ -521,7 +541,7 @@ int IPv4Socket::ioctl(FileDescription&, unsigned request, FlatPtr arg)
             return 0;
 
         case SIOCSIFNETMASK:
-            if (!Process::current->is_superuser())
+            if (!Process::current()->is_superuser())
                 return -EPERM;
             if (ifr->ifr_addr.sa_family != AF_INET)
                 return -EAFNOSUPPORT;
@@ -529,14 +549,14 @@ int IPv4Socket::ioctl(FileDescription&, unsigned request, FlatPtr arg)
             return 0;
 
         case SIOCGIFADDR:
-            if (!Process::current->validate_write_typed(ifr))
+            if (!Process::current()->validate_write_typed(ifr))
                 return -EFAULT;
             ifr->ifr_addr.sa_family = AF_INET;
             ((sockaddr_in&)ifr->ifr_addr).sin_addr.s_addr = adapter->ipv4_address().to_u32();
             return 0;
 
         case SIOCGIFHWADDR:
-            if (!Process::current->validate_write_typed(ifr))
+            if (!Process::current()->validate_write_typed(ifr))
                 return -EFAULT;
             ifr->ifr_hwaddr.sa_family = AF_INET;
             {
@@ -573,6 +593,7 @@ void IPv4Socket::shut_down_for_reading()
 {
     Socket::shut_down_for_reading();
     m_can_read = true;
+    evaluate_block_conditions();
 }
 
 }
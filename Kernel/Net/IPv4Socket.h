@@ -28,11 +28,10 @@
 
 #include <AK/HashMap.h>
 #include <AK/SinglyLinkedList.h>
-#include <Kernel/DoubleBuffer.h>
-#include <Kernel/KBuffer.h>
 #include <Kernel/Lock.h>
 #include <Kernel/Net/IPv4.h>
 #include <Kernel/Net/IPv4SocketTuple.h>
+#include <Kernel/Net/PacketBuffer.h>
 #include <Kernel/Net/Socket.h>
 
 namespace Kernel {
@@ -65,7 +64,7 @@ public:
 
     virtual int ioctl(FileDescription&, unsigned request, FlatPtr arg) override;
 
-    bool did_receive(const IPv4Address& peer_address, u16 peer_port, KBuffer&&);
+    bool did_receive(const IPv4Address& peer_address, u16 peer_port, NonnullRefPtr<PacketBuffer>);
 
     const IPv4Address& local_address() const { return m_local_address; }
     u16 local_port() const { return m_local_port; }
@@ -96,14 +95,19 @@ protected:
 
     virtual KResult protocol_bind() { return KSuccess; }
     virtual KResult protocol_listen() { return KSuccess; }
-    virtual int protocol_receive(const KBuffer&, void*, size_t, int) { return -ENOTIMPL; }
+    virtual int protocol_receive(const PacketBuffer&, void*, size_t, int) { return -ENOTIMPL; }
+    // Byte-buffered sockets queue the received packets themselves, starting at this offset.
+    virtual size_t protocol_payload_offset(const PacketBuffer&) const { return 0; }
     virtual int protocol_send(const void*, size_t) { return -ENOTIMPL; }
     virtual KResult protocol_connect(FileDescription&, ShouldBlock) { return KSuccess; }
     virtual int protocol_allocate_local_port() { return 0; }
     virtual bool protocol_is_disconnected() const { return false; }
+    virtual void protocol_did_drain_receive_buffer() { }
 
     virtual void shut_down_for_reading() override;
 
+    size_t receive_buffer_space() const { return receive_buffer_capacity - m_receive_buffer_size; }
+
     void set_local_address(IPv4Address address) { m_local_address = address; }
     void set_peer_address(IPv4Address address) { m_peer_address = address; }
 
@@ -119,12 +123,16 @@ private:
     struct ReceivedPacket {
         IPv4Address peer_address;
         u16 peer_port;
-        Optional<KBuffer> data;
+        RefPtr<PacketBuffer> data;
     };
 
     SinglyLinkedList<ReceivedPacket> m_receive_queue;
 
-    DoubleBuffer m_receive_buffer;
+    static constexpr size_t receive_buffer_capacity = 64 * KB;
+
+    // In byte-buffered mode, the payloads that haven't been read yet, in order.
+    SinglyLinkedList<NonnullRefPtr<PacketBuffer>> m_receive_buffer;
+    size_t m_receive_buffer_size { 0 };
 
     u16 m_local_port { 0 };
     u16 m_peer_port { 0 };
@@ -136,8 +144,6 @@ private:
     bool m_can_read { false };
 
     BufferMode m_buffer_mode { BufferMode::Packets };
-
-    Optional<KBuffer> m_scratch_buffer;
 };
 
 }
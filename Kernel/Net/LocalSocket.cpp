@@ -63,8 +63,8 @@ LocalSocket::LocalSocket(int type)
     LOCKER(all_sockets().lock());
     all_sockets().resource().append(this);
 
-    m_prebind_uid = Process::current->uid();
-    m_prebind_gid = Process::current->gid();
+    m_prebind_uid = Process::current()->uid();
+    m_prebind_gid = Process::current()->gid();
     m_prebind_mode = 0666;
 
 #ifdef DEBUG_LOCAL_SOCKET
@@ -110,7 +110,7 @@ KResult LocalSocket::bind(const sockaddr* user_address, socklen_t address_size)
 
     mode_t mode = S_IFSOCK | (m_prebind_mode & 04777);
     UidAndGid owner { m_prebind_uid, m_prebind_gid };
-    auto result = VFS::the().open(path, O_CREAT | O_EXCL | O_NOFOLLOW_NOERROR, mode, Process::current->current_directory(), owner);
+    auto result = VFS::the().open(path, O_CREAT | O_EXCL | O_NOFOLLOW_NOERROR, mode, Process::current()->current_directory(), owner);
     if (result.is_error()) {
         if (result.error() == -EEXIST)
             return KResult(-EADDRINUSE);
@@ -148,7 +148,7 @@ KResult LocalSocket::connect(FileDescription& description, const sockaddr* addre
     dbg() << "LocalSocket{" << this << "} connect(" << safe_address << ")";
 #endif
 
-    auto description_or_error = VFS::the().open(safe_address, O_RDWR, 0, Process::current->current_directory());
+    auto description_or_error = VFS::the().open(safe_address, O_RDWR, 0, Process::current()->current_directory());
     if (description_or_error.is_error())
         return KResult(-ECONNREFUSED);
 
@@ -175,7 +175,7 @@ KResult LocalSocket::connect(FileDescription& description, const sockaddr* addre
         return KSuccess;
     }
 
-    if (Thread::current->block<Thread::ConnectBlocker>(description) != Thread::BlockResult::WokeNormally) {
+    if (Thread::current()->block<Thread::ConnectBlocker>(description) != Thread::BlockResult::WokeNormally) {
         m_connect_side_role = Role::None;
         return KResult(-EINTR);
     }
@@ -215,6 +215,7 @@ void LocalSocket::attach(FileDescription& description)
         ASSERT(m_connect_side_fd != &description);
         m_accept_side_fd_open = true;
     }
+    evaluate_block_conditions();
 }
 
 void LocalSocket::detach(FileDescription& description)
@@ -225,6 +226,7 @@ void LocalSocket::detach(FileDescription& description)
         ASSERT(m_accept_side_fd_open);
         m_accept_side_fd_open = false;
     }
+    evaluate_block_conditions();
 }
 
 bool LocalSocket::can_read(const FileDescription& description, size_t) const
@@ -264,8 +266,10 @@ ssize_t LocalSocket::sendto(FileDescription& description, const void* data, size
     if (!has_attached_peer(description))
         return -EPIPE;
     ssize_t nwritten = send_buffer_for(description).write((const u8*)data, data_size);
-    if (nwritten > 0)
-        Thread::current->did_unix_socket_write(nwritten);
+    if (nwritten > 0) {
+        Thread::current()->did_unix_socket_write(nwritten);
+        evaluate_block_conditions();
+    }
     return nwritten;
 }
 
@@ -299,7 +303,7 @@ ssize_t LocalSocket::recvfrom(FileDescription& description, void* buffer, size_t
             return -EAGAIN;
         }
     } else if (!can_read(description, 0)) {
-        auto result = Thread::current->block<Thread::ReadBlocker>(description);
+        auto result = Thread::current()->block<Thread::ReadBlocker>(description);
         if (result != Thread::BlockResult::WokeNormally)
             return -EINTR;
     }
@@ -307,11 +311,76 @@ ssize_t LocalSocket::recvfrom(FileDescription& description, void* buffer, size_t
         return 0;
     ASSERT(!buffer_for_me.is_empty());
     int nread = buffer_for_me.read((u8*)buffer, buffer_size);
-    if (nread > 0)
-        Thread::current->did_unix_socket_read(nread);
+    if (nread > 0) {
+        Thread::current()->did_unix_socket_read(nread);
+        evaluate_block_conditions();
+    }
     return nread;
 }
 
+NonnullRefPtrVector<FileDescription>& LocalSocket::receive_fd_queue_for(FileDescription& description)
+{
+    auto role = this->role(description);
+    if (role == Role::Accepted)
+        return m_fds_for_server;
+    if (role == Role::Connected)
+        return m_fds_for_client;
+    ASSERT_NOT_REACHED();
+}
+
+NonnullRefPtrVector<FileDescription>& LocalSocket::send_fd_queue_for(FileDescription& description)
+{
+    auto role = this->role(description);
+    if (role == Role::Connected)
+        return m_fds_for_server;
+    if (role == Role::Accepted)
+        return m_fds_for_client;
+    ASSERT_NOT_REACHED();
+}
+
+KResult LocalSocket::sendfds(FileDescription& socket_description, const NonnullRefPtrVector<FileDescription>& descriptions)
+{
+    auto role = this->role(socket_description);
+    if (role != Role::Connected && role != Role::Accepted)
+        return KResult(-EINVAL);
+    if (!has_attached_peer(socket_description))
+        return KResult(-EPIPE);
+    LOCKER(m_fd_queue_lock);
+    auto& queue = send_fd_queue_for(socket_description);
+    // All of them or none, so the receiver never sees half a batch.
+    if (queue.size() + descriptions.size() > max_queued_fds)
+        return KResult(-EBUSY);
+    queue.append(descriptions);
+    return KSuccess;
+}
+
+KResult LocalSocket::recvfds(FileDescription& socket_description, NonnullRefPtrVector<FileDescription>& descriptions, size_t max_count)
+{
+    auto role = this->role(socket_description);
+    if (role != Role::Connected && role != Role::Accepted)
+        return KResult(-EINVAL);
+    LOCKER(m_fd_queue_lock);
+    auto& queue = receive_fd_queue_for(socket_description);
+    if (queue.is_empty())
+        return KResult(-EAGAIN);
+    size_t count = min(max_count, queue.size());
+    for (size_t i = 0; i < count; ++i)
+        descriptions.append(queue.take_first());
+    return KSuccess;
+}
+
+size_t LocalSocket::fds_queued_for_client() const
+{
+    LOCKER(m_fd_queue_lock, Lock::Mode::Shared);
+    return m_fds_for_client.size();
+}
+
+size_t LocalSocket::fds_queued_for_server() const
+{
+    LOCKER(m_fd_queue_lock, Lock::Mode::Shared);
+    return m_fds_for_server.size();
+}
+
 StringView LocalSocket::socket_path() const
 {
     size_t len = strnlen(m_address.sun_path, sizeof(m_address.sun_path));
@@ -389,7 +458,7 @@ KResult LocalSocket::chown(FileDescription&, uid_t uid, gid_t gid)
     if (m_file)
         return m_file->chown(uid, gid);
 
-    if (!Process::current->is_superuser() && (Process::current->euid() != uid || !Process::current->in_group(gid)))
+    if (!Process::current()->is_superuser() && (Process::current()->euid() != uid || !Process::current()->in_group(gid)))
         return KResult(-EPERM);
 
     m_prebind_uid = uid;
@@ -27,6 +27,7 @@
 #pragma once
 
 #include <AK/InlineLinkedList.h>
+#include <AK/NonnullRefPtrVector.h>
 #include <Kernel/DoubleBuffer.h>
 #include <Kernel/Net/Socket.h>
 
@@ -47,6 +48,16 @@ public:
     StringView socket_path() const;
     String absolute_path(const FileDescription& description) const override;
 
+    // File descriptions in flight to the peer, in the order they were sent.
+    static constexpr size_t max_queued_fds = 64;
+    KResult sendfds(FileDescription& socket_description, const NonnullRefPtrVector<FileDescription>&);
+    KResult recvfds(FileDescription& socket_description, NonnullRefPtrVector<FileDescription>&, size_t max_count);
+
+    size_t bytes_queued_for_client() const { return m_for_client.used_bytes(); }
+    size_t bytes_queued_for_server() const { return m_for_server.used_bytes(); }
+    size_t fds_queued_for_client() const;
+    size_t fds_queued_for_server() const;
+
     // ^Socket
     virtual KResult bind(const sockaddr*, socklen_t) override;
     virtual KResult connect(FileDescription&, const sockaddr*, socklen_t, ShouldBlock = ShouldBlock::Yes) override;
@@ -71,6 +82,8 @@ private:
     static Lockable<InlineLinkedList<LocalSocket>>& all_sockets();
     DoubleBuffer& receive_buffer_for(FileDescription&);
     DoubleBuffer& send_buffer_for(FileDescription&);
+    NonnullRefPtrVector<FileDescription>& receive_fd_queue_for(FileDescription&);
+    NonnullRefPtrVector<FileDescription>& send_fd_queue_for(FileDescription&);
 
     // An open socket file on the filesystem.
     RefPtr<FileDescription> m_file;
@@ -100,6 +113,10 @@ private:
     DoubleBuffer m_for_client;
     DoubleBuffer m_for_server;
 
+    mutable Lock m_fd_queue_lock { "LocalSocket fds" };
+    NonnullRefPtrVector<FileDescription> m_fds_for_client;
+    NonnullRefPtrVector<FileDescription> m_fds_for_server;
+
     // for InlineLinkedList
     LocalSocket* m_prev { nullptr };
     LocalSocket* m_next { nullptr };
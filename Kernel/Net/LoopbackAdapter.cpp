@@ -25,6 +25,8 @@
  */
 
 #include <Kernel/Net/LoopbackAdapter.h>
+#include <Kernel/Net/NetworkStatistics.h>
+#include <Kernel/Net/NetworkTask.h>
 
 namespace Kernel {
 
@@ -41,16 +43,83 @@ LoopbackAdapter::LoopbackAdapter()
     set_interface_name("loop");
     set_mtu(65536);
     set_mac_address({ 19, 85, 2, 9, 0x55, 0xaa });
+    // Nothing can corrupt packets on their way through here, so there's no point in checksumming them.
+    set_offloads(TCPChecksumOffload);
 }
 
 LoopbackAdapter::~LoopbackAdapter()
 {
 }
 
+// Same limit as the regular receive queue; a sender this far ahead of the NetworkTask gets its packets dropped.
+static constexpr size_t max_queued_ipv4_packets = 1024;
+
+void LoopbackAdapter::send_ipv4(const MACAddress& destination_mac, const IPv4Address& destination_ipv4, IPv4Protocol protocol, const u8* payload, size_t payload_size, u8 ttl, const TransmitOffload& offload)
+{
+    ASSERT(!offload.tcp_segment_size);
+    size_t ipv4_packet_size = sizeof(IPv4Packet) + payload_size;
+    if (ipv4_packet_size > mtu()) {
+        NetworkAdapter::send_ipv4(destination_mac, destination_ipv4, protocol, payload, payload_size, ttl, offload);
+        return;
+    }
+
+    auto packet = PacketBuffer::create_with_size(ipv4_packet_size);
+    // Packet storage gets recycled, so clear out the header fields we don't set below.
+    memset(packet->data(), 0, sizeof(IPv4Packet));
+    auto& ipv4 = *(IPv4Packet*)packet->data();
+    ipv4.set_version(4);
+    ipv4.set_internet_header_length(5);
+    ipv4.set_source(ipv4_address());
+    ipv4.set_destination(destination_ipv4);
+    ipv4.set_protocol((u8)protocol);
+    ipv4.set_ident(1);
+    ipv4.set_ttl(ttl);
+    ipv4.set_length(ipv4_packet_size);
+    ipv4.set_checksum(ipv4.compute_checksum());
+    memcpy(ipv4.payload(), payload, payload_size);
+    did_send_packet(ipv4_packet_size);
+    network_statistics().ipv4.sent++;
+
+    // Receiving a datagram doesn't send anything back, so it's safe to do in the sender's context.
+    if (protocol == IPv4Protocol::UDP) {
+        did_receive_packet(ipv4_packet_size);
+        NetworkTask::handle_loopback_packet(*packet);
+        return;
+    }
+
+    // TCP and ICMP answer from within the receive path, which has to run without the
+    // sender's half-updated state underneath it, so those wait for the NetworkTask.
+    InterruptDisabler disabler;
+    did_receive_packet(ipv4_packet_size);
+    if (m_queued_ipv4_packet_count >= max_queued_ipv4_packets) {
+        did_drop_packets(1);
+        return;
+    }
+    m_ipv4_queue.append(move(packet));
+    ++m_queued_ipv4_packet_count;
+    if (on_receive)
+        on_receive();
+}
+
+RefPtr<PacketBuffer> LoopbackAdapter::dequeue_ipv4_packet()
+{
+    InterruptDisabler disabler;
+    if (m_ipv4_queue.is_empty())
+        return nullptr;
+    --m_queued_ipv4_packet_count;
+    return m_ipv4_queue.take_first();
+}
+
 void LoopbackAdapter::send_raw(const u8* data, size_t size)
 {
     dbg() << "LoopbackAdapter: Sending " << size << " byte(s) to myself.";
     did_receive(data, size);
 }
 
+void LoopbackAdapter::send_raw_with_offload(const u8* data, size_t size, const TransmitOffload& offload)
+{
+    ASSERT(!offload.tcp_segment_size);
+    send_raw(data, size);
+}
+
 }
@@ -26,6 +26,7 @@
 
 #pragma once
 
+#include <AK/SinglyLinkedList.h>
 #include <Kernel/Net/NetworkAdapter.h>
 
 namespace Kernel {
@@ -37,11 +38,21 @@ public:
 
     virtual ~LoopbackAdapter() override;
 
+    // Packets sent to ourselves skip Ethernet framing and ARP altogether. UDP is delivered to
+    // the destination socket right away, everything else is queued for the NetworkTask as a
+    // bare IPv4 packet (see dequeue_ipv4_packet()).
+    virtual void send_ipv4(const MACAddress&, const IPv4Address&, IPv4Protocol, const u8* payload, size_t payload_size, u8 ttl, const TransmitOffload& = {}) override;
+    RefPtr<PacketBuffer> dequeue_ipv4_packet();
+
     virtual void send_raw(const u8*, size_t) override;
+    virtual void send_raw_with_offload(const u8*, size_t, const TransmitOffload&) override;
     virtual const char* class_name() const override { return "LoopbackAdapter"; }
 
 private:
     LoopbackAdapter();
+
+    SinglyLinkedList<NonnullRefPtr<PacketBuffer>> m_ipv4_queue;
+    size_t m_queued_ipv4_packet_count { 0 };
 };
 
 }
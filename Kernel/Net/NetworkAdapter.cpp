@@ -32,6 +32,9 @@
 #include <Kernel/Net/EthernetFrameHeader.h>
 #include <Kernel/Net/LoopbackAdapter.h>
 #include <Kernel/Net/NetworkAdapter.h>
+#include <Kernel/Net/NetworkStatistics.h>
+#include <Kernel/Net/Routing.h>
+#include <Kernel/Net/TCP.h>
 #include <Kernel/Random.h>
 #include <Kernel/StdLib.h>
 
@@ -100,11 +103,17 @@ void NetworkAdapter::send(const MACAddress& destination, const ARPPacket& packet
     send_raw((const u8*)eth, size_in_bytes);
 }
 
-void NetworkAdapter::send_ipv4(const MACAddress& destination_mac, const IPv4Address& destination_ipv4, IPv4Protocol protocol, const u8* payload, size_t payload_size, u8 ttl)
+void NetworkAdapter::send_ipv4(const MACAddress& destination_mac, const IPv4Address& destination_ipv4, IPv4Protocol protocol, const u8* payload, size_t payload_size, u8 ttl, const TransmitOffload& offload)
 {
+    bool is_offloaded = offload.tcp_checksum || offload.tcp_segment_size;
+    ASSERT(!offload.tcp_checksum || supports(TCPChecksumOffload));
+    ASSERT(!offload.tcp_segment_size || supports(TCPSegmentationOffload));
+
+    auto path_mtu = path_mtu_to(destination_ipv4, mtu());
     size_t ipv4_packet_size = sizeof(IPv4Packet) + payload_size;
-    if (ipv4_packet_size > mtu()) {
-        send_ipv4_fragmented(destination_mac, destination_ipv4, protocol, payload, payload_size, ttl);
+    if (ipv4_packet_size > path_mtu && !offload.tcp_segment_size) {
+        ASSERT(!is_offloaded);
+        send_ipv4_fragmented(destination_mac, destination_ipv4, protocol, payload, payload_size, ttl, path_mtu);
         return;
     }
 
@@ -120,30 +129,49 @@ void NetworkAdapter::send_ipv4(const MACAddress& destination_mac, const IPv4Addr
     ipv4.set_source(ipv4_address());
     ipv4.set_destination(destination_ipv4);
     ipv4.set_protocol((u8)protocol);
-    ipv4.set_length(sizeof(IPv4Packet) + payload_size);
     ipv4.set_ident(1);
     ipv4.set_ttl(ttl);
+    // TCP can shrink its segments when a router tells us they're too big (RFC 1191),
+    // so let the path report that instead of fragmenting them along the way.
+    ipv4.set_dont_fragment(protocol == IPv4Protocol::TCP);
+    memcpy(ipv4.payload(), payload, payload_size);
+    m_bytes_out += ethernet_frame_size;
+
+    if (offload.tcp_segment_size) {
+        // The adapter fills in the length and checksum of each IPv4 packet it cuts this into.
+        auto& tcp_packet = *(const TCPPacket*)ipv4.payload();
+        size_t tcp_payload_size = payload_size - tcp_packet.header_size();
+        m_packets_out += max((tcp_payload_size + offload.tcp_segment_size - 1) / offload.tcp_segment_size, (size_t)1);
+        network_statistics().ipv4.sent++;
+        send_raw_with_offload((const u8*)&eth, ethernet_frame_size, offload);
+        return;
+    }
+
+    ipv4.set_length(sizeof(IPv4Packet) + payload_size);
     ipv4.set_checksum(ipv4.compute_checksum());
+    network_statistics().ipv4.sent++;
     m_packets_out++;
-    m_bytes_out += ethernet_frame_size;
-    memcpy(ipv4.payload(), payload, payload_size);
-    send_raw((const u8*)&eth, ethernet_frame_size);
+    if (is_offloaded)
+        send_raw_with_offload((const u8*)&eth, ethernet_frame_size, offload);
+    else
+        send_raw((const u8*)&eth, ethernet_frame_size);
 }
 
-void NetworkAdapter::send_ipv4_fragmented(const MACAddress& destination_mac, const IPv4Address& destination_ipv4, IPv4Protocol protocol, const u8* payload, size_t payload_size, u8 ttl)
+void NetworkAdapter::send_ipv4_fragmented(const MACAddress& destination_mac, const IPv4Address& destination_ipv4, IPv4Protocol protocol, const u8* payload, size_t payload_size, u8 ttl, u32 path_mtu)
 {
     // packets must be split on the 64-bit boundary
-    auto packet_boundary_size = (mtu() - sizeof(IPv4Packet) - sizeof(EthernetFrameHeader)) & 0xfffffff8;
-    auto fragment_block_count = (payload_size + packet_boundary_size) / packet_boundary_size;
+    auto packet_boundary_size = (path_mtu - sizeof(IPv4Packet)) & 0xfffffff8;
+    auto fragment_block_count = (payload_size + packet_boundary_size - 1) / packet_boundary_size;
     auto last_block_size = payload_size - packet_boundary_size * (fragment_block_count - 1);
     auto number_of_blocks_in_fragment = packet_boundary_size / 8;
 
     auto identification = get_good_random<u16>();
+    network_statistics().ipv4.sent++;
 
-    size_t ethernet_frame_size = mtu();
     for (size_t packet_index = 0; packet_index < fragment_block_count; ++packet_index) {
         auto is_last_block = packet_index + 1 == fragment_block_count;
         auto packet_payload_size = is_last_block ? last_block_size : packet_boundary_size;
+        size_t ethernet_frame_size = sizeof(EthernetFrameHeader) + sizeof(IPv4Packet) + packet_payload_size;
         auto buffer = ByteBuffer::create_zeroed(ethernet_frame_size);
         auto& eth = *(EthernetFrameHeader*)buffer.data();
         eth.set_source(mac_address());
@@ -161,6 +189,7 @@ void NetworkAdapter::send_ipv4_fragmented(const MACAddress& destination_mac, con
         ipv4.set_ttl(ttl);
         ipv4.set_fragment_offset(packet_index * number_of_blocks_in_fragment);
         ipv4.set_checksum(ipv4.compute_checksum());
+        network_statistics().ipv4.fragments_created++;
         m_packets_out++;
         m_bytes_out += ethernet_frame_size;
         memcpy(ipv4.payload(), payload + packet_index * packet_boundary_size, packet_payload_size);
@@ -168,47 +197,58 @@ void NetworkAdapter::send_ipv4_fragmented(const MACAddress& destination_mac, con
     }
 }
 
+// Packets that the NetworkTask hasn't gotten to yet. Anything beyond this is dropped.
+static constexpr size_t max_queued_packets = 1024;
+
 void NetworkAdapter::did_receive(const u8* data, size_t length)
 {
     InterruptDisabler disabler;
     m_packets_in++;
     m_bytes_in += length;
 
-    Optional<KBuffer> buffer;
-
-    if (m_unused_packet_buffers.is_empty()) {
-        buffer = KBuffer::copy(data, length);
-    } else {
-        buffer = m_unused_packet_buffers.take_first();
-        --m_unused_packet_buffers_count;
-        if (length <= buffer.value().size()) {
-            memcpy(buffer.value().data(), data, length);
-            buffer.value().set_size(length);
-        } else {
-            buffer = KBuffer::copy(data, length);
-        }
+    if (m_queued_packet_count >= max_queued_packets) {
+        m_packets_dropped++;
+        return;
     }
 
-    m_packet_queue.append(buffer.value());
+    // This is the only copy a received packet goes through before it reaches userspace,
+    // since the adapter is about to reuse its receive buffer.
+    m_packet_queue.append(PacketBuffer::copy(data, length));
+    ++m_queued_packet_count;
 
     if (on_receive)
         on_receive();
 }
 
-size_t NetworkAdapter::dequeue_packet(u8* buffer, size_t buffer_size)
+RefPtr<PacketBuffer> NetworkAdapter::dequeue_packet()
 {
     InterruptDisabler disabler;
     if (m_packet_queue.is_empty())
+        return nullptr;
+    --m_queued_packet_count;
+    return m_packet_queue.take_first();
+}
+
+void NetworkAdapter::schedule_receive_poll()
+{
+    ASSERT_INTERRUPTS_DISABLED();
+    m_receive_poll_pending = true;
+    if (on_receive)
+        on_receive();
+}
+
+size_t NetworkAdapter::poll_receive(size_t budget)
+{
+    if (!m_receive_poll_pending)
         return 0;
-    auto packet = m_packet_queue.take_first();
-    size_t packet_size = packet.size();
-    ASSERT(packet_size <= buffer_size);
-    memcpy(buffer, packet.data(), packet_size);
-    if (m_unused_packet_buffers_count < 100) {
-        m_unused_packet_buffers.append(packet);
-        ++m_unused_packet_buffers_count;
+    size_t received = receive_from_ring(budget);
+    if (received < budget) {
+        // The ring is empty. Anything that arrives from now on raises an interrupt again.
+        InterruptDisabler disabler;
+        m_receive_poll_pending = false;
+        enable_receive_interrupts();
     }
-    return packet_size;
+    return received;
 }
 
 void NetworkAdapter::set_ipv4_address(const IPv4Address& address)
@@ -37,13 +37,28 @@
 #include <Kernel/Net/ARP.h>
 #include <Kernel/Net/ICMP.h>
 #include <Kernel/Net/IPv4.h>
+#include <Kernel/Net/PacketBuffer.h>
 
 namespace Kernel {
 
 class NetworkAdapter;
 
+// Work that a caller of send_ipv4() wants the adapter to do on its behalf.
+// Only ask for what the adapter claims to support().
+struct TransmitOffload {
+    // The TCP checksum field holds the sum of the pseudo-header, and the adapter completes it.
+    bool tcp_checksum { false };
+    // Cut the TCP payload into segments of this size, each with its own headers. Implies tcp_checksum.
+    u16 tcp_segment_size { 0 };
+};
+
 class NetworkAdapter : public RefCounted<NetworkAdapter> {
 public:
+    enum Offload : u8 {
+        TCPChecksumOffload = 1 << 0,
+        TCPSegmentationOffload = 1 << 1,
+    };
+
     static void for_each(Function<void(NetworkAdapter&)>);
     static RefPtr<NetworkAdapter> from_ipv4_address(const IPv4Address&);
     static RefPtr<NetworkAdapter> lookup_by_name(const StringView&);
@@ -58,18 +73,25 @@ public:
     IPv4Address ipv4_gateway() const { return m_ipv4_gateway; }
     virtual bool link_up() { return false; }
 
+    bool supports(Offload offload) const { return m_offloads & offload; }
+
     void set_ipv4_address(const IPv4Address&);
     void set_ipv4_netmask(const IPv4Address&);
     void set_ipv4_gateway(const IPv4Address&);
 
     void send(const MACAddress&, const ARPPacket&);
-    void send_ipv4(const MACAddress&, const IPv4Address&, IPv4Protocol, const u8* payload, size_t payload_size, u8 ttl);
-    void send_ipv4_fragmented(const MACAddress&, const IPv4Address&, IPv4Protocol, const u8* payload, size_t payload_size, u8 ttl);
+    virtual void send_ipv4(const MACAddress&, const IPv4Address&, IPv4Protocol, const u8* payload, size_t payload_size, u8 ttl, const TransmitOffload& = {});
+    void send_ipv4_fragmented(const MACAddress&, const IPv4Address&, IPv4Protocol, const u8* payload, size_t payload_size, u8 ttl, u32 path_mtu);
 
-    size_t dequeue_packet(u8* buffer, size_t buffer_size);
+    RefPtr<PacketBuffer> dequeue_packet();
 
     bool has_queued_packets() const { return !m_packet_queue.is_empty(); }
 
+    // Adapters that defer receiving to the NetworkTask (see schedule_receive_poll()) get their
+    // receive ring drained here, at most `budget` packets at a time.
+    size_t poll_receive(size_t budget);
+    bool receive_poll_pending() const { return m_receive_poll_pending; }
+
     u32 mtu() const { return m_mtu; }
     void set_mtu(u32 mtu) { m_mtu = mtu; }
 
@@ -77,6 +99,8 @@ public:
     u32 bytes_in() const { return m_bytes_in; }
     u32 packets_out() const { return m_packets_out; }
     u32 bytes_out() const { return m_bytes_out; }
+    u32 packets_dropped() const { return m_packets_dropped; }
+    u32 receive_overruns() const { return m_receive_overruns; }
 
     Function<void()> on_receive;
 
@@ -85,22 +109,46 @@ protected:
     void set_interface_name(const StringView& basename);
     void set_mac_address(const MACAddress& mac_address) { m_mac_address = mac_address; }
     virtual void send_raw(const u8*, size_t) = 0;
+    virtual void send_raw_with_offload(const u8*, size_t, const TransmitOffload&) { ASSERT_NOT_REACHED(); }
+    void set_offloads(u8 offloads) { m_offloads = offloads; }
     void did_receive(const u8*, size_t);
 
+    // Called from the IRQ handler, with the adapter's receive interrupts masked, to have the
+    // NetworkTask call receive_from_ring() until the ring is empty and then enable_receive_interrupts().
+    void schedule_receive_poll();
+    virtual size_t receive_from_ring(size_t) { return 0; }
+    virtual void enable_receive_interrupts() { }
+
+    void did_send_packet(size_t size)
+    {
+        m_packets_out++;
+        m_bytes_out += size;
+    }
+    void did_receive_packet(size_t size)
+    {
+        m_packets_in++;
+        m_bytes_in += size;
+    }
+    void did_drop_packets(u32 count) { m_packets_dropped += count; }
+    void did_overrun() { m_receive_overruns++; }
+
 private:
     MACAddress m_mac_address;
     IPv4Address m_ipv4_address;
     IPv4Address m_ipv4_netmask;
     IPv4Address m_ipv4_gateway;
-    SinglyLinkedList<KBuffer> m_packet_queue;
-    SinglyLinkedList<KBuffer> m_unused_packet_buffers;
-    size_t m_unused_packet_buffers_count { 0 };
+    SinglyLinkedList<NonnullRefPtr<PacketBuffer>> m_packet_queue;
     String m_name;
     u32 m_packets_in { 0 };
     u32 m_bytes_in { 0 };
     u32 m_packets_out { 0 };
     u32 m_bytes_out { 0 };
+    u32 m_packets_dropped { 0 };
+    u32 m_receive_overruns { 0 };
+    size_t m_queued_packet_count { 0 };
+    bool m_receive_poll_pending { false };
     u32 m_mtu { 1500 };
+    u8 m_offloads { 0 };
 };
 
 }
@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2018-2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/Types.h>
+
+namespace Kernel {
+
+// System-wide counters in the spirit of the SNMP MIB-II groups, shown in /proc/net/snmp.
+// They're bumped without any locking, so treat them as approximate.
+struct NetworkStatistics {
+    struct {
+        u32 received { 0 };
+        u32 header_errors { 0 };
+        u32 unknown_protocols { 0 };
+        u32 delivered { 0 };
+        u32 sent { 0 };
+        u32 fragments_created { 0 };
+        u32 reassembly_required { 0 };
+        u32 reassembled { 0 };
+        u32 reassembly_failures { 0 };
+    } ipv4;
+
+    struct {
+        u32 received { 0 };
+        u32 fragmentation_needed { 0 };
+        u32 sent { 0 };
+    } icmp;
+
+    struct {
+        u32 received { 0 };
+        u32 no_port { 0 };
+        u32 receive_buffer_errors { 0 };
+        u32 sent { 0 };
+    } udp;
+
+    struct {
+        u32 active_opens { 0 };
+        u32 passive_opens { 0 };
+        u32 listen_drops { 0 };
+        u32 received_segments { 0 };
+        u32 sent_segments { 0 };
+        u32 retransmitted_segments { 0 };
+        u32 timeouts { 0 };
+        u32 fast_retransmits { 0 };
+        u32 bad_segments { 0 };
+        u32 no_socket { 0 };
+        u32 out_of_order_segments { 0 };
+        u32 receive_buffer_drops { 0 };
+        u32 sent_resets { 0 };
+    } tcp;
+};
+
+NetworkStatistics& network_statistics();
+
+}
@@ -24,15 +24,22 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <AK/HashFunctions.h>
+#include <AK/NonnullRefPtrVector.h>
+#include <AK/Time.h>
 #include <Kernel/Lock.h>
 #include <Kernel/Net/ARP.h>
 #include <Kernel/Net/EtherType.h>
 #include <Kernel/Net/EthernetFrameHeader.h>
 #include <Kernel/Net/ICMP.h>
 #include <Kernel/Net/IPv4.h>
+#include <Kernel/Net/IPv4Reassembly.h>
 #include <Kernel/Net/IPv4Socket.h>
 #include <Kernel/Net/LoopbackAdapter.h>
+#include <Kernel/Net/NetworkStatistics.h>
 #include <Kernel/Net/NetworkTask.h>
+#include <Kernel/Net/NetworkTrace.h>
+#include <Kernel/Net/PacketBuffer.h>
 #include <Kernel/Net/Routing.h>
 #include <Kernel/Net/TCP.h>
 #include <Kernel/Net/TCPSocket.h>
@@ -51,16 +58,22 @@
 
 namespace Kernel {
 
+static void handle_frame(PacketBuffer&);
 static void handle_arp(const EthernetFrameHeader&, size_t frame_size);
-static void handle_ipv4(const EthernetFrameHeader&, size_t frame_size);
-static void handle_icmp(const EthernetFrameHeader&, const IPv4Packet&);
-static void handle_udp(const IPv4Packet&);
-static void handle_tcp(const IPv4Packet&);
+static void handle_ipv4(const EthernetFrameHeader&, PacketBuffer&);
+static void handle_ipv4_packet(const MACAddress& source, PacketBuffer&);
+static void deliver_ipv4_packet(const MACAddress& source, PacketBuffer&);
+static void handle_icmp(const MACAddress& source, const IPv4Packet&, PacketBuffer&);
+static void handle_fragmentation_needed(const ICMPFragmentationNeededPacket&);
+static void handle_udp(const IPv4Packet&, PacketBuffer&);
+static void handle_tcp(const IPv4Packet&, PacketBuffer&);
 
 [[noreturn]] static void NetworkTask_main();
 
 void NetworkTask::spawn()
 {
+    NetworkTrace::initialize();
+
     Thread* thread = nullptr;
     Process::create_kernel_process(thread, "NetworkTask", NetworkTask_main);
 }
@@ -69,7 +82,7 @@ void NetworkTask_main()
 {
     WaitQueue packet_wait_queue;
     u8 octet = 15;
-    int pending_packets = 0;
+    bool has_pending_packets = false;
     NetworkAdapter::for_each([&](auto& adapter) {
         if (String(adapter.class_name()) == "LoopbackAdapter") {
             adapter.set_ipv4_address({ 127, 0, 0, 1 });
@@ -84,81 +97,123 @@ void NetworkTask_main()
         klog() << "NetworkTask: " << adapter.class_name() << " network adapter found: hw=" << adapter.mac_address().to_string().characters() << " address=" << adapter.ipv4_address().to_string().characters() << " netmask=" << adapter.ipv4_netmask().to_string().characters() << " gateway=" << adapter.ipv4_gateway().to_string().characters();
 
         adapter.on_receive = [&]() {
-            pending_packets++;
+            has_pending_packets = true;
             packet_wait_queue.wake_all();
         };
     });
 
-    auto dequeue_packet = [&pending_packets](u8* buffer, size_t buffer_size) -> size_t {
-        if (pending_packets == 0)
-            return 0;
-        size_t packet_size = 0;
-        NetworkAdapter::for_each([&](auto& adapter) {
-            if (packet_size || !adapter.has_queued_packets())
-                return;
-            packet_size = adapter.dequeue_packet(buffer, buffer_size);
-            pending_packets--;
-#ifdef NETWORK_TASK_DEBUG
-            klog() << "NetworkTask: Dequeued packet from " << adapter.name().characters() << " (" << packet_size << " bytes)";
-#endif
-        });
-        return packet_size;
-    };
+    // How many packets we take from one adapter before moving on to the next one.
+    static constexpr size_t receive_budget = 64;
+    NonnullRefPtrVector<PacketBuffer> batch;
+    NonnullRefPtrVector<PacketBuffer> loopback_batch;
 
-    size_t buffer_size = 64 * KB;
-    auto buffer_region = MM.allocate_kernel_region(buffer_size, "Kernel Packet Buffer", Region::Access::Read | Region::Access::Write, false, true);
-    auto buffer = (u8*)buffer_region->vaddr().get();
+    // How often we check the TCP retransmission timers (and the IPv4 reassembly timeouts).
+    static constexpr u32 timer_granularity_ms = 50;
+    timeval last_timer_check = kgettimeofday();
 
     klog() << "NetworkTask: Enter main loop.";
     for (;;) {
-        size_t packet_size = dequeue_packet(buffer, buffer_size);
-        if (!packet_size) {
-            Thread::current->wait_on(packet_wait_queue);
-            continue;
+        auto now = kgettimeofday();
+        timeval since_timer_check;
+        timeval_sub(now, last_timer_check, since_timer_check);
+        if (since_timer_check.tv_sec || since_timer_check.tv_usec >= (suseconds_t)(timer_granularity_ms * 1000)) {
+            TCPSocket::run_timers();
+            expire_ipv4_fragments();
+            last_timer_check = now;
         }
-        if (packet_size < sizeof(EthernetFrameHeader)) {
-            klog() << "NetworkTask: Packet is too small to be an Ethernet packet! (" << packet_size << ")";
-            continue;
-        }
-        auto& eth = *(const EthernetFrameHeader*)buffer;
-#ifdef ETHERNET_DEBUG
-        klog() << "NetworkTask: From " << eth.source().to_string().characters() << " to " << eth.destination().to_string().characters() << ", ether_type=" << String::format("%w", eth.ether_type()) << ", packet_length=" << packet_size;
-#endif
 
-#ifdef ETHERNET_VERY_DEBUG
-        for (size_t i = 0; i < packet_size; i++) {
-            klog() << String::format("%b", buffer[i]);
+        has_pending_packets = false;
+        NetworkAdapter::for_each([&](auto& adapter) {
+            // Pull a batch of frames out of the adapter's receive ring (if it's waiting
+            // to be polled), then handle the whole batch before going back to the hardware.
+            adapter.poll_receive(receive_budget);
+            for (size_t i = 0; i < receive_budget; ++i) {
+                auto packet = adapter.dequeue_packet();
+                if (!packet)
+                    break;
+#ifdef NETWORK_TASK_DEBUG
+                klog() << "NetworkTask: Dequeued packet from " << adapter.name().characters() << " (" << packet->size() << " bytes)";
+#endif
+                batch.append(packet.release_nonnull());
+            }
+        });
 
-            switch (i % 16) {
-            case 7:
-                klog() << "  ";
-                break;
-            case 15:
-                klog() << "";
+        // Packets we sent to ourselves are bare IPv4 packets, without an Ethernet header.
+        auto& loopback = LoopbackAdapter::the();
+        for (size_t i = 0; i < receive_budget; ++i) {
+            auto packet = loopback.dequeue_ipv4_packet();
+            if (!packet)
                 break;
-            default:
-                klog() << " ";
-                break;
-            }
+            loopback_batch.append(packet.release_nonnull());
         }
 
-        klog() << "";
+        for (auto& packet : batch)
+            handle_frame(packet);
+        for (auto& packet : loopback_batch)
+            handle_ipv4_packet(loopback.mac_address(), packet);
+
+        if (batch.is_empty() && loopback_batch.is_empty()) {
+            timeval timeout { 0, timer_granularity_ms * 1000 };
+            cli();
+            if (!has_pending_packets)
+                Thread::current()->wait_on(packet_wait_queue, &timeout);
+            sti();
+        }
+        batch.clear_with_capacity();
+        loopback_batch.clear_with_capacity();
+    }
+}
+
+void NetworkTask::handle_loopback_packet(PacketBuffer& packet)
+{
+    handle_ipv4_packet(LoopbackAdapter::the().mac_address(), packet);
+}
+
+void handle_frame(PacketBuffer& packet)
+{
+    size_t packet_size = packet.size();
+    if (packet_size < sizeof(EthernetFrameHeader)) {
+        klog() << "NetworkTask: Packet is too small to be an Ethernet packet! (" << packet_size << ")";
+        return;
+    }
+    auto& eth = *(const EthernetFrameHeader*)packet.data();
+#ifdef ETHERNET_DEBUG
+    klog() << "NetworkTask: From " << eth.source().to_string().characters() << " to " << eth.destination().to_string().characters() << ", ether_type=" << String::format("%w", eth.ether_type()) << ", packet_length=" << packet_size;
 #endif
 
-        switch (eth.ether_type()) {
-        case EtherType::ARP:
-            handle_arp(eth, packet_size);
-            break;
-        case EtherType::IPv4:
-            handle_ipv4(eth, packet_size);
+#ifdef ETHERNET_VERY_DEBUG
+    for (size_t i = 0; i < packet_size; i++) {
+        klog() << String::format("%b", packet.data()[i]);
+
+        switch (i % 16) {
+        case 7:
+            klog() << "  ";
             break;
-        case EtherType::IPv6:
-            // ignore
+        case 15:
+            klog() << "";
             break;
         default:
-            klog() << "NetworkTask: Unknown ethernet type 0x" << String::format("%x", eth.ether_type());
+            klog() << " ";
+            break;
         }
     }
+
+    klog() << "";
+#endif
+
+    switch (eth.ether_type()) {
+    case EtherType::ARP:
+        handle_arp(eth, packet_size);
+        break;
+    case EtherType::IPv4:
+        handle_ipv4(eth, packet);
+        break;
+    case EtherType::IPv6:
+        // ignore
+        break;
+    default:
+        klog() << "NetworkTask: Unknown ethernet type 0x" << String::format("%x", eth.ether_type());
+    }
 }
 
 void handle_arp(const EthernetFrameHeader& eth, size_t frame_size)
@@ -213,46 +268,80 @@ void handle_arp(const EthernetFrameHeader& eth, size_t frame_size)
     }
 }
 
-void handle_ipv4(const EthernetFrameHeader& eth, size_t frame_size)
+void handle_ipv4(const EthernetFrameHeader& eth, PacketBuffer& packet_buffer)
 {
+    size_t frame_size = packet_buffer.size();
     constexpr size_t minimum_ipv4_frame_size = sizeof(EthernetFrameHeader) + sizeof(IPv4Packet);
     if (frame_size < minimum_ipv4_frame_size) {
         klog() << "handle_ipv4: Frame too small (" << frame_size << ", need " << minimum_ipv4_frame_size << ")";
+        network_statistics().ipv4.received++;
+        network_statistics().ipv4.header_errors++;
         return;
     }
-    auto& packet = *static_cast<const IPv4Packet*>(eth.payload());
+    packet_buffer.pull(sizeof(EthernetFrameHeader));
+    handle_ipv4_packet(eth.source(), packet_buffer);
+}
+
+void handle_ipv4_packet(const MACAddress& source, PacketBuffer& packet_buffer)
+{
+    auto& packet = *(const IPv4Packet*)packet_buffer.data();
+    auto& statistics = network_statistics().ipv4;
+    statistics.received++;
 
     if (packet.length() < sizeof(IPv4Packet)) {
         klog() << "handle_ipv4: IPv4 packet too short (" << packet.length() << ", need " << sizeof(IPv4Packet) << ")";
+        statistics.header_errors++;
         return;
     }
 
-    size_t actual_ipv4_packet_length = frame_size - sizeof(EthernetFrameHeader);
+    size_t actual_ipv4_packet_length = packet_buffer.size();
     if (packet.length() > actual_ipv4_packet_length) {
         klog() << "handle_ipv4: IPv4 packet claims to be longer than it is (" << packet.length() << ", actually " << actual_ipv4_packet_length << ")";
+        statistics.header_errors++;
         return;
     }
 
+    // From here on the buffer holds exactly the IPv4 packet, without any padding.
+    packet_buffer.trim(sizeof(IPv4Packet) + packet.payload_size());
+
 #ifdef IPV4_DEBUG
     klog() << "handle_ipv4: source=" << packet.source().to_string().characters() << ", target=" << packet.destination().to_string().characters();
 #endif
 
+    if (packet.is_a_fragment()) {
+        auto whole_packet = reassemble_ipv4_fragment(packet_buffer);
+        if (!whole_packet)
+            return;
+        return deliver_ipv4_packet(source, *whole_packet);
+    }
+    deliver_ipv4_packet(source, packet_buffer);
+}
+
+void deliver_ipv4_packet(const MACAddress& source, PacketBuffer& packet_buffer)
+{
+    auto& packet = *(const IPv4Packet*)packet_buffer.data();
+    auto& statistics = network_statistics().ipv4;
     switch ((IPv4Protocol)packet.protocol()) {
     case IPv4Protocol::ICMP:
-        return handle_icmp(eth, packet);
+        statistics.delivered++;
+        return handle_icmp(source, packet, packet_buffer);
     case IPv4Protocol::UDP:
-        return handle_udp(packet);
+        statistics.delivered++;
+        return handle_udp(packet, packet_buffer);
     case IPv4Protocol::TCP:
-        return handle_tcp(packet);
+        statistics.delivered++;
+        return handle_tcp(packet, packet_buffer);
     default:
         klog() << "handle_ipv4: Unhandled protocol " << packet.protocol();
+        statistics.unknown_protocols++;
         break;
     }
 }
 
-void handle_icmp(const EthernetFrameHeader& eth, const IPv4Packet& ipv4_packet)
+void handle_icmp(const MACAddress& source, const IPv4Packet& ipv4_packet, PacketBuffer& packet_buffer)
 {
     auto& icmp_header = *static_cast<const ICMPHeader*>(ipv4_packet.payload());
+    network_statistics().icmp.received++;
 #ifdef ICMP_DEBUG
     klog() << "handle_icmp: source=" << ipv4_packet.source().to_string().characters() << ", destination=" << ipv4_packet.destination().to_string().characters() << ", type=" << String::format("%b", icmp_header.type()) << ", code=" << String::format("%b", icmp_header.code());
 #endif
@@ -263,7 +352,7 @@ void handle_icmp(const EthernetFrameHeader& eth, const IPv4Packet& ipv4_packet)
             LOCKER(socket->lock());
             if (socket->protocol() != (unsigned)IPv4Protocol::ICMP)
                 continue;
-            socket->did_receive(ipv4_packet.source(), 0, KBuffer::copy(&ipv4_packet, sizeof(IPv4Packet) + ipv4_packet.payload_size()));
+            socket->did_receive(ipv4_packet.source(), 0, packet_buffer);
         }
     }
 
@@ -271,6 +360,12 @@ void handle_icmp(const EthernetFrameHeader& eth, const IPv4Packet& ipv4_packet)
     if (!adapter)
         return;
 
+    if (icmp_header.type() == ICMPType::DestinationUnreachable && icmp_header.code() == ICMPDestinationUnreachableCode::FragmentationNeeded) {
+        if (ipv4_packet.payload_size() >= sizeof(ICMPFragmentationNeededPacket))
+            handle_fragmentation_needed(reinterpret_cast<const ICMPFragmentationNeededPacket&>(icmp_header));
+        return;
+    }
+
     if (icmp_header.type() == ICMPType::EchoRequest) {
         auto& request = reinterpret_cast<const ICMPEchoPacket&>(icmp_header);
         klog() << "handle_icmp: EchoRequest from " << ipv4_packet.source().to_string().characters() << ": id=" << (u16)request.identifier << ", seq=" << (u16)request.sequence_number;
@@ -285,12 +380,58 @@ void handle_icmp(const EthernetFrameHeader& eth, const IPv4Packet& ipv4_packet)
             memcpy(response.payload(), request.payload(), icmp_payload_size);
         response.header.set_checksum(internet_checksum(&response, icmp_packet_size));
         // FIXME: What is the right TTL value here? Is 64 ok? Should we use the same TTL as the echo request?
-        adapter->send_ipv4(eth.source(), ipv4_packet.source(), IPv4Protocol::ICMP, buffer.data(), buffer.size(), 64);
+        adapter->send_ipv4(source, ipv4_packet.source(), IPv4Protocol::ICMP, buffer.data(), buffer.size(), 64);
+        network_statistics().icmp.sent++;
+    }
+}
+
+// The MTUs that routers commonly have, from RFC 1191, section 7.
+static constexpr u16 mtu_plateaus[] = { 32000, 17914, 8166, 4352, 2002, 1492, 1006, 508, 296, 68 };
+
+void handle_fragmentation_needed(const ICMPFragmentationNeededPacket& message)
+{
+    network_statistics().icmp.fragmentation_needed++;
+    auto& original_packet = message.original_packet;
+    // Only believe this about packets we actually sent.
+    auto adapter = NetworkAdapter::from_ipv4_address(original_packet.source());
+    if (!adapter)
+        return;
+
+    u32 mtu = message.next_hop_mtu;
+    if (!mtu) {
+        // Routers from before RFC 1191 don't tell us the MTU, so guess the next plateau down.
+        for (auto plateau : mtu_plateaus) {
+            if (plateau < original_packet.length()) {
+                mtu = plateau;
+                break;
+            }
+        }
     }
+    if (!mtu || mtu >= original_packet.length())
+        return;
+
+#ifdef ICMP_DEBUG
+    klog() << "handle_icmp: Path MTU to " << original_packet.destination().to_string().characters() << " is " << mtu;
+#endif
+    update_path_mtu(original_packet.destination(), mtu);
+    TCPSocket::did_shrink_path_mtu(original_packet.destination(), path_mtu_to(original_packet.destination(), adapter->mtu()));
+}
+
+static void trace_udp(NetworkTraceEvent::Type type, const IPv4Packet& ipv4_packet, const UDPPacket& udp_packet)
+{
+    NetworkTraceEvent event;
+    event.type = type;
+    event.local_address = ipv4_packet.destination();
+    event.local_port = udp_packet.destination_port();
+    event.peer_address = ipv4_packet.source();
+    event.peer_port = udp_packet.source_port();
+    event.length = ipv4_packet.payload_size() - sizeof(UDPPacket);
+    NetworkTrace::record(event);
 }
 
-void handle_udp(const IPv4Packet& ipv4_packet)
+void handle_udp(const IPv4Packet& ipv4_packet, PacketBuffer& packet_buffer)
 {
+    network_statistics().udp.received++;
     if (ipv4_packet.payload_size() < sizeof(UDPPacket)) {
         klog() << "handle_udp: Packet too small (" << ipv4_packet.payload_size() << ", need " << sizeof(UDPPacket) << ")";
         return;
@@ -307,21 +448,33 @@ void handle_udp(const IPv4Packet& ipv4_packet)
     klog() << "handle_udp: source=" << ipv4_packet.source().to_string().characters() << ":" << udp_packet.source_port() << ", destination=" << ipv4_packet.destination().to_string().characters() << ":" << udp_packet.destination_port() << " length=" << udp_packet.length();
 #endif
 
-    auto socket = UDPSocket::from_port(udp_packet.destination_port());
+    auto flow_hash = pair_int_hash(ipv4_packet.source().to_u32(), udp_packet.source_port());
+    auto socket = UDPSocket::from_port(udp_packet.destination_port(), flow_hash);
     if (!socket) {
         klog() << "handle_udp: No UDP socket for port " << udp_packet.destination_port();
+        network_statistics().udp.no_port++;
+        if (NetworkTrace::is_enabled())
+            trace_udp(NetworkTraceEvent::Type::UDPDrop, ipv4_packet, udp_packet);
         return;
     }
 
     ASSERT(socket->type() == SOCK_DGRAM);
     ASSERT(socket->local_port() == udp_packet.destination_port());
-    socket->did_receive(ipv4_packet.source(), udp_packet.source_port(), KBuffer::copy(&ipv4_packet, sizeof(IPv4Packet) + ipv4_packet.payload_size()));
+    bool received = socket->did_receive(ipv4_packet.source(), udp_packet.source_port(), packet_buffer);
+    if (!received)
+        network_statistics().udp.receive_buffer_errors++;
+    if (NetworkTrace::is_enabled())
+        trace_udp(received ? NetworkTraceEvent::Type::UDPReceive : NetworkTraceEvent::Type::UDPDrop, ipv4_packet, udp_packet);
 }
 
-void handle_tcp(const IPv4Packet& ipv4_packet)
+void handle_tcp(const IPv4Packet& ipv4_packet, PacketBuffer& packet_buffer)
 {
+    auto& statistics = network_statistics().tcp;
+    statistics.received_segments++;
+
     if (ipv4_packet.payload_size() < sizeof(TCPPacket)) {
         klog() << "handle_tcp: IPv4 payload is too small to be a TCP packet (" << ipv4_packet.payload_size() << ", need " << sizeof(TCPPacket) << ")";
+        statistics.bad_segments++;
         return;
     }
 
@@ -335,6 +488,7 @@ void handle_tcp(const IPv4Packet& ipv4_packet)
 
     if (ipv4_packet.payload_size() < tcp_packet.header_size()) {
         klog() << "handle_tcp: IPv4 payload is smaller than TCP header claims (" << ipv4_packet.payload_size() << ", supposedly " << tcp_packet.header_size() << ")";
+        statistics.bad_segments++;
         return;
     }
 
@@ -358,6 +512,7 @@ void handle_tcp(const IPv4Packet& ipv4_packet)
 
     auto socket = TCPSocket::from_tuple(tuple);
     if (!socket) {
+        statistics.no_socket++;
         klog() << "handle_tcp: No TCP socket for tuple " << tuple.to_string().characters();
         klog() << "handle_tcp: source=" << ipv4_packet.source().to_string().characters() << ":" << tcp_packet.source_port() << ", destination=" << ipv4_packet.destination().to_string().characters() << ":" << tcp_packet.destination_port() << " seq_no=" << tcp_packet.sequence_number() << ", ack_no=" << tcp_packet.ack_number() << ", flags=" << String::format("%w", tcp_packet.flags()) << " (" << (tcp_packet.has_syn() ? "SYN " : "") << (tcp_packet.has_ack() ? "ACK " : "") << (tcp_packet.has_fin() ? "FIN " : "") << (tcp_packet.has_rst() ? "RST " : "") << "), window_size=" << tcp_packet.window_size() << ", payload_size=" << payload_size;
         return;
@@ -400,6 +555,7 @@ void handle_tcp(const IPv4Packet& ipv4_packet)
 #endif
             client->set_sequence_number(1000);
             client->set_ack_number(tcp_packet.sequence_number() + payload_size + 1);
+            client->apply_syn_options(tcp_packet);
             client->send_tcp_packet(TCPFlags::SYN | TCPFlags::ACK);
             client->set_state(TCPSocket::State::SynReceived);
             return;
@@ -413,11 +569,13 @@ void handle_tcp(const IPv4Packet& ipv4_packet)
         switch (tcp_packet.flags()) {
         case TCPFlags::SYN:
             socket->set_ack_number(tcp_packet.sequence_number() + payload_size + 1);
+            socket->apply_syn_options(tcp_packet);
             socket->send_tcp_packet(TCPFlags::ACK);
             socket->set_state(TCPSocket::State::SynReceived);
             return;
         case TCPFlags::ACK | TCPFlags::SYN:
             socket->set_ack_number(tcp_packet.sequence_number() + payload_size + 1);
+            socket->apply_syn_options(tcp_packet);
             socket->send_tcp_packet(TCPFlags::ACK);
             socket->set_state(TCPSocket::State::Established);
             socket->set_setup_state(Socket::SetupState::Completed);
@@ -546,9 +704,26 @@ void handle_tcp(const IPv4Packet& ipv4_packet)
             return;
         }
     case TCPSocket::State::Established:
+        if ((payload_size || tcp_packet.has_fin()) && tcp_packet.sequence_number() != socket->ack_number()) {
+            // Out of order or a duplicate. We don't keep out-of-order segments around, so we
+            // send a duplicate ACK for what we have, which gets the peer to fast retransmit.
+#ifdef TCP_DEBUG
+            klog() << "handle_tcp: expected seq_no=" << socket->ack_number() << ", got " << tcp_packet.sequence_number() << ", dropping it";
+#endif
+            socket->did_drop_out_of_order_segment(tcp_packet, payload_size);
+            socket->send_tcp_packet(TCPFlags::ACK);
+            return;
+        }
+
         if (tcp_packet.has_fin()) {
-            if (payload_size != 0)
-                socket->did_receive(ipv4_packet.source(), tcp_packet.source_port(), KBuffer::copy(&ipv4_packet, sizeof(IPv4Packet) + ipv4_packet.payload_size()));
+            if (payload_size != 0) {
+                if (!socket->did_receive(ipv4_packet.source(), tcp_packet.source_port(), packet_buffer)) {
+                    // We'll see the FIN again when the peer retransmits.
+                    socket->did_drop_for_lack_of_buffer_space(tcp_packet, payload_size);
+                    socket->send_tcp_packet(TCPFlags::ACK);
+                    return;
+                }
+            }
 
             socket->set_ack_number(tcp_packet.sequence_number() + payload_size + 1);
             socket->send_tcp_packet(TCPFlags::ACK);
@@ -557,16 +732,18 @@ void handle_tcp(const IPv4Packet& ipv4_packet)
             return;
         }
 
-        socket->set_ack_number(tcp_packet.sequence_number() + payload_size);
+        if (payload_size) {
+            // Only acknowledge data that actually made it into the receive buffer.
+            if (socket->did_receive(ipv4_packet.source(), tcp_packet.source_port(), packet_buffer))
+                socket->set_ack_number(tcp_packet.sequence_number() + payload_size);
+            else
+                socket->did_drop_for_lack_of_buffer_space(tcp_packet, payload_size);
+            socket->send_tcp_packet(TCPFlags::ACK);
+        }
 
 #ifdef TCP_DEBUG
         klog() << "Got packet with ack_no=" << tcp_packet.ack_number() << ", seq_no=" << tcp_packet.sequence_number() << ", payload_size=" << payload_size << ", acking it with new ack_no=" << socket->ack_number() << ", seq_no=" << socket->sequence_number();
 #endif
-
-        if (payload_size) {
-            if (socket->did_receive(ipv4_packet.source(), tcp_packet.source_port(), KBuffer::copy(&ipv4_packet, sizeof(IPv4Packet) + ipv4_packet.payload_size())))
-                socket->send_tcp_packet(TCPFlags::ACK);
-        }
     }
 }
 
@@ -26,9 +26,14 @@
 
 #pragma once
 
+#include <Kernel/Forward.h>
+
 namespace Kernel {
 class NetworkTask {
 public:
     static void spawn();
+
+    // Hands a bare IPv4 packet that we sent to ourselves up the stack, in the caller's context.
+    static void handle_loopback_packet(PacketBuffer&);
 };
 }
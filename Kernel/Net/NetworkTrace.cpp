@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) 2018-2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/Vector.h>
+#include <Kernel/Arch/i386/CPU.h>
+#include <Kernel/FileSystem/ProcFS.h>
+#include <Kernel/Net/NetworkTrace.h>
+#include <Kernel/Process.h>
+
+namespace Kernel {
+
+namespace NetworkTrace {
+
+static constexpr size_t event_capacity = 1024;
+
+static Lockable<bool>* s_enabled;
+static NetworkTraceEvent* s_events;
+static size_t s_next_event_index;
+static size_t s_event_count;
+
+static void did_toggle()
+{
+    if (!s_enabled->resource())
+        return;
+    // The ring is only allocated the first time someone asks for it, and it stays around after that.
+    auto* events = s_events ? nullptr : new NetworkTraceEvent[event_capacity];
+    InterruptDisabler disabler;
+    if (events)
+        s_events = events;
+    s_next_event_index = 0;
+    s_event_count = 0;
+}
+
+void initialize()
+{
+    ASSERT(!s_enabled);
+    s_enabled = new Lockable<bool>(false);
+    ProcFS::add_sys_bool("net_trace", *s_enabled, did_toggle);
+}
+
+bool is_enabled()
+{
+    return s_enabled && s_enabled->resource();
+}
+
+void record(NetworkTraceEvent& event)
+{
+    event.timestamp = kgettimeofday();
+    InterruptDisabler disabler;
+    if (!s_events)
+        return;
+    s_events[s_next_event_index] = event;
+    s_next_event_index = (s_next_event_index + 1) % event_capacity;
+    if (s_event_count < event_capacity)
+        ++s_event_count;
+}
+
+void for_each(Function<void(const NetworkTraceEvent&)> callback)
+{
+    Vector<NetworkTraceEvent> events;
+    {
+        InterruptDisabler disabler;
+        if (!s_events)
+            return;
+        events.ensure_capacity(s_event_count);
+        size_t first_event_index = (s_next_event_index + event_capacity - s_event_count) % event_capacity;
+        for (size_t i = 0; i < s_event_count; ++i)
+            events.unchecked_append(s_events[(first_event_index + i) % event_capacity]);
+    }
+    for (auto& event : events)
+        callback(event);
+}
+
+const char* to_string(NetworkTraceEvent::Type type)
+{
+    switch (type) {
+    case NetworkTraceEvent::Type::TCPSend:
+        return "tcp_send";
+    case NetworkTraceEvent::Type::TCPRetransmit:
+        return "tcp_retransmit";
+    case NetworkTraceEvent::Type::TCPReceive:
+        return "tcp_receive";
+    case NetworkTraceEvent::Type::TCPOutOfOrder:
+        return "tcp_out_of_order";
+    case NetworkTraceEvent::Type::UDPSend:
+        return "udp_send";
+    case NetworkTraceEvent::Type::UDPReceive:
+        return "udp_receive";
+    case NetworkTraceEvent::Type::UDPDrop:
+        return "udp_drop";
+    }
+    ASSERT_NOT_REACHED();
+}
+
+}
+
+}
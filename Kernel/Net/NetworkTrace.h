@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2018-2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/Function.h>
+#include <AK/IPv4Address.h>
+#include <AK/Types.h>
+#include <Kernel/UnixTypes.h>
+
+namespace Kernel {
+
+struct NetworkTraceEvent {
+    enum class Type : u8 {
+        TCPSend,
+        TCPRetransmit,
+        TCPReceive,
+        TCPOutOfOrder,
+        UDPSend,
+        UDPReceive,
+        UDPDrop,
+    };
+
+    Type type;
+    timeval timestamp { 0, 0 };
+    IPv4Address local_address;
+    u16 local_port { 0 };
+    IPv4Address peer_address;
+    u16 peer_port { 0 };
+    u32 sequence_number { 0 };
+    u32 ack_number { 0 };
+    u32 length { 0 };
+    u16 flags { 0 };
+    u32 window { 0 };
+    u32 congestion_window { 0 };
+};
+
+// NetworkTrace: A ring of the most recent packet events, for figuring out why a connection
+// is slow. It's off by default; writing 1 to /proc/sys/net_trace turns it on (and clears the
+// ring), and /proc/net/trace shows what has been recorded.
+namespace NetworkTrace {
+
+void initialize();
+bool is_enabled();
+void record(NetworkTraceEvent&);
+void for_each(Function<void(const NetworkTraceEvent&)>);
+const char* to_string(NetworkTraceEvent::Type);
+
+}
+
+}
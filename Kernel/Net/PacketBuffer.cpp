@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2018-2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/SinglyLinkedList.h>
+#include <Kernel/Arch/i386/CPU.h>
+#include <Kernel/Net/PacketBuffer.h>
+
+namespace Kernel {
+
+DEFINE_OBJECT_CACHE(PacketBuffer);
+
+static constexpr size_t max_unused_storage_count = 100;
+
+static SinglyLinkedList<KBuffer>* s_unused_storage;
+static size_t s_unused_storage_count;
+
+static SinglyLinkedList<KBuffer>& unused_storage()
+{
+    if (!s_unused_storage)
+        s_unused_storage = new SinglyLinkedList<KBuffer>;
+    return *s_unused_storage;
+}
+
+NonnullRefPtr<PacketBuffer> PacketBuffer::create_with_size(size_t size)
+{
+    // Packets arrive from IRQ handlers, so the storage pool is protected by disabling interrupts.
+    InterruptDisabler disabler;
+    auto& pool = unused_storage();
+    for (auto it = pool.begin(); it != pool.end(); ++it) {
+        if ((*it).capacity() < size)
+            continue;
+        auto storage = *it;
+        pool.remove(it);
+        --s_unused_storage_count;
+        return adopt(*new PacketBuffer(move(storage), size));
+    }
+    auto storage = KBuffer::create_with_size(size, Region::Access::Read | Region::Access::Write, "Packet Buffer");
+    storage.impl().region().commit();
+    return adopt(*new PacketBuffer(move(storage), size));
+}
+
+NonnullRefPtr<PacketBuffer> PacketBuffer::copy(const void* data, size_t size)
+{
+    auto buffer = create_with_size(size);
+    memcpy(buffer->data(), data, size);
+    return buffer;
+}
+
+PacketBuffer::PacketBuffer(KBuffer&& storage, size_t size)
+    : m_storage(move(storage))
+    , m_size(size)
+{
+    ASSERT(size <= m_storage.capacity());
+}
+
+PacketBuffer::~PacketBuffer()
+{
+    InterruptDisabler disabler;
+    if (s_unused_storage_count >= max_unused_storage_count)
+        return;
+    unused_storage().append(m_storage);
+    ++s_unused_storage_count;
+}
+
+void PacketBuffer::pull(size_t count)
+{
+    ASSERT(count <= m_size);
+    m_offset += count;
+    m_size -= count;
+}
+
+void PacketBuffer::trim(size_t new_size)
+{
+    ASSERT(new_size <= m_size);
+    m_size = new_size;
+}
+
+void PacketBuffer::append(const void* data, size_t count)
+{
+    ASSERT(count <= tailroom());
+    memcpy(this->data() + m_size, data, count);
+    m_size += count;
+}
+
+}
@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2018-2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+// PacketBuffer: A received network packet.
+//
+// Packets are copied exactly once, out of the network adapter's receive ring and into a
+// PacketBuffer. From there the same buffer is handed up the stack by reference: protocol
+// code strips headers with pull() instead of copying the payload, and sockets queue the
+// buffer itself until userspace reads it.
+//
+// The page-backed storage behind a PacketBuffer is recycled once the last reference goes
+// away, so the receive path doesn't have to allocate a kernel region for every packet.
+
+#include <AK/NonnullRefPtr.h>
+#include <AK/RefCounted.h>
+#include <AK/Types.h>
+#include <Kernel/Heap/ObjectCache.h>
+#include <Kernel/KBuffer.h>
+
+namespace Kernel {
+
+class PacketBuffer : public RefCounted<PacketBuffer> {
+    MAKE_OBJECT_CACHED(PacketBuffer)
+public:
+    static NonnullRefPtr<PacketBuffer> create_with_size(size_t);
+    static NonnullRefPtr<PacketBuffer> copy(const void*, size_t);
+    ~PacketBuffer();
+
+    u8* data() { return m_storage.data() + m_offset; }
+    const u8* data() const { return m_storage.data() + m_offset; }
+    size_t size() const { return m_size; }
+
+    // Space in front of data(), which grows as headers are pulled off.
+    size_t headroom() const { return m_offset; }
+    // Space after the end of data() that append() can use.
+    size_t tailroom() const { return m_storage.capacity() - m_offset - m_size; }
+
+    void pull(size_t);
+    void trim(size_t new_size);
+    void append(const void*, size_t);
+
+private:
+    explicit PacketBuffer(KBuffer&&, size_t size);
+
+    KBuffer m_storage;
+    size_t m_offset { 0 };
+    size_t m_size { 0 };
+};
+
+}
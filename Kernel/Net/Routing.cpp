@@ -27,6 +27,7 @@
 #include <AK/HashMap.h>
 #include <Kernel/Net/LoopbackAdapter.h>
 #include <Kernel/Net/Routing.h>
+#include <Kernel/Process.h>
 #include <Kernel/Thread.h>
 
 //#define ROUTING_DEBUG
@@ -41,6 +42,70 @@ Lockable<HashMap<IPv4Address, MACAddress>>& arp_table()
     return *the;
 }
 
+// RFC 1191, section 6.3: Forget a learned path MTU after a while, in case the route has changed.
+static constexpr time_t path_mtu_lifetime_seconds = 10 * 60;
+// Don't let (possibly forged) ICMP messages shrink packets below what every host must accept.
+static constexpr u32 minimum_path_mtu = 576;
+static constexpr size_t max_path_mtu_entries = 256;
+
+struct PathMTU {
+    u32 mtu { 0 };
+    time_t expires { 0 };
+};
+
+static Lockable<HashMap<IPv4Address, PathMTU>>& path_mtu_cache()
+{
+    static Lockable<HashMap<IPv4Address, PathMTU>>* the;
+    if (!the)
+        the = new Lockable<HashMap<IPv4Address, PathMTU>>;
+    return *the;
+}
+
+u32 path_mtu_to(const IPv4Address& target, u32 link_mtu)
+{
+    LOCKER(path_mtu_cache().lock());
+    auto& cache = path_mtu_cache().resource();
+    if (cache.is_empty())
+        return link_mtu;
+    auto it = cache.find(target);
+    if (it == cache.end())
+        return link_mtu;
+    if (kgettimeofday().tv_sec >= it->value.expires) {
+        cache.remove(target);
+        return link_mtu;
+    }
+    return min(it->value.mtu, link_mtu);
+}
+
+void update_path_mtu(const IPv4Address& target, u32 mtu)
+{
+    mtu = max(mtu, minimum_path_mtu);
+    auto now = kgettimeofday().tv_sec;
+
+    LOCKER(path_mtu_cache().lock());
+    auto& cache = path_mtu_cache().resource();
+    auto it = cache.find(target);
+    if (it != cache.end() && now < it->value.expires && it->value.mtu <= mtu)
+        return;
+
+    if (it == cache.end() && cache.size() >= max_path_mtu_entries) {
+        Vector<IPv4Address> expired;
+        for (auto& entry : cache) {
+            if (now >= entry.value.expires)
+                expired.append(entry.key);
+        }
+        for (auto& address : expired)
+            cache.remove(address);
+        if (cache.size() >= max_path_mtu_entries)
+            cache.remove_one_randomly();
+    }
+
+#ifdef ROUTING_DEBUG
+    klog() << "Routing: Path MTU to " << target.to_string().characters() << " is " << mtu;
+#endif
+    cache.set(target, { mtu, now + path_mtu_lifetime_seconds });
+}
+
 bool RoutingDecision::is_zero() const
 {
     return adapter.is_null() || next_hop.is_zero();
@@ -135,7 +200,7 @@ RoutingDecision route_to(const IPv4Address& target, const IPv4Address& source, c
     request.set_sender_protocol_address(adapter->ipv4_address());
     adapter->send({ 0xff, 0xff, 0xff, 0xff, 0xff, 0xff }, request);
 
-    (void)Thread::current->block_until("Routing (ARP)", [next_hop_ip] {
+    (void)Thread::current()->block_until("Routing (ARP)", [next_hop_ip] {
         return arp_table().resource().get(next_hop_ip).has_value();
     });
 
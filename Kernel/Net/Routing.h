@@ -41,4 +41,9 @@ RoutingDecision route_to(const IPv4Address& target, const IPv4Address& source, c
 
 Lockable<HashMap<IPv4Address, MACAddress>>& arp_table();
 
+// The largest packet we can send to a target in one piece: the link MTU, unless an ICMP
+// "fragmentation needed" message told us about a smaller one further along the path.
+u32 path_mtu_to(const IPv4Address& target, u32 link_mtu);
+void update_path_mtu(const IPv4Address& target, u32 mtu);
+
 }
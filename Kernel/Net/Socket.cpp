@@ -55,7 +55,7 @@ Socket::Socket(int domain, int type, int protocol)
     , m_type(type)
     , m_protocol(protocol)
 {
-    auto& process = *Process::current;
+    auto& process = *Process::current();
     m_origin = { process.pid(), process.uid(), process.gid() };
 }
 
@@ -70,6 +70,7 @@ void Socket::set_setup_state(SetupState new_setup_state)
 #endif
 
     m_setup_state = new_setup_state;
+    evaluate_block_conditions();
 }
 
 RefPtr<Socket> Socket::accept()
@@ -82,10 +83,11 @@ RefPtr<Socket> Socket::accept()
 #endif
     auto client = m_pending.take_first();
     ASSERT(!client->is_connected());
-    auto& process = *Process::current;
+    auto& process = *Process::current();
     client->m_acceptor = { process.pid(), process.uid(), process.gid() };
     client->m_connected = true;
     client->m_role = Role::Accepted;
+    client->evaluate_block_conditions();
     return client;
 }
 
@@ -98,12 +100,14 @@ KResult Socket::queue_connection_from(NonnullRefPtr<Socket> peer)
     if (m_pending.size() >= m_backlog)
         return KResult(-ECONNREFUSED);
     m_pending.append(peer);
+    evaluate_block_conditions();
     return KSuccess;
 }
 
 KResult Socket::setsockopt(int level, int option, const void* value, socklen_t value_size)
 {
-    ASSERT(level == SOL_SOCKET);
+    if (level != SOL_SOCKET)
+        return KResult(-ENOPROTOOPT);
     switch (option) {
     case SO_SNDTIMEO:
         if (value_size != sizeof(timeval))
@@ -128,6 +132,11 @@ KResult Socket::setsockopt(int level, int option, const void* value, socklen_t v
     case SO_KEEPALIVE:
         // FIXME: Obviously, this is not a real keepalive.
         return KSuccess;
+    case SO_REUSEPORT:
+        if (value_size != sizeof(int))
+            return KResult(-EINVAL);
+        m_reuse_port = *(const int*)value != 0;
+        return KSuccess;
     default:
         dbg() << "setsockopt(" << option << ") at SOL_SOCKET not implemented.";
         return KResult(-ENOPROTOOPT);
@@ -136,7 +145,8 @@ KResult Socket::setsockopt(int level, int option, const void* value, socklen_t v
 
 KResult Socket::getsockopt(FileDescription&, int level, int option, void* value, socklen_t* value_size)
 {
-    ASSERT(level == SOL_SOCKET);
+    if (level != SOL_SOCKET)
+        return KResult(-ENOPROTOOPT);
     switch (option) {
     case SO_SNDTIMEO:
         if (*value_size < sizeof(timeval))
@@ -170,6 +180,12 @@ KResult Socket::getsockopt(FileDescription&, int level, int option, void* value,
             *value_size = 0;
             return KResult(-EFAULT);
         }
+    case SO_REUSEPORT:
+        if (*value_size < sizeof(int))
+            return KResult(-EINVAL);
+        *(int*)value = m_reuse_port;
+        *value_size = sizeof(int);
+        return KSuccess;
     default:
         dbg() << "getsockopt(" << option << ") at SOL_SOCKET not implemented.";
         return KResult(-ENOPROTOOPT);
@@ -202,6 +218,7 @@ KResult Socket::shutdown(int how)
         shut_down_for_reading();
     m_shut_down_for_reading |= (how & SHUT_RD) != 0;
     m_shut_down_for_writing |= (how & SHUT_WR) != 0;
+    evaluate_block_conditions();
     return KSuccess;
 }
 
@@ -91,7 +91,11 @@ public:
     virtual Role role(const FileDescription&) const { return m_role; }
 
     bool is_connected() const { return m_connected; }
-    void set_connected(bool connected) { m_connected = connected; }
+    void set_connected(bool connected)
+    {
+        m_connected = connected;
+        evaluate_block_conditions();
+    }
 
     bool can_accept() const { return !m_pending.is_empty(); }
     RefPtr<Socket> accept();
@@ -120,6 +124,7 @@ public:
     uid_t acceptor_uid() const { return m_acceptor.uid; }
     gid_t acceptor_gid() const { return m_acceptor.gid; }
     const RefPtr<NetworkAdapter> bound_interface() const { return m_bound_interface; }
+    bool reuse_port() const { return m_reuse_port; }
 
     Lock& lock() { return m_lock; }
 
@@ -139,8 +144,12 @@ protected:
 
     KResult queue_connection_from(NonnullRefPtr<Socket>);
 
+    // Like SOMAXCONN in userspace; listen() asks for a backlog, this is what it gets at most.
+    static constexpr size_t max_backlog = 128;
+
     size_t backlog() const { return m_backlog; }
-    void set_backlog(size_t backlog) { m_backlog = backlog; }
+    void set_backlog(size_t backlog) { m_backlog = max((size_t)1, min(backlog, max_backlog)); }
+    size_t pending_connection_count() const { return m_pending.size(); }
 
     virtual const char* class_name() const override { return "Socket"; }
 
@@ -166,6 +175,7 @@ private:
     bool m_connected { false };
     bool m_shut_down_for_reading { false };
     bool m_shut_down_for_writing { false };
+    bool m_reuse_port { false };
 
     RefPtr<NetworkAdapter> m_bound_interface { nullptr };
 
@@ -0,0 +1,140 @@
+/*
+ * Copyright (c) 2018-2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/Function.h>
+#include <AK/HashMap.h>
+#include <AK/RefPtr.h>
+#include <AK/Vector.h>
+#include <Kernel/Lock.h>
+
+namespace Kernel {
+
+// SocketTable: The sockets that incoming packets are demultiplexed to.
+//
+// The table is split into stripes that each have their own lock, picked by the hash of the
+// key. Lookups only take their stripe's lock in shared mode, so packets for different
+// connections don't wait for each other, and neither waits for unrelated connects or closes.
+//
+// Sockets remove themselves from the table when they're destroyed, so the table holds
+// plain pointers and hands out RefPtrs.
+//
+// Sockets that have SO_REUSEPORT set can share a key with other such sockets from the
+// same user. Lookups that pass a flow hash then spread the flows across the group.
+
+template<typename K, typename T>
+class SocketTable {
+public:
+    RefPtr<T> get(const K& key)
+    {
+        return get(key, 0);
+    }
+
+    // Picks one socket out of a SO_REUSEPORT group. The same flow hash always gets the
+    // same socket for as long as the group doesn't change.
+    RefPtr<T> get(const K& key, u32 flow_hash)
+    {
+        auto& stripe = stripe_for(key);
+        LOCKER(stripe.lock, Lock::Mode::Shared);
+        auto it = stripe.sockets.find(key);
+        if (it == stripe.sockets.end())
+            return nullptr;
+        auto& group = (*it).value;
+        return group[flow_hash % group.size()];
+    }
+
+    bool contains(const K& key)
+    {
+        auto& stripe = stripe_for(key);
+        LOCKER(stripe.lock, Lock::Mode::Shared);
+        return stripe.sockets.contains(key);
+    }
+
+    // Returns false (and leaves the table alone) if there's a socket with this key already,
+    // unless it's a SO_REUSEPORT group that this socket is allowed to join.
+    bool add(const K& key, T& socket)
+    {
+        auto& stripe = stripe_for(key);
+        LOCKER(stripe.lock);
+        auto it = stripe.sockets.find(key);
+        if (it == stripe.sockets.end()) {
+            Vector<T*, 1> group;
+            group.append(&socket);
+            stripe.sockets.set(key, move(group));
+            return true;
+        }
+        auto& group = (*it).value;
+        if (!socket.reuse_port())
+            return false;
+        for (auto* member : group) {
+            if (member == &socket || !member->reuse_port() || member->origin_uid() != socket.origin_uid())
+                return false;
+        }
+        group.append(&socket);
+        return true;
+    }
+
+    // Only removes the entry if it belongs to this socket.
+    void remove(const K& key, T& socket)
+    {
+        auto& stripe = stripe_for(key);
+        LOCKER(stripe.lock);
+        auto it = stripe.sockets.find(key);
+        if (it == stripe.sockets.end())
+            return;
+        auto& group = (*it).value;
+        group.remove_first_matching([&](auto* member) { return member == &socket; });
+        if (group.is_empty())
+            stripe.sockets.remove(it);
+    }
+
+    // This locks one stripe at a time, so it doesn't see a snapshot of the whole table.
+    void for_each(Function<void(T&)> callback)
+    {
+        for (auto& stripe : m_stripes) {
+            LOCKER(stripe.lock, Lock::Mode::Shared);
+            for (auto& it : stripe.sockets) {
+                for (auto* socket : it.value)
+                    callback(*socket);
+            }
+        }
+    }
+
+private:
+    static constexpr size_t stripe_count = 32;
+
+    struct Stripe {
+        Lock lock { "SocketTable" };
+        HashMap<K, Vector<T*, 1>> sockets;
+    };
+
+    Stripe& stripe_for(const K& key) { return m_stripes[Traits<K>::hash(key) % stripe_count]; }
+
+    Stripe m_stripes[stripe_count];
+};
+
+}
@@ -28,6 +28,7 @@
 #include <Kernel/Devices/RandomDevice.h>
 #include <Kernel/FileSystem/FileDescription.h>
 #include <Kernel/Net/NetworkAdapter.h>
+#include <Kernel/Net/NetworkStatistics.h>
 #include <Kernel/Net/Routing.h>
 #include <Kernel/Net/TCP.h>
 #include <Kernel/Net/TCPSocket.h>
@@ -38,11 +39,12 @@
 
 namespace Kernel {
 
+DEFINE_OBJECT_CACHE(TCPSocket);
+
 void TCPSocket::for_each(Function<void(const TCPSocket&)> callback)
 {
-    LOCKER(sockets_by_tuple().lock(), Lock::Mode::Shared);
-    for (auto& it : sockets_by_tuple().resource())
-        callback(*it.value);
+    listening_sockets().for_each([&](auto& socket) { callback(socket); });
+    established_sockets().for_each([&](auto& socket) { callback(socket); });
 }
 
 void TCPSocket::set_state(State new_state)
@@ -56,6 +58,9 @@ void TCPSocket::set_state(State new_state)
     if (new_state == State::Established && m_direction == Direction::Outgoing)
         m_role = Role::Connected;
 
+    evaluate_block_conditions();
+
+    // NOTE: This may drop the last reference to us.
     if (new_state == State::Closed) {
         LOCKER(closing_sockets().lock());
         closing_sockets().resource().remove(tuple());
@@ -70,33 +75,36 @@ Lockable<HashMap<IPv4SocketTuple, RefPtr<TCPSocket>>>& TCPSocket::closing_socket
     return *s_map;
 }
 
-Lockable<HashMap<IPv4SocketTuple, TCPSocket*>>& TCPSocket::sockets_by_tuple()
+SocketTable<IPv4SocketTuple, TCPSocket>& TCPSocket::listening_sockets()
 {
-    static Lockable<HashMap<IPv4SocketTuple, TCPSocket*>>* s_map;
-    if (!s_map)
-        s_map = new Lockable<HashMap<IPv4SocketTuple, TCPSocket*>>;
-    return *s_map;
+    static SocketTable<IPv4SocketTuple, TCPSocket>* s_table;
+    if (!s_table)
+        s_table = new SocketTable<IPv4SocketTuple, TCPSocket>;
+    return *s_table;
+}
+
+SocketTable<IPv4SocketTuple, TCPSocket>& TCPSocket::established_sockets()
+{
+    static SocketTable<IPv4SocketTuple, TCPSocket>* s_table;
+    if (!s_table)
+        s_table = new SocketTable<IPv4SocketTuple, TCPSocket>;
+    return *s_table;
 }
 
 RefPtr<TCPSocket> TCPSocket::from_tuple(const IPv4SocketTuple& tuple)
 {
-    LOCKER(sockets_by_tuple().lock(), Lock::Mode::Shared);
+    if (auto exact_match = established_sockets().get(tuple))
+        return exact_match;
 
-    auto exact_match = sockets_by_tuple().resource().get(tuple);
-    if (exact_match.has_value())
-        return { *exact_match.value() };
+    // New connections are spread across a SO_REUSEPORT group by the hash of their tuple.
+    auto flow_hash = Traits<IPv4SocketTuple>::hash(tuple);
 
     auto address_tuple = IPv4SocketTuple(tuple.local_address(), tuple.local_port(), IPv4Address(), 0);
-    auto address_match = sockets_by_tuple().resource().get(address_tuple);
-    if (address_match.has_value())
-        return { *address_match.value() };
+    if (auto address_match = listening_sockets().get(address_tuple, flow_hash))
+        return address_match;
 
     auto wildcard_tuple = IPv4SocketTuple(IPv4Address(), tuple.local_port(), IPv4Address(), 0);
-    auto wildcard_match = sockets_by_tuple().resource().get(wildcard_tuple);
-    if (wildcard_match.has_value())
-        return { *wildcard_match.value() };
-
-    return {};
+    return listening_sockets().get(wildcard_tuple, flow_hash);
 }
 
 RefPtr<TCPSocket> TCPSocket::from_endpoints(const IPv4Address& local_address, u16 local_port, const IPv4Address& peer_address, u16 peer_port)
@@ -107,10 +115,14 @@ RefPtr<TCPSocket> TCPSocket::from_endpoints(const IPv4Address& local_address, u1
 RefPtr<TCPSocket> TCPSocket::create_client(const IPv4Address& new_local_address, u16 new_local_port, const IPv4Address& new_peer_address, u16 new_peer_port)
 {
     auto tuple = IPv4SocketTuple(new_local_address, new_local_port, new_peer_address, new_peer_port);
+    if (established_sockets().contains(tuple))
+        return {};
 
-    LOCKER(sockets_by_tuple().lock());
-    if (sockets_by_tuple().resource().contains(tuple))
+    // Half-open connections count against the backlog too, so a SYN flood can't pile them up.
+    if (pending_connection_count() + m_pending_release_for_accept.size() >= backlog()) {
+        network_statistics().tcp.listen_drops++;
         return {};
+    }
 
     auto client = TCPSocket::create(protocol());
 
@@ -122,10 +134,13 @@ RefPtr<TCPSocket> TCPSocket::create_client(const IPv4Address& new_local_address,
     client->set_direction(Direction::Incoming);
     client->set_originator(*this);
 
+    // Someone else may have gotten there while we were setting up.
+    if (!established_sockets().add(tuple, *client))
+        return {};
     m_pending_release_for_accept.set(tuple, client);
-    sockets_by_tuple().resource().set(tuple, client);
+    network_statistics().tcp.passive_opens++;
 
-    return from_tuple(tuple);
+    return client;
 }
 
 void TCPSocket::release_to_originator()
@@ -148,8 +163,8 @@ TCPSocket::TCPSocket(int protocol)
 
 TCPSocket::~TCPSocket()
 {
-    LOCKER(sockets_by_tuple().lock());
-    sockets_by_tuple().resource().remove(tuple());
+    listening_sockets().remove(tuple(), *this);
+    established_sockets().remove(tuple(), *this);
 
 #ifdef TCP_SOCKET_DEBUG
     dbg() << "~TCPSocket in state " << to_string(state());
@@ -161,144 +176,801 @@ NonnullRefPtr<TCPSocket> TCPSocket::create(int protocol)
     return adopt(*new TCPSocket(protocol));
 }
 
-int TCPSocket::protocol_receive(const KBuffer& packet_buffer, void* buffer, size_t buffer_size, int flags)
+size_t TCPSocket::protocol_payload_offset(const PacketBuffer& packet_buffer) const
 {
-    (void)flags;
     auto& ipv4_packet = *(const IPv4Packet*)(packet_buffer.data());
     auto& tcp_packet = *static_cast<const TCPPacket*>(ipv4_packet.payload());
-    size_t payload_size = packet_buffer.size() - sizeof(IPv4Packet) - tcp_packet.header_size();
-#ifdef TCP_SOCKET_DEBUG
-    klog() << "payload_size " << payload_size << ", will it fit in " << buffer_size << "?";
-#endif
-    ASSERT(buffer_size >= payload_size);
-    memcpy(buffer, tcp_packet.payload(), payload_size);
-    return payload_size;
+    return sizeof(IPv4Packet) + tcp_packet.header_size();
+}
+
+// How much data we're willing to queue up for a peer that hasn't acknowledged it yet.
+static constexpr size_t send_buffer_size = 256 * KB;
+
+static constexpr u32 minimum_retransmission_timeout_ms = 200;
+static constexpr u32 maximum_retransmission_timeout_ms = 60 * 1000;
+
+// Sequence numbers wrap around, so compare them by their distance instead.
+static inline bool sequence_less_than(u32 a, u32 b) { return (i32)(a - b) < 0; }
+static inline bool sequence_less_than_or_equal(u32 a, u32 b) { return (i32)(a - b) <= 0; }
+
+static u32 milliseconds_between(const timeval& earlier, const timeval& later)
+{
+    timeval diff;
+    timeval_sub(later, earlier, diff);
+    if (diff.tv_sec < 0)
+        return 0;
+    return diff.tv_sec * 1000 + diff.tv_usec / 1000;
+}
+
+static void add_milliseconds(const timeval& time, u32 ms, timeval& result)
+{
+    timeval delta { (time_t)(ms / 1000), (suseconds_t)((ms % 1000) * 1000) };
+    timeval_add(time, delta, result);
+}
+
+bool TCPSocket::can_write(const FileDescription& description, size_t size) const
+{
+    return IPv4Socket::can_write(description, size) && m_queued_bytes + m_unsent_size < send_buffer_size;
 }
 
 int TCPSocket::protocol_send(const void* data, size_t data_length)
 {
-    send_tcp_packet(TCPFlags::PUSH | TCPFlags::ACK, data, data_length);
-    return data_length;
+    LOCKER(m_not_acked_lock);
+    // Never refuse a whole segment, callers that got here have already seen can_write().
+    size_t queued_bytes = m_queued_bytes + m_unsent_size;
+    size_t space = queued_bytes < send_buffer_size ? send_buffer_size - queued_bytes : 0;
+    size_t to_send = min(data_length, max(space, m_maximum_segment_size));
+
+    if (m_unsent_data.size() < m_maximum_segment_size)
+        m_unsent_data.grow(m_maximum_segment_size);
+
+    auto* bytes = (const u8*)data;
+    size_t offset = 0;
+    if (m_unsent_size) {
+        // Top up the partial segment from earlier writes first.
+        if (m_unsent_size < m_maximum_segment_size) {
+            size_t chunk_size = min(to_send, m_maximum_segment_size - m_unsent_size);
+            memcpy(m_unsent_data.data() + m_unsent_size, bytes, chunk_size);
+            m_unsent_size += chunk_size;
+            offset = chunk_size;
+        }
+        if (m_unsent_size >= m_maximum_segment_size)
+            send_unsent_data();
+    }
+
+    for (; to_send - offset >= m_maximum_segment_size; offset += m_maximum_segment_size)
+        send_tcp_packet(TCPFlags::PUSH | TCPFlags::ACK, bytes + offset, m_maximum_segment_size);
+
+    if (offset < to_send) {
+        if (!m_unsent_size)
+            m_unsent_since = kgettimeofday();
+        memcpy(m_unsent_data.data() + m_unsent_size, bytes + offset, to_send - offset);
+        m_unsent_size += to_send - offset;
+    }
+
+    if (m_unsent_size && may_send_partial_segment())
+        send_unsent_data();
+    return to_send;
+}
+
+bool TCPSocket::may_send_partial_segment() const
+{
+    if (m_corked)
+        return false;
+    // RFC 1122, section 4.2.3.4: Hold back small segments while there's unacknowledged data.
+    return m_no_delay || m_not_acked.is_empty();
+}
+
+void TCPSocket::send_unsent_data()
+{
+    LOCKER(m_not_acked_lock);
+    // This is less than a segment, unless the path MTU shrank since it was written.
+    for (size_t offset = 0; offset < m_unsent_size;) {
+        size_t segment_size = min(m_unsent_size - offset, m_maximum_segment_size);
+        send_tcp_packet(TCPFlags::PUSH | TCPFlags::ACK, m_unsent_data.data() + offset, segment_size);
+        offset += segment_size;
+    }
+    m_unsent_size = 0;
+}
+
+// Like Linux, we don't let a forgotten TCP_CORK hold data back forever.
+static constexpr u32 cork_timeout_ms = 200;
+
+void TCPSocket::send_unsent_data_if_cork_expired(const timeval& now)
+{
+    LOCKER(m_not_acked_lock);
+    if (!m_unsent_size || !m_corked)
+        return;
+    if (milliseconds_between(m_unsent_since, now) >= cork_timeout_ms)
+        send_unsent_data();
+}
+
+u16 TCPSocket::advertised_window() const
+{
+    return min(receive_buffer_space(), (size_t)0xffff);
+}
+
+size_t TCPSocket::local_maximum_segment_size() const
+{
+    // Keep segments well below our receive buffer, or the loopback adapter's huge MTU
+    // would give us segments that could never fit in the window.
+    static constexpr size_t maximum_segment_size_limit = 16 * KB;
+    auto routing_decision = route_to(peer_address(), local_address(), bound_interface());
+    if (routing_decision.is_zero())
+        return 536;
+    auto path_mtu = path_mtu_to(peer_address(), routing_decision.adapter->mtu());
+    return min(path_mtu - sizeof(IPv4Packet) - sizeof(TCPPacket), maximum_segment_size_limit);
+}
+
+void TCPSocket::protocol_did_drain_receive_buffer()
+{
+    // Tell the peer once the window has opened up again (avoiding silly window syndrome,
+    // RFC 1122 section 4.2.3.3), since it might be waiting for that.
+    if (m_state != State::Established || m_last_advertised_window >= m_maximum_segment_size)
+        return;
+    if (advertised_window() >= 2 * m_maximum_segment_size)
+        send_tcp_packet(TCPFlags::ACK);
+}
+
+size_t TCPSocket::options_for_syn(u8* options, bool is_syn_ack) const
+{
+    size_t offset = 0;
+    options[offset++] = TCPOptionKind::MaximumSegmentSize;
+    options[offset++] = 4;
+    size_t maximum_segment_size = local_maximum_segment_size();
+    options[offset++] = maximum_segment_size >> 8;
+    options[offset++] = maximum_segment_size & 0xff;
+
+    // We only answer with the options the peer offered, as RFC 7323 and RFC 2018 require.
+    if (!is_syn_ack || m_peer_sent_window_scale) {
+        // Our receive buffer never exceeds 64 KiB, so we don't scale our own window.
+        options[offset++] = TCPOptionKind::NoOperation;
+        options[offset++] = TCPOptionKind::WindowScale;
+        options[offset++] = 3;
+        options[offset++] = 0;
+    }
+    if (!is_syn_ack || m_sack_permitted) {
+        options[offset++] = TCPOptionKind::NoOperation;
+        options[offset++] = TCPOptionKind::NoOperation;
+        options[offset++] = TCPOptionKind::SACKPermitted;
+        options[offset++] = 2;
+    }
+    ASSERT(offset % sizeof(u32) == 0);
+    return offset;
+}
+
+void TCPSocket::apply_syn_options(const TCPPacket& packet)
+{
+    m_peer_sent_window_scale = false;
+    m_sack_permitted = false;
+
+    auto* options = packet.options();
+    size_t options_size = packet.options_size();
+    for (size_t offset = 0; offset < options_size;) {
+        u8 kind = options[offset];
+        if (kind == TCPOptionKind::End)
+            break;
+        if (kind == TCPOptionKind::NoOperation) {
+            ++offset;
+            continue;
+        }
+        if (offset + 1 >= options_size)
+            break;
+        u8 length = options[offset + 1];
+        if (length < 2 || offset + length > options_size)
+            break;
+        switch (kind) {
+        case TCPOptionKind::MaximumSegmentSize:
+            if (length == 4)
+                m_peer_maximum_segment_size = (options[offset + 2] << 8) | options[offset + 3];
+            break;
+        case TCPOptionKind::WindowScale:
+            if (length == 3) {
+                m_peer_sent_window_scale = true;
+                m_peer_window_scale = min(options[offset + 2], (u8)14);
+            }
+            break;
+        case TCPOptionKind::SACKPermitted:
+            m_sack_permitted = true;
+            break;
+        }
+        offset += length;
+    }
+
+    // The peer's scale only applies if we both sent the option. For outgoing connections we
+    // always do, and incoming ones echo whatever the peer offered.
+    if (!m_peer_sent_window_scale)
+        m_peer_window_scale = 0;
+
+    m_maximum_segment_size = min(local_maximum_segment_size(), (size_t)max(m_peer_maximum_segment_size, (u16)64));
+
+    // Initial window from RFC 5681, section 3.1.
+    if (m_maximum_segment_size > 2190)
+        m_congestion_window = 2 * m_maximum_segment_size;
+    else if (m_maximum_segment_size > 1095)
+        m_congestion_window = 3 * m_maximum_segment_size;
+    else
+        m_congestion_window = 4 * m_maximum_segment_size;
+
+    // The window in a SYN is never scaled.
+    m_send_window = packet.window_size();
 }
 
 void TCPSocket::send_tcp_packet(u16 flags, const void* payload, size_t payload_size)
 {
-    auto buffer = ByteBuffer::create_zeroed(sizeof(TCPPacket) + payload_size);
+    // Until the peer's SYN tells us more, stick to one segment of the default size.
+    if ((flags & TCPFlags::SYN) && !m_congestion_window)
+        m_congestion_window = m_maximum_segment_size;
+    if (flags & TCPFlags::RST)
+        network_statistics().tcp.sent_resets++;
+
+    u8 options[20];
+    size_t options_size = 0;
+    if (flags & TCPFlags::SYN)
+        options_size = options_for_syn(options, flags & TCPFlags::ACK);
+
+    size_t header_size = sizeof(TCPPacket) + options_size;
+    auto buffer = ByteBuffer::create_zeroed(header_size + payload_size);
     auto& tcp_packet = *(TCPPacket*)(buffer.data());
     ASSERT(local_port());
     tcp_packet.set_source_port(local_port());
     tcp_packet.set_destination_port(peer_port());
-    tcp_packet.set_window_size(1024);
-    tcp_packet.set_sequence_number(m_sequence_number);
-    tcp_packet.set_data_offset(sizeof(TCPPacket) / sizeof(u32));
+    tcp_packet.set_data_offset(header_size / sizeof(u32));
     tcp_packet.set_flags(flags);
-
-    if (flags & TCPFlags::ACK)
-        tcp_packet.set_ack_number(m_ack_number);
-
-    if (flags & TCPFlags::SYN) {
-        ++m_sequence_number;
-    } else {
-        m_sequence_number += payload_size;
-    }
-
+    memcpy(tcp_packet.options(), options, options_size);
     memcpy(tcp_packet.payload(), payload, payload_size);
-    tcp_packet.set_checksum(compute_tcp_checksum(local_address(), peer_address(), tcp_packet, payload_size));
 
-    if (tcp_packet.has_syn() || payload_size > 0) {
+    u32 sequence_length = payload_size;
+    if (flags & (TCPFlags::SYN | TCPFlags::FIN))
+        ++sequence_length;
+
+    if (sequence_length) {
+        // Anything that takes up sequence space has to be reliable, so it goes through the queue.
         LOCKER(m_not_acked_lock);
-        m_not_acked.append({ m_sequence_number, move(buffer) });
+        tcp_packet.set_sequence_number(m_sequence_number);
+        m_sequence_number += sequence_length;
+        m_queued_bytes += payload_size;
+        m_not_acked.append({ m_sequence_number - sequence_length, m_sequence_number, move(buffer), payload_size });
         send_outgoing_packets();
         return;
     }
 
+    tcp_packet.set_sequence_number(m_send_next);
+    OutgoingPacket packet { m_send_next, m_send_next, move(buffer), 0 };
+    transmit(packet);
+}
+
+void TCPSocket::transmit(OutgoingPacket& packet)
+{
     auto routing_decision = route_to(peer_address(), local_address(), bound_interface());
-    ASSERT(!routing_decision.is_zero());
+    if (routing_decision.is_zero())
+        return;
+
+    packet.tx_time = kgettimeofday();
+    packet.tx_counter++;
 
-    routing_decision.adapter->send_ipv4(
-        routing_decision.next_hop, peer_address(), IPv4Protocol::TCP,
-        buffer.data(), buffer.size(), ttl());
+#ifdef TCP_SOCKET_DEBUG
+    auto& tcp_packet = *(const TCPPacket*)(packet.buffer.data());
+    klog() << "sending tcp packet from " << local_address().to_string().characters() << ":" << local_port() << " to " << peer_address().to_string().characters() << ":" << peer_port() << " with (" << (tcp_packet.has_syn() ? "SYN " : "") << (tcp_packet.has_ack() ? "ACK " : "") << (tcp_packet.has_fin() ? "FIN " : "") << (tcp_packet.has_rst() ? "RST " : "") << ") seq_no=" << tcp_packet.sequence_number() << ", ack_no=" << m_ack_number << ", tx_counter=" << packet.tx_counter;
+#endif
+    send_to_adapter(*routing_decision.adapter, routing_decision.next_hop, packet.buffer, packet.payload_size);
 
     m_packets_out++;
+    m_bytes_out += packet.buffer.size();
+
+    bool is_retransmission = packet.tx_counter > 1;
+    network_statistics().tcp.sent_segments++;
+    if (is_retransmission)
+        network_statistics().tcp.retransmitted_segments++;
+    if (NetworkTrace::is_enabled())
+        trace(is_retransmission ? NetworkTraceEvent::Type::TCPRetransmit : NetworkTraceEvent::Type::TCPSend, *(const TCPPacket*)packet.buffer.data(), packet.payload_size, m_last_advertised_window);
+}
+
+void TCPSocket::transmit_super_segment(const Vector<OutgoingPacket*, 32>& packets)
+{
+    ASSERT(packets.size() > 1);
+    auto routing_decision = route_to(peer_address(), local_address(), bound_interface());
+    if (routing_decision.is_zero())
+        return;
+
+    // The queued segments are contiguous and carry the same header apart from their sequence
+    // numbers, so the first one's header (and its sequence number) is good for all of them.
+    auto& first_packet = *packets.first();
+    size_t header_size = first_packet.buffer.size() - first_packet.payload_size;
+    size_t payload_size = 0;
+    for (auto* packet : packets)
+        payload_size += packet->payload_size;
+
+    auto buffer = ByteBuffer::create_uninitialized(header_size + payload_size);
+    memcpy(buffer.data(), first_packet.buffer.data(), header_size);
+    size_t offset = header_size;
+    auto now = kgettimeofday();
+    for (auto* packet : packets) {
+        memcpy(buffer.data() + offset, packet->buffer.data() + header_size, packet->payload_size);
+        offset += packet->payload_size;
+        packet->tx_time = now;
+        packet->tx_counter++;
+    }
+
+#ifdef TCP_SOCKET_DEBUG
+    klog() << "sending tcp super-segment of " << packets.size() << " packets (" << payload_size << " bytes) from " << local_address().to_string().characters() << ":" << local_port() << " to " << peer_address().to_string().characters() << ":" << peer_port() << ", seq_no=" << first_packet.sequence_number;
+#endif
+    send_to_adapter(*routing_decision.adapter, routing_decision.next_hop, buffer, payload_size, m_maximum_segment_size);
+
+    m_packets_out += packets.size();
     m_bytes_out += buffer.size();
+
+    bool is_retransmission = false;
+    network_statistics().tcp.sent_segments += packets.size();
+    for (auto* packet : packets) {
+        if (packet->tx_counter > 1) {
+            network_statistics().tcp.retransmitted_segments++;
+            is_retransmission = true;
+        }
+    }
+    if (NetworkTrace::is_enabled())
+        trace(is_retransmission ? NetworkTraceEvent::Type::TCPRetransmit : NetworkTraceEvent::Type::TCPSend, *(const TCPPacket*)buffer.data(), payload_size, m_last_advertised_window);
+}
+
+void TCPSocket::send_to_adapter(NetworkAdapter& adapter, const MACAddress& next_hop, ByteBuffer& tcp_segment, size_t payload_size, u16 segment_size)
+{
+    // Queued and retransmitted segments should carry our current view of the connection.
+    auto& tcp_packet = *(TCPPacket*)(tcp_segment.data());
+    if (tcp_packet.has_ack())
+        tcp_packet.set_ack_number(m_ack_number);
+    m_last_advertised_window = advertised_window();
+    tcp_packet.set_window_size(m_last_advertised_window);
+
+    // Segments queued before the path MTU shrank are fragmented by the adapter, and the
+    // checksum has to be done before that.
+    bool will_be_fragmented = !segment_size && sizeof(IPv4Packet) + tcp_segment.size() > path_mtu_to(peer_address(), adapter.mtu());
+
+    TransmitOffload offload;
+    offload.tcp_segment_size = segment_size;
+    if (segment_size || (adapter.supports(NetworkAdapter::TCPChecksumOffload) && !will_be_fragmented)) {
+        // The adapter finishes the checksum. When it does the segmentation too, it works
+        // out the length of each segment itself, so the pseudo-header leaves it out.
+        offload.tcp_checksum = true;
+        u16 tcp_length = segment_size ? 0 : tcp_packet.header_size() + payload_size;
+        tcp_packet.set_checksum(compute_tcp_pseudo_header_checksum(local_address(), peer_address(), tcp_length));
+    } else {
+        tcp_packet.set_checksum(0);
+        tcp_packet.set_checksum(compute_tcp_checksum(local_address(), peer_address(), tcp_packet, payload_size));
+    }
+
+    adapter.send_ipv4(next_hop, peer_address(), IPv4Protocol::TCP, tcp_segment.data(), tcp_segment.size(), ttl(), offload);
+}
+
+// The largest super-segment we hand to an adapter that does TCP segmentation offload.
+static constexpr size_t maximum_super_segment_size = 64 * KB;
+
+static bool can_be_part_of_super_segment(const ByteBuffer& buffer, size_t payload_size)
+{
+    auto& tcp_packet = *(const TCPPacket*)buffer.data();
+    return payload_size && tcp_packet.flags() == (TCPFlags::PUSH | TCPFlags::ACK) && tcp_packet.header_size() == sizeof(TCPPacket);
 }
 
 void TCPSocket::send_outgoing_packets()
 {
+    LOCKER(m_not_acked_lock);
+    u32 window = min(m_congestion_window, m_send_window);
+
     auto routing_decision = route_to(peer_address(), local_address(), bound_interface());
-    ASSERT(!routing_decision.is_zero());
+    bool can_offload_segmentation = !routing_decision.is_zero() && routing_decision.adapter->supports(NetworkAdapter::TCPSegmentationOffload);
+
+    // With segmentation offload, runs of data segments go down to the adapter in one piece.
+    Vector<OutgoingPacket*, 32> super_segment;
+    size_t super_segment_size = 0;
+
+    auto did_send_up_to = [&](u32 end) {
+        m_send_next = end;
+        if (sequence_less_than(m_send_max, m_send_next))
+            m_send_max = m_send_next;
+        if (!m_retransmission_timer_running)
+            restart_retransmission_timer();
+    };
 
-    auto now = kgettimeofday();
+    auto flush_super_segment = [&] {
+        if (super_segment.is_empty())
+            return;
+        if (super_segment.size() == 1)
+            transmit(*super_segment.first());
+        else
+            transmit_super_segment(super_segment);
+        did_send_up_to(super_segment.last()->ack_number);
+        super_segment.clear_with_capacity();
+        super_segment_size = 0;
+    };
 
-    LOCKER(m_not_acked_lock, Lock::Mode::Shared);
     for (auto& packet : m_not_acked) {
-        timeval diff;
-        timeval_sub(packet.tx_time, now, diff);
-        if (diff.tv_sec == 0 && diff.tv_usec <= 500000)
+        if (sequence_less_than(packet.sequence_number, m_send_next))
             continue;
-        packet.tx_time = now;
-        packet.tx_counter++;
-
-#ifdef TCP_SOCKET_DEBUG
-        auto& tcp_packet = *(TCPPacket*)(packet.buffer.data());
-        klog() << "sending tcp packet from " << local_address().to_string().characters() << ":" << local_port() << " to " << peer_address().to_string().characters() << ":" << peer_port() << " with (" << (tcp_packet.has_syn() ? "SYN " : "") << (tcp_packet.has_ack() ? "ACK " : "") << (tcp_packet.has_fin() ? "FIN " : "") << (tcp_packet.has_rst() ? "RST " : "") << ") seq_no=" << tcp_packet.sequence_number() << ", ack_no=" << tcp_packet.ack_number() << ", tx_counter=" << packet.tx_counter;
-#endif
-        routing_decision.adapter->send_ipv4(
-            routing_decision.next_hop, peer_address(), IPv4Protocol::TCP,
-            packet.buffer.data(), packet.buffer.size(), ttl());
+        u32 end = packet.ack_number;
+        // With nothing in flight, we send one segment regardless, which doubles as a zero window probe.
+        bool nothing_in_flight = m_send_next == m_send_unacknowledged && super_segment.is_empty();
+        if (!nothing_in_flight && end - m_send_unacknowledged > window)
+            break;
+        if (packet.tx_counter)
+            ++m_retransmissions;
+
+        if (can_offload_segmentation && can_be_part_of_super_segment(packet.buffer, packet.payload_size)) {
+            bool extends_super_segment = !super_segment.is_empty()
+                && super_segment.last()->ack_number == packet.sequence_number
+                && super_segment_size + packet.payload_size <= maximum_super_segment_size;
+            if (!extends_super_segment)
+                flush_super_segment();
+            super_segment.append(&packet);
+            super_segment_size += packet.payload_size;
+            continue;
+        }
 
-        m_packets_out++;
-        m_bytes_out += packet.buffer.size();
+        flush_super_segment();
+        transmit(packet);
+        did_send_up_to(end);
     }
+    flush_super_segment();
 }
 
-void TCPSocket::receive_tcp_packet(const TCPPacket& packet, u16 size)
+void TCPSocket::restart_retransmission_timer()
 {
-    if (packet.has_ack()) {
-        u32 ack_number = packet.ack_number();
+    m_retransmission_timer_running = !m_not_acked.is_empty();
+    if (m_retransmission_timer_running)
+        add_milliseconds(kgettimeofday(), m_retransmission_timeout_ms, m_retransmission_deadline);
+}
 
-#ifdef TCP_SOCKET_DEBUG
-        dbg() << "TCPSocket: receive_tcp_packet: " << ack_number;
-#endif
+void TCPSocket::update_round_trip_time(u32 sample_ms)
+{
+    // RFC 6298, section 2.
+    if (!m_smoothed_rtt_ms) {
+        m_smoothed_rtt_ms = max(sample_ms, 1u);
+        m_rtt_variance_ms = sample_ms / 2;
+    } else {
+        u32 delta = m_smoothed_rtt_ms > sample_ms ? m_smoothed_rtt_ms - sample_ms : sample_ms - m_smoothed_rtt_ms;
+        m_rtt_variance_ms = (3 * m_rtt_variance_ms + delta) / 4;
+        m_smoothed_rtt_ms = max((7 * m_smoothed_rtt_ms + sample_ms) / 8, 1u);
+    }
+    // We use a lower minimum than the RFC's one second, like most stacks do.
+    u32 timeout = m_smoothed_rtt_ms + max(10u, 4 * m_rtt_variance_ms);
+    m_retransmission_timeout_ms = min(max(timeout, minimum_retransmission_timeout_ms), maximum_retransmission_timeout_ms);
+}
 
-        int removed = 0;
-        LOCKER(m_not_acked_lock);
-        while (!m_not_acked.is_empty()) {
-            auto& packet = m_not_acked.first();
+void TCPSocket::process_sack_blocks(const TCPPacket& packet)
+{
+    auto* options = packet.options();
+    size_t options_size = packet.options_size();
+    for (size_t offset = 0; offset < options_size;) {
+        u8 kind = options[offset];
+        if (kind == TCPOptionKind::End)
+            break;
+        if (kind == TCPOptionKind::NoOperation) {
+            ++offset;
+            continue;
+        }
+        if (offset + 1 >= options_size)
+            break;
+        u8 length = options[offset + 1];
+        if (length < 2 || offset + length > options_size)
+            break;
+        if (kind == TCPOptionKind::SACK) {
+            for (size_t block = offset + 2; block + 8 <= offset + length; block += 8) {
+                u32 left = *(const NetworkOrdered<u32>*)(options + block);
+                u32 right = *(const NetworkOrdered<u32>*)(options + block + 4);
+                for (auto& outgoing : m_not_acked) {
+                    if (sequence_less_than_or_equal(left, outgoing.sequence_number) && sequence_less_than_or_equal(outgoing.ack_number, right))
+                        outgoing.sacked = true;
+                }
+            }
+        }
+        offset += length;
+    }
+}
 
-#ifdef TCP_SOCKET_DEBUG
-            dbg() << "TCPSocket: iterate: " << packet.ack_number;
-#endif
+void TCPSocket::process_ack(const TCPPacket& packet, size_t payload_size)
+{
+    u32 ack_number = packet.ack_number();
+    u32 window = packet.window_size();
+    if (!packet.has_syn())
+        window <<= m_peer_window_scale;
 
-            if (packet.ack_number <= ack_number) {
-                m_not_acked.take_first();
-                removed++;
+    // Ignore ACKs for things we haven't sent.
+    if (sequence_less_than(m_send_max, ack_number))
+        return;
+
+    if (m_sack_permitted)
+        process_sack_blocks(packet);
+
+    if (sequence_less_than(m_send_unacknowledged, ack_number)) {
+        u32 acked_bytes = ack_number - m_send_unacknowledged;
+        Optional<u32> rtt_sample;
+        auto now = kgettimeofday();
+        while (!m_not_acked.is_empty() && sequence_less_than_or_equal(m_not_acked.first().ack_number, ack_number)) {
+            auto acked_packet = m_not_acked.take_first();
+            // Karn's algorithm: retransmitted segments don't give us a usable sample.
+            if (acked_packet.tx_counter == 1)
+                rtt_sample = milliseconds_between(acked_packet.tx_time, now);
+            m_queued_bytes -= acked_packet.payload_size;
+        }
+        if (rtt_sample.has_value())
+            update_round_trip_time(rtt_sample.value());
+
+        m_send_unacknowledged = ack_number;
+        if (sequence_less_than(m_send_next, ack_number))
+            m_send_next = ack_number;
+        m_send_window = window;
+        m_duplicate_ack_count = 0;
+
+        if (m_in_fast_recovery) {
+            if (sequence_less_than_or_equal(m_recovery_point, ack_number)) {
+                // Full acknowledgment, deflate the window (RFC 6582, section 3.2, step 3).
+                m_congestion_window = m_slow_start_threshold;
+                m_in_fast_recovery = false;
             } else {
+                // Partial acknowledgment: the next hole was lost as well, retransmit it right away.
+                for (auto& outgoing : m_not_acked) {
+                    if (outgoing.sacked)
+                        continue;
+                    ++m_retransmissions;
+                    transmit(outgoing);
+                    break;
+                }
+                m_congestion_window = (m_congestion_window > acked_bytes ? m_congestion_window - acked_bytes : 0) + m_maximum_segment_size;
+            }
+        } else if (m_congestion_window < m_slow_start_threshold) {
+            // Slow start.
+            m_congestion_window += min(acked_bytes, (u32)m_maximum_segment_size);
+        } else {
+            // Congestion avoidance, roughly one segment per round trip.
+            m_congestion_window += max(1u, (u32)(m_maximum_segment_size * m_maximum_segment_size / m_congestion_window));
+        }
+
+        restart_retransmission_timer();
+        evaluate_block_conditions();
+
+        // Everything we sent got through, so a held back partial segment can go now.
+        if (m_unsent_size && may_send_partial_segment())
+            send_unsent_data();
+    } else if (ack_number == m_send_unacknowledged && !payload_size && window == m_send_window && !packet.has_syn() && !packet.has_fin() && !m_not_acked.is_empty()) {
+        // A duplicate ACK as defined in RFC 5681, section 2.
+        ++m_duplicate_ack_count;
+        ++m_duplicate_acks;
+        if (m_duplicate_ack_count == 3 && !m_in_fast_recovery) {
+            // Fast retransmit.
+            ++m_fast_retransmits;
+            network_statistics().tcp.fast_retransmits++;
+            m_slow_start_threshold = max(flight_size() / 2, (u32)(2 * m_maximum_segment_size));
+            for (auto& outgoing : m_not_acked) {
+                if (outgoing.sacked)
+                    continue;
+                ++m_retransmissions;
+                transmit(outgoing);
                 break;
             }
+            m_congestion_window = m_slow_start_threshold + 3 * m_maximum_segment_size;
+            m_in_fast_recovery = true;
+            m_recovery_point = m_send_max;
+        } else if (m_in_fast_recovery) {
+            // Every further duplicate means another segment has left the network.
+            m_congestion_window += m_maximum_segment_size;
         }
+    } else {
+        m_send_window = window;
+    }
+
+    send_outgoing_packets();
+}
 
+void TCPSocket::retransmit_if_timed_out(const timeval& now)
+{
+    LOCKER(m_not_acked_lock);
+    if (!m_retransmission_timer_running || m_not_acked.is_empty())
+        return;
+    if (m_state == State::Closed) {
+        // Nobody is going to acknowledge these anymore.
+        m_not_acked.clear();
+        m_queued_bytes = 0;
+        m_retransmission_timer_running = false;
+        return;
+    }
+    auto& deadline = m_retransmission_deadline;
+    if (now.tv_sec < deadline.tv_sec || (now.tv_sec == deadline.tv_sec && now.tv_usec < deadline.tv_usec))
+        return;
+
+    ++m_timeouts;
+    network_statistics().tcp.timeouts++;
+
+    // RFC 5681, section 3.1, and RFC 6298, section 5.
+    if (m_send_max != m_send_unacknowledged)
+        m_slow_start_threshold = max(flight_size() / 2, (u32)(2 * m_maximum_segment_size));
+    m_congestion_window = m_maximum_segment_size;
+    m_duplicate_ack_count = 0;
+    m_in_fast_recovery = false;
+    m_retransmission_timeout_ms = min(m_retransmission_timeout_ms * 2, maximum_retransmission_timeout_ms);
+
+    // Go back to the first unacknowledged segment and let slow start resend the rest.
+    for (auto& outgoing : m_not_acked)
+        outgoing.sacked = false;
+    auto& first = m_not_acked.first();
+    ++m_retransmissions;
+    transmit(first);
+    m_send_next = first.ack_number;
+    add_milliseconds(now, m_retransmission_timeout_ms, m_retransmission_deadline);
+}
+
+void TCPSocket::run_timers()
+{
+    Vector<RefPtr<TCPSocket>> sockets;
+    established_sockets().for_each([&](auto& socket) {
+        if (socket.m_retransmission_timer_running || socket.m_unsent_size)
+            sockets.append(socket);
+    });
+
+    auto now = kgettimeofday();
+    for (auto& socket : sockets) {
+        socket->retransmit_if_timed_out(now);
+        socket->send_unsent_data_if_cork_expired(now);
+    }
+}
+
+void TCPSocket::did_shrink_path_mtu(const IPv4Address& peer_address, u32 path_mtu)
+{
+    Vector<RefPtr<TCPSocket>> sockets;
+    established_sockets().for_each([&](auto& socket) {
+        if (socket.peer_address() == peer_address)
+            sockets.append(socket);
+    });
+
+    size_t segment_size = path_mtu - sizeof(IPv4Packet) - sizeof(TCPPacket);
+    for (auto& socket : sockets) {
+        LOCKER(socket->m_not_acked_lock);
+        if (socket->m_maximum_segment_size <= segment_size)
+            continue;
+        socket->m_maximum_segment_size = segment_size;
+        // The segment that didn't fit was dropped, so resend it (fragmented, since it was
+        // built for the old size) instead of waiting for the retransmission timer.
+        if (socket->m_state != State::Closed && !socket->m_not_acked.is_empty()) {
+            ++socket->m_retransmissions;
+            socket->transmit(socket->m_not_acked.first());
+        }
+    }
+}
+
+void TCPSocket::receive_tcp_packet(const TCPPacket& packet, u16 size)
+{
+    if (packet.has_ack()) {
 #ifdef TCP_SOCKET_DEBUG
-        dbg() << "TCPSocket: receive_tcp_packet acknowledged " << removed << " packets";
+        dbg() << "TCPSocket: receive_tcp_packet: " << packet.ack_number();
 #endif
+        LOCKER(m_not_acked_lock);
+        process_ack(packet, size - packet.header_size());
     }
 
     m_packets_in++;
     m_bytes_in += packet.header_size() + size;
+
+    if (NetworkTrace::is_enabled())
+        trace(NetworkTraceEvent::Type::TCPReceive, packet, size - packet.header_size(), packet.window_size());
 }
 
-NetworkOrdered<u16> TCPSocket::compute_tcp_checksum(const IPv4Address& source, const IPv4Address& destination, const TCPPacket& packet, u16 payload_size)
+void TCPSocket::did_drop_out_of_order_segment(const TCPPacket& packet, size_t payload_size)
 {
-    struct [[gnu::packed]] PseudoHeader
-    {
-        IPv4Address source;
-        IPv4Address destination;
-        u8 zero;
-        u8 protocol;
-        NetworkOrdered<u16> payload_size;
-    };
+    ++m_out_of_order_segments;
+    network_statistics().tcp.out_of_order_segments++;
+    if (NetworkTrace::is_enabled())
+        trace(NetworkTraceEvent::Type::TCPOutOfOrder, packet, payload_size, packet.window_size());
+}
+
+void TCPSocket::did_drop_for_lack_of_buffer_space(const TCPPacket&, size_t)
+{
+    ++m_receive_buffer_drops;
+    network_statistics().tcp.receive_buffer_drops++;
+}
+
+void TCPSocket::trace(NetworkTraceEvent::Type type, const TCPPacket& packet, size_t payload_size, u32 window) const
+{
+    NetworkTraceEvent event;
+    event.type = type;
+    event.local_address = local_address();
+    event.local_port = local_port();
+    event.peer_address = peer_address();
+    event.peer_port = peer_port();
+    event.sequence_number = packet.sequence_number();
+    event.ack_number = packet.ack_number();
+    event.length = payload_size;
+    event.flags = packet.flags();
+    event.window = window;
+    event.congestion_window = m_congestion_window;
+    NetworkTrace::record(event);
+}
+
+tcp_info TCPSocket::info() const
+{
+    tcp_info info;
+    memset(&info, 0, sizeof(info));
+    info.tcpi_state = (u8)m_state;
+    info.tcpi_rto = m_retransmission_timeout_ms;
+    info.tcpi_rtt = m_smoothed_rtt_ms;
+    info.tcpi_rttvar = m_rtt_variance_ms;
+    info.tcpi_snd_mss = m_maximum_segment_size;
+    info.tcpi_snd_cwnd = m_congestion_window;
+    info.tcpi_snd_ssthresh = m_slow_start_threshold;
+    info.tcpi_snd_wnd = m_send_window;
+    info.tcpi_rcv_wnd = m_last_advertised_window;
+    info.tcpi_unacked = bytes_in_flight();
+    info.tcpi_total_retrans = m_retransmissions;
+    info.tcpi_timeouts = m_timeouts;
+    info.tcpi_fast_retrans = m_fast_retransmits;
+    info.tcpi_dup_acks = m_duplicate_acks;
+    info.tcpi_out_of_order = m_out_of_order_segments;
+    info.tcpi_rcv_drops = m_receive_buffer_drops;
+    info.tcpi_segs_in = m_packets_in;
+    info.tcpi_segs_out = m_packets_out;
+    info.tcpi_bytes_in = m_bytes_in;
+    info.tcpi_bytes_out = m_bytes_out;
+    return info;
+}
+
+KResult TCPSocket::setsockopt(int level, int option, const void* value, socklen_t value_size)
+{
+    if (level != IPPROTO_TCP)
+        return IPv4Socket::setsockopt(level, option, value, value_size);
+
+    switch (option) {
+    case TCP_NODELAY:
+    case TCP_CORK: {
+        if (value_size < sizeof(int))
+            return KResult(-EINVAL);
+        bool enabled = *(const int*)value;
+        LOCKER(m_not_acked_lock);
+        if (option == TCP_NODELAY)
+            m_no_delay = enabled;
+        else
+            m_corked = enabled;
+        // Turning on TCP_NODELAY or pulling the cork pushes out whatever was held back.
+        if (m_unsent_size && may_send_partial_segment())
+            send_unsent_data();
+        return KSuccess;
+    }
+    default:
+        return KResult(-ENOPROTOOPT);
+    }
+}
+
+KResult TCPSocket::getsockopt(FileDescription& description, int level, int option, void* value, socklen_t* value_size)
+{
+    if (level != IPPROTO_TCP)
+        return IPv4Socket::getsockopt(description, level, option, value, value_size);
+
+    switch (option) {
+    case TCP_NODELAY:
+    case TCP_CORK:
+        if (*value_size < sizeof(int))
+            return KResult(-EINVAL);
+        *(int*)value = option == TCP_NODELAY ? m_no_delay : m_corked;
+        *value_size = sizeof(int);
+        return KSuccess;
+    case TCP_INFO:
+        if (*value_size < sizeof(tcp_info))
+            return KResult(-EINVAL);
+        *(tcp_info*)value = info();
+        *value_size = sizeof(tcp_info);
+        return KSuccess;
+    default:
+        return KResult(-ENOPROTOOPT);
+    }
+}
 
-    PseudoHeader pseudo_header { source, destination, 0, (u8)IPv4Protocol::TCP, sizeof(TCPPacket) + payload_size };
+struct [[gnu::packed]] TCPPseudoHeader
+{
+    IPv4Address source;
+    IPv4Address destination;
+    u8 zero;
+    u8 protocol;
+    NetworkOrdered<u16> tcp_length;
+};
+
+static u32 sum_tcp_pseudo_header(const IPv4Address& source, const IPv4Address& destination, u16 tcp_length)
+{
+    TCPPseudoHeader pseudo_header { source, destination, 0, (u8)IPv4Protocol::TCP, tcp_length };
 
     u32 checksum = 0;
     auto* w = (const NetworkOrdered<u16>*)&pseudo_header;
@@ -307,13 +979,24 @@ NetworkOrdered<u16> TCPSocket::compute_tcp_checksum(const IPv4Address& source, c
         if (checksum > 0xffff)
             checksum = (checksum >> 16) + (checksum & 0xffff);
     }
-    w = (const NetworkOrdered<u16>*)&packet;
-    for (size_t i = 0; i < sizeof(packet) / sizeof(u16); ++i) {
+    return checksum;
+}
+
+NetworkOrdered<u16> TCPSocket::compute_tcp_pseudo_header_checksum(const IPv4Address& source, const IPv4Address& destination, u16 tcp_length)
+{
+    // Unlike a finished checksum, this isn't inverted: the adapter adds the rest of the segment to it.
+    return sum_tcp_pseudo_header(source, destination, tcp_length);
+}
+
+NetworkOrdered<u16> TCPSocket::compute_tcp_checksum(const IPv4Address& source, const IPv4Address& destination, const TCPPacket& packet, u16 payload_size)
+{
+    u32 checksum = sum_tcp_pseudo_header(source, destination, packet.header_size() + payload_size);
+    auto* w = (const NetworkOrdered<u16>*)&packet;
+    for (size_t i = 0; i < packet.header_size() / sizeof(u16); ++i) {
         checksum += w[i];
         if (checksum > 0xffff)
             checksum = (checksum >> 16) + (checksum & 0xffff);
     }
-    ASSERT(packet.data_offset() * 4 == sizeof(TCPPacket));
     w = (const NetworkOrdered<u16>*)packet.payload();
     for (size_t i = 0; i < payload_size / sizeof(u16); ++i) {
         checksum += w[i];
@@ -342,10 +1025,11 @@ KResult TCPSocket::protocol_bind()
 
 KResult TCPSocket::protocol_listen()
 {
-    LOCKER(sockets_by_tuple().lock());
-    if (sockets_by_tuple().resource().contains(tuple()))
+    // Listening again only changes the backlog.
+    if (state() == State::Listen)
+        return KSuccess;
+    if (!listening_sockets().add(tuple(), *this))
         return KResult(-EADDRINUSE);
-    sockets_by_tuple().resource().set(tuple(), this);
     set_direction(Direction::Passive);
     set_state(State::Listen);
     set_setup_state(SetupState::Completed);
@@ -362,17 +1046,18 @@ KResult TCPSocket::protocol_connect(FileDescription& description, ShouldBlock sh
 
     allocate_local_port_if_needed();
 
-    m_sequence_number = get_good_random<u32>();
+    set_sequence_number(get_good_random<u32>());
     m_ack_number = 0;
 
     set_setup_state(SetupState::InProgress);
+    network_statistics().tcp.active_opens++;
     send_tcp_packet(TCPFlags::SYN);
     m_state = State::SynSent;
     m_role = Role::Connecting;
     m_direction = Direction::Outgoing;
 
     if (should_block == ShouldBlock::Yes) {
-        if (Thread::current->block<Thread::ConnectBlocker>(description) != Thread::BlockResult::WokeNormally)
+        if (Thread::current()->block<Thread::ConnectBlocker>(description) != Thread::BlockResult::WokeNormally)
             return KResult(-EINTR);
         ASSERT(setup_state() == SetupState::Completed);
         if (has_error()) {
@@ -392,14 +1077,10 @@ int TCPSocket::protocol_allocate_local_port()
     static const u16 ephemeral_port_range_size = last_ephemeral_port - first_ephemeral_port;
     u16 first_scan_port = first_ephemeral_port + get_good_random<u16>() % ephemeral_port_range_size;
 
-    LOCKER(sockets_by_tuple().lock());
     for (u16 port = first_scan_port;;) {
         IPv4SocketTuple proposed_tuple(local_address(), port, peer_address(), peer_port());
-
-        auto it = sockets_by_tuple().resource().find(proposed_tuple);
-        if (it == sockets_by_tuple().resource().end()) {
+        if (established_sockets().add(proposed_tuple, *this)) {
             set_local_port(port);
-            sockets_by_tuple().resource().set(proposed_tuple, this);
             return port;
         }
         ++port;
@@ -433,6 +1114,8 @@ void TCPSocket::shut_down_for_writing()
 #ifdef TCP_SOCKET_DEBUG
         dbg() << " Sending FIN/ACK from Established and moving into FinWait1";
 #endif
+        // Anything held back by Nagle's algorithm or TCP_CORK goes out before the FIN.
+        send_unsent_data();
         send_tcp_packet(TCPFlags::FIN | TCPFlags::ACK);
         set_state(State::FinWait1);
     } else {
@@ -447,6 +1130,8 @@ void TCPSocket::close()
 #ifdef TCP_SOCKET_DEBUG
         dbg() << " Sending FIN from CloseWait and moving into LastAck";
 #endif
+        // Anything held back by Nagle's algorithm or TCP_CORK goes out before the FIN.
+        send_unsent_data();
         send_tcp_packet(TCPFlags::FIN | TCPFlags::ACK);
         set_state(State::LastAck);
     }
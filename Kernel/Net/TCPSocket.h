@@ -30,12 +30,16 @@
 #include <AK/HashMap.h>
 #include <AK/SinglyLinkedList.h>
 #include <AK/WeakPtr.h>
+#include <Kernel/Heap/ObjectCache.h>
 #include <Kernel/Net/IPv4Socket.h>
+#include <Kernel/Net/NetworkTrace.h>
+#include <Kernel/Net/SocketTable.h>
 
 namespace Kernel {
 
 class TCPSocket final : public IPv4Socket
     , public Weakable<TCPSocket> {
+    MAKE_OBJECT_CACHED(TCPSocket)
 public:
     static void for_each(Function<void(const TCPSocket&)>);
     static NonnullRefPtr<TCPSocket> create(int protocol);
@@ -141,19 +145,57 @@ public:
     void set_error(Error error) { m_error = error; }
 
     void set_ack_number(u32 n) { m_ack_number = n; }
-    void set_sequence_number(u32 n) { m_sequence_number = n; }
+    void set_sequence_number(u32 n)
+    {
+        m_sequence_number = n;
+        m_send_unacknowledged = n;
+        m_send_next = n;
+        m_send_max = n;
+    }
     u32 ack_number() const { return m_ack_number; }
     u32 sequence_number() const { return m_sequence_number; }
     u32 packets_in() const { return m_packets_in; }
     u32 bytes_in() const { return m_bytes_in; }
     u32 packets_out() const { return m_packets_out; }
     u32 bytes_out() const { return m_bytes_out; }
+    u32 congestion_window() const { return m_congestion_window; }
+    u32 slow_start_threshold() const { return m_slow_start_threshold; }
+    u32 smoothed_round_trip_time_ms() const { return m_smoothed_rtt_ms; }
+    u32 retransmission_timeout_ms() const { return m_retransmission_timeout_ms; }
+    u32 retransmissions() const { return m_retransmissions; }
+    u32 timeouts() const { return m_timeouts; }
+    u32 fast_retransmits() const { return m_fast_retransmits; }
+    u32 duplicate_acks() const { return m_duplicate_acks; }
+    u32 out_of_order_segments() const { return m_out_of_order_segments; }
+    u32 receive_buffer_drops() const { return m_receive_buffer_drops; }
+    u32 send_window() const { return m_send_window; }
+    u32 bytes_in_flight() const { return m_send_next - m_send_unacknowledged; }
+    tcp_info info() const;
+
+    // The NetworkTask tells us about segments it couldn't take, for the counters and traces.
+    void did_drop_out_of_order_segment(const TCPPacket&, size_t payload_size);
+    void did_drop_for_lack_of_buffer_space(const TCPPacket&, size_t payload_size);
+
+    virtual KResult setsockopt(int level, int option, const void*, socklen_t) override;
+    virtual KResult getsockopt(FileDescription&, int level, int option, void*, socklen_t*) override;
 
     void send_tcp_packet(u16 flags, const void* = nullptr, size_t = 0);
     void send_outgoing_packets();
     void receive_tcp_packet(const TCPPacket&, u16 size);
 
-    static Lockable<HashMap<IPv4SocketTuple, TCPSocket*>>& sockets_by_tuple();
+    // Picks up the MSS, window scale and SACK options from the peer's SYN.
+    void apply_syn_options(const TCPPacket&);
+
+    // Called periodically by the NetworkTask to drive the retransmission and TCP_CORK timers.
+    static void run_timers();
+
+    // Called by the NetworkTask when a router tells us that packets to this peer are too big.
+    static void did_shrink_path_mtu(const IPv4Address& peer_address, u32 path_mtu);
+
+    // Sockets in the Listen state, by their local address and port (the peer is always zero),
+    // and everything else, by the full tuple.
+    static SocketTable<IPv4SocketTuple, TCPSocket>& listening_sockets();
+    static SocketTable<IPv4SocketTuple, TCPSocket>& established_sockets();
     static RefPtr<TCPSocket> from_tuple(const IPv4SocketTuple& tuple);
     static RefPtr<TCPSocket> from_endpoints(const IPv4Address& local_address, u16 local_port, const IPv4Address& peer_address, u16 peer_port);
 
@@ -167,6 +209,8 @@ public:
 
     virtual void close() override;
 
+    virtual bool can_write(const FileDescription&, size_t) const override;
+
 protected:
     void set_direction(Direction direction) { m_direction = direction; }
 
@@ -175,17 +219,46 @@ private:
     virtual const char* class_name() const override { return "TCPSocket"; }
 
     static NetworkOrdered<u16> compute_tcp_checksum(const IPv4Address& source, const IPv4Address& destination, const TCPPacket&, u16 payload_size);
+    static NetworkOrdered<u16> compute_tcp_pseudo_header_checksum(const IPv4Address& source, const IPv4Address& destination, u16 tcp_length);
 
     virtual void shut_down_for_writing() override;
 
-    virtual int protocol_receive(const KBuffer&, void* buffer, size_t buffer_size, int flags) override;
+    virtual size_t protocol_payload_offset(const PacketBuffer&) const override;
     virtual int protocol_send(const void*, size_t) override;
     virtual KResult protocol_connect(FileDescription&, ShouldBlock) override;
     virtual int protocol_allocate_local_port() override;
     virtual bool protocol_is_disconnected() const override;
+    virtual void protocol_did_drain_receive_buffer() override;
     virtual KResult protocol_bind() override;
     virtual KResult protocol_listen() override;
 
+    struct OutgoingPacket {
+        u32 sequence_number { 0 };
+        u32 ack_number { 0 };
+        ByteBuffer buffer;
+        size_t payload_size { 0 };
+        int tx_counter { 0 };
+        timeval tx_time { 0, 0 };
+        bool sacked { false };
+    };
+
+    void transmit(OutgoingPacket&);
+    void transmit_super_segment(const Vector<OutgoingPacket*, 32>&);
+    void send_to_adapter(NetworkAdapter&, const MACAddress& next_hop, ByteBuffer& tcp_segment, size_t payload_size, u16 segment_size = 0);
+    void retransmit_if_timed_out(const timeval& now);
+    bool may_send_partial_segment() const;
+    void send_unsent_data();
+    void send_unsent_data_if_cork_expired(const timeval& now);
+    void process_ack(const TCPPacket&, size_t payload_size);
+    void process_sack_blocks(const TCPPacket&);
+    void update_round_trip_time(u32 sample_ms);
+    void restart_retransmission_timer();
+    u32 flight_size() const { return m_send_max - m_send_unacknowledged; }
+    u16 advertised_window() const;
+    size_t local_maximum_segment_size() const;
+    size_t options_for_syn(u8* options, bool is_syn_ack) const;
+    void trace(NetworkTraceEvent::Type, const TCPPacket&, size_t payload_size, u32 window) const;
+
     WeakPtr<TCPSocket> m_originator;
     HashMap<IPv4SocketTuple, NonnullRefPtr<TCPSocket>> m_pending_release_for_accept;
     Direction m_direction { Direction::Unspecified };
@@ -198,13 +271,51 @@ private:
     u32 m_bytes_in { 0 };
     u32 m_packets_out { 0 };
     u32 m_bytes_out { 0 };
+    u32 m_retransmissions { 0 };
+    u32 m_timeouts { 0 };
+    u32 m_fast_retransmits { 0 };
+    u32 m_duplicate_acks { 0 };
+    u32 m_out_of_order_segments { 0 };
+    u32 m_receive_buffer_drops { 0 };
 
-    struct OutgoingPacket {
-        u32 ack_number { 0 };
-        ByteBuffer buffer;
-        int tx_counter { 0 };
-        timeval tx_time { 0, 0 };
-    };
+    // Sender state (RFC 793 names in the comments). m_sequence_number is where the next
+    // queued segment will start, which can be ahead of what the windows let us send yet.
+    u32 m_send_unacknowledged { 0 }; // SND.UNA
+    u32 m_send_next { 0 };           // SND.NXT
+    u32 m_send_max { 0 };            // Highest SND.NXT so far, this goes down on a timeout.
+    u32 m_send_window { 0 };         // SND.WND, already scaled.
+    u32 m_queued_bytes { 0 };
+
+    // Small writes are coalesced here (Nagle's algorithm, RFC 896) until they fill a segment,
+    // or until everything we sent has been acknowledged. TCP_NODELAY skips the wait, and
+    // TCP_CORK holds partial segments back for up to cork_timeout_ms.
+    ByteBuffer m_unsent_data;
+    size_t m_unsent_size { 0 };
+    timeval m_unsent_since { 0, 0 };
+    bool m_no_delay { false };
+    bool m_corked { false };
+
+    // Peer options, negotiated in the SYN exchange.
+    u16 m_peer_maximum_segment_size { 536 };
+    u8 m_peer_window_scale { 0 };
+    bool m_peer_sent_window_scale { false };
+    bool m_sack_permitted { false };
+    size_t m_maximum_segment_size { 536 };
+    u16 m_last_advertised_window { 0 };
+
+    // Congestion control (RFC 5681 with the NewReno recovery from RFC 6582).
+    u32 m_congestion_window { 0 };
+    u32 m_slow_start_threshold { 0xffffffff };
+    u32 m_duplicate_ack_count { 0 };
+    bool m_in_fast_recovery { false };
+    u32 m_recovery_point { 0 };
+
+    // Retransmission timer (RFC 6298).
+    u32 m_smoothed_rtt_ms { 0 };
+    u32 m_rtt_variance_ms { 0 };
+    u32 m_retransmission_timeout_ms { 1000 };
+    bool m_retransmission_timer_running { false };
+    timeval m_retransmission_deadline { 0, 0 };
 
     Lock m_not_acked_lock { "TCPSocket unacked packets" };
     SinglyLinkedList<OutgoingPacket> m_not_acked;
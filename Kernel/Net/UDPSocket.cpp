@@ -26,6 +26,8 @@
 
 #include <Kernel/Devices/RandomDevice.h>
 #include <Kernel/Net/NetworkAdapter.h>
+#include <Kernel/Net/NetworkStatistics.h>
+#include <Kernel/Net/NetworkTrace.h>
 #include <Kernel/Net/Routing.h>
 #include <Kernel/Net/UDP.h>
 #include <Kernel/Net/UDPSocket.h>
@@ -36,30 +38,22 @@ namespace Kernel {
 
 void UDPSocket::for_each(Function<void(const UDPSocket&)> callback)
 {
-    LOCKER(sockets_by_port().lock(), Lock::Mode::Shared);
-    for (auto it : sockets_by_port().resource())
-        callback(*it.value);
+    sockets_by_port().for_each([&](auto& socket) { callback(socket); });
 }
 
-Lockable<HashMap<u16, UDPSocket*>>& UDPSocket::sockets_by_port()
+SocketTable<u16, UDPSocket>& UDPSocket::sockets_by_port()
 {
-    static Lockable<HashMap<u16, UDPSocket*>>* s_map;
-    if (!s_map)
-        s_map = new Lockable<HashMap<u16, UDPSocket*>>;
-    return *s_map;
+    static SocketTable<u16, UDPSocket>* s_table;
+    if (!s_table)
+        s_table = new SocketTable<u16, UDPSocket>;
+    return *s_table;
 }
 
-SocketHandle<UDPSocket> UDPSocket::from_port(u16 port)
+SocketHandle<UDPSocket> UDPSocket::from_port(u16 port, u32 flow_hash)
 {
-    RefPtr<UDPSocket> socket;
-    {
-        LOCKER(sockets_by_port().lock(), Lock::Mode::Shared);
-        auto it = sockets_by_port().resource().find(port);
-        if (it == sockets_by_port().resource().end())
-            return {};
-        socket = (*it).value;
-        ASSERT(socket);
-    }
+    auto socket = sockets_by_port().get(port, flow_hash);
+    if (!socket)
+        return {};
     return { *socket };
 }
 
@@ -70,8 +64,7 @@ UDPSocket::UDPSocket(int protocol)
 
 UDPSocket::~UDPSocket()
 {
-    LOCKER(sockets_by_port().lock());
-    sockets_by_port().resource().remove(local_port());
+    sockets_by_port().remove(local_port(), *this);
 }
 
 NonnullRefPtr<UDPSocket> UDPSocket::create(int protocol)
@@ -79,7 +72,7 @@ NonnullRefPtr<UDPSocket> UDPSocket::create(int protocol)
     return adopt(*new UDPSocket(protocol));
 }
 
-int UDPSocket::protocol_receive(const KBuffer& packet_buffer, void* buffer, size_t buffer_size, int flags)
+int UDPSocket::protocol_receive(const PacketBuffer& packet_buffer, void* buffer, size_t buffer_size, int flags)
 {
     (void)flags;
     auto& ipv4_packet = *(const IPv4Packet*)(packet_buffer.data());
@@ -103,6 +96,17 @@ int UDPSocket::protocol_send(const void* data, size_t data_length)
     memcpy(udp_packet.payload(), data, data_length);
     klog() << "sending as udp packet from " << routing_decision.adapter->ipv4_address().to_string().characters() << ":" << local_port() << " to " << peer_address().to_string().characters() << ":" << peer_port() << "!";
     routing_decision.adapter->send_ipv4(routing_decision.next_hop, peer_address(), IPv4Protocol::UDP, buffer.data(), buffer.size(), ttl());
+    network_statistics().udp.sent++;
+    if (NetworkTrace::is_enabled()) {
+        NetworkTraceEvent event;
+        event.type = NetworkTraceEvent::Type::UDPSend;
+        event.local_address = local_address();
+        event.local_port = local_port();
+        event.peer_address = peer_address();
+        event.peer_port = peer_port();
+        event.length = data_length;
+        NetworkTrace::record(event);
+    }
     return data_length;
 }
 
@@ -120,12 +124,9 @@ int UDPSocket::protocol_allocate_local_port()
     static const u16 ephemeral_port_range_size = last_ephemeral_port - first_ephemeral_port;
     u16 first_scan_port = first_ephemeral_port + get_good_random<u16>() % ephemeral_port_range_size;
 
-    LOCKER(sockets_by_port().lock());
     for (u16 port = first_scan_port;;) {
-        auto it = sockets_by_port().resource().find(port);
-        if (it == sockets_by_port().resource().end()) {
+        if (sockets_by_port().add(port, *this)) {
             set_local_port(port);
-            sockets_by_port().resource().set(port, this);
             return port;
         }
         ++port;
@@ -139,10 +140,8 @@ int UDPSocket::protocol_allocate_local_port()
 
 KResult UDPSocket::protocol_bind()
 {
-    LOCKER(sockets_by_port().lock());
-    if (sockets_by_port().resource().contains(local_port()))
+    if (!sockets_by_port().add(local_port(), *this))
         return KResult(-EADDRINUSE);
-    sockets_by_port().resource().set(local_port(), this);
     return KSuccess;
 }
 
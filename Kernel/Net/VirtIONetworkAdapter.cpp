@@ -0,0 +1,197 @@
+/*
+ * Copyright (c) 2018-2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/Memory.h>
+#include <AK/StringView.h>
+#include <Kernel/Net/VirtIONetworkAdapter.h>
+#include <Kernel/Thread.h>
+#include <Kernel/VM/MemoryManager.h>
+
+//#define VIRTIO_NET_DEBUG
+
+#define VIRTIO_NET_F_MAC 5
+#define VIRTIO_NET_F_STATUS 16
+
+#define VIRTIO_NET_CONFIG_MAC 0
+#define VIRTIO_NET_CONFIG_STATUS 6
+
+#define VIRTIO_NET_S_LINK_UP 1
+
+#define RECEIVE_QUEUE 0
+#define TRANSMIT_QUEUE 1
+
+namespace Kernel {
+
+void VirtIONetworkAdapter::detect()
+{
+    static const PCI::ID virtio_network_id = { VIRTIO_PCI_VENDOR_ID, VIRTIO_PCI_DEVICE_ID_NETWORK };
+
+    PCI::enumerate([&](const PCI::Address& address, PCI::ID id) {
+        if (address.is_null() || id != virtio_network_id)
+            return;
+        auto adapter = adopt(*new VirtIONetworkAdapter(address));
+        if (adapter->initialize())
+            (void)adapter.leak_ref();
+    });
+}
+
+VirtIONetworkAdapter::VirtIONetworkAdapter(PCI::Address address)
+    : VirtIODevice(address)
+{
+    set_interface_name("virtio");
+}
+
+VirtIONetworkAdapter::~VirtIONetworkAdapter()
+{
+}
+
+bool VirtIONetworkAdapter::initialize()
+{
+    u32 features = begin_initialization();
+    if (!(features & (1u << VIRTIO_NET_F_MAC))) {
+        klog() << "VirtIONetworkAdapter: Device @ " << pci_address() << " has no MAC address";
+        fail_initialization();
+        return false;
+    }
+    accept_features(features & ((1u << VIRTIO_NET_F_MAC) | (1u << VIRTIO_NET_F_STATUS)));
+    if (!setup_queues(2)) {
+        fail_initialization();
+        return false;
+    }
+
+    u8 mac[6];
+    for (size_t i = 0; i < 6; ++i)
+        mac[i] = config_read8(VIRTIO_NET_CONFIG_MAC + i);
+    set_mac_address(mac);
+    if (is_feature_accepted(VIRTIO_NET_F_STATUS))
+        m_link_up = config_read16(VIRTIO_NET_CONFIG_STATUS) & VIRTIO_NET_S_LINK_UP;
+
+    // Every buffer takes two descriptors, as legacy devices want the header in a descriptor of its own.
+    m_rx_buffer_count = min(max_rx_buffer_count, (size_t)queue(RECEIVE_QUEUE).size() / 2);
+    m_rx_buffers_region = MM.allocate_contiguous_kernel_region(m_rx_buffer_count * PAGE_SIZE, "VirtIO Net RX", Region::Access::Read | Region::Access::Write);
+    m_tx_buffers_region = MM.allocate_contiguous_kernel_region(tx_buffer_count * PAGE_SIZE, "VirtIO Net TX", Region::Access::Read | Region::Access::Write);
+    if (!m_rx_buffers_region || !m_tx_buffers_region || queue(TRANSMIT_QUEUE).size() < tx_buffer_count * 2) {
+        fail_initialization();
+        return false;
+    }
+    memset(m_tx_buffers_region->vaddr().as_ptr(), 0, tx_buffer_count * PAGE_SIZE);
+    for (size_t i = 0; i < m_rx_buffer_count; ++i)
+        supply_receive_buffer(i);
+
+    // We find out about sent packets whenever we need their buffers back.
+    queue(TRANSMIT_QUEUE).set_interrupts_enabled(false);
+
+    finish_initialization();
+    notify_queue(RECEIVE_QUEUE);
+
+    klog() << "VirtIONetworkAdapter: Found @ " << pci_address() << ", MAC address " << mac_address().to_string() << ", link " << (m_link_up ? "up" : "down");
+    return true;
+}
+
+void VirtIONetworkAdapter::supply_receive_buffer(size_t index)
+{
+    VirtIOBuffer buffers[2] = {
+        { buffer_paddr(*m_rx_buffers_region, index), sizeof(PacketHeader), true },
+        { buffer_paddr(*m_rx_buffers_region, index).offset(frame_offset_in_buffer), PAGE_SIZE - frame_offset_in_buffer, true },
+    };
+    bool supplied = queue(RECEIVE_QUEUE).supply_buffers(buffers, 2, (void*)(index + 1));
+    ASSERT(supplied);
+}
+
+void VirtIONetworkAdapter::send_raw(const u8* data, size_t length)
+{
+    ASSERT(length <= PAGE_SIZE - frame_offset_in_buffer);
+#ifdef VIRTIO_NET_DEBUG
+    klog() << "VirtIONetworkAdapter: Sending packet (" << length << " bytes)";
+#endif
+    InterruptDisabler disabler;
+    size_t index;
+    for (;;) {
+        reclaim_transmit_buffers();
+        if (~m_busy_tx_buffers) {
+            index = __builtin_ctz(~m_busy_tx_buffers);
+            break;
+        }
+        // Out of buffers, so have the device tell us when it's done with one.
+        queue(TRANSMIT_QUEUE).set_interrupts_enabled(true);
+        if (!queue(TRANSMIT_QUEUE).has_used_buffers())
+            Thread::current()->wait_on(m_tx_wait_queue);
+        cli();
+        queue(TRANSMIT_QUEUE).set_interrupts_enabled(false);
+    }
+    m_busy_tx_buffers |= 1u << index;
+
+    memcpy(buffer_data(*m_tx_buffers_region, index) + frame_offset_in_buffer, data, length);
+    VirtIOBuffer buffers[2] = {
+        { buffer_paddr(*m_tx_buffers_region, index), sizeof(PacketHeader), false },
+        { buffer_paddr(*m_tx_buffers_region, index).offset(frame_offset_in_buffer), (u32)length, false },
+    };
+    bool supplied = queue(TRANSMIT_QUEUE).supply_buffers(buffers, 2, (void*)(index + 1));
+    ASSERT(supplied);
+    notify_queue(TRANSMIT_QUEUE);
+}
+
+void VirtIONetworkAdapter::reclaim_transmit_buffers()
+{
+    u32 written_length;
+    while (void* token = queue(TRANSMIT_QUEUE).pop_used_buffers(written_length))
+        m_busy_tx_buffers &= ~(1u << ((FlatPtr)token - 1));
+}
+
+void VirtIONetworkAdapter::receive()
+{
+    bool supplied_any = false;
+    u32 written_length;
+    while (void* token = queue(RECEIVE_QUEUE).pop_used_buffers(written_length)) {
+        size_t index = (FlatPtr)token - 1;
+        if (written_length > sizeof(PacketHeader)) {
+            size_t length = written_length - sizeof(PacketHeader);
+#ifdef VIRTIO_NET_DEBUG
+            klog() << "VirtIONetworkAdapter: Received 1 packet (" << length << " bytes)";
+#endif
+            did_receive(buffer_data(*m_rx_buffers_region, index) + frame_offset_in_buffer, length);
+        }
+        supply_receive_buffer(index);
+        supplied_any = true;
+    }
+    if (supplied_any)
+        notify_queue(RECEIVE_QUEUE);
+}
+
+void VirtIONetworkAdapter::handle_queue_update()
+{
+    receive();
+    if (queue(TRANSMIT_QUEUE).has_used_buffers())
+        m_tx_wait_queue.wake_all();
+}
+
+void VirtIONetworkAdapter::handle_device_config_change()
+{
+    if (is_feature_accepted(VIRTIO_NET_F_STATUS))
+        m_link_up = config_read16(VIRTIO_NET_CONFIG_STATUS) & VIRTIO_NET_S_LINK_UP;
+}
+
+}
@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2018-2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <Kernel/Net/NetworkAdapter.h>
+#include <Kernel/VirtIO/VirtIO.h>
+#include <Kernel/WaitQueue.h>
+
+namespace Kernel {
+
+class VirtIONetworkAdapter final : public NetworkAdapter
+    , public VirtIODevice {
+public:
+    static void detect();
+
+    explicit VirtIONetworkAdapter(PCI::Address);
+    virtual ~VirtIONetworkAdapter() override;
+
+    virtual void send_raw(const u8*, size_t) override;
+    virtual bool link_up() override { return m_link_up; }
+
+    virtual const char* purpose() const override { return class_name(); }
+
+private:
+    virtual const char* class_name() const override { return "VirtIONetworkAdapter"; }
+
+    // ^VirtIODevice
+    virtual void handle_queue_update() override;
+    virtual void handle_device_config_change() override;
+
+    struct [[gnu::packed]] PacketHeader
+    {
+        u8 flags;
+        u8 gso_type;
+        u16 header_length;
+        u16 gso_size;
+        u16 checksum_start;
+        u16 checksum_offset;
+    };
+
+    bool initialize();
+    void supply_receive_buffer(size_t index);
+    void receive();
+    void reclaim_transmit_buffers();
+
+    // Every packet buffer gets a page of its own, with the header at the start and the frame after it.
+    static constexpr size_t frame_offset_in_buffer = 16;
+    u8* buffer_data(Region& region, size_t index) { return region.vaddr().offset(index * PAGE_SIZE).as_ptr(); }
+    PhysicalAddress buffer_paddr(Region& region, size_t index) { return region.physical_page(index)->paddr(); }
+
+    static constexpr size_t max_rx_buffer_count = 64;
+    static constexpr size_t tx_buffer_count = 32;
+
+    size_t m_rx_buffer_count { 0 };
+    OwnPtr<Region> m_rx_buffers_region;
+    OwnPtr<Region> m_tx_buffers_region;
+    u32 m_busy_tx_buffers { 0 };
+    WaitQueue m_tx_wait_queue;
+    bool m_link_up { true };
+};
+
+}
@@ -0,0 +1,258 @@
+/*
+ * Copyright (c) 2018-2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <Kernel/Arch/i386/CPU.h>
+#include <Kernel/Interrupts/APIC.h>
+#include <Kernel/PerformanceCounters.h>
+#include <Kernel/Process.h>
+#include <Kernel/Profiling.h>
+#include <Kernel/Thread.h>
+
+//#define PERFORMANCE_COUNTERS_DEBUG
+
+namespace Kernel {
+
+namespace PerformanceCounters {
+
+#define MSR_IA32_PMC0 0xc1
+#define MSR_IA32_PERFEVTSEL0 0x186
+#define MSR_IA32_PERF_GLOBAL_STATUS 0x38e
+#define MSR_IA32_PERF_GLOBAL_CTRL 0x38f
+#define MSR_IA32_PERF_GLOBAL_OVF_CTRL 0x390
+
+#define PERFEVTSEL_USR (1 << 16)
+#define PERFEVTSEL_OS (1 << 17)
+#define PERFEVTSEL_INT (1 << 20)
+#define PERFEVTSEL_EN (1 << 22)
+
+struct EventDescriptor {
+    const char* name;
+    u8 event_select;
+    u8 unit_mask;
+    // The bit in CPUID.0AH:EBX that is set when the CPU doesn't have this event.
+    u8 unavailable_bit;
+};
+
+static constexpr EventDescriptor s_events[event_count] = {
+    { "cycles", 0x3c, 0x00, 0 },
+    { "instructions", 0xc0, 0x00, 1 },
+    { "cache_misses", 0x2e, 0x41, 4 },
+    { "branch_misses", 0xc5, 0x00, 6 },
+};
+
+static bool s_supported;
+static u8 s_supported_event_mask;
+static u64 s_counter_mask;
+
+const char* to_string(Event event)
+{
+    ASSERT(event < Event::__Count);
+    return s_events[(size_t)event].name;
+}
+
+void initialize_processor()
+{
+    if (Processor::current().is_bootstrap_processor()) {
+        CPUID leaf0(0);
+        if (leaf0.eax() < 0xa)
+            return;
+
+        // We need the global control and status registers, which came with version 2.
+        CPUID perfmon(0xa);
+        u8 version = perfmon.eax() & 0xff;
+        u8 counter_count = (perfmon.eax() >> 8) & 0xff;
+        u8 counter_width = (perfmon.eax() >> 16) & 0xff;
+        u8 ebx_length = (perfmon.eax() >> 24) & 0xff;
+        if (version < 2 || counter_count < event_count || !counter_width) {
+            klog() << "x86: Architectural performance counters not supported (version " << version << ", " << counter_count << " counters)";
+            return;
+        }
+
+        for (size_t i = 0; i < event_count; ++i) {
+            u8 bit = s_events[i].unavailable_bit;
+            if (bit >= ebx_length || !(perfmon.ebx() & (1 << bit)))
+                s_supported_event_mask |= 1 << i;
+        }
+        s_counter_mask = counter_width >= 64 ? ~(u64)0 : ((u64)1 << counter_width) - 1;
+        s_supported = true;
+        klog() << "x86: Architectural performance counters version " << version << ", " << counter_count << " counters of " << counter_width << " bits";
+    }
+
+    if (!s_supported)
+        return;
+
+    // Leave the counters enabled globally; the event select registers turn them on and off per thread.
+    for (size_t i = 0; i < event_count; ++i)
+        MSR(MSR_IA32_PERFEVTSEL0 + i).set(0, 0);
+    MSR(MSR_IA32_PERF_GLOBAL_CTRL).set((1 << event_count) - 1, 0);
+}
+
+bool is_supported()
+{
+    return s_supported;
+}
+
+bool is_event_supported(Event event)
+{
+    return s_supported && (s_supported_event_mask & (1 << (u8)event));
+}
+
+static u64 read_counter(size_t index)
+{
+    u32 low;
+    u32 high;
+    asm volatile("rdpmc"
+                 : "=a"(low), "=d"(high)
+                 : "c"(index));
+    return ((u64)high << 32 | low) & s_counter_mask;
+}
+
+// Only the low 32 bits of a counter can be written, the rest are copies of bit 31. That's fine for
+// the values we use: zero, or just below the overflow point for the event we sample on.
+static void write_counter(size_t index, u64 value)
+{
+    u32 low = value & 0xffffffff;
+    u32 high = (low & 0x80000000) ? (u32)(s_counter_mask >> 32) : 0;
+    MSR(MSR_IA32_PMC0 + index).set(low, high);
+}
+
+static u64 initial_value(const Config& config, size_t index)
+{
+    if (config.sample_event != (i8)index)
+        return 0;
+    return (s_counter_mask + 1 - config.sample_period) & s_counter_mask;
+}
+
+void configure(Process& process, const Config& config)
+{
+    ASSERT(s_supported);
+    InterruptDisabler disabler;
+    auto* current_thread = Thread::current();
+    if (&current_thread->process() == &process)
+        switch_out(*current_thread);
+
+    process.perf_counter_config() = config;
+    process.for_each_thread([&](Thread& thread) {
+        auto& state = thread.perf_counters();
+        for (size_t i = 0; i < event_count; ++i) {
+            state.counts[i] = 0;
+            state.saved_values[i] = initial_value(config, i);
+        }
+        return IterationDecision::Continue;
+    });
+
+    if (&current_thread->process() == &process)
+        switch_in(*current_thread);
+}
+
+static void accumulate(ThreadState& state, size_t index, u64 value)
+{
+    state.counts[index] += (value - state.saved_values[index]) & s_counter_mask;
+    state.saved_values[index] = value;
+}
+
+void switch_out(Thread& thread)
+{
+    auto& state = thread.perf_counters();
+    if (!state.programmed_mask)
+        return;
+    for (size_t i = 0; i < event_count; ++i) {
+        if (!(state.programmed_mask & (1 << i)))
+            continue;
+        MSR(MSR_IA32_PERFEVTSEL0 + i).set(0, 0);
+        accumulate(state, i, read_counter(i));
+    }
+    state.programmed_mask = 0;
+}
+
+void switch_in(Thread& thread)
+{
+    auto& config = thread.process().perf_counter_config();
+    if (!config.event_mask)
+        return;
+    auto& state = thread.perf_counters();
+    ASSERT(!state.programmed_mask);
+    for (size_t i = 0; i < event_count; ++i) {
+        if (!config.is_counting((Event)i))
+            continue;
+        if (config.sample_event != (i8)i)
+            state.saved_values[i] = 0;
+        write_counter(i, state.saved_values[i]);
+        u32 event_select = s_events[i].event_select | s_events[i].unit_mask << 8 | PERFEVTSEL_USR | PERFEVTSEL_OS | PERFEVTSEL_EN;
+        if (config.sample_event == (i8)i)
+            event_select |= PERFEVTSEL_INT;
+        MSR(MSR_IA32_PERFEVTSEL0 + i).set(event_select, 0);
+        state.programmed_mask |= 1 << i;
+    }
+}
+
+void update_counts(Thread& thread)
+{
+    ASSERT(&thread == Thread::current());
+    InterruptDisabler disabler;
+    auto& state = thread.perf_counters();
+    for (size_t i = 0; i < event_count; ++i) {
+        if (state.programmed_mask & (1 << i))
+            accumulate(state, i, read_counter(i));
+    }
+}
+
+void handle_overflow_interrupt(const RegisterState& regs)
+{
+    if (!s_supported)
+        return;
+
+    u32 status;
+    u32 status_high;
+    MSR(MSR_IA32_PERF_GLOBAL_STATUS).get(status, status_high);
+    status &= (1 << event_count) - 1;
+
+#ifdef PERFORMANCE_COUNTERS_DEBUG
+    dbg() << "PerformanceCounters: Overflow interrupt, status " << String::format("%x", status);
+#endif
+
+    auto* thread = Thread::current();
+    if (thread && status) {
+        auto& config = thread->process().perf_counter_config();
+        auto& state = thread->perf_counters();
+        if (config.is_sampling() && (status & (1 << config.sample_event)) && (state.programmed_mask & (1 << config.sample_event))) {
+            size_t index = config.sample_event;
+            accumulate(state, index, read_counter(index));
+            state.saved_values[index] = initial_value(config, index);
+            write_counter(index, state.saved_values[index]);
+            if (thread->process().is_profiling())
+                Profiling::take_sample(regs);
+        }
+    }
+
+    MSR(MSR_IA32_PERF_GLOBAL_OVF_CTRL).set(status, 0);
+    // The local APIC masks the interrupt whenever it delivers it.
+    APIC::enable_performance_counter_interrupt();
+}
+
+}
+
+}
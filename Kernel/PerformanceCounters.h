@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2018-2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/Types.h>
+
+namespace Kernel {
+
+class Process;
+struct RegisterState;
+class Thread;
+
+namespace PerformanceCounters {
+
+// The architectural events, each one counted in the general-purpose counter of the same index.
+enum class Event : u8 {
+    Cycles,
+    Instructions,
+    CacheMisses,
+    BranchMisses,
+    __Count,
+};
+
+constexpr size_t event_count = (size_t)Event::__Count;
+
+const char* to_string(Event);
+
+// What a process asked to count. All of its threads count the same events,
+// each into its own ThreadState, and switch the counters over on every context switch.
+struct Config {
+    u8 event_mask { 0 };
+    // When set, every sample_period occurrences of this event interrupt the thread and
+    // take a profiling sample, in place of the timer.
+    i8 sample_event { -1 };
+    u32 sample_period { 0 };
+
+    bool is_counting(Event event) const { return event_mask & (1 << (u8)event); }
+    bool is_sampling() const { return sample_event >= 0; }
+};
+
+struct ThreadState {
+    u64 counts[event_count] {};
+    // The raw counter values as of when the thread was last switched in, or out.
+    u64 saved_values[event_count] {};
+    u8 programmed_mask { 0 };
+};
+
+void initialize_processor();
+bool is_supported();
+bool is_event_supported(Event);
+
+// Starts the given configuration over on all of the process's threads.
+void configure(Process&, const Config&);
+
+void switch_out(Thread&);
+void switch_in(Thread&);
+
+// Brings the counts of the current thread up to date without stopping its counters.
+void update_counts(Thread&);
+
+void handle_overflow_interrupt(const RegisterState&);
+
+}
+
+}
@@ -27,8 +27,11 @@
 #include <AK/JsonArraySerializer.h>
 #include <AK/JsonObject.h>
 #include <AK/JsonObjectSerializer.h>
+#include <Kernel/Arch/i386/CPU.h>
 #include <Kernel/KBufferBuilder.h>
 #include <Kernel/PerformanceEventBuffer.h>
+#include <Kernel/Syscall.h>
+#include <Kernel/Thread.h>
 
 namespace Kernel {
 
@@ -44,6 +47,7 @@ KResult PerformanceEventBuffer::append(int type, FlatPtr arg1, FlatPtr arg2)
 
     PerformanceEvent event;
     event.type = type;
+    event.tid = Thread::current()->tid();
 
     switch (type) {
     case PERF_EVENT_MALLOC:
@@ -67,11 +71,11 @@ KResult PerformanceEventBuffer::append(int type, FlatPtr arg1, FlatPtr arg2)
     asm volatile("movl %%ebp, %%eax"
                  : "=a"(ebp));
     FlatPtr eip;
-    copy_from_user(&eip, (FlatPtr*)&Thread::current->get_register_dump_from_stack().eip);
+    copy_from_user(&eip, (FlatPtr*)&Thread::current()->get_register_dump_from_stack().eip);
     Vector<FlatPtr> backtrace;
     {
         SmapDisabler disabler;
-        backtrace = Thread::current->raw_backtrace(ebp, eip);
+        backtrace = Thread::current()->raw_backtrace(ebp, eip);
     }
     event.stack_size = min(sizeof(event.stack) / sizeof(FlatPtr), static_cast<size_t>(backtrace.size()));
     memcpy(event.stack, backtrace.data(), event.stack_size * sizeof(FlatPtr));
@@ -82,10 +86,83 @@ KResult PerformanceEventBuffer::append(int type, FlatPtr arg1, FlatPtr arg2)
 #endif
 
     event.timestamp = g_uptime;
+    event.tsc = read_tsc();
+
+    // The kernel may have recorded events of its own while we were collecting the stack.
+    InterruptDisabler disabler;
+    if (count() >= capacity())
+        return KResult(-ENOBUFS);
     at(m_count++) = event;
     return KSuccess;
 }
 
+void PerformanceEventBuffer::set_records_kernel_events()
+{
+    // Kernel events are recorded from the scheduler and the page fault handler, which
+    // mustn't fault on the buffer itself.
+    m_buffer.impl().region().commit();
+    m_records_kernel_events = true;
+}
+
+PerformanceEvent* PerformanceEventBuffer::append_kernel_event(int type, const Thread& thread)
+{
+    ASSERT_INTERRUPTS_DISABLED();
+    if (count() >= capacity())
+        return nullptr;
+    auto& event = at(m_count++);
+    event.type = type;
+    event.stack_size = 0;
+    event.tid = thread.tid();
+    event.timestamp = g_uptime;
+    event.tsc = read_tsc();
+    return &event;
+}
+
+void PerformanceEventBuffer::append_page_fault(const Thread& thread, FlatPtr address, u32 flags, u64 start_tsc)
+{
+    InterruptDisabler disabler;
+    if (auto* event = append_kernel_event(PERF_EVENT_PAGE_FAULT, thread)) {
+        event->data.page_fault.address = address;
+        event->data.page_fault.flags = flags;
+        event->data.page_fault.start_tsc = start_tsc;
+    }
+}
+
+void PerformanceEventBuffer::append_context_switch(int type, const Thread& thread, const char* reason)
+{
+    InterruptDisabler disabler;
+    if (auto* event = append_kernel_event(type, thread))
+        event->data.context_switch.reason = reason;
+}
+
+void PerformanceEventBuffer::append_syscall(const Thread& thread, u32 function, u64 start_tsc)
+{
+    InterruptDisabler disabler;
+    if (auto* event = append_kernel_event(PERF_EVENT_SYSCALL, thread)) {
+        event->data.system_call.function = function;
+        event->data.system_call.start_tsc = start_tsc;
+    }
+}
+
+void PerformanceEventBuffer::append_block_io(int type, const Thread& thread, u32 index, u16 count, bool is_write)
+{
+    InterruptDisabler disabler;
+    if (auto* event = append_kernel_event(type, thread)) {
+        event->data.block_io.index = index;
+        event->data.block_io.count = count;
+        event->data.block_io.is_write = is_write;
+    }
+}
+
+void PerformanceEventBuffer::append_lock_wait(const Thread& thread, const char* name, u64 start_tsc)
+{
+    InterruptDisabler disabler;
+    if (auto* event = append_kernel_event(PERF_EVENT_LOCK_WAIT, thread)) {
+        event->data.lock_wait.name = name;
+        event->data.lock_wait.start_tsc = start_tsc;
+    }
+}
+
 PerformanceEvent& PerformanceEventBuffer::at(size_t index)
 {
     ASSERT(index < capacity());
@@ -115,8 +192,45 @@ KBuffer PerformanceEventBuffer::to_json(pid_t pid, const String& executable_path
             event_object.add("type", "free");
             event_object.add("ptr", static_cast<u64>(event.data.free.ptr));
             break;
+        case PERF_EVENT_PAGE_FAULT:
+            event_object.add("type", "page_fault");
+            event_object.add("address", static_cast<u64>(event.data.page_fault.address));
+            event_object.add("fault_type", event.data.page_fault.flags & PageFaultFlags::ProtectionViolation ? "protection_violation" : "not_present");
+            event_object.add("access", event.data.page_fault.flags & PageFaultFlags::Write ? "write" : "read");
+            event_object.add("start_tsc", event.data.page_fault.start_tsc);
+            break;
+        case PERF_EVENT_CONTEXT_SWITCH_OUT:
+            event_object.add("type", "switch_out");
+            event_object.add("reason", event.data.context_switch.reason);
+            break;
+        case PERF_EVENT_CONTEXT_SWITCH_IN:
+            event_object.add("type", "switch_in");
+            break;
+        case PERF_EVENT_WAKEUP:
+            event_object.add("type", "wakeup");
+            event_object.add("reason", event.data.context_switch.reason);
+            break;
+        case PERF_EVENT_SYSCALL:
+            event_object.add("type", "syscall");
+            event_object.add("function", Syscall::to_string((Syscall::Function)event.data.system_call.function));
+            event_object.add("start_tsc", event.data.system_call.start_tsc);
+            break;
+        case PERF_EVENT_BLOCK_IO_SUBMIT:
+        case PERF_EVENT_BLOCK_IO_COMPLETE:
+            event_object.add("type", event.type == PERF_EVENT_BLOCK_IO_SUBMIT ? "block_io_submit" : "block_io_complete");
+            event_object.add("index", event.data.block_io.index);
+            event_object.add("count", event.data.block_io.count);
+            event_object.add("is_write", event.data.block_io.is_write);
+            break;
+        case PERF_EVENT_LOCK_WAIT:
+            event_object.add("type", "lock_wait");
+            event_object.add("lock", event.data.lock_wait.name);
+            event_object.add("start_tsc", event.data.lock_wait.start_tsc);
+            break;
         }
+        event_object.add("tid", event.tid);
         event_object.add("timestamp", event.timestamp);
+        event_object.add("tsc", event.tsc);
         auto stack_array = event_object.add_array("stack");
         for (size_t j = 0; j < event.stack_size; ++j) {
             stack_array.add(event.stack[j]);
@@ -31,6 +31,8 @@
 
 namespace Kernel {
 
+class Thread;
+
 struct [[gnu::packed]] MallocPerformanceEvent
 {
     size_t size;
@@ -43,14 +45,55 @@ struct [[gnu::packed]] FreePerformanceEvent
     FlatPtr ptr;
 };
 
+struct [[gnu::packed]] PageFaultPerformanceEvent
+{
+    FlatPtr address;
+    u32 flags;
+    u64 start_tsc;
+};
+
+struct [[gnu::packed]] ContextSwitchPerformanceEvent
+{
+    // Why a thread was switched out: its state, or what it blocked on. For a wakeup,
+    // what it had been blocked on. Always a string literal.
+    const char* reason;
+};
+
+struct [[gnu::packed]] SyscallPerformanceEvent
+{
+    u32 function;
+    u64 start_tsc;
+};
+
+struct [[gnu::packed]] BlockIOPerformanceEvent
+{
+    u32 index;
+    u16 count;
+    bool is_write;
+};
+
+struct [[gnu::packed]] LockWaitPerformanceEvent
+{
+    // The name the lock's statistics are kept under, see /proc/locks.
+    const char* name;
+    u64 start_tsc;
+};
+
 struct [[gnu::packed]] PerformanceEvent
 {
     u8 type { 0 };
     u8 stack_size { 0 };
+    u32 tid { 0 };
     u64 timestamp;
+    u64 tsc;
     union {
         MallocPerformanceEvent malloc;
         FreePerformanceEvent free;
+        PageFaultPerformanceEvent page_fault;
+        ContextSwitchPerformanceEvent context_switch;
+        SyscallPerformanceEvent system_call;
+        BlockIOPerformanceEvent block_io;
+        LockWaitPerformanceEvent lock_wait;
     } data;
     FlatPtr stack[32];
 };
@@ -61,6 +104,17 @@ public:
 
     KResult append(int type, FlatPtr arg1, FlatPtr arg2);
 
+    bool records_kernel_events() const { return m_records_kernel_events; }
+    void set_records_kernel_events();
+
+    // Events the kernel records on a thread's behalf. These don't carry a stack,
+    // since they may be recorded from the scheduler or an exception handler.
+    void append_page_fault(const Thread&, FlatPtr address, u32 flags, u64 start_tsc);
+    void append_context_switch(int type, const Thread&, const char* reason);
+    void append_syscall(const Thread&, u32 function, u64 start_tsc);
+    void append_block_io(int type, const Thread&, u32 index, u16 count, bool is_write);
+    void append_lock_wait(const Thread&, const char* name, u64 start_tsc);
+
     size_t capacity() const { return m_buffer.size() / sizeof(PerformanceEvent); }
     size_t count() const { return m_count; }
     const PerformanceEvent& at(size_t index) const
@@ -72,8 +126,10 @@ public:
 
 private:
     PerformanceEvent& at(size_t index);
+    PerformanceEvent* append_kernel_event(int type, const Thread&);
 
     size_t m_count { 0 };
+    bool m_records_kernel_events { false };
     KBuffer m_buffer;
 };
 
@@ -44,6 +44,7 @@
 #include <Kernel/FileSystem/Ext2FileSystem.h>
 #include <Kernel/FileSystem/FIFO.h>
 #include <Kernel/FileSystem/FileDescription.h>
+#include <Kernel/FileSystem/EventQueue.h>
 #include <Kernel/FileSystem/InodeWatcher.h>
 #include <Kernel/FileSystem/ProcFS.h>
 #include <Kernel/FileSystem/TmpFS.h>
@@ -54,7 +55,9 @@
 #include <Kernel/KSyms.h>
 #include <Kernel/Module.h>
 #include <Kernel/Multiboot.h>
+#include <Kernel/Net/LocalSocket.h>
 #include <Kernel/Net/Socket.h>
+#include <Kernel/PerformanceCounters.h>
 #include <Kernel/PerformanceEventBuffer.h>
 #include <Kernel/Process.h>
 #include <Kernel/Profiling.h>
@@ -65,6 +68,7 @@
 #include <Kernel/SharedBuffer.h>
 #include <Kernel/StdLib.h>
 #include <Kernel/Syscall.h>
+#include <Kernel/SyscallStatistics.h>
 #include <Kernel/TTY/MasterPTY.h>
 #include <Kernel/TTY/TTY.h>
 #include <Kernel/Thread.h>
@@ -94,8 +98,6 @@ namespace Kernel {
 
 static void create_signal_trampolines();
 
-Process* Process::current;
-
 static pid_t next_pid;
 InlineLinkedList<Process>* g_processes;
 static String* s_hostname;
@@ -172,6 +174,7 @@ Region& Process::allocate_split_region(const Region& source_region, const Range&
     auto& region = add_region(Region::create_user_accessible(range, source_region.vmobject(), offset_in_vmobject, source_region.name(), source_region.access()));
     region.set_mmap(source_region.is_mmap());
     region.set_stack(source_region.is_stack());
+    region.set_wants_huge_pages(source_region.wants_huge_pages());
     size_t page_offset_in_source_region = (offset_in_vmobject - source_region.offset_in_vmobject()) / PAGE_SIZE;
     for (size_t i = 0; i < region.page_count(); ++i) {
         if (source_region.should_cow(page_offset_in_source_region + i))
@@ -395,6 +398,8 @@ void* Process::sys$mmap(const Syscall::SC_mmap_params* user_params)
     bool map_private = flags & MAP_PRIVATE;
     bool map_stack = flags & MAP_STACK;
     bool map_fixed = flags & MAP_FIXED;
+    bool map_huge = flags & MAP_HUGE;
+    bool map_populate = flags & MAP_POPULATE;
 
     if (map_shared && map_private)
         return (void*)-EINVAL;
@@ -408,6 +413,12 @@ void* Process::sys$mmap(const Syscall::SC_mmap_params* user_params)
     if (map_stack && (!map_private || !map_anonymous))
         return (void*)-EINVAL;
 
+    // Large pages only make sense for anonymous memory, and need 2 MiB aligned addresses.
+    if (map_huge && (!map_anonymous || map_purgeable || map_stack))
+        map_huge = false;
+    if (map_huge && !addr)
+        alignment = max(alignment, huge_page_size);
+
     Region* region = nullptr;
 
     auto range = allocate_range(VirtualAddress(addr), size, alignment);
@@ -422,7 +433,9 @@ void* Process::sys$mmap(const Syscall::SC_mmap_params* user_params)
     } else if (map_anonymous) {
         region = allocate_region(range, !name.is_null() ? name : "mmap", prot, false);
         if (!region && (!map_fixed && addr != 0))
-            region = allocate_region(allocate_range({}, size), !name.is_null() ? name : "mmap", prot, false);
+            region = allocate_region(allocate_range({}, size, map_huge ? huge_page_size : PAGE_SIZE), !name.is_null() ? name : "mmap", prot, false);
+        if (region)
+            region->set_wants_huge_pages(map_huge);
     } else {
         if (offset < 0)
             return (void*)-EINVAL;
@@ -465,6 +478,8 @@ void* Process::sys$mmap(const Syscall::SC_mmap_params* user_params)
         region->set_stack(true);
     if (!name.is_null())
         region->set_name(name);
+    if (map_populate)
+        region->prefault(0, region->page_count());
     return region->vaddr().as_ptr();
 }
 
@@ -592,6 +607,29 @@ int Process::sys$madvise(void* address, size_t size, int advice)
     if (!is_user_range(VirtualAddress(address), size))
         return -EFAULT;
 
+    if (advice & (MADV_WILLNEED | MADV_DONTNEED)) {
+        if ((advice & MADV_WILLNEED) && (advice & MADV_DONTNEED))
+            return -EINVAL;
+        if ((FlatPtr)address & ~PAGE_MASK)
+            return -EINVAL;
+        Range range { VirtualAddress(address), PAGE_ROUND_UP(size) };
+        auto* region = region_containing(range);
+        if (!region)
+            return -ENOMEM;
+        size_t first_page_index = (range.base().get() - region->vaddr().get()) / PAGE_SIZE;
+        size_t page_count = range.size() / PAGE_SIZE;
+        if (advice & MADV_DONTNEED) {
+            if (!region->is_mmap())
+                return -EPERM;
+            region->discard_pages(first_page_index, page_count);
+            return 0;
+        }
+        // Only file contents are worth reading ahead; anonymous memory is allocated as it's touched.
+        if (region->vmobject().is_inode())
+            region->prefault(first_page_index, page_count);
+        return 0;
+    }
+
     auto* region = region_from_range({ VirtualAddress(address), size });
     if (!region)
         return -EINVAL;
@@ -658,19 +696,8 @@ int Process::sys$purge(int mode)
     if (!is_superuser())
         return -EPERM;
     int purged_page_count = 0;
-    if (mode & PURGE_ALL_VOLATILE) {
-        NonnullRefPtrVector<PurgeableVMObject> vmobjects;
-        {
-            InterruptDisabler disabler;
-            MM.for_each_vmobject_of_type<PurgeableVMObject>([&](auto& vmobject) {
-                vmobjects.append(vmobject);
-                return IterationDecision::Continue;
-            });
-        }
-        for (auto& vmobject : vmobjects) {
-            purged_page_count += vmobject.purge();
-        }
-    }
+    if (mode & PURGE_ALL_VOLATILE)
+        purged_page_count += MM.purge_volatile_vmobjects();
     if (mode & PURGE_ALL_CLEAN_INODE) {
         NonnullRefPtrVector<InodeVMObject> vmobjects;
         {
@@ -740,7 +767,9 @@ pid_t Process::sys$fork(RegisterState& regs)
         dbg() << "fork: cloning Region{" << &region << "} '" << region.name() << "' @ " << region.vaddr();
 #endif
         auto& child_region = child->add_region(region.clone());
-        child_region.map(child->page_directory());
+        // Don't build the child's page tables up front; the child (usually the Shell about to
+        // execve() something) maps in only the pages it actually touches.
+        child_region.set_page_directory(child->page_directory());
 
         if (&region == m_master_tls_region)
             child->m_master_tls_region = child_region.make_weak_ptr();
@@ -790,7 +819,7 @@ void Process::kill_threads_except_self()
         return;
 
     for_each_thread([&](Thread& thread) {
-        if (&thread == Thread::current
+        if (&thread == Thread::current()
             || thread.state() == Thread::State::Dead
             || thread.state() == Thread::State::Dying)
             return IterationDecision::Continue;
@@ -852,7 +881,7 @@ int Process::do_exec(NonnullRefPtr<FileDescription> main_program_description, Ve
 
     // Mark this thread as the current thread that does exec
     // No other thread from this process will be scheduled to run
-    m_exec_tid = Thread::current->tid();
+    m_exec_tid = Thread::current()->tid();
 
     auto old_page_directory = move(m_page_directory);
     auto old_regions = move(m_regions);
@@ -892,7 +921,7 @@ int Process::do_exec(NonnullRefPtr<FileDescription> main_program_description, Ve
     RefPtr<ELF::Loader> loader;
     {
         ArmedScopeGuard rollback_regions_guard([&]() {
-            ASSERT(Process::current == this);
+            ASSERT(Process::current() == this);
             m_page_directory = move(old_page_directory);
             m_regions = move(old_regions);
             MM.enter_process_paging_scope(*this);
@@ -984,15 +1013,16 @@ int Process::do_exec(NonnullRefPtr<FileDescription> main_program_description, Ve
     auto main_program_metadata = main_program_description->metadata();
 
     if (!(main_program_description->custody()->mount_flags() & MS_NOSUID)) {
+        InterruptDisabler disabler;
         if (main_program_metadata.is_setuid())
             m_euid = main_program_metadata.uid;
         if (main_program_metadata.is_setgid())
             m_egid = main_program_metadata.gid;
     }
 
-    Thread::current->set_default_signal_dispositions();
-    Thread::current->m_signal_mask = 0;
-    Thread::current->m_pending_signals = 0;
+    Thread::current()->set_default_signal_dispositions();
+    Thread::current()->m_signal_mask = 0;
+    Thread::current()->m_pending_signals = 0;
 
     m_futex_queues.clear();
 
@@ -1004,13 +1034,13 @@ int Process::do_exec(NonnullRefPtr<FileDescription> main_program_description, Ve
         auto& daf = m_fds[i];
         if (daf.description && daf.flags & FD_CLOEXEC) {
             daf.description->close();
-            daf = {};
+            clear_fd(i);
         }
     }
 
     Thread* new_main_thread = nullptr;
-    if (Process::current == this) {
-        new_main_thread = Thread::current;
+    if (Process::current() == this) {
+        new_main_thread = Thread::current();
     } else {
         for_each_thread([&](auto& thread) {
             new_main_thread = &thread;
@@ -1026,7 +1056,7 @@ int Process::do_exec(NonnullRefPtr<FileDescription> main_program_description, Ve
     // We cli() manually here because we don't want to get interrupted between do_exec() and Schedule::yield().
     // The reason is that the task redirection we've set up above will be clobbered by the timer IRQ.
     // If we used an InterruptDisabler that sti()'d on exit, we might timer tick'd too soon in exec().
-    if (Process::current == this)
+    if (Process::current() == this)
         cli();
 
     // NOTE: Be careful to not trigger any page faults below!
@@ -1068,8 +1098,8 @@ int Process::do_exec(NonnullRefPtr<FileDescription> main_program_description, Ve
     klog() << "Process exec'd " << path.characters() << " @ " << String::format("%p", tss.eip);
 #endif
 
-    if (was_profiling)
-        Profiling::did_exec(path);
+    if (was_profiling || Profiling::is_profiling_all_processes())
+        Profiling::did_exec(*this, path);
 
     new_main_thread->set_state(Thread::State::Skip1SchedulerPass);
     big_lock().force_unlock_if_locked();
@@ -1249,13 +1279,13 @@ int Process::exec(String path, Vector<String> arguments, Vector<String> environm
         return rc;
 
     if (m_wait_for_tracer_at_next_execve) {
-        ASSERT(Thread::current->state() == Thread::State::Skip1SchedulerPass);
+        ASSERT(Thread::current()->state() == Thread::State::Skip1SchedulerPass);
         // State::Skip1SchedulerPass is irrelevant since we block the thread
-        Thread::current->set_state(Thread::State::Running);
-        Thread::current->send_urgent_signal_to_self(SIGSTOP);
+        Thread::current()->set_state(Thread::State::Running);
+        Thread::current()->send_urgent_signal_to_self(SIGSTOP);
     }
 
-    if (Process::current == this) {
+    if (Process::current() == this) {
         Scheduler::yield();
         ASSERT_NOT_REACHED();
     }
@@ -1276,7 +1306,7 @@ int Process::sys$execve(const Syscall::SC_execve_params* user_params)
         return -E2BIG;
 
     if (m_wait_for_tracer_at_next_execve)
-        Thread::current->send_urgent_signal_to_self(SIGSTOP);
+        Thread::current()->send_urgent_signal_to_self(SIGSTOP);
 
     String path;
     {
@@ -1394,6 +1424,7 @@ Process::Process(Thread*& first_thread, const String& name, uid_t uid, gid_t gid
     , m_cwd(move(cwd))
     , m_tty(tty)
     , m_ppid(ppid)
+    , m_scheduling_group(fork_parent ? fork_parent->m_scheduling_group : RefPtr<SchedulingGroup>(SchedulingGroup::create()))
 {
 #ifdef PROCESS_DEBUG
     dbg() << "Created new process " << m_name << "(" << m_pid << ")";
@@ -1406,7 +1437,7 @@ Process::Process(Thread*& first_thread, const String& name, uid_t uid, gid_t gid
 
     if (fork_parent) {
         // NOTE: fork() doesn't clone all threads; the thread that called fork() becomes the only thread in the new process.
-        first_thread = Thread::current->clone(*this);
+        first_thread = Thread::current()->clone(*this);
     } else {
         // NOTE: This non-forked code path is only taken when the kernel creates a process "manually" (at boot.)
         first_thread = new Thread(*this);
@@ -1416,6 +1447,8 @@ Process::Process(Thread*& first_thread, const String& name, uid_t uid, gid_t gid
 Process::~Process()
 {
     ASSERT(thread_count() == 0);
+    if (m_alarm_timer_id)
+        TimerQueue::the().cancel_timer(m_alarm_timer_id);
 }
 
 void Process::dump_regions()
@@ -1441,7 +1474,7 @@ void Process::sys$exit(int status)
     m_termination_status = status;
     m_termination_signal = 0;
     die();
-    Thread::current->die_if_needed();
+    Thread::current()->die_if_needed();
     ASSERT_NOT_REACHED();
 }
 
@@ -1505,7 +1538,7 @@ int Process::sys$sigreturn(RegisterState& registers)
     //pop the stored eax, ebp, return address, handler and signal code
     stack_ptr += 5;
 
-    Thread::current->m_signal_mask = *stack_ptr;
+    Thread::current()->m_signal_mask = *stack_ptr;
     stack_ptr++;
 
     //pop edi, esi, ebp, esp, ebx, edx, ecx and eax
@@ -1526,7 +1559,7 @@ void Process::crash(int signal, u32 eip, bool out_of_memory)
 {
     ASSERT_INTERRUPTS_DISABLED();
     ASSERT(!is_dead());
-    ASSERT(Process::current == this);
+    ASSERT(Process::current() == this);
 
     if (out_of_memory) {
         dbg() << "\033[31;1mOut of memory\033[m, killing: " << *this;
@@ -1547,7 +1580,7 @@ void Process::crash(int signal, u32 eip, bool out_of_memory)
     die();
     // We can not return from here, as there is nowhere
     // to unwind to, so die right away.
-    Thread::current->die_if_needed();
+    Thread::current()->die_if_needed();
     ASSERT_NOT_REACHED();
 }
 
@@ -1565,6 +1598,7 @@ RefPtr<FileDescription> Process::file_description(int fd) const
 {
     if (fd < 0)
         return nullptr;
+    InterruptDisabler disabler;
     if (static_cast<size_t>(fd) < m_fds.size())
         return m_fds[fd].description.ptr();
     return nullptr;
@@ -1574,6 +1608,7 @@ int Process::fd_flags(int fd) const
 {
     if (fd < 0)
         return -1;
+    InterruptDisabler disabler;
     if (static_cast<size_t>(fd) < m_fds.size())
         return m_fds[fd].flags;
     return -1;
@@ -1640,49 +1675,162 @@ int Process::sys$ptsname_r(int fd, char* buffer, ssize_t size)
     return 0;
 }
 
-ssize_t Process::sys$writev(int fd, const struct iovec* iov, int iov_count)
+KResult Process::validate_and_copy_iovecs(const struct iovec* iov, int iov_count, Vector<iovec, 32>& vecs, bool will_be_written)
 {
-    REQUIRE_PROMISE(stdio);
     if (iov_count < 0)
-        return -EINVAL;
+        return KResult(-EINVAL);
 
     if (!validate_read_typed(iov, iov_count))
-        return -EFAULT;
+        return KResult(-EFAULT);
 
     u64 total_length = 0;
-    Vector<iovec, 32> vecs;
     vecs.resize(iov_count);
     copy_from_user(vecs.data(), iov, iov_count * sizeof(iovec));
     for (auto& vec : vecs) {
-        if (!validate_read(vec.iov_base, vec.iov_len))
-            return -EFAULT;
+        if (will_be_written ? !validate_write(vec.iov_base, vec.iov_len) : !validate_read(vec.iov_base, vec.iov_len))
+            return KResult(-EFAULT);
         total_length += vec.iov_len;
         if (total_length > INT32_MAX)
-            return -EINVAL;
+            return KResult(-EINVAL);
     }
+    return KSuccess;
+}
 
-    auto description = file_description(fd);
-    if (!description)
-        return -EBADF;
-
-    if (!description->is_writable())
-        return -EBADF;
-
+ssize_t Process::do_writev(FileDescription& description, const Vector<iovec, 32>& vecs, Optional<off_t> offset)
+{
     int nwritten = 0;
     for (auto& vec : vecs) {
-        int rc = do_write(*description, (const u8*)vec.iov_base, vec.iov_len);
+        Optional<off_t> vec_offset;
+        if (offset.has_value())
+            vec_offset = offset.value() + nwritten;
+        int rc = do_write(description, (const u8*)vec.iov_base, vec.iov_len, vec_offset);
         if (rc < 0) {
             if (nwritten == 0)
                 return rc;
             return nwritten;
         }
         nwritten += rc;
+        if ((size_t)rc < vec.iov_len)
+            break;
     }
 
     return nwritten;
 }
 
-ssize_t Process::do_write(FileDescription& description, const u8* data, int data_size)
+ssize_t Process::do_readv(FileDescription& description, const Vector<iovec, 32>& vecs, Optional<off_t> offset)
+{
+    int nread = 0;
+    for (auto& vec : vecs) {
+        if (!vec.iov_len)
+            continue;
+        // Only wait for data before filling the first buffer, after that we take whatever is there.
+        if (nread && !offset.has_value() && !description.can_read())
+            break;
+        Optional<off_t> vec_offset;
+        if (offset.has_value())
+            vec_offset = offset.value() + nread;
+        int rc = do_read(description, (u8*)vec.iov_base, vec.iov_len, vec_offset);
+        if (rc < 0) {
+            if (nread == 0)
+                return rc;
+            return nread;
+        }
+        nread += rc;
+        if ((size_t)rc < vec.iov_len)
+            break;
+    }
+
+    return nread;
+}
+
+ssize_t Process::sys$writev(int fd, const struct iovec* iov, int iov_count)
+{
+    REQUIRE_PROMISE(stdio);
+    Vector<iovec, 32> vecs;
+    auto result = validate_and_copy_iovecs(iov, iov_count, vecs, false);
+    if (result.is_error())
+        return result;
+
+    auto description = file_description(fd);
+    if (!description)
+        return -EBADF;
+
+    if (!description->is_writable())
+        return -EBADF;
+
+    return do_writev(*description, vecs, {});
+}
+
+ssize_t Process::sys$readv(int fd, const struct iovec* iov, int iov_count)
+{
+    REQUIRE_PROMISE(stdio);
+    Vector<iovec, 32> vecs;
+    auto result = validate_and_copy_iovecs(iov, iov_count, vecs, true);
+    if (result.is_error())
+        return result;
+
+    auto description = file_description(fd);
+    if (!description)
+        return -EBADF;
+    if (!description->is_readable())
+        return -EBADF;
+    if (description->is_directory())
+        return -EISDIR;
+
+    return do_readv(*description, vecs, {});
+}
+
+ssize_t Process::sys$preadv(const Syscall::SC_preadv_params* user_params)
+{
+    REQUIRE_PROMISE(stdio);
+    Syscall::SC_preadv_params params;
+    if (!validate_read_and_copy_typed(&params, user_params))
+        return -EFAULT;
+    Vector<iovec, 32> vecs;
+    auto result = validate_and_copy_iovecs(params.iov, params.iov_count, vecs, true);
+    if (result.is_error())
+        return result;
+    if (params.offset < 0)
+        return -EINVAL;
+
+    auto description = file_description(params.fd);
+    if (!description)
+        return -EBADF;
+    if (!description->is_readable())
+        return -EBADF;
+    if (description->is_directory())
+        return -EISDIR;
+    if (!description->file().is_seekable())
+        return -ESPIPE;
+
+    return do_readv(*description, vecs, params.offset);
+}
+
+ssize_t Process::sys$pwritev(const Syscall::SC_pwritev_params* user_params)
+{
+    REQUIRE_PROMISE(stdio);
+    Syscall::SC_pwritev_params params;
+    if (!validate_read_and_copy_typed(&params, user_params))
+        return -EFAULT;
+    Vector<iovec, 32> vecs;
+    auto result = validate_and_copy_iovecs(params.iov, params.iov_count, vecs, false);
+    if (result.is_error())
+        return result;
+    if (params.offset < 0)
+        return -EINVAL;
+
+    auto description = file_description(params.fd);
+    if (!description)
+        return -EBADF;
+    if (!description->is_writable())
+        return -EBADF;
+    if (!description->file().is_seekable())
+        return -ESPIPE;
+
+    return do_writev(*description, vecs, params.offset);
+}
+
+ssize_t Process::do_write(FileDescription& description, const u8* data, int data_size, Optional<off_t> offset)
 {
     ssize_t nwritten = 0;
     if (!description.is_blocking()) {
@@ -1690,7 +1838,7 @@ ssize_t Process::do_write(FileDescription& description, const u8* data, int data
             return -EAGAIN;
     }
 
-    if (description.should_append()) {
+    if (!offset.has_value() && description.should_append()) {
 #ifdef IO_DEBUG
         dbg() << "seeking to end (O_APPEND)";
 #endif
@@ -1705,12 +1853,16 @@ ssize_t Process::do_write(FileDescription& description, const u8* data, int data
 #ifdef IO_DEBUG
             dbg() << "block write on " << description.absolute_path();
 #endif
-            if (Thread::current->block<Thread::WriteBlocker>(description) != Thread::BlockResult::WokeNormally) {
+            if (Thread::current()->block<Thread::WriteBlocker>(description) != Thread::BlockResult::WokeNormally) {
                 if (nwritten == 0)
                     return -EINTR;
             }
         }
-        ssize_t rc = description.write(data + nwritten, data_size - nwritten);
+        ssize_t rc;
+        if (offset.has_value())
+            rc = description.write_at(offset.value() + nwritten, data + nwritten, data_size - nwritten);
+        else
+            rc = description.write(data + nwritten, data_size - nwritten);
 #ifdef IO_DEBUG
         dbg() << "   -> write returned " << rc;
 #endif
@@ -1726,6 +1878,67 @@ ssize_t Process::do_write(FileDescription& description, const u8* data, int data
     return nwritten;
 }
 
+ssize_t Process::sys$sendfile(const Syscall::SC_sendfile_params* user_params)
+{
+    REQUIRE_PROMISE(stdio);
+    Syscall::SC_sendfile_params params;
+    if (!validate_read_and_copy_typed(&params, user_params))
+        return -EFAULT;
+
+    auto in_description = file_description(params.in_fd);
+    auto out_description = file_description(params.out_fd);
+    if (!in_description || !out_description)
+        return -EBADF;
+    if (!in_description->is_readable() || !out_description->is_writable())
+        return -EBADF;
+    // We read straight from the inode (and its page cache), so the source has to be a regular file.
+    auto* inode = in_description->inode();
+    if (!inode || !inode->metadata().is_regular_file())
+        return -EINVAL;
+
+    off_t offset;
+    if (params.offset) {
+        if (!validate_read_and_copy_typed(&offset, params.offset) || !validate_write_typed(params.offset))
+            return -EFAULT;
+        if (offset < 0)
+            return -EINVAL;
+    } else {
+        offset = in_description->offset();
+    }
+
+    size_t count = min(params.count, (size_t)NumericLimits<ssize_t>::max());
+    static constexpr size_t chunk_size = 64 * KB;
+    auto buffer = KBuffer::create_with_size(min(count, chunk_size));
+
+    ssize_t nsent = 0;
+    while ((size_t)nsent < count) {
+        ssize_t nread = inode->read_bytes_through_page_cache(offset, min(count - nsent, chunk_size), buffer.data(), in_description);
+        if (nread < 0) {
+            if (nsent == 0)
+                return nread;
+            break;
+        }
+        if (nread == 0)
+            break;
+        ssize_t nwritten = do_write(*out_description, buffer.data(), nread);
+        if (nwritten < 0) {
+            if (nsent == 0)
+                return nwritten;
+            break;
+        }
+        offset += nwritten;
+        nsent += nwritten;
+        if (nwritten < nread)
+            break;
+    }
+
+    if (params.offset)
+        copy_to_user(params.offset, &offset);
+    else
+        in_description->seek(offset, SEEK_SET);
+    return nsent;
+}
+
 ssize_t Process::sys$write(int fd, const u8* data, ssize_t size)
 {
     REQUIRE_PROMISE(stdio);
@@ -1766,15 +1979,22 @@ ssize_t Process::sys$read(int fd, u8* buffer, ssize_t size)
         return -EBADF;
     if (description->is_directory())
         return -EISDIR;
-    if (description->is_blocking()) {
-        if (!description->can_read()) {
-            if (Thread::current->block<Thread::ReadBlocker>(*description) != Thread::BlockResult::WokeNormally)
+    return do_read(*description, buffer, size);
+}
+
+ssize_t Process::do_read(FileDescription& description, u8* buffer, int size, Optional<off_t> offset)
+{
+    if (offset.has_value())
+        return description.read_at(offset.value(), buffer, size);
+    if (description.is_blocking()) {
+        if (!description.can_read()) {
+            if (Thread::current()->block<Thread::ReadBlocker>(description) != Thread::BlockResult::WokeNormally)
                 return -EINTR;
-            if (!description->can_read())
+            if (!description.can_read())
                 return -EAGAIN;
         }
     }
-    return description->read(buffer, size);
+    return description.read(buffer, size);
 }
 
 int Process::sys$close(int fd)
@@ -1787,7 +2007,7 @@ int Process::sys$close(int fd)
     if (!description)
         return -EBADF;
     int rc = description->close();
-    m_fds[fd] = {};
+    clear_fd(fd);
     return rc;
 }
 
@@ -1837,13 +2057,13 @@ int Process::sys$fcntl(int fd, int cmd, u32 arg)
         int new_fd = alloc_fd(arg_fd);
         if (new_fd < 0)
             return new_fd;
-        m_fds[new_fd].set(*description);
+        set_fd(new_fd, *description);
         return new_fd;
     }
     case F_GETFD:
         return m_fds[fd].flags;
     case F_SETFD:
-        m_fds[fd].flags = arg;
+        set_fd_flags(fd, arg);
         break;
     case F_GETFL:
         return description->file_flags();
@@ -1861,15 +2081,14 @@ int Process::sys$fcntl(int fd, int cmd, u32 arg)
 int Process::sys$fstat(int fd, stat* user_statbuf)
 {
     REQUIRE_PROMISE(stdio);
-    if (!validate_write_typed(user_statbuf))
-        return -EFAULT;
     auto description = file_description(fd);
     if (!description)
         return -EBADF;
     stat buffer;
     memset(&buffer, 0, sizeof(buffer));
     int rc = description->fstat(buffer);
-    copy_to_user(user_statbuf, &buffer);
+    if (!copy_to_user(user_statbuf, &buffer))
+        return -EFAULT;
     return rc;
 }
 
@@ -1884,7 +2103,20 @@ int Process::sys$stat(const Syscall::SC_stat_params* user_params)
     auto path = get_syscall_path_argument(params.path);
     if (path.is_error())
         return path.error();
-    auto metadata_or_error = VFS::the().lookup_metadata(path.value(), current_directory(), params.follow_symlinks ? 0 : O_NOFOLLOW_NOERROR);
+    RefPtr<Custody> base;
+    if (params.dirfd == AT_FDCWD) {
+        base = current_directory();
+    } else {
+        auto base_description = file_description(params.dirfd);
+        if (!base_description)
+            return -EBADF;
+        if (!base_description->is_directory())
+            return -ENOTDIR;
+        if (!base_description->custody())
+            return -EINVAL;
+        base = base_description->custody();
+    }
+    auto metadata_or_error = VFS::the().lookup_metadata(path.value(), *base, params.follow_symlinks ? 0 : O_NOFOLLOW_NOERROR);
     if (metadata_or_error.is_error())
         return metadata_or_error.error();
     stat statbuf;
@@ -2073,7 +2305,7 @@ int Process::sys$open(const Syscall::SC_open_params* user_params)
         return -ENXIO;
 
     u32 fd_flags = (options & O_CLOEXEC) ? FD_CLOEXEC : 0;
-    m_fds[fd].set(move(description), fd_flags);
+    set_fd(fd, move(description), fd_flags);
     return fd;
 }
 
@@ -2086,6 +2318,29 @@ int Process::alloc_fd(int first_candidate_fd)
     return -EMFILE;
 }
 
+void Process::set_fd(int fd, NonnullRefPtr<FileDescription>&& description, u32 flags)
+{
+    // Whatever was there before may be the last reference, which we'd rather not drop with interrupts disabled.
+    RefPtr<FileDescription> old_description;
+    InterruptDisabler disabler;
+    old_description = move(m_fds[fd].description);
+    m_fds[fd].set(move(description), flags);
+}
+
+void Process::set_fd_flags(int fd, u32 flags)
+{
+    InterruptDisabler disabler;
+    m_fds[fd].flags = flags;
+}
+
+void Process::clear_fd(int fd)
+{
+    RefPtr<FileDescription> old_description;
+    InterruptDisabler disabler;
+    old_description = move(m_fds[fd].description);
+    m_fds[fd].flags = 0;
+}
+
 int Process::sys$pipe(int pipefd[2], int flags)
 {
     REQUIRE_PROMISE(stdio);
@@ -2101,13 +2356,15 @@ int Process::sys$pipe(int pipefd[2], int flags)
     auto fifo = FIFO::create(m_uid);
 
     int reader_fd = alloc_fd();
-    m_fds[reader_fd].set(fifo->open_direction(FIFO::Direction::Reader), fd_flags);
-    m_fds[reader_fd].description->set_readable(true);
+    auto reader_description = fifo->open_direction(FIFO::Direction::Reader);
+    reader_description->set_readable(true);
+    set_fd(reader_fd, move(reader_description), fd_flags);
     copy_to_user(&pipefd[0], &reader_fd);
 
     int writer_fd = alloc_fd();
-    m_fds[writer_fd].set(fifo->open_direction(FIFO::Direction::Writer), fd_flags);
-    m_fds[writer_fd].description->set_writable(true);
+    auto writer_description = fifo->open_direction(FIFO::Direction::Writer);
+    writer_description->set_writable(true);
+    set_fd(writer_fd, move(writer_description), fd_flags);
     copy_to_user(&pipefd[1], &writer_fd);
 
     return 0;
@@ -2129,6 +2386,7 @@ int Process::sys$setuid(uid_t uid)
     REQUIRE_PROMISE(id);
     if (uid != m_uid && !is_superuser())
         return -EPERM;
+    InterruptDisabler disabler;
     m_uid = uid;
     m_euid = uid;
     return 0;
@@ -2139,6 +2397,7 @@ int Process::sys$setgid(gid_t gid)
     REQUIRE_PROMISE(id);
     if (gid != m_gid && !is_superuser())
         return -EPERM;
+    InterruptDisabler disabler;
     m_gid = gid;
     m_egid = gid;
     return 0;
@@ -2148,14 +2407,24 @@ unsigned Process::sys$alarm(unsigned seconds)
 {
     REQUIRE_PROMISE(stdio);
     unsigned previous_alarm_remaining = 0;
-    if (m_alarm_deadline && m_alarm_deadline > g_uptime) {
-        previous_alarm_remaining = (m_alarm_deadline - g_uptime) / TimeManagement::the().ticks_per_second();
+    u64 now = TimeManagement::the().monotonic_time_ns();
+    if (m_alarm_timer_id) {
+        if (m_alarm_deadline > now)
+            previous_alarm_remaining = (m_alarm_deadline - now) / 1'000'000'000;
+        TimerQueue::the().cancel_timer(m_alarm_timer_id);
+        m_alarm_timer_id = 0;
     }
-    if (!seconds) {
-        m_alarm_deadline = 0;
+    if (!seconds)
         return previous_alarm_remaining;
-    }
-    m_alarm_deadline = g_uptime + seconds * TimeManagement::the().ticks_per_second();
+    m_alarm_deadline = now + (u64)seconds * 1'000'000'000;
+    auto timer = make<Timer>();
+    timer->expires = m_alarm_deadline;
+    timer->callback = [this] {
+        m_alarm_timer_id = 0;
+        if (!is_dead())
+            send_signal(SIGALRM, nullptr);
+    };
+    m_alarm_timer_id = TimerQueue::the().add_timer(move(timer));
     return previous_alarm_remaining;
 }
 
@@ -2256,9 +2525,9 @@ KResult Process::do_killself(int signal)
     if (signal == 0)
         return KSuccess;
 
-    if (!Thread::current->should_ignore_signal(signal)) {
-        Thread::current->send_signal(signal, this);
-        (void)Thread::current->block<Thread::SemiPermanentBlocker>(Thread::SemiPermanentBlocker::Reason::Signal);
+    if (!Thread::current()->should_ignore_signal(signal)) {
+        Thread::current()->send_signal(signal, this);
+        (void)Thread::current()->block<Thread::SemiPermanentBlocker>(Thread::SemiPermanentBlocker::Reason::Signal);
     }
 
     return KSuccess;
@@ -2295,8 +2564,8 @@ int Process::sys$usleep(useconds_t usec)
     REQUIRE_PROMISE(stdio);
     if (!usec)
         return 0;
-    u64 wakeup_time = Thread::current->sleep(usec / 1000);
-    if (wakeup_time > g_uptime)
+    u64 deadline = Thread::current()->sleep((u64)usec * 1000);
+    if (deadline > TimeManagement::the().monotonic_time_ns())
         return -EINTR;
     return 0;
 }
@@ -2306,11 +2575,10 @@ int Process::sys$sleep(unsigned seconds)
     REQUIRE_PROMISE(stdio);
     if (!seconds)
         return 0;
-    u64 wakeup_time = Thread::current->sleep(seconds * TimeManagement::the().ticks_per_second());
-    if (wakeup_time > g_uptime) {
-        u32 ticks_left_until_original_wakeup_time = wakeup_time - g_uptime;
-        return ticks_left_until_original_wakeup_time / TimeManagement::the().ticks_per_second();
-    }
+    u64 deadline = Thread::current()->sleep((u64)seconds * 1'000'000'000);
+    u64 now = TimeManagement::the().monotonic_time_ns();
+    if (deadline > now)
+        return (deadline - now) / 1'000'000'000;
     return 0;
 }
 
@@ -2340,10 +2608,9 @@ void kgettimeofday(timeval& tv)
 int Process::sys$gettimeofday(timeval* user_tv)
 {
     REQUIRE_PROMISE(stdio);
-    if (!validate_write_typed(user_tv))
-        return -EFAULT;
     auto tv = kgettimeofday();
-    copy_to_user(user_tv, &tv);
+    if (!copy_to_user(user_tv, &tv))
+        return -EFAULT;
     return 0;
 }
 
@@ -2423,6 +2690,9 @@ siginfo_t Process::reap(Process& process)
 #endif
         ASSERT(process.is_dead());
         g_processes->remove(&process);
+
+        // Anyone else waiting for this particular process is out of luck now.
+        process.unblock_waiters();
     }
     delete &process;
     return siginfo;
@@ -2448,7 +2718,7 @@ KResultOr<siginfo_t> Process::do_waitid(idtype_t idtype, int id, int options)
         return KResult(-EINVAL);
     }
 
-    if (Thread::current->block<Thread::WaitBlocker>(options, waitee_pid) != Thread::BlockResult::WokeNormally)
+    if (Thread::current()->block<Thread::WaitBlocker>(options, waitee_pid) != Thread::BlockResult::WokeNormally)
         return KResult(-EINTR);
 
     InterruptDisabler disabler;
@@ -2570,6 +2840,7 @@ pid_t Process::sys$setsid()
         return -EPERM;
     m_sid = m_pid;
     m_pgid = m_pid;
+    m_scheduling_group = SchedulingGroup::create();
     m_tty = nullptr;
     return m_sid;
 }
@@ -2637,6 +2908,15 @@ int Process::sys$setpgid(pid_t specified_pid, pid_t specified_pgid)
         return -EPERM;
     }
     // FIXME: There are more EPERM conditions to check for here..
+    if (new_pgid != process->m_pgid) {
+        // Join the group's CPU share, or start a new one if we're the first one in it.
+        RefPtr<SchedulingGroup> scheduling_group;
+        Process::for_each_in_pgrp(new_pgid, [&](auto& other_process) {
+            scheduling_group = other_process.m_scheduling_group;
+            return IterationDecision::Break;
+        });
+        process->m_scheduling_group = scheduling_group ? scheduling_group.release_nonnull() : SchedulingGroup::create();
+    }
     process->m_pgid = new_pgid;
     return 0;
 }
@@ -2659,7 +2939,7 @@ int Process::sys$dup(int old_fd)
     int new_fd = alloc_fd();
     if (new_fd < 0)
         return new_fd;
-    m_fds[new_fd].set(*description);
+    set_fd(new_fd, *description);
     return new_fd;
 }
 
@@ -2671,7 +2951,7 @@ int Process::sys$dup2(int old_fd, int new_fd)
         return -EBADF;
     if (new_fd < 0 || new_fd >= m_max_open_file_descriptors)
         return -EINVAL;
-    m_fds[new_fd].set(*description);
+    set_fd(new_fd, *description);
     return new_fd;
 }
 
@@ -2681,7 +2961,7 @@ int Process::sys$sigprocmask(int how, const sigset_t* set, sigset_t* old_set)
     if (old_set) {
         if (!validate_write_typed(old_set))
             return -EFAULT;
-        copy_to_user(old_set, &Thread::current->m_signal_mask);
+        copy_to_user(old_set, &Thread::current()->m_signal_mask);
     }
     if (set) {
         if (!validate_read_typed(set))
@@ -2690,13 +2970,13 @@ int Process::sys$sigprocmask(int how, const sigset_t* set, sigset_t* old_set)
         copy_from_user(&set_value, set);
         switch (how) {
         case SIG_BLOCK:
-            Thread::current->m_signal_mask &= ~set_value;
+            Thread::current()->m_signal_mask &= ~set_value;
             break;
         case SIG_UNBLOCK:
-            Thread::current->m_signal_mask |= set_value;
+            Thread::current()->m_signal_mask |= set_value;
             break;
         case SIG_SETMASK:
-            Thread::current->m_signal_mask = set_value;
+            Thread::current()->m_signal_mask = set_value;
             break;
         default:
             return -EINVAL;
@@ -2710,7 +2990,7 @@ int Process::sys$sigpending(sigset_t* set)
     REQUIRE_PROMISE(stdio);
     if (!validate_write_typed(set))
         return -EFAULT;
-    copy_to_user(set, &Thread::current->m_pending_signals);
+    copy_to_user(set, &Thread::current()->m_pending_signals);
     return 0;
 }
 
@@ -2722,7 +3002,7 @@ int Process::sys$sigaction(int signum, const sigaction* act, sigaction* old_act)
     if (!validate_read_typed(act))
         return -EFAULT;
     InterruptDisabler disabler; // FIXME: This should use a narrower lock. Maybe a way to ignore signals temporarily?
-    auto& action = Thread::current->m_signal_action_data[signum];
+    auto& action = Thread::current()->m_signal_action_data[signum];
     if (old_act) {
         if (!validate_write_typed(old_act))
             return -EFAULT;
@@ -2739,17 +3019,21 @@ int Process::sys$getgroups(ssize_t count, gid_t* user_gids)
     REQUIRE_PROMISE(stdio);
     if (count < 0)
         return -EINVAL;
+
+    // This runs without the big lock, so take a snapshot before looking at it.
+    Vector<gid_t> gids;
+    {
+        InterruptDisabler disabler;
+        gids.append(m_extra_gids.data(), m_extra_gids.size());
+    }
+
     if (!count)
-        return m_extra_gids.size();
-    if (count != (int)m_extra_gids.size())
+        return gids.size();
+    if (count != (int)gids.size())
         return -EINVAL;
-    if (!validate_write_typed(user_gids, m_extra_gids.size()))
+    if (!validate_write_typed(user_gids, gids.size()))
         return -EFAULT;
 
-    Vector<gid_t> gids;
-    for (auto gid : m_extra_gids)
-        gids.append(gid);
-
     copy_to_user(user_gids, gids.data(), sizeof(gid_t) * count);
     return 0;
 }
@@ -2765,6 +3049,7 @@ int Process::sys$setgroups(ssize_t count, const gid_t* user_gids)
         return -EFAULT;
 
     if (!count) {
+        InterruptDisabler disabler;
         m_extra_gids.clear();
         return 0;
     }
@@ -2779,6 +3064,7 @@ int Process::sys$setgroups(ssize_t count, const gid_t* user_gids)
             unique_extra_gids.set(gid);
     }
 
+    InterruptDisabler disabler;
     m_extra_gids.resize(unique_extra_gids.size());
     size_t i = 0;
     for (auto& gid : unique_extra_gids) {
@@ -2902,7 +3188,7 @@ int Process::sys$select(const Syscall::SC_select_params* params)
 #endif
 
     if (!timeout || select_has_timeout) {
-        if (Thread::current->block<Thread::SelectBlocker>(computed_timeout, select_has_timeout, rfds, wfds, efds) != Thread::BlockResult::WokeNormally)
+        if (Thread::current()->block<Thread::SelectBlocker>(computed_timeout, select_has_timeout, rfds, wfds, efds) != Thread::BlockResult::WokeNormally)
             return -EINTR;
         // While we blocked, the process lock was dropped. This gave other threads
         // the opportunity to mess with the memory. For example, it could free the
@@ -2974,7 +3260,7 @@ int Process::sys$poll(pollfd* fds, int nfds, int timeout)
 #endif
 
     if (has_timeout || timeout < 0) {
-        if (Thread::current->block<Thread::SelectBlocker>(actual_timeout, has_timeout, rfds, wfds, Thread::SelectBlocker::FDVector()) != Thread::BlockResult::WokeNormally)
+        if (Thread::current()->block<Thread::SelectBlocker>(actual_timeout, has_timeout, rfds, wfds, Thread::SelectBlocker::FDVector()) != Thread::BlockResult::WokeNormally)
             return -EINTR;
     }
 
@@ -2999,6 +3285,109 @@ int Process::sys$poll(pollfd* fds, int nfds, int timeout)
     return fds_with_revents;
 }
 
+int Process::sys$epoll_create(int flags)
+{
+    REQUIRE_PROMISE(stdio);
+    if ((flags & EPOLL_CLOEXEC) != flags)
+        return -EINVAL;
+
+    int fd = alloc_fd();
+    if (fd < 0)
+        return fd;
+
+    auto description = FileDescription::create(*EventQueue::create());
+    description->set_readable(true);
+    set_fd(fd, move(description), (flags & EPOLL_CLOEXEC) ? FD_CLOEXEC : 0);
+    return fd;
+}
+
+int Process::sys$epoll_ctl(const Syscall::SC_epoll_ctl_params* user_params)
+{
+    REQUIRE_PROMISE(stdio);
+    Syscall::SC_epoll_ctl_params params;
+    if (!validate_read_and_copy_typed(&params, user_params))
+        return -EFAULT;
+
+    auto queue_description = file_description(params.epfd);
+    if (!queue_description)
+        return -EBADF;
+    if (!queue_description->file().is_event_queue())
+        return -EINVAL;
+    auto& queue = static_cast<EventQueue&>(queue_description->file());
+
+    auto description = file_description(params.fd);
+    if (!description)
+        return -EBADF;
+
+    epoll_event event;
+    if (params.op != EPOLL_CTL_DEL) {
+        if (!validate_read_and_copy_typed(&event, params.event))
+            return -EFAULT;
+    }
+
+    switch (params.op) {
+    case EPOLL_CTL_ADD:
+        return queue.add(params.fd, *description, event);
+    case EPOLL_CTL_MOD:
+        return queue.modify(params.fd, event);
+    case EPOLL_CTL_DEL:
+        return queue.remove(params.fd);
+    default:
+        return -EINVAL;
+    }
+}
+
+int Process::sys$epoll_wait(const Syscall::SC_epoll_wait_params* user_params)
+{
+    REQUIRE_PROMISE(stdio);
+    Syscall::SC_epoll_wait_params params;
+    if (!validate_read_and_copy_typed(&params, user_params))
+        return -EFAULT;
+
+    if (params.max_events <= 0)
+        return -EINVAL;
+    // Callers get the rest on their next wait, so there's no need to honor huge buffers.
+    size_t max_events = min(params.max_events, 1024);
+    if (!validate_write_typed(params.events, max_events))
+        return -EFAULT;
+
+    auto queue_description = file_description(params.epfd);
+    if (!queue_description)
+        return -EBADF;
+    if (!queue_description->file().is_event_queue())
+        return -EINVAL;
+    auto& queue = static_cast<EventQueue&>(queue_description->file());
+
+    timeval deadline;
+    bool has_timeout = params.timeout >= 0;
+    if (has_timeout) {
+        timeval tvtimeout { params.timeout / 1000, (params.timeout % 1000) * 1000 };
+        timeval_add(Scheduler::time_since_boot(), tvtimeout, deadline);
+    }
+
+    // We only block on the queue itself, which gets woken by the files it watches.
+    Thread::SelectBlocker::FDVector rfds;
+    rfds.append(params.epfd);
+    Thread::SelectBlocker::FDVector no_fds;
+
+    Vector<epoll_event, 32> events;
+    for (;;) {
+        queue.collect_ready_events(events, max_events);
+        if (!events.is_empty() || params.timeout == 0)
+            break;
+        if (Thread::current()->block<Thread::SelectBlocker>(deadline, has_timeout, rfds, no_fds, no_fds) != Thread::BlockResult::WokeNormally)
+            return -EINTR;
+        if (has_timeout) {
+            // Either we timed out, or something was ready when we woke; don't block again either way.
+            queue.collect_ready_events(events, max_events);
+            break;
+        }
+    }
+
+    copy_to_user(params.events, events.data(), events.size() * sizeof(epoll_event));
+    return events.size();
+}
+
 Custody& Process::current_directory()
 {
     if (!m_cwd)
@@ -3111,7 +3500,7 @@ int Process::sys$chown(const Syscall::SC_chown_params* user_params)
 
 void Process::finalize()
 {
-    ASSERT(Thread::current == g_finalizer);
+    ASSERT(Thread::current() == g_finalizer);
 #ifdef PROCESS_DEBUG
     dbg() << "Finalizing process " << *this;
 #endif
@@ -3148,6 +3537,22 @@ void Process::finalize()
     m_regions.clear();
 
     m_dead = true;
+    unblock_waiters();
+}
+
+void Process::unblock_waiters()
+{
+    InterruptDisabler disabler;
+    if (auto* parent = Process::from_pid(m_ppid))
+        parent->wait_block_condition().unblock();
+
+    for_each_thread([](Thread& thread) {
+        if (auto* tracer = thread.tracer()) {
+            if (auto* tracer_process = Process::from_pid(tracer->tracer_pid()))
+                tracer_process->wait_block_condition().unblock();
+        }
+        return IterationDecision::Continue;
+    });
 }
 
 void Process::die()
@@ -3267,7 +3672,7 @@ int Process::sys$socket(int domain, int type, int protocol)
         flags |= FD_CLOEXEC;
     if (type & SOCK_NONBLOCK)
         description->set_blocking(false);
-    m_fds[fd].set(move(description), flags);
+    set_fd(fd, move(description), flags);
     return fd;
 }
 
@@ -3321,7 +3726,7 @@ int Process::sys$accept(int accepting_socket_fd, sockaddr* user_address, socklen
     auto& socket = *accepting_socket_description->socket();
     if (!socket.can_accept()) {
         if (accepting_socket_description->is_blocking()) {
-            if (Thread::current->block<Thread::AcceptBlocker>(*accepting_socket_description) != Thread::BlockResult::WokeNormally)
+            if (Thread::current()->block<Thread::AcceptBlocker>(*accepting_socket_description) != Thread::BlockResult::WokeNormally)
                 return -EINTR;
         } else {
             return -EAGAIN;
@@ -3342,7 +3747,7 @@ int Process::sys$accept(int accepting_socket_fd, sockaddr* user_address, socklen
     // NOTE: The accepted socket inherits fd flags from the accepting socket.
     //       I'm not sure if this matches other systems but it makes sense to me.
     accepted_socket_description->set_blocking(accepting_socket_description->is_blocking());
-    m_fds[accepted_socket_fd].set(move(accepted_socket_description), m_fds[accepting_socket_fd].flags);
+    set_fd(accepted_socket_fd, move(accepted_socket_description), m_fds[accepting_socket_fd].flags);
 
     // NOTE: Moving this state to Completed is what causes connect() to unblock on the client side.
     accepted_socket->set_setup_state(Socket::SetupState::Completed);
@@ -3388,6 +3793,74 @@ int Process::sys$shutdown(int sockfd, int how)
     return socket.shutdown(how);
 }
 
+int Process::sys$sendfds(int sockfd, const int* user_fds, int count)
+{
+    REQUIRE_PROMISE(sendfd);
+    if (count <= 0 || (size_t)count > LocalSocket::max_queued_fds)
+        return -EINVAL;
+    if (!validate_read(user_fds, count * sizeof(int)))
+        return -EFAULT;
+    auto socket_description = file_description(sockfd);
+    if (!socket_description)
+        return -EBADF;
+    if (!socket_description->is_socket())
+        return -ENOTSOCK;
+    auto& socket = *socket_description->socket();
+    if (!socket.is_local())
+        return -EAFNOSUPPORT;
+
+    int fds[LocalSocket::max_queued_fds];
+    copy_from_user(fds, user_fds, count * sizeof(int));
+
+    NonnullRefPtrVector<FileDescription> descriptions;
+    for (int i = 0; i < count; ++i) {
+        auto description = file_description(fds[i]);
+        if (!description)
+            return -EBADF;
+        descriptions.append(description.release_nonnull());
+    }
+    return static_cast<LocalSocket&>(socket).sendfds(*socket_description, descriptions);
+}
+
+int Process::sys$recvfds(int sockfd, int* user_fds, int count)
+{
+    REQUIRE_PROMISE(recvfd);
+    if (count <= 0)
+        return -EINVAL;
+    if (!validate_write(user_fds, count * sizeof(int)))
+        return -EFAULT;
+    auto socket_description = file_description(sockfd);
+    if (!socket_description)
+        return -EBADF;
+    if (!socket_description->is_socket())
+        return -ENOTSOCK;
+    auto& socket = *socket_description->socket();
+    if (!socket.is_local())
+        return -EAFNOSUPPORT;
+
+    // Only take as many as we have room for, so nothing gets dropped on the floor.
+    size_t free_fd_count = 0;
+    for (int fd = 0; fd < (int)m_max_open_file_descriptors && free_fd_count < (size_t)count; ++fd) {
+        if (!m_fds[fd])
+            ++free_fd_count;
+    }
+    if (!free_fd_count)
+        return -EMFILE;
+
+    NonnullRefPtrVector<FileDescription> descriptions;
+    auto result = static_cast<LocalSocket&>(socket).recvfds(*socket_description, descriptions, free_fd_count);
+    if (result.is_error())
+        return result;
+
+    for (size_t i = 0; i < descriptions.size(); ++i) {
+        int new_fd = alloc_fd();
+        ASSERT(new_fd >= 0);
+        set_fd(new_fd, descriptions[i]);
+        copy_to_user(&user_fds[i], &new_fd);
+    }
+    return descriptions.size();
+}
+
 ssize_t Process::sys$sendto(const Syscall::SC_sendto_params* user_params)
 {
     REQUIRE_PROMISE(stdio);
@@ -3522,7 +3995,7 @@ int Process::sys$sched_setparam(int tid, const struct sched_param* param)
     copy_from_user(&desired_priority, &param->sched_priority);
 
     InterruptDisabler disabler;
-    auto* peer = Thread::current;
+    auto* peer = Thread::current();
     if (tid != 0)
         peer = Thread::from_tid(tid);
 
@@ -3546,7 +4019,7 @@ int Process::sys$sched_getparam(pid_t pid, struct sched_param* param)
         return -EFAULT;
 
     InterruptDisabler disabler;
-    auto* peer = Thread::current;
+    auto* peer = Thread::current();
     if (pid != 0)
         peer = Thread::from_tid(pid);
 
@@ -3557,7 +4030,150 @@ int Process::sys$sched_getparam(pid_t pid, struct sched_param* param)
         return -EPERM;
 
     int priority = peer->priority();
+    int group_weight = peer->process().scheduling_group().weight();
     copy_to_user(&param->sched_priority, &priority);
+    copy_to_user(&param->sched_group_weight, &group_weight);
+    return 0;
+}
+
+int Process::sys$sched_setscheduler(pid_t tid, int policy, const struct sched_param* user_param)
+{
+    REQUIRE_PROMISE(proc);
+    sched_param param;
+    if (!validate_read_and_copy_typed(&param, user_param))
+        return -EFAULT;
+
+    InterruptDisabler disabler;
+    auto* peer = Thread::current();
+    if (tid != 0)
+        peer = Thread::from_tid(tid);
+
+    if (!peer)
+        return -ESRCH;
+
+    if (!is_superuser() && m_euid != peer->process().m_uid && m_uid != peer->process().m_uid)
+        return -EPERM;
+
+    switch (policy) {
+    case SCHED_FIFO:
+    case SCHED_RR:
+        // Real-time threads run before everyone else, so only the superuser gets to make them. One that already is
+        // real-time may switch classes or step down though, so real-time services can sort out their own threads.
+        if (!is_superuser() && (!peer->is_realtime() || (u32)param.sched_priority > peer->priority()))
+            return -EPERM;
+        break;
+    case SCHED_OTHER:
+    case SCHED_BATCH:
+        break;
+    default:
+        return -EINVAL;
+    }
+
+    if (param.sched_priority < THREAD_PRIORITY_MIN || param.sched_priority > THREAD_PRIORITY_MAX)
+        return -EINVAL;
+
+    // A weight of zero leaves the process group's share of the CPU alone.
+    auto& scheduling_group = peer->process().scheduling_group();
+    if (param.sched_group_weight < 0 || (u32)param.sched_group_weight > SchedulingGroup::max_weight)
+        return -EINVAL;
+    if (!is_superuser() && (u32)param.sched_group_weight > scheduling_group.weight())
+        return -EPERM;
+
+    peer->set_scheduling_policy(policy);
+    peer->set_priority((u32)param.sched_priority);
+    if (param.sched_group_weight)
+        scheduling_group.set_weight((u32)param.sched_group_weight);
+
+    // Move it to the ready queue for its (possibly) new class.
+    if (peer->state() == Thread::Runnable) {
+        g_scheduler_data->dequeue_ready_thread(*peer);
+        g_scheduler_data->enqueue_ready_thread(*peer);
+    }
+    return 0;
+}
+
+int Process::sys$sched_getscheduler(pid_t tid)
+{
+    REQUIRE_PROMISE(proc);
+    InterruptDisabler disabler;
+    auto* peer = Thread::current();
+    if (tid != 0)
+        peer = Thread::from_tid(tid);
+
+    if (!peer)
+        return -ESRCH;
+
+    if (!is_superuser() && m_euid != peer->process().m_uid && m_uid != peer->process().m_uid)
+        return -EPERM;
+
+    return peer->scheduling_policy();
+}
+
+int Process::sys$sched_setaffinity(pid_t tid, size_t cpusetsize, const cpu_set_t* user_mask)
+{
+    REQUIRE_PROMISE(proc);
+    if (cpusetsize != sizeof(cpu_set_t))
+        return -EINVAL;
+    cpu_set_t mask;
+    if (!validate_read_and_copy_typed(&mask, user_mask))
+        return -EFAULT;
+
+    InterruptDisabler disabler;
+    auto* peer = Thread::current();
+    if (tid != 0)
+        peer = Thread::from_tid(tid);
+
+    if (!peer)
+        return -ESRCH;
+
+    if (!is_superuser() && m_euid != peer->process().m_uid && m_uid != peer->process().m_uid)
+        return -EPERM;
+
+    // The thread has to be able to run somewhere.
+    u32 online_mask = 0;
+    Processor::for_each([&](Processor& processor) {
+        if (processor.is_online())
+            online_mask |= 1u << processor.id();
+        return IterationDecision::Continue;
+    });
+    if (!(mask.__bits & online_mask))
+        return -EINVAL;
+
+    peer->set_affinity_mask(mask.__bits);
+
+    // Move it over to a CPU it's allowed on. A running thread moves at its next scheduling pass,
+    // which is right away if it's us.
+    if (peer->state() == Thread::Runnable) {
+        g_scheduler_data->dequeue_ready_thread(*peer);
+        g_scheduler_data->enqueue_ready_thread(*peer);
+    } else if (peer == Thread::current() && !peer->can_run_on(Processor::current().id())) {
+        Scheduler::yield();
+    }
+    return 0;
+}
+
+int Process::sys$sched_getaffinity(pid_t tid, size_t cpusetsize, cpu_set_t* user_mask)
+{
+    REQUIRE_PROMISE(proc);
+    if (cpusetsize != sizeof(cpu_set_t))
+        return -EINVAL;
+    if (!validate_write_typed(user_mask))
+        return -EFAULT;
+
+    InterruptDisabler disabler;
+    auto* peer = Thread::current();
+    if (tid != 0)
+        peer = Thread::from_tid(tid);
+
+    if (!peer)
+        return -ESRCH;
+
+    if (!is_superuser() && m_euid != peer->process().m_uid && m_uid != peer->process().m_uid)
+        return -EPERM;
+
+    cpu_set_t mask;
+    mask.__bits = peer->affinity_mask();
+    copy_to_user(user_mask, &mask);
     return 0;
 }
 
@@ -3676,6 +4292,28 @@ int Process::sys$shbuf_allow_pid(int shbuf_id, pid_t peer_pid)
     return 0;
 }
 
+int Process::sys$shbuf_hand_over(int shbuf_id, pid_t peer_pid)
+{
+    REQUIRE_PROMISE(shared_buffer);
+    if (!peer_pid || peer_pid < 0 || peer_pid == m_pid)
+        return -EINVAL;
+    LOCKER(shared_buffers().lock());
+    auto it = shared_buffers().resource().find(shbuf_id);
+    if (it == shared_buffers().resource().end())
+        return -EINVAL;
+    auto& shared_buffer = *(*it).value;
+    if (!shared_buffer.is_shared_with(m_pid))
+        return -EPERM;
+    {
+        InterruptDisabler disabler;
+        auto* peer = Process::from_pid(peer_pid);
+        if (!peer)
+            return -ESRCH;
+    }
+    shared_buffer.hand_over_to(peer_pid);
+    return 0;
+}
+
 int Process::sys$shbuf_allow_all(int shbuf_id)
 {
     REQUIRE_PROMISE(shared_buffer);
@@ -3833,6 +4471,12 @@ int Process::sys$create_thread(void* (*entry)(void*), const Syscall::SC_create_t
     thread->set_name(builder.to_string());
 
     thread->set_priority(requested_thread_priority);
+    thread->set_affinity_mask(Thread::current()->affinity_mask());
+    // Real-time threads spawn more of their kind, like they do with fork().
+    if (Thread::current()->is_realtime()) {
+        thread->set_scheduling_policy(Thread::current()->scheduling_policy());
+        thread->set_priority(Thread::current()->priority());
+    }
     thread->set_joinable(is_thread_joinable);
 
     auto& tss = thread->tss();
@@ -3850,10 +4494,10 @@ void Process::sys$exit_thread(void* exit_value)
 {
     REQUIRE_PROMISE(thread);
     cli();
-    Thread::current->m_exit_value = exit_value;
-    Thread::current->set_should_die();
+    Thread::current()->m_exit_value = exit_value;
+    Thread::current()->set_should_die();
     big_lock().force_unlock_if_locked();
-    Thread::current->die_if_needed();
+    Thread::current()->die_if_needed();
     ASSERT_NOT_REACHED();
 }
 
@@ -3883,13 +4527,13 @@ int Process::sys$join_thread(int tid, void** exit_value)
     if (!thread || thread->pid() != pid())
         return -ESRCH;
 
-    if (thread == Thread::current)
+    if (thread == Thread::current())
         return -EDEADLK;
 
-    if (thread->m_joinee == Thread::current)
+    if (thread->m_joinee == Thread::current())
         return -EDEADLK;
 
-    ASSERT(thread->m_joiner != Thread::current);
+    ASSERT(thread->m_joiner != Thread::current());
     if (thread->m_joiner)
         return -EINVAL;
 
@@ -3900,15 +4544,15 @@ int Process::sys$join_thread(int tid, void** exit_value)
 
     // NOTE: pthread_join() cannot be interrupted by signals. Only by death.
     for (;;) {
-        auto result = Thread::current->block<Thread::JoinBlocker>(*thread, joinee_exit_value);
+        auto result = Thread::current()->block<Thread::JoinBlocker>(*thread, joinee_exit_value);
         if (result == Thread::BlockResult::InterruptedByDeath) {
             // NOTE: This cleans things up so that Thread::finalize() won't
             //       get confused about a missing joiner when finalizing the joinee.
             InterruptDisabler disabler_t;
 
-            if (Thread::current->m_joinee) {
-                Thread::current->m_joinee->m_joiner = nullptr;
-                Thread::current->m_joinee = nullptr;
+            if (Thread::current()->m_joinee) {
+                Thread::current()->m_joinee->m_joiner = nullptr;
+                Thread::current()->m_joinee = nullptr;
             }
 
             break;
@@ -3966,7 +4610,7 @@ int Process::sys$get_thread_name(int tid, char* buffer, size_t buffer_size)
 int Process::sys$gettid()
 {
     REQUIRE_PROMISE(stdio);
-    return Thread::current->tid();
+    return Thread::current()->tid();
 }
 
 int Process::sys$donate(int tid)
@@ -4031,8 +4675,9 @@ int Process::sys$watch_file(const char* user_path, size_t path_length)
     if (fd < 0)
         return fd;
 
-    m_fds[fd].set(FileDescription::create(*InodeWatcher::create(inode)));
-    m_fds[fd].description->set_readable(true);
+    auto description = FileDescription::create(*InodeWatcher::create(inode));
+    description->set_readable(true);
+    set_fd(fd, move(description));
     return fd;
 }
 
@@ -4317,17 +4962,16 @@ int Process::sys$setkeymap(const Syscall::SC_setkeymap_params* user_params)
 int Process::sys$clock_gettime(clockid_t clock_id, timespec* user_ts)
 {
     REQUIRE_PROMISE(stdio);
-    if (!validate_write_typed(user_ts))
-        return -EFAULT;
-
     timespec ts;
     memset(&ts, 0, sizeof(ts));
 
     switch (clock_id) {
-    case CLOCK_MONOTONIC:
-        ts.tv_sec = TimeManagement::the().seconds_since_boot();
-        ts.tv_nsec = TimeManagement::the().ticks_this_second() * 1000000;
+    case CLOCK_MONOTONIC: {
+        u64 now = TimeManagement::the().monotonic_time_ns();
+        ts.tv_sec = now / 1'000'000'000;
+        ts.tv_nsec = now % 1'000'000'000;
         break;
+    }
     case CLOCK_REALTIME:
         ts.tv_sec = TimeManagement::the().epoch_time();
         ts.tv_nsec = TimeManagement::the().ticks_this_second() * 1000000;
@@ -4336,10 +4980,22 @@ int Process::sys$clock_gettime(clockid_t clock_id, timespec* user_ts)
         return -EINVAL;
     }
 
-    copy_to_user(user_ts, &ts);
+    if (!copy_to_user(user_ts, &ts))
+        return -EFAULT;
     return 0;
 }
 
+void* Process::sys$map_time_page()
+{
+    REQUIRE_PROMISE(stdio);
+    auto* region = allocate_region_with_vmobject(VirtualAddress(), PAGE_SIZE, TimeManagement::the().time_page_vmobject(), 0, "Time page", PROT_READ);
+    if (!region)
+        return (void*)-ENOMEM;
+    // Share the page with our children, they would see a frozen clock if it was copied on write.
+    region->set_shared(true);
+    return region->vaddr().as_ptr();
+}
+
 int Process::sys$clock_settime(clockid_t clock_id, timespec* user_ts)
 {
     REQUIRE_PROMISE(settime);
@@ -4382,18 +5038,20 @@ int Process::sys$clock_nanosleep(const Syscall::SC_clock_nanosleep_params* user_
 
     switch (params.clock_id) {
     case CLOCK_MONOTONIC: {
-        u64 wakeup_time;
+        if (requested_sleep.tv_sec < 0 || requested_sleep.tv_nsec < 0 || requested_sleep.tv_nsec >= 1'000'000'000)
+            return -EINVAL;
+        u64 requested_ns = (u64)requested_sleep.tv_sec * 1'000'000'000 + requested_sleep.tv_nsec;
+        u64 deadline;
         if (is_absolute) {
-            u64 time_to_wake = (requested_sleep.tv_sec * 1000 + requested_sleep.tv_nsec / 1000000);
-            wakeup_time = Thread::current->sleep_until(time_to_wake);
+            deadline = Thread::current()->sleep_until(requested_ns);
         } else {
-            u32 ticks_to_sleep = (requested_sleep.tv_sec * 1000 + requested_sleep.tv_nsec / 1000000);
-            if (!ticks_to_sleep)
+            if (!requested_ns)
                 return 0;
-            wakeup_time = Thread::current->sleep(ticks_to_sleep);
+            deadline = Thread::current()->sleep(requested_ns);
         }
-        if (wakeup_time > g_uptime) {
-            u32 ticks_left = wakeup_time - g_uptime;
+        u64 now = TimeManagement::the().monotonic_time_ns();
+        if (deadline > now) {
+            u64 ns_left = deadline - now;
             if (!is_absolute && params.remaining_sleep) {
                 if (!validate_write_typed(params.remaining_sleep)) {
                     // This can happen because the lock is dropped while
@@ -4404,9 +5062,8 @@ int Process::sys$clock_nanosleep(const Syscall::SC_clock_nanosleep_params* user_
 
                 timespec remaining_sleep;
                 memset(&remaining_sleep, 0, sizeof(timespec));
-                remaining_sleep.tv_sec = ticks_left / TimeManagement::the().ticks_per_second();
-                ticks_left -= remaining_sleep.tv_sec * TimeManagement::the().ticks_per_second();
-                remaining_sleep.tv_nsec = ticks_left * 1000000;
+                remaining_sleep.tv_sec = ns_left / 1'000'000'000;
+                remaining_sleep.tv_nsec = ns_left % 1'000'000'000;
                 copy_to_user(params.remaining_sleep, &remaining_sleep);
             }
             return -EINTR;
@@ -4428,16 +5085,16 @@ int Process::sys$sync()
 int Process::sys$yield()
 {
     REQUIRE_PROMISE(stdio);
-    Thread::current->yield_without_holding_big_lock();
+    Thread::current()->yield_without_holding_big_lock();
     return 0;
 }
 
 int Process::sys$beep()
 {
     PCSpeaker::tone_on(440);
-    u64 wakeup_time = Thread::current->sleep(100);
+    u64 deadline = Thread::current()->sleep(100'000'000);
     PCSpeaker::tone_off();
-    if (wakeup_time > g_uptime)
+    if (deadline > TimeManagement::the().monotonic_time_ns())
         return -EINTR;
     return 0;
 }
@@ -4596,6 +5253,12 @@ int Process::sys$profiling_enable(pid_t pid)
 {
     REQUIRE_NO_PROMISES;
     InterruptDisabler disabler;
+    if (pid == -1) {
+        if (!is_superuser())
+            return -EPERM;
+        Profiling::start_for_all_processes();
+        return 0;
+    }
     auto* process = Process::from_pid(pid);
     if (!process)
         return -ESRCH;
@@ -4611,6 +5274,12 @@ int Process::sys$profiling_enable(pid_t pid)
 int Process::sys$profiling_disable(pid_t pid)
 {
     InterruptDisabler disabler;
+    if (pid == -1) {
+        if (!is_superuser())
+            return -EPERM;
+        Profiling::stop();
+        return 0;
+    }
     auto* process = Process::from_pid(pid);
     if (!process)
         return -ESRCH;
@@ -4629,6 +5298,71 @@ WaitQueue& Process::futex_queue(i32* userspace_address)
     return *queue;
 }
 
+// Turns an absolute futex timeout into the relative one wait_on() wants.
+// Returns false if the deadline has already passed.
+static bool futex_relative_timeout(const timespec& absolute_timeout, bool realtime, timeval& relative_timeout)
+{
+    if (realtime) {
+        compute_relative_timeout_from_absolute(absolute_timeout, relative_timeout);
+        return relative_timeout.tv_sec > 0 || (relative_timeout.tv_sec == 0 && relative_timeout.tv_usec > 0);
+    }
+    u64 deadline_ns = (u64)absolute_timeout.tv_sec * 1'000'000'000 + absolute_timeout.tv_nsec;
+    u64 now_ns = TimeManagement::the().monotonic_time_ns();
+    if (deadline_ns <= now_ns)
+        return false;
+    u64 remaining_us = (deadline_ns - now_ns + 999) / 1000;
+    relative_timeout.tv_sec = remaining_us / 1'000'000;
+    relative_timeout.tv_usec = remaining_us % 1'000'000;
+    return true;
+}
+
+// Performs a FUTEX_WAKE_OP operation on a userspace word, returning its old value.
+static i32 futex_atomic_op(i32* userspace_address, u32 encoded_op)
+{
+    u32 op = (encoded_op >> 28) & 0xf;
+    u32 oparg = (encoded_op >> 12) & 0xfff;
+    if (op & FUTEX_OP_OPARG_SHIFT) {
+        op &= ~FUTEX_OP_OPARG_SHIFT;
+        oparg = 1u << (oparg & 31);
+    }
+
+    SmapDisabler disabler;
+    auto& atomic = *reinterpret_cast<Atomic<u32>*>(userspace_address);
+    switch (op) {
+    case FUTEX_OP_SET:
+        return atomic.exchange(oparg);
+    case FUTEX_OP_ADD:
+        return atomic.fetch_add(oparg);
+    case FUTEX_OP_OR:
+        return atomic.fetch_or(oparg);
+    case FUTEX_OP_ANDN:
+        return atomic.fetch_and(~oparg);
+    case FUTEX_OP_XOR:
+        return atomic.fetch_xor(oparg);
+    }
+    ASSERT_NOT_REACHED();
+}
+
+static bool futex_compare(i32 value, u32 encoded_op)
+{
+    i32 cmparg = encoded_op & 0xfff;
+    switch ((encoded_op >> 24) & 0xf) {
+    case FUTEX_OP_CMP_EQ:
+        return value == cmparg;
+    case FUTEX_OP_CMP_NE:
+        return value != cmparg;
+    case FUTEX_OP_CMP_LT:
+        return value < cmparg;
+    case FUTEX_OP_CMP_LE:
+        return value <= cmparg;
+    case FUTEX_OP_CMP_GT:
+        return value > cmparg;
+    case FUTEX_OP_CMP_GE:
+        return value >= cmparg;
+    }
+    return false;
+}
+
 int Process::sys$futex(const Syscall::SC_futex_params* user_params)
 {
     REQUIRE_PROMISE(thread);
@@ -4638,55 +5372,100 @@ int Process::sys$futex(const Syscall::SC_futex_params* user_params)
         return -EFAULT;
 
     i32* userspace_address = params.userspace_address;
-    int futex_op = params.futex_op;
+    // All futexes are process-private, so FUTEX_PRIVATE_FLAG doesn't change anything.
+    int futex_op = params.futex_op & FUTEX_CMD_MASK;
+    bool realtime = params.futex_op & FUTEX_CLOCK_REALTIME;
     i32 value = params.val;
     const timespec* user_timeout = params.timeout;
+    i32 value2 = (i32)(FlatPtr)params.timeout;
+    i32* userspace_address2 = params.userspace_address2;
+    i32 value3 = params.val3;
 
+    if ((FlatPtr)userspace_address & 3 || (FlatPtr)userspace_address2 & 3)
+        return -EINVAL;
     if (!validate_read_typed(userspace_address))
         return -EFAULT;
 
-    if (user_timeout && !validate_read_typed(user_timeout))
-        return -EFAULT;
-
     switch (futex_op) {
-    case FUTEX_WAIT: {
-        i32 user_value;
-        copy_from_user(&user_value, userspace_address);
-        if (user_value != value)
-            return -EAGAIN;
+    case FUTEX_WAIT:
+    case FUTEX_WAIT_BITSET: {
+        u32 bitset = futex_op == FUTEX_WAIT_BITSET ? (u32)value3 : FUTEX_BITSET_MATCH_ANY;
+        if (!bitset)
+            return -EINVAL;
 
         timespec ts_abstimeout { 0, 0 };
         if (user_timeout && !validate_read_and_copy_typed(&ts_abstimeout, user_timeout))
             return -EFAULT;
 
-        WaitQueue& wait_queue = futex_queue(userspace_address);
+        i32 user_value;
+        copy_from_user(&user_value, userspace_address);
+        if (user_value != value)
+            return -EAGAIN;
+
         timeval* optional_timeout = nullptr;
         timeval relative_timeout { 0, 0 };
         if (user_timeout) {
-            compute_relative_timeout_from_absolute(ts_abstimeout, relative_timeout);
+            if (!futex_relative_timeout(ts_abstimeout, realtime, relative_timeout))
+                return -ETIMEDOUT;
             optional_timeout = &relative_timeout;
         }
 
+        WaitQueue& wait_queue = futex_queue(userspace_address);
+        auto& thread = *Thread::current();
+        thread.m_wait_queue_bitset = bitset;
         // FIXME: This is supposed to be interruptible by a signal, but right now WaitQueue cannot be interrupted.
-        Thread::BlockResult result = Thread::current->wait_on(wait_queue, optional_timeout);
-        if (result == Thread::BlockResult::InterruptedByTimeout) {
+        Thread::BlockResult result = thread.wait_on(wait_queue, optional_timeout);
+        thread.m_wait_queue_bitset = FUTEX_BITSET_MATCH_ANY;
+        if (result == Thread::BlockResult::InterruptedByTimeout)
             return -ETIMEDOUT;
-        }
-
-        break;
+        return 0;
     }
     case FUTEX_WAKE:
-        if (value == 0)
+    case FUTEX_WAKE_BITSET: {
+        u32 bitset = futex_op == FUTEX_WAKE_BITSET ? (u32)value3 : FUTEX_BITSET_MATCH_ANY;
+        if (!bitset)
+            return -EINVAL;
+        if (value <= 0)
             return 0;
-        if (value == 1) {
-            futex_queue(userspace_address).wake_one();
-        } else {
-            futex_queue(userspace_address).wake_n(value);
+        return futex_queue(userspace_address).wake_n(value, bitset);
+    }
+    case FUTEX_REQUEUE:
+    case FUTEX_CMP_REQUEUE: {
+        if (value < 0 || value2 < 0)
+            return -EINVAL;
+        if (!validate_read_typed(userspace_address2))
+            return -EFAULT;
+        if (futex_op == FUTEX_CMP_REQUEUE) {
+            i32 user_value;
+            copy_from_user(&user_value, userspace_address);
+            if (user_value != value3)
+                return -EAGAIN;
         }
-        break;
+        auto& queue = futex_queue(userspace_address);
+        i32 woken_count = queue.wake_n(value);
+        i32 requeued_count = 0;
+        if (userspace_address2 != userspace_address)
+            requeued_count = queue.requeue_n(futex_queue(userspace_address2), value2);
+        return futex_op == FUTEX_CMP_REQUEUE ? woken_count + requeued_count : woken_count;
+    }
+    case FUTEX_WAKE_OP: {
+        if (value < 0 || value2 < 0)
+            return -EINVAL;
+        u32 encoded_op = (u32)value3;
+        u32 op = ((encoded_op >> 28) & 0xf) & ~FUTEX_OP_OPARG_SHIFT;
+        if (op > FUTEX_OP_XOR)
+            return -ENOSYS;
+        if (!validate_write_typed(userspace_address2))
+            return -EFAULT;
+        i32 old_value = futex_atomic_op(userspace_address2, encoded_op);
+        i32 woken_count = futex_queue(userspace_address).wake_n(value);
+        if (futex_compare(old_value, encoded_op))
+            woken_count += futex_queue(userspace_address2).wake_n(value2);
+        return woken_count;
+    }
     }
 
-    return 0;
+    return -ENOSYS;
 }
 
 int Process::sys$set_thread_boost(int tid, int amount)
@@ -4833,6 +5612,7 @@ int Process::sys$pledge(const Syscall::SC_pledge_params* user_params)
 Region& Process::add_region(NonnullOwnPtr<Region> region)
 {
     auto* ptr = region.ptr();
+    InterruptDisabler disabler;
     m_regions.append(move(region));
     return *ptr;
 }
@@ -4916,9 +5696,92 @@ int Process::sys$perf_event(int type, FlatPtr arg1, FlatPtr arg2)
 {
     if (!m_perf_event_buffer)
         m_perf_event_buffer = make<PerformanceEventBuffer>();
+    if (type == PERF_EVENT_ENABLE_KERNEL_EVENTS) {
+        m_perf_event_buffer->set_records_kernel_events();
+        return 0;
+    }
     return m_perf_event_buffer->append(type, arg1, arg2);
 }
 
+PerformanceEventBuffer* Process::kernel_event_buffer()
+{
+    if (!m_perf_event_buffer || !m_perf_event_buffer->records_kernel_events())
+        return nullptr;
+    return m_perf_event_buffer.ptr();
+}
+
+void Process::set_syscall_accounting_enabled(bool enabled)
+{
+    // Starting over throws away the numbers from last time, but they stay readable after stopping.
+    if (enabled)
+        m_syscall_statistics = make<SyscallStatistics>();
+    m_syscall_accounting_enabled = enabled;
+}
+
+int Process::sys$perf_counters(int request, pid_t pid, FlatPtr arg)
+{
+    REQUIRE_PROMISE(stdio);
+    if (!PerformanceCounters::is_supported())
+        return -ENOTSUP;
+
+    if (request == PERF_COUNTERS_READ) {
+        u64* user_values = (u64*)arg;
+        if (!validate_write_typed(user_values, PerformanceCounters::event_count))
+            return -EFAULT;
+        auto& thread = *Thread::current();
+        PerformanceCounters::update_counts(thread);
+        copy_to_user(user_values, thread.perf_counters().counts, sizeof(u64) * PerformanceCounters::event_count);
+        return 0;
+    }
+
+    if (pid != m_pid)
+        REQUIRE_PROMISE(proc);
+
+    PerformanceCounters::Config config;
+    switch (request) {
+    case PERF_COUNTERS_ENABLE:
+        for (size_t i = 0; i < PerformanceCounters::event_count; ++i) {
+            if ((arg & (1 << i)) && !PerformanceCounters::is_event_supported((PerformanceCounters::Event)i))
+                return -ENOTSUP;
+        }
+        if (!arg || arg >= (1u << PerformanceCounters::event_count))
+            return -EINVAL;
+        config.event_mask = arg;
+        break;
+    case PERF_COUNTERS_DISABLE:
+        break;
+    case PERF_COUNTERS_SAMPLE: {
+        Syscall::SC_perf_counters_sample_params params;
+        if (!validate_read_and_copy_typed(&params, (const Syscall::SC_perf_counters_sample_params*)arg))
+            return -EFAULT;
+        if (params.event < 0 || (size_t)params.event >= PerformanceCounters::event_count)
+            return -EINVAL;
+        if (!PerformanceCounters::is_event_supported((PerformanceCounters::Event)params.event))
+            return -ENOTSUP;
+        // The counter is loaded with minus the period, and only its low 31 bits can hold that.
+        if (!params.period || params.period > 0x7fffffff)
+            return -EINVAL;
+        config.event_mask = 1 << params.event;
+        config.sample_event = params.event;
+        config.sample_period = params.period;
+        break;
+    }
+    default:
+        return -EINVAL;
+    }
+
+    InterruptDisabler disabler;
+    auto* process = Process::from_pid(pid);
+    if (!process || process->is_dead())
+        return -ESRCH;
+    if (!is_superuser() && process->uid() != m_uid)
+        return -EPERM;
+    if (request == PERF_COUNTERS_SAMPLE)
+        config.event_mask |= process->perf_counter_config().event_mask;
+    PerformanceCounters::configure(*process, config);
+    return 0;
+}
+
 void Process::set_tty(TTY* tty)
 {
     m_tty = tty;
@@ -4948,7 +5811,7 @@ int Process::sys$get_stack_bounds(FlatPtr* user_stack_base, size_t* user_stack_s
     if (!validate_write_typed(user_stack_size))
         return -EFAULT;
 
-    FlatPtr stack_pointer = Thread::current->get_register_dump_from_stack().userspace_esp;
+    FlatPtr stack_pointer = Thread::current()->get_register_dump_from_stack().userspace_esp;
     auto* stack_region = MM.region_from_vaddr(*this, VirtualAddress(stack_pointer));
     if (!stack_region) {
         ASSERT_NOT_REACHED();
@@ -32,9 +32,11 @@
 #include <AK/NonnullOwnPtrVector.h>
 #include <AK/String.h>
 #include <AK/WeakPtr.h>
+#include <Kernel/BlockCondition.h>
 #include <Kernel/FileSystem/InodeMetadata.h>
 #include <Kernel/Forward.h>
 #include <Kernel/Lock.h>
+#include <Kernel/SchedulingGroup.h>
 #include <Kernel/Syscall.h>
 #include <Kernel/Thread.h>
 #include <Kernel/UnixTypes.h>
@@ -73,7 +75,9 @@ extern VirtualAddress g_return_to_ring3_from_signal_trampoline;
     __ENUMERATE_PLEDGE_PROMISE(accept)  \
     __ENUMERATE_PLEDGE_PROMISE(settime) \
     __ENUMERATE_PLEDGE_PROMISE(sigaction) \
-    __ENUMERATE_PLEDGE_PROMISE(shared_buffer)
+    __ENUMERATE_PLEDGE_PROMISE(shared_buffer) \
+    __ENUMERATE_PLEDGE_PROMISE(sendfd)  \
+    __ENUMERATE_PLEDGE_PROMISE(recvfd)
 
 enum class Pledge : u32 {
 #define __ENUMERATE_PLEDGE_PROMISE(x) x,
@@ -107,7 +111,7 @@ class Process : public InlineLinkedListNode<Process> {
     friend class Thread;
 
 public:
-    static Process* current;
+    static Process* current();
 
     static Process* create_kernel_process(Thread*& first_thread, String&& name, void (*entry)());
     static Process* create_user_process(Thread*& first_thread, const String& path, uid_t, gid_t, pid_t ppid, int& error, Vector<String>&& arguments = Vector<String>(), Vector<String>&& environment = Vector<String>(), TTY* = nullptr);
@@ -119,6 +123,19 @@ public:
     bool is_profiling() const { return m_profiling; }
     void set_profiling(bool profiling) { m_profiling = profiling; }
 
+    // Where the kernel records page faults, context switches, syscalls and block I/O
+    // for this process, or null if it hasn't asked for them.
+    PerformanceEventBuffer* kernel_event_buffer();
+
+    // Null unless syscall accounting is switched on, see SyscallStatistics.
+    SyscallStatistics* syscall_statistics() { return m_syscall_accounting_enabled ? m_syscall_statistics.ptr() : nullptr; }
+    const SyscallStatistics* recorded_syscall_statistics() const { return m_syscall_statistics.ptr(); }
+    bool is_syscall_accounting_enabled() const { return m_syscall_accounting_enabled; }
+    void set_syscall_accounting_enabled(bool);
+
+    PerformanceCounters::Config& perf_counter_config() { return m_perf_counter_config; }
+    const PerformanceCounters::Config& perf_counter_config() const { return m_perf_counter_config; }
+
     enum RingLevel : u8 {
         Ring0 = 0,
         Ring3 = 3,
@@ -168,6 +185,11 @@ public:
     void die();
     void finalize();
 
+    // Threads of ours that are blocked in waitpid() and friends.
+    BlockCondition& wait_block_condition() { return m_wait_block_condition; }
+    // Tell whoever may be waiting on us (our parent, and any tracers) that we died or stopped.
+    void unblock_waiters();
+
     int sys$yield();
     int sys$sync();
     int sys$beep();
@@ -196,6 +218,9 @@ public:
     ssize_t sys$read(int fd, u8*, ssize_t);
     ssize_t sys$write(int fd, const u8*, ssize_t);
     ssize_t sys$writev(int fd, const struct iovec* iov, int iov_count);
+    ssize_t sys$readv(int fd, const struct iovec* iov, int iov_count);
+    ssize_t sys$preadv(const Syscall::SC_preadv_params*);
+    ssize_t sys$pwritev(const Syscall::SC_pwritev_params*);
     int sys$fstat(int fd, stat*);
     int sys$stat(const Syscall::SC_stat_params*);
     int sys$lseek(int fd, off_t, int whence);
@@ -272,6 +297,17 @@ public:
     int sys$getpeername(const Syscall::SC_getpeername_params*);
     int sys$sched_setparam(pid_t pid, const struct sched_param* param);
     int sys$sched_getparam(pid_t pid, struct sched_param* param);
+    int sys$sched_setscheduler(pid_t pid, int policy, const struct sched_param* param);
+    int sys$sched_getscheduler(pid_t pid);
+    int sys$sched_setaffinity(pid_t pid, size_t cpusetsize, const cpu_set_t* mask);
+    int sys$sched_getaffinity(pid_t pid, size_t cpusetsize, cpu_set_t* mask);
+    void* sys$map_time_page();
+    ssize_t sys$sendfile(const Syscall::SC_sendfile_params*);
+    int sys$epoll_create(int flags);
+    int sys$epoll_ctl(const Syscall::SC_epoll_ctl_params*);
+    int sys$epoll_wait(const Syscall::SC_epoll_wait_params*);
+    int sys$sendfds(int sockfd, const int* fds, int count);
+    int sys$recvfds(int sockfd, int* fds, int count);
     int sys$create_thread(void* (*)(void*), const Syscall::SC_create_thread_params*);
     void sys$exit_thread(void*);
     int sys$join_thread(int tid, void** exit_value);
@@ -283,6 +319,8 @@ public:
     int sys$shbuf_create(int, void** buffer);
     int sys$shbuf_allow_pid(int, pid_t peer_pid);
     int sys$shbuf_allow_all(int);
+    int sys$shbuf_hand_over(int, pid_t peer_pid);
+    int sys$perf_counters(int request, pid_t, FlatPtr arg);
     void* sys$shbuf_get(int shbuf_id, size_t* size);
     int sys$shbuf_release(int shbuf_id);
     int sys$shbuf_seal(int shbuf_id);
@@ -337,11 +375,8 @@ public:
     template<typename T>
     [[nodiscard]] bool validate_read_and_copy_typed(T* dest, const T* src)
     {
-        bool validated = validate_read_typed(src);
-        if (validated) {
-            copy_from_user(dest, src);
-        }
-        return validated;
+        // The copy fails by itself if src isn't readable, without looking up its region first.
+        return copy_from_user(dest, src);
     }
     template<typename T>
     [[nodiscard]] bool validate_write_typed(T* value, size_t count = 1) { return validate_write(value, sizeof(T) * count); }
@@ -398,6 +433,8 @@ public:
     int icon_id() const { return m_icon_id; }
 
     u32 priority_boost() const { return m_priority_boost; }
+    SchedulingGroup& scheduling_group() { return *m_scheduling_group; }
+    const SchedulingGroup& scheduling_group() const { return *m_scheduling_group; }
 
     Custody& root_directory();
     Custody& root_directory_relative_to_global_root();
@@ -433,11 +470,18 @@ private:
     void kill_all_threads();
 
     int do_exec(NonnullRefPtr<FileDescription> main_program_description, Vector<String> arguments, Vector<String> environment, RefPtr<FileDescription> interpreter_description);
-    ssize_t do_write(FileDescription&, const u8*, int data_size);
+    ssize_t do_write(FileDescription&, const u8*, int data_size, Optional<off_t> offset = {});
+    ssize_t do_read(FileDescription&, u8*, int size, Optional<off_t> offset = {});
+    KResult validate_and_copy_iovecs(const struct iovec*, int iov_count, Vector<iovec, 32>&, bool will_be_written);
+    ssize_t do_readv(FileDescription&, const Vector<iovec, 32>&, Optional<off_t> offset);
+    ssize_t do_writev(FileDescription&, const Vector<iovec, 32>&, Optional<off_t> offset);
 
     KResultOr<NonnullRefPtr<FileDescription>> find_elf_interpreter_for_executable(const String& path, char (&first_page)[PAGE_SIZE], int nread, size_t file_size);
 
     int alloc_fd(int first_candidate_fd = 0);
+    void set_fd(int fd, NonnullRefPtr<FileDescription>&&, u32 flags = 0);
+    void set_fd_flags(int fd, u32 flags);
+    void clear_fd(int fd);
     void disown_all_shared_buffers();
 
     KResult do_kill(Process&, int signal);
@@ -478,6 +522,8 @@ private:
         RefPtr<FileDescription> description;
         u32 flags { 0 };
     };
+    // Some syscalls look up file descriptions without taking the big lock, so the table
+    // is only ever changed with interrupts disabled. Use set_fd() and friends for that.
     Vector<FileDescriptionAndFlags> m_fds;
 
     RingLevel m_ring { Ring0 };
@@ -487,6 +533,9 @@ private:
 
     bool m_dead { false };
     bool m_profiling { false };
+    PerformanceCounters::Config m_perf_counter_config;
+    bool m_syscall_accounting_enabled { false };
+    OwnPtr<SyscallStatistics> m_syscall_statistics;
 
     RefPtr<Custody> m_executable;
     RefPtr<Custody> m_cwd;
@@ -498,6 +547,8 @@ private:
     Region* region_from_range(const Range&);
     Region* region_containing(const Range&);
 
+    // The page fault handler and syscalls running without the big lock look through
+    // this, so it's only ever changed with interrupts disabled.
     NonnullOwnPtrVector<Region> m_regions;
     struct RegionLookupCache {
         Range range;
@@ -508,6 +559,7 @@ private:
     pid_t m_ppid { 0 };
     mode_t m_umask { 022 };
 
+    // sys$getgroups() reads this without the big lock, so like the other credentials it is only changed with interrupts disabled.
     FixedArray<gid_t> m_extra_gids;
 
     WeakPtr<Region> m_master_tls_region;
@@ -517,10 +569,14 @@ private:
     Lock m_big_lock { "Process" };
 
     u64 m_alarm_deadline { 0 };
+    TimerId m_alarm_timer_id { 0 };
+
+    BlockCondition m_wait_block_condition;
 
     int m_icon_id { -1 };
 
     u32 m_priority_boost { 0 };
+    RefPtr<SchedulingGroup> m_scheduling_group;
 
     u32 m_promises { 0 };
     u32 m_execpromises { 0 };
@@ -546,14 +602,14 @@ public:
     ProcessInspectionHandle(Process& process)
         : m_process(process)
     {
-        if (&process != Process::current) {
+        if (&process != Process::current()) {
             InterruptDisabler disabler;
             m_process.increment_inspector_count({});
         }
     }
     ~ProcessInspectionHandle()
     {
-        if (&m_process != Process::current) {
+        if (&m_process != Process::current()) {
             InterruptDisabler disabler;
             m_process.decrement_inspector_count({});
         }
@@ -613,8 +669,13 @@ inline void Process::for_each_thread(Callback callback) const
     pid_t my_pid = pid();
 
     if (my_pid == 0) {
-        // NOTE: Special case the colonel process, since its main thread is not in the global thread table.
-        callback(*g_colonel);
+        // NOTE: Special case the colonel process, since its threads (one idle thread per CPU)
+        //       are not in the global thread table.
+        Processor::for_each([&](Processor& processor) {
+            if (!processor.idle_thread())
+                return IterationDecision::Continue;
+            return callback(*processor.idle_thread());
+        });
         return;
     }
 
@@ -655,6 +716,12 @@ inline bool InodeMetadata::may_execute(const Process& process) const
     return may_execute(process.euid(), process.egid(), process.extra_gids());
 }
 
+inline Process* Process::current()
+{
+    auto* thread = Thread::current();
+    return thread ? &thread->process() : nullptr;
+}
+
 inline int Thread::pid() const
 {
     return m_process.pid();
@@ -667,28 +734,28 @@ inline const LogStream& operator<<(const LogStream& stream, const Process& proce
 
 inline u32 Thread::effective_priority() const
 {
-    return m_priority + m_process.priority_boost() + m_priority_boost + m_extra_priority;
+    return m_priority + m_process.priority_boost() + m_priority_boost;
 }
 
-#define REQUIRE_NO_PROMISES                      \
-    do {                                         \
-        if (Process::current->has_promises()) {  \
-            dbg() << "Has made a promise";       \
-            cli();                               \
-            Process::current->crash(SIGABRT, 0); \
-            ASSERT_NOT_REACHED();                \
-        }                                        \
+#define REQUIRE_NO_PROMISES                        \
+    do {                                           \
+        if (Process::current()->has_promises()) {  \
+            dbg() << "Has made a promise";         \
+            cli();                                 \
+            Process::current()->crash(SIGABRT, 0); \
+            ASSERT_NOT_REACHED();                  \
+        }                                          \
     } while (0)
 
-#define REQUIRE_PROMISE(promise)                                   \
-    do {                                                           \
-        if (Process::current->has_promises()                       \
-            && !Process::current->has_promised(Pledge::promise)) { \
-            dbg() << "Has not pledged " << #promise;               \
-            cli();                                                 \
-            Process::current->crash(SIGABRT, 0);                   \
-            ASSERT_NOT_REACHED();                                  \
-        }                                                          \
+#define REQUIRE_PROMISE(promise)                                     \
+    do {                                                             \
+        if (Process::current()->has_promises()                       \
+            && !Process::current()->has_promised(Pledge::promise)) { \
+            dbg() << "Has not pledged " << #promise;                 \
+            cli();                                                   \
+            Process::current()->crash(SIGABRT, 0);                   \
+            ASSERT_NOT_REACHED();                                    \
+        }                                                            \
     } while (0)
 
 }
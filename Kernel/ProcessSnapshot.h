@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2018-2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/Types.h>
+
+// The layout of /proc/all.bin, which has the same information as /proc/all without the cost of writing and parsing
+// JSON, for the programs that read it every second. It starts with a ProcessSnapshotHeader, followed by
+// processor_count ProcessorSnapshots and then process_count processes. A process is a ProcessSnapshot followed by
+// its name, tty, pledge and veil strings, and then its thread_count threads. A thread is a ThreadSnapshot followed
+// by its name and state strings, and then blocked_reason_count BlockedReasonSnapshots, each followed by its reason.
+// Strings are as long as the record before them says, and aren't null-terminated. Since they're variable-length,
+// records aren't necessarily aligned.
+
+static constexpr u32 process_snapshot_magic = 0x504e5350; // "PSNP"
+static constexpr u32 process_snapshot_version = 1;
+
+struct [[gnu::packed]] ProcessSnapshotHeader {
+    u32 magic;
+    u32 version;
+    u32 processor_count;
+    u32 process_count;
+};
+
+struct [[gnu::packed]] ProcessorSnapshot {
+    u32 id;
+    u32 online;
+    u32 busy_ticks;
+    u32 idle_ticks;
+};
+
+struct [[gnu::packed]] ProcessSnapshot {
+    i32 pid;
+    u32 pgid;
+    u32 pgp;
+    u32 sid;
+    u32 uid;
+    u32 gid;
+    i32 ppid;
+    u32 nfds;
+    u32 amount_virtual;
+    u32 amount_resident;
+    u32 amount_shared;
+    u32 amount_dirty_private;
+    u32 amount_clean_inode;
+    u32 amount_purgeable_volatile;
+    u32 amount_purgeable_nonvolatile;
+    i32 icon_id;
+    u16 name_length;
+    u16 tty_length;
+    u16 pledge_length;
+    u16 veil_length;
+    u32 thread_count;
+};
+
+struct [[gnu::packed]] ThreadSnapshot {
+    i32 tid;
+    u32 times_scheduled;
+    u32 ticks;
+    u32 syscall_count;
+    u32 inode_faults;
+    u32 zero_faults;
+    u32 cow_faults;
+    u32 unix_socket_read_bytes;
+    u32 unix_socket_write_bytes;
+    u32 ipv4_socket_read_bytes;
+    u32 ipv4_socket_write_bytes;
+    u32 file_read_bytes;
+    u32 file_write_bytes;
+    u64 running_ns;
+    u64 runnable_ns;
+    u64 blocked_ns;
+    u32 priority;
+    u32 effective_priority;
+    u16 name_length;
+    u16 state_length;
+    u32 blocked_reason_count;
+};
+
+struct [[gnu::packed]] BlockedReasonSnapshot {
+    u64 ns;
+    u16 reason_length;
+};
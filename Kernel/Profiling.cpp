@@ -25,7 +25,9 @@
  */
 
 #include <AK/Demangle.h>
+#include <AK/HashMap.h>
 #include <AK/StringBuilder.h>
+#include <Kernel/Arch/i386/CPU.h>
 #include <Kernel/FileSystem/Custody.h>
 #include <Kernel/KBuffer.h>
 #include <Kernel/KSyms.h>
@@ -39,8 +41,11 @@ namespace Profiling {
 
 static KBufferImpl* s_profiling_buffer;
 static size_t s_slot_count;
-static size_t s_next_slot_index;
-static u32 s_pid;
+static u64 s_total_sample_count;
+static u64 s_consumed_sample_count;
+static u64 s_lost_sample_count;
+static pid_t s_pid;
+static bool s_profiling_all_processes;
 
 String& executable_path()
 {
@@ -50,57 +55,131 @@ String& executable_path()
     return *path;
 }
 
-u32 pid()
+static HashMap<pid_t, String>& executables()
+{
+    static HashMap<pid_t, String>* map;
+    if (!map)
+        map = new HashMap<pid_t, String>;
+    return *map;
+}
+
+pid_t pid()
 {
     return s_pid;
 }
 
-void start(Process& process)
+bool is_profiling_all_processes()
 {
-    if (process.executable())
-        executable_path() = process.executable()->absolute_path().impl();
-    else
-        executable_path() = {};
-    s_pid = process.pid();
+    return s_profiling_all_processes;
+}
 
+static void reset()
+{
     if (!s_profiling_buffer) {
         s_profiling_buffer = RefPtr<KBufferImpl>(KBuffer::create_with_size(8 * MB).impl()).leak_ref();
         s_profiling_buffer->region().commit();
         s_slot_count = s_profiling_buffer->size() / sizeof(Sample);
     }
 
-    s_next_slot_index = 0;
+    s_total_sample_count = 0;
+    s_consumed_sample_count = 0;
+    s_lost_sample_count = 0;
+    executables().clear();
+}
+
+void start(Process& process)
+{
+    if (process.executable())
+        executable_path() = process.executable()->absolute_path().impl();
+    else
+        executable_path() = {};
+    s_pid = process.pid();
+    s_profiling_all_processes = false;
+    reset();
+}
+
+void start_for_all_processes()
+{
+    executable_path() = {};
+    s_pid = -1;
+    reset();
+    s_profiling_all_processes = true;
 }
 
-static Sample& sample_slot(size_t index)
+static Sample& sample_slot(u64 serial)
 {
-    return ((Sample*)s_profiling_buffer->data())[index];
+    return ((Sample*)s_profiling_buffer->data())[serial % s_slot_count];
 }
 
 Sample& next_sample_slot()
 {
-    auto& slot = sample_slot(s_next_slot_index++);
-    if (s_next_slot_index >= s_slot_count)
-        s_next_slot_index = 0;
-    return slot;
+    return sample_slot(s_total_sample_count++);
+}
+
+void take_sample(const RegisterState& regs)
+{
+    // If the interrupt hit the kernel, the frame chain starts with the kernel
+    // frames and continues into the userspace frames that entered it.
+    SmapDisabler disabler;
+    auto backtrace = Thread::current()->raw_backtrace(regs.ebp, regs.eip);
+    auto& sample = next_sample_slot();
+    sample.pid = Process::current()->pid();
+    sample.tid = Thread::current()->tid();
+    sample.timestamp = g_uptime;
+    // The slot may hold an older sample, so clear whatever frames this one doesn't have.
+    for (size_t i = 0; i < max_stack_frame_count; ++i)
+        sample.frames[i] = i < backtrace.size() ? backtrace[i] : 0;
 }
 
 void stop()
 {
+    s_profiling_all_processes = false;
 }
 
-void did_exec(const String& new_executable_path)
+void did_exec(Process& process, const String& new_executable_path)
 {
+    if (s_pid == -1) {
+        // Samples taken before the exec can no longer be symbolicated against the
+        // new image, but everyone else's samples are still good, so keep them.
+        executables().set(process.pid(), new_executable_path);
+        return;
+    }
     executable_path() = new_executable_path;
-    s_next_slot_index = 0;
+    s_total_sample_count = 0;
+    s_consumed_sample_count = 0;
+}
+
+static u64 oldest_available_serial()
+{
+    if (s_total_sample_count > s_slot_count)
+        return s_total_sample_count - s_slot_count;
+    return 0;
 }
 
 void for_each_sample(Function<void(Sample&)> callback)
 {
-    for (size_t i = 0; i < s_next_slot_index; ++i) {
-        auto& sample = sample_slot(i);
-        callback(sample);
-    }
+    for (u64 serial = oldest_available_serial(); serial < s_total_sample_count; ++serial)
+        callback(sample_slot(serial));
+}
+
+void consume_samples(Function<void(Sample&)> callback)
+{
+    u64 first_serial = max(s_consumed_sample_count, oldest_available_serial());
+    s_lost_sample_count += first_serial - s_consumed_sample_count;
+    for (u64 serial = first_serial; serial < s_total_sample_count; ++serial)
+        callback(sample_slot(serial));
+    s_consumed_sample_count = s_total_sample_count;
+}
+
+u64 lost_sample_count()
+{
+    return s_lost_sample_count;
+}
+
+void for_each_executable(Function<void(pid_t, const String&)> callback)
+{
+    for (auto& it : executables())
+        callback(it.key, it.value);
 }
 
 }
@@ -29,10 +29,12 @@
 #include <AK/Function.h>
 #include <AK/String.h>
 #include <AK/Types.h>
+#include <Kernel/UnixTypes.h>
 
 namespace Kernel {
 
 class Process;
+struct RegisterState;
 
 namespace Profiling {
 
@@ -45,15 +47,33 @@ struct Sample {
     u32 frames[max_stack_frame_count];
 };
 
-extern u32 pid();
+// While profiling all processes, every thread that is running on a CPU when the
+// timer fires gets sampled. pid() returns -1 for such a profile.
+extern pid_t pid();
+extern bool is_profiling_all_processes();
 extern String& executable_path();
 
 Sample& next_sample_slot();
+// Records where the current thread was when it got interrupted.
+void take_sample(const RegisterState&);
 void start(Process&);
+void start_for_all_processes();
 void stop();
-void did_exec(const String& new_executable_path);
+void did_exec(Process&, const String& new_executable_path);
+
+// Walks every sample that is still in the ring buffer, oldest first.
 void for_each_sample(Function<void(Sample&)>);
 
+// Walks the samples recorded since the previous call and marks them as consumed,
+// so that a reader can drain the ring buffer continuously while profiling runs.
+void consume_samples(Function<void(Sample&)>);
+
+// Number of samples that were overwritten before anyone consumed them.
+u64 lost_sample_count();
+
+// Executables of processes that exec'd while being profiled system-wide.
+void for_each_executable(Function<void(pid_t, const String&)>);
+
 }
 
 }
@@ -24,43 +24,198 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <AK/Atomic.h>
+#include <AK/StdLibExtras.h>
 #include <Kernel/Arch/i386/CPU.h>
 #include <Kernel/Devices/RandomDevice.h>
 #include <Kernel/Random.h>
+#include <Kernel/StdLib.h>
+#include <Kernel/Time/TimeManagement.h>
 
 namespace Kernel {
 
-static u32 random32()
+// Each CPU has its own ChaCha20 generator, which rekeys itself from its own keystream on every request and
+// reseeds from a global pool, stirred with hardware randomness, after a while or after a lot of output.
+
+static constexpr size_t chacha20_block_size = 64;
+static constexpr size_t reseed_interval_bytes = 1 * MB;
+static constexpr time_t reseed_interval_seconds = 60;
+
+// Wipes key material off the stack in a way the compiler can't leave out.
+static void erase(void* buffer, size_t size)
+{
+    memset(buffer, 0, size);
+    asm volatile(""
+                 :
+                 : "r"(buffer)
+                 : "memory");
+}
+
+static inline u32 rotate_left(u32 value, size_t bits)
+{
+    return (value << bits) | (value >> (32 - bits));
+}
+
+static inline void quarter_round(u32* x, size_t a, size_t b, size_t c, size_t d)
+{
+    x[a] += x[b];
+    x[d] = rotate_left(x[d] ^ x[a], 16);
+    x[c] += x[d];
+    x[b] = rotate_left(x[b] ^ x[c], 12);
+    x[a] += x[b];
+    x[d] = rotate_left(x[d] ^ x[a], 8);
+    x[c] += x[d];
+    x[b] = rotate_left(x[b] ^ x[c], 7);
+}
+
+// The ChaCha20 block function from RFC 8439, with a zero nonce.
+static void chacha20_block(const u32* key, u32 counter, u8* out)
+{
+    u32 state[16] {
+        0x61707865, 0x3320646e, 0x79622d32, 0x6b206574,
+        key[0], key[1], key[2], key[3], key[4], key[5], key[6], key[7],
+        counter, 0, 0, 0
+    };
+    u32 x[16];
+    memcpy(x, state, sizeof(x));
+    for (size_t i = 0; i < 10; ++i) {
+        quarter_round(x, 0, 4, 8, 12);
+        quarter_round(x, 1, 5, 9, 13);
+        quarter_round(x, 2, 6, 10, 14);
+        quarter_round(x, 3, 7, 11, 15);
+        quarter_round(x, 0, 5, 10, 15);
+        quarter_round(x, 1, 6, 11, 12);
+        quarter_round(x, 2, 7, 8, 13);
+        quarter_round(x, 3, 4, 9, 14);
+    }
+    for (size_t i = 0; i < 16; ++i) {
+        u32 word = x[i] + state[i];
+        out[i * 4 + 0] = word;
+        out[i * 4 + 1] = word >> 8;
+        out[i * 4 + 2] = word >> 16;
+        out[i * 4 + 3] = word >> 24;
+    }
+    erase(x, sizeof(x));
+    erase(state, sizeof(state));
+}
+
+static bool read_rdseed(u32& value)
+{
+    // RDSEED runs dry a lot more easily than RDRAND, so don't insist.
+    for (size_t attempt = 0; attempt < 16; ++attempt) {
+        u8 success;
+        asm volatile("rdseed %0; setc %1"
+                     : "=r"(value), "=qm"(success));
+        if (success)
+            return true;
+    }
+    return false;
+}
+
+static u32 read_rdrand()
+{
+    u32 value;
+    asm volatile(
+        "1:\n"
+        "rdrand %0\n"
+        "jnc 1b\n"
+        : "=r"(value));
+    return value;
+}
+
+static u32 hardware_entropy()
 {
-    if (g_cpu_supports_rdrand) {
-        u32 value = 0;
-        asm volatile(
-            "1:\n"
-            "rdrand %0\n"
-            "jnc 1b\n"
-            : "=r"(value));
-        return value;
+    u32 value = 0;
+    if (!g_cpu_supports_rdseed || !read_rdseed(value)) {
+        if (g_cpu_supports_rdrand)
+            value = read_rdrand();
+    }
+    // Whatever else we have, the low bits of the time stamp counter add a bit of jitter.
+    if (g_cpu_supports_tsc) {
+        u32 low;
+        u32 high;
+        read_tsc(low, high);
+        value ^= rotate_left(low, value % 32) ^ high;
     }
-    // FIXME: This sucks lol
-    static u32 next = 1;
-    next = next * 1103515245 + 12345;
-    return next;
+    return value;
+}
+
+struct EntropyPool {
+    u32 key[8];
+    u32 counter { 0 };
+};
+
+struct PerCPUGenerator {
+    u32 key[8];
+    bool seeded { false };
+    size_t bytes_until_reseed { 0 };
+    time_t reseed_time { 0 };
+};
+
+static EntropyPool s_pool;
+// The pool is shared between CPUs, so disabling interrupts isn't enough to keep it to ourselves.
+static Atomic<bool> s_pool_lock;
+static PerCPUGenerator s_generators[MAX_PROCESSOR_COUNT];
+
+static time_t seconds_since_boot()
+{
+    return TimeManagement::initialized() ? TimeManagement::the().seconds_since_boot() : 0;
+}
+
+// Must be called with interrupts disabled.
+static void reseed(PerCPUGenerator& generator)
+{
+    while (s_pool_lock.exchange(true, AK::memory_order_acquire))
+        asm volatile("pause");
+
+    // FIXME: Without RDSEED, RDRAND or a TSC, there's nothing to stir in here and the output is predictable.
+    for (size_t i = 0; i < 8; ++i)
+        s_pool.key[i] ^= hardware_entropy();
+
+    u8 block[chacha20_block_size];
+    chacha20_block(s_pool.key, s_pool.counter++, block);
+    memcpy(s_pool.key, block, sizeof(s_pool.key));
+    s_pool_lock.store(false, AK::memory_order_release);
+
+    memcpy(generator.key, block + sizeof(s_pool.key), sizeof(generator.key));
+    erase(block, sizeof(block));
+
+    generator.seeded = true;
+    generator.bytes_until_reseed = reseed_interval_bytes;
+    generator.reseed_time = seconds_since_boot();
 }
 
 void get_good_random_bytes(u8* buffer, size_t buffer_size)
 {
-    union {
-        u8 bytes[4];
-        u32 value;
-    } u;
-    size_t offset = 4;
-    for (size_t i = 0; i < buffer_size; ++i) {
-        if (offset >= 4) {
-            u.value = random32();
-            offset = 0;
-        }
-        buffer[i] = u.bytes[offset++];
+    if (!buffer_size)
+        return;
+
+    u32 key[8];
+    u8 block[chacha20_block_size];
+    {
+        InterruptDisabler disabler;
+        auto& generator = s_generators[Processor::current().id()];
+        if (!generator.seeded || generator.bytes_until_reseed < buffer_size || seconds_since_boot() - generator.reseed_time >= reseed_interval_seconds)
+            reseed(generator);
+        generator.bytes_until_reseed -= min(buffer_size, generator.bytes_until_reseed);
+
+        memcpy(key, generator.key, sizeof(key));
+        chacha20_block(key, 0, block);
+        memcpy(generator.key, block, sizeof(generator.key));
     }
+
+    // The caller's buffer may be in userspace, so it's only touched once interrupts are back on.
+    size_t offset = min(buffer_size, sizeof(block) - sizeof(key));
+    memcpy(buffer, block + sizeof(key), offset);
+    for (u32 counter = 1; offset < buffer_size; ++counter) {
+        chacha20_block(key, counter, block);
+        size_t length = min(buffer_size - offset, sizeof(block));
+        memcpy(buffer + offset, block, length);
+        offset += length;
+    }
+
+    erase(key, sizeof(key));
+    erase(block, sizeof(block));
 }
 
 void get_fast_random_bytes(u8* buffer, size_t buffer_size)
@@ -31,7 +31,9 @@
 namespace Kernel {
 
 // NOTE: These API's are primarily about expressing intent/needs in the calling code.
-//       We don't make any guarantees about actual fastness or goodness yet.
+//       For now both come out of the same per-CPU ChaCha20 generator, which is seeded with RDSEED or RDRAND
+//       where the CPU has them. Neither touches the output buffer with interrupts disabled, so it may be
+//       userspace memory.
 
 void get_fast_random_bytes(u8*, size_t);
 void get_good_random_bytes(u8*, size_t);
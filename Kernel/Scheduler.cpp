@@ -24,10 +24,13 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
-#include <AK/QuickSort.h>
 #include <AK/TemporaryChange.h>
+#include <AK/Time.h>
 #include <Kernel/FileSystem/FileDescription.h>
+#include <Kernel/Interrupts/APIC.h>
 #include <Kernel/Net/Socket.h>
+#include <Kernel/PerformanceCounters.h>
+#include <Kernel/PerformanceEventBuffer.h>
 #include <Kernel/Process.h>
 #include <Kernel/Profiling.h>
 #include <Kernel/RTC.h>
@@ -54,23 +57,207 @@ void Scheduler::update_state_for_thread(Thread& thread)
     ASSERT_INTERRUPTS_DISABLED();
     auto& list = g_scheduler_data->thread_list_for_state(thread.state());
 
-    if (list.contains(thread))
+    if (!list.contains(thread))
+        list.append(thread);
+
+    if (thread.state() == Thread::Runnable)
+        g_scheduler_data->enqueue_ready_thread(thread);
+    else
+        g_scheduler_data->dequeue_ready_thread(thread);
+
+    bool needs_polling = thread.state() == Thread::Skip1SchedulerPass
+        || thread.state() == Thread::Skip0SchedulerPasses
+        || (thread.state() == Thread::Blocked && thread.m_blocker->needs_polling());
+    auto& polled_threads = g_scheduler_data->m_polled_threads;
+    if (needs_polling && !thread.m_polled_list_node.is_in_list())
+        polled_threads.append(thread);
+    else if (!needs_polling && thread.m_polled_list_node.is_in_list())
+        polled_threads.remove(thread);
+}
+
+static u32 ready_queue_index_for(const Thread& thread)
+{
+    // Higher priorities go into higher queues, so the most important queue is the highest bit in the mask.
+    u32 priority = min(thread.effective_priority(), (u32)THREAD_PRIORITY_MAX);
+    return priority * (SchedulerData::ready_queue_count - 1) / THREAD_PRIORITY_MAX;
+}
+
+// Whether a thread that's ready to run can be picked right now.
+static bool can_schedule(const Thread& thread)
+{
+    // Its state is still being saved by the CPU that just switched away from it.
+    if (thread.is_being_switched_out())
+        return false;
+
+    if (thread.process().is_being_inspected())
+        return false;
+
+    if (thread.process().exec_tid() && thread.process().exec_tid() != thread.tid())
+        return false;
+
+    if (!thread.can_run_on(Processor::current().id()))
+        return false;
+
+    return true;
+}
+
+// Whether the thread may wait for its turn in the given CPU's ready queues.
+static bool can_queue_on(const Thread& thread, u32 cpu)
+{
+    return cpu < Processor::count() && Processor::by_id(cpu).is_online() && thread.can_run_on(cpu);
+}
+
+// A tickless CPU sleeps in hlt until it gets an interrupt, so telling it to stop idling isn't enough.
+static void wake_up_idle_processor(Processor& processor)
+{
+    processor.set_should_stop_idling(true);
+    if (&processor != &Processor::current() && processor.is_bootstrap_processor() && TimeManagement::the().is_tickless())
+        APIC::send_wakeup(processor.id());
+}
+
+void SchedulerData::enqueue_ready_thread(Thread& thread)
+{
+    ASSERT(thread.state() == Thread::Runnable);
+    if (thread.m_ready_queue_node.is_in_list())
+        return;
+
+    // Stay on the CPU we ran on last, where our working set is most likely still cached.
+    u32 cpu = thread.m_last_processor;
+    if (!can_queue_on(thread, cpu)) {
+        cpu = Processor::current().id();
+        if (!can_queue_on(thread, cpu)) {
+            Processor::for_each([&](Processor& processor) {
+                if (!can_queue_on(thread, processor.id()))
+                    return IterationDecision::Continue;
+                cpu = processor.id();
+                return IterationDecision::Break;
+            });
+        }
+    }
+
+    auto& ready_queues = m_ready_queues[cpu];
+    u32 index;
+    if (thread.is_realtime()) {
+        index = ready_queue_count + thread.priority();
+        ready_queues.realtime_queues[thread.priority()].append(thread);
+        ready_queues.realtime_mask[thread.priority() / 32] |= 1u << (thread.priority() % 32);
+    } else {
+        index = ready_queue_index_for(thread);
+        ready_queues.queues[index].append(thread);
+        ready_queues.mask |= 1u << index;
+    }
+    ready_queues.size++;
+    thread.m_ready_queue_processor = cpu;
+    thread.m_ready_queue_index = index;
+    thread.m_ready_queue_stamp = m_pick_count;
+
+    auto& processor = Processor::by_id(cpu);
+    if (processor.current_thread() == processor.idle_thread())
+        wake_up_idle_processor(processor);
+}
+
+void SchedulerData::dequeue_ready_thread(Thread& thread)
+{
+    if (!thread.m_ready_queue_node.is_in_list())
         return;
 
-    list.append(thread);
+    auto& ready_queues = m_ready_queues[thread.m_ready_queue_processor];
+    if (thread.m_ready_queue_index >= ready_queue_count) {
+        // Real-time queues come right after the regular ones.
+        u32 priority = thread.m_ready_queue_index - ready_queue_count;
+        auto& queue = ready_queues.realtime_queues[priority];
+        queue.remove(thread);
+        if (queue.is_empty())
+            ready_queues.realtime_mask[priority / 32] &= ~(1u << (priority % 32));
+    } else {
+        auto& queue = ready_queues.queues[thread.m_ready_queue_index];
+        queue.remove(thread);
+        if (queue.is_empty())
+            ready_queues.mask &= ~(1u << thread.m_ready_queue_index);
+    }
+    ready_queues.size--;
+}
+
+// Threads of process groups that have recently used more than their share of the CPU lose some priority.
+static u32 fair_share_priority(const Thread& thread)
+{
+    u32 priority = thread.effective_priority();
+    u32 penalty = thread.process().scheduling_group().priority_penalty(g_scheduler_data->m_fair_share_epoch, TimeManagement::the().ticks_per_second());
+    return priority > penalty ? priority - penalty : 0;
+}
+
+Thread* SchedulerData::best_ready_thread(u32 processor, u32& best_score)
+{
+    // Threads gain a point for every scheduler pass they spend waiting, so busy
+    // high priority threads can't starve out everyone else indefinitely.
+    auto& ready_queues = m_ready_queues[processor];
+    Thread* best_thread = nullptr;
+    for (u32 mask = ready_queues.mask; mask;) {
+        u32 index = 31 - __builtin_clz(mask);
+        mask &= ~(1u << index);
+        // The queues are FIFO, so the first thread we can take is also the one that has waited the longest.
+        for (auto& thread : ready_queues.queues[index]) {
+            if (!can_schedule(thread))
+                continue;
+            u32 score = fair_share_priority(thread) + (m_pick_count - thread.m_ready_queue_stamp);
+            if (!best_thread || score > best_score) {
+                best_thread = &thread;
+                best_score = score;
+            }
+            break;
+        }
+    }
+    return best_thread;
+}
+
+Thread* SchedulerData::best_realtime_thread(u32 processor)
+{
+    // Real-time threads don't age, the highest priority one always goes first.
+    auto& ready_queues = m_ready_queues[processor];
+    for (int word = realtime_mask_words - 1; word >= 0; --word) {
+        for (u32 mask = ready_queues.realtime_mask[word]; mask;) {
+            u32 bit = 31 - __builtin_clz(mask);
+            mask &= ~(1u << bit);
+            for (auto& thread : ready_queues.realtime_queues[word * 32 + bit]) {
+                if (can_schedule(thread))
+                    return &thread;
+            }
+        }
+    }
+    return nullptr;
+}
+
+bool SchedulerData::is_realtime_throttled(u32 processor) const
+{
+    // Leave at least 5% of every second to everyone else.
+    auto& ready_queues = m_ready_queues[processor];
+    return ready_queues.realtime_ticks_this_period >= TimeManagement::the().ticks_per_second() * 95 / 100;
+}
+
+// Whether the current thread should make way for a waiting real-time thread before its time slice is up.
+static bool should_preempt_for_realtime_thread(Processor& processor, Thread& current_thread)
+{
+    auto& scheduler_data = *g_scheduler_data;
+    if (scheduler_data.is_realtime_throttled(processor.id()))
+        return false;
+    auto* realtime_thread = scheduler_data.best_realtime_thread(processor.id());
+    if (!realtime_thread)
+        return false;
+    return !current_thread.is_realtime() || realtime_thread->priority() > current_thread.priority();
 }
 
 static u32 time_slice_for(const Thread& thread)
 {
     // One time slice unit == 1ms
-    if (&thread == g_colonel)
+    if (thread.pid() == 0)
         return 1;
     return 10;
 }
 
 timeval Scheduler::time_since_boot()
 {
-    return { TimeManagement::the().seconds_since_boot(), (suseconds_t)TimeManagement::the().ticks_this_second() * 1000 };
+    u64 now = TimeManagement::the().monotonic_time_ns();
+    return { (time_t)(now / 1'000'000'000), (suseconds_t)((now % 1'000'000'000) / 1000) };
 }
 
 Thread* g_finalizer;
@@ -80,16 +267,58 @@ bool g_finalizer_has_work;
 static Process* s_colonel_process;
 u64 g_uptime;
 
-struct TaskRedirectionData {
-    u16 selector;
-    TSS32 tss;
-};
-static TaskRedirectionData s_redirection;
-static bool s_active;
-
 bool Scheduler::is_active()
 {
-    return s_active;
+    return Processor::current().in_scheduler();
+}
+
+// A thread that resumes in userspace never holds the kernel lock, whatever
+// it was holding when it was last switched out (e.g. right before exec()).
+static u32 kernel_lock_depth_to_resume(const Thread& thread)
+{
+    if (!thread.in_kernel())
+        return 0;
+    return thread.saved_kernel_lock_depth();
+}
+
+void Thread::Blocker::set_timeout(Thread& thread, const timeval& timeout)
+{
+    ASSERT(!m_timeout_timer_id);
+    if (timeout.tv_sec < 0 || (timeout.tv_sec == 0 && timeout.tv_usec <= 0)) {
+        m_timed_out = true;
+        return;
+    }
+    timeval relative_timeout = timeout;
+    m_timeout_timer_id = TimerQueue::the().add_timer(relative_timeout, [this, &thread] {
+        m_timeout_timer_id = 0;
+        m_timed_out = true;
+        thread.consider_unblock();
+    });
+}
+
+void Thread::Blocker::set_timeout_at(Thread& thread, u64 expires)
+{
+    ASSERT(!m_timeout_timer_id);
+    if (expires <= TimeManagement::the().monotonic_time_ns()) {
+        m_timed_out = true;
+        return;
+    }
+    auto timer = make<Timer>();
+    timer->expires = expires;
+    timer->callback = [this, &thread] {
+        m_timeout_timer_id = 0;
+        m_timed_out = true;
+        thread.consider_unblock();
+    };
+    m_timeout_timer_id = TimerQueue::the().add_timer(move(timer));
+}
+
+void Thread::Blocker::cancel_timeout()
+{
+    if (!m_timeout_timer_id)
+        return;
+    TimerQueue::the().cancel_timer(m_timeout_timer_id);
+    m_timeout_timer_id = 0;
 }
 
 Thread::JoinBlocker::JoinBlocker(Thread& joinee, void*& joinee_exit_value)
@@ -97,8 +326,8 @@ Thread::JoinBlocker::JoinBlocker(Thread& joinee, void*& joinee_exit_value)
     , m_joinee_exit_value(joinee_exit_value)
 {
     ASSERT(m_joinee.m_joiner == nullptr);
-    m_joinee.m_joiner = Thread::current;
-    Thread::current->m_joinee = &joinee;
+    m_joinee.m_joiner = Thread::current();
+    Thread::current()->m_joinee = &joinee;
 }
 
 bool Thread::JoinBlocker::should_unblock(Thread& joiner, time_t, long)
@@ -116,6 +345,21 @@ const FileDescription& Thread::FileDescriptionBlocker::blocked_description() con
     return m_blocked_description;
 }
 
+void Thread::FileDescriptionBlocker::begin_blocking(Thread& thread)
+{
+    m_blocked_description->file().block_condition().add(thread);
+}
+
+void Thread::FileDescriptionBlocker::end_blocking(Thread& thread)
+{
+    m_blocked_description->file().block_condition().remove(thread);
+}
+
+bool Thread::FileDescriptionBlocker::needs_polling() const
+{
+    return m_blocked_description->file().readiness_needs_polling();
+}
+
 Thread::AcceptBlocker::AcceptBlocker(const FileDescription& description)
     : FileDescriptionBlocker(description)
 {
@@ -141,51 +385,37 @@ bool Thread::ConnectBlocker::should_unblock(Thread&, time_t, long)
 Thread::WriteBlocker::WriteBlocker(const FileDescription& description)
     : FileDescriptionBlocker(description)
 {
-    if (description.is_socket()) {
-        auto& socket = *description.socket();
-        if (socket.has_send_timeout()) {
-            timeval deadline = Scheduler::time_since_boot();
-            deadline.tv_sec += socket.send_timeout().tv_sec;
-            deadline.tv_usec += socket.send_timeout().tv_usec;
-            deadline.tv_sec += (socket.send_timeout().tv_usec / 1000000) * 1;
-            deadline.tv_usec %= 1000000;
-            m_deadline = deadline;
-        }
-    }
 }
 
-bool Thread::WriteBlocker::should_unblock(Thread&, time_t now_sec, long now_usec)
+void Thread::WriteBlocker::begin_blocking(Thread& thread)
 {
-    if (m_deadline.has_value()) {
-        bool timed_out = now_sec > m_deadline.value().tv_sec || (now_sec == m_deadline.value().tv_sec && now_usec >= m_deadline.value().tv_usec);
-        return timed_out || blocked_description().can_write();
-    }
-    return blocked_description().can_write();
+    FileDescriptionBlocker::begin_blocking(thread);
+    auto& description = blocked_description();
+    if (description.is_socket() && description.socket()->has_send_timeout())
+        set_timeout(thread, description.socket()->send_timeout());
+}
+
+bool Thread::WriteBlocker::should_unblock(Thread&, time_t, long)
+{
+    return has_timed_out() || blocked_description().can_write();
 }
 
 Thread::ReadBlocker::ReadBlocker(const FileDescription& description)
     : FileDescriptionBlocker(description)
 {
-    if (description.is_socket()) {
-        auto& socket = *description.socket();
-        if (socket.has_receive_timeout()) {
-            timeval deadline = Scheduler::time_since_boot();
-            deadline.tv_sec += socket.receive_timeout().tv_sec;
-            deadline.tv_usec += socket.receive_timeout().tv_usec;
-            deadline.tv_sec += (socket.receive_timeout().tv_usec / 1000000) * 1;
-            deadline.tv_usec %= 1000000;
-            m_deadline = deadline;
-        }
-    }
 }
 
-bool Thread::ReadBlocker::should_unblock(Thread&, time_t now_sec, long now_usec)
+void Thread::ReadBlocker::begin_blocking(Thread& thread)
 {
-    if (m_deadline.has_value()) {
-        bool timed_out = now_sec > m_deadline.value().tv_sec || (now_sec == m_deadline.value().tv_sec && now_usec >= m_deadline.value().tv_usec);
-        return timed_out || blocked_description().can_read();
-    }
-    return blocked_description().can_read();
+    FileDescriptionBlocker::begin_blocking(thread);
+    auto& description = blocked_description();
+    if (description.is_socket() && description.socket()->has_receive_timeout())
+        set_timeout(thread, description.socket()->receive_timeout());
+}
+
+bool Thread::ReadBlocker::should_unblock(Thread&, time_t, long)
+{
+    return has_timed_out() || blocked_description().can_read();
 }
 
 Thread::ConditionBlocker::ConditionBlocker(const char* state_string, Function<bool()>&& condition)
@@ -200,14 +430,19 @@ bool Thread::ConditionBlocker::should_unblock(Thread&, time_t, long)
     return m_block_until_condition();
 }
 
-Thread::SleepBlocker::SleepBlocker(u64 wakeup_time)
-    : m_wakeup_time(wakeup_time)
+Thread::SleepBlocker::SleepBlocker(u64 deadline)
+    : m_deadline(deadline)
+{
+}
+
+void Thread::SleepBlocker::begin_blocking(Thread& thread)
 {
+    set_timeout_at(thread, m_deadline);
 }
 
 bool Thread::SleepBlocker::should_unblock(Thread&, time_t, long)
 {
-    return m_wakeup_time <= g_uptime;
+    return has_timed_out();
 }
 
 Thread::SelectBlocker::SelectBlocker(const timeval& tv, bool select_has_timeout, const FDVector& read_fds, const FDVector& write_fds, const FDVector& except_fds)
@@ -219,12 +454,53 @@ Thread::SelectBlocker::SelectBlocker(const timeval& tv, bool select_has_timeout,
 {
 }
 
-bool Thread::SelectBlocker::should_unblock(Thread& thread, time_t now_sec, long now_usec)
+void Thread::SelectBlocker::register_with_files_for(Thread& thread, const FDVector& fds)
 {
+    auto& process = thread.process();
+    for (int fd : fds) {
+        if (!process.m_fds[fd])
+            continue;
+        auto& file = process.m_fds[fd].description->file();
+        bool already_registered = false;
+        for (auto& registered_file : m_registered_files) {
+            if (registered_file.ptr() == &file) {
+                already_registered = true;
+                break;
+            }
+        }
+        if (already_registered)
+            continue;
+        if (file.readiness_needs_polling())
+            m_needs_polling = true;
+        file.block_condition().add(thread);
+        // Hold on to the file, in case the fd gets closed while we're blocked on it.
+        m_registered_files.append(file);
+    }
+}
+
+void Thread::SelectBlocker::begin_blocking(Thread& thread)
+{
+    register_with_files_for(thread, m_select_read_fds);
+    register_with_files_for(thread, m_select_write_fds);
+
     if (m_select_has_timeout) {
-        if (now_sec > m_select_timeout.tv_sec || (now_sec == m_select_timeout.tv_sec && now_usec >= m_select_timeout.tv_usec))
-            return true;
+        timeval timeout;
+        timeval_sub(m_select_timeout, Scheduler::time_since_boot(), timeout);
+        set_timeout(thread, timeout);
     }
+}
+
+void Thread::SelectBlocker::end_blocking(Thread& thread)
+{
+    for (auto& file : m_registered_files)
+        file->block_condition().remove(thread);
+    m_registered_files.clear();
+}
+
+bool Thread::SelectBlocker::should_unblock(Thread& thread, time_t, long)
+{
+    if (has_timed_out())
+        return true;
 
     auto& process = thread.process();
     for (int fd : m_select_read_fds) {
@@ -286,6 +562,16 @@ bool Thread::WaitBlocker::should_unblock(Thread& thread, time_t, long)
     return should_unblock;
 }
 
+void Thread::WaitBlocker::begin_blocking(Thread& thread)
+{
+    thread.process().wait_block_condition().add(thread);
+}
+
+void Thread::WaitBlocker::end_blocking(Thread& thread)
+{
+    thread.process().wait_block_condition().remove(thread);
+}
+
 Thread::SemiPermanentBlocker::SemiPermanentBlocker(Reason reason)
     : m_reason(reason)
 {
@@ -325,19 +611,28 @@ void Thread::consider_unblock(time_t now_sec, long now_usec)
     }
 }
 
+void Thread::consider_unblock()
+{
+    auto now = Scheduler::time_since_boot();
+    consider_unblock(now.tv_sec, now.tv_usec);
+}
+
 bool Scheduler::pick_next()
 {
     ASSERT_INTERRUPTS_DISABLED();
-    ASSERT(!s_active);
+    auto& processor = Processor::current();
+    ASSERT(processor.kernel_lock_depth());
+    ASSERT(!processor.in_scheduler());
 
-    TemporaryChange<bool> change(s_active, true);
+    TemporaryChange<bool> change(processor.in_scheduler(), true);
 
-    ASSERT(s_active);
+    // Whatever we switched away from last has been saved by now.
+    processor.finish_switching_out_thread();
 
-    if (!Thread::current) {
-        // XXX: The first ever context_switch() goes to the idle process.
+    if (!Thread::current()) {
+        // XXX: The first ever context_switch() on a CPU goes to its idle thread.
         //      This to setup a reliable place we can return to.
-        return context_switch(*g_colonel);
+        return context_switch(*processor.idle_thread());
     }
 
     auto now = time_since_boot();
@@ -345,15 +640,18 @@ bool Scheduler::pick_next()
     auto now_sec = now.tv_sec;
     auto now_usec = now.tv_usec;
 
-    // Check and unblock threads whose wait conditions have been met.
-    Scheduler::for_each_nonrunnable([&](Thread& thread) {
+    // Everyone else gets woken up by whatever they're waiting for, but these threads
+    // are counting scheduler passes, or blocked on something that can't tell us.
+    auto& polled_threads = g_scheduler_data->m_polled_threads;
+    for (auto it = polled_threads.begin(); it != polled_threads.end();) {
+        auto& thread = *it;
+        it = ++it;
         thread.consider_unblock(now_sec, now_usec);
-        return IterationDecision::Continue;
-    });
+    }
 
     Process::for_each([&](Process& process) {
         if (process.is_dead()) {
-            if (Process::current->pid() != process.pid() && (!process.ppid() || !Process::from_pid(process.ppid()))) {
+            if (!is_current_on_any_processor(process) && (!process.ppid() || !Process::from_pid(process.ppid()))) {
                 auto name = process.name();
                 auto pid = process.pid();
                 auto exit_status = Process::reap(process);
@@ -361,10 +659,6 @@ bool Scheduler::pick_next()
             }
             return IterationDecision::Continue;
         }
-        if (process.m_alarm_deadline && g_uptime > process.m_alarm_deadline) {
-            process.m_alarm_deadline = 0;
-            process.send_signal(SIGALRM, nullptr);
-        }
         return IterationDecision::Continue;
     });
 
@@ -375,7 +669,10 @@ bool Scheduler::pick_next()
         // FIXME: It would be nice if the Scheduler didn't have to worry about who is "current"
         //        For now, avoid dispatching signals to "current" and do it in a scheduling pass
         //        while some other process is interrupted. Otherwise a mess will be made.
-        if (&thread == Thread::current)
+        if (&thread == Thread::current())
+            return IterationDecision::Continue;
+        // Same goes for threads currently running on (or leaving) another CPU.
+        if (thread.state() == Thread::Running || thread.is_being_switched_out())
             return IterationDecision::Continue;
         // We know how to interrupt blocked processes, but if they are just executing
         // at some random point in the kernel, let them continue.
@@ -410,34 +707,65 @@ bool Scheduler::pick_next()
     });
 #endif
 
-    Vector<Thread*, 128> sorted_runnables;
-    for_each_runnable([&sorted_runnables](auto& thread) {
-        sorted_runnables.append(&thread);
-        return IterationDecision::Continue;
-    });
-    quick_sort(sorted_runnables, [](auto& a, auto& b) { return a->effective_priority() >= b->effective_priority(); });
-
-    Thread* thread_to_schedule = nullptr;
+    auto& scheduler_data = *g_scheduler_data;
+    ++scheduler_data.m_pick_count;
 
-    for (auto* thread : sorted_runnables) {
-        if (thread->process().is_being_inspected())
-            continue;
+    auto* current_thread = Thread::current();
+    bool current_can_continue = current_thread != processor.idle_thread() && current_thread->state() == Thread::Running && can_schedule(*current_thread);
 
-        if (thread->process().exec_tid() && thread->process().exec_tid() != thread->tid())
-            continue;
+    // Real-time threads go first, unless they've had (almost) all of this second already.
+    Thread* thread_to_schedule = nullptr;
+    Thread* realtime_thread = scheduler_data.best_realtime_thread(processor.id());
+    if (current_can_continue && current_thread->is_realtime()) {
+        // A FIFO thread keeps going until it gives up the CPU or someone more important shows up,
+        // a round-robin thread makes way for its peers when its time slice runs out.
+        if (!realtime_thread
+            || realtime_thread->priority() < current_thread->priority()
+            || (realtime_thread->priority() == current_thread->priority() && current_thread->scheduling_policy() == SCHED_FIFO && !current_thread->ticks_left()))
+            realtime_thread = current_thread;
+    }
+    if (!scheduler_data.is_realtime_throttled(processor.id()))
+        thread_to_schedule = realtime_thread;
 
-        ASSERT(thread->state() == Thread::Runnable || thread->state() == Thread::Running);
+    u32 score = 0;
+    if (!thread_to_schedule) {
+        thread_to_schedule = scheduler_data.best_ready_thread(processor.id(), score);
 
-        if (!thread_to_schedule) {
-            thread->m_extra_priority = 0;
-            thread_to_schedule = thread;
-        } else {
-            thread->m_extra_priority++;
+        // Keep running the current thread unless someone at least as important is waiting.
+        if (current_can_continue && !current_thread->is_realtime()) {
+            if (!thread_to_schedule || score < fair_share_priority(*current_thread))
+                thread_to_schedule = current_thread;
         }
     }
 
+    if (!thread_to_schedule) {
+        // We'd be idling otherwise, so take the best thread waiting on some other CPU.
+        // Real-time threads that are stuck waiting for their CPU come first.
+        Thread* other_realtime_thread = nullptr;
+        Processor::for_each([&](Processor& other_processor) {
+            if (&other_processor == &processor || !scheduler_data.m_ready_queues[other_processor.id()].size)
+                return IterationDecision::Continue;
+            auto* realtime_candidate = scheduler_data.best_realtime_thread(other_processor.id());
+            if (realtime_candidate && (!other_realtime_thread || realtime_candidate->priority() > other_realtime_thread->priority()))
+                other_realtime_thread = realtime_candidate;
+            u32 other_score = 0;
+            auto* other_thread = scheduler_data.best_ready_thread(other_processor.id(), other_score);
+            if (other_thread && (!thread_to_schedule || other_score > score)) {
+                thread_to_schedule = other_thread;
+                score = other_score;
+            }
+            return IterationDecision::Continue;
+        });
+        if (other_realtime_thread)
+            thread_to_schedule = other_realtime_thread;
+    }
+
+    // Throttled real-time threads may still have whatever nobody else wants.
+    if (!thread_to_schedule)
+        thread_to_schedule = realtime_thread;
+
     if (!thread_to_schedule)
-        thread_to_schedule = g_colonel;
+        thread_to_schedule = processor.idle_thread();
 
 #ifdef SCHEDULER_DEBUG
     dbg() << "Scheduler: Switch to " << *thread_to_schedule << " @ " << String::format("%04x:%08x", thread_to_schedule->tss().cs, thread_to_schedule->tss().eip);
@@ -453,8 +781,11 @@ bool Scheduler::donate_to(Thread* beneficiary, const char* reason)
         return false;
 
     (void)reason;
-    unsigned ticks_left = Thread::current->ticks_left();
-    if (!beneficiary || beneficiary->state() != Thread::Runnable || ticks_left <= 1)
+    unsigned ticks_left = Thread::current()->ticks_left();
+    if (!beneficiary || beneficiary->state() != Thread::Runnable || beneficiary->is_being_switched_out() || ticks_left <= 1)
+        return yield();
+
+    if (!beneficiary->can_run_on(Processor::current().id()))
         return yield();
 
     unsigned ticks_to_donate = min(ticks_left - 1, time_slice_for(*beneficiary));
@@ -470,7 +801,7 @@ bool Scheduler::donate_to(Thread* beneficiary, const char* reason)
 bool Scheduler::yield()
 {
     InterruptDisabler disabler;
-    ASSERT(Thread::current);
+    ASSERT(Thread::current());
     if (!pick_next())
         return false;
     switch_now();
@@ -486,69 +817,108 @@ void Scheduler::pick_next_and_switch_now()
 
 void Scheduler::switch_now()
 {
-    Descriptor& descriptor = get_gdt_entry(Thread::current->selector());
+    ASSERT_INTERRUPTS_DISABLED();
+    auto& processor = Processor::current();
+    auto& incoming = *Thread::current();
+    if (auto* outgoing = processor.switching_out_thread())
+        outgoing->set_saved_kernel_lock_depth(processor.kernel_lock_depth());
+
+    // NOTE: If the incoming thread doesn't hold the kernel lock, this lets go of it.
+    //       The outgoing thread stays marked as being switched out until we're off its stack.
+    processor.set_kernel_lock_depth(kernel_lock_depth_to_resume(incoming));
+
+    Descriptor& descriptor = processor.get_gdt_entry(incoming.selector());
     descriptor.type = 9;
     asm("sti\n"
-        "ljmp *(%%eax)\n" ::"a"(&Thread::current->far_ptr()));
+        "ljmp *(%%eax)\n" ::"a"(&incoming.far_ptr()));
+
+    // We're back, possibly on a different CPU, with the kernel lock held.
+    Processor::current().finish_switching_out_thread();
+}
+
+// In tickless mode, the BSP only gets a timer interrupt when it asks for one: every tick as long as
+// it has something to do, and not before the next timer is due while it sits idle.
+static void program_next_tick(Processor& processor)
+{
+    auto& time_management = TimeManagement::the();
+    if (!processor.is_bootstrap_processor() || !time_management.is_tickless())
+        return;
+    // Even an idle CPU takes a look around every now and then.
+    static constexpr u64 max_idle_time_ns = 1'000'000'000;
+    u64 now = time_management.monotonic_time_ns();
+    u64 deadline = now + 1'000'000'000 / time_management.ticks_per_second();
+    bool is_idle = processor.current_thread() == processor.idle_thread()
+        && !g_scheduler_data->m_ready_queues[processor.id()].size
+        && g_scheduler_data->m_polled_threads.is_empty();
+    if (is_idle) {
+        deadline = now + max_idle_time_ns;
+        u64 next_timer_due = TimerQueue::the().next_timer_due();
+        if (next_timer_due && next_timer_due < deadline)
+            deadline = next_timer_due;
+    }
+    time_management.set_system_timer_deadline(deadline);
 }
 
 bool Scheduler::context_switch(Thread& thread)
 {
+    auto& processor = Processor::current();
     thread.set_ticks_left(time_slice_for(thread));
     thread.did_schedule();
 
-    if (Thread::current == &thread)
+    if (Thread::current() == &thread)
         return false;
 
-    if (Thread::current) {
+    ASSERT(!thread.is_being_switched_out());
+    processor.finish_switching_out_thread();
+
+    if (Thread::current()) {
+        if (auto* kernel_event_buffer = Thread::current()->process().kernel_event_buffer()) {
+            const char* reason = Thread::current()->state() == Thread::Running ? "Preempted" : Thread::current()->state_string();
+            kernel_event_buffer->append_context_switch(PERF_EVENT_CONTEXT_SWITCH_OUT, *Thread::current(), reason);
+        }
+
+        PerformanceCounters::switch_out(*Thread::current());
+
         // If the last process hasn't blocked (still marked as running),
         // mark it as runnable for the next round.
-        if (Thread::current->state() == Thread::Running)
-            Thread::current->set_state(Thread::Runnable);
+        if (Thread::current()->state() == Thread::Running)
+            Thread::current()->set_state(Thread::Runnable);
 
         asm volatile("fxsave %0"
-                     : "=m"(Thread::current->fpu_state()));
+                     : "=m"(Thread::current()->fpu_state()));
 
 #ifdef LOG_EVERY_CONTEXT_SWITCH
-        dbg() << "Scheduler: " << *Thread::current << " -> " << thread << " [" << thread.priority() << "] " << String::format("%w", thread.tss().cs) << ":" << String::format("%x", thread.tss().eip);
+        dbg() << "Scheduler: " << *Thread::current() << " -> " << thread << " [" << thread.priority() << "] " << String::format("%w", thread.tss().cs) << ":" << String::format("%x", thread.tss().eip);
 #endif
+
+        // No other CPU may pick up the outgoing thread until its state has been saved.
+        Thread::current()->set_being_switched_out(true);
+        processor.set_switching_out_thread(Thread::current());
     }
 
-    Thread::current = &thread;
-    Process::current = &thread.process();
+    bool was_idle = Thread::current() == processor.idle_thread();
+    processor.account_time(TimeManagement::the().monotonic_time_ns());
+    processor.set_current_thread(thread);
+    thread.m_last_processor = processor.id();
 
-    thread.set_state(Thread::Running);
+    if (auto* kernel_event_buffer = thread.process().kernel_event_buffer())
+        kernel_event_buffer->append_context_switch(PERF_EVENT_CONTEXT_SWITCH_IN, thread, nullptr);
+    PerformanceCounters::switch_in(thread);
 
-    asm volatile("fxrstor %0" ::"m"(Thread::current->fpu_state()));
+    // We may have stopped ticking while idle, so start again now that there's work to do.
+    if (was_idle)
+        program_next_tick(processor);
 
-    if (!thread.selector()) {
-        thread.set_selector(gdt_alloc_entry());
-        auto& descriptor = get_gdt_entry(thread.selector());
-        descriptor.set_base(&thread.tss());
-        descriptor.set_limit(sizeof(TSS32));
-        descriptor.dpl = 0;
-        descriptor.segment_present = 1;
-        descriptor.granularity = 0;
-        descriptor.zero = 0;
-        descriptor.operation_size = 1;
-        descriptor.descriptor_type = 0;
-    }
+    thread.set_state(Thread::Running);
 
-    if (!thread.thread_specific_data().is_null()) {
-        auto& descriptor = thread_specific_descriptor();
-        descriptor.set_base(thread.thread_specific_data().as_ptr());
-        descriptor.set_limit(sizeof(ThreadSpecificData*));
-    }
+    asm volatile("fxrstor %0" ::"m"(Thread::current()->fpu_state()));
 
-    auto& descriptor = get_gdt_entry(thread.selector());
-    descriptor.type = 11; // Busy TSS
-    return true;
-}
+    if (!thread.selector())
+        thread.set_selector(gdt_alloc_entry());
 
-static void initialize_redirection()
-{
-    auto& descriptor = get_gdt_entry(s_redirection.selector);
-    descriptor.set_base(&s_redirection.tss);
+    // The thread may have last run on another CPU, so (re)write its descriptors into this CPU's GDT.
+    auto& descriptor = processor.get_gdt_entry(thread.selector());
+    descriptor.set_base(&thread.tss());
     descriptor.set_limit(sizeof(TSS32));
     descriptor.dpl = 0;
     descriptor.segment_present = 1;
@@ -556,16 +926,24 @@ static void initialize_redirection()
     descriptor.zero = 0;
     descriptor.operation_size = 1;
     descriptor.descriptor_type = 0;
-    descriptor.type = 9;
-    flush_gdt();
+    descriptor.type = 11; // Busy TSS
+
+    if (!thread.thread_specific_data().is_null()) {
+        auto& descriptor = thread_specific_descriptor();
+        descriptor.set_base(thread.thread_specific_data().as_ptr());
+        descriptor.set_limit(sizeof(ThreadSpecificData*));
+    }
+
+    return true;
 }
 
 void Scheduler::prepare_for_iret_to_new_process()
 {
-    auto& descriptor = get_gdt_entry(s_redirection.selector);
+    auto& processor = Processor::current();
+    auto& descriptor = processor.get_gdt_entry(GDT_SELECTOR_REDIRECTION_TSS);
     descriptor.type = 9;
-    s_redirection.tss.backlink = Thread::current->selector();
-    load_task_register(s_redirection.selector);
+    processor.redirection_tss().backlink = Thread::current()->selector();
+    load_task_register(GDT_SELECTOR_REDIRECTION_TSS);
 }
 
 void Scheduler::prepare_to_modify_tss(Thread& thread)
@@ -573,8 +951,8 @@ void Scheduler::prepare_to_modify_tss(Thread& thread)
     // This ensures that a currently running process modifying its own TSS
     // in order to yield() and end up somewhere else doesn't just end up
     // right after the yield().
-    if (Thread::current == &thread)
-        load_task_register(s_redirection.selector);
+    if (Thread::current() == &thread)
+        load_task_register(GDT_SELECTOR_REDIRECTION_TSS);
 }
 
 Process* Scheduler::colonel()
@@ -582,49 +960,112 @@ Process* Scheduler::colonel()
     return s_colonel_process;
 }
 
+bool Scheduler::is_current_on_any_processor(const Process& process)
+{
+    bool found = false;
+    Processor::for_each([&](Processor& processor) {
+        auto* thread = processor.current_thread();
+        if (thread && &thread->process() == &process) {
+            found = true;
+            return IterationDecision::Break;
+        }
+        return IterationDecision::Continue;
+    });
+    return found;
+}
+
+static void make_idle_thread(Processor& processor, Thread& thread)
+{
+    // Idle threads start over in idle_loop() without the kernel lock. Since they
+    // never leave that loop, it doesn't matter that we never return to whatever
+    // brought the CPU into the scheduler.
+    thread.tss().eip = (FlatPtr)Scheduler::idle_loop;
+    thread.set_saved_kernel_lock_depth(0);
+    thread.set_priority(THREAD_PRIORITY_MIN);
+    processor.set_idle_thread(thread);
+}
+
 void Scheduler::initialize()
 {
     g_scheduler_data = new SchedulerData;
     g_finalizer_wait_queue = new WaitQueue;
     g_finalizer_has_work = false;
-    s_redirection.selector = gdt_alloc_entry();
-    initialize_redirection();
     s_colonel_process = Process::create_kernel_process(g_colonel, "colonel", nullptr);
-    g_colonel->set_priority(THREAD_PRIORITY_MIN);
-    load_task_register(s_redirection.selector);
+    make_idle_thread(Processor::current(), *g_colonel);
+    load_task_register(GDT_SELECTOR_REDIRECTION_TSS);
+}
+
+void Scheduler::initialize_ap()
+{
+    ASSERT_INTERRUPTS_DISABLED();
+    auto& processor = Processor::current();
+    ASSERT(!processor.is_bootstrap_processor());
+    ASSERT(processor.kernel_lock_depth());
+
+    auto* idle_thread = new Thread(*s_colonel_process);
+    idle_thread->set_name(String::format("colonel/%u", processor.id()));
+    idle_thread->set_state(Thread::State::Runnable);
+    make_idle_thread(processor, *idle_thread);
+    load_task_register(GDT_SELECTOR_REDIRECTION_TSS);
+
+    pick_next_and_switch_now();
+    ASSERT_NOT_REACHED();
 }
 
 void Scheduler::timer_tick(const RegisterState& regs)
 {
-    if (!Thread::current)
+    if (!Thread::current())
         return;
 
-    ++g_uptime;
+    auto& processor = Processor::current();
+
+    // Every CPU gets its own timer interrupt, but time only moves forward on the BSP.
+    if (processor.is_bootstrap_processor()) {
+        if (TimeManagement::the().is_tickless())
+            g_uptime = TimeManagement::the().ticks_since_boot();
+        else
+            ++g_uptime;
+        g_timeofday = TimeManagement::now_as_timeval();
+    }
 
-    g_timeofday = TimeManagement::now_as_timeval();
+    // Processes that sample on a performance counter take their samples when it overflows instead.
+    bool samples_on_counter = Process::current()->perf_counter_config().is_sampling();
+    if ((Process::current()->is_profiling() && !samples_on_counter) || Profiling::is_profiling_all_processes())
+        Profiling::take_sample(regs);
 
-    if (Process::current->is_profiling()) {
-        SmapDisabler disabler;
-        auto backtrace = Thread::current->raw_backtrace(regs.ebp, regs.eip);
-        auto& sample = Profiling::next_sample_slot();
-        sample.pid = Process::current->pid();
-        sample.tid = Thread::current->tid();
-        sample.timestamp = g_uptime;
-        for (size_t i = 0; i < min(backtrace.size(), Profiling::max_stack_frame_count); ++i) {
-            sample.frames[i] = backtrace[i];
-        }
+    if (processor.is_bootstrap_processor()) {
+        g_scheduler_data->m_fair_share_epoch = g_uptime / TimeManagement::the().ticks_per_second();
+        TimerQueue::the().fire();
     }
 
-    TimerQueue::the().fire();
+    auto& ready_queues = g_scheduler_data->m_ready_queues[processor.id()];
+    if (++ready_queues.ticks_this_period >= (u32)TimeManagement::the().ticks_per_second()) {
+        ready_queues.ticks_this_period = 0;
+        ready_queues.realtime_ticks_this_period = 0;
+    }
+    if (Thread::current()->is_realtime())
+        ++ready_queues.realtime_ticks_this_period;
+    if (Thread::current() != processor.idle_thread())
+        Thread::current()->process().scheduling_group().charge_tick(g_scheduler_data->m_fair_share_epoch);
 
-    if (Thread::current->tick())
+    if (Thread::current()->tick() && !should_preempt_for_realtime_thread(processor, *Thread::current())) {
+        program_next_tick(processor);
         return;
+    }
 
-    auto& outgoing_tss = Thread::current->tss();
+    auto& outgoing_thread = *Thread::current();
+    auto& outgoing_tss = outgoing_thread.tss();
 
-    if (!pick_next())
+    bool switched = pick_next();
+    program_next_tick(processor);
+    if (!switched)
         return;
 
+    // The interrupt handler holds one level of the kernel lock on top of whatever the
+    // outgoing thread had, and lets go of it right before the iret that switches tasks.
+    outgoing_thread.set_saved_kernel_lock_depth(processor.kernel_lock_depth() - 1);
+    processor.set_kernel_lock_depth(kernel_lock_depth_to_resume(*Thread::current()) + 1);
+
     outgoing_tss.gs = regs.gs;
     outgoing_tss.fs = regs.fs;
     outgoing_tss.es = regs.es;
@@ -658,22 +1099,35 @@ void Scheduler::timer_tick(const RegisterState& regs)
         "popf\n");
 }
 
-static bool s_should_stop_idling = false;
-
 void Scheduler::stop_idling()
 {
-    if (Thread::current != g_colonel)
-        return;
-
-    s_should_stop_idling = true;
+    // NOTE: CPUs that are halted in the idle loop will notice at their next timer tick at the latest,
+    //       or right away if they're tickless and need a wakeup IPI.
+    Processor::for_each([](Processor& processor) {
+        auto* thread = processor.current_thread();
+        if (thread && thread == processor.idle_thread())
+            wake_up_idle_processor(processor);
+        return IterationDecision::Continue;
+    });
 }
 
+// NOTE: The idle loop runs without the kernel lock, so that the other CPUs can get on with their work.
 void Scheduler::idle_loop()
 {
+    auto& processor = Processor::current();
+    ASSERT(!processor.kernel_lock_depth());
     for (;;) {
-        asm("hlt");
-        if (s_should_stop_idling) {
-            s_should_stop_idling = false;
+        // Check the flag with interrupts disabled, so that an interrupt that sets it can't sneak in right before the hlt.
+        // The sti only takes effect after the following instruction, so the hlt will still be woken by it.
+        cli();
+        if (processor.should_stop_idling())
+            sti();
+        else
+            asm("sti\n"
+                "hlt");
+        if (processor.should_stop_idling()) {
+            processor.set_should_stop_idling(false);
+            KernelLocker locker;
             yield();
         }
     }
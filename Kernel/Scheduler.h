@@ -51,6 +51,7 @@ extern timeval g_timeofday;
 class Scheduler {
 public:
     static void initialize();
+    [[noreturn]] static void initialize_ap();
     static void timer_tick(const RegisterState&);
     static bool pick_next();
     static timeval time_since_boot();
@@ -61,6 +62,7 @@ public:
     static bool context_switch(Thread&);
     static void prepare_to_modify_tss(Thread&);
     static Process* colonel();
+    static bool is_current_on_any_processor(const Process&);
     static bool is_active();
     static void beep();
     static void idle_loop();
@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2018-2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/NonnullRefPtr.h>
+#include <AK/RefCounted.h>
+#include <AK/StdLibExtras.h>
+#include <AK/Types.h>
+
+namespace Kernel {
+
+// All processes in a process group share one of these, and compete for the CPU as one.
+// The more CPU time a group has used recently compared to its weight, the less priority
+// its threads get, so that busy groups end up sharing the CPU in proportion to their weights.
+class SchedulingGroup : public RefCounted<SchedulingGroup> {
+public:
+    static constexpr u32 default_weight = 1024;
+    static constexpr u32 max_weight = 64 * default_weight;
+
+    static NonnullRefPtr<SchedulingGroup> create() { return adopt(*new SchedulingGroup); }
+
+    u32 weight() const { return m_weight; }
+    void set_weight(u32 weight) { m_weight = weight; }
+
+    // Recent usage halves every second (epoch), so this is roughly the last two seconds' worth of ticks.
+    void charge_tick(u32 epoch)
+    {
+        m_recent_ticks = recent_ticks(epoch) + 1;
+        m_epoch = epoch;
+    }
+
+    // A group hogging a whole CPU at the default weight loses between 16 and 32 points of priority.
+    u32 priority_penalty(u32 epoch, u32 ticks_per_second) const
+    {
+        return (u64)recent_ticks(epoch) * 16 * default_weight / ((u64)ticks_per_second * m_weight);
+    }
+
+private:
+    SchedulingGroup() { }
+
+    u32 recent_ticks(u32 epoch) const { return m_recent_ticks >> min(epoch - m_epoch, 31u); }
+
+    u32 m_weight { default_weight };
+    u32 m_recent_ticks { 0 };
+    u32 m_epoch { 0 };
+};
+
+}
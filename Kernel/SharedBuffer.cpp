@@ -43,7 +43,7 @@ void SharedBuffer::sanity_check(const char* what)
 
     unsigned found_refs = 0;
     for (const auto& ref : m_refs)
-        found_refs += ref.count;
+        found_refs += ref.count + ref.held;
 
     if (found_refs != m_total_refs) {
         dbg() << what << " sanity -- SharedBuffer{" << this << "} id: " << m_shbuf_id << " has total refs " << m_total_refs << " but we found " << found_refs;
@@ -95,6 +95,10 @@ void* SharedBuffer::ref_for_process_and_get_address(Process& process)
             }
             ref.count++;
             m_total_refs++;
+            if (ref.held) {
+                ref.held = false;
+                m_total_refs--;
+            }
             sanity_check("ref_for_process_and_get_address");
             return ref.region->vaddr().as_ptr();
         }
@@ -119,6 +123,27 @@ void SharedBuffer::share_with(pid_t peer_pid)
     sanity_check("share_with (new ref)");
 }
 
+void SharedBuffer::hand_over_to(pid_t peer_pid)
+{
+    LOCKER(shared_buffers().lock());
+    Reference* peer_ref = nullptr;
+    for (auto& ref : m_refs) {
+        if (ref.pid == peer_pid) {
+            peer_ref = &ref;
+            break;
+        }
+    }
+    if (!peer_ref) {
+        m_refs.append(Reference(peer_pid));
+        peer_ref = &m_refs.last();
+    }
+    if (!peer_ref->held) {
+        peer_ref->held = true;
+        m_total_refs++;
+    }
+    sanity_check("hand_over_to");
+}
+
 void SharedBuffer::deref_for_process(Process& process)
 {
     LOCKER(shared_buffers().lock());
@@ -132,6 +157,9 @@ void SharedBuffer::deref_for_process(Process& process)
                 dbg() << "Releasing shared buffer reference on " << m_shbuf_id << " of size " << size() << " by PID " << process.pid();
 #endif
                 process.deallocate_region(*ref.region);
+                // Someone handed it over again, so the peer is about to map it once more.
+                if (ref.held)
+                    return;
                 m_refs.unstable_remove(i);
 #ifdef SHARED_BUFFER_DEBUG
                 dbg() << "Released shared buffer reference on " << m_shbuf_id << " of size " << size() << " by PID " << process.pid();
@@ -156,7 +184,7 @@ void SharedBuffer::disown(pid_t pid)
 #ifdef SHARED_BUFFER_DEBUG
             dbg() << "Disowning shared buffer " << m_shbuf_id << " of size " << size() << " by PID " << pid;
 #endif
-            m_total_refs -= ref.count;
+            m_total_refs -= ref.count + ref.held;
             m_refs.unstable_remove(i);
 #ifdef SHARED_BUFFER_DEBUG
             dbg() << "Disowned shared buffer " << m_shbuf_id << " of size " << size() << " by PID " << pid;
@@ -43,6 +43,8 @@ private:
 
         pid_t pid;
         unsigned count { 0 };
+        // Taken by whoever handed the buffer over, until this process has mapped it.
+        bool held { false };
         WeakPtr<Region> region;
     };
 
@@ -67,6 +69,7 @@ public:
     bool is_shared_with(pid_t peer_pid) const;
     void* ref_for_process_and_get_address(Process& process);
     void share_with(pid_t peer_pid);
+    void hand_over_to(pid_t peer_pid);
     void share_globally() { m_global = true; }
     void deref_for_process(Process& process);
     void disown(pid_t pid);
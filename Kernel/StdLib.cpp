@@ -28,6 +28,7 @@
 #include <AK/String.h>
 #include <AK/Types.h>
 #include <Kernel/Arch/i386/CPU.h>
+#include <Kernel/Arch/i386/SafeMem.h>
 #include <Kernel/Heap/kmalloc.h>
 #include <Kernel/StdLib.h>
 #include <Kernel/VM/MemoryManager.h>
@@ -41,24 +42,123 @@ String copy_string_from_user(const char* user_str, size_t user_str_size)
 
 extern "C" {
 
-void copy_to_user(void* dest_ptr, const void* src_ptr, size_t n)
+bool copy_to_user(void* dest_ptr, const void* src_ptr, size_t n)
 {
-    ASSERT(Kernel::is_user_range(VirtualAddress(dest_ptr), n));
+    if (!Kernel::is_user_range(VirtualAddress(dest_ptr), n))
+        return false;
     ASSERT(!Kernel::is_user_range(VirtualAddress(src_ptr), n));
     Kernel::SmapDisabler disabler;
-    memcpy(dest_ptr, src_ptr, n);
+    return Kernel::safe_memcpy(dest_ptr, src_ptr, n);
 }
 
-void copy_from_user(void* dest_ptr, const void* src_ptr, size_t n)
+bool copy_from_user(void* dest_ptr, const void* src_ptr, size_t n)
 {
-    ASSERT(Kernel::is_user_range(VirtualAddress(src_ptr), n));
+    if (!Kernel::is_user_range(VirtualAddress(src_ptr), n))
+        return false;
     ASSERT(!Kernel::is_user_range(VirtualAddress(dest_ptr), n));
     Kernel::SmapDisabler disabler;
-    memcpy(dest_ptr, src_ptr, n);
+    return Kernel::safe_memcpy(dest_ptr, src_ptr, n);
+}
+
+// Nothing saves the FPU state when entering the kernel, so the SSE registers still hold userspace's
+// values here. The copies below save the registers they use and put them back before they're done.
+static constexpr size_t min_size_for_sse2 = 1024;
+
+static void* sse2_memcpy(void* dest_ptr, const void* src_ptr, size_t n)
+{
+    auto* dest = (u8*)dest_ptr;
+    auto* src = (const u8*)src_ptr;
+
+    size_t prologue = -(FlatPtr)dest & 15;
+    n -= prologue;
+    asm volatile(
+        "rep movsb\n"
+        : "+S"(src), "+D"(dest), "+c"(prologue)
+        :
+        : "memory");
+
+    size_t chunks = n / 64;
+    n %= 64;
+    u8 saved_registers[64];
+    asm volatile(
+        "movdqu %%xmm0, (%[saved])\n"
+        "movdqu %%xmm1, 16(%[saved])\n"
+        "movdqu %%xmm2, 32(%[saved])\n"
+        "movdqu %%xmm3, 48(%[saved])\n"
+        "1:\n"
+        "movdqu (%[src]), %%xmm0\n"
+        "movdqu 16(%[src]), %%xmm1\n"
+        "movdqu 32(%[src]), %%xmm2\n"
+        "movdqu 48(%[src]), %%xmm3\n"
+        "movdqa %%xmm0, (%[dest])\n"
+        "movdqa %%xmm1, 16(%[dest])\n"
+        "movdqa %%xmm2, 32(%[dest])\n"
+        "movdqa %%xmm3, 48(%[dest])\n"
+        "addl $64, %[src]\n"
+        "addl $64, %[dest]\n"
+        "decl %[chunks]\n"
+        "jnz 1b\n"
+        "movdqu (%[saved]), %%xmm0\n"
+        "movdqu 16(%[saved]), %%xmm1\n"
+        "movdqu 32(%[saved]), %%xmm2\n"
+        "movdqu 48(%[saved]), %%xmm3\n"
+        : [src] "+r"(src), [dest] "+r"(dest), [chunks] "+r"(chunks)
+        : [saved] "r"(saved_registers)
+        : "memory", "cc");
+
+    asm volatile(
+        "rep movsb\n"
+        : "+S"(src), "+D"(dest), "+c"(n)
+        :
+        : "memory");
+    return dest_ptr;
+}
+
+static void* sse2_memset(void* dest_ptr, int c, size_t n)
+{
+    auto* dest = (u8*)dest_ptr;
+
+    size_t prologue = -(FlatPtr)dest & 15;
+    n -= prologue;
+    asm volatile(
+        "rep stosb\n"
+        : "+D"(dest), "+c"(prologue)
+        : "a"(c)
+        : "memory");
+
+    size_t chunks = n / 64;
+    n %= 64;
+    u8 saved_register[16];
+    asm volatile(
+        "movdqu %%xmm0, (%[saved])\n"
+        "movd %[pattern], %%xmm0\n"
+        "pshufd $0, %%xmm0, %%xmm0\n"
+        "1:\n"
+        "movdqa %%xmm0, (%[dest])\n"
+        "movdqa %%xmm0, 16(%[dest])\n"
+        "movdqa %%xmm0, 32(%[dest])\n"
+        "movdqa %%xmm0, 48(%[dest])\n"
+        "addl $64, %[dest]\n"
+        "decl %[chunks]\n"
+        "jnz 1b\n"
+        "movdqu (%[saved]), %%xmm0\n"
+        : [dest] "+r"(dest), [chunks] "+r"(chunks)
+        : [pattern] "r"((u8)c * 0x01010101u), [saved] "r"(saved_register)
+        : "memory", "cc");
+
+    asm volatile(
+        "rep stosb\n"
+        : "+D"(dest), "+c"(n)
+        : "a"(c)
+        : "memory");
+    return dest_ptr;
 }
 
 void* memcpy(void* dest_ptr, const void* src_ptr, size_t n)
 {
+    if (n >= min_size_for_sse2 && Kernel::g_cpu_supports_sse2)
+        return sse2_memcpy(dest_ptr, src_ptr, n);
+
     size_t dest = (size_t)dest_ptr;
     size_t src = (size_t)src_ptr;
     // FIXME: Support starting at an unaligned address.
@@ -110,15 +210,19 @@ char* strncpy(char* dest, const char* src, size_t n)
     return dest;
 }
 
-void memset_user(void* dest_ptr, int c, size_t n)
+bool memset_user(void* dest_ptr, int c, size_t n)
 {
-    ASSERT(Kernel::is_user_range(VirtualAddress(dest_ptr), n));
+    if (!Kernel::is_user_range(VirtualAddress(dest_ptr), n))
+        return false;
     Kernel::SmapDisabler disabler;
-    memset(dest_ptr, c, n);
+    return Kernel::safe_memset(dest_ptr, c, n);
 }
 
 void* memset(void* dest_ptr, int c, size_t n)
 {
+    if (n >= min_size_for_sse2 && Kernel::g_cpu_supports_sse2)
+        return sse2_memset(dest_ptr, c, n);
+
     size_t dest = (size_t)dest_ptr;
     // FIXME: Support starting at an unaligned address.
     if (!(dest & 0x3) && n >= 12) {
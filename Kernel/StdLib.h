@@ -36,9 +36,10 @@ String copy_string_from_user(const char*, size_t);
 
 extern "C" {
 
-void copy_to_user(void*, const void*, size_t);
-void copy_from_user(void*, const void*, size_t);
-void memset_user(void*, int, size_t);
+// These fail (returning false) if the user side isn't all user memory, or if it faults.
+bool copy_to_user(void*, const void*, size_t);
+bool copy_from_user(void*, const void*, size_t);
+bool memset_user(void*, int, size_t);
 
 void* memcpy(void*, const void*, size_t);
 char* strcpy(char*, const char*);
@@ -59,13 +60,13 @@ inline u16 htons(u16 w) { return (w & 0xff) << 8 | ((w >> 8) & 0xff); }
 }
 
 template<typename T>
-inline void copy_from_user(T* dest, const T* src)
+inline bool copy_from_user(T* dest, const T* src)
 {
-    copy_from_user(dest, src, sizeof(T));
+    return copy_from_user(dest, src, sizeof(T));
 }
 
 template<typename T>
-inline void copy_to_user(T* dest, const T* src)
+inline bool copy_to_user(T* dest, const T* src)
 {
-    copy_to_user(dest, src, sizeof(T));
+    return copy_to_user(dest, src, sizeof(T));
 }
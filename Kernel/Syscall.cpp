@@ -25,10 +25,13 @@
  */
 
 #include <Kernel/Arch/i386/CPU.h>
+#include <Kernel/PerformanceEventBuffer.h>
 #include <Kernel/Process.h>
 #include <Kernel/Random.h>
 #include <Kernel/Syscall.h>
+#include <Kernel/SyscallStatistics.h>
 #include <Kernel/ThreadTracer.h>
+#include <Kernel/Time/TimeManagement.h>
 #include <Kernel/VM/MemoryManager.h>
 
 namespace Kernel {
@@ -49,6 +52,8 @@ asm(
     "    mov $0x10, %ax\n"
     "    mov %ax, %ds\n"
     "    mov %ax, %es\n"
+    "    mov $0x28, %ax\n" // GDT_SELECTOR_PROC
+    "    mov %ax, %fs\n"
     "    cld\n"
     "    xor %esi, %esi\n"
     "    xor %edi, %edi\n"
@@ -77,17 +82,39 @@ void initialize()
 typedef int (Process::*Handler)(u32, u32, u32);
 #define __ENUMERATE_REMOVED_SYSCALL(x) nullptr,
 #define __ENUMERATE_SYSCALL(x) reinterpret_cast<Handler>(&Process::sys$##x),
+#define __ENUMERATE_UNLOCKED_SYSCALL(x) __ENUMERATE_SYSCALL(x)
 static Handler s_syscall_table[] = {
     ENUMERATE_SYSCALLS
 };
 #undef __ENUMERATE_SYSCALL
+#undef __ENUMERATE_UNLOCKED_SYSCALL
 #undef __ENUMERATE_REMOVED_SYSCALL
 
+// Syscalls that only touch per-thread state, or process state that is only changed
+// with interrupts disabled (the fd table, regions and credentials), don't have to wait
+// for the process big lock.
+#define __ENUMERATE_REMOVED_SYSCALL(x) true,
+#define __ENUMERATE_SYSCALL(x) true,
+#define __ENUMERATE_UNLOCKED_SYSCALL(x) false,
+static bool s_syscall_needs_big_lock[] = {
+    ENUMERATE_SYSCALLS
+};
+#undef __ENUMERATE_SYSCALL
+#undef __ENUMERATE_UNLOCKED_SYSCALL
+#undef __ENUMERATE_REMOVED_SYSCALL
+
+bool needs_big_lock(u32 function)
+{
+    if (function >= Function::__Count)
+        return true;
+    return s_syscall_needs_big_lock[function];
+}
+
 int handle(RegisterState& regs, u32 function, u32 arg1, u32 arg2, u32 arg3)
 {
     ASSERT_INTERRUPTS_ENABLED();
-    auto& process = *Process::current;
-    Thread::current->did_syscall();
+    auto& process = *Process::current();
+    Thread::current()->did_syscall();
 
     if (function == SC_exit || function == SC_exit_thread) {
         // These syscalls need special handling since they never return to the caller.
@@ -125,14 +152,16 @@ void syscall_handler(RegisterState& regs)
     // Special handling of the "gettid" syscall since it's extremely hot.
     // FIXME: Remove this hack once userspace locks stop calling it so damn much.
     if (regs.eax == SC_gettid) {
-        regs.eax = Process::current->sys$gettid();
-        Thread::current->did_syscall();
+        regs.eax = Process::current()->sys$gettid();
+        Thread::current()->did_syscall();
         return;
     }
 
-    if (Thread::current->tracer() && Thread::current->tracer()->is_tracing_syscalls()) {
-        Thread::current->tracer()->set_trace_syscalls(false);
-        Thread::current->tracer_trap(regs);
+    KernelLocker locker;
+
+    if (Thread::current()->tracer() && Thread::current()->tracer()->is_tracing_syscalls()) {
+        Thread::current()->tracer()->set_trace_syscalls(false);
+        Thread::current()->tracer_trap(regs);
     }
 
     // Make sure SMAP protection is enabled on syscall entry.
@@ -144,7 +173,7 @@ void syscall_handler(RegisterState& regs)
     asm volatile(""
                  : "=m"(*ptr));
 
-    auto& process = *Process::current;
+    auto& process = *Process::current();
 
     if (!MM.validate_user_stack(process, VirtualAddress(regs.userspace_esp))) {
         dbg() << "Invalid stack pointer: " << String::format("%p", regs.userspace_esp);
@@ -165,25 +194,40 @@ void syscall_handler(RegisterState& regs)
         ASSERT_NOT_REACHED();
     }
 
-    process.big_lock().lock();
     u32 function = regs.eax;
+    u64 start_tsc = process.kernel_event_buffer() ? read_tsc() : 0;
+    u64 start_ns = process.syscall_statistics() ? TimeManagement::the().monotonic_time_ns() : 0;
+    bool needs_big_lock = Syscall::needs_big_lock(function);
+    if (needs_big_lock)
+        process.big_lock().lock();
     u32 arg1 = regs.edx;
     u32 arg2 = regs.ecx;
     u32 arg3 = regs.ebx;
     regs.eax = (u32)Syscall::handle(regs, function, arg1, arg2, arg3);
 
-    if (Thread::current->tracer() && Thread::current->tracer()->is_tracing_syscalls()) {
-        Thread::current->tracer()->set_trace_syscalls(false);
-        Thread::current->tracer_trap(regs);
+    if (start_tsc) {
+        if (auto* kernel_event_buffer = process.kernel_event_buffer())
+            kernel_event_buffer->append_syscall(*Thread::current(), function, start_tsc);
+    }
+
+    if (start_ns) {
+        if (auto* syscall_statistics = process.syscall_statistics())
+            syscall_statistics->record(function, (int)regs.eax, TimeManagement::the().monotonic_time_ns() - start_ns);
+    }
+
+    if (Thread::current()->tracer() && Thread::current()->tracer()->is_tracing_syscalls()) {
+        Thread::current()->tracer()->set_trace_syscalls(false);
+        Thread::current()->tracer_trap(regs);
     }
 
-    process.big_lock().unlock();
+    if (needs_big_lock)
+        process.big_lock().unlock();
 
     // Check if we're supposed to return to userspace or just die.
-    Thread::current->die_if_needed();
+    Thread::current()->die_if_needed();
 
-    if (Thread::current->has_unmasked_pending_signals())
-        (void)Thread::current->block<Thread::SemiPermanentBlocker>(Thread::SemiPermanentBlocker::Reason::Signal);
+    if (Thread::current()->has_unmasked_pending_signals())
+        (void)Thread::current()->block<Thread::SemiPermanentBlocker>(Thread::SemiPermanentBlocker::Reason::Signal);
 }
 
 }
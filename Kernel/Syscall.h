@@ -39,150 +39,168 @@ struct timeval;
 struct timespec;
 struct sockaddr;
 struct siginfo;
+struct iovec;
+struct epoll_event;
 typedef u32 socklen_t;
 }
 
 namespace Kernel {
 
-#define ENUMERATE_SYSCALLS                    \
-    __ENUMERATE_SYSCALL(sleep)                \
-    __ENUMERATE_SYSCALL(yield)                \
-    __ENUMERATE_SYSCALL(open)                 \
-    __ENUMERATE_SYSCALL(close)                \
-    __ENUMERATE_SYSCALL(read)                 \
-    __ENUMERATE_SYSCALL(lseek)                \
-    __ENUMERATE_SYSCALL(kill)                 \
-    __ENUMERATE_SYSCALL(getuid)               \
-    __ENUMERATE_SYSCALL(exit)                 \
-    __ENUMERATE_SYSCALL(getgid)               \
-    __ENUMERATE_SYSCALL(getpid)               \
-    __ENUMERATE_SYSCALL(waitid)               \
-    __ENUMERATE_SYSCALL(mmap)                 \
-    __ENUMERATE_SYSCALL(munmap)               \
-    __ENUMERATE_SYSCALL(get_dir_entries)      \
-    __ENUMERATE_SYSCALL(getcwd)               \
-    __ENUMERATE_SYSCALL(gettimeofday)         \
-    __ENUMERATE_SYSCALL(gethostname)          \
-    __ENUMERATE_SYSCALL(sethostname)          \
-    __ENUMERATE_SYSCALL(chdir)                \
-    __ENUMERATE_SYSCALL(uname)                \
-    __ENUMERATE_SYSCALL(set_mmap_name)        \
-    __ENUMERATE_SYSCALL(readlink)             \
-    __ENUMERATE_SYSCALL(write)                \
-    __ENUMERATE_SYSCALL(ttyname_r)            \
-    __ENUMERATE_SYSCALL(stat)                 \
-    __ENUMERATE_SYSCALL(getsid)               \
-    __ENUMERATE_SYSCALL(setsid)               \
-    __ENUMERATE_SYSCALL(getpgid)              \
-    __ENUMERATE_SYSCALL(setpgid)              \
-    __ENUMERATE_SYSCALL(getpgrp)              \
-    __ENUMERATE_SYSCALL(fork)                 \
-    __ENUMERATE_SYSCALL(execve)               \
-    __ENUMERATE_SYSCALL(geteuid)              \
-    __ENUMERATE_SYSCALL(getegid)              \
-    __ENUMERATE_SYSCALL(dup)                  \
-    __ENUMERATE_SYSCALL(dup2)                 \
-    __ENUMERATE_SYSCALL(sigaction)            \
-    __ENUMERATE_SYSCALL(getppid)              \
-    __ENUMERATE_SYSCALL(umask)                \
-    __ENUMERATE_SYSCALL(getgroups)            \
-    __ENUMERATE_SYSCALL(setgroups)            \
-    __ENUMERATE_SYSCALL(sigreturn)            \
-    __ENUMERATE_SYSCALL(sigprocmask)          \
-    __ENUMERATE_SYSCALL(sigpending)           \
-    __ENUMERATE_SYSCALL(pipe)                 \
-    __ENUMERATE_SYSCALL(killpg)               \
-    __ENUMERATE_SYSCALL(setuid)               \
-    __ENUMERATE_SYSCALL(setgid)               \
-    __ENUMERATE_SYSCALL(alarm)                \
-    __ENUMERATE_SYSCALL(fstat)                \
-    __ENUMERATE_SYSCALL(access)               \
-    __ENUMERATE_SYSCALL(fcntl)                \
-    __ENUMERATE_SYSCALL(ioctl)                \
-    __ENUMERATE_SYSCALL(mkdir)                \
-    __ENUMERATE_SYSCALL(times)                \
-    __ENUMERATE_SYSCALL(utime)                \
-    __ENUMERATE_SYSCALL(sync)                 \
-    __ENUMERATE_SYSCALL(ptsname_r)            \
-    __ENUMERATE_SYSCALL(select)               \
-    __ENUMERATE_SYSCALL(unlink)               \
-    __ENUMERATE_SYSCALL(poll)                 \
-    __ENUMERATE_SYSCALL(rmdir)                \
-    __ENUMERATE_SYSCALL(chmod)                \
-    __ENUMERATE_SYSCALL(usleep)               \
-    __ENUMERATE_SYSCALL(socket)               \
-    __ENUMERATE_SYSCALL(bind)                 \
-    __ENUMERATE_SYSCALL(accept)               \
-    __ENUMERATE_SYSCALL(listen)               \
-    __ENUMERATE_SYSCALL(connect)              \
-    __ENUMERATE_SYSCALL(shbuf_create)         \
-    __ENUMERATE_SYSCALL(shbuf_allow_pid)      \
-    __ENUMERATE_SYSCALL(shbuf_get)            \
-    __ENUMERATE_SYSCALL(shbuf_release)        \
-    __ENUMERATE_SYSCALL(link)                 \
-    __ENUMERATE_SYSCALL(chown)                \
-    __ENUMERATE_SYSCALL(fchmod)               \
-    __ENUMERATE_SYSCALL(symlink)              \
-    __ENUMERATE_SYSCALL(shbuf_seal)           \
-    __ENUMERATE_SYSCALL(sendto)               \
-    __ENUMERATE_SYSCALL(recvfrom)             \
-    __ENUMERATE_SYSCALL(getsockopt)           \
-    __ENUMERATE_SYSCALL(setsockopt)           \
-    __ENUMERATE_SYSCALL(create_thread)        \
-    __ENUMERATE_SYSCALL(gettid)               \
-    __ENUMERATE_SYSCALL(donate)               \
-    __ENUMERATE_SYSCALL(rename)               \
-    __ENUMERATE_SYSCALL(ftruncate)            \
-    __ENUMERATE_SYSCALL(exit_thread)          \
-    __ENUMERATE_SYSCALL(mknod)                \
-    __ENUMERATE_SYSCALL(writev)               \
-    __ENUMERATE_SYSCALL(beep)                 \
-    __ENUMERATE_SYSCALL(getsockname)          \
-    __ENUMERATE_SYSCALL(getpeername)          \
-    __ENUMERATE_SYSCALL(sched_setparam)       \
-    __ENUMERATE_SYSCALL(sched_getparam)       \
-    __ENUMERATE_SYSCALL(fchown)               \
-    __ENUMERATE_SYSCALL(halt)                 \
-    __ENUMERATE_SYSCALL(reboot)               \
-    __ENUMERATE_SYSCALL(mount)                \
-    __ENUMERATE_SYSCALL(umount)               \
-    __ENUMERATE_SYSCALL(dump_backtrace)       \
-    __ENUMERATE_SYSCALL(dbgputch)             \
-    __ENUMERATE_SYSCALL(dbgputstr)            \
-    __ENUMERATE_SYSCALL(watch_file)           \
-    __ENUMERATE_SYSCALL(shbuf_allow_all)      \
-    __ENUMERATE_SYSCALL(set_process_icon)     \
-    __ENUMERATE_SYSCALL(mprotect)             \
-    __ENUMERATE_SYSCALL(realpath)             \
-    __ENUMERATE_SYSCALL(get_process_name)     \
-    __ENUMERATE_SYSCALL(fchdir)               \
-    __ENUMERATE_SYSCALL(getrandom)            \
-    __ENUMERATE_SYSCALL(setkeymap)            \
-    __ENUMERATE_SYSCALL(clock_gettime)        \
-    __ENUMERATE_SYSCALL(clock_settime)        \
-    __ENUMERATE_SYSCALL(clock_nanosleep)      \
-    __ENUMERATE_SYSCALL(join_thread)          \
-    __ENUMERATE_SYSCALL(module_load)          \
-    __ENUMERATE_SYSCALL(module_unload)        \
-    __ENUMERATE_SYSCALL(detach_thread)        \
-    __ENUMERATE_SYSCALL(set_thread_name)      \
-    __ENUMERATE_SYSCALL(get_thread_name)      \
-    __ENUMERATE_SYSCALL(madvise)              \
-    __ENUMERATE_SYSCALL(purge)                \
-    __ENUMERATE_SYSCALL(shbuf_set_volatile)   \
-    __ENUMERATE_SYSCALL(profiling_enable)     \
-    __ENUMERATE_SYSCALL(profiling_disable)    \
-    __ENUMERATE_SYSCALL(futex)                \
-    __ENUMERATE_SYSCALL(set_thread_boost)     \
-    __ENUMERATE_SYSCALL(set_process_boost)    \
-    __ENUMERATE_SYSCALL(chroot)               \
-    __ENUMERATE_SYSCALL(pledge)               \
-    __ENUMERATE_SYSCALL(unveil)               \
-    __ENUMERATE_SYSCALL(perf_event)           \
-    __ENUMERATE_SYSCALL(shutdown)             \
-    __ENUMERATE_SYSCALL(get_stack_bounds)     \
-    __ENUMERATE_SYSCALL(ptrace)               \
-    __ENUMERATE_SYSCALL(minherit)
+#define ENUMERATE_SYSCALLS                        \
+    __ENUMERATE_UNLOCKED_SYSCALL(sleep)           \
+    __ENUMERATE_UNLOCKED_SYSCALL(yield)           \
+    __ENUMERATE_SYSCALL(open)                     \
+    __ENUMERATE_SYSCALL(close)                    \
+    __ENUMERATE_UNLOCKED_SYSCALL(read)            \
+    __ENUMERATE_SYSCALL(lseek)                    \
+    __ENUMERATE_SYSCALL(kill)                     \
+    __ENUMERATE_UNLOCKED_SYSCALL(getuid)          \
+    __ENUMERATE_SYSCALL(exit)                     \
+    __ENUMERATE_UNLOCKED_SYSCALL(getgid)          \
+    __ENUMERATE_UNLOCKED_SYSCALL(getpid)          \
+    __ENUMERATE_SYSCALL(waitid)                   \
+    __ENUMERATE_SYSCALL(mmap)                     \
+    __ENUMERATE_SYSCALL(munmap)                   \
+    __ENUMERATE_SYSCALL(get_dir_entries)          \
+    __ENUMERATE_SYSCALL(getcwd)                   \
+    __ENUMERATE_SYSCALL(gettimeofday)             \
+    __ENUMERATE_SYSCALL(gethostname)              \
+    __ENUMERATE_SYSCALL(sethostname)              \
+    __ENUMERATE_SYSCALL(chdir)                    \
+    __ENUMERATE_SYSCALL(uname)                    \
+    __ENUMERATE_SYSCALL(set_mmap_name)            \
+    __ENUMERATE_SYSCALL(readlink)                 \
+    __ENUMERATE_UNLOCKED_SYSCALL(write)           \
+    __ENUMERATE_SYSCALL(ttyname_r)                \
+    __ENUMERATE_SYSCALL(stat)                     \
+    __ENUMERATE_SYSCALL(getsid)                   \
+    __ENUMERATE_SYSCALL(setsid)                   \
+    __ENUMERATE_SYSCALL(getpgid)                  \
+    __ENUMERATE_SYSCALL(setpgid)                  \
+    __ENUMERATE_SYSCALL(getpgrp)                  \
+    __ENUMERATE_SYSCALL(fork)                     \
+    __ENUMERATE_SYSCALL(execve)                   \
+    __ENUMERATE_UNLOCKED_SYSCALL(geteuid)         \
+    __ENUMERATE_UNLOCKED_SYSCALL(getegid)         \
+    __ENUMERATE_SYSCALL(dup)                      \
+    __ENUMERATE_SYSCALL(dup2)                     \
+    __ENUMERATE_SYSCALL(sigaction)                \
+    __ENUMERATE_UNLOCKED_SYSCALL(getppid)         \
+    __ENUMERATE_SYSCALL(umask)                    \
+    __ENUMERATE_UNLOCKED_SYSCALL(getgroups)       \
+    __ENUMERATE_SYSCALL(setgroups)                \
+    __ENUMERATE_SYSCALL(sigreturn)                \
+    __ENUMERATE_SYSCALL(sigprocmask)              \
+    __ENUMERATE_SYSCALL(sigpending)               \
+    __ENUMERATE_SYSCALL(pipe)                     \
+    __ENUMERATE_SYSCALL(killpg)                   \
+    __ENUMERATE_SYSCALL(setuid)                   \
+    __ENUMERATE_SYSCALL(setgid)                   \
+    __ENUMERATE_SYSCALL(alarm)                    \
+    __ENUMERATE_SYSCALL(fstat)                    \
+    __ENUMERATE_SYSCALL(access)                   \
+    __ENUMERATE_SYSCALL(fcntl)                    \
+    __ENUMERATE_SYSCALL(ioctl)                    \
+    __ENUMERATE_SYSCALL(mkdir)                    \
+    __ENUMERATE_SYSCALL(times)                    \
+    __ENUMERATE_SYSCALL(utime)                    \
+    __ENUMERATE_SYSCALL(sync)                     \
+    __ENUMERATE_SYSCALL(ptsname_r)                \
+    __ENUMERATE_SYSCALL(select)                   \
+    __ENUMERATE_SYSCALL(unlink)                   \
+    __ENUMERATE_SYSCALL(poll)                     \
+    __ENUMERATE_SYSCALL(rmdir)                    \
+    __ENUMERATE_SYSCALL(chmod)                    \
+    __ENUMERATE_UNLOCKED_SYSCALL(usleep)          \
+    __ENUMERATE_SYSCALL(socket)                   \
+    __ENUMERATE_SYSCALL(bind)                     \
+    __ENUMERATE_SYSCALL(accept)                   \
+    __ENUMERATE_SYSCALL(listen)                   \
+    __ENUMERATE_SYSCALL(connect)                  \
+    __ENUMERATE_SYSCALL(shbuf_create)             \
+    __ENUMERATE_SYSCALL(shbuf_allow_pid)          \
+    __ENUMERATE_SYSCALL(shbuf_get)                \
+    __ENUMERATE_SYSCALL(shbuf_release)            \
+    __ENUMERATE_SYSCALL(link)                     \
+    __ENUMERATE_SYSCALL(chown)                    \
+    __ENUMERATE_SYSCALL(fchmod)                   \
+    __ENUMERATE_SYSCALL(symlink)                  \
+    __ENUMERATE_SYSCALL(shbuf_seal)               \
+    __ENUMERATE_SYSCALL(sendto)                   \
+    __ENUMERATE_SYSCALL(recvfrom)                 \
+    __ENUMERATE_SYSCALL(getsockopt)               \
+    __ENUMERATE_SYSCALL(setsockopt)               \
+    __ENUMERATE_SYSCALL(create_thread)            \
+    __ENUMERATE_UNLOCKED_SYSCALL(gettid)          \
+    __ENUMERATE_SYSCALL(donate)                   \
+    __ENUMERATE_SYSCALL(rename)                   \
+    __ENUMERATE_SYSCALL(ftruncate)                \
+    __ENUMERATE_SYSCALL(exit_thread)              \
+    __ENUMERATE_SYSCALL(mknod)                    \
+    __ENUMERATE_UNLOCKED_SYSCALL(writev)          \
+    __ENUMERATE_SYSCALL(beep)                     \
+    __ENUMERATE_SYSCALL(getsockname)              \
+    __ENUMERATE_SYSCALL(getpeername)              \
+    __ENUMERATE_SYSCALL(sched_setparam)           \
+    __ENUMERATE_SYSCALL(sched_getparam)           \
+    __ENUMERATE_SYSCALL(fchown)                   \
+    __ENUMERATE_SYSCALL(halt)                     \
+    __ENUMERATE_SYSCALL(reboot)                   \
+    __ENUMERATE_SYSCALL(mount)                    \
+    __ENUMERATE_SYSCALL(umount)                   \
+    __ENUMERATE_SYSCALL(dump_backtrace)           \
+    __ENUMERATE_SYSCALL(dbgputch)                 \
+    __ENUMERATE_SYSCALL(dbgputstr)                \
+    __ENUMERATE_SYSCALL(watch_file)               \
+    __ENUMERATE_SYSCALL(shbuf_allow_all)          \
+    __ENUMERATE_SYSCALL(set_process_icon)         \
+    __ENUMERATE_SYSCALL(mprotect)                 \
+    __ENUMERATE_SYSCALL(realpath)                 \
+    __ENUMERATE_SYSCALL(get_process_name)         \
+    __ENUMERATE_SYSCALL(fchdir)                   \
+    __ENUMERATE_UNLOCKED_SYSCALL(getrandom)       \
+    __ENUMERATE_SYSCALL(setkeymap)                \
+    __ENUMERATE_UNLOCKED_SYSCALL(clock_gettime)   \
+    __ENUMERATE_SYSCALL(clock_settime)            \
+    __ENUMERATE_UNLOCKED_SYSCALL(clock_nanosleep) \
+    __ENUMERATE_SYSCALL(join_thread)              \
+    __ENUMERATE_SYSCALL(module_load)              \
+    __ENUMERATE_SYSCALL(module_unload)            \
+    __ENUMERATE_SYSCALL(detach_thread)            \
+    __ENUMERATE_SYSCALL(set_thread_name)          \
+    __ENUMERATE_SYSCALL(get_thread_name)          \
+    __ENUMERATE_SYSCALL(madvise)                  \
+    __ENUMERATE_SYSCALL(purge)                    \
+    __ENUMERATE_SYSCALL(shbuf_set_volatile)       \
+    __ENUMERATE_SYSCALL(profiling_enable)         \
+    __ENUMERATE_SYSCALL(profiling_disable)        \
+    __ENUMERATE_SYSCALL(futex)                    \
+    __ENUMERATE_SYSCALL(set_thread_boost)         \
+    __ENUMERATE_SYSCALL(set_process_boost)        \
+    __ENUMERATE_SYSCALL(chroot)                   \
+    __ENUMERATE_SYSCALL(pledge)                   \
+    __ENUMERATE_SYSCALL(unveil)                   \
+    __ENUMERATE_SYSCALL(perf_event)               \
+    __ENUMERATE_SYSCALL(shutdown)                 \
+    __ENUMERATE_SYSCALL(get_stack_bounds)         \
+    __ENUMERATE_SYSCALL(ptrace)                   \
+    __ENUMERATE_SYSCALL(minherit)                 \
+    __ENUMERATE_SYSCALL(sched_setscheduler)       \
+    __ENUMERATE_SYSCALL(sched_getscheduler)       \
+    __ENUMERATE_SYSCALL(sched_setaffinity)        \
+    __ENUMERATE_SYSCALL(sched_getaffinity)        \
+    __ENUMERATE_SYSCALL(map_time_page)            \
+    __ENUMERATE_SYSCALL(sendfile)                 \
+    __ENUMERATE_UNLOCKED_SYSCALL(readv)           \
+    __ENUMERATE_UNLOCKED_SYSCALL(preadv)          \
+    __ENUMERATE_UNLOCKED_SYSCALL(pwritev)         \
+    __ENUMERATE_SYSCALL(epoll_create)             \
+    __ENUMERATE_SYSCALL(epoll_ctl)                \
+    __ENUMERATE_SYSCALL(epoll_wait)               \
+    __ENUMERATE_SYSCALL(sendfds)                  \
+    __ENUMERATE_SYSCALL(recvfds)                  \
+    __ENUMERATE_SYSCALL(shbuf_hand_over)          \
+    __ENUMERATE_SYSCALL(perf_counters)
 
 namespace Syscall {
 
@@ -191,8 +209,10 @@ enum Function {
 #undef __ENUMERATE_REMOVED_SYSCALL
 #define __ENUMERATE_REMOVED_SYSCALL(x) SC_##x,
 #define __ENUMERATE_SYSCALL(x) SC_##x,
+#define __ENUMERATE_UNLOCKED_SYSCALL(x) SC_##x,
     ENUMERATE_SYSCALLS
 #undef __ENUMERATE_SYSCALL
+#undef __ENUMERATE_UNLOCKED_SYSCALL
 #undef __ENUMERATE_REMOVED_SYSCALL
         __Count
 };
@@ -208,8 +228,10 @@ inline constexpr const char* to_string(Function function)
 #define __ENUMERATE_SYSCALL(x) \
     case SC_##x:               \
         return #x;
+#define __ENUMERATE_UNLOCKED_SYSCALL(x) __ENUMERATE_SYSCALL(x)
         ENUMERATE_SYSCALLS
 #undef __ENUMERATE_SYSCALL
+#undef __ENUMERATE_UNLOCKED_SYSCALL
 #undef __ENUMERATE_REMOVED_SYSCALL
     default:
         break;
@@ -321,7 +343,9 @@ struct SC_futex_params {
     i32* userspace_address;
     int futex_op;
     i32 val;
-    const timespec* timeout;
+    const timespec* timeout; // Or val2 for the requeue and wake-op operations.
+    i32* userspace_address2;
+    i32 val3;
 };
 
 struct SC_setkeymap_params {
@@ -419,6 +443,7 @@ struct SC_waitid_params {
 };
 
 struct SC_stat_params {
+    int dirfd;
     StringArgument path;
     struct stat* statbuf;
     bool follow_symlinks;
@@ -436,8 +461,49 @@ struct SC_ptrace_peek_params {
     u32* out_data;
 };
 
+struct SC_preadv_params {
+    int fd;
+    const struct iovec* iov;
+    int iov_count;
+    i32 offset; // FIXME: 64-bit off_t?
+};
+
+struct SC_pwritev_params {
+    int fd;
+    const struct iovec* iov;
+    int iov_count;
+    i32 offset; // FIXME: 64-bit off_t?
+};
+
+struct SC_epoll_ctl_params {
+    int epfd;
+    int op;
+    int fd;
+    const struct epoll_event* event;
+};
+
+struct SC_epoll_wait_params {
+    int epfd;
+    struct epoll_event* events;
+    int max_events;
+    int timeout;
+};
+
+struct SC_sendfile_params {
+    int out_fd;
+    int in_fd;
+    i32* offset; // FIXME: 64-bit off_t?
+    size_t count;
+};
+
+struct SC_perf_counters_sample_params {
+    int event;
+    u32 period;
+};
+
 void initialize();
 int sync();
+bool needs_big_lock(u32 function);
 
 inline u32 invoke(Function function)
 {
@@ -487,9 +553,11 @@ inline u32 invoke(Function function, T1 arg1, T2 arg2, T3 arg3)
 
 #undef __ENUMERATE_SYSCALL
 #define __ENUMERATE_SYSCALL(x) using Syscall::SC_##x;
+#define __ENUMERATE_UNLOCKED_SYSCALL(x) __ENUMERATE_SYSCALL(x)
 #define __ENUMERATE_REMOVED_SYSCALL(x)
 ENUMERATE_SYSCALLS
 #undef __ENUMERATE_SYSCALL
+#undef __ENUMERATE_UNLOCKED_SYSCALL
 #undef __ENUMERATE_REMOVED_SYSCALL
 #define syscall Syscall::invoke
 
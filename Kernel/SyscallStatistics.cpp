@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2018-2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <Kernel/KResult.h>
+#include <Kernel/SyscallStatistics.h>
+
+namespace Kernel {
+
+void SyscallStatistics::record(u32 function, int result, u64 duration_ns)
+{
+    if (function >= Syscall::Function::__Count)
+        return;
+    auto& entry = m_entries[function];
+    ++entry.count;
+    entry.total_ns += duration_ns;
+    entry.max_ns = max(entry.max_ns, duration_ns);
+
+    size_t bucket = 0;
+    for (u64 duration_us = duration_ns / 1000; duration_us && bucket < histogram_bucket_count - 1; duration_us >>= 1)
+        ++bucket;
+    ++entry.latency_histogram[bucket];
+
+    // Some syscalls return addresses, which may look negative, so only take actual error numbers as failures.
+    if (result < 0 && -result < EMAXERRNO) {
+        auto it = entry.error_counts.find(-result);
+        if (it == entry.error_counts.end())
+            entry.error_counts.set(-result, 1);
+        else
+            ++it->value;
+    }
+}
+
+}
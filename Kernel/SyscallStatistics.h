@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2018-2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/HashMap.h>
+#include <AK/Types.h>
+#include <Kernel/Syscall.h>
+
+namespace Kernel {
+
+// Per-process syscall accounting, switched on by writing 1 to /proc/PID/syscalls.
+// It's cheap enough to leave running on a busy process, unlike tracing every syscall.
+class SyscallStatistics {
+public:
+    // Bucket N counts syscalls that took less than 2^N microseconds, except for the last one.
+    static constexpr size_t histogram_bucket_count = 16;
+
+    struct Entry {
+        u32 count { 0 };
+        u64 total_ns { 0 };
+        u64 max_ns { 0 };
+        u32 latency_histogram[histogram_bucket_count] {};
+        HashMap<int, u32> error_counts;
+    };
+
+    void record(u32 function, int result, u64 duration_ns);
+
+    template<typename Callback>
+    void for_each_entry(Callback callback) const
+    {
+        for (size_t function = 0; function < Syscall::Function::__Count; ++function) {
+            if (m_entries[function].count)
+                callback((Syscall::Function)function, m_entries[function]);
+        }
+    }
+
+private:
+    Entry m_entries[Syscall::Function::__Count];
+};
+
+}
@@ -162,6 +162,7 @@ void TTY::emit(u8 ch)
             //We use '\0' to delimit the end
             //of a line.
             m_input_buffer.enqueue('\0');
+            evaluate_block_conditions();
             return;
         }
         if (is_kill(ch)) {
@@ -182,6 +183,7 @@ void TTY::emit(u8 ch)
     }
     m_input_buffer.enqueue(ch);
     echo(ch);
+    evaluate_block_conditions();
 }
 
 bool TTY::can_do_backspace() const
@@ -264,6 +266,8 @@ void TTY::flush_input()
 void TTY::set_termios(const termios& t)
 {
     m_termios = t;
+    // Switching in or out of canonical mode changes what counts as readable.
+    evaluate_block_conditions();
 #ifdef TTY_DEBUG
     dbg() << tty_name() << " set_termios: "
           << "ECHO=" << should_echo_input()
@@ -282,7 +286,7 @@ void TTY::set_termios(const termios& t)
 int TTY::ioctl(FileDescription&, unsigned request, FlatPtr arg)
 {
     REQUIRE_PROMISE(tty);
-    auto& process = *Process::current;
+    auto& process = *Process::current();
     pid_t pgid;
     termios* tp;
     winsize* ws;
@@ -308,7 +312,7 @@ int TTY::ioctl(FileDescription&, unsigned request, FlatPtr arg)
                 return -EPERM;
             if (pgid != process->pgid())
                 return -EPERM;
-            if (Process::current->sid() != process->sid())
+            if (Process::current()->sid() != process->sid())
                 return -EPERM;
         }
         m_pgid = pgid;
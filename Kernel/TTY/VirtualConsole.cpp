@@ -285,7 +285,7 @@ void VirtualConsole::flush_dirty_lines()
             continue;
         for (size_t column = 0; column < line.length(); ++column) {
             u32 codepoint = line.codepoint(column);
-            auto attribute = line.attributes()[column];
+            auto attribute = line.attribute_at(column);
             u16 vga_index = (visual_row * 160) + (column * 2);
             m_current_vga_window[vga_index] = codepoint < 128 ? codepoint : '?';
             m_current_vga_window[vga_index + 1] = attribute_to_vga(attribute);
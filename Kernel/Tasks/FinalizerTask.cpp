@@ -24,24 +24,34 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <Kernel/Heap/kmalloc.h>
 #include <Kernel/Process.h>
 #include <Kernel/Tasks/FinalizerTask.h>
+#include <Kernel/VM/MemoryManager.h>
 
 namespace Kernel {
 
 void FinalizerTask::spawn()
 {
     Process::create_kernel_process(g_finalizer, "FinalizerTask", [] {
-        Thread::current->set_priority(THREAD_PRIORITY_LOW);
+        Thread::current()->set_priority(THREAD_PRIORITY_LOW);
         for (;;) {
+            bool has_work;
             {
                 InterruptDisabler disabler;
-                if (!g_finalizer_has_work)
-                    Thread::current->wait_on(*g_finalizer_wait_queue);
-                ASSERT(g_finalizer_has_work);
+                if (!g_finalizer_has_work && !MM.zeroed_page_pool_needs_refill() && !MM.has_pending_memory_pressure() && !kmalloc_heap_needs_growth())
+                    Thread::current()->wait_on(*g_finalizer_wait_queue);
+                has_work = g_finalizer_has_work;
                 g_finalizer_has_work = false;
             }
-            Thread::finalize_dying_threads();
+            if (has_work)
+                Thread::finalize_dying_threads();
+            if (kmalloc_heap_needs_growth())
+                kmalloc_grow_heap();
+            if (MM.has_pending_memory_pressure())
+                MM.relieve_memory_pressure();
+            if (MM.zeroed_page_pool_needs_refill())
+                MM.refill_zeroed_page_pool();
         }
     });
 }
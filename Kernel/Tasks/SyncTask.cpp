@@ -28,18 +28,36 @@
 #include <Kernel/Process.h>
 #include <Kernel/Tasks/SyncTask.h>
 #include <Kernel/Time/TimeManagement.h>
+#include <Kernel/WaitQueue.h>
 
 namespace Kernel {
 
+static WaitQueue* s_write_back_queue;
+
 void SyncTask::spawn()
 {
+    s_write_back_queue = new WaitQueue;
     Thread* syncd_thread = nullptr;
     Process::create_kernel_process(syncd_thread, "SyncTask", [] {
+        u64 last_sync_time = 0;
         for (;;) {
-            VFS::the().sync();
-            Thread::current->sleep(1 * TimeManagement::the().ticks_per_second());
+            u64 now = TimeManagement::the().monotonic_time_ns();
+            if (now - last_sync_time >= 1'000'000'000) {
+                VFS::the().sync();
+                last_sync_time = now;
+            } else {
+                FS::write_back_dirty_blocks();
+            }
+            timeval timeout { 1, 0 };
+            Thread::current()->wait_on(*s_write_back_queue, &timeout);
         }
     });
 }
 
+void SyncTask::request_write_back()
+{
+    if (s_write_back_queue)
+        s_write_back_queue->wake_one();
+}
+
 }
@@ -30,5 +30,7 @@ namespace Kernel {
 class SyncTask {
 public:
     static void spawn();
+    // Wakes the task up ahead of its next periodic sync to write back dirty blocks.
+    static void request_write_back();
 };
 }
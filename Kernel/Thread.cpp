@@ -29,11 +29,13 @@
 #include <Kernel/Arch/i386/CPU.h>
 #include <Kernel/FileSystem/FileDescription.h>
 #include <Kernel/KSyms.h>
+#include <Kernel/PerformanceEventBuffer.h>
 #include <Kernel/Process.h>
 #include <Kernel/Profiling.h>
 #include <Kernel/Scheduler.h>
 #include <Kernel/Thread.h>
 #include <Kernel/ThreadTracer.h>
+#include <Kernel/Time/TimeManagement.h>
 #include <Kernel/TimerQueue.h>
 #include <Kernel/VM/MemoryManager.h>
 #include <Kernel/VM/PageDirectory.h>
@@ -46,25 +48,15 @@
 
 namespace Kernel {
 
-Thread* Thread::current;
+
+DEFINE_OBJECT_CACHE(Thread);
 
 static FPUState s_clean_fpu_state;
 
 u16 thread_specific_selector()
 {
-    static u16 selector;
-    if (!selector) {
-        selector = gdt_alloc_entry();
-        auto& descriptor = get_gdt_entry(selector);
-        descriptor.dpl = 3;
-        descriptor.segment_present = 1;
-        descriptor.granularity = 0;
-        descriptor.zero = 0;
-        descriptor.operation_size = 1;
-        descriptor.descriptor_type = 1;
-        descriptor.type = 2;
-    }
-    return selector;
+    // NOTE: Every CPU has this descriptor in its GDT, pointing at the data of whichever thread it's running.
+    return GDT_SELECTOR_TLS;
 }
 
 Descriptor& thread_specific_descriptor()
@@ -119,7 +111,7 @@ Thread::Thread(Process& process)
 
     m_tss.ds = ds;
     m_tss.es = ds;
-    m_tss.fs = ds;
+    m_tss.fs = m_process.is_ring0() ? GDT_SELECTOR_PROC : ds;
     m_tss.gs = gs;
     m_tss.ss = ss;
     m_tss.cs = cs;
@@ -133,6 +125,8 @@ Thread::Thread(Process& process)
 
     if (m_process.is_ring0()) {
         m_tss.esp = m_kernel_stack_top;
+        // Kernel threads start out running kernel code, and so with the kernel lock held.
+        m_saved_kernel_lock_depth = 1;
     } else {
         // Ring 3 processes get a separate stack for ring 0.
         // The ring 3 stack will be assigned by exec().
@@ -164,8 +158,9 @@ Thread::~Thread()
 
 void Thread::unblock()
 {
-    m_blocker = nullptr;
-    if (current == this) {
+    InterruptDisabler disabler;
+    detach_blocker();
+    if (current() == this) {
         if (m_should_die)
             set_state(Thread::Dying);
         else
@@ -179,6 +174,16 @@ void Thread::unblock()
         set_state(Thread::Runnable);
 }
 
+void Thread::detach_blocker()
+{
+    if (!m_blocker)
+        return;
+    // Make sure nothing is going to try waking us up through this blocker anymore.
+    m_blocker->end_blocking(*this);
+    m_blocker->cancel_timeout();
+    m_blocker = nullptr;
+}
+
 void Thread::set_should_die()
 {
     if (m_should_die) {
@@ -210,7 +215,7 @@ void Thread::set_should_die()
 
 void Thread::die_if_needed()
 {
-    ASSERT(current == this);
+    ASSERT(current() == this);
 
     if (!m_should_die)
         return;
@@ -242,24 +247,18 @@ void Thread::relock_process()
     process().big_lock().lock();
 }
 
-u64 Thread::sleep(u32 ticks)
+u64 Thread::sleep(u64 nanoseconds)
 {
-    ASSERT(state() == Thread::Running);
-    u64 wakeup_time = g_uptime + ticks;
-    auto ret = Thread::current->block<Thread::SleepBlocker>(wakeup_time);
-    if (wakeup_time > g_uptime) {
-        ASSERT(ret != Thread::BlockResult::WokeNormally);
-    }
-    return wakeup_time;
+    return sleep_until(TimeManagement::the().monotonic_time_ns() + nanoseconds);
 }
 
-u64 Thread::sleep_until(u64 wakeup_time)
+u64 Thread::sleep_until(u64 deadline)
 {
     ASSERT(state() == Thread::Running);
-    auto ret = Thread::current->block<Thread::SleepBlocker>(wakeup_time);
-    if (wakeup_time > g_uptime)
+    auto ret = Thread::current()->block<Thread::SleepBlocker>(deadline);
+    if (deadline > TimeManagement::the().monotonic_time_ns())
         ASSERT(ret != Thread::BlockResult::WokeNormally);
-    return wakeup_time;
+    return deadline;
 }
 
 const char* Thread::state_string() const
@@ -294,20 +293,24 @@ const char* Thread::state_string() const
 
 void Thread::finalize()
 {
-    ASSERT(current == g_finalizer);
+    ASSERT(current() == g_finalizer);
 
 #ifdef THREAD_DEBUG
     dbg() << "Finalizing thread " << *this;
 #endif
     set_state(Thread::State::Dead);
 
-    if (m_joiner) {
-        ASSERT(m_joiner->m_joinee == this);
-        static_cast<JoinBlocker*>(m_joiner->m_blocker)->set_joinee_exit_value(m_exit_value);
-        static_cast<JoinBlocker*>(m_joiner->m_blocker)->set_interrupted_by_death();
-        m_joiner->m_joinee = nullptr;
+    // We may have been killed while stopped in the middle of blocking.
+    detach_blocker();
+
+    if (auto* joiner = m_joiner) {
+        ASSERT(joiner->m_joinee == this);
+        static_cast<JoinBlocker*>(joiner->m_blocker)->set_joinee_exit_value(m_exit_value);
+        static_cast<JoinBlocker*>(joiner->m_blocker)->set_interrupted_by_death();
+        joiner->m_joinee = nullptr;
         // NOTE: We clear the joiner pointer here as well, to be tidy.
         m_joiner = nullptr;
+        joiner->consider_unblock();
     }
 
     if (m_dump_backtrace_on_finalization)
@@ -316,11 +319,14 @@ void Thread::finalize()
 
 void Thread::finalize_dying_threads()
 {
-    ASSERT(current == g_finalizer);
+    ASSERT(current() == g_finalizer);
     Vector<Thread*, 32> dying_threads;
     {
         InterruptDisabler disabler;
         for_each_in_state(Thread::State::Dying, [&](Thread& thread) {
+            // Leave threads alone while some CPU is still on their stack.
+            if (thread.is_being_switched_out())
+                return IterationDecision::Continue;
             dying_threads.append(&thread);
             return IterationDecision::Continue;
         });
@@ -365,6 +371,9 @@ void Thread::send_signal(u8 signal, [[maybe_unused]] Process* sender)
 #endif
 
     m_pending_signals |= 1 << (signal - 1);
+
+    // Signals are dispatched by the next scheduling pass, which an idle CPU might put off for quite a while.
+    Scheduler::stop_idling();
 }
 
 // Certain exceptions, such as SIGSEGV and SIGILL, put a
@@ -509,6 +518,9 @@ ShouldUnblockThread Thread::dispatch_signal(u8 signal)
         if (m_state != Thread::Runnable && m_state != Thread::Running
             && m_blocker && m_blocker->is_reason_signal())
             unblock();
+        // Whatever we were blocked on may have happened while we were stopped.
+        else if (m_state == Thread::Blocked)
+            consider_unblock();
     }
 
     else {
@@ -713,6 +725,11 @@ Thread* Thread::clone(Process& process)
     clone->m_signal_mask = m_signal_mask;
     memcpy(clone->m_fpu_state, m_fpu_state, sizeof(FPUState));
     clone->m_thread_specific_data = m_thread_specific_data;
+    clone->m_affinity_mask = m_affinity_mask;
+    if (is_realtime()) {
+        clone->m_scheduling_policy = m_scheduling_policy;
+        clone->m_priority = m_priority;
+    }
     return clone;
 }
 
@@ -740,6 +757,52 @@ bool Thread::is_thread(void* ptr)
     return thread_table().contains((Thread*)ptr);
 }
 
+void Thread::account_state_time(StateTimes& times, u64 now_ns) const
+{
+    if (now_ns < m_state_entered_ns)
+        return;
+    u64 elapsed = now_ns - m_state_entered_ns;
+    switch (m_state) {
+    case Running:
+        times.running_ns += elapsed;
+        break;
+    case Runnable:
+    case Skip1SchedulerPass:
+    case Skip0SchedulerPasses:
+        times.runnable_ns += elapsed;
+        break;
+    case Blocked:
+    case Queued: {
+        times.blocked_ns += elapsed;
+        auto* slot = &times.blocked[StateTimes::max_blocked_reasons - 1];
+        for (auto& blocked : times.blocked) {
+            if (!blocked.reason) {
+                blocked.reason = &blocked == slot ? "Other" : m_blocked_reason;
+                slot = &blocked;
+                break;
+            }
+            if (blocked.reason == m_blocked_reason || !strcmp(blocked.reason, m_blocked_reason)) {
+                slot = &blocked;
+                break;
+            }
+        }
+        slot->ns += elapsed;
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+Thread::StateTimes Thread::state_times() const
+{
+    InterruptDisabler disabler;
+    StateTimes times = m_state_times;
+    if (TimeManagement::initialized())
+        account_state_time(times, TimeManagement::the().monotonic_time_ns());
+    return times;
+}
+
 void Thread::set_state(State new_state)
 {
     InterruptDisabler disabler;
@@ -755,11 +818,31 @@ void Thread::set_state(State new_state)
         m_stop_state = m_state;
     }
 
+    if (TimeManagement::initialized()) {
+        u64 now = TimeManagement::the().monotonic_time_ns();
+        account_state_time(m_state_times, now);
+        m_state_entered_ns = now;
+    }
+
+    // Mark where the time spent blocked ends and the wait for a CPU begins.
+    if ((m_state == Blocked || m_state == Queued) && new_state == Runnable) {
+        if (auto* kernel_event_buffer = m_process.kernel_event_buffer())
+            kernel_event_buffer->append_context_switch(PERF_EVENT_WAKEUP, *this, m_blocked_reason);
+    }
+
+    if (new_state == Blocked)
+        m_blocked_reason = m_blocker->state_string();
+    else if (new_state == Queued)
+        m_blocked_reason = m_wait_reason ? m_wait_reason : "Queued";
+
     m_state = new_state;
     if (m_process.pid() != 0) {
         Scheduler::update_state_for_thread(*this);
     }
 
+    if (new_state == Stopped)
+        m_process.unblock_waiters();
+
     if (new_state == Dying) {
         g_finalizer_has_work = true;
         g_finalizer_wait_queue->wake_all();
@@ -807,7 +890,7 @@ String Thread::backtrace_impl() const
     Vector<RecognizedSymbol, 128> recognized_symbols;
 
     u32 start_frame;
-    if (current == this) {
+    if (current() == this) {
         asm volatile("movl %%ebp, %%eax"
                      : "=a"(start_frame));
     } else {
@@ -885,12 +968,20 @@ Thread::BlockResult Thread::wait_on(WaitQueue& queue, timeval* timeout, Atomic<b
     bool did_unlock = unlock_process_if_locked();
     if (lock)
         *lock = false;
+    m_wait_reason = reason;
     set_state(State::Queued);
-    queue.enqueue(*current);
+    queue.enqueue(*current());
 
     TimerId timer_id {};
+    bool timed_out = false;
     if (timeout) {
         timer_id = TimerQueue::the().add_timer(*timeout, [&]() {
+            // We may have been moved to another queue (futex requeue) since we started
+            // waiting, so unlink ourselves from whichever one we're on now.
+            if (!m_wait_queue_node.is_in_list())
+                return;
+            m_wait_queue_node.remove();
+            timed_out = true;
             wake_from_queue();
         });
     }
@@ -904,11 +995,18 @@ Thread::BlockResult Thread::wait_on(WaitQueue& queue, timeval* timeout, Atomic<b
     if (did_unlock)
         relock_process();
 
-    BlockResult result = m_wait_queue_node.is_in_list() ? BlockResult::InterruptedByTimeout : BlockResult::WokeNormally;
-
-    // Make sure we cancel the timer if woke normally.
-    if (timeout && result == BlockResult::WokeNormally)
-        TimerQueue::the().cancel_timer(timer_id);
+    BlockResult result = BlockResult::WokeNormally;
+    {
+        InterruptDisabler disabler;
+        if (timed_out || m_wait_queue_node.is_in_list()) {
+            if (m_wait_queue_node.is_in_list())
+                m_wait_queue_node.remove();
+            result = BlockResult::InterruptedByTimeout;
+        }
+        // Make sure we cancel the timer if woke normally.
+        if (timeout && !timed_out)
+            TimerQueue::the().cancel_timer(timer_id);
+    }
 
     return result;
 }
@@ -34,9 +34,12 @@
 #include <AK/Vector.h>
 #include <Kernel/Arch/i386/CPU.h>
 #include <Kernel/Forward.h>
+#include <Kernel/Heap/ObjectCache.h>
 #include <Kernel/KResult.h>
+#include <Kernel/PerformanceCounters.h>
 #include <Kernel/Scheduler.h>
 #include <Kernel/ThreadTracer.h>
+#include <Kernel/TimerQueue.h>
 #include <Kernel/UnixTypes.h>
 #include <LibC/fd_set.h>
 
@@ -66,12 +69,13 @@ struct ThreadSpecificData {
 class Thread {
     AK_MAKE_NONCOPYABLE(Thread);
     AK_MAKE_NONMOVABLE(Thread);
+    MAKE_OBJECT_CACHED(Thread)
 
     friend class Process;
     friend class Scheduler;
 
 public:
-    static Thread* current;
+    ALWAYS_INLINE static Thread* current() { return Processor::current().current_thread(); }
 
     explicit Thread(Process&);
     ~Thread();
@@ -94,6 +98,16 @@ public:
 
     u32 effective_priority() const;
 
+    // Real-time (SCHED_FIFO and SCHED_RR) threads run before everyone else, strictly in priority order.
+    void set_scheduling_policy(int policy) { m_scheduling_policy = policy; }
+    int scheduling_policy() const { return m_scheduling_policy; }
+    bool is_realtime() const { return m_scheduling_policy == SCHED_FIFO || m_scheduling_policy == SCHED_RR; }
+
+    // One bit per CPU the thread is allowed to run on.
+    void set_affinity_mask(u32 mask) { m_affinity_mask = mask; }
+    u32 affinity_mask() const { return m_affinity_mask; }
+    bool can_run_on(u32 cpu) const { return m_affinity_mask & (1u << cpu); }
+
     void set_joinable(bool j) { m_is_joinable = j; }
     bool is_joinable() const { return m_is_joinable; }
 
@@ -121,18 +135,38 @@ public:
         Queued,
     };
 
+    // A Blocker is only asked whether its thread should_unblock() when something it
+    // registered with in begin_blocking() says the answer may have changed, e.g. a File
+    // through its BlockCondition, or a timer. end_blocking() is called once the thread
+    // has been unblocked, for whatever reason, to undo that registration.
+    // Blockers that can't be told about changes return true from needs_polling(),
+    // and get asked on every pass through the scheduler instead.
     class Blocker {
     public:
         virtual ~Blocker() {}
         virtual bool should_unblock(Thread&, time_t now_s, long us) = 0;
         virtual const char* state_string() const = 0;
         virtual bool is_reason_signal() const { return false; }
+        virtual void begin_blocking(Thread&) {}
+        virtual void end_blocking(Thread&) {}
+        virtual bool needs_polling() const { return false; }
         void set_interrupted_by_death() { m_was_interrupted_by_death = true; }
         bool was_interrupted_by_death() const { return m_was_interrupted_by_death; }
         void set_interrupted_by_signal() { m_was_interrupted_while_blocked = true; }
         bool was_interrupted_by_signal() const { return m_was_interrupted_while_blocked; }
 
+    protected:
+        // Wake the thread up after the given amount of time (or at the given monotonic time in nanoseconds),
+        // with has_timed_out() returning true from then on.
+        void set_timeout(Thread&, const timeval& timeout);
+        void set_timeout_at(Thread&, u64 expires);
+        bool has_timed_out() const { return m_timed_out; }
+
     private:
+        void cancel_timeout();
+
+        TimerId m_timeout_timer_id { 0 };
+        bool m_timed_out { false };
         bool m_was_interrupted_while_blocked { false };
         bool m_was_interrupted_by_death { false };
         friend class Thread;
@@ -153,6 +187,9 @@ public:
     class FileDescriptionBlocker : public Blocker {
     public:
         const FileDescription& blocked_description() const;
+        virtual void begin_blocking(Thread&) override;
+        virtual void end_blocking(Thread&) override;
+        virtual bool needs_polling() const override;
 
     protected:
         explicit FileDescriptionBlocker(const FileDescription&);
@@ -180,9 +217,7 @@ public:
         explicit WriteBlocker(const FileDescription&);
         virtual bool should_unblock(Thread&, time_t, long) override;
         virtual const char* state_string() const override { return "Writing"; }
-
-    private:
-        Optional<timeval> m_deadline;
+        virtual void begin_blocking(Thread&) override;
     };
 
     class ReadBlocker final : public FileDescriptionBlocker {
@@ -190,9 +225,7 @@ public:
         explicit ReadBlocker(const FileDescription&);
         virtual bool should_unblock(Thread&, time_t, long) override;
         virtual const char* state_string() const override { return "Reading"; }
-
-    private:
-        Optional<timeval> m_deadline;
+        virtual void begin_blocking(Thread&) override;
     };
 
     class ConditionBlocker final : public Blocker {
@@ -200,6 +233,7 @@ public:
         ConditionBlocker(const char* state_string, Function<bool()>&& condition);
         virtual bool should_unblock(Thread&, time_t, long) override;
         virtual const char* state_string() const override { return m_state_string; }
+        virtual bool needs_polling() const override { return true; }
 
     private:
         Function<bool()> m_block_until_condition;
@@ -208,12 +242,13 @@ public:
 
     class SleepBlocker final : public Blocker {
     public:
-        explicit SleepBlocker(u64 wakeup_time);
+        explicit SleepBlocker(u64 deadline);
         virtual bool should_unblock(Thread&, time_t, long) override;
         virtual const char* state_string() const override { return "Sleeping"; }
+        virtual void begin_blocking(Thread&) override;
 
     private:
-        u64 m_wakeup_time { 0 };
+        u64 m_deadline { 0 };
     };
 
     class SelectBlocker final : public Blocker {
@@ -222,13 +257,20 @@ public:
         SelectBlocker(const timeval& tv, bool select_has_timeout, const FDVector& read_fds, const FDVector& write_fds, const FDVector& except_fds);
         virtual bool should_unblock(Thread&, time_t, long) override;
         virtual const char* state_string() const override { return "Selecting"; }
+        virtual void begin_blocking(Thread&) override;
+        virtual void end_blocking(Thread&) override;
+        virtual bool needs_polling() const override { return m_needs_polling; }
 
     private:
+        void register_with_files_for(Thread&, const FDVector&);
+
         timeval m_select_timeout;
         bool m_select_has_timeout { false };
+        bool m_needs_polling { false };
         const FDVector& m_select_read_fds;
         const FDVector& m_select_write_fds;
         const FDVector& m_select_exceptional_fds;
+        Vector<NonnullRefPtr<File>> m_registered_files;
     };
 
     class WaitBlocker final : public Blocker {
@@ -236,6 +278,8 @@ public:
         WaitBlocker(int wait_options, pid_t& waitee_pid);
         virtual bool should_unblock(Thread&, time_t, long) override;
         virtual const char* state_string() const override { return "Waiting"; }
+        virtual void begin_blocking(Thread&) override;
+        virtual void end_blocking(Thread&) override;
 
     private:
         int m_wait_options { 0 };
@@ -286,10 +330,29 @@ public:
     const char* state_string() const;
     u32 ticks() const { return m_ticks; }
 
+    // Where the thread's time went since it was created, see /proc/all.
+    struct StateTimes {
+        static constexpr size_t max_blocked_reasons = 8;
+        struct BlockedTime {
+            // What the thread was blocked on, always a string literal.
+            const char* reason;
+            u64 ns;
+        };
+        u64 running_ns;
+        // Ready to run, but waiting for a CPU.
+        u64 runnable_ns;
+        u64 blocked_ns;
+        // Broken down by what blocked it, with anything beyond the first few reasons under "Other".
+        BlockedTime blocked[max_blocked_reasons];
+    };
+    // Includes the time spent in the current state so far.
+    StateTimes state_times() const;
+
     VirtualAddress thread_specific_data() const { return m_thread_specific_data; }
 
-    u64 sleep(u32 ticks);
-    u64 sleep_until(u64 wakeup_time);
+    // Both return the deadline on the monotonic clock, which hasn't been reached yet if the sleep was interrupted.
+    u64 sleep(u64 nanoseconds);
+    u64 sleep_until(u64 deadline);
 
     enum class BlockResult {
         WokeNormally,
@@ -306,17 +369,24 @@ public:
         ASSERT(m_blocker == nullptr);
 
         T t(forward<Args>(args)...);
-        m_blocker = &t;
-        set_state(Thread::Blocked);
+
+        {
+            InterruptDisabler disabler;
+            m_blocker = &t;
+            t.begin_blocking(*this);
+            set_state(Thread::Blocked);
+
+            // Whatever we're waiting for may have happened before we got hooked up to it.
+            consider_unblock();
+        }
 
         // Yield to the scheduler, and wait for us to resume unblocked.
-        yield_without_holding_big_lock();
+        if (state() != Thread::Running)
+            yield_without_holding_big_lock();
 
         // We should no longer be blocked once we woke up
         ASSERT(state() != Thread::Blocked);
-
-        // Remove ourselves...
-        m_blocker = nullptr;
+        ASSERT(m_blocker == nullptr);
 
         if (t.was_interrupted_by_signal())
             return BlockResult::InterruptedBySignal;
@@ -354,9 +424,19 @@ public:
     void set_selector(u16 s) { m_far_ptr.selector = s; }
     void set_state(State);
 
+    // Kernel lock depth this thread held when it was last switched out.
+    u32 saved_kernel_lock_depth() const { return m_saved_kernel_lock_depth; }
+    void set_saved_kernel_lock_depth(u32 depth) { m_saved_kernel_lock_depth = depth; }
+
+    // Set while a CPU is still executing on this thread's stack after having
+    // picked another thread. Other CPUs must not schedule the thread until then.
+    bool is_being_switched_out() const { return m_is_being_switched_out; }
+    void set_being_switched_out(bool b) { m_is_being_switched_out = b; }
+
     void send_urgent_signal_to_self(u8 signal);
     void send_signal(u8 signal, Process* sender);
     void consider_unblock(time_t now_sec, long now_usec);
+    void consider_unblock();
 
     void set_dump_backtrace_on_finalization() { m_dump_backtrace_on_finalization = true; }
 
@@ -370,6 +450,9 @@ public:
 
     FPUState& fpu_state() { return *m_fpu_state; }
 
+    PerformanceCounters::ThreadState& perf_counters() { return m_perf_counters; }
+    const PerformanceCounters::ThreadState& perf_counters() const { return m_perf_counters; }
+
     void set_default_signal_dispositions();
     void push_value_on_stack(FlatPtr);
 
@@ -449,15 +532,21 @@ public:
 
 private:
     IntrusiveListNode m_runnable_list_node;
+    IntrusiveListNode m_ready_queue_node;
+    IntrusiveListNode m_polled_list_node;
     IntrusiveListNode m_wait_queue_node;
+    // Futex waiters only want the wake-ups whose bitset overlaps this one.
+    u32 m_wait_queue_bitset { 0xffffffff };
 
 private:
     friend class SchedulerData;
     friend class WaitQueue;
     bool unlock_process_if_locked();
     void relock_process();
+    void detach_blocker();
     String backtrace_impl() const;
     void reset_fpu_state();
+    void account_state_time(StateTimes&, u64 now_ns) const;
 
     Process& m_process;
     int m_tid { -1 };
@@ -465,6 +554,10 @@ private:
     FarPtr m_far_ptr;
     u32 m_ticks { 0 };
     u32 m_ticks_left { 0 };
+    StateTimes m_state_times {};
+    u64 m_state_entered_ns { 0 };
+    const char* m_blocked_reason { nullptr };
+    const char* m_wait_reason { nullptr };
     u32 m_times_scheduled { 0 };
     u32 m_pending_signals { 0 };
     u32 m_signal_mask { 0 };
@@ -495,15 +588,26 @@ private:
     unsigned m_ipv4_socket_write_bytes { 0 };
 
     FPUState* m_fpu_state { nullptr };
+    PerformanceCounters::ThreadState m_perf_counters;
     State m_state { Invalid };
     String m_name;
     u32 m_priority { THREAD_PRIORITY_NORMAL };
-    u32 m_extra_priority { 0 };
     u32 m_priority_boost { 0 };
+    int m_scheduling_policy { SCHED_OTHER };
+    u32 m_affinity_mask { 0xffffffff };
+
+    // Where the thread sits among the ready queues (see SchedulerData), and when it got there.
+    u32 m_ready_queue_processor { 0 };
+    u32 m_ready_queue_index { 0 };
+    u32 m_ready_queue_stamp { 0 };
+    u32 m_last_processor { 0 };
 
     u8 m_stop_signal { 0 };
     State m_stop_state { Invalid };
 
+    u32 m_saved_kernel_lock_depth { 0 };
+    bool m_is_being_switched_out { false };
+
     bool m_dump_backtrace_on_finalization { false };
     bool m_should_die { false };
 
@@ -553,16 +657,54 @@ const LogStream& operator<<(const LogStream&, const Thread&);
 
 struct SchedulerData {
     typedef IntrusiveList<Thread, &Thread::m_runnable_list_node> ThreadList;
+    typedef IntrusiveList<Thread, &Thread::m_ready_queue_node> ReadyQueue;
+    typedef IntrusiveList<Thread, &Thread::m_polled_list_node> PolledThreadList;
+
+    static constexpr u32 ready_queue_count = 32;
+    static constexpr u32 realtime_queue_count = THREAD_PRIORITY_MAX + 1;
+    static constexpr u32 realtime_mask_words = (realtime_queue_count + 31) / 32;
+
+    // Each processor has its own set of queues with the threads that are waiting
+    // to run there, one queue per priority band. Running threads are not queued.
+    struct ReadyQueues {
+        ReadyQueue queues[ready_queue_count];
+        // Bit N is set if queues[N] is non-empty.
+        u32 mask { 0 };
+        u32 size { 0 };
+
+        // Real-time threads get a queue for every priority.
+        ReadyQueue realtime_queues[realtime_queue_count];
+        u32 realtime_mask[realtime_mask_words] {};
+
+        // Real-time threads only get to use most of every second, so a runaway one can't lock up the CPU.
+        u32 ticks_this_period { 0 };
+        u32 realtime_ticks_this_period { 0 };
+    };
 
     ThreadList m_runnable_threads;
     ThreadList m_nonrunnable_threads;
 
+    // Threads nothing is going to wake up, so the scheduler has to check on them itself.
+    PolledThreadList m_polled_threads;
+
+    ReadyQueues m_ready_queues[MAX_PROCESSOR_COUNT];
+    // Bumped on every pass through the scheduler, used to age threads waiting in the ready queues.
+    u32 m_pick_count { 0 };
+    // Seconds since boot, as far as the scheduling groups' CPU usage decay is concerned.
+    u32 m_fair_share_epoch { 0 };
+
     ThreadList& thread_list_for_state(Thread::State state)
     {
         if (Thread::is_runnable_state(state))
             return m_runnable_threads;
         return m_nonrunnable_threads;
     }
+
+    void enqueue_ready_thread(Thread&);
+    void dequeue_ready_thread(Thread&);
+    Thread* best_ready_thread(u32 processor, u32& score);
+    Thread* best_realtime_thread(u32 processor);
+    bool is_realtime_throttled(u32 processor) const;
 };
 
 template<typename Callback>
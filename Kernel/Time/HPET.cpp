@@ -191,6 +191,17 @@ void HPET::set_non_periodic_comparator_value(const HPETComparator& comparator, u
     auto* registers_block = (HPETRegistersBlock*)m_hpet_mmio_region->vaddr().offset(m_physical_acpi_hpet_registers.offset_in_page()).as_ptr();
     registers_block->timers[comparator.comparator_number()].comparator_value = main_counter_value() + value;
 }
+
+bool HPET::set_one_shot_comparator_value(const HPETComparator& comparator, u64 deadline)
+{
+    ASSERT_INTERRUPTS_DISABLED();
+    ASSERT(!comparator.is_periodic());
+    ASSERT(comparator.comparator_number() <= m_comparators.size());
+    auto* registers_block = (HPETRegistersBlock*)m_hpet_mmio_region->vaddr().offset(m_physical_acpi_hpet_registers.offset_in_page()).as_ptr();
+    registers_block->timers[comparator.comparator_number()].comparator_value = deadline;
+    // The comparator only matches when the counter reaches it, so a deadline that already passed would never fire.
+    return main_counter_value() < deadline;
+}
 void HPET::enable_periodic_interrupt(const HPETComparator& comparator)
 {
 #ifdef HPET_DEBUG
@@ -238,13 +249,33 @@ void HPET::enable(const HPETComparator& comparator)
 u64 HPET::main_counter_value() const
 {
     auto* registers_block = (const HPETRegistersBlock*)m_hpet_mmio_region->vaddr().offset(m_physical_acpi_hpet_registers.offset_in_page()).as_ptr();
-    return registers_block->main_counter_value.reg;
+    auto* counter = (const volatile u32*)&registers_block->main_counter_value.reg;
+    if (!counter_is_64_bit_capable)
+        return counter[0];
+    // We can only read the counter 32 bits at a time, so make sure the upper half didn't change in between.
+    u32 high;
+    u32 low;
+    do {
+        high = counter[1];
+        low = counter[0];
+    } while (high != counter[1]);
+    return ((u64)high << 32) | low;
 }
 u64 HPET::frequency() const
 {
     return m_frequency;
 }
 
+u64 HPET::ticks_to_nanoseconds(u64 ticks) const
+{
+    return (ticks / m_frequency) * 1'000'000'000 + (ticks % m_frequency) * 1'000'000'000 / m_frequency;
+}
+
+u64 HPET::nanoseconds_to_ticks(u64 nanoseconds) const
+{
+    return (nanoseconds / 1'000'000'000) * m_frequency + (nanoseconds % 1'000'000'000) * m_frequency / 1'000'000'000;
+}
+
 Vector<unsigned> HPET::capable_interrupt_numbers(const HPETComparator& comparator)
 {
     ASSERT(comparator.comparator_number() <= m_comparators.size());
@@ -327,6 +358,8 @@ HPET::HPET(PhysicalAddress acpi_hpet)
     klog() << "HPET: Timers count - " << timers_count;
     ASSERT(timers_count >= 2);
     auto* capabilities_register = (const HPETCapabilityRegister*)&registers_block->raw_capabilites.reg;
+    counter_is_64_bit_capable = capabilities_register->attributes & (u32)HPETFlags::Attributes::Counter64BitCapable;
+    klog() << "HPET: Main counter is " << (counter_is_64_bit_capable ? "64" : "32") << " bits wide";
 
     global_disable();
 
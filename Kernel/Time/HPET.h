@@ -46,6 +46,11 @@ public:
 
     u64 main_counter_value() const;
     u64 frequency() const;
+    bool is_main_counter_64_bit() const { return counter_is_64_bit_capable; }
+    u16 minimum_tick() const { return m_minimum_tick; }
+
+    u64 ticks_to_nanoseconds(u64 ticks) const;
+    u64 nanoseconds_to_ticks(u64 nanoseconds) const;
 
     const NonnullRefPtrVector<HPETComparator>& comparators() const { return m_comparators; }
     void disable(const HPETComparator&);
@@ -53,6 +58,8 @@ public:
 
     void set_periodic_comparator_value(const HPETComparator& comparator, u64 value);
     void set_non_periodic_comparator_value(const HPETComparator& comparator, u64 value);
+    // Returns false if the main counter has already gone past the deadline.
+    bool set_one_shot_comparator_value(const HPETComparator& comparator, u64 deadline);
 
     void set_comparator_irq_vector(u8 comparator_number, u8 irq_vector);
 
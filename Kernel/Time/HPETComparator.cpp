@@ -24,6 +24,7 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <AK/StdLibExtras.h>
 #include <Kernel/Assertions.h>
 #include <Kernel/Time/HPETComparator.h>
 #include <Kernel/Time/TimeManagement.h>
@@ -41,6 +42,7 @@ HPETComparator::HPETComparator(u8 number, u8 irq, bool periodic_capable)
     : HardwareTimer(irq)
     , m_periodic(false)
     , m_periodic_capable(periodic_capable)
+    , m_one_shot(false)
     , m_comparator_number(number)
 {
 }
@@ -58,10 +60,27 @@ void HPETComparator::set_non_periodic()
     m_periodic = false;
 }
 
+void HPETComparator::set_one_shot()
+{
+    ASSERT(!is_periodic());
+    m_one_shot = true;
+}
+
+void HPETComparator::fire_after(u64 nanoseconds)
+{
+    ASSERT_INTERRUPTS_DISABLED();
+    ASSERT(m_one_shot);
+    auto& hpet = HPET::the();
+    u64 delta = max<u64>(hpet.nanoseconds_to_ticks(nanoseconds), max<u64>(hpet.minimum_tick(), 1));
+    // If the counter overtook a very close deadline before we could program it, aim a bit further out.
+    while (!hpet.set_one_shot_comparator_value(*this, hpet.main_counter_value() + delta))
+        delta *= 2;
+}
+
 void HPETComparator::handle_irq(const RegisterState& regs)
 {
     HardwareTimer::handle_irq(regs);
-    if (!is_periodic())
+    if (!is_periodic() && !m_one_shot)
         set_new_countdown();
 }
 
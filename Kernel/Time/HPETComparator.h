@@ -50,6 +50,10 @@ public:
     virtual void set_periodic() override;
     virtual void set_non_periodic() override;
 
+    virtual bool is_one_shot_capable() const override { return true; }
+    virtual void set_one_shot() override;
+    virtual void fire_after(u64 nanoseconds) override;
+
     virtual void reset_to_default_ticks_per_second() override;
     virtual bool try_to_set_frequency(size_t frequency) override;
     virtual bool is_capable_of_frequency(size_t frequency) const override;
@@ -62,6 +66,7 @@ private:
     bool m_periodic : 1;
     bool m_periodic_capable : 1;
     bool m_edge_triggered : 1;
+    bool m_one_shot : 1;
     u8 m_comparator_number { 0 };
 };
 }
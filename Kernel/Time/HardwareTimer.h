@@ -57,6 +57,11 @@ public:
     virtual void set_periodic() = 0;
     virtual void set_non_periodic() = 0;
 
+    // A one-shot timer only fires once for every call to fire_after().
+    virtual bool is_one_shot_capable() const = 0;
+    virtual void set_one_shot() = 0;
+    virtual void fire_after(u64 nanoseconds) = 0;
+
     virtual void reset_to_default_ticks_per_second() = 0;
     virtual bool try_to_set_frequency(size_t frequency) = 0;
     virtual bool is_capable_of_frequency(size_t frequency) const = 0;
@@ -64,6 +64,10 @@ public:
     virtual void set_periodic() override;
     virtual void set_non_periodic() override;
 
+    virtual bool is_one_shot_capable() const override { return false; }
+    virtual void set_one_shot() override { ASSERT_NOT_REACHED(); }
+    virtual void fire_after(u64) override { ASSERT_NOT_REACHED(); }
+
     virtual void reset_to_default_ticks_per_second() override;
     virtual bool try_to_set_frequency(size_t frequency) override;
     virtual bool is_capable_of_frequency(size_t frequency) const override;
@@ -24,6 +24,7 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <AK/StringView.h>
 #include <Kernel/ACPI/Parser.h>
 #include <Kernel/CommandLine.h>
 #include <Kernel/Scheduler.h>
@@ -33,6 +34,8 @@
 #include <Kernel/Time/PIT.h>
 #include <Kernel/Time/RTC.h>
 #include <Kernel/Time/TimeManagement.h>
+#include <Kernel/TimePage.h>
+#include <Kernel/VM/AnonymousVMObject.h>
 #include <Kernel/VM/MemoryManager.h>
 
 //#define TIME_DEBUG
@@ -55,11 +58,17 @@ bool TimeManagement::is_system_timer(const HardwareTimer& timer) const
 void TimeManagement::set_epoch_time(time_t value)
 {
     InterruptDisabler disabler;
-    m_epoch_time = value;
+    // Without a time keeper ticking along, we keep the epoch time at boot and derive the rest from the monotonic clock.
+    if (m_tickless)
+        m_epoch_time = value - seconds_since_boot();
+    else
+        m_epoch_time = value;
 }
 
 time_t TimeManagement::epoch_time() const
 {
+    if (m_tickless)
+        return m_epoch_time + seconds_since_boot();
     return m_epoch_time;
 }
 
@@ -70,9 +79,42 @@ void TimeManagement::initialize()
         s_time_management = new TimeManagement(false);
     else
         s_time_management = new TimeManagement(true);
+    s_time_management->create_time_page();
+}
+
+void TimeManagement::create_time_page()
+{
+    auto page = MM.allocate_user_physical_page(MemoryManager::ShouldZeroFill::Yes);
+    ASSERT(page);
+    m_time_page_vmobject = AnonymousVMObject::create_with_physical_page(*page);
+    m_time_page_region = MM.allocate_kernel_region_with_vmobject(*m_time_page_vmobject, PAGE_SIZE, "Time page", Region::Access::Read | Region::Access::Write);
+    ASSERT(m_time_page_region);
+    update_time_page();
+}
+
+void TimeManagement::update_time_page()
+{
+    if (!m_time_page_region)
+        return;
+    auto& time_page = *(TimePage*)m_time_page_region->vaddr().as_ptr();
+    // There's nothing ticking regularly to keep the page fresh in tickless mode, so tell userspace to ask us instead.
+    if (m_tickless) {
+        __atomic_store_n(&time_page.is_updated, 0, __ATOMIC_RELEASE);
+        return;
+    }
+    u64 now = monotonic_time_ns();
+    __atomic_store_n(&time_page.update_sequence, time_page.update_sequence + 1, __ATOMIC_RELEASE);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    time_page.epoch_seconds = m_epoch_time;
+    time_page.epoch_nanoseconds = m_ticks_this_second * (1'000'000'000 / OPTIMAL_TICKS_PER_SECOND_RATE);
+    time_page.monotonic_nanoseconds = now;
+    time_page.is_updated = 1;
+    __atomic_store_n(&time_page.update_sequence, time_page.update_sequence + 1, __ATOMIC_RELEASE);
 }
 time_t TimeManagement::seconds_since_boot() const
 {
+    if (m_tickless)
+        return monotonic_time_ns() / 1'000'000'000;
     return m_seconds_since_boot;
 }
 time_t TimeManagement::ticks_per_second() const
@@ -82,9 +124,34 @@ time_t TimeManagement::ticks_per_second() const
 
 time_t TimeManagement::ticks_this_second() const
 {
+    if (m_tickless)
+        return (monotonic_time_ns() % 1'000'000'000) / (1'000'000'000 / OPTIMAL_TICKS_PER_SECOND_RATE);
     return m_ticks_this_second;
 }
 
+u64 TimeManagement::monotonic_time_ns() const
+{
+    if (m_hpet_main_counter_is_time_source)
+        return HPET::the().ticks_to_nanoseconds(HPET::the().main_counter_value());
+    return (u64)m_seconds_since_boot * 1'000'000'000 + (u64)m_ticks_this_second * 1'000'000'000 / m_time_keeper_timer->ticks_per_second();
+}
+
+u64 TimeManagement::ticks_since_boot() const
+{
+    u64 now = monotonic_time_ns();
+    u64 ticks_per_second = m_system_timer->ticks_per_second();
+    return (now / 1'000'000'000) * ticks_per_second + (now % 1'000'000'000) * ticks_per_second / 1'000'000'000;
+}
+
+void TimeManagement::set_system_timer_deadline(u64 deadline)
+{
+    ASSERT(m_tickless);
+    InterruptDisabler disabler;
+    m_system_timer_deadline = deadline;
+    u64 now = monotonic_time_ns();
+    m_system_timer->fire_after(deadline > now ? deadline - now : 0);
+}
+
 time_t TimeManagement::boot_time() const
 {
     return RTC::boot_time();
@@ -151,11 +218,16 @@ bool TimeManagement::is_hpet_periodic_mode_allowed()
     auto hpet_mode = kernel_command_line().lookup("hpet").value_or("periodic");
     if (hpet_mode == "periodic")
         return true;
-    if (hpet_mode == "nonperiodic")
+    if (hpet_mode == "nonperiodic" || hpet_mode == "oneshot")
         return false;
     ASSERT_NOT_REACHED();
 }
 
+bool TimeManagement::is_hpet_one_shot_mode_requested()
+{
+    return kernel_command_line().lookup("hpet").value_or("periodic") == "oneshot";
+}
+
 bool TimeManagement::probe_and_set_non_legacy_hardware_timers()
 {
     if (!ACPI::is_enabled())
@@ -192,9 +264,25 @@ bool TimeManagement::probe_and_set_non_legacy_hardware_timers()
         }
     }
 
+    m_hpet_main_counter_is_time_source = HPET::the().is_main_counter_64_bit();
+
+    if (is_hpet_one_shot_mode_requested()) {
+        if (m_hpet_main_counter_is_time_source && m_system_timer->is_one_shot_capable())
+            m_tickless = true;
+        else
+            klog() << "HPET: One-shot mode needs a 64-bit main counter, falling back to non-periodic ticks";
+    }
+
     m_system_timer->set_callback(Scheduler::timer_tick);
     dbg() << "Reset timers";
     m_system_timer->try_to_set_frequency(m_system_timer->calculate_nearest_possible_frequency(1024));
+    if (m_tickless) {
+        // The first tick was already programmed above, from then on the scheduler decides when the next one is due.
+        m_system_timer->set_one_shot();
+        m_time_keeper_timer = nullptr;
+        klog() << "Time: Running tickless on the HPET";
+        return true;
+    }
     m_time_keeper_timer->set_callback(TimeManagement::update_time);
     m_time_keeper_timer->try_to_set_frequency(OPTIMAL_TICKS_PER_SECOND_RATE);
 
@@ -233,6 +321,7 @@ void TimeManagement::increment_time_since_boot(const RegisterState&)
         ++m_epoch_time;
         m_ticks_this_second = 0;
     }
+    update_time_page();
 }
 
 }
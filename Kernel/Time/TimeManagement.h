@@ -28,6 +28,7 @@
 
 #include <AK/FixedArray.h>
 #include <AK/NonnullRefPtrVector.h>
+#include <AK/OwnPtr.h>
 #include <AK/RefPtr.h>
 #include <AK/Types.h>
 #include <Kernel/UnixTypes.h>
@@ -37,6 +38,8 @@ namespace Kernel {
 #define OPTIMAL_TICKS_PER_SECOND_RATE 1000
 
 class HardwareTimer;
+class Region;
+class VMObject;
 
 class TimeManagement {
     AK_MAKE_ETERNAL;
@@ -53,28 +56,48 @@ public:
     time_t ticks_this_second() const;
     time_t boot_time() const;
 
+    // Nanoseconds since the time management was brought up, read straight from the HPET main counter when we can.
+    u64 monotonic_time_ns() const;
+    u64 ticks_since_boot() const;
+
     bool is_system_timer(const HardwareTimer&) const;
 
+    // In tickless mode the system timer is a one-shot timer that only fires when it's told to.
+    bool is_tickless() const { return m_tickless; }
+    u64 system_timer_deadline() const { return m_system_timer_deadline; }
+    void set_system_timer_deadline(u64 monotonic_time_ns);
+
     static void update_time(const RegisterState&);
     void increment_time_since_boot(const RegisterState&);
 
     static bool is_hpet_periodic_mode_allowed();
+    static bool is_hpet_one_shot_mode_requested();
 
     static timeval now_as_timeval();
 
+    // The page userspace maps to read the time without a syscall, see Kernel/TimePage.h.
+    VMObject& time_page_vmobject() { return *m_time_page_vmobject; }
+
 private:
     explicit TimeManagement(bool probe_non_legacy_hardware_timers);
     bool probe_and_set_legacy_hardware_timers();
     bool probe_and_set_non_legacy_hardware_timers();
     Vector<HardwareTimer*> scan_and_initialize_periodic_timers();
     Vector<HardwareTimer*> scan_for_non_periodic_timers();
+    void create_time_page();
+    void update_time_page();
     NonnullRefPtrVector<HardwareTimer> m_hardware_timers;
 
     u32 m_ticks_this_second { 0 };
     u32 m_seconds_since_boot { 0 };
     time_t m_epoch_time { 0 };
+    bool m_hpet_main_counter_is_time_source { false };
+    bool m_tickless { false };
+    u64 m_system_timer_deadline { 0 };
     RefPtr<HardwareTimer> m_system_timer;
     RefPtr<HardwareTimer> m_time_keeper_timer;
+    RefPtr<VMObject> m_time_page_vmobject;
+    OwnPtr<Region> m_time_page_region;
 };
 
 }
@@ -44,13 +44,11 @@ TimerQueue& TimerQueue::the()
 
 TimerQueue::TimerQueue()
 {
-    m_ticks_per_second = TimeManagement::the().ticks_per_second();
 }
 
 TimerId TimerQueue::add_timer(NonnullOwnPtr<Timer>&& timer)
 {
     u64 timer_expiration = timer->expires;
-    ASSERT(timer_expiration >= g_uptime);
 
     timer->id = ++m_timer_id_count;
 
@@ -71,13 +69,18 @@ TimerId TimerQueue::add_timer(NonnullOwnPtr<Timer>&& timer)
         }
     }
 
+    // A tickless system timer may be napping until a later deadline.
+    auto& time_management = TimeManagement::the();
+    if (time_management.is_tickless() && timer_expiration < time_management.system_timer_deadline())
+        time_management.set_system_timer_deadline(timer_expiration);
+
     return m_timer_id_count;
 }
 
 TimerId TimerQueue::add_timer(timeval& deadline, Function<void()>&& callback)
 {
     NonnullOwnPtr timer = make<Timer>();
-    timer->expires = g_uptime + seconds_to_ticks(deadline.tv_sec) + microseconds_to_ticks(deadline.tv_usec);
+    timer->expires = TimeManagement::the().monotonic_time_ns() + (u64)deadline.tv_sec * 1'000'000'000 + (u64)deadline.tv_usec * 1000;
     timer->callback = move(callback);
     return add_timer(move(timer));
 }
@@ -104,7 +107,8 @@ void TimerQueue::fire()
 
     ASSERT(m_next_timer_due == m_timer_queue.first()->expires);
 
-    while (!m_timer_queue.is_empty() && g_uptime > m_timer_queue.first()->expires) {
+    u64 now = TimeManagement::the().monotonic_time_ns();
+    while (!m_timer_queue.is_empty() && now >= m_timer_queue.first()->expires) {
         auto timer = m_timer_queue.take_first();
         timer->callback();
     }
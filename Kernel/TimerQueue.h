@@ -38,7 +38,7 @@ typedef u64 TimerId;
 
 struct Timer {
     TimerId id;
-    u64 expires;
+    u64 expires; // In nanoseconds on the monotonic clock.
     Function<void()> callback;
     bool operator<(const Timer& rhs) const
     {
@@ -63,17 +63,16 @@ public:
     bool cancel_timer(TimerId id);
     void fire();
 
+    // Zero if there are no timers.
+    u64 next_timer_due() const { return m_next_timer_due; }
+
 private:
     TimerQueue();
 
     void update_next_timer_due();
 
-    u64 microseconds_to_ticks(u64 micro_seconds) { return micro_seconds * (m_ticks_per_second / 1'000'000); }
-    u64 seconds_to_ticks(u64 seconds) { return seconds * m_ticks_per_second; }
-
     u64 m_next_timer_due { 0 };
     u64 m_timer_id_count { 0 };
-    u64 m_ticks_per_second { 0 };
     SinglyLinkedList<NonnullOwnPtr<Timer>> m_timer_queue;
 };
 
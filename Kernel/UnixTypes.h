@@ -57,6 +57,28 @@
 
 #define PERF_EVENT_MALLOC 1
 #define PERF_EVENT_FREE 2
+#define PERF_EVENT_PAGE_FAULT 3
+#define PERF_EVENT_CONTEXT_SWITCH_OUT 4
+#define PERF_EVENT_CONTEXT_SWITCH_IN 5
+#define PERF_EVENT_SYSCALL 6
+#define PERF_EVENT_BLOCK_IO_SUBMIT 7
+#define PERF_EVENT_BLOCK_IO_COMPLETE 8
+#define PERF_EVENT_LOCK_WAIT 9
+#define PERF_EVENT_WAKEUP 10
+
+// Not an event: asks the kernel to record the kernel events above for the calling process.
+#define PERF_EVENT_ENABLE_KERNEL_EVENTS 64
+
+#define PERF_COUNTER_CYCLES 0
+#define PERF_COUNTER_INSTRUCTIONS 1
+#define PERF_COUNTER_CACHE_MISSES 2
+#define PERF_COUNTER_BRANCH_MISSES 3
+#define PERF_COUNTER_EVENT_COUNT 4
+
+#define PERF_COUNTERS_ENABLE 1
+#define PERF_COUNTERS_DISABLE 2
+#define PERF_COUNTERS_READ 3
+#define PERF_COUNTERS_SAMPLE 4
 
 #define WNOHANG 1
 #define WUNTRACED 2
@@ -84,6 +106,8 @@
 #define MAP_ANON MAP_ANONYMOUS
 #define MAP_STACK 0x40
 #define MAP_PURGEABLE 0x80
+#define MAP_HUGE 0x100
+#define MAP_POPULATE 0x200
 
 #define PROT_READ 0x1
 #define PROT_WRITE 0x2
@@ -93,6 +117,8 @@
 #define MADV_SET_VOLATILE 0x100
 #define MADV_SET_NONVOLATILE 0x200
 #define MADV_GET_VOLATILE 0x400
+#define MADV_WILLNEED 0x800
+#define MADV_DONTNEED 0x1000
 
 #define MAP_INHERIT_ZERO 1
 
@@ -107,6 +133,33 @@
 
 #define FUTEX_WAIT 1
 #define FUTEX_WAKE 2
+#define FUTEX_REQUEUE 3
+#define FUTEX_CMP_REQUEUE 4
+#define FUTEX_WAKE_OP 5
+#define FUTEX_WAIT_BITSET 9
+#define FUTEX_WAKE_BITSET 10
+
+#define FUTEX_PRIVATE_FLAG 128
+#define FUTEX_CLOCK_REALTIME 256
+#define FUTEX_CMD_MASK ~(FUTEX_PRIVATE_FLAG | FUTEX_CLOCK_REALTIME)
+
+#define FUTEX_BITSET_MATCH_ANY 0xffffffff
+
+#define FUTEX_OP_SET 0
+#define FUTEX_OP_ADD 1
+#define FUTEX_OP_OR 2
+#define FUTEX_OP_ANDN 3
+#define FUTEX_OP_XOR 4
+#define FUTEX_OP_OPARG_SHIFT 8
+
+#define FUTEX_OP_CMP_EQ 0
+#define FUTEX_OP_CMP_NE 1
+#define FUTEX_OP_CMP_LT 2
+#define FUTEX_OP_CMP_LE 3
+#define FUTEX_OP_CMP_GT 4
+#define FUTEX_OP_CMP_GE 5
+
+#define FUTEX_OP(op, oparg, cmp, cmparg) ((((op)&0xf) << 28) | (((cmp)&0xf) << 24) | (((oparg)&0xfff) << 12) | ((cmparg)&0xfff))
 
 /* c_cc characters */
 #define VINTR 0
@@ -403,6 +456,32 @@ struct pollfd {
     short revents;
 };
 
+#define EPOLLIN (1u << 0)
+#define EPOLLPRI (1u << 1)
+#define EPOLLOUT (1u << 2)
+#define EPOLLERR (1u << 3)
+#define EPOLLHUP (1u << 4)
+#define EPOLLONESHOT (1u << 30)
+#define EPOLLET (1u << 31)
+
+#define EPOLL_CTL_ADD 1
+#define EPOLL_CTL_DEL 2
+#define EPOLL_CTL_MOD 3
+
+#define EPOLL_CLOEXEC O_CLOEXEC
+
+typedef union epoll_data {
+    void* ptr;
+    int fd;
+    __UINT32_TYPE__ u32;
+    __UINT64_TYPE__ u64;
+} epoll_data_t;
+
+struct epoll_event {
+    u32 events;
+    epoll_data_t data;
+};
+
 #define AF_MASK 0xff
 #define AF_UNSPEC 0
 #define AF_LOCAL 1
@@ -433,6 +512,7 @@ struct pollfd {
 #define SO_PEERCRED 5
 #define SO_REUSEADDR 6
 #define SO_BINDTODEVICE 7
+#define SO_REUSEPORT 8
 
 #define IPPROTO_IP 0
 #define IPPROTO_ICMP 1
@@ -441,6 +521,34 @@ struct pollfd {
 
 #define IP_TTL 2
 
+#define TCP_NODELAY 1
+#define TCP_CORK 3
+#define TCP_INFO 11
+
+// Times are in milliseconds, windows and thresholds in bytes.
+struct tcp_info {
+    u8 tcpi_state;
+    u32 tcpi_rto;
+    u32 tcpi_rtt;
+    u32 tcpi_rttvar;
+    u32 tcpi_snd_mss;
+    u32 tcpi_snd_cwnd;
+    u32 tcpi_snd_ssthresh;
+    u32 tcpi_snd_wnd;
+    u32 tcpi_rcv_wnd;
+    u32 tcpi_unacked;
+    u32 tcpi_total_retrans;
+    u32 tcpi_timeouts;
+    u32 tcpi_fast_retrans;
+    u32 tcpi_dup_acks;
+    u32 tcpi_out_of_order;
+    u32 tcpi_rcv_drops;
+    u32 tcpi_segs_in;
+    u32 tcpi_segs_out;
+    u32 tcpi_bytes_in;
+    u32 tcpi_bytes_out;
+};
+
 struct ucred {
     pid_t pid;
     uid_t uid;
@@ -525,8 +633,20 @@ struct iovec {
 
 struct sched_param {
     int sched_priority;
+    int sched_group_weight;
 };
 
+#define SCHED_FIFO 0
+#define SCHED_RR 1
+#define SCHED_OTHER 2
+#define SCHED_BATCH 3
+
+#define CPU_SETSIZE 32
+
+typedef struct {
+    u32 __bits;
+} cpu_set_t;
+
 struct ifreq {
 #define IFNAMSIZ 16
     char ifr_name[IFNAMSIZ];
@@ -24,7 +24,10 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <AK/Memory.h>
 #include <Kernel/FileSystem/Inode.h>
+#include <Kernel/KBuffer.h>
+#include <Kernel/StdLib.h>
 #include <Kernel/VM/InodeVMObject.h>
 #include <Kernel/VM/MemoryManager.h>
 #include <Kernel/VM/Region.h>
@@ -146,6 +149,119 @@ int InodeVMObject::release_all_clean_pages()
     return release_all_clean_pages_impl();
 }
 
+int InodeVMObject::release_all_clean_pages_with_interrupts_disabled(Badge<MemoryManager>)
+{
+    ASSERT_INTERRUPTS_DISABLED();
+    return release_all_clean_pages_impl();
+}
+
+KResultOr<NonnullRefPtr<PhysicalPage>> InodeVMObject::ensure_physical_page(size_t page_index)
+{
+    {
+        InterruptDisabler disabler;
+        if (page_index >= page_count())
+            return KResult(-EINVAL);
+        if (auto& page = m_physical_pages[page_index])
+            return NonnullRefPtr<PhysicalPage>(*page);
+    }
+
+    if (auto backing_page = m_inode->backing_physical_page(page_index)) {
+        InterruptDisabler disabler;
+        if (page_index >= page_count())
+            return KResult(-EINVAL);
+        auto& page_slot = m_physical_pages[page_index];
+        if (!page_slot)
+            page_slot = move(backing_page);
+        return NonnullRefPtr<PhysicalPage>(*page_slot);
+    }
+
+    u8 page_buffer[PAGE_SIZE];
+    auto nread = m_inode->read_bytes(page_index * PAGE_SIZE, PAGE_SIZE, page_buffer, nullptr);
+    if (nread < 0)
+        return KResult(nread);
+    if (nread < PAGE_SIZE) {
+        // If we read less than a page, zero out the rest to avoid leaking uninitialized data.
+        memset(page_buffer + nread, 0, PAGE_SIZE - nread);
+    }
+
+    InterruptDisabler disabler;
+    // The inode may have shrunk while we were reading.
+    if (page_index >= page_count())
+        return KResult(-EINVAL);
+    auto& page_slot = m_physical_pages[page_index];
+    if (!page_slot) {
+        auto page = MM.allocate_user_physical_page(MemoryManager::ShouldZeroFill::No);
+        if (!page)
+            return KResult(-ENOMEM);
+        u8* dest_ptr = MM.quickmap_page(*page);
+        memcpy(dest_ptr, page_buffer, PAGE_SIZE);
+        MM.unquickmap_page();
+        page_slot = move(page);
+    }
+    return NonnullRefPtr<PhysicalPage>(*page_slot);
+}
+
+static constexpr size_t max_prefetch_page_count = 32;
+
+void InodeVMObject::prefetch_physical_pages(size_t first_page_index, size_t page_count)
+{
+    Optional<KBuffer> buffer;
+    size_t end_page_index = first_page_index + page_count;
+
+    auto is_resident = [&](size_t page_index) {
+        InterruptDisabler disabler;
+        return page_index >= this->page_count() || !m_physical_pages[page_index].is_null();
+    };
+
+    size_t page_index = first_page_index;
+    while (page_index < end_page_index) {
+        if (is_resident(page_index)) {
+            ++page_index;
+            continue;
+        }
+        size_t run_start = page_index;
+        while (page_index < end_page_index && page_index - run_start < max_prefetch_page_count && !is_resident(page_index))
+            ++page_index;
+        size_t run_page_count = page_index - run_start;
+
+        if (!buffer.has_value())
+            buffer = KBuffer::create_with_size(max_prefetch_page_count * PAGE_SIZE, Region::Access::Read | Region::Access::Write, "InodeVMObject prefetch");
+        auto nread = m_inode->read_bytes(run_start * PAGE_SIZE, run_page_count * PAGE_SIZE, buffer.value().data(), nullptr);
+        if (nread <= 0)
+            return;
+        if ((size_t)nread < run_page_count * PAGE_SIZE)
+            memset(buffer.value().data() + nread, 0, run_page_count * PAGE_SIZE - nread);
+
+        for (size_t i = 0; i < ceil_div((size_t)nread, PAGE_SIZE); ++i) {
+            auto page = MM.allocate_user_physical_page(MemoryManager::ShouldZeroFill::No);
+            if (!page)
+                return;
+            InterruptDisabler disabler;
+            // The inode may have shrunk while we were reading.
+            if (run_start + i >= this->page_count())
+                return;
+            auto& page_slot = m_physical_pages[run_start + i];
+            if (page_slot)
+                continue;
+            u8* dest_ptr = MM.quickmap_page(*page);
+            memcpy(dest_ptr, buffer.value().data() + i * PAGE_SIZE, PAGE_SIZE);
+            MM.unquickmap_page();
+            page_slot = move(page);
+        }
+        if ((size_t)nread < run_page_count * PAGE_SIZE)
+            return;
+    }
+}
+
+void InodeVMObject::copy_from_physical_page(PhysicalPage& page, size_t offset_in_page, u8* destination, size_t count)
+{
+    ASSERT(offset_in_page + count <= PAGE_SIZE);
+    InterruptDisabler disabler;
+    auto* page_ptr = MM.quickmap_page(page);
+    memcpy(destination, page_ptr + offset_in_page, count);
+    MM.unquickmap_page();
+}
+
 int InodeVMObject::release_all_clean_pages_impl()
 {
     int count = 0;
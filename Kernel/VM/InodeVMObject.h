@@ -27,6 +27,7 @@
 #pragma once
 
 #include <AK/Bitmap.h>
+#include <Kernel/KResult.h>
 #include <Kernel/UnixTypes.h>
 #include <Kernel/VM/VMObject.h>
 
@@ -44,8 +45,18 @@ public:
 
     size_t amount_dirty() const;
     size_t amount_clean() const;
+    void set_page_dirty(size_t page_index, bool dirty) { m_dirty_pages.set(page_index, dirty); }
 
     int release_all_clean_pages();
+    int release_all_clean_pages_with_interrupts_disabled(Badge<MemoryManager>);
+
+    // Reads the given page of the inode in, unless it's resident already. Call this with the paging lock held.
+    KResultOr<NonnullRefPtr<PhysicalPage>> ensure_physical_page(size_t page_index);
+    // Reads in whichever of the given pages aren't resident yet, batching runs of them into large reads.
+    // Call this with the paging lock held.
+    void prefetch_physical_pages(size_t first_page_index, size_t page_count);
+    // Copies part of a page out. The destination must not be in userspace, since we do this with interrupts disabled.
+    static void copy_from_physical_page(PhysicalPage&, size_t offset_in_page, u8* destination, size_t count);
 
     u32 writable_mappings() const;
     u32 executable_mappings() const;
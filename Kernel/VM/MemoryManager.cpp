@@ -29,9 +29,11 @@
 #include <AK/StringView.h>
 #include <Kernel/Arch/i386/CPU.h>
 #include <Kernel/CMOS.h>
+#include <Kernel/Devices/MemoryPressureDevice.h>
 #include <Kernel/FileSystem/Inode.h>
 #include <Kernel/Multiboot.h>
 #include <Kernel/Process.h>
+#include <Kernel/Scheduler.h>
 #include <Kernel/VM/AnonymousVMObject.h>
 #include <Kernel/VM/ContiguousVMObject.h>
 #include <Kernel/VM/MemoryManager.h>
@@ -64,6 +66,7 @@ MemoryManager::MemoryManager()
     write_cr3(kernel_page_directory().cr3());
     protect_kernel_image();
 
+    m_zeroed_user_physical_pages.ensure_capacity(zeroed_page_pool_capacity);
     m_shared_zero_page = allocate_user_physical_page();
 }
 
@@ -88,6 +91,28 @@ void MemoryManager::protect_kernel_image()
     }
 }
 
+void MemoryManager::identity_map_low_page(VirtualAddress vaddr)
+{
+    ASSERT(vaddr.get() < 2 * MB);
+    InterruptDisabler disabler;
+    auto& pte = ensure_pte(kernel_page_directory(), vaddr);
+    pte.set_physical_page_base(vaddr.get());
+    pte.set_present(true);
+    pte.set_writable(true);
+    pte.set_user_allowed(false);
+    flush_tlb_local(vaddr);
+}
+
+void MemoryManager::unmap_low_page(VirtualAddress vaddr)
+{
+    ASSERT(vaddr.get() < 2 * MB);
+    InterruptDisabler disabler;
+    auto& pte = ensure_pte(kernel_page_directory(), vaddr);
+    pte.clear();
+    // NOTE: Other CPUs drop this translation the next time they load CR3.
+    flush_tlb_local(vaddr);
+}
+
 void MemoryManager::parse_memory_map()
 {
     RefPtr<PhysicalRegion> region;
@@ -170,12 +195,22 @@ const PageTableEntry* MemoryManager::pte(const PageDirectory& page_directory, Vi
 
     auto* pd = quickmap_pd(const_cast<PageDirectory&>(page_directory), page_directory_table_index);
     const PageDirectoryEntry& pde = pd[page_directory_index];
-    if (!pde.is_present())
+    // There's no page table behind a huge page.
+    if (!pde.is_present() || pde.is_huge())
         return nullptr;
 
     return &quickmap_pt(PhysicalAddress((FlatPtr)pde.page_table_base()))[page_table_index];
 }
 
+bool MemoryManager::pde_is_present(const PageDirectory& page_directory, VirtualAddress vaddr)
+{
+    ASSERT_INTERRUPTS_DISABLED();
+    u32 page_directory_table_index = (vaddr.get() >> 30) & 0x3;
+    u32 page_directory_index = (vaddr.get() >> 21) & 0x1ff;
+    auto* pd = quickmap_pd(const_cast<PageDirectory&>(page_directory), page_directory_table_index);
+    return pd[page_directory_index].is_present();
+}
+
 PageTableEntry& MemoryManager::ensure_pte(PageDirectory& page_directory, VirtualAddress vaddr)
 {
     ASSERT_INTERRUPTS_DISABLED();
@@ -185,6 +220,8 @@ PageTableEntry& MemoryManager::ensure_pte(PageDirectory& page_directory, Virtual
 
     auto* pd = quickmap_pd(page_directory, page_directory_table_index);
     PageDirectoryEntry& pde = pd[page_directory_index];
+    if (pde.is_present() && pde.is_huge())
+        split_huge_page(page_directory, vaddr, pde);
     if (!pde.is_present()) {
 #ifdef MM_DEBUG
         dbg() << "MM: PDE " << page_directory_index << " not present (requested for " << vaddr << "), allocating";
@@ -198,12 +235,92 @@ PageTableEntry& MemoryManager::ensure_pte(PageDirectory& page_directory, Virtual
         pde.set_present(true);
         pde.set_writable(true);
         pde.set_global(&page_directory == m_kernel_page_directory.ptr());
-        page_directory.m_physical_pages.set(page_directory_index, move(page_table));
+        page_directory.m_physical_pages.set(vaddr.get() & ~(huge_page_size - 1), move(page_table));
     }
 
     return quickmap_pt(PhysicalAddress((FlatPtr)pde.page_table_base()))[page_table_index];
 }
 
+void MemoryManager::split_huge_page(PageDirectory& page_directory, VirtualAddress vaddr, PageDirectoryEntry& pde)
+{
+    ASSERT_INTERRUPTS_DISABLED();
+    ASSERT(pde.is_present() && pde.is_huge());
+    auto huge_page_vaddr = VirtualAddress(vaddr.get() & ~(huge_page_size - 1));
+    auto page_table = allocate_user_physical_page(ShouldZeroFill::No);
+    ASSERT(page_table);
+
+    // Give each 4 KiB page the same translation and permissions the large page had.
+    u32 base = (FlatPtr)pde.page_table_base();
+    auto* pt = quickmap_pt(page_table->paddr());
+    for (size_t i = 0; i < pages_per_huge_page; ++i) {
+        auto& pte = pt[i];
+        pte.clear();
+        pte.set_physical_page_base(base + i * PAGE_SIZE);
+        pte.set_present(true);
+        pte.set_writable(pde.is_writable());
+        pte.set_user_allowed(pde.is_user_allowed());
+        pte.set_cache_disabled(pde.is_cache_disabled());
+        if (g_cpu_supports_nx)
+            pte.set_execute_disabled(pde.is_execute_disabled());
+    }
+
+    pde.clear();
+    pde.set_page_table_base(page_table->paddr().get());
+    pde.set_user_allowed(true);
+    pde.set_present(true);
+    pde.set_writable(true);
+    pde.set_global(&page_directory == m_kernel_page_directory.ptr());
+    page_directory.m_physical_pages.set(huge_page_vaddr.get(), move(page_table));
+    flush_tlb(&page_directory, huge_page_vaddr);
+}
+
+void MemoryManager::map_huge_page(PageDirectory& page_directory, VirtualAddress vaddr, PhysicalAddress paddr, bool writable, bool user_allowed, bool executable, bool cacheable)
+{
+    ASSERT_INTERRUPTS_DISABLED();
+    ASSERT(!(vaddr.get() % huge_page_size));
+    ASSERT(!(paddr.get() % huge_page_size));
+    u32 page_directory_table_index = (vaddr.get() >> 30) & 0x3;
+    u32 page_directory_index = (vaddr.get() >> 21) & 0x1ff;
+
+    // Hang on to the page table until the TLB has forgotten about it.
+    RefPtr<PhysicalPage> page_table;
+    auto it = page_directory.m_physical_pages.find(vaddr.get());
+    if (it != page_directory.m_physical_pages.end()) {
+        page_table = move(it->value);
+        page_directory.m_physical_pages.remove(it);
+    }
+
+    auto& pde = quickmap_pd(page_directory, page_directory_table_index)[page_directory_index];
+    pde.clear();
+    pde.set_page_table_base(paddr.get());
+    pde.set_huge(true);
+    pde.set_present(true);
+    pde.set_writable(writable);
+    pde.set_user_allowed(user_allowed);
+    pde.set_cache_disabled(!cacheable);
+    if (g_cpu_supports_nx)
+        pde.set_execute_disabled(!executable);
+#ifdef MM_DEBUG
+    dbg() << "MM: >> huge map (PD=" << page_directory.cr3() << ") " << vaddr << " => " << paddr;
+#endif
+    flush_tlb(&page_directory, vaddr, pages_per_huge_page);
+    page_table = nullptr;
+}
+
+bool MemoryManager::unmap_huge_page_if_mapped(PageDirectory& page_directory, VirtualAddress vaddr)
+{
+    ASSERT_INTERRUPTS_DISABLED();
+    ASSERT(!(vaddr.get() % huge_page_size));
+    u32 page_directory_table_index = (vaddr.get() >> 30) & 0x3;
+    u32 page_directory_index = (vaddr.get() >> 21) & 0x1ff;
+    auto& pde = quickmap_pd(page_directory, page_directory_table_index)[page_directory_index];
+    if (!pde.is_present() || !pde.is_huge())
+        return false;
+    pde.clear();
+    flush_tlb(&page_directory, vaddr);
+    return true;
+}
+
 void MemoryManager::initialize()
 {
     s_the = new MemoryManager;
@@ -258,11 +375,26 @@ Region* MemoryManager::region_from_vaddr(VirtualAddress vaddr)
     return user_region_from_vaddr(*page_directory->process(), vaddr);
 }
 
+RefPtr<PhysicalPage> MemoryManager::physical_page_for_dma(VirtualAddress vaddr, bool device_writes_to_memory)
+{
+    InterruptDisabler disabler;
+    auto* region = region_from_vaddr(vaddr);
+    if (!region)
+        return nullptr;
+    auto page_index = region->page_index_from_address(vaddr);
+    auto& page_slot = region->physical_page_slot(page_index);
+    if (!page_slot || page_slot->is_shared_zero_page())
+        return nullptr;
+    if (device_writes_to_memory && (!region->is_writable() || region->should_cow(page_index)))
+        return nullptr;
+    return page_slot;
+}
+
 PageFaultResponse MemoryManager::handle_page_fault(const PageFault& fault)
 {
     ASSERT_INTERRUPTS_DISABLED();
-    ASSERT(Thread::current);
-    if (g_in_irq) {
+    ASSERT(Thread::current());
+    if (Processor::current().in_irq()) {
         dbg() << "BUG! Page fault while handling IRQ! code=" << fault.code() << ", vaddr=" << fault.vaddr();
         dump_kernel_regions();
     }
@@ -356,6 +488,8 @@ void MemoryManager::deallocate_user_physical_page(PhysicalPage&& page)
         region.return_page(move(page));
         --m_user_physical_pages_used;
 
+        if (m_under_memory_pressure && m_user_physical_pages - m_user_physical_pages_used > m_user_physical_pages / 8)
+            m_under_memory_pressure = false;
         return;
     }
 
@@ -374,10 +508,58 @@ RefPtr<PhysicalPage> MemoryManager::find_free_user_physical_page()
     return page;
 }
 
+RefPtr<PhysicalPage> MemoryManager::take_zeroed_user_physical_page()
+{
+    RefPtr<PhysicalPage> page;
+    if (!m_zeroed_user_physical_pages.is_empty())
+        page = m_zeroed_user_physical_pages.take_last();
+
+    if (!m_zeroed_page_pool_needs_refill && m_zeroed_user_physical_pages.size() < zeroed_page_pool_capacity / 2) {
+        m_zeroed_page_pool_needs_refill = true;
+        if (g_finalizer_wait_queue)
+            g_finalizer_wait_queue->wake_all();
+    }
+    return page;
+}
+
+void MemoryManager::refill_zeroed_page_pool()
+{
+    for (;;) {
+        // Clear one page at a time so we don't keep interrupts disabled for long.
+        InterruptDisabler disabler;
+        if (m_zeroed_user_physical_pages.size() >= zeroed_page_pool_capacity)
+            break;
+        auto page = find_free_user_physical_page();
+        if (!page)
+            break;
+        auto* ptr = quickmap_page(*page);
+        memset(ptr, 0, PAGE_SIZE);
+        unquickmap_page();
+        m_zeroed_user_physical_pages.append(page.release_nonnull());
+    }
+
+    InterruptDisabler disabler;
+    m_zeroed_page_pool_needs_refill = false;
+}
+
 RefPtr<PhysicalPage> MemoryManager::allocate_user_physical_page(ShouldZeroFill should_zero_fill)
 {
     InterruptDisabler disabler;
-    auto page = find_free_user_physical_page();
+    RefPtr<PhysicalPage> page;
+    bool page_is_zeroed = false;
+    if (should_zero_fill == ShouldZeroFill::Yes) {
+        page = take_zeroed_user_physical_page();
+        page_is_zeroed = !page.is_null();
+    }
+
+    if (!page)
+        page = find_free_user_physical_page();
+
+    if (!page && !m_zeroed_user_physical_pages.is_empty()) {
+        // The pool is all that's left; that's still better than purging something.
+        page = take_zeroed_user_physical_page();
+        page_is_zeroed = true;
+    }
 
     if (!page) {
         // We didn't have a single free physical page. Let's try to free something up!
@@ -393,6 +575,23 @@ RefPtr<PhysicalPage> MemoryManager::allocate_user_physical_page(ShouldZeroFill s
             return IterationDecision::Continue;
         });
 
+        // Next, we drop clean file contents from page caches that nobody is writing to through a mapping.
+        if (!page) {
+            for_each_vmobject_of_type<InodeVMObject>([&](auto& vmobject) {
+                if (!vmobject.is_shared_inode() || vmobject.writable_mappings())
+                    return IterationDecision::Continue;
+                int released_page_count = vmobject.release_all_clean_pages_with_interrupts_disabled({});
+                if (!released_page_count)
+                    return IterationDecision::Continue;
+                // Someone may still be holding on to the pages we released, so this doesn't have to succeed.
+                page = find_free_user_physical_page();
+                if (!page)
+                    return IterationDecision::Continue;
+                klog() << "MM: Released " << released_page_count << " clean pages from " << vmobject.class_name() << "{" << &vmobject << "}";
+                return IterationDecision::Break;
+            });
+        }
+
         if (!page) {
             klog() << "MM: no user physical pages available";
             return {};
@@ -403,16 +602,57 @@ RefPtr<PhysicalPage> MemoryManager::allocate_user_physical_page(ShouldZeroFill s
     dbg() << "MM: allocate_user_physical_page vending " << page->paddr();
 #endif
 
-    if (should_zero_fill == ShouldZeroFill::Yes) {
+    if (should_zero_fill == ShouldZeroFill::Yes && !page_is_zeroed) {
         auto* ptr = quickmap_page(*page);
         memset(ptr, 0, PAGE_SIZE);
         unquickmap_page();
     }
 
     ++m_user_physical_pages_used;
+    check_memory_pressure();
     return page;
 }
 
+void MemoryManager::check_memory_pressure()
+{
+    ASSERT_INTERRUPTS_DISABLED();
+    if (m_under_memory_pressure)
+        return;
+    if (m_user_physical_pages - m_user_physical_pages_used >= m_user_physical_pages / 16)
+        return;
+    m_under_memory_pressure = true;
+    m_memory_pressure_pending = true;
+    if (g_finalizer_wait_queue)
+        g_finalizer_wait_queue->wake_all();
+}
+
+int MemoryManager::purge_volatile_vmobjects()
+{
+    NonnullRefPtrVector<PurgeableVMObject> vmobjects;
+    {
+        InterruptDisabler disabler;
+        for_each_vmobject_of_type<PurgeableVMObject>([&](auto& vmobject) {
+            vmobjects.append(vmobject);
+            return IterationDecision::Continue;
+        });
+    }
+    int purged_page_count = 0;
+    for (auto& vmobject : vmobjects)
+        purged_page_count += vmobject.purge();
+    return purged_page_count;
+}
+
+void MemoryManager::relieve_memory_pressure()
+{
+    {
+        InterruptDisabler disabler;
+        m_memory_pressure_pending = false;
+    }
+    int purged_page_count = purge_volatile_vmobjects();
+    klog() << "MM: Free memory is low, purged " << purged_page_count << " volatile pages";
+    MemoryPressureDevice::the().notify();
+}
+
 void MemoryManager::deallocate_supervisor_physical_page(PhysicalPage&& page)
 {
     for (auto& region : m_super_physical_regions) {
@@ -430,6 +670,19 @@ void MemoryManager::deallocate_supervisor_physical_page(PhysicalPage&& page)
     ASSERT_NOT_REACHED();
 }
 
+void MemoryManager::for_each_physical_free_block_order(Function<void(size_t order, size_t user_blocks, size_t super_blocks)> callback) const
+{
+    for (size_t order = 0; order <= PhysicalRegion::max_order; ++order) {
+        size_t user_blocks = 0;
+        size_t super_blocks = 0;
+        for (auto& region : m_user_physical_regions)
+            user_blocks += region.free_blocks_at_order(order);
+        for (auto& region : m_super_physical_regions)
+            super_blocks += region.free_blocks_at_order(order);
+        callback(order, user_blocks, super_blocks);
+    }
+}
+
 NonnullRefPtrVector<PhysicalPage> MemoryManager::allocate_contiguous_supervisor_physical_pages(size_t size)
 {
     ASSERT(!(size % PAGE_SIZE));
@@ -439,8 +692,8 @@ NonnullRefPtrVector<PhysicalPage> MemoryManager::allocate_contiguous_supervisor_
 
     for (auto& region : m_super_physical_regions) {
         physical_pages = region.take_contiguous_free_pages((count), true);
-        if (physical_pages.is_empty())
-            continue;
+        if (!physical_pages.is_empty())
+            break;
     }
 
     if (physical_pages.is_empty()) {
@@ -459,6 +712,31 @@ NonnullRefPtrVector<PhysicalPage> MemoryManager::allocate_contiguous_supervisor_
     return physical_pages;
 }
 
+NonnullRefPtrVector<PhysicalPage> MemoryManager::allocate_contiguous_user_physical_pages(size_t count, size_t physical_alignment, ShouldZeroFill should_zero_fill)
+{
+    InterruptDisabler disabler;
+    NonnullRefPtrVector<PhysicalPage> physical_pages;
+    for (auto& region : m_user_physical_regions) {
+        physical_pages = region.take_aligned_contiguous_free_pages(count, physical_alignment, false);
+        if (!physical_pages.is_empty())
+            break;
+    }
+    if (physical_pages.is_empty())
+        return {};
+
+    if (should_zero_fill == ShouldZeroFill::Yes) {
+        for (auto& page : physical_pages) {
+            auto* ptr = quickmap_page(page);
+            memset(ptr, 0, PAGE_SIZE);
+            unquickmap_page();
+        }
+    }
+
+    m_user_physical_pages_used += count;
+    check_memory_pressure();
+    return physical_pages;
+}
+
 RefPtr<PhysicalPage> MemoryManager::allocate_supervisor_physical_page()
 {
     InterruptDisabler disabler;
@@ -491,10 +769,10 @@ RefPtr<PhysicalPage> MemoryManager::allocate_supervisor_physical_page()
 
 void MemoryManager::enter_process_paging_scope(Process& process)
 {
-    ASSERT(Thread::current);
+    ASSERT(Thread::current());
     InterruptDisabler disabler;
 
-    Thread::current->tss().cr3 = process.page_directory().cr3();
+    Thread::current()->tss().cr3 = process.page_directory().cr3();
     write_cr3(process.page_directory().cr3());
 }
 
@@ -503,7 +781,7 @@ void MemoryManager::flush_entire_tlb()
     write_cr3(read_cr3());
 }
 
-void MemoryManager::flush_tlb(VirtualAddress vaddr)
+void MemoryManager::flush_tlb_local(VirtualAddress vaddr)
 {
 #ifdef MM_DEBUG
     dbg() << "MM: Flush page " << vaddr;
@@ -514,6 +792,22 @@ void MemoryManager::flush_tlb(VirtualAddress vaddr)
                  : "memory");
 }
 
+void MemoryManager::flush_tlb(const PageDirectory* page_directory, VirtualAddress vaddr, size_t page_count)
+{
+    bool is_user_range = vaddr.get() < 0xc0000000;
+    // The TLB only holds user translations for the page directory we're running on.
+    if (!is_user_range || !page_directory || page_directory->cr3() == read_cr3()) {
+        // Kernel mappings may be global, and those survive a CR3 reload.
+        if (is_user_range && page_count > tlb_flush_full_reload_threshold) {
+            write_cr3(read_cr3());
+        } else {
+            for (size_t i = 0; i < page_count; ++i)
+                flush_tlb_local(vaddr.offset(i * PAGE_SIZE));
+        }
+    }
+    Processor::current().invalidate_page_on_other_processors(vaddr, page_directory, page_count);
+}
+
 extern "C" PageTableEntry boot_pd3_pt1023[1024];
 
 PageDirectoryEntry* MemoryManager::quickmap_pd(PageDirectory& directory, size_t pdpt_index)
@@ -528,7 +822,7 @@ PageDirectoryEntry* MemoryManager::quickmap_pd(PageDirectory& directory, size_t
         pte.set_present(true);
         pte.set_writable(true);
         pte.set_user_allowed(false);
-        flush_tlb(VirtualAddress(0xffe04000));
+        flush_tlb_local(VirtualAddress(0xffe04000));
     }
     return (PageDirectoryEntry*)0xffe04000;
 }
@@ -544,7 +838,7 @@ PageTableEntry* MemoryManager::quickmap_pt(PhysicalAddress pt_paddr)
         pte.set_present(true);
         pte.set_writable(true);
         pte.set_user_allowed(false);
-        flush_tlb(VirtualAddress(0xffe08000));
+        flush_tlb_local(VirtualAddress(0xffe08000));
     }
     return (PageTableEntry*)0xffe08000;
 }
@@ -564,7 +858,7 @@ u8* MemoryManager::quickmap_page(PhysicalPage& physical_page)
         pte.set_present(true);
         pte.set_writable(true);
         pte.set_user_allowed(false);
-        flush_tlb(VirtualAddress(0xffe00000));
+        flush_tlb_local(VirtualAddress(0xffe00000));
     }
     return (u8*)0xffe00000;
 }
@@ -575,7 +869,7 @@ void MemoryManager::unquickmap_page()
     ASSERT(m_quickmap_in_use);
     auto& pte = boot_pd3_pt1023[0];
     pte.clear();
-    flush_tlb(VirtualAddress(0xffe00000));
+    flush_tlb_local(VirtualAddress(0xffe00000));
     m_quickmap_in_use = false;
 }
 
@@ -594,6 +888,8 @@ bool MemoryManager::validate_range(const Process& process, VirtualAddress base_v
         dbg() << "Shenanigans! Asked to validate " << base_vaddr << " size=" << size;
         return false;
     }
+    // Syscalls that don't take the big lock may be validating while another thread changes the region list.
+    InterruptDisabler disabler;
     const Region* region = nullptr;
     while (vaddr <= end_vaddr) {
         if (!region || !region->contains(vaddr)) {
@@ -26,6 +26,7 @@
 
 #pragma once
 
+#include <AK/Function.h>
 #include <AK/HashTable.h>
 #include <AK/NonnullRefPtrVector.h>
 #include <AK/String.h>
@@ -39,6 +40,10 @@ namespace Kernel {
 
 #define PAGE_ROUND_UP(x) ((((u32)(x)) + PAGE_SIZE - 1) & (~(PAGE_SIZE - 1)))
 
+// With PAE, a page directory entry can map 2 MiB directly instead of pointing to a page table.
+static constexpr size_t huge_page_size = 2 * MB;
+static constexpr size_t pages_per_huge_page = huge_page_size / PAGE_SIZE;
+
 template<typename T>
 inline T* low_physical_to_virtual(T* physical)
 {
@@ -68,10 +73,12 @@ class SynthFSInode;
 
 class MemoryManager {
     AK_MAKE_ETERNAL
+    friend class InodeVMObject;
     friend class PageDirectory;
     friend class PhysicalPage;
     friend class PhysicalRegion;
     friend class Region;
+    friend class TmpFSInode;
     friend class VMObject;
     friend Optional<KBuffer> procfs$mm(InodeIdentifier);
     friend Optional<KBuffer> procfs$memstat(InodeIdentifier);
@@ -101,6 +108,8 @@ public:
     RefPtr<PhysicalPage> allocate_user_physical_page(ShouldZeroFill = ShouldZeroFill::Yes);
     RefPtr<PhysicalPage> allocate_supervisor_physical_page();
     NonnullRefPtrVector<PhysicalPage> allocate_contiguous_supervisor_physical_pages(size_t size);
+    // Returns nothing if there's no suitable range, rather than trying to free something up.
+    NonnullRefPtrVector<PhysicalPage> allocate_contiguous_user_physical_pages(size_t count, size_t physical_alignment, ShouldZeroFill = ShouldZeroFill::Yes);
     void deallocate_user_physical_page(PhysicalPage&&);
     void deallocate_supervisor_physical_page(PhysicalPage&&);
 
@@ -116,6 +125,22 @@ public:
     unsigned super_physical_pages() const { return m_super_physical_pages; }
     unsigned super_physical_pages_used() const { return m_super_physical_pages_used; }
 
+    // Pages handed out with ShouldZeroFill::Yes come from a pool of pages that FinalizerTask
+    // clears ahead of time, so page faults don't have to. Pooled pages still count as available.
+    static constexpr size_t zeroed_page_pool_capacity = 256;
+    size_t zeroed_page_pool_size() const { return m_zeroed_user_physical_pages.size(); }
+    bool zeroed_page_pool_needs_refill() const { return m_zeroed_page_pool_needs_refill; }
+    void refill_zeroed_page_pool();
+
+    // When free user memory drops below 1/16 of the total, FinalizerTask purges volatile
+    // memory and notifies /dev/memory_pressure. This re-arms once more than 1/8 is free.
+    bool has_pending_memory_pressure() const { return m_memory_pressure_pending; }
+    void relieve_memory_pressure();
+    int purge_volatile_vmobjects();
+
+    // Calls the callback with the number of free user and supervisor buddy blocks of each order.
+    void for_each_physical_free_block_order(Function<void(size_t order, size_t user_blocks, size_t super_blocks)>) const;
+
     template<typename Callback>
     static void for_each_vmobject(Callback callback)
     {
@@ -139,10 +164,20 @@ public:
     static Region* region_from_vaddr(Process&, VirtualAddress);
     static const Region* region_from_vaddr(const Process&, VirtualAddress);
 
+    // Returns the page behind the given address in the current address space, for devices that want to transfer
+    // to or from it directly. Returns null if it isn't resident, or if a device writing to it would bypass CoW.
+    RefPtr<PhysicalPage> physical_page_for_dma(VirtualAddress, bool device_writes_to_memory);
+
     void dump_kernel_regions();
 
     PhysicalPage& shared_zero_page() { return *m_shared_zero_page; }
 
+    PageDirectory& kernel_page_directory() { return *m_kernel_page_directory; }
+
+    // Identity maps a page in the bottom 2 MB, which is shared by all page directories.
+    void identity_map_low_page(VirtualAddress);
+    void unmap_low_page(VirtualAddress);
+
 private:
     MemoryManager();
     ~MemoryManager();
@@ -163,7 +198,8 @@ private:
     void protect_kernel_image();
     void parse_memory_map();
     void flush_entire_tlb();
-    void flush_tlb(VirtualAddress);
+    void flush_tlb_local(VirtualAddress);
+    void flush_tlb(const PageDirectory*, VirtualAddress, size_t page_count = 1);
 
     static Region* user_region_from_vaddr(Process&, VirtualAddress);
     static Region* kernel_region_from_vaddr(VirtualAddress);
@@ -171,22 +207,32 @@ private:
     static Region* region_from_vaddr(VirtualAddress);
 
     RefPtr<PhysicalPage> find_free_user_physical_page();
+    RefPtr<PhysicalPage> take_zeroed_user_physical_page();
+    void check_memory_pressure();
     u8* quickmap_page(PhysicalPage&);
     void unquickmap_page();
 
     PageDirectoryEntry* quickmap_pd(PageDirectory&, size_t pdpt_index);
     PageTableEntry* quickmap_pt(PhysicalAddress);
 
-    PageDirectory& kernel_page_directory() { return *m_kernel_page_directory; }
-
     const PageTableEntry* pte(const PageDirectory&, VirtualAddress);
+    bool pde_is_present(const PageDirectory&, VirtualAddress);
     PageTableEntry& ensure_pte(PageDirectory&, VirtualAddress);
+    void split_huge_page(PageDirectory&, VirtualAddress, PageDirectoryEntry&);
+
+    void map_huge_page(PageDirectory&, VirtualAddress, PhysicalAddress, bool writable, bool user_allowed, bool executable, bool cacheable);
+    bool unmap_huge_page_if_mapped(PageDirectory&, VirtualAddress);
 
     RefPtr<PageDirectory> m_kernel_page_directory;
     RefPtr<PhysicalPage> m_low_page_table;
 
     RefPtr<PhysicalPage> m_shared_zero_page;
 
+    NonnullRefPtrVector<PhysicalPage> m_zeroed_user_physical_pages;
+    bool m_zeroed_page_pool_needs_refill { true };
+    bool m_under_memory_pressure { false };
+    bool m_memory_pressure_pending { false };
+
     unsigned m_user_physical_pages { 0 };
     unsigned m_user_physical_pages_used { 0 };
     unsigned m_super_physical_pages { 0 };
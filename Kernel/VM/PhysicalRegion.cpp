@@ -59,33 +59,225 @@ unsigned PhysicalRegion::finalize_capacity()
     ASSERT(!m_pages);
 
     m_pages = (m_upper.get() - m_lower.get()) / PAGE_SIZE;
+    if (!m_pages)
+        return 0;
+
+    m_first_pfn = m_lower.get() / PAGE_SIZE;
     m_bitmap.grow(m_pages, false);
+    for (size_t order = 0; order <= max_order; ++order)
+        m_free_blocks.append(Bitmap::create(block_index(m_pages - 1, order) + 1, false));
+
+    // Carve the region into the largest naturally aligned blocks that fit.
+    for (unsigned page = 0; page < m_pages;) {
+        size_t order = max_order;
+        while (!block_is_in_region(page, order) || ((m_first_pfn + page) & ((1u << order) - 1)))
+            --order;
+        set_block_free(page, order, true);
+        page += 1u << order;
+    }
 
     return size();
 }
 
-NonnullRefPtrVector<PhysicalPage> PhysicalRegion::take_contiguous_free_pages(size_t count, bool supervisor)
+bool PhysicalRegion::block_is_in_region(unsigned page, size_t order) const
 {
-    ASSERT(m_pages);
-    ASSERT(m_used != m_pages);
+    size_t first_pfn = ((m_first_pfn + page) >> order) << order;
+    return first_pfn >= m_first_pfn && first_pfn + (1u << order) <= m_first_pfn + m_pages;
+}
 
-    NonnullRefPtrVector<PhysicalPage> physical_pages;
-    physical_pages.ensure_capacity(count);
+bool PhysicalRegion::block_is_free(unsigned page, size_t order) const
+{
+    return m_free_blocks[order].get(block_index(page, order));
+}
 
-    auto first_contiguous_page = find_contiguous_free_pages(count);
+void PhysicalRegion::set_block_free(unsigned page, size_t order, bool free)
+{
+    ASSERT(block_is_in_region(page, order));
+    auto index = block_index(page, order);
+    ASSERT(m_free_blocks[order].get(index) != free);
+    m_free_blocks[order].set(index, free);
+    if (free) {
+        ++m_free_block_count[order];
+        if (index < m_free_block_hint[order])
+            m_free_block_hint[order] = index;
+    } else {
+        --m_free_block_count[order];
+    }
+}
 
+Optional<unsigned> PhysicalRegion::find_free_block(size_t order)
+{
+    if (!m_free_block_count[order])
+        return {};
+
+    auto& bitmap = m_free_blocks[order];
+    const u8* data = bitmap.data();
+    size_t index = m_free_block_hint[order];
+    while (index < bitmap.size()) {
+        if (!(index % 8) && !data[index / 8]) {
+            index += 8;
+            continue;
+        }
+        if (bitmap.get(index)) {
+            m_free_block_hint[order] = index;
+            size_t first_pfn = ((m_first_pfn >> order) + index) << order;
+            return first_pfn - m_first_pfn;
+        }
+        ++index;
+    }
+    ASSERT_NOT_REACHED();
+    return {};
+}
+
+Optional<unsigned> PhysicalRegion::allocate_block(size_t order)
+{
+    ASSERT(order <= max_order);
+
+    size_t found_order = order;
+    Optional<unsigned> block;
+    for (; found_order <= max_order; ++found_order) {
+        block = find_free_block(found_order);
+        if (block.has_value())
+            break;
+    }
+    if (!block.has_value())
+        return {};
+
+    auto page = block.value();
+    set_block_free(page, found_order, false);
+    // Hand the upper halves back until we're down to the requested size.
+    while (found_order > order) {
+        --found_order;
+        set_block_free(page + (1u << found_order), found_order, true);
+    }
+
+    m_bitmap.set_range(page, 1u << order, true);
+    m_used += 1u << order;
+    return page;
+}
+
+void PhysicalRegion::take_page_from_free_blocks(unsigned page)
+{
+    size_t order = 0;
+    while (order <= max_order && !(block_is_in_region(page, order) && block_is_free(page, order)))
+        ++order;
+    ASSERT(order <= max_order);
+
+    unsigned block_page = (((m_first_pfn + page) >> order) << order) - m_first_pfn;
+    set_block_free(block_page, order, false);
+    // Split the block, keeping the half that contains the page until only that page is left.
+    while (order > 0) {
+        --order;
+        unsigned upper_half = block_page + (1u << order);
+        if (page < upper_half) {
+            set_block_free(upper_half, order, true);
+        } else {
+            set_block_free(block_page, order, true);
+            block_page = upper_half;
+        }
+    }
+
+    m_bitmap.set(page, true);
+    ++m_used;
+}
+
+void PhysicalRegion::free_page(unsigned page)
+{
+    ASSERT(m_bitmap.get(page));
+    m_bitmap.set(page, false);
+    --m_used;
+
+    size_t order = 0;
+    while (order < max_order) {
+        size_t buddy_pfn = (m_first_pfn + page) ^ (1u << order);
+        if (buddy_pfn < m_first_pfn)
+            break;
+        unsigned buddy = buddy_pfn - m_first_pfn;
+        if (!block_is_in_region(buddy, order) || !block_is_free(buddy, order))
+            break;
+        set_block_free(buddy, order, false);
+        page = min(page, buddy);
+        ++order;
+    }
+    set_block_free(page, order, true);
+}
+
+NonnullRefPtrVector<PhysicalPage> PhysicalRegion::create_physical_pages(unsigned first_page, size_t count, bool supervisor)
+{
+    NonnullRefPtrVector<PhysicalPage> physical_pages;
+    physical_pages.ensure_capacity(count);
     for (size_t index = 0; index < count; index++)
-        physical_pages.append(PhysicalPage::create(m_lower.offset(PAGE_SIZE * (index + first_contiguous_page)), supervisor));
+        physical_pages.append(PhysicalPage::create(m_lower.offset(PAGE_SIZE * (first_page + index)), supervisor));
     return physical_pages;
 }
 
-unsigned PhysicalRegion::find_contiguous_free_pages(size_t count)
+static size_t order_for_page_count(size_t count)
+{
+    size_t order = 0;
+    while (((size_t)1 << order) < count)
+        ++order;
+    return order;
+}
+
+NonnullRefPtrVector<PhysicalPage> PhysicalRegion::take_contiguous_free_pages(size_t count, bool supervisor)
+{
+    return take_aligned_contiguous_free_pages(count, PAGE_SIZE, supervisor);
+}
+
+NonnullRefPtrVector<PhysicalPage> PhysicalRegion::take_aligned_contiguous_free_pages(size_t count, size_t physical_alignment, bool supervisor)
 {
     ASSERT(count != 0);
-    // search from the last page we allocated
-    auto range = find_and_allocate_contiguous_range(count);
-    ASSERT(range.has_value());
-    return range.value();
+    ASSERT(physical_alignment && !(physical_alignment % PAGE_SIZE));
+    if (!m_pages || m_pages - m_used < count)
+        return {};
+
+    size_t pages_per_alignment = physical_alignment / PAGE_SIZE;
+    if (!(pages_per_alignment & (pages_per_alignment - 1))) {
+        size_t order = max(order_for_page_count(count), order_for_page_count(pages_per_alignment));
+        if (order <= max_order) {
+            auto block = allocate_block(order);
+            if (block.has_value()) {
+                for (size_t page = block.value() + count; page < block.value() + (1u << order); ++page)
+                    free_page(page);
+                return create_physical_pages(block.value(), count, supervisor);
+            }
+            // A free, size-aligned run of exactly one block would have been coalesced into that block.
+            if (count == pages_per_alignment && count == (1u << order))
+                return {};
+        }
+    }
+
+    // There's no suitable block (or the alignment is odd), but a smaller run that straddles
+    // block boundaries may still fit, so look for it page by page.
+    if (pages_per_alignment == 1) {
+        auto first_page = find_and_allocate_contiguous_range(count);
+        if (!first_page.has_value())
+            return {};
+        return create_physical_pages(first_page.value(), count, supervisor);
+    }
+
+    size_t misalignment = m_lower.get() % physical_alignment;
+    size_t first_candidate = misalignment ? (physical_alignment - misalignment) / PAGE_SIZE : 0;
+
+    for (size_t candidate = first_candidate; candidate + count <= m_pages;) {
+        size_t used_index = 0;
+        bool found = true;
+        for (size_t i = 0; i < count; ++i) {
+            if (m_bitmap.get(candidate + i)) {
+                used_index = candidate + i;
+                found = false;
+                break;
+            }
+        }
+        if (found) {
+            for (size_t i = 0; i < count; ++i)
+                take_page_from_free_blocks(candidate + i);
+            return create_physical_pages(candidate, count, supervisor);
+        }
+        // Skip ahead to the first aligned candidate past the page that's in use.
+        candidate += ((used_index - candidate) / pages_per_alignment + 1) * pages_per_alignment;
+    }
+    return {};
 }
 
 Optional<unsigned> PhysicalRegion::find_and_allocate_contiguous_range(size_t count)
@@ -98,11 +290,8 @@ Optional<unsigned> PhysicalRegion::find_and_allocate_contiguous_range(size_t cou
 
     auto page = first_index.value();
     if (count == found_pages_count) {
-        for (unsigned page_index = page; page_index < (page + count); page_index++) {
-            m_bitmap.set(page_index, true);
-        }
-        m_used += count;
-        m_last = page + count;
+        for (unsigned page_index = page; page_index < (page + count); page_index++)
+            take_page_from_free_blocks(page_index);
         return page;
     }
     return {};
@@ -112,10 +301,11 @@ RefPtr<PhysicalPage> PhysicalRegion::take_free_page(bool supervisor)
 {
     ASSERT(m_pages);
 
-    if (m_used == m_pages)
+    auto page = allocate_block(0);
+    if (!page.has_value())
         return nullptr;
 
-    return PhysicalPage::create(m_lower.offset(find_contiguous_free_pages(1) * PAGE_SIZE), supervisor);
+    return PhysicalPage::create(m_lower.offset(page.value() * PAGE_SIZE), supervisor);
 }
 
 void PhysicalRegion::return_page_at(PhysicalAddress addr)
@@ -130,12 +320,7 @@ void PhysicalRegion::return_page_at(PhysicalAddress addr)
     ASSERT(local_offset >= 0);
     ASSERT((FlatPtr)local_offset < (FlatPtr)(m_pages * PAGE_SIZE));
 
-    auto page = (FlatPtr)local_offset / PAGE_SIZE;
-    if (page < m_last)
-        m_last = page;
-
-    m_bitmap.set(page, false);
-    m_used--;
+    free_page((FlatPtr)local_offset / PAGE_SIZE);
 }
 
 }
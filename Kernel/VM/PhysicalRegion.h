@@ -30,14 +30,20 @@
 #include <AK/NonnullRefPtrVector.h>
 #include <AK/Optional.h>
 #include <AK/RefCounted.h>
+#include <AK/Vector.h>
 #include <Kernel/VM/PhysicalPage.h>
 
 namespace Kernel {
 
+// Free pages are managed by a binary buddy allocator. Blocks of 2^order pages are
+// aligned to their size in physical memory (not just within the region), so an
+// order-9 block is always a 2 MiB-aligned run that can back a huge page.
 class PhysicalRegion : public RefCounted<PhysicalRegion> {
     AK_MAKE_ETERNAL
 
 public:
+    static constexpr size_t max_order = 10;
+
     static NonnullRefPtr<PhysicalRegion> create(PhysicalAddress lower, PhysicalAddress upper);
     ~PhysicalRegion() {}
 
@@ -50,15 +56,28 @@ public:
     unsigned used() const { return m_used; }
     unsigned free() const { return m_pages - m_used; }
     bool contains(PhysicalPage& page) const { return page.paddr() >= m_lower && page.paddr() <= m_upper; }
+    size_t free_blocks_at_order(size_t order) const { return order <= max_order ? m_free_block_count[order] : 0; }
 
     RefPtr<PhysicalPage> take_free_page(bool supervisor);
+    // These return nothing if there's no such range in this region.
     NonnullRefPtrVector<PhysicalPage> take_contiguous_free_pages(size_t count, bool supervisor);
+    NonnullRefPtrVector<PhysicalPage> take_aligned_contiguous_free_pages(size_t count, size_t physical_alignment, bool supervisor);
     void return_page_at(PhysicalAddress addr);
     void return_page(PhysicalPage&& page) { return_page_at(page.paddr()); }
 
 private:
-    unsigned find_contiguous_free_pages(size_t count);
     Optional<unsigned> find_and_allocate_contiguous_range(size_t count);
+    NonnullRefPtrVector<PhysicalPage> create_physical_pages(unsigned first_page, size_t count, bool supervisor);
+
+    // Pages are indexed relative to m_lower; blocks are indexed by their position in the order's bitmap.
+    size_t block_index(unsigned page, size_t order) const { return ((m_first_pfn + page) >> order) - (m_first_pfn >> order); }
+    bool block_is_in_region(unsigned page, size_t order) const;
+    bool block_is_free(unsigned page, size_t order) const;
+    void set_block_free(unsigned page, size_t order, bool);
+    Optional<unsigned> find_free_block(size_t order);
+    Optional<unsigned> allocate_block(size_t order);
+    void take_page_from_free_blocks(unsigned page);
+    void free_page(unsigned page);
 
     PhysicalRegion(PhysicalAddress lower, PhysicalAddress upper);
 
@@ -66,8 +85,14 @@ private:
     PhysicalAddress m_upper;
     unsigned m_pages { 0 };
     unsigned m_used { 0 };
-    unsigned m_last { 0 };
+    size_t m_first_pfn { 0 };
+    // One bit per page, set while the page is allocated.
     Bitmap m_bitmap;
+    // One bitmap per order, with a bit set for each free block of that order.
+    Vector<Bitmap, max_order + 1> m_free_blocks;
+    size_t m_free_block_count[max_order + 1] {};
+    // No block below this index is free, so searches can start here.
+    size_t m_free_block_hint[max_order + 1] {};
 };
 
 }
@@ -30,6 +30,7 @@
 #include <Kernel/Process.h>
 #include <Kernel/Thread.h>
 #include <Kernel/VM/AnonymousVMObject.h>
+#include <Kernel/VM/InodeVMObject.h>
 #include <Kernel/VM/MemoryManager.h>
 #include <Kernel/VM/PageDirectory.h>
 #include <Kernel/VM/Region.h>
@@ -40,6 +41,8 @@
 
 namespace Kernel {
 
+DEFINE_OBJECT_CACHE(Region);
+
 Region::Region(const Range& range, NonnullRefPtr<VMObject> vmobject, size_t offset_in_vmobject, const String& name, u8 access, bool cacheable)
     : m_range(range)
     , m_offset_in_vmobject(offset_in_vmobject)
@@ -66,7 +69,7 @@ Region::~Region()
 
 NonnullOwnPtr<Region> Region::clone()
 {
-    ASSERT(Process::current);
+    ASSERT(Process::current());
 
     if (m_inherit_mode == InheritMode::ZeroedOnFork) {
         ASSERT(m_mmap);
@@ -75,6 +78,7 @@ NonnullOwnPtr<Region> Region::clone()
         auto zeroed_region = Region::create_user_accessible(m_range, AnonymousVMObject::create_with_size(size()), 0, m_name, m_access);
         zeroed_region->set_mmap(m_mmap);
         zeroed_region->set_inherit_mode(m_inherit_mode);
+        zeroed_region->set_wants_huge_pages(m_wants_huge_pages);
         return zeroed_region;
     }
 
@@ -90,6 +94,7 @@ NonnullOwnPtr<Region> Region::clone()
         auto region = Region::create_user_accessible(m_range, m_vmobject, m_offset_in_vmobject, m_name, m_access);
         region->set_mmap(m_mmap);
         region->set_shared(m_shared);
+        region->set_wants_huge_pages(m_wants_huge_pages);
         return region;
     }
 
@@ -101,7 +106,7 @@ NonnullOwnPtr<Region> Region::clone()
 #endif
     // Set up a COW region. The parent (this) region becomes COW as well!
     ensure_cow_map().fill(true);
-    remap();
+    remap_mapped_pages();
     auto clone_region = Region::create_user_accessible(m_range, m_vmobject->clone(), m_offset_in_vmobject, m_name, m_access);
     clone_region->ensure_cow_map();
     if (m_stack) {
@@ -111,6 +116,7 @@ NonnullOwnPtr<Region> Region::clone()
         clone_region->set_stack(true);
     }
     clone_region->set_mmap(m_mmap);
+    clone_region->set_wants_huge_pages(m_wants_huge_pages);
     return clone_region;
 }
 
@@ -145,6 +151,81 @@ bool Region::commit(size_t page_index)
     return true;
 }
 
+void Region::prefault(size_t first_page_index_in_region, size_t page_count)
+{
+    ASSERT(m_page_directory);
+    ASSERT(first_page_index_in_region + page_count <= this->page_count());
+
+    if (vmobject().is_inode()) {
+        auto& inode_vmobject = static_cast<InodeVMObject&>(vmobject());
+        auto& inode = inode_vmobject.inode();
+        if (!m_shared && inode.is_page_cacheable()) {
+            // Read the whole range into the page cache with as few reads as possible, then share its pages.
+            inode.readahead((first_page_index() + first_page_index_in_region) * PAGE_SIZE, page_count * PAGE_SIZE);
+            LOCKER(inode_vmobject.paging_lock());
+            for (size_t i = first_page_index_in_region; i < first_page_index_in_region + page_count; ++i) {
+                if (physical_page(i))
+                    continue;
+                if (share_page_cache_page(i).is_error())
+                    break;
+            }
+        } else {
+            inode_vmobject.prefetch_physical_pages(first_page_index() + first_page_index_in_region, page_count);
+        }
+    } else if (vmobject().is_anonymous() || vmobject().is_purgeable()) {
+        for (size_t i = first_page_index_in_region; i < first_page_index_in_region + page_count; ++i) {
+            InterruptDisabler disabler;
+            auto& page_slot = physical_page_slot(i);
+            if (!page_slot.is_null() && !page_slot->is_shared_zero_page())
+                continue;
+            if (!is_writable())
+                break;
+            // Prefaulting is only a hint, so give up quietly when memory runs out.
+            auto page = MM.allocate_user_physical_page(MemoryManager::ShouldZeroFill::Yes);
+            if (!page)
+                break;
+            page_slot = move(page);
+        }
+    }
+
+    InterruptDisabler disabler;
+    for (size_t i = first_page_index_in_region; i < first_page_index_in_region + page_count; ++i) {
+        if (physical_page(i))
+            map_individual_page_impl(i);
+    }
+    MM.flush_tlb(m_page_directory.ptr(), vaddr().offset(first_page_index_in_region * PAGE_SIZE), page_count);
+}
+
+void Region::discard_pages(size_t first_page_index_in_region, size_t page_count)
+{
+    ASSERT(m_page_directory);
+    ASSERT(first_page_index_in_region + page_count <= this->page_count());
+
+    InterruptDisabler disabler;
+    for (size_t i = first_page_index_in_region; i < first_page_index_in_region + page_count; ++i) {
+        if (!m_shared) {
+            auto& page_slot = physical_page_slot(i);
+            if (vmobject().is_inode()) {
+                page_slot = nullptr;
+                static_cast<InodeVMObject&>(vmobject()).set_page_dirty(first_page_index() + i, false);
+            }
+            else if (vmobject().is_anonymous() || vmobject().is_purgeable())
+                page_slot = MM.shared_zero_page();
+        }
+        auto vaddr = this->vaddr().offset(i * PAGE_SIZE);
+        if (!MM.pde_is_present(*m_page_directory, vaddr))
+            continue;
+        auto* pte = const_cast<PageTableEntry*>(MM.pte(*m_page_directory, vaddr));
+        if (!pte) {
+            // Part of a huge page, which we have to split first.
+            auto& split_pte = MM.ensure_pte(*m_page_directory, vaddr);
+            pte = &split_pte;
+        }
+        pte->clear();
+    }
+    MM.flush_tlb(m_page_directory.ptr(), vaddr().offset(first_page_index_in_region * PAGE_SIZE), page_count);
+}
+
 u32 Region::cow_pages() const
 {
     if (!m_cow_map)
@@ -243,7 +324,6 @@ void Region::map_individual_page_impl(size_t page_index)
         dbg() << "MM: >> region map (PD=" << m_page_directory->cr3() << ", PTE=" << (void*)pte.raw() << "{" << &pte << "}) " << name() << " " << page_vaddr << " => " << page->paddr() << " (@" << page << ")";
 #endif
     }
-    MM.flush_tlb(page_vaddr);
 }
 
 void Region::remap_page(size_t page_index)
@@ -252,6 +332,7 @@ void Region::remap_page(size_t page_index)
     InterruptDisabler disabler;
     ASSERT(physical_page(page_index));
     map_individual_page_impl(page_index);
+    MM.flush_tlb(m_page_directory.ptr(), vaddr().offset(page_index * PAGE_SIZE));
 }
 
 void Region::unmap(ShouldDeallocateVirtualMemoryRange deallocate_range)
@@ -260,14 +341,31 @@ void Region::unmap(ShouldDeallocateVirtualMemoryRange deallocate_range)
     ASSERT(m_page_directory);
     for (size_t i = 0; i < page_count(); ++i) {
         auto vaddr = this->vaddr().offset(i * PAGE_SIZE);
-        auto& pte = MM.ensure_pte(*m_page_directory, vaddr);
-        pte.clear();
-        MM.flush_tlb(vaddr);
+        if (!(vaddr.get() % huge_page_size) && i + pages_per_huge_page <= page_count()
+            && MM.unmap_huge_page_if_mapped(*m_page_directory, vaddr)) {
+            i += pages_per_huge_page - 1;
+            continue;
+        }
+        if (!MM.pde_is_present(*m_page_directory, vaddr)) {
+            // Nothing was ever mapped in this page table's range, so don't create it just to clear it.
+            i += (huge_page_size - vaddr.get() % huge_page_size) / PAGE_SIZE - 1;
+            continue;
+        }
+        auto* pte = const_cast<PageTableEntry*>(MM.pte(*m_page_directory, vaddr));
+        if (!pte) {
+            // This is part of a huge page that the region only partially covers.
+            auto& split_pte = MM.ensure_pte(*m_page_directory, vaddr);
+            pte = &split_pte;
+        }
+        if (!pte->is_present())
+            continue;
+        pte->clear();
 #ifdef MM_DEBUG
         auto* page = physical_page(i);
         dbg() << "MM: >> Unmapped " << vaddr << " => P" << String::format("%p", page ? page->paddr().get() : 0) << " <<";
 #endif
     }
+    MM.flush_tlb(m_page_directory.ptr(), vaddr(), page_count());
     if (deallocate_range == ShouldDeallocateVirtualMemoryRange::Yes)
         m_page_directory->range_allocator().deallocate(range());
     m_page_directory = nullptr;
@@ -286,8 +384,15 @@ void Region::map(PageDirectory& page_directory)
 #ifdef MM_DEBUG
     dbg() << "MM: Region::map() will map VMO pages " << first_page_index() << " - " << last_page_index() << " (VMO page count: " << vmobject().page_count() << ")";
 #endif
-    for (size_t page_index = 0; page_index < page_count(); ++page_index)
+    for (size_t page_index = 0; page_index < page_count();) {
+        if (map_huge_page_if_possible(page_index)) {
+            page_index += pages_per_huge_page;
+            continue;
+        }
         map_individual_page_impl(page_index);
+        ++page_index;
+    }
+    MM.flush_tlb(m_page_directory.ptr(), vaddr(), page_count());
 }
 
 void Region::remap()
@@ -296,6 +401,25 @@ void Region::remap()
     map(*m_page_directory);
 }
 
+void Region::remap_mapped_pages()
+{
+    ASSERT(m_page_directory);
+    InterruptDisabler disabler;
+    for (size_t page_index = 0; page_index < page_count();) {
+        auto vaddr = this->vaddr().offset(page_index * PAGE_SIZE);
+        if (!MM.pde_is_present(*m_page_directory, vaddr)) {
+            page_index += (huge_page_size - vaddr.get() % huge_page_size) / PAGE_SIZE;
+            continue;
+        }
+        // A present directory entry without a page table is a huge page, which gets split here.
+        auto* pte = MM.pte(*m_page_directory, vaddr);
+        if (!pte || pte->is_present())
+            map_individual_page_impl(page_index);
+        ++page_index;
+    }
+    MM.flush_tlb(m_page_directory.ptr(), vaddr(), page_count());
+}
+
 PageFaultResponse Region::handle_fault(const PageFault& fault)
 {
     auto page_index_in_region = page_index_from_address(fault.vaddr());
@@ -314,6 +438,14 @@ PageFaultResponse Region::handle_fault(const PageFault& fault)
 #endif
             return handle_inode_fault(page_index_in_region);
         }
+        if (!physical_page_slot(page_index_in_region).is_null()) {
+            // Regions are only mapped as they're touched after fork(), so the page may already be there.
+#ifdef PAGE_FAULT_DEBUG
+            dbg() << "NP(lazy) fault in Region{" << this << "}[" << page_index_in_region << "]";
+#endif
+            remap_page(page_index_in_region);
+            return PageFaultResponse::Continue;
+        }
 #ifdef MAP_SHARED_ZERO_PAGE_LAZILY
         if (fault.is_read()) {
             physical_page_slot(page_index_in_region) = MM.shared_zero_page();
@@ -362,8 +494,11 @@ PageFaultResponse Region::handle_zero_fault(size_t page_index_in_region)
         return PageFaultResponse::Continue;
     }
 
-    if (Thread::current)
-        Thread::current->did_zero_fault();
+    if (Thread::current())
+        Thread::current()->did_zero_fault();
+
+    if (m_wants_huge_pages && handle_huge_zero_fault(page_index_in_region))
+        return PageFaultResponse::Continue;
 
     auto page = MM.allocate_user_physical_page(MemoryManager::ShouldZeroFill::Yes);
     if (page.is_null()) {
@@ -379,10 +514,82 @@ PageFaultResponse Region::handle_zero_fault(size_t page_index_in_region)
     return PageFaultResponse::Continue;
 }
 
+bool Region::handle_huge_zero_fault(size_t page_index_in_region)
+{
+    ASSERT_INTERRUPTS_DISABLED();
+    if (vmobject().is_purgeable())
+        return false;
+    auto fault_vaddr = vaddr().offset(page_index_in_region * PAGE_SIZE);
+    auto huge_page_vaddr = VirtualAddress(fault_vaddr.get() & ~(huge_page_size - 1));
+    if (huge_page_vaddr < vaddr() || huge_page_vaddr.offset(huge_page_size) > vaddr().offset(size()))
+        return false;
+    size_t first_page_index = page_index_from_address(huge_page_vaddr);
+
+    // Only take over a stretch that nothing has been faulted into yet.
+    for (size_t i = 0; i < pages_per_huge_page; ++i) {
+        auto* page = physical_page(first_page_index + i);
+        if (page && !page->is_shared_zero_page())
+            return false;
+    }
+
+    auto pages = MM.allocate_contiguous_user_physical_pages(pages_per_huge_page, huge_page_size);
+    if (pages.is_empty())
+        return false;
+
+#ifdef PAGE_FAULT_DEBUG
+    dbg() << "      >> HUGE ZERO " << pages[0].paddr() << " for " << huge_page_vaddr;
+#endif
+    for (size_t i = 0; i < pages_per_huge_page; ++i) {
+        physical_page_slot(first_page_index + i) = pages[i];
+        // These pages are ours alone, there's nothing to copy on write.
+        if (m_cow_map)
+            m_cow_map->set(first_page_index + i, false);
+    }
+    bool mapped = map_huge_page_if_possible(first_page_index);
+    ASSERT(mapped);
+    return true;
+}
+
+bool Region::can_map_huge_page(size_t first_page_index) const
+{
+    if (!m_wants_huge_pages || !vmobject().is_anonymous() || vmobject().is_purgeable())
+        return false;
+    if (!is_readable() && !is_writable())
+        return false;
+    auto huge_page_vaddr = vaddr().offset(first_page_index * PAGE_SIZE);
+    if (huge_page_vaddr.get() % huge_page_size || first_page_index + pages_per_huge_page > page_count())
+        return false;
+    auto* first_page = physical_page(first_page_index);
+    if (!first_page || first_page->paddr().get() % huge_page_size)
+        return false;
+    for (size_t i = 0; i < pages_per_huge_page; ++i) {
+        auto* page = physical_page(first_page_index + i);
+        if (!page || page->is_shared_zero_page() || page->paddr() != first_page->paddr().offset(i * PAGE_SIZE))
+            return false;
+        if (should_cow(first_page_index + i))
+            return false;
+    }
+    return true;
+}
+
+bool Region::map_huge_page_if_possible(size_t first_page_index)
+{
+    ASSERT(m_page_directory);
+    if (!can_map_huge_page(first_page_index))
+        return false;
+    auto huge_page_vaddr = vaddr().offset(first_page_index * PAGE_SIZE);
+    MM.map_huge_page(*m_page_directory, huge_page_vaddr, physical_page(first_page_index)->paddr(), is_writable(), is_user_accessible(), is_executable(), m_cacheable);
+    return true;
+}
+
 PageFaultResponse Region::handle_cow_fault(size_t page_index_in_region)
 {
     ASSERT_INTERRUPTS_DISABLED();
     auto& page_slot = physical_page_slot(page_index_in_region);
+    if (vmobject().is_inode()) {
+        // This is a private mapping breaking away from the page cache, so the page can't just be read back in anymore.
+        static_cast<InodeVMObject&>(vmobject()).set_page_dirty(first_page_index() + page_index_in_region, true);
+    }
     if (page_slot->ref_count() == 1) {
 #ifdef PAGE_FAULT_DEBUG
         dbg() << "    >> It's a COW page but nobody is sharing it anymore. Remap r/w";
@@ -392,8 +599,8 @@ PageFaultResponse Region::handle_cow_fault(size_t page_index_in_region)
         return PageFaultResponse::Continue;
     }
 
-    if (Thread::current)
-        Thread::current->did_cow_fault();
+    if (Thread::current())
+        Thread::current()->did_cow_fault();
 
 #ifdef PAGE_FAULT_DEBUG
     dbg() << "    >> It's a COW page and it's time to COW!";
@@ -417,6 +624,22 @@ PageFaultResponse Region::handle_cow_fault(size_t page_index_in_region)
     return PageFaultResponse::Continue;
 }
 
+KResult Region::share_page_cache_page(size_t page_index_in_region)
+{
+    ASSERT(!m_shared);
+    auto& inode_vmobject = static_cast<InodeVMObject&>(vmobject());
+    auto page_or_error = inode_vmobject.inode().page_cache_page(first_page_index() + page_index_in_region);
+    if (page_or_error.is_error())
+        return page_or_error.error();
+    InterruptDisabler disabler;
+    auto& page_slot = physical_page_slot(page_index_in_region);
+    if (page_slot.is_null()) {
+        page_slot = page_or_error.value();
+        set_should_cow(page_index_in_region, true);
+    }
+    return KSuccess;
+}
+
 PageFaultResponse Region::handle_inode_fault(size_t page_index_in_region)
 {
     ASSERT_INTERRUPTS_DISABLED();
@@ -441,16 +664,54 @@ PageFaultResponse Region::handle_inode_fault(size_t page_index_in_region)
         return PageFaultResponse::Continue;
     }
 
-    if (Thread::current)
-        Thread::current->did_inode_fault();
+    if (Thread::current())
+        Thread::current()->did_inode_fault();
 
 #ifdef MM_DEBUG
     dbg() << "MM: page_in_from_inode ready to read from inode";
 #endif
+    size_t page_index_in_vmobject = first_page_index() + page_index_in_region;
+    if (inode_vmobject.is_shared_inode()) {
+        // The shared VMObject is the inode's page cache, so we can use (or fill) its page directly.
+        sti();
+        auto page_or_error = inode_vmobject.ensure_physical_page(page_index_in_vmobject);
+        cli();
+        if (page_or_error.is_error()) {
+            if (page_or_error.error() == -ENOMEM) {
+                klog() << "MM: handle_inode_fault was unable to allocate a physical page";
+                return PageFaultResponse::OutOfMemory;
+            }
+            klog() << "MM: handle_inode_fault had error (" << page_or_error.error() << ") while reading!";
+            return PageFaultResponse::ShouldCrash;
+        }
+        remap_page(page_index_in_region);
+        return PageFaultResponse::Continue;
+    }
+
+    auto& inode = inode_vmobject.inode();
+    if (inode.is_page_cacheable()) {
+        sti();
+        auto result = share_page_cache_page(page_index_in_region);
+        cli();
+        if (result.is_success()) {
+            remap_page(page_index_in_region);
+            return PageFaultResponse::Continue;
+        }
+        if (result.error() == -ENOMEM) {
+            klog() << "MM: handle_inode_fault was unable to allocate a physical page";
+            return PageFaultResponse::OutOfMemory;
+        }
+        // The page cache hasn't caught up with the inode's size, so make a copy of our own.
+        if (result.error() != -EINVAL) {
+            klog() << "MM: handle_inode_fault had error (" << result.error() << ") while reading!";
+            return PageFaultResponse::ShouldCrash;
+        }
+    }
+
+    // Private mappings of inodes without a page cache get their own copy right away.
     sti();
     u8 page_buffer[PAGE_SIZE];
-    auto& inode = inode_vmobject.inode();
-    auto nread = inode.read_bytes((first_page_index() + page_index_in_region) * PAGE_SIZE, PAGE_SIZE, page_buffer, nullptr);
+    auto nread = inode.read_bytes_through_page_cache(page_index_in_vmobject * PAGE_SIZE, PAGE_SIZE, page_buffer, nullptr);
     if (nread < 0) {
         klog() << "MM: handle_inode_fault had error (" << nread << ") while reading!";
         return PageFaultResponse::ShouldCrash;
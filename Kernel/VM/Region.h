@@ -29,7 +29,8 @@
 #include <AK/InlineLinkedList.h>
 #include <AK/String.h>
 #include <AK/Weakable.h>
-#include <Kernel/Heap/SlabAllocator.h>
+#include <Kernel/Heap/ObjectCache.h>
+#include <Kernel/KResult.h>
 #include <Kernel/VM/RangeAllocator.h>
 #include <Kernel/VM/VMObject.h>
 
@@ -49,7 +50,7 @@ class Region final
     , public Weakable<Region> {
     friend class MemoryManager;
 
-    MAKE_SLAB_ALLOCATED(Region)
+    MAKE_OBJECT_CACHED(Region)
 public:
     enum Access {
         Read = 1,
@@ -92,6 +93,10 @@ public:
     bool is_mmap() const { return m_mmap; }
     void set_mmap(bool mmap) { m_mmap = mmap; }
 
+    // Anonymous memory in such regions is faulted in, and mapped, 2 MiB at a time where possible.
+    bool wants_huge_pages() const { return m_wants_huge_pages; }
+    void set_wants_huge_pages(bool b) { m_wants_huge_pages = b; }
+
     bool is_user_accessible() const { return m_user_accessible; }
     void set_user_accessible(bool b) { m_user_accessible = b; }
 
@@ -149,6 +154,12 @@ public:
     bool commit();
     bool commit(size_t page_index);
 
+    // Reads in (or allocates) and maps the given pages up front, so touching them won't fault.
+    void prefault(size_t first_page_index, size_t page_count);
+    // Drops the given pages: private anonymous memory reads back as zeroes and private file
+    // mappings revert to the file contents. Shared mappings only lose their page table entries.
+    void discard_pages(size_t first_page_index, size_t page_count);
+
     size_t amount_resident() const;
     size_t amount_shared() const;
     size_t amount_dirty() const;
@@ -171,6 +182,8 @@ public:
     void unmap(ShouldDeallocateVirtualMemoryRange = ShouldDeallocateVirtualMemoryRange::Yes);
 
     void remap();
+    // Like remap(), but leaves pages that aren't mapped yet to the page fault handler.
+    void remap_mapped_pages();
     void remap_page(size_t index);
 
     // For InlineLinkedListNode
@@ -194,10 +207,16 @@ private:
     }
 
     PageFaultResponse handle_cow_fault(size_t page_index);
+    // Installs the inode's page cache page in our (private) slot, copy-on-write. Call this with the paging lock held.
+    KResult share_page_cache_page(size_t page_index);
     PageFaultResponse handle_inode_fault(size_t page_index);
     PageFaultResponse handle_zero_fault(size_t page_index);
+    bool handle_huge_zero_fault(size_t page_index);
 
+    // Doesn't flush the TLB; callers do that once for the whole range they touched.
     void map_individual_page_impl(size_t page_index);
+    bool can_map_huge_page(size_t first_page_index) const;
+    bool map_huge_page_if_possible(size_t first_page_index);
 
     RefPtr<PageDirectory> m_page_directory;
     Range m_range;
@@ -211,6 +230,7 @@ private:
     bool m_cacheable : 1 { false };
     bool m_stack : 1 { false };
     bool m_mmap : 1 { false };
+    bool m_wants_huge_pages : 1 { false };
     mutable OwnPtr<Bitmap> m_cow_map;
 };
 
@@ -62,6 +62,8 @@ public:
 
     size_t size() const { return m_physical_pages.size() * PAGE_SIZE; }
 
+    Lock& paging_lock() { return m_paging_lock; }
+
     virtual const char* class_name() const = 0;
 
     // For InlineLinkedListNode
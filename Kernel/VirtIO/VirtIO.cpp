@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2018-2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <Kernel/VirtIO/VirtIO.h>
+
+namespace Kernel {
+
+VirtIODevice::VirtIODevice(PCI::Address address)
+    : PCI::Device(address)
+    , m_io_base(PCI::get_BAR0(pci_address()) & ~1)
+{
+    disable_irq();
+    PCI::enable_bus_mastering(pci_address());
+    PCI::enable_interrupt_line(pci_address());
+}
+
+VirtIODevice::~VirtIODevice()
+{
+}
+
+u32 VirtIODevice::begin_initialization()
+{
+    set_status(0);
+    set_status(VIRTIO_STATUS_ACKNOWLEDGE);
+    set_status(VIRTIO_STATUS_ACKNOWLEDGE | VIRTIO_STATUS_DRIVER);
+    return m_io_base.offset(REG_DEVICE_FEATURES).in<u32>();
+}
+
+void VirtIODevice::accept_features(u32 features)
+{
+    m_accepted_features = features;
+    m_io_base.offset(REG_GUEST_FEATURES).out<u32>(features);
+}
+
+bool VirtIODevice::setup_queues(size_t queue_count)
+{
+    for (size_t i = 0; i < queue_count; ++i) {
+        m_io_base.offset(REG_QUEUE_SELECT).out<u16>(i);
+        u16 queue_size = m_io_base.offset(REG_QUEUE_SIZE).in<u16>();
+        if (!queue_size) {
+            klog() << "VirtIODevice: " << purpose() << " @ " << pci_address() << " has no queue " << i;
+            return false;
+        }
+        auto queue = VirtIOQueue::create(queue_size);
+        if (!queue)
+            return false;
+        // Legacy devices take the page frame number of the queue, and get to pick its size themselves.
+        m_io_base.offset(REG_QUEUE_ADDRESS).out<u32>(queue->paddr().get() >> 12);
+        m_queues.append(queue.release_nonnull());
+    }
+    return true;
+}
+
+void VirtIODevice::finish_initialization()
+{
+    set_status(status() | VIRTIO_STATUS_DRIVER_OK);
+    enable_irq();
+}
+
+void VirtIODevice::fail_initialization()
+{
+    set_status(status() | VIRTIO_STATUS_FAILED);
+}
+
+void VirtIODevice::notify_queue(u16 index)
+{
+    if (!queue(index).should_notify())
+        return;
+    m_io_base.offset(REG_QUEUE_NOTIFY).out<u16>(index);
+}
+
+void VirtIODevice::handle_irq(const RegisterState&)
+{
+    // Reading the ISR status acknowledges the interrupt.
+    u8 isr_status = m_io_base.offset(REG_ISR_STATUS).in<u8>();
+    if (isr_status & VIRTIO_ISR_DEVICE_CONFIG_INTERRUPT)
+        handle_device_config_change();
+    if (isr_status & VIRTIO_ISR_QUEUE_INTERRUPT)
+        handle_queue_update();
+}
+
+}
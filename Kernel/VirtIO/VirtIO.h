@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2018-2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+//
+// VirtIO PCI transport
+//
+// Paravirtualized devices as provided by QEMU/KVM and other hypervisors. The guest and the
+// host share rings of buffer descriptors (virtqueues), so a request costs one register write
+// to notify the device instead of a VM exit for every register of an emulated controller.
+//
+// We only speak the legacy (virtio 0.9.5) interface through I/O BAR0, which is what the
+// transitional devices QEMU creates by default offer.
+//
+// More information about VirtIO can be found here:
+//      https://docs.oasis-open.org/virtio/virtio/v1.1/virtio-v1.1.html
+//
+
+#pragma once
+
+#include <AK/NonnullOwnPtrVector.h>
+#include <Kernel/IO.h>
+#include <Kernel/PCI/Access.h>
+#include <Kernel/PCI/Device.h>
+#include <Kernel/VirtIO/VirtIOQueue.h>
+
+namespace Kernel {
+
+#define VIRTIO_PCI_VENDOR_ID 0x1af4
+#define VIRTIO_PCI_DEVICE_ID_NETWORK 0x1000
+#define VIRTIO_PCI_DEVICE_ID_BLOCK 0x1001
+
+#define VIRTIO_STATUS_ACKNOWLEDGE 1
+#define VIRTIO_STATUS_DRIVER 2
+#define VIRTIO_STATUS_DRIVER_OK 4
+#define VIRTIO_STATUS_FAILED 128
+
+#define VIRTIO_ISR_QUEUE_INTERRUPT 1
+#define VIRTIO_ISR_DEVICE_CONFIG_INTERRUPT 2
+
+class VirtIODevice : public PCI::Device {
+public:
+    virtual ~VirtIODevice() override;
+
+protected:
+    explicit VirtIODevice(PCI::Address);
+
+    // Resets the device and tells it we're here. Returns the features it offers.
+    u32 begin_initialization();
+    // Accepts those of the offered features that we support.
+    void accept_features(u32 features);
+    bool is_feature_accepted(u32 feature_bit) const { return m_accepted_features & (1u << feature_bit); }
+    bool setup_queues(size_t queue_count);
+    void finish_initialization();
+    void fail_initialization();
+
+    size_t queue_count() const { return m_queues.size(); }
+    VirtIOQueue& queue(size_t index) { return m_queues[index]; }
+    void notify_queue(u16 index);
+
+    u8 config_read8(u32 offset) { return m_io_base.offset(device_config_offset + offset).in<u8>(); }
+    u16 config_read16(u32 offset) { return m_io_base.offset(device_config_offset + offset).in<u16>(); }
+    u32 config_read32(u32 offset) { return m_io_base.offset(device_config_offset + offset).in<u32>(); }
+    u64 config_read64(u32 offset) { return (u64)config_read32(offset) | ((u64)config_read32(offset + 4) << 32); }
+
+    // Called from the interrupt handler.
+    virtual void handle_queue_update() = 0;
+    virtual void handle_device_config_change() { }
+
+private:
+    //^ IRQHandler
+    virtual void handle_irq(const RegisterState&) override;
+
+    void set_status(u8 status) { m_io_base.offset(REG_DEVICE_STATUS).out<u8>(status); }
+    u8 status() { return m_io_base.offset(REG_DEVICE_STATUS).in<u8>(); }
+
+    enum Register {
+        REG_DEVICE_FEATURES = 0x00,
+        REG_GUEST_FEATURES = 0x04,
+        REG_QUEUE_ADDRESS = 0x08,
+        REG_QUEUE_SIZE = 0x0c,
+        REG_QUEUE_SELECT = 0x0e,
+        REG_QUEUE_NOTIFY = 0x10,
+        REG_DEVICE_STATUS = 0x12,
+        REG_ISR_STATUS = 0x13,
+    };
+    // This is where the device specific configuration starts as long as MSI-X is disabled.
+    static constexpr u32 device_config_offset = 0x14;
+
+    IOAddress m_io_base;
+    u32 m_accepted_features { 0 };
+    NonnullOwnPtrVector<VirtIOQueue> m_queues;
+};
+
+}
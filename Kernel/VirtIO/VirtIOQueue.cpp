@@ -0,0 +1,151 @@
+/*
+ * Copyright (c) 2018-2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/Memory.h>
+#include <AK/StringView.h>
+#include <Kernel/Arch/i386/CPU.h>
+#include <Kernel/VM/MemoryManager.h>
+#include <Kernel/VirtIO/VirtIOQueue.h>
+
+namespace Kernel {
+
+static size_t driver_area_offset(u16 queue_size)
+{
+    return sizeof(VirtIOQueueDescriptor) * queue_size;
+}
+
+static size_t device_area_offset(u16 queue_size)
+{
+    return PAGE_ROUND_UP(driver_area_offset(queue_size) + sizeof(VirtIOQueueDriver) + sizeof(u16) * (queue_size + 1));
+}
+
+size_t VirtIOQueue::size_in_bytes(u16 queue_size)
+{
+    return device_area_offset(queue_size) + PAGE_ROUND_UP(sizeof(VirtIOQueueDevice) + sizeof(VirtIOQueueDeviceItem) * queue_size + sizeof(u16));
+}
+
+OwnPtr<VirtIOQueue> VirtIOQueue::create(u16 queue_size)
+{
+    auto region = MM.allocate_contiguous_kernel_region(size_in_bytes(queue_size), "VirtIO Queue", Region::Access::Read | Region::Access::Write);
+    if (!region)
+        return nullptr;
+    return make<VirtIOQueue>(queue_size, region.release_nonnull());
+}
+
+VirtIOQueue::VirtIOQueue(u16 queue_size, NonnullOwnPtr<Region> region)
+    : m_queue_size(queue_size)
+    , m_free_descriptor_count(queue_size)
+    , m_region(move(region))
+{
+    u8* base = m_region->vaddr().as_ptr();
+    memset(base, 0, size_in_bytes(queue_size));
+    m_descriptors = reinterpret_cast<VirtIOQueueDescriptor*>(base);
+    m_driver = reinterpret_cast<VirtIOQueueDriver*>(base + driver_area_offset(queue_size));
+    m_device = reinterpret_cast<VirtIOQueueDevice*>(base + device_area_offset(queue_size));
+
+    // The free descriptors are kept chained together through their next fields.
+    for (u16 i = 0; i + 1 < queue_size; ++i)
+        m_descriptors[i].next = i + 1;
+    m_tokens.resize(queue_size);
+}
+
+bool VirtIOQueue::supply_buffers(const VirtIOBuffer* buffers, size_t count, void* token)
+{
+    ASSERT(count);
+    if (count > m_free_descriptor_count)
+        return false;
+
+    u16 head = m_free_head;
+    u16 descriptor_index = head;
+    for (size_t i = 0; i < count; ++i) {
+        auto& descriptor = m_descriptors[descriptor_index];
+        descriptor.address = buffers[i].paddr.get();
+        descriptor.length = buffers[i].length;
+        descriptor.flags = buffers[i].device_writable ? VIRTQ_DESC_F_WRITE : 0;
+        if (i + 1 < count) {
+            descriptor.flags |= VIRTQ_DESC_F_NEXT;
+            descriptor_index = descriptor.next;
+        }
+    }
+    m_free_head = m_descriptors[descriptor_index].next;
+    m_free_descriptor_count -= count;
+    m_tokens[head] = token;
+
+    m_driver->rings[m_driver->index % m_queue_size] = head;
+    // The device must see the descriptors and the ring entry before the index that publishes them.
+    memory_barrier();
+    m_driver->index++;
+    memory_barrier();
+    return true;
+}
+
+bool VirtIOQueue::has_used_buffers() const
+{
+    return m_used_tail != *(volatile u16*)&m_device->index;
+}
+
+void* VirtIOQueue::pop_used_buffers(u32& written_length)
+{
+    if (!has_used_buffers())
+        return nullptr;
+    memory_barrier();
+    auto& item = m_device->rings[m_used_tail % m_queue_size];
+    u16 head = item.index;
+    written_length = item.length;
+    m_used_tail++;
+
+    // Put the whole chain back on the free list.
+    u16 tail = head;
+    size_t count = 1;
+    while (m_descriptors[tail].flags & VIRTQ_DESC_F_NEXT) {
+        tail = m_descriptors[tail].next;
+        ++count;
+    }
+    m_descriptors[tail].next = m_free_head;
+    m_free_head = head;
+    m_free_descriptor_count += count;
+
+    void* token = m_tokens[head];
+    m_tokens[head] = nullptr;
+    return token;
+}
+
+bool VirtIOQueue::should_notify() const
+{
+    memory_barrier();
+    return !(*(volatile u16*)&m_device->flags & VIRTQ_USED_F_NO_NOTIFY);
+}
+
+void VirtIOQueue::set_interrupts_enabled(bool enabled)
+{
+    if (enabled)
+        m_driver->flags &= ~VIRTQ_AVAIL_F_NO_INTERRUPT;
+    else
+        m_driver->flags |= VIRTQ_AVAIL_F_NO_INTERRUPT;
+    memory_barrier();
+}
+
+}
@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2018-2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/NonnullOwnPtr.h>
+#include <AK/Vector.h>
+#include <Kernel/PhysicalAddress.h>
+#include <Kernel/VM/PhysicalPage.h>
+#include <Kernel/VM/Region.h>
+
+namespace Kernel {
+
+#define VIRTQ_DESC_F_NEXT 1
+#define VIRTQ_DESC_F_WRITE 2
+
+#define VIRTQ_AVAIL_F_NO_INTERRUPT 1
+#define VIRTQ_USED_F_NO_NOTIFY 1
+
+struct VirtIOQueueDescriptor {
+    u64 address;
+    u32 length;
+    u16 flags;
+    u16 next;
+};
+
+struct VirtIOQueueDriver {
+    u16 flags;
+    u16 index;
+    u16 rings[];
+};
+
+struct VirtIOQueueDeviceItem {
+    u32 index;
+    u32 length;
+};
+
+struct VirtIOQueueDevice {
+    u16 flags;
+    u16 index;
+    VirtIOQueueDeviceItem rings[];
+};
+
+// One physically contiguous piece of a request, as the device sees it.
+struct VirtIOBuffer {
+    PhysicalAddress paddr;
+    u32 length { 0 };
+    bool device_writable { false };
+};
+
+// A split virtqueue, laid out the way the legacy PCI interface wants it: the descriptor table and the
+// available ring, followed by the used ring on the next page boundary.
+class VirtIOQueue {
+public:
+    static OwnPtr<VirtIOQueue> create(u16 queue_size);
+    VirtIOQueue(u16 queue_size, NonnullOwnPtr<Region>);
+
+    u16 size() const { return m_queue_size; }
+    PhysicalAddress paddr() const { return m_region->physical_page(0)->paddr(); }
+    size_t free_descriptor_count() const { return m_free_descriptor_count; }
+
+    // Chains the buffers together and makes them available to the device. The token
+    // comes back out of pop_used_buffers() once the device is done with them.
+    bool supply_buffers(const VirtIOBuffer*, size_t count, void* token);
+    bool has_used_buffers() const;
+    void* pop_used_buffers(u32& written_length);
+
+    bool should_notify() const;
+    void set_interrupts_enabled(bool);
+
+    static size_t size_in_bytes(u16 queue_size);
+
+private:
+    u16 m_queue_size { 0 };
+    u16 m_free_head { 0 };
+    u16 m_free_descriptor_count { 0 };
+    u16 m_used_tail { 0 };
+
+    NonnullOwnPtr<Region> m_region;
+    VirtIOQueueDescriptor* m_descriptors { nullptr };
+    VirtIOQueueDriver* m_driver { nullptr };
+    VirtIOQueueDevice* m_device { nullptr };
+    Vector<void*> m_tokens;
+};
+
+}
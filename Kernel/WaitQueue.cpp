@@ -55,19 +55,26 @@ void WaitQueue::wake_one(Atomic<bool>* lock)
     Scheduler::stop_idling();
 }
 
-void WaitQueue::wake_n(i32 wake_count)
+i32 WaitQueue::wake_n(i32 wake_count, u32 bitset)
 {
     InterruptDisabler disabler;
     if (m_threads.is_empty())
-        return;
+        return 0;
 
-    for (i32 i = 0; i < wake_count; ++i) {
-        Thread* thread = m_threads.take_first();
-        if (!thread)
-            break;
-        thread->wake_from_queue();
+    i32 woken_count = 0;
+    for (auto it = m_threads.begin(); it != m_threads.end() && woken_count < wake_count;) {
+        auto& thread = *it;
+        if (!(thread.m_wait_queue_bitset & bitset)) {
+            ++it;
+            continue;
+        }
+        it.erase();
+        thread.wake_from_queue();
+        ++woken_count;
     }
-    Scheduler::stop_idling();
+    if (woken_count)
+        Scheduler::stop_idling();
+    return woken_count;
 }
 
 void WaitQueue::wake_all()
@@ -80,6 +87,20 @@ void WaitQueue::wake_all()
     Scheduler::stop_idling();
 }
 
+i32 WaitQueue::requeue_n(WaitQueue& target, i32 requeue_count)
+{
+    InterruptDisabler disabler;
+    i32 requeued_count = 0;
+    while (requeued_count < requeue_count) {
+        auto* thread = m_threads.take_first();
+        if (!thread)
+            break;
+        target.m_threads.append(*thread);
+        ++requeued_count;
+    }
+    return requeued_count;
+}
+
 void WaitQueue::clear()
 {
     InterruptDisabler disabler;
@@ -39,8 +39,11 @@ public:
 
     void enqueue(Thread&);
     void wake_one(Atomic<bool>* lock = nullptr);
-    void wake_n(i32 wake_count);
+    // Only threads whose wait bitset shares a bit with the given one are woken. Returns how many were.
+    i32 wake_n(i32 wake_count, u32 bitset = 0xffffffff);
     void wake_all();
+    // Moves up to requeue_count sleeping threads onto another queue without waking them.
+    i32 requeue_n(WaitQueue& target, i32 requeue_count);
     void clear();
 
 private:
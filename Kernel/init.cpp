@@ -32,6 +32,9 @@
 #include <Kernel/Arch/i386/CPU.h>
 #include <Kernel/CMOS.h>
 #include <Kernel/CommandLine.h>
+#include <Kernel/Devices/AC97.h>
+#include <Kernel/Devices/AHCIController.h>
+#include <Kernel/Devices/AHCIDiskDevice.h>
 #include <Kernel/Devices/BXVGADevice.h>
 #include <Kernel/Devices/DiskPartition.h>
 #include <Kernel/Devices/EBRPartitionTable.h>
@@ -40,12 +43,14 @@
 #include <Kernel/Devices/KeyboardDevice.h>
 #include <Kernel/Devices/MBRPartitionTable.h>
 #include <Kernel/Devices/MBVGADevice.h>
+#include <Kernel/Devices/MemoryPressureDevice.h>
 #include <Kernel/Devices/NullDevice.h>
 #include <Kernel/Devices/PATAChannel.h>
 #include <Kernel/Devices/PATADiskDevice.h>
 #include <Kernel/Devices/PS2MouseDevice.h>
 #include <Kernel/Devices/RandomDevice.h>
 #include <Kernel/Devices/SB16.h>
+#include <Kernel/Devices/VirtIOBlockDevice.h>
 #include <Kernel/Devices/SerialDevice.h>
 #include <Kernel/Devices/VMWareBackdoor.h>
 #include <Kernel/Devices/ZeroDevice.h>
@@ -62,6 +67,7 @@
 #include <Kernel/Net/LoopbackAdapter.h>
 #include <Kernel/Net/NetworkTask.h>
 #include <Kernel/Net/RTL8139NetworkAdapter.h>
+#include <Kernel/Net/VirtIONetworkAdapter.h>
 #include <Kernel/PCI/Access.h>
 #include <Kernel/PCI/Initializer.h>
 #include <Kernel/Process.h>
@@ -102,6 +108,10 @@ VirtualConsole* tty0;
 
 extern "C" [[noreturn]] void init()
 {
+    // NOTE: This comes first, since everything that wants to know the current thread
+    //       goes through the per-CPU data that gdt_init() sets up.
+    gdt_init();
+
     setup_serial_debug();
 
     cpu_setup();
@@ -112,8 +122,8 @@ extern "C" [[noreturn]] void init()
     CommandLine::initialize(reinterpret_cast<const char*>(low_physical_to_virtual(multiboot_info_ptr->cmdline)));
 
     MemoryManager::initialize();
+    kmalloc_enable_expansion();
 
-    gdt_init();
     idt_init();
 
     // Invoke all static global constructors in the kernel.
@@ -136,6 +146,7 @@ extern "C" [[noreturn]] void init()
     TimeManagement::initialize();
 
     new NullDevice;
+    new MemoryPressureDevice;
     if (!get_serial_debug())
         new SerialDevice(SERIAL_COM1_ADDR, 64);
     new SerialDevice(SERIAL_COM2_ADDR, 65);
@@ -153,11 +164,27 @@ extern "C" [[noreturn]] void init()
     Thread* init_stage2_thread = nullptr;
     Process::create_kernel_process(init_stage2_thread, "init_stage2", init_stage2);
 
-    Scheduler::pick_next();
+    // The BSP enters its idle thread, which lets go of the kernel lock again.
+    Processor::lock_kernel();
+    Scheduler::pick_next_and_switch_now();
+    ASSERT_NOT_REACHED();
+}
+
+// Application processors come here from the startup code in APIC.cpp.
+// They haven't touched any per-CPU data yet, so not even logging works until Processor::initialize().
+extern "C" [[noreturn]] void init_ap(u32 cpu, Processor* processor)
+{
+    processor->initialize(cpu);
+    flush_idt();
+    processor->set_online();
 
-    sti();
+    Processor::lock_kernel();
+    klog() << "CPU #" << cpu << " is online";
+    cpu_setup();
+    APIC::enable(cpu);
+    APIC::enable_timer();
 
-    Scheduler::idle_loop();
+    Scheduler::initialize_ap();
     ASSERT_NOT_REACHED();
 }
 
@@ -166,6 +193,9 @@ void init_stage2()
     SyncTask::spawn();
     FinalizerTask::spawn();
 
+    if (InterruptManagement::the().smp_enabled() && APIC::is_initialized())
+        APIC::boot_aps(InterruptManagement::the().processor_count());
+
     PCI::initialize();
 
     bool text_mode = kernel_command_line().lookup("boot_mode").value_or("graphical") == "text";
@@ -187,7 +217,8 @@ void init_stage2()
                     PhysicalAddress((u32)(multiboot_info_ptr->framebuffer_addr)),
                     multiboot_info_ptr->framebuffer_pitch,
                     multiboot_info_ptr->framebuffer_width,
-                    multiboot_info_ptr->framebuffer_height);
+                    multiboot_info_ptr->framebuffer_height,
+                    multiboot_info_ptr->framebuffer_bpp);
             } else {
                 new BXVGADevice;
             }
@@ -196,6 +227,7 @@ void init_stage2()
 
     E1000NetworkAdapter::detect();
     RTL8139NetworkAdapter::detect();
+    VirtIONetworkAdapter::detect();
 
     LoopbackAdapter::the();
 
@@ -205,7 +237,8 @@ void init_stage2()
     new FullDevice;
     new RandomDevice;
     new PTYMultiplexer;
-    new SB16;
+    if (!AC97::detect())
+        new SB16;
     VMWareBackdoor::initialize();
 
     bool dmi_unreliable = kernel_command_line().contains("dmi_unreliable");
@@ -219,15 +252,35 @@ void init_stage2()
 
     auto root = kernel_command_line().lookup("root").value_or("/dev/hda");
 
-    if (!root.starts_with("/dev/hda")) {
-        klog() << "init_stage2: root filesystem must be on the first IDE hard drive (/dev/hda)";
+    auto pata0 = PATAChannel::create(PATAChannel::ChannelType::Primary, force_pio);
+    auto ahci = AHCIController::detect();
+    auto virtio_disks = VirtIOBlockDevice::detect();
+
+    RefPtr<BlockDevice> root_device;
+    const char* root_device_prefix = nullptr;
+    if (root.starts_with("/dev/hda")) {
+        root_device_prefix = "/dev/hda";
+        root_device = pata0->master_device();
+    } else if (root.starts_with("/dev/sda")) {
+        root_device_prefix = "/dev/sda";
+        if (ahci && !ahci->disks().is_empty())
+            root_device = ahci->disks().first();
+    } else if (root.starts_with("/dev/vda")) {
+        root_device_prefix = "/dev/vda";
+        if (!virtio_disks.is_empty())
+            root_device = virtio_disks.first();
+    } else {
+        klog() << "init_stage2: root filesystem must be on the first IDE hard drive (/dev/hda), the first SATA disk (/dev/sda) or the first virtio disk (/dev/vda)";
         hang();
     }
 
-    auto pata0 = PATAChannel::create(PATAChannel::ChannelType::Primary, force_pio);
-    NonnullRefPtr<BlockDevice> root_dev = *pata0->master_device();
+    if (!root_device) {
+        klog() << "init_stage2: couldn't find the root device " << root_device_prefix;
+        hang();
+    }
+    NonnullRefPtr<BlockDevice> root_dev = root_device.release_nonnull();
 
-    root = root.substring(strlen("/dev/hda"), root.length() - strlen("/dev/hda"));
+    root = root.substring(strlen(root_device_prefix), root.length() - strlen(root_device_prefix));
 
     if (root.length()) {
         bool ok;
@@ -297,7 +350,7 @@ void init_stage2()
         hang();
     }
 
-    Process::current->set_root_directory(VFS::the().root_custody());
+    Process::current()->set_root_directory(VFS::the().root_custody());
 
     load_kernel_symbol_table();
 
@@ -316,7 +369,7 @@ void init_stage2()
 
     NetworkTask::spawn();
 
-    Process::current->sys$exit(0);
+    Process::current()->sys$exit(0);
     ASSERT_NOT_REACHED();
 }
 
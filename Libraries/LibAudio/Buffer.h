@@ -26,11 +26,11 @@
 
 #pragma once
 
+#include <AK/Atomic.h>
 #include <AK/ByteBuffer.h>
-#include <AK/SharedBuffer.h>
+#include <AK/RefCounted.h>
 #include <AK/Types.h>
 #include <AK/Vector.h>
-#include <string.h>
 
 namespace Audio {
 
@@ -106,6 +106,7 @@ private:
 };
 
 // A buffer of audio samples, normalized to 44100hz.
+// It lives in this process only: ClientConnection copies the samples into the ring it shares with AudioServer.
 class Buffer : public RefCounted<Buffer> {
 public:
     static RefPtr<Buffer> from_pcm_data(ByteBuffer& data, ResampleHelper& resampler, int num_channels, int bits_per_sample);
@@ -113,34 +114,28 @@ public:
     {
         return adopt(*new Buffer(move(samples)));
     }
-    static NonnullRefPtr<Buffer> create_with_shared_buffer(NonnullRefPtr<SharedBuffer>&& buffer, int sample_count)
-    {
-        return adopt(*new Buffer(move(buffer), sample_count));
-    }
 
-    const Sample* samples() const { return (const Sample*)data(); }
-    int sample_count() const { return m_sample_count; }
-    const void* data() const { return m_buffer->data(); }
-    int size_in_bytes() const { return m_sample_count * (int)sizeof(Sample); }
-    int shbuf_id() const { return m_buffer->shbuf_id(); }
-    SharedBuffer& shared_buffer() { return *m_buffer; }
+    const Sample* samples() const { return m_samples.data(); }
+    int sample_count() const { return m_samples.size(); }
+    const void* data() const { return m_samples.data(); }
+    int size_in_bytes() const { return sample_count() * (int)sizeof(Sample); }
+    // Unique within the process, so clients can tell which of their buffers is playing.
+    int id() const { return m_id; }
 
 private:
     explicit Buffer(Vector<Sample>&& samples)
-        : m_buffer(*SharedBuffer::create_with_size(samples.size() * sizeof(Sample)))
-        , m_sample_count(samples.size())
+        : m_samples(move(samples))
+        , m_id(allocate_id())
     {
-        memcpy(m_buffer->data(), samples.data(), samples.size() * sizeof(Sample));
     }
 
-    explicit Buffer(NonnullRefPtr<SharedBuffer>&& buffer, int sample_count)
-        : m_buffer(move(buffer))
-        , m_sample_count(sample_count)
+    static int allocate_id()
     {
+        static Atomic<int> s_next_id;
+        return s_next_id++;
     }
 
-    NonnullRefPtr<SharedBuffer> m_buffer;
-    const int m_sample_count;
+    const Vector<Sample> m_samples;
+    const int m_id;
 };
-
 }
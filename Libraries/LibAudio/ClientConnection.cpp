@@ -24,8 +24,6 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
-#include <AK/SharedBuffer.h>
-#include <LibAudio/Buffer.h>
 #include <LibAudio/ClientConnection.h>
 
 namespace Audio {
@@ -41,22 +39,83 @@ void ClientConnection::handshake()
     set_my_client_id(response->client_id());
 }
 
+SampleRing& ClientConnection::ring()
+{
+    if (!m_ring) {
+        auto response = send_sync<Messages::AudioServer::GetSampleRing>();
+        m_ring = SampleRing::create_from_shbuf_id(response->shbuf_id(), response->capacity());
+        ASSERT(m_ring);
+        m_enqueued_position = m_ring->write_position();
+        m_played_base_position = m_ring->read_position();
+    }
+    return *m_ring;
+}
+
+void ClientConnection::forget_played_buffers()
+{
+    if (!m_ring)
+        return;
+    u32 read_position = m_ring->read_position();
+    while (!m_queued_buffers.is_empty() && (i32)(m_queued_buffers.first().end_position - read_position) <= 0)
+        m_queued_buffers.take_first();
+}
+
+bool ClientConnection::write_queued_samples()
+{
+    for (auto& queued_buffer : m_queued_buffers) {
+        i32 unwritten_count = queued_buffer.end_position - m_ring->write_position();
+        if (unwritten_count <= 0)
+            continue;
+        auto& buffer = *queued_buffer.buffer;
+        bool server_was_idle = false;
+        u32 written_count = m_ring->write(buffer.samples() + buffer.sample_count() - unwritten_count, unwritten_count, server_was_idle);
+        // The server sleeps when it has nothing to play, and doesn't look at the ring until we wake it up.
+        if (written_count && server_was_idle)
+            post_message(Messages::AudioServer::SamplesAvailable());
+        if (written_count < (u32)unwritten_count)
+            return false;
+    }
+    return true;
+}
+
+void ClientConnection::write_queued_samples_or_wait_for_room()
+{
+    while (!write_queued_samples()) {
+        if (!m_ring->request_space_wakeup())
+            return;
+    }
+}
+
 void ClientConnection::enqueue(const Buffer& buffer)
 {
-    for (;;) {
-        const_cast<Buffer&>(buffer).shared_buffer().share_with(server_pid());
-        auto response = send_sync<Messages::AudioServer::EnqueueBuffer>(buffer.shbuf_id(), buffer.sample_count());
-        if (response->success())
-            break;
-        sleep(1);
+    ring();
+    forget_played_buffers();
+    m_enqueued_position += buffer.sample_count();
+    m_queued_buffers.append({ const_cast<Buffer&>(buffer), m_enqueued_position });
+    while (!write_queued_samples()) {
+        if (!m_ring->request_space_wakeup())
+            wait_for_specific_message<Messages::AudioClient::SampleRingHasSpace>();
     }
 }
 
 bool ClientConnection::try_enqueue(const Buffer& buffer)
 {
-    const_cast<Buffer&>(buffer).shared_buffer().share_with(server_pid());
-    auto response = send_sync<Messages::AudioServer::EnqueueBuffer>(buffer.shbuf_id(), buffer.sample_count());
-    return response->success();
+    ring();
+    forget_played_buffers();
+    write_queued_samples_or_wait_for_room();
+
+    size_t unwritten_buffer_count = 0;
+    for (auto& queued_buffer : m_queued_buffers) {
+        if ((i32)(queued_buffer.end_position - m_ring->write_position()) > 0)
+            ++unwritten_buffer_count;
+    }
+    if (unwritten_buffer_count >= 2)
+        return false;
+
+    m_enqueued_position += buffer.sample_count();
+    m_queued_buffers.append({ const_cast<Buffer&>(buffer), m_enqueued_position });
+    write_queued_samples_or_wait_for_room();
+    return true;
 }
 
 bool ClientConnection::get_muted()
@@ -81,12 +140,16 @@ void ClientConnection::set_main_mix_volume(int volume)
 
 int ClientConnection::get_remaining_samples()
 {
-    return send_sync<Messages::AudioServer::GetRemainingSamples>()->remaining_samples();
+    if (!m_ring)
+        return 0;
+    return max(0, (i32)(m_enqueued_position - m_ring->read_position()));
 }
 
 int ClientConnection::get_played_samples()
 {
-    return send_sync<Messages::AudioServer::GetPlayedSamples>()->played_samples();
+    if (!m_ring)
+        return 0;
+    return m_ring->read_position() - m_played_base_position;
 }
 
 void ClientConnection::set_paused(bool paused)
@@ -97,17 +160,31 @@ void ClientConnection::set_paused(bool paused)
 void ClientConnection::clear_buffer(bool paused)
 {
     send_sync<Messages::AudioServer::ClearBuffer>(paused);
+    m_queued_buffers.clear();
+    if (m_ring) {
+        // The server has dropped everything in the ring, and what's not in there yet is dropped here.
+        m_enqueued_position = m_ring->write_position();
+        m_played_base_position = m_ring->read_position();
+    }
 }
 
 int ClientConnection::get_playing_buffer()
 {
-    return send_sync<Messages::AudioServer::GetPlayingBuffer>()->buffer_id();
+    forget_played_buffers();
+    if (m_queued_buffers.is_empty())
+        return -1;
+    return m_queued_buffers.first().buffer->id();
+}
+
+int ClientConnection::get_underrun_count()
+{
+    return send_sync<Messages::AudioServer::GetUnderrunCount>()->underrun_count();
 }
 
-void ClientConnection::handle(const Messages::AudioClient::FinishedPlayingBuffer& message)
+void ClientConnection::handle(const Messages::AudioClient::SampleRingHasSpace&)
 {
-    if (on_finish_playing_buffer)
-        on_finish_playing_buffer(message.buffer_id());
+    if (m_ring)
+        write_queued_samples_or_wait_for_room();
 }
 
 void ClientConnection::handle(const Messages::AudioClient::MutedStateChanged& message)
@@ -28,12 +28,12 @@
 
 #include <AudioServer/AudioClientEndpoint.h>
 #include <AudioServer/AudioServerEndpoint.h>
+#include <LibAudio/Buffer.h>
+#include <LibAudio/SampleRing.h>
 #include <LibIPC/ServerConnection.h>
 
 namespace Audio {
 
-class Buffer;
-
 class ClientConnection : public IPC::ServerConnection<AudioClientEndpoint, AudioServerEndpoint>
     , public AudioClientEndpoint {
     C_OBJECT(ClientConnection)
@@ -41,7 +41,10 @@ public:
     ClientConnection();
 
     virtual void handshake() override;
+    // Waits until the whole buffer has gone into the ring we share with the server.
     void enqueue(const Buffer&);
+    // Takes the buffer unless the last two are still waiting to go into the ring, which they do as it drains.
+    // That needs our event loop to run.
     bool try_enqueue(const Buffer&);
 
     bool get_muted();
@@ -52,17 +55,40 @@ public:
 
     int get_remaining_samples();
     int get_played_samples();
+    // The id of the buffer that's playing, or -1.
     int get_playing_buffer();
+    // How often our samples ran out before we had more to play.
+    int get_underrun_count();
 
     void set_paused(bool paused);
     void clear_buffer(bool paused = false);
 
-    Function<void(i32 buffer_id)> on_finish_playing_buffer;
     Function<void(bool muted)> on_muted_state_change;
 
 private:
-    virtual void handle(const Messages::AudioClient::FinishedPlayingBuffer&) override;
+    struct QueuedBuffer {
+        NonnullRefPtr<Buffer> buffer;
+        // Where the buffer ends in the ring, as a position like SampleRing's.
+        u32 end_position;
+    };
+
+    SampleRing& ring();
+    void forget_played_buffers();
+    // Puts as much of what's been enqueued into the ring as fits, and returns whether that was all of it.
+    bool write_queued_samples();
+    // Same, but asks the server for a wakeup when it has made room for the rest.
+    void write_queued_samples_or_wait_for_room();
+
+    virtual void handle(const Messages::AudioClient::SampleRingHasSpace&) override;
     virtual void handle(const Messages::AudioClient::MutedStateChanged&) override;
+
+    RefPtr<SampleRing> m_ring;
+    // Buffers that haven't finished playing yet, oldest first. The last ones may not be in the ring yet.
+    Vector<QueuedBuffer> m_queued_buffers;
+    // Where the last enqueued buffer ends in the ring.
+    u32 m_enqueued_position { 0 };
+    // Where the ring was when it was last cleared.
+    u32 m_played_base_position { 0 };
 };
 
 }
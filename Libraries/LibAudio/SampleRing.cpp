@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2018-2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <LibAudio/SampleRing.h>
+#include <string.h>
+
+namespace Audio {
+
+static bool is_valid_capacity(u32 capacity)
+{
+    return capacity && !(capacity & (capacity - 1)) && capacity <= 1u << 20;
+}
+
+RefPtr<SampleRing> SampleRing::create(u32 capacity)
+{
+    ASSERT(is_valid_capacity(capacity));
+    // Fresh shared memory is zeroed, which makes an empty ring.
+    auto buffer = SharedBuffer::create_with_size(samples_offset + capacity * sizeof(Sample));
+    if (!buffer)
+        return nullptr;
+    return adopt(*new SampleRing(buffer.release_nonnull(), capacity));
+}
+
+RefPtr<SampleRing> SampleRing::create_from_shbuf_id(int shbuf_id, u32 capacity)
+{
+    if (!is_valid_capacity(capacity))
+        return nullptr;
+    auto buffer = SharedBuffer::create_from_shbuf_id(shbuf_id);
+    if (!buffer || (size_t)buffer->size() < samples_offset + capacity * sizeof(Sample))
+        return nullptr;
+    return adopt(*new SampleRing(buffer.release_nonnull(), capacity));
+}
+
+u32 SampleRing::write(const Sample* samples, u32 count, bool& reader_was_idle)
+{
+    u32 position = write_position();
+    count = min(count, available_to_write());
+    u32 offset = position & (m_capacity - 1);
+    u32 first_count = min(count, m_capacity - offset);
+    memcpy(this->samples() + offset, samples, first_count * sizeof(Sample));
+    memcpy(this->samples(), samples + first_count, (count - first_count) * sizeof(Sample));
+    header().write_position.store(position + count);
+    // Only looking at the reader's position after publishing ours means that either it sees our samples,
+    // or we see that it has read everything before them.
+    reader_was_idle = read_position() == position;
+    return count;
+}
+
+bool SampleRing::request_space_wakeup()
+{
+    header().writer_wants_wakeup.store(1);
+    return available_to_write() > 0;
+}
+
+bool SampleRing::should_wake_writer()
+{
+    if (!header().writer_wants_wakeup.load() || available_to_write() < m_capacity / 2)
+        return false;
+    return header().writer_wants_wakeup.exchange(0);
+}
+
+}
@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2018-2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#pragma once
+
+#include <AK/Atomic.h>
+#include <AK/NonnullRefPtr.h>
+#include <AK/RefCounted.h>
+#include <AK/SharedBuffer.h>
+#include <LibAudio/Buffer.h>
+
+namespace Audio {
+
+// A ring of samples in memory that a client shares with AudioServer. The client writes samples into it, and
+// the server mixes them straight out of it, so playing audio takes no IPC besides the occasional wakeup.
+// There's one writer and one reader, and each only ever moves its own position forward, so neither takes a lock.
+class SampleRing : public RefCounted<SampleRing> {
+public:
+    // For the server, which owns the ring. The capacity has to be a power of two.
+    static RefPtr<SampleRing> create(u32 capacity);
+    // For the client, once the server has shared the ring with it.
+    static RefPtr<SampleRing> create_from_shbuf_id(int shbuf_id, u32 capacity);
+
+    int shbuf_id() const { return m_buffer->shbuf_id(); }
+    SharedBuffer& shared_buffer() { return *m_buffer; }
+    u32 capacity() const { return m_capacity; }
+
+    // Positions count every frame that went in or out, and wrap around at 2^32. Since the capacity is a power of two,
+    // they wrap around the ring at the same time.
+    u32 write_position() const { return header().write_position.load(); }
+    u32 read_position() const { return header().read_position.load(); }
+
+    // The other side can't make us look outside the ring, however it messes with the positions.
+    u32 available_to_read() const { return min(write_position() - read_position(), m_capacity); }
+    u32 available_to_write() const { return m_capacity - available_to_read(); }
+
+    // For the writer: Copies as many of the samples as fit, and returns how many that was. `reader_was_idle`
+    // is set if the reader had already read everything before, in which case it may need a wakeup.
+    u32 write(const Sample*, u32 count, bool& reader_was_idle);
+
+    // For the writer: Asks for a wakeup once the reader has made room. Returns whether there's room already,
+    // in which case the wakeup may come later than needed, or not at all.
+    bool request_space_wakeup();
+
+    // For the reader: Hands up to `max_count` samples to `callback`, in at most two runs, and then frees their room.
+    template<typename Callback>
+    u32 read(u32 max_count, Callback callback)
+    {
+        u32 position = read_position();
+        u32 count = min(max_count, available_to_read());
+        u32 offset = position & (m_capacity - 1);
+        u32 first_count = min(count, m_capacity - offset);
+        if (first_count)
+            callback(samples() + offset, first_count);
+        if (count > first_count)
+            callback(samples(), count - first_count);
+        header().read_position.store(position + count);
+        return count;
+    }
+
+    // For the reader: Drops everything that has been written so far.
+    void discard() { header().read_position.store(write_position()); }
+
+    // For the reader: Whether the writer asked for a wakeup and there's now enough room to make it worthwhile.
+    // Only says so once per request.
+    bool should_wake_writer();
+
+private:
+    struct Header {
+        Atomic<u32> write_position;
+        Atomic<u32> read_position;
+        Atomic<u32> writer_wants_wakeup;
+    };
+    static constexpr size_t samples_offset = 16;
+    static_assert(sizeof(Header) <= samples_offset);
+
+    SampleRing(NonnullRefPtr<SharedBuffer>&& buffer, u32 capacity)
+        : m_buffer(move(buffer))
+        , m_capacity(capacity)
+    {
+    }
+
+    Header& header() { return *reinterpret_cast<Header*>(m_buffer->data()); }
+    const Header& header() const { return *reinterpret_cast<const Header*>(m_buffer->data()); }
+    Sample* samples() { return reinterpret_cast<Sample*>((u8*)m_buffer->data() + samples_offset); }
+
+    NonnullRefPtr<SharedBuffer> m_buffer;
+    const u32 m_capacity;
+};
+
+}
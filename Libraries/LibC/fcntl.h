@@ -88,6 +88,7 @@ int open(const char* path, int options, ...);
 int creat_with_path_length(const char* path, size_t path_length, mode_t);
 int open_with_path_length(const char* path, size_t path_length, int options, mode_t);
 #define AT_FDCWD -100
+#define AT_SYMLINK_NOFOLLOW 0x100
 int openat(int dirfd, const char* path, int options, ...);
 int openat_with_path_length(int dirfd, const char* path, size_t path_length, int options, mode_t);
 
@@ -30,12 +30,17 @@
 #include <AK/Vector.h>
 #include <LibThread/Lock.h>
 #include <assert.h>
+#include <fcntl.h>
+#include <malloc.h>
 #include <mallocdefs.h>
 #include <serenity.h>
+#include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
 
 // FIXME: Thread safety.
 
@@ -44,6 +49,7 @@
 
 #define MAGIC_PAGE_HEADER 0x42657274
 #define MAGIC_BIGALLOC_HEADER 0x42697267
+#define MAGIC_MEDIUM_ARENA_HEADER 0x4d656469
 #define PAGE_ROUND_UP(x) ((((size_t)(x)) + PAGE_SIZE - 1) & (~(PAGE_SIZE - 1)))
 
 static LibThread::Lock& malloc_lock()
@@ -59,9 +65,19 @@ static bool s_log_malloc = false;
 static bool s_scrub_malloc = true;
 static bool s_scrub_free = true;
 static bool s_profiling = false;
-static unsigned short size_classes[] = { 8, 16, 32, 64, 128, 252, 508, 1016, 2036, 4090, 8188, 16376, 32756, 0 };
+// Past 32 bytes, each size class is at most 25% bigger than the one before it.
+static unsigned short size_classes[] = {
+    8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 252,
+    316, 380, 444, 508, 636, 764, 892, 1016, 1272, 1524, 1780, 2036,
+    2544, 3052, 3560, 4090, 5112, 6136, 7160, 8188,
+    10232, 12280, 14328, 16376, 20472, 24568, 28664, 32756, 0
+};
 static constexpr size_t num_size_classes = sizeof(size_classes) / sizeof(unsigned short);
 
+// Finds the size class for small sizes without searching, see allocator_for_size().
+constexpr size_t max_size_for_size_class_lookup = 1016;
+static u8 s_size_class_lookup[max_size_for_size_class_lookup / 8 + 1];
+
 constexpr size_t block_size = 64 * KB;
 constexpr size_t block_mask = ~(block_size - 1);
 
@@ -132,6 +148,79 @@ struct BigAllocator {
     Vector<BigAllocationBlock*, number_of_big_blocks_to_keep_around_per_size_class> blocks;
 };
 
+static size_t s_big_allocation_count;
+static size_t s_big_allocation_bytes;
+
+// Allocations between the largest size class and 1 MiB are cut out of 4 MiB arenas as runs of
+// whole pages, so they reuse address space instead of costing an mmap and munmap each.
+// Arenas are aligned to their size, which lets free() recognize their pointers from the address alone.
+constexpr size_t medium_arena_size = 4 * MB;
+constexpr size_t medium_arena_mask = ~(medium_arena_size - 1);
+constexpr size_t medium_arena_page_count = medium_arena_size / PAGE_SIZE;
+constexpr size_t max_medium_allocation_size = 1 * MB;
+
+// Freed runs keep their pages until an arena has this many of them, then they're all discarded at once.
+constexpr size_t max_dirty_medium_pages = 256;
+
+struct MediumArena : public CommonHeader {
+    // Every run of pages, allocated or free, has its length (and flags) stored for its first
+    // page, and its first page stored for its last one, so that neighbours can be merged.
+    static constexpr u16 run_allocated = 0x8000;
+    static constexpr u16 run_dirty = 0x4000;
+    static constexpr u16 run_length_mask = 0x3fff;
+
+    MediumArena()
+    {
+        m_magic = MAGIC_MEDIUM_ARENA_HEADER;
+        m_size = medium_arena_size;
+        set_run(first_usable_page(), medium_arena_page_count - first_usable_page(), 0);
+        free_pages = medium_arena_page_count - first_usable_page();
+    }
+
+    static constexpr size_t first_usable_page();
+
+    void set_run(size_t first_page, size_t length, u16 flags)
+    {
+        run_info[first_page] = length | flags;
+        run_start[first_page + length - 1] = first_page;
+    }
+    size_t run_length(size_t first_page) const { return run_info[first_page] & run_length_mask; }
+    bool is_allocated(size_t first_page) const { return run_info[first_page] & run_allocated; }
+    void* page(size_t index) { return (u8*)this + index * PAGE_SIZE; }
+    size_t page_index(void* ptr) const { return ((FlatPtr)ptr - (FlatPtr)this) / PAGE_SIZE; }
+
+    MediumArena* next { nullptr };
+    size_t free_pages { 0 };
+    size_t dirty_pages { 0 };
+    u16 run_info[medium_arena_page_count];
+    u16 run_start[medium_arena_page_count];
+};
+
+constexpr size_t MediumArena::first_usable_page()
+{
+    return (sizeof(MediumArena) + PAGE_SIZE - 1) / PAGE_SIZE;
+}
+
+static MediumArena* s_medium_arenas;
+
+// One bit for every arena-sized slot of the address space, set while an arena lives there.
+static u32 s_medium_arena_slots[(0x100000000ull / medium_arena_size) / 32];
+
+static bool is_in_medium_arena(void* ptr)
+{
+    size_t slot = (FlatPtr)ptr / medium_arena_size;
+    return s_medium_arena_slots[slot / 32] & (1u << (slot % 32));
+}
+
+static void set_medium_arena_slot(MediumArena* arena, bool in_use)
+{
+    size_t slot = (FlatPtr)arena / medium_arena_size;
+    if (in_use)
+        s_medium_arena_slots[slot / 32] |= 1u << (slot % 32);
+    else
+        s_medium_arena_slots[slot / 32] &= ~(1u << (slot % 32));
+}
+
 // Allocators will be initialized in __malloc_init.
 // We can not rely on global constructors to initialize them,
 // because they must be initialized before other global constructors
@@ -153,6 +242,14 @@ static inline BigAllocator (&big_allocators())[1]
 
 static Allocator* allocator_for_size(size_t size, size_t& good_size)
 {
+    if (size <= max_size_for_size_class_lookup) {
+        // The table is indexed in steps of 8 bytes; the class below may still be big enough.
+        size_t i = s_size_class_lookup[(size + 7) / 8];
+        while (i && size_classes[i - 1] >= size)
+            --i;
+        good_size = size_classes[i];
+        return &allocators()[i];
+    }
     for (int i = 0; size_classes[i]; ++i) {
         if (size <= size_classes[i]) {
             good_size = size_classes[i];
@@ -163,6 +260,26 @@ static Allocator* allocator_for_size(size_t size, size_t& good_size)
     return nullptr;
 }
 
+// Each thread keeps a few free chunks of every small size class to itself, so the common
+// malloc/free pair neither takes the malloc lock nor touches the blocks in between.
+// The chunks stay accounted as used in their blocks until they're given back in a batch.
+constexpr size_t max_thread_cached_chunk_size = 2036;
+constexpr size_t thread_cache_batch_bytes = 4 * KB;
+constexpr size_t max_thread_cache_batch_size = 32;
+
+struct ThreadCacheBin {
+    FreelistEntry* head;
+    size_t count;
+};
+
+// Zero-initialised by the loader for every new thread, so it needs no setting up.
+static __thread ThreadCacheBin t_cache_bins[num_size_classes];
+
+static constexpr size_t thread_cache_batch_size(size_t bytes_per_chunk)
+{
+    return max(min(thread_cache_batch_bytes / bytes_per_chunk, max_thread_cache_batch_size), (size_t)2);
+}
+
 static BigAllocator* big_allocator_for_size(size_t size)
 {
     if (size == 65536)
@@ -194,10 +311,292 @@ static void os_free(void* ptr, size_t size)
     assert(rc == 0);
 }
 
-static void* malloc_impl(size_t size)
+// With LIBC_MALLOC_SAMPLE_KIB=N set, roughly one allocation per N KiB allocated by each thread
+// has its size and call stack recorded until it's freed. Sending the process SIGUSR2 writes the
+// live samples to /tmp/heap.<pid>.json, which ProfileViewer opens like any other profile.
+constexpr size_t max_heap_samples = 4096;
+constexpr size_t heap_sample_table_size = max_heap_samples * 2;
+constexpr size_t heap_sample_table_mask = heap_sample_table_size - 1;
+constexpr size_t max_heap_sample_frames = 16;
+
+struct HeapSample {
+    FlatPtr ptr;
+    size_t size;
+    u64 timestamp;
+    size_t frame_count;
+    FlatPtr frames[max_heap_sample_frames];
+};
+
+static size_t s_heap_sample_interval;
+static HeapSample* s_heap_samples;
+static size_t s_heap_sample_count;
+static size_t s_dropped_heap_samples;
+static __thread ssize_t t_bytes_until_heap_sample;
+
+static size_t heap_sample_slot(FlatPtr ptr)
+{
+    return ((ptr >> 3) * 2654435761u) & heap_sample_table_mask;
+}
+
+// Open addressing, kept at most half full so that probes stay short and always end.
+static HeapSample* find_heap_sample(FlatPtr ptr)
+{
+    for (size_t i = heap_sample_slot(ptr); s_heap_samples[i].ptr; i = (i + 1) & heap_sample_table_mask) {
+        if (s_heap_samples[i].ptr == ptr)
+            return &s_heap_samples[i];
+    }
+    return nullptr;
+}
+
+static void remove_heap_sample(FlatPtr ptr)
+{
+    auto* sample = find_heap_sample(ptr);
+    if (!sample)
+        return;
+    // Later entries of the same probe sequence are shifted back into the hole, so nothing needs a tombstone.
+    size_t hole = sample - s_heap_samples;
+    for (size_t i = (hole + 1) & heap_sample_table_mask; s_heap_samples[i].ptr; i = (i + 1) & heap_sample_table_mask) {
+        size_t home = heap_sample_slot(s_heap_samples[i].ptr);
+        if (((i - home) & heap_sample_table_mask) >= ((i - hole) & heap_sample_table_mask)) {
+            s_heap_samples[hole] = s_heap_samples[i];
+            hole = i;
+        }
+    }
+    s_heap_samples[hole].ptr = 0;
+    --s_heap_sample_count;
+}
+
+NEVER_INLINE static void record_heap_sample(void* ptr, size_t size)
+{
+    HeapSample sample;
+    sample.ptr = (FlatPtr)ptr;
+    sample.size = size;
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    sample.timestamp = (u64)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+
+    // Userspace is built with frame pointers, so the stack can be walked without any unwind info.
+    // The first return address is the one into malloc() itself, which everybody has in common.
+    sample.frame_count = 0;
+    auto* frame = (FlatPtr*)__builtin_frame_address(0);
+    for (size_t i = 0; frame && sample.frame_count < max_heap_sample_frames; ++i) {
+        auto* next_frame = (FlatPtr*)frame[0];
+        FlatPtr return_address = frame[1];
+        if (!return_address)
+            break;
+        if (i)
+            sample.frames[sample.frame_count++] = return_address;
+        // Callers' frames are further up the stack; anything else means we've walked off the end of it.
+        if (next_frame <= frame || (FlatPtr)next_frame - (FlatPtr)frame > 1 * MB)
+            break;
+        frame = next_frame;
+    }
+
+    LOCKER(malloc_lock());
+    if (auto* existing_sample = find_heap_sample(sample.ptr)) {
+        *existing_sample = sample;
+        return;
+    }
+    if (s_heap_sample_count >= max_heap_samples) {
+        ++s_dropped_heap_samples;
+        return;
+    }
+    size_t i = heap_sample_slot(sample.ptr);
+    while (s_heap_samples[i].ptr)
+        i = (i + 1) & heap_sample_table_mask;
+    s_heap_samples[i] = sample;
+    ++s_heap_sample_count;
+}
+
+static void forget_heap_sample(void* ptr)
 {
+    // Most frees aren't of a sampled allocation, and this lets them skip the lock. A concurrent removal
+    // can make the unlocked probe miss, which leaves a stale sample behind until the address is reused.
+    if (!s_heap_sample_count || !find_heap_sample((FlatPtr)ptr))
+        return;
     LOCKER(malloc_lock());
+    remove_heap_sample((FlatPtr)ptr);
+}
+
+struct HeapSampleWriter {
+    explicit HeapSampleWriter(int fd)
+        : m_fd(fd)
+    {
+    }
+
+    __attribute__((format(printf, 2, 3))) void append(const char* format, ...)
+    {
+        va_list ap;
+        va_start(ap, format);
+        int length = vsnprintf(m_buffer + m_used, sizeof(m_buffer) - m_used, format, ap);
+        va_end(ap);
+        if (length < 0)
+            return;
+        if (m_used + length >= sizeof(m_buffer)) {
+            flush();
+            va_start(ap, format);
+            length = vsnprintf(m_buffer, sizeof(m_buffer), format, ap);
+            va_end(ap);
+        }
+        m_used += min((size_t)length, sizeof(m_buffer) - 1);
+    }
+
+    bool flush()
+    {
+        for (size_t offset = 0; offset < m_used;) {
+            ssize_t nwritten = write(m_fd, m_buffer + offset, m_used - offset);
+            if (nwritten < 0) {
+                m_failed = true;
+                break;
+            }
+            offset += nwritten;
+        }
+        m_used = 0;
+        return !m_failed;
+    }
 
+private:
+    int m_fd { -1 };
+    bool m_failed { false };
+    size_t m_used { 0 };
+    char m_buffer[1024];
+};
+
+static void heap_sample_signal_handler(int)
+{
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/heap.%d.json", getpid());
+    int fd = open(path, O_CREAT | O_WRONLY | O_TRUNC, 0600);
+    if (fd < 0) {
+        dbgprintf("LibC: Couldn't open %s for the heap samples\n", path);
+        return;
+    }
+    if (malloc_dump_heap_samples(fd) == 0)
+        dbgprintf("LibC: Wrote %zu heap samples to %s (%zu dropped)\n", s_heap_sample_count, path, s_dropped_heap_samples);
+    close(fd);
+}
+
+static void* allocate_from_arena(MediumArena& arena, size_t page_count)
+{
+    for (size_t i = MediumArena::first_usable_page(); i < medium_arena_page_count; i += arena.run_length(i)) {
+        size_t length = arena.run_length(i);
+        if (arena.is_allocated(i) || length < page_count)
+            continue;
+        bool was_dirty = arena.run_info[i] & MediumArena::run_dirty;
+        arena.set_run(i, page_count, MediumArena::run_allocated);
+        if (length > page_count)
+            arena.set_run(i + page_count, length - page_count, was_dirty ? MediumArena::run_dirty : 0);
+        // We don't know how much of the run was dirty, so just assume all of what we took was.
+        if (was_dirty)
+            arena.dirty_pages -= min(arena.dirty_pages, page_count);
+        arena.free_pages -= page_count;
+        return arena.page(i);
+    }
+    return nullptr;
+}
+
+static void* medium_malloc(size_t size)
+{
+    size_t page_count = PAGE_ROUND_UP(size) / PAGE_SIZE;
+    for (auto* arena = s_medium_arenas; arena; arena = arena->next) {
+        if (arena->free_pages < page_count)
+            continue;
+        if (auto* ptr = allocate_from_arena(*arena, page_count))
+            return ptr;
+    }
+
+    auto* arena = (MediumArena*)serenity_mmap(nullptr, medium_arena_size, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, 0, 0, medium_arena_size, "malloc: MediumArena");
+    ASSERT(arena != MAP_FAILED);
+    new (arena) MediumArena();
+    arena->next = s_medium_arenas;
+    s_medium_arenas = arena;
+    set_medium_arena_slot(arena, true);
+    return allocate_from_arena(*arena, page_count);
+}
+
+static void discard_dirty_runs(MediumArena& arena)
+{
+    for (size_t i = MediumArena::first_usable_page(); i < medium_arena_page_count; i += arena.run_length(i)) {
+        if (!(arena.run_info[i] & MediumArena::run_dirty))
+            continue;
+        madvise(arena.page(i), arena.run_length(i) * PAGE_SIZE, MADV_DONTNEED);
+        arena.run_info[i] &= ~MediumArena::run_dirty;
+    }
+    arena.dirty_pages = 0;
+}
+
+static void medium_free(void* ptr)
+{
+    auto& arena = *(MediumArena*)((FlatPtr)ptr & medium_arena_mask);
+    assert(arena.m_magic == MAGIC_MEDIUM_ARENA_HEADER);
+    size_t first_page = arena.page_index(ptr);
+    assert(arena.is_allocated(first_page));
+    size_t length = arena.run_length(first_page);
+    arena.free_pages += length;
+    arena.dirty_pages += length;
+
+    size_t next_page = first_page + length;
+    if (next_page < medium_arena_page_count && !arena.is_allocated(next_page))
+        length += arena.run_length(next_page);
+    if (first_page > MediumArena::first_usable_page()) {
+        size_t previous_page = arena.run_start[first_page - 1];
+        if (!arena.is_allocated(previous_page)) {
+            length += first_page - previous_page;
+            first_page = previous_page;
+        }
+    }
+    arena.set_run(first_page, length, MediumArena::run_dirty);
+
+    bool is_empty = arena.free_pages == medium_arena_page_count - MediumArena::first_usable_page();
+    if (is_empty && (s_medium_arenas != &arena || arena.next)) {
+        // Keep one arena around, but give the rest back once they're unused.
+        MediumArena** link = &s_medium_arenas;
+        while (*link != &arena)
+            link = &(*link)->next;
+        *link = arena.next;
+        set_medium_arena_slot(&arena, false);
+        os_free(&arena, medium_arena_size);
+        return;
+    }
+
+    if (arena.dirty_pages > max_dirty_medium_pages)
+        discard_dirty_runs(arena);
+}
+
+static void* allocate_chunk(Allocator*, size_t good_size);
+static void free_chunk(ChunkedBlock*, void* ptr);
+
+static void refill_thread_cache(Allocator* allocator, ThreadCacheBin& bin, size_t good_size)
+{
+    LOCKER(malloc_lock());
+    for (size_t i = thread_cache_batch_size(good_size); i; --i) {
+        auto* entry = (FreelistEntry*)allocate_chunk(allocator, good_size);
+        entry->next = bin.head;
+        bin.head = entry;
+        ++bin.count;
+    }
+}
+
+// Gives back all but the first (most recently freed, so likely still in the CPU cache) chunks.
+static void drain_thread_cache(ThreadCacheBin& bin, size_t chunks_to_keep)
+{
+    FreelistEntry** link = &bin.head;
+    for (size_t i = 0; i < chunks_to_keep && *link; ++i)
+        link = &(*link)->next;
+    auto* entry = *link;
+    *link = nullptr;
+    bin.count = min(bin.count, chunks_to_keep);
+
+    LOCKER(malloc_lock());
+    while (entry) {
+        auto* next = entry->next;
+        free_chunk((ChunkedBlock*)((FlatPtr)entry & block_mask), entry);
+        entry = next;
+    }
+}
+
+static void* malloc_impl(size_t size)
+{
     if (s_log_malloc)
         dbgprintf("LibC: malloc(%zu)\n", size);
 
@@ -207,6 +606,26 @@ static void* malloc_impl(size_t size)
     size_t good_size;
     auto* allocator = allocator_for_size(size, good_size);
 
+    if (allocator && good_size <= max_thread_cached_chunk_size) {
+        auto& bin = t_cache_bins[allocator - allocators()];
+        if (!bin.head)
+            refill_thread_cache(allocator, bin, good_size);
+        auto* ptr = bin.head;
+        bin.head = ptr->next;
+        --bin.count;
+#ifdef MALLOC_DEBUG
+        dbgprintf("LibC: allocated %p from the thread cache (size %zu)\n", ptr, good_size);
+#endif
+        if (s_scrub_malloc)
+            memset(ptr, MALLOC_SCRUB_BYTE, good_size);
+        return ptr;
+    }
+
+    LOCKER(malloc_lock());
+
+    if (!allocator && size <= max_medium_allocation_size)
+        return medium_malloc(size);
+
     if (!allocator) {
         size_t real_size = round_up_to_power_of_two(sizeof(BigAllocationBlock) + size, block_size);
 #ifdef RECYCLE_BIG_ALLOCATIONS
@@ -225,15 +644,27 @@ static void* malloc_impl(size_t size)
                 }
                 if (this_block_was_purged)
                     new (block) BigAllocationBlock(real_size);
+                ++s_big_allocation_count;
+                s_big_allocation_bytes += real_size;
                 return &block->m_slot[0];
             }
         }
 #endif
         auto* block = (BigAllocationBlock*)os_alloc(real_size, "malloc: BigAllocationBlock");
         new (block) BigAllocationBlock(real_size);
+        ++s_big_allocation_count;
+        s_big_allocation_bytes += real_size;
         return &block->m_slot[0];
     }
 
+    void* ptr = allocate_chunk(allocator, good_size);
+    if (s_scrub_malloc)
+        memset(ptr, MALLOC_SCRUB_BYTE, good_size);
+    return ptr;
+}
+
+static void* allocate_chunk(Allocator* allocator, size_t good_size)
+{
     ChunkedBlock* block = nullptr;
 
     for (block = allocator->usable_blocks.head(); block; block = block->next()) {
@@ -281,8 +712,6 @@ static void* malloc_impl(size_t size)
 #ifdef MALLOC_DEBUG
     dbgprintf("LibC: allocated %p (chunk in block %p, size %zu)\n", ptr, block, block->bytes_per_chunk());
 #endif
-    if (s_scrub_malloc)
-        memset(ptr, MALLOC_SCRUB_BYTE, block->m_size);
     return ptr;
 }
 
@@ -293,13 +722,53 @@ static void free_impl(void* ptr)
     if (!ptr)
         return;
 
-    LOCKER(malloc_lock());
+    // This has to be checked first, since there's no header at the start of a medium allocation's 64 KiB block.
+    if (is_in_medium_arena(ptr)) {
+        LOCKER(malloc_lock());
+        medium_free(ptr);
+        return;
+    }
 
     void* block_base = (void*)((FlatPtr)ptr & block_mask);
     size_t magic = *(size_t*)block_base;
 
+    if (magic == MAGIC_PAGE_HEADER) {
+        auto* block = (ChunkedBlock*)block_base;
+        size_t good_size;
+        auto* allocator = allocator_for_size(block->m_size, good_size);
+
+#ifdef MALLOC_DEBUG
+        dbgprintf("LibC: freeing %p in allocator %p (size=%u, used=%u)\n", ptr, block, block->bytes_per_chunk(), block->used_chunks());
+#endif
+
+        if (s_scrub_free)
+            memset(ptr, FREE_SCRUB_BYTE, block->bytes_per_chunk());
+
+        if (good_size > max_thread_cached_chunk_size) {
+            LOCKER(malloc_lock());
+            free_chunk(block, ptr);
+            return;
+        }
+
+        auto& bin = t_cache_bins[allocator - allocators()];
+        auto* entry = (FreelistEntry*)ptr;
+        entry->next = bin.head;
+        bin.head = entry;
+        ++bin.count;
+
+        // Keep one batch around for the next refill, and give the rest back for other threads.
+        size_t batch_size = thread_cache_batch_size(good_size);
+        if (bin.count > batch_size * 2)
+            drain_thread_cache(bin, batch_size);
+        return;
+    }
+
+    LOCKER(malloc_lock());
+
     if (magic == MAGIC_BIGALLOC_HEADER) {
         auto* block = (BigAllocationBlock*)block_base;
+        --s_big_allocation_count;
+        s_big_allocation_bytes -= block->m_size;
 #ifdef RECYCLE_BIG_ALLOCATIONS
         if (auto* allocator = big_allocator_for_size(block->m_size)) {
             if (allocator->blocks.size() < number_of_big_blocks_to_keep_around_per_size_class) {
@@ -321,16 +790,11 @@ static void free_impl(void* ptr)
         return;
     }
 
-    assert(magic == MAGIC_PAGE_HEADER);
-    auto* block = (ChunkedBlock*)block_base;
-
-#ifdef MALLOC_DEBUG
-    dbgprintf("LibC: freeing %p in allocator %p (size=%u, used=%u)\n", ptr, block, block->bytes_per_chunk(), block->used_chunks());
-#endif
-
-    if (s_scrub_free)
-        memset(ptr, FREE_SCRUB_BYTE, block->bytes_per_chunk());
+    ASSERT_NOT_REACHED();
+}
 
+static void free_chunk(ChunkedBlock* block, void* ptr)
+{
     auto* entry = (FreelistEntry*)ptr;
     entry->next = block->m_freelist;
     block->m_freelist = entry;
@@ -374,6 +838,13 @@ void* malloc(size_t size)
     void* ptr = malloc_impl(size);
     if (s_profiling)
         perf_event(PERF_EVENT_MALLOC, size, reinterpret_cast<FlatPtr>(ptr));
+    if (s_heap_sample_interval && ptr) {
+        t_bytes_until_heap_sample -= size;
+        if (t_bytes_until_heap_sample <= 0) {
+            t_bytes_until_heap_sample = s_heap_sample_interval;
+            record_heap_sample(ptr, size);
+        }
+    }
     return ptr;
 }
 
@@ -381,6 +852,9 @@ void free(void* ptr)
 {
     if (s_profiling)
         perf_event(PERF_EVENT_FREE, reinterpret_cast<FlatPtr>(ptr), 0);
+    // This has to happen first, since another thread may get the same address back once it's freed.
+    if (ptr)
+        forget_heap_sample(ptr);
     free_impl(ptr);
 }
 
@@ -397,6 +871,10 @@ size_t malloc_size(void* ptr)
     if (!ptr)
         return 0;
     LOCKER(malloc_lock());
+    if (is_in_medium_arena(ptr)) {
+        auto& arena = *(MediumArena*)((FlatPtr)ptr & medium_arena_mask);
+        return arena.run_length(arena.page_index(ptr)) * PAGE_SIZE;
+    }
     void* page_base = (void*)((FlatPtr)ptr & block_mask);
     auto* header = (const CommonHeader*)page_base;
     auto size = header->m_size;
@@ -405,6 +883,123 @@ size_t malloc_size(void* ptr)
     return size;
 }
 
+static struct malloc_size_class_stats size_class_stats(const Allocator& allocator)
+{
+    struct malloc_size_class_stats stats {};
+    stats.chunk_size = allocator.size;
+    stats.blocks = allocator.block_count;
+    auto count_chunks = [&](const ChunkedBlock* block) {
+        for (; block; block = block->m_next) {
+            stats.used_chunks += block->used_chunks();
+            stats.free_chunks += block->free_chunks();
+        }
+    };
+    count_chunks(allocator.usable_blocks.head());
+    count_chunks(allocator.full_blocks.head());
+    return stats;
+}
+
+size_t malloc_get_size_class_stats(struct malloc_size_class_stats* stats, size_t max_count)
+{
+    LOCKER(malloc_lock());
+    size_t count = num_size_classes - 1;
+    for (size_t i = 0; i < min(count, max_count); ++i)
+        stats[i] = size_class_stats(allocators()[i]);
+    return count;
+}
+
+struct mallinfo mallinfo()
+{
+    LOCKER(malloc_lock());
+    struct mallinfo info {};
+
+    for (size_t i = 0; size_classes[i]; ++i) {
+        auto& allocator = allocators()[i];
+        auto stats = size_class_stats(allocator);
+        info.arena += allocator.block_count * block_size;
+        info.ordblks += stats.free_chunks;
+        info.uordblks += stats.used_chunks * stats.chunk_size;
+        info.fordblks += stats.free_chunks * stats.chunk_size;
+        info.keepcost += allocator.empty_block_count * block_size;
+    }
+
+    for (auto* arena = s_medium_arenas; arena; arena = arena->next) {
+        info.arena += medium_arena_size;
+        for (size_t i = MediumArena::first_usable_page(); i < medium_arena_page_count; i += arena->run_length(i)) {
+            if (!arena->is_allocated(i))
+                ++info.ordblks;
+        }
+        info.uordblks += (medium_arena_page_count - MediumArena::first_usable_page() - arena->free_pages) * PAGE_SIZE;
+        info.fordblks += arena->free_pages * PAGE_SIZE;
+    }
+
+    info.hblks = s_big_allocation_count;
+    info.hblkhd = s_big_allocation_bytes;
+#ifdef RECYCLE_BIG_ALLOCATIONS
+    info.keepcost += big_allocators()[0].blocks.size() * block_size;
+#endif
+    return info;
+}
+
+void malloc_stats()
+{
+    LOCKER(malloc_lock());
+
+    // Chunks sitting in a thread's cache count as used here.
+    fprintf(stderr, "size class  blocks  used chunks  free chunks  free %%\n");
+    for (size_t i = 0; size_classes[i]; ++i) {
+        auto stats = size_class_stats(allocators()[i]);
+        if (!stats.blocks)
+            continue;
+        fprintf(stderr, "%10zu  %6zu  %11zu  %11zu  %5zu%%\n", stats.chunk_size, stats.blocks, stats.used_chunks, stats.free_chunks, stats.free_chunks * 100 / max(stats.used_chunks + stats.free_chunks, (size_t)1));
+    }
+
+    for (auto* arena = s_medium_arenas; arena; arena = arena->next) {
+        size_t largest_free_run = 0;
+        for (size_t i = MediumArena::first_usable_page(); i < medium_arena_page_count; i += arena->run_length(i)) {
+            if (!arena->is_allocated(i))
+                largest_free_run = max(largest_free_run, arena->run_length(i));
+        }
+        fprintf(stderr, "medium arena %p: %zu free pages, %zu not yet discarded, largest free run %zu pages\n", arena, arena->free_pages, arena->dirty_pages, largest_free_run);
+    }
+
+    if (s_big_allocation_count)
+        fprintf(stderr, "%zu big allocations in %zu bytes\n", s_big_allocation_count, s_big_allocation_bytes);
+    if (s_heap_samples)
+        fprintf(stderr, "%zu live heap samples, %zu dropped\n", s_heap_sample_count, s_dropped_heap_samples);
+}
+
+int malloc_dump_heap_samples(int fd)
+{
+    if (!s_heap_samples) {
+        errno = ENOTSUP;
+        return -1;
+    }
+
+    char executable_path[256];
+    ssize_t length = readlink("/proc/self/exe", executable_path, sizeof(executable_path) - 1);
+    executable_path[max(length, (ssize_t)0)] = '\0';
+
+    LOCKER(malloc_lock());
+    HeapSampleWriter writer(fd);
+    writer.append("{\"pid\":%d,\"executable\":\"%s\",\"events\":[", getpid(), executable_path);
+    bool first_sample = true;
+    for (size_t i = 0; i < heap_sample_table_size; ++i) {
+        auto& sample = s_heap_samples[i];
+        if (!sample.ptr)
+            continue;
+        writer.append("%s{\"type\":\"malloc\",\"ptr\":%u,\"size\":%zu,\"timestamp\":%llu,\"stack\":[", first_sample ? "" : ",", sample.ptr, sample.size, sample.timestamp);
+        for (size_t j = 0; j < sample.frame_count; ++j)
+            writer.append("%s%u", j ? "," : "", sample.frames[j]);
+        writer.append("]}");
+        first_sample = false;
+    }
+    writer.append("]}");
+    return writer.flush() ? 0 : -1;
+}
+
+
+
 void* realloc(void* ptr, size_t size)
 {
     if (!ptr)
@@ -419,6 +1014,15 @@ void* realloc(void* ptr, size_t size)
     return new_ptr;
 }
 
+// Gives the calling thread's cached chunks back before it goes away, since nobody else can reach them.
+void __malloc_thread_exit()
+{
+    for (auto& bin : t_cache_bins) {
+        if (bin.count)
+            drain_thread_cache(bin, 0);
+    }
+}
+
 void __malloc_init()
 {
     new (&malloc_lock()) LibThread::Lock();
@@ -430,12 +1034,27 @@ void __malloc_init()
         s_log_malloc = true;
     if (getenv("LIBC_PROFILE_MALLOC"))
         s_profiling = true;
+    if (getenv("LIBC_DUMP_MALLOC_STATS"))
+        atexit(malloc_stats);
+    if (auto* sample_kib = getenv("LIBC_MALLOC_SAMPLE_KIB")) {
+        s_heap_sample_interval = max(atoi(sample_kib), 1) * KB;
+        s_heap_samples = (HeapSample*)os_alloc(PAGE_ROUND_UP(sizeof(HeapSample) * heap_sample_table_size), "malloc: Heap samples");
+        signal(SIGUSR2, heap_sample_signal_handler);
+    }
+    if (getenv("LIBC_PROFILE_KERNEL_EVENTS"))
+        perf_event(PERF_EVENT_ENABLE_KERNEL_EVENTS, 0, 0);
 
     for (size_t i = 0; i < num_size_classes; ++i) {
         new (&allocators()[i]) Allocator();
         allocators()[i].size = size_classes[i];
     }
 
+    for (size_t i = 0, size_class = 0; i < sizeof(s_size_class_lookup); ++i) {
+        while (size_classes[size_class] < i * 8)
+            ++size_class;
+        s_size_class_lookup[i] = size_class;
+    }
+
     new (&big_allocators()[0])(BigAllocator);
 }
 }
@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2018-2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <sys/cdefs.h>
+#include <sys/types.h>
+
+__BEGIN_DECLS
+
+// Chunks sitting in a thread's cache are counted as in use.
+struct mallinfo {
+    size_t arena;    // Bytes mapped for chunked blocks and medium arenas.
+    size_t ordblks;  // Free chunks and free medium runs.
+    size_t hblks;    // Live big allocations, which get a mapping each.
+    size_t hblkhd;   // Bytes mapped for live big allocations.
+    size_t uordblks; // Bytes in use in chunked blocks and medium arenas.
+    size_t fordblks; // Bytes free in chunked blocks and medium arenas.
+    size_t keepcost; // Bytes in empty blocks kept around for reuse.
+};
+
+struct malloc_size_class_stats {
+    size_t chunk_size;
+    size_t blocks;
+    size_t used_chunks;
+    size_t free_chunks;
+};
+
+struct mallinfo mallinfo();
+
+// Fills in up to max_count entries and returns the number of size classes.
+size_t malloc_get_size_class_stats(struct malloc_size_class_stats*, size_t max_count);
+
+// Writes the live heap samples (see LIBC_MALLOC_SAMPLE_KIB) to fd as a profile.
+int malloc_dump_heap_samples(int fd);
+
+__END_DECLS
@@ -37,6 +37,8 @@
 #define MAP_ANON MAP_ANONYMOUS
 #define MAP_STACK 0x40
 #define MAP_PURGEABLE 0x80
+#define MAP_HUGE 0x100
+#define MAP_POPULATE 0x200
 
 #define PROT_READ 0x1
 #define PROT_WRITE 0x2
@@ -48,6 +50,8 @@
 #define MADV_SET_VOLATILE 0x100
 #define MADV_SET_NONVOLATILE 0x200
 #define MADV_GET_VOLATILE 0x400
+#define MADV_WILLNEED 0x800
+#define MADV_DONTNEED 0x1000
 
 #define MAP_INHERIT_ZERO 1
 
@@ -34,16 +34,227 @@
 #include <netinet/in.h>
 #include <stdio.h>
 #include <string.h>
+#include <time.h>
 #include <unistd.h>
 
+// Lookups are cached per process for as long as the TTLs handed back by LookupServer allow.
+// Failed lookups are remembered briefly too, so we don't keep asking for hosts that don't exist.
+static constexpr time_t negative_lookup_cache_ttl = 30;
+static constexpr size_t max_cached_lookups = 64;
+
+struct CachedLookup {
+    String request;
+    Vector<String> records;
+    time_t expiration_time { 0 };
+};
+
+static Vector<CachedLookup> s_lookup_cache;
+
+enum class LookupStatus {
+    Found,
+    NotFound,
+    Failed,
+};
+
+static time_t monotonic_seconds()
+{
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec;
+}
+
+static const CachedLookup* find_cached_lookup(const String& request)
+{
+    for (size_t i = 0; i < s_lookup_cache.size(); ++i) {
+        if (s_lookup_cache[i].request != request)
+            continue;
+        if (monotonic_seconds() < s_lookup_cache[i].expiration_time)
+            return &s_lookup_cache[i];
+        s_lookup_cache.remove(i);
+        return nullptr;
+    }
+    return nullptr;
+}
+
+static void cache_lookup(const String& request, const Vector<String>& records, time_t ttl)
+{
+    if (ttl <= 0)
+        return;
+    auto now = monotonic_seconds();
+    s_lookup_cache.remove_all_matching([&](auto& entry) {
+        return entry.request == request || now >= entry.expiration_time;
+    });
+    if (s_lookup_cache.size() >= max_cached_lookups) {
+        size_t soonest = 0;
+        for (size_t i = 1; i < s_lookup_cache.size(); ++i) {
+            if (s_lookup_cache[i].expiration_time < s_lookup_cache[soonest].expiration_time)
+                soonest = i;
+        }
+        s_lookup_cache.remove(soonest);
+    }
+    s_lookup_cache.append({ request, records, now + ttl });
+}
+
+// LookupServer answers with one "<record> <ttl>" line per record, or with "Not found." or
+// "Timed out.", and ends every response with an empty line.
+static bool is_complete_lookup_response(const ByteBuffer& response)
+{
+    return StringView(response).ends_with("\n\n");
+}
+
+static LookupStatus parse_lookup_response(const String& request, const ByteBuffer& response, Vector<String>& records)
+{
+    auto lines = StringView(response).lines();
+    if (lines.is_empty() || lines[0] == "Timed out.")
+        return LookupStatus::Failed;
+
+    if (lines[0] == "Not found.") {
+        cache_lookup(request, {}, negative_lookup_cache_ttl);
+        return LookupStatus::NotFound;
+    }
+
+    time_t ttl = NumericLimits<time_t>::max();
+    for (auto& line : lines) {
+        if (line.is_empty())
+            continue;
+        auto space = line.find_last_of(' ');
+        if (!space.has_value()) {
+            records.append(line);
+            ttl = 0;
+            continue;
+        }
+        records.append(line.substring_view(0, space.value()));
+        bool ok;
+        time_t record_ttl = line.substring_view(space.value() + 1, line.length() - space.value() - 1).to_uint(ok);
+        ttl = min(ttl, ok ? record_ttl : 0);
+    }
+
+    if (records.is_empty())
+        return LookupStatus::Failed;
+    cache_lookup(request, records, ttl);
+    return LookupStatus::Found;
+}
+
+static int connect_to_lookup_server(int extra_flags = 0)
+{
+    int fd = socket(AF_LOCAL, SOCK_STREAM | SOCK_CLOEXEC | extra_flags, 0);
+    if (fd < 0) {
+        perror("socket");
+        return -1;
+    }
+
+    sockaddr_un address;
+    address.sun_family = AF_LOCAL;
+    strcpy(address.sun_path, "/tmp/portal/lookup");
+
+    if (connect(fd, (const sockaddr*)&address, sizeof(address)) < 0) {
+        perror("connect_to_lookup_server");
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// The connection to LookupServer is kept open between lookups. A forked child must not share
+// its parent's connection, so it is only reused by the process that opened it.
+static int s_lookup_server_fd = -1;
+static pid_t s_lookup_server_pid = 0;
+
+static bool send_lookup_request(int fd, const String& request, ByteBuffer& response)
+{
+    auto line = String::format("%s\n", request.characters());
+    int nsent = write(fd, line.characters(), line.length());
+    if (nsent < 0 || (size_t)nsent != line.length())
+        return false;
+
+    char buffer[1024];
+    while (!is_complete_lookup_response(response)) {
+        int nrecv = read(fd, buffer, sizeof(buffer));
+        if (nrecv <= 0)
+            return false;
+        response.append(buffer, nrecv);
+    }
+    return true;
+}
+
+static LookupStatus lookup(const String& request, Vector<String>& records)
+{
+    if (auto* cached_lookup = find_cached_lookup(request)) {
+        records = cached_lookup->records;
+        return records.is_empty() ? LookupStatus::NotFound : LookupStatus::Found;
+    }
+
+    if (s_lookup_server_fd >= 0 && s_lookup_server_pid != getpid())
+        s_lookup_server_fd = -1;
+
+    // LookupServer may have dropped a connection we kept around, so retry once on a fresh one.
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        bool is_reused_connection = s_lookup_server_fd >= 0;
+        if (!is_reused_connection) {
+            s_lookup_server_fd = connect_to_lookup_server();
+            if (s_lookup_server_fd < 0)
+                return LookupStatus::Failed;
+            s_lookup_server_pid = getpid();
+        }
+
+        ByteBuffer response;
+        if (send_lookup_request(s_lookup_server_fd, request, response))
+            return parse_lookup_response(request, response, records);
+
+        close(s_lookup_server_fd);
+        s_lookup_server_fd = -1;
+        if (!is_reused_connection)
+            break;
+    }
+    return LookupStatus::Failed;
+}
+
+struct HostentBuffer {
+    hostent* fill(const char* name, in_addr_t address_to_use)
+    {
+        strncpy(name_buffer, name, sizeof(name_buffer) - 1);
+        name_buffer[sizeof(name_buffer) - 1] = '\0';
+        address = address_to_use;
+        address_list[0] = &address;
+        address_list[1] = nullptr;
+        host.h_name = name_buffer;
+        host.h_aliases = nullptr;
+        host.h_addrtype = AF_INET;
+        host.h_addr_list = (char**)address_list;
+        host.h_length = 4;
+        return &host;
+    }
+
+    hostent host;
+    char name_buffer[512];
+    in_addr_t address;
+    in_addr_t* address_list[2];
+};
+
+static void set_h_errno_for(LookupStatus status)
+{
+    h_errno = status == LookupStatus::NotFound ? HOST_NOT_FOUND : TRY_AGAIN;
+}
+
+static hostent* hostent_for_addresses(HostentBuffer& buffer, const char* name, LookupStatus status, const Vector<String>& records)
+{
+    if (status != LookupStatus::Found) {
+        set_h_errno_for(status);
+        return nullptr;
+    }
+    in_addr_t address;
+    if (inet_pton(AF_INET, records[0].characters(), &address) <= 0) {
+        h_errno = NO_RECOVERY;
+        return nullptr;
+    }
+    return buffer.fill(name, address);
+}
+
 extern "C" {
 
 int h_errno;
 
-static hostent __gethostbyname_buffer;
-static char __gethostbyname_name_buffer[512];
-static in_addr_t __gethostbyname_address;
-static in_addr_t* __gethostbyname_address_list_buffer[2];
+static HostentBuffer __gethostbyname_buffer;
 
 static hostent __gethostbyaddr_buffer;
 static char __gethostbyaddr_name_buffer[512];
@@ -76,91 +287,103 @@ static int __getproto_protocol_buffer;
 static bool keep_protocols_file_open = false;
 static ssize_t protocol_file_offset = 0;
 
-static int connect_to_lookup_server()
+hostent* gethostbyname(const char* name)
 {
-    int fd = socket(AF_LOCAL, SOCK_STREAM | SOCK_CLOEXEC, 0);
-    if (fd < 0) {
-        perror("socket");
-        return -1;
-    }
-
-    sockaddr_un address;
-    address.sun_family = AF_LOCAL;
-    strcpy(address.sun_path, "/tmp/portal/lookup");
+    auto ipv4_address = IPv4Address::from_string(name);
+    if (ipv4_address.has_value())
+        return __gethostbyname_buffer.fill(ipv4_address.value().to_string().characters(), ipv4_address.value().to_u32());
 
-    if (connect(fd, (const sockaddr*)&address, sizeof(address)) < 0) {
-        perror("connect_to_lookup_server");
-        close(fd);
-        return -1;
-    }
-    return fd;
+    Vector<String> records;
+    auto status = lookup(String::format("L%s", name), records);
+    return hostent_for_addresses(__gethostbyname_buffer, name, status, records);
 }
 
-hostent* gethostbyname(const char* name)
+struct gethostbyname_request {
+    String name;
+    String request;
+    int fd { -1 };
+    ByteBuffer response;
+    LookupStatus status { LookupStatus::Failed };
+    Vector<String> records;
+    HostentBuffer buffer;
+};
+
+gethostbyname_request* gethostbyname_async(const char* name)
 {
+    auto* request = new gethostbyname_request;
+    request->name = name;
+    request->request = String::format("L%s", name);
+
     auto ipv4_address = IPv4Address::from_string(name);
     if (ipv4_address.has_value()) {
-        sprintf(__gethostbyname_name_buffer, "%s", ipv4_address.value().to_string().characters());
-        __gethostbyname_buffer.h_name = __gethostbyname_name_buffer;
-        __gethostbyname_buffer.h_aliases = nullptr;
-        __gethostbyname_buffer.h_addrtype = AF_INET;
-        new (&__gethostbyname_address) IPv4Address(ipv4_address.value());
-        __gethostbyname_address_list_buffer[0] = &__gethostbyname_address;
-        __gethostbyname_address_list_buffer[1] = nullptr;
-        __gethostbyname_buffer.h_addr_list = (char**)__gethostbyname_address_list_buffer;
-        __gethostbyname_buffer.h_length = 4;
-
-        return &__gethostbyname_buffer;
+        request->status = LookupStatus::Found;
+        request->records.append(ipv4_address.value().to_string());
+        return request;
     }
 
-    int fd = connect_to_lookup_server();
-    if (fd < 0)
-        return nullptr;
+    if (auto* cached_lookup = find_cached_lookup(request->request)) {
+        request->records = cached_lookup->records;
+        request->status = request->records.is_empty() ? LookupStatus::NotFound : LookupStatus::Found;
+        return request;
+    }
 
-    auto close_fd_on_exit = ScopeGuard([fd] {
-        close(fd);
-    });
+    request->fd = connect_to_lookup_server(SOCK_NONBLOCK);
+    if (request->fd < 0)
+        return request;
 
-    auto line = String::format("L%s\n", name);
-    int nsent = write(fd, line.characters(), line.length());
-    if (nsent < 0) {
-        perror("write");
-        return nullptr;
+    // The request line is tiny, so this can't block even on a non-blocking socket.
+    auto line = String::format("%s\n", request->request.characters());
+    int nsent = write(request->fd, line.characters(), line.length());
+    if (nsent < 0 || (size_t)nsent != line.length()) {
+        close(request->fd);
+        request->fd = -1;
     }
+    return request;
+}
 
-    ASSERT((size_t)nsent == line.length());
+int gethostbyname_async_fd(const gethostbyname_request* request)
+{
+    return request->fd;
+}
+
+int gethostbyname_async_poll(gethostbyname_request* request)
+{
+    if (request->fd < 0)
+        return 1;
 
     char buffer[1024];
-    int nrecv = read(fd, buffer, sizeof(buffer) - 1);
-    if (nrecv < 0) {
-        perror("recv");
-        return nullptr;
+    for (;;) {
+        int nrecv = read(request->fd, buffer, sizeof(buffer));
+        if (nrecv < 0 && errno == EAGAIN)
+            return 0;
+        if (nrecv <= 0)
+            break;
+        request->response.append(buffer, nrecv);
+        if (is_complete_lookup_response(request->response)) {
+            request->status = parse_lookup_response(request->request, request->response, request->records);
+            break;
+        }
     }
 
-    if (!memcmp(buffer, "Not found.", sizeof("Not found.") - 1))
-        return nullptr;
-
-    auto responses = String(buffer, nrecv).split('\n');
-    if (responses.is_empty())
-        return nullptr;
-
-    auto& response = responses[0];
+    close(request->fd);
+    request->fd = -1;
+    return 1;
+}
 
-    int rc = inet_pton(AF_INET, response.characters(), &__gethostbyname_address);
-    if (rc <= 0)
+hostent* gethostbyname_async_result(gethostbyname_request* request)
+{
+    if (request->fd >= 0) {
+        h_errno = TRY_AGAIN;
         return nullptr;
+    }
+    return hostent_for_addresses(request->buffer, request->name.characters(), request->status, request->records);
+}
 
-    strncpy(__gethostbyname_name_buffer, name, sizeof(__gethostbyaddr_name_buffer) - 1);
-
-    __gethostbyname_buffer.h_name = __gethostbyname_name_buffer;
-    __gethostbyname_buffer.h_aliases = nullptr;
-    __gethostbyname_buffer.h_addrtype = AF_INET;
-    __gethostbyname_address_list_buffer[0] = &__gethostbyname_address;
-    __gethostbyname_address_list_buffer[1] = nullptr;
-    __gethostbyname_buffer.h_addr_list = (char**)__gethostbyname_address_list_buffer;
-    __gethostbyname_buffer.h_length = 4;
-
-    return &__gethostbyname_buffer;
+void gethostbyname_async_free(gethostbyname_request* request)
+{
+    if (request->fd >= 0)
+        close(request->fd);
+    delete request;
 }
 
 hostent* gethostbyaddr(const void* addr, socklen_t addr_size, int type)
@@ -175,46 +398,24 @@ hostent* gethostbyaddr(const void* addr, socklen_t addr_size, int type)
         return nullptr;
     }
 
-    int fd = connect_to_lookup_server();
-    if (fd < 0)
-        return nullptr;
-
-    auto close_fd_on_exit = ScopeGuard([fd] {
-        close(fd);
-    });
-
     IPv4Address ipv4_address((const u8*)&((const in_addr*)addr)->s_addr);
 
-    auto line = String::format("R%d.%d.%d.%d.in-addr.arpa\n",
+    auto request = String::format("R%d.%d.%d.%d.in-addr.arpa",
         ipv4_address[3],
         ipv4_address[2],
         ipv4_address[1],
         ipv4_address[0]);
-    int nsent = write(fd, line.characters(), line.length());
-    if (nsent < 0) {
-        perror("write");
-        return nullptr;
-    }
-
-    ASSERT((size_t)nsent == line.length());
 
-    char buffer[1024];
-    int nrecv = read(fd, buffer, sizeof(buffer) - 1);
-    if (nrecv < 0) {
-        perror("recv");
+    Vector<String> records;
+    auto status = lookup(request, records);
+    if (status != LookupStatus::Found) {
+        set_h_errno_for(status);
         return nullptr;
     }
 
-    if (!memcmp(buffer, "Not found.", sizeof("Not found.") - 1))
-        return nullptr;
-
-    auto responses = String(buffer, nrecv).split('\n');
-    if (responses.is_empty())
-        return nullptr;
-
-    auto& response = responses[0];
-
-    strncpy(__gethostbyaddr_name_buffer, response.characters(), max(sizeof(__gethostbyaddr_name_buffer), response.length()));
+    auto& name = records[0];
+    strncpy(__gethostbyaddr_name_buffer, name.characters(), sizeof(__gethostbyaddr_name_buffer) - 1);
+    __gethostbyaddr_name_buffer[sizeof(__gethostbyaddr_name_buffer) - 1] = '\0';
 
     __gethostbyaddr_buffer.h_name = __gethostbyaddr_name_buffer;
     __gethostbyaddr_buffer.h_aliases = nullptr;
@@ -43,6 +43,18 @@ struct hostent {
 struct hostent* gethostbyname(const char*);
 struct hostent* gethostbyaddr(const void* addr, socklen_t len, int type);
 
+/* Non-blocking host lookup for programs with an event loop. Start it with gethostbyname_async().
+ * While gethostbyname_async_fd() is not -1, wait for that fd to become readable (for example with
+ * a Core::Notifier) and call gethostbyname_async_poll(), which returns 1 once the lookup is done.
+ * gethostbyname_async_result() then behaves like gethostbyname(), with the hostent living until
+ * the request is released with gethostbyname_async_free(). */
+struct gethostbyname_request;
+struct gethostbyname_request* gethostbyname_async(const char* name);
+int gethostbyname_async_fd(const struct gethostbyname_request*);
+int gethostbyname_async_poll(struct gethostbyname_request*);
+struct hostent* gethostbyname_async_result(struct gethostbyname_request*);
+void gethostbyname_async_free(struct gethostbyname_request*);
+
 struct servent {
     char* s_name;
     char** s_aliases;
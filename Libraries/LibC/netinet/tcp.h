@@ -25,3 +25,38 @@
  */
 
 #pragma once
+
+#include <bits/stdint.h>
+#include <sys/cdefs.h>
+
+__BEGIN_DECLS
+
+#define TCP_NODELAY 1
+#define TCP_CORK 3
+#define TCP_INFO 11
+
+// Times are in milliseconds, windows and thresholds in bytes.
+struct tcp_info {
+    uint8_t tcpi_state;
+    uint32_t tcpi_rto;
+    uint32_t tcpi_rtt;
+    uint32_t tcpi_rttvar;
+    uint32_t tcpi_snd_mss;
+    uint32_t tcpi_snd_cwnd;
+    uint32_t tcpi_snd_ssthresh;
+    uint32_t tcpi_snd_wnd;
+    uint32_t tcpi_rcv_wnd;
+    uint32_t tcpi_unacked;
+    uint32_t tcpi_total_retrans;
+    uint32_t tcpi_timeouts;
+    uint32_t tcpi_fast_retrans;
+    uint32_t tcpi_dup_acks;
+    uint32_t tcpi_out_of_order;
+    uint32_t tcpi_rcv_drops;
+    uint32_t tcpi_segs_in;
+    uint32_t tcpi_segs_out;
+    uint32_t tcpi_bytes_in;
+    uint32_t tcpi_bytes_out;
+};
+
+__END_DECLS
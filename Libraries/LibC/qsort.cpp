@@ -61,66 +61,141 @@
 static char sccsid[] = "@(#)qsort.c	5.9 (Berkeley) 2/23/91";
 #endif /* LIBC_SCCS and not lint */
 
+#include <AK/Types.h>
 #include <stdlib.h>
 #include <sys/types.h>
 
-static void insertion_sort(void* bot, size_t nmemb, size_t size, int (*compar)(const void*, const void*));
-static void insertion_sort_r(void* bot, size_t nmemb, size_t size, int (*compar)(const void*, const void*, void*), void* arg);
+// An introsort over untyped elements, mirroring AK::quick_sort: a median-of-three
+// quick sort that insertion sorts short ranges and switches to heap sort when it
+// recurses too deeply, so sorted and all-equal input stay O(n log n).
 
-void qsort(void* bot, size_t nmemb, size_t size, int (*compar)(const void*, const void*))
+static constexpr size_t insertion_sort_threshold = 16;
+
+static void swap_elements(char* a, char* b, size_t size)
 {
-    if (nmemb <= 1)
+    if (a == b)
         return;
-
-    insertion_sort(bot, nmemb, size, compar);
+    if (size % sizeof(u32) == 0 && ((FlatPtr)a | (FlatPtr)b) % alignof(u32) == 0) {
+        auto* a32 = (u32*)a;
+        auto* b32 = (u32*)b;
+        for (size_t i = 0; i < size / sizeof(u32); ++i) {
+            u32 tmp = a32[i];
+            a32[i] = b32[i];
+            b32[i] = tmp;
+        }
+        return;
+    }
+    for (size_t i = 0; i < size; ++i) {
+        char tmp = a[i];
+        a[i] = b[i];
+        b[i] = tmp;
+    }
 }
 
-void qsort_r(void* bot, size_t nmemb, size_t size, int (*compar)(const void*, const void*, void*), void* arg)
+template<typename Compare>
+static void insertion_sort(char* base, size_t nmemb, size_t size, Compare& compare)
 {
-    if (nmemb <= 1)
-        return;
+    for (size_t i = 1; i < nmemb; ++i) {
+        for (char* p = base + i * size; p > base && compare(p, p - size) < 0; p -= size)
+            swap_elements(p, p - size, size);
+    }
+}
 
-    insertion_sort_r(bot, nmemb, size, compar, arg);
+template<typename Compare>
+static void heap_sort_sift_down(char* base, size_t root, size_t nmemb, size_t size, Compare& compare)
+{
+    for (;;) {
+        size_t child = 2 * root + 1;
+        if (child >= nmemb)
+            return;
+        if (child + 1 < nmemb && compare(base + child * size, base + (child + 1) * size) < 0)
+            ++child;
+        if (compare(base + root * size, base + child * size) >= 0)
+            return;
+        swap_elements(base + root * size, base + child * size, size);
+        root = child;
+    }
 }
 
-void insertion_sort(void* bot, size_t nmemb, size_t size, int (*compar)(const void*, const void*))
+template<typename Compare>
+static void heap_sort(char* base, size_t nmemb, size_t size, Compare& compare)
 {
-    int cnt;
-    unsigned char ch;
-    char *s1, *s2, *t1, *t2, *top;
-    top = (char*)bot + nmemb * size;
-    for (t1 = (char*)bot + size; t1 < top;) {
-        for (t2 = t1; (t2 -= size) >= bot && compar(t1, t2) < 0;)
-            ;
-        if (t1 != (t2 += size)) {
-            for (cnt = size; cnt--; ++t1) {
-                ch = *t1;
-                for (s1 = s2 = t1; (s2 -= size) >= t2; s1 = s2)
-                    *s1 = *s2;
-                *s1 = ch;
-            }
-        } else
-            t1 += size;
+    for (size_t i = nmemb / 2; i-- > 0;)
+        heap_sort_sift_down(base, i, nmemb, size, compare);
+    for (size_t i = nmemb; i-- > 1;) {
+        swap_elements(base, base + i * size, size);
+        heap_sort_sift_down(base, 0, i, size, compare);
     }
 }
 
-void insertion_sort_r(void* bot, size_t nmemb, size_t size, int (*compar)(const void*, const void*, void*), void* arg)
+template<typename Compare>
+static void introsort(char* base, size_t nmemb, size_t size, size_t depth_limit, Compare& compare)
 {
-    int cnt;
-    unsigned char ch;
-    char *s1, *s2, *t1, *t2, *top;
-    top = (char*)bot + nmemb * size;
-    for (t1 = (char*)bot + size; t1 < top;) {
-        for (t2 = t1; (t2 -= size) >= bot && compar(t1, t2, arg) < 0;)
-            ;
-        if (t1 != (t2 += size)) {
-            for (cnt = size; cnt--; ++t1) {
-                ch = *t1;
-                for (s1 = s2 = t1; (s2 -= size) >= t2; s1 = s2)
-                    *s1 = *s2;
-                *s1 = ch;
-            }
-        } else
-            t1 += size;
+    while (nmemb > insertion_sort_threshold) {
+        if (depth_limit-- == 0) {
+            heap_sort(base, nmemb, size, compare);
+            return;
+        }
+
+        char* first = base;
+        char* middle = base + (nmemb / 2) * size;
+        char* last = base + (nmemb - 1) * size;
+        if (compare(middle, first) < 0)
+            swap_elements(middle, first, size);
+        if (compare(last, middle) < 0) {
+            swap_elements(last, middle, size);
+            if (compare(middle, first) < 0)
+                swap_elements(middle, first, size);
+        }
+        swap_elements(first, middle, size);
+
+        // The pivot stays at the front while partitioning; both scans stop on equal elements.
+        size_t i = 0;
+        size_t j = nmemb;
+        for (;;) {
+            do {
+                ++i;
+            } while (i < nmemb && compare(base + i * size, first) < 0);
+            do {
+                --j;
+            } while (compare(first, base + j * size) < 0);
+            if (i >= j)
+                break;
+            swap_elements(base + i * size, base + j * size, size);
+        }
+        swap_elements(first, base + j * size, size);
+
+        // Recurse into the smaller side and loop on the larger one.
+        size_t right_count = nmemb - j - 1;
+        if (j < right_count) {
+            introsort(base, j, size, depth_limit, compare);
+            base += (j + 1) * size;
+            nmemb = right_count;
+        } else {
+            introsort(base + (j + 1) * size, right_count, size, depth_limit, compare);
+            nmemb = j;
+        }
     }
+    insertion_sort(base, nmemb, size, compare);
+}
+
+template<typename Compare>
+static void sort(void* bot, size_t nmemb, size_t size, Compare compare)
+{
+    if (nmemb <= 1 || size == 0)
+        return;
+    size_t depth_limit = 0;
+    for (size_t n = nmemb; n > 1; n >>= 1)
+        depth_limit += 2;
+    introsort((char*)bot, nmemb, size, depth_limit, compare);
+}
+
+void qsort(void* bot, size_t nmemb, size_t size, int (*compar)(const void*, const void*))
+{
+    sort(bot, nmemb, size, [&](const void* a, const void* b) { return compar(a, b); });
+}
+
+void qsort_r(void* bot, size_t nmemb, size_t size, int (*compar)(const void*, const void*, void*), void* arg)
+{
+    sort(bot, nmemb, size, [&](const void* a, const void* b) { return compar(a, b, arg); });
 }
@@ -27,6 +27,7 @@
 #include <Kernel/Syscall.h>
 #include <errno.h>
 #include <sched.h>
+#include <serenity.h>
 
 extern "C" {
 
@@ -36,16 +37,27 @@ int sched_yield()
     __RETURN_WITH_ERRNO(rc, rc, -1);
 }
 
+static bool is_valid_policy(int policy)
+{
+    return policy == SCHED_FIFO || policy == SCHED_RR || policy == SCHED_OTHER || policy == SCHED_BATCH;
+}
+
 int sched_get_priority_min(int policy)
 {
-    (void)policy;
-    return 0; // Idle
+    if (!is_valid_policy(policy)) {
+        errno = EINVAL;
+        return -1;
+    }
+    return THREAD_PRIORITY_MIN;
 }
 
 int sched_get_priority_max(int policy)
 {
-    (void)policy;
-    return 3; // High
+    if (!is_valid_policy(policy)) {
+        errno = EINVAL;
+        return -1;
+    }
+    return THREAD_PRIORITY_MAX;
 }
 
 int sched_setparam(pid_t pid, const struct sched_param* param)
@@ -59,4 +71,28 @@ int sched_getparam(pid_t pid, struct sched_param* param)
     int rc = syscall(SC_sched_getparam, pid, param);
     __RETURN_WITH_ERRNO(rc, rc, -1);
 }
+
+int sched_setscheduler(pid_t pid, int policy, const struct sched_param* param)
+{
+    int rc = syscall(SC_sched_setscheduler, pid, policy, param);
+    __RETURN_WITH_ERRNO(rc, rc, -1);
+}
+
+int sched_getscheduler(pid_t pid)
+{
+    int rc = syscall(SC_sched_getscheduler, pid);
+    __RETURN_WITH_ERRNO(rc, rc, -1);
+}
+
+int sched_setaffinity(pid_t pid, size_t cpusetsize, const cpu_set_t* mask)
+{
+    int rc = syscall(SC_sched_setaffinity, pid, cpusetsize, mask);
+    __RETURN_WITH_ERRNO(rc, rc, -1);
+}
+
+int sched_getaffinity(pid_t pid, size_t cpusetsize, cpu_set_t* mask)
+{
+    int rc = syscall(SC_sched_getaffinity, pid, cpusetsize, mask);
+    __RETURN_WITH_ERRNO(rc, rc, -1);
+}
 }
@@ -35,6 +35,8 @@ int sched_yield();
 
 struct sched_param {
     int sched_priority;
+    // The CPU share of the thread's process group, relative to the default of 1024. Zero leaves it unchanged.
+    int sched_group_weight;
 };
 
 #define SCHED_FIFO 0
@@ -42,9 +44,25 @@ struct sched_param {
 #define SCHED_OTHER 2
 #define SCHED_BATCH 3
 
+#define CPU_SETSIZE 32
+
+typedef struct {
+    unsigned int __bits;
+} cpu_set_t;
+
+#define CPU_ZERO(set) ((set)->__bits = 0)
+#define CPU_SET(cpu, set) ((set)->__bits |= (1u << (cpu)))
+#define CPU_CLR(cpu, set) ((set)->__bits &= ~(1u << (cpu)))
+#define CPU_ISSET(cpu, set) (((set)->__bits >> (cpu)) & 1)
+#define CPU_COUNT(set) __builtin_popcount((set)->__bits)
+
 int sched_get_priority_min(int policy);
 int sched_get_priority_max(int policy);
 int sched_setparam(pid_t pid, const struct sched_param* param);
 int sched_getparam(pid_t pid, struct sched_param* param);
+int sched_setscheduler(pid_t pid, int policy, const struct sched_param* param);
+int sched_getscheduler(pid_t pid);
+int sched_setaffinity(pid_t pid, size_t cpusetsize, const cpu_set_t* mask);
+int sched_getaffinity(pid_t pid, size_t cpusetsize, cpu_set_t* mask);
 
 __END_DECLS
@@ -66,9 +66,9 @@ int set_process_boost(int tid, int amount)
     __RETURN_WITH_ERRNO(rc, rc, -1);
 }
 
-int futex(int32_t* userspace_address, int futex_op, int32_t value, const struct timespec* timeout)
+int futex(int32_t* userspace_address, int futex_op, int32_t value, const struct timespec* timeout, int32_t* userspace_address2, int32_t value3)
 {
-    Syscall::SC_futex_params params { userspace_address, futex_op, value, timeout };
+    Syscall::SC_futex_params params { userspace_address, futex_op, value, timeout, userspace_address2, value3 };
     int rc = syscall(SC_futex, &params);
     __RETURN_WITH_ERRNO(rc, rc, -1);
 }
@@ -85,6 +85,31 @@ int perf_event(int type, uintptr_t arg1, FlatPtr arg2)
     __RETURN_WITH_ERRNO(rc, rc, -1);
 }
 
+int perf_counters_enable(pid_t pid, unsigned event_mask)
+{
+    int rc = syscall(SC_perf_counters, PERF_COUNTERS_ENABLE, pid, event_mask);
+    __RETURN_WITH_ERRNO(rc, rc, -1);
+}
+
+int perf_counters_disable(pid_t pid)
+{
+    int rc = syscall(SC_perf_counters, PERF_COUNTERS_DISABLE, pid, 0);
+    __RETURN_WITH_ERRNO(rc, rc, -1);
+}
+
+int perf_counters_read(uint64_t* values)
+{
+    int rc = syscall(SC_perf_counters, PERF_COUNTERS_READ, 0, values);
+    __RETURN_WITH_ERRNO(rc, rc, -1);
+}
+
+int perf_counters_sample(pid_t pid, int event, unsigned period)
+{
+    Syscall::SC_perf_counters_sample_params params { event, period };
+    int rc = syscall(SC_perf_counters, PERF_COUNTERS_SAMPLE, pid, &params);
+    __RETURN_WITH_ERRNO(rc, rc, -1);
+}
+
 void* shbuf_get(int shbuf_id, size_t* size)
 {
     int rc = syscall(SC_shbuf_get, shbuf_id, size);
@@ -125,6 +150,12 @@ int shbuf_allow_all(int shbuf_id)
     __RETURN_WITH_ERRNO(rc, rc, -1);
 }
 
+int shbuf_hand_over(int shbuf_id, pid_t peer_pid)
+{
+    int rc = syscall(SC_shbuf_hand_over, shbuf_id, peer_pid);
+    __RETURN_WITH_ERRNO(rc, rc, -1);
+}
+
 int get_stack_bounds(uintptr_t* user_stack_base, size_t* user_stack_size)
 {
     int rc = syscall(SC_get_stack_bounds, user_stack_base, user_stack_size);
@@ -27,6 +27,7 @@
 #pragma once
 
 #include <stdio.h>
+#include <time.h>
 #include <unistd.h>
 
 __BEGIN_DECLS
@@ -34,6 +35,7 @@ __BEGIN_DECLS
 int shbuf_create(int, void** buffer);
 int shbuf_allow_pid(int, pid_t peer_pid);
 int shbuf_allow_all(int);
+int shbuf_hand_over(int, pid_t peer_pid);
 void* shbuf_get(int shbuf_id, size_t* size);
 int shbuf_release(int shbuf_id);
 int shbuf_seal(int shbuf_id);
@@ -55,8 +57,47 @@ int set_process_boost(pid_t, int amount);
 
 #define FUTEX_WAIT 1
 #define FUTEX_WAKE 2
-
-int futex(int32_t* userspace_address, int futex_op, int32_t value, const struct timespec* timeout);
+#define FUTEX_REQUEUE 3
+#define FUTEX_CMP_REQUEUE 4
+#define FUTEX_WAKE_OP 5
+#define FUTEX_WAIT_BITSET 9
+#define FUTEX_WAKE_BITSET 10
+
+#define FUTEX_PRIVATE_FLAG 128
+#define FUTEX_CLOCK_REALTIME 256
+#define FUTEX_CMD_MASK ~(FUTEX_PRIVATE_FLAG | FUTEX_CLOCK_REALTIME)
+
+#define FUTEX_BITSET_MATCH_ANY 0xffffffff
+
+#define FUTEX_OP_SET 0
+#define FUTEX_OP_ADD 1
+#define FUTEX_OP_OR 2
+#define FUTEX_OP_ANDN 3
+#define FUTEX_OP_XOR 4
+#define FUTEX_OP_OPARG_SHIFT 8
+
+#define FUTEX_OP_CMP_EQ 0
+#define FUTEX_OP_CMP_NE 1
+#define FUTEX_OP_CMP_LT 2
+#define FUTEX_OP_CMP_LE 3
+#define FUTEX_OP_CMP_GT 4
+#define FUTEX_OP_CMP_GE 5
+
+#define FUTEX_OP(op, oparg, cmp, cmparg) ((((op)&0xf) << 28) | (((cmp)&0xf) << 24) | (((oparg)&0xfff) << 12) | ((cmparg)&0xfff))
+
+// For FUTEX_REQUEUE, FUTEX_CMP_REQUEUE and FUTEX_WAKE_OP, the timeout argument carries a second count instead.
+int futex(int32_t* userspace_address, int futex_op, int32_t value, const struct timespec* timeout, int32_t* userspace_address2, int32_t value3);
+
+static inline int futex_wait(int32_t* userspace_address, int32_t value, const struct timespec* abstime, int clockid)
+{
+    int op = clockid == CLOCK_REALTIME ? (FUTEX_WAIT | FUTEX_CLOCK_REALTIME) : FUTEX_WAIT;
+    return futex(userspace_address, op, value, abstime, NULL, 0);
+}
+
+static inline int futex_wake(int32_t* userspace_address, int32_t count)
+{
+    return futex(userspace_address, FUTEX_WAKE, count, NULL, NULL, 0);
+}
 
 #define PURGE_ALL_VOLATILE 0x1
 #define PURGE_ALL_CLEAN_INODE 0x2
@@ -65,9 +106,39 @@ int purge(int mode);
 
 #define PERF_EVENT_MALLOC 1
 #define PERF_EVENT_FREE 2
+#define PERF_EVENT_PAGE_FAULT 3
+#define PERF_EVENT_CONTEXT_SWITCH_OUT 4
+#define PERF_EVENT_CONTEXT_SWITCH_IN 5
+#define PERF_EVENT_SYSCALL 6
+#define PERF_EVENT_BLOCK_IO_SUBMIT 7
+#define PERF_EVENT_BLOCK_IO_COMPLETE 8
+#define PERF_EVENT_LOCK_WAIT 9
+#define PERF_EVENT_WAKEUP 10
+
+// Not an event: asks the kernel to record the kernel events above for the calling process.
+#define PERF_EVENT_ENABLE_KERNEL_EVENTS 64
 
 int perf_event(int type, uintptr_t arg1, uintptr_t arg2);
 
+#define PERF_COUNTER_CYCLES 0
+#define PERF_COUNTER_INSTRUCTIONS 1
+#define PERF_COUNTER_CACHE_MISSES 2
+#define PERF_COUNTER_BRANCH_MISSES 3
+#define PERF_COUNTER_EVENT_COUNT 4
+
+#define PERF_COUNTERS_ENABLE 1
+#define PERF_COUNTERS_DISABLE 2
+#define PERF_COUNTERS_READ 3
+#define PERF_COUNTERS_SAMPLE 4
+
+// Counts the events in event_mask (1 << PERF_COUNTER_*) in every thread of the process.
+int perf_counters_enable(pid_t, unsigned event_mask);
+int perf_counters_disable(pid_t);
+// Reads the calling thread's counts, one for each of the PERF_COUNTER_EVENT_COUNT events.
+int perf_counters_read(uint64_t* values);
+// Takes a profiling sample every period occurrences of the event, instead of on timer ticks.
+int perf_counters_sample(pid_t, int event, unsigned period);
+
 int get_stack_bounds(uintptr_t* user_stack_base, size_t* user_stack_size);
 
 __END_DECLS
@@ -38,6 +38,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <unistd.h>
@@ -67,7 +68,12 @@ public:
     size_t read(u8*, size_t);
     size_t write(const u8*, size_t);
 
+    // Single bytes go straight to and from the buffer whenever they can.
+    int getc();
+    bool putc(u8);
+
     bool gets(u8*, size_t);
+    ssize_t getdelim(char*& line, size_t& line_capacity, u8 delimiter);
     bool ungetc(u8 byte) { return m_buffer.enqueue_front(byte); }
 
     int seek(long offset, int whence);
@@ -113,6 +119,7 @@ private:
         u8 m_unget_buffer { 0 };
         bool m_ungotten : 1 { false };
         bool m_data_is_malloced : 1 { false };
+        bool m_capacity_was_chosen : 1 { false };
         // When m_begin == m_end, we want to distinguish whether
         // the buffer is full or empty.
         bool m_empty : 1 { true };
@@ -389,6 +396,87 @@ bool FILE::gets(u8* data, size_t size)
     return total_read > 0;
 }
 
+int FILE::getc()
+{
+    if (m_buffer.may_use()) {
+        size_t queued_size;
+        const u8* queued_data = m_buffer.begin_dequeue(queued_size);
+        if (queued_size) {
+            u8 byte = *queued_data;
+            m_buffer.did_dequeue(1);
+            return byte;
+        }
+    }
+    u8 byte;
+    if (read(&byte, 1) != 1)
+        return EOF;
+    return byte;
+}
+
+bool FILE::putc(u8 byte)
+{
+    if (m_buffer.may_use()) {
+        m_buffer.realize(m_fd);
+        size_t available_size;
+        u8* buffer_data = m_buffer.begin_enqueue(available_size);
+        if (available_size) {
+            *buffer_data = byte;
+            m_buffer.did_enqueue(1);
+            if (m_buffer.mode() == _IOLBF && byte == '\n')
+                flush();
+            return true;
+        }
+    }
+    return write(&byte, 1) == 1;
+}
+
+ssize_t FILE::getdelim(char*& line, size_t& line_capacity, u8 delimiter)
+{
+    size_t length = 0;
+
+    // Leaves room for the null terminator.
+    auto append = [&](const u8* data, size_t size) {
+        if (length + size >= line_capacity) {
+            line_capacity = max(line_capacity * 2, length + size + 1);
+            line = static_cast<char*>(realloc(line, line_capacity));
+        }
+        memcpy(line + length, data, size);
+        length += size;
+    };
+
+    for (;;) {
+        if (!m_buffer.may_use()) {
+            u8 byte;
+            if (do_read(&byte, 1) <= 0)
+                break;
+            append(&byte, 1);
+            if (byte == delimiter)
+                break;
+            continue;
+        }
+
+        size_t queued_size;
+        const u8* queued_data = m_buffer.begin_dequeue(queued_size);
+        if (queued_size == 0) {
+            if (read_into_buffer())
+                continue;
+            break;
+        }
+        // Take everything up to the delimiter at once, instead of going through the buffer byte by byte.
+        auto* found = reinterpret_cast<const u8*>(memchr(queued_data, delimiter, queued_size));
+        size_t chunk_size = found ? found - queued_data + 1 : queued_size;
+        append(queued_data, chunk_size);
+        m_buffer.did_dequeue(chunk_size);
+        if (found)
+            break;
+    }
+
+    line[length] = '\0';
+    if (length == 0)
+        return -1;
+    return length;
+}
+
 int FILE::seek(long offset, int whence)
 {
     bool ok = flush();
@@ -420,12 +508,30 @@ FILE::Buffer::~Buffer()
         free(m_data);
 }
 
+// Terminals get BUFSIZ, since they're line buffered anyway. Anything else is read and written in
+// bigger pieces, and whole filesystem blocks at least, so that bulk I/O needs fewer syscalls.
+static size_t preferred_buffer_size(int fd)
+{
+    constexpr size_t min_buffer_size = 16 * KB;
+    constexpr size_t max_buffer_size = 64 * KB;
+    if (isatty(fd))
+        return BUFSIZ;
+    struct stat st;
+    if (fstat(fd, &st) < 0 || st.st_blksize <= 0)
+        return min_buffer_size;
+    return min(max((size_t)st.st_blksize, min_buffer_size), max_buffer_size);
+}
+
 void FILE::Buffer::realize(int fd)
 {
     if (m_mode == -1)
         m_mode = isatty(fd) ? _IOLBF : _IOFBF;
 
     if (m_mode != _IONBF && m_data == nullptr) {
+        if (!m_capacity_was_chosen) {
+            m_capacity = preferred_buffer_size(fd);
+            m_capacity_was_chosen = true;
+        }
         m_data = reinterpret_cast<u8*>(malloc(m_capacity));
         m_data_is_malloced = true;
     }
@@ -438,6 +544,10 @@ void FILE::Buffer::setbuf(u8* data, int mode, size_t size)
     if (data != nullptr) {
         m_data = data;
         m_capacity = size;
+        m_capacity_was_chosen = true;
+    } else if (size != 0) {
+        m_capacity = size;
+        m_capacity_was_chosen = true;
     }
 }
 
@@ -619,11 +729,7 @@ char* fgets(char* buffer, int size, FILE* stream)
 int fgetc(FILE* stream)
 {
     ASSERT(stream);
-    char ch;
-    size_t nread = fread(&ch, sizeof(char), 1, stream);
-    if (nread == 1)
-        return ch;
-    return EOF;
+    return stream->getc();
 }
 
 int getc(FILE* stream)
@@ -631,6 +737,7 @@ int getc(FILE* stream)
     return fgetc(stream);
 }
 
+// FIXME: These are the same as their locked counterparts until FILE gets a lock (see flockfile()).
 int getc_unlocked(FILE* stream)
 {
     return fgetc(stream);
@@ -641,44 +748,21 @@ int getchar()
     return getc(stdin);
 }
 
+int getchar_unlocked()
+{
+    return getc_unlocked(stdin);
+}
+
 ssize_t getdelim(char** lineptr, size_t* n, int delim, FILE* stream)
 {
-    char *ptr, *eptr;
+    ASSERT(stream);
     if (*lineptr == nullptr || *n == 0) {
         *n = BUFSIZ;
         if ((*lineptr = static_cast<char*>(malloc(*n))) == nullptr) {
             return -1;
         }
     }
-
-    for (ptr = *lineptr, eptr = *lineptr + *n;;) {
-        int c = fgetc(stream);
-        if (c == -1) {
-            if (feof(stream)) {
-                *ptr = '\0';
-                return ptr == *lineptr ? -1 : ptr - *lineptr;
-            } else {
-                return -1;
-            }
-        }
-        *ptr++ = c;
-        if (c == delim) {
-            *ptr = '\0';
-            return ptr - *lineptr;
-        }
-        if (ptr + 2 >= eptr) {
-            char* nbuf;
-            size_t nbuf_sz = *n * 2;
-            ssize_t d = ptr - *lineptr;
-            if ((nbuf = static_cast<char*>(realloc(*lineptr, nbuf_sz))) == nullptr) {
-                return -1;
-            }
-            *lineptr = nbuf;
-            *n = nbuf_sz;
-            eptr = nbuf + nbuf_sz;
-            ptr = nbuf + d;
-        }
-    }
+    return stream->getdelim(*lineptr, *n, delim);
 }
 
 ssize_t getline(char** lineptr, size_t* n, FILE* stream)
@@ -697,10 +781,8 @@ int fputc(int ch, FILE* stream)
 {
     ASSERT(stream);
     u8 byte = ch;
-    size_t nwritten = stream->write(&byte, 1);
-    if (nwritten == 0)
+    if (!stream->putc(byte))
         return EOF;
-    ASSERT(nwritten == 1);
     return byte;
 }
 
@@ -709,11 +791,21 @@ int putc(int ch, FILE* stream)
     return fputc(ch, stream);
 }
 
+int putc_unlocked(int ch, FILE* stream)
+{
+    return fputc(ch, stream);
+}
+
 int putchar(int ch)
 {
     return putc(ch, stdout);
 }
 
+int putchar_unlocked(int ch)
+{
+    return putc_unlocked(ch, stdout);
+}
+
 int fputs(const char* s, FILE* stream)
 {
     ASSERT(stream);
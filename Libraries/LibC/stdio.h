@@ -68,6 +68,7 @@ int fgetc(FILE*);
 int getc(FILE*);
 int getc_unlocked(FILE* stream);
 int getchar();
+int getchar_unlocked();
 ssize_t getdelim(char**, size_t*, int, FILE*);
 ssize_t getline(char**, size_t*, FILE*);
 int ungetc(int c, FILE*);
@@ -98,6 +99,8 @@ int sprintf(char* buffer, const char* fmt, ...);
 int snprintf(char* buffer, size_t, const char* fmt, ...);
 int putchar(int ch);
 int putc(int ch, FILE*);
+int putc_unlocked(int ch, FILE*);
+int putchar_unlocked(int ch);
 int puts(const char*);
 int fputs(const char*, FILE*);
 void perror(const char*);
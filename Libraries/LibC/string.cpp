@@ -24,12 +24,14 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <AK/NumericLimits.h>
 #include <AK/Platform.h>
 #include <AK/StdLibExtras.h>
 #include <AK/Types.h>
 #include <assert.h>
 #include <ctype.h>
 #include <errno.h>
+#include <limits.h>
 #include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -37,6 +39,39 @@
 
 extern "C" {
 
+#if ARCH(I386)
+// The SSE2 variants are picked once CPUID has been asked, until then everything uses the plain
+// ones. Both are exported under their own names, so that string_benchmark can compare them.
+static bool s_cpu_supports_sse2;
+
+void __string_init()
+{
+    u32 eax = 1, ebx, ecx = 0, edx;
+    asm volatile("cpuid"
+                 : "+a"(eax), "=b"(ebx), "+c"(ecx), "=d"(edx));
+    s_cpu_supports_sse2 = edx & (1 << 26);
+}
+
+// Returns a bit for every byte of the 16-byte aligned block that is equal to the byte in each lane of pattern.
+// Aligned loads never cross a page boundary, so reading past either end of a string this way is safe.
+[[gnu::target("sse2")]] ALWAYS_INLINE static u32 sse2_match_mask(const void* block, u32 pattern)
+{
+    u32 mask;
+    asm("movd %[pattern], %%xmm1\n"
+        "pshufd $0, %%xmm1, %%xmm1\n"
+        "pcmpeqb (%[block]), %%xmm1\n"
+        "pmovmskb %%xmm1, %[mask]\n"
+        : [mask] "=r"(mask)
+        : [block] "r"(block), [pattern] "r"(pattern), "m"(*(const u8(*)[16])block)
+        : "xmm1");
+    return mask;
+}
+#else
+void __string_init()
+{
+}
+#endif
+
 void bzero(void* dest, size_t n)
 {
     memset(dest, 0, n);
@@ -73,7 +108,7 @@ size_t strcspn(const char* s, const char* reject)
     }
 }
 
-size_t strlen(const char* str)
+size_t __strlen_generic(const char* str)
 {
     size_t len = 0;
     while (*(str++))
@@ -81,6 +116,29 @@ size_t strlen(const char* str)
     return len;
 }
 
+#if ARCH(I386)
+[[gnu::target("sse2")]] size_t __strlen_sse2(const char* str)
+{
+    size_t offset = (FlatPtr)str & 15;
+    auto* block = str - offset;
+    u32 mask = sse2_match_mask(block, 0) & (0xffffu << offset);
+    while (!mask) {
+        block += 16;
+        mask = sse2_match_mask(block, 0);
+    }
+    return block + __builtin_ctz(mask) - str;
+}
+#endif
+
+size_t strlen(const char* str)
+{
+#if ARCH(I386)
+    if (s_cpu_supports_sse2)
+        return __strlen_sse2(str);
+#endif
+    return __strlen_generic(str);
+}
+
 size_t strnlen(const char* str, size_t maxlen)
 {
     size_t len = 0;
@@ -106,7 +164,7 @@ char* strndup(const char* str, size_t maxlen)
     return new_str;
 }
 
-int strcmp(const char* s1, const char* s2)
+int __strcmp_generic(const char* s1, const char* s2)
 {
     while (*s1 == *s2++)
         if (*s1++ == 0)
@@ -114,6 +172,52 @@ int strcmp(const char* s1, const char* s2)
     return *(const unsigned char*)s1 - *(const unsigned char*)--s2;
 }
 
+#if ARCH(I386)
+[[gnu::target("sse2")]] int __strcmp_sse2(const char* s1, const char* s2)
+{
+    constexpr FlatPtr last_safe_page_offset = PAGE_SIZE - 16;
+    for (;;) {
+        // The two strings are hardly ever aligned the same way, so these loads can't be aligned.
+        // Near the end of a page, we go a byte at a time instead, since the next page may not be mapped.
+        if (((FlatPtr)s1 & (PAGE_SIZE - 1)) > last_safe_page_offset || ((FlatPtr)s2 & (PAGE_SIZE - 1)) > last_safe_page_offset) {
+            if (*s1 != *s2 || !*s1)
+                return *(const unsigned char*)s1 - *(const unsigned char*)s2;
+            ++s1;
+            ++s2;
+            continue;
+        }
+        u32 equal_mask;
+        u32 null_mask;
+        asm("movdqu (%[s1]), %%xmm0\n"
+            "movdqu (%[s2]), %%xmm1\n"
+            "pxor %%xmm2, %%xmm2\n"
+            "pcmpeqb %%xmm0, %%xmm2\n"
+            "pcmpeqb %%xmm0, %%xmm1\n"
+            "pmovmskb %%xmm1, %[equal_mask]\n"
+            "pmovmskb %%xmm2, %[null_mask]\n"
+            : [equal_mask] "=r"(equal_mask), [null_mask] "=r"(null_mask)
+            : [s1] "r"(s1), [s2] "r"(s2), "m"(*(const u8(*)[16])s1), "m"(*(const u8(*)[16])s2)
+            : "xmm0", "xmm1", "xmm2");
+        u32 mask = (~equal_mask & 0xffff) | null_mask;
+        if (mask) {
+            size_t index = __builtin_ctz(mask);
+            return ((const unsigned char*)s1)[index] - ((const unsigned char*)s2)[index];
+        }
+        s1 += 16;
+        s2 += 16;
+    }
+}
+#endif
+
+int strcmp(const char* s1, const char* s2)
+{
+#if ARCH(I386)
+    if (s_cpu_supports_sse2)
+        return __strcmp_sse2(s1, s2);
+#endif
+    return __strcmp_generic(s1, s2);
+}
+
 int strncmp(const char* s1, const char* s2, size_t n)
 {
     if (!n)
@@ -187,7 +291,7 @@ void* mmx_memcpy(void* dest, const void* src, size_t len)
     return dest;
 }
 
-void* memcpy(void* dest_ptr, const void* src_ptr, size_t n)
+void* __memcpy_generic(void* dest_ptr, const void* src_ptr, size_t n)
 {
     if (n >= 1024)
         return mmx_memcpy(dest_ptr, src_ptr, n);
@@ -212,7 +316,7 @@ void* memcpy(void* dest_ptr, const void* src_ptr, size_t n)
     return dest_ptr;
 }
 
-void* memset(void* dest_ptr, int c, size_t n)
+void* __memset_generic(void* dest_ptr, int c, size_t n)
 {
     u32 dest = (u32)dest_ptr;
     // FIXME: Support starting at an unaligned address.
@@ -237,6 +341,131 @@ void* memset(void* dest_ptr, int c, size_t n)
         : "memory");
     return dest_ptr;
 }
+
+// Anything bigger than this is unlikely to be read again soon, and would only push everything else out of the cache.
+constexpr size_t min_size_for_non_temporal_copy = 512 * KB;
+
+[[gnu::target("sse2")]] void* __memcpy_sse2(void* dest_ptr, const void* src_ptr, size_t n)
+{
+    if (n < 64)
+        return __memcpy_generic(dest_ptr, src_ptr, n);
+
+    auto* dest = (u8*)dest_ptr;
+    auto* src = (const u8*)src_ptr;
+
+    // The stores below are aligned, the loads can't be in general.
+    // Everything is copied front to back, so memmove() can use this when dest is below src.
+    size_t prologue = -(FlatPtr)dest & 15;
+    n -= prologue;
+    asm volatile(
+        "rep movsb\n"
+        : "+S"(src), "+D"(dest), "+c"(prologue)
+        :
+        : "memory");
+
+    size_t chunks = n / 64;
+    n %= 64;
+    if (chunks && n + chunks * 64 >= min_size_for_non_temporal_copy) {
+        asm volatile(
+            "1:\n"
+            "movdqu (%[src]), %%xmm0\n"
+            "movdqu 16(%[src]), %%xmm1\n"
+            "movdqu 32(%[src]), %%xmm2\n"
+            "movdqu 48(%[src]), %%xmm3\n"
+            "movntdq %%xmm0, (%[dest])\n"
+            "movntdq %%xmm1, 16(%[dest])\n"
+            "movntdq %%xmm2, 32(%[dest])\n"
+            "movntdq %%xmm3, 48(%[dest])\n"
+            "addl $64, %[src]\n"
+            "addl $64, %[dest]\n"
+            "decl %[chunks]\n"
+            "jnz 1b\n"
+            "sfence\n"
+            : [src] "+r"(src), [dest] "+r"(dest), [chunks] "+r"(chunks)
+            :
+            : "memory", "cc", "xmm0", "xmm1", "xmm2", "xmm3");
+    } else if (chunks) {
+        asm volatile(
+            "1:\n"
+            "movdqu (%[src]), %%xmm0\n"
+            "movdqu 16(%[src]), %%xmm1\n"
+            "movdqu 32(%[src]), %%xmm2\n"
+            "movdqu 48(%[src]), %%xmm3\n"
+            "movdqa %%xmm0, (%[dest])\n"
+            "movdqa %%xmm1, 16(%[dest])\n"
+            "movdqa %%xmm2, 32(%[dest])\n"
+            "movdqa %%xmm3, 48(%[dest])\n"
+            "addl $64, %[src]\n"
+            "addl $64, %[dest]\n"
+            "decl %[chunks]\n"
+            "jnz 1b\n"
+            : [src] "+r"(src), [dest] "+r"(dest), [chunks] "+r"(chunks)
+            :
+            : "memory", "cc", "xmm0", "xmm1", "xmm2", "xmm3");
+    }
+
+    asm volatile(
+        "rep movsb\n"
+        : "+S"(src), "+D"(dest), "+c"(n)
+        :
+        : "memory");
+    return dest_ptr;
+}
+
+[[gnu::target("sse2")]] void* __memset_sse2(void* dest_ptr, int c, size_t n)
+{
+    if (n < 64)
+        return __memset_generic(dest_ptr, c, n);
+
+    auto* dest = (u8*)dest_ptr;
+    size_t prologue = -(FlatPtr)dest & 15;
+    n -= prologue;
+    asm volatile(
+        "rep stosb\n"
+        : "+D"(dest), "+c"(prologue)
+        : "a"(c)
+        : "memory");
+
+    size_t chunks = n / 64;
+    n %= 64;
+    if (chunks) {
+        asm volatile(
+            "movd %[pattern], %%xmm0\n"
+            "pshufd $0, %%xmm0, %%xmm0\n"
+            "1:\n"
+            "movdqa %%xmm0, (%[dest])\n"
+            "movdqa %%xmm0, 16(%[dest])\n"
+            "movdqa %%xmm0, 32(%[dest])\n"
+            "movdqa %%xmm0, 48(%[dest])\n"
+            "addl $64, %[dest]\n"
+            "decl %[chunks]\n"
+            "jnz 1b\n"
+            : [dest] "+r"(dest), [chunks] "+r"(chunks)
+            : [pattern] "r"((u8)c * 0x01010101u)
+            : "memory", "cc", "xmm0");
+    }
+
+    asm volatile(
+        "rep stosb\n"
+        : "+D"(dest), "+c"(n)
+        : "a"(c)
+        : "memory");
+    return dest_ptr;
+}
+
+void* memcpy(void* dest_ptr, const void* src_ptr, size_t n)
+{
+    if (s_cpu_supports_sse2)
+        return __memcpy_sse2(dest_ptr, src_ptr, n);
+    return __memcpy_generic(dest_ptr, src_ptr, n);
+}
+
+void* memset(void* dest_ptr, int c, size_t n)
+{
+    if (s_cpu_supports_sse2)
+        return __memset_sse2(dest_ptr, c, n);
+    return __memset_generic(dest_ptr, c, n);
+}
 #else
 void* memcpy(void* dest_ptr, const void* src_ptr, size_t n)
 {
@@ -256,7 +485,7 @@ void* memset(void* dest_ptr, int c, size_t n)
 }
 #endif
 
-void* memmove(void* dest, const void* src, size_t n)
+void* __memmove_generic(void* dest, const void* src, size_t n)
 {
     if (dest < src)
         return memcpy(dest, src, n);
@@ -268,6 +497,38 @@ void* memmove(void* dest, const void* src, size_t n)
     return dest;
 }
 
+#if ARCH(I386)
+[[gnu::target("sse2")]] void* __memmove_sse2(void* dest, const void* src, size_t n)
+{
+    if (dest < src || (const u8*)src + n <= dest)
+        return __memcpy_sse2(dest, src, n);
+
+    // Copying back to front, every block is loaded before the stores can reach it.
+    auto* pd = (u8*)dest;
+    auto* ps = (const u8*)src;
+    for (; n >= 16; n -= 16) {
+        asm volatile(
+            "movdqu (%[src]), %%xmm0\n"
+            "movdqu %%xmm0, (%[dest])\n"
+            :
+            : [src] "r"(ps + n - 16), [dest] "r"(pd + n - 16)
+            : "memory", "xmm0");
+    }
+    while (n--)
+        pd[n] = ps[n];
+    return dest;
+}
+#endif
+
+void* memmove(void* dest, const void* src, size_t n)
+{
+#if ARCH(I386)
+    if (s_cpu_supports_sse2)
+        return __memmove_sse2(dest, src, n);
+#endif
+    return __memmove_generic(dest, src, n);
+}
+
 char* strcpy(char* dest, const char* src)
 {
     char* originalDest = dest;
@@ -306,7 +567,7 @@ char* strchrnul(const char* str, int c)
     }
 }
 
-void* memchr(const void* ptr, int c, size_t size)
+void* __memchr_generic(const void* ptr, int c, size_t size)
 {
     char ch = c;
     auto* cptr = (const char*)ptr;
@@ -317,6 +578,43 @@ void* memchr(const void* ptr, int c, size_t size)
     return nullptr;
 }
 
+#if ARCH(I386)
+[[gnu::target("sse2")]] void* __memchr_sse2(const void* ptr, int c, size_t size)
+{
+    if (!size)
+        return nullptr;
+
+    u32 pattern = (u8)c * 0x01010101u;
+    size_t offset = (FlatPtr)ptr & 15;
+    auto* block = (const u8*)ptr - offset;
+    // The number of bytes from the start of the current block to the end of the range.
+    size_t remaining = size > NumericLimits<size_t>::max() - offset ? NumericLimits<size_t>::max() : size + offset;
+    u32 mask = sse2_match_mask(block, pattern) & (0xffffu << offset);
+    for (;;) {
+        if (mask) {
+            size_t index = __builtin_ctz(mask);
+            if (index >= remaining)
+                return nullptr;
+            return const_cast<u8*>(block + index);
+        }
+        if (remaining <= 16)
+            return nullptr;
+        remaining -= 16;
+        block += 16;
+        mask = sse2_match_mask(block, pattern);
+    }
+}
+#endif
+
+void* memchr(const void* ptr, int c, size_t size)
+{
+#if ARCH(I386)
+    if (s_cpu_supports_sse2)
+        return __memchr_sse2(ptr, c, size);
+#endif
+    return __memchr_generic(ptr, c, size);
+}
+
 char* strrchr(const char* str, int ch)
 {
     char* last = nullptr;
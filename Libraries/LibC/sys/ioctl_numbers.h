@@ -39,6 +39,7 @@ struct FBResolution {
     unsigned pitch;
     unsigned width;
     unsigned height;
+    unsigned bpp;
 };
 
 __END_DECLS
@@ -119,4 +119,29 @@ int getpeername(int sockfd, struct sockaddr* addr, socklen_t* addrlen)
     int rc = syscall(SC_getpeername, &params);
     __RETURN_WITH_ERRNO(rc, rc, -1);
 }
+
+int sendfds(int sockfd, const int* fds, int count)
+{
+    int rc = syscall(SC_sendfds, sockfd, fds, count);
+    __RETURN_WITH_ERRNO(rc, rc, -1);
+}
+
+int recvfds(int sockfd, int* fds, int count)
+{
+    int rc = syscall(SC_recvfds, sockfd, fds, count);
+    __RETURN_WITH_ERRNO(rc, rc, -1);
+}
+
+int sendfd(int sockfd, int fd)
+{
+    return sendfds(sockfd, &fd, 1);
+}
+
+int recvfd(int sockfd)
+{
+    int fd = -1;
+    if (recvfds(sockfd, &fd, 1) < 0)
+        return -1;
+    return fd;
+}
 }
@@ -84,6 +84,7 @@ struct ucred {
 #define SO_PEERCRED 5
 #define SO_REUSEADDR 6
 #define SO_BINDTODEVICE 7
+#define SO_REUSEPORT 8
 #define SO_KEEPALIVE 9
 
 int socket(int domain, int type, int protocol);
@@ -100,5 +101,9 @@ int getsockopt(int sockfd, int level, int option, void*, socklen_t*);
 int setsockopt(int sockfd, int level, int option, const void*, socklen_t);
 int getsockname(int sockfd, struct sockaddr*, socklen_t*);
 int getpeername(int sockfd, struct sockaddr*, socklen_t*);
+int sendfds(int sockfd, const int* fds, int count);
+int recvfds(int sockfd, int* fds, int count);
+int sendfd(int sockfd, int fd);
+int recvfd(int sockfd);
 
 __END_DECLS
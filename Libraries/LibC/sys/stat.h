@@ -60,6 +60,7 @@ mode_t umask(mode_t);
 int chmod(const char* pathname, mode_t);
 int fchmod(int fd, mode_t);
 int mkdir(const char* pathname, mode_t);
+int fstatat(int fd, const char* path, struct stat* statbuf, int flags);
 
 inline dev_t makedev(unsigned int major, unsigned int minor) { return (minor & 0xffu) | (major << 8u) | ((minor & ~0xffu) << 12u); }
 inline unsigned int major(dev_t dev) { return (dev & 0xfff00u) >> 8u; }
@@ -92,8 +92,9 @@ typedef struct __pthread_mutexattr_t {
 
 typedef struct __pthread_cond_t {
     int32_t value;
-    uint32_t previous;
+    uint32_t waiters;
     int clockid; // clockid_t
+    pthread_mutex_t* mutex;
 } pthread_cond_t;
 
 typedef void* pthread_rwlock_t;
@@ -27,6 +27,7 @@
 #include <AK/String.h>
 #include <AK/StringBuilder.h>
 #include <Kernel/Syscall.h>
+#include <Kernel/TimePage.h>
 #include <assert.h>
 #include <errno.h>
 #include <stdio.h>
@@ -37,6 +38,49 @@
 
 extern "C" {
 
+static const TimePage* s_time_page;
+static bool s_time_page_unavailable;
+
+static const TimePage* time_page()
+{
+    if (s_time_page || s_time_page_unavailable)
+        return s_time_page;
+    // If two threads race here we just end up with the page mapped twice, which is harmless.
+    int rc = syscall(SC_map_time_page);
+    if (rc < 0 && -rc < EMAXERRNO) {
+        s_time_page_unavailable = true;
+        return nullptr;
+    }
+    s_time_page = (const TimePage*)rc;
+    return s_time_page;
+}
+
+// Returns false if the kernel isn't keeping the time page up to date, and we have to ask it instead.
+static bool read_time_page(clockid_t clock_id, struct timespec& ts)
+{
+    auto* page = time_page();
+    if (!page)
+        return false;
+    for (;;) {
+        u32 sequence = __atomic_load_n(&page->update_sequence, __ATOMIC_ACQUIRE);
+        if (sequence & 1)
+            continue;
+        if (!page->is_updated)
+            return false;
+        if (clock_id == CLOCK_MONOTONIC) {
+            u64 now = page->monotonic_nanoseconds;
+            ts.tv_sec = now / 1'000'000'000;
+            ts.tv_nsec = now % 1'000'000'000;
+        } else {
+            ts.tv_sec = page->epoch_seconds;
+            ts.tv_nsec = page->epoch_nanoseconds;
+        }
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&page->update_sequence, __ATOMIC_RELAXED) == sequence)
+            return true;
+    }
+}
+
 time_t time(time_t* tloc)
 {
     struct timeval tv;
@@ -50,6 +94,12 @@ time_t time(time_t* tloc)
 
 int gettimeofday(struct timeval* __restrict__ tv, void* __restrict__)
 {
+    struct timespec ts;
+    if (read_time_page(CLOCK_REALTIME, ts)) {
+        tv->tv_sec = ts.tv_sec;
+        tv->tv_usec = ts.tv_nsec / 1000;
+        return 0;
+    }
     int rc = syscall(SC_gettimeofday, tv);
     __RETURN_WITH_ERRNO(rc, rc, -1);
 }
@@ -313,6 +363,8 @@ clock_t clock()
 
 int clock_gettime(clockid_t clock_id, struct timespec* ts)
 {
+    if ((clock_id == CLOCK_MONOTONIC || clock_id == CLOCK_REALTIME) && read_time_page(clock_id, *ts))
+        return 0;
     int rc = syscall(SC_clock_gettime, clock_id, ts);
     __RETURN_WITH_ERRNO(rc, rc, -1);
 }
@@ -0,0 +1,425 @@
+/*
+ * Copyright (c) 2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/StdLibExtras.h>
+#include <LibCompress/Inflate.h>
+#include <string.h>
+
+namespace Compress {
+
+static constexpr u16 length_base[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+static constexpr u8 length_extra_bits[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+static constexpr u16 distance_base[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+static constexpr u8 distance_extra_bits[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+static constexpr u8 code_length_order[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+Inflater::Inflater(const u8* data, size_t size)
+    : m_input(data)
+    , m_input_size(size)
+    , m_window(ByteBuffer::create_uninitialized(window_size))
+{
+}
+
+Inflater::Inflater()
+    : m_input_is_closed(false)
+    , m_window(ByteBuffer::create_uninitialized(window_size))
+{
+}
+
+void Inflater::append_input(const u8* data, size_t size)
+{
+    ASSERT(!m_input_is_closed);
+    if (!size)
+        return;
+    size_t remaining = m_input_size - m_input_offset;
+    if (m_input_offset) {
+        memmove(m_input_buffer.data(), m_input_buffer.data() + m_input_offset, remaining);
+        m_input_buffer.trim(remaining);
+        m_discarded_input_size += m_input_offset;
+        m_input_offset = 0;
+    }
+    m_input_buffer.append(data, size);
+    m_input = m_input_buffer.data();
+    m_input_size = m_input_buffer.size();
+}
+
+void Inflater::close_input()
+{
+    m_input_is_closed = true;
+}
+
+bool Inflater::ensure_bits(u32 count)
+{
+    if (m_input_offset + 8 <= m_input_size) {
+        // Top the bit buffer up to at least 56 bits with a single unaligned load.
+        u64 word;
+        memcpy(&word, m_input + m_input_offset, sizeof(word));
+        m_bit_buffer |= word << m_bit_count;
+        m_input_offset += (63 - m_bit_count) >> 3;
+        m_bit_count |= 56;
+        return true;
+    }
+    while (m_bit_count <= 56 && m_input_offset < m_input_size) {
+        m_bit_buffer |= (u64)m_input[m_input_offset++] << m_bit_count;
+        m_bit_count += 8;
+    }
+    return m_bit_count >= count;
+}
+
+u32 Inflater::read_bits(u32 count)
+{
+    if (!count)
+        return 0;
+    if (m_bit_count < count && !ensure_bits(count)) {
+        fail();
+        return 0;
+    }
+    u32 value = m_bit_buffer & ((1u << count) - 1);
+    m_bit_buffer >>= count;
+    m_bit_count -= count;
+    return value;
+}
+
+bool Inflater::build_table(HuffmanTable& table, const u8* lengths, size_t count)
+{
+    memset(table.counts, 0, sizeof(table.counts));
+    for (size_t i = 0; i < count; ++i)
+        ++table.counts[lengths[i]];
+    table.counts[0] = 0;
+
+    // Refuse over-subscribed codes. Incomplete ones are fine, decoding fails if it ever hits a hole.
+    int left = 1;
+    for (int length = 1; length < 16; ++length) {
+        left <<= 1;
+        left -= table.counts[length];
+        if (left < 0)
+            return false;
+    }
+
+    u16 offsets[16];
+    u16 next_code[16];
+    offsets[1] = 0;
+    next_code[1] = 0;
+    for (int length = 1; length < 15; ++length) {
+        offsets[length + 1] = offsets[length] + table.counts[length];
+        next_code[length + 1] = (next_code[length] + table.counts[length]) << 1;
+    }
+
+    memset(table.fast, 0, sizeof(table.fast));
+    for (size_t symbol = 0; symbol < count; ++symbol) {
+        u8 length = lengths[symbol];
+        if (!length)
+            continue;
+        table.symbols[offsets[length]++] = symbol;
+
+        // Codes are stored most significant bit first, but the input is read from the least significant bit.
+        u32 code = next_code[length]++;
+        if (length > fast_bits)
+            continue;
+        u32 reversed = 0;
+        for (int i = 0; i < length; ++i)
+            reversed |= ((code >> i) & 1) << (length - 1 - i);
+        for (u32 index = reversed; index < (1u << fast_bits); index += 1u << length)
+            table.fast[index] = symbol | (length << 9);
+    }
+    return true;
+}
+
+ALWAYS_INLINE int Inflater::decode_symbol(const HuffmanTable& table)
+{
+    if (m_bit_count < 15)
+        ensure_bits(15);
+    u16 entry = table.fast[m_bit_buffer & ((1 << fast_bits) - 1)];
+    if (entry) {
+        u32 length = entry >> 9;
+        if (length > m_bit_count)
+            return -1;
+        m_bit_buffer >>= length;
+        m_bit_count -= length;
+        return entry & 0x1ff;
+    }
+
+    // A code longer than fast_bits, decoded one bit at a time.
+    int code = 0;
+    int first = 0;
+    int index = 0;
+    u64 bits = m_bit_buffer;
+    for (u32 length = 1; length < 16 && length <= m_bit_count; ++length) {
+        code |= bits & 1;
+        bits >>= 1;
+        int count = table.counts[length];
+        if (code - count < first) {
+            m_bit_buffer >>= length;
+            m_bit_count -= length;
+            return table.symbols[index + (code - first)];
+        }
+        index += count;
+        first += count;
+        first <<= 1;
+        code <<= 1;
+    }
+    return -1;
+}
+
+bool Inflater::read_dynamic_tables()
+{
+    u32 literal_count = read_bits(5) + 257;
+    u32 distance_count = read_bits(5) + 1;
+    u32 code_length_count = read_bits(4) + 4;
+    if (has_error() || literal_count > 286 || distance_count > 30)
+        return false;
+
+    u8 lengths[286 + 30];
+    memset(lengths, 0, 19);
+    for (u32 i = 0; i < code_length_count; ++i)
+        lengths[code_length_order[i]] = read_bits(3);
+    if (has_error())
+        return false;
+
+    // The code length code is only needed while reading the other two, so the distance table holds it meanwhile.
+    if (!build_table(m_distance_table, lengths, 19))
+        return false;
+
+    u32 index = 0;
+    while (index < literal_count + distance_count) {
+        int symbol = decode_symbol(m_distance_table);
+        if (symbol < 0)
+            return false;
+        if (symbol < 16) {
+            lengths[index++] = symbol;
+            continue;
+        }
+        u8 length = 0;
+        u32 repeat;
+        if (symbol == 16) {
+            if (!index)
+                return false;
+            length = lengths[index - 1];
+            repeat = 3 + read_bits(2);
+        } else if (symbol == 17) {
+            repeat = 3 + read_bits(3);
+        } else {
+            repeat = 11 + read_bits(7);
+        }
+        if (has_error() || index + repeat > literal_count + distance_count)
+            return false;
+        while (repeat--)
+            lengths[index++] = length;
+    }
+
+    // Without a code for end-of-block, the block could never end.
+    if (!lengths[256])
+        return false;
+
+    return build_table(m_literal_table, lengths, literal_count)
+        && build_table(m_distance_table, lengths + literal_count, distance_count);
+}
+
+bool Inflater::read_block_header()
+{
+    m_is_final_block = read_bits(1);
+    u32 type = read_bits(2);
+    if (has_error())
+        return false;
+
+    switch (type) {
+    case 0: {
+        // Stored blocks start at the next byte boundary.
+        read_bits(m_bit_count % 8);
+        u32 length = read_bits(16);
+        u32 inverted_length = read_bits(16);
+        if (has_error() || length != (~inverted_length & 0xffff))
+            return false;
+        m_stored_remaining = length;
+        m_state = State::StoredBlock;
+        return true;
+    }
+    case 1: {
+        u8 lengths[288];
+        memset(lengths, 8, 144);
+        memset(lengths + 144, 9, 112);
+        memset(lengths + 256, 7, 24);
+        memset(lengths + 280, 8, 8);
+        build_table(m_literal_table, lengths, 288);
+        memset(lengths, 5, 30);
+        build_table(m_distance_table, lengths, 30);
+        m_state = State::HuffmanBlock;
+        return true;
+    }
+    case 2:
+        if (!read_dynamic_tables())
+            return false;
+        m_state = State::HuffmanBlock;
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Copies `length` bytes that start `distance` bytes before `destination`. The two may overlap, in which
+// case the bytes repeat, so only runs that are at least eight bytes apart are copied a word at a time.
+ALWAYS_INLINE static void copy_match(u8* destination, size_t distance, size_t length)
+{
+    const u8* source = destination - distance;
+    size_t i = 0;
+    if (distance >= sizeof(u64)) {
+        for (; i + sizeof(u64) <= length; i += sizeof(u64)) {
+            u64 word;
+            memcpy(&word, source + i, sizeof(word));
+            memcpy(destination + i, &word, sizeof(word));
+        }
+    }
+    for (; i < length; ++i)
+        destination[i] = source[i];
+}
+
+size_t Inflater::read(u8* buffer, size_t size)
+{
+    // Back-references are copied straight out of `buffer` when they reach back no further than this call's
+    // output, and out of the window of earlier output otherwise. The window is only updated on return.
+    const u8* window = m_window.data();
+    const size_t window_mask = window_size - 1;
+    size_t produced = 0;
+
+    auto finish = [&] {
+        size_t count = min(produced, window_size);
+        u8* window = m_window.data();
+        for (size_t i = produced - count; i < produced; ++i)
+            window[(m_total_out + i) & window_mask] = buffer[i];
+        m_total_out += produced;
+        return produced;
+    };
+
+    while (produced < size) {
+        if (m_copy_length) {
+            size_t count = min(m_copy_length, size - produced);
+            u8* destination = buffer + produced;
+            if (m_copy_distance <= produced) {
+                copy_match(destination, m_copy_distance, count);
+            } else {
+                for (size_t i = 0; i < count; ++i) {
+                    size_t position = produced + i;
+                    destination[i] = position >= m_copy_distance
+                        ? buffer[position - m_copy_distance]
+                        : window[(m_total_out + position - m_copy_distance) & window_mask];
+                }
+            }
+            produced += count;
+            m_copy_length -= count;
+            continue;
+        }
+
+        if (!has_input_for_next_step())
+            return finish();
+
+        switch (m_state) {
+        case State::BlockHeader:
+            if (!read_block_header())
+                fail();
+            break;
+        case State::StoredBlock:
+            if (!m_stored_remaining) {
+                finish_block();
+                break;
+            }
+            while (m_stored_remaining && produced < size && has_input_for_next_step()) {
+                u8 byte = read_bits(8);
+                if (has_error())
+                    break;
+                buffer[produced++] = byte;
+                --m_stored_remaining;
+            }
+            break;
+        case State::HuffmanBlock:
+            while (produced < size && !m_copy_length && has_input_for_next_step()) {
+                int symbol = decode_symbol(m_literal_table);
+                if (symbol < 256) {
+                    if (symbol < 0) {
+                        fail();
+                        break;
+                    }
+                    buffer[produced++] = symbol;
+                    continue;
+                }
+                if (symbol == 256) {
+                    finish_block();
+                    break;
+                }
+                symbol -= 257;
+                if (symbol >= 29) {
+                    fail();
+                    break;
+                }
+                size_t length = length_base[symbol] + read_bits(length_extra_bits[symbol]);
+                int distance_symbol = decode_symbol(m_distance_table);
+                if (distance_symbol < 0 || distance_symbol >= 30) {
+                    fail();
+                    break;
+                }
+                size_t distance = distance_base[distance_symbol] + read_bits(distance_extra_bits[distance_symbol]);
+                if (has_error() || distance > min(m_total_out + produced, window_size)) {
+                    fail();
+                    break;
+                }
+                if (distance <= produced && length <= size - produced) {
+                    // The common case: the whole match is in this call's output, and fits.
+                    copy_match(buffer + produced, distance, length);
+                    produced += length;
+                    continue;
+                }
+                m_copy_length = length;
+                m_copy_distance = distance;
+            }
+            break;
+        case State::Finished:
+        case State::Error:
+            return finish();
+        }
+    }
+
+    return finish();
+}
+
+Optional<ByteBuffer> Inflater::decompress_all(const u8* data, size_t size)
+{
+    Inflater inflater(data, size);
+    auto output = ByteBuffer::create_uninitialized(max(size * 4, (size_t)4 * KB));
+    size_t output_size = 0;
+    for (;;) {
+        size_t wanted = output.size() - output_size;
+        size_t nread = inflater.read(output.data() + output_size, wanted);
+        output_size += nread;
+        if (nread < wanted)
+            break;
+        output.grow(output.size() * 2);
+    }
+    if (!inflater.is_finished())
+        return {};
+    output.trim(output_size);
+    return output;
+}
+
+}
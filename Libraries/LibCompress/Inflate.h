@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/ByteBuffer.h>
+#include <AK/Optional.h>
+#include <AK/Types.h>
+
+namespace Compress {
+
+// A table-driven decoder for raw DEFLATE streams (RFC 1951), as found inside zlib, gzip and zip files.
+// The output can be pulled out in pieces of any size, so callers don't need a buffer for all of it.
+// The compressed stream is either all in memory up front, or handed over in pieces as it arrives.
+class Inflater {
+public:
+    // Decompresses `data`, which has to stay around for as long as the inflater does.
+    Inflater(const u8* data, size_t size);
+
+    // Decompresses whatever is passed to append_input(), which is copied, until close_input() is called.
+    Inflater();
+
+    void append_input(const u8* data, size_t size);
+    void close_input();
+
+    // Decompresses up to `size` more bytes into `buffer` and returns how many were written.
+    // Fewer than `size` bytes are only returned at the end of the stream, after an error,
+    // or when more input needs to be appended before going on.
+    size_t read(u8* buffer, size_t size);
+
+    bool is_finished() const { return m_state == State::Finished; }
+    bool has_error() const { return m_state == State::Error; }
+
+    // How much of the input has been consumed, e.g. to find a trailer after the stream.
+    size_t consumed_input_size() const { return m_discarded_input_size + m_input_offset - m_bit_count / 8; }
+
+    static Optional<ByteBuffer> decompress_all(const u8* data, size_t size);
+
+private:
+    enum class State {
+        BlockHeader,
+        StoredBlock,
+        HuffmanBlock,
+        Finished,
+        Error,
+    };
+
+    static constexpr int fast_bits = 10;
+    static constexpr size_t window_size = 32 * KB;
+
+    // The most input any single step of decoding can need, which is a block header with the largest dynamic tables.
+    // Until the input is closed, a step is only started with this much of it at hand, so none runs out halfway.
+    static constexpr size_t max_step_input_size = 600;
+    bool has_input_for_next_step() const { return m_input_is_closed || m_input_offset + max_step_input_size <= m_input_size; }
+
+    struct HuffmanTable {
+        // Indexed by the next fast_bits bits of input: the symbol in the low 9 bits and the length
+        // of its code above them, or 0 if the code is longer than fast_bits.
+        u16 fast[1 << fast_bits];
+        // Canonical code counts per length, and the symbols in code order, for the longer codes.
+        u16 counts[16];
+        u16 symbols[288];
+    };
+
+    static bool build_table(HuffmanTable&, const u8* lengths, size_t count);
+
+    bool read_block_header();
+    bool read_dynamic_tables();
+    int decode_symbol(const HuffmanTable&);
+    void finish_block() { m_state = m_is_final_block ? State::Finished : State::BlockHeader; }
+
+    bool ensure_bits(u32 count);
+    u32 read_bits(u32 count);
+    void fail() { m_state = State::Error; }
+
+    const u8* m_input { nullptr };
+    size_t m_input_size { 0 };
+    size_t m_input_offset { 0 };
+    bool m_input_is_closed { true };
+    // Our copy of appended input, of which consumed bytes are dropped as more arrives.
+    ByteBuffer m_input_buffer;
+    size_t m_discarded_input_size { 0 };
+    u64 m_bit_buffer { 0 };
+    u32 m_bit_count { 0 };
+
+    State m_state { State::BlockHeader };
+    bool m_is_final_block { false };
+    size_t m_stored_remaining { 0 };
+    size_t m_copy_length { 0 };
+    size_t m_copy_distance { 0 };
+
+    ByteBuffer m_window;
+    size_t m_total_out { 0 };
+
+    HuffmanTable m_literal_table;
+    HuffmanTable m_distance_table;
+};
+
+}
@@ -98,4 +98,11 @@ String DirIterator::next_full_path()
     return String::format("%s/%s", m_path.characters(), next_path().characters());
 }
 
+int DirIterator::fd() const
+{
+    if (!m_dir)
+        return -1;
+    return dirfd(m_dir);
+}
+
 }
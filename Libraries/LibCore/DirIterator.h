@@ -49,6 +49,8 @@ public:
     bool has_next();
     String next_path();
     String next_full_path();
+    // The directory being iterated, for looking up entries with fstatat() instead of full paths.
+    int fd() const;
 
 private:
     DIR* m_dir = nullptr;
@@ -29,6 +29,7 @@
 #include <AK/JsonObject.h>
 #include <AK/JsonValue.h>
 #include <AK/NeverDestroyed.h>
+#include <AK/SegmentedStringBuilder.h>
 #include <AK/Time.h>
 #include <LibCore/Event.h>
 #include <LibCore/EventLoop.h>
@@ -50,6 +51,11 @@
 #include <time.h>
 #include <unistd.h>
 
+#if defined(__serenity__) || defined(__linux__)
+#    define CEVENTLOOP_USE_EPOLL
+#    include <sys/epoll.h>
+#endif
+
 //#define CEVENTLOOP_DEBUG
 //#define DEFERRED_INVOKE_DEBUG
 
@@ -64,9 +70,79 @@ struct EventLoopTimer {
     bool should_reload { false };
     TimerShouldFireWhenNotVisible fire_when_not_visible { TimerShouldFireWhenNotVisible::No };
     WeakPtr<Object> owner;
+    size_t heap_index { 0 };
+    bool is_parked { false };
 
     void reload(const timeval& now);
     bool has_expired(const timeval& now) const;
+    bool fires_before(const EventLoopTimer& other) const;
+    bool is_waiting_for_visibility() const;
+};
+
+// A binary min-heap of timers ordered by fire time. The next timer to fire is always on top, and since every timer
+// knows its slot, adding, removing and rescheduling one are O(log n) no matter how many timers there are.
+class TimerHeap {
+public:
+    bool is_empty() const { return m_timers.is_empty(); }
+    EventLoopTimer& peek_min() { return *m_timers.first(); }
+
+    void insert(EventLoopTimer& timer)
+    {
+        timer.heap_index = m_timers.size();
+        m_timers.append(&timer);
+        sift_up(timer.heap_index);
+    }
+
+    void remove(EventLoopTimer& timer)
+    {
+        size_t index = timer.heap_index;
+        ASSERT(m_timers[index] == &timer);
+        auto* last = m_timers.take_last();
+        if (last == &timer)
+            return;
+        m_timers[index] = last;
+        last->heap_index = index;
+        sift_up(index);
+        sift_down(last->heap_index);
+    }
+
+private:
+    void swap_slots(size_t a, size_t b)
+    {
+        swap(m_timers[a], m_timers[b]);
+        m_timers[a]->heap_index = a;
+        m_timers[b]->heap_index = b;
+    }
+
+    void sift_up(size_t index)
+    {
+        while (index > 0) {
+            size_t parent = (index - 1) / 2;
+            if (!m_timers[index]->fires_before(*m_timers[parent]))
+                break;
+            swap_slots(index, parent);
+            index = parent;
+        }
+    }
+
+    void sift_down(size_t index)
+    {
+        for (;;) {
+            size_t smallest = index;
+            size_t left = index * 2 + 1;
+            size_t right = left + 1;
+            if (left < m_timers.size() && m_timers[left]->fires_before(*m_timers[smallest]))
+                smallest = left;
+            if (right < m_timers.size() && m_timers[right]->fires_before(*m_timers[smallest]))
+                smallest = right;
+            if (smallest == index)
+                break;
+            swap_slots(index, smallest);
+            index = smallest;
+        }
+    }
+
+    Vector<EventLoopTimer*> m_timers;
 };
 
 struct EventLoop::Private {
@@ -75,10 +151,67 @@ struct EventLoop::Private {
 
 static EventLoop* s_main_event_loop;
 static Vector<EventLoop*>* s_event_loop_stack;
+// Held while loops are pushed and popped, so other threads can post to the current one.
+static LibThread::Lock s_event_loop_stack_lock;
 static NeverDestroyed<IDAllocator> s_id_allocator;
 static HashMap<int, NonnullOwnPtr<EventLoopTimer>>* s_timers;
+static TimerHeap* s_timer_heap;
+// Timers that came due while their owner wasn't visible are set aside here, and fire once it is again.
+static Vector<EventLoopTimer*>* s_parked_timers;
 static HashTable<Notifier*>* s_notifiers;
 int EventLoop::s_wake_pipe_fds[2];
+
+#ifdef CEVENTLOOP_USE_EPOLL
+// Instead of handing the kernel every fd on every wait, we keep a persistent epoll set
+// that is only touched when notifiers come and go or change their event mask.
+struct EpollInterest {
+    Vector<Notifier*, 1> notifiers;
+    unsigned registered_mask { 0 };
+};
+static int s_epoll_fd = -1;
+static HashMap<int, EpollInterest>* s_epoll_interests;
+
+static void update_epoll_interest(int fd)
+{
+    auto it = s_epoll_interests->find(fd);
+    if (it == s_epoll_interests->end())
+        return;
+    auto& interest = it->value;
+
+    unsigned mask = 0;
+    for (auto* notifier : interest.notifiers)
+        mask |= notifier->event_mask();
+    if (mask & Notifier::Exceptional)
+        ASSERT_NOT_REACHED();
+
+    if (mask != interest.registered_mask) {
+        epoll_event event {};
+        event.data.fd = fd;
+        if (mask & Notifier::Read)
+            event.events |= EPOLLIN;
+        if (mask & Notifier::Write)
+            event.events |= EPOLLOUT;
+
+        int op = EPOLL_CTL_MOD;
+        if (!interest.registered_mask)
+            op = EPOLL_CTL_ADD;
+        else if (!mask)
+            op = EPOLL_CTL_DEL;
+        int rc = epoll_ctl(s_epoll_fd, op, fd, &event);
+        if (rc < 0 && op == EPOLL_CTL_ADD && errno == EEXIST)
+            rc = epoll_ctl(s_epoll_fd, EPOLL_CTL_MOD, fd, &event);
+        // If the fd has already been closed, the kernel has forgotten about it by itself.
+        if (rc < 0 && errno != EBADF && errno != ENOENT) {
+            perror("epoll_ctl");
+            ASSERT_NOT_REACHED();
+        }
+        interest.registered_mask = mask;
+    }
+
+    if (interest.notifiers.is_empty())
+        s_epoll_interests->remove(it);
+}
+#endif
 static RefPtr<LocalServer> s_rpc_server;
 HashMap<int, RefPtr<RPCClient>> s_rpc_clients;
 
@@ -120,10 +253,13 @@ public:
 
     void send_response(const JsonObject& response)
     {
-        auto serialized = response.to_string();
-        u32 length = serialized.length();
+        SegmentedStringBuilder builder;
+        response.serialize(builder);
+        u32 length = builder.length();
         m_socket->write((const u8*)&length, sizeof(length));
-        m_socket->write(serialized);
+        builder.for_each_segment([&](const StringView& segment) {
+            m_socket->write(segment);
+        });
     }
 
     void handle_request(const JsonObject& request)
@@ -218,7 +354,12 @@ EventLoop::EventLoop()
     if (!s_event_loop_stack) {
         s_event_loop_stack = new Vector<EventLoop*>;
         s_timers = new HashMap<int, NonnullOwnPtr<EventLoopTimer>>;
+        s_timer_heap = new TimerHeap;
+        s_parked_timers = new Vector<EventLoopTimer*>;
         s_notifiers = new HashTable<Notifier*>;
+#ifdef CEVENTLOOP_USE_EPOLL
+        s_epoll_interests = new HashMap<int, EpollInterest>;
+#endif
     }
 
     if (!s_main_event_loop) {
@@ -232,6 +373,15 @@ EventLoop::EventLoop()
 
 #endif
         ASSERT(rc == 0);
+#ifdef CEVENTLOOP_USE_EPOLL
+        s_epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        ASSERT(s_epoll_fd >= 0);
+        epoll_event wake_event {};
+        wake_event.events = EPOLLIN;
+        wake_event.data.fd = s_wake_pipe_fds[0];
+        rc = epoll_ctl(s_epoll_fd, EPOLL_CTL_ADD, s_wake_pipe_fds[0], &wake_event);
+        ASSERT(rc == 0);
+#endif
         s_event_loop_stack->append(this);
 
         if (!s_rpc_server) {
@@ -312,6 +462,7 @@ public:
         : m_event_loop(event_loop)
     {
         if (&m_event_loop != s_main_event_loop) {
+            LOCKER(s_event_loop_stack_lock);
             m_event_loop.take_pending_events_from(EventLoop::current());
             s_event_loop_stack->append(&event_loop);
         }
@@ -319,6 +470,7 @@ public:
     ~EventLoopPusher()
     {
         if (&m_event_loop != s_main_event_loop) {
+            LOCKER(s_event_loop_stack_lock);
             s_event_loop_stack->take_last();
             EventLoop::current().take_pending_events_from(m_event_loop);
         }
@@ -400,8 +552,18 @@ void EventLoop::post_event(Object& receiver, NonnullOwnPtr<Event>&& event)
     m_queued_events.empend(receiver, move(event));
 }
 
+void EventLoop::post_event_to_current_loop(Object& receiver, NonnullOwnPtr<Event>&& event)
+{
+    {
+        LOCKER(s_event_loop_stack_lock);
+        current().post_event(receiver, move(event));
+    }
+    wake();
+}
+
 void EventLoop::wait_for_event(WaitMode mode)
 {
+#ifndef CEVENTLOOP_USE_EPOLL
     fd_set rfds;
     fd_set wfds;
     FD_ZERO(&rfds);
@@ -425,6 +587,7 @@ void EventLoop::wait_for_event(WaitMode mode)
         if (notifier->event_mask() & Notifier::Exceptional)
             ASSERT_NOT_REACHED();
     }
+#endif
 
     bool queued_events_is_empty;
     {
@@ -452,8 +615,7 @@ void EventLoop::wait_for_event(WaitMode mode)
         }
     }
 
-    int marked_fd_count = Core::safe_syscall(select, max_fd + 1, &rfds, &wfds, nullptr, should_wait_forever ? nullptr : &timeout);
-    if (FD_ISSET(s_wake_pipe_fds[0], &rfds)) {
+    auto drain_wake_pipe = [] {
         char buffer[32];
         auto nread = read(s_wake_pipe_fds[0], buffer, sizeof(buffer));
         if (nread < 0) {
@@ -461,7 +623,23 @@ void EventLoop::wait_for_event(WaitMode mode)
             ASSERT_NOT_REACHED();
         }
         ASSERT(nread > 0);
+    };
+
+#ifdef CEVENTLOOP_USE_EPOLL
+    int timeout_ms = -1;
+    if (!should_wait_forever)
+        timeout_ms = timeout.tv_sec * 1000 + (timeout.tv_usec + 999) / 1000;
+    epoll_event ready_events[64];
+    int marked_fd_count = Core::safe_syscall(epoll_wait, s_epoll_fd, ready_events, 64, timeout_ms);
+    for (int i = 0; i < marked_fd_count; ++i) {
+        if (ready_events[i].data.fd == s_wake_pipe_fds[0])
+            drain_wake_pipe();
     }
+#else
+    int marked_fd_count = Core::safe_syscall(select, max_fd + 1, &rfds, &wfds, nullptr, should_wait_forever ? nullptr : &timeout);
+    if (FD_ISSET(s_wake_pipe_fds[0], &rfds))
+        drain_wake_pipe();
+#endif
 
     if (!s_timers->is_empty()) {
         timespec now_spec;
@@ -470,30 +648,65 @@ void EventLoop::wait_for_event(WaitMode mode)
         now.tv_usec = now_spec.tv_nsec / 1000;
     }
 
-    for (auto& it : *s_timers) {
-        auto& timer = *it.value;
-        if (!timer.has_expired(now))
-            continue;
-        if (it.value->fire_when_not_visible == TimerShouldFireWhenNotVisible::No
-            && it.value->owner
-            && !it.value->owner->is_visible_for_timer_purposes()) {
-            continue;
-        }
+    auto fire_timer = [&](EventLoopTimer& timer) {
 #ifdef CEVENTLOOP_DEBUG
         dbg() << "Core::EventLoop: Timer " << timer.timer_id << " has expired, sending Core::TimerEvent to " << timer.owner;
 #endif
         post_event(*timer.owner, make<TimerEvent>(timer.timer_id));
-        if (timer.should_reload) {
-            timer.reload(now);
-        } else {
-            // FIXME: Support removing expired timers that don't want to reload.
-            ASSERT_NOT_REACHED();
+        // FIXME: Support removing expired timers that don't want to reload.
+        ASSERT(timer.should_reload);
+        timer.reload(now);
+    };
+
+    for (size_t i = 0; i < s_parked_timers->size();) {
+        auto& timer = *s_parked_timers->at(i);
+        if (timer.is_waiting_for_visibility()) {
+            ++i;
+            continue;
         }
+        s_parked_timers->remove(i);
+        timer.is_parked = false;
+        fire_timer(timer);
+        s_timer_heap->insert(timer);
     }
 
+    // Reloaded timers only go back into the heap afterwards, so a zero interval can't keep us here forever.
+    Vector<EventLoopTimer*, 16> fired_timers;
+    while (!s_timer_heap->is_empty() && s_timer_heap->peek_min().has_expired(now)) {
+        auto& timer = s_timer_heap->peek_min();
+        s_timer_heap->remove(timer);
+        if (timer.is_waiting_for_visibility()) {
+            timer.is_parked = true;
+            s_parked_timers->append(&timer);
+            continue;
+        }
+        fire_timer(timer);
+        fired_timers.append(&timer);
+    }
+    for (auto* timer : fired_timers)
+        s_timer_heap->insert(*timer);
+
     if (!marked_fd_count)
         return;
 
+#ifdef CEVENTLOOP_USE_EPOLL
+    for (int i = 0; i < marked_fd_count; ++i) {
+        int fd = ready_events[i].data.fd;
+        auto it = s_epoll_interests->find(fd);
+        if (it == s_epoll_interests->end())
+            continue;
+        // Like select(), report hangups and errors as readiness and let the reader find out.
+        u32 events = ready_events[i].events;
+        bool readable = events & (EPOLLIN | EPOLLHUP | EPOLLERR);
+        bool writable = events & (EPOLLOUT | EPOLLHUP | EPOLLERR);
+        for (auto* notifier : it->value.notifiers) {
+            if (readable && (notifier->event_mask() & Notifier::Read) && notifier->on_ready_to_read)
+                post_event(*notifier, make<NotifierReadEvent>(fd));
+            if (writable && (notifier->event_mask() & Notifier::Write) && notifier->on_ready_to_write)
+                post_event(*notifier, make<NotifierWriteEvent>(fd));
+        }
+    }
+#else
     for (auto& notifier : *s_notifiers) {
         if (FD_ISSET(notifier->fd(), &rfds)) {
             if (notifier->on_ready_to_read)
@@ -504,6 +717,7 @@ void EventLoop::wait_for_event(WaitMode mode)
                 post_event(*notifier, make<NotifierWriteEvent>(notifier->fd()));
         }
     }
+#endif
 }
 
 bool EventLoopTimer::has_expired(const timeval& now) const
@@ -516,22 +730,29 @@ void EventLoopTimer::reload(const timeval& now)
     fire_time = now;
     fire_time.tv_sec += interval / 1000;
     fire_time.tv_usec += (interval % 1000) * 1000;
+    if (fire_time.tv_usec >= 1000000) {
+        ++fire_time.tv_sec;
+        fire_time.tv_usec -= 1000000;
+    }
+}
+
+bool EventLoopTimer::fires_before(const EventLoopTimer& other) const
+{
+    return fire_time.tv_sec < other.fire_time.tv_sec || (fire_time.tv_sec == other.fire_time.tv_sec && fire_time.tv_usec < other.fire_time.tv_usec);
+}
+
+bool EventLoopTimer::is_waiting_for_visibility() const
+{
+    return fire_when_not_visible == TimerShouldFireWhenNotVisible::No
+        && owner
+        && !owner->is_visible_for_timer_purposes();
 }
 
 Optional<struct timeval> EventLoop::get_next_timer_expiration()
 {
-    Optional<struct timeval> soonest {};
-    for (auto& it : *s_timers) {
-        auto& fire_time = it.value->fire_time;
-        if (it.value->fire_when_not_visible == TimerShouldFireWhenNotVisible::No
-            && it.value->owner
-            && !it.value->owner->is_visible_for_timer_purposes()) {
-            continue;
-        }
-        if (!soonest.has_value() || fire_time.tv_sec < soonest.value().tv_sec || (fire_time.tv_sec == soonest.value().tv_sec && fire_time.tv_usec < soonest.value().tv_usec))
-            soonest = fire_time;
-    }
-    return soonest;
+    if (s_timer_heap->is_empty())
+        return {};
+    return s_timer_heap->peek_min().fire_time;
 }
 
 int EventLoop::register_timer(Object& object, int milliseconds, bool should_reload, TimerShouldFireWhenNotVisible fire_when_not_visible)
@@ -550,6 +771,7 @@ int EventLoop::register_timer(Object& object, int milliseconds, bool should_relo
     timer->fire_when_not_visible = fire_when_not_visible;
     int timer_id = s_id_allocator->allocate();
     timer->timer_id = timer_id;
+    s_timer_heap->insert(*timer);
     s_timers->set(timer_id, move(timer));
     return timer_id;
 }
@@ -560,18 +782,49 @@ bool EventLoop::unregister_timer(int timer_id)
     auto it = s_timers->find(timer_id);
     if (it == s_timers->end())
         return false;
+    auto& timer = *it->value;
+    if (timer.is_parked)
+        s_parked_timers->remove_first_matching([&](auto* parked_timer) { return parked_timer == &timer; });
+    else
+        s_timer_heap->remove(timer);
     s_timers->remove(it);
     return true;
 }
 
 void EventLoop::register_notifier(Badge<Notifier>, Notifier& notifier)
 {
+    if (s_notifiers->contains(&notifier))
+        return;
     s_notifiers->set(&notifier);
+#ifdef CEVENTLOOP_USE_EPOLL
+    if (!s_epoll_interests->contains(notifier.fd()))
+        s_epoll_interests->set(notifier.fd(), {});
+    s_epoll_interests->find(notifier.fd())->value.notifiers.append(&notifier);
+    update_epoll_interest(notifier.fd());
+#endif
 }
 
 void EventLoop::unregister_notifier(Badge<Notifier>, Notifier& notifier)
 {
+    if (!s_notifiers->contains(&notifier))
+        return;
     s_notifiers->remove(&notifier);
+#ifdef CEVENTLOOP_USE_EPOLL
+    auto it = s_epoll_interests->find(notifier.fd());
+    ASSERT(it != s_epoll_interests->end());
+    it->value.notifiers.remove_first_matching([&](auto* entry) { return entry == &notifier; });
+    update_epoll_interest(notifier.fd());
+#endif
+}
+
+void EventLoop::notifier_event_mask_did_change(Badge<Notifier>, Notifier& notifier)
+{
+#ifdef CEVENTLOOP_USE_EPOLL
+    if (s_notifiers->contains(&notifier))
+        update_epoll_interest(notifier.fd());
+#else
+    (void)notifier;
+#endif
 }
 
 void EventLoop::wake()
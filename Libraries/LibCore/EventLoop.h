@@ -54,6 +54,11 @@ public:
 
     void post_event(Object& receiver, NonnullOwnPtr<Event>&&);
 
+    // Queues an event on whichever loop is running innermost and wakes it up. Unlike post_event(), this is safe
+    // to call from other threads: a nested loop can't go away while the event is on its way in, and it hands
+    // the event on to the loop below it if it exits first.
+    static void post_event_to_current_loop(Object& receiver, NonnullOwnPtr<Event>&&);
+
     static EventLoop& main();
     static EventLoop& current();
 
@@ -64,6 +69,7 @@ public:
 
     static void register_notifier(Badge<Notifier>, Notifier&);
     static void unregister_notifier(Badge<Notifier>, Notifier&);
+    static void notifier_event_mask_did_change(Badge<Notifier>, Notifier&);
 
     void quit(int);
     void unquit();
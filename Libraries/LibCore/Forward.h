@@ -41,6 +41,7 @@ class File;
 class IODevice;
 class LocalServer;
 class LocalSocket;
+class MemoryPressureNotifier;
 class MimeData;
 class NetworkJob;
 class NetworkResponse;
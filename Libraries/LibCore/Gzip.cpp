@@ -26,13 +26,11 @@
 
 #include <AK/ByteBuffer.h>
 #include <AK/Optional.h>
+#include <LibCompress/Inflate.h>
 #include <LibCore/Gzip.h>
-#include <LibCore/puff.h>
 #include <limits.h>
 #include <stddef.h>
 
-//#define DEBUG_GZIP
-
 namespace Core {
 
 bool Gzip::is_compressed(const ByteBuffer& data)
@@ -117,37 +115,10 @@ Optional<ByteBuffer> Gzip::decompress(const ByteBuffer& data)
     }
 
     auto source = optional_payload.value();
-    unsigned long source_len = source.size();
-    auto destination = ByteBuffer::create_uninitialized(1024);
-    while (true) {
-        unsigned long destination_len = destination.size();
-
-#ifdef DEBUG_GZIP
-        dbg() << "Gzip::decompress: Calling puff()\n"
-              << "  destination_data = " << destination.data() << "\n"
-              << "  destination_len = " << destination_len << "\n"
-              << "  source_data = " << source.data() << "\n"
-              << "  source_len = " << source_len;
-#endif
-
-        auto puff_ret = puff(
-            destination.data(), &destination_len,
-            source.data(), &source_len);
-
-        if (puff_ret == 0) {
-            dbg() << "Gzip::decompress: Decompression success.";
-            destination.trim(destination_len);
-            break;
-        }
-
-        if (puff_ret == 1) {
-            // FIXME: Find a better way of decompressing without needing to try over and over again.
-            dbg() << "Gzip::decompress: Output buffer exhausted. Growing.";
-            destination.grow(destination.size() * 2);
-        } else {
-            dbg() << "Gzip::decompress: Error. puff() returned: " << puff_ret;
-            ASSERT_NOT_REACHED();
-        }
+    auto destination = Compress::Inflater::decompress_all(source.data(), source.size());
+    if (!destination.has_value()) {
+        dbg() << "Gzip::decompress: Error while inflating.";
+        return Optional<ByteBuffer>();
     }
 
     return destination;
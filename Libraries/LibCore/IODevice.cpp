@@ -277,6 +277,26 @@ bool IODevice::write(const u8* data, int size)
     return rc == size;
 }
 
+int IODevice::read_at(off_t offset, u8* buffer, int length)
+{
+    int rc = ::pread(m_fd, buffer, length, offset);
+    if (rc < 0) {
+        set_error(errno);
+        return -1;
+    }
+    return rc;
+}
+
+bool IODevice::write_at(off_t offset, const u8* data, int size)
+{
+    int rc = ::pwrite(m_fd, data, size, offset);
+    if (rc < 0) {
+        set_error(errno);
+        return false;
+    }
+    return rc == size;
+}
+
 int IODevice::printf(const char* format, ...)
 {
     va_list ap;
@@ -65,6 +65,10 @@ public:
     bool write(const u8*, int size);
     bool write(const StringView&);
 
+    // Positional I/O: these neither use the read buffer nor move the file offset.
+    int read_at(off_t offset, u8* buffer, int length);
+    bool write_at(off_t offset, const u8*, int size);
+
     bool can_read_line() const;
 
     bool can_read() const;
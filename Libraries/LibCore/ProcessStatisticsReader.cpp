@@ -24,20 +24,365 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
-#include <AK/JsonArray.h>
-#include <AK/JsonObject.h>
+#include <AK/JsonPullParser.h>
 #include <AK/JsonValue.h>
+#include <Kernel/ProcessSnapshot.h>
 #include <LibCore/File.h>
 #include <LibCore/ProcessStatisticsReader.h>
 #include <pwd.h>
 #include <stdio.h>
+#include <string.h>
 
 namespace Core {
 
 HashMap<uid_t, String> ProcessStatisticsReader::s_usernames;
 
-HashMap<pid_t, Core::ProcessStatistics> ProcessStatisticsReader::get_all()
+using JsonEvent = JsonPullParser::Event;
+
+// /proc/all is large, so it is walked with the pull parser instead of being built into a JsonValue tree.
+
+static JsonValue read_value(JsonPullParser& parser)
+{
+    auto event = parser.next();
+    switch (event) {
+    case JsonEvent::BeginObject:
+    case JsonEvent::BeginArray:
+        parser.skip_value(event);
+        return JsonValue(JsonValue::Type::Undefined);
+    case JsonEvent::String:
+    case JsonEvent::Number:
+    case JsonEvent::True:
+    case JsonEvent::False:
+    case JsonEvent::Null:
+    case JsonEvent::Undefined:
+        return parser.value(event);
+    default:
+        return JsonValue(JsonValue::Type::Undefined);
+    }
+}
+
+// Calls callback(key) for every member of an object whose BeginObject was just read.
+// The callback has to consume the member's value.
+template<typename Callback>
+static bool for_each_member(JsonPullParser& parser, Callback callback)
+{
+    for (;;) {
+        auto event = parser.next();
+        if (event == JsonEvent::EndObject)
+            return true;
+        if (event != JsonEvent::Key || !callback(parser.text()))
+            return false;
+    }
+}
+
+// Calls callback() for every object in an array whose BeginArray was just read.
+// The callback has to consume the object's members.
+template<typename Callback>
+static bool for_each_object_in_array(JsonPullParser& parser, Callback callback)
+{
+    for (;;) {
+        auto event = parser.next();
+        if (event == JsonEvent::EndArray)
+            return true;
+        if (event == JsonEvent::BeginObject) {
+            if (!callback())
+                return false;
+        } else if (!parser.skip_value(event)) {
+            return false;
+        }
+    }
+}
+
+static bool parse_thread(JsonPullParser& parser, Core::ThreadStatistics& thread)
+{
+    return for_each_member(parser, [&](const StringView& key) {
+        if (key == "blocked_ns_by_reason") {
+            if (parser.next() != JsonEvent::BeginObject)
+                return false;
+            return for_each_member(parser, [&](const StringView& reason) {
+                String reason_string = reason;
+                thread.blocked_ns_by_reason.set(reason_string, read_value(parser).to_number<u64>());
+                return true;
+            });
+        }
+
+        auto value = read_value(parser);
+        if (key == "tid")
+            thread.tid = value.to_u32();
+        else if (key == "times_scheduled")
+            thread.times_scheduled = value.to_u32();
+        else if (key == "name")
+            thread.name = value.to_string();
+        else if (key == "state")
+            thread.state = value.to_string();
+        else if (key == "ticks")
+            thread.ticks = value.to_u32();
+        else if (key == "priority")
+            thread.priority = value.to_u32();
+        else if (key == "effective_priority")
+            thread.effective_priority = value.to_u32();
+        else if (key == "syscall_count")
+            thread.syscall_count = value.to_u32();
+        else if (key == "inode_faults")
+            thread.inode_faults = value.to_u32();
+        else if (key == "zero_faults")
+            thread.zero_faults = value.to_u32();
+        else if (key == "cow_faults")
+            thread.cow_faults = value.to_u32();
+        else if (key == "unix_socket_read_bytes")
+            thread.unix_socket_read_bytes = value.to_u32();
+        else if (key == "unix_socket_write_bytes")
+            thread.unix_socket_write_bytes = value.to_u32();
+        else if (key == "ipv4_socket_read_bytes")
+            thread.ipv4_socket_read_bytes = value.to_u32();
+        else if (key == "ipv4_socket_write_bytes")
+            thread.ipv4_socket_write_bytes = value.to_u32();
+        else if (key == "file_read_bytes")
+            thread.file_read_bytes = value.to_u32();
+        else if (key == "file_write_bytes")
+            thread.file_write_bytes = value.to_u32();
+        else if (key == "running_ns")
+            thread.running_ns = value.to_number<u64>();
+        else if (key == "runnable_ns")
+            thread.runnable_ns = value.to_number<u64>();
+        else if (key == "blocked_ns")
+            thread.blocked_ns = value.to_number<u64>();
+        return !parser.has_error();
+    });
+}
+
+static bool parse_process(JsonPullParser& parser, Core::ProcessStatistics& process)
 {
+    return for_each_member(parser, [&](const StringView& key) {
+        if (key == "threads") {
+            if (parser.next() != JsonEvent::BeginArray)
+                return false;
+            return for_each_object_in_array(parser, [&] {
+                Core::ThreadStatistics thread;
+                if (!parse_thread(parser, thread))
+                    return false;
+                process.threads.append(move(thread));
+                return true;
+            });
+        }
+
+        auto value = read_value(parser);
+        if (key == "pid")
+            process.pid = value.to_u32();
+        else if (key == "pgid")
+            process.pgid = value.to_u32();
+        else if (key == "pgp")
+            process.pgp = value.to_u32();
+        else if (key == "sid")
+            process.sid = value.to_u32();
+        else if (key == "uid")
+            process.uid = value.to_u32();
+        else if (key == "gid")
+            process.gid = value.to_u32();
+        else if (key == "ppid")
+            process.ppid = value.to_u32();
+        else if (key == "nfds")
+            process.nfds = value.to_u32();
+        else if (key == "name")
+            process.name = value.to_string();
+        else if (key == "tty")
+            process.tty = value.to_string();
+        else if (key == "pledge")
+            process.pledge = value.to_string();
+        else if (key == "veil")
+            process.veil = value.to_string();
+        else if (key == "amount_virtual")
+            process.amount_virtual = value.to_u32();
+        else if (key == "amount_resident")
+            process.amount_resident = value.to_u32();
+        else if (key == "amount_shared")
+            process.amount_shared = value.to_u32();
+        else if (key == "amount_dirty_private")
+            process.amount_dirty_private = value.to_u32();
+        else if (key == "amount_clean_inode")
+            process.amount_clean_inode = value.to_u32();
+        else if (key == "amount_purgeable_volatile")
+            process.amount_purgeable_volatile = value.to_u32();
+        else if (key == "amount_purgeable_nonvolatile")
+            process.amount_purgeable_nonvolatile = value.to_u32();
+        else if (key == "icon_id")
+            process.icon_id = value.to_int();
+        return !parser.has_error();
+    });
+}
+
+static bool parse_processor(JsonPullParser& parser, Core::ProcessorStatistics& processor)
+{
+    return for_each_member(parser, [&](const StringView& key) {
+        auto value = read_value(parser);
+        if (key == "id")
+            processor.id = value.to_u32();
+        else if (key == "online")
+            processor.online = value.to_bool();
+        else if (key == "busy_ticks")
+            processor.busy_ticks = value.to_u32();
+        else if (key == "idle_ticks")
+            processor.idle_ticks = value.to_u32();
+        return !parser.has_error();
+    });
+}
+
+// Walks /proc/all.bin, see Kernel/ProcessSnapshot.h for its layout.
+class SnapshotReader {
+public:
+    explicit SnapshotReader(const ByteBuffer& buffer)
+        : m_buffer(buffer)
+    {
+    }
+
+    bool has_error() const { return m_has_error; }
+
+    template<typename Record>
+    Record read_record()
+    {
+        Record record;
+        memset(&record, 0, sizeof(record));
+        if (!can_read(sizeof(record)))
+            return record;
+        // The records aren't aligned.
+        memcpy(&record, m_buffer.data() + m_offset, sizeof(record));
+        m_offset += sizeof(record);
+        return record;
+    }
+
+    String read_string(size_t length)
+    {
+        if (!can_read(length))
+            return {};
+        String string((const char*)m_buffer.data() + m_offset, length);
+        m_offset += length;
+        return string;
+    }
+
+private:
+    bool can_read(size_t size)
+    {
+        if (m_has_error || size > m_buffer.size() - m_offset) {
+            m_has_error = true;
+            return false;
+        }
+        return true;
+    }
+
+    const ByteBuffer& m_buffer;
+    size_t m_offset { 0 };
+    bool m_has_error { false };
+};
+
+static bool parse_snapshot_thread(SnapshotReader& reader, Core::ThreadStatistics& thread)
+{
+    auto snapshot = reader.read_record<ThreadSnapshot>();
+    thread.tid = snapshot.tid;
+    thread.times_scheduled = snapshot.times_scheduled;
+    thread.ticks = snapshot.ticks;
+    thread.syscall_count = snapshot.syscall_count;
+    thread.inode_faults = snapshot.inode_faults;
+    thread.zero_faults = snapshot.zero_faults;
+    thread.cow_faults = snapshot.cow_faults;
+    thread.unix_socket_read_bytes = snapshot.unix_socket_read_bytes;
+    thread.unix_socket_write_bytes = snapshot.unix_socket_write_bytes;
+    thread.ipv4_socket_read_bytes = snapshot.ipv4_socket_read_bytes;
+    thread.ipv4_socket_write_bytes = snapshot.ipv4_socket_write_bytes;
+    thread.file_read_bytes = snapshot.file_read_bytes;
+    thread.file_write_bytes = snapshot.file_write_bytes;
+    thread.running_ns = snapshot.running_ns;
+    thread.runnable_ns = snapshot.runnable_ns;
+    thread.blocked_ns = snapshot.blocked_ns;
+    thread.priority = snapshot.priority;
+    thread.effective_priority = snapshot.effective_priority;
+    thread.name = reader.read_string(snapshot.name_length);
+    thread.state = reader.read_string(snapshot.state_length);
+    for (u32 i = 0; i < snapshot.blocked_reason_count && !reader.has_error(); ++i) {
+        auto blocked = reader.read_record<BlockedReasonSnapshot>();
+        thread.blocked_ns_by_reason.set(reader.read_string(blocked.reason_length), blocked.ns);
+    }
+    return !reader.has_error();
+}
+
+static bool parse_snapshot_process(SnapshotReader& reader, Core::ProcessStatistics& process)
+{
+    auto snapshot = reader.read_record<ProcessSnapshot>();
+    process.pid = snapshot.pid;
+    process.pgid = snapshot.pgid;
+    process.pgp = snapshot.pgp;
+    process.sid = snapshot.sid;
+    process.uid = snapshot.uid;
+    process.gid = snapshot.gid;
+    process.ppid = snapshot.ppid;
+    process.nfds = snapshot.nfds;
+    process.amount_virtual = snapshot.amount_virtual;
+    process.amount_resident = snapshot.amount_resident;
+    process.amount_shared = snapshot.amount_shared;
+    process.amount_dirty_private = snapshot.amount_dirty_private;
+    process.amount_clean_inode = snapshot.amount_clean_inode;
+    process.amount_purgeable_volatile = snapshot.amount_purgeable_volatile;
+    process.amount_purgeable_nonvolatile = snapshot.amount_purgeable_nonvolatile;
+    process.icon_id = snapshot.icon_id;
+    process.name = reader.read_string(snapshot.name_length);
+    process.tty = reader.read_string(snapshot.tty_length);
+    process.pledge = reader.read_string(snapshot.pledge_length);
+    process.veil = reader.read_string(snapshot.veil_length);
+    for (u32 i = 0; i < snapshot.thread_count && !reader.has_error(); ++i) {
+        Core::ThreadStatistics thread;
+        if (!parse_snapshot_thread(reader, thread))
+            return false;
+        process.threads.append(move(thread));
+    }
+    return !reader.has_error();
+}
+
+Optional<HashMap<pid_t, Core::ProcessStatistics>> ProcessStatisticsReader::get_all_from_snapshot(Vector<Core::ProcessorStatistics>* processors)
+{
+    auto file = Core::File::construct("/proc/all.bin");
+    if (!file->open(Core::IODevice::ReadOnly))
+        return {};
+
+    auto file_contents = file->read_all();
+    SnapshotReader reader(file_contents);
+    auto header = reader.read_record<ProcessSnapshotHeader>();
+    if (reader.has_error() || header.magic != process_snapshot_magic || header.version != process_snapshot_version)
+        return {};
+
+    if (processors)
+        processors->clear();
+    for (u32 i = 0; i < header.processor_count && !reader.has_error(); ++i) {
+        auto snapshot = reader.read_record<ProcessorSnapshot>();
+        if (!processors)
+            continue;
+        Core::ProcessorStatistics processor;
+        processor.id = snapshot.id;
+        processor.online = snapshot.online;
+        processor.busy_ticks = snapshot.busy_ticks;
+        processor.idle_ticks = snapshot.idle_ticks;
+        processors->append(processor);
+    }
+
+    HashMap<pid_t, Core::ProcessStatistics> map;
+    for (u32 i = 0; i < header.process_count; ++i) {
+        Core::ProcessStatistics process;
+        if (!parse_snapshot_process(reader, process)) {
+            fprintf(stderr, "ProcessStatisticsReader: Failed to parse /proc/all.bin\n");
+            if (processors)
+                processors->clear();
+            return {};
+        }
+        // and synthetic data last
+        process.username = username_from_uid(process.uid);
+        map.set(process.pid, move(process));
+    }
+    return map;
+}
+
+HashMap<pid_t, Core::ProcessStatistics> ProcessStatisticsReader::get_all(Vector<Core::ProcessorStatistics>* processors)
+{
+    if (auto snapshot = get_all_from_snapshot(processors); snapshot.has_value())
+        return snapshot.release_value();
+
     auto file = Core::File::construct("/proc/all");
     if (!file->open(Core::IODevice::ReadOnly)) {
         fprintf(stderr, "ProcessStatisticsReader: Failed to open /proc/all: %s\n", file->error_string());
@@ -45,65 +390,44 @@ HashMap<pid_t, Core::ProcessStatistics> ProcessStatisticsReader::get_all()
     }
 
     HashMap<pid_t, Core::ProcessStatistics> map;
+    if (processors)
+        processors->clear();
 
     auto file_contents = file->read_all();
-    auto json = JsonValue::from_string(file_contents);
-    json.as_array().for_each([&](auto& value) {
-        const JsonObject& process_object = value.as_object();
-        Core::ProcessStatistics process;
-
-        // kernel data first
-        process.pid = process_object.get("pid").to_u32();
-        process.pgid = process_object.get("pgid").to_u32();
-        process.pgp = process_object.get("pgp").to_u32();
-        process.sid = process_object.get("sid").to_u32();
-        process.uid = process_object.get("uid").to_u32();
-        process.gid = process_object.get("gid").to_u32();
-        process.ppid = process_object.get("ppid").to_u32();
-        process.nfds = process_object.get("nfds").to_u32();
-        process.name = process_object.get("name").to_string();
-        process.tty = process_object.get("tty").to_string();
-        process.pledge = process_object.get("pledge").to_string();
-        process.veil = process_object.get("veil").to_string();
-        process.amount_virtual = process_object.get("amount_virtual").to_u32();
-        process.amount_resident = process_object.get("amount_resident").to_u32();
-        process.amount_shared = process_object.get("amount_shared").to_u32();
-        process.amount_dirty_private = process_object.get("amount_dirty_private").to_u32();
-        process.amount_clean_inode = process_object.get("amount_clean_inode").to_u32();
-        process.amount_purgeable_volatile = process_object.get("amount_purgeable_volatile").to_u32();
-        process.amount_purgeable_nonvolatile = process_object.get("amount_purgeable_nonvolatile").to_u32();
-        process.icon_id = process_object.get("icon_id").to_int();
-
-        auto& thread_array = process_object.get_ptr("threads")->as_array();
-        process.threads.ensure_capacity(thread_array.size());
-        thread_array.for_each([&](auto& value) {
-            auto& thread_object = value.as_object();
-            Core::ThreadStatistics thread;
-            thread.tid = thread_object.get("tid").to_u32();
-            thread.times_scheduled = thread_object.get("times_scheduled").to_u32();
-            thread.name = thread_object.get("name").to_string();
-            thread.state = thread_object.get("state").to_string();
-            thread.ticks = thread_object.get("ticks").to_u32();
-            thread.priority = thread_object.get("priority").to_u32();
-            thread.effective_priority = thread_object.get("effective_priority").to_u32();
-            thread.syscall_count = thread_object.get("syscall_count").to_u32();
-            thread.inode_faults = thread_object.get("inode_faults").to_u32();
-            thread.zero_faults = thread_object.get("zero_faults").to_u32();
-            thread.cow_faults = thread_object.get("cow_faults").to_u32();
-            thread.unix_socket_read_bytes = thread_object.get("unix_socket_read_bytes").to_u32();
-            thread.unix_socket_write_bytes = thread_object.get("unix_socket_write_bytes").to_u32();
-            thread.ipv4_socket_read_bytes = thread_object.get("ipv4_socket_read_bytes").to_u32();
-            thread.ipv4_socket_write_bytes = thread_object.get("ipv4_socket_write_bytes").to_u32();
-            thread.file_read_bytes = thread_object.get("file_read_bytes").to_u32();
-            thread.file_write_bytes = thread_object.get("file_write_bytes").to_u32();
-            process.threads.append(move(thread));
-        });
-
-        // and synthetic data last
-        process.username = username_from_uid(process.uid);
-        map.set(process.pid, process);
+    JsonPullParser parser(file_contents);
+    bool ok = parser.next() == JsonEvent::BeginObject && for_each_member(parser, [&](const StringView& key) {
+        if (key == "processes") {
+            if (parser.next() != JsonEvent::BeginArray)
+                return false;
+            return for_each_object_in_array(parser, [&] {
+                Core::ProcessStatistics process;
+                if (!parse_process(parser, process))
+                    return false;
+                // and synthetic data last
+                process.username = username_from_uid(process.uid);
+                map.set(process.pid, move(process));
+                return true;
+            });
+        }
+        if (key == "processors" && processors) {
+            if (parser.next() != JsonEvent::BeginArray)
+                return false;
+            return for_each_object_in_array(parser, [&] {
+                Core::ProcessorStatistics processor;
+                if (!parse_processor(parser, processor))
+                    return false;
+                processors->append(processor);
+                return true;
+            });
+        }
+        return parser.skip_value();
     });
 
+    if (!ok) {
+        fprintf(stderr, "ProcessStatisticsReader: Failed to parse /proc/all\n");
+        return {};
+    }
+
     return map;
 }
 
@@ -27,54 +27,59 @@
 #pragma once
 
 #include <AK/HashMap.h>
+#include <AK/Optional.h>
 #include <AK/String.h>
 #include <unistd.h>
 
 namespace Core {
 
 struct ThreadStatistics {
-    int tid;
-    unsigned times_scheduled;
-    unsigned ticks;
-    unsigned syscall_count;
-    unsigned inode_faults;
-    unsigned zero_faults;
-    unsigned cow_faults;
-    unsigned unix_socket_read_bytes;
-    unsigned unix_socket_write_bytes;
-    unsigned ipv4_socket_read_bytes;
-    unsigned ipv4_socket_write_bytes;
-    unsigned file_read_bytes;
-    unsigned file_write_bytes;
+    int tid { 0 };
+    unsigned times_scheduled { 0 };
+    unsigned ticks { 0 };
+    unsigned syscall_count { 0 };
+    unsigned inode_faults { 0 };
+    unsigned zero_faults { 0 };
+    unsigned cow_faults { 0 };
+    unsigned unix_socket_read_bytes { 0 };
+    unsigned unix_socket_write_bytes { 0 };
+    unsigned ipv4_socket_read_bytes { 0 };
+    unsigned ipv4_socket_write_bytes { 0 };
+    unsigned file_read_bytes { 0 };
+    unsigned file_write_bytes { 0 };
+    u64 running_ns { 0 };
+    u64 runnable_ns { 0 };
+    u64 blocked_ns { 0 };
+    HashMap<String, u64> blocked_ns_by_reason;
     String state;
-    u32 priority;
-    u32 effective_priority;
+    u32 priority { 0 };
+    u32 effective_priority { 0 };
     String name;
 };
 
 struct ProcessStatistics {
-    // Keep this in sync with /proc/all.
+    // Keep this in sync with /proc/all and /proc/all.bin.
     // From the kernel side:
-    pid_t pid;
-    unsigned pgid;
-    unsigned pgp;
-    unsigned sid;
-    uid_t uid;
-    gid_t gid;
-    pid_t ppid;
-    unsigned nfds;
+    pid_t pid { 0 };
+    unsigned pgid { 0 };
+    unsigned pgp { 0 };
+    unsigned sid { 0 };
+    uid_t uid { 0 };
+    gid_t gid { 0 };
+    pid_t ppid { 0 };
+    unsigned nfds { 0 };
     String name;
     String tty;
     String pledge;
     String veil;
-    size_t amount_virtual;
-    size_t amount_resident;
-    size_t amount_shared;
-    size_t amount_dirty_private;
-    size_t amount_clean_inode;
-    size_t amount_purgeable_volatile;
-    size_t amount_purgeable_nonvolatile;
-    int icon_id;
+    size_t amount_virtual { 0 };
+    size_t amount_resident { 0 };
+    size_t amount_shared { 0 };
+    size_t amount_dirty_private { 0 };
+    size_t amount_clean_inode { 0 };
+    size_t amount_purgeable_volatile { 0 };
+    size_t amount_purgeable_nonvolatile { 0 };
+    int icon_id { 0 };
 
     Vector<Core::ThreadStatistics> threads;
 
@@ -82,11 +87,21 @@ struct ProcessStatistics {
     String username;
 };
 
+struct ProcessorStatistics {
+    // Keep this in sync with /proc/all and /proc/all.bin.
+    u32 id { 0 };
+    bool online { false };
+    unsigned busy_ticks { 0 };
+    unsigned idle_ticks { 0 };
+};
+
 class ProcessStatisticsReader {
 public:
-    static HashMap<pid_t, Core::ProcessStatistics> get_all();
+    // Reads the binary /proc/all.bin, and falls back to the JSON in /proc/all if that isn't available.
+    static HashMap<pid_t, Core::ProcessStatistics> get_all(Vector<Core::ProcessorStatistics>* processors = nullptr);
 
 private:
+    static Optional<HashMap<pid_t, Core::ProcessStatistics>> get_all_from_snapshot(Vector<Core::ProcessorStatistics>*);
     static String username_from_uid(uid_t);
     static HashMap<uid_t, String> s_usernames;
 };
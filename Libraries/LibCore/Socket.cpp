@@ -192,6 +192,22 @@ void Socket::did_update_fd(int fd)
     }
 }
 
+void Socket::set_notifications_enabled(bool enabled)
+{
+    if (m_notifications_enabled == enabled)
+        return;
+    m_notifications_enabled = enabled;
+    if (m_read_notifier)
+        m_read_notifier->set_enabled(enabled);
+    // What was buffered on our side before we were muted won't make the socket readable again.
+    if (enabled && m_connected && can_read()) {
+        deferred_invoke([this](auto&) {
+            if (m_notifications_enabled && on_ready_to_read)
+                on_ready_to_read();
+        });
+    }
+}
+
 void Socket::ensure_read_notifier()
 {
     ASSERT(m_connected);
@@ -200,6 +216,8 @@ void Socket::ensure_read_notifier()
         if (on_ready_to_read)
             on_ready_to_read();
     };
+    if (!m_notifications_enabled)
+        m_read_notifier->set_enabled(false);
 }
 
 }
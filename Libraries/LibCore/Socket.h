@@ -55,6 +55,11 @@ public:
     bool is_connected() const { return m_connected; }
     void set_blocking(bool blocking);
 
+    // While notifications are disabled, on_ready_to_read isn't called, and whatever arrives waits in the kernel
+    // (which eventually makes the peer wait too).
+    virtual void set_notifications_enabled(bool);
+    bool notifications_enabled() const { return m_notifications_enabled; }
+
     SocketAddress source_address() const { return m_source_address; }
     int source_port() const { return m_source_port; }
 
@@ -83,6 +88,7 @@ private:
     Type m_type { Type::Invalid };
     RefPtr<Notifier> m_notifier;
     RefPtr<Notifier> m_read_notifier;
+    bool m_notifications_enabled { true };
 };
 
 }
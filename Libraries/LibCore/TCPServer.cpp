@@ -66,7 +66,8 @@ bool TCPServer::listen(const IPv4Address& address, u16 port)
     rc = ::bind(m_fd, (const sockaddr*)&in, sizeof(in));
     ASSERT(rc == 0);
 
-    rc = ::listen(m_fd, 5);
+    // Connections are accepted one per event loop pass, so a burst of them needs room to wait.
+    rc = ::listen(m_fd, SOMAXCONN);
     ASSERT(rc == 0);
     m_listening = true;
 
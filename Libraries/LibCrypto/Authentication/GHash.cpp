@@ -0,0 +1,186 @@
+/*
+ * Copyright (c) 2020, Ali Mohammad Pur <ali.mpfard@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <LibCrypto/Authentication/GHash.h>
+
+#if ARCH(I386) || ARCH(X86_64)
+#    include <tmmintrin.h>
+#    include <wmmintrin.h>
+#endif
+
+namespace Crypto {
+namespace Authentication {
+
+static u64 load_big_endian(const u8* data)
+{
+    u64 value = 0;
+    for (size_t i = 0; i < 8; ++i)
+        value = (value << 8) | data[i];
+    return value;
+}
+
+static void store_big_endian(u64 value, u8* data)
+{
+    for (size_t i = 0; i < 8; ++i)
+        data[i] = value >> (56 - 8 * i);
+}
+
+#if ARCH(I386) || ARCH(X86_64)
+static bool cpu_supports_pclmulqdq()
+{
+    static int s_supported = -1;
+    if (s_supported < 0) {
+        u32 eax = 1, ebx, ecx = 0, edx;
+        asm volatile("cpuid"
+                     : "+a"(eax), "=b"(ebx), "+c"(ecx), "=d"(edx));
+        // The blocks are byte-swapped with PSHUFB, which came with SSSE3.
+        s_supported = ((ecx & (1 << 1)) && (ecx & (1 << 9))) ? 1 : 0;
+    }
+    return s_supported;
+}
+
+// Multiplies two field elements held as 128-bit integers whose most significant bit is the first bit of
+// the block, following Intel's "Carry-Less Multiplication and Its Usage for Computing the GCM Mode".
+[[gnu::target("pclmul,sse2")]] static __m128i multiply_clmul(__m128i a, __m128i b)
+{
+    __m128i low = _mm_clmulepi64_si128(a, b, 0x00);
+    __m128i middle = _mm_xor_si128(_mm_clmulepi64_si128(a, b, 0x10), _mm_clmulepi64_si128(a, b, 0x01));
+    __m128i high = _mm_clmulepi64_si128(a, b, 0x11);
+    low = _mm_xor_si128(low, _mm_slli_si128(middle, 8));
+    high = _mm_xor_si128(high, _mm_srli_si128(middle, 8));
+
+    // The operands are bit-reflected, so the 255-bit product has to be shifted left by one.
+    __m128i low_carry = _mm_srli_epi32(low, 31);
+    __m128i high_carry = _mm_srli_epi32(high, 31);
+    low = _mm_slli_epi32(low, 1);
+    high = _mm_slli_epi32(high, 1);
+    __m128i carry_into_high = _mm_srli_si128(low_carry, 12);
+    high_carry = _mm_slli_si128(high_carry, 4);
+    low_carry = _mm_slli_si128(low_carry, 4);
+    low = _mm_or_si128(low, low_carry);
+    high = _mm_or_si128(_mm_or_si128(high, high_carry), carry_into_high);
+
+    // Reduce modulo x^128 + x^7 + x^2 + x + 1.
+    __m128i a1 = _mm_xor_si128(_mm_xor_si128(_mm_slli_epi32(low, 31), _mm_slli_epi32(low, 30)), _mm_slli_epi32(low, 25));
+    __m128i a2 = _mm_srli_si128(a1, 4);
+    low = _mm_xor_si128(low, _mm_slli_si128(a1, 12));
+    __m128i b1 = _mm_xor_si128(_mm_xor_si128(_mm_srli_epi32(low, 1), _mm_srli_epi32(low, 2)), _mm_srli_epi32(low, 7));
+    b1 = _mm_xor_si128(b1, a2);
+    low = _mm_xor_si128(low, b1);
+    return _mm_xor_si128(high, low);
+}
+
+[[gnu::target("pclmul,ssse3,sse2")]] static void process_blocks_clmul(u64& high, u64& low, u64 key_high, u64 key_low, const u8* data, size_t length)
+{
+    const __m128i byte_swap = _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    __m128i key = _mm_set_epi64x(key_high, key_low);
+    __m128i state = _mm_set_epi64x(high, low);
+
+    for (size_t offset = 0; offset < length; offset += 16) {
+        __m128i block;
+        if (length - offset >= 16) {
+            block = _mm_loadu_si128((const __m128i*)(data + offset));
+        } else {
+            u8 padded[16] { 0 };
+            __builtin_memcpy(padded, data + offset, length - offset);
+            block = _mm_loadu_si128((const __m128i*)padded);
+        }
+        state = multiply_clmul(_mm_xor_si128(state, _mm_shuffle_epi8(block, byte_swap)), key);
+    }
+
+    u64 result[2];
+    _mm_storeu_si128((__m128i*)result, state);
+    low = result[0];
+    high = result[1];
+}
+#endif
+
+GHash::GHash(const u8* key)
+    : m_key_high(load_big_endian(key))
+    , m_key_low(load_big_endian(key + 8))
+{
+}
+
+void GHash::multiply_by_key(u64& high, u64& low) const
+{
+    u64 result_high = 0;
+    u64 result_low = 0;
+    u64 v_high = m_key_high;
+    u64 v_low = m_key_low;
+
+    // Bit 0 of a block is the most significant bit of its first byte. Masks stand in for every branch.
+    for (size_t i = 0; i < 128; ++i) {
+        u64 bit = i < 64 ? (high >> (63 - i)) : (low >> (127 - i));
+        u64 mask = -(bit & 1);
+        result_high ^= v_high & mask;
+        result_low ^= v_low & mask;
+
+        u64 reduce = -(v_low & 1);
+        v_low = (v_low >> 1) | (v_high << 63);
+        v_high = (v_high >> 1) ^ (0xe100000000000000ULL & reduce);
+    }
+
+    high = result_high;
+    low = result_low;
+}
+
+void GHash::process_blocks(u64& high, u64& low, const u8* data, size_t length)
+{
+#if ARCH(I386) || ARCH(X86_64)
+    if (cpu_supports_pclmulqdq()) {
+        process_blocks_clmul(high, low, m_key_high, m_key_low, data, length);
+        return;
+    }
+#endif
+    for (size_t offset = 0; offset < length; offset += 16) {
+        u8 block[16] { 0 };
+        __builtin_memcpy(block, data + offset, min(length - offset, (size_t)16));
+        high ^= load_big_endian(block);
+        low ^= load_big_endian(block + 8);
+        multiply_by_key(high, low);
+    }
+}
+
+GHash::TagType GHash::process(const ByteBuffer& aad, const ByteBuffer& cipher)
+{
+    u64 high = 0;
+    u64 low = 0;
+    process_blocks(high, low, aad.data(), aad.size());
+    process_blocks(high, low, cipher.data(), cipher.size());
+
+    u8 lengths[16];
+    store_big_endian((u64)aad.size() * 8, lengths);
+    store_big_endian((u64)cipher.size() * 8, lengths + 8);
+    process_blocks(high, low, lengths, sizeof(lengths));
+
+    TagType digest;
+    store_big_endian(high, digest.data);
+    store_big_endian(low, digest.data + 8);
+    return digest;
+}
+
+}
+}
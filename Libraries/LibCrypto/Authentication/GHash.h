@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2020, Ali Mohammad Pur <ali.mpfard@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/ByteBuffer.h>
+#include <AK/String.h>
+#include <AK/Types.h>
+
+namespace Crypto {
+namespace Authentication {
+
+struct GHashDigest {
+    constexpr static size_t Size = 16;
+    u8 data[Size];
+
+    const u8* immutable_data() const { return data; }
+    size_t data_length() { return Size; }
+};
+
+// The universal hash behind GCM (NIST SP 800-38D). It multiplies in GF(2^128) with PCLMULQDQ when the
+// processor has it, and otherwise bit by bit without any data-dependent branches or lookups.
+class GHash final {
+public:
+    using TagType = GHashDigest;
+
+    explicit GHash(const u8* key);
+    explicit GHash(const ByteBuffer& key)
+        : GHash(key.data())
+    {
+        ASSERT(key.size() >= TagType::Size);
+    }
+
+    constexpr static size_t digest_size() { return TagType::Size; }
+
+    String class_name() const { return "GHash"; }
+
+    // Hashes the additional data and the ciphertext, each zero-padded to a whole number of blocks, followed by their lengths.
+    TagType process(const ByteBuffer& aad, const ByteBuffer& cipher);
+
+private:
+    void process_blocks(u64& high, u64& low, const u8* data, size_t length);
+    void multiply_by_key(u64& high, u64& low) const;
+
+    u64 m_key_high { 0 };
+    u64 m_key_low { 0 };
+};
+
+}
+}
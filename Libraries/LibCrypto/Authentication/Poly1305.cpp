@@ -0,0 +1,193 @@
+/*
+ * Copyright (c) 2020, Ali Mohammad Pur <ali.mpfard@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <LibCrypto/Authentication/Poly1305.h>
+
+namespace Crypto {
+namespace Authentication {
+
+static u32 load_little_endian(const u8* data)
+{
+    return data[0] | (data[1] << 8) | (data[2] << 16) | ((u32)data[3] << 24);
+}
+
+static void store_little_endian(u32 value, u8* data)
+{
+    for (size_t i = 0; i < 4; ++i)
+        data[i] = value >> (8 * i);
+}
+
+Poly1305::Poly1305(const u8* key)
+{
+    // r is clamped as the RFC requires, which also keeps the limb products from overflowing.
+    m_r[0] = load_little_endian(key + 0) & 0x3ffffff;
+    m_r[1] = (load_little_endian(key + 3) >> 2) & 0x3ffff03;
+    m_r[2] = (load_little_endian(key + 6) >> 4) & 0x3ffc0ff;
+    m_r[3] = (load_little_endian(key + 9) >> 6) & 0x3f03fff;
+    m_r[4] = (load_little_endian(key + 12) >> 8) & 0x00fffff;
+
+    for (size_t i = 0; i < 4; ++i)
+        m_pad[i] = load_little_endian(key + 16 + 4 * i);
+}
+
+void Poly1305::process_block(const u8* block, u32 high_bit)
+{
+    u32 r0 = m_r[0], r1 = m_r[1], r2 = m_r[2], r3 = m_r[3], r4 = m_r[4];
+    // 2^130 = 5 mod p, so the parts of the product above 2^130 fold back in multiplied by 5.
+    u32 s1 = r1 * 5, s2 = r2 * 5, s3 = r3 * 5, s4 = r4 * 5;
+
+    u32 h0 = m_h[0] + (load_little_endian(block + 0) & 0x3ffffff);
+    u32 h1 = m_h[1] + ((load_little_endian(block + 3) >> 2) & 0x3ffffff);
+    u32 h2 = m_h[2] + ((load_little_endian(block + 6) >> 4) & 0x3ffffff);
+    u32 h3 = m_h[3] + ((load_little_endian(block + 9) >> 6) & 0x3ffffff);
+    u32 h4 = m_h[4] + ((load_little_endian(block + 12) >> 8) | high_bit);
+
+    u64 d0 = (u64)h0 * r0 + (u64)h1 * s4 + (u64)h2 * s3 + (u64)h3 * s2 + (u64)h4 * s1;
+    u64 d1 = (u64)h0 * r1 + (u64)h1 * r0 + (u64)h2 * s4 + (u64)h3 * s3 + (u64)h4 * s2;
+    u64 d2 = (u64)h0 * r2 + (u64)h1 * r1 + (u64)h2 * r0 + (u64)h3 * s4 + (u64)h4 * s3;
+    u64 d3 = (u64)h0 * r3 + (u64)h1 * r2 + (u64)h2 * r1 + (u64)h3 * r0 + (u64)h4 * s4;
+    u64 d4 = (u64)h0 * r4 + (u64)h1 * r3 + (u64)h2 * r2 + (u64)h3 * r1 + (u64)h4 * r0;
+
+    u32 c = d0 >> 26;
+    h0 = d0 & 0x3ffffff;
+    d1 += c;
+    c = d1 >> 26;
+    h1 = d1 & 0x3ffffff;
+    d2 += c;
+    c = d2 >> 26;
+    h2 = d2 & 0x3ffffff;
+    d3 += c;
+    c = d3 >> 26;
+    h3 = d3 & 0x3ffffff;
+    d4 += c;
+    c = d4 >> 26;
+    h4 = d4 & 0x3ffffff;
+    h0 += c * 5;
+    c = h0 >> 26;
+    h0 &= 0x3ffffff;
+    h1 += c;
+
+    m_h[0] = h0;
+    m_h[1] = h1;
+    m_h[2] = h2;
+    m_h[3] = h3;
+    m_h[4] = h4;
+}
+
+void Poly1305::update(const u8* data, size_t length)
+{
+    if (m_buffer_length) {
+        auto count = min(length, BlockSize - m_buffer_length);
+        __builtin_memcpy(m_buffer + m_buffer_length, data, count);
+        m_buffer_length += count;
+        data += count;
+        length -= count;
+        if (m_buffer_length < BlockSize)
+            return;
+        process_block(m_buffer, 1 << 24);
+        m_buffer_length = 0;
+    }
+
+    for (; length >= BlockSize; data += BlockSize, length -= BlockSize)
+        process_block(data, 1 << 24);
+
+    __builtin_memcpy(m_buffer, data, length);
+    m_buffer_length = length;
+}
+
+Poly1305::TagType Poly1305::digest()
+{
+    if (m_buffer_length) {
+        // A short final block gets its 1 bit right after the data instead of past the end of the block.
+        m_buffer[m_buffer_length] = 1;
+        for (size_t i = m_buffer_length + 1; i < BlockSize; ++i)
+            m_buffer[i] = 0;
+        process_block(m_buffer, 0);
+        m_buffer_length = 0;
+    }
+
+    u32 h0 = m_h[0], h1 = m_h[1], h2 = m_h[2], h3 = m_h[3], h4 = m_h[4];
+
+    u32 c = h1 >> 26;
+    h1 &= 0x3ffffff;
+    h2 += c;
+    c = h2 >> 26;
+    h2 &= 0x3ffffff;
+    h3 += c;
+    c = h3 >> 26;
+    h3 &= 0x3ffffff;
+    h4 += c;
+    c = h4 >> 26;
+    h4 &= 0x3ffffff;
+    h0 += c * 5;
+    c = h0 >> 26;
+    h0 &= 0x3ffffff;
+    h1 += c;
+
+    // Compute h - p, and keep it instead of h if that didn't go negative.
+    u32 g0 = h0 + 5;
+    c = g0 >> 26;
+    g0 &= 0x3ffffff;
+    u32 g1 = h1 + c;
+    c = g1 >> 26;
+    g1 &= 0x3ffffff;
+    u32 g2 = h2 + c;
+    c = g2 >> 26;
+    g2 &= 0x3ffffff;
+    u32 g3 = h3 + c;
+    c = g3 >> 26;
+    g3 &= 0x3ffffff;
+    u32 g4 = h4 + c - (1 << 26);
+
+    u32 mask = (g4 >> 31) - 1;
+    h0 = (h0 & ~mask) | (g0 & mask);
+    h1 = (h1 & ~mask) | (g1 & mask);
+    h2 = (h2 & ~mask) | (g2 & mask);
+    h3 = (h3 & ~mask) | (g3 & mask);
+    h4 = (h4 & ~mask) | (g4 & mask);
+
+    // Repack into 32-bit words and add the pad, dropping anything above 2^128.
+    u32 words[4] {
+        h0 | (h1 << 26),
+        (h1 >> 6) | (h2 << 20),
+        (h2 >> 12) | (h3 << 14),
+        (h3 >> 18) | (h4 << 8),
+    };
+
+    TagType tag;
+    u64 sum = 0;
+    for (size_t i = 0; i < 4; ++i) {
+        sum = (u64)words[i] + m_pad[i] + (sum >> 32);
+        store_little_endian(sum, tag.data + 4 * i);
+    }
+
+    for (size_t i = 0; i < 5; ++i)
+        m_h[i] = 0;
+    return tag;
+}
+
+}
+}
@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) 2020, Ali Mohammad Pur <ali.mpfard@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/ByteBuffer.h>
+#include <AK/String.h>
+#include <AK/Types.h>
+
+namespace Crypto {
+namespace Authentication {
+
+struct Poly1305Digest {
+    constexpr static size_t Size = 16;
+    u8 data[Size];
+
+    const u8* immutable_data() const { return data; }
+    size_t data_length() { return Size; }
+};
+
+// The one-time authenticator from RFC 8439 section 2.5. A key must never be used for more than one message.
+// The arithmetic mod 2^130 - 5 is done in 26-bit limbs, without any data-dependent branches.
+class Poly1305 final {
+public:
+    using TagType = Poly1305Digest;
+
+    constexpr static size_t KeySize = 32;
+    constexpr static size_t BlockSize = 16;
+
+    explicit Poly1305(const u8* key);
+    explicit Poly1305(const ByteBuffer& key)
+        : Poly1305(key.data())
+    {
+        ASSERT(key.size() >= KeySize);
+    }
+
+    constexpr static size_t digest_size() { return TagType::Size; }
+
+    String class_name() const { return "Poly1305"; }
+
+    void update(const u8* data, size_t length);
+    void update(const ByteBuffer& buffer) { update(buffer.data(), buffer.size()); }
+
+    TagType digest();
+
+private:
+    void process_block(const u8* block, u32 high_bit);
+
+    u32 m_r[5];
+    u32 m_h[5] { 0, 0, 0, 0, 0 };
+    u32 m_pad[4];
+
+    u8 m_buffer[BlockSize];
+    size_t m_buffer_length { 0 };
+};
+
+}
+}
@@ -169,12 +169,9 @@ FLATTEN UnsignedBigInteger UnsignedBigInteger::shift_left(size_t num_bits) const
 FLATTEN UnsignedBigInteger UnsignedBigInteger::multiplied_by(const UnsignedBigInteger& other) const
 {
     UnsignedBigInteger result;
-    UnsignedBigInteger temp_shift_result;
-    UnsignedBigInteger temp_shift_plus;
-    UnsignedBigInteger temp_shift;
-    UnsignedBigInteger temp_plus;
+    UnsignedBigInteger temp;
 
-    multiply_without_allocation(*this, other, temp_shift_result, temp_shift_plus, temp_shift, temp_plus, result);
+    multiply_without_allocation(*this, other, temp, result);
 
     return result;
 }
@@ -226,7 +223,7 @@ bool UnsignedBigInteger::operator==(const UnsignedBigInteger& other) const
     if (length != other.trimmed_length())
         return false;
 
-    return !__builtin_memcmp(m_words.data(), other.words().data(), length);
+    return !__builtin_memcmp(m_words.data(), other.words().data(), length * sizeof(u32));
 }
 
 bool UnsignedBigInteger::operator!=(const UnsignedBigInteger& other) const
@@ -385,40 +382,141 @@ FLATTEN void UnsignedBigInteger::shift_left_without_allocation(
     }
 }
 
+// Below this many words, Karatsuba's extra additions cost more than the multiplications they save.
+static constexpr size_t KARATSUBA_THRESHOLD = 32;
+
+// out[0..left_length + right_length) = left * right
+static void multiply_words(const u32* left, size_t left_length, const u32* right, size_t right_length, u32* out)
+{
+    __builtin_memset(out, 0, (left_length + right_length) * sizeof(u32));
+    for (size_t i = 0; i < left_length; ++i) {
+        u64 left_word = left[i];
+        if (left_word == 0)
+            continue;
+        u32 carry = 0;
+        for (size_t j = 0; j < right_length; ++j) {
+            u64 product = left_word * right[j] + out[i + j] + carry;
+            out[i + j] = static_cast<u32>(product);
+            carry = static_cast<u32>(product >> 32);
+        }
+        out[i + right_length] = carry;
+    }
+}
+
+// left[0..length) += right[0..right_length), returning the carry out of the top word.
+static u32 add_words(u32* left, size_t length, const u32* right, size_t right_length)
+{
+    u64 carry = 0;
+    for (size_t i = 0; i < length; ++i) {
+        if (i >= right_length && !carry)
+            break;
+        u64 sum = static_cast<u64>(left[i]) + (i < right_length ? right[i] : 0) + carry;
+        left[i] = static_cast<u32>(sum);
+        carry = sum >> 32;
+    }
+    return static_cast<u32>(carry);
+}
+
+// left[0..length) -= right[0..right_length), where the result can't be negative.
+static void subtract_words(u32* left, size_t length, const u32* right, size_t right_length)
+{
+    u32 borrow = 0;
+    for (size_t i = 0; i < length; ++i) {
+        if (i >= right_length && !borrow)
+            break;
+        u64 subtrahend = static_cast<u64>(i < right_length ? right[i] : 0) + borrow;
+        borrow = left[i] < subtrahend;
+        left[i] = static_cast<u32>(left[i] - subtrahend);
+    }
+    ASSERT(borrow == 0);
+}
+
+static size_t karatsuba_scratch_length(size_t length)
+{
+    if (length < KARATSUBA_THRESHOLD)
+        return 0;
+    size_t sum_length = length - length / 2 + 1;
+    return 4 * sum_length + karatsuba_scratch_length(sum_length);
+}
+
+// out[0..2 * length) = left * right, where both operands are length words long.
+static void karatsuba_multiply_words(const u32* left, const u32* right, size_t length, u32* out, u32* scratch)
+{
+    if (length < KARATSUBA_THRESHOLD) {
+        multiply_words(left, length, right, length, out);
+        return;
+    }
+
+    // With x = x1 * B + x0, x * y = z2 * B^2 + z1 * B + z0, where z0 = x0 * y0, z2 = x1 * y1,
+    // and z1 = (x0 + x1) * (y0 + y1) - z0 - z2 needs just one more multiplication.
+    size_t low_length = length / 2;
+    size_t high_length = length - low_length;
+    size_t sum_length = high_length + 1;
+
+    karatsuba_multiply_words(left, right, low_length, out, scratch);
+    if (low_length == high_length) {
+        karatsuba_multiply_words(left + low_length, right + low_length, high_length, out + 2 * low_length, scratch);
+    } else {
+        multiply_words(left + low_length, high_length, right + low_length, high_length, out + 2 * low_length);
+    }
+
+    u32* left_sum = scratch;
+    u32* right_sum = left_sum + sum_length;
+    u32* middle = right_sum + sum_length;
+    __builtin_memcpy(left_sum, left + low_length, high_length * sizeof(u32));
+    left_sum[high_length] = add_words(left_sum, high_length, left, low_length);
+    __builtin_memcpy(right_sum, right + low_length, high_length * sizeof(u32));
+    right_sum[high_length] = add_words(right_sum, high_length, right, low_length);
+
+    karatsuba_multiply_words(left_sum, right_sum, sum_length, middle, middle + 2 * sum_length);
+    subtract_words(middle, 2 * sum_length, out, 2 * low_length);
+    subtract_words(middle, 2 * sum_length, out + 2 * low_length, 2 * high_length);
+    add_words(out + low_length, 2 * length - low_length, middle, 2 * sum_length);
+}
+
 /**
- * Complexity: O(N^2) where N is the number of words in the larger number
+ * Complexity: O(N^2) where N is the number of words in the larger number,
+ * or O(N^1.58) for numbers of similar length that are at least KARATSUBA_THRESHOLD words long.
  * Multiplication method:
- * An integer is equal to the sum of the powers of two
- * according to the indexes of its 'on' bits.
- * So to multiple x*y, we go over each '1' bit in x (say the i'th bit), 
- * and add y<<i to the result.
+ * Schoolbook multiplication, one word at a time: every word of the left number is multiplied
+ * with every word of the right one, and the 64-bit products are added up in the output.
+ * Large numbers are split in halves, and multiplied with Karatsuba's method from those.
  */
 FLATTEN void UnsignedBigInteger::multiply_without_allocation(
     const UnsignedBigInteger& left,
     const UnsignedBigInteger& right,
-    UnsignedBigInteger& temp_shift_result,
-    UnsignedBigInteger& temp_shift_plus,
-    UnsignedBigInteger& temp_shift,
-    UnsignedBigInteger& temp_plus,
+    UnsignedBigInteger& temp,
     UnsignedBigInteger& output)
 {
     output.set_to_0();
 
-    // iterate all bits
-    for (size_t word_index = 0; word_index < left.length(); ++word_index) {
-        for (size_t bit_index = 0; bit_index < UnsignedBigInteger::BITS_IN_WORD; ++bit_index) {
-            // If the bit is off - skip over it
-            if (!(left.m_words[word_index] & (1 << bit_index)))
-                continue;
-
-            const size_t shift_amount = word_index * UnsignedBigInteger::BITS_IN_WORD + bit_index;
+    size_t left_length = left.trimmed_length();
+    size_t right_length = right.trimmed_length();
+    if (!left_length || !right_length)
+        return;
 
-            // output += (right << shift_amount);
-            shift_left_without_allocation(right, shift_amount, temp_shift_result, temp_shift_plus, temp_shift);
-            add_without_allocation(output, temp_shift, temp_plus);
-            output.set_to(temp_plus);
-        }
+    size_t shorter_length = min(left_length, right_length);
+    size_t longer_length = max(left_length, right_length);
+    if (shorter_length < KARATSUBA_THRESHOLD || shorter_length * 2 < longer_length) {
+        output.m_words.resize_and_keep_capacity(left_length + right_length);
+        multiply_words(left.m_words.data(), left_length, right.m_words.data(), right_length, output.m_words.data());
+    } else {
+        // Both operands are padded to the same length.
+        size_t length = longer_length;
+        temp.set_to_0();
+        temp.m_words.resize_and_keep_capacity(2 * length + karatsuba_scratch_length(length));
+        u32* padded_left = temp.m_words.data();
+        u32* padded_right = padded_left + length;
+        __builtin_memset(padded_left, 0, 2 * length * sizeof(u32));
+        __builtin_memcpy(padded_left, left.m_words.data(), left_length * sizeof(u32));
+        __builtin_memcpy(padded_right, right.m_words.data(), right_length * sizeof(u32));
+
+        output.m_words.resize_and_keep_capacity(2 * length);
+        karatsuba_multiply_words(padded_left, padded_right, length, output.m_words.data(), padded_right + length);
     }
+
+    output.m_words.resize_and_keep_capacity(output.trimmed_length());
+    output.m_cached_trimmed_length = {};
 }
 
 /**
@@ -492,6 +590,76 @@ FLATTEN void UnsignedBigInteger::divide_u16_without_allocation(
     remainder.set_to(remainder_word);
 }
 
+u32 UnsignedBigInteger::montgomery_factor(const UnsignedBigInteger& modulus)
+{
+    u32 modulus_word = modulus.m_words[0];
+    ASSERT(modulus_word % 2 == 1);
+    // Newton's iteration doubles the number of correct low bits of the inverse each step,
+    // and any odd x is its own inverse modulo 8.
+    u32 inverse = modulus_word;
+    for (size_t i = 0; i < 4; ++i)
+        inverse *= 2 - modulus_word * inverse;
+    return -inverse;
+}
+
+/**
+ * Complexity: O(N^2) where N is the number of words in the modulus
+ * Reduction method:
+ * One word at a time, from the bottom, add the multiple of the modulus that clears that word
+ * of the value. After N words, the value is a multiple of R, and dividing by R is just dropping
+ * the bottom N words; what's left is at most one subtraction of the modulus away from the result.
+ */
+FLATTEN void UnsignedBigInteger::montgomery_reduce_without_allocation(
+    const UnsignedBigInteger& value,
+    const UnsignedBigInteger& modulus,
+    u32 factor,
+    UnsignedBigInteger& temp,
+    UnsignedBigInteger& output)
+{
+    size_t modulus_length = modulus.trimmed_length();
+    size_t value_length = value.trimmed_length();
+    ASSERT(value_length <= 2 * modulus_length);
+
+    temp.set_to_0();
+    temp.m_words.resize_and_keep_capacity(2 * modulus_length + 1);
+    u32* words = temp.m_words.data();
+    __builtin_memset(words, 0, temp.m_words.size() * sizeof(u32));
+    __builtin_memcpy(words, value.m_words.data(), value_length * sizeof(u32));
+
+    const u32* modulus_words = modulus.m_words.data();
+    for (size_t i = 0; i < modulus_length; ++i) {
+        u64 multiple = static_cast<u32>(words[i] * factor);
+        u32 carry = 0;
+        for (size_t j = 0; j < modulus_length; ++j) {
+            u64 sum = multiple * modulus_words[j] + words[i + j] + carry;
+            words[i + j] = static_cast<u32>(sum);
+            carry = static_cast<u32>(sum >> 32);
+        }
+        add_words(words + i + modulus_length, temp.m_words.size() - i - modulus_length, &carry, 1);
+    }
+
+    output.set_to_0();
+    output.m_words.resize_and_keep_capacity(modulus_length + 1);
+    __builtin_memcpy(output.m_words.data(), words + modulus_length, (modulus_length + 1) * sizeof(u32));
+    if (!(output < modulus))
+        subtract_words(output.m_words.data(), modulus_length + 1, modulus_words, modulus_length);
+    output.m_cached_trimmed_length = {};
+    output.m_words.resize_and_keep_capacity(output.trimmed_length());
+}
+
+FLATTEN void UnsignedBigInteger::montgomery_multiply_without_allocation(
+    const UnsignedBigInteger& left,
+    const UnsignedBigInteger& right,
+    const UnsignedBigInteger& modulus,
+    u32 factor,
+    UnsignedBigInteger& temp_multiply,
+    UnsignedBigInteger& temp,
+    UnsignedBigInteger& output)
+{
+    multiply_without_allocation(left, right, temp, temp_multiply);
+    montgomery_reduce_without_allocation(temp_multiply, modulus, factor, temp, output);
+}
+
 ALWAYS_INLINE void UnsignedBigInteger::shift_left_by_n_words(
     const UnsignedBigInteger& number,
     const size_t number_of_words,
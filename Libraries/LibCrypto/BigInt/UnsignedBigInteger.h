@@ -92,10 +92,18 @@ public:
     static void add_without_allocation(const UnsignedBigInteger& left, const UnsignedBigInteger& right, UnsignedBigInteger& output);
     static void subtract_without_allocation(const UnsignedBigInteger& left, const UnsignedBigInteger& right, UnsignedBigInteger& output);
     static void shift_left_without_allocation(const UnsignedBigInteger& number, size_t bits_to_shift_by, UnsignedBigInteger& temp_result, UnsignedBigInteger& temp_plus, UnsignedBigInteger& output);
-    static void multiply_without_allocation(const UnsignedBigInteger& left, const UnsignedBigInteger& right, UnsignedBigInteger& temp_shift_result, UnsignedBigInteger& temp_shift_plus, UnsignedBigInteger& temp_shift, UnsignedBigInteger& temp_plus, UnsignedBigInteger& output);
+    static void multiply_without_allocation(const UnsignedBigInteger& left, const UnsignedBigInteger& right, UnsignedBigInteger& temp, UnsignedBigInteger& output);
     static void divide_without_allocation(const UnsignedBigInteger& numerator, const UnsignedBigInteger& denominator, UnsignedBigInteger& temp_shift_result, UnsignedBigInteger& temp_shift_plus, UnsignedBigInteger& temp_shift, UnsignedBigInteger& temp_minus, UnsignedBigInteger& quotient, UnsignedBigInteger& remainder);
     static void divide_u16_without_allocation(const UnsignedBigInteger& numerator, u32 denominator, UnsignedBigInteger& quotient, UnsignedBigInteger& remainder);
 
+    // Montgomery arithmetic, for an odd modulus m and R = 2^(32 * m.trimmed_length()).
+    // The factor is -m^-1 mod 2^32, as computed by montgomery_factor().
+    static u32 montgomery_factor(const UnsignedBigInteger& modulus);
+    // output = value * R^-1 mod m, for any value less than m * R.
+    static void montgomery_reduce_without_allocation(const UnsignedBigInteger& value, const UnsignedBigInteger& modulus, u32 factor, UnsignedBigInteger& temp, UnsignedBigInteger& output);
+    // output = left * right * R^-1 mod m, for any operands whose product is less than m * R.
+    static void montgomery_multiply_without_allocation(const UnsignedBigInteger& left, const UnsignedBigInteger& right, const UnsignedBigInteger& modulus, u32 factor, UnsignedBigInteger& temp_multiply, UnsignedBigInteger& temp, UnsignedBigInteger& output);
+
     bool operator==(const UnsignedBigInteger& other) const;
     bool operator!=(const UnsignedBigInteger& other) const;
     bool operator<(const UnsignedBigInteger& other) const;
@@ -27,20 +27,396 @@
 #include <AK/StringBuilder.h>
 #include <LibCrypto/Cipher/AES.h>
 
+#if ARCH(I386) || ARCH(X86_64)
+#    include <wmmintrin.h>
+#endif
+
 namespace Crypto {
 namespace Cipher {
 
-template<typename T>
-constexpr u32 get_key(T pt)
+// The portable implementation works on a bit-sliced block: plane i holds bit i of every byte of the
+// block, bit n of a plane belonging to byte n. Byte n is in row n % 4 and column n / 4 of the AES state.
+// Everything below is built from logic operations and shifts by constant amounts, so it runs in the
+// same time whatever the key and the data are.
+
+// Transposes the 8x8 bit matrix whose rows are the bytes of `x`.
+static u64 transpose_bits(u64 x)
+{
+    u64 t = (x ^ (x >> 7)) & 0x00aa00aa00aa00aaULL;
+    x ^= t ^ (t << 7);
+    t = (x ^ (x >> 14)) & 0x0000cccc0000ccccULL;
+    x ^= t ^ (t << 14);
+    t = (x ^ (x >> 28)) & 0x00000000f0f0f0f0ULL;
+    x ^= t ^ (t << 28);
+    return x;
+}
+
+static void slice(const u8* bytes, u32* planes)
+{
+    u64 low = 0;
+    u64 high = 0;
+    for (size_t i = 0; i < 8; ++i) {
+        low |= (u64)bytes[i] << (8 * i);
+        high |= (u64)bytes[i + 8] << (8 * i);
+    }
+    low = transpose_bits(low);
+    high = transpose_bits(high);
+    for (size_t i = 0; i < 8; ++i)
+        planes[i] = ((low >> (8 * i)) & 0xff) | (((high >> (8 * i)) & 0xff) << 8);
+}
+
+static void unslice(const u32* planes, u8* bytes)
+{
+    u64 low = 0;
+    u64 high = 0;
+    for (size_t i = 0; i < 8; ++i) {
+        low |= (u64)(planes[i] & 0xff) << (8 * i);
+        high |= (u64)((planes[i] >> 8) & 0xff) << (8 * i);
+    }
+    low = transpose_bits(low);
+    high = transpose_bits(high);
+    for (size_t i = 0; i < 8; ++i) {
+        bytes[i] = low >> (8 * i);
+        bytes[i + 8] = high >> (8 * i);
+    }
+}
+
+// The S-box as a boolean circuit (Boyar and Peralta, "A depth-16 circuit for the AES S-box").
+static void sub_bytes(u32* q)
+{
+    u32 x0 = q[7], x1 = q[6], x2 = q[5], x3 = q[4], x4 = q[3], x5 = q[2], x6 = q[1], x7 = q[0];
+
+    // Top linear transformation.
+    u32 y14 = x3 ^ x5;
+    u32 y13 = x0 ^ x6;
+    u32 y9 = x0 ^ x3;
+    u32 y8 = x0 ^ x5;
+    u32 t0 = x1 ^ x2;
+    u32 y1 = t0 ^ x7;
+    u32 y4 = y1 ^ x3;
+    u32 y12 = y13 ^ y14;
+    u32 y2 = y1 ^ x0;
+    u32 y5 = y1 ^ x6;
+    u32 y3 = y5 ^ y8;
+    u32 t1 = x4 ^ y12;
+    u32 y15 = t1 ^ x5;
+    u32 y20 = t1 ^ x1;
+    u32 y6 = y15 ^ x7;
+    u32 y10 = y15 ^ t0;
+    u32 y11 = y20 ^ y9;
+    u32 y7 = x7 ^ y11;
+    u32 y17 = y10 ^ y11;
+    u32 y19 = y10 ^ y8;
+    u32 y16 = t0 ^ y11;
+    u32 y21 = y13 ^ y16;
+    u32 y18 = x0 ^ y16;
+
+    // Non-linear section.
+    u32 t2 = y12 & y15;
+    u32 t3 = y3 & y6;
+    u32 t4 = t3 ^ t2;
+    u32 t5 = y4 & x7;
+    u32 t6 = t5 ^ t2;
+    u32 t7 = y13 & y16;
+    u32 t8 = y5 & y1;
+    u32 t9 = t8 ^ t7;
+    u32 t10 = y2 & y7;
+    u32 t11 = t10 ^ t7;
+    u32 t12 = y9 & y11;
+    u32 t13 = y14 & y17;
+    u32 t14 = t13 ^ t12;
+    u32 t15 = y8 & y10;
+    u32 t16 = t15 ^ t12;
+    u32 t17 = t4 ^ t14;
+    u32 t18 = t6 ^ t16;
+    u32 t19 = t9 ^ t14;
+    u32 t20 = t11 ^ t16;
+    u32 t21 = t17 ^ y20;
+    u32 t22 = t18 ^ y19;
+    u32 t23 = t19 ^ y21;
+    u32 t24 = t20 ^ y18;
+
+    u32 t25 = t21 ^ t22;
+    u32 t26 = t21 & t23;
+    u32 t27 = t24 ^ t26;
+    u32 t28 = t25 & t27;
+    u32 t29 = t28 ^ t22;
+    u32 t30 = t23 ^ t24;
+    u32 t31 = t22 ^ t26;
+    u32 t32 = t31 & t30;
+    u32 t33 = t32 ^ t24;
+    u32 t34 = t23 ^ t33;
+    u32 t35 = t27 ^ t33;
+    u32 t36 = t24 & t35;
+    u32 t37 = t36 ^ t34;
+    u32 t38 = t27 ^ t36;
+    u32 t39 = t29 & t38;
+    u32 t40 = t25 ^ t39;
+
+    u32 t41 = t40 ^ t37;
+    u32 t42 = t29 ^ t33;
+    u32 t43 = t29 ^ t40;
+    u32 t44 = t33 ^ t37;
+    u32 t45 = t42 ^ t41;
+    u32 z0 = t44 & y15;
+    u32 z1 = t37 & y6;
+    u32 z2 = t33 & x7;
+    u32 z3 = t43 & y16;
+    u32 z4 = t40 & y1;
+    u32 z5 = t29 & y7;
+    u32 z6 = t42 & y11;
+    u32 z7 = t45 & y17;
+    u32 z8 = t41 & y10;
+    u32 z9 = t44 & y12;
+    u32 z10 = t37 & y3;
+    u32 z11 = t33 & y4;
+    u32 z12 = t43 & y13;
+    u32 z13 = t40 & y5;
+    u32 z14 = t29 & y2;
+    u32 z15 = t42 & y9;
+    u32 z16 = t45 & y14;
+    u32 z17 = t41 & y8;
+
+    // Bottom linear transformation.
+    u32 t46 = z15 ^ z16;
+    u32 t47 = z10 ^ z11;
+    u32 t48 = z5 ^ z13;
+    u32 t49 = z9 ^ z10;
+    u32 t50 = z2 ^ z12;
+    u32 t51 = z2 ^ z5;
+    u32 t52 = z7 ^ z8;
+    u32 t53 = z0 ^ z3;
+    u32 t54 = z6 ^ z7;
+    u32 t55 = z16 ^ z17;
+    u32 t56 = z12 ^ t48;
+    u32 t57 = t50 ^ t53;
+    u32 t58 = z4 ^ t46;
+    u32 t59 = z3 ^ t54;
+    u32 t60 = t46 ^ t57;
+    u32 t61 = z14 ^ t57;
+    u32 t62 = t52 ^ t58;
+    u32 t63 = t49 ^ t58;
+    u32 t64 = z4 ^ t59;
+    u32 t65 = t61 ^ t62;
+    u32 t66 = z1 ^ t63;
+    u32 s0 = t59 ^ t63;
+    u32 s6 = t56 ^ ~t62;
+    u32 s7 = t48 ^ ~t60;
+    u32 t67 = t64 ^ t65;
+    u32 s3 = t53 ^ t66;
+    u32 s4 = t51 ^ t66;
+    u32 s5 = t47 ^ t65;
+    u32 s1 = t64 ^ ~s3;
+    u32 s2 = t55 ^ ~t67;
+
+    q[7] = s0;
+    q[6] = s1;
+    q[5] = s2;
+    q[4] = s3;
+    q[3] = s4;
+    q[2] = s5;
+    q[1] = s6;
+    q[0] = s7;
+}
+
+// The affine map that turns S-box outputs back into field inverses, and inputs of the inverse S-box into
+// what the S-box would have to be given to produce them.
+static void inverse_affine_transform(u32* q)
+{
+    u32 x[8];
+    for (size_t i = 0; i < 8; ++i)
+        x[i] = q[i];
+    for (size_t i = 0; i < 8; ++i)
+        q[i] = x[(i + 7) % 8] ^ x[(i + 5) % 8] ^ x[(i + 2) % 8];
+    q[0] = ~q[0];
+    q[2] = ~q[2];
+}
+
+static void inverse_sub_bytes(u32* q)
+{
+    inverse_affine_transform(q);
+    sub_bytes(q);
+    inverse_affine_transform(q);
+}
+
+// Rotates every row of the state left by its index, each plane on its own.
+static void shift_rows(u32* q)
+{
+    for (size_t i = 0; i < 8; ++i) {
+        u32 x = q[i];
+        u32 row1 = x & 0x2222;
+        u32 row2 = x & 0x4444;
+        u32 row3 = x & 0x8888;
+        q[i] = (x & 0x1111)
+            | (row1 >> 4) | ((row1 << 12) & 0xffff)
+            | (row2 >> 8) | ((row2 << 8) & 0xffff)
+            | (row3 >> 12) | ((row3 << 4) & 0xffff);
+    }
+}
+
+static void inverse_shift_rows(u32* q)
+{
+    for (size_t i = 0; i < 8; ++i) {
+        u32 x = q[i];
+        u32 row1 = x & 0x2222;
+        u32 row2 = x & 0x4444;
+        u32 row3 = x & 0x8888;
+        q[i] = (x & 0x1111)
+            | ((row1 << 4) & 0xffff) | (row1 >> 12)
+            | ((row2 << 8) & 0xffff) | (row2 >> 8)
+            | ((row3 << 12) & 0xffff) | (row3 >> 4);
+    }
+}
+
+// Moves every byte of a column up by one, two or three rows.
+static u32 rotate_column_by_1(u32 x) { return ((x >> 1) & 0x7777) | ((x << 3) & 0x8888); }
+static u32 rotate_column_by_2(u32 x) { return ((x >> 2) & 0x3333) | ((x << 2) & 0xcccc); }
+static u32 rotate_column_by_3(u32 x) { return ((x >> 3) & 0x1111) | ((x << 1) & 0xeeee); }
+
+// Doubles every byte in GF(2^8).
+static void multiply_by_x(u32* q)
+{
+    u32 carry = q[7];
+    q[7] = q[6];
+    q[6] = q[5];
+    q[5] = q[4];
+    q[4] = q[3] ^ carry;
+    q[3] = q[2] ^ carry;
+    q[2] = q[1];
+    q[1] = q[0] ^ carry;
+    q[0] = carry;
+}
+
+static void mix_columns(u32* q)
+{
+    // Row r becomes 2 * (a[r] + a[r + 1]) + a[r + 1] + a[r + 2] + a[r + 3].
+    u32 doubled[8];
+    u32 rest[8];
+    for (size_t i = 0; i < 8; ++i) {
+        u32 next = rotate_column_by_1(q[i]);
+        doubled[i] = q[i] ^ next;
+        rest[i] = next ^ rotate_column_by_2(q[i]) ^ rotate_column_by_3(q[i]);
+    }
+    multiply_by_x(doubled);
+    for (size_t i = 0; i < 8; ++i)
+        q[i] = doubled[i] ^ rest[i];
+}
+
+static void inverse_mix_columns(u32* q)
+{
+    // The inverse is MixColumns applied after adding 4 * (a[r] + a[r + 2]) to every row r.
+    u32 quadrupled[8];
+    for (size_t i = 0; i < 8; ++i)
+        quadrupled[i] = q[i] ^ rotate_column_by_2(q[i]);
+    multiply_by_x(quadrupled);
+    multiply_by_x(quadrupled);
+    for (size_t i = 0; i < 8; ++i)
+        q[i] ^= quadrupled[i];
+    mix_columns(q);
+}
+
+static void add_round_key(u32* q, const u16* round_key)
+{
+    for (size_t i = 0; i < 8; ++i)
+        q[i] ^= round_key[i];
+}
+
+static void encrypt_block_sliced(const AESCipherKey& key, const u8* in, u8* out)
+{
+    const auto* round_keys = key.sliced_round_keys();
+    auto rounds = key.rounds();
+    u32 q[8];
+
+    slice(in, q);
+    add_round_key(q, round_keys);
+    for (size_t round = 1; round < rounds; ++round) {
+        sub_bytes(q);
+        shift_rows(q);
+        mix_columns(q);
+        add_round_key(q, round_keys + 8 * round);
+    }
+    sub_bytes(q);
+    shift_rows(q);
+    add_round_key(q, round_keys + 8 * rounds);
+    unslice(q, out);
+}
+
+// Decryption runs the equivalent inverse cipher, so that it can share the decryption key schedule with AESDEC.
+static void decrypt_block_sliced(const AESCipherKey& key, const u8* in, u8* out)
+{
+    const auto* round_keys = key.sliced_round_keys();
+    auto rounds = key.rounds();
+    u32 q[8];
+
+    slice(in, q);
+    add_round_key(q, round_keys);
+    for (size_t round = 1; round < rounds; ++round) {
+        inverse_sub_bytes(q);
+        inverse_shift_rows(q);
+        inverse_mix_columns(q);
+        add_round_key(q, round_keys + 8 * round);
+    }
+    inverse_sub_bytes(q);
+    inverse_shift_rows(q);
+    add_round_key(q, round_keys + 8 * rounds);
+    unslice(q, out);
+}
+
+static u32 sub_word(u32 word)
+{
+    u8 bytes[16] { 0 };
+    u32 q[8];
+    for (size_t i = 0; i < 4; ++i)
+        bytes[i] = word >> (24 - 8 * i);
+    slice(bytes, q);
+    sub_bytes(q);
+    unslice(q, bytes);
+    return ((u32)bytes[0] << 24) | ((u32)bytes[1] << 16) | ((u32)bytes[2] << 8) | bytes[3];
+}
+
+#if ARCH(I386) || ARCH(X86_64)
+static bool cpu_supports_aes_ni()
+{
+    static int s_supported = -1;
+    if (s_supported < 0) {
+        u32 eax = 1, ebx, ecx = 0, edx;
+        asm volatile("cpuid"
+                     : "+a"(eax), "=b"(ebx), "+c"(ecx), "=d"(edx));
+        s_supported = (ecx & (1 << 25)) ? 1 : 0;
+    }
+    return s_supported;
+}
+
+[[gnu::target("aes,sse2")]] static void encrypt_block_aes_ni(const AESCipherKey& key, const u8* in, u8* out)
 {
-    return ((u32)(pt)[0] << 24) ^ ((u32)(pt)[1] << 16) ^ ((u32)(pt)[2] << 8) ^ ((u32)(pt)[3]);
+    const auto* round_keys = key.round_keys();
+    auto rounds = key.rounds();
+    __m128i state = _mm_xor_si128(_mm_loadu_si128((const __m128i*)in), _mm_loadu_si128((const __m128i*)round_keys));
+    for (size_t round = 1; round < rounds; ++round)
+        state = _mm_aesenc_si128(state, _mm_loadu_si128((const __m128i*)(round_keys + 16 * round)));
+    state = _mm_aesenclast_si128(state, _mm_loadu_si128((const __m128i*)(round_keys + 16 * rounds)));
+    _mm_storeu_si128((__m128i*)out, state);
 }
 
-constexpr void swap_keys(u32* keys, size_t i, size_t j)
+[[gnu::target("aes,sse2")]] static void decrypt_block_aes_ni(const AESCipherKey& key, const u8* in, u8* out)
 {
-    u32 temp = keys[i];
-    keys[i] = keys[j];
-    keys[j] = temp;
+    const auto* round_keys = key.round_keys();
+    auto rounds = key.rounds();
+    __m128i state = _mm_xor_si128(_mm_loadu_si128((const __m128i*)in), _mm_loadu_si128((const __m128i*)round_keys));
+    for (size_t round = 1; round < rounds; ++round)
+        state = _mm_aesdec_si128(state, _mm_loadu_si128((const __m128i*)(round_keys + 16 * round)));
+    state = _mm_aesdeclast_si128(state, _mm_loadu_si128((const __m128i*)(round_keys + 16 * rounds)));
+    _mm_storeu_si128((__m128i*)out, state);
+}
+#endif
+
+bool AESCipher::is_hardware_accelerated()
+{
+#if ARCH(I386) || ARCH(X86_64)
+    return cpu_supports_aes_ni();
+#else
+    return false;
+#endif
 }
 
 String AESCipherBlock::to_string() const
@@ -54,345 +430,102 @@ String AESCipherBlock::to_string() const
 String AESCipherKey::to_string() const
 {
     StringBuilder builder;
-    for (size_t i = 0; i < (rounds() + 1) * 4; ++i)
+    for (size_t i = 0; i < (rounds() + 1) * 16; ++i)
         builder.appendf("%02x", m_rd_keys[i]);
     return builder.build();
 }
 
-void AESCipherKey::expand_encrypt_key(const ByteBuffer& user_key, size_t bits)
+void AESCipherKey::slice_round_keys()
 {
-    u32* round_key;
-    u32 temp;
-    size_t i { 0 };
+    for (size_t round = 0; round <= rounds(); ++round) {
+        u32 planes[8];
+        slice(m_rd_keys + 16 * round, planes);
+        for (size_t i = 0; i < 8; ++i)
+            m_sliced_rd_keys[8 * round + i] = planes[i];
+    }
+}
 
+void AESCipherKey::expand_encrypt_key(const ByteBuffer& user_key, size_t bits)
+{
     ASSERT(!user_key.is_null());
     ASSERT(is_valid_key_size(bits));
 
-    round_key = round_keys();
-
-    if (bits == 128) {
-        m_rounds = 10;
-    } else if (bits == 192) {
-        m_rounds = 12;
-    } else {
-        m_rounds = 14;
-    }
-
-    round_key[0] = get_key(user_key.slice_view(0, 4).data());
-    round_key[1] = get_key(user_key.slice_view(4, 4).data());
-    round_key[2] = get_key(user_key.slice_view(8, 4).data());
-    round_key[3] = get_key(user_key.slice_view(12, 4).data());
-    if (bits == 128) {
-        for (;;) {
-            temp = round_key[3];
-            // clang-format off
-            round_key[4] = round_key[0] ^
-                    (AESTables::Encode2[(temp >> 16) & 0xff] & 0xff000000) ^
-                    (AESTables::Encode3[(temp >>  8) & 0xff] & 0x00ff0000) ^
-                    (AESTables::Encode0[(temp      ) & 0xff] & 0x0000ff00) ^
-                    (AESTables::Encode1[(temp >> 24)       ] & 0x000000ff) ^ AESTables::RCON[i];
-            // clang-format on
-            round_key[5] = round_key[1] ^ round_key[4];
-            round_key[6] = round_key[2] ^ round_key[5];
-            round_key[7] = round_key[3] ^ round_key[6];
-            ++i;
-            if (i == 10)
-                break;
-            round_key += 4;
+    size_t key_words = bits / 32;
+    m_rounds = key_words + 6;
+
+    u32 words[(MAX_ROUND_COUNT + 1) * 4];
+    for (size_t i = 0; i < key_words; ++i)
+        words[i] = ((u32)user_key[4 * i] << 24) | ((u32)user_key[4 * i + 1] << 16) | ((u32)user_key[4 * i + 2] << 8) | user_key[4 * i + 3];
+
+    u32 round_constant = 1;
+    for (size_t i = key_words; i < (m_rounds + 1) * 4; ++i) {
+        u32 temp = words[i - 1];
+        if (i % key_words == 0) {
+            temp = sub_word((temp << 8) | (temp >> 24)) ^ (round_constant << 24);
+            round_constant = (round_constant << 1) ^ ((round_constant >> 7) * 0x11b);
+        } else if (key_words > 6 && i % key_words == 4) {
+            temp = sub_word(temp);
         }
-        return;
+        words[i] = words[i - key_words] ^ temp;
     }
 
-    round_key[4] = get_key(user_key.slice_view(16, 4).data());
-    round_key[5] = get_key(user_key.slice_view(20, 4).data());
-    if (bits == 192) {
-        for (;;) {
-            temp = round_key[5];
-            // clang-format off
-            round_key[6] = round_key[0] ^
-                    (AESTables::Encode2[(temp >> 16) & 0xff] & 0xff000000) ^
-                    (AESTables::Encode3[(temp >>  8) & 0xff] & 0x00ff0000) ^
-                    (AESTables::Encode0[(temp      ) & 0xff] & 0x0000ff00) ^
-                    (AESTables::Encode1[(temp >> 24)       ] & 0x000000ff) ^ AESTables::RCON[i];
-            // clang-format on
-            round_key[7] = round_key[1] ^ round_key[6];
-            round_key[8] = round_key[2] ^ round_key[7];
-            round_key[9] = round_key[3] ^ round_key[8];
-
-            ++i;
-            if (i == 8)
-                break;
-
-            round_key[10] = round_key[4] ^ round_key[9];
-            round_key[11] = round_key[5] ^ round_key[10];
-
-            round_key += 6;
-        }
-        return;
-    }
-
-    round_key[6] = get_key(user_key.slice_view(24, 4).data());
-    round_key[7] = get_key(user_key.slice_view(28, 4).data());
-    if (true) { // bits == 256
-        for (;;) {
-            temp = round_key[7];
-            // clang-format off
-            round_key[8] = round_key[0] ^
-                    (AESTables::Encode2[(temp >> 16) & 0xff] & 0xff000000) ^
-                    (AESTables::Encode3[(temp >>  8) & 0xff] & 0x00ff0000) ^
-                    (AESTables::Encode0[(temp      ) & 0xff] & 0x0000ff00) ^
-                    (AESTables::Encode1[(temp >> 24)       ] & 0x000000ff) ^ AESTables::RCON[i];
-            // clang-format on
-            round_key[9] = round_key[1] ^ round_key[8];
-            round_key[10] = round_key[2] ^ round_key[9];
-            round_key[11] = round_key[3] ^ round_key[10];
-
-            ++i;
-            if (i == 7)
-                break;
-
-            temp = round_key[11];
-            // clang-format off
-            round_key[12] = round_key[4] ^
-                    (AESTables::Encode2[(temp >> 24)       ] & 0xff000000) ^
-                    (AESTables::Encode3[(temp >> 16) & 0xff] & 0x00ff0000) ^
-                    (AESTables::Encode0[(temp >>  8) & 0xff] & 0x0000ff00) ^
-                    (AESTables::Encode1[(temp      ) & 0xff] & 0x000000ff) ;
-            // clang-format on
-            round_key[13] = round_key[5] ^ round_key[12];
-            round_key[14] = round_key[6] ^ round_key[13];
-            round_key[15] = round_key[7] ^ round_key[14];
-
-            round_key += 8;
-        }
-        return;
+    auto* round_key = round_keys();
+    for (size_t i = 0; i < (m_rounds + 1) * 4; ++i) {
+        round_key[4 * i] = words[i] >> 24;
+        round_key[4 * i + 1] = words[i] >> 16;
+        round_key[4 * i + 2] = words[i] >> 8;
+        round_key[4 * i + 3] = words[i];
     }
+    slice_round_keys();
 }
 
 void AESCipherKey::expand_decrypt_key(const ByteBuffer& user_key, size_t bits)
 {
-    u32* round_key;
-
     expand_encrypt_key(user_key, bits);
 
-    round_key = round_keys();
+    auto* round_key = round_keys();
 
     // reorder round keys
-    for (size_t i = 0, j = 4 * rounds(); i < j; i += 4, j -= 4) {
-        swap_keys(round_key, i, j);
-        swap_keys(round_key, i + 1, j + 1);
-        swap_keys(round_key, i + 2, j + 2);
-        swap_keys(round_key, i + 3, j + 3);
+    for (size_t i = 0, j = rounds(); i < j; ++i, --j) {
+        for (size_t k = 0; k < 16; ++k) {
+            u8 temp = round_key[16 * i + k];
+            round_key[16 * i + k] = round_key[16 * j + k];
+            round_key[16 * j + k] = temp;
+        }
     }
 
     // apply inverse mix-column to middle rounds
     for (size_t i = 1; i < rounds(); ++i) {
-        round_key += 4;
-        // clang-format off
-        round_key[0] =
-                AESTables::Decode0[AESTables::Encode1[(round_key[0] >> 24)       ] & 0xff] ^
-                AESTables::Decode1[AESTables::Encode1[(round_key[0] >> 16) & 0xff] & 0xff] ^
-                AESTables::Decode2[AESTables::Encode1[(round_key[0] >>  8) & 0xff] & 0xff] ^
-                AESTables::Decode3[AESTables::Encode1[(round_key[0]      ) & 0xff] & 0xff] ;
-        round_key[1] =
-                AESTables::Decode0[AESTables::Encode1[(round_key[1] >> 24)       ] & 0xff] ^
-                AESTables::Decode1[AESTables::Encode1[(round_key[1] >> 16) & 0xff] & 0xff] ^
-                AESTables::Decode2[AESTables::Encode1[(round_key[1] >>  8) & 0xff] & 0xff] ^
-                AESTables::Decode3[AESTables::Encode1[(round_key[1]      ) & 0xff] & 0xff] ;
-        round_key[2] =
-                AESTables::Decode0[AESTables::Encode1[(round_key[2] >> 24)       ] & 0xff] ^
-                AESTables::Decode1[AESTables::Encode1[(round_key[2] >> 16) & 0xff] & 0xff] ^
-                AESTables::Decode2[AESTables::Encode1[(round_key[2] >>  8) & 0xff] & 0xff] ^
-                AESTables::Decode3[AESTables::Encode1[(round_key[2]      ) & 0xff] & 0xff] ;
-        round_key[3] =
-                AESTables::Decode0[AESTables::Encode1[(round_key[3] >> 24)       ] & 0xff] ^
-                AESTables::Decode1[AESTables::Encode1[(round_key[3] >> 16) & 0xff] & 0xff] ^
-                AESTables::Decode2[AESTables::Encode1[(round_key[3] >>  8) & 0xff] & 0xff] ^
-                AESTables::Decode3[AESTables::Encode1[(round_key[3]      ) & 0xff] & 0xff] ;
-        // clang-format on
+        u32 planes[8];
+        slice(round_key + 16 * i, planes);
+        inverse_mix_columns(planes);
+        unslice(planes, round_key + 16 * i);
     }
+    slice_round_keys();
 }
 
 void AESCipher::encrypt_block(const AESCipherBlock& in, AESCipherBlock& out)
 {
-    u32 s0, s1, s2, s3, t0, t1, t2, t3;
-    size_t r { 0 };
-
-    const auto& dec_key = key();
-    const auto* round_keys = dec_key.round_keys();
-
-    s0 = get_key(in.data().offset_pointer(0)) ^ round_keys[0];
-    s1 = get_key(in.data().offset_pointer(4)) ^ round_keys[1];
-    s2 = get_key(in.data().offset_pointer(8)) ^ round_keys[2];
-    s3 = get_key(in.data().offset_pointer(12)) ^ round_keys[3];
-
-    r = dec_key.rounds() >> 1;
-
-    // apply the first |r - 1| rounds
-    auto i { 0 };
-    for (;;) {
-        ++i;
-        // clang-format off
-        t0 = AESTables::Encode0[(s0 >> 24)       ] ^
-             AESTables::Encode1[(s1 >> 16) & 0xff] ^
-             AESTables::Encode2[(s2 >>  8) & 0xff] ^
-             AESTables::Encode3[(s3      ) & 0xff] ^ round_keys[4];
-        t1 = AESTables::Encode0[(s1 >> 24)       ] ^
-             AESTables::Encode1[(s2 >> 16) & 0xff] ^
-             AESTables::Encode2[(s3 >>  8) & 0xff] ^
-             AESTables::Encode3[(s0      ) & 0xff] ^ round_keys[5];
-        t2 = AESTables::Encode0[(s2 >> 24)       ] ^
-             AESTables::Encode1[(s3 >> 16) & 0xff] ^
-             AESTables::Encode2[(s0 >>  8) & 0xff] ^
-             AESTables::Encode3[(s1      ) & 0xff] ^ round_keys[6];
-        t3 = AESTables::Encode0[(s3 >> 24)       ] ^
-             AESTables::Encode1[(s0 >> 16) & 0xff] ^
-             AESTables::Encode2[(s1 >>  8) & 0xff] ^
-             AESTables::Encode3[(s2      ) & 0xff] ^ round_keys[7];
-        // clang-format on
-
-        round_keys += 8;
-        --r;
-        ++i;
-        if (r == 0)
-            break;
-
-        // clang-format off
-        s0 = AESTables::Encode0[(t0 >> 24)       ] ^
-             AESTables::Encode1[(t1 >> 16) & 0xff] ^
-             AESTables::Encode2[(t2 >>  8) & 0xff] ^
-             AESTables::Encode3[(t3      ) & 0xff] ^ round_keys[0];
-        s1 = AESTables::Encode0[(t1 >> 24)       ] ^
-             AESTables::Encode1[(t2 >> 16) & 0xff] ^
-             AESTables::Encode2[(t3 >>  8) & 0xff] ^
-             AESTables::Encode3[(t0      ) & 0xff] ^ round_keys[1];
-        s2 = AESTables::Encode0[(t2 >> 24)       ] ^
-             AESTables::Encode1[(t3 >> 16) & 0xff] ^
-             AESTables::Encode2[(t0 >>  8) & 0xff] ^
-             AESTables::Encode3[(t1      ) & 0xff] ^ round_keys[2];
-        s3 = AESTables::Encode0[(t3 >> 24)       ] ^
-             AESTables::Encode1[(t0 >> 16) & 0xff] ^
-             AESTables::Encode2[(t1 >>  8) & 0xff] ^
-             AESTables::Encode3[(t2      ) & 0xff] ^ round_keys[3];
-        // clang-format on
-    }
-
-    // apply the last round and put the encrypted data into out
-    // clang-format off
-    s0 = (AESTables::Encode2[(t0 >> 24)       ] & 0xff000000) ^
-         (AESTables::Encode3[(t1 >> 16) & 0xff] & 0x00ff0000) ^
-         (AESTables::Encode0[(t2 >>  8) & 0xff] & 0x0000ff00) ^
-         (AESTables::Encode1[(t3      ) & 0xff] & 0x000000ff) ^ round_keys[0];
-    out.put(0, s0);
-
-    s1 = (AESTables::Encode2[(t1 >> 24)       ] & 0xff000000) ^
-         (AESTables::Encode3[(t2 >> 16) & 0xff] & 0x00ff0000) ^
-         (AESTables::Encode0[(t3 >>  8) & 0xff] & 0x0000ff00) ^
-         (AESTables::Encode1[(t0      ) & 0xff] & 0x000000ff) ^ round_keys[1];
-    out.put(4, s1);
-
-    s2 = (AESTables::Encode2[(t2 >> 24)       ] & 0xff000000) ^
-         (AESTables::Encode3[(t3 >> 16) & 0xff] & 0x00ff0000) ^
-         (AESTables::Encode0[(t0 >>  8) & 0xff] & 0x0000ff00) ^
-         (AESTables::Encode1[(t1      ) & 0xff] & 0x000000ff) ^ round_keys[2];
-    out.put(8, s2);
-
-    s3 = (AESTables::Encode2[(t3 >> 24)       ] & 0xff000000) ^
-         (AESTables::Encode3[(t0 >> 16) & 0xff] & 0x00ff0000) ^
-         (AESTables::Encode0[(t1 >>  8) & 0xff] & 0x0000ff00) ^
-         (AESTables::Encode1[(t2      ) & 0xff] & 0x000000ff) ^ round_keys[3];
-    out.put(12, s3);
-    // clang-format on
+    u8 result[16];
+#if ARCH(I386) || ARCH(X86_64)
+    if (cpu_supports_aes_ni())
+        encrypt_block_aes_ni(key(), in.data().data(), result);
+    else
+#endif
+        encrypt_block_sliced(key(), in.data().data(), result);
+    out.overwrite(result, sizeof(result));
 }
 
 void AESCipher::decrypt_block(const AESCipherBlock& in, AESCipherBlock& out)
 {
-
-    u32 s0, s1, s2, s3, t0, t1, t2, t3;
-    size_t r { 0 };
-
-    const auto& dec_key = key();
-    const auto* round_keys = dec_key.round_keys();
-
-    s0 = get_key(in.data().offset_pointer(0)) ^ round_keys[0];
-    s1 = get_key(in.data().offset_pointer(4)) ^ round_keys[1];
-    s2 = get_key(in.data().offset_pointer(8)) ^ round_keys[2];
-    s3 = get_key(in.data().offset_pointer(12)) ^ round_keys[3];
-
-    r = dec_key.rounds() >> 1;
-
-    // apply the first |r - 1| rounds
-    for (;;) {
-        // clang-format off
-        t0 = AESTables::Decode0[(s0 >> 24)       ] ^
-             AESTables::Decode1[(s3 >> 16) & 0xff] ^
-             AESTables::Decode2[(s2 >>  8) & 0xff] ^
-             AESTables::Decode3[(s1      ) & 0xff] ^ round_keys[4];
-        t1 = AESTables::Decode0[(s1 >> 24)       ] ^
-             AESTables::Decode1[(s0 >> 16) & 0xff] ^
-             AESTables::Decode2[(s3 >>  8) & 0xff] ^
-             AESTables::Decode3[(s2      ) & 0xff] ^ round_keys[5];
-        t2 = AESTables::Decode0[(s2 >> 24)       ] ^
-             AESTables::Decode1[(s1 >> 16) & 0xff] ^
-             AESTables::Decode2[(s0 >>  8) & 0xff] ^
-             AESTables::Decode3[(s3      ) & 0xff] ^ round_keys[6];
-        t3 = AESTables::Decode0[(s3 >> 24)       ] ^
-             AESTables::Decode1[(s2 >> 16) & 0xff] ^
-             AESTables::Decode2[(s1 >>  8) & 0xff] ^
-             AESTables::Decode3[(s0      ) & 0xff] ^ round_keys[7];
-        // clang-format on
-
-        round_keys += 8;
-        --r;
-        if (r == 0)
-            break;
-
-        // clang-format off
-        s0 = AESTables::Decode0[(t0 >> 24)       ] ^
-             AESTables::Decode1[(t3 >> 16) & 0xff] ^
-             AESTables::Decode2[(t2 >>  8) & 0xff] ^
-             AESTables::Decode3[(t1      ) & 0xff] ^ round_keys[0];
-        s1 = AESTables::Decode0[(t1 >> 24)       ] ^
-             AESTables::Decode1[(t0 >> 16) & 0xff] ^
-             AESTables::Decode2[(t3 >>  8) & 0xff] ^
-             AESTables::Decode3[(t2      ) & 0xff] ^ round_keys[1];
-        s2 = AESTables::Decode0[(t2 >> 24)       ] ^
-             AESTables::Decode1[(t1 >> 16) & 0xff] ^
-             AESTables::Decode2[(t0 >>  8) & 0xff] ^
-             AESTables::Decode3[(t3      ) & 0xff] ^ round_keys[2];
-        s3 = AESTables::Decode0[(t3 >> 24)       ] ^
-             AESTables::Decode1[(t2 >> 16) & 0xff] ^
-             AESTables::Decode2[(t1 >>  8) & 0xff] ^
-             AESTables::Decode3[(t0      ) & 0xff] ^ round_keys[3];
-        // clang-format on
-    }
-
-    // apply the last round and put the decrypted data into out
-    // clang-format off
-    s0 = ((u32)AESTables::Decode4[(t0 >> 24)       ] << 24) ^
-         ((u32)AESTables::Decode4[(t3 >> 16) & 0xff] << 16) ^
-         ((u32)AESTables::Decode4[(t2 >>  8) & 0xff] <<  8) ^
-         ((u32)AESTables::Decode4[(t1      ) & 0xff]      ) ^ round_keys[0];
-    out.put(0, s0);
-
-    s1 = ((u32)AESTables::Decode4[(t1 >> 24)       ] << 24) ^
-         ((u32)AESTables::Decode4[(t0 >> 16) & 0xff] << 16) ^
-         ((u32)AESTables::Decode4[(t3 >>  8) & 0xff] <<  8) ^
-         ((u32)AESTables::Decode4[(t2      ) & 0xff]      ) ^ round_keys[1];
-    out.put(4, s1);
-
-    s2 = ((u32)AESTables::Decode4[(t2 >> 24)       ] << 24) ^
-         ((u32)AESTables::Decode4[(t1 >> 16) & 0xff] << 16) ^
-         ((u32)AESTables::Decode4[(t0 >>  8) & 0xff] <<  8) ^
-         ((u32)AESTables::Decode4[(t3      ) & 0xff]      ) ^ round_keys[2];
-    out.put(8, s2);
-
-    s3 = ((u32)AESTables::Decode4[(t3 >> 24)       ] << 24) ^
-         ((u32)AESTables::Decode4[(t2 >> 16) & 0xff] << 16) ^
-         ((u32)AESTables::Decode4[(t1 >>  8) & 0xff] <<  8) ^
-         ((u32)AESTables::Decode4[(t0      ) & 0xff]      ) ^ round_keys[3];
-    out.put(12, s3);
-    // clang-format on
+    u8 result[16];
+#if ARCH(I386) || ARCH(X86_64)
+    if (cpu_supports_aes_ni())
+        decrypt_block_aes_ni(key(), in.data().data(), result);
+    else
+#endif
+        decrypt_block_sliced(key(), in.data().data(), result);
+    out.overwrite(result, sizeof(result));
 }
 
 void AESCipherBlock::overwrite(const ByteBuffer& buffer)
@@ -0,0 +1,174 @@
+/*
+ * Copyright (c) 2020, Ali Mohammad Pur <ali.mpfard@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <LibCrypto/Authentication/Poly1305.h>
+#include <LibCrypto/Cipher/ChaCha20.h>
+
+namespace Crypto {
+namespace Cipher {
+
+static u32 load_little_endian(const u8* data)
+{
+    return data[0] | (data[1] << 8) | (data[2] << 16) | ((u32)data[3] << 24);
+}
+
+static void store_little_endian(u32 value, u8* data)
+{
+    for (size_t i = 0; i < 4; ++i)
+        data[i] = value >> (8 * i);
+}
+
+static inline u32 rotate_left(u32 value, u32 count)
+{
+    return (value << count) | (value >> (32 - count));
+}
+
+static inline void quarter_round(u32* x, size_t a, size_t b, size_t c, size_t d)
+{
+    x[a] += x[b];
+    x[d] = rotate_left(x[d] ^ x[a], 16);
+    x[c] += x[d];
+    x[b] = rotate_left(x[b] ^ x[c], 12);
+    x[a] += x[b];
+    x[d] = rotate_left(x[d] ^ x[a], 8);
+    x[c] += x[d];
+    x[b] = rotate_left(x[b] ^ x[c], 7);
+}
+
+ChaCha20::ChaCha20(const u8* key, const u8* nonce, u32 counter)
+{
+    // "expand 32-byte k"
+    m_state[0] = 0x61707865;
+    m_state[1] = 0x3320646e;
+    m_state[2] = 0x79622d32;
+    m_state[3] = 0x6b206574;
+    for (size_t i = 0; i < 8; ++i)
+        m_state[4 + i] = load_little_endian(key + 4 * i);
+    m_state[12] = counter;
+    for (size_t i = 0; i < 3; ++i)
+        m_state[13 + i] = load_little_endian(nonce + 4 * i);
+}
+
+void ChaCha20::generate_block(u8* out)
+{
+    u32 x[16];
+    __builtin_memcpy(x, m_state, sizeof(x));
+
+    for (size_t i = 0; i < 10; ++i) {
+        quarter_round(x, 0, 4, 8, 12);
+        quarter_round(x, 1, 5, 9, 13);
+        quarter_round(x, 2, 6, 10, 14);
+        quarter_round(x, 3, 7, 11, 15);
+        quarter_round(x, 0, 5, 10, 15);
+        quarter_round(x, 1, 6, 11, 12);
+        quarter_round(x, 2, 7, 8, 13);
+        quarter_round(x, 3, 4, 9, 14);
+    }
+
+    for (size_t i = 0; i < 16; ++i)
+        store_little_endian(x[i] + m_state[i], out + 4 * i);
+
+    ++m_state[12];
+}
+
+void ChaCha20::process(const u8* in, u8* out, size_t length)
+{
+    u8 keystream[BlockSize];
+    for (size_t offset = 0; offset < length; offset += BlockSize) {
+        generate_block(keystream);
+        auto count = min(length - offset, BlockSize);
+        for (size_t i = 0; i < count; ++i)
+            out[offset + i] = in[offset + i] ^ keystream[i];
+    }
+}
+
+ChaCha20Poly1305::ChaCha20Poly1305(const ByteBuffer& key)
+{
+    ASSERT(key.size() == KeySize);
+    __builtin_memcpy(m_key, key.data(), KeySize);
+}
+
+void ChaCha20Poly1305::compute_tag(const u8* one_time_key, const ByteBuffer& aad, const ByteBuffer& cipher_text, u8* tag)
+{
+    static constexpr u8 zeros[16] {};
+    Authentication::Poly1305 poly1305(one_time_key);
+
+    poly1305.update(aad);
+    poly1305.update(zeros, (16 - aad.size() % 16) % 16);
+    poly1305.update(cipher_text);
+    poly1305.update(zeros, (16 - cipher_text.size() % 16) % 16);
+
+    u8 lengths[16];
+    for (size_t i = 0; i < 8; ++i) {
+        lengths[i] = (u64)aad.size() >> (8 * i);
+        lengths[8 + i] = (u64)cipher_text.size() >> (8 * i);
+    }
+    poly1305.update(lengths, sizeof(lengths));
+
+    auto digest = poly1305.digest();
+    __builtin_memcpy(tag, digest.immutable_data(), TagSizeInBytes);
+}
+
+void ChaCha20Poly1305::encrypt(const ByteBuffer& in, ByteBuffer& out, const ByteBuffer& nonce, const ByteBuffer& aad, ByteBuffer& tag)
+{
+    ASSERT(nonce.size() == NonceSize);
+    ASSERT(out.size() >= in.size());
+    ASSERT(tag.size() >= TagSizeInBytes);
+
+    ChaCha20 chacha20(m_key, nonce.data());
+    u8 first_block[ChaCha20::BlockSize];
+    chacha20.generate_block(first_block);
+    chacha20.process(in.data(), out.data(), in.size());
+
+    compute_tag(first_block, aad, out.slice_view(0, in.size()), tag.data());
+}
+
+bool ChaCha20Poly1305::decrypt(const ByteBuffer& in, ByteBuffer& out, const ByteBuffer& nonce, const ByteBuffer& aad, const ByteBuffer& tag)
+{
+    ASSERT(nonce.size() == NonceSize);
+    ASSERT(out.size() >= in.size());
+    if (tag.size() != TagSizeInBytes)
+        return false;
+
+    ChaCha20 chacha20(m_key, nonce.data());
+    u8 first_block[ChaCha20::BlockSize];
+    chacha20.generate_block(first_block);
+
+    u8 expected_tag[TagSizeInBytes];
+    compute_tag(first_block, aad, in, expected_tag);
+
+    u8 difference = 0;
+    for (size_t i = 0; i < TagSizeInBytes; ++i)
+        difference |= expected_tag[i] ^ tag[i];
+    if (difference != 0)
+        return false;
+
+    chacha20.process(in.data(), out.data(), in.size());
+    return true;
+}
+
+}
+}
@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2020, Ali Mohammad Pur <ali.mpfard@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/ByteBuffer.h>
+#include <AK/String.h>
+#include <AK/Types.h>
+
+namespace Crypto {
+namespace Cipher {
+
+// The ChaCha20 stream cipher from RFC 8439. It only needs 32-bit additions, rotations and XORs, so it is
+// fast and constant-time on processors that have no AES instructions.
+class ChaCha20 {
+public:
+    constexpr static size_t KeySize = 32;
+    constexpr static size_t NonceSize = 12;
+    constexpr static size_t BlockSize = 64;
+
+    ChaCha20(const u8* key, const u8* nonce, u32 counter = 0);
+
+    String class_name() const { return "ChaCha20"; }
+
+    // XORs `in` with the keystream into `out`. Consecutive calls continue the keystream a whole block at a time,
+    // so all but the last must cover a multiple of BlockSize.
+    void process(const u8* in, u8* out, size_t length);
+
+    void generate_block(u8* out);
+
+private:
+    u32 m_state[16];
+};
+
+// The AEAD construction from RFC 8439 section 2.8: ChaCha20 encryption, authenticated with a Poly1305
+// key taken from the first keystream block. The interface matches GCM's.
+class ChaCha20Poly1305 {
+public:
+    constexpr static size_t KeySize = ChaCha20::KeySize;
+    constexpr static size_t NonceSize = ChaCha20::NonceSize;
+    constexpr static size_t TagSizeInBytes = 16;
+
+    explicit ChaCha20Poly1305(const ByteBuffer& key);
+
+    String class_name() const { return "ChaCha20_Poly1305"; }
+
+    // Encrypts `in` into `out` and writes the authentication tag for it and `aad` into `tag`.
+    // `in` and `out` may be the same buffer, in both directions.
+    void encrypt(const ByteBuffer& in, ByteBuffer& out, const ByteBuffer& nonce, const ByteBuffer& aad, ByteBuffer& tag);
+
+    // Checks `tag` against `in` and `aad`, and only if it matches decrypts `in` into `out`.
+    bool decrypt(const ByteBuffer& in, ByteBuffer& out, const ByteBuffer& nonce, const ByteBuffer& aad, const ByteBuffer& tag);
+
+private:
+    void compute_tag(const u8* one_time_key, const ByteBuffer& aad, const ByteBuffer& cipher_text, u8* tag);
+
+    u8 m_key[KeySize];
+};
+
+}
+}
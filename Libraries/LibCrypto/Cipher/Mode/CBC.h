@@ -112,14 +112,20 @@ public:
         typename T::BlockType block { cipher.padding_mode() };
         size_t offset { 0 };
 
+        // `in` and `out` may be the same buffer, so each ciphertext block is kept aside to chain into the next one.
+        u8 chain[2][T::BlockType::BlockSizeInBits / 8];
+        size_t chain_index { 0 };
+
         while (length > 0) {
             auto* slice = in.offset_pointer(offset);
+            __builtin_memcpy(chain[chain_index], slice, block_size);
             block.overwrite(slice, block_size);
             cipher.decrypt_block(block, block);
             block.apply_initialization_vector(iv);
             auto decrypted = block.get();
             out.overwrite(offset, decrypted.data(), decrypted.size());
-            iv = slice;
+            iv = chain[chain_index];
+            chain_index ^= 1;
             length -= block_size;
             offset += block_size;
         }
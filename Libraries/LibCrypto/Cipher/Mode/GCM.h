@@ -0,0 +1,180 @@
+/*
+ * Copyright (c) 2020, Ali Mohammad Pur <ali.mpfard@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/String.h>
+#include <AK/StringBuilder.h>
+#include <LibCrypto/Authentication/GHash.h>
+#include <LibCrypto/Cipher/Mode/Mode.h>
+
+namespace Crypto {
+namespace Cipher {
+
+// Galois/Counter Mode (NIST SP 800-38D): counter mode encryption, authenticated with GHash over the
+// additional data and the ciphertext. Both directions only ever run the cipher forwards.
+template<typename T>
+class GCM : public Mode<T> {
+public:
+    constexpr static size_t IVSizeInBits = 96;
+    constexpr static size_t TagSizeInBytes = Authentication::GHash::TagType::Size;
+
+    virtual ~GCM() { }
+
+    explicit GCM<T>(const ByteBuffer& user_key, size_t key_bits, Intent = Intent::Encryption)
+        : Mode<T>(user_key, key_bits, Intent::Encryption, PaddingMode::Null)
+        , m_ghash(hash_subkey())
+    {
+    }
+
+    virtual String class_name() const override
+    {
+        StringBuilder builder;
+        builder.append(this->cipher().class_name());
+        builder.append("_GCM");
+        return builder.build();
+    }
+
+    virtual size_t IV_length() const override { return IVSizeInBits / 8; }
+
+    // Encrypts `in` into `out` and writes the authentication tag for it and `aad` into `tag`.
+    // `in` and `out` may be the same buffer, in both directions.
+    void encrypt(const ByteBuffer& in, ByteBuffer& out, const ByteBuffer& iv, const ByteBuffer& aad, ByteBuffer& tag)
+    {
+        ASSERT(out.size() >= in.size());
+        ASSERT(tag.size() >= TagSizeInBytes);
+
+        u8 counter[16];
+        initial_counter(iv, counter);
+        apply_keystream(in, out, counter);
+        compute_tag(aad, out.slice_view(0, in.size()), counter, tag.data());
+    }
+
+    // Checks `tag` against `in` and `aad`, and only if it matches decrypts `in` into `out`.
+    bool decrypt(const ByteBuffer& in, ByteBuffer& out, const ByteBuffer& iv, const ByteBuffer& aad, const ByteBuffer& tag)
+    {
+        ASSERT(out.size() >= in.size());
+        if (tag.size() != TagSizeInBytes)
+            return false;
+
+        u8 counter[16];
+        initial_counter(iv, counter);
+        u8 expected_tag[TagSizeInBytes];
+        compute_tag(aad, in, counter, expected_tag);
+
+        u8 difference = 0;
+        for (size_t i = 0; i < TagSizeInBytes; ++i)
+            difference |= expected_tag[i] ^ tag[i];
+        if (difference != 0)
+            return false;
+
+        apply_keystream(in, out, counter);
+        return true;
+    }
+
+    // Without additional data; the tag is returned.
+    virtual Optional<ByteBuffer> encrypt(const ByteBuffer& in, ByteBuffer& out, Optional<ByteBuffer> ivec = {}) override
+    {
+        ASSERT(ivec.has_value());
+        auto tag = ByteBuffer::create_uninitialized(TagSizeInBytes);
+        encrypt(in, out, ivec.value(), {}, tag);
+        return tag;
+    }
+
+    virtual void decrypt(const ByteBuffer&, ByteBuffer&, Optional<ByteBuffer> = {}) override
+    {
+        // Decrypting without checking the tag would defeat the point of GCM, use the overload that takes it.
+        ASSERT_NOT_REACHED();
+    }
+
+private:
+    ByteBuffer hash_subkey()
+    {
+        typename T::BlockType block { PaddingMode::Null };
+        this->cipher().encrypt_block(block, block);
+        return block.get();
+    }
+
+    void initial_counter(const ByteBuffer& iv, u8* counter)
+    {
+        if (iv.size() == IVSizeInBits / 8) {
+            __builtin_memcpy(counter, iv.data(), iv.size());
+            counter[12] = 0;
+            counter[13] = 0;
+            counter[14] = 0;
+            counter[15] = 1;
+            return;
+        }
+        auto digest = m_ghash.process({}, iv);
+        __builtin_memcpy(counter, digest.immutable_data(), 16);
+    }
+
+    static void increment_counter(u8* counter)
+    {
+        for (size_t i = 15; i >= 12; --i) {
+            if (++counter[i] != 0)
+                break;
+        }
+    }
+
+    // XORs the keystream starting after the initial counter block into `out`; the initial block is left as it was.
+    void apply_keystream(const ByteBuffer& in, ByteBuffer& out, const u8* initial_counter)
+    {
+        auto& cipher = this->cipher();
+        typename T::BlockType block { PaddingMode::Null };
+        u8 counter[16];
+        __builtin_memcpy(counter, initial_counter, sizeof(counter));
+
+        auto* output = out.data();
+        const auto* input = in.data();
+        for (size_t offset = 0; offset < in.size(); offset += 16) {
+            increment_counter(counter);
+            block.overwrite(counter, sizeof(counter));
+            cipher.encrypt_block(block, block);
+            auto keystream = block.get();
+            auto length = min(in.size() - offset, (size_t)16);
+            for (size_t i = 0; i < length; ++i)
+                output[offset + i] = input[offset + i] ^ keystream[i];
+        }
+    }
+
+    void compute_tag(const ByteBuffer& aad, const ByteBuffer& cipher_text, const u8* initial_counter, u8* tag)
+    {
+        auto digest = m_ghash.process(aad, cipher_text);
+        typename T::BlockType block { PaddingMode::Null };
+        block.overwrite(initial_counter, 16);
+        this->cipher().encrypt_block(block, block);
+        auto encrypted_counter = block.get();
+        for (size_t i = 0; i < TagSizeInBytes; ++i)
+            tag[i] = digest.data[i] ^ encrypted_counter[i];
+    }
+
+    Authentication::GHash m_ghash;
+};
+
+}
+
+}
@@ -79,6 +79,10 @@ protected:
         }
         case PaddingMode::RFC5246: {
             auto maybe_padding_length = data[size - 1];
+            if (maybe_padding_length >= size) {
+                // more padding than data, this can't be right
+                return;
+            }
             // FIXME: If we want constant-time operations, this loop should not stop
             for (auto i = size - maybe_padding_length - 1; i < size; ++i) {
                 if (data[i] != maybe_padding_length) {
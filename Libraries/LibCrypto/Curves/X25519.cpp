@@ -0,0 +1,228 @@
+/*
+ * Copyright (c) 2020, Ali Mohammad Pur <ali.mpfard@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/Random.h>
+#include <LibCrypto/Curves/X25519.h>
+
+namespace Crypto {
+namespace Curves {
+
+// Field elements mod 2^255 - 19 are kept as sixteen 16-bit limbs in signed 64-bit integers, which leaves
+// enough headroom to multiply without carrying in between.
+typedef i64 FieldElement[16];
+
+static void carry(FieldElement element)
+{
+    for (size_t i = 0; i < 16; ++i) {
+        i64 overflow = element[i] >> 16;
+        element[i] &= 0xffff;
+        // 2^256 = 38 mod p, so what overflows the top limb wraps around to the bottom one.
+        if (i < 15)
+            element[i + 1] += overflow;
+        else
+            element[0] += 38 * overflow;
+    }
+}
+
+// Swaps `a` and `b` if `condition` is 1, without branching on it.
+static void conditional_swap(FieldElement a, FieldElement b, i64 condition)
+{
+    i64 mask = ~(condition - 1);
+    for (size_t i = 0; i < 16; ++i) {
+        i64 t = mask & (a[i] ^ b[i]);
+        a[i] ^= t;
+        b[i] ^= t;
+    }
+}
+
+static void add(FieldElement out, const FieldElement a, const FieldElement b)
+{
+    for (size_t i = 0; i < 16; ++i)
+        out[i] = a[i] + b[i];
+}
+
+static void subtract(FieldElement out, const FieldElement a, const FieldElement b)
+{
+    for (size_t i = 0; i < 16; ++i)
+        out[i] = a[i] - b[i];
+}
+
+static void multiply(FieldElement out, const FieldElement a, const FieldElement b)
+{
+    i64 product[31] {};
+    for (size_t i = 0; i < 16; ++i) {
+        for (size_t j = 0; j < 16; ++j)
+            product[i + j] += a[i] * b[j];
+    }
+    for (size_t i = 0; i < 15; ++i)
+        product[i] += 38 * product[i + 16];
+    for (size_t i = 0; i < 16; ++i)
+        out[i] = product[i];
+    carry(out);
+    carry(out);
+}
+
+static void square(FieldElement out, const FieldElement a)
+{
+    multiply(out, a, a);
+}
+
+// a^(p - 2), which is the inverse of a by Fermat's little theorem.
+static void invert(FieldElement out, const FieldElement a)
+{
+    FieldElement c;
+    for (size_t i = 0; i < 16; ++i)
+        c[i] = a[i];
+    for (int bit = 253; bit >= 0; --bit) {
+        square(c, c);
+        if (bit != 2 && bit != 4)
+            multiply(c, c, a);
+    }
+    for (size_t i = 0; i < 16; ++i)
+        out[i] = c[i];
+}
+
+static void unpack(FieldElement out, const u8* bytes)
+{
+    for (size_t i = 0; i < 16; ++i)
+        out[i] = bytes[2 * i] + ((i64)bytes[2 * i + 1] << 8);
+    // The top bit of a coordinate is ignored.
+    out[15] &= 0x7fff;
+}
+
+// Writes the fully reduced value of `element` as 32 little-endian bytes.
+static void pack(u8* bytes, const FieldElement element)
+{
+    FieldElement t, m;
+    for (size_t i = 0; i < 16; ++i)
+        t[i] = element[i];
+    carry(t);
+    carry(t);
+    carry(t);
+    // t is now below 2^256, so subtracting p at most twice brings it into range.
+    for (size_t pass = 0; pass < 2; ++pass) {
+        m[0] = t[0] - 0xffed;
+        for (size_t i = 1; i < 15; ++i) {
+            m[i] = t[i] - 0xffff - ((m[i - 1] >> 16) & 1);
+            m[i - 1] &= 0xffff;
+        }
+        m[15] = t[15] - 0x7fff - ((m[14] >> 16) & 1);
+        i64 borrow = (m[15] >> 16) & 1;
+        m[14] &= 0xffff;
+        conditional_swap(t, m, 1 - borrow);
+    }
+    for (size_t i = 0; i < 16; ++i) {
+        bytes[2 * i] = t[i] & 0xff;
+        bytes[2 * i + 1] = t[i] >> 8;
+    }
+}
+
+ByteBuffer X25519::generate_private_key()
+{
+    auto key = ByteBuffer::create_uninitialized(key_size);
+    AK::fill_with_random(key.data(), key_size);
+    return key;
+}
+
+ByteBuffer X25519::generate_public_key(const ByteBuffer& private_key)
+{
+    u8 base_point[key_size] { 9 };
+    return compute_coordinate(private_key, ByteBuffer::wrap(base_point, key_size));
+}
+
+ByteBuffer X25519::compute_coordinate(const ByteBuffer& scalar, const ByteBuffer& coordinate)
+{
+    ASSERT(scalar.size() == key_size);
+    ASSERT(coordinate.size() == key_size);
+
+    u8 clamped[key_size];
+    __builtin_memcpy(clamped, scalar.data(), key_size);
+    clamped[0] &= 248;
+    clamped[31] = (clamped[31] & 127) | 64;
+
+    FieldElement x;
+    unpack(x, coordinate.data());
+
+    // The Montgomery ladder from RFC 7748 section 5, with (a : c) and (b : d) as the projective points.
+    const FieldElement a24 { 0xdb41, 1 };
+    FieldElement a {}, b, c {}, d {}, e, f;
+    for (size_t i = 0; i < 16; ++i)
+        b[i] = x[i];
+    a[0] = 1;
+    d[0] = 1;
+
+    for (int bit = 254; bit >= 0; --bit) {
+        i64 swap = (clamped[bit >> 3] >> (bit & 7)) & 1;
+        conditional_swap(a, b, swap);
+        conditional_swap(c, d, swap);
+        add(e, a, c);
+        subtract(a, a, c);
+        add(c, b, d);
+        subtract(b, b, d);
+        square(d, e);
+        square(f, a);
+        multiply(a, c, a);
+        multiply(c, b, e);
+        add(e, a, c);
+        subtract(a, a, c);
+        square(b, a);
+        subtract(c, d, f);
+        multiply(a, c, a24);
+        add(a, a, d);
+        multiply(c, c, a);
+        multiply(a, d, f);
+        multiply(d, b, x);
+        square(b, e);
+        conditional_swap(a, b, swap);
+        conditional_swap(c, d, swap);
+    }
+
+    invert(c, c);
+    multiply(a, a, c);
+
+    auto result = ByteBuffer::create_uninitialized(key_size);
+    pack(result.data(), a);
+    return result;
+}
+
+ByteBuffer X25519::derive_shared_secret(const ByteBuffer& private_key, const ByteBuffer& peer_public_key)
+{
+    if (peer_public_key.size() != key_size)
+        return {};
+
+    auto secret = compute_coordinate(private_key, peer_public_key);
+
+    u8 accumulated = 0;
+    for (size_t i = 0; i < key_size; ++i)
+        accumulated |= secret[i];
+    if (accumulated == 0)
+        return {};
+
+    return secret;
+}
+
+}
+}
@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) 2020, Ali Mohammad Pur <ali.mpfard@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/ByteBuffer.h>
+#include <AK/Types.h>
+
+namespace Crypto {
+namespace Curves {
+
+// Diffie-Hellman over Curve25519 (RFC 7748). Keys and coordinates are 32 bytes, little-endian.
+// Everything runs in constant time with respect to the scalar.
+class X25519 {
+public:
+    constexpr static size_t key_size = 32;
+
+    static ByteBuffer generate_private_key();
+    static ByteBuffer generate_public_key(const ByteBuffer& private_key);
+
+    // Multiplies the point with u-coordinate `coordinate` by `scalar`, after clamping the scalar.
+    static ByteBuffer compute_coordinate(const ByteBuffer& scalar, const ByteBuffer& coordinate);
+
+    // The shared secret for our private key and the peer's public key, or an empty buffer if the
+    // peer sent a point of small order, which would make the secret all zeros.
+    static ByteBuffer derive_shared_secret(const ByteBuffer& private_key, const ByteBuffer& peer_public_key);
+};
+
+}
+}
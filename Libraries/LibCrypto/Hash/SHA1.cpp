@@ -24,9 +24,14 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <AK/StdLibExtras.h>
 #include <AK/Types.h>
 #include <LibCrypto/Hash/SHA1.h>
 
+#if ARCH(I386) || ARCH(X86_64)
+#    include <immintrin.h>
+#endif
+
 namespace Crypto {
 namespace Hash {
 
@@ -85,16 +90,127 @@ inline void SHA1::transform(const u8* data)
     __builtin_memset(blocks, 0, 16 * sizeof(u32));
 }
 
-void SHA1::update(const u8* message, size_t length)
+#if ARCH(I386) || ARCH(X86_64)
+static bool cpu_supports_sha_ni()
+{
+    static int s_supported = -1;
+    if (s_supported < 0) {
+        u32 eax = 1, ebx, ecx = 0, edx;
+        asm volatile("cpuid"
+                     : "+a"(eax), "=b"(ebx), "+c"(ecx), "=d"(edx));
+        bool has_sse41 = ecx & (1 << 19);
+        eax = 7;
+        ecx = 0;
+        asm volatile("cpuid"
+                     : "+a"(eax), "=b"(ebx), "+c"(ecx), "=d"(edx));
+        s_supported = (has_sse41 && (ebx & (1 << 29))) ? 1 : 0;
+    }
+    return s_supported;
+}
+
+// The round function is an immediate operand, so it can't be passed through as a variable.
+[[gnu::target("sha,sse4.1")]] static inline __m128i sha1_four_rounds(__m128i abcd, __m128i e, size_t function)
 {
-    for (size_t i = 0; i < length; ++i) {
-        if (m_data_length == BlockSize) {
-            transform(m_data_buffer);
-            m_bit_length += 512;
-            m_data_length = 0;
+    switch (function) {
+    case 0:
+        return _mm_sha1rnds4_epu32(abcd, e, 0);
+    case 1:
+        return _mm_sha1rnds4_epu32(abcd, e, 1);
+    case 2:
+        return _mm_sha1rnds4_epu32(abcd, e, 2);
+    default:
+        return _mm_sha1rnds4_epu32(abcd, e, 3);
+    }
+}
+
+[[gnu::target("sha,sse4.1")]] static void transform_sha_ni(u32* state, const u8* data, size_t block_count)
+{
+    const __m128i byte_swap = _mm_set_epi64x(0x0001020304050607ULL, 0x08090a0b0c0d0e0fULL);
+
+    auto abcd = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)state), 0x1b);
+    auto e0 = _mm_set_epi32(state[4], 0, 0, 0);
+    __m128i e1;
+
+    for (; block_count; --block_count, data += 64) {
+        auto abcd_saved = abcd;
+        auto e_saved = e0;
+        __m128i message[4];
+
+        for (size_t group = 0; group < 20; ++group) {
+            auto& current = message[group % 4];
+            if (group < 4)
+                current = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(data + group * 16)), byte_swap);
+
+            // E for the next four rounds comes out of A of the current ones, so the two registers take turns.
+            if (group == 0) {
+                e0 = _mm_add_epi32(e0, current);
+                e1 = abcd;
+                abcd = sha1_four_rounds(abcd, e0, 0);
+            } else if (group % 2 == 0) {
+                e0 = _mm_sha1nexte_epu32(e0, current);
+                e1 = abcd;
+                abcd = sha1_four_rounds(abcd, e0, group / 5);
+            } else {
+                e1 = _mm_sha1nexte_epu32(e1, current);
+                e0 = abcd;
+                abcd = sha1_four_rounds(abcd, e1, group / 5);
+            }
+
+            if (group >= 3 && group < 19)
+                message[(group + 1) % 4] = _mm_sha1msg2_epu32(message[(group + 1) % 4], current);
+            if (group >= 1 && group < 17)
+                message[(group + 3) % 4] = _mm_sha1msg1_epu32(message[(group + 3) % 4], current);
+            if (group >= 2 && group < 18)
+                message[(group + 2) % 4] = _mm_xor_si128(message[(group + 2) % 4], current);
         }
-        m_data_buffer[m_data_length++] = message[i];
+
+        e0 = _mm_sha1nexte_epu32(e0, e_saved);
+        abcd = _mm_add_epi32(abcd, abcd_saved);
+    }
+
+    _mm_storeu_si128((__m128i*)state, _mm_shuffle_epi32(abcd, 0x1b));
+    state[4] = _mm_extract_epi32(e0, 3);
+}
+#endif
+
+void SHA1::transform_blocks(const u8* data, size_t block_count)
+{
+#if ARCH(I386) || ARCH(X86_64)
+    if (cpu_supports_sha_ni()) {
+        transform_sha_ni(m_state, data, block_count);
+        return;
+    }
+#endif
+    for (; block_count; --block_count, data += BlockSize)
+        transform(data);
+}
+
+void SHA1::update(const u8* message, size_t length)
+{
+    // Top up a partially filled block first; whole blocks after that are hashed straight from the input.
+    if (m_data_length) {
+        auto to_copy = min(length, BlockSize - m_data_length);
+        __builtin_memcpy(m_data_buffer + m_data_length, message, to_copy);
+        m_data_length += to_copy;
+        message += to_copy;
+        length -= to_copy;
+        if (m_data_length < BlockSize)
+            return;
+        transform_blocks(m_data_buffer, 1);
+        m_bit_length += 512;
+        m_data_length = 0;
     }
+
+    auto block_count = length / BlockSize;
+    if (block_count) {
+        transform_blocks(message, block_count);
+        m_bit_length += block_count * 512;
+        message += block_count * BlockSize;
+        length -= block_count * BlockSize;
+    }
+
+    __builtin_memcpy(m_data_buffer, message, length);
+    m_data_length = length;
 }
 
 SHA1::DigestType SHA1::digest()
@@ -125,7 +241,7 @@ SHA1::DigestType SHA1::peek()
         while (i < BlockSize)
             m_data_buffer[i++] = 0x00;
 
-        transform(m_data_buffer);
+        transform_blocks(m_data_buffer, 1);
         __builtin_memset(m_data_buffer, 0, FinalBlockDataSize);
     }
 
@@ -140,7 +256,7 @@ SHA1::DigestType SHA1::peek()
     m_data_buffer[BlockSize - 7] = m_bit_length >> 48;
     m_data_buffer[BlockSize - 8] = m_bit_length >> 56;
 
-    transform(m_data_buffer);
+    transform_blocks(m_data_buffer, 1);
 
     for (size_t i = 0; i < 4; ++i) {
         digest.data[i + 0] = (m_state[0] >> (24 - i * 8)) & 0x000000ff;
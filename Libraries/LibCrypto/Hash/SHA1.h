@@ -93,6 +93,8 @@ public:
 
 private:
     inline void transform(const u8*);
+    // Runs the compression function over whole blocks, with the SHA extensions when the CPU has them.
+    void transform_blocks(const u8*, size_t block_count);
 
     u8 m_data_buffer[BlockSize];
     size_t m_data_length { 0 };
@@ -24,9 +24,14 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <AK/StdLibExtras.h>
 #include <AK/Types.h>
 #include <LibCrypto/Hash/SHA2.h>
 
+#if ARCH(I386) || ARCH(X86_64)
+#    include <immintrin.h>
+#endif
+
 namespace Crypto {
 namespace Hash {
 constexpr inline static auto ROTRIGHT(u32 a, size_t b) { return (a >> b) | (a << (32 - b)); }
@@ -86,16 +91,107 @@ inline void SHA256::transform(const u8* data)
     m_state[7] += h;
 }
 
-void SHA256::update(const u8* message, size_t length)
+#if ARCH(I386) || ARCH(X86_64)
+static bool cpu_supports_sha_ni()
 {
-    for (size_t i = 0; i < length; ++i) {
-        if (m_data_length == BlockSize) {
-            transform(m_data_buffer);
-            m_bit_length += 512;
-            m_data_length = 0;
+    static int s_supported = -1;
+    if (s_supported < 0) {
+        u32 eax = 1, ebx, ecx = 0, edx;
+        asm volatile("cpuid"
+                     : "+a"(eax), "=b"(ebx), "+c"(ecx), "=d"(edx));
+        bool has_sse41 = ecx & (1 << 19);
+        eax = 7;
+        ecx = 0;
+        asm volatile("cpuid"
+                     : "+a"(eax), "=b"(ebx), "+c"(ecx), "=d"(edx));
+        s_supported = (has_sse41 && (ebx & (1 << 29))) ? 1 : 0;
+    }
+    return s_supported;
+}
+
+// The SHA extensions keep the state as ABEF and CDGH, and do four rounds of the message schedule at a time.
+[[gnu::target("sha,sse4.1")]] static void transform_sha_ni(u32* state, const u8* data, size_t block_count)
+{
+    const __m128i byte_swap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+
+    auto dcba = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)&state[0]), 0xb1);
+    auto hgfe = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)&state[4]), 0x1b);
+    auto abef = _mm_alignr_epi8(dcba, hgfe, 8);
+    auto cdgh = _mm_blend_epi16(hgfe, dcba, 0xf0);
+
+    for (; block_count; --block_count, data += 64) {
+        auto abef_saved = abef;
+        auto cdgh_saved = cdgh;
+        __m128i message[4];
+
+        for (size_t group = 0; group < 16; ++group) {
+            auto& current = message[group % 4];
+            if (group < 4)
+                current = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(data + group * 16)), byte_swap);
+
+            auto words = _mm_add_epi32(current, _mm_loadu_si128((const __m128i*)&SHA256Constants::RoundConstants[group * 4]));
+            cdgh = _mm_sha256rnds2_epu32(cdgh, abef, words);
+            if (group >= 3 && group < 15) {
+                auto& next = message[(group + 1) % 4];
+                next = _mm_add_epi32(next, _mm_alignr_epi8(current, message[(group + 3) % 4], 4));
+                next = _mm_sha256msg2_epu32(next, current);
+            }
+            abef = _mm_sha256rnds2_epu32(abef, cdgh, _mm_shuffle_epi32(words, 0x0e));
+            if (group >= 1 && group < 13) {
+                auto& previous = message[(group + 3) % 4];
+                previous = _mm_sha256msg1_epu32(previous, current);
+            }
         }
-        m_data_buffer[m_data_length++] = message[i];
+
+        abef = _mm_add_epi32(abef, abef_saved);
+        cdgh = _mm_add_epi32(cdgh, cdgh_saved);
+    }
+
+    auto feba = _mm_shuffle_epi32(abef, 0x1b);
+    auto dchg = _mm_shuffle_epi32(cdgh, 0xb1);
+    _mm_storeu_si128((__m128i*)&state[0], _mm_blend_epi16(feba, dchg, 0xf0));
+    _mm_storeu_si128((__m128i*)&state[4], _mm_alignr_epi8(dchg, feba, 8));
+}
+#endif
+
+void SHA256::transform_blocks(const u8* data, size_t block_count)
+{
+#if ARCH(I386) || ARCH(X86_64)
+    if (cpu_supports_sha_ni()) {
+        transform_sha_ni(m_state, data, block_count);
+        return;
+    }
+#endif
+    for (; block_count; --block_count, data += BlockSize)
+        transform(data);
+}
+
+void SHA256::update(const u8* message, size_t length)
+{
+    // Top up a partially filled block first; whole blocks after that are hashed straight from the input.
+    if (m_data_length) {
+        auto to_copy = min(length, BlockSize - m_data_length);
+        __builtin_memcpy(m_data_buffer + m_data_length, message, to_copy);
+        m_data_length += to_copy;
+        message += to_copy;
+        length -= to_copy;
+        if (m_data_length < BlockSize)
+            return;
+        transform_blocks(m_data_buffer, 1);
+        m_bit_length += 512;
+        m_data_length = 0;
     }
+
+    auto block_count = length / BlockSize;
+    if (block_count) {
+        transform_blocks(message, block_count);
+        m_bit_length += block_count * 512;
+        message += block_count * BlockSize;
+        length -= block_count * BlockSize;
+    }
+
+    __builtin_memcpy(m_data_buffer, message, length);
+    m_data_length = length;
 }
 
 SHA256::DigestType SHA256::digest()
@@ -120,7 +216,7 @@ SHA256::DigestType SHA256::peek()
         while (i < BlockSize)
             m_data_buffer[i++] = 0x00;
 
-        transform(m_data_buffer);
+        transform_blocks(m_data_buffer, 1);
         __builtin_memset(m_data_buffer, 0, FinalBlockDataSize);
     }
 
@@ -135,7 +231,7 @@ SHA256::DigestType SHA256::peek()
     m_data_buffer[BlockSize - 7] = m_bit_length >> 48;
     m_data_buffer[BlockSize - 8] = m_bit_length >> 56;
 
-    transform(m_data_buffer);
+    transform_blocks(m_data_buffer, 1);
 
     // SHA uses big-endian and we assume little-endian
     // FIXME: looks like a thing for AK::NetworkOrdered,
@@ -196,14 +292,26 @@ inline void SHA512::transform(const u8* data)
 
 void SHA512::update(const u8* message, size_t length)
 {
-    for (size_t i = 0; i < length; ++i) {
-        if (m_data_length == BlockSize) {
-            transform(m_data_buffer);
-            m_bit_length += 1024;
-            m_data_length = 0;
-        }
-        m_data_buffer[m_data_length++] = message[i];
+    if (m_data_length) {
+        auto to_copy = min(length, BlockSize - m_data_length);
+        __builtin_memcpy(m_data_buffer + m_data_length, message, to_copy);
+        m_data_length += to_copy;
+        message += to_copy;
+        length -= to_copy;
+        if (m_data_length < BlockSize)
+            return;
+        transform(m_data_buffer);
+        m_bit_length += 1024;
+        m_data_length = 0;
     }
+
+    for (; length >= BlockSize; length -= BlockSize, message += BlockSize) {
+        transform(message);
+        m_bit_length += 1024;
+    }
+
+    __builtin_memcpy(m_data_buffer, message, length);
+    m_data_length = length;
 }
 
 SHA512::DigestType SHA512::digest()
@@ -232,7 +340,8 @@ SHA512::DigestType SHA512::peek()
         __builtin_memset(m_data_buffer, 0, FinalBlockDataSize);
     }
 
-    // append total message length
+    // append total message length; we only count 64 bits of it
+    __builtin_memset(m_data_buffer + FinalBlockDataSize, 0, 8);
     m_bit_length += m_data_length * 8;
     m_data_buffer[BlockSize - 1] = m_bit_length;
     m_data_buffer[BlockSize - 2] = m_bit_length >> 8;
@@ -136,6 +136,8 @@ public:
 
 private:
     inline void transform(const u8*);
+    // Runs the compression function over whole blocks, with the SHA extensions when the CPU has them.
+    void transform_blocks(const u8*, size_t block_count);
 
     u8 m_data_buffer[BlockSize];
     size_t m_data_length { 0 };
@@ -196,7 +198,8 @@ private:
     u64 m_bit_length { 0 };
     u64 m_state[8];
 
-    constexpr static auto FinalBlockDataSize = BlockSize - 8;
+    // The message length at the end of the last block is 128 bits wide.
+    constexpr static auto FinalBlockDataSize = BlockSize - 16;
     constexpr static auto Rounds = 80;
 };
 
@@ -121,11 +121,114 @@ static auto ModularInverse(const UnsignedBigInteger& a_, const UnsignedBigIntege
     return temp_remainder;
 }
 
+// Sliding-window exponentiation with Montgomery multiplication, so there's no division in the loop.
+// The modulus has to be odd.
+static UnsignedBigInteger MontgomeryModularPower(const UnsignedBigInteger& b, const UnsignedBigInteger& e, const UnsignedBigInteger& m)
+{
+    ASSERT(m.words()[0] % 2 == 1);
+
+    size_t exponent_length = e.trimmed_length();
+    if (exponent_length == 0)
+        return 1;
+
+    UnsignedBigInteger temp_1;
+    UnsignedBigInteger temp_2;
+    UnsignedBigInteger temp_3;
+    UnsignedBigInteger temp_4;
+    UnsignedBigInteger temp_multiply;
+    UnsignedBigInteger temp_quotient;
+    UnsignedBigInteger temp_remainder;
+
+    size_t modulus_length = m.trimmed_length();
+    u32 factor = UnsignedBigInteger::montgomery_factor(m);
+
+    // R^2 mod m takes the one division, and gets numbers into Montgomery form (x * R mod m).
+    UnsignedBigInteger r_squared;
+    UnsignedBigInteger::divide_without_allocation(UnsignedBigInteger { 1 }.shift_left(64 * modulus_length), m, temp_1, temp_2, temp_3, temp_4, temp_quotient, r_squared);
+
+    // Montgomery multiplication can reduce any product less than m * R. A base below R can go straight
+    // in, one below m * R has to be reduced first, and anything bigger needs dividing.
+    UnsignedBigInteger base;
+    if (b.trimmed_length() <= modulus_length) {
+        base.set_to(b);
+    } else if (b < m.shift_left(32 * modulus_length)) {
+        // b * R^-1 * R^2 * R^-1 = b mod m
+        UnsignedBigInteger::montgomery_reduce_without_allocation(b, m, factor, temp_1, temp_2);
+        UnsignedBigInteger::montgomery_multiply_without_allocation(temp_2, r_squared, m, factor, temp_multiply, temp_1, base);
+    } else {
+        UnsignedBigInteger::divide_without_allocation(b, m, temp_1, temp_2, temp_3, temp_4, temp_quotient, base);
+    }
+    UnsignedBigInteger::montgomery_multiply_without_allocation(base, r_squared, m, factor, temp_multiply, temp_1, temp_2);
+    base.set_to(temp_2);
+
+    size_t bit_count = exponent_length * 32 - __builtin_clz(e.words()[exponent_length - 1]);
+    auto bit = [&](size_t index) -> u32 {
+        return (e.words()[index / 32] >> (index % 32)) & 1;
+    };
+
+    // Bigger windows take fewer multiplications in the loop, but more to fill the table of odd powers first.
+    size_t window_size = 1;
+    if (bit_count > 671)
+        window_size = 6;
+    else if (bit_count > 239)
+        window_size = 5;
+    else if (bit_count > 79)
+        window_size = 4;
+    else if (bit_count > 23)
+        window_size = 3;
+
+    // base^1, base^3, base^5, ... base^(2^window_size - 1)
+    Vector<UnsignedBigInteger, 32> odd_powers;
+    odd_powers.append(base);
+    if (window_size > 1) {
+        UnsignedBigInteger base_squared;
+        UnsignedBigInteger::montgomery_multiply_without_allocation(base, base, m, factor, temp_multiply, temp_1, base_squared);
+        for (size_t i = 1; i < (1u << (window_size - 1)); ++i) {
+            UnsignedBigInteger::montgomery_multiply_without_allocation(odd_powers.last(), base_squared, m, factor, temp_multiply, temp_1, temp_2);
+            odd_powers.append(temp_2);
+        }
+    }
+
+    // Start with 1 in Montgomery form, which is R mod m.
+    UnsignedBigInteger result;
+    UnsignedBigInteger::montgomery_reduce_without_allocation(r_squared, m, factor, temp_1, result);
+
+    for (int i = bit_count - 1; i >= 0;) {
+        if (!bit(i)) {
+            UnsignedBigInteger::montgomery_multiply_without_allocation(result, result, m, factor, temp_multiply, temp_1, temp_2);
+            result.set_to(temp_2);
+            --i;
+            continue;
+        }
+
+        // Take the longest run of at most window_size bits that ends in a 1, so its value is odd.
+        int window_end = max(i - static_cast<int>(window_size) + 1, 0);
+        while (!bit(window_end))
+            ++window_end;
+        u32 window_value = 0;
+        for (int j = i; j >= window_end; --j) {
+            window_value = (window_value << 1) | bit(j);
+            UnsignedBigInteger::montgomery_multiply_without_allocation(result, result, m, factor, temp_multiply, temp_1, temp_2);
+            result.set_to(temp_2);
+        }
+        UnsignedBigInteger::montgomery_multiply_without_allocation(result, odd_powers[window_value / 2], m, factor, temp_multiply, temp_1, temp_2);
+        result.set_to(temp_2);
+        i = window_end - 1;
+    }
+
+    // Out of Montgomery form.
+    UnsignedBigInteger::montgomery_reduce_without_allocation(result, m, factor, temp_1, temp_2);
+    return temp_2;
+}
+
 static auto ModularPower(const UnsignedBigInteger& b, const UnsignedBigInteger& e, const UnsignedBigInteger& m) -> UnsignedBigInteger
 {
     if (m == 1)
         return 0;
 
+    if (m.words()[0] % 2 == 1)
+        return MontgomeryModularPower(b, e, m);
+
     UnsignedBigInteger ep { e };
     UnsignedBigInteger base { b };
     UnsignedBigInteger exp { 1 };
@@ -144,7 +247,7 @@ static auto ModularPower(const UnsignedBigInteger& b, const UnsignedBigInteger&
 #endif
         if (ep.words()[0] % 2 == 1) {
             // exp = (exp * base) % m;
-            UnsignedBigInteger::multiply_without_allocation(exp, base, temp_1, temp_2, temp_3, temp_4, temp_multiply);
+            UnsignedBigInteger::multiply_without_allocation(exp, base, temp_1, temp_multiply);
             UnsignedBigInteger::divide_without_allocation(temp_multiply, m, temp_1, temp_2, temp_3, temp_4, temp_quotient, temp_remainder);
             exp.set_to(temp_remainder);
         }
@@ -154,7 +257,7 @@ static auto ModularPower(const UnsignedBigInteger& b, const UnsignedBigInteger&
         ep.set_to(temp_quotient);
 
         // base = (base * base) % m;
-        UnsignedBigInteger::multiply_without_allocation(base, base, temp_1, temp_2, temp_3, temp_4, temp_multiply);
+        UnsignedBigInteger::multiply_without_allocation(base, base, temp_1, temp_multiply);
         UnsignedBigInteger::divide_without_allocation(temp_multiply, m, temp_1, temp_2, temp_3, temp_4, temp_quotient, temp_remainder);
         base.set_to(temp_remainder);
     }
@@ -236,7 +339,7 @@ static auto LCM(const UnsignedBigInteger& a, const UnsignedBigInteger& b) -> Uns
 
     // output = (a / gcd_output) * b
     UnsignedBigInteger::divide_without_allocation(a, gcd_output, temp_1, temp_2, temp_3, temp_4, temp_quotient, temp_remainder);
-    UnsignedBigInteger::multiply_without_allocation(temp_quotient, b, temp_1, temp_2, temp_3, temp_4, output);
+    UnsignedBigInteger::multiply_without_allocation(temp_quotient, b, temp_1, output);
 
 #ifdef NT_DEBUG
     dbg() << "quot: " << temp_quotient << " rem: " << temp_remainder << " out: " << output;
@@ -252,9 +355,11 @@ static bool MR_primality_test(UnsignedBigInteger n, const Vector<UnsignedBigInte
     auto b = prev;
     auto r = 0;
 
-    auto div_result = b.divided_by(2);
-    while (div_result.quotient == 0) {
-        div_result = b.divided_by(2);
+    // n - 1 = 2^r * b, with b odd.
+    for (;;) {
+        auto div_result = b.divided_by(2);
+        if (!(div_result.remainder == 0))
+            break;
         b = div_result.quotient;
         ++r;
     }
@@ -293,22 +398,38 @@ static UnsignedBigInteger random_number(const UnsignedBigInteger& min, const Uns
     AK::fill_with_random(buf, size);
     Vector<u32> vec;
     for (size_t i = 0; i < size / sizeof(u32); ++i) {
-        vec.append(*(u32*)buf + i);
+        vec.append(*((u32*)buf + i));
     }
     UnsignedBigInteger offset { move(vec) };
-    return offset.plus(min);
+    return offset.divided_by(range).remainder.plus(min);
+}
+
+static u32 remainder_of_division_by_small_number(const UnsignedBigInteger& n, u32 divisor)
+{
+    u64 remainder = 0;
+    for (size_t i = n.length(); i > 0; --i)
+        remainder = ((remainder << 32) | n.words()[i - 1]) % divisor;
+    return remainder;
 }
 
 static bool is_probably_prime(const UnsignedBigInteger& p)
 {
-    if (p == 2 || p == 3 || p == 5)
-        return true;
-    if (p < 49)
-        return true;
+    // Weeds out most candidates before the expensive test, and settles it outright for small numbers.
+    static constexpr u32 small_primes[] = { 2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37, 41, 43, 47, 53, 59, 61, 67, 71, 73, 79, 83, 89, 97 };
+    for (auto small_prime : small_primes) {
+        if (p == small_prime)
+            return true;
+        if (remainder_of_division_by_small_number(p, small_prime) == 0)
+            return false;
+    }
+    // Anything composite left over has two factors above 97.
+    if (p < 101 * 101)
+        return UnsignedBigInteger { 1 } < p;
 
-    Vector<UnsignedBigInteger, 256> tests;
+    constexpr size_t test_count = 256;
+    Vector<UnsignedBigInteger, test_count> tests;
     UnsignedBigInteger seven { 7 };
-    for (size_t i = 0; i < tests.size(); ++i)
+    for (size_t i = 0; i < test_count; ++i)
         tests.append(random_number(seven, p.minus(2)));
 
     return MR_primality_test(p, tests);
@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2020, Ali Mohammad Pur <ali.mpfard@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/StdLibExtras.h>
+#include <LibCrypto/Hash/SHA1.h>
+#include <LibCrypto/Hash/SHA2.h>
+#include <LibCrypto/PK/Code/Code.h>
+
+namespace Crypto {
+namespace PK {
+
+// The deterministic signature encoding from RFC 8017 section 9.2, which is what TLS 1.2 uses for RSA
+// signatures: 00 01 FF .. FF 00, then the DER DigestInfo of the message hash.
+template<typename HashFunction>
+class EMSA_PKCS1_V1_5 : public Code<HashFunction> {
+public:
+    template<typename... Args>
+    EMSA_PKCS1_V1_5(Args... args)
+        : Code<HashFunction>(args...)
+    {
+    }
+
+    virtual void encode(const ByteBuffer& in, ByteBuffer& out, size_t em_bits) override
+    {
+        auto& hash_fn = this->hasher();
+        hash_fn.update(in);
+        auto message_hash = hash_fn.digest();
+        auto prefix = digest_info_prefix();
+
+        auto em_length = (em_bits + 7) / 8;
+        auto t_length = prefix.length() + HashFunction::DigestSize;
+        // At least eight bytes of padding are required.
+        if (em_length < t_length + 11) {
+            dbg() << "intended encoded message length too short";
+            out.clear();
+            return;
+        }
+
+        auto padding_length = em_length - t_length - 3;
+        out[0] = 0x00;
+        out[1] = 0x01;
+        for (size_t i = 0; i < padding_length; ++i)
+            out[2 + i] = 0xff;
+        out[2 + padding_length] = 0x00;
+        out.overwrite(3 + padding_length, prefix.characters_without_null_termination(), prefix.length());
+        out.overwrite(3 + padding_length + prefix.length(), message_hash.data, HashFunction::DigestSize);
+    }
+
+    // `emsg` may be missing its leading zero bytes, as happens when it comes out of a big integer.
+    virtual VerificationConsistency verify(const ByteBuffer& msg, const ByteBuffer& emsg, size_t em_bits) override
+    {
+        auto em_length = (em_bits + 7) / 8;
+        if (emsg.size() > em_length)
+            return VerificationConsistency::Inconsistent;
+
+        auto expected = ByteBuffer::create_zeroed(em_length);
+        encode(msg, expected, em_bits);
+        if (expected.is_empty())
+            return VerificationConsistency::Inconsistent;
+
+        auto skipped = em_length - emsg.size();
+        for (size_t i = 0; i < skipped; ++i) {
+            if (expected[i] != 0)
+                return VerificationConsistency::Inconsistent;
+        }
+        if (__builtin_memcmp(expected.data() + skipped, emsg.data(), emsg.size()))
+            return VerificationConsistency::Inconsistent;
+
+        return VerificationConsistency::Consistent;
+    }
+
+private:
+    static StringView digest_info_prefix()
+    {
+        if constexpr (IsSame<HashFunction, Hash::SHA1>::value)
+            return { "\x30\x21\x30\x09\x06\x05\x2b\x0e\x03\x02\x1a\x05\x00\x04\x14", 15 };
+        if constexpr (IsSame<HashFunction, Hash::SHA256>::value)
+            return { "\x30\x31\x30\x0d\x06\x09\x60\x86\x48\x01\x65\x03\x04\x02\x01\x05\x00\x04\x20", 19 };
+        if constexpr (IsSame<HashFunction, Hash::SHA512>::value)
+            return { "\x30\x51\x30\x0d\x06\x09\x60\x86\x48\x01\x65\x03\x04\x02\x03\x05\x00\x04\x40", 19 };
+        ASSERT_NOT_REACHED();
+    }
+};
+
+}
+}
@@ -92,6 +92,21 @@ RSA::KeyPairType RSA::parse_rsa_key(const ByteBuffer& in)
     if (n == 0) {
         // it is a private key
         UnsignedBigInteger zero;
+        UnsignedBigInteger p, q, dp, dq, qinv;
+        if (der_decode_sequence_many<9>(in.data(), in.size(),
+                ASN1::Kind::Integer, 1, &zero,
+                ASN1::Kind::Integer, 1, &n,
+                ASN1::Kind::Integer, 1, &e,
+                ASN1::Kind::Integer, 1, &d,
+                ASN1::Kind::Integer, 1, &p,
+                ASN1::Kind::Integer, 1, &q,
+                ASN1::Kind::Integer, 1, &dp,
+                ASN1::Kind::Integer, 1, &dq,
+                ASN1::Kind::Integer, 1, &qinv)) {
+            keypair.private_key.set(n, d, e);
+            keypair.private_key.set_crt_parameters(p, q, dp, dq, qinv);
+            return keypair;
+        }
         if (!der_decode_sequence_many<4>(in.data(), in.size(),
                 ASN1::Kind::Integer, 1, &zero,
                 ASN1::Kind::Integer, 1, &n,
@@ -131,12 +146,28 @@ void RSA::encrypt(const ByteBuffer& in, ByteBuffer& out)
         out = out.slice(out.size() - size, size);
 }
 
-void RSA::decrypt(const ByteBuffer& in, ByteBuffer& out)
+UnsignedBigInteger RSA::private_key_operation(const UnsignedBigInteger& in) const
 {
-    // FIXME: Actually use the private key properly
+    if (!m_private_key.has_crt_parameters())
+        return NumberTheory::ModularPower(in, m_private_key.private_exponent(), m_private_key.modulus());
+
+    // Two exponentiations with half-size numbers and exponents are about four times cheaper than one
+    // with the full modulus. With m1 = in^dp mod p and m2 = in^dq mod q, the result is m2 + h * q,
+    // where h = qinv * (m1 - m2) mod p.
+    auto& p = m_private_key.prime_1();
+    auto& q = m_private_key.prime_2();
+    auto m1 = NumberTheory::ModularPower(in, m_private_key.exponent_1(), p);
+    auto m2 = NumberTheory::ModularPower(in, m_private_key.exponent_2(), q);
+    auto m2_mod_p = m2 < p ? m2 : m2.divided_by(p).remainder;
+    auto difference = m1 < m2_mod_p ? m1.plus(p).minus(m2_mod_p) : m1.minus(m2_mod_p);
+    auto h = m_private_key.coefficient().multiplied_by(difference).divided_by(p).remainder;
+    return m2.plus(h.multiplied_by(q));
+}
 
+void RSA::decrypt(const ByteBuffer& in, ByteBuffer& out)
+{
     auto in_integer = UnsignedBigInteger::import_data(in.data(), in.size());
-    auto exp = NumberTheory::ModularPower(in_integer, m_private_key.private_exponent(), m_private_key.modulus());
+    auto exp = private_key_operation(in_integer);
     auto size = exp.export_data(out);
 
     auto align = m_private_key.length();
@@ -150,7 +181,7 @@ void RSA::decrypt(const ByteBuffer& in, ByteBuffer& out)
 void RSA::sign(const ByteBuffer& in, ByteBuffer& out)
 {
     auto in_integer = UnsignedBigInteger::import_data(in.data(), in.size());
-    auto exp = NumberTheory::ModularPower(in_integer, m_private_key.private_exponent(), m_private_key.modulus());
+    auto exp = private_key_operation(in_integer);
     auto size = exp.export_data(out);
     out = out.slice(out.size() - size, size);
 }
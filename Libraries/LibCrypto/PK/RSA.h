@@ -98,10 +98,35 @@ public:
         m_length = (n.length() * sizeof(u32));
     }
 
+    // The factors of the modulus, and what PKCS #1 derives from them, so private key operations can be
+    // done modulo each prime and recombined (with the Chinese remainder theorem) instead of modulo n.
+    void set_crt_parameters(const Integer& p, const Integer& q, const Integer& dp, const Integer& dq, const Integer& qinv)
+    {
+        m_prime_1 = p;
+        m_prime_2 = q;
+        m_exponent_1 = dp;
+        m_exponent_2 = dq;
+        m_coefficient = qinv;
+        m_has_crt_parameters = true;
+    }
+
+    bool has_crt_parameters() const { return m_has_crt_parameters; }
+    const Integer& prime_1() const { return m_prime_1; }
+    const Integer& prime_2() const { return m_prime_2; }
+    const Integer& exponent_1() const { return m_exponent_1; }
+    const Integer& exponent_2() const { return m_exponent_2; }
+    const Integer& coefficient() const { return m_coefficient; }
+
 private:
     Integer m_modulus;
     Integer m_private_exponent;
     Integer m_public_exponent;
+    Integer m_prime_1;
+    Integer m_prime_2;
+    Integer m_exponent_1;
+    Integer m_exponent_2;
+    Integer m_coefficient;
+    bool m_has_crt_parameters { false };
     size_t m_length { 0 };
 };
 
@@ -141,6 +166,10 @@ public:
             { n, e },
             { n, d, e }
         };
+        keys.private_key.set_crt_parameters(p, q,
+            d.divided_by(p.minus(1)).remainder,
+            d.divided_by(q.minus(1)).remainder,
+            NumberTheory::ModularInverse(q, p));
         keys.public_key.set_length(bits / 2 / 8);
         keys.private_key.set_length(bits / 2 / 8);
         return keys;
@@ -192,6 +221,9 @@ public:
 
     const PrivateKeyType& private_key() const { return m_private_key; }
     const PublicKeyType& public_key() const { return m_public_key; }
+
+private:
+    IntegerType private_key_operation(const IntegerType&) const;
 };
 
 template<typename HashFunction>
@@ -25,6 +25,7 @@
  */
 
 #include "DebugInfo.h"
+#include <AK/BinarySearch.h>
 #include <AK/QuickSort.h>
 #include <LibDebug/Dwarf/CompilationUnit.h>
 #include <LibDebug/Dwarf/DwarfInfo.h>
@@ -34,19 +35,30 @@ DebugInfo::DebugInfo(NonnullRefPtr<const ELF::Loader> elf)
     : m_elf(elf)
     , m_dwarf_info(Dwarf::DwarfInfo::create(m_elf))
 {
-    prepare_variable_scopes();
     prepare_lines();
 }
 
-void DebugInfo::prepare_variable_scopes()
+void DebugInfo::prepare_variable_scopes() const
 {
+    if (m_has_prepared_variable_scopes)
+        return;
+    m_has_prepared_variable_scopes = true;
+
     m_dwarf_info->for_each_compilation_unit([&](const Dwarf::CompilationUnit& unit) {
         auto root = unit.root_die();
         parse_scopes_impl(root);
     });
+
+    for (size_t i = 0; i < m_scopes.size(); ++i) {
+        if (m_scopes[i].is_function)
+            m_sorted_function_scopes.append(i);
+    }
+    quick_sort(m_sorted_function_scopes, [this](auto a, auto b) {
+        return m_scopes[a].address_low < m_scopes[b].address_low;
+    });
 }
 
-void DebugInfo::parse_scopes_impl(const Dwarf::DIE& die)
+void DebugInfo::parse_scopes_impl(const Dwarf::DIE& die) const
 {
     die.for_each_child([&](const Dwarf::DIE& child) {
         if (child.is_null())
@@ -117,37 +129,44 @@ void DebugInfo::prepare_lines()
     quick_sort(m_sorted_lines, [](auto& a, auto& b) {
         return a.address < b.address;
     });
+
+    for (auto& line_info : m_sorted_lines) {
+        auto it = m_first_addresses_of_lines.find(line_info.file);
+        if (it == m_first_addresses_of_lines.end()) {
+            m_first_addresses_of_lines.set(line_info.file, {});
+            it = m_first_addresses_of_lines.find(line_info.file);
+        }
+        // The lines are sorted by address, so the first address we see for a line is its lowest.
+        if (!it->value.contains(line_info.line))
+            it->value.set(line_info.line, line_info.address);
+    }
 }
 
 Optional<DebugInfo::SourcePosition> DebugInfo::get_source_position(u32 target_address) const
 {
-    if (m_sorted_lines.is_empty())
-        return {};
-    if (target_address < m_sorted_lines[0].address)
+    size_t index = upper_bound(m_sorted_lines.data(), m_sorted_lines.size(), target_address, [](u32 address, auto& line_info) {
+        return address < line_info.address;
+    });
+    // Past the last entry (which ends the sequence), the address isn't covered by any line.
+    if (index == 0 || index == m_sorted_lines.size())
         return {};
-
-    // TODO: We can do a binray search here
-    for (size_t i = 0; i < m_sorted_lines.size() - 1; ++i) {
-        if (m_sorted_lines[i + 1].address > target_address) {
-            return Optional<SourcePosition>({ m_sorted_lines[i].file, m_sorted_lines[i].line, m_sorted_lines[i].address });
-        }
-    }
-    return {};
+    auto& line_info = m_sorted_lines[index - 1];
+    return Optional<SourcePosition>({ line_info.file, line_info.line, line_info.address });
 }
 
 Optional<u32> DebugInfo::get_instruction_from_source(const String& file, size_t line) const
 {
-    for (const auto& line_entry : m_sorted_lines) {
-        if (line_entry.file == file && line_entry.line == line)
-            return Optional<u32>(line_entry.address);
-    }
-    return {};
+    auto file_it = m_first_addresses_of_lines.find(file);
+    if (file_it == m_first_addresses_of_lines.end())
+        return {};
+    return file_it->value.get(line);
 }
 
 NonnullOwnPtrVector<DebugInfo::VariableInfo> DebugInfo::get_variables_in_current_scope(const PtraceRegisters& regs) const
 {
     NonnullOwnPtrVector<DebugInfo::VariableInfo> variables;
 
+    prepare_variable_scopes();
     // TODO: We can store the scopes in a better data strucutre
     for (const auto& scope : m_scopes) {
         if (regs.eip < scope.address_low || regs.eip >= scope.address_high)
@@ -234,10 +253,15 @@ OwnPtr<DebugInfo::VariableInfo> DebugInfo::create_variable_info(const Dwarf::DIE
 
 String DebugInfo::name_of_containing_function(u32 address) const
 {
-    for (const auto& scope : m_scopes) {
-        if (!scope.is_function || address < scope.address_low || address >= scope.address_high)
-            continue;
-        return scope.name;
-    }
-    return {};
+    prepare_variable_scopes();
+    size_t index = upper_bound(m_sorted_function_scopes.data(), m_sorted_function_scopes.size(), address, [this](u32 address, size_t scope_index) {
+        return address < m_scopes[scope_index].address_low;
+    });
+    // Functions don't overlap, so only the last one starting at or before the address can contain it.
+    if (index == 0)
+        return {};
+    auto& scope = m_scopes[m_sorted_function_scopes[index - 1]];
+    if (address >= scope.address_high)
+        return {};
+    return scope.name;
 }
@@ -26,6 +26,7 @@
 
 #pragma once
 
+#include <AK/HashMap.h>
 #include <AK/NonnullOwnPtrVector.h>
 #include <AK/NonnullRefPtr.h>
 #include <AK/Optional.h>
@@ -96,14 +97,22 @@ public:
     String name_of_containing_function(u32 address) const;
 
 private:
-    void prepare_variable_scopes();
+    // The scopes come from walking every compilation unit's DIEs, which only the variable and function lookups need.
+    // So that attaching to a program doesn't have to wait for that, it happens when one of them is first used.
+    void prepare_variable_scopes() const;
     void prepare_lines();
-    void parse_scopes_impl(const Dwarf::DIE& die);
+    void parse_scopes_impl(const Dwarf::DIE& die) const;
     OwnPtr<VariableInfo> create_variable_info(const Dwarf::DIE& variable_die, const PtraceRegisters&) const;
 
     NonnullRefPtr<const ELF::Loader> m_elf;
     NonnullRefPtr<Dwarf::DwarfInfo> m_dwarf_info;
 
-    Vector<VariablesScope> m_scopes;
+    mutable Vector<VariablesScope> m_scopes;
+    // Indices into m_scopes of the function scopes, sorted by their start address.
+    mutable Vector<size_t> m_sorted_function_scopes;
+    mutable bool m_has_prepared_variable_scopes { false };
+
     Vector<LineProgram::LineInfo> m_sorted_lines;
+    // For each file, the address of the first statement of each line in it.
+    HashMap<String, HashMap<size_t, u32>> m_first_addresses_of_lines;
 };
@@ -30,6 +30,7 @@
 
 #include <assert.h>
 #include <dlfcn.h>
+#include <limits.h>
 #include <mman.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -122,11 +123,23 @@ bool DynamicLoader::load_from_image(unsigned flags)
     return load_stage_2(flags);
 }
 
+static bool should_print_statistics()
+{
+    const char* ld_debug = getenv("LD_DEBUG");
+    return ld_debug && strstr(ld_debug, "statistics");
+}
+
 bool DynamicLoader::load_stage_2(unsigned flags)
 {
     ASSERT(flags & RTLD_GLOBAL);
     ASSERT(flags & RTLD_LAZY);
 
+    timespec start_time;
+    clock_gettime(CLOCK_MONOTONIC, &start_time);
+
+    if (getenv("LD_BIND_NOW"))
+        s_always_bind_now = true;
+
 #ifdef DYNAMIC_LOAD_DEBUG
     m_dynamic_object->dump();
 #endif
@@ -156,9 +169,24 @@ bool DynamicLoader::load_stage_2(unsigned flags)
 #ifdef DYNAMIC_LOAD_DEBUG
     dbgprintf("Loaded %s\n", m_filename.characters());
 #endif
+    if (should_print_statistics())
+        print_statistics(start_time);
     return true;
 }
 
+void DynamicLoader::print_statistics(const timespec& start_time) const
+{
+    timespec end_time;
+    clock_gettime(CLOCK_MONOTONIC, &end_time);
+    i64 elapsed_us = (i64)(end_time.tv_sec - start_time.tv_sec) * 1000000 + (end_time.tv_nsec - start_time.tv_nsec) / 1000;
+
+    fprintf(stderr, "%s: %u symbols (%s hash table)\n", m_filename.characters(), m_dynamic_object->symbol_count(),
+        m_dynamic_object->hash_section().hash_type() == DynamicObject::HashType::GNU ? "GNU" : "SYSV");
+    fprintf(stderr, "%s: %zu relocations, %zu of them against symbols\n", m_filename.characters(), m_statistics.relocation_count, m_statistics.symbol_relocation_count);
+    fprintf(stderr, "%s: %zu PLT slots bound now, %zu left to bind lazily\n", m_filename.characters(), m_statistics.plt_slots_bound_now, m_statistics.plt_slots_bound_lazily);
+    fprintf(stderr, "%s: relocated and initialized in %lld us\n", m_filename.characters(), elapsed_us);
+}
+
 void DynamicLoader::load_program_headers(const Image& elf_image)
 {
     Vector<ProgramHeaderRegion> program_headers;
@@ -199,12 +227,14 @@ void DynamicLoader::load_program_headers(const Image& elf_image)
     m_dynamic_section_address = dynamic_region_desired_vaddr.offset(m_text_segment_load_address.get());
 
     region = data_region_ptr;
-    void* data_segment_begin = mmap_with_name((u8*)text_segment_begin + m_text_segment_size, region->required_load_size(), region->mmap_prot(), MAP_ANONYMOUS | MAP_PRIVATE, 0, 0, String::format(".data: %s", m_filename.characters()).characters());
-    if (MAP_FAILED == data_segment_begin) {
-        ASSERT_NOT_REACHED();
-    }
     VirtualAddress data_segment_actual_addr = region->desired_load_address().offset((u32)text_segment_begin);
-    memcpy(data_segment_actual_addr.as_ptr(), (u8*)m_file_mapping + region->offset(), region->size_in_image());
+    if (!map_data_segment_from_image(*region, (u8*)text_segment_begin + m_text_segment_size, data_segment_actual_addr)) {
+        void* data_segment_begin = mmap_with_name((u8*)text_segment_begin + m_text_segment_size, region->required_load_size(), region->mmap_prot(), MAP_ANONYMOUS | MAP_PRIVATE, 0, 0, String::format(".data: %s", m_filename.characters()).characters());
+        if (MAP_FAILED == data_segment_begin) {
+            ASSERT_NOT_REACHED();
+        }
+        memcpy(data_segment_actual_addr.as_ptr(), (u8*)m_file_mapping + region->offset(), region->size_in_image());
+    }
 
     // FIXME: Do some kind of 'allocate TLS section' or some such from a per-application pool
     if (tls_region_ptr) {
@@ -216,6 +246,45 @@ void DynamicLoader::load_program_headers(const Image& elf_image)
     }
 }
 
+bool DynamicLoader::map_data_segment_from_image(ProgramHeaderRegion& region, u8* segment_begin, VirtualAddress actual_address)
+{
+    // Map the initialized part of .data privately from the image, so the kernel only has to copy the pages
+    // we actually relocate or write to. The rest stay shared with every other process that loaded this object.
+    if (!region.is_writable() || actual_address.as_ptr() < segment_begin)
+        return false;
+    size_t offset_in_segment = actual_address.as_ptr() - segment_begin;
+    if (offset_in_segment > region.offset() || (region.offset() - offset_in_segment) % PAGE_SIZE)
+        return false;
+    size_t offset_in_image = region.offset() - offset_in_segment;
+    size_t file_backed_size = ALIGN_ROUND_UP(offset_in_segment + region.size_in_image(), PAGE_SIZE);
+    size_t segment_size = max((size_t)region.required_load_size(), ALIGN_ROUND_UP(offset_in_segment + region.size_in_memory(), PAGE_SIZE));
+    if (!region.size_in_image() || offset_in_image + file_backed_size > ALIGN_ROUND_UP(m_file_size, PAGE_SIZE))
+        return false;
+
+    auto* data = mmap_with_name(segment_begin, file_backed_size, region.mmap_prot(), MAP_PRIVATE, m_image_fd, offset_in_image, String::format(".data: %s", m_filename.characters()).characters());
+    if (data == MAP_FAILED)
+        return false;
+    if (data != segment_begin) {
+        munmap(data, file_backed_size);
+        return false;
+    }
+
+    if (segment_size > file_backed_size) {
+        auto* bss = mmap_with_name(segment_begin + file_backed_size, segment_size - file_backed_size, region.mmap_prot(), MAP_ANONYMOUS | MAP_PRIVATE, 0, 0, String::format(".bss: %s", m_filename.characters()).characters());
+        if (bss != segment_begin + file_backed_size) {
+            if (bss != MAP_FAILED)
+                munmap(bss, segment_size - file_backed_size);
+            munmap(data, file_backed_size);
+            return false;
+        }
+    }
+
+    // Whatever follows .data in the image's last page belongs to .bss, which has to start out zeroed.
+    size_t end_of_data_in_segment = offset_in_segment + region.size_in_image();
+    memset(segment_begin + end_of_data_in_segment, 0, file_backed_size - end_of_data_in_segment);
+    return true;
+}
+
 void DynamicLoader::do_relocations()
 {
     u32 load_base_address = m_dynamic_object->base_address().get();
@@ -227,6 +296,9 @@ void DynamicLoader::do_relocations()
     main_relocation_section.for_each_relocation([&](const DynamicObject::Relocation& relocation) {
         VERBOSE("====== RELOCATION %d: offset 0x%08X, type %d, symidx %08X\n", relocation.offset_in_section() / main_relocation_section.entry_size(), relocation.offset(), relocation.type(), relocation.symbol_index());
         u32* patch_ptr = (u32*)(load_base_address + relocation.offset());
+        ++m_statistics.relocation_count;
+        if (relocation.symbol_index())
+            ++m_statistics.symbol_relocation_count;
         switch (relocation.type()) {
         case R_386_NONE:
             // Apparently most loaders will just skip these?
@@ -290,6 +362,7 @@ void DynamicLoader::do_relocations()
             // Eagerly BIND_NOW the PLT entries, doing all the symbol looking goodness
             // The patch method returns the address for the LAZY fixup path, but we don't need it here
             (void)patch_plt_entry(relocation.offset_in_section());
+            ++m_statistics.plt_slots_bound_now;
         } else {
             // LAZY-ily bind the PLT slots by just adding the base address to the offsets stored there
             // This avoids doing symbol lookup, which might be expensive
@@ -298,6 +371,7 @@ void DynamicLoader::do_relocations()
             u8* relocation_address = relocation.address().as_ptr();
 
             *(u32*)relocation_address += load_base_address;
+            ++m_statistics.plt_slots_bound_lazily;
         }
         return IterationDecision::Continue;
     });
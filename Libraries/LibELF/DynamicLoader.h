@@ -34,6 +34,7 @@
 #include <LibELF/Image.h>
 #include <LibELF/exec_elf.h>
 #include <sys/mman.h>
+#include <time.h>
 
 namespace ELF {
 
@@ -99,12 +100,22 @@ private:
 
     // Stage 1
     void load_program_headers(const Image& elf_image);
+    bool map_data_segment_from_image(ProgramHeaderRegion&, u8* segment_begin, VirtualAddress actual_address);
 
     // Stage 2
     void do_relocations();
     void setup_plt_trampoline();
     void call_object_init_functions();
 
+    // What LD_DEBUG=statistics reports after loading.
+    struct Statistics {
+        size_t relocation_count { 0 };
+        size_t symbol_relocation_count { 0 };
+        size_t plt_slots_bound_now { 0 };
+        size_t plt_slots_bound_lazily { 0 };
+    };
+    void print_statistics(const timespec& start_time) const;
+
     String m_filename;
     String m_program_interpreter;
     size_t m_file_size { 0 };
@@ -119,6 +130,8 @@ private:
 
     VirtualAddress m_tls_segment_address;
     VirtualAddress m_dynamic_section_address;
+
+    Statistics m_statistics;
 };
 
 } // end namespace ELF
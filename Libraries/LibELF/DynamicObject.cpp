@@ -91,6 +91,9 @@ void DynamicObject::parse()
         case DT_HASH:
             m_hash_table_offset = entry.ptr();
             break;
+        case DT_GNU_HASH:
+            m_gnu_hash_table_offset = entry.ptr();
+            break;
         case DT_SYMTAB:
             m_symbol_table_offset = entry.ptr();
             break;
@@ -151,9 +154,7 @@ void DynamicObject::parse()
         return IterationDecision::Continue;
     });
 
-    auto hash_section_address = hash_section().address().as_ptr();
-    auto num_hash_chains = ((u32*)hash_section_address)[1];
-    m_symbol_count = num_hash_chains;
+    m_symbol_count = hash_section().symbol_count();
 }
 
 const DynamicObject::Relocation DynamicObject::RelocationSection::relocation(unsigned index) const
@@ -200,6 +201,8 @@ const DynamicObject::Section DynamicObject::fini_array_section() const
 
 const DynamicObject::HashSection DynamicObject::hash_section() const
 {
+    if (m_gnu_hash_table_offset)
+        return HashSection(Section(*this, m_gnu_hash_table_offset, 0, 0, "DT_GNU_HASH"), HashType::GNU);
     return HashSection(Section(*this, m_hash_table_offset, 0, 0, "DT_HASH"), HashType::SYSV);
 }
 
@@ -235,17 +238,94 @@ u32 DynamicObject::HashSection::calculate_elf_hash(const char* name) const
     return hash;
 }
 
-u32 DynamicObject::HashSection::calculate_gnu_hash(const char*) const
+u32 DynamicObject::HashSection::calculate_gnu_hash(const char* name) const
 {
-    // FIXME: Implement the GNU hash algorithm
-    ASSERT_NOT_REACHED();
+    // GNU ELF hash algorithm (Bernstein's djb2)
+    u32 hash = 5381;
+    for (; *name != '\0'; ++name)
+        hash = hash * 33 + (u8)*name;
+    return hash;
 }
 
+// The GNU hash table starts with this header, followed by the bloom filter words, the buckets, and the chains.
+// Only the symbols from symbol_offset on are in the table, sorted by bucket; each chain entry holds the hash
+// of its symbol, with the lowest bit set on the last symbol of a bucket.
+struct GnuHashTableHeader {
+    u32 bucket_count;
+    u32 symbol_offset;
+    u32 bloom_size;
+    u32 bloom_shift;
+};
+
 const DynamicObject::Symbol DynamicObject::HashSection::lookup_symbol(const char* name) const
 {
-    // FIXME: If we enable gnu hash in the compiler, we should use that here instead
-    //     The algo is way better with less collisions
-    u32 hash_value = (this->*(m_hash_function))(name);
+    if (m_hash_type == HashType::GNU)
+        return lookup_gnu_symbol(name);
+    return lookup_elf_symbol(name);
+}
+
+unsigned DynamicObject::HashSection::symbol_count() const
+{
+    if (m_hash_type == HashType::SYSV) {
+        // The SYSV table has one chain per symbol.
+        return ((const u32*)address().as_ptr())[1];
+    }
+
+    auto& header = *(const GnuHashTableHeader*)address().as_ptr();
+    auto* buckets = (const u32*)(&header + 1) + header.bloom_size;
+    auto* chains = buckets + header.bucket_count;
+
+    // The symbols in the last non-empty bucket end the table.
+    u32 last_symbol = 0;
+    for (u32 i = 0; i < header.bucket_count; ++i)
+        last_symbol = max(last_symbol, buckets[i]);
+    if (last_symbol < header.symbol_offset)
+        return header.symbol_offset;
+    while (!(chains[last_symbol - header.symbol_offset] & 1))
+        ++last_symbol;
+    return last_symbol + 1;
+}
+
+const DynamicObject::Symbol DynamicObject::HashSection::lookup_gnu_symbol(const char* name) const
+{
+    auto& header = *(const GnuHashTableHeader*)address().as_ptr();
+    auto* bloom = (const u32*)(&header + 1);
+    auto* buckets = bloom + header.bloom_size;
+    auto* chains = buckets + header.bucket_count;
+
+    u32 hash_value = calculate_gnu_hash(name);
+
+    // Each symbol sets two bits in one bloom filter word; if either is clear, the symbol isn't here.
+    constexpr u32 bits_per_word = sizeof(u32) * 8;
+    u32 bloom_word = bloom[(hash_value / bits_per_word) % header.bloom_size];
+    u32 bloom_mask = (1u << (hash_value % bits_per_word)) | (1u << ((hash_value >> header.bloom_shift) % bits_per_word));
+    if ((bloom_word & bloom_mask) != bloom_mask)
+        return m_dynamic.the_undefined_symbol();
+
+    u32 i = buckets[hash_value % header.bucket_count];
+    if (i < header.symbol_offset)
+        return m_dynamic.the_undefined_symbol();
+
+    for (;; ++i) {
+        u32 chain_hash = chains[i - header.symbol_offset];
+        if ((hash_value | 1) == (chain_hash | 1)) {
+            auto symbol = m_dynamic.symbol(i);
+            if (strcmp(name, symbol.name()) == 0) {
+#ifdef DYNAMIC_LOAD_DEBUG
+                dbgprintf("Returning GNU dynamic symbol with index %d for %s: %p\n", i, symbol.name(), symbol.address());
+#endif
+                return symbol;
+            }
+        }
+        if (chain_hash & 1)
+            break;
+    }
+    return m_dynamic.the_undefined_symbol();
+}
+
+const DynamicObject::Symbol DynamicObject::HashSection::lookup_elf_symbol(const char* name) const
+{
+    u32 hash_value = calculate_elf_hash(name);
 
     u32* hash_table_begin = (u32*)address().as_ptr();
 
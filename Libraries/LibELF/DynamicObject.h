@@ -80,7 +80,8 @@ public:
         unsigned index() const { return m_index; }
         unsigned type() const { return ELF32_ST_TYPE(m_sym.st_info); }
         unsigned bind() const { return ELF32_ST_BIND(m_sym.st_info); }
-        bool is_undefined() const { return this == &m_dynamic.the_undefined_symbol(); }
+        // Lookups hand out copies, so we can't compare addresses with the_undefined_symbol(); it's always symbol 0, though.
+        bool is_undefined() const { return m_index == 0; }
         VirtualAddress address() const { return m_dynamic.base_address().offset(value()); }
 
     private:
@@ -164,28 +165,25 @@ public:
     public:
         HashSection(const Section& section, HashType hash_type = HashType::SYSV)
             : Section(section.m_dynamic, section.m_section_offset, section.m_section_size_bytes, section.m_entry_size, section.m_name)
+            , m_hash_type(hash_type)
         {
-            switch (hash_type) {
-            case HashType::SYSV:
-                m_hash_function = &HashSection::calculate_elf_hash;
-                break;
-            case HashType::GNU:
-                m_hash_function = &HashSection::calculate_gnu_hash;
-                break;
-            default:
-                ASSERT_NOT_REACHED();
-                break;
-            }
         }
 
+        HashType hash_type() const { return m_hash_type; }
+
         const Symbol lookup_symbol(const char*) const;
 
+        // The number of entries in the dynamic symbol table, which neither table type stores outright.
+        unsigned symbol_count() const;
+
     private:
         u32 calculate_elf_hash(const char* name) const;
         u32 calculate_gnu_hash(const char* name) const;
 
-        typedef u32 (HashSection::*HashFunction)(const char*) const;
-        HashFunction m_hash_function;
+        const Symbol lookup_elf_symbol(const char* name) const;
+        const Symbol lookup_gnu_symbol(const char* name) const;
+
+        HashType m_hash_type;
     };
 
     unsigned symbol_count() const { return m_symbol_count; }
@@ -241,6 +239,8 @@ private:
     size_t m_fini_array_size { 0 };
 
     FlatPtr m_hash_table_offset { 0 };
+    // If the object has both, we use the GNU table, since its bloom filter turns most misses away early.
+    FlatPtr m_gnu_hash_table_offset { 0 };
 
     FlatPtr m_string_table_offset { 0 };
     size_t m_size_of_string_table { 0 };
@@ -25,6 +25,7 @@
  */
 
 #include "Loader.h"
+#include <AK/BinarySearch.h>
 #include <AK/Demangle.h>
 #include <AK/Memory.h>
 #include <AK/QuickSort.h>
@@ -172,17 +173,12 @@ Optional<Image::Symbol> Loader::find_demangled_function(const String& name) cons
     return found;
 }
 
-#ifndef KERNEL
-Optional<Image::Symbol> Loader::find_symbol(u32 address, u32* out_offset) const
+Loader::SortedSymbol* Loader::sorted_symbols() const
 {
-    if (!m_symbol_count)
-        return {};
-
-    SortedSymbol* sorted_symbols = nullptr;
-#    ifdef KERNEL
+#ifdef KERNEL
     if (!m_sorted_symbols_region) {
         m_sorted_symbols_region = MM.allocate_kernel_region(PAGE_ROUND_UP(m_symbol_count * sizeof(SortedSymbol)), "Sorted symbols", Kernel::Region::Access::Read | Kernel::Region::Access::Write);
-        sorted_symbols = (SortedSymbol*)m_sorted_symbols_region->vaddr().as_ptr();
+        auto* sorted_symbols = (SortedSymbol*)m_sorted_symbols_region->vaddr().as_ptr();
         size_t index = 0;
         m_image.for_each_symbol([&](auto& symbol) {
             sorted_symbols[index++] = { symbol.value(), symbol.name() };
@@ -191,10 +187,9 @@ Optional<Image::Symbol> Loader::find_symbol(u32 address, u32* out_offset) const
         quick_sort(sorted_symbols, sorted_symbols + m_symbol_count, [](auto& a, auto& b) {
             return a.address < b.address;
         });
-    } else {
-        sorted_symbols = (SortedSymbol*)m_sorted_symbols_region->vaddr().as_ptr();
     }
-#    else
+    return (SortedSymbol*)m_sorted_symbols_region->vaddr().as_ptr();
+#else
     if (m_sorted_symbols.is_empty()) {
         m_sorted_symbols.ensure_capacity(m_symbol_count);
         m_image.for_each_symbol([this](auto& symbol) {
@@ -205,87 +200,61 @@ Optional<Image::Symbol> Loader::find_symbol(u32 address, u32* out_offset) const
             return a.address < b.address;
         });
     }
-    sorted_symbols = m_sorted_symbols.data();
-#    endif
+    return m_sorted_symbols.data();
+#endif
+}
 
-    for (size_t i = 0; i < m_symbol_count; ++i) {
-        if (sorted_symbols[i].address > address) {
-            if (i == 0)
-                return {};
-            auto& symbol = sorted_symbols[i - 1];
-            if (out_offset)
-                *out_offset = address - symbol.address;
-            return symbol.symbol;
-        }
-    }
-    return {};
+Loader::SymbolLookup Loader::find_sorted_symbol(u32 address) const
+{
+    if (!m_symbol_count)
+        return { SymbolLookup::NoSymbols, nullptr };
+    auto* sorted_symbols = this->sorted_symbols();
+    size_t index = upper_bound(sorted_symbols, m_symbol_count, address, [](u32 address, auto& symbol) {
+        return address < symbol.address;
+    });
+    if (index == 0)
+        return { SymbolLookup::BeforeFirstSymbol, nullptr };
+    // Past the last symbol, there's no telling where its code ends.
+    if (index == m_symbol_count)
+        return { SymbolLookup::AfterLastSymbol, nullptr };
+    return { SymbolLookup::Found, &sorted_symbols[index - 1] };
+}
+
+#ifndef KERNEL
+Optional<Image::Symbol> Loader::find_symbol(u32 address, u32* out_offset) const
+{
+    auto lookup = find_sorted_symbol(address);
+    if (!lookup.symbol)
+        return {};
+    if (out_offset)
+        *out_offset = address - lookup.symbol->address;
+    return lookup.symbol->symbol;
 }
 #endif
 
 String Loader::symbolicate(u32 address, u32* out_offset) const
 {
-    if (!m_symbol_count) {
+    auto lookup = find_sorted_symbol(address);
+    if (!lookup.symbol) {
         if (out_offset)
             *out_offset = 0;
-        return "??";
+        return lookup.result == SymbolLookup::BeforeFirstSymbol ? "!!" : "??";
     }
-    SortedSymbol* sorted_symbols = nullptr;
-#ifdef KERNEL
-    if (!m_sorted_symbols_region) {
-        m_sorted_symbols_region = MM.allocate_kernel_region(PAGE_ROUND_UP(m_symbol_count * sizeof(SortedSymbol)), "Sorted symbols", Kernel::Region::Access::Read | Kernel::Region::Access::Write);
-        sorted_symbols = (SortedSymbol*)m_sorted_symbols_region->vaddr().as_ptr();
-        size_t index = 0;
-        m_image.for_each_symbol([&](auto& symbol) {
-            sorted_symbols[index++] = { symbol.value(), symbol.name() };
-            return IterationDecision::Continue;
-        });
-        quick_sort(sorted_symbols, sorted_symbols + m_symbol_count, [](auto& a, auto& b) {
-            return a.address < b.address;
-        });
-    } else {
-        sorted_symbols = (SortedSymbol*)m_sorted_symbols_region->vaddr().as_ptr();
-    }
-#else
-    if (m_sorted_symbols.is_empty()) {
-        m_sorted_symbols.ensure_capacity(m_symbol_count);
-        m_image.for_each_symbol([this](auto& symbol) {
-            m_sorted_symbols.append({ symbol.value(), symbol.name(), {}, {} });
-            return IterationDecision::Continue;
-        });
-        quick_sort(m_sorted_symbols, [](auto& a, auto& b) {
-            return a.address < b.address;
-        });
-    }
-    sorted_symbols = m_sorted_symbols.data();
-#endif
-
-    for (size_t i = 0; i < m_symbol_count; ++i) {
-        if (sorted_symbols[i].address > address) {
-            if (i == 0) {
-                if (out_offset)
-                    *out_offset = 0;
-                return "!!";
-            }
-            auto& symbol = sorted_symbols[i - 1];
+    auto& symbol = *lookup.symbol;
 
 #ifdef KERNEL
-            auto demangled_name = demangle(symbol.name);
+    auto demangled_name = demangle(symbol.name);
 #else
-            auto& demangled_name = symbol.demangled_name;
-            if (demangled_name.is_null())
-                demangled_name = demangle(symbol.name);
+    auto& demangled_name = symbol.demangled_name;
+    if (demangled_name.is_null())
+        demangled_name = demangle(symbol.name);
 #endif
 
-            if (out_offset) {
-                *out_offset = address - symbol.address;
-                return demangled_name;
-            }
-            return String::format("%s +%u", demangled_name.characters(), address - symbol.address);
-        }
+    if (out_offset) {
+        *out_offset = address - symbol.address;
+        return demangled_name;
     }
-    if (out_offset)
-        *out_offset = 0;
-    return "??";
+    return String::format("%s +%u", demangled_name.characters(), address - symbol.address);
 }
 
 } // end namespace ELF
@@ -104,6 +104,21 @@ private:
 #else
     mutable Vector<SortedSymbol> m_sorted_symbols;
 #endif
+
+    // The symbols, sorted by address. They're only sorted the first time someone asks.
+    SortedSymbol* sorted_symbols() const;
+
+    struct SymbolLookup {
+        enum Result {
+            Found,
+            NoSymbols,
+            BeforeFirstSymbol,
+            AfterLastSymbol,
+        };
+        Result result;
+        SortedSymbol* symbol;
+    };
+    SymbolLookup find_sorted_symbol(u32 address) const;
 };
 
 } // end namespace ELF
@@ -58,14 +58,22 @@ void AbstractTableView::select_all()
 }
 
 void AbstractTableView::update_column_sizes()
+{
+    int first_row;
+    int last_row;
+    visible_row_range(first_row, last_row);
+    update_column_sizes_for_rows(first_row, last_row);
+}
+
+bool AbstractTableView::update_column_sizes_for_rows(int first_row, int last_row)
 {
     if (!model())
-        return;
+        return false;
 
     auto& model = *this->model();
     int column_count = model.column_count();
-    int row_count = model.row_count();
     int key_column = model.key_column();
+    bool did_change = false;
 
     for (int column = 0; column < column_count; ++column) {
         if (is_column_hidden(column))
@@ -74,7 +82,7 @@ void AbstractTableView::update_column_sizes()
         if (column == key_column && model.is_column_sortable(column))
             header_width += font().width(" \xE2\xAC\x86"); // UPWARDS BLACK ARROW
         int column_width = header_width;
-        for (int row = 0; row < row_count; ++row) {
+        for (int row = first_row; row <= last_row; ++row) {
             auto cell_data = model.data(model.index(row, column));
             int cell_width = 0;
             if (cell_data.is_icon()) {
@@ -87,9 +95,27 @@ void AbstractTableView::update_column_sizes()
             column_width = max(column_width, cell_width);
         }
         auto& column_data = this->column_data(column);
-        column_data.width = max(column_data.width, column_width);
+        if (column_width > column_data.width) {
+            column_data.width = column_width;
+            did_change = true;
+        }
         column_data.has_initialized_width = true;
     }
+    return did_change;
+}
+
+void AbstractTableView::visible_row_range(int& first_row, int& last_row) const
+{
+    first_row = 0;
+    last_row = -1;
+    if (!model())
+        return;
+    int row_count = model()->row_count();
+    int visible_height = frame_inner_rect().height() - header_height();
+    if (!row_count || visible_height <= 0)
+        return;
+    first_row = min(vertical_scrollbar().value() / item_height(), row_count - 1);
+    last_row = min((vertical_scrollbar().value() + visible_height - 1) / item_height(), row_count - 1);
 }
 
 void AbstractTableView::update_content_size()
@@ -392,18 +418,20 @@ ModelIndex AbstractTableView::index_at_event_position(const Gfx::Point& position
     if (!model())
         return {};
 
+    // Rows are all the same height, so there's no need to look through them to find the one at a position.
     auto adjusted_position = this->adjusted_position(position);
-    for (int row = 0, row_count = model()->row_count(); row < row_count; ++row) {
-        if (!row_rect(row).contains(adjusted_position))
+    int row_offset = adjusted_position.y() - header_height();
+    if (row_offset < 0)
+        return {};
+    int row = row_offset / item_height();
+    if (row >= model()->row_count() || !row_rect(row).contains(adjusted_position))
+        return {};
+    for (int column = 0, column_count = model()->column_count(); column < column_count; ++column) {
+        if (!content_rect(row, column).contains(adjusted_position))
             continue;
-        for (int column = 0, column_count = model()->column_count(); column < column_count; ++column) {
-            if (!content_rect(row, column).contains(adjusted_position))
-                continue;
-            return model()->index(row, column);
-        }
-        return model()->index(row, 0);
+        return model()->index(row, column);
     }
-    return {};
+    return model()->index(row, 0);
 }
 
 ModelIndex AbstractTableView::index_at_event_position(const Gfx::Point& position) const
@@ -109,7 +109,13 @@ protected:
     Gfx::Rect column_resize_grabbable_rect(int) const;
     int column_width(int) const;
     void update_content_size();
+    // Column widths are fitted to the rows that have been on screen, rather than all of them, so big models
+    // don't have all their data fetched. Widths only ever grow.
     virtual void update_column_sizes();
+    // Returns whether any column got wider.
+    bool update_column_sizes_for_rows(int first_row, int last_row);
+    // The rows at least partly on screen, with last_row < first_row if there are none.
+    void visible_row_range(int& first_row, int& last_row) const;
     virtual int item_count() const;
 
 private:
@@ -72,6 +72,58 @@ void AbstractView::did_update_model(unsigned flags)
     }
 }
 
+void AbstractView::did_insert_model_rows(const ModelIndex& parent, int first, int last)
+{
+    adjust_indexes_for_inserted_rows(parent, first, last);
+    did_update_model(Model::UpdateFlag::DontInvalidateIndexes);
+}
+
+void AbstractView::did_remove_model_rows(const ModelIndex& parent, int first, int last)
+{
+    adjust_indexes_for_removed_rows(parent, first, last);
+    did_update_model(Model::UpdateFlag::DontInvalidateIndexes);
+}
+
+void AbstractView::did_change_model_rows(const ModelIndex&, int, int)
+{
+    did_update_model(Model::UpdateFlag::DontInvalidateIndexes);
+}
+
+void AbstractView::remap_indexes(Function<ModelIndex(const ModelIndex&)> remap)
+{
+    selection().remap([&](auto& index) { return remap(index); });
+    if (m_hovered_index.is_valid())
+        m_hovered_index = remap(m_hovered_index);
+    if (m_edit_index.is_valid()) {
+        auto edit_index = remap(m_edit_index);
+        if (!edit_index.is_valid())
+            stop_editing();
+        m_edit_index = edit_index;
+    }
+}
+
+void AbstractView::adjust_indexes_for_inserted_rows(const ModelIndex& parent, int first, int last)
+{
+    int count = last - first + 1;
+    remap_indexes([&](auto& index) {
+        if (index.row() < first || index.parent() != parent)
+            return index;
+        return model()->index(index.row() + count, index.column(), parent);
+    });
+}
+
+void AbstractView::adjust_indexes_for_removed_rows(const ModelIndex& parent, int first, int last)
+{
+    int count = last - first + 1;
+    remap_indexes([&](auto& index) {
+        if (index.row() < first || index.parent() != parent)
+            return index;
+        if (index.row() <= last)
+            return ModelIndex();
+        return model()->index(index.row() - count, index.column(), parent);
+    });
+}
+
 void AbstractView::did_update_selection()
 {
     if (!model() || selection().first() != m_edit_index)
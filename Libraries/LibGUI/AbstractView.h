@@ -49,6 +49,11 @@ public:
 
     virtual bool accepts_focus() const override { return true; }
     virtual void did_update_model(unsigned flags);
+    // For models that report exactly which rows changed. By default, indexes are moved along with the rows
+    // and the view refreshes as after any other update.
+    virtual void did_insert_model_rows(const ModelIndex& parent, int first, int last);
+    virtual void did_remove_model_rows(const ModelIndex& parent, int first, int last);
+    virtual void did_change_model_rows(const ModelIndex& parent, int first, int last);
     virtual void did_update_selection();
 
     virtual Gfx::Rect content_rect(const ModelIndex&) const { return {}; }
@@ -89,6 +94,10 @@ protected:
     void activate_selected();
     void update_edit_widget_position();
 
+    // Moves the selected, hovered and edited indexes along with rows that were inserted or removed.
+    void adjust_indexes_for_inserted_rows(const ModelIndex& parent, int first, int last);
+    void adjust_indexes_for_removed_rows(const ModelIndex& parent, int first, int last);
+
     bool m_editable { false };
     ModelIndex m_edit_index;
     RefPtr<Widget> m_edit_widget;
@@ -100,6 +109,8 @@ protected:
     ModelIndex m_hovered_index;
 
 private:
+    void remap_indexes(Function<ModelIndex(const ModelIndex&)>);
+
     RefPtr<Model> m_model;
     OwnPtr<ModelEditingDelegate> m_editing_delegate;
     ModelSelection m_selection;
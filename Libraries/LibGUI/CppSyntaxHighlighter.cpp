@@ -73,34 +73,37 @@ bool CppSyntaxHighlighter::is_navigatable(void* token) const
     return cpp_token == GUI::CppToken::Type::IncludePath;
 }
 
-void CppSyntaxHighlighter::rehighlight(Gfx::Palette palette)
+static void lex_cpp(const StringView& text, SyntaxHighlighter::LexedText& lexed)
 {
-    ASSERT(m_editor);
-    auto text = m_editor->text();
     CppLexer lexer(text);
-    auto tokens = lexer.lex();
-
-    Vector<GUI::TextDocumentSpan> spans;
-    for (auto& token : tokens) {
+    auto previous_type = CppToken::Type::Unknown;
+    for (auto& token : lexer.lex()) {
+        // An #include looks for its path past any number of line breaks.
+        if (previous_type == CppToken::Type::IncludeStatement && token.m_type == CppToken::Type::Whitespace) {
+            for (size_t line = token.m_start.line + 1; line <= token.m_end.line + 1; ++line)
+                lexed.lines_continuing_state.append(line);
+        }
+        previous_type = token.m_type;
 #ifdef DEBUG_SYNTAX_HIGHLIGHTING
         dbg() << token.to_string() << " @ " << token.m_start.line << ":" << token.m_start.column << " - " << token.m_end.line << ":" << token.m_end.column;
 #endif
         GUI::TextDocumentSpan span;
         span.range.set_start({ token.m_start.line, token.m_start.column });
         span.range.set_end({ token.m_end.line, token.m_end.column });
-        auto style = style_for_token_type(palette, token.m_type);
-        span.color = style.color;
-        span.font = style.font;
         span.is_skippable = token.m_type == CppToken::Type::Whitespace;
         span.data = reinterpret_cast<void*>(token.m_type);
-        spans.append(span);
+        lexed.spans.append(span);
     }
-    m_editor->document().set_spans(spans);
+}
 
-    m_has_brace_buddies = false;
-    highlight_matching_token_pair();
+SyntaxHighlighter::LexFunction CppSyntaxHighlighter::lex_function() const
+{
+    return lex_cpp;
+}
 
-    m_editor->update();
+TextStyle CppSyntaxHighlighter::style_for_token(const Gfx::Palette& palette, void* token) const
+{
+    return style_for_token_type(palette, static_cast<CppToken::Type>(reinterpret_cast<size_t>(token)));
 }
 
 Vector<SyntaxHighlighter::MatchingTokenPair> CppSyntaxHighlighter::matching_token_pairs() const
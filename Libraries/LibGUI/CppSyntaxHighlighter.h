@@ -39,9 +39,10 @@ public:
     virtual bool is_navigatable(void*) const override;
 
     virtual SyntaxLanguage language() const override { return SyntaxLanguage::Cpp; }
-    virtual void rehighlight(Gfx::Palette) override;
 
 protected:
+    virtual LexFunction lex_function() const override;
+    virtual TextStyle style_for_token(const Gfx::Palette&, void* token) const override;
     virtual Vector<MatchingTokenPair> matching_token_pairs() const override;
     virtual bool token_types_equal(void*, void*) const override;
 };
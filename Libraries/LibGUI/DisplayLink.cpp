@@ -59,11 +59,14 @@ static HashMap<i32, RefPtr<DisplayLinkCallback>>& callbacks()
 }
 
 static i32 s_next_callback_id = 1;
+static bool s_display_link_enabled = false;
 
 i32 DisplayLink::register_callback(Function<void(i32)> callback)
 {
-    if (callbacks().is_empty())
+    if (!s_display_link_enabled) {
         WindowServerConnection::the().post_message(Messages::WindowServer::EnableDisplayLink());
+        s_display_link_enabled = true;
+    }
 
     i32 callback_id = s_next_callback_id++;
     callbacks().set(callback_id, adopt(*new DisplayLinkCallback(callback_id, move(callback))));
@@ -76,14 +79,21 @@ bool DisplayLink::unregister_callback(i32 callback_id)
     ASSERT(callbacks().contains(callback_id));
     callbacks().remove(callback_id);
 
-    if (callbacks().is_empty())
-        WindowServerConnection::the().post_message(Messages::WindowServer::DisableDisplayLink());
-
+    // Animations typically unregister their callback from within it and register a new one for the
+    // next frame, so the display link is only disabled once a whole frame goes by without any.
     return true;
 }
 
 void DisplayLink::notify(Badge<WindowServerConnection>)
 {
+    if (callbacks().is_empty()) {
+        if (s_display_link_enabled) {
+            WindowServerConnection::the().post_message(Messages::WindowServer::DisableDisplayLink());
+            s_display_link_enabled = false;
+        }
+        return;
+    }
+
     auto copy_of_callbacks = callbacks();
     for (auto& it : copy_of_callbacks)
         it.value->invoke();
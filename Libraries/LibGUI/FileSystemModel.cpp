@@ -28,7 +28,7 @@
 #include <AK/StringBuilder.h>
 #include <LibCore/DirIterator.h>
 #include <LibGUI/FileSystemModel.h>
-#include <LibGUI/Painter.h>
+#include <LibGUI/ThumbnailCache.h>
 #include <LibGfx/Bitmap.h>
 #include <LibThread/BackgroundAction.h>
 #include <dirent.h>
@@ -51,12 +51,14 @@ ModelIndex FileSystemModel::Node::index(const FileSystemModel& model, int column
     ASSERT_NOT_REACHED();
 }
 
-bool FileSystemModel::Node::fetch_data(const String& full_path, bool is_root)
+bool FileSystemModel::Node::fetch_data(const String& full_path, bool is_root, int parent_fd)
 {
     struct stat st;
     int rc;
     if (is_root)
         rc = stat(full_path.characters(), &st);
+    else if (parent_fd != AT_FDCWD)
+        rc = fstatat(parent_fd, name.characters(), &st, AT_SYMLINK_NOFOLLOW);
     else
         rc = lstat(full_path.characters(), &st);
     if (rc < 0) {
@@ -105,12 +107,12 @@ void FileSystemModel::Node::traverse_if_needed(const FileSystemModel& model)
         String name = di.next_path();
         String child_path = String::format("%s/%s", full_path.characters(), name.characters());
         NonnullOwnPtr<Node> child = make<Node>();
-        bool ok = child->fetch_data(child_path, false);
+        child->name = name;
+        bool ok = child->fetch_data(child_path, false, di.fd());
         if (!ok)
             continue;
         if (model.m_mode == DirectoriesOnly && !S_ISDIR(child->mode))
             continue;
-        child->name = name;
         child->parent = this;
         total_size += child->size;
         children.append(move(child));
@@ -128,16 +130,85 @@ void FileSystemModel::Node::traverse_if_needed(const FileSystemModel& model)
     dbg() << "Watching " << full_path << " for changes, m_watch_fd = " << m_watch_fd;
     m_notifier = Core::Notifier::construct(m_watch_fd, Core::Notifier::Event::Read);
     m_notifier->on_ready_to_read = [this, &model] {
-        char buffer[32];
-        int rc = read(m_notifier->fd(), buffer, sizeof(buffer));
-        ASSERT(rc >= 0);
+        u8 buffer[sizeof(InodeWatcherEvent) + PATH_MAX];
+        int nread = read(m_notifier->fd(), buffer, sizeof(buffer));
+        if (nread < 0) {
+            perror("read");
+            return;
+        }
+
+        for (size_t offset = 0; offset + sizeof(InodeWatcherEvent) <= (size_t)nread;) {
+            InodeWatcherEvent event;
+            memcpy(&event, buffer + offset, sizeof(event));
+            offset += sizeof(event);
+            if (event.name_length > nread - offset)
+                break;
+            StringView name((const char*)buffer + offset, event.name_length);
+            offset += event.name_length;
+            handle_watch_event(model, event.type, name);
+        }
+    };
+}
 
+void FileSystemModel::Node::handle_watch_event(const FileSystemModel& model, InodeWatcherEvent::Type type, const StringView& name)
+{
+    auto& mutable_model = const_cast<FileSystemModel&>(model);
+    switch (type) {
+    case InodeWatcherEvent::Type::ChildAdded:
+        did_add_child(model, name);
+        break;
+    case InodeWatcherEvent::Type::ChildRemoved:
+        did_remove_child(model, name);
+        break;
+    case InodeWatcherEvent::Type::Modified:
+        if (parent && fetch_data(full_path(model), false)) {
+            auto index = this->index(model, 0);
+            mutable_model.did_change_rows(index.parent(), index.row(), index.row());
+        }
+        break;
+    default:
+        // We've missed something, so start over.
         has_traversed = false;
         mode = 0;
         children.clear();
         reify_if_needed(model);
-        const_cast<FileSystemModel&>(model).did_update();
-    };
+        mutable_model.did_update();
+        break;
+    }
+}
+
+void FileSystemModel::Node::did_add_child(const FileSystemModel& model, const StringView& name)
+{
+    // We might have seen it already when the directory was read again.
+    for (auto& child : children) {
+        if (child.name == name)
+            return;
+    }
+
+    NonnullOwnPtr<Node> child = make<Node>();
+    child->name = name;
+    child->parent = this;
+    if (!child->fetch_data(child->full_path(model), false))
+        return;
+    if (model.m_mode == DirectoriesOnly && !S_ISDIR(child->mode))
+        return;
+    total_size += child->size;
+    children.append(move(child));
+
+    int row = children.size() - 1;
+    const_cast<FileSystemModel&>(model).did_insert_rows(index(model, 0), row, row);
+}
+
+void FileSystemModel::Node::did_remove_child(const FileSystemModel& model, const StringView& name)
+{
+    for (size_t row = 0; row < children.size(); ++row) {
+        if (children[row].name != name)
+            continue;
+        total_size -= children[row].size;
+        children.remove(row);
+        const_cast<FileSystemModel&>(model).did_remove_rows(index(model, 0), row, row);
+        return;
+    }
 }
 
 void FileSystemModel::Node::reify_if_needed(const FileSystemModel& model)
@@ -473,23 +544,6 @@ Icon FileSystemModel::icon_for(const Node& node) const
 
 static HashMap<String, RefPtr<Gfx::Bitmap>> s_thumbnail_cache;
 
-static RefPtr<Gfx::Bitmap> render_thumbnail(const StringView& path)
-{
-    auto png_bitmap = Gfx::Bitmap::load_from_file(path);
-    if (!png_bitmap)
-        return nullptr;
-
-    double scale = min(32 / (double)png_bitmap->width(), 32 / (double)png_bitmap->height());
-
-    auto thumbnail = Gfx::Bitmap::create(png_bitmap->format(), { 32, 32 });
-    Gfx::Rect destination = Gfx::Rect(0, 0, (int)(png_bitmap->width() * scale), (int)(png_bitmap->height() * scale));
-    destination.center_within(thumbnail->rect());
-
-    Painter painter(*thumbnail);
-    painter.draw_scaled_bitmap(destination, *png_bitmap, png_bitmap->rect());
-    return thumbnail;
-}
-
 bool FileSystemModel::fetch_thumbnail_for(const Node& node)
 {
     // See if we already have the thumbnail
@@ -513,7 +567,7 @@ bool FileSystemModel::fetch_thumbnail_for(const Node& node)
 
     LibThread::BackgroundAction<RefPtr<Gfx::Bitmap>>::create(
         [path] {
-            return render_thumbnail(path);
+            return ThumbnailCache::thumbnail_for(path);
         },
 
         [this, path, weak_this](auto thumbnail) {
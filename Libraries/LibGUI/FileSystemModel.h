@@ -28,6 +28,7 @@
 
 #include <AK/HashMap.h>
 #include <AK/NonnullOwnPtrVector.h>
+#include <Kernel/InodeWatcherEvent.h>
 #include <LibCore/DateTime.h>
 #include <LibCore/Notifier.h>
 #include <LibGUI/Model.h>
@@ -116,7 +117,12 @@ public:
         ModelIndex index(const FileSystemModel&, int column) const;
         void traverse_if_needed(const FileSystemModel&);
         void reify_if_needed(const FileSystemModel&);
-        bool fetch_data(const String& full_path, bool is_root);
+        bool fetch_data(const String& full_path, bool is_root, int parent_fd = AT_FDCWD);
+
+        // Directories are watched once they're read, and follow their entries coming and going from then on.
+        void handle_watch_event(const FileSystemModel&, InodeWatcherEvent::Type, const StringView& name);
+        void did_add_child(const FileSystemModel&, const StringView& name);
+        void did_remove_child(const FileSystemModel&, const StringView& name);
     };
 
     static NonnullRefPtr<FileSystemModel> create(const StringView& root_path = "/", Mode mode = Mode::FilesAndDirectories)
@@ -58,31 +58,27 @@ bool IniSyntaxHighlighter::is_identifier(void* token) const
     return ini_token == GUI::IniToken::Type::Name;
 }
 
-void IniSyntaxHighlighter::rehighlight(Gfx::Palette palette)
+static void lex_ini(const StringView& text, SyntaxHighlighter::LexedText& lexed)
 {
-    ASSERT(m_editor);
-    auto text = m_editor->text();
     IniLexer lexer(text);
-    auto tokens = lexer.lex();
-
-    Vector<GUI::TextDocumentSpan> spans;
-    for (auto& token : tokens) {
+    for (auto& token : lexer.lex()) {
         GUI::TextDocumentSpan span;
         span.range.set_start({ token.m_start.line, token.m_start.column });
         span.range.set_end({ token.m_end.line, token.m_end.column });
-        auto style = style_for_token_type(palette, token.m_type);
-        span.color = style.color;
-        span.font = style.font;
         span.is_skippable = token.m_type == IniToken::Type::Whitespace;
         span.data = reinterpret_cast<void*>(token.m_type);
-        spans.append(span);
+        lexed.spans.append(span);
     }
-    m_editor->document().set_spans(spans);
+}
 
-    m_has_brace_buddies = false;
-    highlight_matching_token_pair();
+SyntaxHighlighter::LexFunction IniSyntaxHighlighter::lex_function() const
+{
+    return lex_ini;
+}
 
-    m_editor->update();
+TextStyle IniSyntaxHighlighter::style_for_token(const Gfx::Palette& palette, void* token) const
+{
+    return style_for_token_type(palette, static_cast<IniToken::Type>(reinterpret_cast<size_t>(token)));
 }
 
 Vector<IniSyntaxHighlighter::MatchingTokenPair> IniSyntaxHighlighter::matching_token_pairs() const
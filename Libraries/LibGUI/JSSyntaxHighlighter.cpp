@@ -151,17 +151,19 @@ bool JSSyntaxHighlighter::is_navigatable(void* token) const
     return false;
 }
 
-void JSSyntaxHighlighter::rehighlight(Gfx::Palette palette)
+static void lex_js(const StringView& text, SyntaxHighlighter::LexedText& lexed)
 {
-    ASSERT(m_editor);
-    auto text = m_editor->text();
-
     JS::Lexer lexer(text);
 
-    Vector<GUI::TextDocumentSpan> spans;
     GUI::TextPosition position { 0, 0 };
     GUI::TextPosition start { 0, 0 };
 
+    // What a lexer starting out on a line wouldn't know: that it's inside a template literal or a comment, or that
+    // a slash is a division.
+    size_t template_depth = 0;
+    bool in_block_comment = false;
+    auto previous_type = JS::TokenType::Eof;
+
     auto advance_position = [&position](char ch) {
         if (ch == '\n') {
             position.set_line(position.line() + 1);
@@ -170,6 +172,32 @@ void JSSyntaxHighlighter::rehighlight(Gfx::Palette palette)
             position.set_column(position.column() + 1);
     };
 
+    auto scan_trivia = [&](StringView trivia) {
+        size_t line = position.line();
+        bool in_line_comment = false;
+        for (size_t i = 0; i < trivia.length(); ++i) {
+            auto rest = trivia.substring_view(i, trivia.length() - i);
+            if (in_block_comment) {
+                if (rest.starts_with("*/")) {
+                    in_block_comment = false;
+                    ++i;
+                }
+            } else if (in_line_comment) {
+                in_line_comment = trivia[i] != '\n';
+            } else if (rest.starts_with("/*")) {
+                in_block_comment = true;
+                ++i;
+            } else if (rest.starts_with("//") || rest.starts_with("<!--") || rest.starts_with("-->")) {
+                in_line_comment = true;
+            }
+            if (trivia[i] == '\n') {
+                ++line;
+                if (template_depth || in_block_comment || !JS::Lexer::slash_means_regex_after(previous_type))
+                    lexed.lines_continuing_state.append(line);
+            }
+        }
+    };
+
     auto append_token = [&](StringView str, const JS::Token& token, bool is_trivia) {
         if (str.is_empty())
             return;
@@ -182,12 +210,9 @@ void JSSyntaxHighlighter::rehighlight(Gfx::Palette palette)
         span.range.set_start(start);
         span.range.set_end({ position.line(), position.column() });
         auto type = is_trivia ? JS::TokenType::Invalid : token.type();
-        auto style = style_for_token_type(palette, type);
-        span.color = style.color;
-        span.font = style.font;
         span.is_skippable = is_trivia;
         span.data = reinterpret_cast<void*>(static_cast<size_t>(type));
-        spans.append(span);
+        lexed.spans.append(span);
         advance_position(str[str.length() - 1]);
 
 #ifdef DEBUG_SYNTAX_HIGHLIGHTING
@@ -199,19 +224,29 @@ void JSSyntaxHighlighter::rehighlight(Gfx::Palette palette)
 
     bool was_eof = false;
     for (auto token = lexer.next(); !was_eof; token = lexer.next()) {
+        scan_trivia(token.trivia());
         append_token(token.trivia(), token, true);
         append_token(token.value(), token, false);
 
+        if (token.type() == JS::TokenType::TemplateLiteralStart)
+            ++template_depth;
+        else if (token.type() == JS::TokenType::TemplateLiteralEnd && template_depth)
+            --template_depth;
         if (token.type() == JS::TokenType::Eof)
             was_eof = true;
+        else
+            previous_type = token.type();
     }
+}
 
-    m_editor->document().set_spans(spans);
-
-    m_has_brace_buddies = false;
-    highlight_matching_token_pair();
+SyntaxHighlighter::LexFunction JSSyntaxHighlighter::lex_function() const
+{
+    return lex_js;
+}
 
-    m_editor->update();
+TextStyle JSSyntaxHighlighter::style_for_token(const Gfx::Palette& palette, void* token) const
+{
+    return style_for_token_type(palette, static_cast<JS::TokenType>(reinterpret_cast<size_t>(token)));
 }
 
 Vector<SyntaxHighlighter::MatchingTokenPair> JSSyntaxHighlighter::matching_token_pairs() const
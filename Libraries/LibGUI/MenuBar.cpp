@@ -57,7 +57,7 @@ void MenuBar::unrealize_menubar()
 {
     if (m_menubar_id == -1)
         return;
-    WindowServerConnection::the().send_sync<Messages::WindowServer::DestroyMenubar>(m_menubar_id);
+    WindowServerConnection::the().send_async<Messages::WindowServer::DestroyMenubar>(m_menubar_id);
     m_menubar_id = -1;
 }
 
@@ -66,12 +66,14 @@ void MenuBar::notify_added_to_application(Badge<Application>)
     ASSERT(m_menubar_id == -1);
     m_menubar_id = realize_menubar();
     ASSERT(m_menubar_id != -1);
+    WindowServerConnection::the().begin_batch();
     for (auto& menu : m_menus) {
         int menu_id = menu.realize_menu();
         ASSERT(menu_id != -1);
-        WindowServerConnection::the().send_sync<Messages::WindowServer::AddMenuToMenubar>(m_menubar_id, menu_id);
+        WindowServerConnection::the().send_async<Messages::WindowServer::AddMenuToMenubar>(m_menubar_id, menu_id);
     }
-    WindowServerConnection::the().send_sync<Messages::WindowServer::SetApplicationMenubar>(m_menubar_id);
+    WindowServerConnection::the().send_async<Messages::WindowServer::SetApplicationMenubar>(m_menubar_id);
+    WindowServerConnection::the().end_batch();
 }
 
 void MenuBar::notify_removed_from_application(Badge<Application>)
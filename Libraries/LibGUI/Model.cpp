@@ -62,6 +62,36 @@ void Model::did_update(unsigned flags)
     });
 }
 
+void Model::did_insert_rows(const ModelIndex& parent, int first, int last)
+{
+    ASSERT(first <= last);
+    if (on_rows_inserted)
+        on_rows_inserted(parent, first, last);
+    for_each_view([&](auto& view) {
+        view.did_insert_model_rows(parent, first, last);
+    });
+}
+
+void Model::did_remove_rows(const ModelIndex& parent, int first, int last)
+{
+    ASSERT(first <= last);
+    if (on_rows_removed)
+        on_rows_removed(parent, first, last);
+    for_each_view([&](auto& view) {
+        view.did_remove_model_rows(parent, first, last);
+    });
+}
+
+void Model::did_change_rows(const ModelIndex& parent, int first, int last)
+{
+    ASSERT(first <= last);
+    if (on_rows_changed)
+        on_rows_changed(parent, first, last);
+    for_each_view([&](auto& view) {
+        view.did_change_model_rows(parent, first, last);
+    });
+}
+
 ModelIndex Model::create_index(int row, int column, const void* data) const
 {
     return ModelIndex(*this, row, column, const_cast<void*>(data));
@@ -96,6 +96,10 @@ public:
     void unregister_view(Badge<AbstractView>, AbstractView&);
 
     Function<void()> on_update;
+    // Like on_update, for following the incremental changes below. The rows are first to last, inclusive.
+    Function<void(const ModelIndex& parent, int first, int last)> on_rows_inserted;
+    Function<void(const ModelIndex& parent, int first, int last)> on_rows_removed;
+    Function<void(const ModelIndex& parent, int first, int last)> on_rows_changed;
 
 protected:
     Model();
@@ -103,6 +107,12 @@ protected:
     void for_each_view(Function<void(AbstractView&)>);
     void did_update(unsigned flags = UpdateFlag::InvalidateAllIndexes);
 
+    // Models that know exactly what changed can say so with these instead of did_update(), so views keep their
+    // selection on the same items and only refresh the rows in question. They are called after the change is made.
+    void did_insert_rows(const ModelIndex& parent, int first, int last);
+    void did_remove_rows(const ModelIndex& parent, int first, int last);
+    void did_change_rows(const ModelIndex& parent, int first, int last);
+
     ModelIndex create_index(int row, int column, const void* data = nullptr) const;
 
 private:
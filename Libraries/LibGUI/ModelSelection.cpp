@@ -42,6 +42,17 @@ void ModelSelection::remove_matching(Function<bool(const ModelIndex&)> filter)
         m_indexes.remove(index);
 }
 
+void ModelSelection::remap(Function<ModelIndex(const ModelIndex&)> remap)
+{
+    HashTable<ModelIndex> remapped_indexes;
+    for (auto& index : m_indexes) {
+        auto remapped_index = remap(index);
+        if (remapped_index.is_valid())
+            remapped_indexes.set(remapped_index);
+    }
+    m_indexes = move(remapped_indexes);
+}
+
 void ModelSelection::set(const ModelIndex& index)
 {
     ASSERT(index.is_valid());
@@ -90,6 +90,9 @@ public:
     }
 
     void remove_matching(Function<bool(const ModelIndex&)>);
+    // Replaces each selected index with what the function returns for it, dropping the ones it returns an invalid
+    // index for. For following rows that moved, so it doesn't count as a change of selection.
+    void remap(Function<ModelIndex(const ModelIndex&)>);
 
 private:
     AbstractView& m_view;
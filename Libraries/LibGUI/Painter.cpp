@@ -44,6 +44,8 @@ Painter::Painter(Widget& widget)
     state().clip_rect = origin_rect;
     m_clip_origin = origin_rect;
     state().clip_rect.intersect(m_target->rect());
+    if (auto* display_list = widget.display_list_being_recorded())
+        start_recording(*display_list);
 }
 
 }
@@ -24,6 +24,7 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <AK/MergeSort.h>
 #include <AK/QuickSort.h>
 #include <LibGUI/AbstractView.h>
 #include <LibGUI/SortingProxyModel.h>
@@ -39,6 +40,40 @@ SortingProxyModel::SortingProxyModel(NonnullRefPtr<Model>&& target)
     m_target->on_update = [this] {
         resort();
     };
+    // Only flat models get incremental updates; for anything else, sort everything again.
+    m_target->on_rows_inserted = [this](auto& parent, int first, int last) {
+        if (parent.is_valid())
+            return resort();
+        target_did_insert_rows(first, last);
+    };
+    m_target->on_rows_removed = [this](auto& parent, int first, int last) {
+        if (parent.is_valid())
+            return resort();
+        target_did_remove_rows(first, last);
+    };
+    m_target->on_rows_changed = [this](auto& parent, int first, int last) {
+        if (parent.is_valid())
+            return resort();
+        target_did_change_rows(first, last);
+    };
+}
+
+// Calls the callback with each run of consecutive rows in a sorted list, from the last run to the first
+// if the rows are being removed, so that earlier ones keep their numbers.
+template<typename Callback>
+static void for_each_row_range(const Vector<int>& sorted_rows, bool backwards, Callback callback)
+{
+    Vector<int> range_starts;
+    for (size_t i = 0; i < sorted_rows.size(); ++i) {
+        if (i == 0 || sorted_rows[i] != sorted_rows[i - 1] + 1)
+            range_starts.append(i);
+    }
+    for (size_t n = 0; n < range_starts.size(); ++n) {
+        size_t range_index = backwards ? range_starts.size() - n - 1 : n;
+        size_t start = range_starts[range_index];
+        size_t end = range_index + 1 < range_starts.size() ? range_starts[range_index + 1] : sorted_rows.size();
+        callback(sorted_rows[start], sorted_rows[end - 1]);
+    }
 }
 
 SortingProxyModel::~SortingProxyModel()
@@ -100,6 +135,29 @@ void SortingProxyModel::set_key_column_and_sort_order(int column, SortOrder sort
     resort();
 }
 
+bool SortingProxyModel::less_than(int target_row1, int target_row2) const
+{
+    auto data1 = target().data(target().index(target_row1, m_key_column), Model::Role::Sort);
+    auto data2 = target().data(target().index(target_row2, m_key_column), Model::Role::Sort);
+    if (data1 == data2)
+        return false;
+    bool is_less_than;
+    if (data1.is_string() && data2.is_string() && !m_sorting_case_sensitive)
+        is_less_than = data1.as_string().to_lowercase() < data2.as_string().to_lowercase();
+    else
+        is_less_than = data1 < data2;
+    return m_sort_order == SortOrder::Ascending ? is_less_than : !is_less_than;
+}
+
+Vector<int> SortingProxyModel::inverse_row_mappings() const
+{
+    Vector<int> inverse;
+    inverse.resize(m_row_mappings.size());
+    for (size_t i = 0; i < m_row_mappings.size(); ++i)
+        inverse[m_row_mappings[i]] = i;
+    return inverse;
+}
+
 void SortingProxyModel::resort()
 {
     auto old_row_mappings = m_row_mappings;
@@ -111,35 +169,120 @@ void SortingProxyModel::resort()
         did_update(Model::UpdateFlag::DontInvalidateIndexes);
         return;
     }
-    quick_sort(m_row_mappings, [&](auto row1, auto row2) -> bool {
-        auto data1 = target().data(target().index(row1, m_key_column), Model::Role::Sort);
-        auto data2 = target().data(target().index(row2, m_key_column), Model::Role::Sort);
-        if (data1 == data2)
-            return 0;
-        bool is_less_than;
-        if (data1.is_string() && data2.is_string() && !m_sorting_case_sensitive)
-            is_less_than = data1.as_string().to_lowercase() < data2.as_string().to_lowercase();
-        else
-            is_less_than = data1 < data2;
-        return m_sort_order == SortOrder::Ascending ? is_less_than : !is_less_than;
+    // Use a stable sort so that rows with equal keys keep the order of the underlying model.
+    merge_sort(m_row_mappings, [&](auto row1, auto row2) -> bool {
+        return less_than(row1, row2);
     });
     did_update(Model::UpdateFlag::DontInvalidateIndexes);
+
+    auto new_rows = inverse_row_mappings();
     for_each_view([&](AbstractView& view) {
         auto& selection = view.selection();
-        Vector<ModelIndex> selected_indexes_in_target;
+        Vector<ModelIndex> new_selected_indexes;
         selection.for_each_index([&](const ModelIndex& index) {
-            selected_indexes_in_target.append(target().index(old_row_mappings[index.row()], index.column()));
+            if (static_cast<size_t>(index.row()) >= old_row_mappings.size())
+                return;
+            int target_row = old_row_mappings[index.row()];
+            if (target_row < row_count)
+                new_selected_indexes.append(this->index(new_rows[target_row], index.column()));
         });
 
         selection.clear();
-        for (auto& index : selected_indexes_in_target) {
-            for (size_t i = 0; i < m_row_mappings.size(); ++i) {
-                if (m_row_mappings[i] == index.row()) {
-                    selection.add(this->index(i, index.column()));
-                    continue;
-                }
-            }
+        for (auto& index : new_selected_indexes)
+            selection.add(index);
+    });
+}
+
+void SortingProxyModel::target_did_insert_rows(int first, int last)
+{
+    int count = last - first + 1;
+    // If the mappings weren't in step with the target to begin with, there's nothing to adjust.
+    if (static_cast<int>(m_row_mappings.size()) + count != target().row_count())
+        return resort();
+
+    for (auto& target_row : m_row_mappings) {
+        if (target_row >= first)
+            target_row += count;
+    }
+
+    for (int target_row = first; target_row <= last; ++target_row) {
+        if (m_key_column == -1) {
+            m_row_mappings.insert(target_row, target_row);
+            continue;
         }
+        // Binary search for the first row that sorts after the new one.
+        size_t low = 0;
+        size_t high = m_row_mappings.size();
+        while (low < high) {
+            size_t middle = low + (high - low) / 2;
+            if (less_than(target_row, m_row_mappings[middle]))
+                high = middle;
+            else
+                low = middle + 1;
+        }
+        m_row_mappings.insert(low, target_row);
+    }
+
+    Vector<int> inserted_rows;
+    for (size_t i = 0; i < m_row_mappings.size(); ++i) {
+        if (m_row_mappings[i] >= first && m_row_mappings[i] <= last)
+            inserted_rows.append(i);
+    }
+    for_each_row_range(inserted_rows, false, [&](int range_first, int range_last) {
+        did_insert_rows({}, range_first, range_last);
+    });
+}
+
+void SortingProxyModel::target_did_remove_rows(int first, int last)
+{
+    int count = last - first + 1;
+    if (static_cast<int>(m_row_mappings.size()) - count != target().row_count())
+        return resort();
+
+    Vector<int> removed_rows;
+    Vector<int> remaining_row_mappings;
+    remaining_row_mappings.ensure_capacity(m_row_mappings.size());
+    for (size_t i = 0; i < m_row_mappings.size(); ++i) {
+        int target_row = m_row_mappings[i];
+        if (target_row >= first && target_row <= last) {
+            removed_rows.append(i);
+            continue;
+        }
+        remaining_row_mappings.append(target_row > last ? target_row - count : target_row);
+    }
+    m_row_mappings = move(remaining_row_mappings);
+
+    for_each_row_range(removed_rows, true, [&](int range_first, int range_last) {
+        did_remove_rows({}, range_first, range_last);
+    });
+}
+
+void SortingProxyModel::target_did_change_rows(int first, int last)
+{
+    if (static_cast<int>(m_row_mappings.size()) != target().row_count())
+        return resort();
+
+    Vector<int> changed_rows;
+    if (m_key_column == -1) {
+        for (int row = first; row <= last; ++row)
+            changed_rows.append(row);
+    } else {
+        auto rows = inverse_row_mappings();
+        for (int target_row = first; target_row <= last; ++target_row)
+            changed_rows.append(rows[target_row]);
+        quick_sort(changed_rows);
+
+        // If every changed row still sorts between its neighbours, nothing has to move.
+        int row_count = m_row_mappings.size();
+        for (int row : changed_rows) {
+            if ((row > 0 && less_than(m_row_mappings[row], m_row_mappings[row - 1]))
+                || (row + 1 < row_count && less_than(m_row_mappings[row + 1], m_row_mappings[row])))
+                return resort();
+        }
+    }
+
+    for_each_row_range(changed_rows, false, [&](int range_first, int range_last) {
+        did_change_rows({}, range_first, range_last);
     });
 }
 
@@ -56,6 +56,15 @@ private:
     const Model& target() const { return *m_target; }
 
     void resort();
+    // Whether target_row1 belongs before target_row2 in the current sort order.
+    bool less_than(int target_row1, int target_row2) const;
+    // Maps each target row to the row it's shown at.
+    Vector<int> inverse_row_mappings() const;
+
+    // Follow incremental changes in the target without sorting everything again, where possible.
+    void target_did_insert_rows(int first, int last);
+    void target_did_remove_rows(int first, int last);
+    void target_did_change_rows(int first, int last);
 
     void set_sorting_case_sensitive(bool b) { m_sorting_case_sensitive = b; }
     bool is_sorting_case_sensitive() { return m_sorting_case_sensitive; }
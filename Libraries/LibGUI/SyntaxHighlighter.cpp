@@ -24,11 +24,39 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <AK/StringBuilder.h>
 #include <LibGUI/SyntaxHighlighter.h>
 #include <LibGUI/TextEditor.h>
+#include <LibThread/BackgroundAction.h>
+#include <string.h>
 
 namespace GUI {
 
+// Lexing starts out with this many lines past the change, and doubles that whenever it isn't enough.
+static constexpr size_t first_lex_chunk_line_count = 64;
+// Lexing more lines than this in one go moves to the ThreadPool.
+static constexpr size_t max_foreground_lex_line_count = 2000;
+
+template<typename T>
+static void replace_range(Vector<T>& vector, size_t first, size_t old_count, Vector<T>&& replacement)
+{
+    size_t end = first + old_count;
+    size_t old_size = vector.size();
+    if (replacement.size() > old_count) {
+        size_t growth = replacement.size() - old_count;
+        vector.resize(old_size + growth);
+        for (size_t i = old_size; i-- > end;)
+            vector[i + growth] = move(vector[i]);
+    } else if (replacement.size() < old_count) {
+        size_t shrinkage = old_count - replacement.size();
+        for (size_t i = end; i < old_size; ++i)
+            vector[i - shrinkage] = move(vector[i]);
+        vector.shrink(old_size - shrinkage);
+    }
+    for (size_t i = 0; i < replacement.size(); ++i)
+        vector[first + i] = move(replacement[i]);
+}
+
 SyntaxHighlighter::~SyntaxHighlighter()
 {
 }
@@ -135,21 +163,280 @@ void SyntaxHighlighter::detach()
 {
     ASSERT(m_editor);
     m_editor = nullptr;
+    forget_highlighted_lines();
+}
+
+void SyntaxHighlighter::restore_brace_buddies()
+{
+    if (!m_has_brace_buddies)
+        return;
+    auto& document = m_editor->document();
+    if (m_brace_buddies[0].index >= 0 && m_brace_buddies[0].index < static_cast<int>(document.spans().size()))
+        document.set_span_at_index(m_brace_buddies[0].index, m_brace_buddies[0].span_backup);
+    if (m_brace_buddies[1].index >= 0 && m_brace_buddies[1].index < static_cast<int>(document.spans().size()))
+        document.set_span_at_index(m_brace_buddies[1].index, m_brace_buddies[1].span_backup);
+    m_has_brace_buddies = false;
 }
 
 void SyntaxHighlighter::cursor_did_change()
 {
     ASSERT(m_editor);
-    auto& document = m_editor->document();
     if (m_has_brace_buddies) {
-        if (m_brace_buddies[0].index >= 0 && m_brace_buddies[0].index < static_cast<int>(document.spans().size()))
-            document.set_span_at_index(m_brace_buddies[0].index, m_brace_buddies[0].span_backup);
-        if (m_brace_buddies[1].index >= 0 && m_brace_buddies[1].index < static_cast<int>(document.spans().size()))
-            document.set_span_at_index(m_brace_buddies[1].index, m_brace_buddies[1].span_backup);
-        m_has_brace_buddies = false;
+        restore_brace_buddies();
         m_editor->update();
     }
     highlight_matching_token_pair();
 }
 
+void SyntaxHighlighter::forget_highlighted_lines()
+{
+    m_highlighted_document = nullptr;
+    m_highlighted_lines.clear();
+    m_line_is_resumable.clear();
+}
+
+void SyntaxHighlighter::restyle(Gfx::Palette palette)
+{
+    ASSERT(m_editor);
+    m_palette = palette;
+    restore_brace_buddies();
+    for (auto& span : m_editor->document().spans()) {
+        auto style = style_for_token(palette, span.data);
+        span.color = style.color;
+        span.font = style.font;
+    }
+    highlight_matching_token_pair();
+    m_editor->update();
+}
+
+void SyntaxHighlighter::rehighlight(Gfx::Palette palette)
+{
+    ASSERT(m_editor);
+    m_palette = palette;
+    if (m_is_lexing_in_background) {
+        m_needs_rehighlight = true;
+        return;
+    }
+
+    // Spans we didn't make, or that were dropped along with the old text, can't be built on.
+    auto& document = m_editor->document();
+    if (&document != m_highlighted_document || (!document.has_spans() && !m_highlighted_lines.is_empty()))
+        forget_highlighted_lines();
+
+    auto changed_lines = find_changed_lines();
+    if (!changed_lines.has_value())
+        return;
+
+    size_t start_line = find_resume_line(changed_lines.value());
+    size_t line_count = document.line_count();
+    LexedLines lexed;
+    size_t lex_start = start_line;
+    size_t chunk_line_count = first_lex_chunk_line_count;
+    for (;;) {
+        size_t end_line = min(line_count, max(changed_lines.value().new_end, lex_start) + chunk_line_count);
+        if (end_line - start_line > max_foreground_lex_line_count) {
+            lex_in_background(changed_lines.value(), start_line);
+            return;
+        }
+
+        auto chunk = lex_lines(lex_function(), text_of_lines(lex_start, end_line), lex_start, end_line - lex_start);
+        auto converged_line = find_converged_line(changed_lines.value(), lex_start, chunk, end_line == line_count);
+        // Keep what the rest of the text can't change anymore, and carry on from the last line we can start on.
+        size_t keep_end_line = converged_line.value_or(lex_start);
+        if (!converged_line.has_value()) {
+            for (size_t i = chunk.line_is_resumable.size(); i-- > 1;) {
+                if (chunk.line_is_resumable[i]) {
+                    keep_end_line = lex_start + i;
+                    break;
+                }
+            }
+        }
+        for (auto& span : chunk.spans) {
+            if (span.range.start().line() < keep_end_line)
+                lexed.spans.append(move(span));
+        }
+        for (size_t line = lex_start; line < keep_end_line; ++line)
+            lexed.line_is_resumable.append(chunk.line_is_resumable[line - lex_start]);
+
+        if (converged_line.has_value()) {
+            apply_lexed_lines(changed_lines.value(), start_line, converged_line.value(), move(lexed));
+            return;
+        }
+        lex_start = keep_end_line;
+        chunk_line_count *= 2;
+    }
+}
+
+Optional<SyntaxHighlighter::ChangedLines> SyntaxHighlighter::find_changed_lines() const
+{
+    auto& document = m_editor->document();
+    size_t old_line_count = m_highlighted_lines.size();
+    size_t new_line_count = document.line_count();
+    auto line_is_unchanged = [&](size_t old_line, size_t new_line) {
+        auto& old_text = m_highlighted_lines[old_line];
+        auto& line = document.line(new_line);
+        return old_text.size() == line.length() && (!line.length() || !memcmp(old_text.data(), line.codepoints(), line.length() * sizeof(u32)));
+    };
+
+    size_t common_line_count = min(old_line_count, new_line_count);
+    // The last line is the one without a line break after it, so it only stays the same while it stays the last.
+    size_t prefix_limit = common_line_count;
+    if (old_line_count != new_line_count && prefix_limit > 0)
+        --prefix_limit;
+    size_t first = 0;
+    while (first < prefix_limit && line_is_unchanged(first, first))
+        ++first;
+    if (first == common_line_count && old_line_count == new_line_count)
+        return {};
+    size_t unchanged_tail = 0;
+    while (unchanged_tail < common_line_count - first && line_is_unchanged(old_line_count - 1 - unchanged_tail, new_line_count - 1 - unchanged_tail))
+        ++unchanged_tail;
+    return ChangedLines { first, old_line_count - unchanged_tail, new_line_count - unchanged_tail };
+}
+
+size_t SyntaxHighlighter::find_resume_line(const ChangedLines& changed_lines) const
+{
+    if (m_line_is_resumable.is_empty())
+        return 0;
+    // Whether lexing can start on a line only depends on the lines above it, which are the same as last time.
+    size_t line = min(changed_lines.first, m_line_is_resumable.size() - 1);
+    while (line > 0 && !m_line_is_resumable[line])
+        --line;
+    return line;
+}
+
+Optional<size_t> SyntaxHighlighter::find_converged_line(const ChangedLines& changed_lines, size_t first_line, const LexedLines& lexed, bool reaches_end) const
+{
+    // Past the change, a line that lexing could start on both now and last time gets the same spans as last time,
+    // since the text from there on is the same.
+    for (size_t i = 1; i < lexed.line_is_resumable.size(); ++i) {
+        size_t line = first_line + i;
+        if (line < changed_lines.new_end || !lexed.line_is_resumable[i])
+            continue;
+        if (m_line_is_resumable[line - changed_lines.new_end + changed_lines.old_end])
+            return line;
+    }
+    if (reaches_end)
+        return first_line + lexed.line_is_resumable.size();
+    return {};
+}
+
+String SyntaxHighlighter::text_of_lines(size_t first_line, size_t end_line) const
+{
+    auto& document = m_editor->document();
+    StringBuilder builder;
+    for (size_t i = first_line; i < end_line; ++i) {
+        builder.append(document.line(i).view());
+        if (i + 1 < document.line_count())
+            builder.append('\n');
+    }
+    return builder.to_string();
+}
+
+SyntaxHighlighter::LexedLines SyntaxHighlighter::lex_lines(LexFunction lex, const String& text, size_t first_line, size_t line_count)
+{
+    LexedText lexed_text;
+    lex(text, lexed_text);
+
+    // In the lexer's own terms, which is bytes rather than codepoints.
+    Vector<size_t> line_lengths;
+    size_t line_start = 0;
+    for (size_t i = 0; i <= text.length(); ++i) {
+        if (i == text.length() || text[i] == '\n') {
+            line_lengths.append(i - line_start);
+            line_start = i + 1;
+        }
+    }
+
+    LexedLines lexed;
+    lexed.line_is_resumable.ensure_capacity(line_count);
+    for (size_t i = 0; i < line_count; ++i)
+        lexed.line_is_resumable.append(true);
+
+    for (auto& span : lexed_text.spans) {
+        auto start = span.range.start();
+        auto end = span.range.end();
+        if (end.line() <= start.line() || !span.is_skippable) {
+            // A token that takes in a line break runs on into the next line, even if nothing of it is left there.
+            size_t last_line = end.line() < line_lengths.size() && end.column() >= line_lengths[end.line()] ? end.line() + 1 : end.line();
+            for (size_t line = start.line() + 1; line <= last_line && line < line_count; ++line)
+                lexed.line_is_resumable[line] = false;
+            span.range.start().set_line(first_line + start.line());
+            span.range.end().set_line(first_line + end.line());
+            lexed.spans.append(move(span));
+            continue;
+        }
+        // Whitespace doesn't carry anything over to the next line, so it's cut up at line boundaries instead.
+        for (size_t line = start.line(); line <= end.line(); ++line) {
+            auto piece = span;
+            piece.range.set_start({ first_line + line, line == start.line() ? start.column() : 0 });
+            piece.range.set_end({ first_line + line, line == end.line() ? end.column() : line_lengths[line] });
+            lexed.spans.append(move(piece));
+        }
+    }
+    for (auto line : lexed_text.lines_continuing_state) {
+        if (line > 0 && line < line_count)
+            lexed.line_is_resumable[line] = false;
+    }
+    return lexed;
+}
+
+void SyntaxHighlighter::apply_lexed_lines(const ChangedLines& changed_lines, size_t start_line, size_t converged_line, LexedLines&& lexed)
+{
+    auto& document = m_editor->document();
+    size_t old_converged_line = converged_line - changed_lines.new_end + changed_lines.old_end;
+
+    for (auto& span : lexed.spans) {
+        auto style = style_for_token(m_palette.value(), span.data);
+        span.color = style.color;
+        span.font = style.font;
+    }
+    restore_brace_buddies();
+    document.replace_spans_on_lines(start_line, old_converged_line - start_line, converged_line - start_line, move(lexed.spans));
+
+    replace_range(m_line_is_resumable, start_line, old_converged_line - start_line, move(lexed.line_is_resumable));
+    Vector<Vector<u32>> changed_line_texts;
+    for (size_t i = changed_lines.first; i < changed_lines.new_end; ++i) {
+        auto& line = document.line(i);
+        Vector<u32> text;
+        text.append(line.codepoints(), line.length());
+        changed_line_texts.append(move(text));
+    }
+    replace_range(m_highlighted_lines, changed_lines.first, changed_lines.old_end - changed_lines.first, move(changed_line_texts));
+    m_highlighted_document = &document;
+
+    highlight_matching_token_pair();
+    m_editor->update();
+}
+
+void SyntaxHighlighter::lex_in_background(const ChangedLines& changed_lines, size_t start_line)
+{
+    m_is_lexing_in_background = true;
+    size_t line_count = m_editor->document().line_count() - start_line;
+    auto text = text_of_lines(start_line, start_line + line_count);
+    auto lex = lex_function();
+    auto weak_this = make_weak_ptr();
+    LibThread::BackgroundAction<LexedLines>::create(
+        [lex, text, start_line, line_count] {
+            return lex_lines(lex, text, start_line, line_count);
+        },
+        [this, weak_this, changed_lines, start_line](LexedLines lexed) {
+            if (!weak_this)
+                return;
+            m_is_lexing_in_background = false;
+            if (!m_editor)
+                return;
+            // The text changed while we were at it, so this is already out of date.
+            if (m_needs_rehighlight) {
+                m_needs_rehighlight = false;
+                rehighlight(m_palette.value());
+                return;
+            }
+            size_t converged_line = find_converged_line(changed_lines, start_line, lexed, true).value();
+            lexed.spans.remove_all_matching([&](auto& span) { return span.range.start().line() >= converged_line; });
+            lexed.line_is_resumable.shrink(converged_line - start_line);
+            apply_lexed_lines(changed_lines, start_line, converged_line, move(lexed));
+        });
+}
+
 }
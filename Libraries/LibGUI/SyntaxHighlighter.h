@@ -27,7 +27,9 @@
 #pragma once
 
 #include <AK/Noncopyable.h>
+#include <AK/Optional.h>
 #include <AK/WeakPtr.h>
+#include <AK/Weakable.h>
 #include <LibGUI/TextDocument.h>
 #include <LibGfx/Palette.h>
 
@@ -45,7 +47,7 @@ struct TextStyle {
     const Gfx::Font* font { nullptr };
 };
 
-class SyntaxHighlighter {
+class SyntaxHighlighter : public Weakable<SyntaxHighlighter> {
     AK_MAKE_NONCOPYABLE(SyntaxHighlighter);
     AK_MAKE_NONMOVABLE(SyntaxHighlighter);
 
@@ -53,7 +55,14 @@ public:
     virtual ~SyntaxHighlighter();
 
     virtual SyntaxLanguage language() const = 0;
-    virtual void rehighlight(Gfx::Palette) = 0;
+
+    // Brings the document's spans up to date with its text. Lexing picks up on the closest line before the first
+    // change that the lexer can start on from scratch, and stops as soon as it's back in step with what it found
+    // last time. Large stretches of text are lexed on the ThreadPool, keeping the old spans up until they're done.
+    void rehighlight(Gfx::Palette);
+    // Applies a new palette to the spans we already have.
+    void restyle(Gfx::Palette);
+
     virtual void highlight_matching_token_pair();
 
     virtual bool is_identifier(void*) const { return false; };
@@ -63,9 +72,24 @@ public:
     void detach();
     void cursor_did_change();
 
+    struct LexedText {
+        // Positions are relative to the start of the lexed text. Only the color and font are left for us to fill in.
+        Vector<TextDocumentSpan> spans;
+        // Lines that start with lexer state carried over from earlier ones, beyond a token running into them.
+        Vector<size_t> lines_continuing_state;
+    };
+
+    // Lexes text that begins at the start of a line with no lexer state carried over from the lines before it.
+    // Skippable spans may run across lines, and are split up at line boundaries afterwards.
+    // This runs on other threads as well, so it can't get at the highlighter.
+    using LexFunction = void (*)(const StringView& text, LexedText&);
+
 protected:
     SyntaxHighlighter() {}
 
+    virtual LexFunction lex_function() const = 0;
+    virtual TextStyle style_for_token(const Gfx::Palette&, void* token) const = 0;
+
     WeakPtr<TextEditor> m_editor;
 
     struct MatchingTokenPair {
@@ -83,6 +107,37 @@ protected:
 
     bool m_has_brace_buddies { false };
     BuddySpan m_brace_buddies[2];
+
+private:
+    struct ChangedLines {
+        size_t first;
+        size_t old_end;
+        size_t new_end;
+    };
+
+    struct LexedLines {
+        Vector<TextDocumentSpan> spans;
+        Vector<bool> line_is_resumable;
+    };
+
+    Optional<ChangedLines> find_changed_lines() const;
+    size_t find_resume_line(const ChangedLines&) const;
+    Optional<size_t> find_converged_line(const ChangedLines&, size_t first_line, const LexedLines&, bool reaches_end) const;
+    String text_of_lines(size_t first_line, size_t end_line) const;
+    static LexedLines lex_lines(LexFunction, const String& text, size_t first_line, size_t line_count);
+    void apply_lexed_lines(const ChangedLines&, size_t start_line, size_t converged_line, LexedLines&&);
+    void lex_in_background(const ChangedLines&, size_t start_line);
+    void restore_brace_buddies();
+    void forget_highlighted_lines();
+
+    Optional<Gfx::Palette> m_palette;
+    const TextDocument* m_highlighted_document { nullptr };
+    // The text of every line as of the last highlight, and whether lexing can start on it.
+    Vector<Vector<u32>> m_highlighted_lines;
+    Vector<bool> m_line_is_resumable;
+
+    bool m_is_lexing_in_background { false };
+    bool m_needs_rehighlight { false };
 };
 
 }
@@ -154,6 +154,76 @@ void TableView::paint_event(PaintEvent& event)
         paint_headers(painter);
 }
 
+void TableView::resize_event(ResizeEvent& event)
+{
+    AbstractTableView::resize_event(event);
+    update_column_sizes_for_visible_rows();
+}
+
+void TableView::did_scroll()
+{
+    AbstractTableView::did_scroll();
+    update_column_sizes_for_visible_rows();
+}
+
+void TableView::update_column_sizes_for_visible_rows()
+{
+    int first_row;
+    int last_row;
+    visible_row_range(first_row, last_row);
+    if (update_column_sizes_for_rows(first_row, last_row)) {
+        update_content_size();
+        update();
+    }
+}
+
+void TableView::did_insert_model_rows(const ModelIndex& parent, int first, int last)
+{
+    if (parent.is_valid())
+        return AbstractTableView::did_insert_model_rows(parent, first, last);
+    adjust_indexes_for_inserted_rows(parent, first, last);
+    update_column_sizes();
+    update_content_size();
+    update_edit_widget_position();
+    update();
+}
+
+void TableView::did_remove_model_rows(const ModelIndex& parent, int first, int last)
+{
+    if (parent.is_valid())
+        return AbstractTableView::did_remove_model_rows(parent, first, last);
+    adjust_indexes_for_removed_rows(parent, first, last);
+    update_column_sizes();
+    update_content_size();
+    update_edit_widget_position();
+    update();
+}
+
+void TableView::did_change_model_rows(const ModelIndex& parent, int first, int last)
+{
+    if (parent.is_valid())
+        return AbstractTableView::did_change_model_rows(parent, first, last);
+
+    // Only the rows on screen need measuring and repainting.
+    int first_visible_row;
+    int last_visible_row;
+    visible_row_range(first_visible_row, last_visible_row);
+    first = max(first, first_visible_row);
+    last = min(last, last_visible_row);
+    if (first > last)
+        return;
+
+    if (update_column_sizes_for_rows(first, last)) {
+        update_content_size();
+        update();
+        return;
+    }
+
+    auto rect = row_rect(first).united(row_rect(last));
+    rect.move_by(frame_thickness() - horizontal_scrollbar().value(), frame_thickness() - vertical_scrollbar().value());
+    update(rect.intersected(frame_inner_rect()));
+}
+
 void TableView::keydown_event(KeyEvent& event)
 {
     if (!model())
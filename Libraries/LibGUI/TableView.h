@@ -35,11 +35,21 @@ class TableView : public AbstractTableView {
 public:
     virtual ~TableView() override;
 
+    virtual void did_insert_model_rows(const ModelIndex& parent, int first, int last) override;
+    virtual void did_remove_model_rows(const ModelIndex& parent, int first, int last) override;
+    virtual void did_change_model_rows(const ModelIndex& parent, int first, int last) override;
+
 protected:
     TableView();
 
     virtual void keydown_event(KeyEvent&) override;
     virtual void paint_event(PaintEvent&) override;
+    virtual void resize_event(ResizeEvent&) override;
+    virtual void did_scroll() override;
+
+private:
+    // Fits the columns to rows that came into view, if any of them are wider than what's been seen so far.
+    void update_column_sizes_for_visible_rows();
 };
 
 }
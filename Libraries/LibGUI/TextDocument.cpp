@@ -30,10 +30,15 @@
 #include <LibCore/Timer.h>
 #include <LibGUI/TextDocument.h>
 #include <LibGUI/TextEditor.h>
+#include <LibThread/BackgroundAction.h>
 #include <ctype.h>
+#include <string.h>
 
 namespace GUI {
 
+// Enough to fill an editor right away, so it's split into lines before load_from_file() returns.
+static constexpr size_t first_loaded_byte_count = 64 * KB;
+
 NonnullRefPtr<TextDocument> TextDocument::create(Client* client)
 {
     return adopt(*new TextDocument(client));
@@ -61,6 +66,9 @@ void TextDocument::set_text(const StringView& text)
     m_client_notifications_enabled = false;
     m_spans.clear();
     remove_all_lines();
+    m_mapped_text = nullptr;
+    m_is_loading_lines = false;
+    ++m_text_serial;
 
     size_t start_of_current_line = 0;
 
@@ -84,6 +92,91 @@ void TextDocument::set_text(const StringView& text)
         client->document_did_set_text();
 }
 
+Vector<TextDocument::MappedLine> TextDocument::find_lines(const StringView& text, size_t start, size_t end)
+{
+    Vector<MappedLine> lines;
+    auto* characters = text.characters_without_null_termination();
+    for (size_t line_start = start;;) {
+        auto* newline = (const char*)memchr(characters + line_start, '\n', end - line_start);
+        size_t line_end = newline ? newline - characters : end;
+        auto line = text.substring_view(line_start, line_end - line_start);
+        lines.append({ line_start, line.length(), Utf8View(line).length_in_codepoints() });
+        // The last line is the one without a line break after it, which belongs to whoever finds the end of the text.
+        if (!newline || line_end + 1 == end)
+            break;
+        line_start = line_end + 1;
+    }
+    if (end == text.length() && text.length() && text[text.length() - 1] == '\n')
+        lines.append({ text.length(), 0, 0 });
+    return lines;
+}
+
+void TextDocument::append_mapped_lines(const Vector<MappedLine>& mapped_lines)
+{
+    auto text = m_mapped_text->text();
+    m_lines.ensure_capacity(m_lines.size() + mapped_lines.size());
+    for (auto& mapped_line : mapped_lines)
+        m_lines.append(make<TextDocumentLine>(text.substring_view(mapped_line.offset, mapped_line.byte_length), mapped_line.length));
+}
+
+bool TextDocument::load_from_file(const StringView& path)
+{
+    auto mapped_text = adopt(*new MappedText(path));
+    // mmap() refuses empty files, which are as good as loaded.
+    if (!mapped_text->file.is_valid() && mapped_text->file.size())
+        return false;
+
+    m_client_notifications_enabled = false;
+    m_spans.clear();
+    remove_all_lines();
+    m_mapped_text = mapped_text;
+    auto serial = ++m_text_serial;
+
+    auto text = mapped_text->text();
+    size_t first_end = text.length();
+    if (text.length() > first_loaded_byte_count) {
+        if (auto* newline = (const char*)memchr(text.characters_without_null_termination() + first_loaded_byte_count, '\n', text.length() - first_loaded_byte_count))
+            first_end = newline - text.characters_without_null_termination() + 1;
+    }
+    if (text.is_empty())
+        append_line(make<TextDocumentLine>(*this));
+    else
+        append_mapped_lines(find_lines(text, 0, first_end));
+    m_client_notifications_enabled = true;
+
+    for (auto* client : m_clients)
+        client->document_did_set_text();
+
+    m_is_loading_lines = first_end < text.length();
+    if (!m_is_loading_lines)
+        return true;
+
+    // The action holds on to the mapping and to us until it's done, even if we've moved on to some other text.
+    NonnullRefPtr<TextDocument> protector(*this);
+    LibThread::BackgroundAction<Vector<MappedLine>>::create(
+        [mapped_text, first_end] {
+            auto text = mapped_text->text();
+            return find_lines(text, first_end, text.length());
+        },
+        [this, protector, serial](auto mapped_lines) {
+            if (serial != m_text_serial)
+                return;
+            m_is_loading_lines = false;
+            append_mapped_lines(mapped_lines);
+            for (auto* client : m_clients)
+                client->document_did_append_lines(mapped_lines.size());
+        });
+    return true;
+}
+
+void TextDocument::decode_all_lines()
+{
+    for (auto& line : m_lines)
+        line.decode_if_needed();
+    if (!m_is_loading_lines)
+        m_mapped_text = nullptr;
+}
+
 size_t TextDocumentLine::first_non_whitespace_column() const
 {
     for (size_t i = 0; i < length(); ++i) {
@@ -96,6 +189,8 @@ size_t TextDocumentLine::first_non_whitespace_column() const
 
 String TextDocumentLine::to_utf8() const
 {
+    if (!m_is_decoded)
+        return m_utf8_text;
     StringBuilder builder;
     builder.append(view());
     return builder.to_string();
@@ -111,14 +206,35 @@ TextDocumentLine::TextDocumentLine(TextDocument& document, const StringView& tex
     set_text(document, text);
 }
 
+TextDocumentLine::TextDocumentLine(const StringView& utf8_text, size_t length)
+    : m_utf8_text(utf8_text)
+    , m_utf8_length(length)
+    , m_is_decoded(false)
+{
+}
+
+void TextDocumentLine::decode_if_needed() const
+{
+    if (m_is_decoded)
+        return;
+    m_text.resize(m_utf8_length);
+    Utf8View(m_utf8_text).decode_to_utf32(m_text.data());
+    m_utf8_text = {};
+    m_is_decoded = true;
+}
+
 void TextDocumentLine::clear(TextDocument& document)
 {
+    m_utf8_text = {};
+    m_is_decoded = true;
     m_text.clear();
     document.update_views({});
 }
 
 void TextDocumentLine::set_text(TextDocument& document, const Vector<u32> text)
 {
+    m_utf8_text = {};
+    m_is_decoded = true;
     m_text = move(text);
     document.update_views({});
 }
@@ -129,10 +245,11 @@ void TextDocumentLine::set_text(TextDocument& document, const StringView& text)
         clear(document);
         return;
     }
-    m_text.clear();
     Utf8View utf8_view(text);
-    for (auto codepoint : utf8_view)
-        m_text.append(codepoint);
+    m_utf8_text = {};
+    m_is_decoded = true;
+    m_text.resize(utf8_view.length_in_codepoints());
+    utf8_view.decode_to_utf32(m_text.data());
     document.update_views({});
 }
 
@@ -140,6 +257,7 @@ void TextDocumentLine::append(TextDocument& document, const u32* codepoints, siz
 {
     if (length == 0)
         return;
+    decode_if_needed();
     m_text.append(codepoints, length);
     document.update_views({});
 }
@@ -156,6 +274,7 @@ void TextDocumentLine::prepend(TextDocument& document, u32 codepoint)
 
 void TextDocumentLine::insert(TextDocument& document, size_t index, u32 codepoint)
 {
+    decode_if_needed();
     if (index == length()) {
         m_text.append(codepoint);
     } else {
@@ -166,6 +285,7 @@ void TextDocumentLine::insert(TextDocument& document, size_t index, u32 codepoin
 
 void TextDocumentLine::remove(TextDocument& document, size_t index)
 {
+    decode_if_needed();
     if (index == length()) {
         m_text.take_last();
     } else {
@@ -176,6 +296,7 @@ void TextDocumentLine::remove(TextDocument& document, size_t index)
 
 void TextDocumentLine::remove_range(TextDocument& document, size_t start, size_t length)
 {
+    decode_if_needed();
     ASSERT(length <= m_text.size());
 
     Vector<u32> new_data;
@@ -190,6 +311,7 @@ void TextDocumentLine::remove_range(TextDocument& document, size_t start, size_t
 
 void TextDocumentLine::truncate(TextDocument& document, size_t length)
 {
+    decode_if_needed();
     m_text.resize(length);
     document.update_views({});
 }
@@ -399,6 +521,50 @@ Vector<TextRange> TextDocument::find_all(const StringView& needle) const
     return ranges;
 }
 
+void TextDocument::replace_spans_on_lines(size_t first_line, size_t old_line_count, size_t new_line_count, Vector<TextDocumentSpan>&& spans)
+{
+    auto first_span_starting_on_or_after = [&](size_t line) {
+        size_t low = 0;
+        size_t high = m_spans.size();
+        while (low < high) {
+            size_t middle = low + (high - low) / 2;
+            if (m_spans[middle].range.start().line() < line)
+                low = middle + 1;
+            else
+                high = middle;
+        }
+        return low;
+    };
+
+    size_t first = first_span_starting_on_or_after(first_line);
+    size_t end = first_span_starting_on_or_after(first_line + old_line_count);
+    size_t old_span_count = end - first;
+    size_t old_size = m_spans.size();
+
+    if (spans.size() > old_span_count) {
+        size_t growth = spans.size() - old_span_count;
+        m_spans.resize(old_size + growth);
+        for (size_t i = old_size; i-- > end;)
+            m_spans[i + growth] = move(m_spans[i]);
+    } else if (spans.size() < old_span_count) {
+        size_t shrinkage = old_span_count - spans.size();
+        for (size_t i = end; i < old_size; ++i)
+            m_spans[i - shrinkage] = move(m_spans[i]);
+        m_spans.shrink(old_size - shrinkage);
+    }
+
+    for (size_t i = 0; i < spans.size(); ++i)
+        m_spans[first + i] = move(spans[i]);
+
+    if (new_line_count == old_line_count)
+        return;
+    for (size_t i = first + spans.size(); i < m_spans.size(); ++i) {
+        auto& range = m_spans[i].range;
+        range.start().set_line(range.start().line() + new_line_count - old_line_count);
+        range.end().set_line(range.end().line() + new_line_count - old_line_count);
+    }
+}
+
 Optional<TextDocumentSpan> TextDocument::first_non_skippable_span_before(const TextPosition& position) const
 {
     for (int i = m_spans.size() - 1; i >= 0; --i) {
@@ -27,11 +27,13 @@
 #pragma once
 
 #include <AK/HashTable.h>
+#include <AK/MappedFile.h>
 #include <AK/NonnullOwnPtrVector.h>
 #include <AK/NonnullRefPtr.h>
 #include <AK/Optional.h>
 #include <AK/RefCounted.h>
 #include <AK/Utf32View.h>
+#include <AK/Utf8View.h>
 #include <LibCore/Forward.h>
 #include <LibGUI/Command.h>
 #include <LibGUI/Forward.h>
@@ -63,6 +65,7 @@ public:
     public:
         virtual ~Client();
         virtual void document_did_append_line() = 0;
+        virtual void document_did_append_lines(size_t count) = 0;
         virtual void document_did_insert_line(size_t) = 0;
         virtual void document_did_remove_line(size_t) = 0;
         virtual void document_did_remove_all_lines() = 0;
@@ -84,6 +87,13 @@ public:
     void set_spans(const Vector<TextDocumentSpan>& spans) { m_spans = spans; }
 
     void set_text(const StringView&);
+    // Shows the file without reading it in: lines keep pointing into a mapping of the file until they're changed or
+    // looked at codepoint by codepoint. Only the start of the file is split into lines right away, the rest of it
+    // is done on the ThreadPool and appended when it's ready.
+    bool load_from_file(const StringView& path);
+    bool is_loading_lines() const { return m_is_loading_lines; }
+    // Lets go of the file that lines were loaded from, so that it can be overwritten.
+    void decode_all_lines();
 
     const NonnullOwnPtrVector<TextDocumentLine>& lines() const { return m_lines; }
     NonnullOwnPtrVector<TextDocumentLine>& lines() { return m_lines; }
@@ -92,6 +102,9 @@ public:
     Vector<TextDocumentSpan>& spans() { return m_spans; }
     const Vector<TextDocumentSpan>& spans() const { return m_spans; }
     void set_span_at_index(size_t index, TextDocumentSpan span) { m_spans[index] = move(span); }
+    // Replaces the spans starting on lines [first_line, first_line + old_line_count) with `spans`, which cover
+    // new_line_count lines from first_line on, and moves the spans after them along by the difference.
+    void replace_spans_on_lines(size_t first_line, size_t old_line_count, size_t new_line_count, Vector<TextDocumentSpan>&& spans);
 
     void append_line(NonnullOwnPtr<TextDocumentLine>);
     void remove_line(size_t line_index);
@@ -142,6 +155,31 @@ private:
 
     void update_undo_timer();
 
+    struct MappedText : public RefCounted<MappedText> {
+        explicit MappedText(const StringView& path)
+            : file(path)
+        {
+        }
+
+        StringView text() const { return { (const char*)file.data(), file.size() }; }
+
+        MappedFile file;
+    };
+
+    struct MappedLine {
+        size_t offset;
+        size_t byte_length;
+        size_t length;
+    };
+
+    static Vector<MappedLine> find_lines(const StringView& text, size_t start, size_t end);
+    void append_mapped_lines(const Vector<MappedLine>&);
+
+    // Declared ahead of the lines, which may point into it.
+    RefPtr<MappedText> m_mapped_text;
+    u32 m_text_serial { 0 };
+    bool m_is_loading_lines { false };
+
     NonnullOwnPtrVector<TextDocumentLine> m_lines;
     Vector<TextDocumentSpan> m_spans;
 
@@ -156,12 +194,34 @@ class TextDocumentLine {
 public:
     explicit TextDocumentLine(TextDocument&);
     explicit TextDocumentLine(TextDocument&, const StringView&);
+    // Leaves the UTF-8 text, which has to outlive the line, as it is until its codepoints are needed.
+    TextDocumentLine(const StringView& utf8_text, size_t length);
 
     String to_utf8() const;
 
     Utf32View view() const { return { codepoints(), length() }; }
-    const u32* codepoints() const { return m_text.data(); }
-    size_t length() const { return m_text.size(); }
+    const u32* codepoints() const
+    {
+        decode_if_needed();
+        return m_text.data();
+    }
+    size_t length() const { return m_is_decoded ? m_text.size() : m_utf8_length; }
+    bool is_decoded() const { return m_is_decoded; }
+    const StringView& undecoded_text() const { return m_utf8_text; }
+    void decode_if_needed() const;
+
+    template<typename Callback>
+    void for_each_codepoint(Callback callback) const
+    {
+        if (!m_is_decoded) {
+            for (auto codepoint : Utf8View(m_utf8_text))
+                callback(codepoint);
+            return;
+        }
+        for (auto codepoint : m_text)
+            callback(codepoint);
+    }
+
     void set_text(TextDocument&, const StringView&);
     void set_text(TextDocument&, Vector<u32>);
     void append(TextDocument&, u32);
@@ -177,7 +237,10 @@ public:
 
 private:
     // NOTE: This vector is null terminated.
-    Vector<u32> m_text;
+    mutable Vector<u32> m_text;
+    mutable StringView m_utf8_text;
+    size_t m_utf8_length { 0 };
+    mutable bool m_is_decoded { true };
 };
 
 class TextDocumentUndoCommand : public Command {
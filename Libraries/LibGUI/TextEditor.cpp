@@ -42,6 +42,7 @@
 #include <LibGfx/Font.h>
 #include <LibGfx/Palette.h>
 #include <ctype.h>
+#include <errno.h>
 #include <fcntl.h>
 #include <stdio.h>
 #include <unistd.h>
@@ -106,9 +107,21 @@ void TextEditor::create_actions()
 void TextEditor::set_text(const StringView& text)
 {
     m_selection.clear();
-
     document().set_text(text);
+    did_replace_text();
+}
+
+bool TextEditor::load_from_file(const StringView& path)
+{
+    m_selection.clear();
+    if (!document().load_from_file(path))
+        return false;
+    did_replace_text();
+    return true;
+}
 
+void TextEditor::did_replace_text()
+{
     update_content_size();
     recompute_all_visual_lines();
     if (is_single_line())
@@ -1111,6 +1124,13 @@ void TextEditor::timer_event(Core::TimerEvent&)
 
 bool TextEditor::write_to_file(const StringView& path)
 {
+    // Lines that are still being loaded, or left undecoded, come from a file that may well be the one we're about to truncate.
+    if (document().is_loading_lines()) {
+        errno = EBUSY;
+        return false;
+    }
+    document().decode_all_lines();
+
     int fd = open_with_path_length(path.characters_without_null_termination(), path.length(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
     if (fd < 0) {
         perror("open");
@@ -1356,7 +1376,7 @@ void TextEditor::theme_change_event(ThemeChangeEvent& event)
 {
     ScrollableWidget::theme_change_event(event);
     if (m_highlighter)
-        m_highlighter->rehighlight(palette());
+        m_highlighter->restyle(palette());
 }
 
 void TextEditor::set_selection(const TextRange& selection)
@@ -1430,16 +1450,17 @@ void TextEditor::recompute_visual_lines(size_t line_index)
         int line_width_so_far = 0;
 
         auto glyph_spacing = font().glyph_spacing();
-        for (size_t i = 0; i < line.length(); ++i) {
-            auto codepoint = line.codepoints()[i];
+        size_t i = 0;
+        line.for_each_codepoint([&](u32 codepoint) {
             auto glyph_width = font().glyph_or_emoji_width(codepoint);
             if ((line_width_so_far + glyph_width + glyph_spacing) > available_width) {
-                visual_data.visual_line_breaks.append(i);
+                visual_data.visual_line_breaks.append(i++);
                 line_width_so_far = glyph_width + glyph_spacing;
-                continue;
+                return;
             }
             line_width_so_far += glyph_width + glyph_spacing;
-        }
+            ++i;
+        });
     }
 
     visual_data.visual_line_breaks.append(line.length());
@@ -1447,7 +1468,7 @@ void TextEditor::recompute_visual_lines(size_t line_index)
     if (is_line_wrapping_enabled())
         visual_data.visual_rect = { m_horizontal_content_padding, 0, available_width, static_cast<int>(visual_data.visual_line_breaks.size()) * line_height() };
     else
-        visual_data.visual_rect = { m_horizontal_content_padding, 0, font().width(line.view()), line_height() };
+        visual_data.visual_rect = { m_horizontal_content_padding, 0, line.is_decoded() ? font().width(line.view()) : font().width(line.undecoded_text()), line_height() };
 }
 
 template<typename Callback>
@@ -1511,6 +1532,16 @@ void TextEditor::document_did_append_line()
     update();
 }
 
+void TextEditor::document_did_append_lines(size_t count)
+{
+    m_line_visual_data.ensure_capacity(m_line_visual_data.size() + count);
+    for (size_t i = 0; i < count; ++i)
+        m_line_visual_data.append(make<LineVisualData>());
+    update_content_size();
+    recompute_all_visual_lines();
+    update();
+}
+
 void TextEditor::document_did_remove_line(size_t line_index)
 {
     m_line_visual_data.remove(line_index);
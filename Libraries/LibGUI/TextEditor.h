@@ -88,6 +88,7 @@ public:
 
     void insert_at_cursor_or_replace_selection(const StringView&);
     bool write_to_file(const StringView& path);
+    bool load_from_file(const StringView& path);
     bool has_selection() const { return m_selection.is_valid(); }
     String selected_text() const;
     void set_selection(const TextRange&);
@@ -161,6 +162,7 @@ private:
 
     // ^TextDocument::Client
     virtual void document_did_append_line() override;
+    virtual void document_did_append_lines(size_t count) override;
     virtual void document_did_insert_line(size_t) override;
     virtual void document_did_remove_line(size_t) override;
     virtual void document_did_remove_all_lines() override;
@@ -211,6 +213,7 @@ private:
     Gfx::Rect ruler_rect_in_inner_coordinates() const;
     Gfx::Rect visible_text_rect_in_inner_coordinates() const;
     void recompute_all_visual_lines();
+    void did_replace_text();
     void ensure_cursor_is_valid();
     void flush_pending_change_notification_if_needed();
     void get_selection_line_boundaries(size_t& first_line, size_t& last_line);
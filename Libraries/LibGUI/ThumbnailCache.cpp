@@ -0,0 +1,181 @@
+/*
+ * Copyright (c) 2018-2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/ByteBuffer.h>
+#include <LibCore/File.h>
+#include <LibCore/StandardPaths.h>
+#include <LibGUI/Painter.h>
+#include <LibGUI/ThumbnailCache.h>
+#include <LibGfx/Bitmap.h>
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace GUI {
+
+static constexpr u32 thumbnail_magic = 0x424d4854; // "THMB"
+static constexpr u32 thumbnail_version = 1;
+
+// An entry on disk is this header, the image's path, and then the thumbnail's RGBA32 pixels, row by row.
+struct [[gnu::packed]] ThumbnailHeader {
+    u32 magic;
+    u32 version;
+    i64 image_mtime;
+    i64 image_size;
+    u32 path_length;
+};
+
+static constexpr size_t thumbnail_data_size = ThumbnailCache::thumbnail_size * ThumbnailCache::thumbnail_size * sizeof(Gfx::RGBA32);
+
+static String cache_directory()
+{
+    return String::format("%s/.cache/thumbnails", Core::StandardPaths::home_directory().characters());
+}
+
+static String cache_path_for(const String& path)
+{
+    return String::format("%s/%08x", cache_directory().characters(), path.hash());
+}
+
+static RefPtr<Gfx::Bitmap> load_from_cache(const String& path, const struct stat& image_stat)
+{
+    auto file_or_error = Core::File::open(cache_path_for(path), Core::IODevice::ReadOnly);
+    if (file_or_error.is_error())
+        return nullptr;
+    auto contents = file_or_error.value()->read_all();
+
+    ThumbnailHeader header;
+    if (contents.size() < sizeof(header))
+        return nullptr;
+    memcpy(&header, contents.data(), sizeof(header));
+    if (header.magic != thumbnail_magic || header.version != thumbnail_version)
+        return nullptr;
+    if (header.image_mtime != image_stat.st_mtime || header.image_size != image_stat.st_size)
+        return nullptr;
+    if (contents.size() != sizeof(header) + header.path_length + thumbnail_data_size)
+        return nullptr;
+    // Different paths may hash to the same file name.
+    if (StringView(contents.data() + sizeof(header), header.path_length) != path)
+        return nullptr;
+
+    auto thumbnail = Gfx::Bitmap::create(Gfx::BitmapFormat::RGBA32, { ThumbnailCache::thumbnail_size, ThumbnailCache::thumbnail_size });
+    if (!thumbnail)
+        return nullptr;
+    auto* pixels = contents.data() + sizeof(header) + header.path_length;
+    size_t row_size = ThumbnailCache::thumbnail_size * sizeof(Gfx::RGBA32);
+    for (int y = 0; y < ThumbnailCache::thumbnail_size; ++y)
+        memcpy(thumbnail->scanline(y), pixels + y * row_size, row_size);
+    return thumbnail;
+}
+
+static void save_to_cache(const String& path, const struct stat& image_stat, const Gfx::Bitmap& thumbnail)
+{
+    ASSERT(thumbnail.format() == Gfx::BitmapFormat::RGBA32);
+    ASSERT(thumbnail.width() == ThumbnailCache::thumbnail_size && thumbnail.height() == ThumbnailCache::thumbnail_size);
+
+    auto parent_directory = String::format("%s/.cache", Core::StandardPaths::home_directory().characters());
+    if (mkdir(parent_directory.characters(), 0700) < 0 && errno != EEXIST) {
+        perror("mkdir");
+        return;
+    }
+    if (mkdir(cache_directory().characters(), 0700) < 0 && errno != EEXIST) {
+        perror("mkdir");
+        return;
+    }
+
+    ThumbnailHeader header;
+    header.magic = thumbnail_magic;
+    header.version = thumbnail_version;
+    header.image_mtime = image_stat.st_mtime;
+    header.image_size = image_stat.st_size;
+    header.path_length = path.length();
+
+    // Write a file of our own and move it into place, since another program may be reading or writing the same entry.
+    auto cache_path = cache_path_for(path);
+    auto temporary_path = String::format("%s.%d", cache_path.characters(), getpid());
+    {
+        auto file_or_error = Core::File::open(temporary_path, (Core::IODevice::OpenMode)(Core::IODevice::WriteOnly | Core::IODevice::Truncate), 0600);
+        if (file_or_error.is_error()) {
+            dbg() << "ThumbnailCache: Failed to write thumbnail for " << path << ": " << file_or_error.error();
+            return;
+        }
+        auto& file = *file_or_error.value();
+        file.write((const u8*)&header, sizeof(header));
+        file.write(path);
+        for (int y = 0; y < thumbnail.height(); ++y)
+            file.write((const u8*)thumbnail.scanline(y), thumbnail.width() * sizeof(Gfx::RGBA32));
+    }
+    if (rename(temporary_path.characters(), cache_path.characters()) < 0) {
+        perror("rename");
+        unlink(temporary_path.characters());
+    }
+}
+
+NonnullRefPtr<Gfx::Bitmap> ThumbnailCache::render_thumbnail(const Gfx::Bitmap& image)
+{
+    double scale = min(thumbnail_size / (double)image.width(), thumbnail_size / (double)image.height());
+
+    auto thumbnail = Gfx::Bitmap::create(Gfx::BitmapFormat::RGBA32, { thumbnail_size, thumbnail_size });
+    ASSERT(thumbnail);
+    thumbnail->fill(Color(0, 0, 0, 0));
+    Gfx::Rect destination = Gfx::Rect(0, 0, (int)(image.width() * scale), (int)(image.height() * scale));
+    destination.center_within(thumbnail->rect());
+
+    Painter painter(*thumbnail);
+    painter.draw_scaled_bitmap(destination, image, image.rect());
+    return thumbnail.release_nonnull();
+}
+
+RefPtr<Gfx::Bitmap> ThumbnailCache::thumbnail_for(const String& path)
+{
+    struct stat image_stat;
+    if (stat(path.characters(), &image_stat) < 0)
+        return nullptr;
+
+    if (auto thumbnail = load_from_cache(path, image_stat))
+        return thumbnail;
+
+    auto image = Gfx::Bitmap::load_from_file(path);
+    if (!image)
+        return nullptr;
+    auto thumbnail = render_thumbnail(*image);
+    save_to_cache(path, image_stat, thumbnail);
+    return thumbnail;
+}
+
+void ThumbnailCache::did_load_image(const String& path, const Gfx::Bitmap& image)
+{
+    struct stat image_stat;
+    if (stat(path.characters(), &image_stat) < 0)
+        return;
+    if (load_from_cache(path, image_stat))
+        return;
+    save_to_cache(path, image_stat, render_thumbnail(image));
+}
+
+}
@@ -224,6 +224,9 @@ void TreeView::paint_event(PaintEvent& event)
     int painted_row_index = 0;
 
     traverse_in_paint_order([&](const ModelIndex& index, const Gfx::Rect& a_rect, const Gfx::Rect& a_toggle_rect, int indent_level) {
+        // Rows come in order from top to bottom, so nothing after the first one below the view is visible either.
+        if (a_rect.top() > visible_content_rect.bottom())
+            return IterationDecision::Break;
         if (!a_rect.intersects_vertically(visible_content_rect))
             return IterationDecision::Continue;
 
@@ -45,6 +45,7 @@
 #include <LibGUI/Window.h>
 #include <LibGUI/WindowServerConnection.h>
 #include <LibGfx/Bitmap.h>
+#include <LibGfx/DisplayList.h>
 #include <LibGfx/Font.h>
 #include <LibGfx/Palette.h>
 #include <unistd.h>
@@ -209,6 +210,7 @@ void Widget::event(Core::Event& event)
     case Event::Drop:
         return drop_event(static_cast<DropEvent&>(event));
     case Event::ThemeChange:
+        m_display_list = nullptr;
         return theme_change_event(static_cast<ThemeChangeEvent&>(event));
     case Event::Enter:
         return handle_enter_event(event);
@@ -228,7 +230,10 @@ void Widget::handle_paint_event(PaintEvent& event)
         Painter painter(*this);
         painter.fill_rect(event.rect(), palette().color(background_role()));
     }
-    paint_event(event);
+    if (m_retains_display_list)
+        paint_with_display_list(event);
+    else
+        paint_event(event);
     for_each_child_widget([&](auto& child) {
         if (!child.is_visible())
             return IterationDecision::Continue;
@@ -253,6 +258,37 @@ void Widget::handle_paint_event(PaintEvent& event)
     }
 }
 
+void Widget::paint_with_display_list(PaintEvent& event)
+{
+    auto window_rect = window_relative_rect();
+    if (!m_display_list || m_display_list_window_rect != window_rect) {
+        // The whole widget is recorded, so the list can be replayed for whatever part of it needs painting later.
+        m_display_list = make<Gfx::DisplayList>();
+        m_display_list_window_rect = window_rect;
+        m_recording_display_list = true;
+        PaintEvent recording_event(rect());
+        paint_event(recording_event);
+        m_recording_display_list = false;
+        if (!m_display_list->is_complete()) {
+            dbg() << *this << " painted something that can't be recorded, so it won't retain a display list";
+            set_retains_display_list(false);
+            paint_event(event);
+            return;
+        }
+    }
+
+    Painter painter(*this);
+    painter.add_clip_rect(event.rect());
+    m_display_list->replay(painter);
+}
+
+void Widget::set_retains_display_list(bool retains_display_list)
+{
+    m_retains_display_list = retains_display_list;
+    if (!retains_display_list)
+        m_display_list = nullptr;
+}
+
 void Widget::set_layout(NonnullRefPtr<Layout> layout)
 {
     if (m_layout) {
@@ -434,6 +470,9 @@ void Widget::update()
 
 void Widget::update(const Gfx::Rect& rect)
 {
+    if (!m_recording_display_list)
+        m_display_list = nullptr;
+
     if (!is_visible())
         return;
 
@@ -26,6 +26,7 @@
 
 #pragma once
 
+#include <AK/OwnPtr.h>
 #include <AK/String.h>
 #include <LibCore/Object.h>
 #include <LibGUI/Event.h>
@@ -275,6 +276,16 @@ public:
     void set_accepts_emoji_input(bool b) { m_accepts_emoji_input = b; }
     bool accepts_emoji_input() const { return m_accepts_emoji_input; }
 
+    // Records what paint_event() draws the first time it runs, and replays that from then on until the widget
+    // is updated or moved, so repainting it for the sake of others (like an overlapping window going away)
+    // doesn't run its paint code. Only suitable for widgets whose painting depends on nothing but their own state,
+    // and that call update() whenever it changes.
+    void set_retains_display_list(bool);
+    bool retains_display_list() const { return m_retains_display_list; }
+
+    // While paint_event() is being recorded, Painters created for this widget record into this.
+    Gfx::DisplayList* display_list_being_recorded() { return m_recording_display_list ? m_display_list.ptr() : nullptr; }
+
 protected:
     Widget();
 
@@ -310,6 +321,7 @@ protected:
 
 private:
     void handle_paint_event(PaintEvent&);
+    void paint_with_display_list(PaintEvent&);
     void handle_resize_event(ResizeEvent&);
     void handle_mousedown_event(MouseEvent&);
     void handle_mousedoubleclick_event(MouseEvent&);
@@ -342,6 +354,12 @@ private:
     bool m_updates_enabled { true };
     bool m_accepts_emoji_input { false };
 
+    bool m_retains_display_list { false };
+    bool m_recording_display_list { false };
+    OwnPtr<Gfx::DisplayList> m_display_list;
+    // Where in the window the display list was recorded; the recorded coordinates are only good there.
+    Gfx::Rect m_display_list_window_rect;
+
     NonnullRefPtr<Gfx::PaletteImpl> m_palette;
 };
 
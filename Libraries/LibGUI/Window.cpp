@@ -82,7 +82,7 @@ void Window::move_to_front()
     if (!is_visible())
         return;
 
-    WindowServerConnection::the().send_sync<Messages::WindowServer::MoveWindowToFront>(m_window_id);
+    WindowServerConnection::the().send_async<Messages::WindowServer::MoveWindowToFront>(m_window_id);
 }
 
 void Window::show()
@@ -166,7 +166,7 @@ void Window::set_title(const StringView& title)
     m_title_when_windowless = title;
     if (!is_visible())
         return;
-    WindowServerConnection::the().send_sync<Messages::WindowServer::SetWindowTitle>(m_window_id, title);
+    WindowServerConnection::the().send_async<Messages::WindowServer::SetWindowTitle>(m_window_id, title);
 }
 
 String Window::title() const
@@ -211,7 +211,7 @@ void Window::set_override_cursor(StandardCursor cursor)
         return;
     if (!m_custom_cursor && m_override_cursor == cursor)
         return;
-    WindowServerConnection::the().send_sync<Messages::WindowServer::SetWindowOverrideCursor>(m_window_id, (u32)cursor);
+    WindowServerConnection::the().send_async<Messages::WindowServer::SetWindowOverrideCursor>(m_window_id, (u32)cursor);
     m_override_cursor = cursor;
     m_custom_cursor = nullptr;
 }
@@ -305,12 +305,13 @@ void Window::event(Core::Event& event)
         for (auto& rect : rects)
             m_main_widget->dispatch_event(*make<PaintEvent>(rect), this);
 
-        if (m_double_buffering_enabled)
+        // Handing over a backing store carries the damage along with it, so the server only recomposes
+        // what was painted, and doesn't need a separate DidFinishPainting.
+        if (m_double_buffering_enabled) {
             flip(rects);
-        else if (created_new_backing_store)
-            set_current_backing_bitmap(*m_back_bitmap, true);
-
-        if (is_visible()) {
+        } else if (created_new_backing_store) {
+            set_current_backing_bitmap(*m_back_bitmap, rects);
+        } else {
             Vector<Gfx::Rect> rects_to_send;
             for (auto& r : rects)
                 rects_to_send.append(r);
@@ -521,7 +522,7 @@ void Window::set_opacity(float opacity)
     m_opacity_when_windowless = opacity;
     if (!is_visible())
         return;
-    WindowServerConnection::the().send_sync<Messages::WindowServer::SetWindowOpacity>(m_window_id, opacity);
+    WindowServerConnection::the().send_async<Messages::WindowServer::SetWindowOpacity>(m_window_id, opacity);
 }
 
 void Window::set_hovered_widget(Widget* widget)
@@ -538,16 +539,19 @@ void Window::set_hovered_widget(Widget* widget)
         Core::EventLoop::current().post_event(*m_hovered_widget, make<Event>(Event::Enter));
 }
 
-void Window::set_current_backing_bitmap(Gfx::Bitmap& bitmap, bool flush_immediately)
+void Window::set_current_backing_bitmap(Gfx::Bitmap& bitmap, const Vector<Gfx::Rect, 32>& dirty_rects)
 {
-    WindowServerConnection::the().send_sync<Messages::WindowServer::SetWindowBackingStore>(m_window_id, 32, bitmap.pitch(), bitmap.shbuf_id(), bitmap.has_alpha_channel(), bitmap.size(), flush_immediately);
+    Vector<Gfx::Rect> rects_to_send;
+    for (auto& rect : dirty_rects)
+        rects_to_send.append(rect);
+    WindowServerConnection::the().send_sync<Messages::WindowServer::SetWindowBackingStore>(m_window_id, 32, bitmap.pitch(), bitmap.shbuf_id(), bitmap.has_alpha_channel(), bitmap.size(), rects_to_send);
 }
 
 void Window::flip(const Vector<Gfx::Rect, 32>& dirty_rects)
 {
     swap(m_front_bitmap, m_back_bitmap);
 
-    set_current_backing_bitmap(*m_front_bitmap);
+    set_current_backing_bitmap(*m_front_bitmap, dirty_rects);
 
     if (!m_back_bitmap || m_back_bitmap->size() != m_front_bitmap->size()) {
         m_back_bitmap = create_backing_bitmap(m_front_bitmap->size());
@@ -749,7 +753,7 @@ void Window::set_base_size(const Gfx::Size& base_size)
         return;
     m_base_size = base_size;
     if (is_visible())
-        WindowServerConnection::the().send_sync<Messages::WindowServer::SetWindowBaseSizeAndSizeIncrement>(m_window_id, m_base_size, m_size_increment);
+        WindowServerConnection::the().send_async<Messages::WindowServer::SetWindowBaseSizeAndSizeIncrement>(m_window_id, m_base_size, m_size_increment);
 }
 
 void Window::set_size_increment(const Gfx::Size& size_increment)
@@ -758,7 +762,7 @@ void Window::set_size_increment(const Gfx::Size& size_increment)
         return;
     m_size_increment = size_increment;
     if (is_visible())
-        WindowServerConnection::the().send_sync<Messages::WindowServer::SetWindowBaseSizeAndSizeIncrement>(m_window_id, m_base_size, m_size_increment);
+        WindowServerConnection::the().send_async<Messages::WindowServer::SetWindowBaseSizeAndSizeIncrement>(m_window_id, m_base_size, m_size_increment);
 }
 
 void Window::did_add_widget(Badge<Widget>, Widget& widget)
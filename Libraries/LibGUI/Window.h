@@ -201,7 +201,7 @@ private:
 
     RefPtr<Gfx::Bitmap> create_backing_bitmap(const Gfx::Size&);
     RefPtr<Gfx::Bitmap> create_shared_bitmap(Gfx::BitmapFormat, const Gfx::Size&);
-    void set_current_backing_bitmap(Gfx::Bitmap&, bool flush_immediately = false);
+    void set_current_backing_bitmap(Gfx::Bitmap&, const Vector<Gfx::Rect, 32>& dirty_rects);
     void flip(const Vector<Gfx::Rect, 32>& dirty_rects);
     void force_update();
 
@@ -143,6 +143,9 @@ void Job::on_socket_connected()
 
 void Job::finish_up()
 {
+    // Both the end of the body and the TLS connection closing get us here.
+    if (m_state == State::Finished)
+        return;
     m_state = State::Finished;
     auto flattened_buffer = ByteBuffer::create_uninitialized(m_received_size);
     u8* flat_ptr = flattened_buffer.data();
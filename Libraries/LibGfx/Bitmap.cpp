@@ -29,6 +29,7 @@
 #include <AK/SharedBuffer.h>
 #include <AK/String.h>
 #include <LibGfx/Bitmap.h>
+#include <LibGfx/BlendKernels.h>
 #include <LibGfx/PNGLoader.h>
 #include <LibGfx/GIFLoader.h>
 #include <LibGfx/ShareableBitmap.h>
@@ -72,6 +73,9 @@ Bitmap::Bitmap(BitmapFormat format, const Size& size, Purgeable purgeable)
     if (format == BitmapFormat::Indexed8)
         m_palette = new RGBA32[256];
     int map_flags = purgeable == Purgeable::Yes ? (MAP_PURGEABLE | MAP_PRIVATE) : (MAP_ANONYMOUS | MAP_PRIVATE);
+    // Big bitmaps are worth backing with large pages.
+    if (purgeable == Purgeable::No && size_in_bytes() >= 2 * MB)
+        map_flags |= MAP_HUGE;
     m_data = (RGBA32*)mmap_with_name(nullptr, size_in_bytes(), PROT_READ | PROT_WRITE, map_flags, 0, 0, String::format("GraphicsBitmap [%dx%d]", width(), height()).characters());
     ASSERT(m_data && m_data != (void*)-1);
     m_needs_munmap = true;
@@ -181,6 +185,17 @@ RefPtr<Bitmap> Bitmap::to_bitmap_backed_by_shared_buffer() const
     return bitmap;
 }
 
+RefPtr<Bitmap> Bitmap::to_premultiplied() const
+{
+    ASSERT(m_format == BitmapFormat::RGBA32);
+    auto bitmap = Bitmap::create(BitmapFormat::RGBA32Premultiplied, m_size);
+    if (!bitmap)
+        return nullptr;
+    for (int y = 0; y < height(); ++y)
+        premultiply_row(bitmap->scanline(y), scanline(y), width());
+    return bitmap;
+}
+
 Bitmap::~Bitmap()
 {
     if (m_needs_munmap) {
@@ -199,10 +214,11 @@ void Bitmap::set_mmap_name(const StringView& name)
 
 void Bitmap::fill(Color color)
 {
-    ASSERT(m_format == BitmapFormat::RGB32 || m_format == BitmapFormat::RGBA32);
+    ASSERT(m_format == BitmapFormat::RGB32 || m_format == BitmapFormat::RGBA32 || m_format == BitmapFormat::RGBA32Premultiplied);
+    auto value = m_format == BitmapFormat::RGBA32Premultiplied ? color.premultiplied_value() : color.value();
     for (int y = 0; y < height(); ++y) {
         auto* scanline = this->scanline(y);
-        fast_u32_fill(scanline, color.value(), width());
+        fast_u32_fill(scanline, value, width());
     }
 }
 
@@ -0,0 +1,318 @@
+/*
+ * Copyright (c) 2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <LibGfx/BlendKernels.h>
+
+#if ARCH(I386)
+#    include <emmintrin.h>
+#endif
+
+namespace Gfx {
+
+namespace BlendKernels {
+
+// x / 255, rounded down, for any x up to 255 * 255. Avoids the division Color::blend() does for every channel.
+ALWAYS_INLINE static u32 divide_by_255(u32 x)
+{
+    return (x + 1 + (x >> 8)) >> 8;
+}
+
+ALWAYS_INLINE static RGBA32 blend_pixel(RGBA32 dst, RGBA32 src, u32 alpha)
+{
+    u32 inverse_alpha = 255 - alpha;
+    u32 r = divide_by_255(((src >> 16) & 0xff) * alpha + ((dst >> 16) & 0xff) * inverse_alpha);
+    u32 g = divide_by_255(((src >> 8) & 0xff) * alpha + ((dst >> 8) & 0xff) * inverse_alpha);
+    u32 b = divide_by_255((src & 0xff) * alpha + (dst & 0xff) * inverse_alpha);
+    return 0xff000000 | (r << 16) | (g << 8) | b;
+}
+
+void blend_row_generic(RGBA32* dst, const RGBA32* src, size_t count)
+{
+    for (size_t i = 0; i < count; ++i) {
+        u32 alpha = src[i] >> 24;
+        if (alpha == 0xff)
+            dst[i] = src[i];
+        else if (alpha)
+            dst[i] = blend_pixel(dst[i], src[i], alpha);
+    }
+}
+
+void blend_row_with_opacity_generic(RGBA32* dst, const RGBA32* src, size_t count, u8 opacity, bool source_has_alpha)
+{
+    for (size_t i = 0; i < count; ++i) {
+        u32 alpha = source_has_alpha ? divide_by_255((src[i] >> 24) * opacity) : opacity;
+        if (alpha)
+            dst[i] = blend_pixel(dst[i], src[i], alpha);
+    }
+}
+
+void blend_row_premultiplied_generic(RGBA32* dst, const RGBA32* src, size_t count)
+{
+    for (size_t i = 0; i < count; ++i) {
+        u32 alpha = src[i] >> 24;
+        if (alpha == 0xff) {
+            dst[i] = src[i];
+            continue;
+        }
+        if (!src[i])
+            continue;
+        u32 inverse_alpha = 255 - alpha;
+        u32 r = min(255u, ((src[i] >> 16) & 0xff) + divide_by_255(((dst[i] >> 16) & 0xff) * inverse_alpha));
+        u32 g = min(255u, ((src[i] >> 8) & 0xff) + divide_by_255(((dst[i] >> 8) & 0xff) * inverse_alpha));
+        u32 b = min(255u, (src[i] & 0xff) + divide_by_255((dst[i] & 0xff) * inverse_alpha));
+        dst[i] = 0xff000000 | (r << 16) | (g << 8) | b;
+    }
+}
+
+void premultiply_row_generic(RGBA32* dst, const RGBA32* src, size_t count)
+{
+    for (size_t i = 0; i < count; ++i) {
+        u32 alpha = src[i] >> 24;
+        if (alpha == 0xff) {
+            dst[i] = src[i];
+            continue;
+        }
+        u32 r = divide_by_255(((src[i] >> 16) & 0xff) * alpha);
+        u32 g = divide_by_255(((src[i] >> 8) & 0xff) * alpha);
+        u32 b = divide_by_255((src[i] & 0xff) * alpha);
+        dst[i] = (alpha << 24) | (r << 16) | (g << 8) | b;
+    }
+}
+
+ALWAYS_INLINE static u32 rgb565_from_rgb32(RGBA32 pixel)
+{
+    return ((pixel >> 8) & 0xf800) | ((pixel >> 5) & 0x07e0) | ((pixel >> 3) & 0x001f);
+}
+
+void convert_row_to_rgb565_generic(u16* dst, const RGBA32* src, size_t count)
+{
+    for (size_t i = 0; i < count; ++i)
+        dst[i] = rgb565_from_rgb32(src[i]);
+}
+
+#if ARCH(I386)
+bool cpu_supports_sse2()
+{
+    static int s_supported = -1;
+    if (s_supported < 0) {
+        u32 eax = 1, ebx, ecx = 0, edx;
+        asm volatile("cpuid"
+                     : "+a"(eax), "=b"(ebx), "+c"(ecx), "=d"(edx));
+        s_supported = (edx & (1 << 26)) ? 1 : 0;
+    }
+    return s_supported;
+}
+
+// Spreads each pixel's alpha (the top word of its four 16-bit channels) across all of them.
+[[gnu::target("sse2")]] ALWAYS_INLINE static __m128i broadcast_alpha(__m128i pixels)
+{
+    return _mm_shufflehi_epi16(_mm_shufflelo_epi16(pixels, 0xff), 0xff);
+}
+
+[[gnu::target("sse2")]] ALWAYS_INLINE static __m128i divide_by_255(__m128i x)
+{
+    return _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), _mm_set1_epi16(1)), 8);
+}
+
+// Blends two pixels, unpacked to 16 bits per channel, using the alpha in `alpha`.
+[[gnu::target("sse2")]] ALWAYS_INLINE static __m128i blend_unpacked(__m128i dst, __m128i src, __m128i alpha)
+{
+    __m128i inverse_alpha = _mm_sub_epi16(_mm_set1_epi16(255), alpha);
+    return divide_by_255(_mm_add_epi16(_mm_mullo_epi16(src, alpha), _mm_mullo_epi16(dst, inverse_alpha)));
+}
+
+[[gnu::target("sse2")]] void blend_row_sse2(RGBA32* dst, const RGBA32* src, size_t count)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i alpha_mask = _mm_set1_epi32(0xff000000);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i s = _mm_loadu_si128((const __m128i*)(src + i));
+        __m128i s_alpha = _mm_and_si128(s, alpha_mask);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(s_alpha, alpha_mask)) == 0xffff) {
+            _mm_storeu_si128((__m128i*)(dst + i), s);
+            continue;
+        }
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(s_alpha, zero)) == 0xffff)
+            continue;
+        __m128i d = _mm_loadu_si128((const __m128i*)(dst + i));
+        __m128i s_low = _mm_unpacklo_epi8(s, zero);
+        __m128i s_high = _mm_unpackhi_epi8(s, zero);
+        __m128i low = blend_unpacked(_mm_unpacklo_epi8(d, zero), s_low, broadcast_alpha(s_low));
+        __m128i high = blend_unpacked(_mm_unpackhi_epi8(d, zero), s_high, broadcast_alpha(s_high));
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_or_si128(_mm_packus_epi16(low, high), alpha_mask));
+    }
+    blend_row_generic(dst + i, src + i, count - i);
+}
+
+[[gnu::target("sse2")]] void blend_row_with_opacity_sse2(RGBA32* dst, const RGBA32* src, size_t count, u8 opacity, bool source_has_alpha)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i alpha_mask = _mm_set1_epi32(0xff000000);
+    const __m128i opacity_16 = _mm_set1_epi16(opacity);
+    const __m128i opaque = source_has_alpha ? zero : alpha_mask;
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i s = _mm_or_si128(_mm_loadu_si128((const __m128i*)(src + i)), opaque);
+        __m128i d = _mm_loadu_si128((const __m128i*)(dst + i));
+        __m128i s_low = _mm_unpacklo_epi8(s, zero);
+        __m128i s_high = _mm_unpackhi_epi8(s, zero);
+        __m128i alpha_low = divide_by_255(_mm_mullo_epi16(broadcast_alpha(s_low), opacity_16));
+        __m128i alpha_high = divide_by_255(_mm_mullo_epi16(broadcast_alpha(s_high), opacity_16));
+        __m128i low = blend_unpacked(_mm_unpacklo_epi8(d, zero), s_low, alpha_low);
+        __m128i high = blend_unpacked(_mm_unpackhi_epi8(d, zero), s_high, alpha_high);
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_or_si128(_mm_packus_epi16(low, high), alpha_mask));
+    }
+    blend_row_with_opacity_generic(dst + i, src + i, count - i, opacity, source_has_alpha);
+}
+
+// Adds `dst`, scaled by the inverse of the alpha in `alpha`, to the premultiplied `src`. Both are unpacked.
+[[gnu::target("sse2")]] ALWAYS_INLINE static __m128i blend_premultiplied_unpacked(__m128i dst, __m128i src, __m128i alpha)
+{
+    __m128i inverse_alpha = _mm_sub_epi16(_mm_set1_epi16(255), alpha);
+    return _mm_add_epi16(src, divide_by_255(_mm_mullo_epi16(dst, inverse_alpha)));
+}
+
+[[gnu::target("sse2")]] void blend_row_premultiplied_sse2(RGBA32* dst, const RGBA32* src, size_t count)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i alpha_mask = _mm_set1_epi32(0xff000000);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i s = _mm_loadu_si128((const __m128i*)(src + i));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(s, alpha_mask), alpha_mask)) == 0xffff) {
+            _mm_storeu_si128((__m128i*)(dst + i), s);
+            continue;
+        }
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(s, zero)) == 0xffff)
+            continue;
+        __m128i d = _mm_loadu_si128((const __m128i*)(dst + i));
+        __m128i s_low = _mm_unpacklo_epi8(s, zero);
+        __m128i s_high = _mm_unpackhi_epi8(s, zero);
+        __m128i low = blend_premultiplied_unpacked(_mm_unpacklo_epi8(d, zero), s_low, broadcast_alpha(s_low));
+        __m128i high = blend_premultiplied_unpacked(_mm_unpackhi_epi8(d, zero), s_high, broadcast_alpha(s_high));
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_or_si128(_mm_packus_epi16(low, high), alpha_mask));
+    }
+    blend_row_premultiplied_generic(dst + i, src + i, count - i);
+}
+
+[[gnu::target("sse2")]] void premultiply_row_sse2(RGBA32* dst, const RGBA32* src, size_t count)
+{
+    const __m128i zero = _mm_setzero_si128();
+    // Multiplies the color channels by alpha, and alpha itself by 255, which divide_by_255() undoes exactly.
+    const __m128i color_channels = _mm_set_epi16(0, -1, -1, -1, 0, -1, -1, -1);
+    const __m128i alpha_channel = _mm_set_epi16(255, 0, 0, 0, 255, 0, 0, 0);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i s = _mm_loadu_si128((const __m128i*)(src + i));
+        __m128i s_low = _mm_unpacklo_epi8(s, zero);
+        __m128i s_high = _mm_unpackhi_epi8(s, zero);
+        __m128i factor_low = _mm_or_si128(_mm_and_si128(broadcast_alpha(s_low), color_channels), alpha_channel);
+        __m128i factor_high = _mm_or_si128(_mm_and_si128(broadcast_alpha(s_high), color_channels), alpha_channel);
+        __m128i low = divide_by_255(_mm_mullo_epi16(s_low, factor_low));
+        __m128i high = divide_by_255(_mm_mullo_epi16(s_high, factor_high));
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_packus_epi16(low, high));
+    }
+    premultiply_row_generic(dst + i, src + i, count - i);
+}
+
+// Packs the low 16 bits of each 32-bit lane. SSE2 only has a signed saturating pack, so the
+// values are sign-extended from 16 bits first, which makes the saturation a no-op.
+[[gnu::target("sse2")]] ALWAYS_INLINE static __m128i pack_low_words(__m128i a, __m128i b)
+{
+    a = _mm_srai_epi32(_mm_slli_epi32(a, 16), 16);
+    b = _mm_srai_epi32(_mm_slli_epi32(b, 16), 16);
+    return _mm_packs_epi32(a, b);
+}
+
+[[gnu::target("sse2")]] ALWAYS_INLINE static __m128i rgb565_from_rgb32(__m128i pixels)
+{
+    __m128i r = _mm_and_si128(_mm_srli_epi32(pixels, 8), _mm_set1_epi32(0xf800));
+    __m128i g = _mm_and_si128(_mm_srli_epi32(pixels, 5), _mm_set1_epi32(0x07e0));
+    __m128i b = _mm_and_si128(_mm_srli_epi32(pixels, 3), _mm_set1_epi32(0x001f));
+    return _mm_or_si128(_mm_or_si128(r, g), b);
+}
+
+[[gnu::target("sse2")]] void convert_row_to_rgb565_sse2(u16* dst, const RGBA32* src, size_t count)
+{
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128i first = rgb565_from_rgb32(_mm_loadu_si128((const __m128i*)(src + i)));
+        __m128i second = rgb565_from_rgb32(_mm_loadu_si128((const __m128i*)(src + i + 4)));
+        _mm_storeu_si128((__m128i*)(dst + i), pack_low_words(first, second));
+    }
+    convert_row_to_rgb565_generic(dst + i, src + i, count - i);
+}
+#endif
+
+}
+
+void blend_row(RGBA32* dst, const RGBA32* src, size_t count)
+{
+#if ARCH(I386)
+    if (BlendKernels::cpu_supports_sse2())
+        return BlendKernels::blend_row_sse2(dst, src, count);
+#endif
+    BlendKernels::blend_row_generic(dst, src, count);
+}
+
+void blend_row_with_opacity(RGBA32* dst, const RGBA32* src, size_t count, u8 opacity, bool source_has_alpha)
+{
+#if ARCH(I386)
+    if (BlendKernels::cpu_supports_sse2())
+        return BlendKernels::blend_row_with_opacity_sse2(dst, src, count, opacity, source_has_alpha);
+#endif
+    BlendKernels::blend_row_with_opacity_generic(dst, src, count, opacity, source_has_alpha);
+}
+
+void blend_row_premultiplied(RGBA32* dst, const RGBA32* src, size_t count)
+{
+#if ARCH(I386)
+    if (BlendKernels::cpu_supports_sse2())
+        return BlendKernels::blend_row_premultiplied_sse2(dst, src, count);
+#endif
+    BlendKernels::blend_row_premultiplied_generic(dst, src, count);
+}
+
+void premultiply_row(RGBA32* dst, const RGBA32* src, size_t count)
+{
+#if ARCH(I386)
+    if (BlendKernels::cpu_supports_sse2())
+        return BlendKernels::premultiply_row_sse2(dst, src, count);
+#endif
+    BlendKernels::premultiply_row_generic(dst, src, count);
+}
+
+void convert_row_to_rgb565(u16* dst, const RGBA32* src, size_t count)
+{
+#if ARCH(I386)
+    if (BlendKernels::cpu_supports_sse2())
+        return BlendKernels::convert_row_to_rgb565_sse2(dst, src, count);
+#endif
+    BlendKernels::convert_row_to_rgb565_generic(dst, src, count);
+}
+
+}
@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/Platform.h>
+#include <AK/Types.h>
+#include <LibGfx/Color.h>
+
+namespace Gfx {
+
+// Row kernels behind Painter's blits onto opaque (RGB32) targets, and the pixel format conversions around
+// them. The results are always opaque, and every channel is rounded down, so the portable and the SSE2
+// variants produce the same pixels.
+
+// Blends `count` RGBA32 pixels from `src` over `dst`.
+void blend_row(RGBA32* dst, const RGBA32* src, size_t count);
+
+// Blends `count` pixels from `src` over `dst`, scaling their alpha by `opacity`.
+// If `source_has_alpha` is false, the source pixels are treated as opaque.
+void blend_row_with_opacity(RGBA32* dst, const RGBA32* src, size_t count, u8 opacity, bool source_has_alpha);
+
+// Blends `count` premultiplied pixels from `src` over `dst`. Only `dst` has to be scaled (by the inverse of
+// the source alpha), which is what makes premultiplied sources cheaper to blend.
+void blend_row_premultiplied(RGBA32* dst, const RGBA32* src, size_t count);
+
+// Converts `count` RGBA32 pixels from `src` to premultiplied alpha. `dst` may be the same as `src`.
+void premultiply_row(RGBA32* dst, const RGBA32* src, size_t count);
+
+// Packs `count` opaque pixels into RGB565, for 16-bit framebuffers. The low bits of each channel are dropped.
+void convert_row_to_rgb565(u16* dst, const RGBA32* src, size_t count);
+
+// Both variants are exported under their own names, so that gfx_benchmark can compare them.
+namespace BlendKernels {
+
+void blend_row_generic(RGBA32* dst, const RGBA32* src, size_t count);
+void blend_row_with_opacity_generic(RGBA32* dst, const RGBA32* src, size_t count, u8 opacity, bool source_has_alpha);
+void blend_row_premultiplied_generic(RGBA32* dst, const RGBA32* src, size_t count);
+void premultiply_row_generic(RGBA32* dst, const RGBA32* src, size_t count);
+void convert_row_to_rgb565_generic(u16* dst, const RGBA32* src, size_t count);
+
+#if ARCH(I386)
+bool cpu_supports_sse2();
+void blend_row_sse2(RGBA32* dst, const RGBA32* src, size_t count);
+void blend_row_with_opacity_sse2(RGBA32* dst, const RGBA32* src, size_t count, u8 opacity, bool source_has_alpha);
+void blend_row_premultiplied_sse2(RGBA32* dst, const RGBA32* src, size_t count);
+void premultiply_row_sse2(RGBA32* dst, const RGBA32* src, size_t count);
+void convert_row_to_rgb565_sse2(u16* dst, const RGBA32* src, size_t count);
+#endif
+
+}
+
+}
@@ -86,6 +86,22 @@ public:
     static constexpr Color from_rgb(unsigned rgb) { return Color(rgb | 0xff000000); }
     static constexpr Color from_rgba(unsigned rgba) { return Color(rgba); }
 
+    // Premultiplied pixels have their color channels already scaled by their alpha.
+    static Color from_premultiplied_rgba(unsigned rgba)
+    {
+        u32 a = rgba >> 24;
+        if (a == 255 || !a)
+            return Color(rgba);
+        auto unpremultiply = [a](u32 channel) -> u8 { return min(255u, (channel * 255 + a / 2) / a); };
+        return Color(unpremultiply((rgba >> 16) & 0xff), unpremultiply((rgba >> 8) & 0xff), unpremultiply(rgba & 0xff), a);
+    }
+
+    RGBA32 premultiplied_value() const
+    {
+        u32 a = alpha();
+        return (a << 24) | ((red() * a / 255) << 16) | ((green() * a / 255) << 8) | (blue() * a / 255);
+    }
+
     u8 red() const { return (m_value >> 16) & 0xff; }
     u8 green() const { return (m_value >> 8) & 0xff; }
     u8 blue() const { return m_value & 0xff; }
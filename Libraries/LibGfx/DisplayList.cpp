@@ -0,0 +1,161 @@
+/*
+ * Copyright (c) 2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/NonnullOwnPtrVector.h>
+#include <LibGfx/DisplayList.h>
+#include <LibThread/ParallelFor.h>
+
+namespace Gfx {
+
+// Every band goes through the whole list, so there's no point in having more bands than threads to run them on.
+static constexpr size_t replay_band_count = 4;
+// Below this many pixels, the replay isn't worth handing to other threads.
+static constexpr int parallel_replay_threshold = 256 * 256;
+
+DisplayList::Command& DisplayList::append(Type type, const Painter::State& state)
+{
+    bool state_changed = m_states.is_empty()
+        || m_states.last().font != state.font
+        || m_states.last().translation != state.translation
+        || m_states.last().clip_rect != state.clip_rect
+        || m_states.last().draw_op != state.draw_op;
+    if (state_changed) {
+        if (m_fonts.is_empty() || m_fonts.last().ptr() != state.font)
+            m_fonts.append(const_cast<Font&>(*state.font));
+        m_states.append(state);
+    }
+    Command command;
+    command.type = type;
+    command.state_index = m_states.size() - 1;
+    m_commands.append(command);
+    return m_commands.last();
+}
+
+u32 DisplayList::add_bitmap(const Bitmap& bitmap)
+{
+    m_bitmaps.append(const_cast<Bitmap&>(bitmap));
+    return m_bitmaps.size() - 1;
+}
+
+u32 DisplayList::add_character_bitmap(const CharacterBitmap& bitmap)
+{
+    m_character_bitmaps.append(const_cast<CharacterBitmap&>(bitmap));
+    return m_character_bitmaps.size() - 1;
+}
+
+u32 DisplayList::add_string(const StringView& string)
+{
+    m_contains_text = true;
+    m_strings.append(string);
+    return m_strings.size() - 1;
+}
+
+void DisplayList::replay(Painter& painter) const
+{
+    ASSERT(!painter.is_recording());
+    auto clip_rect = painter.clip_rect();
+    if (m_contains_text || clip_rect.height() < (int)replay_band_count || clip_rect.width() * clip_rect.height() < parallel_replay_threshold) {
+        replay_serially(painter);
+        return;
+    }
+
+    // The painters are set up here rather than on the worker threads, since creating one takes a reference
+    // to the target, and reference counts aren't safe to touch from several threads at once.
+    NonnullOwnPtrVector<Painter> band_painters;
+    int band_height = (clip_rect.height() + replay_band_count - 1) / replay_band_count;
+    for (int y = clip_rect.top(); y <= clip_rect.bottom(); y += band_height) {
+        auto band_painter = make<Painter>(*painter.target());
+        band_painter->add_clip_rect({ clip_rect.x(), y, clip_rect.width(), min(band_height, clip_rect.bottom() + 1 - y) });
+        band_painters.append(move(band_painter));
+    }
+    LibThread::parallel_for(band_painters.size(), [&](size_t band_index) {
+        replay_serially(band_painters[band_index]);
+    });
+}
+
+void DisplayList::replay_serially(Painter& painter) const
+{
+    PainterStateSaver saver(painter);
+    auto replay_clip_rect = painter.clip_rect();
+    // Starts out past the end, so the first command always sets up its state.
+    size_t current_state_index = m_states.size();
+    for (auto& command : m_commands) {
+        if (current_state_index != command.state_index) {
+            current_state_index = command.state_index;
+            painter.state() = m_states[command.state_index];
+            painter.state().clip_rect.intersect(replay_clip_rect);
+        }
+        switch (command.type) {
+        case Type::ClearRect:
+            painter.clear_rect(command.rect, command.color);
+            break;
+        case Type::FillRect:
+            painter.fill_rect(command.rect, command.color);
+            break;
+        case Type::FillRectWithDitherPattern:
+            painter.fill_rect_with_dither_pattern(command.rect, command.color, command.second_color);
+            break;
+        case Type::FillRectWithCheckerboard:
+            painter.fill_rect_with_checkerboard(command.rect, command.source_rect.size(), command.color, command.second_color);
+            break;
+        case Type::FillRectWithGradient:
+            painter.fill_rect_with_gradient((Orientation)command.mode, command.rect, command.color, command.second_color);
+            break;
+        case Type::DrawRect:
+            painter.draw_rect(command.rect, command.color, command.mode);
+            break;
+        case Type::DrawCharacterBitmap:
+            painter.draw_bitmap(command.point, m_character_bitmaps[command.resource_index], command.color);
+            break;
+        case Type::SetPixel:
+            painter.set_pixel(command.point, command.color);
+            break;
+        case Type::DrawLine:
+            painter.draw_line(command.point, command.second_point, command.color, command.thickness, (Painter::LineStyle)command.mode);
+            break;
+        case Type::Blit:
+            painter.blit(command.point, m_bitmaps[command.resource_index], command.source_rect, command.opacity);
+            break;
+        case Type::BlitDimmed:
+            painter.blit_dimmed(command.point, m_bitmaps[command.resource_index], command.source_rect);
+            break;
+        case Type::BlitBrightened:
+            painter.blit_brightened(command.point, m_bitmaps[command.resource_index], command.source_rect);
+            break;
+        case Type::DrawScaledBitmap:
+            painter.draw_scaled_bitmap(command.rect, m_bitmaps[command.resource_index], command.source_rect);
+            break;
+        case Type::DrawTiledBitmap:
+            painter.draw_tiled_bitmap(command.rect, m_bitmaps[command.resource_index]);
+            break;
+        case Type::DrawText:
+            painter.draw_text(command.rect, m_strings[command.resource_index], painter.font(), (TextAlignment)command.mode, command.color, command.elision);
+            break;
+        }
+    }
+}
+
+}
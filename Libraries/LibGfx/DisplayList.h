@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/NonnullRefPtr.h>
+#include <AK/String.h>
+#include <AK/Vector.h>
+#include <LibGfx/Bitmap.h>
+#include <LibGfx/CharacterBitmap.h>
+#include <LibGfx/Font.h>
+#include <LibGfx/Painter.h>
+
+namespace Gfx {
+
+// A recording of painting commands, along with the painter state each was issued under, that can be replayed
+// later without running the code that produced them. A Painter records into one instead of drawing while
+// start_recording() is in effect. Coordinates are kept as they were on the recording painter's target, so
+// a list must be replayed onto a painter targeting the same coordinate space.
+class DisplayList {
+public:
+    DisplayList() {}
+
+    bool is_empty() const { return m_commands.is_empty(); }
+
+    // False if something was painted that can't be recorded. Such a list leaves that out, so it mustn't be used.
+    bool is_complete() const { return m_is_complete; }
+
+    // Replays the commands within the painter's clip rect. Large areas are split into bands that are
+    // replayed on the LibThread worker pool, unless the list contains text, whose layout caches aren't
+    // safe to share between threads.
+    void replay(Painter&) const;
+
+private:
+    friend class Painter;
+
+    struct Command {
+        enum class Type : u8 {
+            ClearRect,
+            FillRect,
+            FillRectWithDitherPattern,
+            FillRectWithCheckerboard,
+            FillRectWithGradient,
+            DrawRect,
+            DrawCharacterBitmap,
+            SetPixel,
+            DrawLine,
+            Blit,
+            BlitDimmed,
+            BlitBrightened,
+            DrawScaledBitmap,
+            DrawTiledBitmap,
+            DrawText,
+        };
+
+        Type type;
+        // Line style, gradient orientation, text alignment, or whether a rect is rough, depending on the type.
+        u8 mode { 0 };
+        TextElision elision { TextElision::None };
+        u32 state_index { 0 };
+        // Index into m_bitmaps, m_character_bitmaps or m_strings, depending on the type.
+        u32 resource_index { 0 };
+        Rect rect;
+        Rect source_rect;
+        Point point;
+        Point second_point;
+        Color color;
+        Color second_color;
+        int thickness { 1 };
+        float opacity { 1.0f };
+    };
+
+    using Type = Command::Type;
+
+    Command& append(Type, const Painter::State&);
+    u32 add_bitmap(const Bitmap&);
+    u32 add_character_bitmap(const CharacterBitmap&);
+    u32 add_string(const StringView&);
+    void mark_incomplete() { m_is_complete = false; }
+
+    void replay_serially(Painter&) const;
+
+    Vector<Command> m_commands;
+    Vector<Painter::State> m_states;
+    Vector<NonnullRefPtr<Bitmap>> m_bitmaps;
+    Vector<NonnullRefPtr<CharacterBitmap>> m_character_bitmaps;
+    // Fonts used by the recorded states and text, kept alive for as long as the list is.
+    Vector<NonnullRefPtr<Font>> m_fonts;
+    Vector<String> m_strings;
+    bool m_is_complete { true };
+    bool m_contains_text { false };
+};
+
+}
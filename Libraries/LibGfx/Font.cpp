@@ -27,6 +27,7 @@
 #include "Font.h"
 #include "Bitmap.h"
 #include "Emoji.h"
+#include "GlyphAtlas.h"
 #include <AK/BufferStream.h>
 #include <AK/MappedFile.h>
 #include <AK/StdLibExtras.h>
@@ -155,6 +156,45 @@ Font::~Font()
 {
 }
 
+void Font::set_fixed_width(bool fixed_width)
+{
+    m_fixed_width = fixed_width;
+    did_change_metrics();
+}
+
+void Font::set_glyph_spacing(u8 spacing)
+{
+    m_glyph_spacing = spacing;
+    did_change_metrics();
+}
+
+void Font::set_glyph_width(size_t ch, u8 width)
+{
+    ASSERT(m_glyph_widths);
+    m_glyph_widths[ch] = width;
+    did_change_glyph(ch);
+}
+
+GlyphAtlas& Font::glyph_atlas() const
+{
+    if (!m_glyph_atlas)
+        m_glyph_atlas = make<GlyphAtlas>(*this);
+    return *m_glyph_atlas;
+}
+
+void Font::did_change_glyph(u32 codepoint)
+{
+    if (m_glyph_atlas)
+        m_glyph_atlas->invalidate(codepoint);
+    m_text_run_cache.clear();
+}
+
+void Font::did_change_metrics()
+{
+    m_glyph_atlas = nullptr;
+    m_text_run_cache.clear();
+}
+
 RefPtr<Font> Font::load_from_memory(const u8* data)
 {
     auto& header = *reinterpret_cast<const FontFileHeader*>(data);
@@ -287,6 +327,56 @@ int Font::width(const Utf8View& utf8) const
     return width;
 }
 
+// Enough for the labels, menu items and window titles on screen at once.
+static constexpr size_t text_run_cache_size = 512;
+
+Font::TextRun Font::text_run(const Utf8View& text, int available_width, TextElision elision) const
+{
+    auto string = text.as_string();
+    if (string.is_empty())
+        return {};
+
+    // Without elision, the run doesn't depend on the space available.
+    if (elision == TextElision::None)
+        available_width = 0;
+
+    auto it = m_text_run_cache.find(string.hash(), [&](auto& entry) { return entry.key == string; });
+    if (it != m_text_run_cache.end() && it->value.available_width == available_width && it->value.elision == elision)
+        return it->value.run;
+
+    auto run = measure_text_run(text, available_width, elision);
+    if (m_text_run_cache.size() >= text_run_cache_size)
+        m_text_run_cache.clear();
+    m_text_run_cache.set(string, { available_width, elision, run });
+    return run;
+}
+
+Font::TextRun Font::measure_text_run(const Utf8View& text, int available_width, TextElision elision) const
+{
+    int text_width = width(text);
+    TextRun run { text_width, (size_t)text.byte_length(), false };
+    if (elision != TextElision::Right || text_width <= available_width)
+        return run;
+
+    int new_width = width("...");
+    if (new_width >= text_width)
+        return run;
+
+    size_t byte_length = 0;
+    for (auto it = text.begin(); it != text.end(); ++it) {
+        int glyph_width = glyph_or_emoji_width(*it);
+        // NOTE: Glyph spacing should not be added after the last glyph on the line,
+        //       but since we are here because the last glyph does not actually fit on the line,
+        //       we don't have to worry about spacing.
+        int width_with_this_glyph_included = new_width + glyph_width + glyph_spacing();
+        if (width_with_this_glyph_included > available_width)
+            break;
+        byte_length = text.byte_offset_of(it) + it.codepoint_length_in_bytes();
+        new_width = width_with_this_glyph_included;
+    }
+    return { new_width, byte_length, true };
+}
+
 int Font::width(const Utf32View& view) const
 {
     if (view.length() == 0)
@@ -308,6 +398,7 @@ void Font::set_type(FontTypes type)
     size_t new_glyph_count = glyph_count_by_type(type);
     if (new_glyph_count <= m_glyph_count) {
         m_glyph_count = new_glyph_count;
+        did_change_metrics();
         return;
     }
 
@@ -330,6 +421,7 @@ void Font::set_type(FontTypes type)
     m_glyph_count = new_glyph_count;
     m_rows = new_rows;
     m_glyph_widths = new_widths;
+    did_change_metrics();
 }
 
 }
@@ -26,12 +26,16 @@
 
 #pragma once
 
+#include <AK/HashMap.h>
 #include <AK/MappedFile.h>
+#include <AK/OwnPtr.h>
 #include <AK/RefCounted.h>
 #include <AK/RefPtr.h>
 #include <AK/String.h>
 #include <AK/Types.h>
+#include <LibGfx/Forward.h>
 #include <LibGfx/Size.h>
+#include <LibGfx/TextElision.h>
 
 namespace Gfx {
 
@@ -106,16 +110,27 @@ public:
     void set_name(const StringView& name) { m_name = name; }
 
     bool is_fixed_width() const { return m_fixed_width; }
-    void set_fixed_width(bool b) { m_fixed_width = b; }
+    void set_fixed_width(bool);
 
     u8 glyph_spacing() const { return m_glyph_spacing; }
-    void set_glyph_spacing(u8 spacing) { m_glyph_spacing = spacing; }
+    void set_glyph_spacing(u8);
 
-    void set_glyph_width(size_t ch, u8 width)
-    {
-        ASSERT(m_glyph_widths);
-        m_glyph_widths[ch] = width;
-    }
+    void set_glyph_width(size_t ch, u8 width);
+
+    GlyphAtlas& glyph_atlas() const;
+
+    // Must be called after a glyph's bitmap has been edited in place.
+    void did_change_glyph(u32 codepoint);
+
+    // How a line of text is laid out by Painter::draw_text_line(). The first `length` bytes of the text
+    // are drawn, followed by "..." if it had to be elided to fit. `width` is the width of all of that.
+    struct TextRun {
+        int width { 0 };
+        size_t length { 0 };
+        bool is_elided { false };
+    };
+    // Runs are cached per string, so that labels and menu items aren't measured on every paint.
+    TextRun text_run(const Utf8View&, int available_width, TextElision) const;
 
     int glyph_count() const { return m_glyph_count; }
 
@@ -127,6 +142,9 @@ private:
     static RefPtr<Font> load_from_memory(const u8*);
     static size_t glyph_count_by_type(FontTypes type);
 
+    TextRun measure_text_run(const Utf8View&, int available_width, TextElision) const;
+    void did_change_metrics();
+
     String m_name;
     FontTypes m_type;
     size_t m_glyph_count { 256 };
@@ -142,6 +160,15 @@ private:
     u8 m_glyph_spacing { 0 };
 
     bool m_fixed_width { false };
+
+    mutable OwnPtr<GlyphAtlas> m_glyph_atlas;
+
+    struct CachedTextRun {
+        int available_width { 0 };
+        TextElision elision { TextElision::None };
+        TextRun run;
+    };
+    mutable HashMap<String, CachedTextRun> m_text_run_cache;
 };
 
 }
@@ -32,11 +32,13 @@ class Bitmap;
 class CharacterBitmap;
 class Color;
 class DisjointRectSet;
+class DisplayList;
 class Emoji;
 class FloatPoint;
 class FloatRect;
 class FloatSize;
 class Font;
+class GlyphAtlas;
 class GlyphBitmap;
 class ImageDecoder;
 class Painter;
@@ -28,9 +28,9 @@
 #include <AK/ByteBuffer.h>
 #include <AK/LexicalPath.h>
 #include <AK/MappedFile.h>
+#include <AK/Memory.h>
 #include <AK/NonnullOwnPtrVector.h>
 #include <LibGfx/GIFLoader.h>
-#include <LibM/math.h>
 #include <stdio.h>
 #include <string.h>
 
@@ -53,7 +53,6 @@ struct ImageDescriptor {
     RGB color_map[256];
     u8 lzw_min_code_size;
     Vector<u8> lzw_encoded_bytes;
-    RefPtr<Gfx::Bitmap> bitmap;
 
     // Fields from optional graphic control extension block
     enum DisposalMethod : u8 {
@@ -82,13 +81,19 @@ struct GIFLoadingContext {
         FrameDescriptorsLoaded,
     };
     State state { NotDecoded };
-    size_t frames_decoded { 0 };
     const u8* data { nullptr };
     size_t data_size { 0 };
     LogicalScreen logical_screen {};
     u8 background_color_index { 0 };
     NonnullOwnPtrVector<ImageDescriptor> images {};
     size_t loops { 1 };
+
+    // The fully composited frame at index current_frame, which later frames are drawn on top of.
+    RefPtr<Gfx::Bitmap> frame_buffer;
+    Optional<size_t> current_frame;
+    // What lies under the current frame, for when its disposal method asks to restore it afterwards.
+    RefPtr<Gfx::Bitmap> restore_buffer;
+    Vector<u8> color_indices;
 };
 
 RefPtr<Gfx::Bitmap> load_gif(const StringView& path)
@@ -137,194 +142,238 @@ Optional<GIFFormat> decode_gif_header(BufferStream& stream)
     return {};
 }
 
+// Decodes a GIF LZW stream with a flat dictionary: each code stores the code it extends, the byte it appends,
+// and its total length and first byte, so a code's string can be written out back to front without allocating.
 class LZWDecoder {
-private:
-    static constexpr int max_code_size = 12;
-
 public:
-    explicit LZWDecoder(const Vector<u8>& lzw_bytes, u8 min_code_size)
+    LZWDecoder(const Vector<u8>& lzw_bytes, u8 min_code_size)
         : m_lzw_bytes(lzw_bytes)
-        , m_code_size(min_code_size)
-        , m_original_code_size(min_code_size)
-        , m_table_capacity(pow(2, min_code_size))
+        , m_min_code_size(min_code_size)
     {
-        init_code_table();
     }
 
-    u16 add_control_code()
+    // Decodes up to `size` color indices into `output` and returns how many were written, or nothing if the
+    // stream is corrupt. Streams that end early (or without an end-of-information code) are not an error.
+    Optional<size_t> decode(u8* output, size_t size)
     {
-        const u16 control_code = m_code_table.size();
-        m_code_table.append(Vector<u8> {});
-        m_original_code_table.append(Vector<u8> {});
-        if (m_code_table.size() >= m_table_capacity && m_code_size < max_code_size) {
+        if (m_min_code_size < 1 || m_min_code_size > 8)
+            return {};
 
-            ++m_code_size;
-            ++m_original_code_size;
-            m_table_capacity *= 2;
+        const u16 clear_code = 1 << m_min_code_size;
+        const u16 end_of_information_code = clear_code + 1;
+        for (u16 code = 0; code < clear_code; ++code) {
+            m_suffix[code] = code;
+            m_first[code] = code;
+            m_length[code] = 1;
         }
-        return control_code;
-    }
-
-    void reset()
-    {
-        m_code_table.clear();
-        m_code_table.append(m_original_code_table);
-        m_code_size = m_original_code_size;
-        m_table_capacity = pow(2, m_code_size);
-        m_output.clear();
-    }
+        reset(clear_code);
 
-    Optional<u16> next_code()
-    {
-        size_t current_byte_index = m_current_bit_index / 8;
-        if (current_byte_index >= m_lzw_bytes.size()) {
-            return {};
-        }
+        size_t written = 0;
+        u16 previous_code = no_code;
+        while (written < size) {
+            auto code = read_code();
+            if (!code.has_value())
+                break;
 
-        // Extract the code bits using a 32-bit mask to cover the possibility that if
-        // the current code size > 9 bits then the code can span 3 bytes.
-        u8 current_bit_offset = m_current_bit_index % 8;
-        u32 mask = (u32)(m_table_capacity - 1) << current_bit_offset;
+            if (code.value() == clear_code) {
+                reset(clear_code);
+                previous_code = no_code;
+                continue;
+            }
+            if (code.value() == end_of_information_code)
+                break;
 
-        // Make a padded copy of the final bytes in the data to ensure we don't read past the end.
-        if (current_byte_index + sizeof(mask) > m_lzw_bytes.size()) {
-            u8 padded_last_bytes[sizeof(mask)] = { 0 };
-            for (int i = 0; current_byte_index + i < m_lzw_bytes.size(); ++i) {
-                padded_last_bytes[i] = m_lzw_bytes[current_byte_index + i];
+            if (previous_code == no_code) {
+                if (code.value() > clear_code)
+                    return {};
+            } else {
+                if (code.value() > m_next_code)
+                    return {};
+                // A code that isn't in the table yet can only be the one about to be added: the previous
+                // string followed by its own first byte.
+                u8 appended = code.value() < m_next_code ? m_first[code.value()] : m_first[previous_code];
+                add_code(previous_code, appended);
             }
-            const u32* addr = (const u32*)&padded_last_bytes;
-            m_current_code = (*addr & mask) >> current_bit_offset;
-        } else {
-            const u32* addr = (const u32*)&m_lzw_bytes.at(current_byte_index);
-            m_current_code = (*addr & mask) >> current_bit_offset;
-        }
 
-        if (m_current_code > m_code_table.size()) {
-            dbg() << "Corrupted LZW stream, invalid code: " << m_current_code << " at bit index: "
-                  << m_current_bit_index << ", code table size: " << m_code_table.size();
-            return {};
+            written += output_code(code.value(), output + written, size - written);
+            previous_code = code.value();
         }
+        return written;
+    }
 
-        m_current_bit_index += m_code_size;
+private:
+    static constexpr int max_code_size = 12;
+    static constexpr u16 table_size = 1 << max_code_size;
+    static constexpr u16 no_code = 0xffff;
 
-        return m_current_code;
+    void reset(u16 clear_code)
+    {
+        m_code_size = m_min_code_size + 1;
+        m_next_code = clear_code + 2;
     }
 
-    Vector<u8>& get_output()
+    void add_code(u16 prefix, u8 suffix)
     {
-        ASSERT(m_current_code <= m_code_table.size());
-        if (m_current_code < m_code_table.size()) {
-            Vector<u8> new_entry = m_output;
-            m_output = m_code_table.at(m_current_code);
-            new_entry.append(m_output[0]);
-            extend_code_table(new_entry);
-        } else if (m_current_code == m_code_table.size()) {
-            m_output.append(m_output[0]);
-            extend_code_table(m_output);
-        }
-        return m_output;
+        if (m_next_code >= table_size)
+            return;
+        m_prefix[m_next_code] = prefix;
+        m_suffix[m_next_code] = suffix;
+        m_first[m_next_code] = m_first[prefix];
+        m_length[m_next_code] = m_length[prefix] + 1;
+        ++m_next_code;
+        if (m_next_code == (1 << m_code_size) && m_code_size < max_code_size)
+            ++m_code_size;
     }
 
-private:
-    void init_code_table()
+    size_t output_code(u16 code, u8* output, size_t available)
     {
-        m_code_table.clear();
-        for (u16 i = 0; i < m_table_capacity; ++i) {
-            m_code_table.append({ (u8)i });
+        size_t length = m_length[code];
+        // Walk the prefix chain from the last byte to the first, dropping whatever doesn't fit.
+        for (size_t i = length; i > 0; --i) {
+            if (i - 1 < available)
+                output[i - 1] = m_suffix[code];
+            code = m_prefix[code];
         }
-        m_original_code_table = m_code_table;
+        return min(length, available);
     }
 
-    void extend_code_table(const Vector<u8>& entry)
+    Optional<u16> read_code()
     {
-        if (entry.size() > 1 && m_code_table.size() < 4096) {
-            m_code_table.append(entry);
-            if (m_code_table.size() >= m_table_capacity && m_code_size < max_code_size) {
-                ++m_code_size;
-                m_table_capacity *= 2;
-            }
+        while (m_bit_count < m_code_size) {
+            if (m_byte_index >= m_lzw_bytes.size())
+                return {};
+            m_bit_buffer |= (u32)m_lzw_bytes[m_byte_index++] << m_bit_count;
+            m_bit_count += 8;
         }
+        u16 code = m_bit_buffer & ((1 << m_code_size) - 1);
+        m_bit_buffer >>= m_code_size;
+        m_bit_count -= m_code_size;
+        return code;
     }
 
     const Vector<u8>& m_lzw_bytes;
+    size_t m_byte_index { 0 };
+    u32 m_bit_buffer { 0 };
+    u8 m_bit_count { 0 };
 
-    int m_current_bit_index { 0 };
-
-    Vector<Vector<u8>> m_code_table {};
-    Vector<Vector<u8>> m_original_code_table {};
-
+    u8 m_min_code_size { 0 };
     u8 m_code_size { 0 };
-    u8 m_original_code_size { 0 };
+    u16 m_next_code { 0 };
 
-    u32 m_table_capacity { 0 };
-
-    u16 m_current_code { 0 };
-    Vector<u8> m_output {};
+    u16 m_prefix[table_size];
+    u8 m_suffix[table_size];
+    u8 m_first[table_size];
+    u16 m_length[table_size];
 };
 
-bool decode_frames_up_to_index(GIFLoadingContext& context, size_t frame_index)
+static void fill_frame_rect(Bitmap& bitmap, const Rect& rect, RGBA32 value)
 {
-    if (frame_index >= context.images.size()) {
-        return false;
-    }
+    for (int y = rect.top(); y <= rect.bottom(); ++y)
+        fast_u32_fill(bitmap.scanline(y) + rect.left(), value, rect.width());
+}
 
-    for (size_t i = context.frames_decoded; i <= frame_index; ++i) {
-        auto& image = context.images.at(i);
-        printf("Image %zu: %d,%d %dx%d  %zu bytes LZW-encoded\n", i, image.x, image.y, image.width, image.height, image.lzw_encoded_bytes.size());
+static void copy_frame_rect(Bitmap& destination, const Bitmap& source, const Rect& rect)
+{
+    for (int y = rect.top(); y <= rect.bottom(); ++y)
+        memcpy(destination.scanline(y) + rect.left(), source.scanline(y) + rect.left(), rect.width() * sizeof(RGBA32));
+}
 
-        dbg() << "Decoding frame: " << i + 1 << " of " << context.images.size();
+static Rect frame_rect(const GIFLoadingContext& context, const ImageDescriptor& image)
+{
+    return Rect(image.x, image.y, image.width, image.height).intersected({ 0, 0, context.logical_screen.width, context.logical_screen.height });
+}
 
-        LZWDecoder decoder(image.lzw_encoded_bytes, image.lzw_min_code_size);
+static bool draw_frame(GIFLoadingContext& context, ImageDescriptor& image)
+{
+    size_t pixel_count = (size_t)image.width * image.height;
+    context.color_indices.resize(pixel_count);
 
-        // Add GIF-specific control codes
-        const int clear_code = decoder.add_control_code();
-        const int end_of_information_code = decoder.add_control_code();
+    LZWDecoder decoder(image.lzw_encoded_bytes, image.lzw_min_code_size);
+    auto decoded_count = decoder.decode(context.color_indices.data(), pixel_count);
+    if (!decoded_count.has_value()) {
+        dbg() << "Corrupted LZW stream in gif frame";
+        return false;
+    }
 
-        auto background_rgb = context.logical_screen.color_map[context.background_color_index];
-        Color background_color = Color(background_rgb.r, background_rgb.g, background_rgb.b);
+    RGBA32 palette[256];
+    for (int i = 0; i < 256; ++i) {
+        auto& rgb = context.logical_screen.color_map[i];
+        palette[i] = Color(rgb.r, rgb.g, rgb.b).value();
+    }
 
-        image.bitmap = Bitmap::create_purgeable(BitmapFormat::RGBA32, { context.logical_screen.width, context.logical_screen.height });
-        image.bitmap->fill(background_color);
-        if (i > 0 && image.disposal_method == ImageDescriptor::DisposalMethod::InPlace) {
-            for (int y = 0; y < image.bitmap->height(); ++y) {
-                for (int x = 0; x < image.bitmap->width(); ++x) {
-                    image.bitmap->set_pixel(x, y, context.images.at(i - 1).bitmap->get_pixel(x, y));
-                }
+    auto rect = frame_rect(context, image);
+    auto& bitmap = *context.frame_buffer;
+    for (int y = rect.top(); y <= rect.bottom(); ++y) {
+        size_t row_start = (size_t)(y - image.y) * image.width;
+        if (row_start >= decoded_count.value())
+            break;
+        auto* indices = context.color_indices.data() + row_start + (rect.left() - image.x);
+        auto* pixels = bitmap.scanline(y) + rect.left();
+        int count = min<size_t>(rect.width(), decoded_count.value() - row_start);
+        if (image.transparent) {
+            for (int i = 0; i < count; ++i) {
+                if (indices[i] != image.transparency_index)
+                    pixels[i] = palette[indices[i]];
             }
+        } else {
+            for (int i = 0; i < count; ++i)
+                pixels[i] = palette[indices[i]];
         }
+    }
+    return true;
+}
 
-        int pixel_index = 0;
-        while (true) {
-            Optional<u16> code = decoder.next_code();
-            if (!code.has_value()) {
-                dbg() << "Unexpectedly reached end of gif frame data";
-                return false;
-            }
+// Only the composited result of the most recently decoded frame is kept, in context.frame_buffer. Moving on to
+// the next frame only applies the previous frame's disposal and draws one more image on top, and looping back
+// to the start redraws from the first frame, so playing an animation decodes one frame per step.
+static bool decode_frame(GIFLoadingContext& context, size_t frame_index)
+{
+    if (frame_index >= context.images.size())
+        return false;
 
-            if (code.value() == clear_code) {
-                decoder.reset();
-                continue;
-            } else if (code.value() == end_of_information_code) {
-                break;
-            }
+    if (context.current_frame.has_value() && context.current_frame.value() == frame_index)
+        return true;
 
-            auto colors = decoder.get_output();
+    auto background_rgb = context.logical_screen.color_map[context.background_color_index];
+    RGBA32 background_color = Color(background_rgb.r, background_rgb.g, background_rgb.b).value();
 
-            for (const auto& color : colors) {
-                if (!image.transparent || color != image.transparency_index) {
-                    auto rgb = context.logical_screen.color_map[color];
+    size_t start_index = 0;
+    if (context.current_frame.has_value() && context.current_frame.value() < frame_index) {
+        start_index = context.current_frame.value() + 1;
+    } else {
+        if (!context.frame_buffer) {
+            context.frame_buffer = Bitmap::create_purgeable(BitmapFormat::RGBA32, { context.logical_screen.width, context.logical_screen.height });
+            if (!context.frame_buffer)
+                return false;
+        }
+        context.frame_buffer->fill(Color::from_rgba(background_color));
+    }
 
-                    int x = pixel_index % image.width + image.x;
-                    int y = pixel_index / image.width + image.y;
+    for (size_t i = start_index; i <= frame_index; ++i) {
+        context.current_frame = {};
 
-                    Color c = Color(rgb.r, rgb.g, rgb.b);
-                    image.bitmap->set_pixel(x, y, c);
-                }
-                ++pixel_index;
+        if (i > 0) {
+            auto& previous_image = context.images.at(i - 1);
+            auto previous_rect = frame_rect(context, previous_image);
+            if (previous_image.disposal_method == ImageDescriptor::DisposalMethod::RestoreBackground)
+                fill_frame_rect(*context.frame_buffer, previous_rect, background_color);
+            else if (previous_image.disposal_method == ImageDescriptor::DisposalMethod::RestorePrevious && context.restore_buffer)
+                copy_frame_rect(*context.frame_buffer, *context.restore_buffer, previous_rect);
+        }
+
+        auto& image = context.images.at(i);
+        if (image.disposal_method == ImageDescriptor::DisposalMethod::RestorePrevious) {
+            if (!context.restore_buffer) {
+                context.restore_buffer = Bitmap::create_purgeable(BitmapFormat::RGBA32, context.frame_buffer->size());
+                if (!context.restore_buffer)
+                    return false;
             }
+            copy_frame_rect(*context.restore_buffer, *context.frame_buffer, frame_rect(context, image));
         }
 
-        ++context.frames_decoded;
+        if (!draw_frame(context, image))
+            return false;
+        context.current_frame = i;
     }
 
     return true;
@@ -561,9 +610,10 @@ RefPtr<Gfx::Bitmap> GIFImageDecoderPlugin::bitmap()
 
 void GIFImageDecoderPlugin::set_volatile()
 {
-    for (size_t i = 0; i < m_context->frames_decoded; ++i) {
-        m_context->images.at(i).bitmap->set_volatile();
-    }
+    if (m_context->frame_buffer)
+        m_context->frame_buffer->set_volatile();
+    if (m_context->restore_buffer)
+        m_context->restore_buffer->set_volatile();
 }
 
 bool GIFImageDecoderPlugin::set_nonvolatile()
@@ -573,9 +623,13 @@ bool GIFImageDecoderPlugin::set_nonvolatile()
     }
 
     bool success = true;
-    for (size_t i = 0; i < m_context->frames_decoded; ++i) {
-        success &= m_context->images.at(i).bitmap->set_nonvolatile();
-    }
+    if (m_context->frame_buffer)
+        success &= m_context->frame_buffer->set_nonvolatile();
+    if (m_context->restore_buffer)
+        success &= m_context->restore_buffer->set_nonvolatile();
+    // Whatever was purged has to be composited again from the first frame.
+    if (!success)
+        m_context->current_frame = {};
     return success;
 }
 
@@ -635,13 +689,13 @@ ImageFrameDescriptor GIFImageDecoderPlugin::frame(size_t i)
         }
     }
 
-    if (!decode_frames_up_to_index(*m_context, i)) {
+    if (!decode_frame(*m_context, i)) {
         m_context->state = GIFLoadingContext::State::Error;
         return {};
     }
 
     ImageFrameDescriptor frame {};
-    frame.image = m_context->images.at(i).bitmap;
+    frame.image = m_context->frame_buffer;
     frame.duration = m_context->images.at(i).duration * 10;
 
     if (frame.duration <= 10) {
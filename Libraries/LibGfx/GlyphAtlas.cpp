@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <LibGfx/Font.h>
+#include <LibGfx/GlyphAtlas.h>
+
+namespace Gfx {
+
+GlyphAtlas::GlyphAtlas(const Font& font)
+    : m_font(font)
+{
+    m_entries.resize(font.glyph_count());
+}
+
+const Vector<GlyphAtlas::Span>& GlyphAtlas::spans(u32 codepoint)
+{
+    auto& entry = m_entries[codepoint];
+    if (entry.is_valid)
+        return entry.spans;
+
+    auto bitmap = m_font.glyph_bitmap(codepoint);
+    entry.spans.clear();
+    for (int y = 0; y < bitmap.height(); ++y) {
+        for (int x = 0; x < bitmap.width();) {
+            if (!bitmap.bit_at(x, y)) {
+                ++x;
+                continue;
+            }
+            int start = x;
+            while (x < bitmap.width() && bitmap.bit_at(x, y))
+                ++x;
+            entry.spans.append({ (u8)start, (u8)y, (u8)(x - start) });
+        }
+    }
+    entry.is_valid = true;
+    return entry.spans;
+}
+
+void GlyphAtlas::invalidate(u32 codepoint)
+{
+    if (codepoint < m_entries.size())
+        m_entries[codepoint].is_valid = false;
+}
+
+}
@@ -55,6 +55,8 @@ public:
     virtual bool is_animated() = 0;
     virtual size_t loop_count() = 0;
     virtual size_t frame_count() = 0;
+    // Asking for the frames in order is the cheap way through an animation. Animated decoders may composite
+    // each frame into the bitmap they returned for the previous one.
     virtual ImageFrameDescriptor frame(size_t i) = 0;
 
 protected:
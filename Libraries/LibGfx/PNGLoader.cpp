@@ -28,17 +28,19 @@
 #include <AK/LexicalPath.h>
 #include <AK/MappedFile.h>
 #include <AK/NetworkOrdered.h>
-#include <LibCore/puff.h>
+#include <LibCompress/Inflate.h>
+#include <LibGfx/BlendKernels.h>
 #include <LibGfx/PNGLoader.h>
-#include <LibM/math.h>
 #include <fcntl.h>
-#include <serenity.h>
 #include <stdio.h>
 #include <string.h>
-#include <sys/mman.h>
 #include <sys/stat.h>
 #include <unistd.h>
 
+#if ARCH(I386)
+#    include <emmintrin.h>
+#endif
+
 namespace Gfx {
 
 static const u8 png_header[8] = { 0x89, 'P', 'N', 'G', 13, 10, 26, 10 };
@@ -55,11 +57,6 @@ struct PNG_IHDR {
 
 static_assert(sizeof(PNG_IHDR) == 13);
 
-struct Scanline {
-    u8 filter { 0 };
-    ByteBuffer data {};
-};
-
 struct [[gnu::packed]] PaletteEntry
 {
     u8 r;
@@ -68,40 +65,6 @@ struct [[gnu::packed]] PaletteEntry
     //u8 a;
 };
 
-struct [[gnu::packed]] Tuple
-{
-    u8 gray;
-    u8 a;
-};
-
-struct [[gnu::packed]] Tuple16
-{
-    u16 gray;
-    u16 a;
-};
-
-struct [[gnu::packed]] Triplet
-{
-    u8 r;
-    u8 g;
-    u8 b;
-};
-
-struct [[gnu::packed]] Triplet16
-{
-    u16 r;
-    u16 g;
-    u16 b;
-};
-
-struct [[gnu::packed]] Quad16
-{
-    u16 r;
-    u16 g;
-    u16 b;
-    u16 a;
-};
-
 struct PNGLoadingContext {
     enum State {
         NotDecoded = 0,
@@ -124,10 +87,7 @@ struct PNGLoadingContext {
     u8 channels { 0 };
     bool has_seen_zlib_header { false };
     bool has_alpha() const { return color_type & 4 || palette_transparency_data.size() > 0; }
-    Vector<Scanline> scanlines;
     RefPtr<Gfx::Bitmap> bitmap;
-    u8* decompression_buffer { nullptr };
-    int decompression_buffer_size { 0 };
     Vector<u8> compressed_data;
     Vector<PaletteEntry> palette_data;
     Vector<u8> palette_transparency_data;
@@ -184,7 +144,7 @@ private:
 };
 
 static RefPtr<Gfx::Bitmap> load_png_impl(const u8*, int);
-static bool process_chunk(Streamer&, PNGLoadingContext& context, bool decode_size_only);
+static bool process_chunk(Streamer&, PNGLoadingContext& context);
 
 RefPtr<Gfx::Bitmap> load_png(const StringView& path)
 {
@@ -218,305 +178,211 @@ ALWAYS_INLINE static u8 paeth_predictor(int a, int b, int c)
     return c;
 }
 
-union [[gnu::packed]] Pixel
+// Reverses the filter of one row in place. `previous` is the already unfiltered row above it (all zeroes for
+// the first row of a pass), and `bpp` is the distance in bytes to the corresponding byte of the pixel on the left.
+static void unfilter_row_generic(u8 filter, u8* row, const u8* previous, size_t size, size_t bpp)
 {
-    RGBA32 rgba { 0 };
-    u8 v[4];
-    struct {
-        u8 r;
-        u8 g;
-        u8 b;
-        u8 a;
-    };
-};
-static_assert(sizeof(Pixel) == 4);
+    switch (filter) {
+    case 1:
+        for (size_t i = bpp; i < size; ++i)
+            row[i] += row[i - bpp];
+        break;
+    case 2:
+        for (size_t i = 0; i < size; ++i)
+            row[i] += previous[i];
+        break;
+    case 3:
+        for (size_t i = 0; i < bpp; ++i)
+            row[i] += previous[i] / 2;
+        for (size_t i = bpp; i < size; ++i)
+            row[i] += (row[i - bpp] + previous[i]) / 2;
+        break;
+    case 4:
+        for (size_t i = 0; i < bpp; ++i)
+            row[i] += previous[i];
+        for (size_t i = bpp; i < size; ++i)
+            row[i] += paeth_predictor(row[i - bpp], previous[i], previous[i - bpp]);
+        break;
+    }
+}
 
-template<bool has_alpha, u8 filter_type>
-ALWAYS_INLINE static void unfilter_impl(Gfx::Bitmap& bitmap, int y, const void* dummy_scanline_data)
+#if ARCH(I386)
+// Sub, Avg and Paeth carry a dependency from each pixel to the next, so these handle one whole 3- or 4-byte pixel
+// per step instead of one byte, which is where nearly all 8-bit RGB and RGBA images spend their unfiltering time.
+[[gnu::target("sse2")]] ALWAYS_INLINE static __m128i load_pixel(const u8* p, size_t bpp)
 {
-    auto* dummy_scanline = (const Pixel*)dummy_scanline_data;
-    if constexpr (filter_type == 0) {
-        auto* pixels = (Pixel*)bitmap.scanline(y);
-        for (int i = 0; i < bitmap.width(); ++i) {
-            auto& x = pixels[i];
-            swap(x.r, x.b);
-        }
-    }
+    u32 value = 0;
+    memcpy(&value, p, bpp);
+    return _mm_cvtsi32_si128(value);
+}
 
-    if constexpr (filter_type == 1) {
-        auto* pixels = (Pixel*)bitmap.scanline(y);
-        swap(pixels[0].r, pixels[0].b);
-        for (int i = 1; i < bitmap.width(); ++i) {
-            auto& x = pixels[i];
-            swap(x.r, x.b);
-            auto& a = (const Pixel&)pixels[i - 1];
-            x.v[0] += a.v[0];
-            x.v[1] += a.v[1];
-            x.v[2] += a.v[2];
-            if constexpr (has_alpha)
-                x.v[3] += a.v[3];
-        }
-        return;
-    }
-    if constexpr (filter_type == 2) {
-        auto* pixels = (Pixel*)bitmap.scanline(y);
-        auto* pixels_y_minus_1 = y == 0 ? dummy_scanline : (Pixel*)bitmap.scanline(y - 1);
-        for (int i = 0; i < bitmap.width(); ++i) {
-            auto& x = pixels[i];
-            swap(x.r, x.b);
-            const Pixel& b = pixels_y_minus_1[i];
-            x.v[0] += b.v[0];
-            x.v[1] += b.v[1];
-            x.v[2] += b.v[2];
-            if constexpr (has_alpha)
-                x.v[3] += b.v[3];
+[[gnu::target("sse2")]] ALWAYS_INLINE static void store_pixel(u8* p, __m128i pixel, size_t bpp)
+{
+    u32 value = _mm_cvtsi128_si32(pixel);
+    memcpy(p, &value, bpp);
+}
+
+[[gnu::target("sse2")]] static void unfilter_row_sse2(u8 filter, u8* row, const u8* previous, size_t size, size_t bpp)
+{
+    auto zero = _mm_setzero_si128();
+    switch (filter) {
+    case 1: {
+        auto a = zero;
+        for (size_t i = 0; i < size; i += bpp) {
+            a = _mm_add_epi8(load_pixel(row + i, bpp), a);
+            store_pixel(row + i, a, bpp);
         }
-        return;
-    }
-    if constexpr (filter_type == 3) {
-        auto* pixels = (Pixel*)bitmap.scanline(y);
-        auto* pixels_y_minus_1 = y == 0 ? dummy_scanline : (Pixel*)bitmap.scanline(y - 1);
-        for (int i = 0; i < bitmap.width(); ++i) {
-            auto& x = pixels[i];
-            swap(x.r, x.b);
-            Pixel a;
-            if (i != 0)
-                a = pixels[i - 1];
-            const Pixel& b = pixels_y_minus_1[i];
-            x.v[0] = x.v[0] + ((a.v[0] + b.v[0]) / 2);
-            x.v[1] = x.v[1] + ((a.v[1] + b.v[1]) / 2);
-            x.v[2] = x.v[2] + ((a.v[2] + b.v[2]) / 2);
-            if constexpr (has_alpha)
-                x.v[3] = x.v[3] + ((a.v[3] + b.v[3]) / 2);
+        break;
+    }
+    case 3: {
+        // (a + b) / 2 without widening: the rounding average, minus the bit it rounded up.
+        auto ones = _mm_set1_epi8(1);
+        auto a = zero;
+        for (size_t i = 0; i < size; i += bpp) {
+            auto b = load_pixel(previous + i, bpp);
+            auto average = _mm_sub_epi8(_mm_avg_epu8(a, b), _mm_and_si128(_mm_xor_si128(a, b), ones));
+            a = _mm_add_epi8(load_pixel(row + i, bpp), average);
+            store_pixel(row + i, a, bpp);
         }
-        return;
-    }
-    if constexpr (filter_type == 4) {
-        auto* pixels = (Pixel*)bitmap.scanline(y);
-        auto* pixels_y_minus_1 = y == 0 ? dummy_scanline : (Pixel*)bitmap.scanline(y - 1);
-        for (int i = 0; i < bitmap.width(); ++i) {
-            auto& x = pixels[i];
-            swap(x.r, x.b);
-            Pixel a;
-            const Pixel& b = pixels_y_minus_1[i];
-            Pixel c;
-            if (i != 0) {
-                a = pixels[i - 1];
-                c = pixels_y_minus_1[i - 1];
-            }
-            x.v[0] += paeth_predictor(a.v[0], b.v[0], c.v[0]);
-            x.v[1] += paeth_predictor(a.v[1], b.v[1], c.v[1]);
-            x.v[2] += paeth_predictor(a.v[2], b.v[2], c.v[2]);
-            if constexpr (has_alpha)
-                x.v[3] += paeth_predictor(a.v[3], b.v[3], c.v[3]);
+        break;
+    }
+    case 4: {
+        // The predictor in 16-bit lanes: pa = |b - c|, pb = |a - c| and pc = |(b - c) + (a - c)| are the
+        // distances from p = a + b - c to a, b and c respectively.
+        auto a = zero;
+        auto b = zero;
+        auto c = zero;
+        auto x = zero;
+        for (size_t i = 0; i < size; i += bpp) {
+            c = b;
+            b = _mm_unpacklo_epi8(load_pixel(previous + i, bpp), zero);
+            a = x;
+            x = _mm_unpacklo_epi8(load_pixel(row + i, bpp), zero);
+
+            auto pa = _mm_sub_epi16(b, c);
+            auto pb = _mm_sub_epi16(a, c);
+            auto pc = _mm_add_epi16(pa, pb);
+            pa = _mm_max_epi16(pa, _mm_sub_epi16(zero, pa));
+            pb = _mm_max_epi16(pb, _mm_sub_epi16(zero, pb));
+            pc = _mm_max_epi16(pc, _mm_sub_epi16(zero, pc));
+
+            auto smallest = _mm_min_epi16(pc, _mm_min_epi16(pa, pb));
+            auto use_a = _mm_cmpeq_epi16(pa, smallest);
+            auto use_b = _mm_andnot_si128(use_a, _mm_cmpeq_epi16(pb, smallest));
+            auto use_c = _mm_andnot_si128(_mm_or_si128(use_a, use_b), _mm_set1_epi16(-1));
+            auto predictor = _mm_or_si128(_mm_or_si128(_mm_and_si128(use_a, a), _mm_and_si128(use_b, b)), _mm_and_si128(use_c, c));
+
+            // Adding bytewise keeps the sum modulo 256 in the low byte and leaves the high byte zero.
+            x = _mm_add_epi8(x, predictor);
+            store_pixel(row + i, _mm_packus_epi16(x, x), bpp);
         }
+        break;
+    }
+    default:
+        unfilter_row_generic(filter, row, previous, size, bpp);
+        break;
     }
 }
+#endif
 
-NEVER_INLINE FLATTEN static void unfilter(PNGLoadingContext& context)
+static bool unfilter_row(u8 filter, u8* row, const u8* previous, size_t size, size_t bpp)
 {
-    // First unpack the scanlines to RGBA:
+    if (filter > 4)
+        return false;
+    if (filter == 0)
+        return true;
+#if ARCH(I386)
+    if ((bpp == 3 || bpp == 4) && BlendKernels::cpu_supports_sse2()) {
+        unfilter_row_sse2(filter, row, previous, size, bpp);
+        return true;
+    }
+#endif
+    unfilter_row_generic(filter, row, previous, size, bpp);
+    return true;
+}
+
+ALWAYS_INLINE static u8 sample_at(const u8* row, int index, int bit_depth)
+{
+    auto bit_offset = index * bit_depth;
+    auto mask = (1 << bit_depth) - 1;
+    return (row[bit_offset / 8] >> (8 - bit_depth - bit_offset % 8)) & mask;
+}
+
+// Converts one unfiltered row of samples into pixels x, x + dx, x + 2 * dx, ... of scanline y. Channels deeper
+// than 8 bits are big-endian, so their high byte comes first.
+static bool convert_row(PNGLoadingContext& context, const u8* row, int count, int y, int x, int dx)
+{
+    auto* pixels = context.bitmap->scanline(y);
+    int bytes_per_sample = context.bit_depth == 16 ? 2 : 1;
+
     switch (context.color_type) {
     case 0:
-        if (context.bit_depth == 8) {
-            for (int y = 0; y < context.height; ++y) {
-                auto* gray_values = (u8*)context.scanlines[y].data.data();
-                for (int i = 0; i < context.width; ++i) {
-                    auto& pixel = (Pixel&)context.bitmap->scanline(y)[i];
-                    pixel.r = gray_values[i];
-                    pixel.g = gray_values[i];
-                    pixel.b = gray_values[i];
-                    pixel.a = 0xff;
-                }
-            }
-        } else if (context.bit_depth == 16) {
-            for (int y = 0; y < context.height; ++y) {
-                auto* gray_values = (u16*)context.scanlines[y].data.data();
-                for (int i = 0; i < context.width; ++i) {
-                    auto& pixel = (Pixel&)context.bitmap->scanline(y)[i];
-                    pixel.r = gray_values[i] & 0xFF;
-                    pixel.g = gray_values[i] & 0xFF;
-                    pixel.b = gray_values[i] & 0xFF;
-                    pixel.a = 0xff;
-                }
-            }
-        } else if (context.bit_depth == 1 || context.bit_depth == 2 || context.bit_depth == 4) {
-            auto pixels_per_byte = 8 / context.bit_depth;
+        if (context.bit_depth < 8) {
             auto mask = (1 << context.bit_depth) - 1;
-            for (int y = 0; y < context.height; ++y) {
-                auto* gray_values = (u8*)context.scanlines[y].data.data();
-                for (int i = 0; i < context.width; ++i) {
-                    auto bit_offset = (8 - context.bit_depth) - (context.bit_depth * (i % pixels_per_byte));
-                    auto value = (gray_values[i / pixels_per_byte] >> bit_offset) & mask;
-                    auto& pixel = (Pixel&)context.bitmap->scanline(y)[i];
-                    pixel.r = value * (0xff / pow(context.bit_depth, 2));
-                    pixel.g = value * (0xff / pow(context.bit_depth, 2));
-                    pixel.b = value * (0xff / pow(context.bit_depth, 2));
-                    pixel.a = 0xff;
-                }
+            for (int i = 0; i < count; ++i, x += dx) {
+                u8 gray = sample_at(row, i, context.bit_depth) * 255 / mask;
+                pixels[x] = Color(gray, gray, gray).value();
             }
-        } else {
-            ASSERT_NOT_REACHED();
+            break;
+        }
+        for (int i = 0; i < count; ++i, x += dx) {
+            u8 gray = row[i * bytes_per_sample];
+            pixels[x] = Color(gray, gray, gray).value();
         }
         break;
     case 4:
-        if (context.bit_depth == 8) {
-            for (int y = 0; y < context.height; ++y) {
-                auto* tuples = (Tuple*)context.scanlines[y].data.data();
-                for (int i = 0; i < context.width; ++i) {
-                    auto& pixel = (Pixel&)context.bitmap->scanline(y)[i];
-                    pixel.r = tuples[i].gray;
-                    pixel.g = tuples[i].gray;
-                    pixel.b = tuples[i].gray;
-                    pixel.a = tuples[i].a;
-                }
-            }
-        } else if (context.bit_depth == 16) {
-            for (int y = 0; y < context.height; ++y) {
-                auto* tuples = (Tuple16*)context.scanlines[y].data.data();
-                for (int i = 0; i < context.width; ++i) {
-                    auto& pixel = (Pixel&)context.bitmap->scanline(y)[i];
-                    pixel.r = tuples[i].gray & 0xFF;
-                    pixel.g = tuples[i].gray & 0xFF;
-                    pixel.b = tuples[i].gray & 0xFF;
-                    pixel.a = tuples[i].a & 0xFF;
-                }
-            }
-        } else {
-            ASSERT_NOT_REACHED();
+        for (int i = 0; i < count; ++i, x += dx) {
+            auto* sample = row + i * 2 * bytes_per_sample;
+            pixels[x] = Color(sample[0], sample[0], sample[0], sample[bytes_per_sample]).value();
         }
         break;
     case 2:
-        if (context.bit_depth == 8) {
-            for (int y = 0; y < context.height; ++y) {
-                auto* triplets = (Triplet*)context.scanlines[y].data.data();
-                for (int i = 0; i < context.width; ++i) {
-                    auto& pixel = (Pixel&)context.bitmap->scanline(y)[i];
-                    pixel.r = triplets[i].r;
-                    pixel.g = triplets[i].g;
-                    pixel.b = triplets[i].b;
-                    pixel.a = 0xff;
-                }
-            }
-        } else if (context.bit_depth == 16) {
-            for (int y = 0; y < context.height; ++y) {
-                auto* triplets = (Triplet16*)context.scanlines[y].data.data();
-                for (int i = 0; i < context.width; ++i) {
-                    auto& pixel = (Pixel&)context.bitmap->scanline(y)[i];
-                    pixel.r = triplets[i].r & 0xFF;
-                    pixel.g = triplets[i].g & 0xFF;
-                    pixel.b = triplets[i].b & 0xFF;
-                    pixel.a = 0xff;
-                }
-            }
-        } else {
-            ASSERT_NOT_REACHED();
+        for (int i = 0; i < count; ++i, x += dx) {
+            auto* sample = row + i * 3 * bytes_per_sample;
+            pixels[x] = Color(sample[0], sample[bytes_per_sample], sample[2 * bytes_per_sample]).value();
         }
         break;
     case 6:
-        if (context.bit_depth == 8) {
-            for (int y = 0; y < context.height; ++y) {
-                memcpy(context.bitmap->scanline(y), context.scanlines[y].data.data(), context.scanlines[y].data.size());
-            }
-        } else if (context.bit_depth == 16) {
-            for (int y = 0; y < context.height; ++y) {
-                auto* triplets = (Quad16*)context.scanlines[y].data.data();
-                for (int i = 0; i < context.width; ++i) {
-                    auto& pixel = (Pixel&)context.bitmap->scanline(y)[i];
-                    pixel.r = triplets[i].r & 0xFF;
-                    pixel.g = triplets[i].g & 0xFF;
-                    pixel.b = triplets[i].b & 0xFF;
-                    pixel.a = triplets[i].a & 0xFF;
-                }
-            }
-        } else {
-            ASSERT_NOT_REACHED();
+        for (int i = 0; i < count; ++i, x += dx) {
+            auto* sample = row + i * 4 * bytes_per_sample;
+            pixels[x] = Color(sample[0], sample[bytes_per_sample], sample[2 * bytes_per_sample], sample[3 * bytes_per_sample]).value();
         }
         break;
     case 3:
-        if (context.bit_depth == 8) {
-            for (int y = 0; y < context.height; ++y) {
-                auto* palette_index = (u8*)context.scanlines[y].data.data();
-                for (int i = 0; i < context.width; ++i) {
-                    auto& pixel = (Pixel&)context.bitmap->scanline(y)[i];
-                    auto& color = context.palette_data.at((int)palette_index[i]);
-                    auto transparency = context.palette_transparency_data.size() >= palette_index[i] + 1u
-                        ? context.palette_transparency_data.data()[palette_index[i]]
-                        : 0xff;
-                    pixel.r = color.r;
-                    pixel.g = color.g;
-                    pixel.b = color.b;
-                    pixel.a = transparency;
-                }
-            }
-        } else if (context.bit_depth == 1 || context.bit_depth == 2 || context.bit_depth == 4) {
-            auto pixels_per_byte = 8 / context.bit_depth;
-            auto mask = (1 << context.bit_depth) - 1;
-            for (int y = 0; y < context.height; ++y) {
-                auto* palette_indexes = (u8*)context.scanlines[y].data.data();
-                for (int i = 0; i < context.width; ++i) {
-                    auto bit_offset = (8 - context.bit_depth) - (context.bit_depth * (i % pixels_per_byte));
-                    auto palette_index = (palette_indexes[i / pixels_per_byte] >> bit_offset) & mask;
-                    auto& pixel = (Pixel&)context.bitmap->scanline(y)[i];
-                    auto& color = context.palette_data.at(palette_index);
-                    auto transparency = context.palette_transparency_data.size() >= palette_index + 1u
-                        ? context.palette_transparency_data.data()[palette_index]
-                        : 0xff;
-                    pixel.r = color.r;
-                    pixel.g = color.g;
-                    pixel.b = color.b;
-                    pixel.a = transparency;
-                }
-            }
-        } else {
-            ASSERT_NOT_REACHED();
+        for (int i = 0; i < count; ++i, x += dx) {
+            u8 index = context.bit_depth == 8 ? row[i] : sample_at(row, i, context.bit_depth);
+            if (index >= context.palette_data.size())
+                return false;
+            auto& color = context.palette_data[index];
+            u8 alpha = index < context.palette_transparency_data.size() ? context.palette_transparency_data[index] : 0xff;
+            pixels[x] = Color(color.r, color.g, color.b, alpha).value();
         }
         break;
     default:
         ASSERT_NOT_REACHED();
-        break;
     }
+    return true;
+}
 
-    auto dummy_scanline = ByteBuffer::create_zeroed(context.width * sizeof(RGBA32));
+// Pulls the rows of one (sub-)image out of the inflater, unfilters each against the previous one and writes
+// its pixels straight into the bitmap, so only two rows of decompressed data are ever held in memory.
+static bool decode_pass(PNGLoadingContext& context, Compress::Inflater& inflater, Vector<u8>& current, Vector<u8>& previous, int width, int height, int x, int y, int dx, int dy)
+{
+    size_t row_size = ((size_t)width * context.channels * context.bit_depth + 7) / 8;
+    size_t bpp = max<size_t>(1, context.channels * context.bit_depth / 8);
 
-    for (int y = 0; y < context.height; ++y) {
-        auto filter = context.scanlines[y].filter;
-        if (filter == 0) {
-            if (context.has_alpha())
-                unfilter_impl<true, 0>(*context.bitmap, y, dummy_scanline.data());
-            else
-                unfilter_impl<false, 0>(*context.bitmap, y, dummy_scanline.data());
-            continue;
-        }
-        if (filter == 1) {
-            if (context.has_alpha())
-                unfilter_impl<true, 1>(*context.bitmap, y, dummy_scanline.data());
-            else
-                unfilter_impl<false, 1>(*context.bitmap, y, dummy_scanline.data());
-            continue;
-        }
-        if (filter == 2) {
-            if (context.has_alpha())
-                unfilter_impl<true, 2>(*context.bitmap, y, dummy_scanline.data());
-            else
-                unfilter_impl<false, 2>(*context.bitmap, y, dummy_scanline.data());
-            continue;
-        }
-        if (filter == 3) {
-            if (context.has_alpha())
-                unfilter_impl<true, 3>(*context.bitmap, y, dummy_scanline.data());
-            else
-                unfilter_impl<false, 3>(*context.bitmap, y, dummy_scanline.data());
-            continue;
-        }
-        if (filter == 4) {
-            if (context.has_alpha())
-                unfilter_impl<true, 4>(*context.bitmap, y, dummy_scanline.data());
-            else
-                unfilter_impl<false, 4>(*context.bitmap, y, dummy_scanline.data());
-            continue;
-        }
+    // Each buffer holds the filter byte followed by the row.
+    __builtin_memset(previous.data(), 0, row_size + 1);
+    for (int row = 0; row < height; ++row, y += dy) {
+        if (inflater.read(current.data(), row_size + 1) != row_size + 1)
+            return false;
+        if (!unfilter_row(current[0], current.data() + 1, previous.data() + 1, row_size, bpp))
+            return false;
+        if (!convert_row(context, current.data() + 1, width, y, x, dx))
+            return false;
+        swap(current, previous);
     }
+    return true;
 }
 
 static bool decode_png_header(PNGLoadingContext& context)
@@ -555,7 +421,7 @@ static bool decode_png_size(PNGLoadingContext& context)
 
     Streamer streamer(data_ptr, data_remaining);
     while (!streamer.at_end()) {
-        if (!process_chunk(streamer, context, true)) {
+        if (!process_chunk(streamer, context)) {
             context.state = PNGLoadingContext::State::Error;
             return false;
         }
@@ -585,7 +451,7 @@ static bool decode_png_chunks(PNGLoadingContext& context)
 
     Streamer streamer(data_ptr, data_remaining);
     while (!streamer.at_end()) {
-        if (!process_chunk(streamer, context, false)) {
+        if (!process_chunk(streamer, context)) {
             context.state = PNGLoadingContext::State::Error;
             return false;
         }
@@ -605,40 +471,51 @@ static bool decode_png_bitmap(PNGLoadingContext& context)
     if (context.state >= PNGLoadingContext::State::BitmapDecoded)
         return true;
 
-    unsigned long srclen = context.compressed_data.size() - 6;
-    unsigned long destlen = context.decompression_buffer_size;
-    int ret = puff(context.decompression_buffer, &destlen, context.compressed_data.data() + 2, &srclen);
-    if (ret < 0) {
+    // Skip the two-byte zlib header; the inflater stops by itself at the end of the stream, before the checksum.
+    if (context.compressed_data.size() < 2) {
         context.state = PNGLoadingContext::State::Error;
         return false;
     }
-    context.compressed_data.clear();
 
-    context.scanlines.ensure_capacity(context.height);
-    Streamer streamer(context.decompression_buffer, context.decompression_buffer_size);
-    for (int y = 0; y < context.height; ++y) {
-        u8 filter;
-        if (!streamer.read(filter)) {
-            context.state = PNGLoadingContext::State::Error;
-            return false;
-        }
+    context.bitmap = Bitmap::create_purgeable(context.has_alpha() ? BitmapFormat::RGBA32 : BitmapFormat::RGB32, { context.width, context.height });
+    if (!context.bitmap) {
+        context.state = PNGLoadingContext::State::Error;
+        return false;
+    }
 
-        context.scanlines.append({ filter });
-        auto& scanline_buffer = context.scanlines.last().data;
-        auto row_size = ((context.width * context.channels * context.bit_depth) + 7) / 8;
-        if (!streamer.wrap_bytes(scanline_buffer, row_size)) {
-            context.state = PNGLoadingContext::State::Error;
-            return false;
+    Compress::Inflater inflater(context.compressed_data.data() + 2, context.compressed_data.size() - 2);
+
+    size_t max_row_size = ((size_t)context.width * context.channels * context.bit_depth + 7) / 8 + 1;
+    Vector<u8> current;
+    Vector<u8> previous;
+    current.resize(max_row_size);
+    previous.resize(max_row_size);
+
+    bool success = true;
+    if (context.interlace_method == 0) {
+        success = decode_pass(context, inflater, current, previous, context.width, context.height, 0, 0, 1, 1);
+    } else {
+        // Adam7 stores seven progressively finer sub-images, each of which lands on a regular grid of the final image.
+        static constexpr int starting_row[7] = { 0, 0, 4, 0, 2, 0, 1 };
+        static constexpr int starting_col[7] = { 0, 4, 0, 2, 0, 1, 0 };
+        static constexpr int row_increment[7] = { 8, 8, 8, 4, 4, 2, 2 };
+        static constexpr int col_increment[7] = { 8, 8, 4, 4, 2, 2, 1 };
+        for (int pass = 0; pass < 7 && success; ++pass) {
+            int width = (context.width - starting_col[pass] + col_increment[pass] - 1) / col_increment[pass];
+            int height = (context.height - starting_row[pass] + row_increment[pass] - 1) / row_increment[pass];
+            // Passes that don't reach any pixel are absent from the stream altogether.
+            if (width <= 0 || height <= 0)
+                continue;
+            success = decode_pass(context, inflater, current, previous, width, height, starting_col[pass], starting_row[pass], col_increment[pass], row_increment[pass]);
         }
     }
 
-    context.bitmap = Bitmap::create_purgeable(context.has_alpha() ? BitmapFormat::RGBA32 : BitmapFormat::RGB32, { context.width, context.height });
-
-    unfilter(context);
-
-    munmap(context.decompression_buffer, context.decompression_buffer_size);
-    context.decompression_buffer = nullptr;
-    context.decompression_buffer_size = 0;
+    context.compressed_data.clear();
+    if (!success) {
+        context.bitmap = nullptr;
+        context.state = PNGLoadingContext::State::Error;
+        return false;
+    }
 
     context.state = PNGLoadingContext::State::BitmapDecoded;
     return true;
@@ -659,7 +536,7 @@ static RefPtr<Gfx::Bitmap> load_png_impl(const u8* data, int data_size)
     return context.bitmap;
 }
 
-static bool process_IHDR(const ByteBuffer& data, PNGLoadingContext& context, bool decode_size_only = false)
+static bool process_IHDR(const ByteBuffer& data, PNGLoadingContext& context)
 {
     if (data.size() < (int)sizeof(PNG_IHDR))
         return false;
@@ -680,11 +557,8 @@ static bool process_IHDR(const ByteBuffer& data, PNGLoadingContext& context, boo
     printf(" Interlace type: %d\n", context.interlace_method);
 #endif
 
-    // FIXME: Implement Adam7 deinterlacing
-    if (context.interlace_method != 0) {
-        dbgprintf("PNGLoader::process_IHDR: Interlaced PNGs not currently supported.\n");
+    if (context.interlace_method > 1)
         return false;
-    }
 
     switch (context.color_type) {
     case 0: // Each pixel is a grayscale sample.
@@ -706,12 +580,24 @@ static bool process_IHDR(const ByteBuffer& data, PNGLoadingContext& context, boo
         ASSERT_NOT_REACHED();
     }
 
-    if (!decode_size_only) {
-        // Calculate number of bytes per row (+1 for filter)
-        auto row_size = ((context.width * context.channels * context.bit_depth) + 7) / 8 + 1;
-        context.decompression_buffer_size = row_size * context.height;
-        context.decompression_buffer = (u8*)mmap_with_name(nullptr, context.decompression_buffer_size, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, 0, 0, "PNG decompression buffer");
+    // Only grayscale and palette images pack several samples into a byte, and palette indices are at most 8 bits.
+    switch (context.bit_depth) {
+    case 1:
+    case 2:
+    case 4:
+        if (context.color_type != 0 && context.color_type != 3)
+            return false;
+        break;
+    case 8:
+        break;
+    case 16:
+        if (context.color_type == 3)
+            return false;
+        break;
+    default:
+        return false;
     }
+
     return true;
 }
 
@@ -737,7 +623,7 @@ static bool process_tRNS(const ByteBuffer& data, PNGLoadingContext& context)
     return true;
 }
 
-static bool process_chunk(Streamer& streamer, PNGLoadingContext& context, bool decode_size_only)
+static bool process_chunk(Streamer& streamer, PNGLoadingContext& context)
 {
     u32 chunk_size;
     if (!streamer.read(chunk_size)) {
@@ -765,7 +651,7 @@ static bool process_chunk(Streamer& streamer, PNGLoadingContext& context, bool d
 #endif
 
     if (!strcmp((const char*)chunk_type, "IHDR"))
-        return process_IHDR(chunk_data, context, decode_size_only);
+        return process_IHDR(chunk_data, context);
     if (!strcmp((const char*)chunk_type, "IDAT"))
         return process_IDAT(chunk_data, context);
     if (!strcmp((const char*)chunk_type, "PLTE"))
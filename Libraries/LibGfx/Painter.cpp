@@ -31,13 +31,16 @@
 #include <AK/Assertions.h>
 #include <AK/Function.h>
 #include <AK/Memory.h>
-#include <AK/QuickSort.h>
 #include <AK/StdLibExtras.h>
 #include <AK/StringBuilder.h>
 #include <AK/Utf32View.h>
 #include <AK/Utf8View.h>
+#include <LibGfx/BlendKernels.h>
 #include <LibGfx/CharacterBitmap.h>
+#include <LibGfx/DisplayList.h>
+#include <LibGfx/GlyphAtlas.h>
 #include <LibGfx/Path.h>
+#include <LibGfx/PathRasterizer.h>
 #include <math.h>
 #include <stdio.h>
 #include <unistd.h>
@@ -57,9 +60,19 @@ ALWAYS_INLINE Color get_pixel(const Gfx::Bitmap& bitmap, int x, int y)
         return Color::from_rgb(bitmap.scanline(y)[x]);
     if constexpr (format == BitmapFormat::RGBA32)
         return Color::from_rgba(bitmap.scanline(y)[x]);
+    if constexpr (format == BitmapFormat::RGBA32Premultiplied)
+        return Color::from_premultiplied_rgba(bitmap.scanline(y)[x]);
     return bitmap.get_pixel(x, y);
 }
 
+// Reads a pixel from a 32-bit bitmap with alpha, in whichever alpha format it's stored.
+ALWAYS_INLINE static Color color_with_alpha(const Gfx::Bitmap& bitmap, RGBA32 pixel)
+{
+    if (bitmap.format() == BitmapFormat::RGBA32Premultiplied)
+        return Color::from_premultiplied_rgba(pixel);
+    return Color::from_rgba(pixel);
+}
+
 Painter::Painter(Gfx::Bitmap& bitmap)
     : m_target(bitmap)
 {
@@ -91,6 +104,12 @@ void Painter::fill_rect_with_draw_op(const Rect& a_rect, Color color)
 
 void Painter::clear_rect(const Rect& a_rect, Color color)
 {
+    if (m_display_list) {
+        auto& command = m_display_list->append(DisplayList::Type::ClearRect, state());
+        command.rect = a_rect;
+        command.color = color;
+        return;
+    }
     auto rect = a_rect.translated(translation()).intersected(clip_rect());
     if (rect.is_empty())
         return;
@@ -108,6 +127,12 @@ void Painter::clear_rect(const Rect& a_rect, Color color)
 
 void Painter::fill_rect(const Rect& a_rect, Color color)
 {
+    if (m_display_list) {
+        auto& command = m_display_list->append(DisplayList::Type::FillRect, state());
+        command.rect = a_rect;
+        command.color = color;
+        return;
+    }
     if (color.alpha() == 0)
         return;
 
@@ -139,16 +164,27 @@ void Painter::fill_rect(const Rect& a_rect, Color color)
 
 void Painter::fill_rect_with_dither_pattern(const Rect& a_rect, Color color_a, Color color_b)
 {
-    auto rect = a_rect.translated(translation()).intersected(clip_rect());
+    if (m_display_list) {
+        auto& command = m_display_list->append(DisplayList::Type::FillRectWithDitherPattern, state());
+        command.rect = a_rect;
+        command.color = color_a;
+        command.second_color = color_b;
+        return;
+    }
+    auto translated_rect = a_rect.translated(translation());
+    auto rect = translated_rect.intersected(clip_rect());
     if (rect.is_empty())
         return;
 
+    // Like the checkerboard, the pattern starts at the corner of the whole rect rather than the clipped part.
+    int first_row = rect.top() - translated_rect.top();
+    int first_column = rect.left() - translated_rect.left();
     RGBA32* dst = m_target->scanline(rect.top()) + rect.left();
     const size_t dst_skip = m_target->pitch() / sizeof(RGBA32);
 
     for (int i = 0; i < rect.height(); ++i) {
         for (int j = 0; j < rect.width(); ++j) {
-            bool checkboard_use_a = (i & 1) ^ (j & 1);
+            bool checkboard_use_a = ((first_row + i) & 1) ^ ((first_column + j) & 1);
             dst[j] = checkboard_use_a ? color_a.value() : color_b.value();
         }
         dst += dst_skip;
@@ -157,17 +193,29 @@ void Painter::fill_rect_with_dither_pattern(const Rect& a_rect, Color color_a, C
 
 void Painter::fill_rect_with_checkerboard(const Rect& a_rect, const Size& cell_size, Color color_dark, Color color_light)
 {
-    auto rect = a_rect.translated(translation()).intersected(clip_rect());
+    if (m_display_list) {
+        auto& command = m_display_list->append(DisplayList::Type::FillRectWithCheckerboard, state());
+        command.rect = a_rect;
+        command.source_rect.set_size(cell_size);
+        command.color = color_dark;
+        command.second_color = color_light;
+        return;
+    }
+    auto translated_rect = a_rect.translated(translation());
+    auto rect = translated_rect.intersected(clip_rect());
     if (rect.is_empty())
         return;
 
+    // The cells are laid out from the corner of the whole rect, however much of it is clipped away.
+    int first_row = rect.top() - translated_rect.top();
+    int first_column = rect.left() - translated_rect.left();
     RGBA32* dst = m_target->scanline(rect.top()) + rect.left();
     const size_t dst_skip = m_target->pitch() / sizeof(RGBA32);
 
     for (int i = 0; i < rect.height(); ++i) {
         for (int j = 0; j < rect.width(); ++j) {
-            int cell_row = i / cell_size.height();
-            int cell_col = j / cell_size.width();
+            int cell_row = (first_row + i) / cell_size.height();
+            int cell_col = (first_column + j) / cell_size.width();
             dst[j] = ((cell_row % 2) ^ (cell_col % 2)) ? color_light.value() : color_dark.value();
         }
         dst += dst_skip;
@@ -176,6 +224,14 @@ void Painter::fill_rect_with_checkerboard(const Rect& a_rect, const Size& cell_s
 
 void Painter::fill_rect_with_gradient(Orientation orientation, const Rect& a_rect, Color gradient_start, Color gradient_end)
 {
+    if (m_display_list) {
+        auto& command = m_display_list->append(DisplayList::Type::FillRectWithGradient, state());
+        command.mode = (u8)orientation;
+        command.rect = a_rect;
+        command.color = gradient_start;
+        command.second_color = gradient_end;
+        return;
+    }
 #ifdef NO_FPU
     return fill_rect(a_rect, gradient_start);
 #endif
@@ -234,6 +290,8 @@ void Painter::fill_rect_with_gradient(const Rect& a_rect, Color gradient_start,
 
 void Painter::fill_ellipse(const Rect& a_rect, Color color)
 {
+    if (m_display_list)
+        return m_display_list->mark_incomplete();
     auto rect = a_rect.translated(translation()).intersected(clip_rect());
     if (rect.is_empty())
         return;
@@ -253,6 +311,8 @@ void Painter::fill_ellipse(const Rect& a_rect, Color color)
 
 void Painter::draw_ellipse_intersecting(const Rect& rect, Color color, int thickness)
 {
+    if (m_display_list)
+        return m_display_list->mark_incomplete();
     constexpr int number_samples = 100; // FIXME: dynamically work out the number of samples based upon the rect size
     double increment = M_PI / number_samples;
 
@@ -271,6 +331,13 @@ void Painter::draw_ellipse_intersecting(const Rect& rect, Color color, int thick
 
 void Painter::draw_rect(const Rect& a_rect, Color color, bool rough)
 {
+    if (m_display_list) {
+        auto& command = m_display_list->append(DisplayList::Type::DrawRect, state());
+        command.mode = rough;
+        command.rect = a_rect;
+        command.color = color;
+        return;
+    }
     Rect rect = a_rect.translated(translation());
     auto clipped_rect = rect.intersected(clip_rect());
     if (clipped_rect.is_empty())
@@ -315,6 +382,13 @@ void Painter::draw_rect(const Rect& a_rect, Color color, bool rough)
 
 void Painter::draw_bitmap(const Point& p, const CharacterBitmap& bitmap, Color color)
 {
+    if (m_display_list) {
+        auto& command = m_display_list->append(DisplayList::Type::DrawCharacterBitmap, state());
+        command.point = p;
+        command.resource_index = m_display_list->add_character_bitmap(bitmap);
+        command.color = color;
+        return;
+    }
     auto rect = Rect(p, bitmap.size()).translated(translation());
     auto clipped_rect = rect.intersected(clip_rect());
     if (clipped_rect.is_empty())
@@ -341,6 +415,8 @@ void Painter::draw_bitmap(const Point& p, const CharacterBitmap& bitmap, Color c
 
 void Painter::draw_bitmap(const Point& p, const GlyphBitmap& bitmap, Color color)
 {
+    if (m_display_list)
+        return m_display_list->mark_incomplete();
     auto dst_rect = Rect(p, bitmap.size()).translated(translation());
     auto clipped_rect = dst_rect.intersected(clip_rect());
     if (clipped_rect.is_empty())
@@ -363,6 +439,8 @@ void Painter::draw_bitmap(const Point& p, const GlyphBitmap& bitmap, Color color
 
 void Painter::draw_triangle(const Point& a, const Point& b, const Point& c, Color color)
 {
+    if (m_display_list)
+        return m_display_list->mark_incomplete();
     RGBA32 rgba = color.value();
 
     Point p0(a);
@@ -431,6 +509,8 @@ void Painter::draw_triangle(const Point& a, const Point& b, const Point& c, Colo
 
 void Painter::blit_scaled(const Rect& dst_rect_raw, const Gfx::Bitmap& source, const Rect& src_rect, float hscale, float vscale)
 {
+    if (m_display_list)
+        return m_display_list->mark_incomplete();
     auto dst_rect = Rect(dst_rect_raw.location(), dst_rect_raw.size()).translated(translation());
     auto clipped_rect = dst_rect.intersected(clip_rect());
     if (clipped_rect.is_empty())
@@ -484,11 +564,21 @@ void Painter::blit_with_opacity(const Point& position, const Gfx::Bitmap& source
     const RGBA32* src = source.scanline(src_rect.top() + first_row) + src_rect.left() + first_column;
     const size_t dst_skip = m_target->pitch() / sizeof(RGBA32);
     const unsigned src_skip = source.pitch() / sizeof(RGBA32);
+    const bool source_has_alpha = source.has_alpha_channel();
+
+    if (source.format() == BitmapFormat::RGB32 || source.format() == BitmapFormat::RGBA32) {
+        for (int row = first_row; row <= last_row; ++row) {
+            blend_row_with_opacity(dst, src, clipped_rect.width(), alpha, source_has_alpha);
+            dst += dst_skip;
+            src += src_skip;
+        }
+        return;
+    }
 
     for (int row = first_row; row <= last_row; ++row) {
         for (int x = 0; x <= (last_column - first_column); ++x) {
-            Color src_color_with_alpha = Color::from_rgb(src[x]);
-            src_color_with_alpha.set_alpha(alpha);
+            Color src_color_with_alpha = source_has_alpha ? color_with_alpha(source, src[x]) : Color::from_rgb(src[x]);
+            src_color_with_alpha.set_alpha(src_color_with_alpha.alpha() * alpha / 255);
             Color dst_color = Color::from_rgb(dst[x]);
             dst[x] = dst_color.blend(src_color_with_alpha).value();
         }
@@ -499,6 +589,8 @@ void Painter::blit_with_opacity(const Point& position, const Gfx::Bitmap& source
 
 void Painter::blit_filtered(const Point& position, const Gfx::Bitmap& source, const Rect& src_rect, Function<Color(Color)> filter)
 {
+    if (m_display_list)
+        return m_display_list->mark_incomplete();
     Rect safe_src_rect = src_rect.intersected(source.rect());
     auto dst_rect = Rect(position, safe_src_rect.size()).translated(translation());
     auto clipped_rect = dst_rect.intersected(clip_rect());
@@ -521,7 +613,7 @@ void Painter::blit_filtered(const Point& position, const Gfx::Bitmap& source, co
             else if (!alpha)
                 continue;
             else
-                dst[x] = Color::from_rgba(dst[x]).blend(filter(Color::from_rgba(src[x]))).value();
+                dst[x] = Color::from_rgba(dst[x]).blend(filter(color_with_alpha(source, src[x]))).value();
         }
         dst += dst_skip;
         src += src_skip;
@@ -530,6 +622,13 @@ void Painter::blit_filtered(const Point& position, const Gfx::Bitmap& source, co
 
 void Painter::blit_brightened(const Point& position, const Gfx::Bitmap& source, const Rect& src_rect)
 {
+    if (m_display_list) {
+        auto& command = m_display_list->append(DisplayList::Type::BlitBrightened, state());
+        command.point = position;
+        command.resource_index = m_display_list->add_bitmap(source);
+        command.source_rect = src_rect;
+        return;
+    }
     return blit_filtered(position, source, src_rect, [](Color src) {
         return src.lightened();
     });
@@ -537,6 +636,13 @@ void Painter::blit_brightened(const Point& position, const Gfx::Bitmap& source,
 
 void Painter::blit_dimmed(const Point& position, const Gfx::Bitmap& source, const Rect& src_rect)
 {
+    if (m_display_list) {
+        auto& command = m_display_list->append(DisplayList::Type::BlitDimmed, state());
+        command.point = position;
+        command.resource_index = m_display_list->add_bitmap(source);
+        command.source_rect = src_rect;
+        return;
+    }
     return blit_filtered(position, source, src_rect, [](Color src) {
         return src.to_grayscale().lightened();
     });
@@ -544,6 +650,12 @@ void Painter::blit_dimmed(const Point& position, const Gfx::Bitmap& source, cons
 
 void Painter::draw_tiled_bitmap(const Rect& a_dst_rect, const Gfx::Bitmap& source)
 {
+    if (m_display_list) {
+        auto& command = m_display_list->append(DisplayList::Type::DrawTiledBitmap, state());
+        command.rect = a_dst_rect;
+        command.resource_index = m_display_list->add_bitmap(source);
+        return;
+    }
     auto dst_rect = a_dst_rect.translated(translation());
     auto clipped_rect = dst_rect.intersected(clip_rect());
     if (clipped_rect.is_empty())
@@ -575,6 +687,8 @@ void Painter::blit_offset(const Point& position,
     const Rect& src_rect,
     const Point& offset)
 {
+    if (m_display_list)
+        return m_display_list->mark_incomplete();
     auto dst_rect = Rect(position, src_rect.size()).translated(translation());
     auto clipped_rect = dst_rect.intersected(clip_rect());
     if (clipped_rect.is_empty())
@@ -624,6 +738,16 @@ void Painter::blit_with_alpha(const Point& position, const Gfx::Bitmap& source,
     const size_t dst_skip = m_target->pitch() / sizeof(RGBA32);
     const size_t src_skip = source.pitch() / sizeof(RGBA32);
 
+    if (!m_target->has_alpha_channel()) {
+        auto* blend = source.format() == BitmapFormat::RGBA32Premultiplied ? blend_row_premultiplied : blend_row;
+        for (int row = first_row; row <= last_row; ++row) {
+            blend(dst, src, clipped_rect.width());
+            dst += dst_skip;
+            src += src_skip;
+        }
+        return;
+    }
+
     for (int row = first_row; row <= last_row; ++row) {
         for (int x = 0; x <= (last_column - first_column); ++x) {
             u8 alpha = Color::from_rgba(src[x]).alpha();
@@ -632,7 +756,7 @@ void Painter::blit_with_alpha(const Point& position, const Gfx::Bitmap& source,
             else if (!alpha)
                 continue;
             else
-                dst[x] = Color::from_rgba(dst[x]).blend(Color::from_rgba(src[x])).value();
+                dst[x] = Color::from_rgba(dst[x]).blend(color_with_alpha(source, src[x])).value();
         }
         dst += dst_skip;
         src += src_skip;
@@ -641,6 +765,14 @@ void Painter::blit_with_alpha(const Point& position, const Gfx::Bitmap& source,
 
 void Painter::blit(const Point& position, const Gfx::Bitmap& source, const Rect& src_rect, float opacity)
 {
+    if (m_display_list) {
+        auto& command = m_display_list->append(DisplayList::Type::Blit, state());
+        command.point = position;
+        command.resource_index = m_display_list->add_bitmap(source);
+        command.source_rect = src_rect;
+        command.opacity = opacity;
+        return;
+    }
     if (opacity < 1.0f)
         return blit_with_opacity(position, source, src_rect, opacity);
     if (source.has_alpha_channel())
@@ -734,8 +866,40 @@ ALWAYS_INLINE static void do_draw_scaled_bitmap(Gfx::Bitmap& target, const Rect&
     }
 }
 
+// Nearest-neighbour scaling of a 32-bit bitmap onto an opaque target. Translucent sources are gathered
+// into a row buffer first, so that they can be blended a whole row at a time.
+template<bool has_alpha_channel>
+static void do_draw_scaled_rgb32_bitmap(Gfx::Bitmap& target, const Rect& dst_rect, const Rect& clipped_rect, const Gfx::Bitmap& source, int hscale, int vscale)
+{
+    Vector<RGBA32, 1024> row_buffer;
+    if constexpr (has_alpha_channel)
+        row_buffer.resize(clipped_rect.width());
+
+    const int first_scaled_x = (clipped_rect.left() - dst_rect.x()) * hscale;
+    for (int y = clipped_rect.top(); y <= clipped_rect.bottom(); ++y) {
+        auto scaled_y = ((y - dst_rect.y()) * vscale) >> 16;
+        const RGBA32* src = source.scanline(scaled_y);
+        RGBA32* dst = target.scanline(y) + clipped_rect.left();
+        RGBA32* row = has_alpha_channel ? row_buffer.data() : dst;
+        int scaled_x = first_scaled_x;
+        for (int i = 0; i < clipped_rect.width(); ++i) {
+            row[i] = src[scaled_x >> 16];
+            scaled_x += hscale;
+        }
+        if constexpr (has_alpha_channel)
+            blend_row(dst, row, clipped_rect.width());
+    }
+}
+
 void Painter::draw_scaled_bitmap(const Rect& a_dst_rect, const Gfx::Bitmap& source, const Rect& src_rect)
 {
+    if (m_display_list) {
+        auto& command = m_display_list->append(DisplayList::Type::DrawScaledBitmap, state());
+        command.rect = a_dst_rect;
+        command.resource_index = m_display_list->add_bitmap(source);
+        command.source_rect = src_rect;
+        return;
+    }
     auto dst_rect = a_dst_rect;
     if (dst_rect.size() == src_rect.size())
         return blit(dst_rect.location(), source, src_rect);
@@ -750,6 +914,13 @@ void Painter::draw_scaled_bitmap(const Rect& a_dst_rect, const Gfx::Bitmap& sour
     int hscale = (src_rect.width() << 16) / dst_rect.width();
     int vscale = (src_rect.height() << 16) / dst_rect.height();
 
+    if (!m_target->has_alpha_channel()) {
+        if (source.format() == BitmapFormat::RGBA32)
+            return do_draw_scaled_rgb32_bitmap<true>(*m_target, dst_rect, clipped_rect, source, hscale, vscale);
+        if (source.format() == BitmapFormat::RGB32)
+            return do_draw_scaled_rgb32_bitmap<false>(*m_target, dst_rect, clipped_rect, source, hscale, vscale);
+    }
+
     if (source.has_alpha_channel()) {
         switch (source.format()) {
         case BitmapFormat::RGB32:
@@ -758,6 +929,9 @@ void Painter::draw_scaled_bitmap(const Rect& a_dst_rect, const Gfx::Bitmap& sour
         case BitmapFormat::RGBA32:
             do_draw_scaled_bitmap<true>(*m_target, dst_rect, clipped_rect, source, src_rect, hscale, vscale, get_pixel<BitmapFormat::RGBA32>);
             break;
+        case BitmapFormat::RGBA32Premultiplied:
+            do_draw_scaled_bitmap<true>(*m_target, dst_rect, clipped_rect, source, src_rect, hscale, vscale, get_pixel<BitmapFormat::RGBA32Premultiplied>);
+            break;
         case BitmapFormat::Indexed8:
             do_draw_scaled_bitmap<true>(*m_target, dst_rect, clipped_rect, source, src_rect, hscale, vscale, get_pixel<BitmapFormat::Indexed8>);
             break;
@@ -790,11 +964,39 @@ FLATTEN void Painter::draw_glyph(const Point& point, u32 codepoint, Color color)
 
 FLATTEN void Painter::draw_glyph(const Point& point, u32 codepoint, const Font& font, Color color)
 {
-    draw_bitmap(point, font.glyph_bitmap(codepoint), color);
+    if (m_display_list)
+        return m_display_list->mark_incomplete();
+    auto dst_rect = Rect(point, { font.glyph_width(codepoint), font.glyph_height() }).translated(translation());
+    auto clipped_rect = dst_rect.intersected(clip_rect());
+    if (clipped_rect.is_empty())
+        return;
+
+    auto& spans = font.glyph_atlas().spans(codepoint);
+    RGBA32* origin = m_target->scanline(dst_rect.y()) + dst_rect.x();
+    const size_t dst_skip = m_target->pitch() / sizeof(RGBA32);
+
+    if (clipped_rect == dst_rect) {
+        for (auto& span : spans)
+            fast_u32_fill(origin + span.y * dst_skip + span.x, color.value(), span.length);
+        return;
+    }
+
+    for (auto& span : spans) {
+        int y = dst_rect.y() + span.y;
+        if (y < clipped_rect.top() || y > clipped_rect.bottom())
+            continue;
+        int left = max(dst_rect.x() + span.x, clipped_rect.left());
+        int right = min(dst_rect.x() + span.x + span.length - 1, clipped_rect.right());
+        if (left > right)
+            continue;
+        fast_u32_fill(m_target->scanline(y) + left, color.value(), right - left + 1);
+    }
 }
 
 void Painter::draw_emoji(const Point& point, const Gfx::Bitmap& emoji, const Font& font)
 {
+    if (m_display_list)
+        return m_display_list->mark_incomplete();
     if (!font.is_fixed_width())
         blit(point, emoji, emoji.rect());
     else {
@@ -832,35 +1034,7 @@ void Painter::draw_glyph_or_emoji(const Point& point, u32 codepoint, const Font&
 void Painter::draw_text_line(const Rect& a_rect, const Utf8View& text, const Font& font, TextAlignment alignment, Color color, TextElision elision)
 {
     auto rect = a_rect;
-    Utf8View final_text(text);
-    String elided_text;
-    if (elision == TextElision::Right) {
-        int text_width = font.width(final_text);
-        if (font.width(final_text) > rect.width()) {
-            int glyph_spacing = font.glyph_spacing();
-            int byte_offset = 0;
-            int new_width = font.width("...");
-            if (new_width < text_width) {
-                for (auto it = final_text.begin(); it != final_text.end(); ++it) {
-                    u32 codepoint = *it;
-                    int glyph_width = font.glyph_or_emoji_width(codepoint);
-                    // NOTE: Glyph spacing should not be added after the last glyph on the line,
-                    //       but since we are here because the last glyph does not actually fit on the line,
-                    //       we don't have to worry about spacing.
-                    int width_with_this_glyph_included = new_width + glyph_width + glyph_spacing;
-                    if (width_with_this_glyph_included > rect.width())
-                        break;
-                    byte_offset = final_text.byte_offset_of(it);
-                    new_width += glyph_width + glyph_spacing;
-                }
-                StringBuilder builder;
-                builder.append(final_text.substring_view(0, byte_offset).as_string());
-                builder.append("...");
-                elided_text = builder.to_string();
-                final_text = Utf8View { elided_text };
-            }
-        }
-    }
+    auto run = font.text_run(text, rect.width(), elision);
 
     switch (alignment) {
     case TextAlignment::TopLeft:
@@ -868,11 +1042,11 @@ void Painter::draw_text_line(const Rect& a_rect, const Utf8View& text, const Fon
         break;
     case TextAlignment::TopRight:
     case TextAlignment::CenterRight:
-        rect.set_x(rect.right() - font.width(final_text));
+        rect.set_x(rect.right() - run.width);
         break;
     case TextAlignment::Center: {
         auto shrunken_rect = rect;
-        shrunken_rect.set_width(font.width(final_text));
+        shrunken_rect.set_width(run.width);
         shrunken_rect.center_within(rect);
         rect = shrunken_rect;
         break;
@@ -884,14 +1058,20 @@ void Painter::draw_text_line(const Rect& a_rect, const Utf8View& text, const Fon
     auto point = rect.location();
     int space_width = font.glyph_width(' ') + font.glyph_spacing();
 
-    for (u32 codepoint : final_text) {
-        if (codepoint == ' ') {
-            point.move_by(space_width, 0);
-            continue;
+    auto draw_codepoints = [&](const Utf8View& codepoints) {
+        for (u32 codepoint : codepoints) {
+            if (codepoint == ' ') {
+                point.move_by(space_width, 0);
+                continue;
+            }
+            draw_glyph_or_emoji(point, codepoint, font, color);
+            point.move_by(font.glyph_or_emoji_width(codepoint) + font.glyph_spacing(), 0);
         }
-        draw_glyph_or_emoji(point, codepoint, font, color);
-        point.move_by(font.glyph_or_emoji_width(codepoint) + font.glyph_spacing(), 0);
-    }
+    };
+
+    draw_codepoints(text.substring_view(0, run.length));
+    if (run.is_elided)
+        draw_codepoints(Utf8View("..."));
 }
 
 void Painter::draw_text_line(const Rect& a_rect, const Utf32View& text, const Font& font, TextAlignment alignment, Color color, TextElision elision)
@@ -972,6 +1152,18 @@ void Painter::draw_text(const Rect& rect, const Utf32View& text, TextAlignment a
 
 void Painter::draw_text(const Rect& rect, const StringView& raw_text, const Font& font, TextAlignment alignment, Color color, TextElision elision)
 {
+    if (m_display_list) {
+        // The font is recorded as part of the state, so it's kept alive along with the others.
+        auto recorded_state = state();
+        recorded_state.font = &font;
+        auto& command = m_display_list->append(DisplayList::Type::DrawText, recorded_state);
+        command.mode = (u8)alignment;
+        command.elision = elision;
+        command.rect = rect;
+        command.resource_index = m_display_list->add_string(raw_text);
+        command.color = color;
+        return;
+    }
     Utf8View text { raw_text };
     Vector<Utf8View, 32> lines;
 
@@ -1031,6 +1223,8 @@ void Painter::draw_text(const Rect& rect, const StringView& raw_text, const Font
 
 void Painter::draw_text(const Rect& rect, const Utf32View& text, const Font& font, TextAlignment alignment, Color color, TextElision elision)
 {
+    if (m_display_list)
+        return m_display_list->mark_incomplete();
     Vector<Utf32View, 32> lines;
 
     size_t start_of_current_line = 0;
@@ -1088,6 +1282,12 @@ void Painter::draw_text(const Rect& rect, const Utf32View& text, const Font& fon
 
 void Painter::set_pixel(const Point& p, Color color)
 {
+    if (m_display_list) {
+        auto& command = m_display_list->append(DisplayList::Type::SetPixel, state());
+        command.point = p;
+        command.color = color;
+        return;
+    }
     auto point = p;
     point.move_by(state().translation);
     if (!clip_rect().contains(point))
@@ -1106,14 +1306,33 @@ ALWAYS_INLINE void Painter::set_pixel_with_draw_op(u32& pixel, const Color& colo
 void Painter::draw_pixel(const Point& position, Color color, int thickness)
 {
     ASSERT(draw_op() == DrawOp::Copy);
-    if (thickness == 1)
+    if (thickness == 1) {
+        if (!clip_rect().contains(position))
+            return;
         return set_pixel_with_draw_op(m_target->scanline(position.y())[position.x()], color);
+    }
     Rect rect { position.translated(-(thickness / 2), -(thickness / 2)), { thickness, thickness } };
     fill_rect(rect.translated(-state().translation), color);
 }
 
+// Where a dotted or dashed pattern that starts at line_start first repeats at or before clip_start, so the dots and
+// dashes land in the same places no matter where the line is clipped. draw_pixel() clips whatever sticks out.
+static int pattern_start(int line_start, int clip_start, int period)
+{
+    return line_start + (clip_start - line_start) / period * period;
+}
+
 void Painter::draw_line(const Point& p1, const Point& p2, Color color, int thickness, LineStyle style)
 {
+    if (m_display_list) {
+        auto& command = m_display_list->append(DisplayList::Type::DrawLine, state());
+        command.mode = (u8)style;
+        command.point = p1;
+        command.second_point = p2;
+        command.color = color;
+        command.thickness = thickness;
+        return;
+    }
     auto clip_rect = this->clip_rect();
 
     auto point1 = p1;
@@ -1136,10 +1355,10 @@ void Painter::draw_line(const Point& p1, const Point& p2, Color color, int thick
         int min_y = max(point1.y(), clip_rect.top());
         int max_y = min(point2.y(), clip_rect.bottom());
         if (style == LineStyle::Dotted) {
-            for (int y = min_y; y <= max_y; y += thickness * 2)
+            for (int y = pattern_start(point1.y(), min_y, thickness * 2); y <= max_y; y += thickness * 2)
                 draw_pixel({ x, y }, color, thickness);
         } else if (style == LineStyle::Dashed) {
-            for (int y = min_y; y <= max_y; y += thickness * 6) {
+            for (int y = pattern_start(point1.y(), min_y, thickness * 6); y <= max_y; y += thickness * 6) {
                 draw_pixel({ x, y }, color, thickness);
                 draw_pixel({ x, min(y + thickness, max_y) }, color, thickness);
                 draw_pixel({ x, min(y + thickness * 2, max_y) }, color, thickness);
@@ -1165,10 +1384,10 @@ void Painter::draw_line(const Point& p1, const Point& p2, Color color, int thick
         int min_x = max(point1.x(), clip_rect.left());
         int max_x = min(point2.x(), clip_rect.right());
         if (style == LineStyle::Dotted) {
-            for (int x = min_x; x <= max_x; x += thickness * 2)
+            for (int x = pattern_start(point1.x(), min_x, thickness * 2); x <= max_x; x += thickness * 2)
                 draw_pixel({ x, y }, color, thickness);
         } else if (style == LineStyle::Dashed) {
-            for (int x = min_x; x <= max_x; x += thickness * 6) {
+            for (int x = pattern_start(point1.x(), min_x, thickness * 6); x <= max_x; x += thickness * 6) {
                 draw_pixel({ x, y }, color, thickness);
                 draw_pixel({ min(x + thickness, max_x), y }, color, thickness);
                 draw_pixel({ min(x + thickness * 2, max_x), y }, color, thickness);
@@ -1204,8 +1423,7 @@ void Painter::draw_line(const Point& p1, const Point& p2, Color color, int thick
         const double delta_error = fabs(dy / dx);
         int y = point1.y();
         for (int x = point1.x(); x <= point2.x(); ++x) {
-            if (clip_rect.contains(x, y))
-                draw_pixel({ x, y }, color, thickness);
+            draw_pixel({ x, y }, color, thickness);
             error += delta_error;
             if (error >= 0.5) {
                 y = (double)y + y_step;
@@ -1217,8 +1435,7 @@ void Painter::draw_line(const Point& p1, const Point& p2, Color color, int thick
         const double delta_error = fabs(dx / dy);
         int x = point1.x();
         for (int y = point1.y(); y <= point2.y(); ++y) {
-            if (clip_rect.contains(x, y))
-                draw_pixel({ x, y }, color, thickness);
+            draw_pixel({ x, y }, color, thickness);
             error += delta_error;
             if (error >= 0.5) {
                 x = (double)x + x_step;
@@ -1276,6 +1493,8 @@ void Painter::for_each_line_segment_on_bezier_curve(const FloatPoint& control_po
 
 void Painter::draw_quadratic_bezier_curve(const Point& control_point, const Point& p1, const Point& p2, Color color, int thickness, LineStyle style)
 {
+    if (m_display_list)
+        return m_display_list->mark_incomplete();
     for_each_line_segment_on_bezier_curve(FloatPoint(control_point.x(), control_point.y()), FloatPoint(p1.x(), p1.y()), FloatPoint(p2.x(), p2.y()), [&](const FloatPoint& p1, const FloatPoint& p2) {
         draw_line(Point(p1.x(), p1.y()), Point(p2.x(), p2.y()), color, thickness, style);
     });
@@ -1305,179 +1524,61 @@ PainterStateSaver::~PainterStateSaver()
 
 void Painter::stroke_path(const Path& path, Color color, int thickness)
 {
-    FloatPoint cursor;
+    if (m_display_list)
+        return m_display_list->mark_incomplete();
+    // Every flattened segment becomes a rectangle `thickness` wide. They all wind the same way, so
+    // filling them with the nonzero rule gives their union, anti-aliased like any other fill.
+    PathRasterizer rasterizer(clip_rect());
+    float half_thickness = thickness / 2.0f;
+
+    auto add_segment = [&](const FloatPoint& from, const FloatPoint& to) {
+        auto delta = to - from;
+        float length = sqrtf(delta.x() * delta.x() + delta.y() * delta.y());
+        if (!length)
+            return;
+        FloatPoint normal(-delta.y() / length * half_thickness, delta.x() / length * half_thickness);
+        rasterizer.add_line(from + normal, to + normal);
+        rasterizer.add_line(to + normal, to - normal);
+        rasterizer.add_line(to - normal, from - normal);
+        rasterizer.add_line(from - normal, from + normal);
+    };
+
+    FloatPoint offset(translation().x(), translation().y());
+    FloatPoint cursor = offset;
 
     for (auto& segment : path.segments()) {
+        auto point = segment.point.translated(offset);
         switch (segment.type) {
         case Path::Segment::Type::Invalid:
             ASSERT_NOT_REACHED();
             break;
         case Path::Segment::Type::MoveTo:
-            cursor = segment.point;
+            cursor = point;
             break;
         case Path::Segment::Type::LineTo:
-            draw_line(Point(cursor.x(), cursor.y()), Point(segment.point.x(), segment.point.y()), color, thickness);
-            cursor = segment.point;
+            add_segment(cursor, point);
+            cursor = point;
             break;
         case Path::Segment::Type::QuadraticBezierCurveTo:
             ASSERT(segment.through.has_value());
-            draw_quadratic_bezier_curve(Point(segment.through.value().x(), segment.through.value().y()), Point(cursor.x(), cursor.y()), Point(segment.point.x(), segment.point.y()), color, thickness);
-            cursor = segment.point;
+            for_each_line_segment_on_bezier_curve(segment.through.value().translated(offset), cursor, point, [&](auto& from, auto& to) {
+                add_segment(from, to);
+            });
+            cursor = point;
             break;
         }
     }
-}
 
-//#define FILL_PATH_DEBUG
+    rasterizer.fill(*m_target, color, WindingRule::Nonzero);
+}
 
 void Painter::fill_path(Path& path, Color color, WindingRule winding_rule)
 {
-    const auto& segments = path.split_lines();
-
-    if (segments.size() == 0)
-        return;
-
-    Vector<Path::LineSegment> active_list;
-    active_list.ensure_capacity(segments.size());
-
-    // first, grab the segments for the very first scanline
-    auto first_y = segments.first().maximum_y;
-    auto last_y = segments.last().minimum_y;
-    auto scanline = first_y;
-
-    size_t last_active_segment { 0 };
-
-    for (auto& segment : segments) {
-        if (segment.maximum_y != scanline)
-            break;
-        active_list.append(segment);
-        ++last_active_segment;
-    }
-
-    auto is_inside_shape = [winding_rule](int winding_number) {
-        if (winding_rule == WindingRule::Nonzero)
-            return winding_number != 0;
-
-        if (winding_rule == WindingRule::EvenOdd)
-            return winding_number % 2 == 0;
-
-        ASSERT_NOT_REACHED();
-    };
-
-    auto increment_winding = [winding_rule](int& winding_number, const Point& from, const Point& to) {
-        if (winding_rule == WindingRule::EvenOdd) {
-            ++winding_number;
-            return;
-        }
-
-        if (winding_rule == WindingRule::Nonzero) {
-            if (from.dy_relative_to(to) < 0)
-                ++winding_number;
-            else
-                --winding_number;
-            return;
-        }
-
-        ASSERT_NOT_REACHED();
-    };
-
-    while (scanline >= last_y) {
-        if (active_list.size()) {
-            // sort the active list by 'x' from right to left
-            quick_sort(active_list, [](const auto& line0, const auto& line1) {
-                return line1.x < line0.x;
-            });
-#ifdef FILL_PATH_DEBUG
-            if ((int)scanline % 10 == 0) {
-                draw_text(Rect(active_list.last().x - 20, scanline, 20, 10), String::format("%d", (int)scanline));
-            }
-#endif
-
-            if (active_list.size() > 1) {
-                auto winding_number { 0 };
-                for (size_t i = 1; i < active_list.size(); ++i) {
-                    auto& previous = active_list[i - 1];
-                    auto& current = active_list[i];
-
-                    int int_distance = fabs(current.x - previous.x);
-                    Point from(previous.x, scanline);
-                    Point to(current.x, scanline);
-
-                    if (int_distance < 1) {
-                        // the two lines intersect on an int grid
-                        // so they should both be treated as a single line segment
-                        goto skip_drawing;
-                    }
-
-                    if (int_distance == 1 && is_inside_shape(winding_number)) {
-                        // The two lines form a singluar edge for the shape
-                        // while they do not intersect, they connect together
-                        goto skip_drawing;
-                    }
-
-                    if (is_inside_shape(winding_number)) {
-                        // The points between this segment and the previous are
-                        // inside the shape
-#ifdef FILL_PATH_DEBUG
-                        dbg() << "y=" << scanline << ": " << winding_number << " at " << i << ": " << from << " -- " << to;
-#endif
-                        draw_line(from, to, color, 1);
-                    }
-
-                skip_drawing:;
-
-                    auto is_passing_through_maxima = scanline == previous.maximum_y
-                        || scanline == previous.minimum_y
-                        || scanline == current.maximum_y
-                        || scanline == current.minimum_y;
-
-                    auto is_passing_through_vertex = false;
-
-                    if (is_passing_through_maxima) {
-                        is_passing_through_vertex = previous.x == current.x;
-                    }
-
-                    if (!is_passing_through_vertex || previous.inverse_slope * current.inverse_slope < 0)
-                        increment_winding(winding_number, from, to);
-
-                    // update the x coord
-                    active_list[i - 1].x -= active_list[i - 1].inverse_slope;
-                }
-                active_list.last().x -= active_list.last().inverse_slope;
-            } else {
-                auto point = Point(active_list[0].x, scanline);
-                draw_line(point, point, color);
-
-                // update the x coord
-                active_list.first().x -= active_list.first().inverse_slope;
-            }
-        }
-
-        --scanline;
-        // remove any edge that goes out of bound from the active list
-        for (size_t i = 0, count = active_list.size(); i < count; ++i) {
-            if (scanline <= active_list[i].minimum_y) {
-                active_list.remove(i);
-                --count;
-                --i;
-            }
-        }
-        for (size_t j = last_active_segment; j < segments.size(); ++j, ++last_active_segment) {
-            auto& segment = segments[j];
-            if (segment.maximum_y < scanline)
-                break;
-            if (segment.minimum_y >= scanline)
-                continue;
-
-            active_list.append(segment);
-        }
-    }
-
-#ifdef FILL_PATH_DEBUG
-    size_t i { 0 };
-    for (auto& segment : segments)
-        draw_line(Point(segment.from.x(), segment.from.y()), Point(segment.to.x(), segment.to.y()), Color::from_hsv(++i / segments.size() * 255, 255, 255), 1);
-#endif
+    if (m_display_list)
+        return m_display_list->mark_incomplete();
+    PathRasterizer rasterizer(clip_rect());
+    rasterizer.add_path(path, FloatPoint(translation().x(), translation().y()));
+    rasterizer.fill(*m_target, color, winding_rule);
 }
 
 }
@@ -114,6 +114,10 @@ public:
 
     Gfx::Bitmap* target() { return m_target.ptr(); }
 
+    // From here on, painting is added to the display list instead of being drawn. See DisplayList.
+    void start_recording(DisplayList& display_list) { m_display_list = &display_list; }
+    bool is_recording() const { return m_display_list; }
+
     void save() { m_state_stack.append(m_state_stack.last()); }
     void restore()
     {
@@ -122,6 +126,8 @@ public:
     }
 
 protected:
+    friend class DisplayList;
+
     void set_pixel_with_draw_op(u32& pixel, const Color&);
     void fill_rect_with_draw_op(const Rect&, Color);
     void blit_with_alpha(const Point&, const Gfx::Bitmap&, const Rect& src_rect);
@@ -144,6 +150,7 @@ protected:
     Rect m_clip_origin;
     NonnullRefPtr<Gfx::Bitmap> m_target;
     Vector<State, 4> m_state_stack;
+    DisplayList* m_display_list { nullptr };
 };
 
 class PainterStateSaver {
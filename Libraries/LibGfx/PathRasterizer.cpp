@@ -0,0 +1,250 @@
+/*
+ * Copyright (c) 2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/Assertions.h>
+#include <AK/StdLibExtras.h>
+#include <LibGfx/Bitmap.h>
+#include <LibGfx/FloatRect.h>
+#include <LibGfx/Path.h>
+#include <LibGfx/PathRasterizer.h>
+#include <LibThread/ParallelFor.h>
+#include <math.h>
+#include <string.h>
+
+namespace Gfx {
+
+// Rows per band. Each band gets its own coverage buffer, so this bounds the memory a worker needs.
+static constexpr int band_height = 32;
+
+// Fills smaller than this many pixels aren't worth waking up the worker threads for.
+static constexpr int parallel_fill_threshold = 256 * 256;
+
+PathRasterizer::PathRasterizer(const Rect& clip_rect)
+    : m_clip_rect(clip_rect)
+{
+}
+
+void PathRasterizer::add_line(const FloatPoint& from, const FloatPoint& to)
+{
+    if (from.y() == to.y())
+        return;
+
+    if (m_edges.is_empty()) {
+        m_min_x = m_max_x = from.x();
+        m_min_y = m_max_y = from.y();
+    }
+    m_min_x = min(m_min_x, min(from.x(), to.x()));
+    m_max_x = max(m_max_x, max(from.x(), to.x()));
+    m_min_y = min(m_min_y, min(from.y(), to.y()));
+    m_max_y = max(m_max_y, max(from.y(), to.y()));
+
+    m_edges.append({ from.x(), from.y(), to.x(), to.y() });
+}
+
+void PathRasterizer::add_path(const Path& path, const FloatPoint& offset)
+{
+    FloatPoint cursor = offset;
+    FloatPoint start_of_subpath = offset;
+
+    auto close_subpath = [&] {
+        if (cursor != start_of_subpath)
+            add_line(cursor, start_of_subpath);
+    };
+
+    for (auto& segment : path.segments()) {
+        auto point = segment.point.translated(offset);
+        switch (segment.type) {
+        case Path::Segment::Type::MoveTo:
+            close_subpath();
+            cursor = point;
+            start_of_subpath = point;
+            break;
+        case Path::Segment::Type::LineTo:
+            add_line(cursor, point);
+            cursor = point;
+            break;
+        case Path::Segment::Type::QuadraticBezierCurveTo:
+            ASSERT(segment.through.has_value());
+            Painter::for_each_line_segment_on_bezier_curve(segment.through.value().translated(offset), cursor, point, [this](auto& from, auto& to) {
+                add_line(from, to);
+            });
+            cursor = point;
+            break;
+        case Path::Segment::Type::Invalid:
+            ASSERT_NOT_REACHED();
+            break;
+        }
+    }
+    close_subpath();
+}
+
+// Adds the signed area between the line and the left edge of the buffer to every pixel the line crosses,
+// so that a running sum along each row gives the winding-weighted coverage of each pixel.
+static void accumulate_line(float* buffer, int width, int height, float x0, float y0, float x1, float y1)
+{
+    float direction = 1;
+    if (y0 > y1) {
+        swap(x0, x1);
+        swap(y0, y1);
+        direction = -1;
+    }
+
+    float dxdy = (x1 - x0) / (y1 - y0);
+    int first_row = max(0, (int)floorf(y0));
+    int last_row = min(height, (int)ceilf(y1));
+    float x = x0 + (max((float)first_row, y0) - y0) * dxdy;
+    const size_t pitch = width + 2;
+
+    for (int y = first_row; y < last_row; ++y) {
+        float dy = min((float)y + 1, y1) - max((float)y, y0);
+        float next_x = x + dxdy * dy;
+        float d = dy * direction;
+
+        // Anything to the left of the buffer covers all of the row, anything to the right none of it.
+        float from_x = clamp(x, 0.0f, (float)width);
+        float to_x = clamp(next_x, 0.0f, (float)width);
+        float left = min(from_x, to_x);
+        float right = max(from_x, to_x);
+
+        float* row = buffer + y * pitch;
+        float left_floor = floorf(left);
+        int left_index = left_floor;
+        float right_ceil = ceilf(right);
+        int right_index = right_ceil;
+
+        if (right_index <= left_index + 1) {
+            float middle = 0.5f * (from_x + to_x) - left_floor;
+            row[left_index] += d - d * middle;
+            row[left_index + 1] += d * middle;
+        } else {
+            float inverse_width = 1 / (right - left);
+            float left_fraction = left - left_floor;
+            float first_area = 0.5f * inverse_width * (1 - left_fraction) * (1 - left_fraction);
+            float right_fraction = right - right_ceil + 1;
+            float last_area = 0.5f * inverse_width * right_fraction * right_fraction;
+            row[left_index] += d * first_area;
+            if (right_index == left_index + 2) {
+                row[left_index + 1] += d * (1 - first_area - last_area);
+            } else {
+                float second_area = inverse_width * (1.5f - left_fraction);
+                row[left_index + 1] += d * (second_area - first_area);
+                for (int i = left_index + 2; i < right_index - 1; ++i)
+                    row[i] += d * inverse_width;
+                float penultimate_area = second_area + (right_index - left_index - 3) * inverse_width;
+                row[right_index - 1] += d * (1 - penultimate_area - last_area);
+            }
+            row[right_index] += d * last_area;
+        }
+        x = next_x;
+    }
+}
+
+void PathRasterizer::rasterize_band(Bitmap& target, const Rect& band, const Vector<u32>& edge_indices, Color color, Painter::WindingRule winding_rule) const
+{
+    const int width = band.width();
+    const int height = band.height();
+    const size_t pitch = width + 2;
+
+    Vector<float> buffer;
+    buffer.resize(pitch * height);
+    memset(buffer.data(), 0, buffer.size() * sizeof(float));
+
+    for (auto index : edge_indices) {
+        auto& edge = m_edges[index];
+        accumulate_line(buffer.data(), width, height, edge.x0 - band.x(), edge.y0 - band.y(), edge.x1 - band.x(), edge.y1 - band.y());
+    }
+
+    for (int y = 0; y < height; ++y) {
+        const float* row = buffer.data() + y * pitch;
+        RGBA32* dst = target.scanline(band.y() + y) + band.x();
+        float winding = 0;
+        for (int x = 0; x < width; ++x) {
+            winding += row[x];
+            float coverage = fabsf(winding);
+            if (winding_rule == Painter::WindingRule::EvenOdd) {
+                coverage = fmodf(coverage, 2);
+                if (coverage > 1)
+                    coverage = 2 - coverage;
+            } else {
+                coverage = min(coverage, 1.0f);
+            }
+
+            u8 alpha = color.alpha() * coverage + 0.5f;
+            if (!alpha)
+                continue;
+            if (alpha == 0xff) {
+                dst[x] = color.value();
+                continue;
+            }
+            auto existing = target.has_alpha_channel() ? Color::from_rgba(dst[x]) : Color::from_rgb(dst[x]);
+            dst[x] = existing.blend(color.with_alpha(alpha)).value();
+        }
+    }
+}
+
+void PathRasterizer::fill(Bitmap& target, Color color, Painter::WindingRule winding_rule)
+{
+    if (m_edges.is_empty() || !color.alpha())
+        return;
+
+    auto bounds = enclosing_int_rect(FloatRect(m_min_x, m_min_y, m_max_x - m_min_x, m_max_y - m_min_y)).inflated(2, 2);
+    bounds.intersect(m_clip_rect);
+    bounds.intersect(target.rect());
+    if (bounds.is_empty())
+        return;
+
+    size_t band_count = (bounds.height() + band_height - 1) / band_height;
+    Vector<Vector<u32>> band_edges;
+    band_edges.resize(band_count);
+
+    for (size_t i = 0; i < m_edges.size(); ++i) {
+        auto& edge = m_edges[i];
+        int top = (int)floorf(min(edge.y0, edge.y1)) - bounds.y();
+        int bottom = (int)ceilf(max(edge.y0, edge.y1)) - bounds.y();
+        if (bottom <= 0 || top >= bounds.height())
+            continue;
+        size_t first_band = max(top, 0) / band_height;
+        size_t last_band = min(bottom - 1, bounds.height() - 1) / band_height;
+        for (size_t band = first_band; band <= last_band; ++band)
+            band_edges[band].append(i);
+    }
+
+    auto rasterize = [&](size_t band_index) {
+        int y = bounds.y() + band_index * band_height;
+        Rect band(bounds.x(), y, bounds.width(), min(band_height, bounds.bottom() + 1 - y));
+        rasterize_band(target, band, band_edges[band_index], color, winding_rule);
+    };
+
+    if (band_count > 1 && bounds.width() * bounds.height() >= parallel_fill_threshold) {
+        LibThread::parallel_for(band_count, move(rasterize));
+        return;
+    }
+
+    for (size_t i = 0; i < band_count; ++i)
+        rasterize(i);
+}
+
+}
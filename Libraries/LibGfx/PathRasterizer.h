@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/Vector.h>
+#include <LibGfx/Color.h>
+#include <LibGfx/FloatPoint.h>
+#include <LibGfx/Forward.h>
+#include <LibGfx/Painter.h>
+#include <LibGfx/Rect.h>
+
+namespace Gfx {
+
+// An anti-aliasing rasterizer for filled polygons. Every edge adds its exact signed area to the pixels it
+// crosses in a coverage buffer, and a running sum along each row turns that into the fraction of each
+// pixel that is covered. The target is cut into bands of rows that are rasterized independently, so
+// large fills are spread across LibThread worker threads.
+class PathRasterizer {
+public:
+    // Only pixels inside `clip_rect` (in target coordinates) are touched.
+    explicit PathRasterizer(const Rect& clip_rect);
+
+    void add_line(const FloatPoint& from, const FloatPoint& to);
+
+    // Adds the flattened outline of `path`, moved by `offset`. Open subpaths are closed, as for any fill.
+    void add_path(const Path&, const FloatPoint& offset);
+
+    void fill(Bitmap& target, Color, Painter::WindingRule);
+
+private:
+    struct Edge {
+        float x0, y0, x1, y1;
+    };
+
+    void rasterize_band(Bitmap& target, const Rect& band, const Vector<u32>& edge_indices, Color, Painter::WindingRule) const;
+
+    Rect m_clip_rect;
+    Vector<Edge> m_edges;
+    float m_min_x { 0 };
+    float m_max_x { 0 };
+    float m_min_y { 0 };
+    float m_max_y { 0 };
+};
+
+}
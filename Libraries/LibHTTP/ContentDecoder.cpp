@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) 2018-2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <LibHTTP/ContentDecoder.h>
+
+namespace HTTP {
+
+OwnPtr<ContentDecoder> ContentDecoder::create(const String& content_encoding)
+{
+    if (content_encoding.equals_ignoring_case("gzip") || content_encoding.equals_ignoring_case("x-gzip"))
+        return adopt_own(*new ContentDecoder(Format::Gzip));
+    if (content_encoding.equals_ignoring_case("deflate"))
+        return adopt_own(*new ContentDecoder(Format::Deflate));
+    return nullptr;
+}
+
+// How long the gzip header at the start of `data` is (see RFC 1952), 0 if it hasn't all arrived yet, or -1 if it's malformed.
+static ssize_t gzip_header_size(const u8* data, size_t size)
+{
+    if (size < 10)
+        return 0;
+    if (data[0] != 0x1f || data[1] != 0x8b || data[2] != 8)
+        return -1;
+
+    u8 flags = data[3];
+    size_t offset = 10;
+    // FEXTRA
+    if (flags & 4) {
+        if (size < offset + 2)
+            return 0;
+        offset += 2 + (data[offset] | data[offset + 1] << 8);
+    }
+    auto skip_string = [&] {
+        while (offset < size && data[offset])
+            ++offset;
+        ++offset;
+    };
+    // FNAME
+    if (flags & 8)
+        skip_string();
+    // FCOMMENT
+    if (flags & 16)
+        skip_string();
+    // FHCRC
+    if (flags & 2)
+        offset += 2;
+
+    if (offset > size)
+        return 0;
+    return offset;
+}
+
+bool ContentDecoder::skip_header()
+{
+    size_t header_size = 0;
+    if (m_format == Format::Gzip) {
+        auto size = gzip_header_size(m_header.data(), m_header.size());
+        if (size < 0)
+            return false;
+        if (size == 0)
+            return true;
+        header_size = size;
+    } else {
+        if (m_header.size() < 2)
+            return true;
+        u8 method_and_flags[2] = { m_header[0], m_header[1] };
+        bool is_zlib = (method_and_flags[0] & 0xf) == 8 && (method_and_flags[0] >> 4) <= 7 && ((method_and_flags[0] << 8) | method_and_flags[1]) % 31 == 0;
+        // We don't have the preset dictionary such a stream would need.
+        if (is_zlib && (method_and_flags[1] & 0x20))
+            return false;
+        header_size = is_zlib ? 2 : 0;
+    }
+
+    m_has_skipped_header = true;
+    m_inflater.append_input(m_header.data() + header_size, m_header.size() - header_size);
+    m_header.clear();
+    return true;
+}
+
+Optional<ByteBuffer> ContentDecoder::decode(const ByteBuffer& data)
+{
+    if (data.is_empty())
+        return ByteBuffer {};
+    m_has_received_input = true;
+
+    if (!m_has_skipped_header) {
+        m_header.append(data.data(), data.size());
+        if (!skip_header())
+            return {};
+        if (!m_has_skipped_header)
+            return ByteBuffer {};
+    } else if (!m_inflater.is_finished()) {
+        // Whatever comes after the stream, like the gzip trailer, is of no interest.
+        m_inflater.append_input(data.data(), data.size());
+    }
+    return read_available_output();
+}
+
+Optional<ByteBuffer> ContentDecoder::finish()
+{
+    // An empty body, like the one of a HEAD request, has nothing to decode.
+    if (!m_has_received_input)
+        return ByteBuffer {};
+    if (!m_has_skipped_header)
+        return {};
+
+    m_inflater.close_input();
+    auto output = read_available_output();
+    if (!m_inflater.is_finished())
+        return {};
+    return output;
+}
+
+Optional<ByteBuffer> ContentDecoder::read_available_output()
+{
+    static constexpr size_t read_size = 64 * KB;
+    ByteBuffer output;
+    for (;;) {
+        size_t offset = output.size();
+        output.grow(offset + read_size);
+        size_t nread = m_inflater.read(output.data() + offset, read_size);
+        output.trim(offset + nread);
+        if (nread < read_size)
+            break;
+    }
+    if (m_inflater.has_error())
+        return {};
+    return output;
+}
+
+}
@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2018-2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/ByteBuffer.h>
+#include <AK/Optional.h>
+#include <AK/OwnPtr.h>
+#include <AK/String.h>
+#include <LibCompress/Inflate.h>
+
+namespace HTTP {
+
+// Undoes a Content-Encoding on a response body as it arrives.
+class ContentDecoder {
+public:
+    // Returns null for encodings we can't decode.
+    static OwnPtr<ContentDecoder> create(const String& content_encoding);
+
+    // Decodes what it can of the next piece of the body. Returns nothing if the body turns out to be malformed.
+    Optional<ByteBuffer> decode(const ByteBuffer&);
+
+    // Decodes what's left, once the whole body is in. Returns nothing if it was malformed or cut short.
+    Optional<ByteBuffer> finish();
+
+private:
+    enum class Format {
+        Gzip,
+        // What HTTP calls deflate is a zlib stream, though some servers send raw DEFLATE data instead.
+        Deflate,
+    };
+
+    explicit ContentDecoder(Format format)
+        : m_format(format)
+    {
+    }
+
+    // Skips the gzip or zlib header. Returns false if it's malformed, and leaves m_has_skipped_header unset until all of it is in.
+    bool skip_header();
+    Optional<ByteBuffer> read_available_output();
+
+    Format m_format;
+    bool m_has_received_input { false };
+    bool m_has_skipped_header { false };
+    // The start of the body, until the whole header is in.
+    ByteBuffer m_header;
+    Compress::Inflater m_inflater;
+};
+
+}
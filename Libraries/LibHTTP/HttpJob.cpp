@@ -38,6 +38,20 @@ void HttpJob::start()
 {
     ASSERT(!m_socket);
     m_socket = Core::TCPSocket::construct(this);
+    start_on_socket();
+}
+
+void HttpJob::start(NonnullRefPtr<Core::TCPSocket> socket)
+{
+    ASSERT(!m_socket);
+    m_socket = move(socket);
+    start_on_socket();
+}
+
+void HttpJob::start_on_socket()
+{
+    if (m_socket->is_connected())
+        return on_socket_connected();
     m_socket->on_connected = [this] {
 #ifdef CHTTPJOB_DEBUG
         dbg() << "HttpJob: on_connected callback";
@@ -58,8 +72,16 @@ void HttpJob::shutdown()
         return;
     m_socket->on_ready_to_read = nullptr;
     m_socket->on_connected = nullptr;
-    remove_child(*m_socket);
+    if (m_socket->parent() == this) {
+        remove_child(*m_socket);
+        m_socket = nullptr;
+        return;
+    }
+    // Whoever uses the connection next expects to hear from it.
+    m_socket->set_notifications_enabled(true);
     m_socket = nullptr;
+    if (on_socket_released)
+        on_socket_released(can_reuse_connection());
 }
 
 void HttpJob::register_on_ready_to_read(Function<void()> callback)
@@ -103,4 +125,10 @@ bool HttpJob::write(const ByteBuffer& data)
     return m_socket->write(data);
 }
 
+void HttpJob::set_socket_notifications_enabled(bool enabled)
+{
+    if (m_socket)
+        m_socket->set_notifications_enabled(enabled);
+}
+
 }
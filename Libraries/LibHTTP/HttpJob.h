@@ -48,6 +48,8 @@ public:
     }
 
     virtual void start() override;
+    // Sends the request on a connection opened by someone else, connecting it first if need be.
+    void start(NonnullRefPtr<Core::TCPSocket>);
     virtual void shutdown() override;
 
 protected:
@@ -59,9 +61,12 @@ protected:
     virtual ByteBuffer receive(size_t) override;
     virtual bool eof() const override;
     virtual bool write(const ByteBuffer&) override;
+    virtual void set_socket_notifications_enabled(bool) override;
     virtual bool is_established() const override { return true; }
 
 private:
+    void start_on_socket();
+
     RefPtr<Core::Socket> m_socket;
 };
 
@@ -72,13 +72,19 @@ ByteBuffer HttpRequest::to_raw_request() const
     builder.append(" HTTP/1.1\r\nHost: ");
     builder.append(m_url.host());
     builder.append("\r\n");
+    bool has_accept_encoding = false;
     for (auto& header : m_headers) {
         builder.append(header.name);
         builder.append(": ");
         builder.append(header.value);
         builder.append("\r\n");
+        if (header.name.equals_ignoring_case("Accept-Encoding"))
+            has_accept_encoding = true;
     }
-    builder.append("Connection: close\r\n\r\n");
+    // Jobs decode these as the body arrives.
+    if (!has_accept_encoding)
+        builder.append("Accept-Encoding: gzip, deflate\r\n");
+    builder.append("\r\n");
     return builder.to_byte_buffer();
 }
 
@@ -183,6 +189,7 @@ Optional<HttpRequest> HttpRequest::from_raw_request(const ByteBuffer& raw_reques
         return {};
 
     request.m_resource = resource;
+    request.m_protocol = protocol;
     request.m_headers = move(headers);
 
     return request;
@@ -52,6 +52,8 @@ public:
     ~HttpRequest();
 
     const String& resource() const { return m_resource; }
+    // The HTTP version of a request that was parsed, e.g. "HTTP/1.1".
+    const String& protocol() const { return m_protocol; }
     const Vector<Header>& headers() const { return m_headers; }
 
     const URL& url() const { return m_url; }
@@ -72,6 +74,7 @@ public:
 private:
     URL m_url;
     String m_resource;
+    String m_protocol;
     Method m_method { GET };
     Vector<Header> m_headers;
 };
@@ -40,6 +40,18 @@ void HttpsJob::start()
 {
     ASSERT(!m_socket);
     m_socket = TLS::TLSv12::construct(this);
+    start_on_socket();
+}
+
+void HttpsJob::start(NonnullRefPtr<TLS::TLSv12> socket)
+{
+    ASSERT(!m_socket);
+    m_socket = move(socket);
+    start_on_socket();
+}
+
+void HttpsJob::start_on_socket()
+{
     m_socket->on_tls_connected = [this] {
 #ifdef HTTPSJOB_DEBUG
         dbg() << "HttpsJob: on_connected callback";
@@ -62,8 +74,11 @@ void HttpsJob::start()
         }
     };
     m_socket->on_tls_finished = [&] {
+        m_keep_alive = false;
         finish_up();
     };
+    if (m_socket->is_established())
+        return on_socket_connected();
     bool success = ((TLS::TLSv12&)*m_socket).connect(m_request.url().host(), m_request.url().port());
     if (!success) {
         deferred_invoke([this](auto&) {
@@ -78,16 +93,19 @@ void HttpsJob::shutdown()
         return;
     m_socket->on_tls_ready_to_read = nullptr;
     m_socket->on_tls_connected = nullptr;
-    remove_child(*m_socket);
-    m_socket = nullptr;
-}
-
-void HttpsJob::read_while_data_available(Function<IterationDecision()> read)
-{
-    while (m_socket->can_read()) {
-        if (read() == IterationDecision::Break)
-            break;
+    if (m_socket->parent() == this) {
+        remove_child(*m_socket);
+        m_socket = nullptr;
+        return;
     }
+    m_socket->on_tls_ready_to_write = nullptr;
+    m_socket->on_tls_error = nullptr;
+    m_socket->on_tls_finished = nullptr;
+    // Whoever uses the connection next expects to hear from it.
+    m_socket->set_notifications_enabled(true);
+    m_socket = nullptr;
+    if (on_socket_released)
+        on_socket_released(can_reuse_connection());
 }
 
 void HttpsJob::register_on_ready_to_read(Function<void()> callback)
@@ -99,6 +117,9 @@ void HttpsJob::register_on_ready_to_read(Function<void()> callback)
 
 void HttpsJob::register_on_ready_to_write(Function<void()> callback)
 {
+    // A connection that's being reused is all set, and won't flush anything to tell us so.
+    if (m_socket->is_established())
+        return callback();
     m_socket->on_tls_ready_to_write = [callback = move(callback)](auto&) {
         callback();
     };
@@ -134,4 +155,10 @@ bool HttpsJob::write(const ByteBuffer& data)
     return m_socket->write(data);
 }
 
+void HttpsJob::set_socket_notifications_enabled(bool enabled)
+{
+    if (m_socket)
+        m_socket->set_notifications_enabled(enabled);
+}
+
 }
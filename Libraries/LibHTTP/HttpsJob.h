@@ -48,6 +48,8 @@ public:
     }
 
     virtual void start() override;
+    // Sends the request on a connection opened by someone else, connecting it first if need be.
+    void start(NonnullRefPtr<TLS::TLSv12>);
     virtual void shutdown() override;
 
 protected:
@@ -59,11 +61,13 @@ protected:
     virtual ByteBuffer receive(size_t) override;
     virtual bool eof() const override;
     virtual bool write(const ByteBuffer&) override;
+    virtual void set_socket_notifications_enabled(bool) override;
     virtual bool is_established() const override { return m_socket->is_established(); }
     virtual bool should_fail_on_empty_payload() const override { return false; }
-    virtual void read_while_data_available(Function<IterationDecision()>) override;
 
 private:
+    void start_on_socket();
+
     RefPtr<TLS::TLSv12> m_socket;
     bool m_queued_finish { false };
 };
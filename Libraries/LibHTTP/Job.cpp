@@ -24,7 +24,6 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
-#include <LibCore/Gzip.h>
 #include <LibCore/TCPSocket.h>
 #include <LibHTTP/HttpResponse.h>
 #include <LibHTTP/Job.h>
@@ -35,39 +34,6 @@
 
 namespace HTTP {
 
-static ByteBuffer handle_content_encoding(const ByteBuffer& buf, const String& content_encoding)
-{
-#ifdef JOB_DEBUG
-    dbg() << "Job::handle_content_encoding: buf has content_encoding = " << content_encoding;
-#endif
-
-    if (content_encoding == "gzip") {
-        if (!Core::Gzip::is_compressed(buf)) {
-            dbg() << "Job::handle_content_encoding: buf is not gzip compressed!";
-        }
-
-#ifdef JOB_DEBUG
-        dbg() << "Job::handle_content_encoding: buf is gzip compressed!";
-#endif
-
-        auto uncompressed = Core::Gzip::decompress(buf);
-        if (!uncompressed.has_value()) {
-            dbg() << "Job::handle_content_encoding: Gzip::decompress() failed. Returning original buffer.";
-            return buf;
-        }
-
-#ifdef JOB_DEBUG
-        dbg() << "Job::handle_content_encoding: Gzip::decompress() successful.\n"
-              << "  Input size = " << buf.size() << "\n"
-              << "  Output size = " << uncompressed.value().size();
-#endif
-
-        return uncompressed.value();
-    }
-
-    return buf;
-}
-
 Job::Job(const HttpRequest& request)
     : m_request(request)
 {
@@ -93,11 +59,34 @@ void Job::on_socket_connected()
             deferred_invoke([this](auto&) { did_fail(Core::NetworkJob::Error::TransmissionFailed); });
     });
     register_on_ready_to_read([&] {
-        if (is_cancelled())
+        read_available_data();
+    });
+}
+
+void Job::read_available_data()
+{
+    if (is_cancelled() || m_paused)
+        return;
+    // Everything that has arrived is dealt with now: if the connection stays open after the response,
+    // nothing else may come along to call us back for what's already buffered.
+    while (m_state != State::Finished && !m_paused) {
+        if (m_state == State::InBody) {
+            if (!can_read())
+                return;
+            read_body();
+            if (m_state == State::InBody)
+                return;
+            continue;
+        }
+        if (!can_read_line()) {
+            // A connection that was kept open may be closed by the server just as we send another request on it.
+            if (eof()) {
+                m_state = State::Finished;
+                deferred_invoke([this](auto&) { did_fail(Core::NetworkJob::Error::TransmissionFailed); });
+            }
             return;
+        }
         if (m_state == State::InStatus) {
-            if (!can_read_line())
-                return;
             auto line = read_line(PAGE_SIZE);
             if (line.is_null()) {
                 fprintf(stderr, "Job: Expected HTTP status\n");
@@ -114,12 +103,11 @@ void Job::on_socket_connected()
                 fprintf(stderr, "Job: Expected numeric HTTP status\n");
                 return deferred_invoke([this](auto&) { did_fail(Core::NetworkJob::Error::ProtocolFailed); });
             }
+            m_keep_alive = parts[0] == "HTTP/1.1";
             m_state = State::InHeaders;
-            return;
+            continue;
         }
         if (m_state == State::InHeaders || m_state == State::AfterChunkedEncodingTrailer) {
-            if (!can_read_line())
-                return;
             auto line = read_line(PAGE_SIZE);
             if (line.is_null()) {
                 fprintf(stderr, "Job: Expected HTTP header\n");
@@ -127,12 +115,10 @@ void Job::on_socket_connected()
             }
             auto chomped_line = String::copy(line, Chomp);
             if (chomped_line.is_empty()) {
-                if (m_state == State::AfterChunkedEncodingTrailer) {
+                if (m_state == State::AfterChunkedEncodingTrailer)
                     return finish_up();
-                } else {
-                    m_state = State::InBody;
-                }
-                return;
+                did_receive_headers();
+                continue;
             }
             auto parts = chomped_line.split(':');
             if (parts.is_empty()) {
@@ -149,155 +135,257 @@ void Job::on_socket_connected()
 #ifdef JOB_DEBUG
             dbg() << "Job: [" << name << "] = '" << value << "'";
 #endif
-            return;
+            continue;
         }
-        ASSERT(m_state == State::InBody);
-        ASSERT(can_read());
+    }
+}
+
+void Job::pause()
+{
+    if (m_paused || m_state == State::Finished)
+        return;
+    m_paused = true;
+    set_socket_notifications_enabled(false);
+}
+
+void Job::resume()
+{
+    if (!m_paused)
+        return;
+    m_paused = false;
+    set_socket_notifications_enabled(true);
+}
+
+void Job::did_receive_headers()
+{
+    m_state = State::InBody;
+
+    auto connection = m_headers.get("Connection");
+    if (connection.has_value()) {
+        if (connection.value().equals_ignoring_case("close"))
+            m_keep_alive = false;
+        else if (connection.value().equals_ignoring_case("keep-alive"))
+            m_keep_alive = true;
+    }
+
+    auto content_encoding = m_headers.get("Content-Encoding");
+    if (content_encoding.has_value() && !content_encoding.value().equals_ignoring_case("identity")) {
+        m_content_decoder = ContentDecoder::create(content_encoding.value());
+        if (!m_content_decoder)
+            dbg() << "Job: Unknown content encoding _" << content_encoding.value() << "_, the body is left as it is";
+    }
+    if (on_headers_received)
+        on_headers_received(m_headers);
+
+    // Some responses never have a body, and waiting for one would hang on a connection that stays open.
+    auto content_length = this->content_length();
+    if (m_request.method() == HttpRequest::Method::HEAD || m_code == 204 || m_code == 304 || (content_length.has_value() && content_length.value() == 0))
+        return finish_up();
 
-        read_while_data_available([&] {
-            auto read_size = 64 * KB;
-            if (m_current_chunk_remaining_size.has_value()) {
-            read_chunk_size:;
-                auto remaining = m_current_chunk_remaining_size.value();
-                if (remaining == -1) {
-                    // read size
-                    auto size_data = read_line(PAGE_SIZE);
-                    auto size_lines = StringView { size_data.data(), size_data.size() }.lines();
+    // Without a length or chunked encoding, the body runs until the server closes the connection.
+    auto transfer_encoding = m_headers.get("Transfer-Encoding");
+    if (!content_length.has_value() && !(transfer_encoding.has_value() && transfer_encoding.value().equals_ignoring_case("chunked")))
+        m_keep_alive = false;
+}
+
+Optional<u32> Job::content_length() const
+{
+    auto content_length_header = m_headers.get("Content-Length");
+    if (!content_length_header.has_value())
+        return {};
+    bool ok;
+    auto length = content_length_header.value().to_uint(ok);
+    if (!ok)
+        return {};
+    return length;
+}
+
+void Job::read_body()
+{
+    read_while_data_available([&] {
+        size_t read_size = 64 * KB;
+        auto content_length = this->content_length();
+        if (m_current_chunk_remaining_size.has_value()) {
+        read_chunk_size:;
+            auto remaining = m_current_chunk_remaining_size.value();
+            if (remaining == -1) {
+                // read size
+                if (!can_read_line())
+                    return IterationDecision::Break;
+                auto size_data = read_line(PAGE_SIZE);
+                auto size_lines = StringView { size_data.data(), size_data.size() }.lines();
 #ifdef JOB_DEBUG
-                    dbg() << "Job: Received a chunk with size _" << size_data << "_";
+                dbg() << "Job: Received a chunk with size _" << size_data << "_";
 #endif
-                    if (size_lines.size() == 0) {
-                        dbg() << "Job: Reached end of stream";
-                        m_state = State::AfterChunkedEncodingTrailer;
+                if (size_lines.is_empty() || size_lines[0].is_empty()) {
+                    // This is the line break ending the previous chunk, which hadn't arrived along with it.
+                    return IterationDecision::Continue;
+                } else {
+                    auto chunk = size_lines[0].split_view(';', true);
+                    String size_string = chunk[0];
+                    char* endptr;
+                    auto size = strtoul(size_string.characters(), &endptr, 16);
+                    if (*endptr) {
+                        // invalid number
+                        deferred_invoke([this](auto&) { did_fail(Core::NetworkJob::Error::TransmissionFailed); });
                         return IterationDecision::Break;
-                    } else {
-                        auto chunk = size_lines[0].split_view(';', true);
-                        String size_string = chunk[0];
-                        char* endptr;
-                        auto size = strtoul(size_string.characters(), &endptr, 16);
-                        if (*endptr) {
-                            // invalid number
-                            deferred_invoke([this](auto&) { did_fail(Core::NetworkJob::Error::TransmissionFailed); });
-                            return IterationDecision::Break;
-                        }
-                        if (size == 0) {
-                            // This is the last chunk
-                            // '0' *[; chunk-ext-name = chunk-ext-value]
-                            // We're going to ignore _all_ chunk extensions
-                            read_size = 0;
-                            m_current_chunk_total_size = 0;
-                            m_current_chunk_remaining_size = 0;
+                    }
+                    if (size == 0) {
+                        // This is the last chunk
+                        // '0' *[; chunk-ext-name = chunk-ext-value]
+                        // We're going to ignore _all_ chunk extensions
+                        // What follows is the trailer, and an empty line to end it.
 #ifdef JOB_DEBUG
-                            dbg() << "Job: Received the last chunk with extensions _" << size_string.substring_view(1, size_string.length() - 1) << "_";
+                        dbg() << "Job: Received the last chunk with extensions _" << size_string.substring_view(1, size_string.length() - 1) << "_";
 #endif
-                        } else {
-                            m_current_chunk_total_size = size;
-                            m_current_chunk_remaining_size = size;
-                            read_size = size;
+                        m_state = State::AfterChunkedEncodingTrailer;
+                        return IterationDecision::Break;
+                    } else {
+                        m_current_chunk_total_size = size;
+                        m_current_chunk_remaining_size = size;
+                        read_size = min(read_size, (size_t)size);
 #ifdef JOB_DEBUG
-                            dbg() << "Job: Chunk of size _" << size << "_ started";
+                        dbg() << "Job: Chunk of size _" << size << "_ started";
 #endif
-                        }
                     }
-                } else {
-                    read_size = remaining;
-#ifdef JOB_DEBUG
-                    dbg() << "Job: Resuming chunk with _" << remaining << "_ bytes left over";
-#endif
                 }
             } else {
-                auto transfer_encoding = m_headers.get("Transfer-Encoding");
-                if (transfer_encoding.has_value()) {
-                    auto encoding = transfer_encoding.value();
+                read_size = min(read_size, (size_t)remaining);
 #ifdef JOB_DEBUG
-                    dbg() << "Job: This content has transfer encoding '" << encoding << "'";
+                dbg() << "Job: Resuming chunk with _" << remaining << "_ bytes left over";
 #endif
-                    if (encoding.equals_ignoring_case("chunked")) {
-                        m_current_chunk_remaining_size = -1;
-                        goto read_chunk_size;
-                    } else {
-                        dbg() << "Job: Unknown transfer encoding _" << encoding << "_, the result will likely be wrong!";
-                    }
+            }
+        } else {
+            auto transfer_encoding = m_headers.get("Transfer-Encoding");
+            if (transfer_encoding.has_value()) {
+                auto encoding = transfer_encoding.value();
+#ifdef JOB_DEBUG
+                dbg() << "Job: This content has transfer encoding '" << encoding << "'";
+#endif
+                if (encoding.equals_ignoring_case("chunked")) {
+                    m_current_chunk_remaining_size = -1;
+                    goto read_chunk_size;
+                } else {
+                    dbg() << "Job: Unknown transfer encoding _" << encoding << "_, the result will likely be wrong!";
                 }
             }
+            // Don't read into whatever might come after the body on this connection.
+            if (content_length.has_value())
+                read_size = min(read_size, content_length.value() - m_received_size);
+        }
 
-            auto payload = receive(read_size);
-            if (!payload) {
-                if (eof()) {
-                    finish_up();
-                    return IterationDecision::Break;
-                }
+        auto payload = receive(read_size);
+        if (!payload) {
+            if (eof()) {
+                m_keep_alive = false;
+                finish_up();
+                return IterationDecision::Break;
+            }
 
-                if (should_fail_on_empty_payload()) {
-                    deferred_invoke([this](auto&) { did_fail(Core::NetworkJob::Error::ProtocolFailed); });
-                    return IterationDecision::Break;
-                }
+            if (should_fail_on_empty_payload()) {
+                deferred_invoke([this](auto&) { did_fail(Core::NetworkJob::Error::ProtocolFailed); });
+                return IterationDecision::Break;
             }
+        }
 
-            m_received_buffers.append(payload);
-            m_received_size += payload.size();
+        m_received_size += payload.size();
+        if (!did_receive_body_data(payload)) {
+            did_fail_to_decode_body();
+            return IterationDecision::Break;
+        }
 
-            if (m_current_chunk_remaining_size.has_value()) {
-                auto size = m_current_chunk_remaining_size.value() - payload.size();
+        if (m_current_chunk_remaining_size.has_value()) {
+            auto size = m_current_chunk_remaining_size.value() - payload.size();
 #ifdef JOB_DEBUG
-                dbg() << "Job: We have " << size << " bytes left over in this chunk";
+            dbg() << "Job: We have " << size << " bytes left over in this chunk";
 #endif
-                if (size == 0) {
+            if (size == 0) {
 #ifdef JOB_DEBUG
-                    dbg() << "Job: Finished a chunk of " << m_current_chunk_total_size.value() << " bytes";
+                dbg() << "Job: Finished a chunk of " << m_current_chunk_total_size.value() << " bytes";
 #endif
-                    // we've read everything, now let's get the next chunk
-                    size = -1;
-                    auto line = read_line(PAGE_SIZE);
+                // we've read everything, now let's get the next chunk
+                size = -1;
+                auto line = read_line(PAGE_SIZE);
 #ifdef JOB_DEBUG
-                    dbg() << "Line following (should be empty): _" << line << "_";
+                dbg() << "Line following (should be empty): _" << line << "_";
 #endif
-                    (void)line;
-
-                    if (m_current_chunk_total_size.value() == 0) {
-                        m_state = State::AfterChunkedEncodingTrailer;
-                        return IterationDecision::Break;
-                    }
-                }
-                m_current_chunk_remaining_size = size;
+                (void)line;
             }
+            m_current_chunk_remaining_size = size;
+        }
 
-            auto content_length_header = m_headers.get("Content-Length");
-            Optional<u32> content_length {};
+        deferred_invoke([this, content_length](auto&) { did_progress(content_length, m_received_size); });
 
-            if (content_length_header.has_value()) {
-                bool ok;
-                auto length = content_length_header.value().to_uint(ok);
-                if (ok)
-                    content_length = length;
+        if (content_length.has_value()) {
+            auto length = content_length.value();
+            if (m_received_size >= length) {
+                m_received_size = length;
+                finish_up();
+                return IterationDecision::Break;
             }
+        }
+        if (m_paused)
+            return IterationDecision::Break;
+        return IterationDecision::Continue;
+    });
 
-            deferred_invoke([this, content_length](auto&) { did_progress(content_length, m_received_size); });
-
-            if (content_length.has_value()) {
-                auto length = content_length.value();
-                if (m_received_size >= length) {
-                    m_received_size = length;
-                    finish_up();
-                    return IterationDecision::Break;
-                }
-            }
-            return IterationDecision::Continue;
-        });
-
-        if (!is_established()) {
+    if (!is_established()) {
 #ifdef JOB_DEBUG
-            dbg() << "Connection appears to have closed, finishing up";
+        dbg() << "Connection appears to have closed, finishing up";
 #endif
-            finish_up();
-        }
-    });
+        m_keep_alive = false;
+        finish_up();
+    }
+}
+
+bool Job::did_receive_body_data(const ByteBuffer& data)
+{
+    if (!m_content_decoder) {
+        did_decode_body_data(data);
+        return true;
+    }
+    auto decoded_data = m_content_decoder->decode(data);
+    if (!decoded_data.has_value())
+        return false;
+    did_decode_body_data(decoded_data.value());
+    return true;
+}
+
+void Job::did_decode_body_data(const ByteBuffer& data)
+{
+    if (data.is_empty())
+        return;
+    if (on_body_data)
+        on_body_data(data);
+    else
+        m_received_buffers.append(data);
+}
+
+void Job::did_fail_to_decode_body()
+{
+    dbg() << "Job: Failed to decode the body, which has content encoding _" << m_headers.get("Content-Encoding").value_or({}) << "_";
+    m_state = State::Finished;
+    deferred_invoke([this](auto&) { did_fail(Core::NetworkJob::Error::ProtocolFailed); });
 }
 
 void Job::finish_up()
 {
+    if (m_state == State::Finished)
+        return;
     m_state = State::Finished;
-    auto flattened_buffer = ByteBuffer::create_uninitialized(m_received_size);
+
+    if (m_content_decoder) {
+        auto decoded_data = m_content_decoder->finish();
+        if (!decoded_data.has_value())
+            return did_fail_to_decode_body();
+        did_decode_body_data(decoded_data.value());
+    }
+
+    // What was streamed through on_body_data isn't kept here.
+    size_t flattened_size = 0;
+    for (auto& received_buffer : m_received_buffers)
+        flattened_size += received_buffer.size();
+    auto flattened_buffer = ByteBuffer::create_uninitialized(flattened_size);
     u8* flat_ptr = flattened_buffer.data();
     for (auto& received_buffer : m_received_buffers) {
         memcpy(flat_ptr, received_buffer.data(), received_buffer.size());
@@ -305,11 +393,6 @@ void Job::finish_up()
     }
     m_received_buffers.clear();
 
-    auto content_encoding = m_headers.get("Content-Encoding");
-    if (content_encoding.has_value()) {
-        flattened_buffer = handle_content_encoding(flattened_buffer, content_encoding.value());
-    }
-
     auto response = HttpResponse::create(m_code, move(m_headers), move(flattened_buffer));
     deferred_invoke([this, response](auto&) {
         did_finish(move(response));
@@ -30,6 +30,7 @@
 #include <AK/Optional.h>
 #include <LibCore/NetworkJob.h>
 #include <LibCore/TCPSocket.h>
+#include <LibHTTP/ContentDecoder.h>
 #include <LibHTTP/HttpRequest.h>
 #include <LibHTTP/HttpResponse.h>
 
@@ -46,9 +47,33 @@ public:
     HttpResponse* response() { return static_cast<HttpResponse*>(Core::NetworkJob::response()); }
     const HttpResponse* response() const { return static_cast<const HttpResponse*>(Core::NetworkJob::response()); }
 
+    // A job started on a socket it was handed doesn't close it when it shuts down, but gives it back through this,
+    // saying whether another request can be sent on it.
+    Function<void(bool can_reuse_connection)> on_socket_released;
+
+    // Called once the headers are in, before any of the body.
+    Function<void(const HashMap<String, String, CaseInsensitiveStringTraits>& response_headers)> on_headers_received;
+
+    // If set, the body is handed over through this as it arrives (and is decoded), rather than collected into the response.
+    Function<void(const ByteBuffer&)> on_body_data;
+
+    // Stops reading from the connection until resumed, for when whoever gets the body can't keep up with it.
+    void pause();
+    void resume();
+    bool is_paused() const { return m_paused; }
+
 protected:
     void finish_up();
+    bool can_reuse_connection() const { return m_state == State::Finished && m_keep_alive && !has_error(); }
     void on_socket_connected();
+    void read_available_data();
+    void did_receive_headers();
+    void read_body();
+    // Decodes a piece of the body as it was sent and hands it over. Returns false if it can't be decoded.
+    bool did_receive_body_data(const ByteBuffer&);
+    void did_decode_body_data(const ByteBuffer&);
+    void did_fail_to_decode_body();
+    Optional<u32> content_length() const;
     virtual void register_on_ready_to_read(Function<void()>) = 0;
     virtual void register_on_ready_to_write(Function<void()>) = 0;
     virtual bool can_read_line() const = 0;
@@ -58,8 +83,15 @@ protected:
     virtual bool eof() const = 0;
     virtual bool write(const ByteBuffer&) = 0;
     virtual bool is_established() const = 0;
+    virtual void set_socket_notifications_enabled(bool) = 0;
     virtual bool should_fail_on_empty_payload() const { return true; }
-    virtual void read_while_data_available(Function<IterationDecision()> read) { read(); };
+    virtual void read_while_data_available(Function<IterationDecision()> read)
+    {
+        while (can_read()) {
+            if (read() == IterationDecision::Break)
+                break;
+        }
+    }
 
     enum class State {
         InStatus,
@@ -72,9 +104,14 @@ protected:
     HttpRequest m_request;
     State m_state { State::InStatus };
     int m_code { -1 };
+    // Whether the server leaves the connection open after this response, and we've read exactly all of it.
+    bool m_keep_alive { false };
     HashMap<String, String, CaseInsensitiveStringTraits> m_headers;
     Vector<ByteBuffer> m_received_buffers;
+    // How much of the body has arrived, before it's decoded.
     size_t m_received_size { 0 };
+    OwnPtr<ContentDecoder> m_content_decoder;
+    bool m_paused { false };
     bool m_sent_data { 0 };
     Optional<ssize_t> m_current_chunk_remaining_size;
     Optional<size_t> m_current_chunk_total_size;
@@ -106,7 +106,8 @@ public:
         if (!m_socket->is_open())
             return;
 
-        auto buffer = message.encode();
+        auto buffer = message.encode(m_client_pid);
+        record_sent_message(message, buffer.size());
 
         int nwritten = write(m_socket->fd(), buffer.data(), buffer.size());
         if (nwritten < 0) {
@@ -162,6 +163,7 @@ public:
                 did_misbehave();
                 return;
             }
+            record_received_message(*message, decoded_bytes);
             if (auto response = m_endpoint.handle(*message))
                 post_message(*response);
             ASSERT(decoded_bytes);
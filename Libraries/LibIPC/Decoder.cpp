@@ -25,6 +25,7 @@
  */
 
 #include <AK/BufferStream.h>
+#include <AK/SharedBuffer.h>
 #include <LibIPC/Decoder.h>
 #include <LibIPC/Dictionary.h>
 
@@ -90,38 +91,108 @@ bool Decoder::decode(float& value)
     return !m_stream.handle_read_failure();
 }
 
-bool Decoder::decode(String& value)
+bool Decoder::decode_varint(u64& value)
+{
+    value = 0;
+    for (size_t shift = 0; shift < 64; shift += 7) {
+        u8 byte = 0;
+        m_stream >> byte;
+        if (m_stream.handle_read_failure())
+            return false;
+        value |= (u64)(byte & 0x7f) << shift;
+        if (!(byte & 0x80))
+            return true;
+    }
+    return false;
+}
+
+bool Decoder::decode_size(size_t& size)
+{
+    u64 value = 0;
+    if (!decode_varint(value) || value > m_stream.remaining())
+        return false;
+    size = value;
+    return true;
+}
+
+// Payloads that Encoder handed over in a shared buffer come as their size and shbuf_id.
+template<typename Callback>
+bool Decoder::decode_from_shared_buffer(Callback callback)
 {
-    i32 length = 0;
-    m_stream >> length;
+#ifdef __serenity__
+    u64 size = 0;
+    i32 shbuf_id = 0;
+    if (!decode_varint(size))
+        return false;
+    m_stream >> shbuf_id;
     if (m_stream.handle_read_failure())
         return false;
-    if (length < 0) {
+    auto shared_buffer = SharedBuffer::create_from_shbuf_id(shbuf_id);
+    if (!shared_buffer || size > static_cast<u64>(shared_buffer->size()))
+        return false;
+    callback((const u8*)shared_buffer->data(), static_cast<size_t>(size));
+    return true;
+#else
+    (void)callback;
+    return false;
+#endif
+}
+
+bool Decoder::decode(String& value)
+{
+    u64 header = 0;
+    if (!decode_varint(header))
+        return false;
+    if (header == null_payload) {
         value = {};
         return true;
     }
+    if (header == in_shared_buffer) {
+        return decode_from_shared_buffer([&](const u8* data, size_t size) {
+            value = String((const char*)data, size);
+        });
+    }
+    u64 length = header - first_inline_payload;
+    if (length > m_stream.remaining())
+        return false;
     if (length == 0) {
         value = String::empty();
         return true;
     }
     char* text_buffer = nullptr;
     auto text_impl = StringImpl::create_uninitialized(static_cast<size_t>(length), text_buffer);
-    for (size_t i = 0; i < static_cast<size_t>(length); ++i) {
-        m_stream >> text_buffer[i];
-    }
+    m_stream.read_raw((u8*)text_buffer, length);
     value = *text_impl;
     return !m_stream.handle_read_failure();
 }
 
-bool Decoder::decode(Dictionary& dictionary)
+bool Decoder::decode(ByteBuffer& value)
 {
-    u64 size = 0;
-    m_stream >> size;
-    if (m_stream.handle_read_failure())
+    u64 header = 0;
+    if (!decode_varint(header))
         return false;
-    if (size >= NumericLimits<i32>::max()) {
-        ASSERT_NOT_REACHED();
+    if (header == null_payload) {
+        value = {};
+        return true;
+    }
+    if (header == in_shared_buffer) {
+        return decode_from_shared_buffer([&](const u8* data, size_t size) {
+            value = ByteBuffer::copy(data, size);
+        });
     }
+    u64 length = header - first_inline_payload;
+    if (length > m_stream.remaining())
+        return false;
+    value = ByteBuffer::create_uninitialized(length);
+    m_stream.read_raw(value.data(), length);
+    return !m_stream.handle_read_failure();
+}
+
+bool Decoder::decode(Dictionary& dictionary)
+{
+    size_t size = 0;
+    if (!decode_size(size))
+        return false;
 
     for (size_t i = 0; i < size; ++i) {
         String key;
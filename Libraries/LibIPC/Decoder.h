@@ -60,6 +60,7 @@ public:
     bool decode(i64&);
     bool decode(float&);
     bool decode(String&);
+    bool decode(ByteBuffer&);
     bool decode(Dictionary&);
 
     template<typename T>
@@ -68,12 +69,17 @@ public:
         return IPC::decode(*this, value);
     }
 
+    bool decode_varint(u64&);
+    // A count of things that each take at least a byte, so it can't be more than what's left.
+    bool decode_size(size_t&);
+
     template<typename T>
     bool decode(Vector<T>& vector)
     {
-        u64 size;
-        if (!decode(size) || size > NumericLimits<i32>::max())
+        size_t size;
+        if (!decode_size(size))
             return false;
+        vector.ensure_capacity(vector.size() + size);
         for (size_t i = 0; i < size; ++i) {
             T value;
             if (!decode(value))
@@ -101,6 +107,9 @@ public:
     }
 
 private:
+    template<typename Callback>
+    bool decode_from_shared_buffer(Callback);
+
     BufferStream& m_stream;
 };
 
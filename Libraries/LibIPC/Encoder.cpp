@@ -24,9 +24,12 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <AK/ByteBuffer.h>
+#include <AK/SharedBuffer.h>
 #include <AK/String.h>
 #include <LibIPC/Dictionary.h>
 #include <LibIPC/Encoder.h>
+#include <string.h>
 
 namespace IPC {
 
@@ -111,6 +114,15 @@ Encoder& Encoder::operator<<(i64 value)
     return *this;
 }
 
+void Encoder::encode_varint(u64 value)
+{
+    while (value >= 0x80) {
+        m_buffer.append((u8)(value | 0x80));
+        value >>= 7;
+    }
+    m_buffer.append((u8)value);
+}
+
 Encoder& Encoder::operator<<(float value)
 {
     union bits {
@@ -132,17 +144,58 @@ Encoder& Encoder::operator<<(const StringView& value)
     return *this;
 }
 
+bool Encoder::encode_in_shared_buffer(const u8* data, size_t size)
+{
+#ifdef __serenity__
+    if (m_peer_pid < 0 || size < shared_buffer_threshold)
+        return false;
+    auto shared_buffer = SharedBuffer::create_with_size(size);
+    if (!shared_buffer)
+        return false;
+    memcpy(shared_buffer->data(), data, size);
+    shared_buffer->seal();
+    if (!shared_buffer->hand_over_to(m_peer_pid))
+        return false;
+    // Our own reference goes away with shared_buffer, the peer's once it's done decoding.
+    encode_varint(in_shared_buffer);
+    encode_varint(size);
+    *this << shared_buffer->shbuf_id();
+    return true;
+#else
+    (void)data;
+    (void)size;
+    return false;
+#endif
+}
+
 Encoder& Encoder::operator<<(const String& value)
 {
-    if (value.is_null())
-        return *this << (i32)-1;
-    *this << static_cast<i32>(value.length());
+    if (value.is_null()) {
+        encode_varint(null_payload);
+        return *this;
+    }
+    if (encode_in_shared_buffer((const u8*)value.characters(), value.length()))
+        return *this;
+    encode_varint(value.length() + first_inline_payload);
     return *this << value.view();
 }
 
+Encoder& Encoder::operator<<(const ByteBuffer& value)
+{
+    if (value.is_null()) {
+        encode_varint(null_payload);
+        return *this;
+    }
+    if (encode_in_shared_buffer(value.data(), value.size()))
+        return *this;
+    encode_varint(value.size() + first_inline_payload);
+    m_buffer.append(value.data(), value.size());
+    return *this;
+}
+
 Encoder& Encoder::operator<<(const Dictionary& dictionary)
 {
-    *this << (u64)dictionary.size();
+    encode_varint(dictionary.size());
     dictionary.for_each_entry([this](auto& key, auto& value) {
         *this << key << value;
     });
@@ -40,11 +40,16 @@ bool encode(BufferStream&, T&)
 
 class Encoder {
 public:
-    explicit Encoder(MessageBuffer& buffer)
+    explicit Encoder(MessageBuffer& buffer, pid_t peer_pid = -1)
         : m_buffer(buffer)
+        , m_peer_pid(peer_pid)
     {
     }
 
+    // Strings and ByteBuffers at least this big go to the peer in a shared buffer, instead
+    // of through the socket.
+    static constexpr size_t shared_buffer_threshold = 16 * KB;
+
     Encoder& operator<<(bool);
     Encoder& operator<<(u8);
     Encoder& operator<<(u16);
@@ -58,12 +63,16 @@ public:
     Encoder& operator<<(const char*);
     Encoder& operator<<(const StringView&);
     Encoder& operator<<(const String&);
+    Encoder& operator<<(const ByteBuffer&);
     Encoder& operator<<(const Dictionary&);
 
+    // Sizes and message IDs are written as LEB128 varints, so small ones take a single byte.
+    void encode_varint(u64);
+
     template<typename T>
     Encoder& operator<<(const Vector<T>& vector)
     {
-        *this << (u64)vector.size();
+        encode_varint(vector.size());
         for (auto& value : vector)
             *this << value;
         return *this;
@@ -92,7 +101,10 @@ public:
     }
 
 private:
+    bool encode_in_shared_buffer(const u8*, size_t);
+
     MessageBuffer& m_buffer;
+    pid_t m_peer_pid { -1 };
 };
 
 }
@@ -24,10 +24,66 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <AK/HashMap.h>
+#include <AK/LogStream.h>
+#include <AK/QuickSort.h>
+#include <AK/String.h>
 #include <LibIPC/Message.h>
+#include <stdlib.h>
 
 namespace IPC {
 
+struct MessageStatistics {
+    size_t sent_count { 0 };
+    size_t sent_bytes { 0 };
+    size_t received_count { 0 };
+    size_t received_bytes { 0 };
+};
+
+static HashMap<String, MessageStatistics>* s_statistics;
+
+static void dump_statistics()
+{
+    auto names = s_statistics->keys();
+    quick_sort(names.begin(), names.end(), [](auto& a, auto& b) { return a < b; });
+    dbg() << "IPC message statistics (count and bytes, sent / received):";
+    for (auto& name : names) {
+        auto& statistics = s_statistics->get(name).value();
+        dbg() << "    " << name << ": " << statistics.sent_count << " " << statistics.sent_bytes << " / " << statistics.received_count << " " << statistics.received_bytes;
+    }
+}
+
+static MessageStatistics* statistics_for(const Message& message)
+{
+    static enum { Unknown, Enabled, Disabled } s_state = Unknown;
+    if (s_state == Unknown) {
+        s_state = getenv("IPC_STATS") ? Enabled : Disabled;
+        if (s_state == Enabled) {
+            s_statistics = new HashMap<String, MessageStatistics>;
+            atexit(dump_statistics);
+        }
+    }
+    if (s_state == Disabled)
+        return nullptr;
+    return &s_statistics->ensure(message.message_name());
+}
+
+void record_sent_message(const Message& message, size_t size)
+{
+    if (auto* statistics = statistics_for(message)) {
+        ++statistics->sent_count;
+        statistics->sent_bytes += size;
+    }
+}
+
+void record_received_message(const Message& message, size_t size)
+{
+    if (auto* statistics = statistics_for(message)) {
+        ++statistics->received_count;
+        statistics->received_bytes += size;
+    }
+}
+
 Message::Message()
 {
 }
@@ -27,11 +27,20 @@
 #pragma once
 
 #include <AK/Vector.h>
+#include <sys/types.h>
 
 namespace IPC {
 
 typedef Vector<u8, 1024> MessageBuffer;
 
+// Strings and ByteBuffers start with one of these, or with their length plus
+// first_inline_payload when their contents follow inline.
+enum PayloadTag : u8 {
+    null_payload = 0,
+    in_shared_buffer = 1,
+    first_inline_payload = 2,
+};
+
 class Message {
 public:
     virtual ~Message();
@@ -39,10 +48,16 @@ public:
     virtual int endpoint_magic() const = 0;
     virtual int message_id() const = 0;
     virtual const char* message_name() const = 0;
-    virtual MessageBuffer encode() const = 0;
+    // Large payloads are handed over to the peer in shared buffers, unless peer_pid is -1.
+    virtual MessageBuffer encode(pid_t peer_pid) const = 0;
 
 protected:
     Message();
 };
 
+// With IPC_STATS set in the environment, a program counts the messages it sends and
+// receives, with their sizes on the wire, and prints the totals when it exits.
+void record_sent_message(const Message&, size_t size);
+void record_received_message(const Message&, size_t size);
+
 }
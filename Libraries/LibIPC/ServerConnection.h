@@ -27,7 +27,9 @@
 #pragma once
 
 #include <AK/ByteBuffer.h>
+#include <AK/Function.h>
 #include <AK/NonnullOwnPtrVector.h>
+#include <AK/Queue.h>
 #include <LibCore/Event.h>
 #include <LibCore/LocalSocket.h>
 #include <LibCore/Notifier.h>
@@ -81,8 +83,10 @@ public:
     template<typename MessageType>
     OwnPtr<MessageType> wait_for_specific_message()
     {
+        flush_batch();
         // Double check we don't already have the event waiting for us.
         // Otherwise we might end up blocked for a while for no reason.
+        dispatch_pending_responses();
         for (size_t i = 0; i < m_unprocessed_messages.size(); ++i) {
             if (m_unprocessed_messages[i].message_id() == MessageType::static_message_id())
                 return m_unprocessed_messages.take(i).template release_nonnull<MessageType>();
@@ -99,6 +103,7 @@ public:
             ASSERT(FD_ISSET(m_connection->fd(), &rfds));
             if (!drain_messages_from_server())
                 return nullptr;
+            dispatch_pending_responses();
             for (size_t i = 0; i < m_unprocessed_messages.size(); ++i) {
                 if (m_unprocessed_messages[i].message_id() == MessageType::static_message_id())
                     return m_unprocessed_messages.take(i).template release_nonnull<MessageType>();
@@ -108,15 +113,46 @@ public:
 
     bool post_message(const Message& message)
     {
-        auto buffer = message.encode();
-        int nwritten = write(m_connection->fd(), buffer.data(), buffer.size());
-        if (nwritten < 0) {
-            perror("write");
-            ASSERT_NOT_REACHED();
-            return false;
+        auto buffer = message.encode(m_server_pid);
+        record_sent_message(message, buffer.size());
+        if (m_batch_depth) {
+            m_batch_buffer.append(buffer.data(), buffer.size());
+            if (m_batch_buffer.size() >= max_batch_size)
+                return flush_batch();
+            return true;
         }
-        ASSERT(static_cast<size_t>(nwritten) == buffer.size());
-        return true;
+        return write_to_server(buffer.data(), buffer.size());
+    }
+
+    // Messages posted between begin_batch() and end_batch() go out in one write. Anything
+    // that waits for the server sends the batch first.
+    void begin_batch() { ++m_batch_depth; }
+    void end_batch()
+    {
+        ASSERT(m_batch_depth);
+        if (!--m_batch_depth)
+            flush_batch();
+    }
+
+    // Sends a synchronous request without waiting for the response. The server answers
+    // requests in order, so responses are matched up with their callbacks in order too.
+    template<typename RequestType, typename... Args>
+    void send_async_with_callback(Function<void(typename RequestType::ResponseType&)> callback, Args&&... args)
+    {
+        using ResponseType = typename RequestType::ResponseType;
+        m_pending_responses.enqueue({ ResponseType::static_message_id(), [callback = move(callback)](Message& message) {
+                                         if (callback)
+                                             callback(static_cast<ResponseType&>(message));
+                                     } });
+        bool success = post_message(RequestType(forward<Args>(args)...));
+        ASSERT(success);
+    }
+
+    // Like send_sync(), for requests whose response doesn't matter.
+    template<typename RequestType, typename... Args>
+    void send_async(Args&&... args)
+    {
+        send_async_with_callback<RequestType>(nullptr, forward<Args>(args)...);
     }
 
     template<typename RequestType, typename... Args>
@@ -130,6 +166,50 @@ public:
     }
 
 private:
+    struct PendingResponse {
+        i32 message_id;
+        Function<void(Message&)> callback;
+    };
+
+    static constexpr size_t max_batch_size = 4096;
+
+    bool write_to_server(const u8* data, size_t size)
+    {
+        int nwritten = write(m_connection->fd(), data, size);
+        if (nwritten < 0) {
+            perror("write");
+            ASSERT_NOT_REACHED();
+            return false;
+        }
+        ASSERT(static_cast<size_t>(nwritten) == size);
+        return true;
+    }
+
+    bool flush_batch()
+    {
+        if (m_batch_buffer.is_empty())
+            return true;
+        auto buffer = move(m_batch_buffer);
+        return write_to_server(buffer.data(), buffer.size());
+    }
+
+    // Hands the responses to send_async() requests that have come in to their callbacks.
+    void dispatch_pending_responses()
+    {
+        for (size_t i = 0; i < m_unprocessed_messages.size() && !m_pending_responses.is_empty();) {
+            auto& message = m_unprocessed_messages[i];
+            if (message.endpoint_magic() != PeerEndpoint::static_magic() || message.message_id() != m_pending_responses.head().message_id) {
+                ++i;
+                continue;
+            }
+            auto response = m_unprocessed_messages.take(i);
+            auto pending_response = m_pending_responses.dequeue();
+            pending_response.callback(*response);
+            // The callback may have talked to the server, so look at everything again.
+            i = 0;
+        }
+    }
+
     bool drain_messages_from_server()
     {
         Vector<u8> bytes;
@@ -156,8 +236,10 @@ private:
         for (size_t index = 0; index < bytes.size(); index += decoded_bytes) {
             auto remaining_bytes = ByteBuffer::wrap(bytes.data() + index, bytes.size() - index);
             if (auto message = LocalEndpoint::decode_message(remaining_bytes, decoded_bytes)) {
+                record_received_message(*message, decoded_bytes);
                 m_unprocessed_messages.append(message.release_nonnull());
             } else if (auto message = PeerEndpoint::decode_message(remaining_bytes, decoded_bytes)) {
+                record_received_message(*message, decoded_bytes);
                 m_unprocessed_messages.append(message.release_nonnull());
             } else {
                 ASSERT_NOT_REACHED();
@@ -175,6 +257,7 @@ private:
 
     void handle_messages()
     {
+        dispatch_pending_responses();
         auto messages = move(m_unprocessed_messages);
         for (auto& message : messages) {
             if (message.endpoint_magic() == LocalEndpoint::static_magic())
@@ -186,6 +269,9 @@ private:
     RefPtr<Core::LocalSocket> m_connection;
     RefPtr<Core::Notifier> m_notifier;
     NonnullOwnPtrVector<Message> m_unprocessed_messages;
+    Queue<PendingResponse, 16> m_pending_responses;
+    Vector<u8> m_batch_buffer;
+    int m_batch_depth { 0 };
     int m_server_pid { -1 };
     int m_my_client_id { -1 };
 };
@@ -30,7 +30,9 @@
 #include <AK/ScopeGuard.h>
 #include <AK/StringBuilder.h>
 #include <LibJS/AST.h>
+#include <LibJS/Bytecode/Generator.h>
 #include <LibJS/Interpreter.h>
+#include <LibJS/Parser.h>
 #include <LibJS/Runtime/Accessor.h>
 #include <LibJS/Runtime/Array.h>
 #include <LibJS/Runtime/Error.h>
@@ -39,6 +41,7 @@
 #include <LibJS/Runtime/NativeFunction.h>
 #include <LibJS/Runtime/PrimitiveString.h>
 #include <LibJS/Runtime/Reference.h>
+#include <LibJS/Runtime/RegExpObject.h>
 #include <LibJS/Runtime/ScriptFunction.h>
 #include <LibJS/Runtime/Shape.h>
 #include <LibJS/Runtime/StringObject.h>
@@ -46,7 +49,33 @@
 
 namespace JS {
 
-static void update_function_name(Value& value, const FlyString& name)
+RefPtr<ASTArena> ASTArena::s_current;
+
+struct alignas(8) ASTNodeAllocationHeader {
+    ASTArena* arena;
+};
+
+void* ASTNode::operator new(size_t size)
+{
+    auto* arena = ASTArena::current();
+    void* storage = arena ? arena->allocate(sizeof(ASTNodeAllocationHeader) + size) : kmalloc(sizeof(ASTNodeAllocationHeader) + size);
+    auto* header = static_cast<ASTNodeAllocationHeader*>(storage);
+    header->arena = arena;
+    if (arena)
+        arena->ref();
+    return header + 1;
+}
+
+void ASTNode::operator delete(void* pointer)
+{
+    auto* header = static_cast<ASTNodeAllocationHeader*>(pointer) - 1;
+    if (header->arena)
+        header->arena->unref();
+    else
+        kfree(header);
+}
+
+void update_function_name(Value& value, const FlyString& name)
 {
     if (!value.is_object())
         return;
@@ -57,26 +86,60 @@ static void update_function_name(Value& value, const FlyString& name)
             function.set_name(name);
     } else if (object.is_array()) {
         auto& array = static_cast<Array&>(object);
-        for (auto& entry : array.indexed_properties().values_unordered())
-            update_function_name(entry.value, name);
+        array.indexed_properties().for_each_value([&](Value element) {
+            update_function_name(element, name);
+        });
     }
 }
 
+ScopeNode::ScopeNode()
+{
+}
+
+ScopeNode::~ScopeNode()
+{
+}
+
+const Bytecode::Executable& ScopeNode::bytecode() const
+{
+    if (!m_bytecode)
+        m_bytecode = Bytecode::Generator::generate(*this);
+    return *m_bytecode;
+}
+
 Value ScopeNode::execute(Interpreter& interpreter) const
 {
     return interpreter.run(*this);
 }
 
+const Statement& FunctionBody::statement() const
+{
+    if (m_statement)
+        return *m_statement;
+
+    Parser parser(Lexer(m_source, m_line_number, m_line_column));
+    parser.set_lazy_function_bodies(true);
+    auto statement = parser.parse_function_body(m_strict_mode);
+    if (parser.has_errors()) {
+        m_syntax_error = parser.errors()[0].to_string();
+        m_statement = create_ast_node<BlockStatement>();
+    } else {
+        m_statement = move(statement);
+    }
+    m_source = {};
+    return *m_statement;
+}
+
 Value FunctionDeclaration::execute(Interpreter& interpreter) const
 {
-    auto* function = ScriptFunction::create(interpreter.global_object(), name(), body(), parameters(), function_length(), interpreter.current_environment());
+    auto* function = ScriptFunction::create(interpreter.global_object(), name(), function_body(), parameters(), function_length(), interpreter.current_environment());
     interpreter.set_variable(name(), function);
     return js_undefined();
 }
 
 Value FunctionExpression::execute(Interpreter& interpreter) const
 {
-    return ScriptFunction::create(interpreter.global_object(), name(), body(), parameters(), function_length(), interpreter.current_environment(), m_is_arrow_function);
+    return ScriptFunction::create(interpreter.global_object(), name(), function_body(), parameters(), function_length(), interpreter.current_environment(), m_is_arrow_function);
 }
 
 Value ExpressionStatement::execute(Interpreter& interpreter) const
@@ -99,12 +162,49 @@ CallExpression::ThisAndCallee CallExpression::compute_this_and_callee(Interprete
         auto* this_value = object_value.to_object(interpreter);
         if (interpreter.exception())
             return {};
-        auto callee = this_value->get(member_expression.computed_property_name(interpreter)).value_or(js_undefined());
+        auto callee = member_expression.get_property(interpreter, *this_value);
+        if (interpreter.exception())
+            return {};
         return { this_value, callee };
     }
     return { &interpreter.global_object(), m_callee->execute(interpreter) };
 }
 
+bool CallExpression::can_use_fast_native_call(const Function& function) const
+{
+    return !is_new_expression()
+        && !m_has_spread_argument
+        && m_arguments.size() <= max_fast_native_call_arguments
+        && function.is_native_function()
+        && function.bound_this().is_empty()
+        && function.bound_arguments().is_empty();
+}
+
+Value CallExpression::call_native_function(Interpreter& interpreter, NativeFunction& function, Value this_value) const
+{
+    // The arguments stay on the machine stack while the rest are evaluated, where the
+    // conservative root scan keeps them alive, so there's no MarkedValueList to register.
+    Value arguments[max_fast_native_call_arguments];
+    for (size_t i = 0; i < m_arguments.size(); ++i) {
+        arguments[i] = m_arguments[i].value->execute(interpreter);
+        if (interpreter.exception())
+            return {};
+    }
+
+    auto& call_frame = interpreter.push_call_frame();
+    call_frame.function = &function;
+    call_frame.function_name = function.name();
+    call_frame.this_value = this_value;
+    call_frame.arguments.append(arguments, m_arguments.size());
+    interpreter.poll_profiler();
+    auto result = function.call(interpreter);
+    interpreter.pop_call_frame();
+
+    if (interpreter.exception())
+        return {};
+    return result;
+}
+
 Value CallExpression::execute(Interpreter& interpreter) const
 {
     auto [this_value, callee] = compute_this_and_callee(interpreter);
@@ -113,6 +213,9 @@ Value CallExpression::execute(Interpreter& interpreter) const
 
     ASSERT(!callee.is_empty());
 
+    if (callee.is_object() && &callee.as_object() == m_native_call_cache.function && m_native_call_cache.collection_count == interpreter.heap().collection_count())
+        return call_native_function(interpreter, *m_native_call_cache.function, this_value);
+
     if (!callee.is_function()
         || (is_new_expression() && (callee.as_object().is_native_function() && !static_cast<NativeFunction&>(callee.as_object()).has_constructor()))) {
         String error_message;
@@ -132,6 +235,12 @@ Value CallExpression::execute(Interpreter& interpreter) const
 
     auto& function = callee.as_function();
 
+    if (can_use_fast_native_call(function)) {
+        auto& native_function = static_cast<NativeFunction&>(function);
+        m_native_call_cache = { &native_function, interpreter.heap().collection_count() };
+        return call_native_function(interpreter, native_function, this_value);
+    }
+
     MarkedValueList arguments(interpreter.heap());
     arguments.values().append(function.bound_arguments());
 
@@ -163,6 +272,7 @@ Value CallExpression::execute(Interpreter& interpreter) const
     }
 
     auto& call_frame = interpreter.push_call_frame();
+    call_frame.function = &function;
     call_frame.function_name = function.name();
     call_frame.arguments = arguments.values();
     call_frame.environment = function.create_environment();
@@ -553,7 +663,7 @@ Reference Expression::to_reference(Interpreter&) const
 
 Reference Identifier::to_reference(Interpreter& interpreter) const
 {
-    return interpreter.get_reference(string());
+    return interpreter.get_reference(string(), &m_cached_coordinate);
 }
 
 Reference MemberExpression::to_reference(Interpreter& interpreter) const
@@ -564,7 +674,7 @@ Reference MemberExpression::to_reference(Interpreter& interpreter) const
     auto property_name = computed_property_name(interpreter);
     if (!property_name.is_valid())
         return {};
-    return { object_value, property_name };
+    return { object_value, property_name, false, property_lookup_cache() };
 }
 
 Value UnaryExpression::execute(Interpreter& interpreter) const
@@ -825,6 +935,12 @@ void BooleanLiteral::dump(int indent) const
     printf("BooleanLiteral %s\n", m_value ? "true" : "false");
 }
 
+void RegExpLiteral::dump(int indent) const
+{
+    print_indent(indent);
+    printf("RegExpLiteral /%s/%s\n", m_pattern->source().characters(), m_flags.characters());
+}
+
 void NullLiteral::dump(int indent) const
 {
     print_indent(indent);
@@ -951,7 +1067,7 @@ void ForOfStatement::dump(int indent) const
 
 Value Identifier::execute(Interpreter& interpreter) const
 {
-    auto value = interpreter.get_variable(string());
+    auto value = interpreter.get_variable(string(), &m_cached_coordinate);
     if (value.is_empty())
         return interpreter.throw_exception<ReferenceError>(String::format("'%s' not known", string().characters()));
     return value;
@@ -1109,7 +1225,12 @@ Value UpdateExpression::execute(Interpreter& interpreter) const
         ASSERT_NOT_REACHED();
     }
 
-    auto new_value = Value(old_value.as_double() + op_result);
+    i32 int32_result;
+    Value new_value;
+    if (old_value.is_int32() && !__builtin_add_overflow(old_value.as_i32(), op_result, &int32_result))
+        new_value = Value(int32_result);
+    else
+        new_value = Value(old_value.as_double() + op_result);
     reference.put(interpreter, new_value);
     if (interpreter.exception())
         return {};
@@ -1200,7 +1321,7 @@ Value VariableDeclaration::execute(Interpreter& interpreter) const
                 return {};
             auto variable_name = declarator.id().string();
             update_function_name(initalizer_result, variable_name);
-            interpreter.set_variable(variable_name, initalizer_result, true);
+            interpreter.set_variable(variable_name, initalizer_result, true, &declarator.id().cached_coordinate());
         }
     }
     return js_undefined();
@@ -1367,6 +1488,9 @@ PropertyName MemberExpression::computed_property_name(Interpreter& interpreter)
     if (index.is_integer() && index.as_i32() >= 0)
         return index.as_i32();
 
+    if (index.is_string())
+        return index.as_string().fly_string();
+
     auto index_string = index.to_string(interpreter);
     if (interpreter.exception())
         return {};
@@ -1392,7 +1516,26 @@ Value MemberExpression::execute(Interpreter& interpreter) const
     auto* object_result = object_value.to_object(interpreter);
     if (interpreter.exception())
         return {};
-    return object_result->get(computed_property_name(interpreter)).value_or(js_undefined());
+    return get_property(interpreter, *object_result);
+}
+
+PropertyLookupCache* MemberExpression::property_lookup_cache() const
+{
+    if (is_computed())
+        return nullptr;
+    if (!m_property_lookup_cache)
+        m_property_lookup_cache = make<PropertyLookupCache>();
+    return m_property_lookup_cache;
+}
+
+Value MemberExpression::get_property(Interpreter& interpreter, Object& object) const
+{
+    if (auto* cache = property_lookup_cache())
+        return object.get(static_cast<const Identifier&>(*m_property).string(), *cache).value_or(js_undefined());
+    auto property_name = computed_property_name(interpreter);
+    if (interpreter.exception())
+        return {};
+    return object.get(property_name).value_or(js_undefined());
 }
 
 Value StringLiteral::execute(Interpreter& interpreter) const
@@ -1400,6 +1543,11 @@ Value StringLiteral::execute(Interpreter& interpreter) const
     return js_string(interpreter, m_value);
 }
 
+Value RegExpLiteral::execute(Interpreter& interpreter) const
+{
+    return RegExpObject::create(interpreter.global_object(), m_pattern, m_flags);
+}
+
 Value NumericLiteral::execute(Interpreter&) const
 {
     return Value(m_value);
@@ -1746,6 +1894,17 @@ Value DebuggerStatement::execute(Interpreter&) const
 
 void ScopeNode::add_variables(NonnullRefPtrVector<VariableDeclaration> variables)
 {
+    for (auto& declaration : variables) {
+        for (auto& declarator : declaration.declarations()) {
+            auto& name = declarator.id().string();
+            if (auto index = m_variable_names.find_first_index(name); index.has_value()) {
+                m_variable_kinds[index.value()] = declaration.declaration_kind();
+                continue;
+            }
+            m_variable_names.append(name);
+            m_variable_kinds.append(declaration.declaration_kind());
+        }
+    }
     m_variables.append(move(variables));
 }
 
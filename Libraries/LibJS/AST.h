@@ -27,20 +27,50 @@
 
 #pragma once
 
+#include <AK/Arena.h>
 #include <AK/FlyString.h>
 #include <AK/HashMap.h>
 #include <AK/NonnullRefPtrVector.h>
+#include <AK/Optional.h>
+#include <AK/OwnPtr.h>
 #include <AK/RefPtr.h>
 #include <AK/String.h>
 #include <AK/Vector.h>
+#include <LibJS/Bytecode/Register.h>
 #include <LibJS/Forward.h>
+#include <LibJS/Runtime/LexicalEnvironment.h>
+#include <LibJS/Runtime/PropertyLookupCache.h>
 #include <LibJS/Runtime/PropertyName.h>
 #include <LibJS/Runtime/Value.h>
+#include <LibRegex/Pattern.h>
 
 namespace JS {
 
+namespace Bytecode {
+struct Executable;
+class Generator;
+}
+
 class VariableDeclaration;
 
+// Nodes created while an arena is current are carved out of it. Every node holds a reference
+// to its arena, so the arena's memory lives until the last of its nodes has been destroyed.
+class ASTArena : public RefCounted<ASTArena> {
+public:
+    static NonnullRefPtr<ASTArena> create() { return adopt(*new ASTArena); }
+
+    static ASTArena* current() { return s_current.ptr(); }
+    static RefPtr<ASTArena> set_current(RefPtr<ASTArena> arena) { return exchange(s_current, move(arena)); }
+
+    void* allocate(size_t size) { return m_arena.allocate(size); }
+
+private:
+    ASTArena() { }
+
+    static RefPtr<ASTArena> s_current;
+    Arena m_arena;
+};
+
 template<class T, class... Args>
 static inline NonnullRefPtr<T>
 create_ast_node(Args&&... args)
@@ -63,6 +93,13 @@ public:
     virtual bool is_call_expression() const { return false; }
     virtual bool is_new_expression() const { return false; }
 
+    // Nodes without a bytecode implementation of their own are executed by the AST
+    // interpreter from within the bytecode.
+    virtual Optional<Bytecode::Register> generate_bytecode(Bytecode::Generator&) const;
+
+    static void* operator new(size_t);
+    static void operator delete(void*);
+
 protected:
     ASTNode() { }
 
@@ -81,6 +118,7 @@ protected:
 class EmptyStatement final : public Statement {
 public:
     Value execute(Interpreter&) const override { return js_undefined(); }
+    virtual Optional<Bytecode::Register> generate_bytecode(Bytecode::Generator&) const override;
     const char* class_name() const override { return "EmptyStatement"; }
 };
 
@@ -98,6 +136,7 @@ public:
     }
 
     Value execute(Interpreter&) const override;
+    virtual Optional<Bytecode::Register> generate_bytecode(Bytecode::Generator&) const override;
     const char* class_name() const override { return "ExpressionStatement"; }
     virtual void dump(int indent) const override;
 
@@ -121,22 +160,34 @@ public:
 
     const NonnullRefPtrVector<Statement>& children() const { return m_children; }
     virtual Value execute(Interpreter&) const override;
+    virtual Optional<Bytecode::Register> generate_bytecode(Bytecode::Generator&) const override;
     virtual void dump(int indent) const override;
 
     void add_variables(NonnullRefPtrVector<VariableDeclaration>);
     const NonnullRefPtrVector<VariableDeclaration>& variables() const { return m_variables; }
 
+    // Every name declared by variables(), once, in the order of the slots they get in this
+    // scope's environment.
+    const Vector<FlyString>& variable_names() const { return m_variable_names; }
+    const Vector<DeclarationKind>& variable_kinds() const { return m_variable_kinds; }
+
     bool in_strict_mode() const { return m_strict_mode; }
     void set_strict_mode() { m_strict_mode = true; }
 
+    const Bytecode::Executable& bytecode() const;
+
 protected:
-    ScopeNode() { }
+    ScopeNode();
+    virtual ~ScopeNode() override;
 
 private:
     virtual bool is_scope_node() const final { return true; }
     NonnullRefPtrVector<Statement> m_children;
     NonnullRefPtrVector<VariableDeclaration> m_variables;
+    Vector<FlyString> m_variable_names;
+    Vector<DeclarationKind> m_variable_kinds;
     bool m_strict_mode { false };
+    mutable OwnPtr<Bytecode::Executable> m_bytecode;
 };
 
 class Program : public ScopeNode {
@@ -164,6 +215,56 @@ public:
 class Declaration : public Statement {
 };
 
+// The body of a function. A body that the parser only pre-parsed keeps its source text instead
+// of statements, and is parsed in full the first time anything asks for them.
+class FunctionBody : public RefCounted<FunctionBody> {
+public:
+    static NonnullRefPtr<FunctionBody> create(NonnullRefPtr<Statement> statement) { return adopt(*new FunctionBody(move(statement))); }
+    static NonnullRefPtr<FunctionBody> create_lazy(String source, size_t line_number, size_t line_column, bool strict_mode)
+    {
+        return adopt(*new FunctionBody(move(source), line_number, line_column, strict_mode));
+    }
+
+    bool is_parsed() const { return m_statement; }
+
+    // A body that fails to parse is replaced by an empty block, and syntax_error() says why.
+    const Statement& statement() const;
+    bool has_syntax_error() const { return !m_syntax_error.is_null(); }
+    const String& syntax_error() const { return m_syntax_error; }
+
+    // Where the function starts in its script, for profiles.
+    size_t function_line_number() const { return m_function_line_number; }
+    size_t function_line_column() const { return m_function_line_column; }
+    void set_function_position(size_t line_number, size_t line_column)
+    {
+        m_function_line_number = line_number;
+        m_function_line_column = line_column;
+    }
+
+private:
+    explicit FunctionBody(NonnullRefPtr<Statement> statement)
+        : m_statement(move(statement))
+    {
+    }
+
+    FunctionBody(String source, size_t line_number, size_t line_column, bool strict_mode)
+        : m_source(move(source))
+        , m_line_number(line_number)
+        , m_line_column(line_column)
+        , m_strict_mode(strict_mode)
+    {
+    }
+
+    mutable RefPtr<Statement> m_statement;
+    mutable String m_source;
+    mutable String m_syntax_error;
+    size_t m_line_number { 0 };
+    size_t m_line_column { 0 };
+    size_t m_function_line_number { 0 };
+    size_t m_function_line_column { 0 };
+    bool m_strict_mode { false };
+};
+
 class FunctionNode {
 public:
     struct Parameter {
@@ -173,11 +274,12 @@ public:
     };
 
     const FlyString& name() const { return m_name; }
-    const Statement& body() const { return *m_body; }
+    const Statement& body() const { return m_body->statement(); }
+    const FunctionBody& function_body() const { return *m_body; }
     const Vector<Parameter>& parameters() const { return m_parameters; };
 
 protected:
-    FunctionNode(const FlyString& name, NonnullRefPtr<Statement> body, Vector<Parameter> parameters, i32 function_length, NonnullRefPtrVector<VariableDeclaration> variables)
+    FunctionNode(const FlyString& name, NonnullRefPtr<FunctionBody> body, Vector<Parameter> parameters, i32 function_length, NonnullRefPtrVector<VariableDeclaration> variables)
         : m_name(name)
         , m_body(move(body))
         , m_parameters(move(parameters))
@@ -193,7 +295,7 @@ protected:
 
 private:
     FlyString m_name;
-    NonnullRefPtr<Statement> m_body;
+    NonnullRefPtr<FunctionBody> m_body;
     const Vector<Parameter> m_parameters;
     NonnullRefPtrVector<VariableDeclaration> m_variables;
     const i32 m_function_length;
@@ -205,7 +307,7 @@ class FunctionDeclaration final
 public:
     static bool must_have_name() { return true; }
 
-    FunctionDeclaration(const FlyString& name, NonnullRefPtr<Statement> body, Vector<Parameter> parameters, i32 function_length, NonnullRefPtrVector<VariableDeclaration> variables)
+    FunctionDeclaration(const FlyString& name, NonnullRefPtr<FunctionBody> body, Vector<Parameter> parameters, i32 function_length, NonnullRefPtrVector<VariableDeclaration> variables)
         : FunctionNode(name, move(body), move(parameters), function_length, move(variables))
     {
     }
@@ -223,7 +325,7 @@ class FunctionExpression final
 public:
     static bool must_have_name() { return false; }
 
-    FunctionExpression(const FlyString& name, NonnullRefPtr<Statement> body, Vector<Parameter> parameters, i32 function_length, NonnullRefPtrVector<VariableDeclaration> variables, bool is_arrow_function = false)
+    FunctionExpression(const FlyString& name, NonnullRefPtr<FunctionBody> body, Vector<Parameter> parameters, i32 function_length, NonnullRefPtrVector<VariableDeclaration> variables, bool is_arrow_function = false)
         : FunctionNode(name, move(body), move(parameters), function_length, move(variables))
         , m_is_arrow_function(is_arrow_function)
     {
@@ -254,6 +356,7 @@ public:
     const Expression* argument() const { return m_argument; }
 
     virtual Value execute(Interpreter&) const override;
+    virtual Optional<Bytecode::Register> generate_bytecode(Bytecode::Generator&) const override;
     virtual void dump(int indent) const override;
 
 private:
@@ -276,6 +379,7 @@ public:
     const Statement* alternate() const { return m_alternate; }
 
     virtual Value execute(Interpreter&) const override;
+    virtual Optional<Bytecode::Register> generate_bytecode(Bytecode::Generator&) const override;
     virtual void dump(int indent) const override;
 
 private:
@@ -298,6 +402,7 @@ public:
     const Statement& body() const { return *m_body; }
 
     virtual Value execute(Interpreter&) const override;
+    virtual Optional<Bytecode::Register> generate_bytecode(Bytecode::Generator&) const override;
     virtual void dump(int indent) const override;
 
 private:
@@ -319,6 +424,7 @@ public:
     const Statement& body() const { return *m_body; }
 
     virtual Value execute(Interpreter&) const override;
+    virtual Optional<Bytecode::Register> generate_bytecode(Bytecode::Generator&) const override;
     virtual void dump(int indent) const override;
 
 private:
@@ -344,6 +450,7 @@ public:
     const Statement& body() const { return *m_body; }
 
     virtual Value execute(Interpreter&) const override;
+    virtual Optional<Bytecode::Register> generate_bytecode(Bytecode::Generator&) const override;
     virtual void dump(int indent) const override;
 
 private:
@@ -438,6 +545,7 @@ public:
     }
 
     virtual Value execute(Interpreter&) const override;
+    virtual Optional<Bytecode::Register> generate_bytecode(Bytecode::Generator&) const override;
     virtual void dump(int indent) const override;
 
 private:
@@ -464,6 +572,7 @@ public:
     }
 
     virtual Value execute(Interpreter&) const override;
+    virtual Optional<Bytecode::Register> generate_bytecode(Bytecode::Generator&) const override;
     virtual void dump(int indent) const override;
 
 private:
@@ -493,6 +602,7 @@ public:
     }
 
     virtual Value execute(Interpreter&) const override;
+    virtual Optional<Bytecode::Register> generate_bytecode(Bytecode::Generator&) const override;
     virtual void dump(int indent) const override;
 
 private:
@@ -511,6 +621,7 @@ public:
 
     virtual void dump(int indent) const override;
     virtual Value execute(Interpreter&) const override;
+    virtual Optional<Bytecode::Register> generate_bytecode(Bytecode::Generator&) const override;
 
 private:
     virtual const char* class_name() const override { return "SequenceExpression"; }
@@ -531,6 +642,7 @@ public:
     }
 
     virtual Value execute(Interpreter&) const override;
+    virtual Optional<Bytecode::Register> generate_bytecode(Bytecode::Generator&) const override;
     virtual void dump(int indent) const override;
 
 private:
@@ -547,6 +659,7 @@ public:
     }
 
     virtual Value execute(Interpreter&) const override;
+    virtual Optional<Bytecode::Register> generate_bytecode(Bytecode::Generator&) const override;
     virtual void dump(int indent) const override;
 
 private:
@@ -563,6 +676,7 @@ public:
     }
 
     virtual Value execute(Interpreter&) const override;
+    virtual Optional<Bytecode::Register> generate_bytecode(Bytecode::Generator&) const override;
     virtual void dump(int indent) const override;
 
 private:
@@ -576,12 +690,32 @@ public:
     explicit NullLiteral() { }
 
     virtual Value execute(Interpreter&) const override;
+    virtual Optional<Bytecode::Register> generate_bytecode(Bytecode::Generator&) const override;
     virtual void dump(int indent) const override;
 
 private:
     virtual const char* class_name() const override { return "NullLiteral"; }
 };
 
+class RegExpLiteral final : public Literal {
+public:
+    RegExpLiteral(NonnullRefPtr<Regex::Pattern> pattern, String flags)
+        : m_pattern(move(pattern))
+        , m_flags(move(flags))
+    {
+    }
+
+    virtual Value execute(Interpreter&) const override;
+    virtual void dump(int indent) const override;
+
+private:
+    virtual const char* class_name() const override { return "RegExpLiteral"; }
+
+    // Compiled once by the parser and shared by every RegExp object the literal evaluates to.
+    NonnullRefPtr<Regex::Pattern> m_pattern;
+    String m_flags;
+};
+
 class Identifier final : public Expression {
 public:
     explicit Identifier(const FlyString& string)
@@ -591,7 +725,11 @@ public:
 
     const FlyString& string() const { return m_string; }
 
+    // Where this identifier was last found in the environment chain.
+    Optional<EnvironmentCoordinate>& cached_coordinate() const { return m_cached_coordinate; }
+
     virtual Value execute(Interpreter&) const override;
+    virtual Optional<Bytecode::Register> generate_bytecode(Bytecode::Generator&) const override;
     virtual void dump(int indent) const override;
     virtual bool is_identifier() const override { return true; }
     virtual Reference to_reference(Interpreter&) const override;
@@ -600,6 +738,7 @@ private:
     virtual const char* class_name() const override { return "Identifier"; }
 
     FlyString m_string;
+    mutable Optional<EnvironmentCoordinate> m_cached_coordinate;
 };
 
 class SpreadExpression final : public Expression {
@@ -639,6 +778,10 @@ public:
         : m_callee(move(callee))
         , m_arguments(move(arguments))
     {
+        for (auto& argument : m_arguments) {
+            if (argument.is_spread)
+                m_has_spread_argument = true;
+        }
     }
 
     virtual Value execute(Interpreter&) const override;
@@ -654,8 +797,21 @@ private:
     };
     ThisAndCallee compute_this_and_callee(Interpreter&) const;
 
+    static constexpr size_t max_fast_native_call_arguments = 8;
+    bool can_use_fast_native_call(const Function&) const;
+    Value call_native_function(Interpreter&, NativeFunction&, Value this_value) const;
+
     NonnullRefPtr<Expression> m_callee;
     const Vector<Argument> m_arguments;
+    bool m_has_spread_argument { false };
+
+    // The native function this site called last time. Cells are only freed by a collection,
+    // so the pointer can be trusted to still name the same function until the next one.
+    struct NativeCallCache {
+        NativeFunction* function { nullptr };
+        size_t collection_count { 0 };
+    };
+    mutable NativeCallCache m_native_call_cache;
 };
 
 class NewExpression final : public CallExpression {
@@ -697,6 +853,7 @@ public:
     }
 
     virtual Value execute(Interpreter&) const override;
+    virtual Optional<Bytecode::Register> generate_bytecode(Bytecode::Generator&) const override;
     virtual void dump(int indent) const override;
 
 private:
@@ -722,6 +879,7 @@ public:
     }
 
     virtual Value execute(Interpreter&) const override;
+    virtual Optional<Bytecode::Register> generate_bytecode(Bytecode::Generator&) const override;
     virtual void dump(int indent) const override;
 
 private:
@@ -776,6 +934,7 @@ public:
     DeclarationKind declaration_kind() const { return m_declaration_kind; }
 
     virtual Value execute(Interpreter&) const override;
+    virtual Optional<Bytecode::Register> generate_bytecode(Bytecode::Generator&) const override;
     virtual void dump(int indent) const override;
 
     const NonnullRefPtrVector<VariableDeclarator>& declarations() const { return m_declarations; }
@@ -916,6 +1075,12 @@ public:
 
     PropertyName computed_property_name(Interpreter&) const;
 
+    // The inline cache for `object.name` accesses; computed accesses have none.
+    PropertyLookupCache* property_lookup_cache() const;
+
+    // Gets the property from an object this expression's object() evaluated to.
+    Value get_property(Interpreter&, Object&) const;
+
     String to_string_approximation() const;
 
 private:
@@ -925,6 +1090,7 @@ private:
     NonnullRefPtr<Expression> m_object;
     NonnullRefPtr<Expression> m_property;
     bool m_computed { false };
+    mutable OwnPtr<PropertyLookupCache> m_property_lookup_cache;
 };
 
 class ConditionalExpression final : public Expression {
@@ -938,6 +1104,7 @@ public:
 
     virtual void dump(int indent) const override;
     virtual Value execute(Interpreter&) const override;
+    virtual Optional<Bytecode::Register> generate_bytecode(Bytecode::Generator&) const override;
 
 private:
     virtual const char* class_name() const override { return "ConditionalExpression"; }
@@ -1057,6 +1224,7 @@ public:
     }
 
     virtual Value execute(Interpreter&) const override;
+    virtual Optional<Bytecode::Register> generate_bytecode(Bytecode::Generator&) const override;
 
     const FlyString& target_label() const { return m_target_label; }
 
@@ -1074,6 +1242,7 @@ public:
     }
 
     virtual Value execute(Interpreter&) const override;
+    virtual Optional<Bytecode::Register> generate_bytecode(Bytecode::Generator&) const override;
 
     const FlyString& target_label() const { return m_target_label; }
 
@@ -1093,4 +1262,8 @@ private:
     virtual const char* class_name() const override { return "DebuggerStatement"; }
 };
 
+
+// Gives anonymous functions the name of the variable or property they are assigned to.
+void update_function_name(Value&, const FlyString&);
+
 }
@@ -0,0 +1,45 @@
+// The Array.prototype functions that take callbacks, plus push/pop/shift/slice/join on
+// dense arrays.
+
+var numbers = [];
+for (var i = 0; i < 10000; ++i)
+    numbers.push(i);
+
+var checksum = 0;
+for (var round = 0; round < 10; ++round) {
+    var doubled = numbers.map(x => x * 2);
+    var even = doubled.filter(x => x % 4 === 0);
+    checksum += even.reduce((sum, x) => sum + x, 0);
+
+    var count = 0;
+    numbers.forEach(x => {
+        if (x % 3 === 0)
+            ++count;
+    });
+    checksum += count;
+
+    checksum += numbers.indexOf(9999) + numbers.lastIndexOf(0);
+    checksum += numbers.some(x => x > 9998) ? 1 : 0;
+    checksum += numbers.every(x => x >= 0) ? 1 : 0;
+    checksum += numbers.find(x => x * x > 1000000);
+    checksum += numbers.findIndex(x => x === 5000);
+    checksum += numbers.includes(1234) ? 1 : 0;
+}
+
+var queue = [];
+for (var i = 0; i < 2000; ++i)
+    queue.push(i);
+var drained = 0;
+while (queue.length)
+    drained += queue.shift();
+
+var stack = [];
+for (var i = 0; i < 20000; ++i)
+    stack.push(i);
+while (stack.length > 1)
+    stack.push(stack.pop() + stack.pop());
+
+var joined = numbers.slice(0, 1000).join(",");
+
+if (checksum !== 10 * (49990000 + 3334 + 9999 + 1 + 1 + 1001 + 5000 + 1) || drained !== 1999000 || stack[0] !== 199990000 || joined.length !== 3889)
+    throw new Error("array-builtins: wrong result " + checksum + " " + drained + " " + stack[0] + " " + joined.length);
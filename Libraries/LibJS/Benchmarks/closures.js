@@ -0,0 +1,55 @@
+// Creating closures and calling them, reading and writing captured variables at
+// various depths.
+
+function makeCounter() {
+    var count = 0;
+    return {
+        increment: function () {
+            return ++count;
+        },
+        current: function () {
+            return count;
+        },
+    };
+}
+
+function makeAdder(a) {
+    return function (b) {
+        return function (c) {
+            return a + b + c;
+        };
+    };
+}
+
+function compose(f, g) {
+    return function (x) {
+        return f(g(x));
+    };
+}
+
+var counter = makeCounter();
+for (var i = 0; i < 100000; ++i)
+    counter.increment();
+
+var sum = 0;
+for (var i = 0; i < 20000; ++i)
+    sum += makeAdder(i)(1)(2);
+
+var addOne = function (x) { return x + 1; };
+var double = function (x) { return x * 2; };
+var composed = compose(addOne, compose(double, addOne));
+var result = 0;
+for (var i = 0; i < 30000; ++i)
+    result += composed(i) % 7;
+
+var arrows = 0;
+var callbacks = [];
+for (var i = 0; i < 1000; ++i)
+    callbacks.push(x => x + i);
+for (var round = 0; round < 20; ++round) {
+    for (var j = 0; j < callbacks.length; ++j)
+        arrows += callbacks[j](round);
+}
+
+if (counter.current() !== 100000 || sum !== 200050000 || arrows !== 20 * 1000 * 1000 + 1000 * 190)
+    throw new Error("closures: wrong result " + counter.current() + " " + sum + " " + arrows);
@@ -0,0 +1,30 @@
+// Lots of short-lived garbage next to a long-lived tree, so collections have both
+// something to sweep and something to mark.
+
+function makeTree(depth) {
+    if (depth === 0)
+        return { left: null, right: null };
+    return { left: makeTree(depth - 1), right: makeTree(depth - 1) };
+}
+
+function countNodes(node) {
+    if (!node)
+        return 0;
+    return 1 + countNodes(node.left) + countNodes(node.right);
+}
+
+var longLived = makeTree(14);
+
+var sum = 0;
+for (var round = 0; round < 40; ++round) {
+    var temporary = makeTree(10);
+    sum += countNodes(temporary);
+
+    var garbage = [];
+    for (var i = 0; i < 2000; ++i)
+        garbage.push({ index: i, name: "object" + i, values: [i, i + 1, i + 2] });
+    sum += garbage.length;
+}
+
+if (countNodes(longLived) !== 32767 || sum !== 40 * (2047 + 2000))
+    throw new Error("gc-churn: wrong result " + sum);
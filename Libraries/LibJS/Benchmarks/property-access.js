@@ -0,0 +1,63 @@
+// Named property loads and stores on objects that share a shape, through the prototype
+// chain, and on a megamorphic site that sees more shapes than an inline cache holds.
+
+function Point(x, y) {
+    this.x = x;
+    this.y = y;
+}
+
+Point.prototype.lengthSquared = function () {
+    return this.x * this.x + this.y * this.y;
+};
+
+function monomorphic(points) {
+    var sum = 0;
+    for (var i = 0; i < points.length; ++i) {
+        var point = points[i];
+        point.x = point.x + 1;
+        sum += point.x + point.y;
+    }
+    return sum;
+}
+
+function prototypeChain(points) {
+    var sum = 0;
+    for (var i = 0; i < points.length; ++i)
+        sum += points[i].lengthSquared();
+    return sum;
+}
+
+function megamorphic(objects) {
+    var sum = 0;
+    for (var i = 0; i < objects.length; ++i)
+        sum += objects[i].value;
+    return sum;
+}
+
+var points = [];
+for (var i = 0; i < 1000; ++i)
+    points.push(new Point(i, 2 * i));
+
+var objects = [];
+for (var i = 0; i < 1000; ++i) {
+    switch (i % 8) {
+    case 0: objects.push({ value: 1 }); break;
+    case 1: objects.push({ a: 0, value: 1 }); break;
+    case 2: objects.push({ b: 0, value: 1 }); break;
+    case 3: objects.push({ c: 0, value: 1 }); break;
+    case 4: objects.push({ a: 0, b: 0, value: 1 }); break;
+    case 5: objects.push({ a: 0, c: 0, value: 1 }); break;
+    case 6: objects.push({ b: 0, c: 0, value: 1 }); break;
+    case 7: objects.push({ a: 0, b: 0, c: 0, value: 1 }); break;
+    }
+}
+
+var total = 0;
+for (var round = 0; round < 200; ++round) {
+    total += monomorphic(points);
+    total += prototypeChain(points) % 1000;
+    total += megamorphic(objects);
+}
+
+if (points[0].x !== 200 || megamorphic(objects) !== 1000)
+    throw new Error("property-access: wrong result " + total);
@@ -0,0 +1,23 @@
+#!/bin/bash
+
+if [ "$(uname)" = "SerenityOS" ]; then
+    js_program=/bin/js
+else
+    [ -z "$js_program" ] && js_program="$SERENITY_ROOT/Build/Meta/Lagom/js"
+fi
+
+[ -z "$runs" ] && runs=5
+
+fail_count=0
+
+for f in *.js; do
+    if ! "$js_program" "$@" -B "$runs" "$f"; then
+        echo -e "\033[31;1mFailed\033[0m: $f"
+        (( ++fail_count ))
+    fi
+done
+
+if (( fail_count > 0 )); then
+    exit 1
+fi
+exit 0
@@ -0,0 +1,27 @@
+// Building strings piece by piece with +=, template literals and join, then reading
+// them back.
+
+var concatenated = "";
+for (var i = 0; i < 20000; ++i)
+    concatenated += "item" + i + ";";
+
+var templated = "";
+for (var i = 0; i < 10000; ++i)
+    templated += `<li id="${i}">${i * 2}</li>`;
+
+var parts = [];
+for (var i = 0; i < 20000; ++i)
+    parts.push(String(i));
+var joined = parts.join("-");
+
+var characters = 0;
+for (var i = 0; i < concatenated.length; i += 7) {
+    if (concatenated.charAt(i) === ";")
+        ++characters;
+}
+
+var upper = concatenated.substring(0, 10000).toUpperCase();
+var repeated = "abc".repeat(10000);
+
+if (concatenated.length !== 188890 || !templated.startsWith("<li id=\"0\">0</li>") || joined.length !== 108889 || upper.indexOf("ITEM999;") < 0 || repeated.length !== 30000)
+    throw new Error("string-building: wrong result " + concatenated.length + " " + joined.length + " " + characters);
@@ -0,0 +1,423 @@
+/*
+ * Copyright (c) 2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <LibJS/AST.h>
+#include <LibJS/Bytecode/Generator.h>
+#include <LibJS/Interpreter.h>
+
+namespace JS {
+
+using Bytecode::Opcode;
+using Bytecode::Register;
+
+Optional<Register> ASTNode::generate_bytecode(Bytecode::Generator& generator) const
+{
+    return generator.emit_fallback(*this);
+}
+
+Optional<Register> ExpressionStatement::generate_bytecode(Bytecode::Generator& generator) const
+{
+    return m_expression->generate_bytecode(generator);
+}
+
+Optional<Register> EmptyStatement::generate_bytecode(Bytecode::Generator&) const
+{
+    return {};
+}
+
+Optional<Register> ScopeNode::generate_bytecode(Bytecode::Generator& generator) const
+{
+    // Breaking out of a labeled block is handled by Interpreter::run(), so those are run as
+    // a separate executable instead of inline.
+    if (!label().is_null())
+        return generator.emit_fallback(*this);
+
+    generator.begin_scope(*this);
+    for (auto& child : children())
+        child.generate_bytecode(generator);
+    generator.end_scope();
+    return {};
+}
+
+// A statement run through Interpreter::run() only produces a value if it isn't a scope.
+static void generate_statement_into(Bytecode::Generator& generator, const Statement& statement, Register result)
+{
+    auto value = statement.generate_bytecode(generator);
+    if (statement.is_scope_node())
+        generator.emit(Opcode::LoadUndefined, result);
+    else if (value.has_value())
+        generator.emit(Opcode::Move, result, value.value().index());
+    else
+        generator.emit(Opcode::LoadUndefined, result);
+}
+
+Optional<Register> ReturnStatement::generate_bytecode(Bytecode::Generator& generator) const
+{
+    auto value = m_argument ? generator.generate_value(*m_argument) : generator.emit_load_undefined();
+    generator.emit(Opcode::Return, 0, value.index());
+    return {};
+}
+
+Optional<Register> IfStatement::generate_bytecode(Bytecode::Generator& generator) const
+{
+    auto result = generator.emit_load_undefined();
+    auto predicate = generator.generate_value(*m_predicate);
+    auto jump_to_alternate = generator.emit_conditional_jump(Opcode::JumpIfFalse, predicate);
+    generate_statement_into(generator, *m_consequent, result);
+    if (!m_alternate) {
+        generator.set_jump_target(jump_to_alternate, generator.next_instruction_index());
+        return result;
+    }
+    auto jump_to_end = generator.emit_jump();
+    generator.set_jump_target(jump_to_alternate, generator.next_instruction_index());
+    generate_statement_into(generator, *m_alternate, result);
+    generator.set_jump_target(jump_to_end, generator.next_instruction_index());
+    return result;
+}
+
+Optional<Register> WhileStatement::generate_bytecode(Bytecode::Generator& generator) const
+{
+    auto result = generator.emit_load_undefined();
+    generator.begin_loop(label());
+    auto test_index = generator.next_instruction_index();
+    auto test = generator.generate_value(*m_test);
+    auto jump_to_end = generator.emit_conditional_jump(Opcode::JumpIfFalse, test);
+    generate_statement_into(generator, *m_body, result);
+    generator.set_jump_target(generator.emit_jump(), test_index);
+    auto end_index = generator.next_instruction_index();
+    generator.set_jump_target(jump_to_end, end_index);
+    generator.end_loop(end_index, test_index);
+    return result;
+}
+
+Optional<Register> DoWhileStatement::generate_bytecode(Bytecode::Generator& generator) const
+{
+    auto result = generator.emit_load_undefined();
+    generator.begin_loop(label());
+    auto body_index = generator.next_instruction_index();
+    generate_statement_into(generator, *m_body, result);
+    auto test_index = generator.next_instruction_index();
+    auto test = generator.generate_value(*m_test);
+    generator.set_jump_target(generator.emit_conditional_jump(Opcode::JumpIfTrue, test), body_index);
+    generator.end_loop(generator.next_instruction_index(), test_index);
+    return result;
+}
+
+Optional<Register> ForStatement::generate_bytecode(Bytecode::Generator& generator) const
+{
+    // Like execute(), give let and const declarations in the init clause a scope of their own.
+    RefPtr<BlockStatement> wrapper;
+    if (m_init && m_init->is_variable_declaration() && static_cast<const VariableDeclaration*>(m_init.ptr())->declaration_kind() != DeclarationKind::Var) {
+        wrapper = create_ast_node<BlockStatement>();
+        NonnullRefPtrVector<VariableDeclaration> declarations;
+        declarations.append(*static_cast<const VariableDeclaration*>(m_init.ptr()));
+        wrapper->add_variables(declarations);
+        generator.retain(*wrapper);
+        generator.begin_scope(*wrapper);
+    }
+
+    auto result = generator.emit_load_undefined();
+    if (m_init)
+        m_init->generate_bytecode(generator);
+
+    generator.begin_loop(label());
+    auto test_index = generator.next_instruction_index();
+    Optional<u32> jump_to_end;
+    if (m_test)
+        jump_to_end = generator.emit_conditional_jump(Opcode::JumpIfFalse, generator.generate_value(*m_test));
+    generate_statement_into(generator, *m_body, result);
+    auto update_index = generator.next_instruction_index();
+    if (m_update)
+        m_update->generate_bytecode(generator);
+    generator.set_jump_target(generator.emit_jump(), test_index);
+    auto end_index = generator.next_instruction_index();
+    if (jump_to_end.has_value())
+        generator.set_jump_target(jump_to_end.value(), end_index);
+    generator.end_loop(end_index, update_index);
+
+    if (wrapper)
+        generator.end_scope();
+    return result;
+}
+
+Optional<Register> BreakStatement::generate_bytecode(Bytecode::Generator& generator) const
+{
+    generator.emit_break(m_target_label);
+    return {};
+}
+
+Optional<Register> ContinueStatement::generate_bytecode(Bytecode::Generator& generator) const
+{
+    generator.emit_continue(m_target_label);
+    return {};
+}
+
+Optional<Register> VariableDeclaration::generate_bytecode(Bytecode::Generator& generator) const
+{
+    for (auto& declarator : m_declarations) {
+        if (auto* init = declarator.init()) {
+            auto value = generator.generate_value(*init);
+            generator.emit(Opcode::InitializeVariable, 0, value.index(), generator.add_identifier(declarator.id()));
+        }
+    }
+    return {};
+}
+
+static Opcode opcode_for(BinaryOp op)
+{
+    switch (op) {
+    case BinaryOp::Addition:
+        return Opcode::Add;
+    case BinaryOp::Subtraction:
+        return Opcode::Sub;
+    case BinaryOp::Multiplication:
+        return Opcode::Mul;
+    case BinaryOp::Division:
+        return Opcode::Div;
+    case BinaryOp::Modulo:
+        return Opcode::Mod;
+    case BinaryOp::Exponentiation:
+        return Opcode::Exp;
+    case BinaryOp::TypedEquals:
+        return Opcode::TypedEquals;
+    case BinaryOp::TypedInequals:
+        return Opcode::TypedInequals;
+    case BinaryOp::AbstractEquals:
+        return Opcode::AbstractEquals;
+    case BinaryOp::AbstractInequals:
+        return Opcode::AbstractInequals;
+    case BinaryOp::GreaterThan:
+        return Opcode::GreaterThan;
+    case BinaryOp::GreaterThanEquals:
+        return Opcode::GreaterThanEquals;
+    case BinaryOp::LessThan:
+        return Opcode::LessThan;
+    case BinaryOp::LessThanEquals:
+        return Opcode::LessThanEquals;
+    case BinaryOp::BitwiseAnd:
+        return Opcode::BitwiseAnd;
+    case BinaryOp::BitwiseOr:
+        return Opcode::BitwiseOr;
+    case BinaryOp::BitwiseXor:
+        return Opcode::BitwiseXor;
+    case BinaryOp::LeftShift:
+        return Opcode::LeftShift;
+    case BinaryOp::RightShift:
+        return Opcode::RightShift;
+    case BinaryOp::UnsignedRightShift:
+        return Opcode::UnsignedRightShift;
+    case BinaryOp::In:
+        return Opcode::In;
+    case BinaryOp::InstanceOf:
+        return Opcode::InstanceOf;
+    }
+    ASSERT_NOT_REACHED();
+}
+
+Optional<Register> BinaryExpression::generate_bytecode(Bytecode::Generator& generator) const
+{
+    auto lhs = generator.generate_value(*m_lhs);
+    auto rhs = generator.generate_value(*m_rhs);
+    auto result = generator.allocate_register();
+    generator.emit(opcode_for(m_op), result, lhs.index(), rhs.index());
+    return result;
+}
+
+Optional<Register> LogicalExpression::generate_bytecode(Bytecode::Generator& generator) const
+{
+    auto result = generator.allocate_register();
+    generator.emit(Opcode::Move, result, generator.generate_value(*m_lhs).index());
+    Opcode jump_opcode = Opcode::JumpIfFalse;
+    switch (m_op) {
+    case LogicalOp::And:
+        jump_opcode = Opcode::JumpIfFalse;
+        break;
+    case LogicalOp::Or:
+        jump_opcode = Opcode::JumpIfTrue;
+        break;
+    case LogicalOp::NullishCoalescing:
+        jump_opcode = Opcode::JumpIfNotNullish;
+        break;
+    }
+    auto jump_to_end = generator.emit_conditional_jump(jump_opcode, result);
+    generator.emit(Opcode::Move, result, generator.generate_value(*m_rhs).index());
+    generator.set_jump_target(jump_to_end, generator.next_instruction_index());
+    return result;
+}
+
+Optional<Register> UnaryExpression::generate_bytecode(Bytecode::Generator& generator) const
+{
+    Opcode opcode;
+    switch (m_op) {
+    case UnaryOp::BitwiseNot:
+        opcode = Opcode::BitwiseNot;
+        break;
+    case UnaryOp::Not:
+        opcode = Opcode::Not;
+        break;
+    case UnaryOp::Plus:
+        opcode = Opcode::UnaryPlus;
+        break;
+    case UnaryOp::Minus:
+        opcode = Opcode::UnaryMinus;
+        break;
+    case UnaryOp::Void:
+        generator.generate_value(*m_lhs);
+        return generator.emit_load_undefined();
+    default:
+        return generator.emit_fallback(*this);
+    }
+    auto value = generator.generate_value(*m_lhs);
+    auto result = generator.allocate_register();
+    generator.emit(opcode, result, value.index());
+    return result;
+}
+
+Optional<Register> SequenceExpression::generate_bytecode(Bytecode::Generator& generator) const
+{
+    Optional<Register> result;
+    for (auto& expression : m_expressions)
+        result = generator.generate_value(expression);
+    return result;
+}
+
+Optional<Register> BooleanLiteral::generate_bytecode(Bytecode::Generator& generator) const
+{
+    auto result = generator.allocate_register();
+    generator.emit(Opcode::LoadBoolean, result, m_value);
+    return result;
+}
+
+Optional<Register> NumericLiteral::generate_bytecode(Bytecode::Generator& generator) const
+{
+    auto result = generator.allocate_register();
+    generator.emit(Opcode::LoadNumber, result, generator.add_number(m_value));
+    return result;
+}
+
+Optional<Register> StringLiteral::generate_bytecode(Bytecode::Generator& generator) const
+{
+    auto result = generator.allocate_register();
+    generator.emit(Opcode::LoadString, result, generator.add_string(m_value));
+    return result;
+}
+
+Optional<Register> NullLiteral::generate_bytecode(Bytecode::Generator& generator) const
+{
+    auto result = generator.allocate_register();
+    generator.emit(Opcode::LoadNull, result);
+    return result;
+}
+
+Optional<Register> Identifier::generate_bytecode(Bytecode::Generator& generator) const
+{
+    auto result = generator.allocate_register();
+    generator.emit(Opcode::GetVariable, result, generator.add_identifier(*this));
+    return result;
+}
+
+static Optional<Opcode> opcode_for(AssignmentOp op)
+{
+    switch (op) {
+    case AssignmentOp::Assignment:
+        return {};
+    case AssignmentOp::AdditionAssignment:
+        return Opcode::Add;
+    case AssignmentOp::SubtractionAssignment:
+        return Opcode::Sub;
+    case AssignmentOp::MultiplicationAssignment:
+        return Opcode::Mul;
+    case AssignmentOp::DivisionAssignment:
+        return Opcode::Div;
+    case AssignmentOp::ModuloAssignment:
+        return Opcode::Mod;
+    case AssignmentOp::ExponentiationAssignment:
+        return Opcode::Exp;
+    case AssignmentOp::BitwiseAndAssignment:
+        return Opcode::BitwiseAnd;
+    case AssignmentOp::BitwiseOrAssignment:
+        return Opcode::BitwiseOr;
+    case AssignmentOp::BitwiseXorAssignment:
+        return Opcode::BitwiseXor;
+    case AssignmentOp::LeftShiftAssignment:
+        return Opcode::LeftShift;
+    case AssignmentOp::RightShiftAssignment:
+        return Opcode::RightShift;
+    case AssignmentOp::UnsignedRightShiftAssignment:
+        return Opcode::UnsignedRightShift;
+    }
+    ASSERT_NOT_REACHED();
+}
+
+Optional<Register> AssignmentExpression::generate_bytecode(Bytecode::Generator& generator) const
+{
+    // Only plain variables are compiled; member expressions need References.
+    if (!m_lhs->is_identifier())
+        return generator.emit_fallback(*this);
+    auto name = generator.add_identifier(static_cast<const Identifier&>(*m_lhs));
+
+    // Same evaluation order as execute(): the right-hand side goes first.
+    auto value = generator.generate_value(*m_rhs);
+    if (auto opcode = opcode_for(m_op); opcode.has_value()) {
+        auto lhs = generator.allocate_register();
+        generator.emit(Opcode::GetVariable, lhs, name);
+        auto result = generator.allocate_register();
+        generator.emit(opcode.value(), result, lhs.index(), value.index());
+        value = result;
+    }
+    generator.emit(Opcode::SetVariable, 0, value.index(), name);
+    return value;
+}
+
+Optional<Register> UpdateExpression::generate_bytecode(Bytecode::Generator& generator) const
+{
+    if (!m_argument->is_identifier())
+        return generator.emit_fallback(*this);
+    auto name = generator.add_identifier(static_cast<const Identifier&>(*m_argument));
+
+    auto old_value = generator.allocate_register();
+    generator.emit(Opcode::GetVariable, old_value, name);
+    generator.emit(Opcode::ToNumber, old_value, old_value.index());
+    auto new_value = generator.allocate_register();
+    generator.emit(m_op == UpdateOp::Increment ? Opcode::Increment : Opcode::Decrement, new_value, old_value.index());
+    generator.emit(Opcode::SetVariable, 0, new_value.index(), name);
+    return m_prefixed ? new_value : old_value;
+}
+
+Optional<Register> ConditionalExpression::generate_bytecode(Bytecode::Generator& generator) const
+{
+    auto result = generator.allocate_register();
+    auto jump_to_alternate = generator.emit_conditional_jump(Opcode::JumpIfFalse, generator.generate_value(*m_test));
+    generator.emit(Opcode::Move, result, generator.generate_value(*m_consequent).index());
+    auto jump_to_end = generator.emit_jump();
+    generator.set_jump_target(jump_to_alternate, generator.next_instruction_index());
+    generator.emit(Opcode::Move, result, generator.generate_value(*m_alternate).index());
+    generator.set_jump_target(jump_to_end, generator.next_instruction_index());
+    return result;
+}
+
+}
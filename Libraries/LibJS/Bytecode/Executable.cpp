@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <AK/LogStream.h>
+#include <LibJS/AST.h>
+#include <LibJS/Bytecode/Executable.h>
+#include <stdio.h>
+
+namespace JS::Bytecode {
+
+const char* opcode_name(Opcode opcode)
+{
+    switch (opcode) {
+#define __ENUMERATE_BYTECODE_OPCODE(name) \
+    case Opcode::name:                    \
+        return #name;
+        ENUMERATE_BYTECODE_OPCODES
+#undef __ENUMERATE_BYTECODE_OPCODE
+    }
+    ASSERT_NOT_REACHED();
+}
+
+void Executable::dump() const
+{
+    printf("Executable (%zu instructions, %zu registers)\n", instructions.size(), register_count);
+    for (size_t i = 0; i < instructions.size(); ++i) {
+        auto& instruction = instructions[i];
+        printf("  [%4zu] %-18s r%u, %u, %u", i, opcode_name(instruction.opcode), instruction.destination, instruction.operand1, instruction.operand2);
+        switch (instruction.opcode) {
+        case Opcode::LoadNumber:
+            printf("  ; %g", numbers[instruction.operand1]);
+            break;
+        case Opcode::LoadString:
+            printf("  ; \"%s\"", strings[instruction.operand1].characters());
+            break;
+        case Opcode::GetVariable:
+            printf("  ; %s", identifiers[instruction.operand1]->string().characters());
+            break;
+        case Opcode::SetVariable:
+        case Opcode::InitializeVariable:
+            printf("  ; %s", identifiers[instruction.operand2]->string().characters());
+            break;
+        case Opcode::Evaluate:
+            printf("  ; %s", sites[instruction.operand1].node->class_name());
+            break;
+        default:
+            break;
+        }
+        printf("\n");
+    }
+}
+
+}
@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#pragma once
+
+#include <AK/FlyString.h>
+#include <AK/NonnullRefPtrVector.h>
+#include <AK/String.h>
+#include <AK/Vector.h>
+#include <LibJS/Bytecode/Instruction.h>
+#include <LibJS/Forward.h>
+
+namespace JS::Bytecode {
+
+struct LoopTarget {
+    FlyString label;
+    u32 break_target { 0 };
+    u32 continue_target { 0 };
+};
+
+// How to leave an enclosing loop from somewhere inside it: which loop, and the outermost
+// scope that was entered inside the loop and has to be exited first (if any).
+struct LoopExit {
+    u32 loop;
+    const ScopeNode* scope_to_exit;
+};
+
+// A node the generator can't compile; it is executed by the AST interpreter instead. If it
+// breaks out of or continues one of the enclosing loops, execution resumes at that loop.
+struct EvaluationSite {
+    const ASTNode* node;
+    Vector<LoopExit> loop_exits;
+};
+
+struct Executable {
+    Vector<Instruction> instructions;
+    Vector<double> numbers;
+    Vector<String> strings;
+    Vector<FlyString> names;
+    // Variable accesses go through their Identifier node, which caches where the variable lives.
+    Vector<const Identifier*> identifiers;
+    Vector<const ScopeNode*> scopes;
+    Vector<EvaluationSite> sites;
+    Vector<LoopTarget> loops;
+    NonnullRefPtrVector<ASTNode> retained_nodes;
+    size_t register_count { 1 };
+
+    void dump() const;
+};
+
+}
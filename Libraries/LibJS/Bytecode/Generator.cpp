@@ -0,0 +1,225 @@
+/*
+ * Copyright (c) 2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <LibJS/AST.h>
+#include <LibJS/Bytecode/Generator.h>
+#include <LibJS/Interpreter.h>
+
+namespace JS::Bytecode {
+
+Generator::Generator()
+    : m_executable(make<Executable>())
+{
+}
+
+NonnullOwnPtr<Executable> Generator::generate(const ScopeNode& scope_node)
+{
+    Generator generator;
+    for (auto& child : scope_node.children()) {
+        // Like Interpreter::run(), remember the value of every top-level statement.
+        auto value = child.generate_bytecode(generator);
+        if (value.has_value())
+            generator.emit(Opcode::Move, Register::completion(), value.value().index());
+        else
+            generator.emit(Opcode::LoadUndefined, Register::completion());
+    }
+    generator.emit(Opcode::End);
+    return move(generator.m_executable);
+}
+
+Register Generator::allocate_register()
+{
+    return Register(m_executable->register_count++);
+}
+
+u32 Generator::emit(Opcode opcode, u32 destination, u32 operand1, u32 operand2)
+{
+    m_executable->instructions.append({ opcode, destination, operand1, operand2 });
+    return m_executable->instructions.size() - 1;
+}
+
+Register Generator::emit_load_undefined()
+{
+    auto destination = allocate_register();
+    emit(Opcode::LoadUndefined, destination);
+    return destination;
+}
+
+Register Generator::emit_fallback(const ASTNode& node)
+{
+    EvaluationSite site { &node, {} };
+    for (ssize_t i = m_loops.size() - 1; i >= 0; --i)
+        site.loop_exits.append({ m_loops[i].loop_index, scope_to_exit_for(m_loops[i]) });
+    m_executable->sites.append(move(site));
+
+    auto destination = allocate_register();
+    emit(Opcode::Evaluate, destination, m_executable->sites.size() - 1);
+    return destination;
+}
+
+u32 Generator::emit_jump()
+{
+    return emit(Opcode::Jump);
+}
+
+u32 Generator::emit_conditional_jump(Opcode opcode, Register condition)
+{
+    ASSERT(opcode == Opcode::JumpIfTrue || opcode == Opcode::JumpIfFalse || opcode == Opcode::JumpIfNotNullish);
+    return emit(opcode, 0, condition.index());
+}
+
+void Generator::set_jump_target(u32 jump, u32 target)
+{
+    auto& instruction = m_executable->instructions[jump];
+    if (instruction.opcode == Opcode::Jump)
+        instruction.operand1 = target;
+    else
+        instruction.operand2 = target;
+}
+
+u32 Generator::add_number(double number)
+{
+    m_executable->numbers.append(number);
+    return m_executable->numbers.size() - 1;
+}
+
+u32 Generator::add_string(const String& string)
+{
+    m_executable->strings.append(string);
+    return m_executable->strings.size() - 1;
+}
+
+u32 Generator::add_name(const FlyString& name)
+{
+    for (size_t i = 0; i < m_executable->names.size(); ++i) {
+        if (m_executable->names[i] == name)
+            return i;
+    }
+    m_executable->names.append(name);
+    return m_executable->names.size() - 1;
+}
+
+u32 Generator::add_identifier(const Identifier& identifier)
+{
+    for (size_t i = 0; i < m_executable->identifiers.size(); ++i) {
+        if (m_executable->identifiers[i] == &identifier)
+            return i;
+    }
+    m_executable->identifiers.append(&identifier);
+    return m_executable->identifiers.size() - 1;
+}
+
+void Generator::retain(const ASTNode& node)
+{
+    m_executable->retained_nodes.append(const_cast<ASTNode&>(node));
+}
+
+Register Generator::generate_value(const ASTNode& node)
+{
+    auto value = node.generate_bytecode(*this);
+    if (value.has_value())
+        return value.value();
+    return emit_load_undefined();
+}
+
+void Generator::begin_scope(const ScopeNode& scope_node)
+{
+    m_executable->scopes.append(&scope_node);
+    m_scopes.append(m_executable->scopes.size() - 1);
+    emit(Opcode::EnterScope, 0, m_scopes.last());
+}
+
+void Generator::end_scope()
+{
+    emit(Opcode::ExitScope, 0, m_scopes.take_last());
+}
+
+void Generator::begin_loop(const FlyString& label)
+{
+    m_executable->loops.append({ label, 0, 0 });
+    m_loops.append({ (u32)m_executable->loops.size() - 1, m_scopes.size(), label, {}, {} });
+}
+
+void Generator::end_loop(u32 break_target, u32 continue_target)
+{
+    auto loop = m_loops.take_last();
+    m_executable->loops[loop.loop_index].break_target = break_target;
+    m_executable->loops[loop.loop_index].continue_target = continue_target;
+    for (auto jump : loop.break_jumps)
+        set_jump_target(jump, break_target);
+    for (auto jump : loop.continue_jumps)
+        set_jump_target(jump, continue_target);
+}
+
+Generator::LoopContext* Generator::find_loop(const FlyString& label)
+{
+    // Same matching as Interpreter::should_unwind_until(): an unlabeled break or continue
+    // applies to the innermost loop.
+    for (ssize_t i = m_loops.size() - 1; i >= 0; --i) {
+        if (label.is_null() || m_loops[i].label == label)
+            return &m_loops[i];
+    }
+    return nullptr;
+}
+
+const ScopeNode* Generator::scope_to_exit_for(const LoopContext& loop) const
+{
+    if (m_scopes.size() <= loop.scope_depth)
+        return nullptr;
+    return m_executable->scopes[m_scopes[loop.scope_depth]];
+}
+
+void Generator::emit_exit_scopes_for(const LoopContext& loop)
+{
+    // Exiting the outermost scope entered inside the loop also exits the ones nested in it.
+    if (m_scopes.size() > loop.scope_depth)
+        emit(Opcode::ExitScope, 0, m_scopes[loop.scope_depth]);
+}
+
+void Generator::emit_break(const FlyString& label)
+{
+    auto* loop = find_loop(label);
+    if (!loop) {
+        emit(Opcode::Unwind, 0, (u32)ScopeType::Breakable, add_name(label));
+        return;
+    }
+    emit_exit_scopes_for(*loop);
+    loop->break_jumps.append(emit_jump());
+}
+
+void Generator::emit_continue(const FlyString& label)
+{
+    auto* loop = find_loop(label);
+    if (!loop) {
+        emit(Opcode::Unwind, 0, (u32)ScopeType::Continuable, add_name(label));
+        return;
+    }
+    emit_exit_scopes_for(*loop);
+    loop->continue_jumps.append(emit_jump());
+}
+
+}
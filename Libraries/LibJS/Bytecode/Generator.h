@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#pragma once
+
+#include <AK/NonnullOwnPtr.h>
+#include <AK/Optional.h>
+#include <LibJS/Bytecode/Executable.h>
+#include <LibJS/Bytecode/Register.h>
+#include <LibJS/Forward.h>
+
+namespace JS::Bytecode {
+
+class Generator {
+public:
+    // Compiles the children of a scope node. Entering and exiting the scope itself is left
+    // to the caller, see Interpreter::run().
+    static NonnullOwnPtr<Executable> generate(const ScopeNode&);
+
+    Register allocate_register();
+
+    u32 emit(Opcode, u32 destination = 0, u32 operand1 = 0, u32 operand2 = 0);
+    u32 emit(Opcode opcode, Register destination, u32 operand1 = 0, u32 operand2 = 0) { return emit(opcode, destination.index(), operand1, operand2); }
+    Register emit_load_undefined();
+    Register emit_fallback(const ASTNode&);
+
+    // Jumps are emitted with a placeholder target that is filled in once it is known.
+    u32 emit_jump();
+    u32 emit_conditional_jump(Opcode, Register condition);
+    void set_jump_target(u32 jump, u32 target);
+    u32 next_instruction_index() const { return m_executable->instructions.size(); }
+
+    u32 add_number(double);
+    u32 add_string(const String&);
+    u32 add_name(const FlyString&);
+    u32 add_identifier(const Identifier&);
+    void retain(const ASTNode&);
+
+    // Generates a node and returns the register holding its value, or a register holding
+    // undefined if the node doesn't produce a value.
+    Register generate_value(const ASTNode&);
+
+    void begin_scope(const ScopeNode&);
+    void end_scope();
+
+    void begin_loop(const FlyString& label);
+    void end_loop(u32 break_target, u32 continue_target);
+    void emit_break(const FlyString& label);
+    void emit_continue(const FlyString& label);
+
+private:
+    Generator();
+
+    struct LoopContext {
+        u32 loop_index;
+        size_t scope_depth;
+        FlyString label;
+        Vector<u32> break_jumps;
+        Vector<u32> continue_jumps;
+    };
+
+    LoopContext* find_loop(const FlyString& label);
+    void emit_exit_scopes_for(const LoopContext&);
+    const ScopeNode* scope_to_exit_for(const LoopContext&) const;
+
+    NonnullOwnPtr<Executable> m_executable;
+    Vector<LoopContext> m_loops;
+    Vector<u32> m_scopes;
+};
+
+}
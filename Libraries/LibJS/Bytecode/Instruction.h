@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#pragma once
+
+#include <AK/Types.h>
+
+// The operands of every instruction are register indices unless noted otherwise.
+#define ENUMERATE_BYTECODE_OPCODES                                           \
+    __ENUMERATE_BYTECODE_OPCODE(LoadNumber)         /* dst, number */        \
+    __ENUMERATE_BYTECODE_OPCODE(LoadString)         /* dst, string */        \
+    __ENUMERATE_BYTECODE_OPCODE(LoadBoolean)        /* dst, value */         \
+    __ENUMERATE_BYTECODE_OPCODE(LoadNull)           /* dst */                \
+    __ENUMERATE_BYTECODE_OPCODE(LoadUndefined)      /* dst */                \
+    __ENUMERATE_BYTECODE_OPCODE(Move)               /* dst, src */           \
+    __ENUMERATE_BYTECODE_OPCODE(GetVariable)        /* dst, identifier */    \
+    __ENUMERATE_BYTECODE_OPCODE(SetVariable)        /* -, src, identifier */ \
+    __ENUMERATE_BYTECODE_OPCODE(InitializeVariable) /* -, src, identifier */ \
+    __ENUMERATE_BYTECODE_OPCODE(Add)                /* dst, lhs, rhs */      \
+    __ENUMERATE_BYTECODE_OPCODE(Sub)                                         \
+    __ENUMERATE_BYTECODE_OPCODE(Mul)                                         \
+    __ENUMERATE_BYTECODE_OPCODE(Div)                                         \
+    __ENUMERATE_BYTECODE_OPCODE(Mod)                                         \
+    __ENUMERATE_BYTECODE_OPCODE(Exp)                                         \
+    __ENUMERATE_BYTECODE_OPCODE(TypedEquals)                                 \
+    __ENUMERATE_BYTECODE_OPCODE(TypedInequals)                               \
+    __ENUMERATE_BYTECODE_OPCODE(AbstractEquals)                              \
+    __ENUMERATE_BYTECODE_OPCODE(AbstractInequals)                            \
+    __ENUMERATE_BYTECODE_OPCODE(GreaterThan)                                 \
+    __ENUMERATE_BYTECODE_OPCODE(GreaterThanEquals)                           \
+    __ENUMERATE_BYTECODE_OPCODE(LessThan)                                    \
+    __ENUMERATE_BYTECODE_OPCODE(LessThanEquals)                              \
+    __ENUMERATE_BYTECODE_OPCODE(BitwiseAnd)                                  \
+    __ENUMERATE_BYTECODE_OPCODE(BitwiseOr)                                   \
+    __ENUMERATE_BYTECODE_OPCODE(BitwiseXor)                                  \
+    __ENUMERATE_BYTECODE_OPCODE(LeftShift)                                   \
+    __ENUMERATE_BYTECODE_OPCODE(RightShift)                                  \
+    __ENUMERATE_BYTECODE_OPCODE(UnsignedRightShift)                          \
+    __ENUMERATE_BYTECODE_OPCODE(In)                                          \
+    __ENUMERATE_BYTECODE_OPCODE(InstanceOf)                                  \
+    __ENUMERATE_BYTECODE_OPCODE(BitwiseNot)         /* dst, src */           \
+    __ENUMERATE_BYTECODE_OPCODE(Not)                                         \
+    __ENUMERATE_BYTECODE_OPCODE(UnaryPlus)                                   \
+    __ENUMERATE_BYTECODE_OPCODE(UnaryMinus)                                  \
+    __ENUMERATE_BYTECODE_OPCODE(ToNumber)                                    \
+    __ENUMERATE_BYTECODE_OPCODE(Increment)          /* src is a number */    \
+    __ENUMERATE_BYTECODE_OPCODE(Decrement)                                   \
+    __ENUMERATE_BYTECODE_OPCODE(Jump)               /* -, target */          \
+    __ENUMERATE_BYTECODE_OPCODE(JumpIfTrue)         /* -, src, target */     \
+    __ENUMERATE_BYTECODE_OPCODE(JumpIfFalse)                                 \
+    __ENUMERATE_BYTECODE_OPCODE(JumpIfNotNullish)                            \
+    __ENUMERATE_BYTECODE_OPCODE(Evaluate)           /* dst, site */          \
+    __ENUMERATE_BYTECODE_OPCODE(EnterScope)         /* -, scope */           \
+    __ENUMERATE_BYTECODE_OPCODE(ExitScope)          /* -, scope */           \
+    __ENUMERATE_BYTECODE_OPCODE(Return)             /* -, src */             \
+    __ENUMERATE_BYTECODE_OPCODE(Unwind)             /* -, type, label */     \
+    __ENUMERATE_BYTECODE_OPCODE(End)
+
+namespace JS::Bytecode {
+
+enum class Opcode : u8 {
+#define __ENUMERATE_BYTECODE_OPCODE(name) name,
+    ENUMERATE_BYTECODE_OPCODES
+#undef __ENUMERATE_BYTECODE_OPCODE
+};
+
+const char* opcode_name(Opcode);
+
+struct Instruction {
+    Opcode opcode;
+    u32 destination;
+    u32 operand1;
+    u32 operand2;
+};
+
+}
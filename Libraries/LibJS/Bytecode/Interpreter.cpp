@@ -0,0 +1,257 @@
+/*
+ * Copyright (c) 2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <LibJS/AST.h>
+#include <LibJS/Bytecode/Interpreter.h>
+#include <LibJS/Interpreter.h>
+#include <LibJS/Runtime/Error.h>
+#include <LibJS/Runtime/MarkedValueList.h>
+#include <LibJS/Runtime/PrimitiveString.h>
+
+namespace JS::Bytecode {
+
+Value run(Interpreter& interpreter, const Executable& executable, const ScopeNode& scope_node)
+{
+    // The registers are GC roots for as long as the executable runs.
+    MarkedValueList register_list(interpreter.heap());
+    auto& registers = register_list.values();
+    registers.resize(executable.register_count);
+    Value* r = registers.data();
+
+    static const void* const dispatch_table[] = {
+#define __ENUMERATE_BYTECODE_OPCODE(name) &&handle_##name,
+        ENUMERATE_BYTECODE_OPCODES
+#undef __ENUMERATE_BYTECODE_OPCODE
+    };
+
+    const Instruction* instructions = executable.instructions.data();
+    const Instruction* instruction = instructions;
+
+#define DISPATCH() goto* dispatch_table[(size_t)instruction->opcode]
+#define NEXT()         \
+    do {               \
+        ++instruction; \
+        DISPATCH();    \
+    } while (0)
+#define JUMP(target)                             \
+    do {                                         \
+        instruction = instructions + (target);   \
+        DISPATCH();                              \
+    } while (0)
+#define CHECK_EXCEPTION()           \
+    do {                            \
+        if (interpreter.exception()) \
+            goto done;              \
+    } while (0)
+#define DST r[instruction->destination]
+#define OPERAND1 r[instruction->operand1]
+#define OPERAND2 r[instruction->operand2]
+
+#define BINARY_OPERATION(name, function)          \
+    handle_##name:                                \
+    DST = function(interpreter, OPERAND1, OPERAND2); \
+    CHECK_EXCEPTION();                            \
+    NEXT();
+#define BOOLEAN_BINARY_OPERATION(name, expression) \
+    handle_##name:                                 \
+    DST = Value(expression);                       \
+    CHECK_EXCEPTION();                             \
+    NEXT();
+#define UNARY_OPERATION(name, function)  \
+    handle_##name:                       \
+    DST = function(interpreter, OPERAND1); \
+    CHECK_EXCEPTION();                   \
+    NEXT();
+
+    DISPATCH();
+
+handle_LoadNumber:
+    DST = Value(executable.numbers[instruction->operand1]);
+    NEXT();
+handle_LoadString:
+    DST = js_string(interpreter, executable.strings[instruction->operand1]);
+    NEXT();
+handle_LoadBoolean:
+    DST = Value((bool)instruction->operand1);
+    NEXT();
+handle_LoadNull:
+    DST = js_null();
+    NEXT();
+handle_LoadUndefined:
+    DST = js_undefined();
+    NEXT();
+handle_Move:
+    DST = OPERAND1;
+    NEXT();
+
+handle_GetVariable : {
+    auto& identifier = *executable.identifiers[instruction->operand1];
+    auto value = interpreter.get_variable(identifier.string(), &identifier.cached_coordinate());
+    CHECK_EXCEPTION();
+    if (value.is_empty()) {
+        interpreter.throw_exception<ReferenceError>(String::format("'%s' not known", identifier.string().characters()));
+        goto done;
+    }
+    DST = value;
+    NEXT();
+}
+handle_SetVariable : {
+    auto& identifier = *executable.identifiers[instruction->operand2];
+    update_function_name(OPERAND1, identifier.string());
+    interpreter.set_variable(identifier.string(), OPERAND1, false, &identifier.cached_coordinate());
+    CHECK_EXCEPTION();
+    NEXT();
+}
+handle_InitializeVariable : {
+    auto& identifier = *executable.identifiers[instruction->operand2];
+    update_function_name(OPERAND1, identifier.string());
+    interpreter.set_variable(identifier.string(), OPERAND1, true, &identifier.cached_coordinate());
+    CHECK_EXCEPTION();
+    NEXT();
+}
+
+    BINARY_OPERATION(Add, add)
+    BINARY_OPERATION(Sub, sub)
+    BINARY_OPERATION(Mul, mul)
+    BINARY_OPERATION(Div, div)
+    BINARY_OPERATION(Mod, mod)
+    BINARY_OPERATION(Exp, exp)
+    BOOLEAN_BINARY_OPERATION(TypedEquals, strict_eq(interpreter, OPERAND1, OPERAND2))
+    BOOLEAN_BINARY_OPERATION(TypedInequals, !strict_eq(interpreter, OPERAND1, OPERAND2))
+    BOOLEAN_BINARY_OPERATION(AbstractEquals, abstract_eq(interpreter, OPERAND1, OPERAND2))
+    BOOLEAN_BINARY_OPERATION(AbstractInequals, !abstract_eq(interpreter, OPERAND1, OPERAND2))
+    BINARY_OPERATION(GreaterThan, greater_than)
+    BINARY_OPERATION(GreaterThanEquals, greater_than_equals)
+    BINARY_OPERATION(LessThan, less_than)
+    BINARY_OPERATION(LessThanEquals, less_than_equals)
+    BINARY_OPERATION(BitwiseAnd, bitwise_and)
+    BINARY_OPERATION(BitwiseOr, bitwise_or)
+    BINARY_OPERATION(BitwiseXor, bitwise_xor)
+    BINARY_OPERATION(LeftShift, left_shift)
+    BINARY_OPERATION(RightShift, right_shift)
+    BINARY_OPERATION(UnsignedRightShift, unsigned_right_shift)
+    BINARY_OPERATION(In, in)
+    BINARY_OPERATION(InstanceOf, instance_of)
+
+    UNARY_OPERATION(BitwiseNot, bitwise_not)
+    UNARY_OPERATION(UnaryPlus, unary_plus)
+    UNARY_OPERATION(UnaryMinus, unary_minus)
+handle_Not:
+    DST = Value(!OPERAND1.to_boolean());
+    NEXT();
+handle_ToNumber:
+    DST = OPERAND1.to_number(interpreter);
+    CHECK_EXCEPTION();
+    NEXT();
+handle_Increment : {
+    i32 result;
+    if (OPERAND1.is_int32() && !__builtin_add_overflow(OPERAND1.as_i32(), 1, &result))
+        DST = Value(result);
+    else
+        DST = Value(OPERAND1.as_double() + 1);
+    NEXT();
+}
+handle_Decrement : {
+    i32 result;
+    if (OPERAND1.is_int32() && !__builtin_sub_overflow(OPERAND1.as_i32(), 1, &result))
+        DST = Value(result);
+    else
+        DST = Value(OPERAND1.as_double() - 1);
+    NEXT();
+}
+
+handle_Jump:
+    JUMP(instruction->operand1);
+handle_JumpIfTrue:
+    if (OPERAND1.to_boolean())
+        JUMP(instruction->operand2);
+    NEXT();
+handle_JumpIfFalse:
+    if (!OPERAND1.to_boolean())
+        JUMP(instruction->operand2);
+    NEXT();
+handle_JumpIfNotNullish:
+    if (!OPERAND1.is_null() && !OPERAND1.is_undefined())
+        JUMP(instruction->operand2);
+    NEXT();
+
+handle_Evaluate : {
+    auto& site = executable.sites[instruction->operand1];
+    DST = site.node->execute(interpreter);
+    if (!interpreter.should_unwind())
+        NEXT();
+    if (interpreter.exception())
+        goto done;
+    for (auto& loop_exit : site.loop_exits) {
+        auto& loop = executable.loops[loop_exit.loop];
+        bool is_continue = interpreter.should_unwind_until(ScopeType::Continuable, loop.label);
+        if (!is_continue && !interpreter.should_unwind_until(ScopeType::Breakable, loop.label))
+            continue;
+        interpreter.stop_unwind();
+        if (loop_exit.scope_to_exit)
+            interpreter.exit_scope(*loop_exit.scope_to_exit);
+        JUMP(is_continue ? loop.continue_target : loop.break_target);
+    }
+    // Anything else, like a return, leaves this executable. The value of the node is the
+    // completion value, as it would be in Interpreter::run().
+    r[0] = DST;
+    goto done;
+}
+handle_EnterScope:
+    interpreter.enter_scope(*executable.scopes[instruction->operand1], {}, ScopeType::Block);
+    NEXT();
+handle_ExitScope:
+    interpreter.exit_scope(*executable.scopes[instruction->operand1]);
+    NEXT();
+handle_Return:
+    r[0] = OPERAND1;
+    interpreter.unwind(ScopeType::Function);
+    goto done;
+handle_Unwind:
+    interpreter.unwind((ScopeType)instruction->operand1, executable.names[instruction->operand2]);
+    goto done;
+handle_End:
+    goto done;
+
+#undef DISPATCH
+#undef NEXT
+#undef JUMP
+#undef CHECK_EXCEPTION
+#undef DST
+#undef OPERAND1
+#undef OPERAND2
+#undef BINARY_OPERATION
+#undef BOOLEAN_BINARY_OPERATION
+#undef UNARY_OPERATION
+
+done:
+    if (interpreter.should_unwind_until(ScopeType::Breakable, scope_node.label()))
+        interpreter.stop_unwind();
+    return r[0];
+}
+
+}
@@ -29,6 +29,7 @@
 #include <AK/StringBuilder.h>
 #include <LibJS/Console.h>
 #include <LibJS/Interpreter.h>
+#include <unistd.h>
 
 namespace JS {
 
@@ -139,6 +140,34 @@ Value Console::count_reset()
     return js_undefined();
 }
 
+Value Console::profile()
+{
+    auto title = m_interpreter.argument_count() ? m_interpreter.argument(0).to_string_without_side_effects() : "default";
+
+    auto& profiler = m_interpreter.profiler();
+    if (profiler.is_running()) {
+        dbg() << "warn: profile \"" << profiler.title() << "\" is already running";
+        return js_undefined();
+    }
+    profiler.start(title);
+    return js_undefined();
+}
+
+Value Console::profile_end()
+{
+    auto& profiler = m_interpreter.profiler();
+    if (!profiler.is_running()) {
+        dbg() << "warn: no profile is running";
+        return js_undefined();
+    }
+    profiler.stop();
+
+    auto path = String::format("/tmp/js-profile.%d.%u", getpid(), ++m_profile_count);
+    if (profiler.write_to_file(path))
+        dbg() << "log: profile \"" << profiler.title() << "\" (" << profiler.sample_count() << " samples) written to " << path;
+    return js_undefined();
+}
+
 unsigned Console::counter_increment(String label)
 {
     auto value = m_counters.get(label);
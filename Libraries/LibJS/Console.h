@@ -63,6 +63,9 @@ public:
     Value count();
     Value count_reset();
 
+    Value profile();
+    Value profile_end();
+
     unsigned counter_increment(String label);
     bool counter_reset(String label);
 
@@ -71,6 +74,7 @@ private:
     ConsoleClient* m_client { nullptr };
 
     HashMap<String, unsigned> m_counters;
+    unsigned m_profile_count { 0 };
 };
 
 class ConsoleClient {
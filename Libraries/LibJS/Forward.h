@@ -26,15 +26,17 @@
 
 #pragma once
 
-#define JS_ENUMERATE_NATIVE_OBJECTS                                              \
-    __JS_ENUMERATE(Array, array, ArrayPrototype, ArrayConstructor)               \
-    __JS_ENUMERATE(BooleanObject, boolean, BooleanPrototype, BooleanConstructor) \
-    __JS_ENUMERATE(Date, date, DatePrototype, DateConstructor)                   \
-    __JS_ENUMERATE(Error, error, ErrorPrototype, ErrorConstructor)               \
-    __JS_ENUMERATE(Function, function, FunctionPrototype, FunctionConstructor)   \
-    __JS_ENUMERATE(NumberObject, number, NumberPrototype, NumberConstructor)     \
-    __JS_ENUMERATE(Object, object, ObjectPrototype, ObjectConstructor)           \
-    __JS_ENUMERATE(StringObject, string, StringPrototype, StringConstructor)     \
+#define JS_ENUMERATE_NATIVE_OBJECTS                                                         \
+    __JS_ENUMERATE(Array, array, ArrayPrototype, ArrayConstructor)                          \
+    __JS_ENUMERATE(ArrayBuffer, array_buffer, ArrayBufferPrototype, ArrayBufferConstructor) \
+    __JS_ENUMERATE(BooleanObject, boolean, BooleanPrototype, BooleanConstructor)            \
+    __JS_ENUMERATE(Date, date, DatePrototype, DateConstructor)                              \
+    __JS_ENUMERATE(Error, error, ErrorPrototype, ErrorConstructor)                          \
+    __JS_ENUMERATE(Function, function, FunctionPrototype, FunctionConstructor)              \
+    __JS_ENUMERATE(NumberObject, number, NumberPrototype, NumberConstructor)                \
+    __JS_ENUMERATE(Object, object, ObjectPrototype, ObjectConstructor)                      \
+    __JS_ENUMERATE(RegExpObject, regexp, RegExpPrototype, RegExpConstructor)                \
+    __JS_ENUMERATE(StringObject, string, StringPrototype, StringConstructor)                \
     __JS_ENUMERATE(SymbolObject, symbol, SymbolPrototype, SymbolConstructor)
 
 #define JS_ENUMERATE_ERROR_SUBCLASSES                                                                   \
@@ -46,6 +48,17 @@
     __JS_ENUMERATE(TypeError, type_error, TypeErrorPrototype, TypeErrorConstructor)                     \
     __JS_ENUMERATE(URIError, uri_error, URIErrorPrototype, URIErrorConstructor)
 
+#define JS_ENUMERATE_TYPED_ARRAYS                                                                                               \
+    __JS_ENUMERATE(Int8Array, int8_array, Int8ArrayPrototype, Int8ArrayConstructor, i8)                                         \
+    __JS_ENUMERATE(Uint8Array, uint8_array, Uint8ArrayPrototype, Uint8ArrayConstructor, u8)                                     \
+    __JS_ENUMERATE(Uint8ClampedArray, uint8_clamped_array, Uint8ClampedArrayPrototype, Uint8ClampedArrayConstructor, ClampedU8) \
+    __JS_ENUMERATE(Int16Array, int16_array, Int16ArrayPrototype, Int16ArrayConstructor, i16)                                    \
+    __JS_ENUMERATE(Uint16Array, uint16_array, Uint16ArrayPrototype, Uint16ArrayConstructor, u16)                                \
+    __JS_ENUMERATE(Int32Array, int32_array, Int32ArrayPrototype, Int32ArrayConstructor, i32)                                    \
+    __JS_ENUMERATE(Uint32Array, uint32_array, Uint32ArrayPrototype, Uint32ArrayConstructor, u32)                                \
+    __JS_ENUMERATE(Float32Array, float32_array, Float32ArrayPrototype, Float32ArrayConstructor, float)                          \
+    __JS_ENUMERATE(Float64Array, float64_array, Float64ArrayPrototype, Float64ArrayConstructor, double)
+
 #define JS_ENUMERATE_BUILTIN_TYPES \
     JS_ENUMERATE_NATIVE_OBJECTS    \
     JS_ENUMERATE_ERROR_SUBCLASSES
@@ -64,17 +77,21 @@ class GlobalObject;
 class HandleImpl;
 class Heap;
 class HeapBlock;
+class Identifier;
 class Interpreter;
 class LexicalEnvironment;
 class MarkedValueList;
+class NativeFunction;
 class PrimitiveString;
+class PropertyLookupCache;
 class Reference;
 class ScopeNode;
 class Shape;
 class Statement;
 class Symbol;
 class Token;
-class Uint8ClampedArray;
+class TypedArrayBase;
+class TypedArrayPrototype;
 class Value;
 enum class DeclarationKind;
 
@@ -85,7 +102,15 @@ enum class DeclarationKind;
 JS_ENUMERATE_BUILTIN_TYPES
 #undef __JS_ENUMERATE
 
+#define __JS_ENUMERATE(ClassName, snake_name, PrototypeName, ConstructorName, ArrayType) \
+    class ClassName;                                                                     \
+    class PrototypeName;                                                                 \
+    class ConstructorName;
+JS_ENUMERATE_TYPED_ARRAYS
+#undef __JS_ENUMERATE
+
 struct Argument;
+struct CallFrame;
 
 template<class T>
 class Handle;
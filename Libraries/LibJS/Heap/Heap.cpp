@@ -26,14 +26,17 @@
 
 #include <AK/Badge.h>
 #include <AK/HashTable.h>
+#include <LibCore/MemoryPressureNotifier.h>
 #include <LibJS/Heap/Handle.h>
 #include <LibJS/Heap/Heap.h>
 #include <LibJS/Heap/HeapBlock.h>
 #include <LibJS/Interpreter.h>
 #include <LibJS/Runtime/MarkedValueList.h>
 #include <LibJS/Runtime/Object.h>
+#include <LibJS/Runtime/PrimitiveString.h>
 #include <setjmp.h>
 #include <stdio.h>
+#include <time.h>
 
 #ifdef __serenity__
 #    include <serenity.h>
@@ -50,6 +53,10 @@ namespace JS {
 Heap::Heap(Interpreter& interpreter)
     : m_interpreter(interpreter)
 {
+    m_memory_pressure_notifier = Core::MemoryPressureNotifier::construct();
+    m_memory_pressure_notifier->on_memory_pressure = [this] {
+        collect_garbage();
+    };
 }
 
 Heap::~Heap()
@@ -59,29 +66,47 @@ Heap::~Heap()
 
 Cell* Heap::allocate_cell(size_t size)
 {
+    size_t cell_size = round_up_to_power_of_two(size, 16);
+
     if (should_collect_on_every_allocation()) {
         collect_garbage();
-    } else if (m_allocations_since_last_gc > m_max_allocations_between_gc) {
-        m_allocations_since_last_gc = 0;
+    } else if (m_allocated_bytes_since_last_gc > m_gc_threshold_bytes) {
         collect_garbage();
-    } else {
-        ++m_allocations_since_last_gc;
     }
+    m_allocated_bytes_since_last_gc += cell_size;
+    ++m_statistics.allocated_cells;
+    m_statistics.allocated_bytes += cell_size;
 
-    for (auto& block : m_blocks) {
-        if (size > block->cell_size())
-            continue;
+    auto& size_class = size_class_for(cell_size);
+    while (!size_class.usable_blocks.is_empty()) {
+        auto* block = size_class.usable_blocks.last();
         if (auto* cell = block->allocate())
             return cell;
+        size_class.usable_blocks.take_last();
     }
 
-    size_t cell_size = round_up_to_power_of_two(size, 16);
     auto block = HeapBlock::create_with_cell_size(*this, cell_size);
     auto* cell = block->allocate();
+    size_class.usable_blocks.append(block.ptr());
+    m_block_set.set(block.ptr());
+    auto block_address = reinterpret_cast<FlatPtr>(block.ptr());
+    if (!m_min_block_address || block_address < m_min_block_address)
+        m_min_block_address = block_address;
+    m_max_block_address = max(m_max_block_address, block_address + HeapBlock::block_size);
     m_blocks.append(move(block));
     return cell;
 }
 
+Heap::SizeClass& Heap::size_class_for(size_t cell_size)
+{
+    for (auto& size_class : m_size_classes) {
+        if (size_class.cell_size == cell_size)
+            return size_class;
+    }
+    m_size_classes.append({ cell_size, {} });
+    return m_size_classes.last();
+}
+
 void Heap::collect_garbage(CollectionType collection_type)
 {
     if (collection_type == CollectionType::CollectGarbage) {
@@ -89,11 +114,52 @@ void Heap::collect_garbage(CollectionType collection_type)
             m_should_gc_when_deferral_ends = true;
             return;
         }
+    }
+
+    struct timespec start_time;
+    clock_gettime(CLOCK_MONOTONIC, &start_time);
+
+    if (collection_type == CollectionType::CollectGarbage) {
         HashTable<Cell*> roots;
         gather_roots(roots);
         mark_live_cells(roots);
     }
     sweep_dead_cells();
+
+    struct timespec end_time;
+    clock_gettime(CLOCK_MONOTONIC, &end_time);
+    double pause_ms = (end_time.tv_sec - start_time.tv_sec) * 1000.0 + (end_time.tv_nsec - start_time.tv_nsec) / 1000000.0;
+
+    ++m_statistics.collection_count;
+    m_statistics.last_pause_ms = pause_ms;
+    m_statistics.max_pause_ms = max(m_statistics.max_pause_ms, pause_ms);
+    m_statistics.total_pause_ms += pause_ms;
+
+    m_gc_threshold_bytes = max(min_bytes_between_gc, m_statistics.marked_bytes);
+    m_allocated_bytes_since_last_gc = 0;
+}
+
+HeapStatistics Heap::statistics() const
+{
+    auto statistics = m_statistics;
+    statistics.heap_bytes = m_blocks.size() * HeapBlock::block_size;
+    statistics.allocated_bytes_since_last_gc = m_allocated_bytes_since_last_gc;
+    statistics.gc_threshold_bytes = m_gc_threshold_bytes;
+    return statistics;
+}
+
+PrimitiveString* Heap::interned_short_string(const String& string)
+{
+    ASSERT(string.length() <= 1);
+    if (string.is_empty()) {
+        if (!m_empty_string)
+            m_empty_string = allocate<PrimitiveString>(string);
+        return m_empty_string;
+    }
+    auto& slot = m_single_character_strings[static_cast<u8>(string[0])];
+    if (!slot)
+        slot = allocate<PrimitiveString>(string);
+    return slot;
 }
 
 void Heap::gather_roots(HashTable<Cell*>& roots)
@@ -105,13 +171,20 @@ void Heap::gather_roots(HashTable<Cell*>& roots)
     for (auto* handle : m_handles)
         roots.set(handle->cell());
 
-    for (auto* list : m_marked_value_lists) {
-        for (auto& value : list->values()) {
+    for (auto& list : m_marked_value_lists) {
+        for (auto& value : list.values()) {
             if (value.is_cell())
                 roots.set(value.as_cell());
         }
     }
 
+    if (m_empty_string)
+        roots.set(m_empty_string);
+    for (auto* string : m_single_character_strings) {
+        if (string)
+            roots.set(string);
+    }
+
 #ifdef HEAP_DEBUG
     dbg() << "gather_roots:";
     for (auto* root : roots) {
@@ -128,15 +201,37 @@ void Heap::gather_conservative_roots(HashTable<Cell*>& roots)
     dbg() << "gather_conservative_roots:";
 #endif
 
+    // Each word is checked as soon as it is read; only the ones that point into one of our
+    // blocks end up in the root set.
+    auto add_possible_pointer = [&](FlatPtr possible_pointer) {
+        // A Value keeps its tag above the pointer in the same 64-bit word.
+        possible_pointer &= static_cast<FlatPtr>(Value::payload_mask);
+        if (possible_pointer < m_min_block_address || possible_pointer >= m_max_block_address)
+            return;
+#ifdef HEAP_DEBUG
+        dbg() << "  ? " << (const void*)possible_pointer;
+#endif
+        if (auto* cell = cell_from_possible_pointer(possible_pointer)) {
+            if (cell->is_live()) {
+#ifdef HEAP_DEBUG
+                dbg() << "  ?-> " << (const void*)cell;
+#endif
+                roots.set(cell);
+            } else {
+#ifdef HEAP_DEBUG
+                dbg() << "  #-> " << (const void*)cell;
+#endif
+            }
+        }
+    };
+
     jmp_buf buf;
     setjmp(buf);
 
-    HashTable<FlatPtr> possible_pointers;
-
     const FlatPtr* raw_jmp_buf = reinterpret_cast<const FlatPtr*>(buf);
 
-    for (size_t i = 0; i < ((size_t)sizeof(buf)) / sizeof(FlatPtr); i += sizeof(FlatPtr))
-        possible_pointers.set(raw_jmp_buf[i]);
+    for (size_t i = 0; i < ((size_t)sizeof(buf)) / sizeof(FlatPtr); ++i)
+        add_possible_pointer(raw_jmp_buf[i]);
 
     FlatPtr stack_base;
     size_t stack_size;
@@ -170,40 +265,20 @@ void Heap::gather_conservative_roots(HashTable<Cell*>& roots)
     FlatPtr stack_reference = reinterpret_cast<FlatPtr>(&dummy);
     FlatPtr stack_top = stack_base + stack_size;
 
-    for (FlatPtr stack_address = stack_reference; stack_address < stack_top; stack_address += sizeof(FlatPtr)) {
-        auto data = *reinterpret_cast<FlatPtr*>(stack_address);
-        possible_pointers.set(data);
-    }
-
-    for (auto possible_pointer : possible_pointers) {
-        if (!possible_pointer)
-            continue;
-#ifdef HEAP_DEBUG
-        dbg() << "  ? " << (const void*)possible_pointer;
-#endif
-        if (auto* cell = cell_from_possible_pointer(possible_pointer)) {
-            if (cell->is_live()) {
-#ifdef HEAP_DEBUG
-                dbg() << "  ?-> " << (const void*)cell;
-#endif
-                roots.set(cell);
-            } else {
-#ifdef HEAP_DEBUG
-                dbg() << "  #-> " << (const void*)cell;
-#endif
-            }
-        }
-    }
+    for (FlatPtr stack_address = stack_reference; stack_address < stack_top; stack_address += sizeof(FlatPtr))
+        add_possible_pointer(*reinterpret_cast<FlatPtr*>(stack_address));
 }
 
 Cell* Heap::cell_from_possible_pointer(FlatPtr pointer)
 {
     auto* possible_heap_block = HeapBlock::from_cell(reinterpret_cast<const Cell*>(pointer));
-    if (m_blocks.find([possible_heap_block](auto& block) { return block.ptr() == possible_heap_block; }) == m_blocks.end())
+    if (!m_block_set.contains(possible_heap_block))
         return nullptr;
     return possible_heap_block->cell_from_possible_pointer(pointer);
 }
 
+// Marks cells through an explicit work list rather than by recursion, so long chains of
+// objects can't exhaust the stack.
 class MarkingVisitor final : public Cell::Visitor {
 public:
     MarkingVisitor() { }
@@ -216,8 +291,17 @@ public:
         dbg() << "  ! " << cell;
 #endif
         cell->set_marked(true);
-        cell->visit_children(*this);
+        m_work_list.append(cell);
     }
+
+    void mark_all()
+    {
+        while (!m_work_list.is_empty())
+            m_work_list.take_last()->visit_children(*this);
+    }
+
+private:
+    Vector<Cell*, 256> m_work_list;
 };
 
 void Heap::mark_live_cells(const HashTable<Cell*>& roots)
@@ -226,8 +310,10 @@ void Heap::mark_live_cells(const HashTable<Cell*>& roots)
     dbg() << "mark_live_cells:";
 #endif
     MarkingVisitor visitor;
-    for (auto* root : roots)
+    for (auto* root : roots) {
         visitor.visit(root);
+        visitor.mark_all();
+    }
 }
 
 void Heap::sweep_dead_cells()
@@ -235,9 +321,14 @@ void Heap::sweep_dead_cells()
 #ifdef HEAP_DEBUG
     dbg() << "sweep_dead_cells:";
 #endif
-    Vector<HeapBlock*, 32> empty_blocks;
+    size_t marked_bytes = 0;
+    size_t swept_bytes = 0;
+    size_t blocks_freed = 0;
 
-    for (auto& block : m_blocks) {
+    for (auto& size_class : m_size_classes)
+        size_class.usable_blocks.clear_with_capacity();
+
+    m_blocks.remove_all_matching([&](auto& block) {
         bool block_has_live_cells = false;
         block->for_each_cell([&](Cell* cell) {
             if (cell->is_live()) {
@@ -246,22 +337,30 @@ void Heap::sweep_dead_cells()
                     dbg() << "  ~ " << cell;
 #endif
                     block->deallocate(cell);
+                    swept_bytes += block->cell_size();
                 } else {
                     cell->set_marked(false);
                     block_has_live_cells = true;
+                    marked_bytes += block->cell_size();
                 }
             }
         });
-        if (!block_has_live_cells)
-            empty_blocks.append(block);
-    }
-
-    for (auto* block : empty_blocks) {
+        if (!block_has_live_cells) {
 #ifdef HEAP_DEBUG
-        dbg() << " - Reclaim HeapBlock @ " << block << ": cell_size=" << block->cell_size();
+            dbg() << " - Reclaim HeapBlock @ " << block << ": cell_size=" << block->cell_size();
 #endif
-        m_blocks.remove_first_matching([block](auto& entry) { return entry == block; });
-    }
+            m_block_set.remove(block.ptr());
+            ++blocks_freed;
+            return true;
+        }
+        if (block->has_free_cells())
+            size_class_for(block->cell_size()).usable_blocks.append(block.ptr());
+        return false;
+    });
+
+    m_statistics.marked_bytes = marked_bytes;
+    m_statistics.swept_bytes = swept_bytes;
+    m_statistics.blocks_freed = blocks_freed;
 
 #ifdef HEAP_DEBUG
     for (auto& block : m_blocks) {
@@ -284,14 +383,14 @@ void Heap::did_destroy_handle(Badge<HandleImpl>, HandleImpl& impl)
 
 void Heap::did_create_marked_value_list(Badge<MarkedValueList>, MarkedValueList& list)
 {
-    ASSERT(!m_marked_value_lists.contains(&list));
-    m_marked_value_lists.set(&list);
+    ASSERT(!list.m_list_node.is_in_list());
+    m_marked_value_lists.append(list);
 }
 
 void Heap::did_destroy_marked_value_list(Badge<MarkedValueList>, MarkedValueList& list)
 {
-    ASSERT(m_marked_value_lists.contains(&list));
-    m_marked_value_lists.remove(&list);
+    ASSERT(list.m_list_node.is_in_list());
+    m_marked_value_lists.remove(list);
 }
 
 void Heap::defer_gc(Badge<DeferGC>)
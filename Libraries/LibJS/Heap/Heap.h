@@ -27,16 +27,40 @@
 #pragma once
 
 #include <AK/HashTable.h>
+#include <AK/IntrusiveList.h>
 #include <AK/Noncopyable.h>
 #include <AK/NonnullOwnPtr.h>
+#include <AK/RefPtr.h>
 #include <AK/Types.h>
 #include <AK/Vector.h>
+#include <LibCore/Forward.h>
 #include <LibJS/Forward.h>
 #include <LibJS/Heap/Handle.h>
 #include <LibJS/Runtime/Cell.h>
+#include <LibJS/Runtime/MarkedValueList.h>
 
 namespace JS {
 
+struct HeapStatistics {
+    size_t collection_count { 0 };
+    double last_pause_ms { 0 };
+    double max_pause_ms { 0 };
+    double total_pause_ms { 0 };
+
+    // Of the most recent collection.
+    size_t marked_bytes { 0 };
+    size_t swept_bytes { 0 };
+    size_t blocks_freed { 0 };
+
+    // Since the heap was created.
+    size_t allocated_cells { 0 };
+    size_t allocated_bytes { 0 };
+
+    size_t heap_bytes { 0 };
+    size_t allocated_bytes_since_last_gc { 0 };
+    size_t gc_threshold_bytes { 0 };
+};
+
 class Heap {
     AK_MAKE_NONCOPYABLE(Heap);
     AK_MAKE_NONMOVABLE(Heap);
@@ -62,6 +86,9 @@ public:
 
     Interpreter& interpreter() { return m_interpreter; }
 
+    HeapStatistics statistics() const;
+    size_t collection_count() const { return m_statistics.collection_count; }
+
     bool should_collect_on_every_allocation() const { return m_should_collect_on_every_allocation; }
     void set_should_collect_on_every_allocation(bool b) { m_should_collect_on_every_allocation = b; }
 
@@ -74,6 +101,9 @@ public:
     void defer_gc(Badge<DeferGC>);
     void undefer_gc(Badge<DeferGC>);
 
+    // The empty string and single characters are shared instead of allocated anew each time.
+    PrimitiveString* interned_short_string(const String&);
+
 private:
     Cell* allocate_cell(size_t);
 
@@ -84,16 +114,40 @@ private:
 
     Cell* cell_from_possible_pointer(FlatPtr);
 
-    size_t m_max_allocations_between_gc { 10000 };
-    size_t m_allocations_since_last_gc { false };
+    // All blocks of one cell size, and the ones among them that still have free cells.
+    struct SizeClass {
+        size_t cell_size { 0 };
+        Vector<HeapBlock*> usable_blocks;
+    };
+    SizeClass& size_class_for(size_t cell_size);
+
+    // A collection happens once as many bytes have been allocated as survived the previous
+    // one, so its cost is amortized over the allocations that made it necessary. Small
+    // heaps still get some headroom.
+    static constexpr size_t min_bytes_between_gc = 1 * MB;
+    size_t m_gc_threshold_bytes { min_bytes_between_gc };
+    size_t m_allocated_bytes_since_last_gc { 0 };
+
+    HeapStatistics m_statistics;
 
     bool m_should_collect_on_every_allocation { false };
 
     Interpreter& m_interpreter;
     Vector<NonnullOwnPtr<HeapBlock>> m_blocks;
+    HashTable<HeapBlock*> m_block_set;
+    // Bounds of every block we have ever had, so most non-pointer words on the stack can
+    // be rejected without a hash lookup.
+    FlatPtr m_min_block_address { 0 };
+    FlatPtr m_max_block_address { 0 };
+    Vector<SizeClass> m_size_classes;
     HashTable<HandleImpl*> m_handles;
 
-    HashTable<MarkedValueList*> m_marked_value_lists;
+    IntrusiveList<MarkedValueList, &MarkedValueList::m_list_node> m_marked_value_lists;
+
+    PrimitiveString* m_empty_string { nullptr };
+    PrimitiveString* m_single_character_strings[256] {};
+
+    RefPtr<Core::MemoryPressureNotifier> m_memory_pressure_notifier;
 
     size_t m_gc_deferrals { 0 };
     bool m_should_gc_when_deferral_ends { false };
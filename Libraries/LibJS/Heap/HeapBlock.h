@@ -47,6 +47,8 @@ public:
     Cell* allocate();
     void deallocate(Cell*);
 
+    bool has_free_cells() const { return m_freelist; }
+
     template<typename Callback>
     void for_each_cell(Callback callback)
     {
@@ -66,6 +68,8 @@ public:
         if (pointer < reinterpret_cast<FlatPtr>(m_storage))
             return nullptr;
         size_t cell_index = (pointer - reinterpret_cast<FlatPtr>(m_storage)) / m_cell_size;
+        if (cell_index >= cell_count())
+            return nullptr;
         return cell(cell_index);
     }
 
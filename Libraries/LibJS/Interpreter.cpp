@@ -27,6 +27,7 @@
 #include <AK/Badge.h>
 #include <AK/StringBuilder.h>
 #include <LibJS/AST.h>
+#include <LibJS/Bytecode/Interpreter.h>
 #include <LibJS/Interpreter.h>
 #include <LibJS/Runtime/Error.h>
 #include <LibJS/Runtime/GlobalObject.h>
@@ -51,6 +52,13 @@ Interpreter::~Interpreter()
 {
 }
 
+Profiler& Interpreter::profiler()
+{
+    if (!m_profiler)
+        m_profiler = make<Profiler>(*this);
+    return *m_profiler;
+}
+
 Value Interpreter::run(const Statement& statement, ArgumentVector arguments, ScopeType scope_type)
 {
     if (statement.is_program()) {
@@ -68,14 +76,19 @@ Value Interpreter::run(const Statement& statement, ArgumentVector arguments, Sco
 
     auto& block = static_cast<const ScopeNode&>(statement);
     enter_scope(block, move(arguments), scope_type);
+    poll_profiler();
 
     m_last_value = js_undefined();
-    for (auto& node : block.children()) {
-        m_last_value = node.execute(*this);
-        if (should_unwind()) {
-            if (should_unwind_until(ScopeType::Breakable, block.label()))
-                stop_unwind();
-            break;
+    if (m_bytecode_enabled) {
+        m_last_value = Bytecode::run(*this, block.bytecode(), block);
+    } else {
+        for (auto& node : block.children()) {
+            m_last_value = node.execute(*this);
+            if (should_unwind()) {
+                if (should_unwind_until(ScopeType::Breakable, block.label()))
+                    stop_unwind();
+                break;
+            }
         }
     }
 
@@ -96,26 +109,22 @@ void Interpreter::enter_scope(const ScopeNode& scope_node, ArgumentVector argume
         return;
     }
 
-    HashMap<FlyString, Variable> scope_variables_with_declaration_kind;
-    scope_variables_with_declaration_kind.ensure_capacity(16);
-
-    for (auto& declaration : scope_node.variables()) {
-        for (auto& declarator : declaration.declarations()) {
-            if (scope_node.is_program())
-                global_object().put(declarator.id().string(), js_undefined());
-            else
-                scope_variables_with_declaration_kind.set(declarator.id().string(), { js_undefined(), declaration.declaration_kind() });
-        }
-    }
-
-    for (auto& argument : arguments) {
-        scope_variables_with_declaration_kind.set(argument.name, { argument.value, DeclarationKind::Var });
+    if (scope_node.is_program()) {
+        for (auto& name : scope_node.variable_names())
+            global_object().put(name, js_undefined());
     }
 
     bool pushed_lexical_environment = false;
 
-    if (!scope_variables_with_declaration_kind.is_empty()) {
-        auto* block_lexical_environment = heap().allocate<LexicalEnvironment>(move(scope_variables_with_declaration_kind), current_environment());
+    if (!scope_node.is_program() && (!scope_node.variable_names().is_empty() || !arguments.is_empty())) {
+        Vector<FlyString> names = scope_node.variable_names();
+        Vector<Variable> variables;
+        variables.ensure_capacity(names.size() + arguments.size());
+        for (auto kind : scope_node.variable_kinds())
+            variables.append({ js_undefined(), kind });
+        auto* block_lexical_environment = heap().allocate<LexicalEnvironment>(move(names), move(variables), current_environment());
+        for (auto& argument : arguments)
+            block_lexical_environment->set(argument.name, { argument.value, DeclarationKind::Var });
         m_call_stack.last().environment = block_lexical_environment;
         pushed_lexical_environment = true;
     }
@@ -138,47 +147,57 @@ void Interpreter::exit_scope(const ScopeNode& scope_node)
         m_unwind_until = ScopeType::None;
 }
 
-void Interpreter::set_variable(const FlyString& name, Value value, bool first_assignment)
+Variable* Interpreter::find_variable(const FlyString& name, Optional<EnvironmentCoordinate>* cached_coordinate)
 {
-    if (m_call_stack.size()) {
-        for (auto* environment = current_environment(); environment; environment = environment->parent()) {
-            auto possible_match = environment->get(name);
-            if (possible_match.has_value()) {
-                if (!first_assignment && possible_match.value().declaration_kind == DeclarationKind::Const) {
-                    throw_exception<TypeError>("Assignment to constant variable");
-                    return;
-                }
-
-                environment->set(name, { value, possible_match.value().declaration_kind });
-                return;
-            }
-        }
+    if (m_call_stack.is_empty())
+        return nullptr;
+
+    if (cached_coordinate && cached_coordinate->has_value()) {
+        auto coordinate = cached_coordinate->value();
+        auto* environment = current_environment();
+        for (u32 i = 0; environment && i < coordinate.hops; ++i)
+            environment = environment->parent();
+        if (environment && coordinate.index < environment->size() && environment->name_at(coordinate.index) == name)
+            return &environment->variable_at(coordinate.index);
     }
 
-    global_object().put(move(name), move(value));
+    u32 hops = 0;
+    for (auto* environment = current_environment(); environment; environment = environment->parent(), ++hops) {
+        auto index = environment->index_of(name);
+        if (!index.has_value())
+            continue;
+        if (cached_coordinate)
+            *cached_coordinate = EnvironmentCoordinate { hops, static_cast<u32>(index.value()) };
+        return &environment->variable_at(index.value());
+    }
+    return nullptr;
 }
 
-Value Interpreter::get_variable(const FlyString& name)
+void Interpreter::set_variable(const FlyString& name, Value value, bool first_assignment, Optional<EnvironmentCoordinate>* cached_coordinate)
 {
-    if (m_call_stack.size()) {
-        for (auto* environment = current_environment(); environment; environment = environment->parent()) {
-            auto possible_match = environment->get(name);
-            if (possible_match.has_value())
-                return possible_match.value().value;
+    if (auto* variable = find_variable(name, cached_coordinate)) {
+        if (!first_assignment && variable->declaration_kind == DeclarationKind::Const) {
+            throw_exception<TypeError>("Assignment to constant variable");
+            return;
         }
+        variable->value = value;
+        return;
     }
+
+    global_object().put(move(name), move(value));
+}
+
+Value Interpreter::get_variable(const FlyString& name, Optional<EnvironmentCoordinate>* cached_coordinate)
+{
+    if (auto* variable = find_variable(name, cached_coordinate))
+        return variable->value;
     return global_object().get(name);
 }
 
-Reference Interpreter::get_reference(const FlyString& name)
+Reference Interpreter::get_reference(const FlyString& name, Optional<EnvironmentCoordinate>* cached_coordinate)
 {
-    if (m_call_stack.size()) {
-        for (auto* environment = current_environment(); environment; environment = environment->parent()) {
-            auto possible_match = environment->get(name);
-            if (possible_match.has_value())
-                return { Reference::LocalVariable, name };
-        }
-    }
+    if (find_variable(name, cached_coordinate))
+        return { Reference::LocalVariable, name, false, cached_coordinate };
     return { Reference::GlobalVariable, name };
 }
 
@@ -206,11 +225,12 @@ void Interpreter::gather_roots(Badge<Heap>, HashTable<Cell*>& roots)
 Value Interpreter::call(Function& function, Value this_value, Optional<MarkedValueList> arguments)
 {
     auto& call_frame = push_call_frame();
+    call_frame.function = &function;
     call_frame.function_name = function.name();
     call_frame.this_value = function.bound_this().value_or(this_value);
     call_frame.arguments = function.bound_arguments();
     if (arguments.has_value())
-        call_frame.arguments.append(arguments.value().values());
+        call_frame.arguments.append(arguments.value().values().data(), arguments.value().size());
     call_frame.environment = function.create_environment();
     auto result = function.call(*this);
     pop_call_frame();
@@ -220,6 +240,7 @@ Value Interpreter::call(Function& function, Value this_value, Optional<MarkedVal
 Value Interpreter::construct(Function& function, Function& new_target, Optional<MarkedValueList> arguments)
 {
     auto& call_frame = push_call_frame();
+    call_frame.function = &function;
     call_frame.function_name = function.name();
     if (arguments.has_value())
         call_frame.arguments = arguments.value().values();
@@ -28,6 +28,7 @@
 
 #include <AK/FlyString.h>
 #include <AK/HashMap.h>
+#include <AK/OwnPtr.h>
 #include <AK/String.h>
 #include <AK/Vector.h>
 #include <AK/Weakable.h>
@@ -35,6 +36,7 @@
 #include <LibJS/Console.h>
 #include <LibJS/Forward.h>
 #include <LibJS/Heap/Heap.h>
+#include <LibJS/Profiler.h>
 #include <LibJS/Runtime/Exception.h>
 #include <LibJS/Runtime/LexicalEnvironment.h>
 #include <LibJS/Runtime/MarkedValueList.h>
@@ -58,9 +60,10 @@ struct ScopeFrame {
 };
 
 struct CallFrame {
+    Function* function { nullptr };
     FlyString function_name;
     Value this_value;
-    Vector<Value> arguments;
+    Vector<Value, 8> arguments;
     LexicalEnvironment* environment { nullptr };
 };
 
@@ -91,6 +94,10 @@ public:
 
     Heap& heap() { return m_heap; }
 
+    // Runs scope nodes by compiling them to bytecode instead of walking the AST.
+    bool is_bytecode_enabled() const { return m_bytecode_enabled; }
+    void set_bytecode_enabled(bool enabled) { m_bytecode_enabled = enabled; }
+
     void unwind(ScopeType type, FlyString label = {})
     {
         m_unwind_until = type;
@@ -105,10 +112,12 @@ public:
     }
     bool should_unwind() const { return m_unwind_until != ScopeType::None; }
 
-    Value get_variable(const FlyString& name);
-    void set_variable(const FlyString& name, Value, bool first_assignment = false);
+    // The optional coordinate caches where the name was found last time; it is checked
+    // against the name before use, and refreshed by the full search when it misses.
+    Value get_variable(const FlyString& name, Optional<EnvironmentCoordinate>* cached_coordinate = nullptr);
+    void set_variable(const FlyString& name, Value, bool first_assignment = false, Optional<EnvironmentCoordinate>* cached_coordinate = nullptr);
 
-    Reference get_reference(const FlyString& name);
+    Reference get_reference(const FlyString& name, Optional<EnvironmentCoordinate>* cached_coordinate = nullptr);
 
     void gather_roots(Badge<Heap>, HashTable<Cell*>&);
 
@@ -120,7 +129,7 @@ public:
 
     CallFrame& push_call_frame()
     {
-        m_call_stack.append({ {}, js_undefined(), {}, nullptr });
+        m_call_stack.append({ nullptr, {}, js_undefined(), {}, nullptr });
         return m_call_stack.last();
     }
     void pop_call_frame() { m_call_stack.take_last(); }
@@ -183,9 +192,20 @@ public:
     String join_arguments() const;
     Vector<String> get_trace() const;
 
+    Profiler& profiler();
+
+    // Called where the call stack is consistent, so a pending profiler sample can be taken.
+    void poll_profiler()
+    {
+        if (m_profiler && m_profiler->has_pending_sample())
+            m_profiler->take_sample();
+    }
+
 private:
     Interpreter();
 
+    Variable* find_variable(const FlyString& name, Optional<EnvironmentCoordinate>* cached_coordinate);
+
     Heap m_heap;
 
     Value m_last_value;
@@ -201,6 +221,9 @@ private:
     FlyString m_unwind_until_label;
 
     Console m_console;
+    OwnPtr<Profiler> m_profiler;
+
+    bool m_bytecode_enabled { false };
 };
 
 }
@@ -26,98 +26,98 @@
 
 #include "Lexer.h"
 #include <AK/HashMap.h>
+#include <AK/StaticStringMap.h>
 #include <AK/StringBuilder.h>
 #include <ctype.h>
 #include <stdio.h>
 
 namespace JS {
 
-HashMap<String, TokenType> Lexer::s_keywords;
-HashMap<String, TokenType> Lexer::s_three_char_tokens;
-HashMap<String, TokenType> Lexer::s_two_char_tokens;
+static constexpr auto s_keywords = make_static_string_map<TokenType>({
+    { "await", TokenType::Await },
+    { "break", TokenType::Break },
+    { "case", TokenType::Case },
+    { "catch", TokenType::Catch },
+    { "class", TokenType::Class },
+    { "const", TokenType::Const },
+    { "continue", TokenType::Continue },
+    { "debugger", TokenType::Debugger },
+    { "default", TokenType::Default },
+    { "delete", TokenType::Delete },
+    { "do", TokenType::Do },
+    { "else", TokenType::Else },
+    { "enum", TokenType::Enum },
+    { "export", TokenType::Export },
+    { "extends", TokenType::Extends },
+    { "false", TokenType::BoolLiteral },
+    { "finally", TokenType::Finally },
+    { "for", TokenType::For },
+    { "function", TokenType::Function },
+    { "if", TokenType::If },
+    { "import", TokenType::Import },
+    { "in", TokenType::In },
+    { "instanceof", TokenType::Instanceof },
+    { "let", TokenType::Let },
+    { "new", TokenType::New },
+    { "null", TokenType::NullLiteral },
+    { "return", TokenType::Return },
+    { "super", TokenType::Super },
+    { "switch", TokenType::Switch },
+    { "this", TokenType::This },
+    { "throw", TokenType::Throw },
+    { "true", TokenType::BoolLiteral },
+    { "try", TokenType::Try },
+    { "typeof", TokenType::Typeof },
+    { "var", TokenType::Var },
+    { "void", TokenType::Void },
+    { "while", TokenType::While },
+    { "with", TokenType::With },
+    { "yield", TokenType::Yield },
+});
+
+static constexpr auto s_three_char_tokens = make_static_string_map<TokenType>({
+    { "===", TokenType::EqualsEqualsEquals },
+    { "!==", TokenType::ExclamationMarkEqualsEquals },
+    { "**=", TokenType::DoubleAsteriskEquals },
+    { "<<=", TokenType::ShiftLeftEquals },
+    { ">>=", TokenType::ShiftRightEquals },
+    { ">>>", TokenType::UnsignedShiftRight },
+    { "...", TokenType::TripleDot },
+});
+
+static constexpr auto s_two_char_tokens = make_static_string_map<TokenType>({
+    { "=>", TokenType::Arrow },
+    { "+=", TokenType::PlusEquals },
+    { "-=", TokenType::MinusEquals },
+    { "*=", TokenType::AsteriskEquals },
+    { "/=", TokenType::SlashEquals },
+    { "%=", TokenType::PercentEquals },
+    { "&=", TokenType::AmpersandEquals },
+    { "|=", TokenType::PipeEquals },
+    { "^=", TokenType::CaretEquals },
+    { "&&", TokenType::DoubleAmpersand },
+    { "||", TokenType::DoublePipe },
+    { "??", TokenType::DoubleQuestionMark },
+    { "**", TokenType::DoubleAsterisk },
+    { "==", TokenType::EqualsEquals },
+    { "<=", TokenType::LessThanEquals },
+    { ">=", TokenType::GreaterThanEquals },
+    { "!=", TokenType::ExclamationMarkEquals },
+    { "--", TokenType::MinusMinus },
+    { "++", TokenType::PlusPlus },
+    { "<<", TokenType::ShiftLeft },
+    { ">>", TokenType::ShiftRight },
+    { "?.", TokenType::QuestionMarkPeriod },
+});
+
 HashMap<char, TokenType> Lexer::s_single_char_tokens;
 
-Lexer::Lexer(StringView source)
+Lexer::Lexer(StringView source, size_t line_number, size_t line_column)
     : m_source(source)
     , m_current_token(TokenType::Eof, StringView(nullptr), StringView(nullptr), 0, 0)
+    , m_line_number(line_number)
+    , m_line_column(line_column - 1)
 {
-    if (s_keywords.is_empty()) {
-        s_keywords.set("await", TokenType::Await);
-        s_keywords.set("break", TokenType::Break);
-        s_keywords.set("case", TokenType::Case);
-        s_keywords.set("catch", TokenType::Catch);
-        s_keywords.set("class", TokenType::Class);
-        s_keywords.set("const", TokenType::Const);
-        s_keywords.set("continue", TokenType::Continue);
-        s_keywords.set("debugger", TokenType::Debugger);
-        s_keywords.set("default", TokenType::Default);
-        s_keywords.set("delete", TokenType::Delete);
-        s_keywords.set("do", TokenType::Do);
-        s_keywords.set("else", TokenType::Else);
-        s_keywords.set("enum", TokenType::Enum);
-        s_keywords.set("export", TokenType::Export);
-        s_keywords.set("extends", TokenType::Extends);
-        s_keywords.set("false", TokenType::BoolLiteral);
-        s_keywords.set("finally", TokenType::Finally);
-        s_keywords.set("for", TokenType::For);
-        s_keywords.set("function", TokenType::Function);
-        s_keywords.set("if", TokenType::If);
-        s_keywords.set("import", TokenType::Import);
-        s_keywords.set("in", TokenType::In);
-        s_keywords.set("instanceof", TokenType::Instanceof);
-        s_keywords.set("let", TokenType::Let);
-        s_keywords.set("new", TokenType::New);
-        s_keywords.set("null", TokenType::NullLiteral);
-        s_keywords.set("return", TokenType::Return);
-        s_keywords.set("super", TokenType::Super);
-        s_keywords.set("switch", TokenType::Switch);
-        s_keywords.set("this", TokenType::This);
-        s_keywords.set("throw", TokenType::Throw);
-        s_keywords.set("true", TokenType::BoolLiteral);
-        s_keywords.set("try", TokenType::Try);
-        s_keywords.set("typeof", TokenType::Typeof);
-        s_keywords.set("var", TokenType::Var);
-        s_keywords.set("void", TokenType::Void);
-        s_keywords.set("while", TokenType::While);
-        s_keywords.set("with", TokenType::With);
-        s_keywords.set("yield", TokenType::Yield);
-    }
-
-    if (s_three_char_tokens.is_empty()) {
-        s_three_char_tokens.set("===", TokenType::EqualsEqualsEquals);
-        s_three_char_tokens.set("!==", TokenType::ExclamationMarkEqualsEquals);
-        s_three_char_tokens.set("**=", TokenType::DoubleAsteriskEquals);
-        s_three_char_tokens.set("<<=", TokenType::ShiftLeftEquals);
-        s_three_char_tokens.set(">>=", TokenType::ShiftRightEquals);
-        s_three_char_tokens.set(">>>", TokenType::UnsignedShiftRight);
-        s_three_char_tokens.set("...", TokenType::TripleDot);
-    }
-
-    if (s_two_char_tokens.is_empty()) {
-        s_two_char_tokens.set("=>", TokenType::Arrow);
-        s_two_char_tokens.set("+=", TokenType::PlusEquals);
-        s_two_char_tokens.set("-=", TokenType::MinusEquals);
-        s_two_char_tokens.set("*=", TokenType::AsteriskEquals);
-        s_two_char_tokens.set("/=", TokenType::SlashEquals);
-        s_two_char_tokens.set("%=", TokenType::PercentEquals);
-        s_two_char_tokens.set("&=", TokenType::AmpersandEquals);
-        s_two_char_tokens.set("|=", TokenType::PipeEquals);
-        s_two_char_tokens.set("^=", TokenType::CaretEquals);
-        s_two_char_tokens.set("&&", TokenType::DoubleAmpersand);
-        s_two_char_tokens.set("||", TokenType::DoublePipe);
-        s_two_char_tokens.set("??", TokenType::DoubleQuestionMark);
-        s_two_char_tokens.set("**", TokenType::DoubleAsterisk);
-        s_two_char_tokens.set("==", TokenType::EqualsEquals);
-        s_two_char_tokens.set("<=", TokenType::LessThanEquals);
-        s_two_char_tokens.set(">=", TokenType::GreaterThanEquals);
-        s_two_char_tokens.set("!=", TokenType::ExclamationMarkEquals);
-        s_two_char_tokens.set("--", TokenType::MinusMinus);
-        s_two_char_tokens.set("++", TokenType::PlusPlus);
-        s_two_char_tokens.set("<<", TokenType::ShiftLeft);
-        s_two_char_tokens.set(">>", TokenType::ShiftRight);
-        s_two_char_tokens.set("?.", TokenType::QuestionMarkPeriod);
-    }
-
     if (s_single_char_tokens.is_empty()) {
         s_single_char_tokens.set('&', TokenType::Ampersand);
         s_single_char_tokens.set('*', TokenType::Asterisk);
@@ -147,6 +147,22 @@ Lexer::Lexer(StringView source)
     consume();
 }
 
+Lexer::Lexer(StringView source, NonnullRefPtr<TokenBuffer> token_buffer)
+    : m_source(source)
+    , m_current_token(TokenType::Eof, StringView(nullptr), StringView(nullptr), 0, 0)
+    , m_token_buffer(move(token_buffer))
+{
+}
+
+NonnullRefPtr<TokenBuffer> Lexer::lex_all()
+{
+    Vector<Token> tokens;
+    do {
+        tokens.append(next());
+    } while (tokens.last().type() != TokenType::Eof);
+    return TokenBuffer::create(move(tokens));
+}
+
 void Lexer::consume()
 {
     if (m_position > m_source.length())
@@ -244,8 +260,45 @@ bool Lexer::is_numeric_literal_start() const
     return isdigit(m_current_char) || (m_current_char == '.' && m_position < m_source.length() && isdigit(m_source[m_position]));
 }
 
+// Whether a '/' starts a regular expression literal rather than being a division, judging by the
+// token before it. After something that ends an expression it has to be a division.
+bool Lexer::slash_means_regex() const
+{
+    return slash_means_regex_after(m_current_token.type());
+}
+
+bool Lexer::slash_means_regex_after(TokenType type)
+{
+    switch (type) {
+    case TokenType::BoolLiteral:
+    case TokenType::BracketClose:
+    case TokenType::Identifier:
+    case TokenType::MinusMinus:
+    case TokenType::NullLiteral:
+    case TokenType::NumericLiteral:
+    case TokenType::ParenClose:
+    case TokenType::PlusPlus:
+    case TokenType::RegexLiteral:
+    case TokenType::StringLiteral:
+    case TokenType::Super:
+    case TokenType::TemplateLiteralEnd:
+    case TokenType::This:
+        return false;
+    default:
+        return true;
+    }
+}
+
 Token Lexer::next()
 {
+    if (m_token_buffer) {
+        auto& tokens = m_token_buffer->tokens();
+        m_current_token = tokens[min(m_token_buffer_index, tokens.size() - 1)];
+        if (m_token_buffer_index < tokens.size())
+            ++m_token_buffer_index;
+        return m_current_token;
+    }
+
     size_t trivia_start = m_position;
     auto in_template = !m_template_states.is_empty();
 
@@ -321,12 +374,8 @@ Token Lexer::next()
         } while (is_identifier_middle());
 
         StringView value = m_source.substring_view(value_start - 1, m_position - value_start);
-        auto it = s_keywords.find(value);
-        if (it == s_keywords.end()) {
-            token_type = TokenType::Identifier;
-        } else {
-            token_type = it->value;
-        }
+        auto* keyword = s_keywords.get(value);
+        token_type = keyword ? *keyword : TokenType::Identifier;
     } else if (is_numeric_literal_start()) {
         if (m_current_char == '0') {
             consume();
@@ -397,6 +446,25 @@ Token Lexer::next()
             consume();
             token_type = TokenType::StringLiteral;
         }
+    } else if (m_current_char == '/' && slash_means_regex()) {
+        consume();
+        bool in_class = false;
+        while (!is_eof() && m_current_char != '\n' && (in_class || m_current_char != '/')) {
+            if (m_current_char == '[')
+                in_class = true;
+            else if (m_current_char == ']')
+                in_class = false;
+            else if (m_current_char == '\\' && m_position < m_source.length() && m_source[m_position] != '\n')
+                consume();
+            consume();
+        }
+        if (m_current_char == '/') {
+            consume();
+            // Flags, like the g in /x/g
+            while (is_identifier_middle())
+                consume();
+            token_type = TokenType::RegexLiteral;
+        }
     } else if (m_current_char == EOF) {
         token_type = TokenType::Eof;
     } else {
@@ -413,29 +481,24 @@ Token Lexer::next()
 
         bool found_three_char_token = false;
         if (!found_four_char_token && m_position + 1 < m_source.length()) {
-            char second_char = m_source[m_position];
-            char third_char = m_source[m_position + 1];
-            char three_chars[] { (char)m_current_char, second_char, third_char, 0 };
-            auto it = s_three_char_tokens.find(three_chars);
-            if (it != s_three_char_tokens.end()) {
+            auto* three_char_token = s_three_char_tokens.get(m_source.substring_view(m_position - 1, 3));
+            if (three_char_token) {
                 found_three_char_token = true;
                 consume();
                 consume();
                 consume();
-                token_type = it->value;
+                token_type = *three_char_token;
             }
         }
 
         bool found_two_char_token = false;
         if (!found_four_char_token && !found_three_char_token && m_position < m_source.length()) {
-            char second_char = m_source[m_position];
-            char two_chars[] { (char)m_current_char, second_char, 0 };
-            auto it = s_two_char_tokens.find(two_chars);
-            if (it != s_two_char_tokens.end()) {
+            auto* two_char_token = s_two_char_tokens.get(m_source.substring_view(m_position - 1, 2));
+            if (two_char_token) {
                 found_two_char_token = true;
                 consume();
                 consume();
-                token_type = it->value;
+                token_type = *two_char_token;
             }
         }
 
@@ -29,17 +29,49 @@
 #include "Token.h"
 
 #include <AK/HashMap.h>
+#include <AK/RefCounted.h>
+#include <AK/RefPtr.h>
 #include <AK/String.h>
 #include <AK/StringView.h>
+#include <AK/Vector.h>
 
 namespace JS {
 
+// All of the tokens of a source, lexed ahead of time. The tokens point into the source text,
+// which has to outlive them.
+class TokenBuffer : public RefCounted<TokenBuffer> {
+public:
+    static NonnullRefPtr<TokenBuffer> create(Vector<Token> tokens) { return adopt(*new TokenBuffer(move(tokens))); }
+
+    const Vector<Token>& tokens() const { return m_tokens; }
+
+private:
+    explicit TokenBuffer(Vector<Token> tokens)
+        : m_tokens(move(tokens))
+    {
+    }
+
+    Vector<Token> m_tokens;
+};
+
 class Lexer {
 public:
-    explicit Lexer(StringView source);
+    // The line number and column are those of the first character of the source, for lexing a
+    // piece cut out of a larger one.
+    explicit Lexer(StringView source, size_t line_number = 1, size_t line_column = 1);
+
+    // Replays the tokens of the source that were lexed ahead of time, possibly on another thread.
+    Lexer(StringView source, NonnullRefPtr<TokenBuffer>);
 
     Token next();
 
+    // Lexes the rest of the source, up to and including the Eof token. This only reads the
+    // lexer's own state, so it is safe to do on another thread than the one that created it.
+    NonnullRefPtr<TokenBuffer> lex_all();
+
+    // Whether a slash following a token of this type starts a regex literal rather than being a division.
+    static bool slash_means_regex_after(TokenType);
+
 private:
     void consume();
     void consume_exponent();
@@ -50,6 +82,7 @@ private:
     bool is_block_comment_start() const;
     bool is_block_comment_end() const;
     bool is_numeric_literal_start() const;
+    bool slash_means_regex() const;
     bool match(char, char) const;
     bool match(char, char, char) const;
     bool match(char, char, char, char) const;
@@ -67,9 +100,9 @@ private:
     };
     Vector<TemplateState> m_template_states;
 
-    static HashMap<String, TokenType> s_keywords;
-    static HashMap<String, TokenType> s_three_char_tokens;
-    static HashMap<String, TokenType> s_two_char_tokens;
+    RefPtr<TokenBuffer> m_token_buffer;
+    size_t m_token_buffer_index { 0 };
+
     static HashMap<char, TokenType> s_single_char_tokens;
 };
 
@@ -29,6 +29,7 @@
 #include <AK/HashMap.h>
 #include <AK/ScopeGuard.h>
 #include <AK/StdLibExtras.h>
+#include <LibJS/Runtime/RegExpObject.h>
 
 namespace JS {
 
@@ -70,7 +71,9 @@ Parser::ParserState::ParserState(Lexer lexer)
 
 Parser::Parser(Lexer lexer)
     : m_parser_state(move(lexer))
+    , m_arena(ASTArena::create())
 {
+    m_previous_arena = ASTArena::set_current(m_arena);
     if (g_operator_precedence.is_empty()) {
         // https://developer.mozilla.org/en-US/docs/Web/JavaScript/Reference/Operators/Operator_Precedence
         g_operator_precedence.set(TokenType::Period, 20);
@@ -149,6 +152,12 @@ Parser::Parser(Lexer lexer)
     }
 }
 
+Parser::~Parser()
+{
+    if (ASTArena::current() == m_arena.ptr())
+        ASTArena::set_current(move(m_previous_arena));
+}
+
 int Parser::operator_precedence(TokenType type) const
 {
     auto it = g_operator_precedence.find(type);
@@ -289,6 +298,7 @@ NonnullRefPtr<Statement> Parser::parse_statement()
 
 RefPtr<FunctionExpression> Parser::try_parse_arrow_function_expression(bool expect_parens)
 {
+    auto function_start = m_parser_state.m_current_token;
     save_state();
     m_parser_state.m_var_scopes.append(NonnullRefPtrVector<VariableDeclaration>());
 
@@ -381,7 +391,8 @@ RefPtr<FunctionExpression> Parser::try_parse_arrow_function_expression(bool expe
 
     if (!function_body_result.is_null()) {
         state_rollback_guard.disarm();
-        auto body = function_body_result.release_nonnull();
+        auto body = FunctionBody::create(function_body_result.release_nonnull());
+        body->set_function_position(function_start.line_number(), function_start.line_column());
         return create_ast_node<FunctionExpression>("", move(body), move(parameters), function_length, m_parser_state.m_var_scopes.take_last(), true);
     }
 
@@ -443,6 +454,8 @@ NonnullRefPtr<Expression> Parser::parse_primary_expression()
         return create_ast_node<BooleanLiteral>(consume().bool_value());
     case TokenType::StringLiteral:
         return parse_string_literal(consume());
+    case TokenType::RegexLiteral:
+        return parse_regexp_literal(consume());
     case TokenType::NullLiteral:
         consume();
         return create_ast_node<NullLiteral>();
@@ -643,6 +656,24 @@ NonnullRefPtr<StringLiteral> Parser::parse_string_literal(Token token)
     return create_ast_node<StringLiteral>(string);
 }
 
+NonnullRefPtr<RegExpLiteral> Parser::parse_regexp_literal(Token token)
+{
+    // The lexer has made sure the token is /pattern/flags.
+    auto value = token.value();
+    size_t closing_slash = value.length() - 1;
+    while (value[closing_slash] != '/')
+        --closing_slash;
+    auto source = value.substring_view(1, closing_slash - 1);
+    auto flags = value.substring_view(closing_slash + 1, value.length() - closing_slash - 1);
+
+    if (!RegExpObject::are_valid_flags(flags))
+        syntax_error(String::format("Invalid regular expression flags '%s'", String(flags).characters()), token.line_number(), token.line_column());
+    auto pattern = Regex::Pattern::create(source, RegExpObject::pattern_flags(flags));
+    if (!pattern->is_valid())
+        syntax_error(String::format("Invalid regular expression: %s", pattern->error().characters()), token.line_number(), token.line_column());
+    return create_ast_node<RegExpLiteral>(move(pattern), flags);
+}
+
 NonnullRefPtr<TemplateLiteral> Parser::parse_template_literal(bool is_tagged)
 {
     consume(TokenType::TemplateLiteralStart);
@@ -1005,6 +1036,7 @@ NonnullRefPtr<FunctionNodeType> Parser::parse_function_node(bool needs_function_
 {
     ScopePusher scope(*this, ScopePusher::Var);
 
+    auto function_start = m_parser_state.m_current_token;
     if (needs_function_keyword)
         consume(TokenType::Function);
 
@@ -1043,9 +1075,64 @@ NonnullRefPtr<FunctionNodeType> Parser::parse_function_node(bool needs_function_
     if (function_length == -1)
         function_length = parameters.size();
 
+    RefPtr<FunctionBody> body;
+    if (m_lazy_function_bodies) {
+        body = pre_parse_function_body();
+    } else {
+        auto block = parse_block_statement();
+        block->add_variables(m_parser_state.m_var_scopes.last());
+        body = FunctionBody::create(move(block));
+    }
+    body->set_function_position(function_start.line_number(), function_start.line_column());
+    return create_ast_node<FunctionNodeType>(name, body.release_nonnull(), move(parameters), function_length, NonnullRefPtrVector<VariableDeclaration>());
+}
+
+NonnullRefPtr<FunctionBody> Parser::pre_parse_function_body()
+{
+    auto open_curly = m_parser_state.m_current_token;
+    consume(TokenType::CurlyOpen);
+
+    // The body's source runs from the opening curly to its matching closing curly. Curlies
+    // inside of template literal substitutions don't need special care, as the lexer gives
+    // the ones that delimit a substitution their own token types.
+    auto* source_start = open_curly.value().characters_without_null_termination();
+    auto* source_end = source_start + open_curly.value().length();
+    size_t depth = 1;
+    while (depth) {
+        auto& token = m_parser_state.m_current_token;
+        switch (token.type()) {
+        case TokenType::Eof:
+            expected(Token::name(TokenType::CurlyClose));
+            return FunctionBody::create(create_ast_node<BlockStatement>());
+        case TokenType::Invalid:
+        case TokenType::UnterminatedStringLiteral:
+        case TokenType::UnterminatedTemplateLiteral:
+            expected("statement");
+            break;
+        case TokenType::CurlyOpen:
+            ++depth;
+            break;
+        case TokenType::CurlyClose:
+            --depth;
+            break;
+        default:
+            break;
+        }
+        source_end = token.value().characters_without_null_termination() + token.value().length();
+        consume();
+    }
+
+    StringView source { source_start, static_cast<size_t>(source_end - source_start) };
+    return FunctionBody::create_lazy(source, open_curly.line_number(), open_curly.line_column(), m_parser_state.m_strict_mode);
+}
+
+NonnullRefPtr<BlockStatement> Parser::parse_function_body(bool strict_mode)
+{
+    ScopePusher scope(*this, ScopePusher::Var);
+    m_parser_state.m_strict_mode = strict_mode;
     auto body = parse_block_statement();
     body->add_variables(m_parser_state.m_var_scopes.last());
-    return create_ast_node<FunctionNodeType>(name, move(body), move(parameters), function_length, NonnullRefPtrVector<VariableDeclaration>());
+    return body;
 }
 
 NonnullRefPtr<VariableDeclaration> Parser::parse_variable_declaration(bool with_semicolon)
@@ -1368,6 +1455,7 @@ bool Parser::match_expression() const
     return type == TokenType::BoolLiteral
         || type == TokenType::NumericLiteral
         || type == TokenType::StringLiteral
+        || type == TokenType::RegexLiteral
         || type == TokenType::TemplateLiteralStart
         || type == TokenType::NullLiteral
         || type == TokenType::Identifier
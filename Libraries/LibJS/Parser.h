@@ -42,11 +42,17 @@ enum class Associativity {
 class Parser {
 public:
     explicit Parser(Lexer lexer);
+    ~Parser();
 
     NonnullRefPtr<Program> parse_program();
 
+    // Only pre-parse the bodies of functions: check that their braces balance and their tokens
+    // are valid, and leave the rest of the parsing to the first time each function is called.
+    void set_lazy_function_bodies(bool lazy) { m_lazy_function_bodies = lazy; }
+
     template<typename FunctionNodeType>
     NonnullRefPtr<FunctionNodeType> parse_function_node(bool need_function_keyword = true);
+    NonnullRefPtr<BlockStatement> parse_function_body(bool strict_mode);
 
     NonnullRefPtr<Statement> parse_statement();
     NonnullRefPtr<BlockStatement> parse_block_statement();
@@ -73,6 +79,7 @@ public:
     NonnullRefPtr<ObjectExpression> parse_object_expression();
     NonnullRefPtr<ArrayExpression> parse_array_expression();
     NonnullRefPtr<StringLiteral> parse_string_literal(Token token);
+    NonnullRefPtr<RegExpLiteral> parse_regexp_literal(Token token);
     NonnullRefPtr<TemplateLiteral> parse_template_literal(bool is_tagged);
     NonnullRefPtr<Expression> parse_secondary_expression(NonnullRefPtr<Expression>, int min_precedence, Associativity associate = Associativity::Right);
     NonnullRefPtr<CallExpression> parse_call_expression(NonnullRefPtr<Expression>);
@@ -134,6 +141,7 @@ private:
     void consume_or_insert_semicolon();
     void save_state();
     void load_state();
+    NonnullRefPtr<FunctionBody> pre_parse_function_body();
 
     enum class UseStrictDirectiveState {
         None,
@@ -154,6 +162,9 @@ private:
     };
 
     ParserState m_parser_state;
+    NonnullRefPtr<ASTArena> m_arena;
+    RefPtr<ASTArena> m_previous_arena;
     Vector<ParserState> m_saved_state;
+    bool m_lazy_function_bodies { false };
 };
 }
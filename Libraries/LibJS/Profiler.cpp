@@ -0,0 +1,188 @@
+/*
+ * Copyright (c) 2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/JsonArraySerializer.h>
+#include <AK/JsonObjectSerializer.h>
+#include <AK/StringBuilder.h>
+#include <LibCore/File.h>
+#include <LibJS/Interpreter.h>
+#include <LibJS/Profiler.h>
+#include <LibJS/Runtime/ScriptFunction.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace JS {
+
+Profiler::Profiler(Interpreter& interpreter)
+    : m_interpreter(interpreter)
+{
+}
+
+Profiler::~Profiler()
+{
+    if (m_running)
+        stop();
+}
+
+void Profiler::start(const String& title, useconds_t sample_interval_us)
+{
+    ASSERT(!m_running);
+    m_title = title;
+    m_sample_interval_us = sample_interval_us;
+    m_samples.clear();
+    m_frame_names.clear();
+    m_frame_index_for_body.clear();
+    m_frame_index_for_native_name.clear();
+    m_bodies.clear();
+    m_sample_requested.store(false);
+    m_should_stop.store(false);
+
+    if (pthread_create(&m_sampler_thread, nullptr, sampler_thread, this) != 0) {
+        perror("pthread_create");
+        return;
+    }
+    m_running = true;
+}
+
+void Profiler::stop()
+{
+    ASSERT(m_running);
+    m_should_stop.store(true);
+    pthread_join(m_sampler_thread, nullptr);
+    m_running = false;
+    m_sample_requested.store(false);
+}
+
+void* Profiler::sampler_thread(void* argument)
+{
+    auto& profiler = *static_cast<Profiler*>(argument);
+    while (!profiler.m_should_stop.load(AK::memory_order_relaxed)) {
+        usleep(profiler.m_sample_interval_us);
+        profiler.m_sample_requested.store(true, AK::memory_order_relaxed);
+    }
+    return nullptr;
+}
+
+size_t Profiler::frame_index_for(const CallFrame& call_frame)
+{
+    auto* function = call_frame.function;
+    if (function && function->is_script_function()) {
+        auto& body = static_cast<ScriptFunction*>(function)->function_body();
+        auto it = m_frame_index_for_body.find(&body);
+        if (it != m_frame_index_for_body.end())
+            return it->value;
+        auto& name = call_frame.function_name;
+        auto frame_name = String::format("%s (%zu:%zu)", name.is_empty() ? "(anonymous)" : name.characters(), body.function_line_number(), body.function_line_column());
+        u32 index = m_frame_names.size();
+        m_frame_names.append(move(frame_name));
+        m_frame_index_for_body.set(&body, index);
+        m_bodies.append(const_cast<FunctionBody&>(body));
+        return index;
+    }
+
+    String name = call_frame.function_name;
+    if (name.is_empty())
+        name = function ? "(native)" : "(global)";
+    auto it = m_frame_index_for_native_name.find(name);
+    if (it != m_frame_index_for_native_name.end())
+        return it->value;
+    u32 index = m_frame_names.size();
+    m_frame_names.append(name);
+    m_frame_index_for_native_name.set(name, index);
+    return index;
+}
+
+void Profiler::take_sample()
+{
+    m_sample_requested.store(false, AK::memory_order_relaxed);
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    Sample sample;
+    sample.timestamp = (u64)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+    auto& call_stack = m_interpreter.call_stack();
+    sample.frames.ensure_capacity(call_stack.size());
+    for (ssize_t i = call_stack.size() - 1; i >= 0; --i)
+        sample.frames.unchecked_append(frame_index_for(call_stack[i]));
+    m_samples.append(move(sample));
+}
+
+// AK's JSON serializers don't escape strings, so keep only what can't break out of one.
+static String json_safe(const String& string)
+{
+    StringBuilder builder;
+    for (char ch : string) {
+        if (ch == '"' || ch == '\\' || (u8)ch < 0x20)
+            builder.append('_');
+        else
+            builder.append(ch);
+    }
+    return builder.build();
+}
+
+String Profiler::to_json() const
+{
+    Vector<String> frame_names;
+    frame_names.ensure_capacity(m_frame_names.size());
+    for (auto& name : m_frame_names)
+        frame_names.unchecked_append(json_safe(name));
+
+    StringBuilder builder;
+    {
+        JsonObjectSerializer object(builder);
+        object.add("pid", getpid());
+        object.add("executable", "");
+        object.add("title", json_safe(m_title));
+        object.add("symbolicated", true);
+        auto events = object.add_array("events");
+        for (auto& sample : m_samples) {
+            auto event = events.add_object();
+            event.add("type", "sample");
+            event.add("pid", getpid());
+            event.add("tid", gettid());
+            event.add("timestamp", sample.timestamp);
+            auto stack = event.add_array("stack");
+            for (auto index : sample.frames)
+                stack.add(frame_names[index]);
+        }
+    }
+    return builder.build();
+}
+
+bool Profiler::write_to_file(const String& path) const
+{
+    auto file = Core::File::construct(path);
+    if (!file->open(Core::IODevice::WriteOnly)) {
+        fprintf(stderr, "Unable to open %s: %s\n", path.characters(), file->error_string());
+        return false;
+    }
+    auto json = to_json();
+    return file->write(json);
+}
+
+}
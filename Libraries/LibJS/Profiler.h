@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/Atomic.h>
+#include <AK/HashMap.h>
+#include <AK/Noncopyable.h>
+#include <AK/String.h>
+#include <AK/Vector.h>
+#include <LibJS/AST.h>
+#include <LibJS/Forward.h>
+#include <pthread.h>
+
+namespace JS {
+
+// A sampling profiler for scripts. A thread wakes up every sample interval and asks the
+// interpreter for a sample, which takes it the next time it reaches a safe point (entering
+// a scope or calling a function) by walking its call stack. The result is written out in
+// the same JSON format as kernel profiles, with stacks that are already symbolicated, so
+// ProfileViewer can show it as a tree or a flame graph.
+class Profiler {
+    AK_MAKE_NONCOPYABLE(Profiler);
+    AK_MAKE_NONMOVABLE(Profiler);
+
+public:
+    explicit Profiler(Interpreter&);
+    ~Profiler();
+
+    static constexpr useconds_t default_sample_interval_us = 1000;
+
+    bool is_running() const { return m_running; }
+    const String& title() const { return m_title; }
+
+    void start(const String& title, useconds_t sample_interval_us = default_sample_interval_us);
+    void stop();
+
+    bool has_pending_sample() const { return m_sample_requested.load(AK::memory_order_relaxed); }
+    void take_sample();
+
+    size_t sample_count() const { return m_samples.size(); }
+    String to_json() const;
+    bool write_to_file(const String& path) const;
+
+private:
+    static void* sampler_thread(void*);
+
+    size_t frame_index_for(const CallFrame&);
+
+    struct Sample {
+        u64 timestamp { 0 };
+        // Innermost frame first, like the return addresses of a kernel profile.
+        Vector<u32> frames;
+    };
+
+    Interpreter& m_interpreter;
+    String m_title;
+    useconds_t m_sample_interval_us { default_sample_interval_us };
+    pthread_t m_sampler_thread;
+    bool m_running { false };
+    Atomic<bool> m_sample_requested { false };
+    Atomic<bool> m_should_stop { false };
+
+    Vector<Sample> m_samples;
+
+    // Frames are described once, as "name (line:column)", and then referred to by index.
+    // The bodies are kept alive so their addresses stay unique while they're used as keys.
+    Vector<String> m_frame_names;
+    HashMap<const FunctionBody*, u32> m_frame_index_for_body;
+    HashMap<String, u32> m_frame_index_for_native_name;
+    Vector<NonnullRefPtr<FunctionBody>> m_bodies;
+};
+
+}
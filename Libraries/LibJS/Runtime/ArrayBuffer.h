@@ -24,35 +24,31 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+
 #pragma once
 
+#include <AK/ByteBuffer.h>
 #include <LibJS/Runtime/Object.h>
 
 namespace JS {
 
-class Uint8ClampedArray final : public Object {
+class ArrayBuffer final : public Object {
 public:
-    static Uint8ClampedArray* create(GlobalObject&, u32 length);
-
-    Uint8ClampedArray(u32 length, Object& prototype);
-    virtual ~Uint8ClampedArray() override;
+    static ArrayBuffer* create(GlobalObject&, size_t byte_length);
 
-    i32 length() const { return m_length; }
+    ArrayBuffer(ByteBuffer, Object& prototype);
+    virtual ~ArrayBuffer() override;
 
-    virtual bool put_by_index(u32 property_index, Value value) override;
-    virtual Value get_by_index(u32 property_index) const override;
-
-    u8* data() { return m_data; }
-    const u8* data() const { return m_data; }
+    size_t byte_length() const { return m_buffer.size(); }
+    ByteBuffer& buffer() { return m_buffer; }
+    const ByteBuffer& buffer() const { return m_buffer; }
 
 private:
-    virtual const char* class_name() const override { return "Uint8ClampedArray"; }
-    virtual bool is_array() const override { return true; }
-
-    static Value length_getter(Interpreter&);
+    virtual const char* class_name() const override { return "ArrayBuffer"; }
+    virtual bool is_array_buffer() const override { return true; }
 
-    u8* m_data { nullptr };
-    u32 m_length { 0 };
+    // Allocated once and never resized, so views can hold on to pointers into it.
+    ByteBuffer m_buffer;
 };
 
 }
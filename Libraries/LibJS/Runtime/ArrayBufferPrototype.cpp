@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <AK/Function.h>
+#include <LibJS/Interpreter.h>
+#include <LibJS/Runtime/ArrayBuffer.h>
+#include <LibJS/Runtime/ArrayBufferPrototype.h>
+#include <LibJS/Runtime/Error.h>
+#include <LibJS/Runtime/GlobalObject.h>
+
+namespace JS {
+
+ArrayBufferPrototype::ArrayBufferPrototype()
+    : Object(interpreter().global_object().object_prototype())
+{
+    u8 attr = Attribute::Writable | Attribute::Configurable;
+    define_native_property("byteLength", byte_length_getter, nullptr, Attribute::Configurable);
+    define_native_function("slice", slice, 2, attr);
+}
+
+ArrayBufferPrototype::~ArrayBufferPrototype()
+{
+}
+
+static ArrayBuffer* array_buffer_from(Interpreter& interpreter)
+{
+    auto* this_object = interpreter.this_value().to_object(interpreter);
+    if (!this_object)
+        return nullptr;
+    if (!this_object->is_array_buffer()) {
+        interpreter.throw_exception<TypeError>("Not an ArrayBuffer");
+        return nullptr;
+    }
+    return static_cast<ArrayBuffer*>(this_object);
+}
+
+Value ArrayBufferPrototype::byte_length_getter(Interpreter& interpreter)
+{
+    auto* array_buffer = array_buffer_from(interpreter);
+    if (!array_buffer)
+        return {};
+    return Value(static_cast<i32>(array_buffer->byte_length()));
+}
+
+Value ArrayBufferPrototype::slice(Interpreter& interpreter)
+{
+    auto* array_buffer = array_buffer_from(interpreter);
+    if (!array_buffer)
+        return {};
+
+    i32 byte_length = array_buffer->byte_length();
+    i32 start = 0;
+    i32 end = byte_length;
+    if (interpreter.argument_count() >= 1) {
+        start = interpreter.argument(0).to_i32(interpreter);
+        if (interpreter.exception())
+            return {};
+        start = start < 0 ? max(byte_length + start, 0) : min(start, byte_length);
+    }
+    if (interpreter.argument_count() >= 2 && !interpreter.argument(1).is_undefined()) {
+        end = interpreter.argument(1).to_i32(interpreter);
+        if (interpreter.exception())
+            return {};
+        end = end < 0 ? max(byte_length + end, 0) : min(end, byte_length);
+    }
+
+    auto* new_array_buffer = ArrayBuffer::create(interpreter.global_object(), max(end - start, 0));
+    if (end > start)
+        __builtin_memcpy(new_array_buffer->buffer().data(), array_buffer->buffer().data() + start, end - start);
+    return new_array_buffer;
+}
+
+}
@@ -99,6 +99,18 @@ static size_t get_length(Interpreter& interpreter, Object& object)
     return length_property.to_size_t(interpreter);
 }
 
+// Dense arrays have no holes or accessors, so their elements can be read without a property lookup.
+static Value get_element(Object& object, size_t index)
+{
+    if (object.is_array()) {
+        auto& indexed_properties = object.indexed_properties();
+        auto* elements = indexed_properties.packed_elements();
+        if (elements && index < indexed_properties.array_like_size())
+            return elements->at(index);
+    }
+    return object.get(index);
+}
+
 static void for_each_item(Interpreter& interpreter, const String& name, AK::Function<IterationDecision(size_t index, Value value, Value callback_result)> callback, bool skip_empty = true)
 {
     auto* this_object = interpreter.this_value().to_object(interpreter);
@@ -116,7 +128,7 @@ static void for_each_item(Interpreter& interpreter, const String& name, AK::Func
     auto this_value = interpreter.argument(1);
 
     for (size_t i = 0; i < initial_length; ++i) {
-        auto value = this_object->get(i);
+        auto value = get_element(*this_object, i);
         if (interpreter.exception())
             return;
         if (value.is_empty()) {
@@ -167,11 +179,13 @@ Value ArrayPrototype::map(Interpreter& interpreter)
     if (interpreter.exception())
         return {};
     auto* new_array = Array::create(interpreter.global_object());
-    new_array->indexed_properties().set_array_like_size(initial_length);
+    // Results are defined as own properties in index order, so mapping a dense array yields a dense array.
     for_each_item(interpreter, "map", [&](auto index, auto, auto callback_result) {
-        new_array->put(index, callback_result);
+        new_array->indexed_properties().put(new_array, index, callback_result);
         return IterationDecision::Continue;
     });
+    if (new_array->indexed_properties().array_like_size() < initial_length)
+        new_array->indexed_properties().set_array_like_size(initial_length);
     return Value(new_array);
 }
 
@@ -419,6 +433,28 @@ Value ArrayPrototype::index_of(Interpreter& interpreter)
             from_index = max(length + from_index, 0);
     }
     auto search_element = interpreter.argument(0);
+    if (this_object->is_array()) {
+        auto& indexed_properties = this_object->indexed_properties();
+        if (auto* elements = indexed_properties.packed_elements()) {
+            auto element_kind = indexed_properties.element_kind();
+            i32 end = min(length, static_cast<i32>(indexed_properties.array_like_size()));
+            if (element_kind != ElementKind::Any) {
+                if (!search_element.is_number() || (element_kind == ElementKind::Int32 && !search_element.is_integer()))
+                    return Value(-1);
+                auto number = search_element.as_double();
+                for (i32 i = from_index; i < end; ++i) {
+                    if (elements->at(i).as_double() == number)
+                        return Value(i);
+                }
+                return Value(-1);
+            }
+            for (i32 i = from_index; i < end; ++i) {
+                if (strict_eq(interpreter, elements->at(i), search_element))
+                    return Value(i);
+            }
+            return Value(-1);
+        }
+    }
     for (i32 i = from_index; i < length; ++i) {
         auto element = this_object->get(i);
         if (interpreter.exception())
@@ -47,6 +47,8 @@ ConsoleObject::ConsoleObject()
     define_native_function("count", count);
     define_native_function("countReset", count_reset);
     define_native_function("clear", clear);
+    define_native_function("profile", profile);
+    define_native_function("profileEnd", profile_end);
 }
 
 ConsoleObject::~ConsoleObject()
@@ -98,4 +100,14 @@ Value ConsoleObject::clear(Interpreter& interpreter)
     return interpreter.console().clear();
 }
 
+Value ConsoleObject::profile(Interpreter& interpreter)
+{
+    return interpreter.console().profile();
+}
+
+Value ConsoleObject::profile_end(Interpreter& interpreter)
+{
+    return interpreter.console().profile_end();
+}
+
 }
@@ -29,6 +29,8 @@
 #include <AK/String.h>
 #include <LibJS/Heap/Heap.h>
 #include <LibJS/Interpreter.h>
+#include <LibJS/Runtime/ArrayBufferConstructor.h>
+#include <LibJS/Runtime/ArrayBufferPrototype.h>
 #include <LibJS/Runtime/ArrayConstructor.h>
 #include <LibJS/Runtime/ArrayPrototype.h>
 #include <LibJS/Runtime/BooleanConstructor.h>
@@ -52,10 +54,14 @@
 #include <LibJS/Runtime/ObjectPrototype.h>
 #include <LibJS/Runtime/ReflectObject.h>
 #include <LibJS/Runtime/Shape.h>
+#include <LibJS/Runtime/RegExpConstructor.h>
+#include <LibJS/Runtime/RegExpPrototype.h>
 #include <LibJS/Runtime/StringConstructor.h>
 #include <LibJS/Runtime/StringPrototype.h>
 #include <LibJS/Runtime/SymbolConstructor.h>
 #include <LibJS/Runtime/SymbolPrototype.h>
+#include <LibJS/Runtime/TypedArrayConstructor.h>
+#include <LibJS/Runtime/TypedArrayPrototype.h>
 #include <LibJS/Runtime/Value.h>
 
 namespace JS {
@@ -81,8 +87,16 @@ void GlobalObject::initialize()
     JS_ENUMERATE_BUILTIN_TYPES
 #undef __JS_ENUMERATE
 
+    m_typed_array_prototype = heap().allocate<TypedArrayPrototype>();
+
+#define __JS_ENUMERATE(ClassName, snake_name, PrototypeName, ConstructorName, ArrayType) \
+    m_##snake_name##_prototype = heap().allocate<PrototypeName>();
+    JS_ENUMERATE_TYPED_ARRAYS
+#undef __JS_ENUMERATE
+
     u8 attr = Attribute::Writable | Attribute::Configurable;
     define_native_function("gc", gc, 0, attr);
+    get("gc").as_object().define_native_function("stats", gc_stats, 0, attr);
     define_native_function("isNaN", is_nan, 1, attr);
     define_native_function("isFinite", is_finite, 1, attr);
     define_native_function("parseFloat", parse_float, 1, attr);
@@ -97,12 +111,14 @@ void GlobalObject::initialize()
     define_property("Reflect", heap().allocate<ReflectObject>(), attr);
 
     add_constructor("Array", m_array_constructor, *m_array_prototype);
+    add_constructor("ArrayBuffer", m_array_buffer_constructor, *m_array_buffer_prototype);
     add_constructor("Boolean", m_boolean_constructor, *m_boolean_prototype);
     add_constructor("Date", m_date_constructor, *m_date_prototype);
     add_constructor("Error", m_error_constructor, *m_error_prototype);
     add_constructor("Function", m_function_constructor, *m_function_prototype);
     add_constructor("Number", m_number_constructor, *m_number_prototype);
     add_constructor("Object", m_object_constructor, *m_object_prototype);
+    add_constructor("RegExp", m_regexp_constructor, *m_regexp_prototype);
     add_constructor("String", m_string_constructor, *m_string_prototype);
     add_constructor("Symbol", m_symbol_constructor, *m_symbol_prototype);
 
@@ -110,6 +126,11 @@ void GlobalObject::initialize()
     add_constructor(#ClassName, m_##snake_name##_constructor, *m_##snake_name##_prototype);
     JS_ENUMERATE_ERROR_SUBCLASSES
 #undef __JS_ENUMERATE
+
+#define __JS_ENUMERATE(ClassName, snake_name, PrototypeName, ConstructorName, ArrayType) \
+    add_constructor(#ClassName, m_##snake_name##_constructor, *m_##snake_name##_prototype);
+    JS_ENUMERATE_TYPED_ARRAYS
+#undef __JS_ENUMERATE
 }
 
 GlobalObject::~GlobalObject()
@@ -126,6 +147,13 @@ void GlobalObject::visit_children(Visitor& visitor)
     visitor.visit(m_##snake_name##_constructor);
     JS_ENUMERATE_ERROR_SUBCLASSES
 #undef __JS_ENUMERATE
+
+    visitor.visit(m_typed_array_prototype);
+
+#define __JS_ENUMERATE(ClassName, snake_name, PrototypeName, ConstructorName, ArrayType) \
+    visitor.visit(m_##snake_name##_constructor);
+    JS_ENUMERATE_TYPED_ARRAYS
+#undef __JS_ENUMERATE
 }
 
 Value GlobalObject::gc(Interpreter& interpreter)
@@ -135,6 +163,25 @@ Value GlobalObject::gc(Interpreter& interpreter)
     return js_undefined();
 }
 
+Value GlobalObject::gc_stats(Interpreter& interpreter)
+{
+    auto statistics = interpreter.heap().statistics();
+    auto* object = Object::create_empty(interpreter, interpreter.global_object());
+    object->put("collections", Value((double)statistics.collection_count));
+    object->put("lastPauseMs", Value(statistics.last_pause_ms));
+    object->put("maxPauseMs", Value(statistics.max_pause_ms));
+    object->put("totalPauseMs", Value(statistics.total_pause_ms));
+    object->put("markedBytes", Value((double)statistics.marked_bytes));
+    object->put("sweptBytes", Value((double)statistics.swept_bytes));
+    object->put("blocksFreed", Value((double)statistics.blocks_freed));
+    object->put("allocatedCells", Value((double)statistics.allocated_cells));
+    object->put("allocatedBytes", Value((double)statistics.allocated_bytes));
+    object->put("heapBytes", Value((double)statistics.heap_bytes));
+    object->put("allocatedBytesSinceLastGC", Value((double)statistics.allocated_bytes_since_last_gc));
+    object->put("thresholdBytes", Value((double)statistics.gc_threshold_bytes));
+    return object;
+}
+
 Value GlobalObject::is_nan(Interpreter& interpreter)
 {
     auto number = interpreter.argument(0).to_number(interpreter);
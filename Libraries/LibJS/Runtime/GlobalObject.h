@@ -46,6 +46,14 @@ public:
     JS_ENUMERATE_BUILTIN_TYPES
 #undef __JS_ENUMERATE
 
+    Object* typed_array_prototype() { return m_typed_array_prototype; }
+
+#define __JS_ENUMERATE(ClassName, snake_name, PrototypeName, ConstructorName, ArrayType) \
+    ConstructorName* snake_name##_constructor() { return m_##snake_name##_constructor; } \
+    Object* snake_name##_prototype() { return m_##snake_name##_prototype; }
+    JS_ENUMERATE_TYPED_ARRAYS
+#undef __JS_ENUMERATE
+
 protected:
     virtual void visit_children(Visitor&) override;
 
@@ -56,6 +64,7 @@ private:
     virtual const char* class_name() const override { return "GlobalObject"; }
 
     static Value gc(Interpreter&);
+    static Value gc_stats(Interpreter&);
     static Value is_nan(Interpreter&);
     static Value is_finite(Interpreter&);
     static Value parse_float(Interpreter&);
@@ -67,6 +76,14 @@ private:
     Object* m_##snake_name##_prototype { nullptr };
     JS_ENUMERATE_BUILTIN_TYPES
 #undef __JS_ENUMERATE
+
+    Object* m_typed_array_prototype { nullptr };
+
+#define __JS_ENUMERATE(ClassName, snake_name, PrototypeName, ConstructorName, ArrayType) \
+    ConstructorName* m_##snake_name##_constructor { nullptr };                           \
+    Object* m_##snake_name##_prototype { nullptr };
+    JS_ENUMERATE_TYPED_ARRAYS
+#undef __JS_ENUMERATE
 };
 
 template<typename ConstructorType>
@@ -33,6 +33,36 @@ SimpleIndexedPropertyStorage::SimpleIndexedPropertyStorage(Vector<Value>&& initi
     : m_array_size(initial_values.size())
     , m_packed_elements(move(initial_values))
 {
+    for (auto& value : m_packed_elements) {
+        if (value.is_empty())
+            m_has_holes = true;
+        else
+            did_store(value);
+    }
+}
+
+static ElementKind element_kind_for(Value value)
+{
+    if (!value.is_number())
+        return ElementKind::Any;
+    if (value.is_integer())
+        return ElementKind::Int32;
+    return ElementKind::Double;
+}
+
+void SimpleIndexedPropertyStorage::did_store(Value value)
+{
+    if (m_element_kind == ElementKind::Any)
+        return;
+    auto kind = element_kind_for(value);
+    if (kind > m_element_kind)
+        m_element_kind = kind;
+}
+
+void SimpleIndexedPropertyStorage::did_become_empty()
+{
+    m_element_kind = ElementKind::Int32;
+    m_has_holes = false;
 }
 
 bool SimpleIndexedPropertyStorage::has_index(u32 index) const
@@ -50,35 +80,49 @@ Optional<ValueAndAttributes> SimpleIndexedPropertyStorage::get(u32 index) const
 void SimpleIndexedPropertyStorage::put(u32 index, Value value, u8 attributes)
 {
     ASSERT(attributes == default_attributes);
-    ASSERT(index < SPARSE_ARRAY_THRESHOLD);
+    ASSERT(can_store_index(index));
 
     if (index >= m_array_size) {
+        if (index > m_array_size)
+            m_has_holes = true;
         m_array_size = index + 1;
-        if (index >= m_packed_elements.size())
-            m_packed_elements.resize(index + MIN_PACKED_RESIZE_AMOUNT >= SPARSE_ARRAY_THRESHOLD ? SPARSE_ARRAY_THRESHOLD : index + MIN_PACKED_RESIZE_AMOUNT);
+        if (index >= m_packed_elements.size()) {
+            if (index < SPARSE_ARRAY_THRESHOLD) {
+                m_packed_elements.resize(index + MIN_PACKED_RESIZE_AMOUNT >= SPARSE_ARRAY_THRESHOLD ? SPARSE_ARRAY_THRESHOLD : index + MIN_PACKED_RESIZE_AMOUNT);
+            } else {
+                m_packed_elements.grow_capacity(index + 1);
+                m_packed_elements.resize(index + 1);
+            }
+        }
     }
     m_packed_elements[index] = value;
+    did_store(value);
 }
 
 void SimpleIndexedPropertyStorage::remove(u32 index)
 {
-    if (index < m_array_size)
+    if (index < m_array_size) {
         m_packed_elements[index] = {};
+        m_has_holes = true;
+    }
 }
 
 void SimpleIndexedPropertyStorage::insert(u32 index, Value value, u8 attributes)
 {
     ASSERT(attributes == default_attributes);
-    ASSERT(index < SPARSE_ARRAY_THRESHOLD);
+    ASSERT(index <= m_array_size);
     m_array_size++;
-    ASSERT(m_array_size <= SPARSE_ARRAY_THRESHOLD);
     m_packed_elements.insert(index, value);
+    did_store(value);
 }
 
 ValueAndAttributes SimpleIndexedPropertyStorage::take_first()
 {
     m_array_size--;
-    return { m_packed_elements.take_first(), default_attributes };
+    auto first_element = m_packed_elements.take_first();
+    if (m_array_size == 0)
+        did_become_empty();
+    return { first_element, default_attributes };
 }
 
 ValueAndAttributes SimpleIndexedPropertyStorage::take_last()
@@ -86,21 +130,34 @@ ValueAndAttributes SimpleIndexedPropertyStorage::take_last()
     m_array_size--;
     auto last_element = m_packed_elements[m_array_size];
     m_packed_elements[m_array_size] = {};
+    if (m_array_size == 0)
+        did_become_empty();
     return { last_element, default_attributes };
 }
 
 void SimpleIndexedPropertyStorage::set_array_like_size(size_t new_size)
 {
-    ASSERT(new_size <= SPARSE_ARRAY_THRESHOLD);
+    ASSERT(new_size <= max(static_cast<size_t>(SPARSE_ARRAY_THRESHOLD), m_array_size));
+    if (new_size > m_array_size)
+        m_has_holes = true;
     m_array_size = new_size;
     m_packed_elements.resize(new_size);
+    if (m_array_size == 0)
+        did_become_empty();
 }
 
 GenericIndexedPropertyStorage::GenericIndexedPropertyStorage(SimpleIndexedPropertyStorage&& storage)
 {
     m_array_size = storage.array_like_size();
-    for (auto& element : move(storage.m_packed_elements))
-        m_packed_elements.append({ element, default_attributes });
+    auto& elements = storage.m_packed_elements;
+    size_t packed_size = min(elements.size(), static_cast<size_t>(SPARSE_ARRAY_THRESHOLD));
+    m_packed_elements.ensure_capacity(packed_size);
+    for (size_t i = 0; i < packed_size; ++i)
+        m_packed_elements.unchecked_append({ elements[i], default_attributes });
+    for (size_t i = packed_size; i < elements.size(); ++i) {
+        if (!elements[i].is_empty())
+            m_sparse_elements.set(i, { elements[i], default_attributes });
+    }
 }
 
 bool GenericIndexedPropertyStorage::has_index(u32 index) const
@@ -283,7 +340,7 @@ Optional<ValueAndAttributes> IndexedProperties::get(Object* this_object, u32 ind
 
 void IndexedProperties::put(Object* this_object, u32 index, Value value, u8 attributes, bool evaluate_accessors)
 {
-    if (m_storage->is_simple_storage() && (index >= SPARSE_ARRAY_THRESHOLD || attributes != default_attributes))
+    if (m_storage->is_simple_storage() && (attributes != default_attributes || !static_cast<const SimpleIndexedPropertyStorage&>(*m_storage).can_store_index(index)))
         switch_to_generic_storage();
     if (m_storage->is_simple_storage() || !evaluate_accessors) {
         m_storage->put(index, value, attributes);
@@ -312,7 +369,7 @@ bool IndexedProperties::remove(u32 index)
 
 void IndexedProperties::insert(u32 index, Value value, u8 attributes)
 {
-    if (m_storage->is_simple_storage() && (index >= SPARSE_ARRAY_THRESHOLD || attributes != default_attributes || array_like_size() == SPARSE_ARRAY_THRESHOLD))
+    if (m_storage->is_simple_storage() && (attributes != default_attributes || index > array_like_size()))
         switch_to_generic_storage();
     m_storage->insert(index, value, attributes);
 }
@@ -346,19 +403,42 @@ void IndexedProperties::append_all(Object* this_object, const IndexedProperties&
     }
 }
 
+void IndexedProperties::set_array_like_size(size_t new_size)
+{
+    if (m_storage->is_simple_storage() && new_size > max(static_cast<size_t>(SPARSE_ARRAY_THRESHOLD), array_like_size()))
+        switch_to_generic_storage();
+    m_storage->set_array_like_size(new_size);
+}
+
+const Vector<Value>* IndexedProperties::packed_elements() const
+{
+    if (!m_storage->is_simple_storage())
+        return nullptr;
+    auto& storage = static_cast<const SimpleIndexedPropertyStorage&>(*m_storage);
+    if (storage.has_holes())
+        return nullptr;
+    return &storage.elements();
+}
+
+ElementKind IndexedProperties::element_kind() const
+{
+    if (!m_storage->is_simple_storage())
+        return ElementKind::Any;
+    return static_cast<const SimpleIndexedPropertyStorage&>(*m_storage).element_kind();
+}
+
 Vector<ValueAndAttributes> IndexedProperties::values_unordered() const
 {
+    Vector<ValueAndAttributes> values;
+    values.ensure_capacity(m_storage->size());
     if (m_storage->is_simple_storage()) {
-        auto elements = static_cast<const SimpleIndexedPropertyStorage&>(*m_storage).elements();
-        Vector<ValueAndAttributes> with_attributes;
-        for (auto& value : elements)
-            with_attributes.append({ value, default_attributes });
-        return with_attributes;
+        for (auto& value : static_cast<const SimpleIndexedPropertyStorage&>(*m_storage).elements())
+            values.unchecked_append({ value, default_attributes });
+        return values;
     }
 
-    auto storage = static_cast<const GenericIndexedPropertyStorage&>(*m_storage);
-    auto values = storage.packed_elements();
-    values.ensure_capacity(values.size() + storage.sparse_elements().size());
+    auto& storage = static_cast<const GenericIndexedPropertyStorage&>(*m_storage);
+    values.append(storage.packed_elements().data(), storage.packed_elements().size());
     for (auto& entry : storage.sparse_elements())
         values.unchecked_append(entry.value);
     return values;
@@ -366,7 +446,7 @@ Vector<ValueAndAttributes> IndexedProperties::values_unordered() const
 
 void IndexedProperties::switch_to_generic_storage()
 {
-    auto storage = static_cast<const SimpleIndexedPropertyStorage&>(*m_storage);
+    auto& storage = static_cast<SimpleIndexedPropertyStorage&>(*m_storage);
     m_storage = make<GenericIndexedPropertyStorage>(move(storage));
 }
 
@@ -40,6 +40,14 @@ struct ValueAndAttributes {
     u8 attributes { default_attributes };
 };
 
+// What kind of values a simple storage holds, ordered from most to least specific.
+// The kind only ever widens as values are stored, until the storage is emptied.
+enum class ElementKind : u8 {
+    Int32,
+    Double,
+    Any,
+};
+
 class IndexedProperties;
 class IndexedPropertyIterator;
 class GenericIndexedPropertyStorage;
@@ -83,13 +91,24 @@ public:
     virtual void set_array_like_size(size_t new_size) override;
 
     virtual bool is_simple_storage() const override { return true; }
-    Vector<Value> elements() const { return m_packed_elements; }
+    const Vector<Value>& elements() const { return m_packed_elements; }
+
+    // Simple storage can grow past SPARSE_ARRAY_THRESHOLD as long as it's filled contiguously.
+    bool can_store_index(u32 index) const { return index < SPARSE_ARRAY_THRESHOLD || index <= m_array_size; }
+
+    ElementKind element_kind() const { return m_element_kind; }
+    bool has_holes() const { return m_has_holes; }
 
 private:
     friend GenericIndexedPropertyStorage;
 
+    void did_store(Value);
+    void did_become_empty();
+
     size_t m_array_size { 0 };
     Vector<Value> m_packed_elements;
+    ElementKind m_element_kind { ElementKind::Int32 };
+    bool m_has_holes { false };
 };
 
 class GenericIndexedPropertyStorage final : public IndexedPropertyStorage {
@@ -109,8 +128,8 @@ public:
     virtual size_t array_like_size() const override { return m_array_size; }
     virtual void set_array_like_size(size_t new_size) override;
 
-    Vector<ValueAndAttributes> packed_elements() const { return m_packed_elements; }
-    HashMap<u32, ValueAndAttributes> sparse_elements() const { return m_sparse_elements; }
+    const Vector<ValueAndAttributes>& packed_elements() const { return m_packed_elements; }
+    const HashMap<u32, ValueAndAttributes>& sparse_elements() const { return m_sparse_elements; }
 
 private:
     size_t m_array_size { 0 };
@@ -162,10 +181,30 @@ public:
     size_t size() const { return m_storage->size(); }
     bool is_empty() const { return size() == 0; }
     size_t array_like_size() const { return m_storage->array_like_size(); }
-    void set_array_like_size(size_t new_size) { m_storage->set_array_like_size(new_size); };
+    void set_array_like_size(size_t new_size);
+
+    // Elements of a dense array, with no holes or accessors, or nullptr if the storage is anything else.
+    // Only the first array_like_size() values are elements.
+    const Vector<Value>* packed_elements() const;
+    ElementKind element_kind() const;
 
     Vector<ValueAndAttributes> values_unordered() const;
 
+    template<typename Callback>
+    void for_each_value(Callback callback) const
+    {
+        if (m_storage->is_simple_storage()) {
+            for (auto& value : static_cast<const SimpleIndexedPropertyStorage&>(*m_storage).elements())
+                callback(value);
+            return;
+        }
+        auto& storage = static_cast<const GenericIndexedPropertyStorage&>(*m_storage);
+        for (auto& element : storage.packed_elements())
+            callback(element.value);
+        for (auto& entry : storage.sparse_elements())
+            callback(entry.value.value);
+    }
+
 private:
     void switch_to_generic_storage();
 
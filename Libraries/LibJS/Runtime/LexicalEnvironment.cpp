@@ -32,10 +32,12 @@ LexicalEnvironment::LexicalEnvironment()
 {
 }
 
-LexicalEnvironment::LexicalEnvironment(HashMap<FlyString, Variable> variables, LexicalEnvironment* parent)
+LexicalEnvironment::LexicalEnvironment(Vector<FlyString> names, Vector<Variable> variables, LexicalEnvironment* parent)
     : m_parent(parent)
+    , m_names(move(names))
     , m_variables(move(variables))
 {
+    ASSERT(m_names.size() == m_variables.size());
 }
 
 LexicalEnvironment::~LexicalEnvironment()
@@ -46,18 +48,36 @@ void LexicalEnvironment::visit_children(Visitor& visitor)
 {
     Cell::visit_children(visitor);
     visitor.visit(m_parent);
-    for (auto& it : m_variables)
-        visitor.visit(it.value.value);
+    for (auto& variable : m_variables)
+        visitor.visit(variable.value);
+}
+
+Optional<size_t> LexicalEnvironment::index_of(const FlyString& name) const
+{
+    for (size_t i = 0; i < m_names.size(); ++i) {
+        if (m_names[i] == name)
+            return i;
+    }
+    return {};
 }
 
 Optional<Variable> LexicalEnvironment::get(const FlyString& name) const
 {
-    return m_variables.get(name);
+    auto index = index_of(name);
+    if (!index.has_value())
+        return {};
+    return m_variables[index.value()];
 }
 
 void LexicalEnvironment::set(const FlyString& name, Variable variable)
 {
-    m_variables.set(name, variable);
+    auto index = index_of(name);
+    if (index.has_value()) {
+        m_variables[index.value()] = variable;
+        return;
+    }
+    m_names.append(name);
+    m_variables.append(variable);
 }
 
 }
@@ -27,7 +27,8 @@
 #pragma once
 
 #include <AK/FlyString.h>
-#include <AK/HashMap.h>
+#include <AK/Optional.h>
+#include <AK/Vector.h>
 #include <LibJS/Runtime/Cell.h>
 #include <LibJS/Runtime/Value.h>
 
@@ -38,27 +39,37 @@ struct Variable {
     DeclarationKind declaration_kind;
 };
 
+// Where a binding lives relative to the current environment: how many parents up, and
+// which slot of that environment.
+struct EnvironmentCoordinate {
+    u32 hops { 0 };
+    u32 index { 0 };
+};
+
 class LexicalEnvironment final : public Cell {
 public:
     LexicalEnvironment();
-    LexicalEnvironment(HashMap<FlyString, Variable> variables, LexicalEnvironment* parent);
+    LexicalEnvironment(Vector<FlyString> names, Vector<Variable> variables, LexicalEnvironment* parent);
     virtual ~LexicalEnvironment() override;
 
     LexicalEnvironment* parent() { return m_parent; }
 
+    size_t size() const { return m_variables.size(); }
+    Optional<size_t> index_of(const FlyString&) const;
+    const FlyString& name_at(size_t index) const { return m_names[index]; }
+    Variable& variable_at(size_t index) { return m_variables[index]; }
+
     Optional<Variable> get(const FlyString&) const;
     void set(const FlyString&, Variable);
 
-    void clear();
-
-    const HashMap<FlyString, Variable>& variables() const { return m_variables; }
-
 private:
     virtual const char* class_name() const override { return "LexicalEnvironment"; }
     virtual void visit_children(Visitor&) override;
 
     LexicalEnvironment* m_parent { nullptr };
-    HashMap<FlyString, Variable> m_variables;
+    // Environments only hold a handful of bindings, so the slots are searched linearly.
+    Vector<FlyString> m_names;
+    Vector<Variable> m_variables;
 };
 
 }
@@ -26,6 +26,7 @@
 
 #pragma once
 
+#include <AK/IntrusiveList.h>
 #include <AK/Noncopyable.h>
 #include <AK/Vector.h>
 #include <LibJS/Forward.h>
@@ -37,6 +38,8 @@ class MarkedValueList {
     AK_MAKE_NONCOPYABLE(MarkedValueList);
 
 public:
+    IntrusiveListNode m_list_node;
+
     explicit MarkedValueList(Heap&);
     MarkedValueList(MarkedValueList&&);
     ~MarkedValueList();
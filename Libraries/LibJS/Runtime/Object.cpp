@@ -34,6 +34,7 @@
 #include <LibJS/Runtime/NativeFunction.h>
 #include <LibJS/Runtime/NativeProperty.h>
 #include <LibJS/Runtime/Object.h>
+#include <LibJS/Runtime/PropertyLookupCache.h>
 #include <LibJS/Runtime/Shape.h>
 #include <LibJS/Runtime/StringObject.h>
 #include <LibJS/Runtime/Value.h>
@@ -105,6 +106,11 @@ Value Object::get_own_property(const Object& this_object, PropertyName property_
         value_here = m_storage[metadata.value().offset];
     }
 
+    return get_own_property_value(this_object, value_here);
+}
+
+Value Object::get_own_property_value(const Object& this_object, Value value_here) const
+{
     ASSERT(!value_here.is_empty());
     if (value_here.is_accessor()) {
         return value_here.as_accessor().call_getter(Value(const_cast<Object*>(this)));
@@ -536,12 +542,54 @@ bool Object::put(PropertyName property_name, Value value)
                 call_native_property_setter(const_cast<Object*>(this), value_here, value);
                 return true;
             }
+            // The nearest data property shadows any setters further up the chain.
+            break;
         }
         object = object->prototype();
     }
     return put_own_property(*this, property_string, value, default_attributes, PutOwnPropertyMode::Put);
 }
 
+Value Object::get(const FlyString& property_name, PropertyLookupCache& cache) const
+{
+    PropertyLookupCache::Hit hit;
+    if (cache.lookup(*this, hit))
+        return hit.holder->get_own_property_value(*this, hit.holder->m_storage[hit.offset]);
+
+    for (const Object* object = this; object; object = object->prototype()) {
+        auto metadata = object->shape().lookup(property_name);
+        if (!metadata.has_value())
+            continue;
+        cache.add(*this, *object, metadata.value().offset, metadata.value().attributes);
+        return object->get_own_property_value(*this, object->m_storage[metadata.value().offset]);
+    }
+    return {};
+}
+
+bool Object::put(const FlyString& property_name, Value value, PropertyLookupCache& cache)
+{
+    ASSERT(!value.is_empty());
+
+    // Only writes to an existing, writable data property of the receiver are cached.
+    auto is_plain_data = [](Value value_here) {
+        return !value_here.is_accessor() && !(value_here.is_object() && value_here.as_object().is_native_property());
+    };
+
+    PropertyLookupCache::Hit hit;
+    if (cache.lookup(*this, hit) && hit.holder == this && (hit.attributes & Attribute::Writable) && is_plain_data(m_storage[hit.offset])) {
+        m_storage[hit.offset] = value;
+        return true;
+    }
+
+    if (!put(PropertyName(property_name), value))
+        return false;
+
+    auto metadata = shape().lookup(property_name);
+    if (metadata.has_value() && (metadata.value().attributes & Attribute::Writable) && is_plain_data(m_storage[metadata.value().offset]))
+        cache.add(*this, *this, metadata.value().offset, metadata.value().attributes);
+    return true;
+}
+
 bool Object::define_native_function(const FlyString& property_name, AK::Function<Value(Interpreter&)> native_function, i32 length, u8 attribute)
 {
     auto* function = NativeFunction::create(interpreter(), interpreter().global_object(), property_name, move(native_function));
@@ -563,8 +611,9 @@ void Object::visit_children(Cell::Visitor& visitor)
     for (auto& value : m_storage)
         visitor.visit(value);
 
-    for (auto& value : m_indexed_properties.values_unordered())
-        visitor.visit(value.value);
+    m_indexed_properties.for_each_value([&](auto& value) {
+        visitor.visit(value);
+    });
 }
 
 bool Object::has_property(PropertyName property_name) const
@@ -582,7 +631,7 @@ bool Object::has_own_property(PropertyName property_name) const
 {
     auto has_indexed_property = [&](u32 index) -> bool {
         if (is_string_object())
-            return index < static_cast<const StringObject*>(this)->primitive_string().string().length();
+            return index < static_cast<const StringObject*>(this)->primitive_string().length();
         return m_indexed_properties.has_index(index);
     };
 
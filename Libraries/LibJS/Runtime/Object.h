@@ -67,6 +67,11 @@ public:
 
     bool put(PropertyName, Value);
 
+    // Named property accesses that go through an inline cache. The name must not be an
+    // array index.
+    Value get(const FlyString& property_name, PropertyLookupCache&) const;
+    bool put(const FlyString& property_name, Value, PropertyLookupCache&);
+
     Value get_own_property(const Object& this_object, PropertyName) const;
     Value get_own_properties(const Object& this_object, GetOwnPropertyMode, u8 attributes = default_attributes) const;
     Value get_own_property_descriptor(PropertyName) const;
@@ -80,15 +85,19 @@ public:
     Value delete_property(PropertyName);
 
     virtual bool is_array() const { return false; }
+    virtual bool is_array_buffer() const { return false; }
     virtual bool is_boolean() const { return false; }
     virtual bool is_date() const { return false; }
     virtual bool is_error() const { return false; }
     virtual bool is_function() const { return false; }
     virtual bool is_native_function() const { return false; }
+    virtual bool is_script_function() const { return false; }
     virtual bool is_bound_function() const { return false; }
     virtual bool is_native_property() const { return false; }
+    virtual bool is_regexp_object() const { return false; }
     virtual bool is_string_object() const { return false; }
     virtual bool is_symbol_object() const { return false; }
+    virtual bool is_typed_array() const { return false; }
 
     virtual const char* class_name() const override { return "Object"; }
     virtual void visit_children(Cell::Visitor&) override;
@@ -116,6 +125,7 @@ private:
     bool put_own_property(Object& this_object, const FlyString& property_name, Value, u8 attributes, PutOwnPropertyMode = PutOwnPropertyMode::Put, bool throw_exceptions = true);
     bool put_own_property_by_index(Object& this_object, u32 property_index, Value, u8 attributes, PutOwnPropertyMode = PutOwnPropertyMode::Put, bool throw_exceptions = true);
 
+    Value get_own_property_value(const Object& this_object, Value value_here) const;
     Value call_native_property_getter(Object* this_object, Value property) const;
     void call_native_property_setter(Object* this_object, Value property, Value) const;
 
@@ -24,14 +24,27 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <AK/StringBuilder.h>
 #include <LibJS/Heap/Heap.h>
 #include <LibJS/Interpreter.h>
 #include <LibJS/Runtime/PrimitiveString.h>
 
 namespace JS {
 
+// Below this, copying the characters is cheaper than allocating and later walking a rope.
+static constexpr size_t min_rope_length = 16;
+
 PrimitiveString::PrimitiveString(String string)
     : m_string(move(string))
+    , m_length(m_string.length())
+{
+}
+
+PrimitiveString::PrimitiveString(PrimitiveString& lhs, PrimitiveString& rhs)
+    : m_lhs(&lhs)
+    , m_rhs(&rhs)
+    , m_is_rope(true)
+    , m_length(lhs.length() + rhs.length())
 {
 }
 
@@ -39,8 +52,52 @@ PrimitiveString::~PrimitiveString()
 {
 }
 
+void PrimitiveString::visit_children(Visitor& visitor)
+{
+    Cell::visit_children(visitor);
+    if (m_is_rope) {
+        visitor.visit(m_lhs);
+        visitor.visit(m_rhs);
+    }
+}
+
+void PrimitiveString::resolve_rope() const
+{
+    ASSERT(m_is_rope);
+    StringBuilder builder(m_length);
+
+    // Ropes built by repeated += are as deep as they are long, so walk them without recursing.
+    Vector<const PrimitiveString*, 32> pieces;
+    pieces.append(m_rhs);
+    pieces.append(m_lhs);
+    while (!pieces.is_empty()) {
+        auto* piece = pieces.take_last();
+        if (piece->m_is_rope) {
+            pieces.append(piece->m_rhs);
+            pieces.append(piece->m_lhs);
+            continue;
+        }
+        builder.append(piece->m_string);
+    }
+
+    m_string = builder.to_string();
+    m_is_rope = false;
+    m_lhs = nullptr;
+    m_rhs = nullptr;
+}
+
+FlyString PrimitiveString::fly_string() const
+{
+    FlyString fly_string = string();
+    if (!fly_string.is_null())
+        m_string = *fly_string.impl();
+    return fly_string;
+}
+
 PrimitiveString* js_string(Heap& heap, String string)
 {
+    if (!string.is_null() && string.length() <= 1)
+        return heap.interned_short_string(string);
     return heap.allocate<PrimitiveString>(move(string));
 }
 
@@ -49,4 +106,19 @@ PrimitiveString* js_string(Interpreter& interpreter, String string)
     return js_string(interpreter.heap(), string);
 }
 
+PrimitiveString* js_rope_string(Interpreter& interpreter, PrimitiveString& lhs, PrimitiveString& rhs)
+{
+    if (lhs.length() == 0)
+        return &rhs;
+    if (rhs.length() == 0)
+        return &lhs;
+    if (lhs.length() + rhs.length() < min_rope_length) {
+        StringBuilder builder(lhs.length() + rhs.length());
+        builder.append(lhs.string());
+        builder.append(rhs.string());
+        return js_string(interpreter, builder.to_string());
+    }
+    return interpreter.heap().allocate<PrimitiveString>(lhs, rhs);
+}
+
 }
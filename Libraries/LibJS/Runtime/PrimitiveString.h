@@ -26,6 +26,7 @@
 
 #pragma once
 
+#include <AK/FlyString.h>
 #include <AK/String.h>
 #include <LibJS/Runtime/Cell.h>
 
@@ -34,17 +35,38 @@ namespace JS {
 class PrimitiveString final : public Cell {
 public:
     explicit PrimitiveString(String);
+    PrimitiveString(PrimitiveString& lhs, PrimitiveString& rhs);
     virtual ~PrimitiveString();
 
-    const String& string() const { return m_string; }
+    // A concatenation is kept as a rope of its two halves until the characters are needed.
+    const String& string() const
+    {
+        if (m_is_rope)
+            resolve_rope();
+        return m_string;
+    }
+
+    size_t length() const { return m_length; }
+    bool is_rope() const { return m_is_rope; }
+
+    // Interns the string and keeps the interned copy, so later uses as a property name are cheap.
+    FlyString fly_string() const;
 
 private:
     virtual const char* class_name() const override { return "PrimitiveString"; }
+    virtual void visit_children(Visitor&) override;
+
+    void resolve_rope() const;
 
-    String m_string;
+    mutable String m_string;
+    mutable PrimitiveString* m_lhs { nullptr };
+    mutable PrimitiveString* m_rhs { nullptr };
+    mutable bool m_is_rope { false };
+    size_t m_length { 0 };
 };
 
 PrimitiveString* js_string(Heap&, String);
 PrimitiveString* js_string(Interpreter&, String);
+PrimitiveString* js_rope_string(Interpreter&, PrimitiveString& lhs, PrimitiveString& rhs);
 
 }
@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <LibJS/Runtime/Object.h>
+#include <LibJS/Runtime/PropertyLookupCache.h>
+
+namespace JS {
+
+bool PropertyLookupCache::lookup(const Object& receiver, Hit& hit) const
+{
+    auto receiver_shape_id = receiver.shape().id();
+    for (size_t i = 0; i < m_entry_count; ++i) {
+        auto& entry = m_entries[i];
+        if (entry.shape_ids[0] != receiver_shape_id)
+            continue;
+        const Object* object = &receiver;
+        bool matches = true;
+        for (size_t depth = 1; depth <= entry.depth; ++depth) {
+            object = object->prototype();
+            if (!object || object->shape().id() != entry.shape_ids[depth]) {
+                matches = false;
+                break;
+            }
+        }
+        if (!matches)
+            continue;
+        hit = { object, entry.offset, entry.attributes };
+        return true;
+    }
+    return false;
+}
+
+void PropertyLookupCache::add(const Object& receiver, const Object& holder, size_t offset, u8 attributes)
+{
+    if (m_entry_count == max_entries)
+        return;
+    Entry entry;
+    entry.depth = 0;
+    entry.attributes = attributes;
+    entry.offset = offset;
+    const Object* object = &receiver;
+    for (;;) {
+        if (object->shape().is_unique())
+            return;
+        entry.shape_ids[entry.depth] = object->shape().id();
+        if (object == &holder)
+            break;
+        if (entry.depth == max_prototype_depth)
+            return;
+        object = object->prototype();
+        if (!object)
+            return;
+        ++entry.depth;
+    }
+    m_entries[m_entry_count++] = entry;
+}
+
+}
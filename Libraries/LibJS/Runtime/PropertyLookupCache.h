@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#pragma once
+
+#include <AK/Types.h>
+#include <LibJS/Forward.h>
+
+namespace JS {
+
+// An inline cache for one named property access site. Each entry remembers, for one
+// receiver shape, which object along the prototype chain holds the property and where
+// in its storage. Entries record the serial number of every shape from the receiver to
+// the holder, so matching them proves that nothing in between has gained the property.
+// Unique shapes change in place and are never cached.
+class PropertyLookupCache {
+public:
+    static constexpr size_t max_entries = 4;
+    static constexpr size_t max_prototype_depth = 2;
+
+    struct Hit {
+        const Object* holder { nullptr };
+        size_t offset { 0 };
+        u8 attributes { 0 };
+    };
+
+    bool lookup(const Object& receiver, Hit&) const;
+    void add(const Object& receiver, const Object& holder, size_t offset, u8 attributes);
+
+private:
+    struct Entry {
+        u64 shape_ids[max_prototype_depth + 1];
+        u8 depth;
+        u8 attributes;
+        u32 offset;
+    };
+
+    Entry m_entries[max_entries];
+    size_t m_entry_count { 0 };
+};
+
+}
@@ -44,7 +44,7 @@ void Reference::put(Interpreter& interpreter, Value value)
 
     if (is_local_variable() || is_global_variable()) {
         if (is_local_variable())
-            interpreter.set_variable(m_name.to_string(), value);
+            interpreter.set_variable(m_name.to_string(), value, false, m_cached_coordinate);
         else
             interpreter.global_object().put(m_name, value);
         return;
@@ -59,7 +59,10 @@ void Reference::put(Interpreter& interpreter, Value value)
     if (!object)
         return;
 
-    object->put(m_name, value);
+    if (m_property_lookup_cache)
+        object->put(m_name.as_string(), value, *m_property_lookup_cache);
+    else
+        object->put(m_name, value);
 }
 
 void Reference::throw_reference_error(Interpreter& interpreter)
@@ -85,7 +88,7 @@ Value Reference::get(Interpreter& interpreter)
     if (is_local_variable() || is_global_variable()) {
         Value value;
         if (is_local_variable())
-            value = interpreter.get_variable(m_name.to_string());
+            value = interpreter.get_variable(m_name.to_string(), m_cached_coordinate);
         else
             value = interpreter.global_object().get(m_name);
         if (interpreter.exception())
@@ -101,6 +104,8 @@ Value Reference::get(Interpreter& interpreter)
     if (!object)
         return {};
 
+    if (m_property_lookup_cache)
+        return object->get(m_name.as_string(), *m_property_lookup_cache).value_or(js_undefined());
     return object->get(m_name).value_or(js_undefined());
 }
 
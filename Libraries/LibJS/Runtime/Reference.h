@@ -26,7 +26,9 @@
 
 #pragma once
 
+#include <AK/Optional.h>
 #include <AK/String.h>
+#include <LibJS/Runtime/LexicalEnvironment.h>
 #include <LibJS/Runtime/PropertyName.h>
 #include <LibJS/Runtime/Value.h>
 
@@ -35,19 +37,21 @@ namespace JS {
 class Reference {
 public:
     Reference() {}
-    Reference(Value base, const PropertyName& name, bool strict = false)
+    Reference(Value base, const PropertyName& name, bool strict = false, PropertyLookupCache* property_lookup_cache = nullptr)
         : m_base(base)
         , m_name(name)
         , m_strict(strict)
+        , m_property_lookup_cache(property_lookup_cache)
     {
     }
 
     enum LocalVariableTag { LocalVariable };
-    Reference(LocalVariableTag, const String& name, bool strict = false)
+    Reference(LocalVariableTag, const String& name, bool strict = false, Optional<EnvironmentCoordinate>* cached_coordinate = nullptr)
         : m_base(js_null())
         , m_name(name)
         , m_strict(strict)
         , m_local_variable(true)
+        , m_cached_coordinate(cached_coordinate)
     {
     }
 
@@ -96,6 +100,8 @@ private:
     bool m_strict { false };
     bool m_local_variable { false };
     bool m_global_variable { false };
+    Optional<EnvironmentCoordinate>* m_cached_coordinate { nullptr };
+    PropertyLookupCache* m_property_lookup_cache { nullptr };
 };
 
 const LogStream& operator<<(const LogStream&, const Value&);
@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <LibJS/Interpreter.h>
+#include <LibJS/Runtime/Error.h>
+#include <LibJS/Runtime/GlobalObject.h>
+#include <LibJS/Runtime/RegExpConstructor.h>
+#include <LibJS/Runtime/RegExpObject.h>
+
+namespace JS {
+
+RegExpConstructor::RegExpConstructor()
+    : NativeFunction("RegExp", *interpreter().global_object().function_prototype())
+{
+    define_property("prototype", interpreter().global_object().regexp_prototype(), 0);
+    define_property("length", Value(2), Attribute::Configurable);
+}
+
+RegExpConstructor::~RegExpConstructor()
+{
+}
+
+Value RegExpConstructor::call(Interpreter& interpreter)
+{
+    auto pattern = interpreter.argument(0);
+    if (pattern.is_object() && pattern.as_object().is_regexp_object() && interpreter.argument(1).is_undefined())
+        return pattern;
+    return construct(interpreter);
+}
+
+Value RegExpConstructor::construct(Interpreter& interpreter)
+{
+    auto pattern_value = interpreter.argument(0);
+    auto flags_value = interpreter.argument(1);
+
+    String source;
+    String flags;
+    if (pattern_value.is_object() && pattern_value.as_object().is_regexp_object()) {
+        auto& regexp = static_cast<RegExpObject&>(pattern_value.as_object());
+        source = regexp.pattern().source();
+        flags = regexp.flags();
+    } else if (!pattern_value.is_undefined()) {
+        source = pattern_value.to_string(interpreter);
+        if (interpreter.exception())
+            return {};
+    }
+    if (!flags_value.is_undefined()) {
+        flags = flags_value.to_string(interpreter);
+        if (interpreter.exception())
+            return {};
+    }
+
+    if (!RegExpObject::are_valid_flags(flags))
+        return interpreter.throw_exception<SyntaxError>(String::format("Invalid regular expression flags '%s'", flags.characters()));
+    auto pattern = Regex::Pattern::create(source.is_null() ? "" : source, RegExpObject::pattern_flags(flags));
+    if (!pattern->is_valid())
+        return interpreter.throw_exception<SyntaxError>(String::format("Invalid regular expression: %s", pattern->error().characters()));
+    return RegExpObject::create(interpreter.global_object(), move(pattern), flags.is_null() ? "" : flags);
+}
+
+}
@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) 2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <LibJS/Heap/Heap.h>
+#include <LibJS/Interpreter.h>
+#include <LibJS/Runtime/Array.h>
+#include <LibJS/Runtime/GlobalObject.h>
+#include <LibJS/Runtime/RegExpObject.h>
+#include <LibJS/Runtime/Value.h>
+
+namespace JS {
+
+bool RegExpObject::are_valid_flags(const StringView& flags)
+{
+    for (size_t i = 0; i < flags.length(); ++i) {
+        if (!StringView("gimsuy").contains(flags[i]))
+            return false;
+        for (size_t j = 0; j < i; ++j) {
+            if (flags[j] == flags[i])
+                return false;
+        }
+    }
+    return true;
+}
+
+u8 RegExpObject::pattern_flags(const StringView& flags)
+{
+    u8 pattern_flags = Regex::NoFlags;
+    if (flags.contains('i'))
+        pattern_flags |= Regex::CaseInsensitive;
+    if (flags.contains('m'))
+        pattern_flags |= Regex::Multiline;
+    if (flags.contains('s'))
+        pattern_flags |= Regex::DotAll;
+    return pattern_flags;
+}
+
+RegExpObject* RegExpObject::create(GlobalObject& global_object, NonnullRefPtr<Regex::Pattern> pattern, String flags)
+{
+    return global_object.heap().allocate<RegExpObject>(move(pattern), move(flags), *global_object.regexp_prototype());
+}
+
+RegExpObject::RegExpObject(NonnullRefPtr<Regex::Pattern> pattern, String flags, Object& prototype)
+    : Object(&prototype)
+    , m_pattern(move(pattern))
+    , m_flags(move(flags))
+{
+    define_property("lastIndex", Value(0), Attribute::Writable);
+}
+
+RegExpObject::~RegExpObject()
+{
+}
+
+bool RegExpObject::has_flag(char flag) const
+{
+    return m_flags.view().contains(flag);
+}
+
+Optional<Regex::Match> RegExpObject::exec(Interpreter& interpreter, const String& input)
+{
+    bool global = has_flag('g');
+    bool sticky = has_flag('y');
+
+    size_t last_index = 0;
+    if (global || sticky) {
+        auto last_index_value = get("lastIndex");
+        if (interpreter.exception())
+            return {};
+        auto number = last_index_value.to_number(interpreter);
+        if (interpreter.exception())
+            return {};
+        if (!number.is_nan() && number.as_double() > 0)
+            last_index = number.is_infinity() ? input.length() + 1 : number.to_size_t(interpreter);
+    }
+
+    Optional<Regex::Match> match;
+    if (last_index <= input.length())
+        match = sticky ? m_pattern->match_at(input, last_index) : m_pattern->search(input, last_index);
+
+    if (global || sticky) {
+        put("lastIndex", Value(match.has_value() ? (i32)match.value().end() : 0));
+        if (interpreter.exception())
+            return {};
+    }
+    return match;
+}
+
+Value RegExpObject::create_match_array(Interpreter& interpreter, const Regex::Match& match, const String& input) const
+{
+    auto& global_object = interpreter.global_object();
+    auto* array = Array::create(global_object);
+    Value groups = js_undefined();
+    auto& names = m_pattern->capture_names();
+    for (size_t i = 0; i < match.captures.size(); ++i) {
+        auto& capture = match.captures[i];
+        Value value = capture.matched ? js_string(interpreter, capture.view(input)) : js_undefined();
+        array->indexed_properties().append(value);
+        if (i < names.size() && !names[i].is_null()) {
+            if (groups.is_undefined())
+                groups = Object::create_empty(interpreter, global_object);
+            groups.as_object().put(names[i], value);
+        }
+    }
+    array->put("index", Value((i32)match.start()));
+    array->put("input", js_string(interpreter, input));
+    array->put("groups", groups);
+    return array;
+}
+
+}
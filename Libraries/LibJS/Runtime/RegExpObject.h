@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/Optional.h>
+#include <LibJS/Runtime/Object.h>
+#include <LibRegex/Pattern.h>
+
+namespace JS {
+
+class RegExpObject final : public Object {
+public:
+    // Whether `flags` only has flags we know ("gimsuy"), each at most once.
+    static bool are_valid_flags(const StringView& flags);
+    static u8 pattern_flags(const StringView& flags);
+
+    static RegExpObject* create(GlobalObject&, NonnullRefPtr<Regex::Pattern>, String flags);
+
+    RegExpObject(NonnullRefPtr<Regex::Pattern>, String flags, Object& prototype);
+    virtual ~RegExpObject() override;
+
+    const Regex::Pattern& pattern() const { return *m_pattern; }
+    const String& flags() const { return m_flags; }
+    bool has_flag(char) const;
+
+    // Matches from lastIndex if the regexp is global or sticky (and anywhere otherwise), and
+    // updates lastIndex to match, the way RegExp.prototype.exec does.
+    Optional<Regex::Match> exec(Interpreter&, const String& input);
+    Value create_match_array(Interpreter&, const Regex::Match&, const String& input) const;
+
+private:
+    virtual bool is_regexp_object() const override { return true; }
+    virtual const char* class_name() const override { return "RegExpObject"; }
+
+    NonnullRefPtr<Regex::Pattern> m_pattern;
+    String m_flags;
+};
+
+}
@@ -0,0 +1,218 @@
+/*
+ * Copyright (c) 2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/Function.h>
+#include <AK/StringBuilder.h>
+#include <LibJS/Interpreter.h>
+#include <LibJS/Runtime/Error.h>
+#include <LibJS/Runtime/GlobalObject.h>
+#include <LibJS/Runtime/RegExpObject.h>
+#include <LibJS/Runtime/RegExpPrototype.h>
+#include <LibJS/Runtime/Value.h>
+
+namespace JS {
+
+RegExpPrototype::RegExpPrototype()
+    : Object(interpreter().global_object().object_prototype())
+{
+    define_native_property("source", source_getter, nullptr, Attribute::Configurable);
+    define_native_property("flags", flags_getter, nullptr, Attribute::Configurable);
+    define_native_property("global", global_getter, nullptr, Attribute::Configurable);
+    define_native_property("ignoreCase", ignore_case_getter, nullptr, Attribute::Configurable);
+    define_native_property("multiline", multiline_getter, nullptr, Attribute::Configurable);
+    define_native_property("dotAll", dot_all_getter, nullptr, Attribute::Configurable);
+    define_native_property("unicode", unicode_getter, nullptr, Attribute::Configurable);
+    define_native_property("sticky", sticky_getter, nullptr, Attribute::Configurable);
+
+    u8 attr = Attribute::Writable | Attribute::Configurable;
+    define_native_function("exec", exec, 1, attr);
+    define_native_function("test", test, 1, attr);
+    define_native_function("toString", to_string, 0, attr);
+}
+
+RegExpPrototype::~RegExpPrototype()
+{
+}
+
+static RegExpObject* this_regexp_from_interpreter(Interpreter& interpreter)
+{
+    auto* this_object = interpreter.this_value().to_object(interpreter);
+    if (!this_object)
+        return nullptr;
+    if (!this_object->is_regexp_object()) {
+        interpreter.throw_exception<TypeError>("object must be of type RegExp");
+        return nullptr;
+    }
+    return static_cast<RegExpObject*>(this_object);
+}
+
+// The flag getters return undefined for RegExp.prototype itself, which isn't a RegExp.
+static bool this_is_regexp_prototype(Interpreter& interpreter)
+{
+    auto this_value = interpreter.this_value();
+    return this_value.is_object() && &this_value.as_object() == interpreter.global_object().regexp_prototype();
+}
+
+static Value flag_getter(Interpreter& interpreter, char flag)
+{
+    if (this_is_regexp_prototype(interpreter))
+        return js_undefined();
+    auto* regexp = this_regexp_from_interpreter(interpreter);
+    if (!regexp)
+        return {};
+    return Value(regexp->has_flag(flag));
+}
+
+static String escaped_source(const RegExpObject& regexp)
+{
+    auto& source = regexp.pattern().source();
+    if (source.is_empty())
+        return "(?:)";
+    // Escape forward slashes that aren't already, so that toString() gives a valid literal.
+    StringBuilder builder;
+    bool in_class = false;
+    for (size_t i = 0; i < source.length(); ++i) {
+        char ch = source[i];
+        if (ch == '\\' && i + 1 < source.length()) {
+            builder.append(ch);
+            builder.append(source[++i]);
+            continue;
+        }
+        if (ch == '[')
+            in_class = true;
+        else if (ch == ']')
+            in_class = false;
+        else if (ch == '/' && !in_class)
+            builder.append('\\');
+        else if (ch == '\n') {
+            builder.append("\\n");
+            continue;
+        }
+        builder.append(ch);
+    }
+    return builder.to_string();
+}
+
+// The flags in their canonical order, whichever order they were given in.
+static String canonical_flags(const RegExpObject& regexp)
+{
+    StringBuilder builder;
+    for (char flag : { 'g', 'i', 'm', 's', 'u', 'y' }) {
+        if (regexp.has_flag(flag))
+            builder.append(flag);
+    }
+    return builder.to_string();
+}
+
+Value RegExpPrototype::source_getter(Interpreter& interpreter)
+{
+    if (this_is_regexp_prototype(interpreter))
+        return js_string(interpreter, "(?:)");
+    auto* regexp = this_regexp_from_interpreter(interpreter);
+    if (!regexp)
+        return {};
+    return js_string(interpreter, escaped_source(*regexp));
+}
+
+Value RegExpPrototype::flags_getter(Interpreter& interpreter)
+{
+    auto* this_object = interpreter.this_value().to_object(interpreter);
+    if (!this_object)
+        return {};
+    if (!this_object->is_regexp_object())
+        return js_string(interpreter, "");
+    return js_string(interpreter, canonical_flags(static_cast<RegExpObject&>(*this_object)));
+}
+
+Value RegExpPrototype::global_getter(Interpreter& interpreter)
+{
+    return flag_getter(interpreter, 'g');
+}
+
+Value RegExpPrototype::ignore_case_getter(Interpreter& interpreter)
+{
+    return flag_getter(interpreter, 'i');
+}
+
+Value RegExpPrototype::multiline_getter(Interpreter& interpreter)
+{
+    return flag_getter(interpreter, 'm');
+}
+
+Value RegExpPrototype::dot_all_getter(Interpreter& interpreter)
+{
+    return flag_getter(interpreter, 's');
+}
+
+Value RegExpPrototype::unicode_getter(Interpreter& interpreter)
+{
+    return flag_getter(interpreter, 'u');
+}
+
+Value RegExpPrototype::sticky_getter(Interpreter& interpreter)
+{
+    return flag_getter(interpreter, 'y');
+}
+
+Value RegExpPrototype::exec(Interpreter& interpreter)
+{
+    auto* regexp = this_regexp_from_interpreter(interpreter);
+    if (!regexp)
+        return {};
+    auto input = interpreter.argument(0).to_string(interpreter);
+    if (interpreter.exception())
+        return {};
+    auto match = regexp->exec(interpreter, input);
+    if (interpreter.exception())
+        return {};
+    if (!match.has_value())
+        return js_null();
+    return regexp->create_match_array(interpreter, match.value(), input);
+}
+
+Value RegExpPrototype::test(Interpreter& interpreter)
+{
+    auto* regexp = this_regexp_from_interpreter(interpreter);
+    if (!regexp)
+        return {};
+    auto input = interpreter.argument(0).to_string(interpreter);
+    if (interpreter.exception())
+        return {};
+    auto match = regexp->exec(interpreter, input);
+    if (interpreter.exception())
+        return {};
+    return Value(match.has_value());
+}
+
+Value RegExpPrototype::to_string(Interpreter& interpreter)
+{
+    auto* regexp = this_regexp_from_interpreter(interpreter);
+    if (!regexp)
+        return {};
+    return js_string(interpreter, String::format("/%s/%s", escaped_source(*regexp).characters(), canonical_flags(*regexp).characters()));
+}
+
+}
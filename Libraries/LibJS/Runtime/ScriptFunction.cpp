@@ -47,12 +47,12 @@ static ScriptFunction* script_function_from(Interpreter& interpreter)
     return static_cast<ScriptFunction*>(this_object);
 }
 
-ScriptFunction* ScriptFunction::create(GlobalObject& global_object, const FlyString& name, const Statement& body, Vector<FunctionNode::Parameter> parameters, i32 m_function_length, LexicalEnvironment* parent_environment, bool is_arrow_function)
+ScriptFunction* ScriptFunction::create(GlobalObject& global_object, const FlyString& name, const FunctionBody& body, Vector<FunctionNode::Parameter> parameters, i32 m_function_length, LexicalEnvironment* parent_environment, bool is_arrow_function)
 {
     return global_object.heap().allocate<ScriptFunction>(name, body, move(parameters), m_function_length, parent_environment, *global_object.function_prototype(), is_arrow_function);
 }
 
-ScriptFunction::ScriptFunction(const FlyString& name, const Statement& body, Vector<FunctionNode::Parameter> parameters, i32 m_function_length, LexicalEnvironment* parent_environment, Object& prototype, bool is_arrow_function)
+ScriptFunction::ScriptFunction(const FlyString& name, const FunctionBody& body, Vector<FunctionNode::Parameter> parameters, i32 m_function_length, LexicalEnvironment* parent_environment, Object& prototype, bool is_arrow_function)
     : Function(prototype, is_arrow_function ? interpreter().this_value() : Value(), {})
     , m_name(name)
     , m_body(body)
@@ -77,27 +77,45 @@ void ScriptFunction::visit_children(Visitor& visitor)
     visitor.visit(m_parent_environment);
 }
 
-LexicalEnvironment* ScriptFunction::create_environment()
+void ScriptFunction::ensure_environment_names()
 {
-    HashMap<FlyString, Variable> variables;
-    for (auto& parameter : m_parameters) {
-        variables.set(parameter.name, { js_undefined(), DeclarationKind::Var });
-    }
+    if (m_has_environment_names)
+        return;
+    m_has_environment_names = true;
 
-    if (body().is_scope_node()) {
-        for (auto& declaration : static_cast<const ScopeNode&>(body()).variables()) {
-            for (auto& declarator : declaration.declarations()) {
-                variables.set(declarator.id().string(), { js_undefined(), DeclarationKind::Var });
-            }
-        }
+    // The parameters come first, followed by everything declared in the body. This waits for
+    // the first call, as that is when a lazily parsed body gets its declarations.
+    auto add_name = [&](const FlyString& name) {
+        if (!m_environment_names.contains_slow(name))
+            m_environment_names.append(name);
+    };
+    for (auto& parameter : m_parameters)
+        add_name(parameter.name);
+    auto& body = m_body->statement();
+    if (body.is_scope_node()) {
+        for (auto& name : static_cast<const ScopeNode&>(body).variable_names())
+            add_name(name);
     }
-    if (variables.is_empty())
+}
+
+LexicalEnvironment* ScriptFunction::create_environment()
+{
+    ensure_environment_names();
+    if (m_environment_names.is_empty())
         return m_parent_environment;
-    return heap().allocate<LexicalEnvironment>(move(variables), m_parent_environment);
+    Vector<Variable> variables;
+    variables.ensure_capacity(m_environment_names.size());
+    for (size_t i = 0; i < m_environment_names.size(); ++i)
+        variables.unchecked_append({ js_undefined(), DeclarationKind::Var });
+    return heap().allocate<LexicalEnvironment>(m_environment_names, move(variables), m_parent_environment);
 }
 
 Value ScriptFunction::call(Interpreter& interpreter)
 {
+    auto& body = m_body->statement();
+    if (m_body->has_syntax_error())
+        return interpreter.throw_exception<SyntaxError>(m_body->syntax_error());
+
     auto& argument_values = interpreter.call_frame().arguments;
     ArgumentVector arguments;
     for (size_t i = 0; i < m_parameters.size(); ++i) {
@@ -120,7 +138,7 @@ Value ScriptFunction::call(Interpreter& interpreter)
         arguments.append({ parameter.name, value });
         interpreter.current_environment()->set(parameter.name, { value, DeclarationKind::Var });
     }
-    return interpreter.run(m_body, arguments, ScopeType::Function);
+    return interpreter.run(body, arguments, ScopeType::Function);
 }
 
 Value ScriptFunction::construct(Interpreter& interpreter)
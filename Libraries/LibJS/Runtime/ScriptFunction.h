@@ -33,12 +33,13 @@ namespace JS {
 
 class ScriptFunction final : public Function {
 public:
-    static ScriptFunction* create(GlobalObject&, const FlyString& name, const Statement& body, Vector<FunctionNode::Parameter> parameters, i32 m_function_length, LexicalEnvironment* parent_environment, bool is_arrow_function = false);
+    static ScriptFunction* create(GlobalObject&, const FlyString& name, const FunctionBody& body, Vector<FunctionNode::Parameter> parameters, i32 m_function_length, LexicalEnvironment* parent_environment, bool is_arrow_function = false);
 
-    ScriptFunction(const FlyString& name, const Statement& body, Vector<FunctionNode::Parameter> parameters, i32 m_function_length, LexicalEnvironment* parent_environment, Object& prototype, bool is_arrow_function = false);
+    ScriptFunction(const FlyString& name, const FunctionBody& body, Vector<FunctionNode::Parameter> parameters, i32 m_function_length, LexicalEnvironment* parent_environment, Object& prototype, bool is_arrow_function = false);
     virtual ~ScriptFunction();
 
-    const Statement& body() const { return m_body; }
+    const Statement& body() const { return m_body->statement(); }
+    const FunctionBody& function_body() const { return *m_body; }
     const Vector<FunctionNode::Parameter>& parameters() const { return m_parameters; };
 
     virtual Value call(Interpreter&) override;
@@ -53,13 +54,17 @@ private:
     virtual LexicalEnvironment* create_environment() override;
     virtual void visit_children(Visitor&) override;
 
+    void ensure_environment_names();
+
     static Value length_getter(Interpreter&);
     static Value name_getter(Interpreter&);
 
     FlyString m_name;
-    NonnullRefPtr<Statement> m_body;
+    NonnullRefPtr<FunctionBody> m_body;
     const Vector<FunctionNode::Parameter> m_parameters;
     LexicalEnvironment* m_parent_environment { nullptr };
+    Vector<FlyString> m_environment_names;
+    bool m_has_environment_names { false };
     i32 m_function_length;
     bool m_is_arrow_function;
 };
@@ -29,6 +29,8 @@
 
 namespace JS {
 
+u64 Shape::s_next_id = 1;
+
 Shape* Shape::create_unique_clone() const
 {
     auto* new_shape = heap().allocate<Shape>();
@@ -82,6 +82,9 @@ public:
     Shape* create_configure_transition(const FlyString& name, u8 attributes);
     Shape* create_prototype_transition(Object* new_prototype);
 
+    // Identifies this shape for inline caches. Unlike the pointer, it is never reused.
+    u64 id() const { return m_id; }
+
     bool is_unique() const { return m_unique; }
     Shape* create_unique_clone() const;
 
@@ -111,8 +114,12 @@ private:
 
     void ensure_property_table() const;
 
+    static u64 s_next_id;
+
     mutable OwnPtr<HashMap<FlyString, PropertyMetadata>> m_property_table;
 
+    u64 m_id { s_next_id++ };
+
     HashMap<TransitionKey, Shape*> m_forward_transitions;
     Shape* m_previous { nullptr };
     FlyString m_property_name;
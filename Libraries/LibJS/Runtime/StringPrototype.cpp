@@ -29,9 +29,11 @@
 #include <AK/StringBuilder.h>
 #include <LibJS/Heap/Heap.h>
 #include <LibJS/Interpreter.h>
+#include <LibJS/Runtime/Array.h>
 #include <LibJS/Runtime/Error.h>
 #include <LibJS/Runtime/GlobalObject.h>
 #include <LibJS/Runtime/PrimitiveString.h>
+#include <LibJS/Runtime/RegExpObject.h>
 #include <LibJS/Runtime/StringObject.h>
 #include <LibJS/Runtime/StringPrototype.h>
 #include <LibJS/Runtime/Value.h>
@@ -82,6 +84,10 @@ StringPrototype::StringPrototype()
     define_native_function("includes", includes, 1, attr);
     define_native_function("slice", slice, 2, attr);
     define_native_function("lastIndexOf", last_index_of, 1, attr);
+    define_native_function("split", split, 2, attr);
+    define_native_function("match", match, 1, attr);
+    define_native_function("replace", replace, 2, attr);
+    define_native_function("search", search, 1, attr);
 }
 
 StringPrototype::~StringPrototype()
@@ -186,7 +192,7 @@ Value StringPrototype::length_getter(Interpreter& interpreter)
     auto* string_object = string_object_from(interpreter);
     if (!string_object)
         return {};
-    return Value((i32)string_object->primitive_string().string().length());
+    return Value((i32)string_object->primitive_string().length());
 }
 
 Value StringPrototype::to_string(Interpreter& interpreter)
@@ -423,4 +429,343 @@ Value StringPrototype::last_index_of(Interpreter& interpreter)
     return Value(-1);
 }
 
+static RegExpObject* regexp_from(Value value)
+{
+    if (!value.is_object() || !value.as_object().is_regexp_object())
+        return nullptr;
+    return static_cast<RegExpObject*>(&value.as_object());
+}
+
+// Turns a non-RegExp argument to match() or search() into a RegExp, like `new RegExp(value)`.
+static RegExpObject* regexp_from_argument(Interpreter& interpreter, Value value)
+{
+    if (auto* regexp = regexp_from(value))
+        return regexp;
+    String source;
+    if (!value.is_undefined()) {
+        source = value.to_string(interpreter);
+        if (interpreter.exception())
+            return nullptr;
+    }
+    auto pattern = Regex::Pattern::create(source.is_null() ? "" : source);
+    if (!pattern->is_valid()) {
+        interpreter.throw_exception<SyntaxError>(String::format("Invalid regular expression: %s", pattern->error().characters()));
+        return nullptr;
+    }
+    return RegExpObject::create(interpreter.global_object(), move(pattern), "");
+}
+
+// Where a global regexp looks for its next match once it has found `match`: right after it,
+// or one further along if it was empty so that we don't find it again.
+static size_t next_search_position(const Regex::Match& match)
+{
+    return match.length() ? match.end() : match.end() + 1;
+}
+
+Value StringPrototype::split(Interpreter& interpreter)
+{
+    auto string = string_from(interpreter);
+    if (string.is_null())
+        return {};
+
+    auto* result = Array::create(interpreter.global_object());
+    auto separator = interpreter.argument(0);
+    auto limit_value = interpreter.argument(1);
+
+    size_t limit = NumericLimits<u32>::max();
+    if (!limit_value.is_undefined()) {
+        limit = limit_value.to_size_t(interpreter);
+        if (interpreter.exception())
+            return {};
+    }
+    if (limit == 0)
+        return result;
+
+    auto append = [&](const StringView& part) {
+        result->indexed_properties().append(js_string(interpreter, part));
+        return result->indexed_properties().array_like_size() < limit;
+    };
+
+    if (separator.is_undefined()) {
+        append(string);
+        return result;
+    }
+
+    if (auto* regexp = regexp_from(separator)) {
+        auto& pattern = regexp->pattern();
+        if (string.is_empty()) {
+            if (!pattern.match_at(string, 0).has_value())
+                append(string);
+            return result;
+        }
+        size_t position = 0;
+        size_t search_position = 0;
+        while (search_position < string.length()) {
+            auto match = pattern.search(string, search_position);
+            if (!match.has_value() || match.value().start() >= string.length())
+                break;
+            // An empty match right where the last part ended doesn't separate anything.
+            if (match.value().end() == position) {
+                search_position = match.value().start() + 1;
+                continue;
+            }
+            if (!append(string.substring_view(position, match.value().start() - position)))
+                return result;
+            for (size_t i = 1; i < match.value().captures.size(); ++i) {
+                auto& capture = match.value().captures[i];
+                result->indexed_properties().append(capture.matched ? js_string(interpreter, capture.view(string)) : js_undefined());
+                if (result->indexed_properties().array_like_size() >= limit)
+                    return result;
+            }
+            position = match.value().end();
+            search_position = position;
+        }
+        append(string.substring_view(position, string.length() - position));
+        return result;
+    }
+
+    auto separator_string = separator.to_string(interpreter);
+    if (interpreter.exception())
+        return {};
+    if (separator_string.is_empty()) {
+        for (size_t i = 0; i < string.length(); ++i) {
+            if (!append(string.substring_view(i, 1)))
+                break;
+        }
+        return result;
+    }
+    size_t position = 0;
+    while (auto* found = strstr(string.characters() + position, separator_string.characters())) {
+        size_t index = found - string.characters();
+        if (!append(string.substring_view(position, index - position)))
+            return result;
+        position = index + separator_string.length();
+    }
+    append(string.substring_view(position, string.length() - position));
+    return result;
+}
+
+Value StringPrototype::match(Interpreter& interpreter)
+{
+    auto string = string_from(interpreter);
+    if (string.is_null())
+        return {};
+    auto* regexp = regexp_from_argument(interpreter, interpreter.argument(0));
+    if (!regexp)
+        return {};
+
+    if (!regexp->has_flag('g')) {
+        auto match = regexp->exec(interpreter, string);
+        if (interpreter.exception())
+            return {};
+        if (!match.has_value())
+            return js_null();
+        return regexp->create_match_array(interpreter, match.value(), string);
+    }
+
+    auto& pattern = regexp->pattern();
+    bool sticky = regexp->has_flag('y');
+    auto* result = Array::create(interpreter.global_object());
+    size_t position = 0;
+    while (position <= string.length()) {
+        auto match = sticky ? pattern.match_at(string, position) : pattern.search(string, position);
+        if (!match.has_value())
+            break;
+        result->indexed_properties().append(js_string(interpreter, match.value().captures[0].view(string)));
+        position = next_search_position(match.value());
+    }
+    regexp->put("lastIndex", Value(0));
+    if (interpreter.exception())
+        return {};
+    if (result->indexed_properties().is_empty())
+        return js_null();
+    return result;
+}
+
+Value StringPrototype::search(Interpreter& interpreter)
+{
+    auto string = string_from(interpreter);
+    if (string.is_null())
+        return {};
+    auto* regexp = regexp_from_argument(interpreter, interpreter.argument(0));
+    if (!regexp)
+        return {};
+    // Unlike exec(), search() always starts at the beginning and leaves lastIndex alone.
+    auto& pattern = regexp->pattern();
+    auto match = regexp->has_flag('y') ? pattern.match_at(string, 0) : pattern.search(string, 0);
+    if (!match.has_value())
+        return Value(-1);
+    return Value((i32)match.value().start());
+}
+
+// Expands the $ patterns of a replacement string, with `captures` being the match followed by
+// its capture groups (null for those that didn't participate).
+static String expand_replacement(const StringView& replacement, const String& string, size_t position, const Vector<String>& captures, const Vector<String>& capture_names)
+{
+    auto& matched = captures[0];
+    size_t group_count = captures.size() - 1;
+    StringBuilder builder;
+    for (size_t i = 0; i < replacement.length(); ++i) {
+        char ch = replacement[i];
+        if (ch != '$' || i + 1 == replacement.length()) {
+            builder.append(ch);
+            continue;
+        }
+        char next = replacement[i + 1];
+        if (next == '$') {
+            builder.append('$');
+            ++i;
+        } else if (next == '&') {
+            builder.append(matched);
+            ++i;
+        } else if (next == '`') {
+            builder.append(string.substring_view(0, position));
+            ++i;
+        } else if (next == '\'') {
+            size_t tail_start = min(position + matched.length(), string.length());
+            builder.append(string.substring_view(tail_start, string.length() - tail_start));
+            ++i;
+        } else if (next >= '0' && next <= '9') {
+            size_t index = next - '0';
+            size_t digits = 1;
+            if (i + 2 < replacement.length() && replacement[i + 2] >= '0' && replacement[i + 2] <= '9') {
+                size_t two_digit_index = index * 10 + (replacement[i + 2] - '0');
+                if (two_digit_index >= 1 && two_digit_index <= group_count) {
+                    index = two_digit_index;
+                    digits = 2;
+                }
+            }
+            if (index < 1 || index > group_count) {
+                builder.append(ch);
+                continue;
+            }
+            builder.append(captures[index]);
+            i += digits;
+        } else if (next == '<' && !capture_names.is_empty()) {
+            auto rest = replacement.substring_view(i + 2, replacement.length() - i - 2);
+            auto close = rest.find_first_of('>');
+            if (!close.has_value()) {
+                builder.append(ch);
+                continue;
+            }
+            auto name = rest.substring_view(0, close.value());
+            for (size_t group = 1; group < capture_names.size() && group < captures.size(); ++group) {
+                if (capture_names[group] == name) {
+                    builder.append(captures[group]);
+                    break;
+                }
+            }
+            i += close.value() + 2;
+        } else {
+            builder.append(ch);
+        }
+    }
+    return builder.to_string();
+}
+
+Value StringPrototype::replace(Interpreter& interpreter)
+{
+    auto string = string_from(interpreter);
+    if (string.is_null())
+        return {};
+    auto search_value = interpreter.argument(0);
+    auto replace_value = interpreter.argument(1);
+
+    String replacement;
+    if (!replace_value.is_function()) {
+        replacement = replace_value.to_string(interpreter);
+        if (interpreter.exception())
+            return {};
+    }
+
+    Vector<Regex::Match> matches;
+    const Vector<String>* capture_names = nullptr;
+    Vector<String> no_capture_names;
+    if (auto* regexp = regexp_from(search_value)) {
+        capture_names = &regexp->pattern().capture_names();
+        if (regexp->has_flag('g')) {
+            auto& pattern = regexp->pattern();
+            bool sticky = regexp->has_flag('y');
+            size_t position = 0;
+            while (position <= string.length()) {
+                auto match = sticky ? pattern.match_at(string, position) : pattern.search(string, position);
+                if (!match.has_value())
+                    break;
+                position = next_search_position(match.value());
+                matches.append(move(match.value()));
+            }
+            regexp->put("lastIndex", Value(0));
+            if (interpreter.exception())
+                return {};
+        } else {
+            auto match = regexp->exec(interpreter, string);
+            if (interpreter.exception())
+                return {};
+            if (match.has_value())
+                matches.append(move(match.value()));
+        }
+    } else {
+        capture_names = &no_capture_names;
+        auto search_string = search_value.to_string(interpreter);
+        if (interpreter.exception())
+            return {};
+        auto index = string.index_of(search_string);
+        if (index.has_value()) {
+            Regex::Match match;
+            match.captures.append({ index.value(), index.value() + search_string.length(), true });
+            matches.append(move(match));
+        }
+    }
+
+    if (matches.is_empty())
+        return js_string(interpreter, string);
+
+    bool has_named_captures = false;
+    for (auto& name : *capture_names) {
+        if (!name.is_null())
+            has_named_captures = true;
+    }
+
+    StringBuilder builder;
+    size_t position = 0;
+    for (auto& match : matches) {
+        Vector<String> captures;
+        for (auto& capture : match.captures)
+            captures.append(capture.matched ? String(capture.view(string)) : String());
+        if (captures[0].is_null())
+            captures[0] = String::empty();
+
+        builder.append(string.substring_view(position, match.start() - position));
+        position = match.end();
+
+        if (!replace_value.is_function()) {
+            builder.append(expand_replacement(replacement, string, match.start(), captures, has_named_captures ? *capture_names : no_capture_names));
+            continue;
+        }
+
+        MarkedValueList arguments(interpreter.heap());
+        for (auto& capture : captures)
+            arguments.append(capture.is_null() ? js_undefined() : js_string(interpreter, capture));
+        arguments.append(Value((i32)match.start()));
+        arguments.append(js_string(interpreter, string));
+        if (has_named_captures) {
+            auto* groups = Object::create_empty(interpreter, interpreter.global_object());
+            for (size_t i = 1; i < capture_names->size() && i < captures.size(); ++i) {
+                if (!capture_names->at(i).is_null())
+                    groups->put(capture_names->at(i), arguments.values()[i]);
+            }
+            arguments.append(groups);
+        }
+        auto result = interpreter.call(replace_value.as_function(), js_undefined(), move(arguments));
+        if (interpreter.exception())
+            return {};
+        auto result_string = result.to_string(interpreter);
+        if (interpreter.exception())
+            return {};
+        builder.append(result_string);
+    }
+    builder.append(string.substring_view(position, string.length() - position));
+    return js_string(interpreter, builder.to_string());
+}
+
 }
@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) 2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <AK/Assertions.h>
+#include <AK/StdLibExtras.h>
+#include <LibJS/Heap/Heap.h>
+#include <LibJS/Interpreter.h>
+#include <LibJS/Runtime/GlobalObject.h>
+#include <LibJS/Runtime/TypedArray.h>
+#include <math.h>
+
+namespace JS {
+
+TypedArrayBase::TypedArrayBase(ArrayBuffer& array_buffer, u32 byte_offset, u32 array_length, Object& prototype)
+    : Object(&prototype)
+    , m_viewed_array_buffer(&array_buffer)
+    , m_byte_offset(byte_offset)
+    , m_array_length(array_length)
+{
+}
+
+TypedArrayBase::~TypedArrayBase()
+{
+}
+
+void TypedArrayBase::visit_children(Visitor& visitor)
+{
+    Object::visit_children(visitor);
+    visitor.visit(m_viewed_array_buffer);
+}
+
+template<typename T>
+static Value element_to_value(T element)
+{
+    if constexpr (IsSame<T, ClampedU8>::value)
+        return Value(static_cast<i32>(element.value));
+    else if constexpr (IsSame<T, u32>::value || IsSame<T, float>::value || IsSame<T, double>::value)
+        return Value(static_cast<double>(element));
+    else
+        return Value(static_cast<i32>(element));
+}
+
+template<typename T>
+static T element_from_number(double number)
+{
+    if constexpr (IsSame<T, float>::value || IsSame<T, double>::value) {
+        return number;
+    } else if constexpr (IsSame<T, ClampedU8>::value) {
+        if (isnan(number))
+            return { 0 };
+        // Rounds halfway cases to even, as the spec requires.
+        return { static_cast<u8>(nearbyint(clamp(number, 0.0, 255.0))) };
+    } else {
+        // Integers wrap around modulo 2^(8 * sizeof(T)), so do the math in 64 bits and truncate.
+        if (isnan(number) || isinf(number))
+            return 0;
+        return static_cast<T>(static_cast<i64>(fmod(trunc(number), 4294967296.0)));
+    }
+}
+
+template<typename T>
+Value TypedArray<T>::get_by_index(u32 property_index) const
+{
+    if (property_index >= array_length())
+        return js_undefined();
+    return element_to_value(elements()[property_index]);
+}
+
+template<typename T>
+bool TypedArray<T>::put_by_index(u32 property_index, Value value)
+{
+    auto number = value.to_double(interpreter());
+    if (interpreter().exception())
+        return false;
+    // Out of bounds writes are silently dropped, typed arrays never grow.
+    if (property_index < array_length())
+        elements()[property_index] = element_from_number<T>(number);
+    return true;
+}
+
+#define __JS_ENUMERATE(ClassName, snake_name, PrototypeName, ConstructorName, ArrayType)                                                   \
+    template class TypedArray<ArrayType>;                                                                                                  \
+    ClassName* ClassName::create(GlobalObject& global_object, u32 array_length)                                                            \
+    {                                                                                                                                      \
+        auto* array_buffer = ArrayBuffer::create(global_object, array_length * sizeof(ArrayType));                                         \
+        return create(global_object, *array_buffer, 0, array_length);                                                                      \
+    }                                                                                                                                      \
+    ClassName* ClassName::create(GlobalObject& global_object, ArrayBuffer& array_buffer, u32 byte_offset, u32 array_length)                \
+    {                                                                                                                                      \
+        ASSERT(byte_offset % sizeof(ArrayType) == 0);                                                                                      \
+        ASSERT(byte_offset + array_length * sizeof(ArrayType) <= array_buffer.byte_length());                                              \
+        return global_object.heap().allocate<ClassName>(array_buffer, byte_offset, array_length, *global_object.snake_name##_prototype()); \
+    }                                                                                                                                      \
+    ClassName::ClassName(ArrayBuffer& array_buffer, u32 byte_offset, u32 array_length, Object& prototype)                                  \
+        : TypedArray(array_buffer, byte_offset, array_length, prototype)                                                                   \
+    {                                                                                                                                      \
+    }                                                                                                                                      \
+    ClassName::~ClassName() { }                                                                                                            \
+    TypedArrayBase* ClassName::create_view(ArrayBuffer& array_buffer, u32 byte_offset, u32 array_length) const                             \
+    {                                                                                                                                      \
+        return create(interpreter().global_object(), array_buffer, byte_offset, array_length);                                             \
+    }
+
+JS_ENUMERATE_TYPED_ARRAYS
+#undef __JS_ENUMERATE
+
+}
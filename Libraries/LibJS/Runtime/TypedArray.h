@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#pragma once
+
+#include <AK/StringView.h>
+#include <LibJS/Runtime/ArrayBuffer.h>
+#include <LibJS/Runtime/Object.h>
+
+namespace JS {
+
+// Uint8ClampedArray elements are bytes, but numbers are clamped into them instead of wrapped.
+struct ClampedU8 {
+    u8 value;
+};
+
+class TypedArrayBase : public Object {
+public:
+    virtual ~TypedArrayBase() override;
+
+    ArrayBuffer& viewed_array_buffer() { return *m_viewed_array_buffer; }
+    const ArrayBuffer& viewed_array_buffer() const { return *m_viewed_array_buffer; }
+    u32 byte_offset() const { return m_byte_offset; }
+    u32 array_length() const { return m_array_length; }
+    u32 byte_length() const { return m_array_length * element_size(); }
+
+    virtual size_t element_size() const = 0;
+
+    virtual Value get_by_index(u32 property_index) const override = 0;
+    virtual bool put_by_index(u32 property_index, Value) override = 0;
+
+    // Arrays of the same type store their elements the same way, so they can be copied bytewise.
+    bool has_same_element_type_as(const TypedArrayBase& other) const { return StringView(class_name()) == other.class_name(); }
+
+    // The elements live in the viewed ArrayBuffer, so this can be handed to native code as is.
+    u8* data() { return m_viewed_array_buffer->buffer().data() + m_byte_offset; }
+    const u8* data() const { return m_viewed_array_buffer->buffer().data() + m_byte_offset; }
+
+    // Another view of the same kind onto the given buffer, used by e.g. subarray().
+    virtual TypedArrayBase* create_view(ArrayBuffer&, u32 byte_offset, u32 array_length) const = 0;
+
+protected:
+    TypedArrayBase(ArrayBuffer&, u32 byte_offset, u32 array_length, Object& prototype);
+
+private:
+    virtual bool is_typed_array() const final { return true; }
+    virtual void visit_children(Visitor&) override;
+
+    ArrayBuffer* m_viewed_array_buffer { nullptr };
+    u32 m_byte_offset { 0 };
+    u32 m_array_length { 0 };
+};
+
+template<typename T>
+class TypedArray : public TypedArrayBase {
+public:
+    using ElementType = T;
+
+    virtual size_t element_size() const override { return sizeof(T); }
+
+    virtual Value get_by_index(u32 property_index) const override;
+    virtual bool put_by_index(u32 property_index, Value) override;
+
+    T* elements() { return reinterpret_cast<T*>(data()); }
+    const T* elements() const { return reinterpret_cast<const T*>(data()); }
+
+protected:
+    TypedArray(ArrayBuffer& array_buffer, u32 byte_offset, u32 array_length, Object& prototype)
+        : TypedArrayBase(array_buffer, byte_offset, array_length, prototype)
+    {
+    }
+};
+
+#define JS_DECLARE_TYPED_ARRAY(ClassName, snake_name, PrototypeName, ConstructorName, ArrayType)             \
+    class ClassName final : public TypedArray<ArrayType> {                                                   \
+    public:                                                                                                  \
+        static ClassName* create(GlobalObject&, u32 array_length);                                           \
+        static ClassName* create(GlobalObject&, ArrayBuffer&, u32 byte_offset, u32 array_length);            \
+                                                                                                             \
+        ClassName(ArrayBuffer&, u32 byte_offset, u32 array_length, Object& prototype);                       \
+        virtual ~ClassName() override;                                                                       \
+                                                                                                             \
+        virtual TypedArrayBase* create_view(ArrayBuffer&, u32 byte_offset, u32 array_length) const override; \
+                                                                                                             \
+    private:                                                                                                 \
+        virtual const char* class_name() const override { return #ClassName; }                               \
+    };
+
+#define __JS_ENUMERATE(ClassName, snake_name, PrototypeName, ConstructorName, ArrayType) \
+    JS_DECLARE_TYPED_ARRAY(ClassName, snake_name, PrototypeName, ConstructorName, ArrayType)
+JS_ENUMERATE_TYPED_ARRAYS
+#undef __JS_ENUMERATE
+
+}
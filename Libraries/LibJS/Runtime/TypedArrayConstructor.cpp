@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) 2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <AK/NumericLimits.h>
+#include <LibJS/Interpreter.h>
+#include <LibJS/Runtime/Error.h>
+#include <LibJS/Runtime/GlobalObject.h>
+#include <LibJS/Runtime/TypedArray.h>
+#include <LibJS/Runtime/TypedArrayConstructor.h>
+#include <math.h>
+#include <string.h>
+
+namespace JS {
+
+// ToIndex() from the spec, with an upper bound so that byte lengths always fit into an i32.
+static Optional<u32> to_index(Interpreter& interpreter, Value value, u32 max_index, const char* error_message)
+{
+    auto number = value.to_double(interpreter);
+    if (interpreter.exception())
+        return {};
+    if (isnan(number))
+        number = 0;
+    number = trunc(number);
+    if (number < 0 || number > max_index) {
+        interpreter.throw_exception<RangeError>(error_message);
+        return {};
+    }
+    return static_cast<u32>(number);
+}
+
+template<typename TypedArrayType>
+static Value construct_typed_array(Interpreter& interpreter)
+{
+    constexpr u32 element_size = sizeof(typename TypedArrayType::ElementType);
+    constexpr u32 max_array_length = NumericLimits<i32>::max() / element_size;
+    auto& global_object = interpreter.global_object();
+
+    auto first_argument = interpreter.argument(0);
+    if (!first_argument.is_object()) {
+        auto array_length = to_index(interpreter, first_argument, max_array_length, "Invalid typed array length");
+        if (!array_length.has_value())
+            return {};
+        return TypedArrayType::create(global_object, array_length.value());
+    }
+
+    auto& object = first_argument.as_object();
+    if (object.is_array_buffer()) {
+        auto& array_buffer = static_cast<ArrayBuffer&>(object);
+        auto byte_offset = to_index(interpreter, interpreter.argument(1), array_buffer.byte_length(), "Invalid typed array offset");
+        if (!byte_offset.has_value())
+            return {};
+        if (byte_offset.value() % element_size != 0)
+            return interpreter.throw_exception<RangeError>("Typed array offset must be a multiple of the element size");
+        auto remaining_byte_length = array_buffer.byte_length() - byte_offset.value();
+        u32 array_length;
+        if (interpreter.argument(2).is_undefined()) {
+            if (remaining_byte_length % element_size != 0)
+                return interpreter.throw_exception<RangeError>("Array buffer length must be a multiple of the element size");
+            array_length = remaining_byte_length / element_size;
+        } else {
+            auto length = to_index(interpreter, interpreter.argument(2), remaining_byte_length / element_size, "Invalid typed array length");
+            if (!length.has_value())
+                return {};
+            array_length = length.value();
+        }
+        return TypedArrayType::create(global_object, array_buffer, byte_offset.value(), array_length);
+    }
+
+    if (object.is_typed_array()) {
+        auto& source = static_cast<TypedArrayBase&>(object);
+        if (source.array_length() > max_array_length)
+            return interpreter.throw_exception<RangeError>("Invalid typed array length");
+        auto* typed_array = TypedArrayType::create(global_object, source.array_length());
+        if (typed_array->has_same_element_type_as(source)) {
+            memcpy(typed_array->data(), source.data(), source.byte_length());
+            return typed_array;
+        }
+        for (u32 i = 0; i < source.array_length(); ++i)
+            typed_array->put_by_index(i, source.get_by_index(i));
+        return typed_array;
+    }
+
+    auto length = object.get("length").to_size_t(interpreter);
+    if (interpreter.exception())
+        return {};
+    if (length > max_array_length)
+        return interpreter.throw_exception<RangeError>("Invalid typed array length");
+    auto* typed_array = TypedArrayType::create(global_object, length);
+    for (u32 i = 0; i < length; ++i) {
+        auto value = object.get(i).value_or(js_undefined());
+        if (interpreter.exception())
+            return {};
+        typed_array->put_by_index(i, value);
+        if (interpreter.exception())
+            return {};
+    }
+    return typed_array;
+}
+
+#define __JS_ENUMERATE(ClassName, snake_name, PrototypeName, ConstructorName, ArrayType)                    \
+    ConstructorName::ConstructorName()                                                                      \
+        : NativeFunction(#ClassName, *interpreter().global_object().function_prototype())                   \
+    {                                                                                                       \
+        define_property("prototype", interpreter().global_object().snake_name##_prototype(), 0);            \
+        define_property("length", Value(3), Attribute::Configurable);                                       \
+        define_property("BYTES_PER_ELEMENT", Value(static_cast<i32>(sizeof(ArrayType))), 0);                \
+    }                                                                                                       \
+    ConstructorName::~ConstructorName() { }                                                                 \
+    Value ConstructorName::call(Interpreter& interpreter)                                                   \
+    {                                                                                                       \
+        return interpreter.throw_exception<TypeError>(#ClassName " constructor must be called with 'new'"); \
+    }                                                                                                       \
+    Value ConstructorName::construct(Interpreter& interpreter)                                              \
+    {                                                                                                       \
+        return construct_typed_array<ClassName>(interpreter);                                               \
+    }
+
+JS_ENUMERATE_TYPED_ARRAYS
+#undef __JS_ENUMERATE
+
+}
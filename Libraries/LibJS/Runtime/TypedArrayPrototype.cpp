@@ -0,0 +1,210 @@
+/*
+ * Copyright (c) 2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <AK/Function.h>
+#include <LibJS/Interpreter.h>
+#include <LibJS/Runtime/Error.h>
+#include <LibJS/Runtime/GlobalObject.h>
+#include <LibJS/Runtime/TypedArrayPrototype.h>
+#include <string.h>
+
+namespace JS {
+
+TypedArrayPrototype::TypedArrayPrototype()
+    : Object(interpreter().global_object().object_prototype())
+{
+    u8 attr = Attribute::Writable | Attribute::Configurable;
+    define_native_property("length", length_getter, nullptr, Attribute::Configurable);
+    define_native_property("byteLength", byte_length_getter, nullptr, Attribute::Configurable);
+    define_native_property("byteOffset", byte_offset_getter, nullptr, Attribute::Configurable);
+    define_native_property("buffer", buffer_getter, nullptr, Attribute::Configurable);
+    define_native_function("fill", fill, 1, attr);
+    define_native_function("set", set, 1, attr);
+    define_native_function("subarray", subarray, 2, attr);
+}
+
+TypedArrayPrototype::~TypedArrayPrototype()
+{
+}
+
+static TypedArrayBase* typed_array_from(Interpreter& interpreter)
+{
+    auto* this_object = interpreter.this_value().to_object(interpreter);
+    if (!this_object)
+        return nullptr;
+    if (!this_object->is_typed_array()) {
+        interpreter.throw_exception<TypeError>("Not a TypedArray");
+        return nullptr;
+    }
+    return static_cast<TypedArrayBase*>(this_object);
+}
+
+// Resolves a possibly negative start/end argument against the array length, like slice() does.
+static i32 relative_index(Interpreter& interpreter, size_t argument_index, i32 length, i32 default_index)
+{
+    if (interpreter.argument_count() <= argument_index || interpreter.argument(argument_index).is_undefined())
+        return default_index;
+    auto index = interpreter.argument(argument_index).to_i32(interpreter);
+    if (interpreter.exception())
+        return 0;
+    return index < 0 ? max(length + index, 0) : min(index, length);
+}
+
+Value TypedArrayPrototype::length_getter(Interpreter& interpreter)
+{
+    auto* typed_array = typed_array_from(interpreter);
+    if (!typed_array)
+        return {};
+    return Value(static_cast<i32>(typed_array->array_length()));
+}
+
+Value TypedArrayPrototype::byte_length_getter(Interpreter& interpreter)
+{
+    auto* typed_array = typed_array_from(interpreter);
+    if (!typed_array)
+        return {};
+    return Value(static_cast<i32>(typed_array->byte_length()));
+}
+
+Value TypedArrayPrototype::byte_offset_getter(Interpreter& interpreter)
+{
+    auto* typed_array = typed_array_from(interpreter);
+    if (!typed_array)
+        return {};
+    return Value(static_cast<i32>(typed_array->byte_offset()));
+}
+
+Value TypedArrayPrototype::buffer_getter(Interpreter& interpreter)
+{
+    auto* typed_array = typed_array_from(interpreter);
+    if (!typed_array)
+        return {};
+    return &typed_array->viewed_array_buffer();
+}
+
+Value TypedArrayPrototype::fill(Interpreter& interpreter)
+{
+    auto* typed_array = typed_array_from(interpreter);
+    if (!typed_array)
+        return {};
+    i32 length = typed_array->array_length();
+    auto value = interpreter.argument(0).to_number(interpreter);
+    if (interpreter.exception())
+        return {};
+    auto start = relative_index(interpreter, 1, length, 0);
+    if (interpreter.exception())
+        return {};
+    auto end = relative_index(interpreter, 2, length, length);
+    if (interpreter.exception())
+        return {};
+    for (i32 i = start; i < end; ++i)
+        typed_array->put_by_index(i, value);
+    return typed_array;
+}
+
+Value TypedArrayPrototype::set(Interpreter& interpreter)
+{
+    auto* typed_array = typed_array_from(interpreter);
+    if (!typed_array)
+        return {};
+    auto* source = interpreter.argument(0).to_object(interpreter);
+    if (!source)
+        return {};
+    auto offset = interpreter.argument(1).to_i32(interpreter);
+    if (interpreter.exception())
+        return {};
+    if (offset < 0)
+        return interpreter.throw_exception<RangeError>("Offset must not be negative");
+
+    size_t source_length;
+    if (source->is_typed_array()) {
+        source_length = static_cast<TypedArrayBase*>(source)->array_length();
+    } else {
+        source_length = source->get("length").to_size_t(interpreter);
+        if (interpreter.exception())
+            return {};
+    }
+    if (offset + source_length > typed_array->array_length())
+        return interpreter.throw_exception<RangeError>("Source is too large");
+
+    if (source->is_typed_array()) {
+        auto& source_typed_array = static_cast<TypedArrayBase&>(*source);
+        // The views may overlap if they share a buffer, hence memmove.
+        if (typed_array->has_same_element_type_as(source_typed_array)) {
+            memmove(typed_array->data() + offset * typed_array->element_size(), source_typed_array.data(), source_typed_array.byte_length());
+            return js_undefined();
+        }
+        // Read everything before writing anything, in case the views overlap. Typed array
+        // elements are always numbers, so the values don't need to be kept alive.
+        Vector<Value> values;
+        values.ensure_capacity(source_length);
+        for (size_t i = 0; i < source_length; ++i)
+            values.unchecked_append(source_typed_array.get_by_index(i));
+        for (size_t i = 0; i < source_length; ++i)
+            typed_array->put_by_index(offset + i, values[i]);
+        return js_undefined();
+    }
+
+    for (size_t i = 0; i < source_length; ++i) {
+        auto value = source->get(i).value_or(js_undefined());
+        if (interpreter.exception())
+            return {};
+        typed_array->put_by_index(offset + i, value);
+        if (interpreter.exception())
+            return {};
+    }
+    return js_undefined();
+}
+
+Value TypedArrayPrototype::subarray(Interpreter& interpreter)
+{
+    auto* typed_array = typed_array_from(interpreter);
+    if (!typed_array)
+        return {};
+    i32 length = typed_array->array_length();
+    auto begin = relative_index(interpreter, 0, length, 0);
+    if (interpreter.exception())
+        return {};
+    auto end = relative_index(interpreter, 1, length, length);
+    if (interpreter.exception())
+        return {};
+    u32 new_length = max(end - begin, 0);
+    return typed_array->create_view(typed_array->viewed_array_buffer(), typed_array->byte_offset() + begin * typed_array->element_size(), new_length);
+}
+
+#define __JS_ENUMERATE(ClassName, snake_name, PrototypeName, ConstructorName, ArrayType)     \
+    PrototypeName::PrototypeName()                                                           \
+        : Object(interpreter().global_object().typed_array_prototype())                      \
+    {                                                                                        \
+        define_property("BYTES_PER_ELEMENT", Value(static_cast<i32>(sizeof(ArrayType))), 0); \
+    }                                                                                        \
+    PrototypeName::~PrototypeName() { }
+
+JS_ENUMERATE_TYPED_ARRAYS
+#undef __JS_ENUMERATE
+
+}
@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#pragma once
+
+#include <LibJS/Runtime/TypedArray.h>
+
+namespace JS {
+
+// %TypedArray%.prototype, which all the typed array prototypes inherit from.
+class TypedArrayPrototype final : public Object {
+public:
+    TypedArrayPrototype();
+    virtual ~TypedArrayPrototype() override;
+
+private:
+    virtual const char* class_name() const override { return "TypedArrayPrototype"; }
+
+    static Value length_getter(Interpreter&);
+    static Value byte_length_getter(Interpreter&);
+    static Value byte_offset_getter(Interpreter&);
+    static Value buffer_getter(Interpreter&);
+
+    static Value fill(Interpreter&);
+    static Value set(Interpreter&);
+    static Value subarray(Interpreter&);
+};
+
+#define JS_DECLARE_TYPED_ARRAY_PROTOTYPE(ClassName, snake_name, PrototypeName, ConstructorName, ArrayType) \
+    class PrototypeName final : public Object {                                                            \
+    public:                                                                                                \
+        PrototypeName();                                                                                   \
+        virtual ~PrototypeName() override;                                                                 \
+                                                                                                           \
+    private:                                                                                               \
+        virtual const char* class_name() const override { return #PrototypeName; }                         \
+    };
+
+#define __JS_ENUMERATE(ClassName, snake_name, PrototypeName, ConstructorName, ArrayType) \
+    JS_DECLARE_TYPED_ARRAY_PROTOTYPE(ClassName, snake_name, PrototypeName, ConstructorName, ArrayType)
+JS_ENUMERATE_TYPED_ARRAYS
+#undef __JS_ENUMERATE
+
+}
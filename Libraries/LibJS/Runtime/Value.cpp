@@ -65,7 +65,7 @@ Function& Value::as_function()
 Accessor& Value::as_accessor()
 {
     ASSERT(is_accessor());
-    return static_cast<Accessor&>(*m_value.as_accessor);
+    return *pointer<Accessor>();
 }
 
 String Value::to_string_without_side_effects() const
@@ -92,7 +92,7 @@ String Value::to_string_without_side_effects() const
     }
 
     if (is_string())
-        return m_value.as_string->string();
+        return as_string().string();
 
     if (is_symbol())
         return as_symbol().to_string();
@@ -150,24 +150,26 @@ String Value::to_string(Interpreter& interpreter) const
     }
 
     ASSERT(is_string());
-    return m_value.as_string->string();
+    return as_string().string();
 }
 
 bool Value::to_boolean() const
 {
-    switch (m_type) {
+    switch (type()) {
     case Type::Boolean:
-        return m_value.as_bool;
+        return as_bool();
     case Type::Number:
+        if (is_int32())
+            return as_i32() != 0;
         if (is_nan()) {
             return false;
         }
-        return !(m_value.as_double == 0 || m_value.as_double == -0);
+        return !(as_double() == 0 || as_double() == -0);
     case Type::Null:
     case Type::Undefined:
         return false;
     case Type::String:
-        return !as_string().string().is_empty();
+        return as_string().length() != 0;
     case Type::Object:
     case Type::Symbol:
         return true;
@@ -189,16 +191,16 @@ Object* Value::to_object(Interpreter& interpreter) const
         return &const_cast<Object&>(as_object());
 
     if (is_string())
-        return StringObject::create(interpreter.global_object(), *m_value.as_string);
+        return StringObject::create(interpreter.global_object(), *pointer<PrimitiveString>());
 
     if (is_symbol())
-        return SymbolObject::create(interpreter.global_object(), *m_value.as_symbol);
+        return SymbolObject::create(interpreter.global_object(), *pointer<Symbol>());
 
     if (is_number())
-        return NumberObject::create(interpreter.global_object(), m_value.as_double);
+        return NumberObject::create(interpreter.global_object(), as_double());
 
     if (is_boolean())
-        return BooleanObject::create(interpreter.global_object(), m_value.as_bool);
+        return BooleanObject::create(interpreter.global_object(), as_bool());
 
     if (is_null() || is_undefined()) {
         interpreter.throw_exception<TypeError>("ToObject on null or undefined.");
@@ -211,7 +213,7 @@ Object* Value::to_object(Interpreter& interpreter) const
 
 Value Value::to_number(Interpreter& interpreter) const
 {
-    switch (m_type) {
+    switch (type()) {
     case Type::Empty:
     case Type::Accessor:
         ASSERT_NOT_REACHED();
@@ -221,9 +223,9 @@ Value Value::to_number(Interpreter& interpreter) const
     case Type::Null:
         return Value(0);
     case Type::Boolean:
-        return Value(m_value.as_bool ? 1 : 0);
+        return Value(as_bool() ? 1 : 0);
     case Type::Number:
-        return Value(m_value.as_double);
+        return *this;
     case Type::String: {
         auto string = as_string().string().trim_whitespace();
         if (string.is_empty())
@@ -242,7 +244,7 @@ Value Value::to_number(Interpreter& interpreter) const
         interpreter.throw_exception<TypeError>("Can't convert symbol to number");
         return {};
     case Type::Object:
-        auto primitive = m_value.as_object->to_primitive(PreferredType::Number);
+        auto primitive = pointer<Object>()->to_primitive(PreferredType::Number);
         if (interpreter.exception())
             return {};
         return primitive.to_number(interpreter);
@@ -251,11 +253,6 @@ Value Value::to_number(Interpreter& interpreter) const
     ASSERT_NOT_REACHED();
 }
 
-i32 Value::as_i32() const
-{
-    return static_cast<i32>(as_double());
-}
-
 size_t Value::as_size_t() const
 {
     ASSERT(as_double() >= 0);
@@ -298,6 +295,8 @@ size_t Value::to_size_t(Interpreter& interpreter) const
 
 Value greater_than(Interpreter& interpreter, Value lhs, Value rhs)
 {
+    if (lhs.is_int32() && rhs.is_int32())
+        return Value(lhs.as_i32() > rhs.as_i32());
     TriState relation = abstract_relation(interpreter, false, lhs, rhs);
     if (relation == TriState::Unknown)
         return Value(false);
@@ -306,6 +305,8 @@ Value greater_than(Interpreter& interpreter, Value lhs, Value rhs)
 
 Value greater_than_equals(Interpreter& interpreter, Value lhs, Value rhs)
 {
+    if (lhs.is_int32() && rhs.is_int32())
+        return Value(lhs.as_i32() >= rhs.as_i32());
     TriState relation = abstract_relation(interpreter, true, lhs, rhs);
     if (relation == TriState::Unknown || relation == TriState::True)
         return Value(false);
@@ -314,6 +315,8 @@ Value greater_than_equals(Interpreter& interpreter, Value lhs, Value rhs)
 
 Value less_than(Interpreter& interpreter, Value lhs, Value rhs)
 {
+    if (lhs.is_int32() && rhs.is_int32())
+        return Value(lhs.as_i32() < rhs.as_i32());
     TriState relation = abstract_relation(interpreter, true, lhs, rhs);
     if (relation == TriState::Unknown)
         return Value(false);
@@ -322,6 +325,8 @@ Value less_than(Interpreter& interpreter, Value lhs, Value rhs)
 
 Value less_than_equals(Interpreter& interpreter, Value lhs, Value rhs)
 {
+    if (lhs.is_int32() && rhs.is_int32())
+        return Value(lhs.as_i32() <= rhs.as_i32());
     TriState relation = abstract_relation(interpreter, false, lhs, rhs);
     if (relation == TriState::Unknown || relation == TriState::True)
         return Value(false);
@@ -443,6 +448,12 @@ Value unsigned_right_shift(Interpreter& interpreter, Value lhs, Value rhs)
 
 Value add(Interpreter& interpreter, Value lhs, Value rhs)
 {
+    if (lhs.is_int32() && rhs.is_int32()) {
+        i32 result;
+        if (!__builtin_add_overflow(lhs.as_i32(), rhs.as_i32(), &result))
+            return Value(result);
+    }
+
     auto lhs_primitive = lhs.to_primitive(interpreter);
     if (interpreter.exception())
         return {};
@@ -451,16 +462,13 @@ Value add(Interpreter& interpreter, Value lhs, Value rhs)
         return {};
 
     if (lhs_primitive.is_string() || rhs_primitive.is_string()) {
-        auto lhs_string = lhs_primitive.to_string(interpreter);
+        auto* lhs_string = lhs_primitive.to_primitive_string(interpreter);
         if (interpreter.exception())
             return {};
-        auto rhs_string = rhs_primitive.to_string(interpreter);
+        auto* rhs_string = rhs_primitive.to_primitive_string(interpreter);
         if (interpreter.exception())
             return {};
-        StringBuilder builder(lhs_string.length() + rhs_string.length());
-        builder.append(lhs_string);
-        builder.append(rhs_string);
-        return js_string(interpreter, builder.to_string());
+        return js_rope_string(interpreter, *lhs_string, *rhs_string);
     }
 
     auto lhs_number = lhs_primitive.to_number(interpreter);
@@ -474,6 +482,12 @@ Value add(Interpreter& interpreter, Value lhs, Value rhs)
 
 Value sub(Interpreter& interpreter, Value lhs, Value rhs)
 {
+    if (lhs.is_int32() && rhs.is_int32()) {
+        i32 result;
+        if (!__builtin_sub_overflow(lhs.as_i32(), rhs.as_i32(), &result))
+            return Value(result);
+    }
+
     auto lhs_number = lhs.to_number(interpreter);
     if (interpreter.exception())
         return {};
@@ -485,6 +499,13 @@ Value sub(Interpreter& interpreter, Value lhs, Value rhs)
 
 Value mul(Interpreter& interpreter, Value lhs, Value rhs)
 {
+    if (lhs.is_int32() && rhs.is_int32()) {
+        // A zero product with a negative factor is -0, which only a double can hold.
+        i32 result;
+        if (!__builtin_mul_overflow(lhs.as_i32(), rhs.as_i32(), &result) && (result != 0 || (lhs.as_i32() >= 0 && rhs.as_i32() >= 0)))
+            return Value(result);
+    }
+
     auto lhs_number = lhs.to_number(interpreter);
     if (interpreter.exception())
         return {};
@@ -617,6 +638,9 @@ bool same_value_non_numeric(Interpreter&, Value lhs, Value rhs)
 
 bool strict_eq(Interpreter& interpreter, Value lhs, Value rhs)
 {
+    if (lhs.is_int32() && rhs.is_int32())
+        return lhs.as_i32() == rhs.as_i32();
+
     if (lhs.type() != rhs.type())
         return false;
 
@@ -29,6 +29,7 @@
 #include <AK/Assertions.h>
 #include <AK/Forward.h>
 #include <AK/LogStream.h>
+#include <AK/NumericLimits.h>
 #include <AK/Types.h>
 #include <LibJS/Forward.h>
 #include <LibJS/Runtime/Symbol.h>
@@ -58,146 +59,157 @@ public:
         Number,
     };
 
-    bool is_empty() const { return m_type == Type::Empty; }
-    bool is_undefined() const { return m_type == Type::Undefined; }
-    bool is_null() const { return m_type == Type::Null; }
-    bool is_number() const { return m_type == Type::Number; }
-    bool is_string() const { return m_type == Type::String; }
-    bool is_object() const { return m_type == Type::Object; }
-    bool is_boolean() const { return m_type == Type::Boolean; }
-    bool is_symbol() const { return m_type == Type::Symbol; }
-    bool is_accessor() const { return m_type == Type::Accessor; };
+    bool is_empty() const { return has_tag(Tag::Empty); }
+    bool is_undefined() const { return has_tag(Tag::Undefined); }
+    bool is_null() const { return has_tag(Tag::Null); }
+    bool is_number() const { return !is_tagged() || has_tag(Tag::Int32); }
+    bool is_int32() const { return has_tag(Tag::Int32); }
+    bool is_string() const { return has_tag(Tag::String); }
+    bool is_object() const { return has_tag(Tag::Object); }
+    bool is_boolean() const { return has_tag(Tag::Boolean); }
+    bool is_symbol() const { return has_tag(Tag::Symbol); }
+    bool is_accessor() const { return has_tag(Tag::Accessor); };
     bool is_cell() const { return is_string() || is_accessor() || is_object(); }
     bool is_array() const;
     bool is_function() const;
 
-    bool is_nan() const { return is_number() && __builtin_isnan(as_double()); }
-    bool is_infinity() const { return is_number() && __builtin_isinf(as_double()); }
-    bool is_positive_infinity() const { return is_number() && __builtin_isinf_sign(as_double()) > 0; }
-    bool is_negative_infinity() const { return is_number() && __builtin_isinf_sign(as_double()) < 0; }
+    bool is_nan() const { return m_encoded == canonical_nan; }
+    bool is_infinity() const { return !is_tagged() && __builtin_isinf(as_double()); }
+    bool is_positive_infinity() const { return !is_tagged() && __builtin_isinf_sign(as_double()) > 0; }
+    bool is_negative_infinity() const { return !is_tagged() && __builtin_isinf_sign(as_double()) < 0; }
     bool is_positive_zero() const { return is_number() && 1.0 / as_double() == __builtin_huge_val(); }
-    bool is_negative_zero() const { return is_number() && 1.0 / as_double() == -__builtin_huge_val(); }
-    bool is_integer() const { return is_finite_number() && (i32)as_double() == as_double(); }
+    bool is_negative_zero() const { return !is_tagged() && 1.0 / as_double() == -__builtin_huge_val(); }
+    bool is_integer() const { return is_int32() || (is_finite_number() && (i32)as_double() == as_double()); }
     bool is_finite_number() const
     {
-        if (!is_number())
+        if (is_int32())
+            return true;
+        if (is_tagged())
             return false;
         auto number = as_double();
         return !__builtin_isnan(number) && !__builtin_isinf(number);
     }
 
     Value()
-        : m_type(Type::Empty)
+        : m_encoded(encode(Tag::Empty, 0))
     {
     }
 
     explicit Value(bool value)
-        : m_type(Type::Boolean)
+        : m_encoded(encode(Tag::Boolean, value))
     {
-        m_value.as_bool = value;
     }
 
     explicit Value(double value)
-        : m_type(Type::Number)
     {
-        m_value.as_double = value;
+        if (__builtin_isnan(value))
+            m_encoded = canonical_nan;
+        else
+            __builtin_memcpy(&m_encoded, &value, sizeof(value));
     }
 
     explicit Value(unsigned value)
-        : m_type(Type::Number)
     {
-        m_value.as_double = static_cast<double>(value);
+        if (value <= static_cast<unsigned>(NumericLimits<i32>::max()))
+            m_encoded = encode(Tag::Int32, value);
+        else
+            *this = Value(static_cast<double>(value));
     }
 
     explicit Value(i32 value)
-        : m_type(Type::Number)
+        : m_encoded(encode(Tag::Int32, static_cast<u32>(value)))
     {
-        m_value.as_double = value;
     }
 
     Value(Object* object)
-        : m_type(object ? Type::Object : Type::Null)
+        : m_encoded(object ? encode(Tag::Object, object) : encode(Tag::Null, 0))
     {
-        m_value.as_object = object;
     }
 
     Value(PrimitiveString* string)
-        : m_type(Type::String)
+        : m_encoded(encode(Tag::String, string))
     {
-        m_value.as_string = string;
     }
 
     Value(Symbol* symbol)
-        : m_type(Type::Symbol)
+        : m_encoded(encode(Tag::Symbol, symbol))
     {
-        m_value.as_symbol = symbol;
     }
 
     Value(Accessor* accessor)
-        : m_type(Type::Accessor)
+        : m_encoded(encode(Tag::Accessor, accessor))
     {
-        m_value.as_accessor = accessor;
     }
 
     explicit Value(Type type)
-        : m_type(type)
+        : m_encoded(encode(static_cast<Tag>(static_cast<u16>(Tag::Empty) + static_cast<u16>(type)), 0))
     {
+        ASSERT(type == Type::Empty || type == Type::Undefined || type == Type::Null);
     }
 
-    Type type() const { return m_type; }
+    Type type() const
+    {
+        if (!is_tagged())
+            return Type::Number;
+        return static_cast<Type>((m_encoded >> tag_shift) - static_cast<u16>(Tag::Empty));
+    }
 
     double as_double() const
     {
-        ASSERT(type() == Type::Number);
-        return m_value.as_double;
+        ASSERT(is_number());
+        if (is_int32())
+            return static_cast<i32>(m_encoded);
+        double value;
+        __builtin_memcpy(&value, &m_encoded, sizeof(value));
+        return value;
     }
 
     bool as_bool() const
     {
-        ASSERT(type() == Type::Boolean);
-        return m_value.as_bool;
+        ASSERT(is_boolean());
+        return m_encoded & 1;
     }
 
     Object& as_object()
     {
-        ASSERT(type() == Type::Object);
-        return *m_value.as_object;
+        ASSERT(is_object());
+        return *pointer<Object>();
     }
 
     const Object& as_object() const
     {
-        ASSERT(type() == Type::Object);
-        return *m_value.as_object;
+        ASSERT(is_object());
+        return *pointer<Object>();
     }
 
     PrimitiveString& as_string()
     {
         ASSERT(is_string());
-        return *m_value.as_string;
+        return *pointer<PrimitiveString>();
     }
 
     const PrimitiveString& as_string() const
     {
         ASSERT(is_string());
-        return *m_value.as_string;
+        return *pointer<PrimitiveString>();
     }
 
     Symbol& as_symbol()
     {
         ASSERT(is_symbol());
-        return *m_value.as_symbol;
+        return *pointer<Symbol>();
     }
 
     const Symbol& as_symbol() const
     {
         ASSERT(is_symbol());
-        return *m_value.as_symbol;
+        return *pointer<Symbol>();
     }
 
     Cell* as_cell()
     {
         ASSERT(is_cell());
-        return m_value.as_cell;
+        return pointer<Cell>();
     }
 
     String to_string_without_side_effects() const;
@@ -205,7 +217,12 @@ public:
     Function& as_function();
     Accessor& as_accessor();
 
-    i32 as_i32() const;
+    i32 as_i32() const
+    {
+        if (is_int32())
+            return static_cast<i32>(m_encoded);
+        return static_cast<i32>(as_double());
+    }
     size_t as_size_t() const;
 
     String to_string(Interpreter&) const;
@@ -225,18 +242,47 @@ public:
         return *this;
     }
 
+    // Cell pointers live in the low bits of a value, below its tag.
+    static constexpr u64 payload_mask = 0x0000ffffffffffff;
+
 private:
-    Type m_type { Type::Empty };
-
-    union {
-        bool as_bool;
-        double as_double;
-        PrimitiveString* as_string;
-        Symbol* as_symbol;
-        Object* as_object;
-        Cell* as_cell;
-        Accessor* as_accessor;
-    } m_value;
+    // Values are NaN-boxed into 64 bits. Doubles are stored as they are, except that every NaN
+    // is canonicalized to a single positive quiet NaN. That leaves all the NaNs whose top 16
+    // bits are above 0xfff0 free to hold the other types: the top 16 bits are a tag saying
+    // which type, and the low 48 bits carry a pointer, a boolean or an int32. The tags are in
+    // the same order as Type, with Int32 in the place of Number, so that type() is a subtraction.
+    enum class Tag : u16 {
+        Empty = 0xfff1,
+        Undefined,
+        Null,
+        Int32,
+        String,
+        Object,
+        Boolean,
+        Symbol,
+        Accessor,
+    };
+
+    static constexpr u64 tag_shift = 48;
+    static constexpr u64 canonical_nan = 0x7ff8000000000000;
+
+    static u64 encode(Tag tag, u64 payload) { return (static_cast<u64>(tag) << tag_shift) | payload; }
+
+    template<typename T>
+    static u64 encode(Tag tag, T* pointer)
+    {
+        auto address = reinterpret_cast<FlatPtr>(pointer);
+        ASSERT(!(static_cast<u64>(address) & ~payload_mask));
+        return encode(tag, static_cast<u64>(address));
+    }
+
+    template<typename T>
+    T* pointer() const { return reinterpret_cast<T*>(static_cast<FlatPtr>(m_encoded & payload_mask)); }
+
+    bool is_tagged() const { return (m_encoded >> tag_shift) > 0xfff0; }
+    bool has_tag(Tag tag) const { return (m_encoded >> tag_shift) == static_cast<u16>(tag); }
+
+    u64 m_encoded;
 };
 
 inline Value js_undefined()
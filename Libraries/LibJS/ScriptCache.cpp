@@ -0,0 +1,183 @@
+/*
+ * Copyright (c) 2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <AK/ByteBuffer.h>
+#include <AK/MappedFile.h>
+#include <AK/NumericLimits.h>
+#include <LibJS/ScriptCache.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace JS {
+
+static constexpr u32 script_cache_magic = 0x43534a4c; // "LJSC"
+static constexpr u32 script_cache_version = 2;
+
+// Entries store token types by number, so they go stale whenever a token type is added.
+#define __ENUMERATE_JS_TOKEN(x) +1
+static constexpr u32 token_type_count = 0 ENUMERATE_JS_TOKENS;
+#undef __ENUMERATE_JS_TOKEN
+
+// Lexing small sources is cheaper than touching the file system.
+static constexpr size_t min_source_length_to_cache = 4 * KB;
+
+struct [[gnu::packed]] ScriptCacheHeader {
+    u32 magic;
+    u32 version;
+    u32 token_type_count;
+    u32 token_count;
+    u64 source_length;
+    u64 source_hash;
+};
+
+// Tokens refer to their trivia and value by offset into the source. The trivia always ends
+// where the value starts.
+struct [[gnu::packed]] CachedToken {
+    u8 type;
+    u32 trivia_start;
+    u32 value_start;
+    u32 value_end;
+    u32 line_number;
+    u32 line_column;
+};
+
+static u64 hash_source(StringView source)
+{
+    // FNV-1a
+    u64 hash = 0xcbf29ce484222325;
+    for (size_t i = 0; i < source.length(); ++i) {
+        hash ^= static_cast<u8>(source[i]);
+        hash *= 0x100000001b3;
+    }
+    return hash;
+}
+
+ScriptCache::ScriptCache(String directory)
+    : m_directory(move(directory))
+{
+}
+
+NonnullRefPtr<TokenBuffer> ScriptCache::tokens_for(StringView source, Lexer& lexer) const
+{
+    if (source.length() < min_source_length_to_cache || source.length() > NumericLimits<u32>::max())
+        return lexer.lex_all();
+
+    auto source_hash = hash_source(source);
+    auto path = String::format("%s/%q", m_directory.characters(), source_hash);
+    if (auto tokens = load(path, source, source_hash))
+        return tokens.release_nonnull();
+
+    auto tokens = lexer.lex_all();
+    store(path, source, source_hash, tokens);
+    return tokens;
+}
+
+RefPtr<TokenBuffer> ScriptCache::load(const String& path, StringView source, u64 source_hash) const
+{
+    if (access(path.characters(), R_OK) < 0)
+        return nullptr;
+    MappedFile file(path);
+    if (!file.is_valid() || file.size() < sizeof(ScriptCacheHeader))
+        return nullptr;
+
+    auto& header = *reinterpret_cast<const ScriptCacheHeader*>(file.data());
+    if (header.magic != script_cache_magic
+        || header.version != script_cache_version
+        || header.token_type_count != token_type_count
+        || header.source_length != source.length()
+        || header.source_hash != source_hash
+        || file.size() != sizeof(ScriptCacheHeader) + header.token_count * sizeof(CachedToken))
+        return nullptr;
+
+    auto* cached_tokens = reinterpret_cast<const CachedToken*>(reinterpret_cast<const u8*>(file.data()) + sizeof(ScriptCacheHeader));
+    Vector<Token> tokens;
+    tokens.ensure_capacity(header.token_count);
+    for (size_t i = 0; i < header.token_count; ++i) {
+        auto& cached_token = cached_tokens[i];
+        if (cached_token.type >= token_type_count
+            || cached_token.trivia_start > cached_token.value_start
+            || cached_token.value_start > cached_token.value_end
+            || cached_token.value_end > source.length())
+            return nullptr;
+        tokens.unchecked_append(Token(
+            static_cast<TokenType>(cached_token.type),
+            source.substring_view(cached_token.trivia_start, cached_token.value_start - cached_token.trivia_start),
+            source.substring_view(cached_token.value_start, cached_token.value_end - cached_token.value_start),
+            cached_token.line_number,
+            cached_token.line_column));
+    }
+    if (tokens.is_empty() || tokens.last().type() != TokenType::Eof)
+        return nullptr;
+    return TokenBuffer::create(move(tokens));
+}
+
+void ScriptCache::store(const String& path, StringView source, u64 source_hash, const TokenBuffer& token_buffer) const
+{
+    if (mkdir(m_directory.characters(), 0700) < 0 && errno != EEXIST)
+        return;
+
+    auto offset_of = [&](const StringView& view) {
+        if (view.is_null())
+            return static_cast<u32>(source.length());
+        return static_cast<u32>(view.characters_without_null_termination() - source.characters_without_null_termination());
+    };
+
+    auto& tokens = token_buffer.tokens();
+    ScriptCacheHeader header { script_cache_magic, script_cache_version, token_type_count, static_cast<u32>(tokens.size()), source.length(), source_hash };
+    ByteBuffer buffer = ByteBuffer::create_uninitialized(sizeof(header) + tokens.size() * sizeof(CachedToken));
+    memcpy(buffer.data(), &header, sizeof(header));
+    auto* cached_tokens = reinterpret_cast<CachedToken*>(buffer.data() + sizeof(header));
+    for (size_t i = 0; i < tokens.size(); ++i) {
+        auto& token = tokens[i];
+        auto value_start = offset_of(token.value());
+        cached_tokens[i] = {
+            static_cast<u8>(token.type()),
+            value_start - static_cast<u32>(token.trivia().length()),
+            value_start,
+            value_start + static_cast<u32>(token.value().length()),
+            static_cast<u32>(token.line_number()),
+            static_cast<u32>(token.line_column()),
+        };
+    }
+
+    // Write to a file of our own and move it into place, so that nobody ever maps a half
+    // written entry.
+    auto temporary_path = String::format("%s.%d", path.characters(), getpid());
+    int fd = open(temporary_path.characters(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0)
+        return;
+    bool did_write = write(fd, buffer.data(), buffer.size()) == static_cast<ssize_t>(buffer.size());
+    close(fd);
+    if (!did_write || rename(temporary_path.characters(), path.characters()) < 0)
+        unlink(temporary_path.characters());
+}
+
+}
@@ -0,0 +1,37 @@
+load("test-common.js");
+
+try {
+    assert(ArrayBuffer.length === 1);
+    assert(ArrayBuffer.name === "ArrayBuffer");
+
+    var buffer = new ArrayBuffer(16);
+    assert(buffer.byteLength === 16);
+    assert(new ArrayBuffer().byteLength === 0);
+
+    var slice = buffer.slice(4, -4);
+    assert(slice instanceof ArrayBuffer);
+    assert(slice.byteLength === 8);
+    assert(buffer.slice(-2).byteLength === 2);
+    assert(buffer.slice(10, 5).byteLength === 0);
+
+    assert(ArrayBuffer.isView(new Uint8Array(buffer)));
+    assert(!ArrayBuffer.isView(buffer));
+    assert(!ArrayBuffer.isView([]));
+
+    assertThrowsError(() => {
+        ArrayBuffer(8);
+    }, {
+        error: TypeError,
+    });
+
+    assertThrowsError(() => {
+        new ArrayBuffer(-1);
+    }, {
+        error: RangeError,
+        message: "Invalid array buffer length",
+    });
+
+    console.log("PASS");
+} catch (e) {
+    console.log("FAIL: " + e);
+}
@@ -0,0 +1,50 @@
+load("test-common.js");
+
+try {
+    assert(RegExp.length === 2);
+    assert(typeof RegExp.prototype === "object");
+
+    var re = /ab+c/gi;
+    assert(re instanceof RegExp);
+    assert(re.source === "ab+c");
+    assert(re.flags === "gi");
+    assert(re.global === true);
+    assert(re.ignoreCase === true);
+    assert(re.multiline === false);
+    assert(re.lastIndex === 0);
+    assert(re.toString() === "/ab+c/gi");
+
+    assert(new RegExp("a/b").source === "a\\/b");
+    assert(new RegExp().source === "(?:)");
+    assert(new RegExp("x", "ym").flags === "my");
+    assert(RegExp.prototype.source === "(?:)");
+    assert(RegExp.prototype.global === undefined);
+
+    var copy = new RegExp(re, "m");
+    assert(copy !== re);
+    assert(copy.source === "ab+c");
+    assert(copy.flags === "m");
+    assert(RegExp(re) === re);
+
+    // A slash after a value is division, anywhere else it starts a regex literal.
+    var a = 12, g = 3;
+    assert(a / 2 / g === 2);
+    assert([/=/.source][0] === "=");
+    assert(/[/]/.test("/"));
+
+    assertThrowsError(() => {
+        new RegExp("(");
+    }, {
+        error: SyntaxError,
+    });
+    assertThrowsError(() => {
+        new RegExp("a", "gg");
+    }, {
+        error: SyntaxError,
+        message: "Invalid regular expression flags 'gg'",
+    });
+
+    console.log("PASS");
+} catch (e) {
+    console.log("FAIL: " + e);
+}
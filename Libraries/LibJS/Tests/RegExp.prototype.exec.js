@@ -0,0 +1,45 @@
+load("test-common.js");
+
+try {
+    assert(RegExp.prototype.exec.length === 1);
+
+    var match = /(\d+)-(\d+)?-(?<word>[a-z]+)/.exec("id: 12--abc!");
+    assert(match.length === 4);
+    assert(match[0] === "12--abc");
+    assert(match[1] === "12");
+    assert(match[2] === undefined);
+    assert(match[3] === "abc");
+    assert(match.index === 4);
+    assert(match.input === "id: 12--abc!");
+    assert(match.groups.word === "abc");
+    assert(/a/.exec("a").groups === undefined);
+    assert(/x/.exec("abc") === null);
+
+    var global = /o/g;
+    assert(global.exec("foo").index === 1);
+    assert(global.lastIndex === 2);
+    assert(global.exec("foo").index === 2);
+    assert(global.exec("foo") === null);
+    assert(global.lastIndex === 0);
+
+    var sticky = /a/y;
+    assert(sticky.test("ab") === true);
+    assert(sticky.test("ab") === false);
+    assert(sticky.lastIndex === 0);
+
+    assert(/^b/m.test("a\nb"));
+    assert(!/^b/.test("a\nb"));
+    assert(/a.c/s.test("a\nc"));
+    assert(/(a)\1/i.test("aA"));
+    assert(/x(?=y)/.exec("xzxy").index === 2);
+
+    assertThrowsError(() => {
+        RegExp.prototype.exec.call({}, "a");
+    }, {
+        error: TypeError,
+    });
+
+    console.log("PASS");
+} catch (e) {
+    console.log("FAIL: " + e);
+}
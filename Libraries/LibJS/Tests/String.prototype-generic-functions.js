@@ -17,6 +17,10 @@ try {
         "substring",
         "includes",
         "slice",
+        "split",
+        "match",
+        "replace",
+        "search",
     ];
 
     genericStringPrototypeFunctions.forEach(name => {
@@ -0,0 +1,23 @@
+load("test-common.js");
+
+try {
+    assert(String.prototype.match.length === 1);
+
+    var match = "hello friends".match(/fr(i)e/);
+    assert(match[0] === "frie");
+    assert(match[1] === "i");
+    assert(match.index === 6);
+    assert("hello".match(/x/) === null);
+    assert("1+1".match("1\\+").index === 0);
+
+    var all = "a1b22c333".match(/\d+/g);
+    assert(all.length === 3);
+    assert(all[0] === "1");
+    assert(all[2] === "333");
+    assert("abc".match(/(?:)/g).length === 4);
+    assert("abc".match(/x/g) === null);
+
+    console.log("PASS");
+} catch (e) {
+    console.log("FAIL: " + e);
+}
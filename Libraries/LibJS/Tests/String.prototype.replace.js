@@ -0,0 +1,28 @@
+load("test-common.js");
+
+try {
+    assert(String.prototype.replace.length === 2);
+
+    assert("aaa".replace("a", "b") === "baa");
+    assert("abc".replace("x", "y") === "abc");
+    assert("abc".replace("b", "[$&$`$'$$]") === "a[bac$]c");
+
+    assert("aaa".replace(/a/, "b") === "baa");
+    assert("aaa".replace(/a/g, "b") === "bbb");
+    assert("abc".replace(/(?:)/g, "-") === "-a-b-c-");
+    assert("John Smith".replace(/(\w+)\s(\w+)/, "$2, $1") === "Smith, John");
+    assert("abc".replace(/(b)/, "$2$1") === "a$2bc");
+    assert("2020-01-02".replace(/(?<y>\d+)-(?<m>\d+)-(?<d>\d+)/, "$<d>.$<m>.$<y>") === "02.01.2020");
+
+    assert("a1b2".replace(/\d/g, digit => digit * 2) === "a2b4");
+    assert("x-y".replace(/(\w)-(\w)/, (match, first, second, offset, string) => {
+        assert(match === "x-y");
+        assert(offset === 0);
+        assert(string === "x-y");
+        return second + "-" + first;
+    }) === "y-x");
+
+    console.log("PASS");
+} catch (e) {
+    console.log("FAIL: " + e);
+}
@@ -0,0 +1,18 @@
+load("test-common.js");
+
+try {
+    assert(String.prototype.search.length === 1);
+
+    assert("hello friends".search(/fr/) === 6);
+    assert("hello friends".search(/xyz/) === -1);
+    assert("hello".search("l+") === 2);
+
+    var re = /o/g;
+    re.lastIndex = 3;
+    assert("foo".search(re) === 1);
+    assert(re.lastIndex === 3);
+
+    console.log("PASS");
+} catch (e) {
+    console.log("FAIL: " + e);
+}
@@ -0,0 +1,28 @@
+load("test-common.js");
+
+function joined(array) {
+    return array.map(value => value === undefined ? "<undefined>" : value).join("|");
+}
+
+try {
+    assert(String.prototype.split.length === 2);
+
+    assert(joined("a,b,,c".split(",")) === "a|b||c");
+    assert(joined("abc".split("")) === "a|b|c");
+    assert(joined("abc".split()) === "abc");
+    assert(joined("a--b--c".split("--", 2)) === "a|b");
+    assert("abc".split(",", 0).length === 0);
+    assert("".split(",").length === 1);
+    assert("".split("").length === 0);
+
+    assert(joined("a1b22c333".split(/\d+/)) === "a|b|c|");
+    assert(joined("abc".split(/(?:)/)) === "a|b|c");
+    assert(joined("a, b ,c".split(/\s*,\s*/)) === "a|b|c");
+    assert(joined("a<b>c</b>".split(/<(\/)?b>/)) === "a|<undefined>|c|/|");
+    assert("".split(/x/).length === 1);
+    assert("".split(/(?:)/).length === 0);
+
+    console.log("PASS");
+} catch (e) {
+    console.log("FAIL: " + e);
+}
@@ -0,0 +1,114 @@
+load("test-common.js");
+
+try {
+    var typedArrays = [Int8Array, Uint8Array, Uint8ClampedArray, Int16Array, Uint16Array, Int32Array, Uint32Array, Float32Array, Float64Array];
+    var elementSizes = [1, 1, 1, 2, 2, 4, 4, 4, 8];
+    typedArrays.forEach((T, i) => {
+        assert(T.BYTES_PER_ELEMENT === elementSizes[i]);
+        assert(T.prototype.BYTES_PER_ELEMENT === elementSizes[i]);
+        var a = new T(4);
+        assert(a.length === 4);
+        assert(a.byteLength === 4 * elementSizes[i]);
+        assert(a.byteOffset === 0);
+        assert(a.buffer instanceof ArrayBuffer);
+        assert(a[0] === 0);
+        assert(a[4] === undefined);
+        a[1] = 42;
+        assert(a[1] === 42);
+        a[4] = 1;
+        assert(a[4] === undefined);
+        assert(a.length === 4);
+    });
+
+    var u8 = new Uint8Array([1, 2, 300, -1]);
+    assert(u8[2] === 44);
+    assert(u8[3] === 255);
+
+    var i8 = new Int8Array([127, 128, -129]);
+    assert(i8[0] === 127);
+    assert(i8[1] === -128);
+    assert(i8[2] === 127);
+
+    var u32 = new Uint32Array([-1]);
+    assert(u32[0] === 4294967295);
+
+    var clamped = new Uint8ClampedArray([300, -5, 1.5, 2.5, NaN]);
+    assert(clamped[0] === 255);
+    assert(clamped[1] === 0);
+    assert(clamped[2] === 2);
+    assert(clamped[3] === 2);
+    assert(clamped[4] === 0);
+
+    var f32 = new Float32Array([0.5, 1.1]);
+    assert(f32[0] === 0.5);
+    assert(f32[1] !== 1.1);
+    assert(Math.abs(f32[1] - 1.1) < 0.0001);
+
+    var buffer = new ArrayBuffer(8);
+    var bytes = new Uint8Array(buffer);
+    var words = new Uint16Array(buffer, 2, 2);
+    assert(words.length === 2);
+    assert(words.byteOffset === 2);
+    words[0] = 0xffff;
+    assert(bytes[2] === 255);
+    assert(bytes[3] === 255);
+    assert(bytes[4] === 0);
+    assert(words.buffer === buffer);
+
+    assertThrowsError(() => {
+        new Uint16Array(buffer, 1);
+    }, {
+        error: RangeError,
+    });
+
+    assertThrowsError(() => {
+        new Uint32Array(new ArrayBuffer(6));
+    }, {
+        error: RangeError,
+    });
+
+    assertThrowsError(() => {
+        Uint8Array(4);
+    }, {
+        error: TypeError,
+    });
+
+    var copy = new Float64Array(new Uint8Array([1, 2, 3]));
+    assert(copy.length === 3);
+    assert(copy[2] === 3);
+
+    var filled = new Int32Array(5).fill(7, 1, -1);
+    assert(filled[0] === 0);
+    assert(filled[1] === 7);
+    assert(filled[3] === 7);
+    assert(filled[4] === 0);
+
+    var target = new Uint8Array(6);
+    target.set([1, 2, 3], 2);
+    assert(target[1] === 0);
+    assert(target[2] === 1);
+    assert(target[4] === 3);
+    target.set(new Uint8Array([9, 9]));
+    assert(target[0] === 9);
+    assert(target[1] === 9);
+    target.set(new Float32Array([4.5]), 5);
+    assert(target[5] === 4);
+    assertThrowsError(() => {
+        target.set([1, 2], 5);
+    }, {
+        error: RangeError,
+    });
+
+    var sub = target.subarray(2, 5);
+    assert(sub.length === 3);
+    assert(sub.byteOffset === 2);
+    assert(sub[0] === 1);
+    sub[0] = 100;
+    assert(target[2] === 100);
+    assert(sub.buffer === target.buffer);
+    assert(target.subarray(-1).length === 1);
+
+    console.log("PASS");
+} catch (e) {
+    console.log("FAIL: " + e);
+}
@@ -0,0 +1,76 @@
+load("test-common.js");
+
+try {
+    var a = [];
+    for (var i = 0; i < 1000; ++i)
+        a.push(i);
+    assert(a.length === 1000);
+    assert(a[0] === 0);
+    assert(a[999] === 999);
+    assert(a[1000] === undefined);
+    assert(a.indexOf(500) === 500);
+    assert(a.indexOf(500.5) === -1);
+    assert(a.indexOf("500") === -1);
+    assert(a.indexOf(NaN) === -1);
+
+    var sum = 0;
+    a.forEach(function(value) { sum += value; });
+    assert(sum === 499500);
+
+    var doubled = a.map(function(value) { return value * 2; });
+    assert(doubled.length === 1000);
+    assert(doubled[999] === 1998);
+
+    a.push(0.5);
+    assert(a.indexOf(0.5) === 1000);
+    assert(a.indexOf(0) === 0);
+    a.push("x");
+    assert(a.indexOf("x") === 1001);
+    assert(a.pop() === "x");
+    assert(a.pop() === 0.5);
+    assert(a.shift() === 0);
+    assert(a.length === 999);
+    assert(a[0] === 1);
+    a.unshift(-1);
+    assert(a[0] === -1);
+    assert(a[1] === 1);
+    assert(a.length === 1000);
+
+    var holey = [];
+    for (var i = 0; i < 500; ++i)
+        holey.push(i);
+    delete holey[100];
+    assert(holey.length === 500);
+    assert(holey[100] === undefined);
+    assert(holey.indexOf(undefined) === -1);
+    assert(holey.indexOf(499) === 499);
+    var visited = 0;
+    holey.forEach(function() { ++visited; });
+    assert(visited === 499);
+    var mapped = holey.map(function(value) { return value; });
+    assert(mapped.length === 500);
+    assert(!(100 in mapped));
+    assert(mapped[499] === 499);
+
+    var sparse = [1, 2, 3];
+    sparse[100000] = 4;
+    assert(sparse.length === 100001);
+    assert(sparse[100000] === 4);
+    assert(sparse.indexOf(4) === 100000);
+
+    var big = [];
+    for (var i = 0; i < 300; ++i)
+        big.push(i);
+    Object.defineProperty(big, 250, { value: "fixed", writable: false });
+    assert(big[250] === "fixed");
+    assert(big[299] === 299);
+    assert(big.indexOf(299) === 299);
+
+    var trailing = [];
+    trailing.length = 5;
+    assert(trailing.map(function(value) { return value; }).length === 5);
+
+    console.log("PASS");
+} catch (e) {
+    console.log("FAIL: " + e);
+}
@@ -0,0 +1,58 @@
+load("test-common.js");
+
+try {
+    function neverCalled() {
+        return 1 +;
+    }
+
+    function broken() {
+        var x = ;
+    }
+    assertThrowsError(() => {
+        broken();
+    }, {
+        error: SyntaxError,
+    });
+
+    function hoisted() {
+        var a = 1;
+        if (true) {
+            var b = a + 1;
+        }
+        return a + b;
+    }
+    assert(hoisted() === 3);
+
+    function outer(x) {
+        function inner(y) {
+            return `${x}-${y}-${{ a: "}" }.a}`;
+        }
+        return inner;
+    }
+    assert(outer(1)(2) === "1-2-}");
+    assert(outer.length === 1);
+
+    function withDefaults(a, b = a * 2) {
+        return a + b;
+    }
+    assert(withDefaults(1) === 3);
+
+    (function() {
+        "use strict";
+        function f() {
+            return isStrictMode();
+        }
+        assert(f());
+    })();
+
+    var o = {
+        method() {
+            return this;
+        },
+    };
+    assert(o.method() === o);
+
+    console.log("PASS");
+} catch (e) {
+    console.log("FAIL: " + e);
+}
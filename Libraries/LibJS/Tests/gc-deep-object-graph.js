@@ -0,0 +1,19 @@
+load("test-common.js");
+
+try {
+    var head = null;
+    for (var i = 0; i < 100000; i++)
+        head = { next: head, value: i };
+
+    gc();
+
+    var length = 0;
+    for (var node = head; node; node = node.next)
+        ++length;
+    assert(length === 100000);
+    assert(head.value === 99999);
+
+    console.log("PASS");
+} catch (e) {
+    console.log("FAIL: " + e);
+}
@@ -0,0 +1,25 @@
+load("test-common.js");
+
+try {
+    assert(typeof gc.stats === "function");
+
+    var before = gc.stats();
+    gc();
+    var after = gc.stats();
+
+    assert(after.collections === before.collections + 1);
+    assert(after.lastPauseMs >= 0);
+    assert(after.maxPauseMs >= after.lastPauseMs);
+    assert(after.totalPauseMs >= after.lastPauseMs);
+    assert(after.markedBytes > 0);
+    assert(after.sweptBytes >= 0);
+    assert(after.blocksFreed >= 0);
+    assert(after.allocatedCells > before.allocatedCells);
+    assert(after.allocatedBytes >= after.allocatedCells * 16);
+    assert(after.heapBytes >= after.markedBytes);
+    assert(after.thresholdBytes >= after.markedBytes);
+
+    console.log("PASS");
+} catch (e) {
+    console.log("FAIL: " + e);
+}
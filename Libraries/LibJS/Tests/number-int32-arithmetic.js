@@ -0,0 +1,40 @@
+load("test-common.js");
+
+try {
+    var max = 2147483647;
+    var min = -2147483648;
+
+    assert(max + 1 === 2147483648);
+    assert(min - 1 === -2147483649);
+    assert(max * 2 === 4294967294);
+    assert(min * -1 === 2147483648);
+
+    var x = max;
+    x++;
+    assert(x === 2147483648);
+    var y = min;
+    y--;
+    assert(y === -2147483649);
+
+    assert(1 / (0 * -1) === -Infinity);
+    assert(1 / (-5 * 0) === -Infinity);
+    assert(1 / (5 * 0) === Infinity);
+
+    assert(0 === -0);
+    assert(1 < 2 && 2 > 1 && 2 <= 2 && 2 >= 2);
+    assert(1 === 1.0);
+    assert(3 - 5 === -2);
+
+    var sum = 0;
+    for (var i = 0; i < 1000; ++i)
+        sum += i;
+    assert(sum === 499500);
+
+    assert(isNaN(0 / 0));
+    assert(0 / 0 !== 0 / 0);
+    assert(isNaN(Math.sqrt(-1)));
+
+    console.log("PASS");
+} catch (e) {
+    console.log("FAIL: " + e);
+}
@@ -0,0 +1,41 @@
+load("test-common.js");
+
+try {
+    var s = "";
+    for (var i = 0; i < 100000; ++i)
+        s += "abc";
+    assert(s.length === 300000);
+    assert(s.charAt(0) === "a");
+    assert(s.charAt(299999) === "c");
+    assert(s.substring(3, 9) === "abcabc");
+
+    var prepended = "";
+    for (var i = 0; i < 1000; ++i)
+        prepended = i % 10 + prepended;
+    assert(prepended.length === 1000);
+    assert(prepended.charAt(0) === "9");
+    assert(prepended.charAt(999) === "0");
+
+    var left = "hello, this is a long left half ";
+    var right = "and this is the matching right half";
+    var joined = left + right;
+    assert(joined.length === left.length + right.length);
+    assert(joined === "hello, this is a long left half and this is the matching right half");
+    assert(joined + "" === joined);
+    assert("" + joined === joined);
+    assert((joined + joined).indexOf("halfhello") === left.length + right.length - 4);
+
+    var o = {};
+    o[left + right] = 1;
+    assert(o["hello, this is a long left half and this is the matching right half"] === 1);
+    assert(Object.keys(o)[0] === joined);
+
+    assert("a" + 1 + 2 === "a12");
+    assert(1 + 2 + "a" === "3a");
+    assert(!!(left + right));
+    assert(!("" + ""));
+
+    console.log("PASS");
+} catch (e) {
+    console.log("FAIL: " + e);
+}
@@ -61,6 +61,9 @@ extern "C" {
 
 double trunc(double x)
 {
+    // Anything this large is a whole number already, and wouldn't fit in an int64_t. This also passes NaN and infinity through.
+    if (!(fabs(x) < 4503599627370496.0))
+        return x;
     return (int64_t)x;
 }
 
@@ -426,6 +429,15 @@ double floor(double value)
     return ((double)intvalue == value) ? intvalue : intvalue - 1;
 }
 
+double nearbyint(double value)
+{
+    double res;
+    __asm__("frndint"
+            : "=t"(res)
+            : "0"(value));
+    return res;
+}
+
 double rint(double value)
 {
     return (int)roundf(value);
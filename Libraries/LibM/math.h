@@ -40,6 +40,9 @@ __BEGIN_DECLS
 #define M_SQRT2 1.4142135623730951
 #define M_SQRT1_2 0.7071067811865475
 
+#define isnan(x) __builtin_isnan(x)
+#define isinf(x) __builtin_isinf(x)
+
 double acos(double);
 float acosf(float);
 double asin(double);
@@ -66,6 +69,8 @@ double floor(double);
 float floorf(float);
 double round(double);
 float roundf(float);
+double trunc(double);
+double nearbyint(double);
 double fabs(double);
 float fabsf(float);
 double fmod(double, double);
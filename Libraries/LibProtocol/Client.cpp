@@ -24,7 +24,6 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
-#include <AK/SharedBuffer.h>
 #include <LibProtocol/Client.h>
 #include <LibProtocol/Download.h>
 
@@ -68,13 +67,28 @@ bool Client::stop_download(Badge<Download>, Download& download)
     return send_sync<Messages::ProtocolServer::StopDownload>(download.id())->success();
 }
 
+void Client::handle(const Messages::ProtocolClient::DownloadResponseHeaders& message)
+{
+    if (auto download = const_cast<Download*>(m_downloads.get(message.download_id()).value_or(nullptr)))
+        download->did_receive_headers({}, message.response_headers());
+}
+
+void Client::handle(const Messages::ProtocolClient::DownloadData& message)
+{
+    auto* download = const_cast<Download*>(m_downloads.get(message.download_id()).value_or(nullptr));
+    if (!download)
+        return;
+    download->did_receive_data({}, message.data());
+    // Only now that it has been dealt with, so a client that can't keep up holds the server back.
+    post_message(Messages::ProtocolServer::DidConsumeDownloadData(message.download_id(), message.data().size()));
+}
+
 void Client::handle(const Messages::ProtocolClient::DownloadFinished& message)
 {
     RefPtr<Download> download;
     if ((download = m_downloads.get(message.download_id()).value_or(nullptr))) {
-        download->did_finish({}, message.success(), message.total_size(), message.shbuf_id(), message.response_headers());
+        download->did_finish({}, message.success());
     }
-    send_sync<Messages::ProtocolServer::DisownSharedBuffer>(message.shbuf_id());
     m_downloads.remove(message.download_id());
 }
 
@@ -53,6 +53,8 @@ private:
     Client();
 
     virtual void handle(const Messages::ProtocolClient::DownloadProgress&) override;
+    virtual void handle(const Messages::ProtocolClient::DownloadResponseHeaders&) override;
+    virtual void handle(const Messages::ProtocolClient::DownloadData&) override;
     virtual void handle(const Messages::ProtocolClient::DownloadFinished&) override;
 
     HashMap<i32, RefPtr<Download>> m_downloads;
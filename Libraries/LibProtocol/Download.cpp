@@ -24,7 +24,6 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
-#include <AK/SharedBuffer.h>
 #include <LibProtocol/Client.h>
 #include <LibProtocol/Download.h>
 
@@ -41,25 +40,36 @@ bool Download::stop()
     return m_client->stop_download({}, *this);
 }
 
-void Download::did_finish(Badge<Client>, bool success, u32 total_size, i32 shbuf_id, const IPC::Dictionary& response_headers)
+void Download::did_receive_headers(Badge<Client>, const IPC::Dictionary& response_headers)
 {
-    if (!on_finish)
-        return;
-
-    ByteBuffer payload;
-    RefPtr<SharedBuffer> shared_buffer;
-    if (success && shbuf_id != -1) {
-        shared_buffer = SharedBuffer::create_from_shbuf_id(shbuf_id);
-        payload = ByteBuffer::wrap(shared_buffer->data(), total_size);
-    }
-
     // FIXME: It's a bit silly that we copy the response headers here just so we can move them into a HashMap with different traits.
-    HashMap<String, String, CaseInsensitiveStringTraits> caseless_response_headers;
+    m_response_headers.clear();
     response_headers.for_each_entry([&](auto& name, auto& value) {
-        caseless_response_headers.set(name, value);
+        m_response_headers.set(name, value);
     });
 
-    on_finish(success, payload, move(shared_buffer), caseless_response_headers);
+    if (on_headers_received)
+        on_headers_received(m_response_headers);
+}
+
+void Download::did_receive_data(Badge<Client>, const ByteBuffer& data)
+{
+    if (on_data) {
+        on_data(data);
+        return;
+    }
+    m_received_data.append(data.data(), data.size());
+}
+
+void Download::did_finish(Badge<Client>, bool success)
+{
+    if (!on_finish)
+        return;
+
+    ByteBuffer payload;
+    if (success)
+        payload = move(m_received_data);
+    on_finish(success, payload, m_response_headers);
 }
 
 void Download::did_progress(Badge<Client>, Optional<u32> total_size, u32 downloaded_size)
@@ -29,6 +29,7 @@
 #include <AK/Badge.h>
 #include <AK/ByteBuffer.h>
 #include <AK/Function.h>
+#include <AK/HashMap.h>
 #include <AK/RefCounted.h>
 #include <AK/String.h>
 #include <AK/WeakPtr.h>
@@ -48,16 +49,25 @@ public:
     int id() const { return m_download_id; }
     bool stop();
 
-    Function<void(bool success, const ByteBuffer& payload, RefPtr<SharedBuffer> payload_storage, const HashMap<String, String, CaseInsensitiveStringTraits>& response_headers)> on_finish;
+    // Called once the response headers are in, before any of the data.
+    Function<void(const HashMap<String, String, CaseInsensitiveStringTraits>& response_headers)> on_headers_received;
+    // If set, the data is handed over piece by piece as it arrives, and on_finish gets none of it.
+    Function<void(const ByteBuffer& data)> on_data;
+    Function<void(bool success, const ByteBuffer& payload, const HashMap<String, String, CaseInsensitiveStringTraits>& response_headers)> on_finish;
     Function<void(Optional<u32> total_size, u32 downloaded_size)> on_progress;
 
-    void did_finish(Badge<Client>, bool success, u32 total_size, i32 shbuf_id, const IPC::Dictionary& response_headers);
+    void did_receive_headers(Badge<Client>, const IPC::Dictionary& response_headers);
+    void did_receive_data(Badge<Client>, const ByteBuffer&);
+    void did_finish(Badge<Client>, bool success);
     void did_progress(Badge<Client>, Optional<u32> total_size, u32 downloaded_size);
 
 private:
     explicit Download(Client&, i32 download_id);
     WeakPtr<Client> m_client;
     int m_download_id { -1 };
+    HashMap<String, String, CaseInsensitiveStringTraits> m_response_headers;
+    // The data that has arrived so far, if nobody is taking it as it does.
+    ByteBuffer m_received_data;
 };
 
 }
@@ -28,6 +28,7 @@
 #include <AK/Atomic.h>
 #include <AK/StdLibExtras.h>
 #include <Kernel/Syscall.h>
+#include <errno.h>
 #include <limits.h>
 #include <pthread.h>
 #include <serenity.h>
@@ -85,6 +86,9 @@ static int create_thread(void* (*entry)(void*), void* argument, PthreadAttrImpl*
 
 static void exit_thread(void* code)
 {
+    void __malloc_thread_exit();
+    __malloc_thread_exit();
+
     syscall(SC_exit_thread, code);
     ASSERT_NOT_REACHED();
 }
@@ -167,37 +171,47 @@ int pthread_mutex_destroy(pthread_mutex_t*)
     return 0;
 }
 
+// The mutex word is 0 when unlocked, 1 when locked and 2 when locked with (possibly) sleeping waiters.
+// Only the last state makes unlocking enter the kernel, so uncontended mutexes never do.
+enum : u32 {
+    MUTEX_UNLOCKED = 0,
+    MUTEX_LOCKED = 1,
+    MUTEX_LOCKED_WITH_WAITERS = 2,
+};
+
+static void mutex_lock_contended(pthread_mutex_t* mutex)
+{
+    auto& lock = reinterpret_cast<Atomic<u32>&>(mutex->lock);
+    while (lock.exchange(MUTEX_LOCKED_WITH_WAITERS, AK::memory_order_acquire) != MUTEX_UNLOCKED)
+        futex_wait(reinterpret_cast<int32_t*>(&mutex->lock), MUTEX_LOCKED_WITH_WAITERS, nullptr, CLOCK_MONOTONIC);
+}
+
 int pthread_mutex_lock(pthread_mutex_t* mutex)
 {
-    auto& atomic = reinterpret_cast<Atomic<u32>&>(mutex->lock);
     pthread_t this_thread = pthread_self();
-    for (;;) {
-        u32 expected = false;
-        if (!atomic.compare_exchange_strong(expected, true, AK::memory_order_acq_rel)) {
-            if (mutex->type == PTHREAD_MUTEX_RECURSIVE && mutex->owner == this_thread) {
-                mutex->level++;
-                return 0;
-            }
-            sched_yield();
-            continue;
-        }
-        mutex->owner = this_thread;
-        mutex->level = 0;
+    if (mutex->type == PTHREAD_MUTEX_RECURSIVE && mutex->owner == this_thread) {
+        mutex->level++;
         return 0;
     }
+    auto& lock = reinterpret_cast<Atomic<u32>&>(mutex->lock);
+    u32 expected = MUTEX_UNLOCKED;
+    if (!lock.compare_exchange_strong(expected, MUTEX_LOCKED, AK::memory_order_acquire))
+        mutex_lock_contended(mutex);
+    mutex->owner = this_thread;
+    mutex->level = 0;
+    return 0;
 }
 
 int pthread_mutex_trylock(pthread_mutex_t* mutex)
 {
-    auto& atomic = reinterpret_cast<Atomic<u32>&>(mutex->lock);
-    u32 expected = false;
-    if (!atomic.compare_exchange_strong(expected, true, AK::memory_order_acq_rel)) {
-        if (mutex->type == PTHREAD_MUTEX_RECURSIVE && mutex->owner == pthread_self()) {
-            mutex->level++;
-            return 0;
-        }
-        return EBUSY;
+    if (mutex->type == PTHREAD_MUTEX_RECURSIVE && mutex->owner == pthread_self()) {
+        mutex->level++;
+        return 0;
     }
+    auto& lock = reinterpret_cast<Atomic<u32>&>(mutex->lock);
+    u32 expected = MUTEX_UNLOCKED;
+    if (!lock.compare_exchange_strong(expected, MUTEX_LOCKED, AK::memory_order_acquire))
+        return EBUSY;
     mutex->owner = pthread_self();
     mutex->level = 0;
     return 0;
@@ -210,7 +224,9 @@ int pthread_mutex_unlock(pthread_mutex_t* mutex)
         return 0;
     }
     mutex->owner = 0;
-    mutex->lock = 0;
+    auto& lock = reinterpret_cast<Atomic<u32>&>(mutex->lock);
+    if (lock.exchange(MUTEX_UNLOCKED, AK::memory_order_release) == MUTEX_LOCKED_WITH_WAITERS)
+        futex_wake(reinterpret_cast<int32_t*>(&mutex->lock), 1);
     return 0;
 }
 
@@ -458,25 +474,32 @@ int pthread_attr_setstacksize(pthread_attr_t* attributes, size_t stack_size)
 
 int pthread_getschedparam(pthread_t thread, int* policy, struct sched_param* param)
 {
-    (void)thread;
-    (void)policy;
-    (void)param;
+    if (!policy || !param)
+        return EINVAL;
+    int rc = sched_getscheduler(thread);
+    if (rc < 0)
+        return errno;
+    *policy = rc;
+    if (sched_getparam(thread, param) < 0)
+        return errno;
     return 0;
 }
 
 int pthread_setschedparam(pthread_t thread, int policy, const struct sched_param* param)
 {
-    (void)thread;
-    (void)policy;
-    (void)param;
+    if (!param)
+        return EINVAL;
+    if (sched_setscheduler(thread, policy, param) < 0)
+        return errno;
     return 0;
 }
 
 int pthread_cond_init(pthread_cond_t* cond, const pthread_condattr_t* attr)
 {
     cond->value = 0;
-    cond->previous = 0;
-    cond->clockid = attr ? attr->clockid : CLOCK_MONOTONIC;
+    cond->waiters = 0;
+    cond->clockid = attr ? attr->clockid : CLOCK_REALTIME;
+    cond->mutex = nullptr;
     return 0;
 }
 
@@ -487,12 +510,20 @@ int pthread_cond_destroy(pthread_cond_t*)
 
 static int cond_wait(pthread_cond_t* cond, pthread_mutex_t* mutex, const struct timespec* abstime)
 {
+    auto& waiters = reinterpret_cast<Atomic<u32>&>(cond->waiters);
     i32 value = cond->value;
-    cond->previous = value;
+    cond->mutex = mutex;
+    waiters++;
     pthread_mutex_unlock(mutex);
-    int rc = futex(&cond->value, FUTEX_WAIT, value, abstime);
-    pthread_mutex_lock(mutex);
-    return rc;
+    int rc = futex_wait(&cond->value, value, abstime, cond->clockid);
+    bool timed_out = rc < 0 && errno == ETIMEDOUT;
+    // pthread_cond_broadcast() may have requeued us onto the mutex, in which case other
+    // waiters could be sleeping on it behind us, so let our unlock wake them up.
+    mutex_lock_contended(mutex);
+    mutex->owner = pthread_self();
+    mutex->level = 0;
+    waiters--;
+    return timed_out ? ETIMEDOUT : 0;
 }
 
 int pthread_cond_wait(pthread_cond_t* cond, pthread_mutex_t* mutex)
@@ -504,7 +535,7 @@ int pthread_cond_wait(pthread_cond_t* cond, pthread_mutex_t* mutex)
 
 int pthread_condattr_init(pthread_condattr_t* attr)
 {
-    attr->clockid = CLOCK_MONOTONIC;
+    attr->clockid = CLOCK_REALTIME;
     return 0;
 }
 
@@ -526,19 +557,33 @@ int pthread_cond_timedwait(pthread_cond_t* cond, pthread_mutex_t* mutex, const s
 
 int pthread_cond_signal(pthread_cond_t* cond)
 {
-    u32 value = cond->previous + 1;
-    cond->value = value;
-    int rc = futex(&cond->value, FUTEX_WAKE, 1, nullptr);
-    ASSERT(rc == 0);
+    auto& value = reinterpret_cast<Atomic<i32>&>(cond->value);
+    auto& waiters = reinterpret_cast<Atomic<u32>&>(cond->waiters);
+    value++;
+    if (!waiters.load())
+        return 0;
+    int rc = futex_wake(&cond->value, 1);
+    ASSERT(rc >= 0);
     return 0;
 }
 
 int pthread_cond_broadcast(pthread_cond_t* cond)
 {
-    u32 value = cond->previous + 1;
-    cond->value = value;
-    int rc = futex(&cond->value, FUTEX_WAKE, INT32_MAX, nullptr);
-    ASSERT(rc == 0);
+    auto& value = reinterpret_cast<Atomic<i32>&>(cond->value);
+    auto& waiters = reinterpret_cast<Atomic<u32>&>(cond->waiters);
+    value++;
+    if (!waiters.load())
+        return 0;
+    // Waking everyone would just have them pile up on the mutex again, so wake one
+    // and move the rest over to the mutex, where unlocking will wake them one by one.
+    for (;;) {
+        i32 expected_value = value.load();
+        auto* mutex_lock = reinterpret_cast<int32_t*>(&cond->mutex->lock);
+        int rc = futex(&cond->value, FUTEX_CMP_REQUEUE, 1, reinterpret_cast<const struct timespec*>(INT32_MAX), mutex_lock, expected_value);
+        if (rc >= 0)
+            break;
+        ASSERT(errno == EAGAIN);
+    }
     return 0;
 }
 
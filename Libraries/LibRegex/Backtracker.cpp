@@ -0,0 +1,201 @@
+/*
+ * Copyright (c) 2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <LibRegex/Backtracker.h>
+
+namespace Regex {
+
+Backtracker::Backtracker(const Program& program, const StringView& input)
+    : m_program(program)
+    , m_input(input)
+{
+    m_slots.resize(program.capture_count * 2);
+    m_marks.resize(program.mark_count);
+}
+
+bool Backtracker::match_at(size_t start, Match& match)
+{
+    for (auto& slot : m_slots)
+        slot = -1;
+    if (!run(0, start))
+        return false;
+
+    match.captures.clear();
+    for (size_t i = 0; i < m_program.capture_count; ++i) {
+        auto start = m_slots[i * 2];
+        auto end = m_slots[i * 2 + 1];
+        if (start < 0 || end < 0)
+            match.captures.append(Capture {});
+        else
+            match.captures.append({ (size_t)start, (size_t)end, true });
+    }
+    return true;
+}
+
+bool Backtracker::assertion_holds(OpCode op, size_t position) const
+{
+    bool at_start = position == 0;
+    bool at_end = position == m_input.length();
+    switch (op) {
+    case OpCode::AssertInputStart:
+        return at_start;
+    case OpCode::AssertInputEnd:
+        return at_end;
+    case OpCode::AssertLineStart:
+        return at_start || is_line_terminator(m_input[position - 1]);
+    case OpCode::AssertLineEnd:
+        return at_end || is_line_terminator(m_input[position]);
+    case OpCode::AssertWordBoundary:
+    case OpCode::AssertNotWordBoundary: {
+        bool is_boundary = (!at_start && is_word_byte(m_input[position - 1])) != (!at_end && is_word_byte(m_input[position]));
+        return op == OpCode::AssertWordBoundary ? is_boundary : !is_boundary;
+    }
+    default:
+        ASSERT_NOT_REACHED();
+    }
+}
+
+bool Backtracker::match_back_reference(u32 capture, size_t& position) const
+{
+    auto start = m_slots[capture * 2];
+    auto end = m_slots[capture * 2 + 1];
+    // A reference to a group that hasn't participated in the match matches the empty string.
+    if (start < 0 || end < 0)
+        return true;
+    size_t length = end - start;
+    if (position + length > m_input.length())
+        return false;
+    for (size_t i = 0; i < length; ++i) {
+        u8 expected = m_input[start + i];
+        u8 actual = m_input[position + i];
+        if (m_program.ignore_case ? to_lower(expected) != to_lower(actual) : expected != actual)
+            return false;
+    }
+    position += length;
+    return true;
+}
+
+// Runs from `pc` until the program (or the lookahead we're in) matches, and returns whether it
+// did. On success the captures are left as that path set them.
+bool Backtracker::run(u32 pc, size_t position)
+{
+    size_t stack_base = m_stack.size();
+
+    for (;;) {
+        auto& instruction = m_program.instructions[pc];
+        bool ok = true;
+        switch (instruction.op) {
+        case OpCode::Byte:
+            ok = position < m_input.length() && (u8)m_input[position] == instruction.argument;
+            ++position;
+            ++pc;
+            break;
+        case OpCode::ByteSet:
+            ok = position < m_input.length() && m_program.byte_sets[instruction.argument].contains(m_input[position]);
+            ++position;
+            ++pc;
+            break;
+        case OpCode::Split:
+            m_stack.append({ Frame::Kind::Choice, instruction.alternative, (ssize_t)position });
+            pc = instruction.target;
+            break;
+        case OpCode::Jump:
+            pc = instruction.target;
+            break;
+        case OpCode::Save:
+            m_stack.append({ Frame::Kind::RestoreSlot, instruction.argument, m_slots[instruction.argument] });
+            m_slots[instruction.argument] = position;
+            ++pc;
+            break;
+        case OpCode::ResetCaptures:
+            for (u32 slot = instruction.argument * 2; slot <= instruction.target * 2 + 1; ++slot) {
+                m_stack.append({ Frame::Kind::RestoreSlot, slot, m_slots[slot] });
+                m_slots[slot] = -1;
+            }
+            ++pc;
+            break;
+        case OpCode::SetMark:
+            m_stack.append({ Frame::Kind::RestoreMark, instruction.argument, (ssize_t)m_marks[instruction.argument] });
+            m_marks[instruction.argument] = position;
+            ++pc;
+            break;
+        case OpCode::CheckProgress:
+            ok = m_marks[instruction.argument] != position;
+            ++pc;
+            break;
+        case OpCode::BackReference:
+            ok = match_back_reference(instruction.argument, position);
+            ++pc;
+            break;
+        case OpCode::LookAhead: {
+            bool negative = instruction.argument;
+            auto slots_before = m_slots;
+            bool matched = run(pc + 1, position);
+            if (matched == negative) {
+                m_slots = move(slots_before);
+                ok = false;
+                break;
+            }
+            // The lookahead's own frames are gone, so record how to undo the captures it set.
+            for (size_t i = 0; i < m_slots.size(); ++i) {
+                if (m_slots[i] != slots_before[i])
+                    m_stack.append({ Frame::Kind::RestoreSlot, (u32)i, slots_before[i] });
+            }
+            pc = instruction.target;
+            break;
+        }
+        case OpCode::LookAheadEnd:
+        case OpCode::Match:
+            m_stack.shrink(stack_base, true);
+            return true;
+        default:
+            ok = assertion_holds(instruction.op, position);
+            ++pc;
+            break;
+        }
+
+        if (ok)
+            continue;
+
+        // Back out to the most recent choice, undoing everything done since.
+        for (;;) {
+            if (m_stack.size() == stack_base)
+                return false;
+            auto frame = m_stack.take_last();
+            if (frame.kind == Frame::Kind::RestoreSlot) {
+                m_slots[frame.index] = frame.value;
+            } else if (frame.kind == Frame::Kind::RestoreMark) {
+                m_marks[frame.index] = frame.value;
+            } else {
+                pc = frame.index;
+                position = frame.value;
+                break;
+            }
+        }
+    }
+}
+
+}
@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/StringView.h>
+#include <AK/Vector.h>
+#include <LibRegex/Pattern.h>
+#include <LibRegex/Program.h>
+
+namespace Regex {
+
+// Runs a program by depth-first search over its splits, undoing capture writes as it backs out
+// of failed paths. This is what back-references and lookaheads need, and it's also how we
+// recover the captures of a match the DFA has found.
+class Backtracker {
+public:
+    Backtracker(const Program&, const StringView& input);
+
+    bool match_at(size_t start, Match&);
+
+private:
+    struct Frame {
+        enum class Kind : u8 {
+            Choice,
+            RestoreSlot,
+            RestoreMark,
+        };
+        Kind kind;
+        u32 index;
+        ssize_t value;
+    };
+
+    bool run(u32 pc, size_t position);
+    bool assertion_holds(OpCode, size_t position) const;
+    bool match_back_reference(u32 capture, size_t& position) const;
+
+    const Program& m_program;
+    StringView m_input;
+    Vector<ssize_t> m_slots;
+    Vector<size_t> m_marks;
+    Vector<Frame> m_stack;
+};
+
+}
@@ -0,0 +1,1008 @@
+/*
+ * Copyright (c) 2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/NonnullOwnPtr.h>
+#include <AK/NonnullOwnPtrVector.h>
+#include <AK/Optional.h>
+#include <LibRegex/Compiler.h>
+#include <LibRegex/Pattern.h>
+#include <ctype.h>
+#include <string.h>
+
+namespace Regex {
+
+static constexpr size_t max_repetition_count = 1000;
+static constexpr size_t max_instruction_count = 100000;
+
+struct Node {
+    enum class Type {
+        Empty,
+        Byte,
+        ByteSet,
+        Assertion,
+        Group,
+        BackReference,
+        LookAhead,
+        Concatenation,
+        Alternation,
+        Repetition,
+    };
+
+    explicit Node(Type type)
+        : type(type)
+    {
+    }
+
+    Type type;
+    u8 byte { 0 };
+    ByteSet byte_set;
+    OpCode assertion { OpCode::Match };
+    // The capture group of a Group (-1 for a non-capturing one), or the one a BackReference refers to.
+    int capture { -1 };
+    String capture_name;
+    bool negative { false };
+    size_t min { 0 };
+    Optional<size_t> max;
+    bool greedy { true };
+    NonnullOwnPtrVector<Node> children;
+};
+
+static NonnullOwnPtr<Node> make_node(Node::Type type)
+{
+    return make<Node>(type);
+}
+
+static NonnullOwnPtr<Node> make_byte_set_node(const ByteSet& byte_set)
+{
+    auto node = make_node(Node::Type::ByteSet);
+    node->byte_set = byte_set;
+    return node;
+}
+
+static NonnullOwnPtr<Node> make_code_point_node(u32 code_point)
+{
+    u8 bytes[4];
+    size_t length = 0;
+    if (code_point < 0x80) {
+        bytes[length++] = code_point;
+    } else if (code_point < 0x800) {
+        bytes[length++] = 0xc0 | (code_point >> 6);
+        bytes[length++] = 0x80 | (code_point & 0x3f);
+    } else if (code_point < 0x10000) {
+        bytes[length++] = 0xe0 | (code_point >> 12);
+        bytes[length++] = 0x80 | ((code_point >> 6) & 0x3f);
+        bytes[length++] = 0x80 | (code_point & 0x3f);
+    } else {
+        bytes[length++] = 0xf0 | (code_point >> 18);
+        bytes[length++] = 0x80 | ((code_point >> 12) & 0x3f);
+        bytes[length++] = 0x80 | ((code_point >> 6) & 0x3f);
+        bytes[length++] = 0x80 | (code_point & 0x3f);
+    }
+    if (length == 1) {
+        auto node = make_node(Node::Type::Byte);
+        node->byte = bytes[0];
+        return node;
+    }
+    auto node = make_node(Node::Type::Concatenation);
+    for (size_t i = 0; i < length; ++i) {
+        auto byte_node = make_node(Node::Type::Byte);
+        byte_node->byte = bytes[i];
+        node->children.append(move(byte_node));
+    }
+    return node;
+}
+
+// Matches one multi-byte UTF-8 sequence, i.e. any code point outside of ASCII.
+static void append_non_ascii_alternatives(Node& alternation)
+{
+    ByteSet continuation;
+    continuation.add_range(0x80, 0xbf);
+    struct {
+        u8 first;
+        u8 last;
+        size_t continuation_count;
+    } lead_bytes[] = { { 0xc0, 0xdf, 1 }, { 0xe0, 0xef, 2 }, { 0xf0, 0xf7, 3 } };
+    for (auto& lead : lead_bytes) {
+        auto sequence = make_node(Node::Type::Concatenation);
+        ByteSet lead_set;
+        lead_set.add_range(lead.first, lead.last);
+        sequence->children.append(make_byte_set_node(lead_set));
+        for (size_t i = 0; i < lead.continuation_count; ++i)
+            sequence->children.append(make_byte_set_node(continuation));
+        alternation.children.append(move(sequence));
+    }
+}
+
+static bool can_match_empty(const Node& node)
+{
+    switch (node.type) {
+    case Node::Type::Empty:
+    case Node::Type::Assertion:
+    case Node::Type::LookAhead:
+    case Node::Type::BackReference:
+        return true;
+    case Node::Type::Byte:
+    case Node::Type::ByteSet:
+        return false;
+    case Node::Type::Group:
+        return can_match_empty(node.children.first());
+    case Node::Type::Concatenation:
+        for (auto& child : node.children) {
+            if (!can_match_empty(child))
+                return false;
+        }
+        return true;
+    case Node::Type::Alternation:
+        for (auto& child : node.children) {
+            if (can_match_empty(child))
+                return true;
+        }
+        return false;
+    case Node::Type::Repetition:
+        return node.min == 0 || can_match_empty(node.children.first());
+    }
+    ASSERT_NOT_REACHED();
+}
+
+// The range of capture groups inside a node, if it has any.
+static void find_captures(const Node& node, int& first, int& last)
+{
+    if (node.type == Node::Type::Group && node.capture >= 0) {
+        if (first < 0)
+            first = node.capture;
+        last = node.capture;
+    }
+    for (auto& child : node.children)
+        find_captures(child, first, last);
+}
+
+// The contents of a [...] class, before negation.
+struct ClassContents {
+    ByteSet ascii;
+    Vector<u32> code_points;
+    bool includes_all_non_ascii { false };
+};
+
+class Parser {
+public:
+    Parser(const StringView& pattern, u8 flags, Program& program)
+        : m_pattern(pattern)
+        , m_flags(flags)
+        , m_program(program)
+    {
+    }
+
+    NonnullOwnPtr<Node> parse();
+    const String& error() const { return m_error; }
+
+private:
+    bool at_end() const { return m_position >= m_pattern.length(); }
+    u8 peek(size_t offset = 0) const { return m_position + offset < m_pattern.length() ? m_pattern[m_position + offset] : 0; }
+    u8 consume() { return m_pattern[m_position++]; }
+    bool consume_if(const StringView& expected)
+    {
+        if (m_position + expected.length() > m_pattern.length())
+            return false;
+        if (m_pattern.substring_view(m_position, expected.length()) != expected)
+            return false;
+        m_position += expected.length();
+        return true;
+    }
+    void set_error(const String& error)
+    {
+        if (m_error.is_null())
+            m_error = error;
+    }
+
+    size_t count_capture_groups() const;
+
+    NonnullOwnPtr<Node> parse_disjunction();
+    NonnullOwnPtr<Node> parse_alternative();
+    NonnullOwnPtr<Node> parse_term();
+    NonnullOwnPtr<Node> parse_atom();
+    NonnullOwnPtr<Node> parse_group();
+    NonnullOwnPtr<Node> parse_atom_escape();
+    NonnullOwnPtr<Node> parse_class();
+    bool parse_quantifier(size_t& min, Optional<size_t>& max);
+    Optional<size_t> parse_decimal();
+    bool parse_hex_digits(size_t count, u32& value);
+    u32 parse_character_escape();
+    u32 consume_code_point();
+    bool add_builtin_class(u8 letter, ClassContents&);
+    NonnullOwnPtr<Node> make_class_node(ClassContents&, bool negated);
+
+    StringView m_pattern;
+    size_t m_position { 0 };
+    u8 m_flags { 0 };
+    Program& m_program;
+    size_t m_total_capture_count { 0 };
+    String m_error;
+};
+
+size_t Parser::count_capture_groups() const
+{
+    size_t count = 0;
+    bool in_class = false;
+    for (size_t i = 0; i < m_pattern.length(); ++i) {
+        char c = m_pattern[i];
+        if (c == '\\') {
+            ++i;
+        } else if (c == '[') {
+            in_class = true;
+        } else if (c == ']') {
+            in_class = false;
+        } else if (c == '(' && !in_class) {
+            if (i + 1 >= m_pattern.length() || m_pattern[i + 1] != '?')
+                ++count;
+            else if (i + 3 < m_pattern.length() && m_pattern[i + 2] == '<' && m_pattern[i + 3] != '=' && m_pattern[i + 3] != '!')
+                ++count;
+        }
+    }
+    return count;
+}
+
+NonnullOwnPtr<Node> Parser::parse()
+{
+    m_total_capture_count = count_capture_groups();
+    m_program.capture_names.resize(m_total_capture_count + 1);
+    auto root = parse_disjunction();
+    if (!at_end())
+        set_error("Unmatched ')'");
+    return root;
+}
+
+NonnullOwnPtr<Node> Parser::parse_disjunction()
+{
+    auto first = parse_alternative();
+    if (peek() != '|')
+        return first;
+    auto alternation = make_node(Node::Type::Alternation);
+    alternation->children.append(move(first));
+    while (!at_end() && peek() == '|') {
+        consume();
+        alternation->children.append(parse_alternative());
+    }
+    return alternation;
+}
+
+NonnullOwnPtr<Node> Parser::parse_alternative()
+{
+    auto concatenation = make_node(Node::Type::Concatenation);
+    while (!at_end() && peek() != '|' && peek() != ')' && m_error.is_null())
+        concatenation->children.append(parse_term());
+    if (concatenation->children.size() == 1)
+        return concatenation->children.take_last();
+    return concatenation;
+}
+
+NonnullOwnPtr<Node> Parser::parse_term()
+{
+    if (peek() == '^' || peek() == '$') {
+        auto node = make_node(Node::Type::Assertion);
+        bool multiline = m_flags & Multiline;
+        if (consume() == '^')
+            node->assertion = multiline ? OpCode::AssertLineStart : OpCode::AssertInputStart;
+        else
+            node->assertion = multiline ? OpCode::AssertLineEnd : OpCode::AssertInputEnd;
+        return node;
+    }
+    if (consume_if("\\b") || consume_if("\\B")) {
+        auto node = make_node(Node::Type::Assertion);
+        node->assertion = m_pattern[m_position - 1] == 'b' ? OpCode::AssertWordBoundary : OpCode::AssertNotWordBoundary;
+        return node;
+    }
+    if (consume_if("(?=") || consume_if("(?!")) {
+        auto node = make_node(Node::Type::LookAhead);
+        node->negative = m_pattern[m_position - 1] == '!';
+        node->children.append(parse_disjunction());
+        if (!consume_if(")"))
+            set_error("Unterminated lookahead");
+        return node;
+    }
+    if (consume_if("(?<=") || consume_if("(?<!")) {
+        set_error("Lookbehind assertions are not supported");
+        return make_node(Node::Type::Empty);
+    }
+
+    auto atom = parse_atom();
+    size_t min = 0;
+    Optional<size_t> max;
+    if (!parse_quantifier(min, max))
+        return atom;
+
+    auto repetition = make_node(Node::Type::Repetition);
+    repetition->min = min;
+    repetition->max = max;
+    repetition->greedy = !consume_if("?");
+    if (max.has_value() && max.value() < min)
+        set_error("Numbers out of order in {} quantifier");
+    if (min > max_repetition_count || max.value_or(0) > max_repetition_count)
+        set_error("Repetition count is too large");
+    repetition->children.append(move(atom));
+    return repetition;
+}
+
+bool Parser::parse_quantifier(size_t& min, Optional<size_t>& max)
+{
+    switch (peek()) {
+    case '*':
+        consume();
+        min = 0;
+        return true;
+    case '+':
+        consume();
+        min = 1;
+        return true;
+    case '?':
+        consume();
+        min = 0;
+        max = 1;
+        return true;
+    case '{': {
+        // Anything that isn't a well-formed {n}, {n,} or {n,m} is just a literal brace.
+        auto start = m_position;
+        consume();
+        auto low = parse_decimal();
+        if (low.has_value()) {
+            min = low.value();
+            if (consume_if("}")) {
+                max = min;
+                return true;
+            }
+            if (consume_if(",")) {
+                if (consume_if("}"))
+                    return true;
+                auto high = parse_decimal();
+                if (high.has_value() && consume_if("}")) {
+                    max = high.value();
+                    return true;
+                }
+            }
+        }
+        m_position = start;
+        return false;
+    }
+    default:
+        return false;
+    }
+}
+
+Optional<size_t> Parser::parse_decimal()
+{
+    if (!isdigit(peek()))
+        return {};
+    size_t value = 0;
+    while (isdigit(peek())) {
+        u8 digit = consume() - '0';
+        if (value < 100000000)
+            value = value * 10 + digit;
+    }
+    return value;
+}
+
+NonnullOwnPtr<Node> Parser::parse_atom()
+{
+    switch (peek()) {
+    case '.': {
+        consume();
+        // Any code point, except for line terminators unless the s flag is set.
+        ClassContents excluded;
+        if (!(m_flags & DotAll)) {
+            excluded.ascii.add('\n');
+            excluded.ascii.add('\r');
+        }
+        return make_class_node(excluded, true);
+    }
+    case '(':
+        return parse_group();
+    case '[':
+        return parse_class();
+    case '\\':
+        return parse_atom_escape();
+    case '*':
+    case '+':
+    case '?':
+        set_error("Nothing to repeat");
+        consume();
+        return make_node(Node::Type::Empty);
+    case '{': {
+        size_t min;
+        Optional<size_t> max;
+        if (parse_quantifier(min, max)) {
+            set_error("Nothing to repeat");
+            return make_node(Node::Type::Empty);
+        }
+        break;
+    }
+    default:
+        break;
+    }
+
+    u8 byte = consume();
+    if (byte < 0xc0) {
+        auto node = make_node(Node::Type::Byte);
+        node->byte = byte;
+        return node;
+    }
+    // Keep a multi-byte character together, so that a quantifier applies to all of it.
+    auto node = make_node(Node::Type::Concatenation);
+    auto lead = make_node(Node::Type::Byte);
+    lead->byte = byte;
+    node->children.append(move(lead));
+    while (!at_end() && (peek() & 0xc0) == 0x80) {
+        auto continuation = make_node(Node::Type::Byte);
+        continuation->byte = consume();
+        node->children.append(move(continuation));
+    }
+    return node;
+}
+
+NonnullOwnPtr<Node> Parser::parse_group()
+{
+    consume();
+    auto node = make_node(Node::Type::Group);
+    if (consume_if("?:")) {
+        node->capture = -1;
+    } else {
+        String name;
+        if (consume_if("?<")) {
+            auto name_start = m_position;
+            while (!at_end() && peek() != '>')
+                consume();
+            name = m_pattern.substring_view(name_start, m_position - name_start);
+            if (!consume_if(">") || name.is_empty())
+                set_error("Invalid capture group name");
+        } else if (peek() == '?') {
+            set_error("Invalid group");
+        }
+        node->capture = m_program.capture_count++;
+        if ((size_t)node->capture < m_program.capture_names.size())
+            m_program.capture_names[node->capture] = name;
+    }
+    node->children.append(parse_disjunction());
+    if (!consume_if(")"))
+        set_error("Unterminated group");
+    return node;
+}
+
+u32 Parser::consume_code_point()
+{
+    u8 lead = consume();
+    if (lead < 0xc0)
+        return lead;
+    size_t continuation_count = lead < 0xe0 ? 1 : lead < 0xf0 ? 2 : 3;
+    u32 code_point = lead & (0x3f >> continuation_count);
+    for (size_t i = 0; i < continuation_count && !at_end() && (peek() & 0xc0) == 0x80; ++i)
+        code_point = (code_point << 6) | (consume() & 0x3f);
+    return code_point;
+}
+
+bool Parser::parse_hex_digits(size_t count, u32& value)
+{
+    value = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (!isxdigit(peek(i)))
+            return false;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        u8 digit = consume();
+        value = value * 16 + (isdigit(digit) ? digit - '0' : (to_lower(digit) - 'a' + 10));
+    }
+    return true;
+}
+
+// The escape after a backslash (which has been consumed) that stands for a single character.
+u32 Parser::parse_character_escape()
+{
+    u32 value = 0;
+    switch (peek()) {
+    case 'n':
+        consume();
+        return '\n';
+    case 't':
+        consume();
+        return '\t';
+    case 'r':
+        consume();
+        return '\r';
+    case 'f':
+        consume();
+        return '\f';
+    case 'v':
+        consume();
+        return '\v';
+    case '0':
+        consume();
+        return 0;
+    case 'x':
+        consume();
+        if (parse_hex_digits(2, value))
+            return value;
+        return 'x';
+    case 'u':
+        consume();
+        if (consume_if("{")) {
+            auto start = m_position;
+            while (isxdigit(peek()))
+                consume();
+            auto digits = m_position - start;
+            m_position = start;
+            if (digits > 0 && digits <= 6 && parse_hex_digits(digits, value) && consume_if("}") && value <= 0x10ffff)
+                return value;
+            m_position = start - 1;
+            return 'u';
+        }
+        if (parse_hex_digits(4, value))
+            return value;
+        return 'u';
+    case 'c':
+        if (isalpha(peek(1))) {
+            consume();
+            return consume() % 32;
+        }
+        return '\\';
+    default:
+        return consume_code_point();
+    }
+}
+
+bool Parser::add_builtin_class(u8 letter, ClassContents& contents)
+{
+    ClassContents builtin;
+    switch (to_lower(letter)) {
+    case 'd':
+        builtin.ascii.add_range('0', '9');
+        break;
+    case 'w':
+        builtin.ascii.add_range('a', 'z');
+        builtin.ascii.add_range('A', 'Z');
+        builtin.ascii.add_range('0', '9');
+        builtin.ascii.add('_');
+        break;
+    case 's':
+        builtin.ascii.add_range('\t', '\r');
+        builtin.ascii.add(' ');
+        break;
+    default:
+        return false;
+    }
+    if (letter >= 'A' && letter <= 'Z') {
+        builtin.ascii.invert();
+        builtin.includes_all_non_ascii = true;
+    }
+    for (unsigned byte = 0; byte < 0x80; ++byte) {
+        if (builtin.ascii.contains(byte))
+            contents.ascii.add(byte);
+    }
+    contents.includes_all_non_ascii |= builtin.includes_all_non_ascii;
+    return true;
+}
+
+NonnullOwnPtr<Node> Parser::make_class_node(ClassContents& contents, bool negated)
+{
+    ByteSet ascii;
+    for (unsigned byte = 0; byte < 0x80; ++byte) {
+        if (!contents.ascii.contains(byte))
+            continue;
+        ascii.add(byte);
+        if (m_flags & CaseInsensitive && isalpha(byte)) {
+            ascii.add(tolower(byte));
+            ascii.add(toupper(byte));
+        }
+    }
+    bool includes_all_non_ascii = contents.includes_all_non_ascii;
+    if (negated) {
+        if (!contents.code_points.is_empty()) {
+            set_error("Negated character classes with non-ASCII characters are not supported");
+            return make_node(Node::Type::Empty);
+        }
+        ByteSet inverted;
+        for (unsigned byte = 0; byte < 0x80; ++byte) {
+            if (!ascii.contains(byte))
+                inverted.add(byte);
+        }
+        ascii = inverted;
+        includes_all_non_ascii = !includes_all_non_ascii;
+    }
+
+    auto byte_set_node = make_byte_set_node(ascii);
+    if (!includes_all_non_ascii && contents.code_points.is_empty())
+        return byte_set_node;
+    auto alternation = make_node(Node::Type::Alternation);
+    alternation->children.append(move(byte_set_node));
+    if (includes_all_non_ascii) {
+        append_non_ascii_alternatives(*alternation);
+    } else {
+        for (auto code_point : contents.code_points)
+            alternation->children.append(make_code_point_node(code_point));
+    }
+    return alternation;
+}
+
+NonnullOwnPtr<Node> Parser::parse_class()
+{
+    consume();
+    bool negated = consume_if("^");
+    ClassContents contents;
+
+    auto add_code_point = [&](u32 code_point) {
+        if (code_point < 0x80)
+            contents.ascii.add(code_point);
+        else
+            contents.code_points.append(code_point);
+    };
+
+    // Returns the code point of the next class atom, or nothing if it was a class escape like \d.
+    auto parse_class_atom = [&]() -> Optional<u32> {
+        if (!consume_if("\\"))
+            return consume_code_point();
+        if (add_builtin_class(peek(), contents)) {
+            consume();
+            return {};
+        }
+        if (consume_if("b"))
+            return '\b';
+        if (consume_if("-"))
+            return '-';
+        return parse_character_escape();
+    };
+
+    while (!at_end() && peek() != ']' && m_error.is_null()) {
+        auto first = parse_class_atom();
+        if (peek() == '-' && peek(1) != ']' && peek(1) != 0) {
+            consume();
+            auto last = parse_class_atom();
+            if (!first.has_value() || !last.has_value()) {
+                // One end of the range is a class escape, so the dash is just a dash.
+                if (first.has_value())
+                    add_code_point(first.value());
+                contents.ascii.add('-');
+                if (last.has_value())
+                    add_code_point(last.value());
+                continue;
+            }
+            if (first.value() > last.value()) {
+                set_error("Range out of order in character class");
+                break;
+            }
+            for (u32 code_point = first.value(); code_point <= last.value() && code_point < 0x80; ++code_point)
+                contents.ascii.add(code_point);
+            if (last.value() >= 0x80) {
+                if (last.value() - max(first.value(), (u32)0x80) > 0x400) {
+                    set_error("Non-ASCII ranges in character classes are limited to 1024 characters");
+                    break;
+                }
+                for (u32 code_point = max(first.value(), (u32)0x80); code_point <= last.value(); ++code_point)
+                    contents.code_points.append(code_point);
+            }
+            continue;
+        }
+        if (first.has_value())
+            add_code_point(first.value());
+    }
+    if (!consume_if("]"))
+        set_error("Unterminated character class");
+    return make_class_node(contents, negated);
+}
+
+NonnullOwnPtr<Node> Parser::parse_atom_escape()
+{
+    consume();
+    if (at_end()) {
+        set_error("\\ at end of pattern");
+        return make_node(Node::Type::Empty);
+    }
+
+    ClassContents contents;
+    if (add_builtin_class(peek(), contents)) {
+        consume();
+        return make_class_node(contents, false);
+    }
+
+    if (peek() >= '1' && peek() <= '9') {
+        auto start = m_position;
+        auto index = parse_decimal().value();
+        if (index <= m_total_capture_count) {
+            auto node = make_node(Node::Type::BackReference);
+            node->capture = index;
+            return node;
+        }
+        // Annex B: a reference to a group that doesn't exist is an octal escape (or just a digit).
+        m_position = start;
+        if (peek() > '7')
+            return make_code_point_node(consume());
+        u32 value = 0;
+        for (size_t i = 0; i < 3 && peek() >= '0' && peek() <= '7' && value * 8 + (peek() - '0') <= 0xff; ++i)
+            value = value * 8 + (consume() - '0');
+        return make_code_point_node(value);
+    }
+
+    if (peek() == 'k' && peek(1) == '<') {
+        auto start = m_position;
+        m_position += 2;
+        auto name_start = m_position;
+        while (!at_end() && peek() != '>')
+            consume();
+        auto name = m_pattern.substring_view(name_start, m_position - name_start);
+        if (consume_if(">") && !name.is_empty()) {
+            auto node = make_node(Node::Type::BackReference);
+            node->capture_name = name;
+            return node;
+        }
+        m_position = start;
+    }
+
+    return make_code_point_node(parse_character_escape());
+}
+
+class Emitter {
+public:
+    Emitter(Program& program, String& error)
+        : m_program(program)
+        , m_error(error)
+    {
+    }
+
+    void emit(const Node&);
+    u32 emit_instruction(OpCode, u32 argument = 0);
+
+private:
+    Instruction& at(u32 index) { return m_program.instructions[index]; }
+    u32 here() const { return m_program.instructions.size(); }
+    u32 byte_set_index(const ByteSet&);
+
+    Program& m_program;
+    String& m_error;
+};
+
+u32 Emitter::emit_instruction(OpCode op, u32 argument)
+{
+    if (m_program.instructions.size() >= max_instruction_count && m_error.is_null())
+        m_error = "Pattern is too large";
+    m_program.instructions.append({ op, argument, 0, 0 });
+    return m_program.instructions.size() - 1;
+}
+
+u32 Emitter::byte_set_index(const ByteSet& byte_set)
+{
+    for (size_t i = 0; i < m_program.byte_sets.size(); ++i) {
+        if (!memcmp(&m_program.byte_sets[i], &byte_set, sizeof(ByteSet)))
+            return i;
+    }
+    m_program.byte_sets.append(byte_set);
+    return m_program.byte_sets.size() - 1;
+}
+
+void Emitter::emit(const Node& node)
+{
+    if (!m_error.is_null())
+        return;
+
+    switch (node.type) {
+    case Node::Type::Empty:
+        return;
+    case Node::Type::Byte:
+        if (m_program.ignore_case && isalpha(node.byte)) {
+            ByteSet both_cases;
+            both_cases.add(tolower(node.byte));
+            both_cases.add(toupper(node.byte));
+            emit_instruction(OpCode::ByteSet, byte_set_index(both_cases));
+            return;
+        }
+        emit_instruction(OpCode::Byte, node.byte);
+        return;
+    case Node::Type::ByteSet:
+        emit_instruction(OpCode::ByteSet, byte_set_index(node.byte_set));
+        return;
+    case Node::Type::Assertion:
+        if (node.assertion == OpCode::AssertWordBoundary || node.assertion == OpCode::AssertNotWordBoundary)
+            m_program.uses_word_boundaries = true;
+        else if (node.assertion == OpCode::AssertLineStart || node.assertion == OpCode::AssertLineEnd)
+            m_program.uses_line_assertions = true;
+        else if (node.assertion == OpCode::AssertInputStart)
+            m_program.uses_input_start = true;
+        emit_instruction(node.assertion);
+        return;
+    case Node::Type::Group:
+        if (node.capture < 0) {
+            emit(node.children.first());
+            return;
+        }
+        emit_instruction(OpCode::Save, node.capture * 2);
+        emit(node.children.first());
+        emit_instruction(OpCode::Save, node.capture * 2 + 1);
+        return;
+    case Node::Type::BackReference: {
+        auto capture = node.capture;
+        if (!node.capture_name.is_null()) {
+            capture = -1;
+            for (size_t i = 1; i < m_program.capture_names.size(); ++i) {
+                if (m_program.capture_names[i] == node.capture_name)
+                    capture = i;
+            }
+            if (capture < 0) {
+                m_error = String::format("Reference to unknown capture group '%s'", node.capture_name.characters());
+                return;
+            }
+        }
+        m_program.needs_backtracking = true;
+        emit_instruction(OpCode::BackReference, capture);
+        return;
+    }
+    case Node::Type::LookAhead: {
+        m_program.needs_backtracking = true;
+        auto look_ahead = emit_instruction(OpCode::LookAhead, node.negative);
+        emit(node.children.first());
+        emit_instruction(OpCode::LookAheadEnd);
+        at(look_ahead).target = here();
+        return;
+    }
+    case Node::Type::Concatenation:
+        for (auto& child : node.children)
+            emit(child);
+        return;
+    case Node::Type::Alternation: {
+        Vector<u32> jumps_to_end;
+        for (size_t i = 0; i < node.children.size(); ++i) {
+            if (i == node.children.size() - 1) {
+                emit(node.children[i]);
+                break;
+            }
+            auto split = emit_instruction(OpCode::Split);
+            at(split).target = here();
+            emit(node.children[i]);
+            jumps_to_end.append(emit_instruction(OpCode::Jump));
+            at(split).alternative = here();
+        }
+        for (auto jump : jumps_to_end)
+            at(jump).target = here();
+        return;
+    }
+    case Node::Type::Repetition: {
+        auto& body = node.children.first();
+        int first_capture = -1;
+        int last_capture = -1;
+        find_captures(body, first_capture, last_capture);
+        auto emit_iteration = [&] {
+            if (first_capture >= 0)
+                at(emit_instruction(OpCode::ResetCaptures, first_capture)).target = last_capture;
+            emit(body);
+        };
+
+        for (size_t i = 0; i < node.min; ++i)
+            emit_iteration();
+
+        auto link_split = [&](u32 split, u32 body_start, u32 end) {
+            at(split).target = node.greedy ? body_start : end;
+            at(split).alternative = node.greedy ? end : body_start;
+        };
+
+        // An optional iteration that matches the empty string doesn't count, so it mustn't be
+        // taken in favor of the alternatives.
+        bool needs_progress_check = can_match_empty(body);
+        auto emit_optional_iteration = [&] {
+            auto mark = m_program.mark_count;
+            if (needs_progress_check) {
+                ++m_program.mark_count;
+                emit_instruction(OpCode::SetMark, mark);
+            }
+            emit_iteration();
+            if (needs_progress_check)
+                emit_instruction(OpCode::CheckProgress, mark);
+        };
+
+        if (!node.max.has_value()) {
+            auto split = emit_instruction(OpCode::Split);
+            emit_optional_iteration();
+            at(emit_instruction(OpCode::Jump)).target = split;
+            link_split(split, split + 1, here());
+            return;
+        }
+
+        // The DFA gets the check on a loop for free, since an empty iteration brings it back to a
+        // state it has already visited. A bounded repetition doesn't loop back, so it would need
+        // to track the positions of its marks.
+        if (needs_progress_check && node.max.value() > node.min)
+            m_program.needs_backtracking = true;
+
+        Vector<u32> splits;
+        for (size_t i = node.min; i < node.max.value(); ++i) {
+            splits.append(emit_instruction(OpCode::Split));
+            emit_optional_iteration();
+        }
+        for (auto split : splits)
+            link_split(split, split + 1, here());
+        return;
+    }
+    }
+}
+
+static void compute_first_bytes(Program& program)
+{
+    ByteSet first_bytes;
+    Vector<bool> visited;
+    visited.resize(program.instructions.size());
+    for (auto& entry : visited)
+        entry = false;
+    Vector<u32> pending;
+    pending.append(0);
+    while (!pending.is_empty()) {
+        auto pc = pending.take_last();
+        if (visited[pc])
+            continue;
+        visited[pc] = true;
+        auto& instruction = program.instructions[pc];
+        switch (instruction.op) {
+        case OpCode::Byte:
+            first_bytes.add(instruction.argument);
+            break;
+        case OpCode::ByteSet:
+            first_bytes.add_all(program.byte_sets[instruction.argument]);
+            break;
+        case OpCode::Split:
+            pending.append(instruction.alternative);
+            pending.append(instruction.target);
+            break;
+        case OpCode::Jump:
+            pending.append(instruction.target);
+            break;
+        case OpCode::Match:
+        case OpCode::BackReference:
+        case OpCode::LookAhead:
+        case OpCode::LookAheadEnd:
+            return;
+        default:
+            pending.append(pc + 1);
+            break;
+        }
+    }
+    program.first_bytes = first_bytes;
+    program.has_first_bytes = true;
+}
+
+String compile(const StringView& pattern, u8 flags, Program& program)
+{
+    program.ignore_case = flags & CaseInsensitive;
+
+    Parser parser(pattern, flags, program);
+    auto root = parser.parse();
+    if (!parser.error().is_null())
+        return parser.error();
+
+    String error;
+    Emitter emitter(program, error);
+    emitter.emit_instruction(OpCode::Save, 0);
+    emitter.emit(*root);
+    emitter.emit_instruction(OpCode::Save, 1);
+    emitter.emit_instruction(OpCode::Match);
+    if (!error.is_null())
+        return error;
+
+    compute_first_bytes(program);
+    return {};
+}
+
+}
@@ -0,0 +1,243 @@
+/*
+ * Copyright (c) 2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/StringBuilder.h>
+#include <LibRegex/DFA.h>
+
+namespace Regex {
+
+DFA::DFA(const Program& program)
+    : m_program(program)
+{
+    if (program.uses_input_start || program.uses_line_assertions)
+        m_context_mask |= AtInputStart;
+    if (program.uses_word_boundaries)
+        m_context_mask |= AfterWordByte;
+    if (program.uses_line_assertions)
+        m_context_mask |= AfterLineTerminator;
+
+    for (auto& start_state : m_start_states)
+        start_state = -1;
+    m_visited.resize(program.instructions.size());
+    for (auto& visited : m_visited)
+        visited = 0;
+
+    auto dead = intern_state({}, 0);
+    ASSERT(dead.has_value() && dead.value() == dead_state);
+}
+
+u8 DFA::context_at(const StringView& input, size_t position) const
+{
+    if (position == 0)
+        return AtInputStart & m_context_mask;
+    return context_after(input[position - 1]);
+}
+
+u8 DFA::context_after(u8 byte) const
+{
+    u8 context = 0;
+    if (is_word_byte(byte))
+        context |= AfterWordByte;
+    if (is_line_terminator(byte))
+        context |= AfterLineTerminator;
+    return context & m_context_mask;
+}
+
+bool DFA::assertion_holds(OpCode op, u8 context, int next_byte) const
+{
+    bool at_end = next_byte < 0;
+    switch (op) {
+    case OpCode::AssertInputStart:
+        return context & AtInputStart;
+    case OpCode::AssertInputEnd:
+        return at_end;
+    case OpCode::AssertLineStart:
+        return context & (AtInputStart | AfterLineTerminator);
+    case OpCode::AssertLineEnd:
+        return at_end || is_line_terminator(next_byte);
+    case OpCode::AssertWordBoundary:
+    case OpCode::AssertNotWordBoundary: {
+        bool is_boundary = (bool)(context & AfterWordByte) != (!at_end && is_word_byte(next_byte));
+        return op == OpCode::AssertWordBoundary ? is_boundary : !is_boundary;
+    }
+    default:
+        ASSERT_NOT_REACHED();
+    }
+}
+
+// Expands the state's threads through everything that doesn't consume input, in priority order.
+// Returns whether one of them reaches a match; the threads after it have lower priority than
+// that match, so they are dropped.
+bool DFA::follow_epsilons(const State& state, int next_byte, Vector<u32>& consuming_threads)
+{
+    if (++m_visit_generation == 0) {
+        for (auto& visited : m_visited)
+            visited = 0;
+        m_visit_generation = 1;
+    }
+
+    for (auto thread : state.threads) {
+        m_pending.clear();
+        m_pending.append(thread);
+        while (!m_pending.is_empty()) {
+            auto pc = m_pending.take_last();
+            if (m_visited[pc] == m_visit_generation)
+                continue;
+            m_visited[pc] = m_visit_generation;
+            auto& instruction = m_program.instructions[pc];
+            switch (instruction.op) {
+            case OpCode::Byte:
+            case OpCode::ByteSet:
+                consuming_threads.append(pc);
+                break;
+            case OpCode::Split:
+                m_pending.append(instruction.alternative);
+                m_pending.append(instruction.target);
+                break;
+            case OpCode::Jump:
+                m_pending.append(instruction.target);
+                break;
+            case OpCode::Save:
+            case OpCode::ResetCaptures:
+            case OpCode::SetMark:
+            case OpCode::CheckProgress:
+                m_pending.append(pc + 1);
+                break;
+            case OpCode::Match:
+                return true;
+            case OpCode::BackReference:
+            case OpCode::LookAhead:
+            case OpCode::LookAheadEnd:
+                ASSERT_NOT_REACHED();
+            default:
+                if (assertion_holds(instruction.op, state.context, next_byte))
+                    m_pending.append(pc + 1);
+                break;
+            }
+        }
+    }
+    return false;
+}
+
+Optional<u32> DFA::intern_state(const Vector<u32>& threads, u8 context)
+{
+    if (threads.is_empty() && !m_states.is_empty())
+        return dead_state;
+
+    // The key must not start with a null byte, or String would take it for an empty string.
+    StringBuilder key_builder;
+    key_builder.append('A' + context);
+    key_builder.append((const char*)threads.data(), threads.size() * sizeof(u32));
+    auto key = key_builder.to_string();
+
+    auto it = m_state_indices.find(key);
+    if (it != m_state_indices.end())
+        return it->value;
+
+    if (m_states.size() >= max_state_count) {
+        m_overflowed = true;
+        return {};
+    }
+    auto state = make<State>();
+    state->threads = threads;
+    state->context = context;
+    for (auto& transition : state->transitions)
+        transition = -1;
+    m_states.append(move(state));
+    u32 index = m_states.size() - 1;
+    m_state_indices.set(key, index);
+    return index;
+}
+
+Optional<i32> DFA::compute_transition(u32 state_index, u8 byte)
+{
+    Vector<u32> consuming_threads;
+    bool matched = follow_epsilons(m_states[state_index], byte, consuming_threads);
+
+    Vector<u32> next_threads;
+    for (auto pc : consuming_threads) {
+        auto& instruction = m_program.instructions[pc];
+        bool accepts_byte = instruction.op == OpCode::Byte ? instruction.argument == byte : m_program.byte_sets[instruction.argument].contains(byte);
+        if (accepts_byte)
+            next_threads.append(pc + 1);
+    }
+
+    auto next_state = intern_state(next_threads, context_after(byte));
+    if (!next_state.has_value())
+        return {};
+    i32 transition = (next_state.value() << 1) | matched;
+    m_states[state_index].transitions[byte] = transition;
+    return transition;
+}
+
+bool DFA::accepts_at_end(u32 state_index)
+{
+    auto& state = m_states[state_index];
+    if (state.accepts_at_end < 0) {
+        Vector<u32> consuming_threads;
+        state.accepts_at_end = follow_epsilons(state, -1, consuming_threads);
+    }
+    return state.accepts_at_end;
+}
+
+Optional<size_t> DFA::match_at(const StringView& input, size_t start)
+{
+    if (m_overflowed)
+        return {};
+
+    auto context = context_at(input, start);
+    if (m_start_states[context] < 0) {
+        Vector<u32> start_threads;
+        start_threads.append(0);
+        auto start_state = intern_state(start_threads, context);
+        if (!start_state.has_value())
+            return {};
+        m_start_states[context] = start_state.value();
+    }
+    u32 state = m_start_states[context];
+
+    Optional<size_t> match_end;
+    for (size_t position = start; position < input.length(); ++position) {
+        u8 byte = input[position];
+        i32 transition = m_states[state].transitions[byte];
+        if (transition < 0) {
+            auto computed = compute_transition(state, byte);
+            if (!computed.has_value())
+                return {};
+            transition = computed.value();
+        }
+        if (transition & 1)
+            match_end = position;
+        state = transition >> 1;
+        if (state == dead_state)
+            return match_end;
+    }
+    if (accepts_at_end(state))
+        match_end = input.length();
+    return match_end;
+}
+
+}
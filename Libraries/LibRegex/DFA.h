@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/HashMap.h>
+#include <AK/NonnullOwnPtrVector.h>
+#include <AK/Optional.h>
+#include <AK/String.h>
+#include <AK/StringView.h>
+#include <AK/Vector.h>
+#include <LibRegex/Program.h>
+
+namespace Regex {
+
+// A DFA built lazily from a program without back-references or lookaheads. Each state is the
+// list of NFA threads still alive, kept in priority order so that the DFA finds the same match
+// the backtracking matcher would. Assertions are resolved during transitions, when the bytes on
+// both sides of the current position are known.
+class DFA {
+public:
+    explicit DFA(const Program&);
+
+    // The end of the match starting exactly at `start`, if there is one.
+    Optional<size_t> match_at(const StringView& input, size_t start);
+
+    // Set once the DFA has grown too large to be worth caching, after which it must not be used.
+    bool has_overflowed() const { return m_overflowed; }
+
+private:
+    static constexpr size_t max_state_count = 4096;
+    static constexpr u32 dead_state = 0;
+
+    enum Context : u8 {
+        AtInputStart = 1 << 0,
+        AfterWordByte = 1 << 1,
+        AfterLineTerminator = 1 << 2,
+    };
+
+    struct State {
+        Vector<u32> threads;
+        u8 context { 0 };
+        // Each transition is the next state shifted left by one, with the low bit set if a match
+        // ended right before the byte. -1 if we haven't computed it yet.
+        i32 transitions[256];
+        i8 accepts_at_end { -1 };
+    };
+
+    u8 context_at(const StringView& input, size_t position) const;
+    u8 context_after(u8 byte) const;
+    bool assertion_holds(OpCode, u8 context, int next_byte) const;
+    bool follow_epsilons(const State&, int next_byte, Vector<u32>& consuming_threads);
+    Optional<u32> intern_state(const Vector<u32>& threads, u8 context);
+    Optional<i32> compute_transition(u32 state_index, u8 byte);
+    bool accepts_at_end(u32 state_index);
+
+    const Program& m_program;
+    u8 m_context_mask { 0 };
+    NonnullOwnPtrVector<State> m_states;
+    HashMap<String, u32> m_state_indices;
+    i32 m_start_states[8];
+    bool m_overflowed { false };
+
+    Vector<u32> m_visited;
+    u32 m_visit_generation { 0 };
+    Vector<u32> m_pending;
+};
+
+}
@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <LibRegex/Backtracker.h>
+#include <LibRegex/Compiler.h>
+#include <LibRegex/DFA.h>
+#include <LibRegex/Pattern.h>
+
+namespace Regex {
+
+Pattern::Pattern(const StringView& source, u8 flags)
+    : m_source(source)
+    , m_flags(flags)
+{
+    m_error = compile(source, flags, m_program);
+}
+
+Pattern::~Pattern()
+{
+}
+
+bool Pattern::can_use_dfa() const
+{
+    if (m_program.needs_backtracking)
+        return false;
+    if (!m_dfa)
+        m_dfa = make<DFA>(m_program);
+    return !m_dfa->has_overflowed();
+}
+
+Optional<Match> Pattern::find(const StringView& input, size_t start, Anchoring anchoring, bool need_captures) const
+{
+    if (!is_valid() || start > input.length())
+        return {};
+
+    auto may_start_at = [&](size_t position) {
+        if (!m_program.has_first_bytes)
+            return true;
+        return position < input.length() && m_program.first_bytes.contains(input[position]);
+    };
+    size_t last_start = anchoring == Anchoring::AtStart ? start : input.length();
+
+    Backtracker backtracker(m_program, input);
+    Match match;
+    for (size_t position = start; position <= last_start; ++position) {
+        if (!may_start_at(position))
+            continue;
+
+        if (can_use_dfa()) {
+            auto end = m_dfa->match_at(input, position);
+            if (!m_dfa->has_overflowed()) {
+                if (!end.has_value())
+                    continue;
+                if (!need_captures || m_program.capture_count == 1) {
+                    match.captures.append({ position, end.value(), true });
+                    return match;
+                }
+                // The DFA only knows where the match is; the backtracker will take the same path to
+                // it, and it's cheap now that we know where it starts.
+            }
+        }
+
+        if (backtracker.match_at(position, match))
+            return match;
+    }
+    return {};
+}
+
+Optional<Match> Pattern::search(const StringView& input, size_t start) const
+{
+    return find(input, start, Anchoring::Anywhere, true);
+}
+
+Optional<Match> Pattern::match_at(const StringView& input, size_t position) const
+{
+    return find(input, position, Anchoring::AtStart, true);
+}
+
+bool Pattern::has_match(const StringView& input) const
+{
+    return find(input, 0, Anchoring::Anywhere, false).has_value();
+}
+
+}
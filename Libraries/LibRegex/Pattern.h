@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/Optional.h>
+#include <AK/OwnPtr.h>
+#include <AK/RefCounted.h>
+#include <AK/String.h>
+#include <AK/StringView.h>
+#include <AK/Vector.h>
+#include <LibRegex/Program.h>
+
+namespace Regex {
+
+enum Flag : u8 {
+    NoFlags = 0,
+    CaseInsensitive = 1 << 0,
+    Multiline = 1 << 1,
+    DotAll = 1 << 2,
+};
+
+struct Capture {
+    size_t start { 0 };
+    size_t end { 0 };
+    bool matched { false };
+
+    size_t length() const { return end - start; }
+    StringView view(const StringView& input) const { return matched ? input.substring_view(start, length()) : StringView(); }
+};
+
+struct Match {
+    // Capture 0 is the whole match; the rest are the pattern's capture groups, in order.
+    Vector<Capture, 4> captures;
+
+    size_t start() const { return captures[0].start; }
+    size_t end() const { return captures[0].end; }
+    size_t length() const { return captures[0].length(); }
+};
+
+class DFA;
+
+// A compiled regular expression using ECMAScript syntax. Matching works on the bytes of UTF-8
+// text: patterns without back-references or lookaheads run on a lazily built DFA, and only
+// the ones that need it (or whose captures are asked for) use the backtracking matcher.
+class Pattern : public RefCounted<Pattern> {
+public:
+    static NonnullRefPtr<Pattern> create(const StringView& source, u8 flags = NoFlags) { return adopt(*new Pattern(source, flags)); }
+    ~Pattern();
+
+    bool is_valid() const { return m_error.is_null(); }
+    const String& error() const { return m_error; }
+
+    const String& source() const { return m_source; }
+    u8 flags() const { return m_flags; }
+
+    // Including capture 0, the whole match.
+    size_t capture_count() const { return m_program.capture_count; }
+    // The names of named capture groups, indexed like the captures; unnamed ones are null.
+    const Vector<String>& capture_names() const { return m_program.capture_names; }
+
+    // Finds the leftmost match that starts at or after `start`.
+    Optional<Match> search(const StringView& input, size_t start = 0) const;
+    // Only matches starting exactly at `position`, for sticky matching.
+    Optional<Match> match_at(const StringView& input, size_t position) const;
+    bool has_match(const StringView& input) const;
+
+private:
+    Pattern(const StringView& source, u8 flags);
+
+    enum class Anchoring {
+        Anywhere,
+        AtStart,
+    };
+    Optional<Match> find(const StringView& input, size_t start, Anchoring, bool need_captures) const;
+    bool can_use_dfa() const;
+
+    String m_source;
+    u8 m_flags { NoFlags };
+    String m_error;
+    Program m_program;
+    mutable OwnPtr<DFA> m_dfa;
+};
+
+}
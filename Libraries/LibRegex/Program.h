@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/String.h>
+#include <AK/Types.h>
+#include <AK/Vector.h>
+
+namespace Regex {
+
+enum class OpCode : u8 {
+    // Consume one byte of input.
+    Byte,
+    ByteSet,
+
+    // Continue at `target`, and at `alternative` if that fails.
+    Split,
+    Jump,
+
+    // Record the current position in capture slot `argument`.
+    Save,
+    // Forget captures `argument` through `target`, as each iteration of a quantified group starts afresh.
+    ResetCaptures,
+
+    // Guard against looping forever on an empty iteration of a nullable loop body.
+    SetMark,
+    CheckProgress,
+
+    AssertInputStart,
+    AssertInputEnd,
+    AssertLineStart,
+    AssertLineEnd,
+    AssertWordBoundary,
+    AssertNotWordBoundary,
+
+    BackReference,
+
+    // Run the sub-program following this instruction up to its LookAheadEnd, then continue
+    // at `target`. `argument` is 1 for a negative lookahead.
+    LookAhead,
+    LookAheadEnd,
+
+    Match,
+};
+
+struct Instruction {
+    OpCode op;
+    u32 argument { 0 };
+    u32 target { 0 };
+    u32 alternative { 0 };
+};
+
+class ByteSet {
+public:
+    bool contains(u8 byte) const { return m_bits[byte / 32] & (1u << (byte % 32)); }
+    void add(u8 byte) { m_bits[byte / 32] |= 1u << (byte % 32); }
+    void add_range(u8 first, u8 last)
+    {
+        for (unsigned byte = first; byte <= last; ++byte)
+            add(byte);
+    }
+    void add_all(const ByteSet& other)
+    {
+        for (size_t i = 0; i < 8; ++i)
+            m_bits[i] |= other.m_bits[i];
+    }
+    void invert()
+    {
+        for (auto& bits : m_bits)
+            bits = ~bits;
+    }
+
+private:
+    u32 m_bits[8] {};
+};
+
+struct Program {
+    Vector<Instruction> instructions;
+    Vector<ByteSet> byte_sets;
+
+    // Capture group 0 is the whole match, so there are always at least two slots.
+    size_t capture_count { 1 };
+    Vector<String> capture_names;
+    size_t mark_count { 0 };
+    bool ignore_case { false };
+
+    // Back-references and lookaheads need the backtracking matcher; everything else can run on the DFA.
+    bool needs_backtracking { false };
+    bool uses_word_boundaries { false };
+    bool uses_line_assertions { false };
+    bool uses_input_start { false };
+
+    // The bytes a match can start with, for skipping ahead when searching. Patterns that can
+    // match the empty string (or whose first byte we can't tell) may start anywhere.
+    ByteSet first_bytes;
+    bool has_first_bytes { false };
+};
+
+inline bool is_word_byte(u8 byte)
+{
+    return (byte >= 'a' && byte <= 'z') || (byte >= 'A' && byte <= 'Z') || (byte >= '0' && byte <= '9') || byte == '_';
+}
+
+inline bool is_line_terminator(u8 byte)
+{
+    return byte == '\n' || byte == '\r';
+}
+
+inline u8 to_lower(u8 byte)
+{
+    return byte >= 'A' && byte <= 'Z' ? byte + ('a' - 'A') : byte;
+}
+
+}
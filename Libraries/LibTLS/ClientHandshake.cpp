@@ -27,6 +27,7 @@
 #include <AK/Random.h>
 #include <LibCore/Timer.h>
 #include <LibCrypto/ASN1/DER.h>
+#include <LibCrypto/Curves/X25519.h>
 #include <LibCrypto/PK/Code/EMSA_PSS.h>
 #include <LibTLS/TLSv12.h>
 
@@ -85,6 +86,10 @@ ssize_t TLSv12::handle_hello(const ByteBuffer& buffer, WritePacketStage& write_p
         return (i8)Error::NeedMoreData;
     }
 
+    // The server takes up the session we offered by echoing its ID back.
+    bool resumes_offered_session = m_context.offered_session.has_value() && session_length && session_length == m_context.session_id_size
+        && !memcmp(m_context.session_id, buffer.offset_pointer(res), session_length);
+
     if (session_length && session_length <= 32) {
         memcpy(m_context.session_id, buffer.offset_pointer(res), session_length);
         m_context.session_id_size = session_length;
@@ -197,9 +202,39 @@ ssize_t TLSv12::handle_hello(const ByteBuffer& buffer, WritePacketStage& write_p
         }
     }
 
+    if (resumes_offered_session) {
+#ifdef TLS_DEBUG
+        dbg() << "resuming session";
+#endif
+        if (!resume_offered_session())
+            return (i8)Error::UnexpectedMessage;
+    }
+
     return res;
 }
 
+ssize_t TLSv12::handle_new_session_ticket(const ByteBuffer& buffer)
+{
+    if (buffer.size() < 3)
+        return (i8)Error::NeedMoreData;
+
+    size_t size = buffer[0] * 0x10000 + buffer[1] * 0x100 + buffer[2];
+    if (buffer.size() - 3 < size)
+        return (i8)Error::NeedMoreData;
+
+    // RFC 5077 3.3: the lifetime hint in seconds, then the opaque ticket.
+    if (size < 6)
+        return (i8)Error::BrokenPacket;
+    size_t ticket_length = buffer[7] * 0x100 + buffer[8];
+    if (size < 6 + ticket_length)
+        return (i8)Error::BrokenPacket;
+
+    m_context.new_session_ticket_lifetime = convert_between_host_and_network(*(const u32*)buffer.offset_pointer(3));
+    m_context.new_session_ticket = ByteBuffer::copy(buffer.offset_pointer(9), ticket_length);
+
+    return size + 3;
+}
+
 ssize_t TLSv12::handle_finished(const ByteBuffer& buffer, WritePacketStage& write_packets)
 {
     if (m_context.connection_status < ConnectionStatus::KeyExchange || m_context.connection_status == ConnectionStatus::Established) {
@@ -236,8 +271,6 @@ ssize_t TLSv12::handle_finished(const ByteBuffer& buffer, WritePacketStage& writ
 #ifdef TLS_DEBUG
     dbg() << "FIXME: handle_finished :: Check message validity";
 #endif
-    m_context.connection_status = ConnectionStatus::Established;
-
     if (m_handshake_timeout_timer) {
         // Disable the handshake timeout timer as handshake has been established.
         m_handshake_timeout_timer->stop();
@@ -245,10 +278,19 @@ ssize_t TLSv12::handle_finished(const ByteBuffer& buffer, WritePacketStage& writ
         m_handshake_timeout_timer = nullptr;
     }
 
+    if (m_context.resuming_session) {
+        // In an abbreviated handshake the server finishes first, and we follow with our own Finished.
+        write_packets = WritePacketStage::Finished;
+        return index + size;
+    }
+
+    m_context.connection_status = ConnectionStatus::Established;
+    cache_session();
+
     if (on_tls_ready_to_write)
         on_tls_ready_to_write(*this);
 
-    return handle_message(buffer);
+    return index + size;
 }
 
 void TLSv12::build_random(PacketBuilder& builder)
@@ -300,6 +342,33 @@ void TLSv12::build_random(PacketBuilder& builder)
     builder.append(outbuf);
 }
 
+void TLSv12::build_ecdhe_key_share(PacketBuilder& builder)
+{
+    auto private_key = Crypto::Curves::X25519::generate_private_key();
+    auto public_key = Crypto::Curves::X25519::generate_public_key(private_key);
+
+    m_context.premaster_key = Crypto::Curves::X25519::derive_shared_secret(private_key, m_context.server_ecdhe_public_key);
+    m_context.server_ecdhe_public_key.clear();
+    if (m_context.premaster_key.is_empty()) {
+        dbg() << "server sent an unusable key share";
+        return;
+    }
+
+#ifdef TLS_DEBUG
+    dbg() << "PreMaster secret";
+    print_buffer(m_context.premaster_key);
+#endif
+
+    if (!compute_master_secret(48)) {
+        dbg() << "oh noes we could not derive a master key :(";
+        return;
+    }
+
+    builder.append_u24(public_key.size() + 1);
+    builder.append((u8)public_key.size());
+    builder.append(public_key);
+}
+
 ssize_t TLSv12::handle_payload(const ByteBuffer& vbuffer)
 {
     if (m_context.connection_status == ConnectionStatus::Established) {
@@ -373,6 +442,16 @@ ssize_t TLSv12::handle_payload(const ByteBuffer& vbuffer)
             dbg() << "unsupported: DTLS";
             payload_res = (i8)Error::UnexpectedMessage;
             break;
+        case NewSessionTicket:
+#ifdef TLS_DEBUG
+            dbg() << "new session ticket";
+#endif
+            if (m_context.is_server || m_context.connection_status == ConnectionStatus::Established) {
+                payload_res = (i8)Error::UnexpectedMessage;
+            } else {
+                payload_res = handle_new_session_ticket(buffer.slice_view(1, payload_size));
+            }
+            break;
         case CertificateMessage:
             if (m_context.handshake_messages[4] >= 1) {
                 dbg() << "unexpected certificate message";
@@ -457,6 +536,10 @@ ssize_t TLSv12::handle_payload(const ByteBuffer& vbuffer)
                 ASSERT_NOT_REACHED();
             } else {
                 payload_res = handle_server_hello_done(buffer.slice_view(1, payload_size));
+                if (payload_res > 0 && uses_ecdhe() && m_context.server_ecdhe_public_key.is_empty()) {
+                    dbg() << "server didn't send its key share";
+                    payload_res = (i8)Error::UnexpectedMessage;
+                }
                 if (payload_res > 0)
                     write_packets = WritePacketStage::ClientHandshake;
             }
@@ -643,6 +726,9 @@ ssize_t TLSv12::handle_payload(const ByteBuffer& vbuffer)
                 write_packet(packet);
             }
             m_context.connection_status = ConnectionStatus::Established;
+            cache_session();
+            if (on_tls_ready_to_write)
+                on_tls_ready_to_write(*this);
             break;
         }
         payload_size++;
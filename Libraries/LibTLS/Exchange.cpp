@@ -26,6 +26,8 @@
 
 #include <LibCore/Timer.h>
 #include <LibCrypto/ASN1/DER.h>
+#include <LibCrypto/Curves/X25519.h>
+#include <LibCrypto/PK/Code/EMSA_PKCS1_V1_5.h>
 #include <LibCrypto/PK/Code/EMSA_PSS.h>
 #include <LibTLS/TLSv12.h>
 
@@ -85,8 +87,16 @@ bool TLSv12::expand_key()
     memcpy(m_context.crypto.local_iv, client_iv, iv_size);
     memcpy(m_context.crypto.remote_iv, server_iv, iv_size);
 
-    m_aes_local = make<Crypto::Cipher::AESCipher::CBCMode>(ByteBuffer::wrap(client_key, key_size), key_size * 8, Crypto::Cipher::Intent::Encryption, Crypto::Cipher::PaddingMode::RFC5246);
-    m_aes_remote = make<Crypto::Cipher::AESCipher::CBCMode>(ByteBuffer::wrap(server_key, key_size), key_size * 8, Crypto::Cipher::Intent::Decryption, Crypto::Cipher::PaddingMode::RFC5246);
+    if (uses_chacha20_poly1305()) {
+        m_chacha20_poly1305_local = make<Crypto::Cipher::ChaCha20Poly1305>(ByteBuffer::wrap(client_key, key_size));
+        m_chacha20_poly1305_remote = make<Crypto::Cipher::ChaCha20Poly1305>(ByteBuffer::wrap(server_key, key_size));
+    } else if (is_aead()) {
+        m_aes_gcm_local = make<Crypto::Cipher::AESCipher::GCMMode>(ByteBuffer::wrap(client_key, key_size), key_size * 8, Crypto::Cipher::Intent::Encryption);
+        m_aes_gcm_remote = make<Crypto::Cipher::AESCipher::GCMMode>(ByteBuffer::wrap(server_key, key_size), key_size * 8, Crypto::Cipher::Intent::Decryption);
+    } else {
+        m_aes_local = make<Crypto::Cipher::AESCipher::CBCMode>(ByteBuffer::wrap(client_key, key_size), key_size * 8, Crypto::Cipher::Intent::Encryption, Crypto::Cipher::PaddingMode::RFC5246);
+        m_aes_remote = make<Crypto::Cipher::AESCipher::CBCMode>(ByteBuffer::wrap(server_key, key_size), key_size * 8, Crypto::Cipher::Intent::Decryption, Crypto::Cipher::PaddingMode::RFC5246);
+    }
 
     m_context.crypto.created = 1;
 
@@ -190,7 +200,10 @@ ByteBuffer TLSv12::build_client_key_exchange()
 {
     PacketBuilder builder { MessageType::Handshake, m_context.version };
     builder.append((u8)HandshakeType::ClientKeyExchange);
-    build_random(builder);
+    if (uses_ecdhe())
+        build_ecdhe_key_share(builder);
+    else
+        build_random(builder);
 
     m_context.connection_status = ConnectionStatus::KeyExchange;
 
@@ -201,10 +214,91 @@ ByteBuffer TLSv12::build_client_key_exchange()
     return packet;
 }
 
-ssize_t TLSv12::handle_server_key_exchange(const ByteBuffer&)
+template<typename HashFunction>
+static Crypto::PK::VerificationConsistency verify_pkcs1_signature(const ByteBuffer& message, const ByteBuffer& encoded_message, size_t em_bits)
 {
-    dbg() << "FIXME: parse_server_key_exchange";
-    return 0;
+    Crypto::PK::EMSA_PKCS1_V1_5<HashFunction> emsa;
+    return emsa.verify(message, encoded_message, em_bits);
+}
+
+ssize_t TLSv12::handle_server_key_exchange(const ByteBuffer& buffer)
+{
+    if (buffer.size() < 3)
+        return (i8)Error::NeedMoreData;
+
+    size_t size = buffer[0] * 0x10000 + buffer[1] * 0x100 + buffer[2];
+    if (buffer.size() - 3 < size)
+        return (i8)Error::NeedMoreData;
+
+    if (!uses_ecdhe()) {
+        dbg() << "server key exchange for a cipher suite that doesn't use one";
+        return (i8)Error::UnexpectedMessage;
+    }
+
+    // RFC 8422 5.4: ECParameters and the server's public point, then the signature over both randoms and them.
+    auto params = buffer.slice_view(3, size);
+    if (params.size() < 4) {
+        dbg() << "server key exchange too short";
+        return (i8)Error::BrokenPacket;
+    }
+    if (params[0] != (u8)ECCurveType::NamedCurve || (NamedCurve)(params[1] * 0x100 + params[2]) != NamedCurve::X25519) {
+        dbg() << "server picked a curve we didn't offer";
+        return (i8)Error::NoCommonCipher;
+    }
+    size_t public_key_length = params[3];
+    size_t params_length = 4 + public_key_length;
+    if (public_key_length != Crypto::Curves::X25519::key_size || params.size() < params_length + 4) {
+        dbg() << "server key exchange has a broken public key";
+        return (i8)Error::BrokenPacket;
+    }
+
+    auto scheme = (SignatureScheme)(params[params_length] * 0x100 + params[params_length + 1]);
+    size_t signature_length = params[params_length + 2] * 0x100 + params[params_length + 3];
+    if (params.size() < params_length + 4 + signature_length) {
+        dbg() << "server key exchange has a broken signature";
+        return (i8)Error::BrokenPacket;
+    }
+    auto signature = params.slice_view(params_length + 4, signature_length);
+
+    if (m_context.certificates.is_empty()) {
+        dbg() << "no certificate to check the server key exchange against";
+        return (i8)Error::BadCertificate;
+    }
+
+    auto signed_data = ByteBuffer::create_uninitialized(64 + params_length);
+    signed_data.overwrite(0, m_context.local_random, 32);
+    signed_data.overwrite(32, m_context.remote_random, 32);
+    signed_data.overwrite(64, params.data(), params_length);
+
+    const auto& public_key = m_context.certificates[0].public_key;
+    Crypto::PK::RSA rsa(public_key.modulus(), 0, public_key.public_exponent());
+    auto encoded_message = ByteBuffer::create_zeroed(signature_length);
+    rsa.verify(signature, encoded_message);
+
+    auto em_bits = signature_length * 8;
+    Crypto::PK::VerificationConsistency consistency;
+    switch (scheme) {
+    case SignatureScheme::RSA_PKCS1_SHA1:
+        consistency = verify_pkcs1_signature<Crypto::Hash::SHA1>(signed_data, encoded_message, em_bits);
+        break;
+    case SignatureScheme::RSA_PKCS1_SHA256:
+        consistency = verify_pkcs1_signature<Crypto::Hash::SHA256>(signed_data, encoded_message, em_bits);
+        break;
+    case SignatureScheme::RSA_PKCS1_SHA512:
+        consistency = verify_pkcs1_signature<Crypto::Hash::SHA512>(signed_data, encoded_message, em_bits);
+        break;
+    default:
+        dbg() << "server signed its key exchange with a scheme we didn't offer: " << (u16)scheme;
+        return (i8)Error::NoCommonCipher;
+    }
+
+    if (consistency != Crypto::PK::VerificationConsistency::Consistent) {
+        dbg() << "server key exchange signature doesn't check out";
+        return (i8)Error::NotVerified;
+    }
+
+    m_context.server_ecdhe_public_key = ByteBuffer::copy(params.offset_pointer(4), public_key_length);
+    return size + 3;
 }
 
 ssize_t TLSv12::handle_verify(const ByteBuffer&)
@@ -24,17 +24,111 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <AK/HashMap.h>
 #include <AK/Random.h>
 #include <LibCore/Timer.h>
 #include <LibCrypto/ASN1/DER.h>
 #include <LibCrypto/PK/Code/EMSA_PSS.h>
 #include <LibTLS/TLSv12.h>
+#include <time.h>
 
 namespace TLS {
 
+// Sessions are shared by every connection in the process, so repeated requests to a server only pay for
+// the full handshake once.
+static constexpr size_t max_cached_sessions = 64;
+static constexpr time_t max_session_lifetime = 60 * 60;
+
+static HashMap<String, CachedSession>* s_session_cache;
+
+static HashMap<String, CachedSession>& session_cache()
+{
+    if (!s_session_cache)
+        s_session_cache = new HashMap<String, CachedSession>;
+    return *s_session_cache;
+}
+
+void TLSv12::offer_cached_session()
+{
+    m_context.offered_session = {};
+    m_context.resuming_session = false;
+    if (m_context.session_cache_key.is_null())
+        return;
+
+    // A session is only offered once; it goes back into the cache when the handshake completes, so one
+    // that the server chokes on is forgotten.
+    auto it = session_cache().find(m_context.session_cache_key);
+    if (it == session_cache().end())
+        return;
+    auto session = move(it->value);
+    session_cache().remove(it);
+    if (session.expires_at <= time(nullptr))
+        return;
+
+    if (session.session_id_size) {
+        memcpy(m_context.session_id, session.session_id, session.session_id_size);
+        m_context.session_id_size = session.session_id_size;
+    } else {
+        // RFC 5077 3.4: with a ticket, a fresh session ID lets us tell whether the server accepted it.
+        AK::fill_with_random(m_context.session_id, sizeof(m_context.session_id));
+        m_context.session_id_size = sizeof(m_context.session_id);
+    }
+    memcpy(session.session_id, m_context.session_id, m_context.session_id_size);
+    session.session_id_size = m_context.session_id_size;
+    m_context.offered_session = move(session);
+}
+
+bool TLSv12::resume_offered_session()
+{
+    auto& session = m_context.offered_session.value();
+    if (session.cipher != m_context.cipher) {
+        dbg() << "server resumed a session with a different cipher";
+        return false;
+    }
+
+    m_context.resuming_session = true;
+    m_context.master_key = session.master_key;
+    m_context.connection_status = ConnectionStatus::KeyExchange;
+    return expand_key();
+}
+
+void TLSv12::cache_session()
+{
+    if (m_context.session_cache_key.is_null())
+        return;
+
+    CachedSession session;
+    session.cipher = m_context.cipher;
+    session.master_key = m_context.master_key;
+    session.expires_at = time(nullptr) + max_session_lifetime;
+    if (!m_context.new_session_ticket.is_empty()) {
+        session.ticket = m_context.new_session_ticket;
+        if (m_context.new_session_ticket_lifetime)
+            session.expires_at = min(session.expires_at, time(nullptr) + (time_t)m_context.new_session_ticket_lifetime);
+    } else if (m_context.resuming_session) {
+        // The server accepted our ticket without issuing a new one, so it's still good for as long as it was.
+        session.ticket = m_context.offered_session.value().ticket;
+        session.expires_at = m_context.offered_session.value().expires_at;
+    }
+    if (m_context.session_id_size) {
+        memcpy(session.session_id, m_context.session_id, m_context.session_id_size);
+        session.session_id_size = m_context.session_id_size;
+    }
+    m_context.new_session_ticket.clear();
+
+    if (!session.session_id_size && session.ticket.is_empty())
+        return;
+
+    auto& cache = session_cache();
+    if (cache.size() >= max_cached_sessions && !cache.contains(m_context.session_cache_key))
+        cache.remove_one_randomly();
+    cache.set(m_context.session_cache_key, move(session));
+}
+
 ByteBuffer TLSv12::build_hello()
 {
     AK::fill_with_random(&m_context.local_random, 32);
+    offer_cached_session();
 
     auto packet_version = (u16)m_context.version;
     auto version = (u16)m_context.version;
@@ -74,7 +168,16 @@ ByteBuffer TLSv12::build_hello()
     }
 
     // Ciphers
-    builder.append((u16)(4 * sizeof(u16)));
+    // Forward secret suites first. AES-GCM is the fastest of them with AES-NI, ChaCha20-Poly1305 without.
+    builder.append((u16)(7 * sizeof(u16)));
+    if (Crypto::Cipher::AESCipher::is_hardware_accelerated()) {
+        builder.append((u16)CipherSuite::ECDHE_RSA_WITH_AES_128_GCM_SHA256);
+        builder.append((u16)CipherSuite::ECDHE_RSA_WITH_CHACHA20_POLY1305_SHA256);
+    } else {
+        builder.append((u16)CipherSuite::ECDHE_RSA_WITH_CHACHA20_POLY1305_SHA256);
+        builder.append((u16)CipherSuite::ECDHE_RSA_WITH_AES_128_GCM_SHA256);
+    }
+    builder.append((u16)CipherSuite::RSA_WITH_AES_128_GCM_SHA256);
     builder.append((u16)CipherSuite::RSA_WITH_AES_128_CBC_SHA256);
     builder.append((u16)CipherSuite::RSA_WITH_AES_256_CBC_SHA256);
     builder.append((u16)CipherSuite::RSA_WITH_AES_128_CBC_SHA);
@@ -92,8 +195,40 @@ ByteBuffer TLSv12::build_hello()
     if (sni_length)
         extension_length += sni_length + 9;
 
+    // Groups and point formats for ECDHE, and the signatures we can check on the server's key share.
+    static constexpr SignatureScheme signature_schemes[] { SignatureScheme::RSA_PKCS1_SHA256, SignatureScheme::RSA_PKCS1_SHA512, SignatureScheme::RSA_PKCS1_SHA1 };
+    extension_length += 8 + 6 + 6 + sizeof(signature_schemes);
+
+    // An empty session ticket extension asks for a ticket, a full one offers it back.
+    ByteBuffer ticket;
+    if (m_context.offered_session.has_value())
+        ticket = m_context.offered_session.value().ticket;
+    extension_length += 4 + ticket.size();
+
     builder.append((u16)extension_length);
 
+    builder.append((u16)HandshakeExtension::SupportedGroups);
+    builder.append((u16)4);
+    builder.append((u16)2);
+    builder.append((u16)NamedCurve::X25519);
+
+    builder.append((u16)HandshakeExtension::ECPointFormats);
+    builder.append((u16)2);
+    builder.append((u8)1);
+    // uncompressed
+    builder.append((u8)0);
+
+    builder.append((u16)HandshakeExtension::SignatureAlgorithms);
+    builder.append((u16)(sizeof(signature_schemes) + 2));
+    builder.append((u16)sizeof(signature_schemes));
+    for (auto scheme : signature_schemes)
+        builder.append((u16)scheme);
+
+    builder.append((u16)HandshakeExtension::SessionTicket);
+    builder.append((u16)ticket.size());
+    if (!ticket.is_empty())
+        builder.append(ticket);
+
     if (sni_length) {
         // SNI extension
         builder.append((u16)HandshakeExtension::ServerName);
@@ -24,6 +24,7 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <AK/Random.h>
 #include <LibCore/Timer.h>
 #include <LibCrypto/ASN1/DER.h>
 #include <LibCrypto/PK/Code/EMSA_PSS.h>
@@ -56,6 +57,10 @@ void TLSv12::write_packet(ByteBuffer& packet)
 void TLSv12::update_packet(ByteBuffer& packet)
 {
     u32 header_size = 5;
+
+    // Application data that is still waiting to be sealed was written first, so its record has to go out first.
+    seal_pending_application_data();
+
     *(u16*)packet.offset_pointer(3) = convert_between_host_and_network((u16)(packet.size() - header_size));
 
     if (packet[0] != (u8)MessageType::ChangeCipher) {
@@ -66,82 +71,141 @@ void TLSv12::update_packet(ByteBuffer& packet)
             }
         }
         if (m_context.cipher_spec_set && m_context.crypto.created) {
-            size_t length = packet.size() - header_size + mac_length();
-            auto block_size = m_aes_local->cipher().block_size();
-            // if length is a multiple of block size, pad it up again
-            // since it seems no one handles aligned unpadded blocks
-            size_t padding = 0;
-            if (length % block_size == 0) {
-                padding = block_size;
-                length += padding;
-            }
-            size_t mac_size = mac_length();
-
-            if (m_context.crypto.created == 1) {
-                // `buffer' will continue to be encrypted
-                auto buffer = ByteBuffer::create_zeroed(length);
-                size_t buffer_position = 0;
-                u16 aligned_length = length + block_size - length % block_size;
-                auto iv_size = iv_length();
-
-                // we need enough space for a header, iv_length bytes of IV and whatever the packet contains
-                auto ct = ByteBuffer::create_zeroed(aligned_length + header_size + iv_size);
-
-                // copy the header over
-                ct.overwrite(0, packet.data(), header_size - 2);
-
-                // copy the packet, sans the header
-                buffer.overwrite(buffer_position, packet.offset_pointer(header_size), packet.size() - header_size);
-                buffer_position += packet.size() - header_size;
-
-                // get the appropricate HMAC value for the entire packet
-                auto mac = hmac_message(packet, {}, mac_size, true);
-
-                // write the MAC
-                buffer.overwrite(buffer_position, mac.data(), mac.size());
-                buffer_position += mac.size();
-
-                // if there's some padding to be done (since a packet MUST always be padded)
-                // apply it manually
-                if (padding) {
-                    memset(buffer.offset_pointer(buffer_position), padding - 1, padding);
-                    buffer_position += padding;
-                }
-
-                // should be the same value, but the manual padding
-                // throws a wrench into our plans
-                buffer.trim(buffer_position);
-
-                // FIXME: REALLY Should be filled with random bytes
-                auto iv = ByteBuffer::create_zeroed(iv_size);
+            size_t plain_length = packet.size() - header_size;
+            auto record = ByteBuffer::create_uninitialized(header_size + record_headroom() + plain_length + record_tailroom());
+            memcpy(record.data(), packet.data(), header_size);
+            memcpy(record.offset_pointer(header_size + record_headroom()), packet.offset_pointer(header_size), plain_length);
+            record.trim(seal_record(record.data(), plain_length));
+            packet = record;
+        }
+    }
+    ++m_context.record_statistics.records_sent;
+    ++m_context.local_sequence_number;
+}
 
-                // write it into the ciphertext portion of the message
-                ct.overwrite(header_size, iv.data(), iv.size());
-                ct.trim(length + block_size - length % block_size + header_size + block_size - padding);
+size_t TLSv12::record_headroom() const
+{
+    if (!m_context.cipher_spec_set || !m_context.crypto.created)
+        return 0;
+    return is_aead() ? aead_explicit_nonce_length() : iv_length();
+}
 
-                // get a block to encrypt into
-                auto view = ct.slice_view(header_size + iv_size, length + block_size - length % block_size + block_size - padding - iv_size);
+size_t TLSv12::record_tailroom() const
+{
+    if (!m_context.cipher_spec_set || !m_context.crypto.created)
+        return 0;
+    // A CBC record always has at least one byte of padding, and at most a whole block of it.
+    return is_aead() ? aead_tag_length : mac_length() + m_aes_local->cipher().block_size();
+}
 
-                // encrypt the message
-                m_aes_local->encrypt(buffer, view, iv);
+size_t TLSv12::seal_record(u8* record, size_t plain_length)
+{
+    constexpr size_t header_size = 5;
+    auto headroom = record_headroom();
+    auto* plain = record + header_size + headroom;
+    u64 sequence_number = convert_between_host_and_network(m_context.local_sequence_number);
+    size_t length;
+
+    if (is_aead()) {
+        // RFC 5246 6.2.3.3: the record carries the explicit part of the nonce, then the ciphertext with its tag.
+        // The sequence number makes a fine explicit nonce, since it never repeats under the same key.
+        memcpy(record + header_size, &sequence_number, headroom);
+
+        u8 nonce[12];
+        compute_aead_nonce(nonce, m_context.crypto.local_iv, (const u8*)&sequence_number);
+
+        u8 additional_data[13];
+        memcpy(additional_data, &sequence_number, sizeof(u64));
+        memcpy(additional_data + sizeof(u64), record, header_size - 2);
+        *(u16*)(additional_data + 11) = convert_between_host_and_network((u16)plain_length);
+
+        auto text = ByteBuffer::wrap(plain, plain_length);
+        auto tag = ByteBuffer::wrap(plain + plain_length, aead_tag_length);
+        auto nonce_buffer = ByteBuffer::wrap(nonce, sizeof(nonce));
+        auto additional_data_buffer = ByteBuffer::wrap(additional_data, sizeof(additional_data));
+        if (m_chacha20_poly1305_local)
+            m_chacha20_poly1305_local->encrypt(text, text, nonce_buffer, additional_data_buffer, tag);
+        else
+            m_aes_gcm_local->encrypt(text, text, nonce_buffer, additional_data_buffer, tag);
+
+        length = headroom + plain_length + aead_tag_length;
+    } else {
+        // RFC 5246 6.2.3.2: a random IV, then the plaintext, its MAC and the padding, encrypted together.
+        AK::fill_with_random(record + header_size, headroom);
+
+        *(u16*)(record + header_size - 2) = convert_between_host_and_network((u16)plain_length);
+        auto mac = hmac_message(ByteBuffer::wrap(record, header_size), ByteBuffer::wrap(plain, plain_length), mac_length(), true);
+        memcpy(plain + plain_length, mac.data(), mac.size());
+
+        auto block_size = m_aes_local->cipher().block_size();
+        auto text_length = plain_length + mac.size();
+        auto padding = block_size - text_length % block_size;
+        memset(plain + text_length, padding - 1, padding);
+        text_length += padding;
+
+        auto text = ByteBuffer::wrap(plain, text_length);
+        m_aes_local->encrypt(text, text, ByteBuffer::wrap(record + header_size, headroom));
+
+        length = headroom + text_length;
+    }
 
-                // store the correct ciphertext length into the packet
-                u16 ct_length = (u16)ct.size() - header_size;
-                *(u16*)ct.offset_pointer(header_size - 2) = convert_between_host_and_network(ct_length);
+    *(u16*)(record + header_size - 2) = convert_between_host_and_network((u16)length);
+    return header_size + length;
+}
 
-                // replace the packet with the ciphertext
-                packet = ct;
-            }
-        }
-    }
+void TLSv12::seal_application_record(const u8* data, size_t length)
+{
+    ASSERT(length <= max_record_plaintext_length);
+    constexpr size_t header_size = 5;
+
+    // The record is laid out and sealed right where it is going to be sent from.
+    auto& buffer = m_context.tls_buffer;
+    auto offset = buffer.size();
+    buffer.grow(offset + header_size + record_headroom() + length + record_tailroom());
+    auto* record = buffer.offset_pointer(offset);
+    record[0] = (u8)MessageType::ApplicationData;
+    *(u16*)(record + 1) = convert_between_host_and_network((u16)m_context.version);
+    *(u16*)(record + 3) = convert_between_host_and_network((u16)length);
+    memcpy(record + header_size + record_headroom(), data, length);
+    if (m_context.cipher_spec_set && m_context.crypto.created)
+        buffer.trim(offset + seal_record(record, length));
+    else
+        buffer.trim(offset + header_size + length);
+
+    ++m_context.record_statistics.records_sent;
+    m_context.record_statistics.application_bytes_sent += length;
     ++m_context.local_sequence_number;
 }
 
+void TLSv12::seal_pending_application_data()
+{
+    auto& pending = m_context.pending_application_data;
+    if (!pending.size())
+        return;
+    seal_application_record(pending.data(), pending.size());
+    pending.trim(0);
+}
+
 void TLSv12::update_hash(const ByteBuffer& message)
 {
     m_context.handshake_hash.update(message);
 }
 
+void TLSv12::compute_aead_nonce(u8* nonce, const u8* iv, const u8* record_nonce) const
+{
+    if (aead_explicit_nonce_length()) {
+        // RFC 5288: the implicit part from the key block, followed by the explicit part.
+        memcpy(nonce, iv, iv_length());
+        memcpy(nonce + iv_length(), record_nonce, aead_explicit_nonce_length());
+        return;
+    }
+
+    // RFC 7905: the sequence number, padded on the left to the size of the IV, XORed with the IV.
+    memcpy(nonce, iv, iv_length());
+    for (size_t i = 0; i < sizeof(u64); ++i)
+        nonce[iv_length() - sizeof(u64) + i] ^= record_nonce[i];
+}
+
 ByteBuffer TLSv12::hmac_message(const ByteBuffer& buf, const Optional<ByteBuffer> buf2, size_t mac_length, bool local)
 {
     u64 sequence_number = convert_between_host_and_network(local ? m_context.local_sequence_number : m_context.remote_sequence_number);
@@ -169,7 +233,7 @@ ByteBuffer TLSv12::hmac_message(const ByteBuffer& buf, const Optional<ByteBuffer
     return mac;
 }
 
-ssize_t TLSv12::handle_message(const ByteBuffer& buffer)
+ssize_t TLSv12::handle_message(ByteBuffer& buffer)
 {
     auto res { 5ll };
     size_t header_size = res;
@@ -205,12 +269,61 @@ ssize_t TLSv12::handle_message(const ByteBuffer& buffer)
         return (i8)Error::NeedMoreData;
     }
 
+    ++m_context.record_statistics.records_received;
+    m_context.record_statistics.bytes_received += header_size + length;
+
 #ifdef TLS_DEBUG
     dbg() << "message type: " << (u8)type << ", length: " << length;
 #endif
     ByteBuffer plain = buffer.slice_view(buffer_position, buffer.size() - buffer_position);
 
-    if (m_context.cipher_spec_set && type != MessageType::ChangeCipher) {
+    if (m_context.cipher_spec_set && type != MessageType::ChangeCipher && is_aead()) {
+#ifdef TLS_DEBUG
+        dbg() << "Encrypted: ";
+        print_buffer(buffer.slice_view(header_size, length));
+#endif
+
+        ASSERT(m_aes_gcm_remote || m_chacha20_poly1305_remote);
+        auto explicit_nonce_length = aead_explicit_nonce_length();
+        if (length < explicit_nonce_length + aead_tag_length) {
+            dbg() << "broken packet";
+            auto packet = build_alert(true, (u8)AlertDescription::DecryptError);
+            write_packet(packet);
+            return (i8)Error::BrokenPacket;
+        }
+        size_t plain_length = length - explicit_nonce_length - aead_tag_length;
+        u64 sequence_number = convert_between_host_and_network(m_context.remote_sequence_number);
+
+        u8 nonce[12];
+        compute_aead_nonce(nonce, m_context.crypto.remote_iv, explicit_nonce_length ? buffer.offset_pointer(header_size) : (const u8*)&sequence_number);
+
+        u8 additional_data[13];
+        memcpy(additional_data, &sequence_number, sizeof(u64));
+        memcpy(additional_data + sizeof(u64), buffer.offset_pointer(0), header_size - 2);
+        *(u16*)(additional_data + 11) = convert_between_host_and_network((u16)plain_length);
+
+        // The record is decrypted where it is, in the message buffer.
+        auto decrypted = buffer.slice_view(header_size + explicit_nonce_length, plain_length);
+        auto tag = buffer.slice_view(header_size + explicit_nonce_length + plain_length, aead_tag_length);
+        auto nonce_buffer = ByteBuffer::wrap(nonce, sizeof(nonce));
+        auto additional_data_buffer = ByteBuffer::wrap(additional_data, sizeof(additional_data));
+        bool authentic = m_chacha20_poly1305_remote
+            ? m_chacha20_poly1305_remote->decrypt(decrypted, decrypted, nonce_buffer, additional_data_buffer, tag)
+            : m_aes_gcm_remote->decrypt(decrypted, decrypted, nonce_buffer, additional_data_buffer, tag);
+        if (!authentic) {
+            dbg() << "integrity check failed (tag mismatch)";
+            auto packet = build_alert(true, (u8)AlertDescription::BadRecordMAC);
+            write_packet(packet);
+
+            return (i8)Error::IntegrityCheckFailed;
+        }
+
+#ifdef TLS_DEBUG
+        dbg() << "Decrypted: ";
+        print_buffer(decrypted);
+#endif
+        plain = decrypted;
+    } else if (m_context.cipher_spec_set && type != MessageType::ChangeCipher) {
 #ifdef TLS_DEBUG
         dbg() << "Encrypted: ";
         print_buffer(buffer.slice_view(header_size, length));
@@ -218,11 +331,19 @@ ssize_t TLSv12::handle_message(const ByteBuffer& buffer)
 
         ASSERT(m_aes_remote);
         auto iv_size = iv_length();
+        auto block_size = m_aes_remote->cipher().block_size();
+        if (length < iv_size + block_size || (length - iv_size) % block_size != 0) {
+            dbg() << "broken packet";
+            auto packet = build_alert(true, (u8)AlertDescription::DecryptError);
+            write_packet(packet);
+            return (i8)Error::BrokenPacket;
+        }
 
-        auto decrypted = m_aes_remote->create_aligned_buffer(length - iv_size);
+        // The record is decrypted where it is, in the message buffer.
+        auto decrypted = buffer.slice_view(header_size + iv_size, length - iv_size);
         auto iv = buffer.slice_view(header_size, iv_size);
 
-        m_aes_remote->decrypt(buffer.slice_view(header_size + iv_size, length - iv_size), decrypted, iv);
+        m_aes_remote->decrypt(decrypted, decrypted, iv);
 
         length = decrypted.size();
 
@@ -239,13 +360,18 @@ ssize_t TLSv12::handle_message(const ByteBuffer& buffer)
             return (i8)Error::BrokenPacket;
         }
 
-        const u8* message_hmac = decrypted.offset_pointer(length - mac_size);
+        // The MAC covers the record header and the plaintext, with the length of the plaintext alone.
+        size_t plain_length = length - mac_size;
+        const u8* message_hmac = decrypted.offset_pointer(plain_length);
         u8 temp_buf[5];
         memcpy(temp_buf, buffer.offset_pointer(0), 3);
-        *(u16*)(temp_buf + 3) = convert_between_host_and_network(length);
-        auto hmac = hmac_message(ByteBuffer::wrap(temp_buf, 5), decrypted, mac_size);
+        *(u16*)(temp_buf + 3) = convert_between_host_and_network((u16)plain_length);
+        auto hmac = hmac_message(ByteBuffer::wrap(temp_buf, 5), decrypted.slice_view(0, plain_length), mac_size);
         auto message_mac = ByteBuffer::wrap(message_hmac, mac_size);
-        if (hmac != message_mac) {
+        u8 difference = 0;
+        for (size_t i = 0; i < mac_size; ++i)
+            difference |= hmac[i] ^ message_hmac[i];
+        if (difference != 0) {
             dbg() << "integrity check failed (mac length " << length << ")";
             dbg() << "mac received:";
             print_buffer(message_mac);
@@ -256,7 +382,7 @@ ssize_t TLSv12::handle_message(const ByteBuffer& buffer)
 
             return (i8)Error::IntegrityCheckFailed;
         }
-        plain = decrypted.slice(0, length - mac_size);
+        plain = decrypted.slice_view(0, plain_length);
     }
     m_context.remote_sequence_number++;
 
@@ -273,6 +399,7 @@ ssize_t TLSv12::handle_message(const ByteBuffer& buffer)
 #endif
 
             m_context.application_buffer.append(plain.data(), plain.size());
+            m_context.record_statistics.application_bytes_received += plain.size();
         }
         break;
     case MessageType::Handshake:
@@ -311,7 +438,8 @@ ssize_t TLSv12::handle_message(const ByteBuffer& buffer)
             if (code == 0) {
                 // close notify
                 res += 2;
-                alert(AlertLevel::Critical, AlertDescription::CloseNotify);
+                // Our answer has to be a warning too, a fatal alert makes the server throw the session away.
+                alert(AlertLevel::Warning, AlertDescription::CloseNotify);
                 m_context.connection_finished = true;
             }
             m_context.error_code = (Error)code;
@@ -82,12 +82,27 @@ bool TLSv12::write(const ByteBuffer& buffer)
         return false;
     }
 
-    PacketBuilder builder { MessageType::ApplicationData, m_context.version, buffer.size() };
-    builder.append(buffer);
-    auto packet = builder.build();
+    const u8* data = buffer.data();
+    size_t length = buffer.size();
+    auto& pending = m_context.pending_application_data;
+
+    // Top up what is already pending; whole records after that are sealed straight from the caller's buffer.
+    if (pending.size()) {
+        auto to_copy = min(length, max_record_plaintext_length - pending.size());
+        pending.append(data, to_copy);
+        data += to_copy;
+        length -= to_copy;
+        if (pending.size() == max_record_plaintext_length)
+            seal_pending_application_data();
+    }
+    for (; length >= max_record_plaintext_length; length -= max_record_plaintext_length, data += max_record_plaintext_length)
+        seal_application_record(data, max_record_plaintext_length);
+    pending.append(data, length);
 
-    update_packet(packet);
-    write_packet(packet);
+    if (!m_has_scheduled_write_flush) {
+        deferred_invoke([this](auto&) { write_into_socket(); });
+        m_has_scheduled_write_flush = true;
+    }
 
     return true;
 }
@@ -95,9 +110,18 @@ bool TLSv12::write(const ByteBuffer& buffer)
 bool TLSv12::connect(const String& hostname, int port)
 {
     set_sni(hostname);
+    m_context.session_cache_key = String::format("%s:%d", hostname.characters(), port);
     return Core::Socket::connect(hostname, port);
 }
 
+void TLSv12::set_notifications_enabled(bool enabled)
+{
+    Core::Socket::set_notifications_enabled(enabled);
+    // What was decrypted before we were muted won't make the socket readable again.
+    if (enabled && m_context.application_buffer.size())
+        deferred_invoke([&](auto&) { read_from_socket(); });
+}
+
 bool TLSv12::common_connect(const struct sockaddr* saddr, socklen_t length)
 {
     if (m_context.critical_error)
@@ -149,7 +173,11 @@ bool TLSv12::common_connect(const struct sockaddr* saddr, socklen_t length)
 
 void TLSv12::read_from_socket()
 {
-    if (m_context.application_buffer.size() > 0) {
+    if (!notifications_enabled())
+        return;
+
+    bool had_application_data = m_context.application_buffer.size() > 0;
+    if (had_application_data) {
         deferred_invoke([&](auto&) { read_from_socket(); });
         if (on_tls_ready_to_read)
             on_tls_ready_to_read(*this);
@@ -158,7 +186,12 @@ void TLSv12::read_from_socket()
     if (!check_connection_state(true))
         return;
 
-    consume(Core::Socket::read(4096));
+    consume(Core::Socket::read(max_record_plaintext_length));
+
+    // Don't wait for the socket to become readable again before handing this over: on a connection that's
+    // kept open, the peer may have nothing more to send until it hears back.
+    if (!had_application_data && m_context.application_buffer.size() > 0)
+        deferred_invoke([&](auto&) { read_from_socket(); });
 }
 
 void TLSv12::write_into_socket()
@@ -169,6 +202,7 @@ void TLSv12::write_into_socket()
     m_has_scheduled_write_flush = false;
     if (!check_connection_state(false))
         return;
+    seal_pending_application_data();
     flush();
 
     if (!is_established())
@@ -233,7 +267,9 @@ bool TLSv12::flush()
     print_buffer(out_buffer, out_buffer_length);
 #endif
     if (Core::Socket::write(&out_buffer[out_buffer_index], out_buffer_length)) {
-        write_buffer().clear();
+        m_context.record_statistics.bytes_sent += out_buffer_length;
+        // Keep the allocation around for the next records.
+        write_buffer().trim(0);
         return true;
     }
     if (m_context.send_retries++ == 10) {
@@ -545,7 +545,8 @@ void TLSv12::consume(const ByteBuffer& record)
 #endif
             break;
         }
-        auto consumed = handle_message(m_context.message_buffer.slice_view(index, length));
+        auto message = m_context.message_buffer.slice_view(index, length);
+        auto consumed = handle_message(message);
 
 #ifdef TLS_DEBUG
         if (consumed > 0)
@@ -581,7 +582,10 @@ void TLSv12::consume(const ByteBuffer& record)
     }
 
     if (index) {
-        m_context.message_buffer = m_context.message_buffer.slice(index, m_context.message_buffer.size() - index);
+        // Move the incomplete record that is left to the front, keeping the buffer for what comes next.
+        auto remaining = m_context.message_buffer.size() - index;
+        memmove(m_context.message_buffer.data(), m_context.message_buffer.offset_pointer(index), remaining);
+        m_context.message_buffer.trim(remaining);
     }
 }
 
@@ -27,6 +27,7 @@
 #pragma once
 
 #include <AK/IPv4Address.h>
+#include <AK/Optional.h>
 #include <AK/WeakPtr.h>
 #include <LibCore/Notifier.h>
 #include <LibCore/Socket.h>
@@ -34,6 +35,7 @@
 #include <LibCrypto/Authentication/HMAC.h>
 #include <LibCrypto/BigInt/UnsignedBigInteger.h>
 #include <LibCrypto/Cipher/AES.h>
+#include <LibCrypto/Cipher/ChaCha20.h>
 #include <LibCrypto/Hash/HashManager.h>
 #include <LibCrypto/PK/RSA.h>
 #include <LibTLS/TLSPacketBuilder.h>
@@ -68,8 +70,10 @@ enum class CipherSuite {
     RSA_WITH_AES_256_CBC_SHA = 0x0035,
     RSA_WITH_AES_128_CBC_SHA256 = 0x003C,
     RSA_WITH_AES_256_CBC_SHA256 = 0x003D,
-    // TODO
     RSA_WITH_AES_128_GCM_SHA256 = 0x009C,
+    ECDHE_RSA_WITH_AES_128_GCM_SHA256 = 0xC02F,
+    ECDHE_RSA_WITH_CHACHA20_POLY1305_SHA256 = 0xCCA8,
+    // TODO
     RSA_WITH_AES_256_GCM_SHA384 = 0x009D,
 };
 
@@ -155,6 +159,7 @@ enum HandshakeType {
     ClientHello = 0x01,
     ServerHello = 0x02,
     HelloVerifyRequest = 0x03,
+    NewSessionTicket = 0x04,
     CertificateMessage = 0x0b,
     ServerKeyExchange = 0x0c,
     CertificateRequest = 0x0d,
@@ -167,7 +172,24 @@ enum HandshakeType {
 enum class HandshakeExtension : u16 {
     ServerName = 0x00,
     ApplicationLayerProtocolNegotiation = 0x10,
+    SupportedGroups = 0x0a,
+    ECPointFormats = 0x0b,
     SignatureAlgorithms = 0x0d,
+    SessionTicket = 0x23,
+};
+
+enum class NamedCurve : u16 {
+    X25519 = 0x001d,
+};
+
+enum class ECCurveType : u8 {
+    NamedCurve = 3,
+};
+
+enum class SignatureScheme : u16 {
+    RSA_PKCS1_SHA1 = 0x0201,
+    RSA_PKCS1_SHA256 = 0x0401,
+    RSA_PKCS1_SHA512 = 0x0601,
 };
 
 enum class WritePacketStage {
@@ -230,6 +252,27 @@ struct Certificate {
     bool is_valid() const;
 };
 
+// What it takes to resume a session with an abbreviated handshake, skipping the certificate and the key exchange.
+struct CachedSession {
+    u8 session_id[32];
+    u8 session_id_size { 0 };
+    // An RFC 5077 ticket, if the server issued one. It holds the session state encrypted for the server itself.
+    ByteBuffer ticket;
+    ByteBuffer master_key;
+    CipherSuite cipher { CipherSuite::Invalid };
+    time_t expires_at { 0 };
+};
+
+// Running totals for a connection. The byte counts on the wire include record headers, MACs and handshakes.
+struct RecordStatistics {
+    u64 records_sent { 0 };
+    u64 records_received { 0 };
+    u64 bytes_sent { 0 };
+    u64 bytes_received { 0 };
+    u64 application_bytes_sent { 0 };
+    u64 application_bytes_received { 0 };
+};
+
 struct Context {
     String to_string() const;
     bool verify() const;
@@ -250,6 +293,8 @@ struct Context {
     Vector<Certificate> client_certificates;
     ByteBuffer master_key;
     ByteBuffer premaster_key;
+    // The server's ephemeral X25519 key from its ServerKeyExchange, for the ECDHE suites.
+    ByteBuffer server_ecdhe_public_key;
     u8 cipher_spec_set { 0 };
     struct {
         int created { 0 };
@@ -272,11 +317,23 @@ struct Context {
     ByteBuffer tls_buffer;
 
     ByteBuffer application_buffer;
+    // Application data written since the last flush; it is sealed into a record when the event loop comes round,
+    // so that a series of small writes shares one.
+    ByteBuffer pending_application_data;
+
+    RecordStatistics record_statistics;
 
     bool is_child { false };
 
     String SNI; // I hate your existence
 
+    // "host:port", under which the session is cached for later connections to the same server.
+    String session_cache_key;
+    Optional<CachedSession> offered_session;
+    bool resuming_session { false };
+    ByteBuffer new_session_ticket;
+    u32 new_session_ticket_lifetime { 0 };
+
     u8 request_client_certificate { 0 };
 
     ByteBuffer cached_handshake;
@@ -304,6 +361,7 @@ public:
     ByteBuffer& write_buffer() { return m_context.tls_buffer; }
     bool is_established() const { return m_context.connection_status == ConnectionStatus::Established; }
     virtual bool connect(const String&, int) override;
+    virtual void set_notifications_enabled(bool) override;
 
     void set_sni(const StringView& sni)
     {
@@ -326,7 +384,7 @@ public:
 
     bool supports_cipher(CipherSuite suite) const
     {
-        return suite == CipherSuite::RSA_WITH_AES_128_CBC_SHA256 || suite == CipherSuite::RSA_WITH_AES_256_CBC_SHA256 || suite == CipherSuite::RSA_WITH_AES_128_CBC_SHA || suite == CipherSuite::RSA_WITH_AES_256_CBC_SHA;
+        return suite == CipherSuite::ECDHE_RSA_WITH_CHACHA20_POLY1305_SHA256 || suite == CipherSuite::ECDHE_RSA_WITH_AES_128_GCM_SHA256 || suite == CipherSuite::RSA_WITH_AES_128_GCM_SHA256 || suite == CipherSuite::RSA_WITH_AES_128_CBC_SHA256 || suite == CipherSuite::RSA_WITH_AES_256_CBC_SHA256 || suite == CipherSuite::RSA_WITH_AES_128_CBC_SHA || suite == CipherSuite::RSA_WITH_AES_256_CBC_SHA;
     }
 
     bool supports_version(Version v) const
@@ -340,6 +398,8 @@ public:
     bool write(const ByteBuffer& buffer);
     void alert(AlertLevel, AlertDescription);
 
+    const RecordStatistics& record_statistics() const { return m_context.record_statistics; }
+
     bool can_read_line() const { return m_context.application_buffer.size() && memchr(m_context.application_buffer.data(), '\n', m_context.application_buffer.size()); }
     bool can_read() const { return m_context.application_buffer.size() > 0; }
     ByteBuffer read_line(size_t max_size);
@@ -363,6 +423,19 @@ private:
     void update_packet(ByteBuffer& packet);
     void update_hash(const ByteBuffer& in);
 
+    // RFC 5246 6.2.1: a record carries at most 2^14 bytes of plaintext.
+    static constexpr size_t max_record_plaintext_length = 16384;
+
+    // How much room an encrypted record needs in front of its plaintext (the explicit nonce or IV), and after it
+    // (the tag, or the MAC and padding).
+    size_t record_headroom() const;
+    size_t record_tailroom() const;
+    // Encrypts the record in place. Its plaintext is at record_headroom() after the header, with record_tailroom()
+    // bytes to spare behind it. Returns the size of the sealed record.
+    size_t seal_record(u8* record, size_t plain_length);
+    void seal_application_record(const u8* data, size_t length);
+    void seal_pending_application_data();
+
     void write_packet(ByteBuffer& packet);
 
     ByteBuffer build_client_key_exchange();
@@ -376,6 +449,7 @@ private:
     ByteBuffer build_change_cipher_spec();
     ByteBuffer build_verify_request();
     void build_random(PacketBuilder&);
+    void build_ecdhe_key_share(PacketBuilder&);
 
     bool flush();
     void write_into_socket();
@@ -390,8 +464,13 @@ private:
     ssize_t handle_server_hello_done(const ByteBuffer& buffer);
     ssize_t handle_verify(const ByteBuffer& buffer);
     ssize_t handle_payload(const ByteBuffer& buffer);
-    ssize_t handle_message(const ByteBuffer& buffer);
+    ssize_t handle_message(ByteBuffer& buffer);
     ssize_t handle_random(const ByteBuffer& buffer);
+    ssize_t handle_new_session_ticket(const ByteBuffer& buffer);
+
+    void offer_cached_session();
+    bool resume_offered_session();
+    void cache_session();
 
     size_t asn1_length(const ByteBuffer& buffer, size_t* octets);
 
@@ -407,12 +486,14 @@ private:
         case CipherSuite::RSA_WITH_AES_128_CBC_SHA256:
         case CipherSuite::RSA_WITH_AES_128_CBC_SHA:
         case CipherSuite::RSA_WITH_AES_128_GCM_SHA256:
+        case CipherSuite::ECDHE_RSA_WITH_AES_128_GCM_SHA256:
         default:
             return 128 / 8;
         case CipherSuite::AES_256_GCM_SHA384:
         case CipherSuite::RSA_WITH_AES_256_CBC_SHA:
         case CipherSuite::RSA_WITH_AES_256_CBC_SHA256:
         case CipherSuite::RSA_WITH_AES_256_GCM_SHA384:
+        case CipherSuite::ECDHE_RSA_WITH_CHACHA20_POLY1305_SHA256:
             return 256 / 8;
         }
     }
@@ -422,15 +503,19 @@ private:
         case CipherSuite::RSA_WITH_AES_128_CBC_SHA:
         case CipherSuite::RSA_WITH_AES_256_CBC_SHA:
             return Crypto::Hash::SHA1::digest_size();
-        case CipherSuite::AES_256_GCM_SHA384:
+        case CipherSuite::RSA_WITH_AES_128_GCM_SHA256:
         case CipherSuite::RSA_WITH_AES_256_GCM_SHA384:
+        case CipherSuite::ECDHE_RSA_WITH_AES_128_GCM_SHA256:
+        case CipherSuite::ECDHE_RSA_WITH_CHACHA20_POLY1305_SHA256:
+            // AEAD records carry no separate MAC.
+            return 0;
+        case CipherSuite::AES_256_GCM_SHA384:
             return Crypto::Hash::SHA512::digest_size();
         case CipherSuite::AES_128_CCM_8_SHA256:
         case CipherSuite::AES_128_CCM_SHA256:
         case CipherSuite::AES_128_GCM_SHA256:
         case CipherSuite::Invalid:
         case CipherSuite::RSA_WITH_AES_128_CBC_SHA256:
-        case CipherSuite::RSA_WITH_AES_128_GCM_SHA256:
         case CipherSuite::RSA_WITH_AES_256_CBC_SHA256:
         default:
             return Crypto::Hash::SHA256::digest_size();
@@ -450,11 +535,36 @@ private:
             return 16;
         case CipherSuite::AES_128_GCM_SHA256:
         case CipherSuite::AES_256_GCM_SHA384:
+        case CipherSuite::ECDHE_RSA_WITH_CHACHA20_POLY1305_SHA256:
+            return 12;
         case CipherSuite::RSA_WITH_AES_128_GCM_SHA256:
         case CipherSuite::RSA_WITH_AES_256_GCM_SHA384:
-            return 12;
+        case CipherSuite::ECDHE_RSA_WITH_AES_128_GCM_SHA256:
+            // Only the implicit part of the nonce comes from the key block, the rest is sent with every record (RFC 5288).
+            return 4;
         }
     }
+    bool is_aead() const
+    {
+        return m_context.cipher == CipherSuite::RSA_WITH_AES_128_GCM_SHA256 || m_context.cipher == CipherSuite::RSA_WITH_AES_256_GCM_SHA384 || m_context.cipher == CipherSuite::ECDHE_RSA_WITH_AES_128_GCM_SHA256 || uses_chacha20_poly1305();
+    }
+    bool uses_chacha20_poly1305() const
+    {
+        return m_context.cipher == CipherSuite::ECDHE_RSA_WITH_CHACHA20_POLY1305_SHA256;
+    }
+    bool uses_ecdhe() const
+    {
+        return m_context.cipher == CipherSuite::ECDHE_RSA_WITH_AES_128_GCM_SHA256 || m_context.cipher == CipherSuite::ECDHE_RSA_WITH_CHACHA20_POLY1305_SHA256;
+    }
+
+    // Length of the per-record part of an AEAD nonce, and of the tag that follows the ciphertext.
+    // ChaCha20-Poly1305 records send no nonce, it is derived from the sequence number (RFC 7905).
+    size_t aead_explicit_nonce_length() const { return uses_chacha20_poly1305() ? 0 : 8; }
+    static constexpr size_t aead_tag_length = Crypto::Cipher::AESCipher::GCMMode::TagSizeInBytes;
+    static_assert(aead_tag_length == Crypto::Cipher::ChaCha20Poly1305::TagSizeInBytes);
+
+    // `record_nonce` is the explicit nonce of a received record, or else the big-endian sequence number.
+    void compute_aead_nonce(u8* nonce, const u8* iv, const u8* record_nonce) const;
 
     bool expand_key();
 
@@ -470,6 +580,12 @@ private:
     OwnPtr<Crypto::Cipher::AESCipher::CBCMode> m_aes_local;
     OwnPtr<Crypto::Cipher::AESCipher::CBCMode> m_aes_remote;
 
+    OwnPtr<Crypto::Cipher::AESCipher::GCMMode> m_aes_gcm_local;
+    OwnPtr<Crypto::Cipher::AESCipher::GCMMode> m_aes_gcm_remote;
+
+    OwnPtr<Crypto::Cipher::ChaCha20Poly1305> m_chacha20_poly1305_local;
+    OwnPtr<Crypto::Cipher::ChaCha20Poly1305> m_chacha20_poly1305_remote;
+
     bool m_has_scheduled_write_flush { false };
     i32 m_max_wait_time_for_handshake_in_seconds { 10 };
 
@@ -48,10 +48,11 @@ class BackgroundActionBase {
 private:
     BackgroundActionBase() {}
 
-    static Lockable<Queue<Function<void()>>>& all_actions();
+    static void enqueue_work(Function<void()>);
     static Thread& background_thread();
 };
 
+// Runs an action on the shared ThreadPool, then hands its result to on_complete back on the event loop.
 template<typename Result>
 class BackgroundAction final : public Core::Object
     , private BackgroundActionBase {
@@ -73,19 +74,14 @@ private:
         , m_action(move(action))
         , m_on_complete(move(on_complete))
     {
-        LOCKER(all_actions().lock());
-
-        all_actions().resource().enqueue([this] {
+        enqueue_work([this] {
             m_result = m_action();
-            if (m_on_complete) {
-                Core::EventLoop::current().post_event(*this, make<Core::DeferredInvocationEvent>([this](auto&) {
+            // Even without a completion handler, we're only ever unparented on the event loop's thread.
+            Core::EventLoop::post_event_to_current_loop(*this, make<Core::DeferredInvocationEvent>([this](auto&) {
+                if (m_on_complete)
                     m_on_complete(m_result.release_value());
-                    this->remove_from_parent();
-                }));
-                Core::EventLoop::wake();
-            } else {
                 this->remove_from_parent();
-            }
+            }));
         });
     }
 
@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/Atomic.h>
+#include <LibThread/ParallelFor.h>
+#include <LibThread/ThreadPool.h>
+#include <pthread.h>
+
+namespace {
+
+// Shared between the caller and its helper tasks. A helper may only get to run once the batch is over,
+// so the last one out deletes it.
+struct Batch {
+    Function<void(size_t)>* job { nullptr };
+    size_t count { 0 };
+    AK::Atomic<size_t> next_index { 0 };
+    AK::Atomic<u32> ref_count { 1 };
+
+    pthread_mutex_t mutex;
+    pthread_cond_t finished;
+    size_t finished_count { 0 };
+
+    Batch()
+    {
+        pthread_mutex_init(&mutex, nullptr);
+        pthread_cond_init(&finished, nullptr);
+    }
+
+    ~Batch()
+    {
+        pthread_cond_destroy(&finished);
+        pthread_mutex_destroy(&mutex);
+    }
+
+    void unref()
+    {
+        if (ref_count.fetch_sub(1) == 1)
+            delete this;
+    }
+
+    size_t run_jobs()
+    {
+        size_t done = 0;
+        for (;;) {
+            size_t index = next_index.fetch_add(1);
+            if (index >= count)
+                return done;
+            (*job)(index);
+            ++done;
+        }
+    }
+
+    void did_finish(size_t done)
+    {
+        pthread_mutex_lock(&mutex);
+        finished_count += done;
+        if (finished_count == count)
+            pthread_cond_signal(&finished);
+        pthread_mutex_unlock(&mutex);
+    }
+};
+
+}
+
+void LibThread::parallel_for(size_t count, Function<void(size_t)> job)
+{
+    if (count <= 1) {
+        if (count)
+            job(0);
+        return;
+    }
+
+    auto* batch = new Batch;
+    batch->job = &job;
+    batch->count = count;
+
+    size_t helper_count = min(count - 1, ThreadPool::thread_count);
+    batch->ref_count.fetch_add(helper_count);
+    for (size_t i = 0; i < helper_count; ++i) {
+        ThreadPool::the().submit([batch] {
+            if (size_t done = batch->run_jobs())
+                batch->did_finish(done);
+            batch->unref();
+        });
+    }
+
+    // We take part as well, so the batch finishes even if every worker is busy with something else.
+    batch->did_finish(batch->run_jobs());
+
+    pthread_mutex_lock(&batch->mutex);
+    while (batch->finished_count < count)
+        pthread_cond_wait(&batch->finished, &batch->mutex);
+    pthread_mutex_unlock(&batch->mutex);
+    batch->unref();
+}
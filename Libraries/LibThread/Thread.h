@@ -42,6 +42,7 @@ public:
 
     void start();
     void quit(void *code = 0);
+    pthread_t tid() const { return m_tid; }
 
 private:
     Function<int()> m_action;
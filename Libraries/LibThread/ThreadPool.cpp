@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <LibThread/ThreadPool.h>
+
+namespace LibThread {
+
+static __thread int s_current_worker_index = -1;
+
+ThreadPool& ThreadPool::the()
+{
+    static ThreadPool* s_the;
+    static pthread_once_t s_once = PTHREAD_ONCE_INIT;
+    pthread_once(&s_once, [] { s_the = new ThreadPool; });
+    return *s_the;
+}
+
+ThreadPool::ThreadPool()
+{
+    pthread_mutex_init(&m_idle_mutex, nullptr);
+    pthread_cond_init(&m_work_available, nullptr);
+    for (size_t i = 0; i < thread_count; ++i)
+        pthread_mutex_init(&m_workers[i].mutex, nullptr);
+
+    for (size_t i = 0; i < thread_count; ++i) {
+        auto& worker = m_workers[i];
+        worker.thread = Thread::construct([this, i] {
+            worker_loop(i);
+            return 0;
+        });
+        worker.thread->set_name("Worker thread");
+        worker.thread->start();
+    }
+}
+
+void ThreadPool::submit(Function<void()> task)
+{
+    size_t index = s_current_worker_index >= 0 ? s_current_worker_index : m_next_worker.fetch_add(1) % thread_count;
+    auto& worker = m_workers[index];
+    pthread_mutex_lock(&worker.mutex);
+    worker.tasks.enqueue(move(task));
+    pthread_mutex_unlock(&worker.mutex);
+
+    pthread_mutex_lock(&m_idle_mutex);
+    ++m_queued_task_count;
+    pthread_cond_signal(&m_work_available);
+    pthread_mutex_unlock(&m_idle_mutex);
+}
+
+Function<void()> ThreadPool::take_task(size_t index)
+{
+    // Our own queue first, then everybody else's, starting with our neighbour.
+    for (size_t i = 0; i < thread_count; ++i) {
+        auto& worker = m_workers[(index + i) % thread_count];
+        pthread_mutex_lock(&worker.mutex);
+        Function<void()> task;
+        if (!worker.tasks.is_empty())
+            task = worker.tasks.dequeue();
+        pthread_mutex_unlock(&worker.mutex);
+        if (task)
+            return task;
+    }
+    return nullptr;
+}
+
+void ThreadPool::worker_loop(size_t index)
+{
+    s_current_worker_index = index;
+    for (;;) {
+        auto task = take_task(index);
+        if (!task) {
+            pthread_mutex_lock(&m_idle_mutex);
+            while (!m_queued_task_count)
+                pthread_cond_wait(&m_work_available, &m_idle_mutex);
+            pthread_mutex_unlock(&m_idle_mutex);
+            continue;
+        }
+
+        pthread_mutex_lock(&m_idle_mutex);
+        --m_queued_task_count;
+        pthread_mutex_unlock(&m_idle_mutex);
+
+        task();
+    }
+}
+
+}
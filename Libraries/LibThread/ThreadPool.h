@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#pragma once
+
+#include <AK/Atomic.h>
+#include <AK/Function.h>
+#include <AK/Queue.h>
+#include <AK/RefPtr.h>
+#include <LibThread/Thread.h>
+#include <pthread.h>
+
+namespace LibThread {
+
+// A fixed set of worker threads shared by everything in the process that wants work done off its event loop:
+// BackgroundAction, parallel_for() and anyone calling submit() directly.
+// Every worker has its own task queue, so submitting and taking tasks rarely contend on a lock. Tasks submitted
+// from a worker stay on that worker's queue, the rest are dealt out round-robin, and a worker whose queue runs
+// dry steals from the others before going to sleep.
+// Tasks shouldn't block for long, since each one ties up one of a handful of threads.
+class ThreadPool {
+public:
+    static constexpr size_t thread_count = 4;
+
+    static ThreadPool& the();
+
+    void submit(Function<void()>);
+
+    Thread& thread(size_t index) { return *m_workers[index].thread; }
+
+private:
+    ThreadPool();
+
+    struct Worker {
+        RefPtr<Thread> thread;
+        pthread_mutex_t mutex;
+        Queue<Function<void()>> tasks;
+    };
+
+    void worker_loop(size_t index);
+    Function<void()> take_task(size_t index);
+
+    Worker m_workers[thread_count];
+    Atomic<size_t> m_next_worker { 0 };
+
+    pthread_mutex_t m_idle_mutex;
+    pthread_cond_t m_work_available;
+    size_t m_queued_task_count { 0 };
+};
+
+}
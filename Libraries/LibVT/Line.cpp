@@ -62,6 +62,8 @@ void Line::set_length(u16 new_length)
 {
     if (m_length == new_length)
         return;
+    if (m_is_compact)
+        expand();
 
     if (m_utf32)
         m_codepoints.as_u32 = create_new_codepoint_array<u32>(new_length, m_codepoints.as_u32, m_length);
@@ -76,10 +78,13 @@ void Line::set_length(u16 new_length)
     delete[] m_attributes;
     m_attributes = new_attributes;
     m_length = new_length;
+    m_codepoint_count = new_length;
 }
 
 void Line::clear(Attribute attribute)
 {
+    if (m_is_compact)
+        expand();
     if (m_dirty) {
         for (u16 i = 0; i < m_length; ++i) {
             set_codepoint(i, ' ');
@@ -103,6 +108,14 @@ bool Line::has_only_one_background_color() const
 {
     if (!m_length)
         return true;
+    if (m_is_compact) {
+        auto color = m_attribute_runs[0].attribute.background_color;
+        for (auto& run : m_attribute_runs) {
+            if (run.attribute.background_color != color)
+                return false;
+        }
+        return true;
+    }
     // FIXME: Cache this result?
     auto color = m_attributes[0].background_color;
     for (size_t i = 1; i < m_length; ++i) {
@@ -115,13 +128,80 @@ bool Line::has_only_one_background_color() const
 void Line::convert_to_utf32()
 {
     ASSERT(!m_utf32);
-    auto* new_codepoints = new u32[m_length];
-    for (size_t i = 0; i < m_length; ++i) {
+    auto* new_codepoints = new u32[m_codepoint_count];
+    for (size_t i = 0; i < m_codepoint_count; ++i) {
         new_codepoints[i] = m_codepoints.as_u8[i];
     }
-    delete m_codepoints.as_u8;
+    delete[] m_codepoints.as_u8;
     m_codepoints.as_u32 = new_codepoints;
     m_utf32 = true;
 }
 
+void Line::compact()
+{
+    if (m_is_compact)
+        return;
+
+    size_t codepoint_count = m_length;
+    while (codepoint_count > 0 && codepoint(codepoint_count - 1) == ' ')
+        --codepoint_count;
+    if (codepoint_count != m_length) {
+        if (m_utf32)
+            m_codepoints.as_u32 = create_new_codepoint_array<u32>(codepoint_count, m_codepoints.as_u32, codepoint_count);
+        else
+            m_codepoints.as_u8 = create_new_codepoint_array<u8>(codepoint_count, m_codepoints.as_u8, codepoint_count);
+        m_codepoint_count = codepoint_count;
+    }
+
+    size_t run_count = 0;
+    for (size_t i = 0; i < m_length; ++i) {
+        if (i == 0 || !m_attributes[i].is_identical_to(m_attributes[i - 1]))
+            ++run_count;
+    }
+    m_attribute_runs.ensure_capacity(run_count);
+    for (size_t i = 0; i < m_length; ++i) {
+        if (i == 0 || !m_attributes[i].is_identical_to(m_attributes[i - 1]))
+            m_attribute_runs.unchecked_append({ (u16)i, m_attributes[i] });
+    }
+    delete[] m_attributes;
+    m_attributes = nullptr;
+    m_is_compact = true;
+}
+
+void Line::expand()
+{
+    if (!m_is_compact)
+        return;
+
+    if (m_codepoint_count != m_length) {
+        if (m_utf32)
+            m_codepoints.as_u32 = create_new_codepoint_array<u32>(m_length, m_codepoints.as_u32, m_codepoint_count);
+        else
+            m_codepoints.as_u8 = create_new_codepoint_array<u8>(m_length, m_codepoints.as_u8, m_codepoint_count);
+        m_codepoint_count = m_length;
+    }
+
+    m_attributes = new Attribute[m_length];
+    for (size_t i = 0; i < m_length; ++i)
+        m_attributes[i] = compact_attribute_at(i);
+    m_attribute_runs.clear();
+    m_is_compact = false;
+}
+
+const Attribute& Line::compact_attribute_at(size_t index) const
+{
+    ASSERT(index < m_length);
+    size_t low = 0;
+    size_t high = m_attribute_runs.size();
+    // Find the last run that starts at or before the index; the first one always starts at 0.
+    while (high - low > 1) {
+        size_t middle = low + (high - low) / 2;
+        if (m_attribute_runs[middle].start <= index)
+            low = middle;
+        else
+            high = middle;
+    }
+    return m_attribute_runs[low].attribute;
+}
+
 }
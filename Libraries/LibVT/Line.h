@@ -28,6 +28,7 @@
 
 #include <AK/Noncopyable.h>
 #include <AK/String.h>
+#include <AK/Vector.h>
 #include <LibVT/XtermColors.h>
 
 namespace VT {
@@ -74,6 +75,11 @@ struct Attribute {
     {
         return !(*this == other);
     }
+
+    bool is_identical_to(const Attribute& other) const
+    {
+        return *this == other && href == other.href && href_id == other.href_id;
+    }
 };
 
 class Line {
@@ -92,6 +98,8 @@ public:
 
     u32 codepoint(size_t index) const
     {
+        if (index >= m_codepoint_count)
+            return ' ';
         if (m_utf32)
             return m_codepoints.as_u32[index];
         return m_codepoints.as_u8[index];
@@ -99,6 +107,8 @@ public:
 
     void set_codepoint(size_t index, u32 codepoint)
     {
+        if (m_is_compact)
+            expand();
         if (!m_utf32 && codepoint & 0xffffff80u)
             convert_to_utf32();
 
@@ -111,22 +121,49 @@ public:
     bool is_dirty() const { return m_dirty; }
     void set_dirty(bool b) { m_dirty = b; }
 
-    const Attribute* attributes() const { return m_attributes; }
-    Attribute* attributes() { return m_attributes; }
+    const Attribute& attribute_at(size_t index) const
+    {
+        if (m_is_compact)
+            return compact_attribute_at(index);
+        return m_attributes[index];
+    }
+    void set_attribute_at(size_t index, const Attribute& attribute)
+    {
+        if (m_is_compact)
+            expand();
+        m_attributes[index] = attribute;
+    }
 
     void convert_to_utf32();
 
     bool is_utf32() const { return m_utf32; }
 
+    // Lines in the scrollback don't change anymore, so they only keep the codepoints up to the trailing blanks, and
+    // one attribute for every run of cells that share it. Anything that changes the line expands it again.
+    void compact();
+    void expand();
+    bool is_compact() const { return m_is_compact; }
+
 private:
+    struct AttributeRun {
+        u16 start;
+        Attribute attribute;
+    };
+
+    const Attribute& compact_attribute_at(size_t index) const;
+
     union {
         u8* as_u8;
         u32* as_u32;
     } m_codepoints { nullptr };
     Attribute* m_attributes { nullptr };
+    Vector<AttributeRun> m_attribute_runs;
     bool m_dirty { false };
     bool m_utf32 { false };
+    bool m_is_compact { false };
     u16 m_length { 0 };
+    // Beyond this, the line is blank. It's the same as the length unless the line is compact.
+    u16 m_codepoint_count { 0 };
 };
 
 }
@@ -729,10 +729,7 @@ void Terminal::scroll_up()
     // NOTE: We have to invalidate the cursor first.
     invalidate_cursor();
     if (m_scroll_region_top == 0) {
-        auto line = move(m_lines.ptr_at(m_scroll_region_top));
-        m_history.append(move(line));
-        while (m_history.size() > max_history_size())
-            m_history.take_first();
+        add_line_to_history(move(m_lines.ptr_at(m_scroll_region_top)));
         m_client.terminal_history_changed();
     }
     m_lines.remove(m_scroll_region_top);
@@ -740,6 +737,39 @@ void Terminal::scroll_up()
     m_need_full_flush = true;
 }
 
+void Terminal::add_line_to_history(NonnullOwnPtr<Line> line)
+{
+    if (!max_history_size())
+        return;
+    // Nothing writes to a line once it's scrolled out, so it can give back what it doesn't need to be drawn.
+    line->compact();
+    if (m_history.size() < max_history_size()) {
+        m_history.append(move(line));
+        return;
+    }
+    m_history.ptr_at(m_history_start) = move(line);
+    m_history_start = (m_history_start + 1) % m_history.size();
+}
+
+void Terminal::set_max_history_size(size_t max_history_size)
+{
+    if (max_history_size == m_max_history_size)
+        return;
+    m_max_history_size = max_history_size;
+    if (m_history.size() <= max_history_size && !m_history_start)
+        return;
+
+    // Unroll the ring, keeping only the newest lines.
+    size_t kept_line_count = min(m_history.size(), max_history_size);
+    NonnullOwnPtrVector<Line> history;
+    history.ensure_capacity(kept_line_count);
+    for (size_t i = m_history.size() - kept_line_count; i < m_history.size(); ++i)
+        history.append(move(m_history.ptr_at((m_history_start + i) % m_history.size())));
+    m_history = move(history);
+    m_history_start = 0;
+    m_client.terminal_history_changed();
+}
+
 void Terminal::scroll_down()
 {
     // NOTE: We have to invalidate the cursor first.
@@ -770,8 +800,9 @@ void Terminal::put_character_at(unsigned row, unsigned column, u32 codepoint)
     ASSERT(column < columns());
     auto& line = m_lines[row];
     line.set_codepoint(column, codepoint);
-    line.attributes()[column] = m_current_attribute;
-    line.attributes()[column].flags |= Attribute::Touched;
+    auto attribute = m_current_attribute;
+    attribute.flags |= Attribute::Touched;
+    line.set_attribute_at(column, attribute);
     line.set_dirty(true);
 
     m_last_codepoint = codepoint;
@@ -977,6 +1008,49 @@ void Terminal::on_input(u8 ch)
     on_codepoint(ch);
 }
 
+static inline bool is_printable_ascii(u8 ch)
+{
+    return ch >= 0x20 && ch < 0x7f;
+}
+
+void Terminal::on_input(const u8* data, size_t length)
+{
+    for (size_t i = 0; i < length;) {
+        if (m_parser_state == Normal && is_printable_ascii(data[i])) {
+            i += put_printable_run(data + i, length - i);
+            continue;
+        }
+        on_input(data[i++]);
+    }
+}
+
+// Puts as much of a run of printable ASCII as fits on the cursor's line, and returns how much it consumed.
+// This is on_codepoint() for each character, except the line and the cursor are only touched once.
+size_t Terminal::put_printable_run(const u8* data, size_t length)
+{
+    if (m_stomp || m_cursor_column + 1u >= columns()) {
+        on_codepoint(data[0]);
+        return 1;
+    }
+
+    size_t run_length = 0;
+    size_t max_run_length = min(length, (size_t)(columns() - 1 - m_cursor_column));
+    while (run_length < max_run_length && is_printable_ascii(data[run_length]))
+        ++run_length;
+
+    auto& line = m_lines[m_cursor_row];
+    auto attribute = m_current_attribute;
+    attribute.flags |= Attribute::Touched;
+    for (size_t i = 0; i < run_length; ++i) {
+        line.set_codepoint(m_cursor_column + i, data[i]);
+        line.set_attribute_at(m_cursor_column + i, attribute);
+    }
+    line.set_dirty(true);
+    m_last_codepoint = data[run_length - 1];
+    set_cursor(m_cursor_row, m_cursor_column + run_length);
+    return run_length;
+}
+
 void Terminal::on_codepoint(u32 codepoint)
 {
     auto new_column = m_cursor_column + 1;
@@ -999,8 +1073,7 @@ void Terminal::on_codepoint(u32 codepoint)
 
 void Terminal::inject_string(const StringView& str)
 {
-    for (size_t i = 0; i < str.length(); ++i)
-        on_input(str[i]);
+    on_input((const u8*)str.characters_without_null_termination(), str.length());
 }
 
 void Terminal::emit_string(const StringView& string)
@@ -1174,7 +1247,7 @@ Attribute Terminal::attribute_at(const Position& position) const
     auto& line = this->line(position.row());
     if (position.column() >= line.length())
         return {};
-    return line.attributes()[position.column()];
+    return line.attribute_at(position.column());
 }
 
 }
@@ -57,6 +57,7 @@ public:
 
     void invalidate_cursor();
     void on_input(u8);
+    void on_input(const u8*, size_t);
 
     void clear();
     void set_size(u16 columns, u16 rows);
@@ -74,13 +75,13 @@ public:
     Line& line(size_t index)
     {
         if (index < m_history.size())
-            return m_history[index];
+            return history_line(index);
         return m_lines[index - m_history.size()];
     }
     const Line& line(size_t index) const
     {
         if (index < m_history.size())
-            return m_history[index];
+            return history_line(index);
         return m_lines[index - m_history.size()];
     }
 
@@ -93,8 +94,10 @@ public:
         return m_lines[index];
     }
 
-    size_t max_history_size() const { return 500; }
-    const NonnullOwnPtrVector<Line>& history() const { return m_history; }
+    static constexpr size_t default_max_history_size = 10000;
+    size_t max_history_size() const { return m_max_history_size; }
+    void set_max_history_size(size_t);
+    size_t history_size() const { return m_history.size(); }
 
     void inject_string(const StringView&);
     void handle_key_press(KeyCode, u8 charatcter, u8 flags);
@@ -105,6 +108,7 @@ private:
     typedef Vector<unsigned, 4> ParamVector;
 
     void on_codepoint(u32);
+    size_t put_printable_run(const u8*, size_t);
 
     void scroll_up();
     void scroll_down();
@@ -152,7 +156,14 @@ private:
 
     TerminalClient& m_client;
 
+    Line& history_line(size_t index) { return m_history[(m_history_start + index) % m_history.size()]; }
+    const Line& history_line(size_t index) const { return m_history[(m_history_start + index) % m_history.size()]; }
+    void add_line_to_history(NonnullOwnPtr<Line>);
+
+    // Once it's full, the history is a ring: new lines replace the oldest one, which is at m_history_start.
     NonnullOwnPtrVector<Line> m_history;
+    size_t m_history_start { 0 };
+    size_t m_max_history_size { default_max_history_size };
     NonnullOwnPtrVector<Line> m_lines;
 
     size_t m_scroll_region_top { 0 };
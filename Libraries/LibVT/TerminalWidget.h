@@ -55,6 +55,9 @@ public:
     void flush_dirty_lines();
     void force_repaint();
 
+    // Output is drawn at most this often; whatever scrolls by in between is never drawn at all.
+    static constexpr int output_flush_interval_ms = 16;
+
     void apply_size_increments_to_window(GUI::Window&);
 
     const Gfx::Font& bold_font() const { return *m_bold_font; }
@@ -120,6 +123,7 @@ private:
 
     void update_cursor();
     void invalidate_cursor();
+    void update_scrollbar_for_history();
 
     void relayout(const Gfx::Size&);
 
@@ -170,6 +174,9 @@ private:
 
     RefPtr<Core::Timer> m_cursor_blink_timer;
     RefPtr<Core::Timer> m_visual_beep_timer;
+    RefPtr<Core::Timer> m_output_flush_timer;
+    bool m_has_unflushed_output { false };
+    bool m_history_changed { false };
     RefPtr<Core::ConfigFile> m_config;
 
     RefPtr<GUI::ScrollBar> m_scrollbar;
@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/FlyString.h>
+#include <LibJS/Interpreter.h>
+#include <LibJS/Runtime/GlobalObject.h>
+#include <LibWeb/Bindings/PerformanceObject.h>
+#include <LibWeb/Bindings/WindowObject.h>
+#include <LibWeb/DOM/Document.h>
+#include <LibWeb/DOM/Window.h>
+
+namespace Web {
+namespace Bindings {
+
+PerformanceObject::PerformanceObject()
+    : Object(interpreter().global_object().object_prototype())
+{
+    define_native_function("now", now, 0, JS::Attribute::Enumerable | JS::Attribute::Configurable);
+    define_native_property("timeOrigin", time_origin_getter, nullptr);
+    define_native_property("timing", timing_getter, nullptr);
+}
+
+PerformanceObject::~PerformanceObject()
+{
+}
+
+static PerformanceTimeline& timeline_from(JS::Interpreter& interpreter)
+{
+    auto& window = static_cast<WindowObject&>(interpreter.global_object());
+    return window.impl().document().performance_timeline();
+}
+
+JS::Value PerformanceObject::now(JS::Interpreter& interpreter)
+{
+    return JS::Value(timeline_from(interpreter).now());
+}
+
+JS::Value PerformanceObject::time_origin_getter(JS::Interpreter& interpreter)
+{
+    return JS::Value(timeline_from(interpreter).time_origin());
+}
+
+JS::Value PerformanceObject::timing_getter(JS::Interpreter& interpreter)
+{
+    using Milestone = PerformanceTimeline::Milestone;
+    auto& timeline = timeline_from(interpreter);
+    auto* timing = JS::Object::create_empty(interpreter, interpreter.global_object());
+
+    auto define_milestone = [&](const FlyString& name, Milestone milestone) {
+        timing->define_property(name, JS::Value(timeline.milestone_since_epoch(milestone)));
+    };
+
+    define_milestone("navigationStart", Milestone::NavigationStart);
+    define_milestone("fetchStart", Milestone::FetchStart);
+
+    // FIXME: ProtocolServer doesn't tell us when name lookup, connection setup or the first byte
+    //        of the response happened, so those collapse onto the fetch start / response end.
+    define_milestone("domainLookupStart", Milestone::FetchStart);
+    define_milestone("domainLookupEnd", Milestone::FetchStart);
+    define_milestone("connectStart", Milestone::FetchStart);
+    define_milestone("connectEnd", Milestone::FetchStart);
+    timing->define_property("secureConnectionStart", JS::Value(0));
+    define_milestone("requestStart", Milestone::FetchStart);
+    define_milestone("responseStart", Milestone::ResponseEnd);
+
+    define_milestone("responseEnd", Milestone::ResponseEnd);
+    define_milestone("domLoading", Milestone::DOMLoading);
+    define_milestone("domInteractive", Milestone::DOMInteractive);
+    define_milestone("domContentLoadedEventStart", Milestone::DOMContentLoadedEventStart);
+    define_milestone("domContentLoadedEventEnd", Milestone::DOMContentLoadedEventEnd);
+    define_milestone("domComplete", Milestone::DOMComplete);
+
+    // We don't fire a separate load event for documents yet.
+    define_milestone("loadEventStart", Milestone::DOMComplete);
+    define_milestone("loadEventEnd", Milestone::DOMComplete);
+
+    return timing;
+}
+
+}
+}
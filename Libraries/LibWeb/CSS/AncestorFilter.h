@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/FlyString.h>
+#include <AK/HashFunctions.h>
+#include <AK/Types.h>
+#include <LibWeb/CSS/Selector.h>
+
+namespace Web {
+
+// A Bloom filter of the ids, classes and tag names of an element's ancestors. Selectors with
+// descendant or child combinators can't match when one of the names their ancestor compounds
+// require is missing, and this tells us that without walking up the tree for every rule.
+class AncestorFilter {
+public:
+    static u32 hash(Selector::SimpleSelector::Type type, const FlyString& name)
+    {
+        return pair_int_hash(static_cast<u32>(type), name.hash());
+    }
+
+    void add(u32 hash)
+    {
+        set_bit(hash);
+        set_bit(hash >> bit_count_log2);
+    }
+
+    // False positives are possible, false negatives are not.
+    bool may_contain(u32 hash) const
+    {
+        return has_bit(hash) && has_bit(hash >> bit_count_log2);
+    }
+
+private:
+    static constexpr size_t bit_count_log2 = 10;
+    static constexpr size_t bit_count = 1 << bit_count_log2;
+
+    void set_bit(u32 hash) { m_bits[(hash % bit_count) / 64] |= 1ull << (hash % 64); }
+    bool has_bit(u32 hash) const { return m_bits[(hash % bit_count) / 64] & (1ull << (hash % 64)); }
+
+    u64 m_bits[bit_count / 64] {};
+};
+
+}
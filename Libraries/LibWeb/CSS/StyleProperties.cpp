@@ -24,6 +24,7 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <AK/Assertions.h>
 #include <LibCore/DirIterator.h>
 #include <LibWeb/CSS/StyleProperties.h>
 #include <LibWeb/FontCache.h>
@@ -180,6 +181,14 @@ float StyleProperties::line_height() const
     return (float)font().glyph_height() * 1.4f;
 }
 
+float StyleProperties::opacity() const
+{
+    auto opacity_length = length_or_fallback(CSS::PropertyID::Opacity, {}, 1);
+    if (!opacity_length.is_absolute())
+        return 1;
+    return clamp(opacity_length.to_px(), 0.0f, 1.0f);
+}
+
 CSS::Position StyleProperties::position() const
 {
     if (property(CSS::PropertyID::Position).has_value()) {
@@ -67,6 +67,7 @@ public:
     }
 
     float line_height() const;
+    float opacity() const;
 
     bool operator==(const StyleProperties&) const;
     bool operator!=(const StyleProperties& other) const { return !(*this == other); }
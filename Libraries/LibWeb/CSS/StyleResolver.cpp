@@ -24,11 +24,14 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <AK/QuickSort.h>
+#include <LibWeb/CSS/AncestorFilter.h>
 #include <LibWeb/CSS/SelectorEngine.h>
 #include <LibWeb/CSS/StyleResolver.h>
 #include <LibWeb/CSS/StyleSheet.h>
 #include <LibWeb/DOM/Document.h>
 #include <LibWeb/DOM/Element.h>
+#include <LibWeb/DOM/Text.h>
 #include <LibWeb/Dump.h>
 #include <LibWeb/Parser/CSSParser.h>
 #include <ctype.h>
@@ -65,20 +68,220 @@ void StyleResolver::for_each_stylesheet(Callback callback) const
     }
 }
 
-NonnullRefPtrVector<StyleRule> StyleResolver::collect_matching_rules(const Element& element) const
+// Collects the hashes of the ids, classes and tag names that have to be present on an element's
+// ancestors for the selector to match it.
+static Vector<u32, 4> ancestor_hashes_for(const Selector& selector)
 {
-    NonnullRefPtrVector<StyleRule> matching_rules;
+    Vector<u32, 4> hashes;
+    auto& complex_selectors = selector.complex_selectors();
+    for (size_t i = complex_selectors.size() - 1; i > 0; --i) {
+        // Only compounds that are a parent or an ancestor of the one to their right are
+        // ancestors of the element; siblings of those are not.
+        auto relation = complex_selectors[i].relation;
+        if (relation != Selector::ComplexSelector::Relation::Descendant && relation != Selector::ComplexSelector::Relation::ImmediateChild)
+            continue;
+        for (auto& simple_selector : complex_selectors[i - 1].compound_selector) {
+            switch (simple_selector.type) {
+            case Selector::SimpleSelector::Type::Id:
+            case Selector::SimpleSelector::Type::Class:
+            case Selector::SimpleSelector::Type::TagName:
+                hashes.append(AncestorFilter::hash(simple_selector.type, simple_selector.value));
+                break;
+            default:
+                break;
+            }
+        }
+    }
+    return hashes;
+}
 
+static void note_invalidation(HashMap<FlyString, StyleInvalidation>& invalidations, const FlyString& name, StyleInvalidation invalidation)
+{
+    auto it = invalidations.find(name);
+    if (it == invalidations.end())
+        invalidations.set(name, invalidation);
+    else if (it->value < invalidation)
+        it->value = invalidation;
+}
+
+void StyleResolver::build_rule_cache() const
+{
+    m_rule_cache = make<RuleCache>();
+    size_t rule_order = 0;
     for_each_stylesheet([&](auto& sheet) {
         for (auto& rule : sheet.rules()) {
-            for (auto& selector : rule.selectors()) {
-                if (SelectorEngine::matches(selector, element)) {
-                    matching_rules.append(rule);
-                    break;
+            for (size_t selector_index = 0; selector_index < rule.selectors().size(); ++selector_index) {
+                auto& selector = rule.selectors()[selector_index];
+                MatchingRule matching_rule { rule, selector_index, rule_order, ancestor_hashes_for(selector) };
+
+                // A change that affects the rightmost compound selector only affects that element;
+                // one that affects a compound to its left affects the elements after it in the
+                // tree that the rest of the selector can reach.
+                auto& complex_selectors = selector.complex_selectors();
+                for (size_t i = 0; i < complex_selectors.size(); ++i) {
+                    auto invalidation = StyleInvalidation::Self;
+                    if (i + 1 < complex_selectors.size()) {
+                        auto relation = complex_selectors[i + 1].relation;
+                        if (relation == Selector::ComplexSelector::Relation::AdjacentSibling || relation == Selector::ComplexSelector::Relation::GeneralSibling) {
+                            invalidation = StyleInvalidation::SubtreeAndFollowingSiblings;
+                            m_rule_cache->has_sibling_combinators = true;
+                        } else
+                            invalidation = StyleInvalidation::Subtree;
+                    }
+                    for (auto& simple_selector : complex_selectors[i].compound_selector) {
+                        if (simple_selector.type == Selector::SimpleSelector::Type::Id)
+                            note_invalidation(m_rule_cache->id_invalidations, simple_selector.value, invalidation);
+                        else if (simple_selector.type == Selector::SimpleSelector::Type::Class)
+                            note_invalidation(m_rule_cache->class_invalidations, simple_selector.value, invalidation);
+                        if (simple_selector.attribute_match_type != Selector::SimpleSelector::AttributeMatchType::None)
+                            note_invalidation(m_rule_cache->attribute_invalidations, simple_selector.attribute_name, invalidation);
+                        if (simple_selector.pseudo_class == Selector::SimpleSelector::PseudoClass::Hover && m_rule_cache->hover_invalidation < invalidation)
+                            m_rule_cache->hover_invalidation = invalidation;
+                    }
                 }
+
+                // Bucket by the most selective part of the rightmost compound selector.
+                const Selector::SimpleSelector* id_selector = nullptr;
+                const Selector::SimpleSelector* class_selector = nullptr;
+                const Selector::SimpleSelector* tag_name_selector = nullptr;
+                for (auto& simple_selector : selector.complex_selectors().last().compound_selector) {
+                    if (simple_selector.type == Selector::SimpleSelector::Type::Id)
+                        id_selector = &simple_selector;
+                    else if (simple_selector.type == Selector::SimpleSelector::Type::Class)
+                        class_selector = &simple_selector;
+                    else if (simple_selector.type == Selector::SimpleSelector::Type::TagName)
+                        tag_name_selector = &simple_selector;
+                }
+                if (id_selector)
+                    m_rule_cache->rules_by_id.ensure(id_selector->value).append(move(matching_rule));
+                else if (class_selector)
+                    m_rule_cache->rules_by_class.ensure(class_selector->value).append(move(matching_rule));
+                else if (tag_name_selector)
+                    m_rule_cache->rules_by_tag_name.ensure(tag_name_selector->value).append(move(matching_rule));
+                else
+                    m_rule_cache->other_rules.append(move(matching_rule));
             }
+            ++rule_order;
         }
     });
+}
+
+void StyleResolver::invalidate_rule_cache()
+{
+    m_rule_cache = nullptr;
+    m_shared_styles.clear();
+}
+
+const StyleResolver::RuleCache& StyleResolver::rule_cache() const
+{
+    if (!m_rule_cache)
+        build_rule_cache();
+    return *m_rule_cache;
+}
+
+static StyleInvalidation find_invalidation(const HashMap<FlyString, StyleInvalidation>& invalidations, const FlyString& name)
+{
+    auto it = invalidations.find(name);
+    if (it == invalidations.end())
+        return StyleInvalidation::None;
+    return it->value;
+}
+
+StyleInvalidation StyleResolver::invalidation_for_id(const FlyString& id) const
+{
+    return find_invalidation(rule_cache().id_invalidations, id);
+}
+
+StyleInvalidation StyleResolver::invalidation_for_class(const FlyString& class_name) const
+{
+    return find_invalidation(rule_cache().class_invalidations, class_name);
+}
+
+StyleInvalidation StyleResolver::invalidation_for_attribute(const FlyString& attribute_name) const
+{
+    return find_invalidation(rule_cache().attribute_invalidations, attribute_name);
+}
+
+StyleInvalidation StyleResolver::invalidation_for_hover() const
+{
+    return rule_cache().hover_invalidation;
+}
+
+NonnullRefPtrVector<StyleRule> StyleResolver::collect_matching_rules(const Element& element) const
+{
+    auto& rule_cache = this->rule_cache();
+    ++m_statistics.elements;
+
+    Vector<const MatchingRule*, 64> candidates;
+    auto add_candidates = [&](auto& map, const FlyString& key) {
+        auto it = map.find(key);
+        if (it == map.end())
+            return;
+        for (auto& matching_rule : it->value)
+            candidates.append(&matching_rule);
+    };
+
+    auto id = element.attribute(HTML::AttributeNames::id);
+    if (!id.is_null())
+        add_candidates(rule_cache.rules_by_id, id);
+    for (auto& class_name : element.class_names())
+        add_candidates(rule_cache.rules_by_class, class_name);
+    add_candidates(rule_cache.rules_by_tag_name, element.tag_name());
+    for (auto& matching_rule : rule_cache.other_rules)
+        candidates.append(&matching_rule);
+
+    // The buckets each keep the cascade order, but we need it across all of them.
+    quick_sort(candidates.begin(), candidates.end(), [](auto* a, auto* b) {
+        if (a->rule_order != b->rule_order)
+            return a->rule_order < b->rule_order;
+        return a->selector_index < b->selector_index;
+    });
+    m_statistics.candidate_selectors += candidates.size();
+
+    AncestorFilter ancestor_filter;
+    bool has_built_ancestor_filter = false;
+    auto may_match_ancestors = [&](const MatchingRule& matching_rule) {
+        if (matching_rule.ancestor_hashes.is_empty())
+            return true;
+        if (!has_built_ancestor_filter) {
+            has_built_ancestor_filter = true;
+            for (auto* ancestor = element.parent(); ancestor; ancestor = ancestor->parent()) {
+                if (!is<Element>(*ancestor))
+                    continue;
+                auto& ancestor_element = to<Element>(*ancestor);
+                ancestor_filter.add(AncestorFilter::hash(Selector::SimpleSelector::Type::TagName, ancestor_element.tag_name()));
+                auto ancestor_id = ancestor_element.attribute(HTML::AttributeNames::id);
+                if (!ancestor_id.is_null())
+                    ancestor_filter.add(AncestorFilter::hash(Selector::SimpleSelector::Type::Id, ancestor_id));
+                for (auto& class_name : ancestor_element.class_names())
+                    ancestor_filter.add(AncestorFilter::hash(Selector::SimpleSelector::Type::Class, class_name));
+            }
+        }
+        for (auto hash : matching_rule.ancestor_hashes) {
+            if (!ancestor_filter.may_contain(hash))
+                return false;
+        }
+        return true;
+    };
+
+    NonnullRefPtrVector<StyleRule> matching_rules;
+    const MatchingRule* last_match = nullptr;
+    for (auto* candidate : candidates) {
+        // A rule matches once, even if several of its selectors do.
+        if (last_match && last_match->rule_order == candidate->rule_order)
+            continue;
+        if (!may_match_ancestors(*candidate)) {
+            ++m_statistics.rejected_by_ancestor_filter;
+            continue;
+        }
+        ++m_statistics.selector_matches;
+        if (!SelectorEngine::matches(candidate->rule->selectors()[candidate->selector_index], element))
+            continue;
+        ++candidate->match_count;
+        matching_rules.append(candidate->rule);
+        last_match = candidate;
+    }
+    m_statistics.matched_rules += matching_rules.size();
 
 #ifdef HTML_DEBUG
     dbgprintf("Rules matching Element{%p}\n", &element);
@@ -90,6 +293,33 @@ NonnullRefPtrVector<StyleRule> StyleResolver::collect_matching_rules(const Eleme
     return matching_rules;
 }
 
+void StyleResolver::dump_statistics() const
+{
+    dbg() << "StyleResolver: " << m_statistics.elements << " elements, "
+          << m_statistics.candidate_selectors << " candidate selectors, "
+          << m_statistics.rejected_by_ancestor_filter << " rejected by the ancestor filter, "
+          << m_statistics.selector_matches << " selectors matched against, "
+          << m_statistics.matched_rules << " rules matched, "
+          << m_statistics.shared_styles << " styles shared";
+    if (!m_rule_cache)
+        return;
+    auto dump_rules = [](auto& rules) {
+        for (auto& matching_rule : rules) {
+            if (!matching_rule.match_count)
+                continue;
+            dbgprintf("%8zu ", matching_rule.match_count);
+            dump_selector(matching_rule.rule->selectors()[matching_rule.selector_index]);
+        }
+    };
+    for (auto& it : m_rule_cache->rules_by_id)
+        dump_rules(it.value);
+    for (auto& it : m_rule_cache->rules_by_class)
+        dump_rules(it.value);
+    for (auto& it : m_rule_cache->rules_by_tag_name)
+        dump_rules(it.value);
+    dump_rules(m_rule_cache->other_rules);
+}
+
 bool StyleResolver::is_inherited_property(CSS::PropertyID property_id)
 {
     static HashTable<CSS::PropertyID> inherited_properties;
@@ -371,8 +601,82 @@ static void set_property_expanding_shorthands(StyleProperties& style, CSS::Prope
     style.set_property(property_id, value);
 }
 
+enum StructureFlags : u8 {
+    IsFirstChild = 1 << 0,
+    IsLastChild = 1 << 1,
+    IsEmpty = 1 << 2,
+    IsHovered = 1 << 3,
+};
+
+// What selectors can test about an element beyond its tag name, attributes and ancestors.
+static u8 structure_flags_for(const Element& element, bool has_hover_rules)
+{
+    u8 flags = 0;
+    if (!element.previous_element_sibling())
+        flags |= IsFirstChild;
+    if (!element.next_element_sibling())
+        flags |= IsLastChild;
+    if (!element.first_child_of_type<Element>() && !element.first_child_of_type<Text>())
+        flags |= IsEmpty;
+    if (has_hover_rules) {
+        auto* hovered_node = element.document().hovered_node();
+        if (hovered_node && (hovered_node == &element || element.is_ancestor_of(*hovered_node)))
+            flags |= IsHovered;
+    }
+    return flags;
+}
+
+static constexpr size_t max_shared_styles = 16;
+
+RefPtr<StyleProperties> StyleResolver::find_shared_style(const Element& element, const StyleProperties* parent_style, u8 structure) const
+{
+    // Search from the most recently added, since that is usually a sibling of the element.
+    for (size_t i = m_shared_styles.size(); i > 0; --i) {
+        auto& shared_style = m_shared_styles[i - 1];
+        if (shared_style.parent_style.ptr() != parent_style || shared_style.structure != structure)
+            continue;
+        if (shared_style.tag_name != element.tag_name() || shared_style.attributes.size() != element.attribute_count())
+            continue;
+        bool attributes_match = true;
+        for (auto& attribute : shared_style.attributes) {
+            if (element.attribute(attribute.name()) != attribute.value()) {
+                attributes_match = false;
+                break;
+            }
+        }
+        if (attributes_match)
+            return shared_style.style;
+    }
+    return nullptr;
+}
+
+void StyleResolver::add_shared_style(const Element& element, const StyleProperties* parent_style, u8 structure, NonnullRefPtr<StyleProperties> style) const
+{
+    Vector<Attribute> attributes;
+    element.for_each_attribute([&](auto& name, auto& value) {
+        attributes.empend(name, value);
+    });
+    if (m_shared_styles.size() == max_shared_styles)
+        m_shared_styles.take_first();
+    m_shared_styles.append({ parent_style, element.tag_name(), move(attributes), structure, move(style) });
+}
+
 NonnullRefPtr<StyleProperties> StyleResolver::resolve_style(const Element& element, const StyleProperties* parent_style) const
 {
+    // Sharing is keyed on the parent's style object: elements whose parents share a style have
+    // ancestors that look the same to every selector, unless a sibling combinator can tell
+    // them apart.
+    auto& rule_cache = this->rule_cache();
+    bool can_share_style = !rule_cache.has_sibling_combinators;
+    u8 structure = 0;
+    if (can_share_style) {
+        structure = structure_flags_for(element, rule_cache.hover_invalidation != StyleInvalidation::None);
+        if (auto shared_style = find_shared_style(element, parent_style, structure)) {
+            ++m_statistics.shared_styles;
+            return shared_style.release_nonnull();
+        }
+    }
+
     auto style = StyleProperties::create();
 
     if (parent_style) {
@@ -400,6 +704,10 @@ NonnullRefPtr<StyleProperties> StyleResolver::resolve_style(const Element& eleme
         }
     }
 
+    // An element with an id is unlikely to have a twin, so don't let it push out useful entries.
+    if (can_share_style && !element.has_attribute(HTML::AttributeNames::id))
+        add_shared_style(element, parent_style, structure, style);
+
     return style;
 }
 
@@ -26,9 +26,12 @@
 
 #pragma once
 
+#include <AK/FlyString.h>
+#include <AK/HashMap.h>
 #include <AK/NonnullRefPtrVector.h>
 #include <AK/OwnPtr.h>
 #include <LibWeb/CSS/StyleProperties.h>
+#include <LibWeb/DOM/Attribute.h>
 
 namespace Web {
 
@@ -38,6 +41,15 @@ class ParentNode;
 class StyleRule;
 class StyleSheet;
 
+// Which elements may need their style resolved again after something a selector can test for
+// changes on an element, from least to most.
+enum class StyleInvalidation {
+    None,
+    Self,
+    Subtree,
+    SubtreeAndFollowingSiblings,
+};
+
 class StyleResolver {
 public:
     explicit StyleResolver(Document&);
@@ -50,13 +62,81 @@ public:
 
     NonnullRefPtrVector<StyleRule> collect_matching_rules(const Element&) const;
 
+    // Must be called whenever the document's set of style sheets changes.
+    void invalidate_rule_cache();
+
+    StyleInvalidation invalidation_for_id(const FlyString&) const;
+    StyleInvalidation invalidation_for_class(const FlyString&) const;
+    StyleInvalidation invalidation_for_attribute(const FlyString&) const;
+    StyleInvalidation invalidation_for_hover() const;
+
+    struct Statistics {
+        size_t elements { 0 };
+        size_t candidate_selectors { 0 };
+        size_t rejected_by_ancestor_filter { 0 };
+        size_t selector_matches { 0 };
+        size_t matched_rules { 0 };
+        size_t shared_styles { 0 };
+    };
+    const Statistics& statistics() const { return m_statistics; }
+    void dump_statistics() const;
+
     static bool is_inherited_property(CSS::PropertyID);
 
 private:
     template<typename Callback>
     void for_each_stylesheet(Callback) const;
 
+    struct MatchingRule {
+        NonnullRefPtr<StyleRule> rule;
+        size_t selector_index { 0 };
+        // Where the rule comes in the cascade: its index among all rules of all style sheets.
+        size_t rule_order { 0 };
+        // What the selector needs on the element's ancestors, for the AncestorFilter.
+        Vector<u32, 4> ancestor_hashes;
+        mutable size_t match_count { 0 };
+    };
+
+    // The rules of all style sheets, bucketed by the rightmost compound selector of each of
+    // their selectors, so that an element only has to be matched against rules that can apply.
+    struct RuleCache {
+        HashMap<FlyString, Vector<MatchingRule>> rules_by_id;
+        HashMap<FlyString, Vector<MatchingRule>> rules_by_class;
+        HashMap<FlyString, Vector<MatchingRule>> rules_by_tag_name;
+        Vector<MatchingRule> other_rules;
+
+        // How far a change to something that the selectors test for reaches.
+        HashMap<FlyString, StyleInvalidation> id_invalidations;
+        HashMap<FlyString, StyleInvalidation> class_invalidations;
+        HashMap<FlyString, StyleInvalidation> attribute_invalidations;
+        StyleInvalidation hover_invalidation { StyleInvalidation::None };
+
+        // Whether any selector uses a sibling combinator, which makes an element's style depend
+        // on its siblings (or those of its ancestors) and rules out style sharing.
+        bool has_sibling_combinators { false };
+    };
+
+    void build_rule_cache() const;
+    const RuleCache& rule_cache() const;
+
+    // A recently resolved style, along with everything that went into resolving it. Elements
+    // with the same parent style, tag name, attributes and structural state always resolve to
+    // the same style, so they can share one StyleProperties instead of each building their own.
+    struct SharedStyle {
+        RefPtr<const StyleProperties> parent_style;
+        FlyString tag_name;
+        Vector<Attribute> attributes;
+        u8 structure { 0 };
+        NonnullRefPtr<StyleProperties> style;
+    };
+
+    RefPtr<StyleProperties> find_shared_style(const Element&, const StyleProperties* parent_style, u8 structure) const;
+    void add_shared_style(const Element&, const StyleProperties* parent_style, u8 structure, NonnullRefPtr<StyleProperties>) const;
+
     Document& m_document;
+    mutable OwnPtr<RuleCache> m_rule_cache;
+    mutable Vector<SharedStyle> m_shared_styles;
+    mutable Statistics m_statistics;
 };
 
 }
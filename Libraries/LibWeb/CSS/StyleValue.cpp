@@ -25,6 +25,8 @@
  */
 
 #include <AK/ByteBuffer.h>
+#include <AK/FlyString.h>
+#include <AK/HashMap.h>
 #include <LibGfx/Bitmap.h>
 #include <LibGfx/PNGLoader.h>
 #include <LibGfx/Palette.h>
@@ -32,7 +34,9 @@
 #include <LibWeb/DOM/Document.h>
 #include <LibWeb/Frame.h>
 #include <LibWeb/PageView.h>
+#include <LibThread/Lock.h>
 #include <LibWeb/ResourceLoader.h>
+#include <ctype.h>
 
 namespace Web {
 
@@ -45,6 +49,104 @@ StyleValue::~StyleValue()
 {
 }
 
+// Stylesheets mostly consist of the same few keywords, lengths and colors, so rather than
+// allocating a value for each occurrence, those are interned. Stylesheets may be parsed on
+// background threads, so the tables are guarded by a lock.
+static LibThread::Lock s_interned_values_lock;
+
+// Keeps a page full of unique colors (or class-name-like keywords) from growing the tables forever.
+static constexpr size_t max_interned_values_per_table = 1024;
+
+// Pixel lengths from 0 up to this are interned.
+static constexpr int max_interned_pixel_length = 64;
+
+static bool is_keyword(const StringView& string)
+{
+    if (string.is_empty() || string.length() > 32)
+        return false;
+    for (size_t i = 0; i < string.length(); ++i) {
+        if (!isalnum(string[i]) && string[i] != '-')
+            return false;
+    }
+    return true;
+}
+
+NonnullRefPtr<StringStyleValue> StringStyleValue::create(const String& string)
+{
+    if (!is_keyword(string))
+        return adopt(*new StringStyleValue(string));
+
+    // Interned strings are handed out to any thread, so they're fly strings, whose reference counts are thread-safe.
+    LOCKER(s_interned_values_lock);
+    static HashMap<String, StringStyleValue*> s_interned_keywords;
+    if (auto it = s_interned_keywords.find(string); it != s_interned_keywords.end())
+        return *it->value;
+    if (s_interned_keywords.size() >= max_interned_values_per_table)
+        return adopt(*new StringStyleValue(string));
+    FlyString keyword = string;
+    auto value = make_interned(new StringStyleValue(keyword));
+    s_interned_keywords.set(keyword, value.ptr());
+    return value;
+}
+
+NonnullRefPtr<LengthStyleValue> LengthStyleValue::create(const Length& length)
+{
+    int pixels = (int)length.value();
+    bool is_small_whole_pixel_length = length.is_absolute() && length.value() == (float)pixels && pixels >= 0 && pixels <= max_interned_pixel_length;
+    if (!length.is_auto() && !is_small_whole_pixel_length)
+        return adopt(*new LengthStyleValue(length));
+
+    static LengthStyleValue* s_auto;
+    static LengthStyleValue* s_pixel_lengths[max_interned_pixel_length + 1];
+    auto& slot = length.is_auto() ? s_auto : s_pixel_lengths[pixels];
+    LOCKER(s_interned_values_lock);
+    if (!slot)
+        slot = make_interned(new LengthStyleValue(length)).ptr();
+    return *slot;
+}
+
+NonnullRefPtr<InitialStyleValue> InitialStyleValue::create()
+{
+    static InitialStyleValue* s_the;
+    LOCKER(s_interned_values_lock);
+    if (!s_the)
+        s_the = make_interned(new InitialStyleValue).ptr();
+    return *s_the;
+}
+
+NonnullRefPtr<InheritStyleValue> InheritStyleValue::create()
+{
+    static InheritStyleValue* s_the;
+    LOCKER(s_interned_values_lock);
+    if (!s_the)
+        s_the = make_interned(new InheritStyleValue).ptr();
+    return *s_the;
+}
+
+NonnullRefPtr<ColorStyleValue> ColorStyleValue::create(Color color)
+{
+    LOCKER(s_interned_values_lock);
+    static HashMap<Gfx::RGBA32, ColorStyleValue*> s_interned_colors;
+    if (auto it = s_interned_colors.find(color.value()); it != s_interned_colors.end())
+        return *it->value;
+    if (s_interned_colors.size() >= max_interned_values_per_table)
+        return adopt(*new ColorStyleValue(color));
+    auto value = make_interned(new ColorStyleValue(color));
+    s_interned_colors.set(color.value(), value.ptr());
+    return value;
+}
+
+NonnullRefPtr<IdentifierStyleValue> IdentifierStyleValue::create(CSS::ValueID id)
+{
+    LOCKER(s_interned_values_lock);
+    static HashMap<int, IdentifierStyleValue*> s_interned_identifiers;
+    if (auto it = s_interned_identifiers.find((int)id); it != s_interned_identifiers.end())
+        return *it->value;
+    auto value = make_interned(new IdentifierStyleValue(id));
+    s_interned_identifiers.set((int)id, value.ptr());
+    return value;
+}
+
 String IdentifierStyleValue::to_string() const
 {
     switch (id()) {
@@ -149,19 +149,40 @@ public:
 
     virtual bool is_auto() const { return false; }
 
+    // Interned values are shared by every stylesheet, whichever thread parsed it, and are never
+    // destroyed. They skip reference counting altogether, which also keeps sharing them thread-safe.
+    ALWAYS_INLINE void ref() const
+    {
+        if (!m_interned)
+            RefCounted::ref();
+    }
+    ALWAYS_INLINE void unref() const
+    {
+        if (!m_interned)
+            RefCounted::unref();
+    }
+
+    bool is_interned() const { return m_interned; }
+
 protected:
     explicit StyleValue(Type);
 
+    template<typename T>
+    static NonnullRefPtr<T> make_interned(T* value)
+    {
+        value->m_interned = true;
+        return *value;
+    }
+
 private:
     Type m_type { Type::Invalid };
+    bool m_interned { false };
 };
 
 class StringStyleValue : public StyleValue {
 public:
-    static NonnullRefPtr<StringStyleValue> create(const String& string)
-    {
-        return adopt(*new StringStyleValue(string));
-    }
+    // Keywords are interned, other strings get a value of their own.
+    static NonnullRefPtr<StringStyleValue> create(const String&);
     virtual ~StringStyleValue() override {}
 
     String to_string() const override { return m_string; }
@@ -178,10 +199,8 @@ private:
 
 class LengthStyleValue : public StyleValue {
 public:
-    static NonnullRefPtr<LengthStyleValue> create(const Length& length)
-    {
-        return adopt(*new LengthStyleValue(length));
-    }
+    // auto and small whole pixel lengths are interned.
+    static NonnullRefPtr<LengthStyleValue> create(const Length&);
     virtual ~LengthStyleValue() override {}
 
     virtual String to_string() const override { return m_length.to_string(); }
@@ -228,7 +247,7 @@ private:
 
 class InitialStyleValue final : public StyleValue {
 public:
-    static NonnullRefPtr<InitialStyleValue> create() { return adopt(*new InitialStyleValue); }
+    static NonnullRefPtr<InitialStyleValue> create();
     virtual ~InitialStyleValue() override {}
 
     String to_string() const override { return "initial"; }
@@ -242,7 +261,7 @@ private:
 
 class InheritStyleValue final : public StyleValue {
 public:
-    static NonnullRefPtr<InheritStyleValue> create() { return adopt(*new InheritStyleValue); }
+    static NonnullRefPtr<InheritStyleValue> create();
     virtual ~InheritStyleValue() override {}
 
     String to_string() const override { return "inherit"; }
@@ -256,10 +275,8 @@ private:
 
 class ColorStyleValue : public StyleValue {
 public:
-    static NonnullRefPtr<ColorStyleValue> create(Color color)
-    {
-        return adopt(*new ColorStyleValue(color));
-    }
+    // Colors are interned, up to a limit.
+    static NonnullRefPtr<ColorStyleValue> create(Color);
     virtual ~ColorStyleValue() override {}
 
     Color color() const { return m_color; }
@@ -278,10 +295,7 @@ private:
 
 class IdentifierStyleValue final : public StyleValue {
 public:
-    static NonnullRefPtr<IdentifierStyleValue> create(CSS::ValueID id)
-    {
-        return adopt(*new IdentifierStyleValue(id));
-    }
+    static NonnullRefPtr<IdentifierStyleValue> create(CSS::ValueID);
     virtual ~IdentifierStyleValue() override {}
 
     CSS::ValueID id() const { return m_id; }
@@ -59,20 +59,21 @@ int main(int argc, char** argv)
     ASSERT(json.is_object());
 
     out() << "#include <AK/Assertions.h>";
+    out() << "#include <AK/StaticStringMap.h>";
     out() << "#include <LibWeb/CSS/PropertyID.h>";
     out() << "namespace Web {";
     out() << "namespace CSS {";
 
-    out() << "PropertyID property_id_from_string(const StringView& string) {";
-
+    out() << "static constexpr auto s_property_ids = make_static_string_map<PropertyID>({";
     json.as_object().for_each_member([&](auto& name, auto& value) {
         ASSERT(value.is_object());
-        out() << "    if (string.equals_ignoring_case(\"" << name << "\"))";
-        out() << "        return PropertyID::" << title_casify(name) << ";";
+        out() << "    { \"" << name << "\", PropertyID::" << title_casify(name) << " },";
     });
+    out() << "}, CaseSensitivity::CaseInsensitive);";
 
-    out() << "    return PropertyID::Invalid;";
-
+    out() << "PropertyID property_id_from_string(const StringView& string) {";
+    out() << "    auto* property_id = s_property_ids.get(string);";
+    out() << "    return property_id ? *property_id : PropertyID::Invalid;";
     out() << "}";
 
     out() << "const char* string_from_property_id(PropertyID property_id) {";
@@ -25,6 +25,8 @@
  */
 
 #include <LibWeb/DOM/CharacterData.h>
+#include <LibWeb/DOM/Document.h>
+#include <LibWeb/Layout/LayoutNode.h>
 
 namespace Web {
 
@@ -38,4 +40,16 @@ CharacterData::~CharacterData()
 {
 }
 
+void CharacterData::set_data(const String& data)
+{
+    if (m_data == data)
+        return;
+    m_data = data;
+    if (auto* layout_node = this->layout_node()) {
+        layout_node->set_needs_layout();
+        // The style update lays out whatever needs it once it's done.
+        document().schedule_style_update();
+    }
+}
+
 }
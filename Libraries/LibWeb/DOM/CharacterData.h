@@ -36,7 +36,7 @@ public:
     virtual ~CharacterData() override;
 
     const String& data() const { return m_data; }
-    void set_data(const String& data) { m_data = data; }
+    void set_data(const String&);
 
     virtual String text_content() const override { return m_data; }
 
@@ -215,7 +215,8 @@ URL Document::complete_url(const String& string) const
 
 void Document::invalidate_layout()
 {
-    m_layout_root = nullptr;
+    m_needs_layout_tree_rebuild = true;
+    schedule_style_update();
 }
 
 void Document::force_layout()
@@ -229,22 +230,59 @@ void Document::layout()
     if (!frame())
         return;
 
+    PerformanceTimeline::Measurement measurement(m_performance_timeline, PerformanceTimeline::Category::Layout, m_layout_root && !m_needs_layout_tree_rebuild ? "Layout" : "Build layout tree");
+
+    if (m_needs_layout_tree_rebuild) {
+        m_layout_root = nullptr;
+        m_needs_layout_tree_rebuild = false;
+    }
+
     if (!m_layout_root) {
         LayoutTreeBuilder tree_builder;
         m_layout_root = static_ptr_cast<LayoutDocument>(tree_builder.build(*this));
     }
+    // Layout reports what it changed on screen as it goes.
     m_layout_root->layout();
-    m_layout_root->set_needs_display();
+    m_layout_root->clear_needs_layout();
+}
+
+void Document::add_sheet(const StyleSheet& sheet)
+{
+    m_sheets.append(sheet);
+    m_style_resolver->invalidate_rule_cache();
+    invalidate_style();
+}
+
+static void update_style_of_children(Node& node)
+{
+    for (auto* child = node.first_child(); child; child = child->next_sibling()) {
+        if (child->needs_style_update() && is<Element>(*child))
+            to<Element>(*child).recompute_style();
+        if (child->child_needs_style_update())
+            update_style_of_children(*child);
+    }
+    node.set_child_needs_style_update(false);
 }
 
 void Document::update_style()
 {
-    for_each_in_subtree_of_type<Element>([&](auto& element) {
-        if (element.needs_style_update())
-            element.recompute_style();
-        return IterationDecision::Continue;
-    });
-    update_layout();
+    {
+        PerformanceTimeline::Measurement measurement(m_performance_timeline, PerformanceTimeline::Category::Style, "Recompute style");
+        update_style_of_children(*this);
+    }
+#ifdef STYLE_DEBUG
+    style_resolver().dump_statistics();
+#endif
+    if (!m_layout_root || m_needs_layout_tree_rebuild || m_layout_root->needs_layout() || m_layout_root->child_needs_layout())
+        update_layout();
+}
+
+void Document::update_style_and_layout_if_needed()
+{
+    if (!m_style_update_timer->is_active() && !m_needs_layout_tree_rebuild)
+        return;
+    m_style_update_timer->stop();
+    update_style();
 }
 
 void Document::update_layout()
@@ -309,7 +347,27 @@ void Document::set_hovered_node(Node* node)
     RefPtr<Node> old_hovered_node = move(m_hovered_node);
     m_hovered_node = node;
 
-    invalidate_style();
+    auto invalidation = style_resolver().invalidation_for_hover();
+    if (invalidation == StyleInvalidation::None)
+        return;
+
+    // :hover matches the hovered node and its ancestors, so only the ones that aren't ancestors
+    // of both the old and the new hovered node change.
+    Node* common_ancestor = nullptr;
+    for (auto* ancestor = old_hovered_node.ptr(); ancestor && m_hovered_node; ancestor = ancestor->parent()) {
+        if (ancestor == m_hovered_node || ancestor->is_ancestor_of(*m_hovered_node)) {
+            common_ancestor = ancestor;
+            break;
+        }
+    }
+    auto invalidate_up_to_common_ancestor = [&](Node* node) {
+        for (; node && node != common_ancestor; node = node->parent()) {
+            if (is<Element>(*node))
+                to<Element>(*node).apply_style_invalidation(invalidation);
+        }
+    };
+    invalidate_up_to_common_ancestor(old_hovered_node.ptr());
+    invalidate_up_to_common_ancestor(m_hovered_node.ptr());
 }
 
 Vector<const Element*> Document::get_elements_by_name(const String& name) const
@@ -399,6 +457,7 @@ JS::Interpreter& Document::interpreter()
 JS::Value Document::run_javascript(const StringView& source)
 {
     auto parser = JS::Parser(JS::Lexer(source));
+    parser.set_lazy_function_bodies(true);
     auto program = parser.parse_program();
     if (parser.has_errors()) {
         parser.print_errors();
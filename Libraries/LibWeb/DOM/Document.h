@@ -39,6 +39,7 @@
 #include <LibWeb/CSS/StyleSheet.h>
 #include <LibWeb/DOM/NonElementParentNode.h>
 #include <LibWeb/DOM/ParentNode.h>
+#include <LibWeb/PerformanceTimeline.h>
 
 namespace Web {
 
@@ -63,7 +64,7 @@ public:
     StyleResolver& style_resolver() { return *m_style_resolver; }
     const StyleResolver& style_resolver() const { return *m_style_resolver; }
 
-    void add_sheet(const StyleSheet& sheet) { m_sheets.append(sheet); }
+    void add_sheet(const StyleSheet&);
     const NonnullRefPtrVector<StyleSheet>& stylesheets() const { return m_sheets; }
 
     virtual FlyString tag_name() const override { return "#document"; }
@@ -102,12 +103,23 @@ public:
 
     void layout();
     void force_layout();
+
+    // Throws away the layout tree the next time style or layout is updated, instead of right away,
+    // so that many DOM mutations in a row only cause one rebuild.
     void invalidate_layout();
+    bool needs_layout_tree_rebuild() const { return m_needs_layout_tree_rebuild; }
 
     void update_style();
     void update_layout();
+
+    // Runs style and layout updates that are scheduled but haven't happened yet. Anything that looks
+    // at the layout tree after the DOM may have changed (painting, hit testing) has to call this first.
+    void update_style_and_layout_if_needed();
     Function<void()> on_layout_updated;
 
+    PerformanceTimeline& performance_timeline() { return m_performance_timeline; }
+    const PerformanceTimeline& performance_timeline() const { return m_performance_timeline; }
+
     virtual bool is_child_allowed(const Node&) const override;
 
     const LayoutDocument* layout_node() const;
@@ -161,6 +173,7 @@ private:
     Optional<Color> m_visited_link_color;
 
     RefPtr<Core::Timer> m_style_update_timer;
+    bool m_needs_layout_tree_rebuild { false };
 
     String m_source;
 
@@ -171,6 +184,8 @@ private:
     NonnullRefPtrVector<HTMLScriptElement> m_scripts_to_execute_as_soon_as_possible;
 
     bool m_quirks_mode { false };
+
+    PerformanceTimeline m_performance_timeline;
 };
 
 template<>
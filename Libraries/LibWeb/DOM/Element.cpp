@@ -28,6 +28,7 @@
 #include <LibWeb/CSS/Length.h>
 #include <LibWeb/CSS/PropertyID.h>
 #include <LibWeb/CSS/StyleResolver.h>
+#include <LibWeb/DOM/AttributeNames.h>
 #include <LibWeb/DOM/Document.h>
 #include <LibWeb/DOM/DocumentFragment.h>
 #include <LibWeb/DOM/Element.h>
@@ -39,7 +40,6 @@
 #include <LibWeb/Layout/LayoutTable.h>
 #include <LibWeb/Layout/LayoutTableCell.h>
 #include <LibWeb/Layout/LayoutTableRow.h>
-#include <LibWeb/Layout/LayoutTreeBuilder.h>
 #include <LibWeb/Parser/HTMLParser.h>
 
 namespace Web {
@@ -81,12 +81,81 @@ String Element::attribute(const FlyString& name) const
 
 void Element::set_attribute(const FlyString& name, const String& value)
 {
-    if (auto* attribute = find_attribute(name))
+    String old_value;
+    if (auto* attribute = find_attribute(name)) {
+        if (attribute->value() == value)
+            return;
+        old_value = attribute->value();
         attribute->set_value(value);
-    else
+    } else {
         m_attributes.empend(name, value);
+    }
 
+    // This has to look at the classes before parse_attribute() replaces them.
+    auto invalidation = style_invalidation_for_attribute_change(name, old_value, value);
     parse_attribute(name, value);
+    apply_style_invalidation(invalidation);
+}
+
+static bool contains_class(const Vector<StringView>& classes, const FlyString& class_name)
+{
+    for (auto& class_ : classes) {
+        if (class_name == class_)
+            return true;
+    }
+    return false;
+}
+
+StyleInvalidation Element::style_invalidation_for_attribute_change(const FlyString& name, const String& old_value, const String& new_value) const
+{
+    // Any attribute may be a presentational hint, or the style attribute, so this element always
+    // has to be resolved again. How far beyond it the change reaches depends on the selectors.
+    auto invalidation = StyleInvalidation::Self;
+    auto widen = [&](StyleInvalidation other) {
+        if (invalidation < other)
+            invalidation = other;
+    };
+
+    auto& style_resolver = document().style_resolver();
+    widen(style_resolver.invalidation_for_attribute(name));
+
+    if (name == HTML::AttributeNames::id) {
+        if (!old_value.is_null())
+            widen(style_resolver.invalidation_for_id(old_value));
+        widen(style_resolver.invalidation_for_id(new_value));
+    } else if (name == HTML::AttributeNames::class_) {
+        // Only the classes that were added or removed matter.
+        auto new_classes = new_value.split_view(' ');
+        for (auto& class_name : m_classes) {
+            if (!contains_class(new_classes, class_name))
+                widen(style_resolver.invalidation_for_class(class_name));
+        }
+        for (auto& class_name : new_classes) {
+            if (!has_class(class_name))
+                widen(style_resolver.invalidation_for_class(class_name));
+        }
+    }
+    return invalidation;
+}
+
+void Element::apply_style_invalidation(StyleInvalidation invalidation)
+{
+    switch (invalidation) {
+    case StyleInvalidation::None:
+        return;
+    case StyleInvalidation::Self:
+        set_needs_style_update(true);
+        return;
+    case StyleInvalidation::Subtree:
+        invalidate_style();
+        return;
+    case StyleInvalidation::SubtreeAndFollowingSiblings:
+        invalidate_style();
+        for (auto* sibling = next_sibling(); sibling; sibling = sibling->next_sibling())
+            sibling->invalidate_style();
+        return;
+    }
+    ASSERT_NOT_REACHED();
 }
 
 void Element::set_attributes(Vector<Attribute>&& attributes)
@@ -152,20 +221,60 @@ enum class StyleDifference {
     None,
     NeedsRepaint,
     NeedsRelayout,
+    NeedsLayoutTreeRebuild,
 };
 
-static StyleDifference compute_style_difference(const StyleProperties& old_style, const StyleProperties& new_style, const Document& document)
+static bool property_differs(const StyleProperties& old_style, const StyleProperties& new_style, CSS::PropertyID property_id)
+{
+    auto old_value = old_style.property(property_id);
+    auto new_value = new_style.property(property_id);
+    if (old_value.has_value() != new_value.has_value())
+        return true;
+    if (!old_value.has_value())
+        return false;
+    return old_value.value()->type() != new_value.value()->type() || old_value.value()->to_string() != new_value.value()->to_string();
+}
+
+static bool only_affects_painting(CSS::PropertyID property_id)
+{
+    switch (property_id) {
+    case CSS::PropertyID::BackgroundColor:
+    case CSS::PropertyID::BackgroundImage:
+    case CSS::PropertyID::BorderBottomColor:
+    case CSS::PropertyID::BorderLeftColor:
+    case CSS::PropertyID::BorderRightColor:
+    case CSS::PropertyID::BorderTopColor:
+    case CSS::PropertyID::Color:
+    case CSS::PropertyID::Cursor:
+    case CSS::PropertyID::TextDecoration:
+    case CSS::PropertyID::Visibility:
+        return true;
+    default:
+        return false;
+    }
+}
+
+static StyleDifference compute_style_difference(const StyleProperties& old_style, const StyleProperties& new_style)
 {
     if (old_style == new_style)
         return StyleDifference::None;
 
+    // Changing the display type changes what kind of layout node the element needs.
+    if (property_differs(old_style, new_style, CSS::PropertyID::Display))
+        return StyleDifference::NeedsLayoutTreeRebuild;
+
     bool needs_repaint = false;
     bool needs_relayout = false;
-
-    if (new_style.color_or_fallback(CSS::PropertyID::Color, document, Color::Black) != old_style.color_or_fallback(CSS::PropertyID::Color, document, Color::Black))
-        needs_repaint = true;
-    else if (new_style.color_or_fallback(CSS::PropertyID::BackgroundColor, document, Color::Black) != old_style.color_or_fallback(CSS::PropertyID::BackgroundColor, document, Color::Black))
-        needs_repaint = true;
+    auto check_property = [&](auto property_id, auto&) {
+        if (needs_relayout || !property_differs(old_style, new_style, property_id))
+            return;
+        if (only_affects_painting(property_id))
+            needs_repaint = true;
+        else
+            needs_relayout = true;
+    };
+    old_style.for_each_property(check_property);
+    new_style.for_each_property(check_property);
 
     if (needs_relayout)
         return StyleDifference::NeedsRelayout;
@@ -181,27 +290,35 @@ void Element::recompute_style()
     auto* parent_layout_node = parent()->layout_node();
     if (!parent_layout_node)
         return;
-    ASSERT(parent_layout_node);
     auto style = document().style_resolver().resolve_style(*this, &parent_layout_node->style());
     m_resolved_style = style;
     if (!layout_node()) {
         if (style->string_or_fallback(CSS::PropertyID::Display, "inline") == "none")
             return;
-        // We need a new layout tree here!
-        LayoutTreeBuilder tree_builder;
-        tree_builder.build(*this);
+        // FIXME: Build just the layout subtree for this element instead of the whole tree.
+        document().invalidate_layout();
         return;
     }
-    auto diff = compute_style_difference(layout_node()->style(), *style, document());
+    auto diff = compute_style_difference(layout_node()->style(), *style);
     if (diff == StyleDifference::None)
         return;
+    if (diff == StyleDifference::NeedsLayoutTreeRebuild) {
+        // FIXME: Rebuild just the layout subtree for this element instead of the whole tree.
+        document().invalidate_layout();
+        return;
+    }
     layout_node()->set_style(*style);
-    if (diff == StyleDifference::NeedsRelayout) {
-        ASSERT_NOT_REACHED();
+
+    // The children may inherit something that changed.
+    for (auto* child = first_child(); child; child = child->next_sibling()) {
+        if (is<Element>(*child))
+            child->set_needs_style_update(true);
     }
-    if (diff == StyleDifference::NeedsRepaint) {
+
+    if (diff == StyleDifference::NeedsRelayout)
+        layout_node()->set_needs_layout();
+    else
         layout_node()->set_needs_display();
-    }
 }
 
 NonnullRefPtr<StyleProperties> Element::computed_style()
@@ -233,18 +350,22 @@ NonnullRefPtr<StyleProperties> Element::computed_style()
 
 void Element::set_inner_html(StringView markup)
 {
+    // This has to happen before the old children (and their layout nodes) go away, so that nothing
+    // paints or hit-tests the layout tree until it has been rebuilt.
+    document().invalidate_layout();
+
     auto fragment = parse_html_fragment(document(), markup);
     remove_all_children();
     if (!fragment)
         return;
     while (RefPtr<Node> child = fragment->first_child()) {
-        fragment->remove_child(*child);
-        append_child(*child);
+        fragment->remove_child(*child, false);
+        append_child(*child, false);
+        child->inserted_into(*this);
     }
+    children_changed();
 
     set_needs_style_update(true);
-    document().schedule_style_update();
-    document().invalidate_layout();
 }
 
 String Element::inner_html() const
@@ -35,6 +35,7 @@
 namespace Web {
 
 class LayoutNodeWithStyle;
+enum class StyleInvalidation;
 
 class Element : public ParentNode {
 public:
@@ -50,6 +51,7 @@ public:
     void set_attribute(const FlyString& name, const String& value);
 
     void set_attributes(Vector<Attribute>&&);
+    size_t attribute_count() const { return m_attributes.size(); }
 
     template<typename Callback>
     void for_each_attribute(Callback callback) const
@@ -59,11 +61,13 @@ public:
     }
 
     bool has_class(const FlyString&) const;
+    const Vector<FlyString>& class_names() const { return m_classes; }
 
     virtual void apply_presentational_hints(StyleProperties&) const { }
     virtual void parse_attribute(const FlyString& name, const String& value);
 
     void recompute_style();
+    void apply_style_invalidation(StyleInvalidation);
 
     LayoutNodeWithStyle* layout_node() { return static_cast<LayoutNodeWithStyle*>(Node::layout_node()); }
     const LayoutNodeWithStyle* layout_node() const { return static_cast<const LayoutNodeWithStyle*>(Node::layout_node()); }
@@ -82,6 +86,8 @@ private:
     Attribute* find_attribute(const FlyString& name);
     const Attribute* find_attribute(const FlyString& name) const;
 
+    StyleInvalidation style_invalidation_for_attribute_change(const FlyString& name, const String& old_value, const String& new_value) const;
+
     FlyString m_tag_name;
     Vector<Attribute> m_attributes;
 
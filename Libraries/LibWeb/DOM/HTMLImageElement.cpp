@@ -27,6 +27,7 @@
 #include <LibCore/Timer.h>
 #include <LibGfx/Bitmap.h>
 #include <LibGfx/ImageDecoder.h>
+#include <LibThread/BackgroundAction.h>
 #include <LibWeb/CSS/StyleResolver.h>
 #include <LibWeb/DOM/Document.h>
 #include <LibWeb/DOM/Event.h>
@@ -36,6 +37,12 @@
 
 namespace Web {
 
+struct HTMLImageElement::DecodedImage {
+    Gfx::Size natural_size;
+    RefPtr<Gfx::Bitmap> bitmap;
+    RefPtr<Gfx::ImageDecoder> animated_image_decoder;
+};
+
 HTMLImageElement::HTMLImageElement(Document& document, const FlyString& tag_name)
     : HTMLElement(document, tag_name)
     , m_timer(Core::Timer::construct())
@@ -48,8 +55,19 @@ HTMLImageElement::~HTMLImageElement()
 
 void HTMLImageElement::parse_attribute(const FlyString& name, const String& value)
 {
-    if (name.equals_ignoring_case("src"))
+    if (name.equals_ignoring_case("src")) {
         load_image(value);
+        return;
+    }
+
+    if (name.equals_ignoring_case("width") || name.equals_ignoring_case("height")) {
+        // A bitmap that was decoded at the old displayed size may now be too small.
+        if (m_bitmap && m_bitmap->size() != m_natural_size) {
+            auto displayed_size = displayed_size_from_attributes();
+            if (displayed_size.is_empty() || displayed_size.width() > m_bitmap->width() || displayed_size.height() > m_bitmap->height())
+                decode_image();
+        }
+    }
 }
 
 void HTMLImageElement::load_image(const String& src)
@@ -66,24 +84,144 @@ void HTMLImageElement::load_image(const String& src)
         }
 
         m_encoded_data = data;
-        m_image_decoder = Gfx::ImageDecoder::create(m_encoded_data.data(), m_encoded_data.size());
+        m_image_decoder = nullptr;
+        m_bitmap = nullptr;
+        m_timer->stop();
+        m_current_frame_index = 0;
+        m_loops_completed = 0;
+        m_load_event_pending = true;
+        decode_image();
+    });
+}
+
+Gfx::Size HTMLImageElement::displayed_size_from_attributes() const
+{
+    bool width_ok = false;
+    bool height_ok = false;
+    int width = attribute("width").to_int(width_ok);
+    int height = attribute("height").to_int(height_ok);
+    if (!width_ok || !height_ok || width <= 0 || height <= 0)
+        return {};
+    return { width, height };
+}
+
+// Shrinks a bitmap by averaging all the source pixels that end up in each destination pixel.
+static RefPtr<Gfx::Bitmap> downscale_bitmap(const Gfx::Bitmap& source, const Gfx::Size& size)
+{
+    auto bitmap = Gfx::Bitmap::create_purgeable(source.has_alpha_channel() ? Gfx::BitmapFormat::RGBA32 : Gfx::BitmapFormat::RGB32, size);
+    if (!bitmap)
+        return nullptr;
+
+    for (int y = 0; y < size.height(); ++y) {
+        int source_top = y * source.height() / size.height();
+        int source_bottom = max(source_top + 1, (y + 1) * source.height() / size.height());
+        for (int x = 0; x < size.width(); ++x) {
+            int source_left = x * source.width() / size.width();
+            int source_right = max(source_left + 1, (x + 1) * source.width() / size.width());
+            u32 red = 0;
+            u32 green = 0;
+            u32 blue = 0;
+            u32 alpha = 0;
+            for (int source_y = source_top; source_y < source_bottom; ++source_y) {
+                for (int source_x = source_left; source_x < source_right; ++source_x) {
+                    auto color = source.get_pixel(source_x, source_y);
+                    red += color.red();
+                    green += color.green();
+                    blue += color.blue();
+                    alpha += color.alpha();
+                }
+            }
+            u32 count = (source_bottom - source_top) * (source_right - source_left);
+            bitmap->set_pixel(x, y, Color(red / count, green / count, blue / count, alpha / count));
+        }
+    }
+    return bitmap;
+}
+
+void HTMLImageElement::decode_image()
+{
+    if (m_encoded_data.is_null())
+        return;
+
+    // A decode that's still running for older data or an older displayed size will be ignored when it finishes.
+    u32 generation = ++m_decode_generation;
+    m_decode_in_progress = true;
+
+    LibThread::BackgroundAction<DecodedImage>::create(
+        [data = m_encoded_data, displayed_size = displayed_size_from_attributes()] {
+            DecodedImage decoded_image;
+            auto decoder = Gfx::ImageDecoder::create(data.data(), data.size());
+            decoded_image.natural_size = decoder->size();
+
+            if (decoder->is_animated() && decoder->frame_count() > 1) {
+                // FIXME: Frames after the first one are still decoded on the main thread as they're shown.
+                decoded_image.bitmap = decoder->frame(0).image;
+                decoded_image.animated_image_decoder = move(decoder);
+                return decoded_image;
+            }
+
+            auto bitmap = decoder->bitmap();
+            // There's no point in keeping (and painting from) many more pixels than will be shown.
+            if (bitmap && !displayed_size.is_empty() && displayed_size.width() * 2 <= bitmap->width() && displayed_size.height() * 2 <= bitmap->height()) {
+                if (auto downscaled_bitmap = downscale_bitmap(*bitmap, displayed_size))
+                    bitmap = move(downscaled_bitmap);
+            }
+            decoded_image.bitmap = move(bitmap);
+            return decoded_image;
+        },
+        [this, weak_element = make_weak_ptr(), generation](DecodedImage decoded_image) {
+            if (!weak_element || generation != m_decode_generation)
+                return;
+            did_decode_image(decoded_image);
+        });
+}
+
+void HTMLImageElement::did_decode_image(DecodedImage& decoded_image)
+{
+    m_decode_in_progress = false;
+
+    if (!decoded_image.bitmap) {
+        dbg() << "HTMLImageElement: Failed to decode " << src();
+        return;
+    }
 
-        if (m_image_decoder->is_animated() && m_image_decoder->frame_count() > 1) {
-            const auto& first_frame = m_image_decoder->frame(0);
-            m_timer->set_interval(first_frame.duration);
+    bool natural_size_changed = m_natural_size != decoded_image.natural_size;
+    m_natural_size = decoded_image.natural_size;
+
+    if (decoded_image.animated_image_decoder) {
+        m_image_decoder = move(decoded_image.animated_image_decoder);
+        m_bitmap = nullptr;
+        if (!m_timer->is_active()) {
+            const auto& current_frame = m_image_decoder->frame(m_current_frame_index);
+            m_timer->set_interval(current_frame.duration);
             m_timer->on_timeout = [this] { animate(); };
             m_timer->start();
         }
+    } else {
+        m_bitmap = move(decoded_image.bitmap);
+        if (m_volatile && m_bitmap->is_purgeable())
+            m_bitmap->set_volatile();
+    }
 
-        document().update_layout();
+    if (layout_node()) {
+        if (natural_size_changed) {
+            // Only the image itself changed size, so only its containing blocks need layout.
+            layout_node()->set_needs_layout();
+            document().update_layout();
+        } else {
+            layout_node()->set_needs_display();
+        }
+    }
 
+    if (m_load_event_pending) {
+        m_load_event_pending = false;
         dispatch_event(Event::create("load"));
-    });
+    }
 }
 
 void HTMLImageElement::animate()
 {
-    if (!layout_node()) {
+    if (!layout_node() || !m_image_decoder) {
         return;
     }
 
@@ -111,8 +249,8 @@ int HTMLImageElement::preferred_width() const
     if (ok)
         return width;
 
-    if (m_image_decoder)
-        return m_image_decoder->width();
+    if (!m_natural_size.is_empty())
+        return m_natural_size.width();
 
     return 0;
 }
@@ -124,8 +262,8 @@ int HTMLImageElement::preferred_height() const
     if (ok)
         return height;
 
-    if (m_image_decoder)
-        return m_image_decoder->height();
+    if (!m_natural_size.is_empty())
+        return m_natural_size.height();
 
     return 0;
 }
@@ -141,28 +279,44 @@ RefPtr<LayoutNode> HTMLImageElement::create_layout_node(const StyleProperties* p
 
 const Gfx::Bitmap* HTMLImageElement::bitmap() const
 {
-    if (!m_image_decoder)
-        return nullptr;
-
-    if (m_image_decoder->is_animated()) {
+    if (m_image_decoder)
         return m_image_decoder->frame(m_current_frame_index).image;
-    }
-
-    return m_image_decoder->bitmap();
+    return m_bitmap.ptr();
 }
 
 void HTMLImageElement::set_volatile(Badge<LayoutDocument>, bool v)
 {
-    if (!m_image_decoder)
+    m_volatile = v;
+
+    if (m_image_decoder) {
+        if (v) {
+            m_image_decoder->set_volatile();
+            return;
+        }
+        if (m_image_decoder->set_nonvolatile())
+            return;
+        // The kernel took back the decoded frames while we were offscreen.
+        m_image_decoder = nullptr;
+        decode_image();
+        return;
+    }
+
+    if (!m_bitmap) {
+        if (!v && !m_decode_in_progress && !m_natural_size.is_empty())
+            decode_image();
+        return;
+    }
+
+    if (!m_bitmap->is_purgeable())
         return;
     if (v) {
-        m_image_decoder->set_volatile();
+        m_bitmap->set_volatile();
         return;
     }
-    bool has_image = m_image_decoder->set_nonvolatile();
-    if (has_image)
+    if (m_bitmap->set_nonvolatile())
         return;
-    m_image_decoder = Gfx::ImageDecoder::create(m_encoded_data.data(), m_encoded_data.size());
+    m_bitmap = nullptr;
+    decode_image();
 }
 
 }
@@ -29,6 +29,7 @@
 #include <AK/ByteBuffer.h>
 #include <LibCore/Forward.h>
 #include <LibGfx/Forward.h>
+#include <LibGfx/Size.h>
 #include <LibWeb/DOM/HTMLElement.h>
 
 namespace Web {
@@ -49,21 +50,38 @@ public:
     int preferred_width() const;
     int preferred_height() const;
 
+    // Known once the image has been decoded for the first time.
+    const Gfx::Size& natural_size() const { return m_natural_size; }
+
+    // May be null while the image is being decoded, or smaller than natural_size() if it's displayed smaller.
     const Gfx::Bitmap* bitmap() const;
-    const Gfx::ImageDecoder* image_decoder() const { return m_image_decoder; }
+    bool is_animated() const { return m_image_decoder; }
 
     void set_volatile(Badge<LayoutDocument>, bool);
 
 private:
+    struct DecodedImage;
+
     void load_image(const String& src);
+    void decode_image();
+    void did_decode_image(DecodedImage&);
+    Gfx::Size displayed_size_from_attributes() const;
 
     void animate();
 
     virtual RefPtr<LayoutNode> create_layout_node(const StyleProperties* parent_style) const override;
 
+    // Only kept for animated images, whose frames are decoded as they're shown.
     RefPtr<Gfx::ImageDecoder> m_image_decoder;
+    RefPtr<Gfx::Bitmap> m_bitmap;
+    Gfx::Size m_natural_size;
     ByteBuffer m_encoded_data;
 
+    u32 m_decode_generation { 0 };
+    bool m_decode_in_progress { false };
+    bool m_load_event_pending { false };
+    bool m_volatile { false };
+
     size_t m_current_frame_index { 0 };
     size_t m_loops_completed { 0 };
     NonnullRefPtr<Core::Timer> m_timer;
@@ -27,6 +27,7 @@
 #include <AK/ByteBuffer.h>
 #include <AK/URL.h>
 #include <LibCore/File.h>
+#include <LibThread/BackgroundAction.h>
 #include <LibWeb/DOM/Document.h>
 #include <LibWeb/DOM/HTMLLinkElement.h>
 #include <LibWeb/Parser/CSSParser.h>
@@ -47,18 +48,28 @@ void HTMLLinkElement::inserted_into(Node&)
 {
     if (rel() == "stylesheet") {
         URL url = document().complete_url(href());
-        ResourceLoader::the().load(url, [&](auto data, auto&) {
+        ResourceLoader::the().load(url, [this, weak_element = make_weak_ptr()](auto data, auto&) {
+            if (!weak_element)
+                return;
             if (data.is_null()) {
                 dbg() << "HTMLLinkElement: Failed to load stylesheet: " << href();
                 return;
             }
-            auto sheet = parse_css(data);
-            if (!sheet) {
-                dbg() << "HTMLLinkElement: Failed to parse stylesheet: " << href();
-                return;
-            }
-            document().add_sheet(*sheet);
-            document().update_style();
+            // Each linked stylesheet is parsed on a background thread, so several can be parsed at once.
+            LibThread::BackgroundAction<RefPtr<StyleSheet>>::create(
+                [data = move(data)] {
+                    return parse_css(data);
+                },
+                [this, weak_element = move(weak_element)](RefPtr<StyleSheet> sheet) {
+                    if (!weak_element)
+                        return;
+                    if (!sheet) {
+                        dbg() << "HTMLLinkElement: Failed to parse stylesheet: " << href();
+                        return;
+                    }
+                    document().add_sheet(*sheet);
+                    document().update_style();
+                });
         });
     }
 }
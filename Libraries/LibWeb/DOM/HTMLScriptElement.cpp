@@ -25,8 +25,10 @@
  */
 
 #include <AK/StringBuilder.h>
+#include <LibCore/StandardPaths.h>
 #include <LibJS/Interpreter.h>
 #include <LibJS/Parser.h>
+#include <LibJS/ScriptCache.h>
 #include <LibWeb/DOM/Document.h>
 #include <LibWeb/DOM/HTMLScriptElement.h>
 #include <LibWeb/DOM/Text.h>
@@ -34,6 +36,13 @@
 
 namespace Web {
 
+// External scripts tend to be loaded again and again, so their tokens are kept around.
+static const JS::ScriptCache& script_cache()
+{
+    static JS::ScriptCache* cache = new JS::ScriptCache(String::format("%s/js-script-cache", Core::StandardPaths::tempfile_directory().characters()));
+    return *cache;
+}
+
 HTMLScriptElement::HTMLScriptElement(Document& document, const FlyString& tag_name)
     : HTMLElement(document, tag_name)
 {
@@ -41,6 +50,8 @@ HTMLScriptElement::HTMLScriptElement(Document& document, const FlyString& tag_na
 
 HTMLScriptElement::~HTMLScriptElement()
 {
+    if (m_is_lexing_in_background)
+        pthread_join(m_background_lexer_thread, nullptr);
 }
 
 void HTMLScriptElement::set_parser_document(Badge<HTMLDocumentParser>, Document& document)
@@ -69,7 +80,9 @@ void HTMLScriptElement::children_changed()
     if (source.is_empty())
         return;
 
+    PerformanceTimeline::Measurement measurement(document().performance_timeline(), PerformanceTimeline::Category::Script, name_for_performance_timeline());
     auto parser = JS::Parser(JS::Lexer(source));
+    parser.set_lazy_function_bodies(true);
     auto program = parser.parse_program();
     if (parser.has_errors()) {
         parser.print_errors();
@@ -106,7 +119,10 @@ void HTMLScriptElement::inserted_into(Node& new_parent)
     }
 
     dbg() << "Parsing and running script from " << src_url;
-    auto parser = JS::Parser(JS::Lexer(source));
+    PerformanceTimeline::Measurement measurement(document().performance_timeline(), PerformanceTimeline::Category::Script, name_for_performance_timeline());
+    auto lexer = JS::Lexer(source);
+    auto parser = JS::Parser(JS::Lexer(source, script_cache().tokens_for(source, lexer)));
+    parser.set_lazy_function_bodies(true);
     auto program = parser.parse_program();
     if (parser.has_errors()) {
         parser.print_errors();
@@ -115,9 +131,57 @@ void HTMLScriptElement::inserted_into(Node& new_parent)
     document().interpreter().run(*program);
 }
 
+void HTMLScriptElement::start_lexing_script_source_in_background()
+{
+    if (m_is_lexing_in_background || m_script_source.is_empty())
+        return;
+
+    // The lexer is created here rather than on the thread, as creating the first one sets up
+    // tables that every lexer shares.
+    m_background_lexer = JS::Lexer(m_script_source);
+    int rc = pthread_create(
+        &m_background_lexer_thread,
+        nullptr,
+        [](void* arg) -> void* {
+            auto& script = *static_cast<HTMLScriptElement*>(arg);
+            script.m_background_tokens = script_cache().tokens_for(script.m_script_source, script.m_background_lexer.value());
+            return nullptr;
+        },
+        this);
+    if (rc != 0) {
+        m_background_lexer.clear();
+        return;
+    }
+    m_is_lexing_in_background = true;
+}
+
+JS::Lexer HTMLScriptElement::take_lexer_for_script_source()
+{
+    if (!m_is_lexing_in_background) {
+        auto lexer = JS::Lexer(m_script_source);
+        if (!m_from_an_external_file)
+            return lexer;
+        return JS::Lexer(m_script_source, script_cache().tokens_for(m_script_source, lexer));
+    }
+
+    pthread_join(m_background_lexer_thread, nullptr);
+    m_is_lexing_in_background = false;
+    m_background_lexer.clear();
+    return JS::Lexer(m_script_source, m_background_tokens.release_nonnull());
+}
+
+String HTMLScriptElement::name_for_performance_timeline() const
+{
+    if (has_attribute("src"))
+        return attribute("src");
+    return "Inline script";
+}
+
 void HTMLScriptElement::execute_script()
 {
-    auto parser = JS::Parser(JS::Lexer(m_script_source));
+    PerformanceTimeline::Measurement measurement(document().performance_timeline(), PerformanceTimeline::Category::Script, name_for_performance_timeline());
+    auto parser = JS::Parser(take_lexer_for_script_source());
+    parser.set_lazy_function_bodies(true);
     auto program = parser.parse_program();
     if (parser.has_errors()) {
         parser.print_errors();
@@ -206,6 +270,7 @@ void HTMLScriptElement::prepare_script(Badge<HTMLDocumentParser>)
 
     // FIXME: Check classic vs. module
     if (has_attribute("src") && has_attribute("defer") && m_parser_inserted && !has_attribute("async")) {
+        start_lexing_script_source_in_background();
         document().add_script_to_execute_when_parsing_has_finished({}, *this);
     }
 
@@ -222,6 +287,7 @@ void HTMLScriptElement::prepare_script(Badge<HTMLDocumentParser>)
     }
 
     else if (has_attribute("src")) {
+        start_lexing_script_source_in_background();
         m_preparation_time_document->add_script_to_execute_as_soon_as_possible({}, *this);
     }
 
@@ -27,7 +27,10 @@
 #pragma once
 
 #include <AK/Function.h>
+#include <AK/Optional.h>
+#include <LibJS/Lexer.h>
 #include <LibWeb/DOM/HTMLElement.h>
+#include <pthread.h>
 
 namespace Web {
 
@@ -48,9 +51,16 @@ public:
     void execute_script();
 
 private:
+    String name_for_performance_timeline() const;
+
     void script_became_ready();
     void when_the_script_is_ready(Function<void()>);
 
+    // Deferred and async scripts don't run right away, so their sources get lexed on a
+    // background thread while the document parser carries on.
+    void start_lexing_script_source_in_background();
+    JS::Lexer take_lexer_for_script_source();
+
     WeakPtr<Document> m_parser_document;
     WeakPtr<Document> m_preparation_time_document;
     bool m_non_blocking { false };
@@ -63,6 +73,11 @@ private:
     Function<void()> m_script_ready_callback;
 
     String m_script_source;
+
+    Optional<JS::Lexer> m_background_lexer;
+    RefPtr<JS::TokenBuffer> m_background_tokens;
+    pthread_t m_background_lexer_thread;
+    bool m_is_lexing_in_background { false };
 };
 
 template<>
@@ -25,7 +25,7 @@
  */
 
 #include <LibGfx/Bitmap.h>
-#include <LibJS/Runtime/Uint8ClampedArray.h>
+#include <LibJS/Runtime/TypedArray.h>
 #include <LibWeb/DOM/ImageData.h>
 
 namespace Web {
@@ -47,6 +47,7 @@ RefPtr<ImageData> ImageData::create_with_size(JS::GlobalObject& global_object, i
 
     auto data_handle = JS::make_handle(data);
 
+    // The bitmap wraps the array's backing ArrayBuffer, so scripts and painting share the same pixels.
     auto bitmap = Gfx::Bitmap::create_wrapper(Gfx::BitmapFormat::RGBA32, Gfx::Size(width, height), width * sizeof(u32), (u32*)data->data());
     if (!bitmap)
         return nullptr;
@@ -113,6 +113,21 @@ RefPtr<LayoutNode> Node::create_layout_node(const StyleProperties*) const
     return nullptr;
 }
 
+void Node::set_needs_style_update(bool value)
+{
+    if (m_needs_style_update == value)
+        return;
+    m_needs_style_update = value;
+    if (!value)
+        return;
+    for (auto* ancestor = parent(); ancestor; ancestor = ancestor->parent()) {
+        if (ancestor->m_child_needs_style_update)
+            break;
+        ancestor->m_child_needs_style_update = true;
+    }
+    document().schedule_style_update();
+}
+
 void Node::invalidate_style()
 {
     for_each_in_subtree_of_type<Element>([&](auto& element) {
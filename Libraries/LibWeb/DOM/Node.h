@@ -122,7 +122,12 @@ public:
     virtual bool is_child_allowed(const Node&) const { return true; }
 
     bool needs_style_update() const { return m_needs_style_update; }
-    void set_needs_style_update(bool value) { m_needs_style_update = value; }
+    void set_needs_style_update(bool);
+
+    // Set on the ancestors of nodes that need a style update, so that Document::update_style()
+    // can skip the subtrees that don't have any.
+    bool child_needs_style_update() const { return m_child_needs_style_update; }
+    void set_child_needs_style_update(bool value) { m_child_needs_style_update = value; }
 
     void invalidate_style();
 
@@ -135,6 +140,7 @@ protected:
     mutable LayoutNode* m_layout_node { nullptr };
     NodeType m_type { NodeType::INVALID };
     bool m_needs_style_update { false };
+    bool m_child_needs_style_update { false };
 };
 
 template<typename T>
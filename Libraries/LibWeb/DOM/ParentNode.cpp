@@ -30,9 +30,12 @@ namespace Web {
 
 void ParentNode::remove_all_children()
 {
-    while (RefPtr<Node> child = first_child()) {
-        remove_child(*child);
-    }
+    if (!first_child())
+        return;
+    // Tell ourselves about the removals once, not once per child.
+    while (RefPtr<Node> child = first_child())
+        remove_child(*child, false);
+    children_changed();
 }
 
 }
@@ -43,6 +43,7 @@ class HTMLFormElement;
 class HTMLHeadElement;
 class HTMLHtmlElement;
 class HTMLImageElement;
+class HTMLPreloadScanner;
 class HTMLScriptElement;
 class PageView;
 class ImageData;
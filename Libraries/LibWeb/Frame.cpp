@@ -81,4 +81,14 @@ void Frame::set_needs_display(const Gfx::Rect& rect)
     on_set_needs_display(rect);
 }
 
+void Frame::set_needs_composite(const Gfx::Rect& rect)
+{
+    if (!m_viewport_rect.intersects(rect))
+        return;
+
+    if (!on_set_needs_composite)
+        return;
+    on_set_needs_composite(rect);
+}
+
 }
@@ -58,6 +58,10 @@ public:
     void set_needs_display(const Gfx::Rect&);
     Function<void(const Gfx::Rect&)> on_set_needs_display;
 
+    // Only the composited layer covering the rect changed; what's beneath it can stay as it is.
+    void set_needs_composite(const Gfx::Rect&);
+    Function<void(const Gfx::Rect&)> on_set_needs_composite;
+
     void set_viewport_rect(const Gfx::Rect&);
     Gfx::Rect viewport_rect() const { return m_viewport_rect; }
 
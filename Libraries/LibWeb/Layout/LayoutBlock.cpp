@@ -25,12 +25,16 @@
  */
 
 #include <LibGUI/Painter.h>
+#include <LibGUI/Widget.h>
 #include <LibWeb/CSS/StyleResolver.h>
+#include <LibWeb/DOM/Document.h>
 #include <LibWeb/DOM/Element.h>
+#include <LibWeb/Frame.h>
 #include <LibWeb/Layout/LayoutBlock.h>
 #include <LibWeb/Layout/LayoutInline.h>
 #include <LibWeb/Layout/LayoutReplaced.h>
 #include <LibWeb/Layout/LayoutText.h>
+#include <LibWeb/Layout/LayoutWidget.h>
 #include <math.h>
 
 namespace Web {
@@ -53,8 +57,94 @@ LayoutNode& LayoutBlock::inline_wrapper()
     return *last_child();
 }
 
+bool LayoutBlock::can_skip_layout(LayoutMode layout_mode) const
+{
+    // Inline blocks are positioned by their line box, and the other modes measure content.
+    if (layout_mode != LayoutMode::Default || is_inline())
+        return false;
+    if (needs_layout() || child_needs_layout())
+        return false;
+    auto* containing_block = this->containing_block();
+    return containing_block && containing_block->width() == m_containing_block_width_at_last_layout;
+}
+
+void LayoutBlock::move_contents_by(const Gfx::FloatPoint& offset)
+{
+    for_each_fragment([&](auto& fragment) {
+        fragment.rect().move_by(offset);
+        return IterationDecision::Continue;
+    });
+    for_each_in_subtree_of_type<LayoutBox>([&](auto& box) {
+        if (&box == this)
+            return IterationDecision::Continue;
+        box.rect().move_by(offset);
+        if (is<LayoutBlock>(box)) {
+            to<LayoutBlock>(box).for_each_fragment([&](auto& fragment) {
+                fragment.rect().move_by(offset);
+                return IterationDecision::Continue;
+            });
+        }
+        if (box.is_widget())
+            to<LayoutWidget>(box).widget().move_to(box.rect().x(), box.rect().y());
+        return IterationDecision::Continue;
+    });
+}
+
+// Our border box, along with any of our line box fragments that stick out of it.
+Gfx::FloatRect LayoutBlock::visual_rect() const
+{
+    auto visual_rect = bordered_rect();
+    for_each_fragment([&](auto& fragment) {
+        visual_rect = visual_rect.united(fragment.rect());
+        return IterationDecision::Continue;
+    });
+    return visual_rect;
+}
+
+void LayoutBlock::did_change_visual_rect(const Gfx::FloatRect& old_visual_rect)
+{
+    auto new_visual_rect = visual_rect();
+    if (new_visual_rect == old_visual_rect && !needs_layout() && !children_are_inline())
+        return;
+
+    auto* frame = document().frame();
+    ASSERT(frame);
+
+    // Our block children damage what they change themselves, so if all that happened to us
+    // is that they made us taller or shorter, only the part below the shorter bottom changed.
+    if (!needs_layout() && !children_are_inline()
+        && new_visual_rect.x() == old_visual_rect.x()
+        && new_visual_rect.y() == old_visual_rect.y()
+        && new_visual_rect.width() == old_visual_rect.width()) {
+        float bottom_edge = box_model().padding().bottom.to_px() + box_model().border().bottom.to_px();
+        float top = min(old_visual_rect.bottom(), new_visual_rect.bottom()) - bottom_edge;
+        float bottom = max(old_visual_rect.bottom(), new_visual_rect.bottom());
+        const_cast<Frame*>(frame)->set_needs_display(enclosing_int_rect(Gfx::FloatRect { new_visual_rect.x(), top, new_visual_rect.width(), bottom - top + 1 }));
+        return;
+    }
+
+    const_cast<Frame*>(frame)->set_needs_display(enclosing_int_rect(old_visual_rect));
+    const_cast<Frame*>(frame)->set_needs_display(enclosing_int_rect(new_visual_rect));
+}
+
 void LayoutBlock::layout(LayoutMode layout_mode)
 {
+    if (can_skip_layout(layout_mode)) {
+        // Nothing inside us changed and neither did our width, so neither did our size; but
+        // something before us may have, so we may still have to move.
+        auto old_position = rect().location();
+        compute_position();
+        auto offset = rect().location() - old_position;
+        if (!offset.is_null()) {
+            move_contents_by(offset);
+            auto new_visual_rect = visual_rect();
+            did_change_visual_rect(new_visual_rect.translated(-offset.x(), -offset.y()));
+        }
+        return;
+    }
+
+    auto old_visual_rect = visual_rect();
+
     compute_width();
 
     if (!is_inline())
@@ -63,6 +153,11 @@ void LayoutBlock::layout(LayoutMode layout_mode)
     layout_children(layout_mode);
 
     compute_height();
+
+    if (auto* containing_block = this->containing_block())
+        m_containing_block_width_at_last_layout = containing_block->width();
+
+    did_change_visual_rect(old_visual_rect);
 }
 
 void LayoutBlock::layout_children(LayoutMode layout_mode)
@@ -447,6 +542,8 @@ void LayoutBlock::render(RenderingContext& context)
     if (children_are_inline()) {
         for (auto& line_box : m_line_boxes) {
             for (auto& fragment : line_box.fragments()) {
+                if (!enclosing_int_rect(fragment.rect()).intersects(context.paint_rect()))
+                    continue;
                 if (context.should_show_line_box_borders())
                     context.painter().draw_rect(enclosing_int_rect(fragment.rect()), Color::Green);
                 fragment.render(context);
@@ -79,7 +79,16 @@ private:
     void compute_position();
     void compute_height();
 
+    bool can_skip_layout(LayoutMode) const;
+    void move_contents_by(const Gfx::FloatPoint&);
+
+    Gfx::FloatRect visual_rect() const;
+    void did_change_visual_rect(const Gfx::FloatRect& old_visual_rect);
+
     Vector<LineBox> m_line_boxes;
+
+    // The width of the containing block the last time we were laid out, since ours depends on it.
+    float m_containing_block_width_at_last_layout { -1 };
 };
 
 template<typename Callback>
@@ -189,6 +189,27 @@ void LayoutBox::paint_border(RenderingContext& context, Edge edge, const Gfx::Fl
     }
 }
 
+Gfx::FloatRect LayoutBox::padded_rect() const
+{
+    Gfx::FloatRect padded_rect;
+    padded_rect.set_x(x() - box_model().padding().left.to_px());
+    padded_rect.set_width(width() + box_model().padding().left.to_px() + box_model().padding().right.to_px());
+    padded_rect.set_y(y() - box_model().padding().top.to_px());
+    padded_rect.set_height(height() + box_model().padding().top.to_px() + box_model().padding().bottom.to_px());
+    return padded_rect;
+}
+
+Gfx::FloatRect LayoutBox::bordered_rect() const
+{
+    auto padded_rect = this->padded_rect();
+    Gfx::FloatRect bordered_rect;
+    bordered_rect.set_x(padded_rect.x() - box_model().border().left.to_px());
+    bordered_rect.set_width(padded_rect.width() + box_model().border().left.to_px() + box_model().border().right.to_px());
+    bordered_rect.set_y(padded_rect.y() - box_model().border().top.to_px());
+    bordered_rect.set_height(padded_rect.height() + box_model().border().top.to_px() + box_model().border().bottom.to_px());
+    return bordered_rect;
+}
+
 void LayoutBox::render(RenderingContext& context)
 {
     if (!is_visible())
@@ -202,37 +223,31 @@ void LayoutBox::render(RenderingContext& context)
         context.painter().draw_rect(m_rect, Color::Red);
 #endif
 
-    Gfx::FloatRect padded_rect;
-    padded_rect.set_x(x() - box_model().padding().left.to_px());
-    padded_rect.set_width(width() + box_model().padding().left.to_px() + box_model().padding().right.to_px());
-    padded_rect.set_y(y() - box_model().padding().top.to_px());
-    padded_rect.set_height(height() + box_model().padding().top.to_px() + box_model().padding().bottom.to_px());
+    auto padded_rect = this->padded_rect();
+    auto bordered_rect = this->bordered_rect();
 
-    if (!is_body()) {
-        auto bgcolor = style().property(CSS::PropertyID::BackgroundColor);
-        if (bgcolor.has_value() && bgcolor.value()->is_color()) {
-            context.painter().fill_rect(enclosing_int_rect(padded_rect), bgcolor.value()->to_color(document()));
-        }
+    // Our own background and borders stay inside the border box; our descendants may not.
+    if (enclosing_int_rect(bordered_rect).intersects(context.paint_rect())) {
+        if (!is_body()) {
+            auto bgcolor = style().property(CSS::PropertyID::BackgroundColor);
+            if (bgcolor.has_value() && bgcolor.value()->is_color()) {
+                context.painter().fill_rect(enclosing_int_rect(padded_rect), bgcolor.value()->to_color(document()));
+            }
 
-        auto bgimage = style().property(CSS::PropertyID::BackgroundImage);
-        if (bgimage.has_value() && bgimage.value()->is_image()) {
-            auto& image_value = static_cast<const ImageStyleValue&>(*bgimage.value());
-            if (image_value.bitmap()) {
-                context.painter().draw_tiled_bitmap(enclosing_int_rect(padded_rect), *image_value.bitmap());
+            auto bgimage = style().property(CSS::PropertyID::BackgroundImage);
+            if (bgimage.has_value() && bgimage.value()->is_image()) {
+                auto& image_value = static_cast<const ImageStyleValue&>(*bgimage.value());
+                if (image_value.bitmap()) {
+                    context.painter().draw_tiled_bitmap(enclosing_int_rect(padded_rect), *image_value.bitmap());
+                }
             }
         }
-    }
 
-    Gfx::FloatRect bordered_rect;
-    bordered_rect.set_x(padded_rect.x() - box_model().border().left.to_px());
-    bordered_rect.set_width(padded_rect.width() + box_model().border().left.to_px() + box_model().border().right.to_px());
-    bordered_rect.set_y(padded_rect.y() - box_model().border().top.to_px());
-    bordered_rect.set_height(padded_rect.height() + box_model().border().top.to_px() + box_model().border().bottom.to_px());
-
-    paint_border(context, Edge::Left, bordered_rect, CSS::PropertyID::BorderLeftStyle, CSS::PropertyID::BorderLeftColor, CSS::PropertyID::BorderLeftWidth);
-    paint_border(context, Edge::Right, bordered_rect, CSS::PropertyID::BorderRightStyle, CSS::PropertyID::BorderRightColor, CSS::PropertyID::BorderRightWidth);
-    paint_border(context, Edge::Top, bordered_rect, CSS::PropertyID::BorderTopStyle, CSS::PropertyID::BorderTopColor, CSS::PropertyID::BorderTopWidth);
-    paint_border(context, Edge::Bottom, bordered_rect, CSS::PropertyID::BorderBottomStyle, CSS::PropertyID::BorderBottomColor, CSS::PropertyID::BorderBottomWidth);
+        paint_border(context, Edge::Left, bordered_rect, CSS::PropertyID::BorderLeftStyle, CSS::PropertyID::BorderLeftColor, CSS::PropertyID::BorderLeftWidth);
+        paint_border(context, Edge::Right, bordered_rect, CSS::PropertyID::BorderRightStyle, CSS::PropertyID::BorderRightColor, CSS::PropertyID::BorderRightWidth);
+        paint_border(context, Edge::Top, bordered_rect, CSS::PropertyID::BorderTopStyle, CSS::PropertyID::BorderTopColor, CSS::PropertyID::BorderTopWidth);
+        paint_border(context, Edge::Bottom, bordered_rect, CSS::PropertyID::BorderBottomStyle, CSS::PropertyID::BorderBottomColor, CSS::PropertyID::BorderBottomWidth);
+    }
 
     LayoutNodeWithStyleAndBoxModelMetrics::render(context);
 
@@ -259,8 +274,14 @@ void LayoutBox::set_needs_display()
     auto* frame = document().frame();
     ASSERT(frame);
 
+    // The body's background is painted across the whole canvas.
+    if (is_body()) {
+        const_cast<Frame*>(frame)->set_needs_display(frame->viewport_rect());
+        return;
+    }
+
     if (!is_inline()) {
-        const_cast<Frame*>(frame)->set_needs_display(enclosing_int_rect(rect()));
+        const_cast<Frame*>(frame)->set_needs_display(enclosing_int_rect(bordered_rect()));
         return;
     }
 
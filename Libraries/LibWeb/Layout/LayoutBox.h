@@ -44,6 +44,9 @@ public:
     Gfx::FloatSize size() const { return rect().size(); }
     Gfx::FloatPoint position() const { return rect().location(); }
 
+    Gfx::FloatRect padded_rect() const;
+    Gfx::FloatRect bordered_rect() const;
+
     virtual HitTestResult hit_test(const Gfx::Point& position) const override;
     virtual void set_needs_display() override;
 
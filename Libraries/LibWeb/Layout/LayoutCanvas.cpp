@@ -56,7 +56,7 @@ void LayoutCanvas::render(RenderingContext& context)
     if (!context.viewport_rect().intersects(enclosing_int_rect(rect())))
         return;
 
-    if (node().bitmap())
+    if (should_paint_content())
         context.painter().draw_scaled_bitmap(enclosing_int_rect(rect()), *node().bitmap(), node().bitmap()->rect());
     LayoutReplaced::render(context);
 }
@@ -46,6 +46,9 @@ public:
 private:
     virtual const char* class_name() const override { return "LayoutCanvas"; }
     virtual bool is_canvas() const override { return true; }
+
+    virtual const Gfx::Bitmap* content_bitmap() const override { return node().bitmap(); }
+    virtual bool has_changing_content() const override { return true; }
 };
 
 template<>
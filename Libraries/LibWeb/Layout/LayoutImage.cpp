@@ -76,14 +76,22 @@ void LayoutImage::render(RenderingContext& context)
         if (alt.is_empty())
             alt = node().src();
         context.painter().draw_text(enclosing_int_rect(rect()), alt, Gfx::TextAlignment::Center, style().color_or_fallback(CSS::PropertyID::Color, document(), Color::Black), Gfx::TextElision::Right);
-    } else if (node().bitmap())
+    } else if (should_paint_content())
         context.painter().draw_scaled_bitmap(enclosing_int_rect(rect()), *node().bitmap(), node().bitmap()->rect());
     LayoutReplaced::render(context);
 }
 
+const Gfx::Bitmap* LayoutImage::content_bitmap() const
+{
+    if (renders_as_alt_text())
+        return nullptr;
+    return node().bitmap();
+}
+
+// Until the image has been decoded, its alt text stands in for it.
 bool LayoutImage::renders_as_alt_text() const
 {
-    return !node().image_decoder();
+    return node().natural_size().is_empty();
 }
 
 }
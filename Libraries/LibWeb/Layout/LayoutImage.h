@@ -48,6 +48,9 @@ public:
 private:
     virtual const char* class_name() const override { return "LayoutImage"; }
     virtual bool is_image() const override { return true; }
+
+    virtual const Gfx::Bitmap* content_bitmap() const override;
+    virtual bool has_changing_content() const override { return node().is_animated(); }
 };
 
 template<>
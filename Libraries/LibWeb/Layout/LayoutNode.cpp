@@ -53,6 +53,25 @@ void LayoutNode::layout(LayoutMode layout_mode)
     });
 }
 
+void LayoutNode::set_needs_layout()
+{
+    m_needs_layout = true;
+    for (auto* ancestor = parent(); ancestor && !ancestor->m_child_needs_layout; ancestor = ancestor->parent())
+        ancestor->m_child_needs_layout = true;
+}
+
+void LayoutNode::clear_needs_layout()
+{
+    m_needs_layout = false;
+    if (!m_child_needs_layout)
+        return;
+    m_child_needs_layout = false;
+    for_each_child([](auto& child) {
+        if (child.m_needs_layout || child.m_child_needs_layout)
+            child.clear_needs_layout();
+    });
+}
+
 const LayoutBlock* LayoutNode::containing_block() const
 {
     for (auto* ancestor = parent(); ancestor; ancestor = ancestor->parent()) {
@@ -127,6 +146,11 @@ void LayoutNode::set_needs_display()
     auto* frame = document().frame();
     ASSERT(frame);
 
+    // The line boxes may still point at layout nodes of removed DOM nodes. The whole tree will be
+    // rebuilt and repainted before anyone sees it anyway.
+    if (document().needs_layout_tree_rebuild())
+        return;
+
     if (auto* block = containing_block()) {
         block->for_each_fragment([&](auto& fragment) {
             if (&fragment.layout_node() == this || is_ancestor_of(fragment.layout_node())) {
@@ -108,6 +108,13 @@ public:
     virtual void layout(LayoutMode);
     virtual void render(RenderingContext&);
 
+    // Layout nodes start out needing layout. Marking one as needing it again also marks its
+    // ancestors as having a child that does, so that layout can skip the subtrees that don't.
+    bool needs_layout() const { return m_needs_layout; }
+    bool child_needs_layout() const { return m_child_needs_layout; }
+    void set_needs_layout();
+    void clear_needs_layout();
+
     const LayoutBlock* containing_block() const;
 
     virtual LayoutNode& inline_wrapper() { return *this; }
@@ -117,9 +124,9 @@ public:
     LayoutNodeWithStyle* parent();
     const LayoutNodeWithStyle* parent() const;
 
-    void inserted_into(LayoutNode&) { }
+    void inserted_into(LayoutNode&) { set_needs_layout(); }
     void removed_from(LayoutNode&) { }
-    void children_changed() { }
+    void children_changed() { set_needs_layout(); }
 
     virtual void split_into_lines(LayoutBlock& container, LayoutMode);
 
@@ -163,6 +170,8 @@ private:
     bool m_has_style { false };
     bool m_visible { true };
     bool m_children_are_inline { false };
+    bool m_needs_layout { true };
+    bool m_child_needs_layout { false };
 };
 
 class LayoutNodeWithStyle : public LayoutNode {
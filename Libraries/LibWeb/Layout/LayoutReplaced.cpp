@@ -24,7 +24,10 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <LibGUI/Painter.h>
+#include <LibWeb/DOM/Document.h>
 #include <LibWeb/DOM/Element.h>
+#include <LibWeb/Frame.h>
 #include <LibWeb/Layout/LayoutBlock.h>
 #include <LibWeb/Layout/LayoutReplaced.h>
 
@@ -51,4 +54,65 @@ void LayoutReplaced::split_into_lines(LayoutBlock& container, LayoutMode layout_
     line_box->add_fragment(*this, 0, 0, width(), height());
 }
 
+bool LayoutReplaced::is_composited() const
+{
+    if (!content_bitmap())
+        return false;
+    return has_changing_content() || style().opacity() < 1;
+}
+
+bool LayoutReplaced::should_paint_content()
+{
+    m_painted_as_layer = is_composited();
+    return !m_painted_as_layer && content_bitmap();
+}
+
+void LayoutReplaced::set_needs_display()
+{
+    // If the backing store was painted with the content in it (or with a hole for it), that has to be redone.
+    if (!m_painted_as_layer || !is_composited()) {
+        LayoutBox::set_needs_display();
+        return;
+    }
+
+    m_layer_needs_repaint = true;
+    auto* frame = document().frame();
+    ASSERT(frame);
+    const_cast<Frame*>(frame)->set_needs_composite(enclosing_int_rect(rect()));
+}
+
+void LayoutReplaced::composite(GUI::Painter& painter)
+{
+    auto* bitmap = content_bitmap();
+    if (!bitmap || !m_painted_as_layer || !is_visible())
+        return;
+
+    auto dst_rect = enclosing_int_rect(rect());
+    if (dst_rect.is_empty())
+        return;
+
+    float opacity = style().opacity();
+    if (dst_rect.size() == bitmap->size()) {
+        m_layer_bitmap = nullptr;
+        painter.blit(dst_rect.location(), *bitmap, bitmap->rect(), opacity);
+        return;
+    }
+
+    if (!m_layer_bitmap || m_layer_bitmap->size() != dst_rect.size()) {
+        m_layer_bitmap = Gfx::Bitmap::create(Gfx::BitmapFormat::RGBA32, dst_rect.size());
+        if (!m_layer_bitmap)
+            return;
+        m_layer_needs_repaint = true;
+    }
+
+    if (m_layer_needs_repaint) {
+        m_layer_bitmap->fill(Color::from_rgba(0));
+        GUI::Painter layer_painter(*m_layer_bitmap);
+        layer_painter.draw_scaled_bitmap(m_layer_bitmap->rect(), *bitmap, bitmap->rect());
+        m_layer_needs_repaint = false;
+    }
+
+    painter.blit(dst_rect.location(), *m_layer_bitmap, m_layer_bitmap->rect(), opacity);
+}
+
 }
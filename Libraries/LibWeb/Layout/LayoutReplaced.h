@@ -40,10 +40,31 @@ public:
 
     virtual bool is_replaced() const final { return true; }
 
+    virtual void set_needs_display() override;
+
+    // Content that changes on its own (canvas drawing, animated images) or that is drawn translucently
+    // gets a layer of its own, which PageView composites on top of its backing store. Updating the
+    // content then only recomposites the layer instead of repainting everything beneath it.
+    bool is_composited() const;
+    void composite(GUI::Painter&);
+
+protected:
+    // The bitmap that is shown, stretched to the box, if there is one.
+    virtual const Gfx::Bitmap* content_bitmap() const { return nullptr; }
+    virtual bool has_changing_content() const { return false; }
+
+    // Whether render() should paint the content bitmap, or leave that to composite().
+    bool should_paint_content();
+
 private:
     virtual const char* class_name() const override { return "LayoutReplaced"; }
 
     virtual void split_into_lines(LayoutBlock& container, LayoutMode) override;
+
+    // The content bitmap scaled to the size of the box, if it isn't that size already.
+    RefPtr<Gfx::Bitmap> m_layer_bitmap;
+    bool m_layer_needs_repaint { true };
+    bool m_painted_as_layer { false };
 };
 
 template<>
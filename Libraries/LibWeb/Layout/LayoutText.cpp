@@ -146,20 +146,19 @@ void LayoutText::for_each_chunk(Callback callback, LayoutMode layout_mode, bool
         commit_chunk(view.end(), false, true);
 }
 
-void LayoutText::split_into_lines_by_rules(LayoutBlock& container, LayoutMode layout_mode, bool do_collapse, bool do_wrap_lines, bool do_wrap_breaks)
+void LayoutText::measure_chunks(const Gfx::Font& font, LayoutMode layout_mode, bool do_collapse, bool do_wrap_lines, bool do_wrap_breaks)
 {
-    auto& font = style().font();
-    float space_width = font.glyph_width(' ') + font.glyph_spacing();
-
-    auto& line_boxes = container.line_boxes();
-    if (line_boxes.is_empty())
-        line_boxes.append(LineBox());
-    float available_width = container.width() - line_boxes.last().width();
+    auto& text = node().data();
+    if (m_chunk_measurements.has_value()) {
+        auto& measurements = m_chunk_measurements.value();
+        if (measurements.text.impl() == text.impl() && measurements.font == &font && measurements.layout_mode == layout_mode && measurements.do_collapse == do_collapse && measurements.do_wrap_lines == do_wrap_lines && measurements.do_wrap_breaks == do_wrap_breaks)
+            return;
+    }
 
     // Collapse whitespace into single spaces
     if (do_collapse) {
-        auto utf8_view = Utf8View(node().data());
-        StringBuilder builder(node().data().length());
+        auto utf8_view = Utf8View(text);
+        StringBuilder builder(text.length());
         for (auto it = utf8_view.begin(); it != utf8_view.end(); ++it) {
             if (!isspace(*it)) {
                 builder.append(utf8_view.as_string().characters_without_null_termination() + utf8_view.byte_offset_of(it), it.codepoint_length_in_bytes());
@@ -175,65 +174,108 @@ void LayoutText::split_into_lines_by_rules(LayoutBlock& container, LayoutMode la
         }
         m_text_for_rendering = builder.to_string();
     } else {
-        m_text_for_rendering = node().data();
+        m_text_for_rendering = text;
     }
 
+    float space_width = font.glyph_width(' ') + font.glyph_spacing();
+
     // do_wrap_lines  => chunks_are_words
     // !do_wrap_lines => chunks_are_lines
-    struct Chunk {
-        Utf8View view;
-        int start;
-        int length;
-        bool is_break;
-    };
-    Vector<Chunk> chunks;
-
+    Vector<MeasuredChunk> chunks;
     for_each_chunk(
         [&](const Utf8View& view, int start, int length, bool is_break) {
-            chunks.append({ Utf8View(view), start, length, is_break });
+            MeasuredChunk chunk { start, length, 0, is_break, false };
+            if (do_wrap_lines) {
+                chunk.is_collapsible_space = do_collapse && isspace(*view.begin());
+                if (chunk.is_collapsible_space)
+                    chunk.width = space_width;
+                else
+                    chunk.width = font.width(view) + font.glyph_spacing();
+            } else {
+                chunk.width = font.width(view);
+            }
+            chunks.append(chunk);
         },
         layout_mode, do_wrap_lines, do_wrap_breaks);
 
-    for (size_t i = 0; i < chunks.size(); ++i) {
-        auto& chunk = chunks[i];
+    m_chunk_measurements = ChunkMeasurements { text, const_cast<Gfx::Font*>(&font), layout_mode, do_collapse, do_wrap_lines, do_wrap_breaks, move(chunks) };
+    m_line_breaks = {};
+}
 
-        float chunk_width;
-        bool need_collapse = false;
-        if (do_wrap_lines) {
-            bool need_collapse = do_collapse && isspace(*chunk.view.begin());
+void LayoutText::compute_line_breaks(float container_width, float initial_line_width, bool initial_line_is_empty, bool do_wrap_lines, bool do_wrap_breaks)
+{
+    if (m_line_breaks.has_value()) {
+        auto& line_breaks = m_line_breaks.value();
+        if (line_breaks.container_width == container_width && line_breaks.initial_line_width == initial_line_width && line_breaks.initial_line_is_empty == initial_line_is_empty)
+            return;
+    }
 
-            if (need_collapse)
-                chunk_width = space_width;
-            else
-                chunk_width = font.width(chunk.view) + font.glyph_spacing();
+    Vector<LineBreakingStep> steps;
+    auto start_new_line = [&] {
+        steps.append({ LineBreakingStep::Type::NewLine, 0, 0, 0 });
+    };
 
-            if (line_boxes.last().width() > 0 && chunk_width > available_width) {
-                line_boxes.append(LineBox());
-                available_width = container.width();
+    // This mirrors what LineBox::add_fragment() will do with the fragments, which only counts whole pixels.
+    float available_width = container_width - initial_line_width;
+    int line_width = initial_line_width;
+    bool line_is_empty = initial_line_is_empty;
+
+    for (auto& chunk : m_chunk_measurements.value().chunks) {
+        if (do_wrap_lines) {
+            if (line_width > 0 && chunk.width > available_width) {
+                start_new_line();
+                available_width = container_width;
+                line_width = 0;
+                line_is_empty = true;
             }
-            if (need_collapse & line_boxes.last().fragments().is_empty())
+            if (chunk.is_collapsible_space && line_is_empty)
                 continue;
-        } else {
-            chunk_width = font.width(chunk.view);
         }
 
-        line_boxes.last().add_fragment(*this, chunk.start, need_collapse ? 1 : chunk.length, chunk_width, font.glyph_height());
-        available_width -= chunk_width;
+        steps.append({ LineBreakingStep::Type::Fragment, chunk.start, chunk.length, chunk.width });
+        available_width -= chunk.width;
+        line_width += (int)chunk.width;
+        line_is_empty = false;
 
         if (do_wrap_lines) {
             if (available_width < 0) {
-                line_boxes.append(LineBox());
-                available_width = container.width();
+                start_new_line();
+                available_width = container_width;
+                line_width = 0;
+                line_is_empty = true;
             }
         }
 
         if (do_wrap_breaks) {
             if (chunk.is_break) {
-                line_boxes.append(LineBox());
-                available_width = container.width();
+                start_new_line();
+                available_width = container_width;
+                line_width = 0;
+                line_is_empty = true;
             }
         }
     }
+
+    m_line_breaks = LineBreaks { container_width, initial_line_width, initial_line_is_empty, move(steps) };
+}
+
+void LayoutText::split_into_lines_by_rules(LayoutBlock& container, LayoutMode layout_mode, bool do_collapse, bool do_wrap_lines, bool do_wrap_breaks)
+{
+    auto& font = style().font();
+
+    auto& line_boxes = container.line_boxes();
+    if (line_boxes.is_empty())
+        line_boxes.append(LineBox());
+
+    measure_chunks(font, layout_mode, do_collapse, do_wrap_lines, do_wrap_breaks);
+    compute_line_breaks(container.width(), line_boxes.last().width(), line_boxes.last().fragments().is_empty(), do_wrap_lines, do_wrap_breaks);
+
+    for (auto& step : m_line_breaks.value().steps) {
+        if (step.type == LineBreakingStep::Type::NewLine)
+            line_boxes.append(LineBox());
+        else
+            line_boxes.last().add_fragment(*this, step.start, step.length, step.width, font.glyph_height());
+    }
 }
 
 void LayoutText::split_into_lines(LayoutBlock& container, LayoutMode layout_mode)
@@ -26,6 +26,8 @@
 
 #pragma once
 
+#include <AK/Optional.h>
+#include <LibGfx/Forward.h>
 #include <LibWeb/DOM/Text.h>
 #include <LibWeb/Layout/LayoutNode.h>
 
@@ -54,11 +56,53 @@ public:
 
 private:
     void split_into_lines_by_rules(LayoutBlock& container, LayoutMode, bool do_collapse, bool do_wrap_lines, bool do_wrap_breaks);
+    void measure_chunks(const Gfx::Font&, LayoutMode, bool do_collapse, bool do_wrap_lines, bool do_wrap_breaks);
+    void compute_line_breaks(float container_width, float initial_line_width, bool initial_line_is_empty, bool do_wrap_lines, bool do_wrap_breaks);
 
     template<typename Callback>
     void for_each_chunk(Callback, LayoutMode, bool do_wrap_lines, bool do_wrap_breaks) const;
 
     String m_text_for_rendering;
+
+    // Splitting the text into chunks (words, or lines) and measuring them only depends on the text,
+    // the font and the white-space rules, so that's kept until one of those changes.
+    struct MeasuredChunk {
+        int start;
+        int length;
+        float width;
+        bool is_break;
+        bool is_collapsible_space;
+    };
+    struct ChunkMeasurements {
+        String text;
+        RefPtr<Gfx::Font> font;
+        LayoutMode layout_mode;
+        bool do_collapse;
+        bool do_wrap_lines;
+        bool do_wrap_breaks;
+        Vector<MeasuredChunk> chunks;
+    };
+    Optional<ChunkMeasurements> m_chunk_measurements;
+
+    // Where the chunks broke into lines, which is kept as long as the containing block stays as wide
+    // and this text starts at the same place on its first line.
+    struct LineBreakingStep {
+        enum class Type {
+            Fragment,
+            NewLine,
+        };
+        Type type;
+        int start;
+        int length;
+        float width;
+    };
+    struct LineBreaks {
+        float container_width;
+        float initial_line_width;
+        bool initial_line_is_empty;
+        Vector<LineBreakingStep> steps;
+    };
+    Optional<LineBreaks> m_line_breaks;
 };
 
 template<>
@@ -47,11 +47,13 @@
 #include <LibWeb/PageView.h>
 #include <LibWeb/Layout/LayoutDocument.h>
 #include <LibWeb/Layout/LayoutNode.h>
+#include <LibWeb/Layout/LayoutReplaced.h>
 #include <LibWeb/Parser/HTMLDocumentParser.h>
 #include <LibWeb/Parser/HTMLParser.h>
 #include <LibWeb/RenderingContext.h>
 #include <LibWeb/ResourceLoader.h>
 #include <stdio.h>
+#include <string.h>
 
 //#define SELECTION_DEBUG
 
@@ -62,9 +64,16 @@ PageView::PageView()
 {
     main_frame().on_set_needs_display = [this](auto& content_rect) {
         if (content_rect.is_empty()) {
+            damage_viewport();
             update();
             return;
         }
+        damage(content_rect);
+        Gfx::Rect adjusted_rect = content_rect;
+        adjusted_rect.set_location(to_widget_position(content_rect.location()));
+        update(adjusted_rect);
+    };
+    main_frame().on_set_needs_composite = [this](auto& content_rect) {
         Gfx::Rect adjusted_rect = content_rect;
         adjusted_rect.set_location(to_widget_position(content_rect.location()));
         update(adjusted_rect);
@@ -85,6 +94,9 @@ void PageView::set_document(Document* new_document)
     if (new_document == old_document)
         return;
 
+    if (m_parser && new_document != &m_parser->document())
+        m_parser = nullptr;
+
     if (old_document)
         old_document->on_layout_updated = nullptr;
 
@@ -94,9 +106,9 @@ void PageView::set_document(Document* new_document)
         on_set_document(new_document);
 
     if (new_document) {
+        // Layout damages what it changes as it goes, so there's no need to repaint everything.
         new_document->on_layout_updated = [this] {
             layout_and_sync_size();
-            update();
         };
     }
 
@@ -108,9 +120,16 @@ void PageView::set_document(Document* new_document)
 #endif
 
     layout_and_sync_size();
+    damage_viewport();
     update();
 }
 
+void PageView::set_should_show_line_box_borders(bool value)
+{
+    m_should_show_line_box_borders = value;
+    damage_viewport();
+}
+
 void PageView::layout_and_sync_size()
 {
     if (!document())
@@ -145,10 +164,104 @@ void PageView::resize_event(GUI::ResizeEvent& event)
     layout_and_sync_size();
 }
 
+void PageView::damage(const Gfx::Rect& content_rect)
+{
+    // Past a certain point, keeping track of the individual rects costs more than it saves.
+    static constexpr size_t max_damage_rects = 32;
+    if (m_backing_store_damage.size() >= max_damage_rects) {
+        damage_viewport();
+        return;
+    }
+    m_backing_store_damage.add(content_rect);
+}
+
+void PageView::damage_viewport()
+{
+    m_backing_store_damage.clear();
+    m_backing_store_damage.add(viewport_rect_in_content_coordinates());
+}
+
+// Moves the contents of the bitmap by delta, leaving the pixels that nothing moved into as they were.
+static void shift_bitmap_contents(Gfx::Bitmap& bitmap, const Gfx::Point& delta)
+{
+    int row_length = bitmap.width() - abs(delta.x());
+    int dst_x = max(delta.x(), 0);
+    int src_x = max(-delta.x(), 0);
+    auto shift_row = [&](int dst_y) {
+        int src_y = dst_y - delta.y();
+        memmove(bitmap.scanline(dst_y) + dst_x, bitmap.scanline(src_y) + src_x, row_length * sizeof(Gfx::RGBA32));
+    };
+    // Go against the direction of movement so that we never read a row we've already overwritten.
+    if (delta.y() > 0) {
+        for (int y = bitmap.height() - 1; y >= delta.y(); --y)
+            shift_row(y);
+    } else {
+        for (int y = 0; y < bitmap.height() + delta.y(); ++y)
+            shift_row(y);
+    }
+}
+
+void PageView::update_backing_store()
+{
+    auto viewport_rect = viewport_rect_in_content_coordinates();
+    if (viewport_rect.is_empty()) {
+        m_backing_store = nullptr;
+        return;
+    }
+
+    if (!m_backing_store || m_backing_store->size() != viewport_rect.size()) {
+        m_backing_store = Gfx::Bitmap::create(Gfx::BitmapFormat::RGB32, viewport_rect.size());
+        damage_viewport();
+    } else if (m_backing_store_content_rect != viewport_rect) {
+        if (m_backing_store_content_rect.intersects(viewport_rect)) {
+            shift_bitmap_contents(*m_backing_store, m_backing_store_content_rect.location() - viewport_rect.location());
+            for (auto& exposed_rect : viewport_rect.shatter(m_backing_store_content_rect))
+                m_backing_store_damage.add(exposed_rect);
+        } else {
+            damage_viewport();
+        }
+    }
+    m_backing_store_content_rect = viewport_rect;
+
+    if (m_backing_store_damage.is_empty())
+        return;
+
+    PerformanceTimeline::Measurement measurement(document()->performance_timeline(), PerformanceTimeline::Category::Paint, "Paint");
+    GUI::Painter painter(*m_backing_store);
+    painter.translate(-viewport_rect.x(), -viewport_rect.y());
+    for (auto& damage_rect : m_backing_store_damage.rects()) {
+        auto paint_rect = damage_rect.intersected(viewport_rect);
+        if (paint_rect.is_empty())
+            continue;
+        Gfx::PainterStateSaver saver(painter);
+        painter.add_clip_rect(paint_rect.translated(-viewport_rect.x(), -viewport_rect.y()));
+        paint_content(painter, paint_rect);
+    }
+    m_backing_store_damage.clear();
+}
+
+void PageView::paint_content(GUI::Painter& painter, const Gfx::Rect& content_rect)
+{
+    painter.fill_rect(content_rect, document()->background_color(palette()));
+
+    if (auto background_bitmap = document()->background_image()) {
+        painter.draw_tiled_bitmap(content_rect, *background_bitmap);
+    }
+
+    RenderingContext context(painter, palette());
+    context.set_should_show_line_box_borders(m_should_show_line_box_borders);
+    context.set_viewport_rect(viewport_rect_in_content_coordinates());
+    context.set_paint_rect(content_rect);
+    layout_root()->render(context);
+}
+
 void PageView::paint_event(GUI::PaintEvent& event)
 {
     GUI::Frame::paint_event(event);
 
+    if (document())
+        document()->update_style_and_layout_if_needed();
+
     GUI::Painter painter(*this);
     painter.add_clip_rect(widget_inner_rect());
     painter.add_clip_rect(event.rect());
@@ -158,23 +271,29 @@ void PageView::paint_event(GUI::PaintEvent& event)
         return;
     }
 
-    painter.fill_rect(event.rect(), document()->background_color(palette()));
+    update_backing_store();
+    if (m_backing_store)
+        painter.blit(widget_inner_rect().location(), *m_backing_store, m_backing_store->rect());
 
-    if (auto background_bitmap = document()->background_image()) {
-        painter.draw_tiled_bitmap(event.rect(), *background_bitmap);
-    }
-
-    painter.translate(frame_thickness(), frame_thickness());
-    painter.translate(-horizontal_scrollbar().value(), -vertical_scrollbar().value());
+    composite_layers(painter);
+}
 
-    RenderingContext context(painter, palette());
-    context.set_should_show_line_box_borders(m_should_show_line_box_borders);
-    context.set_viewport_rect(viewport_rect_in_content_coordinates());
-    layout_root()->render(context);
+void PageView::composite_layers(GUI::Painter& painter)
+{
+    auto viewport_rect = viewport_rect_in_content_coordinates();
+    Gfx::PainterStateSaver saver(painter);
+    painter.translate(frame_thickness() - horizontal_scrollbar().value(), frame_thickness() - vertical_scrollbar().value());
+    layout_root()->for_each_in_subtree_of_type<LayoutReplaced>([&](auto& replaced) {
+        if (viewport_rect.intersects(enclosing_int_rect(replaced.rect())))
+            replaced.composite(painter);
+        return IterationDecision::Continue;
+    });
 }
 
 void PageView::mousemove_event(GUI::MouseEvent& event)
 {
+    if (document())
+        document()->update_style_and_layout_if_needed();
     if (!layout_root())
         return GUI::ScrollableWidget::mousemove_event(event);
 
@@ -201,13 +320,13 @@ void PageView::mousemove_event(GUI::MouseEvent& event)
         if (m_in_mouse_selection) {
             layout_root()->selection().set_end({ result.layout_node, result.index_in_node });
             dump_selection("MouseMove");
+            damage_viewport();
             update();
         }
     }
     if (window())
         window()->set_override_cursor(is_hovering_link ? GUI::StandardCursor::Hand : GUI::StandardCursor::None);
     if (hovered_node_changed) {
-        update();
         RefPtr<HTMLElement> hovered_html_element = document()->hovered_node() ? document()->hovered_node()->enclosing_html_element() : nullptr;
         if (hovered_html_element && !hovered_html_element->title().is_null()) {
             auto screen_position = screen_relative_rect().location().translated(event.position());
@@ -226,14 +345,14 @@ void PageView::mousemove_event(GUI::MouseEvent& event)
 
 void PageView::mousedown_event(GUI::MouseEvent& event)
 {
+    if (document())
+        document()->update_style_and_layout_if_needed();
     if (!layout_root())
         return GUI::ScrollableWidget::mousemove_event(event);
 
-    bool hovered_node_changed = false;
     auto result = layout_root()->hit_test(to_content_position(event.position()));
     if (result.layout_node) {
         RefPtr<Node> node = result.layout_node->node();
-        hovered_node_changed = node != document()->hovered_node();
         document()->set_hovered_node(node);
         if (node) {
             auto offset = compute_mouse_event_offset(event.position(), *result.layout_node);
@@ -261,17 +380,19 @@ void PageView::mousedown_event(GUI::MouseEvent& event)
                         layout_root()->selection().set({ result.layout_node, result.index_in_node }, {});
                     dump_selection("MouseDown");
                     m_in_mouse_selection = true;
+                    damage_viewport();
+                    update();
                 }
             }
         }
     }
-    if (hovered_node_changed)
-        update();
     event.accept();
 }
 
 void PageView::mouseup_event(GUI::MouseEvent& event)
 {
+    if (document())
+        document()->update_style_and_layout_if_needed();
     if (!layout_root())
         return GUI::ScrollableWidget::mouseup_event(event);
 
@@ -453,10 +574,63 @@ RefPtr<Document> PageView::create_document_from_mime_type(const ByteBuffer& data
     return nullptr;
 }
 
+// How long to parse for before showing what we have and letting the event loop run.
+static constexpr int parse_time_slice_in_ms = 50;
+
+void PageView::continue_parsing(const URL& url)
+{
+    bool finished = m_parser->parse_available_input(parse_time_slice_in_ms);
+
+    // The parser doesn't build layout nodes for what it inserts, so start over with the layout tree.
+    document()->invalidate_layout();
+    layout_and_sync_size();
+    damage_viewport();
+    update();
+
+    if (finished) {
+        m_parser = nullptr;
+        did_load_document(url);
+        return;
+    }
+
+    // More of the document arriving gets us going again.
+    if (m_parser->is_waiting_for_input())
+        return;
+
+    deferred_invoke([this, url, parser = m_parser.ptr()](auto&) {
+        // Another document may have been loaded in the meantime.
+        if (m_parser.ptr() != parser)
+            return;
+        continue_parsing(url);
+    });
+}
+
+void PageView::record_navigation_timing(Document& document, double navigation_start, double response_end)
+{
+    auto& timeline = document.performance_timeline();
+    timeline.set_navigation_start(navigation_start);
+    timeline.set_milestone(PerformanceTimeline::Milestone::FetchStart, navigation_start);
+    timeline.set_milestone(PerformanceTimeline::Milestone::ResponseEnd, response_end);
+    timeline.add_entry(PerformanceTimeline::Category::Network, document.url().to_string(), navigation_start, response_end);
+}
+
+void PageView::did_load_document(const URL& url)
+{
+    if (!url.fragment().is_empty())
+        scroll_to_anchor(url.fragment());
+
+    if (on_title_change)
+        on_title_change(document()->title());
+}
+
 void PageView::load(const URL& url)
 {
     dbg() << "PageView::load: " << url;
 
+    // Stop loading and parsing whatever we were loading before.
+    m_pending_load = nullptr;
+    m_parser = nullptr;
+
     if (!url.is_valid()) {
         load_error_page(url, "Invalid URL");
         return;
@@ -468,9 +642,15 @@ void PageView::load(const URL& url)
     if (on_load_start)
         on_load_start(url);
 
-    ResourceLoader::the().load(
+    auto navigation_start = PerformanceTimeline::monotonic_now();
+    auto pending_load = adopt(*new PendingLoad);
+    m_pending_load = pending_load;
+    ResourceLoader::the().load_incrementally(
         url,
-        [this, url](auto data, auto& response_headers) {
+        [this, url, pending_load](auto& response_headers) {
+            if (m_pending_load.ptr() != pending_load.ptr())
+                return;
+
             // FIXME: Also check HTTP status code before redirecting
             auto location = response_headers.get("Location");
             if (location.has_value()) {
@@ -478,36 +658,71 @@ void PageView::load(const URL& url)
                 return;
             }
 
-            if (data.is_null()) {
-                load_error_page(url, "No data");
-                return;
-            }
-
-            String encoding = "utf-8";
-            String mime_type;
-
             auto content_type = response_headers.get("Content-Type");
             if (content_type.has_value()) {
                 dbg() << "Content-Type header: _" << content_type.value() << "_";
-                encoding = encoding_from_content_type(content_type.value());
-                mime_type = mime_type_from_content_type(content_type.value());
+                m_pending_load->encoding = encoding_from_content_type(content_type.value());
+                m_pending_load->mime_type = mime_type_from_content_type(content_type.value());
             } else {
                 dbg() << "No Content-Type header to go on! Guessing based on filename...";
-                mime_type = guess_mime_type_based_on_filename(url);
+                m_pending_load->mime_type = guess_mime_type_based_on_filename(url);
             }
 
-            dbg() << "I believe this content has MIME type '" << mime_type << "', encoding '" << encoding << "'";
-            auto document = create_document_from_mime_type(data, url, mime_type, encoding);
-            ASSERT(document);
-            set_document(document);
+            dbg() << "I believe this content has MIME type '" << m_pending_load->mime_type << "', encoding '" << m_pending_load->encoding << "'";
+            if (m_pending_load->mime_type == "text/html" && m_use_new_parser) {
+                // Show the document as it comes in.
+                m_pending_load->is_parsed_incrementally = true;
+                m_parser = make<HTMLDocumentParser>(m_pending_load->encoding);
+                m_parser->begin(url);
+                set_document(&m_parser->document());
+                continue_parsing(url);
+            }
+        },
+        [this, url, pending_load](auto& data) {
+            if (m_pending_load.ptr() != pending_load.ptr())
+                return;
+            if (!m_pending_load->is_parsed_incrementally) {
+                m_pending_load->data.append(data.data(), data.size());
+                return;
+            }
+            if (!m_parser)
+                return;
+            m_parser->append_input(data);
+            // Otherwise the parser is still busy with what it had, and gets to this next.
+            if (m_parser->is_waiting_for_input())
+                continue_parsing(url);
+        },
+        [this, url, navigation_start, pending_load] {
+            if (m_pending_load.ptr() != pending_load.ptr())
+                return;
+            m_pending_load = nullptr;
+            auto response_end = PerformanceTimeline::monotonic_now();
 
-            if (!url.fragment().is_empty())
-                scroll_to_anchor(url.fragment());
+            if (pending_load->is_parsed_incrementally) {
+                if (!m_parser)
+                    return;
+                record_navigation_timing(m_parser->document(), navigation_start, response_end);
+                m_parser->close_input();
+                if (m_parser->is_waiting_for_input())
+                    continue_parsing(url);
+                return;
+            }
 
-            if (on_title_change)
-                on_title_change(document->title());
+            if (pending_load->data.is_null()) {
+                load_error_page(url, "No data");
+                return;
+            }
+
+            auto document = create_document_from_mime_type(pending_load->data, url, pending_load->mime_type, pending_load->encoding);
+            ASSERT(document);
+            record_navigation_timing(*document, navigation_start, response_end);
+            set_document(document);
+            did_load_document(url);
         },
-        [this, url](auto error) {
+        [this, url, pending_load](auto error) {
+            if (m_pending_load.ptr() != pending_load.ptr())
+                return;
+            m_pending_load = nullptr;
             load_error_page(url, error);
         });
 
@@ -592,6 +807,7 @@ void PageView::scroll_to_anchor(const StringView& name)
         dbg() << "PageView::scroll_to_anchor(): Anchor not found: '" << name << "'";
         return;
     }
+    document()->update_style_and_layout_if_needed();
     if (!element->layout_node()) {
         dbg() << "PageView::scroll_to_anchor(): Anchor found but without layout node: '" << name << "'";
         return;
@@ -26,13 +26,16 @@
 
 #pragma once
 
+#include <AK/ByteBuffer.h>
 #include <AK/URL.h>
 #include <LibGUI/ScrollableWidget.h>
+#include <LibGfx/DisjointRectSet.h>
 #include <LibWeb/DOM/Document.h>
 
 namespace Web {
 
 class Frame;
+class HTMLDocumentParser;
 
 class PageView : public GUI::ScrollableWidget {
     C_OBJECT(PageView)
@@ -59,7 +62,7 @@ public:
 
     URL url() const;
 
-    void set_should_show_line_box_borders(bool value) { m_should_show_line_box_borders = value; }
+    void set_should_show_line_box_borders(bool);
 
     Function<void(const String& href, const String& target, unsigned modifiers)> on_link_click;
     Function<void(const String& href, const Gfx::Point& screen_position)> on_link_context_menu_request;
@@ -88,14 +91,42 @@ private:
     virtual void did_scroll() override;
 
     RefPtr<Document> create_document_from_mime_type(const ByteBuffer& data, const URL& url, const String& mime_type, const String& encoding);
+    void record_navigation_timing(Document&, double navigation_start, double response_end);
+    void continue_parsing(const URL&);
+    void did_load_document(const URL&);
 
     void run_javascript_url(const String& url);
     void layout_and_sync_size();
+    void damage(const Gfx::Rect& content_rect);
+    void damage_viewport();
+    void update_backing_store();
+    void composite_layers(GUI::Painter&);
+    void paint_content(GUI::Painter&, const Gfx::Rect& content_rect);
     void dump_selection(const char* event_name);
     Gfx::Point compute_mouse_event_offset(const Gfx::Point&, const LayoutNode&) const;
 
     RefPtr<Web::Frame> m_main_frame;
 
+    // What has arrived of the response to the load() in progress, and what we made of its headers.
+    struct PendingLoad : public RefCounted<PendingLoad> {
+        String mime_type;
+        String encoding { "utf-8" };
+        // If so, the data goes straight into m_parser instead.
+        bool is_parsed_incrementally { false };
+        ByteBuffer data;
+    };
+    RefPtr<PendingLoad> m_pending_load;
+
+    // The parser of a document that we're showing while it's still being parsed.
+    OwnPtr<HTMLDocumentParser> m_parser;
+
+    // What the viewport showed when we last painted, so that scrolling only has to move the
+    // pixels along and paint the newly exposed strip, and so that a repaint only has to paint
+    // the parts of the document that changed.
+    RefPtr<Gfx::Bitmap> m_backing_store;
+    Gfx::Rect m_backing_store_content_rect;
+    Gfx::DisjointRectSet m_backing_store_damage;
+
     bool m_should_show_line_box_borders { false };
     bool m_in_mouse_selection { false };
 
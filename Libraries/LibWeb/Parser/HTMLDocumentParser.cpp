@@ -27,6 +27,7 @@
 #define PARSER_DEBUG
 
 #include <AK/Utf32View.h>
+#include <LibCore/ElapsedTimer.h>
 #include <LibWeb/DOM/Comment.h>
 #include <LibWeb/DOM/Document.h>
 #include <LibWeb/DOM/DocumentType.h>
@@ -37,6 +38,7 @@
 #include <LibWeb/DOM/HTMLScriptElement.h>
 #include <LibWeb/DOM/Text.h>
 #include <LibWeb/Parser/HTMLDocumentParser.h>
+#include <LibWeb/Parser/HTMLPreloadScanner.h>
 #include <LibWeb/Parser/HTMLToken.h>
 
 #define PARSE_ERROR()                                                         \
@@ -51,22 +53,83 @@ HTMLDocumentParser::HTMLDocumentParser(const StringView& input, const String& en
 {
 }
 
+HTMLDocumentParser::HTMLDocumentParser(const String& encoding)
+    : m_tokenizer(encoding)
+{
+}
+
 HTMLDocumentParser::~HTMLDocumentParser()
 {
 }
 
 void HTMLDocumentParser::run(const URL& url)
+{
+    begin(url);
+    parse_available_input();
+}
+
+void HTMLDocumentParser::begin(const URL& url)
 {
     m_document = adopt(*new Document);
     m_document->set_url(url);
-    m_document->set_source(m_tokenizer.source());
+    m_document->performance_timeline().set_milestone(PerformanceTimeline::Milestone::DOMLoading);
+
+    m_preload_scanner = make<HTMLPreloadScanner>(url);
+    m_preload_scanner->append_input(m_tokenizer.decoded_input());
+    if (m_tokenizer.is_input_closed())
+        m_preload_scanner->close_input();
+}
+
+void HTMLDocumentParser::append_input(const StringView& input)
+{
+    size_t decoded_length_before = m_tokenizer.decoded_input().length();
+    m_tokenizer.append_input(input);
+    if (m_preload_scanner) {
+        auto decoded_input = m_tokenizer.decoded_input();
+        m_preload_scanner->append_input(decoded_input.substring_view(decoded_length_before, decoded_input.length() - decoded_length_before));
+    }
+}
+
+void HTMLDocumentParser::close_input()
+{
+    m_tokenizer.close_input();
+    if (m_preload_scanner)
+        m_preload_scanner->close_input();
+}
+
+// How long the preload scanner may take out of each time slice the parser gets.
+static constexpr int preload_scan_time_budget_in_ms = 10;
+
+bool HTMLDocumentParser::parse_available_input(int time_budget_in_ms)
+{
+    ASSERT(m_document);
+    if (m_finished)
+        return true;
 
-    for (;;) {
+    Core::ElapsedTimer timer;
+    timer.start();
+
+    PerformanceTimeline::Measurement measurement(m_document->performance_timeline(), PerformanceTimeline::Category::Parse, "Parse HTML");
+
+    // Give the preload scanner a head start, so that it stays ahead of us.
+    if (m_preload_scanner && m_preload_scanner->scan(time_budget_in_ms >= 0 ? preload_scan_time_budget_in_ms : -1))
+        m_preload_scanner = nullptr;
+
+    for (size_t tokens_processed = 1;; ++tokens_processed) {
         auto optional_token = m_tokenizer.next_token();
-        if (!optional_token.has_value())
+        if (!optional_token.has_value()) {
+            if (m_tokenizer.is_waiting_for_input())
+                return false;
             break;
+        }
         auto& token = optional_token.value();
 
+        if (m_next_line_feed_can_be_ignored) {
+            m_next_line_feed_can_be_ignored = false;
+            if (token.is_character() && token.codepoint() == '\n')
+                continue;
+        }
+
 #ifdef PARSER_DEBUG
         dbg() << "[" << insertion_mode_name() << "] " << token.to_string();
 #endif
@@ -76,21 +139,40 @@ void HTMLDocumentParser::run(const URL& url)
             dbg() << "Stop parsing! :^)";
             break;
         }
+
+        // Checking the time is not free, so only do it every so often.
+        if (time_budget_in_ms >= 0 && !(tokens_processed % 256) && timer.elapsed() >= time_budget_in_ms)
+            return false;
     }
 
+    finish();
+    return true;
+}
+
+void HTMLDocumentParser::finish()
+{
+    m_finished = true;
+    m_document->set_source(m_tokenizer.source());
+
     // "The end"
+    auto& timeline = m_document->performance_timeline();
+    timeline.set_milestone(PerformanceTimeline::Milestone::DOMInteractive);
 
     auto scripts_to_execute_when_parsing_has_finished = m_document->take_scripts_to_execute_when_parsing_has_finished({});
     for (auto& script : scripts_to_execute_when_parsing_has_finished) {
         script.execute_script();
     }
 
+    timeline.set_milestone(PerformanceTimeline::Milestone::DOMContentLoadedEventStart);
     m_document->dispatch_event(Event::create("DOMContentLoaded"));
+    timeline.set_milestone(PerformanceTimeline::Milestone::DOMContentLoadedEventEnd);
 
     auto scripts_to_execute_as_soon_as_possible = m_document->take_scripts_to_execute_as_soon_as_possible({});
     for (auto& script : scripts_to_execute_as_soon_as_possible) {
         script.execute_script();
     }
+
+    timeline.set_milestone(PerformanceTimeline::Milestone::DOMComplete);
 }
 
 void HTMLDocumentParser::process_using_the_rules_for(InsertionMode mode, HTMLToken& token)
@@ -885,12 +967,7 @@ void HTMLDocumentParser::handle_in_body(HTMLToken& token)
         // If the next token is a U+000A LINE FEED (LF) character token,
         // then ignore that token and move on to the next one.
         // (Newlines at the start of pre blocks are ignored as an authoring convenience.)
-        auto next_token = m_tokenizer.next_token();
-        if (next_token.has_value() && next_token.value().is_character() && next_token.value().codepoint() == '\n') {
-            // Ignore it.
-        } else {
-            process_using_the_rules_for(m_insertion_mode, next_token.value());
-        }
+        m_next_line_feed_can_be_ignored = true;
         return;
     }
 
@@ -1190,18 +1267,12 @@ void HTMLDocumentParser::handle_in_body(HTMLToken& token)
         // If the next token is a U+000A LINE FEED (LF) character token,
         // then ignore that token and move on to the next one.
         // (Newlines at the start of pre blocks are ignored as an authoring convenience.)
-        auto next_token = m_tokenizer.next_token();
+        m_next_line_feed_can_be_ignored = true;
 
         m_tokenizer.switch_to({}, HTMLTokenizer::State::RCDATA);
         m_original_insertion_mode = m_insertion_mode;
         m_frameset_ok = false;
         m_insertion_mode = InsertionMode::Text;
-
-        if (next_token.has_value() && next_token.value().is_character() && next_token.value().codepoint() == '\n') {
-            // Ignore it.
-        } else {
-            process_using_the_rules_for(m_insertion_mode, next_token.value());
-        }
         return;
     }
 
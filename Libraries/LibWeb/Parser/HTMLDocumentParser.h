@@ -62,10 +62,27 @@ namespace Web {
 class HTMLDocumentParser {
 public:
     HTMLDocumentParser(const StringView& input, const String& encoding);
+    explicit HTMLDocumentParser(const String& encoding);
     ~HTMLDocumentParser();
 
     void run(const URL&);
 
+    // Parsing a document as it arrives: begin(), then append_input() and parse_available_input()
+    // as data comes in, and finally close_input() and parse_available_input() until it's done.
+    void begin(const URL&);
+    void append_input(const StringView& input);
+    void close_input();
+
+    // Parses the input that has arrived so far, stopping after roughly the given number of
+    // milliseconds (if any) so that the caller can get back to its event loop.
+    // Returns true once the whole document has been parsed.
+    bool parse_available_input(int time_budget_in_ms = -1);
+    bool has_finished() const { return m_finished; }
+
+    // Whether parse_available_input() stopped because it got through all the input there is so far,
+    // rather than because it ran out of time.
+    bool is_waiting_for_input() const { return m_tokenizer.is_waiting_for_input(); }
+
     Document& document();
 
     enum class InsertionMode {
@@ -100,6 +117,7 @@ private:
     void handle_in_select(HTMLToken&);
 
     void stop_parsing() { m_stop_parsing = true; }
+    void finish();
 
     void generate_implied_end_tags(const FlyString& exception = {});
     bool stack_of_open_elements_has_element_with_tag_name_in_scope(const FlyString& tag_name);
@@ -137,6 +155,7 @@ private:
     ListOfActiveFormattingElements m_list_of_active_formatting_elements;
 
     HTMLTokenizer m_tokenizer;
+    OwnPtr<HTMLPreloadScanner> m_preload_scanner;
 
     bool m_foster_parenting { false };
     bool m_frameset_ok { true };
@@ -146,6 +165,8 @@ private:
     bool m_aborted { false };
     bool m_parser_pause_flag { false };
     bool m_stop_parsing { false };
+    bool m_finished { false };
+    bool m_next_line_feed_can_be_ignored { false };
     size_t m_script_nesting_level { 0 };
 
     RefPtr<Document> m_document;
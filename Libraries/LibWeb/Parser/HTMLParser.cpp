@@ -495,7 +495,12 @@ RefPtr<Document> parse_html_document(const StringView& raw_html, const URL& url,
     fire_insertion_callbacks(document);
 #endif
 
+    auto& timeline = document->performance_timeline();
+    timeline.set_milestone(PerformanceTimeline::Milestone::DOMInteractive);
+    timeline.set_milestone(PerformanceTimeline::Milestone::DOMContentLoadedEventStart);
     document->dispatch_event(Event::create("DOMContentLoaded"));
+    timeline.set_milestone(PerformanceTimeline::Milestone::DOMContentLoadedEventEnd);
+    timeline.set_milestone(PerformanceTimeline::Milestone::DOMComplete);
 
     return document;
 }
@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <LibCore/ElapsedTimer.h>
+#include <LibWeb/Parser/HTMLPreloadScanner.h>
+#include <LibWeb/ResourceLoader.h>
+
+namespace Web {
+
+HTMLPreloadScanner::HTMLPreloadScanner(const URL& document_url)
+    : m_tokenizer("utf-8")
+    , m_base_url(document_url)
+{
+}
+
+bool HTMLPreloadScanner::scan(int time_budget_in_ms)
+{
+    Core::ElapsedTimer timer;
+    timer.start();
+
+    for (size_t tokens_processed = 1;; ++tokens_processed) {
+        auto optional_token = m_tokenizer.next_token();
+        if (!optional_token.has_value())
+            return !m_tokenizer.is_waiting_for_input();
+        auto& token = optional_token.value();
+        if (token.is_end_of_file())
+            return true;
+        if (token.is_start_tag())
+            process_start_tag(token);
+
+        if (time_budget_in_ms >= 0 && !(tokens_processed % 256) && timer.elapsed() >= time_budget_in_ms)
+            return false;
+    }
+}
+
+void HTMLPreloadScanner::process_start_tag(HTMLToken& token)
+{
+    auto tag_name = token.tag_name();
+
+    if (tag_name == "base") {
+        // Only the first <base> with an href counts.
+        auto href = token.attribute("href");
+        if (!m_has_seen_base_element && !href.is_null()) {
+            m_base_url = m_base_url.complete_url(href);
+            m_has_seen_base_element = true;
+        }
+        return;
+    }
+
+    if (tag_name == "link") {
+        for (auto& relationship : token.attribute("rel").split_view(' ')) {
+            if (relationship.equals_ignoring_case("stylesheet")) {
+                prefetch(token.attribute("href"));
+                break;
+            }
+        }
+        return;
+    }
+
+    if (tag_name == "img") {
+        prefetch(token.attribute("src"));
+        return;
+    }
+
+    // The parser switches the tokenizer out of the data state after these, so we have to as well.
+    // Otherwise we'd go looking for tags in the middle of scripts and stylesheets.
+    if (tag_name == "script") {
+        prefetch(token.attribute("src"));
+        m_tokenizer.switch_to_for_preload_scanning({}, HTMLTokenizer::State::ScriptData);
+        return;
+    }
+    if (tag_name == "title" || tag_name == "textarea") {
+        m_tokenizer.switch_to_for_preload_scanning({}, HTMLTokenizer::State::RCDATA);
+        return;
+    }
+    if (tag_name.is_one_of("style", "xmp", "iframe", "noembed", "noframes", "noscript")) {
+        m_tokenizer.switch_to_for_preload_scanning({}, HTMLTokenizer::State::RAWTEXT);
+        return;
+    }
+    if (tag_name == "plaintext")
+        m_tokenizer.switch_to_for_preload_scanning({}, HTMLTokenizer::State::PLAINTEXT);
+}
+
+void HTMLPreloadScanner::prefetch(const StringView& url)
+{
+    if (url.is_empty())
+        return;
+    auto complete_url = m_base_url.complete_url(url);
+    if (!complete_url.is_valid())
+        return;
+    ResourceLoader::the().prefetch(complete_url);
+}
+
+}
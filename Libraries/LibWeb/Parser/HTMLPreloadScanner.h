@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/URL.h>
+#include <LibWeb/Parser/HTMLTokenizer.h>
+
+namespace Web {
+
+// Runs through the markup ahead of the parser, looking for the stylesheets, scripts and images the
+// document will need, and has ResourceLoader start fetching them. By the time the parser gets to
+// them (which may take a while if a script blocks it), they're already on their way.
+class HTMLPreloadScanner {
+public:
+    explicit HTMLPreloadScanner(const URL& document_url);
+
+    // Expects UTF-8, i.e. input that the parser's tokenizer has already decoded.
+    void append_input(const StringView& input) { m_tokenizer.append_input(input); }
+    void close_input() { m_tokenizer.close_input(); }
+
+    // Scans the input that has arrived so far, stopping after roughly the given number of
+    // milliseconds (if any). Returns true once it has seen the whole document.
+    bool scan(int time_budget_in_ms = -1);
+
+private:
+    void process_start_tag(HTMLToken&);
+    void prefetch(const StringView& url);
+
+    HTMLTokenizer m_tokenizer;
+    URL m_base_url;
+    bool m_has_seen_base_element { false };
+};
+
+}
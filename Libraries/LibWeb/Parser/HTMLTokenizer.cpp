@@ -39,8 +39,15 @@
         dbg() << "Parse error (tokenization)" << __PRETTY_FUNCTION__ << " @ " << __LINE__; \
     } while (0)
 
-#define CONSUME_NEXT_INPUT_CHARACTER \
-    current_input_character = next_codepoint();
+#define STOP_IF_OUT_OF_INPUT                      \
+    do {                                          \
+        if (m_ran_out_of_input)                   \
+            return stop_and_wait_for_input();     \
+    } while (0)
+
+#define CONSUME_NEXT_INPUT_CHARACTER            \
+    current_input_character = next_codepoint(); \
+    STOP_IF_OUT_OF_INPUT
 
 #define SWITCH_TO(new_state)              \
     do {                                  \
@@ -73,6 +80,7 @@
 
 #define SWITCH_TO_AND_EMIT_CURRENT_TOKEN(new_state) \
     do {                                            \
+        STOP_IF_OUT_OF_INPUT;                       \
         will_switch_to(State::new_state);           \
         m_state = State::new_state;                 \
         will_emit(m_current_token);                 \
@@ -134,6 +142,7 @@
 
 #define EMIT_EOF                                      \
     do {                                              \
+        STOP_IF_OUT_OF_INPUT;                         \
         if (m_has_emitted_eof)                        \
             return {};                                \
         m_has_emitted_eof = true;                     \
@@ -145,6 +154,7 @@
 
 #define EMIT_CURRENT_TOKEN                        \
     do {                                          \
+        STOP_IF_OUT_OF_INPUT;                     \
         will_emit(m_current_token);               \
         m_queued_tokens.enqueue(m_current_token); \
         return m_queued_tokens.dequeue();         \
@@ -152,6 +162,7 @@
 
 #define EMIT_CHARACTER(codepoint)                                      \
     do {                                                               \
+        STOP_IF_OUT_OF_INPUT;                                          \
         create_new_token(HTMLToken::Type::Character);                  \
         m_current_token.m_comment_or_character.data.append(codepoint); \
         m_queued_tokens.enqueue(m_current_token);                      \
@@ -198,26 +209,56 @@ namespace Web {
 
 Optional<u32> HTMLTokenizer::next_codepoint()
 {
-    if (m_cursor >= m_input.length())
+    if (m_cursor >= m_input.length()) {
+        if (!m_input_closed)
+            m_ran_out_of_input = true;
         return {};
+    }
     return m_input[m_cursor++];
 }
 
-Optional<u32> HTMLTokenizer::peek_codepoint(size_t offset) const
+Optional<u32> HTMLTokenizer::peek_codepoint(size_t offset)
 {
-    if ((m_cursor + offset) >= m_input.length())
+    if ((m_cursor + offset) >= m_input.length()) {
+        if (!m_input_closed)
+            m_ran_out_of_input = true;
         return {};
+    }
     return m_input[m_cursor + offset];
 }
 
+Optional<HTMLToken> HTMLTokenizer::stop_and_wait_for_input()
+{
+    // Forget everything we did since the checkpoint; we'll do it again once there's more input.
+    m_cursor = m_checkpoint.cursor;
+    m_state = m_checkpoint.state;
+    m_return_state = m_checkpoint.return_state;
+    m_temporary_buffer = move(m_checkpoint.temporary_buffer);
+    m_queued_tokens.clear();
+    m_ran_out_of_input = false;
+    m_waiting_for_input = true;
+    return {};
+}
+
 Optional<HTMLToken> HTMLTokenizer::next_token()
 {
+    if (!m_queued_tokens.is_empty())
+        return m_queued_tokens.dequeue();
+
+    // NOTE: Every call starts at a token boundary, so this is all the state there is to restore.
+    //       Tokens under construction never outlive a call, since returning means emitting them.
+    m_waiting_for_input = false;
+    if (!m_input_closed)
+        m_checkpoint = { m_cursor, m_state, m_return_state, m_temporary_buffer };
+
 _StartOfFunction:
+    STOP_IF_OUT_OF_INPUT;
     if (!m_queued_tokens.is_empty())
         return m_queued_tokens.dequeue();
 
     for (;;) {
         auto current_input_character = next_codepoint();
+        STOP_IF_OUT_OF_INPUT;
         switch (m_state) {
             BEGIN_STATE(Data)
             {
@@ -355,6 +396,7 @@ _StartOfFunction:
                 if (consume_next_if_match("DOCTYPE", CaseSensitivity::CaseInsensitive)) {
                     SWITCH_TO(DOCTYPE);
                 }
+                STOP_IF_OUT_OF_INPUT;
             }
             END_STATE
 
@@ -485,6 +527,7 @@ _StartOfFunction:
                     if (toupper(current_input_character.value()) == 'S' && consume_next_if_match("YSTEM", CaseSensitivity::CaseInsensitive)) {
                         SWITCH_TO(AfterDOCTYPESystemKeyword);
                     }
+                    STOP_IF_OUT_OF_INPUT;
                     TODO();
                 }
             }
@@ -1255,6 +1298,12 @@ _StartOfFunction:
 
             BEGIN_STATE(NamedCharacterReference)
             {
+                // The longest named character reference is 33 characters long, so until we have that many,
+                // a longer match than the one we can see may still be on its way.
+                static constexpr size_t longest_named_character_reference_length = 33;
+                if (!m_input_closed && m_input.length() - m_cursor + 1 < longest_named_character_reference_length)
+                    return stop_and_wait_for_input();
+
                 auto match = HTML::codepoints_from_entity(m_input.substring_view(m_cursor - 1, m_input.length() - m_cursor + 1));
 
                 if (match.has_value()) {
@@ -2061,11 +2110,30 @@ void HTMLTokenizer::create_new_token(HTMLToken::Type type)
 }
 
 HTMLTokenizer::HTMLTokenizer(const StringView& input, const String& encoding)
+    : HTMLTokenizer(encoding)
 {
-    auto* decoder = TextCodec::decoder_for(encoding);
-    ASSERT(decoder);
-    m_decoded_input = decoder->to_utf8(input);
-    m_input = m_decoded_input;
+    append_input(input);
+    close_input();
+}
+
+HTMLTokenizer::HTMLTokenizer(const String& encoding)
+{
+    m_decoder = TextCodec::decoder_for(encoding);
+    ASSERT(m_decoder);
+}
+
+void HTMLTokenizer::append_input(const StringView& input)
+{
+    ASSERT(!m_input_closed);
+    // FIXME: A multi-byte sequence split across two chunks won't survive decoders that aren't
+    //        byte-for-byte, since each chunk is decoded on its own.
+    m_decoded_input.append(m_decoder->to_utf8(input));
+    m_input = m_decoded_input.string_view();
+}
+
+void HTMLTokenizer::close_input()
+{
+    m_input_closed = true;
 }
 
 void HTMLTokenizer::will_switch_to([[maybe_unused]] State new_state)
@@ -2090,6 +2158,11 @@ void HTMLTokenizer::switch_to(Badge<HTMLDocumentParser>, State new_state)
     m_state = new_state;
 }
 
+void HTMLTokenizer::switch_to_for_preload_scanning(Badge<HTMLPreloadScanner>, State new_state)
+{
+    m_state = new_state;
+}
+
 void HTMLTokenizer::will_emit(HTMLToken& token)
 {
     if (token.is_start_tag())
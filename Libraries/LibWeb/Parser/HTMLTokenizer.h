@@ -27,6 +27,7 @@
 #pragma once
 
 #include <AK/Queue.h>
+#include <AK/StringBuilder.h>
 #include <AK/StringView.h>
 #include <AK/Types.h>
 #include <LibWeb/Forward.h>
@@ -114,12 +115,19 @@
     __ENUMERATE_TOKENIZER_STATE(DecimalCharacterReference)                \
     __ENUMERATE_TOKENIZER_STATE(NumericCharacterReferenceEnd)
 
+namespace TextCodec {
+class Decoder;
+}
+
 namespace Web {
 
 class HTMLTokenizer {
 public:
     explicit HTMLTokenizer(const StringView& input, const String& encoding);
 
+    // Starts out without any input, so that a document can be fed to it as it arrives.
+    explicit HTMLTokenizer(const String& encoding);
+
     enum class State {
 #define __ENUMERATE_TOKENIZER_STATE(state) state,
         ENUMERATE_TOKENIZER_STATES
@@ -128,16 +136,28 @@ public:
 
     Optional<HTMLToken> next_token();
 
+    void append_input(const StringView&);
+    void close_input();
+    bool is_input_closed() const { return m_input_closed; }
+
+    // Whether next_token() returned nothing because it can't tell what comes next until more
+    // input has arrived, rather than because it has reached the end of the input.
+    bool is_waiting_for_input() const { return m_waiting_for_input; }
+
     void switch_to(Badge<HTMLDocumentParser>, State new_state);
+    void switch_to_for_preload_scanning(Badge<HTMLPreloadScanner>, State new_state);
 
     void set_blocked(bool b) { m_blocked = b; }
     bool is_blocked() const { return m_blocked; }
 
-    String source() const { return m_decoded_input; }
+    String source() const { return m_decoded_input.to_string(); }
+
+    // All the input so far, decoded to UTF-8. Only valid until more input is appended.
+    StringView decoded_input() const { return m_input; }
 
 private:
     Optional<u32> next_codepoint();
-    Optional<u32> peek_codepoint(size_t offset) const;
+    Optional<u32> peek_codepoint(size_t offset);
     bool consume_next_if_match(const StringView&, CaseSensitivity = CaseSensitivity::CaseSensitive);
     void create_new_token(HTMLToken::Type);
     bool current_end_tag_token_is_appropriate() const;
@@ -154,6 +174,8 @@ private:
         ASSERT_NOT_REACHED();
     }
 
+    Optional<HTMLToken> stop_and_wait_for_input();
+
     void will_emit(HTMLToken&);
     void will_switch_to(State);
     void will_reconsume_in(State);
@@ -165,11 +187,26 @@ private:
 
     Vector<u32> m_temporary_buffer;
 
-    String m_decoded_input;
+    TextCodec::Decoder* m_decoder { nullptr };
+    StringBuilder m_decoded_input;
 
     StringView m_input;
     size_t m_cursor { 0 };
 
+    bool m_input_closed { false };
+    bool m_ran_out_of_input { false };
+    bool m_waiting_for_input { false };
+
+    // Where the current call to next_token() started, so that it can start over from there if
+    // it runs out of input before it can emit a token.
+    struct Checkpoint {
+        size_t cursor { 0 };
+        State state { State::Data };
+        State return_state { State::Data };
+        Vector<u32> temporary_buffer;
+    };
+    Checkpoint m_checkpoint;
+
     HTMLToken m_current_token;
 
     HTMLToken m_last_emitted_start_tag;
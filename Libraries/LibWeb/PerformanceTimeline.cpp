@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <LibWeb/PerformanceTimeline.h>
+#include <sys/time.h>
+#include <time.h>
+
+namespace Web {
+
+// Pages that keep repainting would otherwise grow the timeline forever.
+static constexpr size_t max_entries = 1000;
+
+double PerformanceTimeline::monotonic_now()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000.0 + now.tv_nsec / 1000000.0;
+}
+
+const char* PerformanceTimeline::category_name(Category category)
+{
+    switch (category) {
+    case Category::Network:
+        return "Network";
+    case Category::Parse:
+        return "Parse";
+    case Category::Style:
+        return "Style";
+    case Category::Layout:
+        return "Layout";
+    case Category::Paint:
+        return "Paint";
+    case Category::Script:
+        return "Script";
+    }
+    ASSERT_NOT_REACHED();
+}
+
+PerformanceTimeline::PerformanceTimeline()
+{
+    set_navigation_start(monotonic_now());
+}
+
+void PerformanceTimeline::set_navigation_start(double monotonic_time)
+{
+    struct timeval now;
+    gettimeofday(&now, nullptr);
+    double now_since_epoch = now.tv_sec * 1000.0 + now.tv_usec / 1000.0;
+
+    // Entries and milestones recorded so far were relative to the old origin.
+    double shift = m_origin - monotonic_time;
+    for (auto& entry : m_entries)
+        entry.start += shift;
+
+    m_origin = monotonic_time;
+    m_time_origin_since_epoch = now_since_epoch - (monotonic_now() - monotonic_time);
+    m_milestones[(size_t)Milestone::NavigationStart] = monotonic_time;
+}
+
+void PerformanceTimeline::set_milestone(Milestone milestone, double monotonic_time)
+{
+    m_milestones[(size_t)milestone] = monotonic_time;
+}
+
+double PerformanceTimeline::milestone_since_epoch(Milestone milestone) const
+{
+    double time = m_milestones[(size_t)milestone];
+    if (!time)
+        return 0;
+    return m_time_origin_since_epoch + (time - m_origin);
+}
+
+double PerformanceTimeline::milestone(Milestone milestone) const
+{
+    double time = m_milestones[(size_t)milestone];
+    if (!time)
+        return 0;
+    return time - m_origin;
+}
+
+void PerformanceTimeline::add_entry(Category category, const String& name, double monotonic_start, double monotonic_end)
+{
+    if (m_entries.size() >= max_entries)
+        return;
+    m_entries.append({ category, name, monotonic_start - m_origin, monotonic_end - monotonic_start });
+}
+
+}
@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/String.h>
+#include <AK/Vector.h>
+
+namespace Web {
+
+// Records when a document's load reached each milestone, and how long the work done for it
+// (parsing, style, layout, paint, scripts) took. This backs performance.now() / performance.timing
+// and the timeline in Browser's inspector.
+//
+// Times handed in are from monotonic_now(). Entries are kept relative to the time origin, which is
+// when the navigation that led to the document started.
+class PerformanceTimeline {
+public:
+    enum class Milestone {
+        NavigationStart,
+        FetchStart,
+        ResponseEnd,
+        DOMLoading,
+        DOMInteractive,
+        DOMContentLoadedEventStart,
+        DOMContentLoadedEventEnd,
+        DOMComplete,
+        __Count,
+    };
+
+    enum class Category {
+        Network,
+        Parse,
+        Style,
+        Layout,
+        Paint,
+        Script,
+    };
+
+    struct Entry {
+        Category category;
+        String name;
+        double start { 0 };
+        double duration { 0 };
+    };
+
+    // Milliseconds on a monotonic clock with an arbitrary epoch.
+    static double monotonic_now();
+
+    static const char* category_name(Category);
+
+    PerformanceTimeline();
+
+    void set_navigation_start(double monotonic_time);
+
+    // Milliseconds since the Unix epoch when the timeline starts.
+    double time_origin() const { return m_time_origin_since_epoch; }
+
+    // Milliseconds since the time origin.
+    double now() const { return monotonic_now() - m_origin; }
+
+    void set_milestone(Milestone milestone) { set_milestone(milestone, monotonic_now()); }
+    void set_milestone(Milestone, double monotonic_time);
+
+    // Milliseconds since the Unix epoch, or 0 if the milestone hasn't been reached (yet).
+    double milestone_since_epoch(Milestone) const;
+
+    // Milliseconds since the time origin, or 0 if the milestone hasn't been reached (yet).
+    double milestone(Milestone) const;
+
+    void add_entry(Category, const String& name, double monotonic_start, double monotonic_end);
+    const Vector<Entry>& entries() const { return m_entries; }
+
+    class Measurement {
+    public:
+        Measurement(PerformanceTimeline& timeline, Category category, const String& name)
+            : m_timeline(timeline)
+            , m_category(category)
+            , m_name(name)
+            , m_start(monotonic_now())
+        {
+        }
+        ~Measurement() { m_timeline.add_entry(m_category, m_name, m_start, monotonic_now()); }
+
+    private:
+        PerformanceTimeline& m_timeline;
+        Category m_category;
+        String m_name;
+        double m_start { 0 };
+    };
+
+private:
+    double m_origin { 0 };
+    double m_time_origin_since_epoch { 0 };
+    double m_milestones[(size_t)Milestone::__Count] {};
+    Vector<Entry> m_entries;
+};
+
+}
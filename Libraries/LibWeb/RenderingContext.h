@@ -49,10 +49,15 @@ public:
     Gfx::Rect viewport_rect() const { return m_viewport_rect; }
     void set_viewport_rect(const Gfx::Rect& rect) { m_viewport_rect = rect; }
 
+    // The part of the document that is being painted. Anything outside of it can be skipped.
+    Gfx::Rect paint_rect() const { return m_paint_rect; }
+    void set_paint_rect(const Gfx::Rect& rect) { m_paint_rect = rect; }
+
 private:
     GUI::Painter& m_painter;
     Palette m_palette;
     Gfx::Rect m_viewport_rect;
+    Gfx::Rect m_paint_rect;
     bool m_should_show_line_box_borders { false };
 };
 
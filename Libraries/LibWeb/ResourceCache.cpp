@@ -0,0 +1,353 @@
+/*
+ * Copyright (c) 2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/JsonObject.h>
+#include <AK/StringBuilder.h>
+#include <LibCore/File.h>
+#include <LibWeb/ResourceCache.h>
+#include <errno.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+//#define CACHE_DEBUG
+
+namespace Web {
+
+// Responses larger than this are not worth evicting everything else for.
+static constexpr size_t max_entry_size_in_memory = 4 * MB;
+
+struct CachePolicy {
+    bool may_store { true };
+    time_t freshness_lifetime { 0 };
+};
+
+static CachePolicy cache_policy_for(const ResourceCache::ResponseHeaders& response_headers)
+{
+    CachePolicy policy;
+
+    // We don't key entries on request headers, so a response that varies on them can't be reused safely.
+    auto vary = response_headers.get("Vary");
+    if (vary.has_value() && !vary.value().trim_whitespace().is_empty()) {
+        policy.may_store = false;
+        return policy;
+    }
+
+    auto cache_control = response_headers.get("Cache-Control");
+    if (!cache_control.has_value())
+        return policy;
+
+    bool no_cache = false;
+    for (auto& part : cache_control.value().split(',')) {
+        auto directive = part.trim_whitespace().to_lowercase();
+        if (directive == "no-store") {
+            policy.may_store = false;
+            return policy;
+        }
+        if (directive == "no-cache") {
+            no_cache = true;
+            continue;
+        }
+        if (directive.starts_with("max-age=")) {
+            bool ok;
+            auto max_age = directive.substring_view(8, directive.length() - 8).to_uint(ok);
+            if (ok)
+                policy.freshness_lifetime = max_age;
+        }
+    }
+
+    if (no_cache) {
+        policy.freshness_lifetime = 0;
+        return policy;
+    }
+
+    // Time the response already spent in caches upstream counts against its lifetime.
+    auto age = response_headers.get("Age");
+    if (age.has_value()) {
+        bool ok;
+        auto seconds = age.value().trim_whitespace().to_uint(ok);
+        if (ok)
+            policy.freshness_lifetime = max((time_t)0, policy.freshness_lifetime - (time_t)seconds);
+    }
+
+    // FIXME: Honor Expires when there's no max-age.
+    return policy;
+}
+
+static String cache_key_for(const URL& url)
+{
+    // The fragment is never sent to the server, so it doesn't make for a different resource.
+    if (url.fragment().is_empty())
+        return url.to_string();
+    URL url_without_fragment = url;
+    url_without_fragment.set_fragment({});
+    return url_without_fragment.to_string();
+}
+
+ResourceCache::ResourceCache()
+{
+}
+
+ResourceCache::~ResourceCache()
+{
+}
+
+bool ResourceCache::is_cacheable_url(const URL& url)
+{
+    return url.protocol() == "http" || url.protocol() == "https";
+}
+
+ResourceCache::Entry* ResourceCache::find(const URL& url)
+{
+    auto key = cache_key_for(url);
+    auto it = m_entries.find(key);
+    if (it != m_entries.end()) {
+        it->value->last_used = ++m_use_counter;
+        return it->value.ptr();
+    }
+
+    auto entry = load_from_disk(key);
+    if (!entry)
+        return nullptr;
+    ++m_statistics.disk_hits;
+    return &insert(key, entry.release_nonnull());
+}
+
+void ResourceCache::store(const URL& url, const ByteBuffer& data, const ResponseHeaders& response_headers)
+{
+    auto key = cache_key_for(url);
+    auto policy = cache_policy_for(response_headers);
+
+    auto etag = response_headers.get("ETag");
+    auto last_modified = response_headers.get("Last-Modified");
+    bool has_validators = etag.has_value() || last_modified.has_value();
+
+    if (!policy.may_store || (policy.freshness_lifetime == 0 && !has_validators) || data.size() > max_entry_size_in_memory) {
+        remove(url);
+        return;
+    }
+
+    auto entry = make<Entry>();
+    entry->data = ByteBuffer::copy(data.data(), data.size());
+    entry->response_headers = response_headers;
+    entry->stored_at = time(nullptr);
+    entry->freshness_lifetime = policy.freshness_lifetime;
+    if (etag.has_value())
+        entry->etag = etag.value();
+    if (last_modified.has_value())
+        entry->last_modified = last_modified.value();
+
+#ifdef CACHE_DEBUG
+    dbg() << "ResourceCache: Storing " << key << " (" << data.size() << " bytes, fresh for " << policy.freshness_lifetime << "s)";
+#endif
+
+    auto& stored_entry = insert(key, move(entry));
+    save_to_disk(key, stored_entry);
+}
+
+void ResourceCache::did_revalidate(const URL& url, const ResponseHeaders& response_headers)
+{
+    auto key = cache_key_for(url);
+    auto it = m_entries.find(key);
+    if (it == m_entries.end())
+        return;
+    auto& entry = *it->value;
+
+    // A 304 carries updated metadata for the stored response (RFC 7234 section 4.3.4).
+    for (auto& header : response_headers)
+        entry.response_headers.set(header.key, header.value);
+
+    auto policy = cache_policy_for(entry.response_headers);
+    if (!policy.may_store) {
+        remove(url);
+        return;
+    }
+
+    entry.stored_at = time(nullptr);
+    entry.freshness_lifetime = policy.freshness_lifetime;
+    entry.last_used = ++m_use_counter;
+    save_to_disk(key, entry);
+}
+
+void ResourceCache::remove(const URL& url)
+{
+    auto key = cache_key_for(url);
+    auto it = m_entries.find(key);
+    if (it != m_entries.end()) {
+        m_memory_usage -= it->value->data.size();
+        m_entries.remove(it);
+    }
+    remove_from_disk(key);
+}
+
+void ResourceCache::clear()
+{
+    m_entries.clear();
+    m_memory_usage = 0;
+}
+
+void ResourceCache::set_memory_budget(size_t budget)
+{
+    m_memory_budget = budget;
+    evict_until_within_budget();
+}
+
+ResourceCache::Entry& ResourceCache::insert(const String& key, NonnullOwnPtr<Entry> entry)
+{
+    auto it = m_entries.find(key);
+    if (it != m_entries.end()) {
+        m_memory_usage -= it->value->data.size();
+        m_entries.remove(it);
+    }
+
+    entry->last_used = ++m_use_counter;
+    m_memory_usage += entry->data.size();
+    auto& entry_ref = *entry;
+    m_entries.set(key, move(entry));
+
+    evict_until_within_budget();
+    return entry_ref;
+}
+
+void ResourceCache::evict_until_within_budget()
+{
+    // The most recently used entry is never evicted, so the caller can keep using what it just inserted.
+    while (m_memory_usage > m_memory_budget && m_entries.size() > 1) {
+        String least_recently_used_key;
+        u64 least_recent_use = NumericLimits<u64>::max();
+        for (auto& it : m_entries) {
+            if (it.value->last_used < least_recent_use) {
+                least_recent_use = it.value->last_used;
+                least_recently_used_key = it.key;
+            }
+        }
+        auto it = m_entries.find(least_recently_used_key);
+        m_memory_usage -= it->value->data.size();
+        m_entries.remove(it);
+        ++m_statistics.evictions;
+#ifdef CACHE_DEBUG
+        dbg() << "ResourceCache: Evicted " << least_recently_used_key;
+#endif
+    }
+}
+
+void ResourceCache::set_disk_cache_directory(const String& path)
+{
+    if (!path.is_null() && mkdir(path.characters(), 0700) < 0 && errno != EEXIST) {
+        perror("mkdir");
+        m_disk_cache_directory = {};
+        return;
+    }
+    m_disk_cache_directory = path;
+}
+
+String ResourceCache::disk_path_for(const String& key) const
+{
+    return String::format("%s/%08x", m_disk_cache_directory.characters(), key.hash());
+}
+
+// An on-disk entry is one line of JSON metadata followed by the response body.
+OwnPtr<ResourceCache::Entry> ResourceCache::load_from_disk(const String& key)
+{
+    if (m_disk_cache_directory.is_null())
+        return nullptr;
+
+    auto file_or_error = Core::File::open(disk_path_for(key), Core::IODevice::ReadOnly);
+    if (file_or_error.is_error())
+        return nullptr;
+    auto contents = file_or_error.value()->read_all();
+
+    size_t metadata_length = 0;
+    while (metadata_length < contents.size() && contents[metadata_length] != '\n')
+        ++metadata_length;
+    if (metadata_length == contents.size())
+        return nullptr;
+
+    auto json = JsonValue::from_string(StringView(contents.data(), metadata_length));
+    if (!json.is_object())
+        return nullptr;
+    auto& metadata = json.as_object();
+
+    // Different URLs may hash to the same file name.
+    if (metadata.get("url").to_string() != key)
+        return nullptr;
+
+    auto entry = make<Entry>();
+    size_t data_offset = metadata_length + 1;
+    entry->data = ByteBuffer::copy(contents.data() + data_offset, contents.size() - data_offset);
+    entry->stored_at = metadata.get("stored_at").to_number<i64>();
+    entry->freshness_lifetime = metadata.get("freshness_lifetime").to_number<i64>();
+    if (metadata.has("etag"))
+        entry->etag = metadata.get("etag").to_string();
+    if (metadata.has("last_modified"))
+        entry->last_modified = metadata.get("last_modified").to_string();
+    auto headers = metadata.get("headers");
+    if (headers.is_object()) {
+        headers.as_object().for_each_member([&](auto& name, auto& value) {
+            entry->response_headers.set(name, value.to_string());
+        });
+    }
+    return entry;
+}
+
+void ResourceCache::save_to_disk(const String& key, const Entry& entry)
+{
+    if (m_disk_cache_directory.is_null())
+        return;
+
+    JsonObject headers;
+    for (auto& header : entry.response_headers)
+        headers.set(header.key, header.value);
+
+    JsonObject metadata;
+    metadata.set("url", key);
+    metadata.set("stored_at", (i64)entry.stored_at);
+    metadata.set("freshness_lifetime", (i64)entry.freshness_lifetime);
+    if (!entry.etag.is_null())
+        metadata.set("etag", entry.etag);
+    if (!entry.last_modified.is_null())
+        metadata.set("last_modified", entry.last_modified);
+    metadata.set("headers", move(headers));
+
+    auto file_or_error = Core::File::open(disk_path_for(key), (Core::IODevice::OpenMode)(Core::IODevice::WriteOnly | Core::IODevice::Truncate), 0600);
+    if (file_or_error.is_error()) {
+        dbg() << "ResourceCache: Failed to write " << key << " to disk: " << file_or_error.error();
+        return;
+    }
+    auto& file = *file_or_error.value();
+    file.write(metadata.to_string());
+    file.write("\n");
+    file.write(entry.data.data(), entry.data.size());
+}
+
+void ResourceCache::remove_from_disk(const String& key)
+{
+    if (m_disk_cache_directory.is_null())
+        return;
+    unlink(disk_path_for(key).characters());
+}
+
+}
@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/ByteBuffer.h>
+#include <AK/HashMap.h>
+#include <AK/NonnullOwnPtr.h>
+#include <AK/String.h>
+#include <AK/URL.h>
+#include <time.h>
+
+namespace Web {
+
+// An HTTP cache for ResourceLoader, following the freshness and validation rules of RFC 7234.
+// Responses live in memory and are evicted least-recently-used first once the memory budget is exceeded.
+// If a disk cache directory has been set, responses are also written there and survive the process.
+class ResourceCache {
+public:
+    using ResponseHeaders = HashMap<String, String, CaseInsensitiveStringTraits>;
+
+    struct Entry {
+        ByteBuffer data;
+        ResponseHeaders response_headers;
+        time_t stored_at { 0 };
+        time_t freshness_lifetime { 0 };
+        String etag;
+        String last_modified;
+        u64 last_used { 0 };
+
+        bool is_fresh(time_t now) const { return now - stored_at < freshness_lifetime; }
+        bool can_be_revalidated() const { return !etag.is_null() || !last_modified.is_null(); }
+    };
+
+    struct Statistics {
+        size_t hits { 0 };
+        size_t revalidated_hits { 0 };
+        size_t misses { 0 };
+        size_t disk_hits { 0 };
+        size_t evictions { 0 };
+    };
+
+    ResourceCache();
+    ~ResourceCache();
+
+    static bool is_cacheable_url(const URL&);
+
+    // Returns the entry for the URL, fresh or stale, loading it from disk if it's not in memory.
+    Entry* find(const URL&);
+
+    // Stores a response if its headers allow it, replacing any existing entry for the URL.
+    void store(const URL&, const ByteBuffer&, const ResponseHeaders&);
+
+    // Refreshes a stale entry after the server confirmed (with 304 Not Modified) that it's still valid.
+    void did_revalidate(const URL&, const ResponseHeaders&);
+
+    void remove(const URL&);
+    void clear();
+
+    const String& disk_cache_directory() const { return m_disk_cache_directory; }
+    void set_disk_cache_directory(const String&);
+
+    size_t memory_budget() const { return m_memory_budget; }
+    void set_memory_budget(size_t);
+
+    size_t entry_count() const { return m_entries.size(); }
+    size_t memory_usage() const { return m_memory_usage; }
+
+    Statistics& statistics() { return m_statistics; }
+    const Statistics& statistics() const { return m_statistics; }
+
+private:
+    Entry& insert(const String& key, NonnullOwnPtr<Entry>);
+    void evict_until_within_budget();
+
+    String disk_path_for(const String& key) const;
+    OwnPtr<Entry> load_from_disk(const String& key);
+    void save_to_disk(const String& key, const Entry&);
+    void remove_from_disk(const String& key);
+
+    HashMap<String, NonnullOwnPtr<Entry>> m_entries;
+    size_t m_memory_usage { 0 };
+    size_t m_memory_budget { 32 * MB };
+    u64 m_use_counter { 0 };
+
+    String m_disk_cache_directory;
+
+    Statistics m_statistics;
+};
+
+}
@@ -69,6 +69,39 @@ void ResourceLoader::load_sync(const URL& url, Function<void(const ByteBuffer&,
 }
 
 void ResourceLoader::load(const URL& url, Function<void(const ByteBuffer&, const HashMap<String, String, CaseInsensitiveStringTraits>& response_headers)> success_callback, Function<void(const String&)> error_callback)
+{
+    start_load(url, move(success_callback), move(error_callback), nullptr);
+}
+
+void ResourceLoader::load_incrementally(const URL& url, Function<void(const HashMap<String, String, CaseInsensitiveStringTraits>& response_headers)> headers_callback, Function<void(const ByteBuffer&)> data_callback, Function<void()> finished_callback, Function<void(const String&)> error_callback)
+{
+    auto incremental_load = adopt(*new IncrementalLoad);
+    incremental_load->headers_callback = move(headers_callback);
+    incremental_load->data_callback = move(data_callback);
+    start_load(
+        url,
+        [incremental_load, finished_callback = move(finished_callback)](auto& data, auto& response_headers) {
+            // Whatever hasn't been handed over as it arrived (all of it, if it didn't come over the network) comes now.
+            const_cast<IncrementalLoad&>(*incremental_load).catch_up(response_headers, data);
+            finished_callback();
+        },
+        move(error_callback), incremental_load);
+}
+
+void ResourceLoader::IncrementalLoad::catch_up(const HashMap<String, String, CaseInsensitiveStringTraits>& response_headers, const ByteBuffer& data)
+{
+    if (!has_received_headers) {
+        has_received_headers = true;
+        headers_callback(response_headers);
+    }
+    if (data.size() > received_size) {
+        auto new_data = data.slice(received_size, data.size() - received_size);
+        received_size = data.size();
+        data_callback(new_data);
+    }
+}
+
+void ResourceLoader::start_load(const URL& url, Function<void(const ByteBuffer&, const HashMap<String, String, CaseInsensitiveStringTraits>& response_headers)> success_callback, Function<void(const String&)> error_callback, RefPtr<IncrementalLoad> incremental_load)
 {
     if (is_port_blocked(url.port())) {
         dbg() << "ResourceLoader::load: Error: blocked port " << url.port() << " for URL: " << url;
@@ -116,28 +149,53 @@ void ResourceLoader::load(const URL& url, Function<void(const ByteBuffer&, const
     }
 
     if (url.protocol() == "http" || url.protocol() == "https" || url.protocol() == "gemini") {
-        HashMap<String, String> headers;
-        headers.set("User-Agent", m_user_agent);
-        auto download = protocol_client().start_download(url.to_string(), headers);
-        if (!download) {
-            if (error_callback)
-                error_callback("Failed to initiate load");
+        auto url_string = url.to_string();
+
+        for (size_t i = 0; i < m_prefetched_responses.size(); ++i) {
+            if (m_prefetched_responses[i].url_string != url_string)
+                continue;
+            auto response = m_prefetched_responses.take(i);
+            deferred_invoke([data = move(response.data), response_headers = move(response.response_headers), success_callback = move(success_callback)](auto&) {
+                success_callback(data, response_headers);
+            });
             return;
         }
-        download->on_finish = [this, success_callback = move(success_callback), error_callback = move(error_callback)](bool success, const ByteBuffer& payload, auto, auto& response_headers) {
-            --m_pending_loads;
-            if (on_load_counter_change)
-                on_load_counter_change();
-            if (!success) {
-                if (error_callback)
-                    error_callback("HTTP load failed");
-                return;
+
+        auto* cached_entry = ResourceCache::is_cacheable_url(url) ? m_cache.find(url) : nullptr;
+        if (cached_entry && cached_entry->is_fresh(time(nullptr))) {
+            ++m_cache.statistics().hits;
+            deferred_invoke([data = ByteBuffer::copy(cached_entry->data.data(), cached_entry->data.size()), response_headers = cached_entry->response_headers, success_callback = move(success_callback)](auto&) {
+                success_callback(data, response_headers);
+            });
+            return;
+        }
+
+        // Loads of a URL that is already being downloaded piggyback on that download.
+        auto pending_download = m_pending_downloads.find(url_string);
+        if (pending_download != m_pending_downloads.end()) {
+            // If it's a prefetch still waiting for its turn, somebody needs it now, so it goes first.
+            if (pending_download->value->success_callbacks.is_empty()) {
+                for (size_t i = 0; i < m_queued_downloads.size(); ++i) {
+                    if (m_queued_downloads[i] == url_string) {
+                        m_queued_downloads.prepend(m_queued_downloads.take(i));
+                        break;
+                    }
+                }
             }
-            success_callback(ByteBuffer::copy(payload.data(), payload.size()), response_headers);
-        };
-        ++m_pending_loads;
-        if (on_load_counter_change)
-            on_load_counter_change();
+            pending_download->value->success_callbacks.append(move(success_callback));
+            pending_download->value->error_callbacks.append(move(error_callback));
+            // It catches up with what has arrived already along with whatever arrives next.
+            if (incremental_load)
+                pending_download->value->incremental_loads.append(incremental_load.release_nonnull());
+            return;
+        }
+
+        auto& new_pending_download = create_pending_download(url, url_string);
+        new_pending_download.success_callbacks.append(move(success_callback));
+        new_pending_download.error_callbacks.append(move(error_callback));
+        if (incremental_load)
+            new_pending_download.incremental_loads.append(incremental_load.release_nonnull());
+        start_queued_downloads();
         return;
     }
 
@@ -145,6 +203,204 @@ void ResourceLoader::load(const URL& url, Function<void(const ByteBuffer&, const
         error_callback(String::format("Protocol not implemented: %s", url.protocol().characters()));
 }
 
+void ResourceLoader::prefetch(const URL& url)
+{
+    if (url.protocol() != "http" && url.protocol() != "https")
+        return;
+    if (is_port_blocked(url.port()))
+        return;
+
+    auto url_string = url.to_string();
+    if (m_pending_downloads.contains(url_string))
+        return;
+    for (auto& response : m_prefetched_responses) {
+        if (response.url_string == url_string)
+            return;
+    }
+    auto* cached_entry = ResourceCache::is_cacheable_url(url) ? m_cache.find(url) : nullptr;
+    if (cached_entry && cached_entry->is_fresh(time(nullptr)))
+        return;
+
+    create_pending_download(url, url_string);
+    start_queued_downloads();
+}
+
+void ResourceLoader::set_max_downloads_per_origin(size_t max_downloads)
+{
+    m_max_downloads_per_origin = max(max_downloads, (size_t)1);
+    start_queued_downloads();
+}
+
+static String origin_of(const URL& url)
+{
+    return String::format("%s://%s:%u", url.protocol().characters(), url.host().characters(), url.port());
+}
+
+ResourceLoader::PendingDownload& ResourceLoader::create_pending_download(const URL& url, const String& url_string)
+{
+    auto pending_download = make<PendingDownload>();
+    pending_download->url = url;
+    pending_download->request_headers.set("User-Agent", m_user_agent);
+
+    auto* cached_entry = ResourceCache::is_cacheable_url(url) ? m_cache.find(url) : nullptr;
+    if (cached_entry && cached_entry->can_be_revalidated()) {
+        pending_download->is_revalidation = true;
+        pending_download->cached_etag = cached_entry->etag;
+        if (!cached_entry->etag.is_null())
+            pending_download->request_headers.set("If-None-Match", cached_entry->etag);
+        if (!cached_entry->last_modified.is_null())
+            pending_download->request_headers.set("If-Modified-Since", cached_entry->last_modified);
+    }
+
+    auto& pending_download_ref = *pending_download;
+    m_pending_downloads.set(url_string, move(pending_download));
+    m_queued_downloads.append(url_string);
+
+    ++m_pending_loads;
+    if (on_load_counter_change)
+        on_load_counter_change();
+    return pending_download_ref;
+}
+
+void ResourceLoader::start_queued_downloads()
+{
+    for (size_t i = 0; i < m_queued_downloads.size();) {
+        auto& pending_download = *m_pending_downloads.find(m_queued_downloads[i])->value;
+        if (m_active_downloads_per_origin.get(origin_of(pending_download.url)).value_or(0) >= m_max_downloads_per_origin) {
+            ++i;
+            continue;
+        }
+        auto url_string = m_queued_downloads.take(i);
+        start_download(url_string, pending_download);
+    }
+}
+
+void ResourceLoader::start_download(const String& url_string, PendingDownload& pending_download)
+{
+    auto download = protocol_client().start_download(url_string, pending_download.request_headers);
+    if (!download) {
+        // Tell the callbacks later, since they may well load() something else right away.
+        auto failed_download = move(m_pending_downloads.find(url_string)->value);
+        m_pending_downloads.remove(url_string);
+        --m_pending_loads;
+        if (on_load_counter_change)
+            on_load_counter_change();
+        deferred_invoke([failed_download = move(failed_download)](auto&) {
+            for (auto& error_callback : failed_download->error_callbacks) {
+                if (error_callback)
+                    error_callback("Failed to initiate load");
+            }
+        });
+        return;
+    }
+
+    auto origin = origin_of(pending_download.url);
+    m_active_downloads_per_origin.set(origin, m_active_downloads_per_origin.get(origin).value_or(0) + 1);
+
+    download->on_headers_received = [this, url_string](auto& response_headers) {
+        did_receive_response_headers(url_string, response_headers);
+    };
+    download->on_data = [this, url_string](auto& data) {
+        did_receive_data(url_string, data);
+    };
+    download->on_finish = [this, url_string, origin](bool success, auto&, auto& response_headers) {
+        auto active_downloads = m_active_downloads_per_origin.get(origin).value_or(1) - 1;
+        if (active_downloads)
+            m_active_downloads_per_origin.set(origin, active_downloads);
+        else
+            m_active_downloads_per_origin.remove(origin);
+
+        did_finish_download(url_string, success, response_headers);
+        start_queued_downloads();
+    };
+}
+
+void ResourceLoader::did_receive_response_headers(const String& url_string, const HashMap<String, String, CaseInsensitiveStringTraits>& response_headers)
+{
+    auto& pending_download = *m_pending_downloads.find(url_string)->value;
+    pending_download.has_response_headers = true;
+    pending_download.response_headers = response_headers;
+    update_incremental_loads(pending_download);
+}
+
+void ResourceLoader::did_receive_data(const String& url_string, const ByteBuffer& data)
+{
+    auto& pending_download = *m_pending_downloads.find(url_string)->value;
+    pending_download.received_data.append(data.data(), data.size());
+    update_incremental_loads(pending_download);
+}
+
+void ResourceLoader::update_incremental_loads(PendingDownload& pending_download)
+{
+    // A revalidation may be answered with the cached copy, which we only know once the response is complete.
+    if (pending_download.is_revalidation || !pending_download.has_response_headers)
+        return;
+    // The callbacks may well load() something else, maybe even joining this download.
+    for (size_t i = 0; i < pending_download.incremental_loads.size(); ++i) {
+        auto incremental_load = pending_download.incremental_loads[i];
+        incremental_load->catch_up(pending_download.response_headers, pending_download.received_data);
+    }
+}
+
+void ResourceLoader::did_finish_download(const String& url_string, bool success, const HashMap<String, String, CaseInsensitiveStringTraits>& response_headers)
+{
+    auto it = m_pending_downloads.find(url_string);
+    ASSERT(it != m_pending_downloads.end());
+    auto pending_download = move(it->value);
+    m_pending_downloads.remove(it);
+    auto& url = pending_download->url;
+    auto payload = move(pending_download->received_data);
+
+    --m_pending_loads;
+    if (on_load_counter_change)
+        on_load_counter_change();
+    if (!success) {
+        for (auto& error_callback : pending_download->error_callbacks) {
+            if (error_callback)
+                error_callback("HTTP load failed");
+        }
+        return;
+    }
+
+    ByteBuffer data;
+    HashMap<String, String, CaseInsensitiveStringTraits> headers;
+
+    // FIXME: ProtocolServer doesn't tell us the status code, so we recognize a 304 Not Modified
+    //        by its empty body (and by it not naming some other ETag).
+    bool not_modified = false;
+    if (pending_download->is_revalidation && payload.is_empty()) {
+        auto etag = response_headers.get("ETag");
+        not_modified = !etag.has_value() || etag.value() == pending_download->cached_etag;
+    }
+
+    auto* cached_entry = not_modified ? m_cache.find(url) : nullptr;
+    if (cached_entry) {
+        ++m_cache.statistics().revalidated_hits;
+        data = ByteBuffer::copy(cached_entry->data.data(), cached_entry->data.size());
+        headers = cached_entry->response_headers;
+        m_cache.did_revalidate(url, response_headers);
+    } else {
+        if (ResourceCache::is_cacheable_url(url)) {
+            ++m_cache.statistics().misses;
+            m_cache.store(url, payload, response_headers);
+        }
+        data = ByteBuffer::copy(payload.data(), payload.size());
+        headers = response_headers;
+    }
+
+    if (pending_download->success_callbacks.is_empty()) {
+        // A prefetch that nobody has asked for yet. Hold on to it, even if the cache wouldn't.
+        static constexpr size_t max_prefetched_responses = 64;
+        if (m_prefetched_responses.size() >= max_prefetched_responses)
+            m_prefetched_responses.take_first();
+        m_prefetched_responses.append({ url_string, move(data), move(headers) });
+        return;
+    }
+
+    for (auto& success_callback : pending_download->success_callbacks)
+        success_callback(data, headers);
+}
+
 bool ResourceLoader::is_port_blocked(int port)
 {
     int ports[] { 1, 7, 9, 11, 13, 15, 17, 19, 20, 21, 22, 23, 25, 37, 42,
@@ -162,7 +418,23 @@ void ResourceLoader::save_to(JsonObject& object)
 {
     Object::save_to(object);
     object.set("pending_loads", m_pending_loads);
+    object.set("queued_downloads", m_queued_downloads.size());
+    object.set("prefetched_responses", m_prefetched_responses.size());
+    object.set("max_downloads_per_origin", m_max_downloads_per_origin);
     object.set("user_agent", m_user_agent);
+
+    auto& statistics = m_cache.statistics();
+    JsonObject cache;
+    cache.set("entries", m_cache.entry_count());
+    cache.set("memory_usage", m_cache.memory_usage());
+    cache.set("memory_budget", m_cache.memory_budget());
+    cache.set("disk_cache_directory", m_cache.disk_cache_directory());
+    cache.set("hits", statistics.hits);
+    cache.set("revalidated_hits", statistics.revalidated_hits);
+    cache.set("misses", statistics.misses);
+    cache.set("disk_hits", statistics.disk_hits);
+    cache.set("evictions", statistics.evictions);
+    object.set("cache", move(cache));
 }
 
 }
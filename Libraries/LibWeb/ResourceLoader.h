@@ -27,8 +27,11 @@
 #pragma once
 
 #include <AK/Function.h>
+#include <AK/OwnPtr.h>
+#include <AK/RefCounted.h>
 #include <AK/URL.h>
 #include <LibCore/Object.h>
+#include <LibWeb/ResourceCache.h>
 
 namespace Protocol {
 class Client;
@@ -44,6 +47,17 @@ public:
     void load(const URL&, Function<void(const ByteBuffer&, const HashMap<String, String, CaseInsensitiveStringTraits>& response_headers)> success_callback, Function<void(const String&)> error_callback = nullptr);
     void load_sync(const URL&, Function<void(const ByteBuffer&, const HashMap<String, String, CaseInsensitiveStringTraits>& response_headers)> success_callback, Function<void(const String&)> error_callback = nullptr);
 
+    // Like load(), but hands the response over as it arrives: first the headers, then the data piece by piece,
+    // and finally a call to finished_callback. Anything that doesn't come over the network is a single piece.
+    void load_incrementally(const URL&, Function<void(const HashMap<String, String, CaseInsensitiveStringTraits>& response_headers)> headers_callback, Function<void(const ByteBuffer&)> data_callback, Function<void()> finished_callback, Function<void(const String&)> error_callback = nullptr);
+
+    // Starts downloading something that will probably be load()ed soon, so that the response
+    // is already there (or on its way) by then.
+    void prefetch(const URL&);
+
+    size_t max_downloads_per_origin() const { return m_max_downloads_per_origin; }
+    void set_max_downloads_per_origin(size_t);
+
     Function<void()> on_load_counter_change;
 
     int pending_loads() const { return m_pending_loads; }
@@ -52,14 +66,65 @@ public:
 
     const String& user_agent() const { return m_user_agent; }
 
+    ResourceCache& cache() { return m_cache; }
+    const ResourceCache& cache() const { return m_cache; }
+
 private:
     ResourceLoader();
     static bool is_port_blocked(int port);
 
     virtual void save_to(JsonObject&) override;
 
+    // A load_incrementally(), keeping track of how much of the response it has been given.
+    struct IncrementalLoad : public RefCounted<IncrementalLoad> {
+        void catch_up(const HashMap<String, String, CaseInsensitiveStringTraits>& response_headers, const ByteBuffer& data);
+
+        Function<void(const HashMap<String, String, CaseInsensitiveStringTraits>& response_headers)> headers_callback;
+        Function<void(const ByteBuffer&)> data_callback;
+        bool has_received_headers { false };
+        size_t received_size { 0 };
+    };
+
+    struct PendingDownload {
+        URL url;
+        HashMap<String, String> request_headers;
+        bool is_revalidation { false };
+        String cached_etag;
+        Vector<Function<void(const ByteBuffer&, const HashMap<String, String, CaseInsensitiveStringTraits>& response_headers)>> success_callbacks;
+        Vector<Function<void(const String&)>> error_callbacks;
+        Vector<NonnullRefPtr<IncrementalLoad>> incremental_loads;
+        // What has arrived so far.
+        bool has_response_headers { false };
+        HashMap<String, String, CaseInsensitiveStringTraits> response_headers;
+        ByteBuffer received_data;
+    };
+    void start_load(const URL&, Function<void(const ByteBuffer&, const HashMap<String, String, CaseInsensitiveStringTraits>& response_headers)> success_callback, Function<void(const String&)> error_callback, RefPtr<IncrementalLoad>);
+    PendingDownload& create_pending_download(const URL&, const String& url_string);
+    void start_queued_downloads();
+    void start_download(const String& url_string, PendingDownload&);
+    void did_receive_response_headers(const String& url_string, const HashMap<String, String, CaseInsensitiveStringTraits>& response_headers);
+    void did_receive_data(const String& url_string, const ByteBuffer& data);
+    void update_incremental_loads(PendingDownload&);
+    void did_finish_download(const String& url_string, bool success, const HashMap<String, String, CaseInsensitiveStringTraits>& response_headers);
+
     int m_pending_loads { 0 };
 
+    // Keyed by URL. Downloads wait in m_queued_downloads until their origin has a free slot.
+    HashMap<String, OwnPtr<PendingDownload>> m_pending_downloads;
+    Vector<String> m_queued_downloads;
+    HashMap<String, size_t> m_active_downloads_per_origin;
+    size_t m_max_downloads_per_origin { 6 };
+
+    // Prefetched responses that nobody has asked for yet, oldest first.
+    struct PrefetchedResponse {
+        String url_string;
+        ByteBuffer data;
+        HashMap<String, String, CaseInsensitiveStringTraits> response_headers;
+    };
+    Vector<PrefetchedResponse> m_prefetched_responses;
+
+    ResourceCache m_cache;
+
     RefPtr<Protocol::Client> m_protocol_client;
     String m_user_agent;
 };
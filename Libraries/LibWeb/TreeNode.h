@@ -110,7 +110,7 @@ public:
 
     void prepend_child(NonnullRefPtr<T> node);
     void append_child(NonnullRefPtr<T> node, bool notify = true);
-    NonnullRefPtr<T> remove_child(NonnullRefPtr<T> node);
+    NonnullRefPtr<T> remove_child(NonnullRefPtr<T> node, bool notify = true);
     void donate_all_children_to(T& node);
 
     bool is_child_allowed(const T&) const { return true; }
@@ -200,7 +200,7 @@ private:
 };
 
 template<typename T>
-inline NonnullRefPtr<T> TreeNode<T>::remove_child(NonnullRefPtr<T> node)
+inline NonnullRefPtr<T> TreeNode<T>::remove_child(NonnullRefPtr<T> node, bool notify)
 {
     ASSERT(node->m_parent == this);
 
@@ -224,7 +224,8 @@ inline NonnullRefPtr<T> TreeNode<T>::remove_child(NonnullRefPtr<T> node)
 
     node->unref();
 
-    static_cast<T*>(this)->children_changed();
+    if (notify)
+        static_cast<T*>(this)->children_changed();
 
     return node;
 }
@@ -121,15 +121,12 @@ private:
         busy = 0;
         idle = 0;
 
-        auto all_processes = Core::ProcessStatisticsReader::get_all();
-
-        for (auto& it : all_processes) {
-            for (auto& jt : it.value.threads) {
-                if (it.value.pid == 0)
-                    idle += jt.times_scheduled;
-                else
-                    busy += jt.times_scheduled;
-            }
+        Vector<Core::ProcessorStatistics> processors;
+        Core::ProcessStatisticsReader::get_all(&processors);
+
+        for (auto& processor : processors) {
+            busy += processor.busy_ticks;
+            idle += processor.idle_ticks;
         }
     }
 
@@ -225,6 +222,11 @@ int main(int argc, char** argv)
         return 1;
     }
 
+    if (unveil("/proc/all.bin", "r") < 0) {
+        perror("unveil");
+        return 1;
+    }
+
     if (unveil("/proc/memstat", "r") < 0) {
         perror("unveil");
         return 1;
@@ -59,6 +59,8 @@ chmod 666 mnt/dev/random || true
 chmod 666 mnt/dev/null
 chmod 666 mnt/dev/zero
 chmod 666 mnt/dev/full
+mknod mnt/dev/memory_pressure c 1 12
+chmod 444 mnt/dev/memory_pressure
 mknod mnt/dev/keyboard c 85 1
 chmod 440 mnt/dev/keyboard
 chown 0:$phys_gid mnt/dev/keyboard
@@ -74,8 +76,18 @@ mknod mnt/dev/hda b 3 0
 mknod mnt/dev/hdb b 3 1
 mknod mnt/dev/hdc b 4 0
 mknod mnt/dev/hdd b 4 1
+mknod mnt/dev/sda b 8 0
+mknod mnt/dev/sdb b 8 1
+mknod mnt/dev/sdc b 8 2
+mknod mnt/dev/sdd b 8 3
+mknod mnt/dev/vda b 254 0
+mknod mnt/dev/vdb b 254 1
+mknod mnt/dev/vdc b 254 2
+mknod mnt/dev/vdd b 254 3
 for hd in a b c d; do
     chmod 600 mnt/dev/hd$hd
+    chmod 600 mnt/dev/sd$hd
+    chmod 600 mnt/dev/vd$hd
 done
 
 ln -s /proc/self/fd/0 mnt/dev/stdin
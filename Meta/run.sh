@@ -26,7 +26,7 @@ $SERENITY_EXTRA_QEMU_ARGS
 -device ich9-ahci
 -debugcon stdio
 -soundhw pcspk
--soundhw sb16
+-device AC97
 "
 
 [ -z "$SERENITY_COMMON_QEMU_Q35_ARGS" ] && SERENITY_COMMON_QEMU_Q35_ARGS="
@@ -42,7 +42,7 @@ $SERENITY_EXTRA_QEMU_ARGS
 -device ide-hd,bus=ide.6,drive=disk,unit=0
 -debugcon stdio
 -soundhw pcspk
--soundhw sb16
+-device AC97
 "
 
 export SDL_VIDEO_X11_DGAMOUSE=0
@@ -75,6 +75,16 @@ elif [ "$1" = "qgrub" ]; then
         $SERENITY_PACKET_LOGGING_ARG \
         -netdev user,id=breh,hostfwd=tcp:127.0.0.1:8888-10.0.2.15:8888,hostfwd=tcp:127.0.0.1:8823-10.0.2.15:23 \
         -device e1000,netdev=breh
+elif [ "$1" = "qvirtio" ]; then
+    # ./run qvirtio: qemu with the disk and network on virtio
+    $SERENITY_QEMU_BIN \
+        $(echo "$SERENITY_COMMON_QEMU_ARGS" | sed 's/^-hda _disk_image$//') \
+        $SERENITY_KVM_ARG \
+        -drive file=_disk_image,if=virtio \
+        -netdev user,id=breh,hostfwd=tcp:127.0.0.1:8888-10.0.2.15:8888,hostfwd=tcp:127.0.0.1:8823-10.0.2.15:23 \
+        -device virtio-net-pci,netdev=breh \
+        -kernel Kernel/Kernel \
+        -append "${SERENITY_KERNEL_CMDLINE} root=/dev/vda"
 elif [ "$1" = "q35_cmd" ]; then
     SERENITY_KERNEL_CMDLINE=""
     # FIXME: Someone who knows sh syntax better, please help:
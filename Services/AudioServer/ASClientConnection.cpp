@@ -28,7 +28,7 @@
 #include "ASMixer.h"
 #include <AK/SharedBuffer.h>
 #include <AudioServer/AudioClientEndpoint.h>
-#include <LibAudio/Buffer.h>
+#include <LibAudio/SampleRing.h>
 #include <LibCore/EventLoop.h>
 #include <errno.h>
 #include <stdio.h>
@@ -64,9 +64,9 @@ void ASClientConnection::die()
     s_connections.remove(client_id());
 }
 
-void ASClientConnection::did_finish_playing_buffer(Badge<ASBufferQueue>, int buffer_id)
+void ASClientConnection::did_make_room_in_ring(Badge<ASBufferQueue>)
 {
-    post_message(Messages::AudioClient::FinishedPlayingBuffer(buffer_id));
+    post_message(Messages::AudioClient::SampleRingHasSpace());
 }
 
 void ASClientConnection::did_change_muted_state(Badge<ASMixer>, bool muted)
@@ -90,47 +90,27 @@ OwnPtr<Messages::AudioServer::SetMainMixVolumeResponse> ASClientConnection::hand
     return make<Messages::AudioServer::SetMainMixVolumeResponse>();
 }
 
-OwnPtr<Messages::AudioServer::EnqueueBufferResponse> ASClientConnection::handle(const Messages::AudioServer::EnqueueBuffer& message)
+OwnPtr<Messages::AudioServer::GetSampleRingResponse> ASClientConnection::handle(const Messages::AudioServer::GetSampleRing&)
 {
-    auto shared_buffer = SharedBuffer::create_from_shbuf_id(message.buffer_id());
-    if (!shared_buffer) {
-        // FIXME: The shared buffer should have been retrieved for us already.
-        //        We don't want to do IPC error checking at this layer.
-        ASSERT_NOT_REACHED();
-    }
-
     if (!m_queue)
         m_queue = m_mixer.create_queue(*this);
-
-    if (m_queue->is_full())
-        return make<Messages::AudioServer::EnqueueBufferResponse>(false);
-
-    m_queue->enqueue(Audio::Buffer::create_with_shared_buffer(*shared_buffer, message.sample_count()));
-    return make<Messages::AudioServer::EnqueueBufferResponse>(true);
+    if (!m_queue || !m_queue->ring().shared_buffer().share_with(client_pid()))
+        return make<Messages::AudioServer::GetSampleRingResponse>(-1, 0);
+    return make<Messages::AudioServer::GetSampleRingResponse>(m_queue->ring().shbuf_id(), m_queue->ring().capacity());
 }
 
-OwnPtr<Messages::AudioServer::GetRemainingSamplesResponse> ASClientConnection::handle(const Messages::AudioServer::GetRemainingSamples&)
+void ASClientConnection::handle(const Messages::AudioServer::SamplesAvailable&)
 {
-    int remaining = 0;
-    if (m_queue)
-        remaining = m_queue->get_remaining_samples();
-
-    return make<Messages::AudioServer::GetRemainingSamplesResponse>(remaining);
-}
-
-OwnPtr<Messages::AudioServer::GetPlayedSamplesResponse> ASClientConnection::handle(const Messages::AudioServer::GetPlayedSamples&)
-{
-    int played = 0;
-    if (m_queue)
-        played = m_queue->get_played_samples();
-
-    return make<Messages::AudioServer::GetPlayedSamplesResponse>(played);
+    m_mixer.did_get_samples_to_mix();
 }
 
 OwnPtr<Messages::AudioServer::SetPausedResponse> ASClientConnection::handle(const Messages::AudioServer::SetPaused& message)
 {
-    if (m_queue)
+    if (m_queue) {
         m_queue->set_paused(message.paused());
+        if (!message.paused())
+            m_mixer.did_get_samples_to_mix();
+    }
     return make<Messages::AudioServer::SetPausedResponse>();
 }
 
@@ -141,12 +121,12 @@ OwnPtr<Messages::AudioServer::ClearBufferResponse> ASClientConnection::handle(co
     return make<Messages::AudioServer::ClearBufferResponse>();
 }
 
-OwnPtr<Messages::AudioServer::GetPlayingBufferResponse> ASClientConnection::handle(const Messages::AudioServer::GetPlayingBuffer&)
+OwnPtr<Messages::AudioServer::GetUnderrunCountResponse> ASClientConnection::handle(const Messages::AudioServer::GetUnderrunCount&)
 {
-    int id = -1;
+    int count = 0;
     if (m_queue)
-        id = m_queue->get_playing_buffer();
-    return make<Messages::AudioServer::GetPlayingBufferResponse>(id);
+        count = m_queue->get_underrun_count();
+    return make<Messages::AudioServer::GetUnderrunCountResponse>(count);
 }
 
 OwnPtr<Messages::AudioServer::GetMutedResponse> ASClientConnection::handle(const Messages::AudioServer::GetMuted&)
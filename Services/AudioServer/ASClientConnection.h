@@ -44,7 +44,7 @@ public:
     explicit ASClientConnection(Core::LocalSocket&, int client_id, ASMixer& mixer);
     ~ASClientConnection() override;
 
-    void did_finish_playing_buffer(Badge<ASBufferQueue>, int buffer_id);
+    void did_make_room_in_ring(Badge<ASBufferQueue>);
     void did_change_muted_state(Badge<ASMixer>, bool muted);
 
     virtual void die() override;
@@ -55,12 +55,11 @@ private:
     virtual OwnPtr<Messages::AudioServer::GreetResponse> handle(const Messages::AudioServer::Greet&) override;
     virtual OwnPtr<Messages::AudioServer::GetMainMixVolumeResponse> handle(const Messages::AudioServer::GetMainMixVolume&) override;
     virtual OwnPtr<Messages::AudioServer::SetMainMixVolumeResponse> handle(const Messages::AudioServer::SetMainMixVolume&) override;
-    virtual OwnPtr<Messages::AudioServer::EnqueueBufferResponse> handle(const Messages::AudioServer::EnqueueBuffer&) override;
-    virtual OwnPtr<Messages::AudioServer::GetRemainingSamplesResponse> handle(const Messages::AudioServer::GetRemainingSamples&) override;
-    virtual OwnPtr<Messages::AudioServer::GetPlayedSamplesResponse> handle(const Messages::AudioServer::GetPlayedSamples&) override;
+    virtual OwnPtr<Messages::AudioServer::GetSampleRingResponse> handle(const Messages::AudioServer::GetSampleRing&) override;
+    virtual void handle(const Messages::AudioServer::SamplesAvailable&) override;
     virtual OwnPtr<Messages::AudioServer::SetPausedResponse> handle(const Messages::AudioServer::SetPaused&) override;
     virtual OwnPtr<Messages::AudioServer::ClearBufferResponse> handle(const Messages::AudioServer::ClearBuffer&) override;
-    virtual OwnPtr<Messages::AudioServer::GetPlayingBufferResponse> handle(const Messages::AudioServer::GetPlayingBuffer&) override;
+    virtual OwnPtr<Messages::AudioServer::GetUnderrunCountResponse> handle(const Messages::AudioServer::GetUnderrunCount&) override;
     virtual OwnPtr<Messages::AudioServer::GetMutedResponse> handle(const Messages::AudioServer::GetMuted&) override;
     virtual OwnPtr<Messages::AudioServer::SetMutedResponse> handle(const Messages::AudioServer::SetMuted&) override;
 
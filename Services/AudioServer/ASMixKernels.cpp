@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2018-2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <AK/NumericLimits.h>
+#include <AudioServer/ASMixKernels.h>
+
+#if ARCH(I386)
+#    include <emmintrin.h>
+#endif
+
+namespace ASMixKernels {
+
+void mix_frames_generic(float* dst, const Audio::Sample* src, size_t frame_count)
+{
+    for (size_t i = 0; i < frame_count; ++i) {
+        dst[2 * i] += (float)src[i].left;
+        dst[2 * i + 1] += (float)src[i].right;
+    }
+}
+
+void convert_to_pcm16_generic(i16* dst, const float* src, size_t sample_count, float gain)
+{
+    for (size_t i = 0; i < sample_count; ++i) {
+        float sample = src[i] * gain;
+        if (sample > 1)
+            sample = 1;
+        else if (sample < -1)
+            sample = -1;
+        dst[i] = (i16)(sample * NumericLimits<i16>::max());
+    }
+}
+
+#if ARCH(I386)
+bool cpu_supports_sse2()
+{
+    static int s_supported = -1;
+    if (s_supported < 0) {
+        u32 eax = 1, ebx, ecx = 0, edx;
+        asm volatile("cpuid"
+                     : "+a"(eax), "=b"(ebx), "+c"(ecx), "=d"(edx));
+        s_supported = (edx & (1 << 26)) ? 1 : 0;
+    }
+    return s_supported;
+}
+
+[[gnu::target("sse2")]] void mix_frames_sse2(float* dst, const Audio::Sample* src, size_t frame_count)
+{
+    static_assert(sizeof(Audio::Sample) == 2 * sizeof(double));
+    size_t i = 0;
+    for (; i + 2 <= frame_count; i += 2) {
+        __m128 first = _mm_cvtpd_ps(_mm_loadu_pd(&src[i].left));
+        __m128 second = _mm_cvtpd_ps(_mm_loadu_pd(&src[i + 1].left));
+        __m128 mix = _mm_loadu_ps(dst + 2 * i);
+        _mm_storeu_ps(dst + 2 * i, _mm_add_ps(mix, _mm_movelh_ps(first, second)));
+    }
+    mix_frames_generic(dst + 2 * i, src + i, frame_count - i);
+}
+
+[[gnu::target("sse2")]] ALWAYS_INLINE static __m128i pcm16_from_float(__m128 samples, __m128 gain)
+{
+    samples = _mm_min_ps(_mm_max_ps(_mm_mul_ps(samples, gain), _mm_set1_ps(-1)), _mm_set1_ps(1));
+    // Truncates like the cast in the generic variant does.
+    return _mm_cvttps_epi32(_mm_mul_ps(samples, _mm_set1_ps(NumericLimits<i16>::max())));
+}
+
+[[gnu::target("sse2")]] void convert_to_pcm16_sse2(i16* dst, const float* src, size_t sample_count, float gain)
+{
+    const __m128 gain4 = _mm_set1_ps(gain);
+    size_t i = 0;
+    for (; i + 8 <= sample_count; i += 8) {
+        __m128i first = pcm16_from_float(_mm_loadu_ps(src + i), gain4);
+        __m128i second = pcm16_from_float(_mm_loadu_ps(src + i + 4), gain4);
+        // Everything is in range after clipping, so the saturation is a no-op.
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_packs_epi32(first, second));
+    }
+    convert_to_pcm16_generic(dst + i, src + i, sample_count - i, gain);
+}
+#endif
+
+}
+
+void mix_frames(float* dst, const Audio::Sample* src, size_t frame_count)
+{
+#if ARCH(I386)
+    if (ASMixKernels::cpu_supports_sse2())
+        return ASMixKernels::mix_frames_sse2(dst, src, frame_count);
+#endif
+    ASMixKernels::mix_frames_generic(dst, src, frame_count);
+}
+
+void convert_to_pcm16(i16* dst, const float* src, size_t sample_count, float gain)
+{
+#if ARCH(I386)
+    if (ASMixKernels::cpu_supports_sse2())
+        return ASMixKernels::convert_to_pcm16_sse2(dst, src, sample_count, gain);
+#endif
+    ASMixKernels::convert_to_pcm16_generic(dst, src, sample_count, gain);
+}
@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2018-2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#pragma once
+
+#include <AK/Platform.h>
+#include <AK/Types.h>
+#include <LibAudio/Buffer.h>
+
+// Inner loops of ASMixer. The mix is accumulated in 32-bit floats, with the left and right channels
+// interleaved, which halves the memory traffic of mixing in Audio::Sample's doubles and lets SSE2
+// work on two frames at a time.
+
+// Adds `frame_count` frames from `src` to the mix in `dst`, which holds twice as many floats.
+void mix_frames(float* dst, const Audio::Sample* src, size_t frame_count);
+
+// Scales `sample_count` floats from `src` by `gain`, clips them to [-1, 1] and converts them to 16-bit PCM.
+void convert_to_pcm16(i16* dst, const float* src, size_t sample_count, float gain);
+
+// Both variants are exported under their own names, so that they can be compared.
+namespace ASMixKernels {
+
+void mix_frames_generic(float* dst, const Audio::Sample* src, size_t frame_count);
+void convert_to_pcm16_generic(i16* dst, const float* src, size_t sample_count, float gain);
+
+#if ARCH(I386)
+bool cpu_supports_sse2();
+void mix_frames_sse2(float* dst, const Audio::Sample* src, size_t frame_count);
+void convert_to_pcm16_sse2(i16* dst, const float* src, size_t sample_count, float gain);
+#endif
+
+}
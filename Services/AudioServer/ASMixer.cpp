@@ -24,11 +24,14 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
-#include <AK/BufferStream.h>
-#include <AK/NumericLimits.h>
+#include <AK/Vector.h>
 #include <AudioServer/ASClientConnection.h>
+#include <AudioServer/ASMixKernels.h>
 #include <AudioServer/ASMixer.h>
+#include <LibCore/ConfigFile.h>
 #include <pthread.h>
+#include <sched.h>
+#include <string.h>
 
 ASMixer::ASMixer()
     : m_device(Core::File::construct("/dev/audio", this))
@@ -44,21 +47,41 @@ ASMixer::ASMixer()
         return;
     }
 
+    auto config = Core::ConfigFile::get_for_system("AudioServer");
+    m_period_frames = clamp(config->read_num_entry("Mixer", "PeriodFrames", default_period_frames), min_period_frames, max_period_frames);
+    m_buffer_frames = max(config->read_num_entry("Mixer", "BufferFrames", default_buffer_frames), m_period_frames);
+
     pthread_mutex_init(&m_pending_mutex, nullptr);
     pthread_cond_init(&m_pending_cond, nullptr);
 
-    m_zero_filled_buffer = (u8*)malloc(4096);
-    bzero(m_zero_filled_buffer, 4096);
+    m_zero_filled_buffer = (u8*)malloc(m_period_frames * 2 * sizeof(i16));
+    bzero(m_zero_filled_buffer, m_period_frames * 2 * sizeof(i16));
     m_sound_thread.start();
+
+    // A late period is an audible click, so the mixer runs ahead of everything else, including the rest of
+    // AudioServer. It steps up from the real-time class we were started with, if any.
+    struct sched_param param;
+    if (sched_getscheduler(0) == SCHED_RR && sched_getparam(0, &param) == 0) {
+        param.sched_group_weight = 0;
+        int rc = pthread_setschedparam(m_sound_thread.tid(), SCHED_FIFO, &param);
+        if (rc != 0)
+            dbg() << "AudioServer: Can't make the mixer thread real-time: " << strerror(rc);
+    }
 }
 
 ASMixer::~ASMixer()
 {
 }
 
-NonnullRefPtr<ASBufferQueue> ASMixer::create_queue(ASClientConnection& client)
+RefPtr<ASBufferQueue> ASMixer::create_queue(ASClientConnection& client)
 {
-    auto queue = adopt(*new ASBufferQueue(client));
+    u32 capacity = 1;
+    while (capacity < (u32)m_buffer_frames)
+        capacity *= 2;
+    auto ring = Audio::SampleRing::create(capacity);
+    if (!ring)
+        return nullptr;
+    auto queue = adopt(*new ASBufferQueue(client, ring.release_nonnull()));
     pthread_mutex_lock(&m_pending_mutex);
     m_pending_mixing.append(*queue);
     pthread_cond_signal(&m_pending_cond);
@@ -66,67 +89,61 @@ NonnullRefPtr<ASBufferQueue> ASMixer::create_queue(ASClientConnection& client)
     return queue;
 }
 
+void ASMixer::did_get_samples_to_mix()
+{
+    pthread_mutex_lock(&m_pending_mutex);
+    m_has_new_samples = true;
+    pthread_cond_signal(&m_pending_cond);
+    pthread_mutex_unlock(&m_pending_mutex);
+}
+
 void ASMixer::mix()
 {
     decltype(m_pending_mixing) active_mix_queues;
 
+    Vector<float> mixed_buffer;
+    mixed_buffer.resize(m_period_frames * 2);
+    Vector<i16> output_buffer;
+    output_buffer.resize(m_period_frames * 2);
+
     for (;;) {
-        if (active_mix_queues.is_empty()) {
+        pthread_mutex_lock(&m_pending_mutex);
+        active_mix_queues.append(move(m_pending_mixing));
+        m_has_new_samples = false;
+        pthread_mutex_unlock(&m_pending_mutex);
+
+        active_mix_queues.remove_all_matching([&](auto& entry) {
+            if (entry->client())
+                return false;
+            entry->clear();
+            return true;
+        });
+
+        // Rather than feed the device silence, sleep until there's something to play. It then starts right away,
+        // instead of after the period of silence that would be playing.
+        bool has_samples_to_mix = false;
+        for (auto& queue : active_mix_queues)
+            has_samples_to_mix |= queue->has_samples_to_mix();
+        if (!has_samples_to_mix) {
             pthread_mutex_lock(&m_pending_mutex);
-            pthread_cond_wait(&m_pending_cond, &m_pending_mutex);
-            active_mix_queues.append(move(m_pending_mixing));
+            while (!m_has_new_samples && m_pending_mixing.is_empty())
+                pthread_cond_wait(&m_pending_cond, &m_pending_mutex);
             pthread_mutex_unlock(&m_pending_mutex);
+            continue;
         }
 
-        active_mix_queues.remove_all_matching([&](auto& entry) { return !entry->client(); });
-
-        Audio::Sample mixed_buffer[1024];
-        auto mixed_buffer_length = (int)(sizeof(mixed_buffer) / sizeof(Audio::Sample));
-
         // Mix the buffers together into the output
-        for (auto& queue : active_mix_queues) {
-            if (!queue->client()) {
-                queue->clear();
-                continue;
-            }
-
-            for (int i = 0; i < mixed_buffer_length; ++i) {
-                auto& mixed_sample = mixed_buffer[i];
-                Audio::Sample sample;
-                if (!queue->get_next_sample(sample))
-                    break;
-                mixed_sample += sample;
-            }
-        }
-
-        bool muted = m_muted;
+        memset(mixed_buffer.data(), 0, mixed_buffer.size() * sizeof(float));
+        for (auto& queue : active_mix_queues)
+            queue->mix_into(mixed_buffer.data(), m_period_frames);
 
         // output the mixed stuff to the device
-        u8 raw_buffer[4096];
-        auto buffer = ByteBuffer::wrap(muted ? m_zero_filled_buffer : raw_buffer, sizeof(raw_buffer));
-
-        BufferStream stream(buffer);
-        if (!muted) {
-            for (int i = 0; i < mixed_buffer_length; ++i) {
-                auto& mixed_sample = mixed_buffer[i];
-
-                mixed_sample.scale(m_main_volume);
-                mixed_sample.clip();
-
-                i16 out_sample;
-                out_sample = mixed_sample.left * NumericLimits<i16>::max();
-                stream << out_sample;
-
-                ASSERT(!stream.at_end()); // we should have enough space for both channels in one buffer!
-                out_sample = mixed_sample.right * NumericLimits<i16>::max();
-                stream << out_sample;
-            }
+        const u8* output = m_zero_filled_buffer;
+        if (!m_muted) {
+            convert_to_pcm16(output_buffer.data(), mixed_buffer.data(), mixed_buffer.size(), m_main_volume / 100.0f);
+            output = (const u8*)output_buffer.data();
         }
-
-        if (stream.offset() != 0) {
-            buffer.trim(stream.offset());
-        }
-        m_device->write(buffer);
+        m_device->write(output, m_period_frames * 2 * sizeof(i16));
     }
 }
 
@@ -140,13 +157,55 @@ void ASMixer::set_muted(bool muted)
     });
 }
 
-ASBufferQueue::ASBufferQueue(ASClientConnection& client)
-    : m_client(client.make_weak_ptr())
+ASBufferQueue::ASBufferQueue(ASClientConnection& client, NonnullRefPtr<Audio::SampleRing>&& ring)
+    : m_ring(move(ring))
+    , m_client(client.make_weak_ptr())
+{
+}
+
+int ASBufferQueue::mix_into(float* mix, int frame_count)
+{
+    LibThread::Locker locker(m_lock);
+    if (m_paused)
+        return 0;
+
+    if (m_is_starved && m_ring->available_to_read()) {
+        ++m_underrun_count;
+        m_is_starved = false;
+    }
+
+    int mixed_frames = m_ring->read(frame_count, [&](const Audio::Sample* samples, u32 count) {
+        mix_frames(mix, samples, count);
+        mix += 2 * count;
+    });
+
+    if (mixed_frames)
+        m_has_played = true;
+    if (m_has_played && mixed_frames < frame_count)
+        m_is_starved = true;
+
+    if (m_ring->should_wake_writer() && m_client)
+        m_client->did_make_room_in_ring({});
+    return mixed_frames;
+}
+
+bool ASBufferQueue::has_samples_to_mix() const
+{
+    LibThread::Locker locker(m_lock);
+    return !m_paused && m_ring->available_to_read();
+}
+
+void ASBufferQueue::clear(bool paused)
 {
+    LibThread::Locker locker(m_lock);
+    m_ring->discard();
+    m_paused = paused;
+    m_has_played = false;
+    m_is_starved = false;
 }
 
-void ASBufferQueue::enqueue(NonnullRefPtr<Audio::Buffer>&& buffer)
+void ASBufferQueue::set_paused(bool paused)
 {
-    m_remaining_samples += buffer->sample_count();
-    m_queue.enqueue(move(buffer));
+    LibThread::Locker locker(m_lock);
+    m_paused = paused;
 }
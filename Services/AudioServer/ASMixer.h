@@ -28,92 +28,60 @@
 
 #include "ASClientConnection.h"
 #include <AK/Badge.h>
-#include <AK/ByteBuffer.h>
 #include <AK/NonnullRefPtrVector.h>
-#include <AK/Queue.h>
 #include <AK/RefCounted.h>
 #include <AK/WeakPtr.h>
-#include <LibAudio/Buffer.h>
+#include <LibAudio/SampleRing.h>
 #include <LibCore/File.h>
 #include <LibThread/Lock.h>
 #include <LibThread/Thread.h>
 
 class ASClientConnection;
 
+// A client's samples, which it writes into a ring shared with us.
 class ASBufferQueue : public RefCounted<ASBufferQueue> {
 public:
-    explicit ASBufferQueue(ASClientConnection&);
+    ASBufferQueue(ASClientConnection&, NonnullRefPtr<Audio::SampleRing>&&);
     ~ASBufferQueue() {}
 
-    bool is_full() const { return m_queue.size() >= 3; }
-    void enqueue(NonnullRefPtr<Audio::Buffer>&&);
+    Audio::SampleRing& ring() { return *m_ring; }
 
-    bool get_next_sample(Audio::Sample& sample)
-    {
-        if (m_paused)
-            return false;
-
-        while (!m_current && !m_queue.is_empty())
-            m_current = m_queue.dequeue();
-
-        if (!m_current)
-            return false;
-
-        sample = m_current->samples()[m_position++];
-        --m_remaining_samples;
-        ++m_played_samples;
-
-        if (m_position >= m_current->sample_count()) {
-            m_client->did_finish_playing_buffer({}, m_current->shbuf_id());
-            m_current = nullptr;
-            m_position = 0;
-        }
-        return true;
-    }
+    // Adds up to `frame_count` frames to the mix, and returns how many there were.
+    int mix_into(float* mix, int frame_count);
+    bool has_samples_to_mix() const;
 
     ASClientConnection* client() { return m_client.ptr(); }
 
-    void clear(bool paused = false)
-    {
-        m_queue.clear();
-        m_position = 0;
-        m_remaining_samples = 0;
-        m_played_samples = 0;
-        m_current = nullptr;
-        m_paused = paused;
-    }
-
-    void set_paused(bool paused)
-    {
-        m_paused = paused;
-    }
-
-    int get_remaining_samples() const { return m_remaining_samples; }
-    int get_played_samples() const { return m_played_samples; }
-    int get_playing_buffer() const
-    {
-        if (m_current)
-            return m_current->shbuf_id();
-        return -1;
-    }
+    void clear(bool paused = false);
+    void set_paused(bool paused);
+
+    int get_underrun_count() const { return m_underrun_count; }
 
 private:
-    RefPtr<Audio::Buffer> m_current;
-    Queue<NonnullRefPtr<Audio::Buffer>> m_queue;
-    int m_position { 0 };
-    int m_remaining_samples { 0 };
-    int m_played_samples { 0 };
+    NonnullRefPtr<Audio::SampleRing> m_ring;
     bool m_paused { false };
+    bool m_has_played { false };
+    // Set when we ran out of samples mid-stream. If the client has more after all, it wasn't fast enough.
+    bool m_is_starved { false };
+    int m_underrun_count { 0 };
     WeakPtr<ASClientConnection> m_client;
+    // The main thread clears and pauses the queue, while the mixer's reads from it.
+    mutable LibThread::Lock m_lock;
 };
 
 class ASMixer : public Core::Object {
     C_OBJECT(ASMixer)
 public:
+    static constexpr int default_period_frames = 256;
+    static constexpr int default_buffer_frames = 2048;
+    // The device takes at most a page per write.
+    static constexpr int max_period_frames = 1024;
+    static constexpr int min_period_frames = 32;
+
     ASMixer();
     virtual ~ASMixer() override;
 
-    NonnullRefPtr<ASBufferQueue> create_queue(ASClientConnection&);
+    RefPtr<ASBufferQueue> create_queue(ASClientConnection&);
 
     int main_volume() const { return m_main_volume; }
     void set_main_volume(int volume) { m_main_volume = volume; }
@@ -121,8 +89,12 @@ public:
     bool is_muted() const { return m_muted; }
     void set_muted(bool);
 
+    // Wakes the mixer if it's idle, after a queue got something to play.
+    void did_get_samples_to_mix();
+
 private:
     Vector<NonnullRefPtr<ASBufferQueue>> m_pending_mixing;
+    bool m_has_new_samples { false };
     pthread_mutex_t m_pending_mutex;
     pthread_cond_t m_pending_cond;
 
@@ -133,6 +105,10 @@ private:
     bool m_muted { false };
     int m_main_volume { 100 };
 
+    // How many frames go to the device at a time, and how many a client may have queued up (its ring's capacity).
+    int m_period_frames { default_period_frames };
+    int m_buffer_frames { default_buffer_frames };
+
     u8* m_zero_filled_buffer { nullptr };
 
     void mix();
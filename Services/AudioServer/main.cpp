@@ -27,10 +27,11 @@
 #include "ASMixer.h"
 #include <LibCore/File.h>
 #include <LibCore/LocalServer.h>
+#include <sched.h>
 
 int main(int, char**)
 {
-    if (pledge("stdio thread shared_buffer accept rpath wpath cpath unix fattr", nullptr) < 0) {
+    if (pledge("stdio thread shared_buffer accept rpath wpath cpath unix fattr proc", nullptr) < 0) {
         perror("pledge");
         return 1;
     }
@@ -38,6 +39,14 @@ int main(int, char**)
     Core::EventLoop event_loop;
     ASMixer mixer;
 
+    // Handling requests can wait, so let the mixer thread preempt us.
+    struct sched_param param;
+    if (sched_getscheduler(0) == SCHED_RR && sched_getparam(0, &param) == 0 && param.sched_priority > 1) {
+        param.sched_priority -= 1;
+        param.sched_group_weight = 0;
+        sched_setscheduler(0, SCHED_RR, &param);
+    }
+
     auto server = Core::LocalServer::construct();
     bool ok = server->take_over_from_system_server();
     ASSERT(ok);
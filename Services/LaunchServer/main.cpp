@@ -45,7 +45,7 @@ int main(int argc, char** argv)
     launcher.load_handlers("/res/apps");
     launcher.load_config(Core::ConfigFile::get_for_app("LaunchServer"));
 
-    if (pledge("stdio accept rpath proc exec", nullptr) < 0) {
+    if (pledge("stdio shared_buffer accept rpath proc exec", nullptr) < 0) {
         perror("pledge");
         return 1;
     }
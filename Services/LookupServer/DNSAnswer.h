@@ -40,6 +40,7 @@ public:
     const String& record_data() const { return m_record_data; }
 
     bool has_expired() const;
+    u32 remaining_ttl() const;
 
 private:
     String m_name;
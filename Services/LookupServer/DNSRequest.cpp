@@ -32,8 +32,6 @@
 #include <ctype.h>
 #include <stdlib.h>
 
-#define C_IN 1
-
 DNSRequest::DNSRequest()
     : m_id(arc4random_uniform(UINT16_MAX))
 {
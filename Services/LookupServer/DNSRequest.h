@@ -37,6 +37,8 @@
 #define T_PTR 12
 #define T_MX 15
 
+#define C_IN 1
+
 enum class ShouldRandomizeCase {
     No = 0,
     Yes
@@ -72,13 +72,16 @@ Optional<DNSResponse> DNSResponse::from_raw_response(const u8* raw_data, size_t
     response.m_id = response_header.id();
     response.m_code = response_header.response_code();
 
-    if (response.code() != DNSResponse::Code::NOERROR)
+    // A name that doesn't exist still comes with an authority section saying for how long.
+    if (response.code() != DNSResponse::Code::NOERROR && response.code() != DNSResponse::Code::NXDOMAIN)
         return response;
 
     size_t offset = sizeof(DNSPacket);
 
     for (u16 i = 0; i < response_header.question_count(); ++i) {
         auto name = parse_dns_name(raw_data, offset, raw_size);
+        if (offset + 4 > raw_size)
+            return {};
         struct RawDNSAnswerQuestion {
             NetworkOrdered<u16> record_type;
             NetworkOrdered<u16> class_code;
@@ -92,12 +95,16 @@ Optional<DNSResponse> DNSResponse::from_raw_response(const u8* raw_data, size_t
 
     for (u16 i = 0; i < response_header.answer_count(); ++i) {
         auto name = parse_dns_name(raw_data, offset, raw_size);
+        if (offset + sizeof(DNSRecordWithoutName) > raw_size)
+            return {};
 
         auto& record = *(const DNSRecordWithoutName*)(&raw_data[offset]);
 
         String data;
 
         offset += sizeof(DNSRecordWithoutName);
+        if (offset + record.data_length() > raw_size)
+            return {};
         if (record.type() == T_PTR) {
             size_t dummy_offset = offset;
             data = parse_dns_name(raw_data, dummy_offset, raw_size);
@@ -113,6 +120,29 @@ Optional<DNSResponse> DNSResponse::from_raw_response(const u8* raw_data, size_t
         offset += record.data_length();
     }
 
+    for (u16 i = 0; i < response_header.authority_count(); ++i) {
+        parse_dns_name(raw_data, offset, raw_size);
+        if (offset + sizeof(DNSRecordWithoutName) > raw_size)
+            return {};
+        auto& record = *(const DNSRecordWithoutName*)(&raw_data[offset]);
+        offset += sizeof(DNSRecordWithoutName);
+        size_t end_of_data = offset + record.data_length();
+        if (end_of_data > raw_size)
+            return {};
+        if (record.type() == T_SOA) {
+            // The primary nameserver and the responsible mailbox come first, then serial, refresh, retry, expire
+            // and finally the minimum, which is what negative answers are cached for.
+            size_t soa_offset = offset;
+            parse_dns_name(raw_data, soa_offset, end_of_data);
+            parse_dns_name(raw_data, soa_offset, end_of_data);
+            if (soa_offset + 5 * sizeof(u32) <= end_of_data) {
+                u32 minimum = *(const NetworkOrdered<u32>*)(&raw_data[soa_offset + 4 * sizeof(u32)]);
+                response.m_negative_ttl = min(record.ttl(), minimum);
+            }
+        }
+        offset = end_of_data;
+    }
+
     return response;
 }
 
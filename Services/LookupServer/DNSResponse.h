@@ -67,6 +67,9 @@ public:
 
     Code code() const { return (Code)m_code; }
 
+    // How long it may be remembered that there's no answer, from the SOA record in the authority section (RFC 2308).
+    Optional<u32> negative_ttl() const { return m_negative_ttl; }
+
 private:
     DNSResponse() { }
 
@@ -74,4 +77,5 @@ private:
     u8 m_code { 0 };
     Vector<DNSQuestion> m_questions;
     Vector<DNSAnswer> m_answers;
+    Optional<u32> m_negative_ttl;
 };
@@ -28,6 +28,7 @@
 #include "DNSRequest.h"
 #include "DNSResponse.h"
 #include <AK/HashMap.h>
+#include <AK/NumericLimits.h>
 #include <AK/String.h>
 #include <AK/StringBuilder.h>
 #include <LibCore/ConfigFile.h>
@@ -37,23 +38,41 @@
 #include <LibCore/LocalSocket.h>
 #include <LibCore/UDPSocket.h>
 #include <stdio.h>
+#include <time.h>
 #include <unistd.h>
 
+// Entries from /etc/hosts never change while we're running, but clients should still check back now and then.
+static constexpr u32 etc_hosts_ttl = 3600;
+
 LookupServer::LookupServer()
 {
     auto config = Core::ConfigFile::get_for_system("LookupServer");
     dbg() << "Using network config file at " << config->file_name();
-    m_nameserver = config->read_entry("DNS", "Nameserver", "1.1.1.1");
+    // Several nameservers can be given, separated by commas. Every lookup is sent to all of them.
+    for (auto& nameserver : config->read_entry("DNS", "Nameserver", "1.1.1.1").split(',')) {
+        auto address = IPv4Address::from_string(nameserver.trim_whitespace());
+        if (!address.has_value()) {
+            dbg() << "LookupServer: Ignoring invalid nameserver '" << nameserver << "'";
+            continue;
+        }
+        m_nameservers.append(address.value());
+    }
 
     load_etc_hosts();
 
     m_local_server = Core::LocalServer::construct(this);
     m_local_server->on_ready_to_accept = [this]() {
         auto socket = m_local_server->accept();
-        socket->on_ready_to_read = [this, socket]() {
-            service_client(socket);
-            RefPtr<Core::LocalSocket> keeper = socket;
-            const_cast<Core::LocalSocket&>(*socket).on_ready_to_read = [] {};
+        if (!socket)
+            return;
+        auto client = adopt(*new Client(socket.release_nonnull()));
+        client->socket->on_ready_to_read = [this, client = client.ptr(), protector = client]() {
+            // Clients keep their connection open across lookups, so only let go once they hang up.
+            if (service_client(*client))
+                return;
+            client->has_hung_up = true;
+            RefPtr<Client> keeper = client;
+            client->socket->on_ready_to_read = [] {};
         };
     };
     bool ok = m_local_server->take_over_from_system_server();
@@ -96,164 +115,322 @@ void LookupServer::load_etc_hosts()
     }
 }
 
-void LookupServer::service_client(RefPtr<Core::LocalSocket> socket)
+// Each request is a line of the form "L<hostname>" or "R<reverse name>". The reply is one
+// "<record data> <ttl>" line per answer, or "Not found." or "Timed out.", followed by an
+// empty line so that clients can send further requests over the same connection.
+// A request of just "S" is answered with "<name> <value>" lines of cache statistics.
+bool LookupServer::service_client(Client& client)
 {
     u8 client_buffer[1024];
-    int nrecv = socket->read(client_buffer, sizeof(client_buffer) - 1);
+    int nrecv = client.socket->read(client_buffer, sizeof(client_buffer) - 1);
     if (nrecv < 0) {
         perror("read");
-        return;
+        return false;
     }
+    if (nrecv == 0)
+        return false;
+
+    auto requests = StringView((const char*)client_buffer, nrecv).lines();
+    for (auto& request : requests) {
+        if (!request.is_empty())
+            service_request(client, request);
+    }
+    return true;
+}
+
+static String format_reply(const Vector<DNSAnswer>& answers)
+{
+    if (answers.is_empty())
+        return "Not found.\n\n";
+    StringBuilder builder;
+    for (auto& answer : answers)
+        builder.appendf("%s %u\n", answer.record_data().characters(), answer.remaining_ttl());
+    builder.append('\n');
+    return builder.to_string();
+}
 
-    client_buffer[nrecv] = '\0';
+void LookupServer::service_request(Client& client, const StringView& request)
+{
+    size_t reply_id = client.first_pending_reply_id + client.pending_replies.size();
+    client.pending_replies.append(Optional<String>());
 
-    char lookup_type = client_buffer[0];
+    char lookup_type = request[0];
+    if (lookup_type == 'S' && request.length() == 1) {
+        send_reply(client, reply_id, statistics_reply());
+        return;
+    }
     if (lookup_type != 'L' && lookup_type != 'R') {
         dbg() << "Invalid lookup_type " << lookup_type;
+        send_reply(client, reply_id, "Not found.\n\n");
         return;
     }
-    auto hostname = String((const char*)client_buffer + 1, nrecv - 1, Chomp);
-    dbg() << "Got request for '" << hostname << "' (using IP " << m_nameserver << ")";
-
-    Vector<String> responses;
+    auto hostname = request.substring_view(1, request.length() - 1).to_string();
+    dbg() << "Got request for '" << hostname << "'";
+    ++m_statistics.requests;
 
+    u16 record_type = lookup_type == 'L' ? T_A : T_PTR;
     if (auto known_host = m_etc_hosts.get(hostname); known_host.has_value()) {
-        responses.append(known_host.value());
-    } else if (!hostname.is_empty()) {
-        bool did_timeout;
-        int retries = 3;
-        do {
-            did_timeout = false;
-            if (lookup_type == 'L')
-                responses = lookup(hostname, did_timeout, T_A);
-            else if (lookup_type == 'R')
-                responses = lookup(hostname, did_timeout, T_PTR);
-            if (!did_timeout)
-                break;
-        } while (--retries);
-        if (did_timeout) {
+        ++m_statistics.etc_hosts_hits;
+        Vector<DNSAnswer> answers;
+        answers.empend(hostname, record_type, C_IN, etc_hosts_ttl, known_host.value());
+        send_reply(client, reply_id, format_reply(answers));
+        return;
+    }
+    if (hostname.is_empty()) {
+        send_reply(client, reply_id, "Not found.\n\n");
+        return;
+    }
+
+    lookup(hostname, record_type, [this, client = &client, protector = NonnullRefPtr<Client>(client), reply_id](LookupResult result, const Vector<DNSAnswer>& answers) {
+        if (result == LookupResult::TimedOut) {
             fprintf(stderr, "LookupServer: Out of retries :(\n");
+            send_reply(*client, reply_id, "Timed out.\n\n");
             return;
         }
-    }
+        send_reply(*client, reply_id, format_reply(answers));
+    });
+}
 
-    if (responses.is_empty()) {
-        int nsent = socket->write("Not found.\n");
-        if (nsent < 0)
-            perror("write");
-        return;
-    }
-    for (auto& response : responses) {
-        auto line = String::format("%s\n", response.characters());
-        int nsent = socket->write(line);
-        if (nsent < 0) {
+void LookupServer::send_reply(Client& client, size_t reply_id, String reply)
+{
+    client.pending_replies[reply_id - client.first_pending_reply_id] = move(reply);
+    while (!client.pending_replies.is_empty() && client.pending_replies.first().has_value()) {
+        auto ready_reply = client.pending_replies.take_first().value();
+        ++client.first_pending_reply_id;
+        if (client.has_hung_up)
+            continue;
+        if (!client.socket->write(ready_reply))
             perror("write");
-            break;
-        }
     }
 }
 
-Vector<String> LookupServer::lookup(const String& hostname, bool& did_timeout, unsigned short record_type, ShouldRandomizeCase should_randomize_case)
+String LookupServer::statistics_reply() const
 {
-    if (auto it = m_lookup_cache.find(hostname); it != m_lookup_cache.end()) {
-        auto& cached_lookup = it->value;
-        if (cached_lookup.question.record_type() == record_type) {
-            Vector<String> responses;
-            for (auto& cached_answer : cached_lookup.answers) {
-                dbg() << "Cache hit: " << hostname << " -> " << cached_answer.record_data() << ", expired: " << cached_answer.has_expired();
-                if (!cached_answer.has_expired()) {
-                    responses.append(cached_answer.record_data());
-                }
-            }
-            if (!responses.is_empty())
-                return responses;
+    StringBuilder builder;
+    builder.appendf("requests %llu\n", m_statistics.requests);
+    builder.appendf("etc_hosts_hits %llu\n", m_statistics.etc_hosts_hits);
+    builder.appendf("cache_hits %llu\n", m_statistics.cache_hits);
+    builder.appendf("negative_cache_hits %llu\n", m_statistics.negative_cache_hits);
+    builder.appendf("cache_misses %llu\n", m_statistics.cache_misses);
+    builder.appendf("cache_evictions %llu\n", m_statistics.cache_evictions);
+    builder.appendf("cache_entries %zu\n", m_lookup_cache.size());
+    builder.appendf("coalesced_lookups %llu\n", m_statistics.coalesced_lookups);
+    builder.appendf("pending_lookups %zu\n", m_pending_lookups.size());
+    builder.appendf("upstream_queries %llu\n", m_statistics.upstream_queries);
+    builder.appendf("upstream_timeouts %llu\n", m_statistics.upstream_timeouts);
+    builder.append('\n');
+    return builder.to_string();
+}
+
+void LookupServer::lookup(const String& name, u16 record_type, LookupCallback callback)
+{
+    // Names are case-insensitive, and 0x20 randomization means we never ask twice in the same case anyway.
+    auto key = String::format("%u:%s", record_type, name.to_lowercase().characters());
+
+    Vector<DNSAnswer> cached_answers;
+    if (lookup_in_cache(key, cached_answers)) {
+        if (cached_answers.is_empty()) {
+            ++m_statistics.negative_cache_hits;
+            callback(LookupResult::NotFound, {});
+        } else {
+            ++m_statistics.cache_hits;
+            callback(LookupResult::Found, cached_answers);
         }
-        m_lookup_cache.remove(it);
+        return;
     }
 
-    DNSRequest request;
-    request.add_question(hostname, record_type, should_randomize_case);
-
-    auto buffer = request.to_byte_buffer();
-
-    auto udp_socket = Core::UDPSocket::construct();
-    udp_socket->set_blocking(true);
+    if (auto it = m_pending_lookups.find(key); it != m_pending_lookups.end()) {
+        ++m_statistics.coalesced_lookups;
+        it->value->callbacks.append(move(callback));
+        return;
+    }
 
-    struct timeval timeout {
-        1, 0
-    };
+    ++m_statistics.cache_misses;
+    auto pending_lookup = adopt(*new PendingLookup);
+    pending_lookup->key = key;
+    pending_lookup->name = name;
+    pending_lookup->record_type = record_type;
+    pending_lookup->callbacks.append(move(callback));
+    pending_lookup->timeout_timer = Core::Timer::create_single_shot(query_timeout_ms, [this, pending_lookup = pending_lookup.ptr()] {
+        ++m_statistics.upstream_timeouts;
+        did_fail_attempt(*pending_lookup, true);
+    });
+    m_pending_lookups.set(key, pending_lookup);
+    send_queries(*pending_lookup);
+}
 
-    int rc = setsockopt(udp_socket->fd(), SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
-    if (rc < 0) {
-        perror("setsockopt(SOL_SOCKET, SO_RCVTIMEO)");
-        return {};
+void LookupServer::send_queries(PendingLookup& pending_lookup)
+{
+    // We may be here from a callback of one of the previous attempt's sockets.
+    for (auto& query : pending_lookup.queries)
+        query.socket->set_notifications_enabled(false);
+    deferred_invoke([previous_queries = move(pending_lookup.queries)](auto&) {});
+    pending_lookup.queries.clear();
+    pending_lookup.was_refused = false;
+
+    for (auto& nameserver : m_nameservers) {
+        auto socket = Core::UDPSocket::construct();
+        if (!socket->connect(nameserver, 53))
+            continue;
+        // Every nameserver gets its own ID and case randomization, so one can't answer for another.
+        DNSRequest request;
+        request.add_question(pending_lookup.name, pending_lookup.record_type, pending_lookup.should_randomize_case);
+        if (!socket->write(request.to_byte_buffer()))
+            continue;
+        ++m_statistics.upstream_queries;
+        socket->on_ready_to_read = [this, pending_lookup = &pending_lookup, socket = socket.ptr()] {
+            did_receive_response(*pending_lookup, *socket);
+        };
+        pending_lookup.queries.append({ move(request), move(socket) });
     }
 
-    if (!udp_socket->connect(m_nameserver, 53))
-        return {};
-
-    if (!udp_socket->write(buffer))
-        return {};
+    if (pending_lookup.queries.is_empty()) {
+        finish_lookup(pending_lookup, LookupResult::NotFound, {});
+        return;
+    }
+    pending_lookup.timeout_timer->restart(query_timeout_ms);
+}
 
+void LookupServer::did_receive_response(PendingLookup& pending_lookup, Core::UDPSocket& socket)
+{
     u8 response_buffer[4096];
-    int nrecv = udp_socket->read(response_buffer, sizeof(response_buffer));
-    if (nrecv == 0)
-        return {};
+    int nrecv = socket.read(response_buffer, sizeof(response_buffer));
 
-    auto o_response = DNSResponse::from_raw_response(response_buffer, nrecv);
-    if (!o_response.has_value())
-        return {};
+    PendingLookup::Query* query = nullptr;
+    for (auto& candidate : pending_lookup.queries) {
+        if (candidate.socket.ptr() == &socket)
+            query = &candidate;
+    }
+    if (pending_lookup.is_finished || !query || query->has_failed)
+        return;
 
-    auto& response = o_response.value();
+    auto o_response = nrecv > 0 ? DNSResponse::from_raw_response(response_buffer, nrecv) : Optional<DNSResponse>();
+    if (!o_response.has_value()) {
+        query->has_failed = true;
+    } else {
+        auto& response = o_response.value();
+        auto& request = query->request;
 
-    if (response.id() != request.id()) {
-        dbgprintf("LookupServer: ID mismatch (%u vs %u) :(\n", response.id(), request.id());
-        return {};
-    }
+        // Anything that isn't an answer to what we asked this nameserver is ignored, and we keep waiting.
+        if (response.id() != request.id()) {
+            dbgprintf("LookupServer: ID mismatch (%u vs %u) :(\n", response.id(), request.id());
+            return;
+        }
+        if (response.code() == DNSResponse::Code::NOERROR || response.code() == DNSResponse::Code::NXDOMAIN) {
+            if (response.question_count() != request.question_count() || response.questions()[0] != request.questions()[0]) {
+                dbg() << "Request and response questions do not match";
+                return;
+            }
 
-    if (response.code() == DNSResponse::Code::REFUSED) {
-        if (should_randomize_case == ShouldRandomizeCase::Yes) {
-            // Retry with 0x20 case randomization turned off.
-            return lookup(hostname, did_timeout, record_type, ShouldRandomizeCase::No);
+            Vector<DNSAnswer> answers;
+            u32 ttl = max_cache_ttl;
+            for (auto& answer : response.answers()) {
+                if (answer.type() != pending_lookup.record_type)
+                    continue;
+                answers.append(answer);
+                ttl = min(ttl, answer.ttl());
+            }
+
+            if (answers.is_empty()) {
+                if (response.negative_ttl().has_value())
+                    add_to_cache(pending_lookup.key, {}, min(response.negative_ttl().value(), max_negative_cache_ttl));
+                finish_lookup(pending_lookup, LookupResult::NotFound, {});
+                return;
+            }
+            add_to_cache(pending_lookup.key, answers, ttl);
+            finish_lookup(pending_lookup, LookupResult::Found, answers);
+            return;
         }
-        return {};
+        if (response.code() == DNSResponse::Code::REFUSED)
+            pending_lookup.was_refused = true;
+        query->has_failed = true;
     }
 
-    if (response.question_count() != request.question_count()) {
-        dbgprintf("LookupServer: Question count (%u vs %u) :(\n", response.question_count(), request.question_count());
-        return {};
+    for (auto& other_query : pending_lookup.queries) {
+        if (!other_query.has_failed)
+            return;
     }
+    did_fail_attempt(pending_lookup, false);
+}
 
-    for (size_t i = 0; i < request.question_count(); ++i) {
-        auto& request_question = request.questions()[i];
-        auto& response_question = response.questions()[i];
-        if (request_question != response_question) {
-            dbg() << "Request and response questions do not match";
-            dbg() << "   Request: {_" << request_question.name() << "_, " << request_question.record_type() << ", " << request_question.class_code() << "}";
-            dbg() << "  Response: {_" << response_question.name() << "_, " << response_question.record_type() << ", " << response_question.class_code() << "}";
-            return {};
-        }
+void LookupServer::did_fail_attempt(PendingLookup& pending_lookup, bool did_timeout)
+{
+    if (pending_lookup.is_finished)
+        return;
+    if (pending_lookup.was_refused && pending_lookup.should_randomize_case == ShouldRandomizeCase::Yes) {
+        // Retry with 0x20 case randomization turned off.
+        pending_lookup.should_randomize_case = ShouldRandomizeCase::No;
+        send_queries(pending_lookup);
+        return;
     }
-
-    if (response.answer_count() < 1) {
-        dbgprintf("LookupServer: Not enough answers (%u) :(\n", response.answer_count());
-        return {};
+    if (did_timeout && --pending_lookup.attempts_left > 0) {
+        send_queries(pending_lookup);
+        return;
     }
+    finish_lookup(pending_lookup, did_timeout ? LookupResult::TimedOut : LookupResult::NotFound, {});
+}
 
-    Vector<String, 8> responses;
-    Vector<DNSAnswer, 8> cacheable_answers;
-    for (auto& answer : response.answers()) {
-        if (answer.type() != T_A)
-            continue;
-        responses.append(answer.record_data());
-        if (!answer.has_expired())
-            cacheable_answers.append(answer);
+void LookupServer::finish_lookup(PendingLookup& pending_lookup, LookupResult result, const Vector<DNSAnswer>& answers)
+{
+    NonnullRefPtr<PendingLookup> protector(pending_lookup);
+    pending_lookup.is_finished = true;
+    pending_lookup.timeout_timer->stop();
+    for (auto& query : pending_lookup.queries)
+        query.socket->set_notifications_enabled(false);
+    m_pending_lookups.remove(pending_lookup.key);
+
+    auto callbacks = move(pending_lookup.callbacks);
+    for (auto& callback : callbacks)
+        callback(result, answers);
+
+    // Its sockets and timer may be what got us here, so they're let go of from the event loop.
+    deferred_invoke([protector](auto&) {});
+}
+
+// Returns whether the cache knows the answer, which may also be that there is none.
+bool LookupServer::lookup_in_cache(const String& key, Vector<DNSAnswer>& answers)
+{
+    auto it = m_lookup_cache.find(key);
+    if (it == m_lookup_cache.end())
+        return false;
+    auto& cached_lookup = it->value;
+    if (time(nullptr) >= cached_lookup.expiration_time) {
+        m_lookup_cache.remove(it);
+        return false;
     }
+    cached_lookup.last_used = ++m_cache_use_counter;
+    answers = cached_lookup.answers;
+    return true;
+}
+
+void LookupServer::add_to_cache(const String& key, const Vector<DNSAnswer>& answers, u32 ttl)
+{
+    ttl = min(ttl, max_cache_ttl);
+    if (ttl == 0)
+        return;
+    if (!m_lookup_cache.contains(key) && m_lookup_cache.size() >= max_cache_entries)
+        make_room_in_cache();
+    m_lookup_cache.set(key, { answers, time(nullptr) + ttl, ++m_cache_use_counter });
+}
 
-    if (!cacheable_answers.is_empty()) {
-        if (m_lookup_cache.size() >= 256)
-            m_lookup_cache.remove(m_lookup_cache.begin());
-        m_lookup_cache.set(hostname, { request.questions()[0], move(cacheable_answers) });
+// Drops whatever has expired, or failing that, the entry that has gone unused the longest.
+void LookupServer::make_room_in_cache()
+{
+    auto now = time(nullptr);
+    Vector<String> expired_keys;
+    String least_recently_used_key;
+    u64 least_recent_use = NumericLimits<u64>::max();
+    for (auto& it : m_lookup_cache) {
+        if (now >= it.value.expiration_time)
+            expired_keys.append(it.key);
+        if (it.value.last_used < least_recent_use) {
+            least_recent_use = it.value.last_used;
+            least_recently_used_key = it.key;
+        }
     }
-    return responses;
+    if (expired_keys.is_empty())
+        expired_keys.append(least_recently_used_key);
+    for (auto& key : expired_keys)
+        m_lookup_cache.remove(key);
+    m_statistics.cache_evictions += expired_keys.size();
 }
@@ -26,12 +26,16 @@
 
 #pragma once
 
+#include "DNSAnswer.h"
 #include "DNSRequest.h"
 #include "DNSResponse.h"
 #include <AK/HashMap.h>
+#include <AK/IPv4Address.h>
+#include <AK/RefCounted.h>
+#include <LibCore/LocalSocket.h>
 #include <LibCore/Object.h>
-
-class DNSAnswer;
+#include <LibCore/Timer.h>
+#include <LibCore/UDPSocket.h>
 
 class LookupServer final : public Core::Object {
     C_OBJECT(LookupServer)
@@ -40,17 +44,94 @@ public:
     LookupServer();
 
 private:
-    void load_etc_hosts();
-    void service_client(RefPtr<Core::LocalSocket>);
-    Vector<String> lookup(const String& hostname, bool& did_timeout, unsigned short record_type, ShouldRandomizeCase = ShouldRandomizeCase::Yes);
+    static constexpr size_t max_cache_entries = 256;
+    // Upper bounds on what nameservers may ask us to remember, the negative one as suggested by RFC 2308.
+    static constexpr u32 max_cache_ttl = 86400;
+    static constexpr u32 max_negative_cache_ttl = 10800;
+    static constexpr int query_timeout_ms = 1000;
+    static constexpr int max_query_attempts = 3;
+
+    // Replies go out in the order the requests came in, even when a later lookup is answered first.
+    struct Client : public RefCounted<Client> {
+        explicit Client(NonnullRefPtr<Core::LocalSocket> socket)
+            : socket(move(socket))
+        {
+        }
+
+        NonnullRefPtr<Core::LocalSocket> socket;
+        Vector<Optional<String>> pending_replies;
+        size_t first_pending_reply_id { 0 };
+        bool has_hung_up { false };
+    };
+
+    enum class LookupResult {
+        Found,
+        NotFound,
+        TimedOut,
+    };
+    using LookupCallback = Function<void(LookupResult, const Vector<DNSAnswer>&)>;
+
+    // A question that's out to the nameservers. It goes to all of them at once, and the first good answer wins.
+    // Anybody asking the same thing in the meantime waits for that answer instead of asking again.
+    struct PendingLookup : public RefCounted<PendingLookup> {
+        struct Query {
+            DNSRequest request;
+            NonnullRefPtr<Core::UDPSocket> socket;
+            bool has_failed { false };
+        };
+
+        String key;
+        String name;
+        u16 record_type { 0 };
+        ShouldRandomizeCase should_randomize_case { ShouldRandomizeCase::Yes };
+        bool was_refused { false };
+        bool is_finished { false };
+        int attempts_left { max_query_attempts };
+        Vector<LookupCallback> callbacks;
+        Vector<Query> queries;
+        RefPtr<Core::Timer> timeout_timer;
+    };
 
     struct CachedLookup {
-        DNSQuestion question;
+        // Empty when the nameserver told us there's no such thing.
         Vector<DNSAnswer> answers;
+        time_t expiration_time { 0 };
+        u64 last_used { 0 };
+    };
+
+    struct Statistics {
+        u64 requests { 0 };
+        u64 etc_hosts_hits { 0 };
+        u64 cache_hits { 0 };
+        u64 negative_cache_hits { 0 };
+        u64 cache_misses { 0 };
+        u64 cache_evictions { 0 };
+        u64 coalesced_lookups { 0 };
+        u64 upstream_queries { 0 };
+        u64 upstream_timeouts { 0 };
     };
 
+    void load_etc_hosts();
+    bool service_client(Client&);
+    void service_request(Client&, const StringView& request);
+    void send_reply(Client&, size_t reply_id, String reply);
+    String statistics_reply() const;
+
+    void lookup(const String& name, u16 record_type, LookupCallback);
+    void send_queries(PendingLookup&);
+    void did_receive_response(PendingLookup&, Core::UDPSocket&);
+    void did_fail_attempt(PendingLookup&, bool did_timeout);
+    void finish_lookup(PendingLookup&, LookupResult, const Vector<DNSAnswer>&);
+
+    bool lookup_in_cache(const String& key, Vector<DNSAnswer>&);
+    void add_to_cache(const String& key, const Vector<DNSAnswer>&, u32 ttl);
+    void make_room_in_cache();
+
     RefPtr<Core::LocalServer> m_local_server;
-    String m_nameserver;
+    Vector<IPv4Address> m_nameservers;
     HashMap<String, String> m_etc_hosts;
     HashMap<String, CachedLookup> m_lookup_cache;
+    u64 m_cache_use_counter { 0 };
+    HashMap<String, NonnullRefPtr<PendingLookup>> m_pending_lookups;
+    Statistics m_statistics;
 };
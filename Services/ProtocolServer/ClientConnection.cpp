@@ -25,7 +25,6 @@
  */
 
 #include <AK/Badge.h>
-#include <AK/SharedBuffer.h>
 #include <ProtocolServer/ClientConnection.h>
 #include <ProtocolServer/Download.h>
 #include <ProtocolServer/Protocol.h>
@@ -84,23 +83,22 @@ OwnPtr<Messages::ProtocolServer::StopDownloadResponse> ClientConnection::handle(
     return make<Messages::ProtocolServer::StopDownloadResponse>(success);
 }
 
-void ClientConnection::did_finish_download(Badge<Download>, Download& download, bool success)
+void ClientConnection::did_receive_download_headers(Badge<Download>, Download& download)
 {
-    RefPtr<SharedBuffer> buffer;
-    if (success && download.payload().size() > 0 && !download.payload().is_null()) {
-        buffer = SharedBuffer::create_with_size(download.payload().size());
-        memcpy(buffer->data(), download.payload().data(), download.payload().size());
-        buffer->seal();
-        buffer->share_with(client_pid());
-        m_shared_buffers.set(buffer->shbuf_id(), buffer);
-    }
-    ASSERT(download.total_size().has_value());
-
     IPC::Dictionary response_headers;
     for (auto& it : download.response_headers())
         response_headers.add(it.key, it.value);
-    post_message(Messages::ProtocolClient::DownloadFinished(download.id(), success, download.total_size().value(), buffer ? buffer->shbuf_id() : -1, response_headers));
+    post_message(Messages::ProtocolClient::DownloadResponseHeaders(download.id(), response_headers));
+}
 
+void ClientConnection::did_receive_download_data(Badge<Download>, Download& download, const ByteBuffer& data)
+{
+    post_message(Messages::ProtocolClient::DownloadData(download.id(), data));
+}
+
+void ClientConnection::did_finish_download(Badge<Download>, Download& download, bool success)
+{
+    post_message(Messages::ProtocolClient::DownloadFinished(download.id(), success));
     m_downloads.remove(download.id());
 }
 
@@ -114,10 +112,11 @@ OwnPtr<Messages::ProtocolServer::GreetResponse> ClientConnection::handle(const M
     return make<Messages::ProtocolServer::GreetResponse>(client_id());
 }
 
-OwnPtr<Messages::ProtocolServer::DisownSharedBufferResponse> ClientConnection::handle(const Messages::ProtocolServer::DisownSharedBuffer& message)
+void ClientConnection::handle(const Messages::ProtocolServer::DidConsumeDownloadData& message)
 {
-    m_shared_buffers.remove(message.shbuf_id());
-    return make<Messages::ProtocolServer::DisownSharedBufferResponse>();
+    // The download may well have finished (or been stopped) in the meantime.
+    if (auto* download = const_cast<Download*>(m_downloads.get(message.download_id()).value_or(nullptr)))
+        download->did_consume_data(message.size());
 }
 
 }
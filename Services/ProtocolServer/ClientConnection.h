@@ -44,6 +44,8 @@ public:
 
     virtual void die() override;
 
+    void did_receive_download_headers(Badge<Download>, Download&);
+    void did_receive_download_data(Badge<Download>, Download&, const ByteBuffer&);
     void did_finish_download(Badge<Download>, Download&, bool success);
     void did_progress_download(Badge<Download>, Download&);
 
@@ -52,10 +54,9 @@ private:
     virtual OwnPtr<Messages::ProtocolServer::IsSupportedProtocolResponse> handle(const Messages::ProtocolServer::IsSupportedProtocol&) override;
     virtual OwnPtr<Messages::ProtocolServer::StartDownloadResponse> handle(const Messages::ProtocolServer::StartDownload&) override;
     virtual OwnPtr<Messages::ProtocolServer::StopDownloadResponse> handle(const Messages::ProtocolServer::StopDownload&) override;
-    virtual OwnPtr<Messages::ProtocolServer::DisownSharedBufferResponse> handle(const Messages::ProtocolServer::DisownSharedBuffer&) override;
+    virtual void handle(const Messages::ProtocolServer::DidConsumeDownloadData&) override;
 
     HashMap<i32, OwnPtr<Download>> m_downloads;
-    HashMap<i32, RefPtr<AK::SharedBuffer>> m_shared_buffers;
 };
 
 }
@@ -0,0 +1,173 @@
+/*
+ * Copyright (c) 2018-2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/HashMap.h>
+#include <AK/NonnullOwnPtr.h>
+#include <AK/Queue.h>
+#include <AK/URL.h>
+#include <AK/WeakPtr.h>
+#include <LibCore/Object.h>
+#include <LibCore/TCPSocket.h>
+#include <LibCore/Timer.h>
+#include <LibTLS/TLSv12.h>
+
+//#define CONNECTION_CACHE_DEBUG
+
+namespace ProtocolServer {
+
+inline bool is_connection_open(const Core::TCPSocket& socket) { return socket.is_connected() && !socket.eof(); }
+inline bool is_connection_open(const TLS::TLSv12& socket) { return socket.is_established(); }
+
+// An idle connection has nothing to say, so anything happening on it means it's going away.
+inline void watch_idle_connection(Core::TCPSocket& socket, Function<void()> on_closed)
+{
+    socket.on_ready_to_read = move(on_closed);
+}
+
+inline void watch_idle_connection(TLS::TLSv12& socket, Function<void()> on_closed)
+{
+    socket.on_tls_finished = move(on_closed);
+    socket.on_tls_error = [&socket](auto) {
+        if (socket.on_tls_finished)
+            socket.on_tls_finished();
+    };
+}
+
+// Keeps connections open after a download is done with them, so the next download from the same server can skip
+// connecting, and for HTTPS the handshake. There's one cache per scheme, shared by all clients. A server gets at
+// most max_connections_per_host connections, and jobs beyond that wait for one of them to be free.
+template<typename SocketType, typename JobType>
+class ConnectionCache final : public Core::Object {
+    C_OBJECT(ConnectionCache)
+public:
+    static constexpr size_t max_connections_per_host = 6;
+    static constexpr int idle_timeout_ms = 10000;
+
+    virtual ~ConnectionCache() override { }
+
+    void start_job(JobType& job, const URL& url)
+    {
+        auto key = String::format("%s:%d", url.host().characters(), url.port());
+        if (!m_hosts.contains(key))
+            m_hosts.set(key, make<Host>());
+        auto& host = *m_hosts.find(key)->value;
+        host.waiting_jobs.enqueue(job.make_weak_ptr());
+        start_waiting_jobs(host);
+    }
+
+private:
+    struct Connection {
+        explicit Connection(NonnullRefPtr<SocketType> socket)
+            : socket(move(socket))
+        {
+        }
+
+        NonnullRefPtr<SocketType> socket;
+        bool in_use { false };
+        // Set once the connection is on its way out, which only happens on the next event loop pass.
+        bool is_closing { false };
+        RefPtr<Core::Timer> idle_timer;
+    };
+
+    struct Host {
+        Vector<NonnullOwnPtr<Connection>> connections;
+        Queue<WeakPtr<Core::Object>> waiting_jobs;
+    };
+
+    ConnectionCache() { }
+
+    void start_waiting_jobs(Host& host)
+    {
+        for (;;) {
+            // Downloads that were stopped while waiting have taken their jobs with them.
+            while (!host.waiting_jobs.is_empty() && !host.waiting_jobs.head())
+                host.waiting_jobs.dequeue();
+            if (host.waiting_jobs.is_empty())
+                return;
+
+            Connection* connection = nullptr;
+            for (auto& candidate : host.connections) {
+                if (!candidate->in_use && !candidate->is_closing && is_connection_open(*candidate->socket)) {
+                    connection = candidate.ptr();
+                    break;
+                }
+            }
+            if (!connection) {
+                if (host.connections.size() >= max_connections_per_host)
+                    return;
+                host.connections.append(make<Connection>(SocketType::construct(nullptr)));
+                connection = host.connections.last().ptr();
+            }
+
+            auto& job = static_cast<JobType&>(*host.waiting_jobs.dequeue());
+#ifdef CONNECTION_CACHE_DEBUG
+            dbg() << "ConnectionCache: Starting a job on " << (connection->socket->is_connected() ? "a reused" : "a new") << " connection";
+#endif
+            connection->in_use = true;
+            connection->idle_timer = nullptr;
+            watch_idle_connection(*connection->socket, nullptr);
+            job.on_socket_released = [this, &host, connection](bool can_reuse_connection) {
+                release_connection(host, *connection, can_reuse_connection);
+            };
+            job.start(connection->socket);
+        }
+    }
+
+    void release_connection(Host& host, Connection& connection, bool can_reuse_connection)
+    {
+        connection.in_use = false;
+        if (!can_reuse_connection || !is_connection_open(*connection.socket)) {
+            remove_connection_later(host, connection);
+            return;
+        }
+        watch_idle_connection(*connection.socket, [this, &host, &connection] {
+            remove_connection_later(host, connection);
+        });
+        connection.idle_timer = Core::Timer::create_single_shot(idle_timeout_ms, [this, &host, &connection] {
+            remove_connection_later(host, connection);
+        });
+        connection.idle_timer->start();
+        start_waiting_jobs(host);
+    }
+
+    // Connections are dropped from the event loop, since we're usually called back from something the connection owns.
+    void remove_connection_later(Host& host, Connection& connection)
+    {
+        connection.is_closing = true;
+        deferred_invoke([this, &host, connection = &connection](auto&) {
+            host.connections.remove_first_matching([&](auto& candidate) {
+                return candidate.ptr() == connection && !candidate->in_use;
+            });
+            start_waiting_jobs(host);
+        });
+    }
+
+    HashMap<String, NonnullOwnPtr<Host>> m_hosts;
+};
+
+}
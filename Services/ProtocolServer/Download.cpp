@@ -48,15 +48,31 @@ void Download::stop()
     m_client.did_finish_download({}, *this, false);
 }
 
-void Download::set_payload(const ByteBuffer& payload)
+void Download::set_response_headers(const HashMap<String, String, CaseInsensitiveStringTraits>& response_headers)
 {
-    m_payload = payload;
-    m_total_size = payload.size();
+    m_response_headers = response_headers;
+    m_client.did_receive_download_headers({}, *this);
 }
 
-void Download::set_response_headers(const HashMap<String, String, CaseInsensitiveStringTraits>& response_headers)
+void Download::did_receive_data(const ByteBuffer& data)
 {
-    m_response_headers = response_headers;
+    if (data.is_empty())
+        return;
+    m_unconsumed_data_size += data.size();
+    m_client.did_receive_download_data({}, *this, data);
+    if (!m_paused && m_unconsumed_data_size > max_unconsumed_data_size) {
+        m_paused = true;
+        pause();
+    }
+}
+
+void Download::did_consume_data(size_t size)
+{
+    m_unconsumed_data_size -= min(size, m_unconsumed_data_size);
+    if (m_paused && m_unconsumed_data_size <= max_unconsumed_data_size / 2) {
+        m_paused = false;
+        resume();
+    }
 }
 
 void Download::did_finish(bool success)
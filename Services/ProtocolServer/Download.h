@@ -44,26 +44,36 @@ public:
 
     Optional<u32> total_size() const { return m_total_size; }
     size_t downloaded_size() const { return m_downloaded_size; }
-    const ByteBuffer& payload() const { return m_payload; }
     const HashMap<String, String, CaseInsensitiveStringTraits>& response_headers() const { return m_response_headers; }
 
     void stop();
 
+    // The client is done with this much of the data we sent it.
+    void did_consume_data(size_t);
+
 protected:
     explicit Download(ClientConnection&);
 
     void did_finish(bool success);
     void did_progress(Optional<u32> total_size, u32 downloaded_size);
-    void set_payload(const ByteBuffer&);
+    void did_receive_data(const ByteBuffer&);
     void set_response_headers(const HashMap<String, String, CaseInsensitiveStringTraits>&);
 
+    // Called when the client has too much data it hasn't got round to yet, and once it has caught up again.
+    virtual void pause() { }
+    virtual void resume() { }
+
 private:
+    // How much data may be on its way to the client, or waiting there, before we stop receiving more.
+    static constexpr size_t max_unconsumed_data_size = 1 * MB;
+
     ClientConnection& m_client;
     i32 m_id { 0 };
     URL m_url;
     Optional<u32> m_total_size {};
     size_t m_downloaded_size { 0 };
-    ByteBuffer m_payload;
+    size_t m_unconsumed_data_size { 0 };
+    bool m_paused { false };
     HashMap<String, String, CaseInsensitiveStringTraits> m_response_headers;
 };
 
@@ -36,7 +36,6 @@ GeminiDownload::GeminiDownload(ClientConnection& client, NonnullRefPtr<Gemini::G
 {
     m_job->on_finish = [this](bool success) {
         if (auto* response = m_job->response()) {
-            set_payload(response->payload());
             if (!response->meta().is_empty()) {
                 HashMap<String, String, CaseInsensitiveStringTraits> headers;
                 headers.set("meta", response->meta());
@@ -48,6 +47,7 @@ GeminiDownload::GeminiDownload(ClientConnection& client, NonnullRefPtr<Gemini::G
                 }
                 set_response_headers(headers);
             }
+            did_receive_data(response->payload());
         }
 
         // signal 100% download progress so any listeners can react
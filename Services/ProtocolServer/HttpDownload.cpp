@@ -34,11 +34,16 @@ HttpDownload::HttpDownload(ClientConnection& client, NonnullRefPtr<HTTP::HttpJob
     : Download(client)
     , m_job(job)
 {
+    m_job->on_headers_received = [this](auto& response_headers) {
+        set_response_headers(response_headers);
+    };
+    m_job->on_body_data = [this](auto& data) {
+        did_receive_data(data);
+    };
     m_job->on_finish = [this](bool success) {
-        if (auto* response = m_job->response()) {
-            set_payload(response->payload());
-            set_response_headers(response->headers());
-        }
+        // Anything the job couldn't hand over as it arrived is in the response.
+        if (auto* response = m_job->response())
+            did_receive_data(response->payload());
 
         // if we didn't know the total size, pretend that the download finished successfully
         // and set the total size to the downloaded size
@@ -54,11 +59,23 @@ HttpDownload::HttpDownload(ClientConnection& client, NonnullRefPtr<HTTP::HttpJob
 
 HttpDownload::~HttpDownload()
 {
+    m_job->on_headers_received = nullptr;
+    m_job->on_body_data = nullptr;
     m_job->on_finish = nullptr;
     m_job->on_progress = nullptr;
     m_job->shutdown();
 }
 
+void HttpDownload::pause()
+{
+    m_job->pause();
+}
+
+void HttpDownload::resume()
+{
+    m_job->resume();
+}
+
 NonnullOwnPtr<HttpDownload> HttpDownload::create_with_job(Badge<HttpProtocol>, ClientConnection& client, NonnullRefPtr<HTTP::HttpJob> job)
 {
     return adopt_own(*new HttpDownload(client, move(job)));
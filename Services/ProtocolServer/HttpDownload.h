@@ -41,6 +41,9 @@ public:
 private:
     explicit HttpDownload(ClientConnection&, NonnullRefPtr<HTTP::HttpJob>);
 
+    virtual void pause() override;
+    virtual void resume() override;
+
     NonnullRefPtr<HTTP::HttpJob> m_job;
 };
 
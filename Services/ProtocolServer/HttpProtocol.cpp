@@ -33,6 +33,7 @@ namespace ProtocolServer {
 
 HttpProtocol::HttpProtocol()
     : Protocol("http")
+    , m_connection_cache(ConnectionCache<Core::TCPSocket, HTTP::HttpJob>::construct())
 {
 }
 
@@ -46,10 +47,10 @@ OwnPtr<Download> HttpProtocol::start_download(ClientConnection& client, const UR
     request.set_method(HTTP::HttpRequest::Method::GET);
     request.set_url(url);
     request.set_headers(headers);
-    auto job = request.schedule();
-    if (!job)
-        return nullptr;
-    return HttpDownload::create_with_job({}, client, (HTTP::HttpJob&)*job);
+    auto job = HTTP::HttpJob::construct(request);
+    auto download = HttpDownload::create_with_job({}, client, (HTTP::HttpJob&)*job);
+    m_connection_cache->start_job(*job, url);
+    return download;
 }
 
 }
@@ -26,6 +26,8 @@
 
 #pragma once
 
+#include <LibHTTP/HttpJob.h>
+#include <ProtocolServer/ConnectionCache.h>
 #include <ProtocolServer/Protocol.h>
 
 namespace ProtocolServer {
@@ -36,6 +38,9 @@ public:
     virtual ~HttpProtocol() override;
 
     virtual OwnPtr<Download> start_download(ClientConnection&, const URL&, const HashMap<String, String>& headers) override;
+
+private:
+    NonnullRefPtr<ConnectionCache<Core::TCPSocket, HTTP::HttpJob>> m_connection_cache;
 };
 
 }
@@ -41,6 +41,9 @@ public:
 private:
     explicit HttpsDownload(ClientConnection&, NonnullRefPtr<HTTP::HttpsJob>);
 
+    virtual void pause() override;
+    virtual void resume() override;
+
     NonnullRefPtr<HTTP::HttpsJob> m_job;
 };
 
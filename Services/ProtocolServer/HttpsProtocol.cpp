@@ -33,6 +33,7 @@ namespace ProtocolServer {
 
 HttpsProtocol::HttpsProtocol()
     : Protocol("https")
+    , m_connection_cache(ConnectionCache<TLS::TLSv12, HTTP::HttpsJob>::construct())
 {
 }
 
@@ -48,7 +49,7 @@ OwnPtr<Download> HttpsProtocol::start_download(ClientConnection& client, const U
     request.set_headers(headers);
     auto job = HTTP::HttpsJob::construct(request);
     auto download = HttpsDownload::create_with_job({}, client, (HTTP::HttpsJob&)*job);
-    job->start();
+    m_connection_cache->start_job(*job, url);
     return download;
 }
 
@@ -26,6 +26,8 @@
 
 #pragma once
 
+#include <LibHTTP/HttpsJob.h>
+#include <ProtocolServer/ConnectionCache.h>
 #include <ProtocolServer/Protocol.h>
 
 namespace ProtocolServer {
@@ -36,6 +38,9 @@ public:
     virtual ~HttpsProtocol() override;
 
     virtual OwnPtr<Download> start_download(ClientConnection&, const URL&, const HashMap<String, String>& headers) override;
+
+private:
+    NonnullRefPtr<ConnectionCache<TLS::TLSv12, HTTP::HttpsJob>> m_connection_cache;
 };
 
 }
@@ -28,6 +28,7 @@
 #include <AK/HashMap.h>
 #include <AK/JsonArray.h>
 #include <AK/JsonObject.h>
+#include <AK/StringBuilder.h>
 #include <LibCore/ConfigFile.h>
 #include <LibCore/LocalSocket.h>
 #include <fcntl.h>
@@ -36,6 +37,7 @@
 #include <pwd.h>
 #include <sched.h>
 #include <stdio.h>
+#include <string.h>
 #include <sys/ioctl.h>
 #include <sys/stat.h>
 #include <unistd.h>
@@ -48,6 +50,9 @@ struct UidAndGids {
 
 static HashMap<String, UidAndGids>* s_user_map;
 static HashMap<pid_t, Service*> s_service_map;
+static HashMap<String, Service*> s_service_by_name_map;
+
+extern Core::ElapsedTimer g_startup_timer;
 
 void Service::resolve_user()
 {
@@ -85,6 +90,14 @@ Service* Service::find_by_pid(pid_t pid)
     return (*it).value;
 }
 
+Service* Service::find_by_name(const StringView& name)
+{
+    auto it = s_service_by_name_map.find(name);
+    if (it == s_service_by_name_map.end())
+        return nullptr;
+    return (*it).value;
+}
+
 static int ensure_parent_directories(const char* path)
 {
     ASSERT(path[0] == '/');
@@ -158,7 +171,7 @@ void Service::setup_notifier()
 
     m_socket_notifier = Core::Notifier::construct(m_socket_fd, Core::Notifier::Event::Read, this);
     m_socket_notifier->on_ready_to_read = [this] {
-        dbg() << "Ready to read on behalf of " << name();
+        dbg() << "Activating " << name() << " on first connection, " << g_startup_timer.elapsed() << " ms after startup";
         remove_child(*m_socket_notifier);
         m_socket_notifier = nullptr;
         spawn();
@@ -175,9 +188,24 @@ void Service::activate()
         spawn();
 }
 
+void Service::spawn_lazy_requirements()
+{
+    for (auto& requirement : m_requirements) {
+        auto* service = find_by_name(requirement);
+        // Services that aren't waiting on their socket are either running already or not ours to start.
+        if (!service || !service->m_socket_notifier)
+            continue;
+        dbg() << "Activating " << service->name() << ", which is required by " << name();
+        service->remove_child(*service->m_socket_notifier);
+        service->m_socket_notifier = nullptr;
+        service->spawn();
+    }
+}
+
 void Service::spawn()
 {
-    dbg() << "Spawning " << name();
+    // Get whatever we need going first; it starts up alongside us rather than on our first connection to it.
+    spawn_lazy_requirements();
 
     m_run_timer.start();
     m_pid = fork();
@@ -196,10 +224,11 @@ void Service::spawn()
         }
 
         struct sched_param p;
+        memset(&p, 0, sizeof(p));
         p.sched_priority = m_priority;
-        int rc = sched_setparam(0, &p);
+        int rc = sched_setscheduler(0, m_scheduling_policy, &p);
         if (rc < 0) {
-            perror("sched_setparam");
+            perror("sched_setscheduler");
             ASSERT_NOT_REACHED();
         }
 
@@ -261,6 +290,7 @@ void Service::spawn()
     } else {
         // We are the parent.
         s_service_map.set(m_pid, this);
+        dbg() << "Spawned " << name() << " (pid " << m_pid << ") " << g_startup_timer.elapsed() << " ms after startup, fork took " << m_run_timer.elapsed() << " ms";
     }
 }
 
@@ -268,7 +298,8 @@ void Service::did_exit(int exit_code)
 {
     ASSERT(m_pid > 0);
 
-    dbg() << "Service " << name() << " has exited with exit code " << exit_code;
+    int run_time_in_msec = m_run_timer.elapsed();
+    dbg() << "Service " << name() << " has exited with exit code " << exit_code << " after running for " << run_time_in_msec << " ms";
 
     s_service_map.remove(m_pid);
     m_pid = -1;
@@ -276,7 +307,6 @@ void Service::did_exit(int exit_code)
     if (!m_keep_alive)
         return;
 
-    int run_time_in_msec = m_run_timer.elapsed();
     bool exited_successfully = exit_code == 0;
 
     if (!exited_successfully && run_time_in_msec < 1000) {
@@ -314,7 +344,11 @@ Service::Service(const Core::ConfigFile& config, const StringView& name)
         m_priority = 30;
     else if (prio == "high")
         m_priority = 50;
-    else
+    else if (prio == "realtime") {
+        // Round-robin among other real-time threads, but ahead of everyone else.
+        m_scheduling_policy = SCHED_RR;
+        m_priority = 50;
+    } else
         ASSERT_NOT_REACHED();
 
     m_keep_alive = config.read_bool_entry(name, "KeepAlive");
@@ -327,6 +361,14 @@ Service::Service(const Core::ConfigFile& config, const StringView& name)
     m_working_directory = config.read_entry(name, "WorkingDirectory");
     m_environment = config.read_entry(name, "Environment").split(' ');
     m_boot_modes = config.read_entry(name, "BootModes", "graphical").split(',');
+    for (auto& requirement : config.read_entry(name, "Requires").split(',')) {
+        auto trimmed_requirement = requirement.trim_whitespace();
+        if (!trimmed_requirement.is_empty())
+            m_requirements.append(move(trimmed_requirement));
+    }
+
+    if (is_enabled())
+        s_service_by_name_map.set(this->name(), this);
 
     m_socket_path = config.read_entry(name, "Socket");
     if (!m_socket_path.is_null() && is_enabled()) {
@@ -366,6 +408,9 @@ void Service::save_to(JsonObject& json)
     json.set("socket_path", m_socket_path);
     json.set("socket_permissions", m_socket_permissions);
     json.set("lazy", m_lazy);
+    StringBuilder requirements;
+    requirements.join(',', m_requirements);
+    json.set("requires", requirements.to_string());
     json.set("user", m_user);
     json.set("uid", m_uid);
     json.set("gid", m_gid);
@@ -31,6 +31,7 @@
 #include <LibCore/ElapsedTimer.h>
 #include <LibCore/Notifier.h>
 #include <LibCore/Object.h>
+#include <sched.h>
 
 class Service final : public Core::Object {
     C_OBJECT(Service)
@@ -41,6 +42,9 @@ public:
     void did_exit(int exit_code);
 
     static Service* find_by_pid(pid_t);
+    static Service* find_by_name(const StringView&);
+
+    const Vector<String>& requirements() const { return m_requirements; }
 
     void save_to(AK::JsonObject&) override;
 
@@ -56,6 +60,7 @@ private:
     // File path to open as stdio fds.
     String m_stdio_file_path;
     int m_priority { 1 };
+    int m_scheduling_policy { SCHED_OTHER };
     // Whether we should re-launch it if it exits.
     bool m_keep_alive { false };
     // Path to the socket to create and listen on on behalf of this service.
@@ -75,6 +80,8 @@ private:
     Vector<String> m_boot_modes;
     // Environment variables to pass to the service.
     Vector<String> m_environment;
+    // Names of services that have to be activated before this one, and spawned along with it if they're lazy.
+    Vector<String> m_requirements;
 
     // PID of the running instance of this service.
     pid_t m_pid { -1 };
@@ -91,4 +98,5 @@ private:
     void resolve_user();
     void setup_socket();
     void setup_notifier();
+    void spawn_lazy_requirements();
 };
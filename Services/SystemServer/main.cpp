@@ -27,7 +27,9 @@
 #include "Service.h"
 #include <AK/Assertions.h>
 #include <AK/ByteBuffer.h>
+#include <AK/HashTable.h>
 #include <LibCore/ConfigFile.h>
+#include <LibCore/ElapsedTimer.h>
 #include <LibCore/Event.h>
 #include <LibCore/EventLoop.h>
 #include <LibCore/File.h>
@@ -39,6 +41,7 @@
 #include <unistd.h>
 
 String g_boot_mode = "graphical";
+Core::ElapsedTimer g_startup_timer;
 
 static void sigchld_handler(int)
 {
@@ -99,8 +102,33 @@ static void mount_all_filesystems()
     }
 }
 
+// Orders services so that each one comes after the services it requires.
+static void add_in_dependency_order(Service& service, Vector<Service*>& ordered, HashTable<Service*>& visited, HashTable<Service*>& visiting)
+{
+    if (visited.contains(&service))
+        return;
+    if (visiting.contains(&service)) {
+        dbg() << "Service " << service.name() << " is part of a dependency cycle, ignoring the requirement that closes it";
+        return;
+    }
+    visiting.set(&service);
+    for (auto& requirement : service.requirements()) {
+        auto* required_service = Service::find_by_name(requirement);
+        if (!required_service) {
+            dbg() << "Service " << service.name() << " requires " << requirement << ", which is not enabled";
+            continue;
+        }
+        add_in_dependency_order(*required_service, ordered, visited, visiting);
+    }
+    visiting.remove(&service);
+    visited.set(&service);
+    ordered.append(&service);
+}
+
 int main(int, char**)
 {
+    g_startup_timer.start();
+
     if (pledge("stdio proc exec tty accept unix rpath wpath cpath chown fattr id sigaction", nullptr) < 0) {
         perror("pledge");
         return 1;
@@ -128,10 +156,19 @@ int main(int, char**)
             services.append(service);
     }
 
-    // After we've set them all up, activate them!
-    dbg() << "Activating " << services.size() << " services...";
+    // After we've set them all up, activate them! Spawning doesn't wait for the child,
+    // and anyone connecting to a socket we've already bound just waits for its service,
+    // so the order only matters for what has been declared with Requires=.
+    Vector<Service*> ordered_services;
+    HashTable<Service*> visited;
+    HashTable<Service*> visiting;
     for (auto& service : services)
-        service.activate();
+        add_in_dependency_order(service, ordered_services, visited, visiting);
+
+    dbg() << "Activating " << ordered_services.size() << " services...";
+    for (auto* service : ordered_services)
+        service->activate();
+    dbg() << "Activated all services " << g_startup_timer.elapsed() << " ms after startup";
 
     return event_loop.exec();
 }
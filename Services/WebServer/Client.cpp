@@ -25,17 +25,26 @@
  */
 
 #include "Client.h"
+#include "FileCache.h"
 #include <AK/LexicalPath.h>
 #include <AK/StringBuilder.h>
 #include <LibCore/DateTime.h>
 #include <LibCore/DirIterator.h>
 #include <LibCore/File.h>
+#include <LibCore/Notifier.h>
+#include <LibCore/Timer.h>
 #include <LibHTTP/HttpRequest.h>
+#include <errno.h>
+#include <netinet/tcp.h>
 #include <stdio.h>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
 #include <sys/stat.h>
 #include <time.h>
 #include <unistd.h>
 
+//#define WEBSERVER_DEBUG
+
 namespace WebServer {
 
 Client::Client(NonnullRefPtr<Core::TCPSocket> socket, Core::Object* parent)
@@ -44,46 +53,149 @@ Client::Client(NonnullRefPtr<Core::TCPSocket> socket, Core::Object* parent)
 {
 }
 
+Client::~Client()
+{
+}
+
 void Client::die()
 {
-    remove_from_parent();
+    if (m_is_dead)
+        return;
+    m_is_dead = true;
+    m_socket->set_notifications_enabled(false);
+    if (m_write_notifier)
+        m_write_notifier->set_enabled(false);
+    m_idle_timer->stop();
+    // We're usually called back from something we own, so we go away once that has returned.
+    deferred_invoke([this](auto&) { remove_from_parent(); });
 }
 
 void Client::start()
 {
+    m_socket->set_blocking(false);
+    m_idle_timer = Core::Timer::create_single_shot(
+        keep_alive_timeout_ms, [this] { die(); }, this);
+    m_idle_timer->start();
     m_socket->on_ready_to_read = [this] {
-        auto raw_request = m_socket->read_all();
-        if (raw_request.is_null()) {
-            die();
-            return;
+        did_become_readable();
+    };
+}
+
+void Client::did_become_readable()
+{
+    for (;;) {
+        auto data = m_socket->read(16 * KB);
+        if (data.is_null()) {
+            if (m_socket->eof()) {
+                // The client won't ask for anything else, but may still be waiting for what it asked for already.
+                m_socket->set_notifications_enabled(false);
+                m_should_close_after_output = true;
+                break;
+            }
+            if (m_socket->error() != EAGAIN) {
+                die();
+                return;
+            }
+            break;
         }
+        m_request_buffer.append(data.data(), data.size());
+        if (m_request_buffer.size() > max_request_header_size)
+            break;
+    }
+    m_idle_timer->restart(keep_alive_timeout_ms);
+    handle_buffered_requests();
+}
 
-        dbg() << "Got raw request: '" << String::copy(raw_request) << "'";
+static Optional<size_t> find_end_of_request_header(const ByteBuffer& buffer)
+{
+    for (size_t i = 0; i + 4 <= buffer.size(); ++i) {
+        if (buffer[i] == '\r' && buffer[i + 1] == '\n' && buffer[i + 2] == '\r' && buffer[i + 3] == '\n')
+            return i + 4;
+    }
+    return {};
+}
 
-        handle_request(move(raw_request));
+void Client::handle_buffered_requests()
+{
+    // A request is only handled once the response to the one before it has gone out. Meanwhile, the ones
+    // that follow wait in the kernel, which makes a client that sends more than it reads wait too.
+    while (!m_is_dead && m_output.is_empty()) {
+        auto end_of_request = find_end_of_request_header(m_request_buffer);
+        if (!end_of_request.has_value()) {
+            if (m_request_buffer.size() > max_request_header_size)
+                die();
+            break;
+        }
+        auto raw_request = m_request_buffer.slice(0, end_of_request.value());
+        m_request_buffer = m_request_buffer.slice(end_of_request.value(), m_request_buffer.size() - end_of_request.value());
+        handle_request(raw_request);
+        flush_output();
+    }
+    if (m_is_dead)
+        return;
+    if (m_output.is_empty() && m_should_close_after_output) {
         die();
-    };
+        return;
+    }
+    if (!m_should_close_after_output)
+        m_socket->set_notifications_enabled(m_output.is_empty());
+}
+
+static Optional<String> header_value(const HTTP::HttpRequest& request, const StringView& name)
+{
+    for (auto& header : request.headers()) {
+        if (header.name.equals_ignoring_case(name))
+            return header.value;
+    }
+    return {};
 }
 
-void Client::handle_request(ByteBuffer raw_request)
+void Client::handle_request(const ByteBuffer& raw_request)
 {
+#ifdef WEBSERVER_DEBUG
+    dbg() << "Got raw request: '" << String::copy(raw_request) << "'";
+#endif
+
     auto request_or_error = HTTP::HttpRequest::from_raw_request(raw_request);
-    if (!request_or_error.has_value())
+    if (!request_or_error.has_value()) {
+        die();
         return;
+    }
     auto& request = request_or_error.value();
 
+#ifdef WEBSERVER_DEBUG
     dbg() << "Got HTTP request: " << request.method_name() << " " << request.resource();
     for (auto& header : request.headers()) {
         dbg() << "    " << header.name << " => " << header.value;
     }
+#endif
+
+    // HTTP/1.1 connections stay open unless the client says otherwise, and HTTP/1.0 ones only if it asks.
+    auto connection = header_value(request, "Connection");
+    if (request.protocol() == "HTTP/1.1") {
+        if (connection.has_value() && connection.value().equals_ignoring_case("close"))
+            m_should_close_after_output = true;
+    } else {
+        if (!connection.has_value() || !connection.value().equals_ignoring_case("keep-alive"))
+            m_should_close_after_output = true;
+    }
 
-    if (request.method() != HTTP::HttpRequest::Method::GET) {
+    if (request.method() != HTTP::HttpRequest::Method::GET && request.method() != HTTP::HttpRequest::Method::HEAD) {
+        // We don't know where the body of such a request ends, so we can't read the next one after it.
+        m_should_close_after_output = true;
         send_error_response(403, "Forbidden, bro!", request);
         return;
     }
 
-    auto requested_path = LexicalPath::canonicalized_path(request.resource());
+    auto resource = request.resource();
+    auto query_start = resource.index_of("?");
+    if (query_start.has_value())
+        resource = resource.substring(0, query_start.value());
+
+    auto requested_path = LexicalPath::canonicalized_path(resource);
+#ifdef WEBSERVER_DEBUG
     dbg() << "Canonical requested path: '" << requested_path << "'";
+#endif
 
     StringBuilder path_builder;
     path_builder.append("/www/");
@@ -92,7 +204,7 @@ void Client::handle_request(ByteBuffer raw_request)
 
     if (Core::File::is_directory(real_path)) {
 
-        if (!request.resource().ends_with("/")) {
+        if (!resource.ends_with("/")) {
             StringBuilder red;
 
             red.append(requested_path);
@@ -113,39 +225,313 @@ void Client::handle_request(ByteBuffer raw_request)
         real_path = index_html_path;
     }
 
-    auto file = Core::File::construct(real_path);
-    if (!file->open(Core::File::ReadOnly)) {
+    serve_file(real_path, request);
+}
+
+static String http_date(time_t timestamp)
+{
+    struct tm tm;
+    gmtime_r(&timestamp, &tm);
+    char buffer[64];
+    strftime(buffer, sizeof(buffer), "%a, %d %b %Y %H:%M:%S GMT", &tm);
+    return buffer;
+}
+
+static const char* guess_content_type(const String& path)
+{
+    if (path.ends_with(".html") || path.ends_with(".htm"))
+        return "text/html";
+    if (path.ends_with(".css"))
+        return "text/css";
+    if (path.ends_with(".js"))
+        return "application/javascript";
+    if (path.ends_with(".json"))
+        return "application/json";
+    if (path.ends_with(".png"))
+        return "image/png";
+    if (path.ends_with(".gif"))
+        return "image/gif";
+    if (path.ends_with(".jpg") || path.ends_with(".jpeg"))
+        return "image/jpeg";
+    if (path.ends_with(".svg"))
+        return "image/svg+xml";
+    if (path.ends_with(".md"))
+        return "text/markdown";
+    return "text/plain";
+}
+
+// Whether an If-None-Match header names the entity tag we have.
+static bool entity_tag_list_matches(const String& list, const String& entity_tag)
+{
+    for (auto& part : list.split(',')) {
+        auto candidate = part.trim_whitespace();
+        if (candidate == "*")
+            return true;
+        // Weak comparison is what conditional GETs call for.
+        if (candidate.starts_with("W/"))
+            candidate = candidate.substring(2, candidate.length() - 2);
+        if (candidate == entity_tag)
+            return true;
+    }
+    return false;
+}
+
+struct ByteRange {
+    enum class Kind {
+        // The whole file is sent, as if no range was asked for.
+        Ignored,
+        Satisfiable,
+        Unsatisfiable,
+    };
+    Kind kind { Kind::Ignored };
+    off_t start { 0 };
+    off_t length { 0 };
+};
+
+// Only a single range is supported; several would need a multipart response, so those get the whole file.
+static ByteRange parse_byte_range(const String& value, off_t size)
+{
+    if (!value.starts_with("bytes="))
+        return {};
+    auto spec = value.substring_view(6, value.length() - 6);
+    if (spec.contains(','))
+        return {};
+    auto dash = spec.find_first_of('-');
+    if (!dash.has_value())
+        return {};
+    auto first = spec.substring_view(0, dash.value());
+    auto last = spec.substring_view(dash.value() + 1, spec.length() - dash.value() - 1);
+
+    bool ok;
+    if (first.is_empty()) {
+        // The last so many bytes.
+        off_t suffix_length = last.to_uint(ok);
+        if (!ok)
+            return {};
+        if (!suffix_length || !size)
+            return { ByteRange::Kind::Unsatisfiable };
+        auto length = min(suffix_length, size);
+        return { ByteRange::Kind::Satisfiable, size - length, length };
+    }
+
+    off_t start = first.to_uint(ok);
+    if (!ok)
+        return {};
+    if (start >= size)
+        return { ByteRange::Kind::Unsatisfiable };
+    off_t end = size - 1;
+    if (!last.is_empty()) {
+        end = last.to_uint(ok);
+        if (!ok || end < start)
+            return {};
+        end = min(end, size - 1);
+    }
+    return { ByteRange::Kind::Satisfiable, start, end - start + 1 };
+}
+
+void Client::serve_file(const String& real_path, const HTTP::HttpRequest& request)
+{
+    struct stat st;
+    if (stat(real_path.characters(), &st) < 0 || !S_ISREG(st.st_mode)) {
         send_error_response(404, "Not found, bro!", request);
         return;
     }
 
-    send_response(file->read_all(), request);
+    auto entity_tag = String::format("\"%llx-%llx-%llx\"", (u64)st.st_ino, (u64)st.st_size, (u64)st.st_mtime);
+    auto last_modified = http_date(st.st_mtime);
+    auto append_validators = [&](StringBuilder& builder) {
+        builder.appendf("ETag: %s\r\n", entity_tag.characters());
+        builder.appendf("Last-Modified: %s\r\n", last_modified.characters());
+    };
+
+    // A client that has the file already only needs to hear that it hasn't changed. Clients send back the
+    // Last-Modified they were given, so only that exact date counts as unchanged.
+    auto if_none_match = header_value(request, "If-None-Match");
+    auto if_modified_since = header_value(request, "If-Modified-Since");
+    bool is_unchanged = if_none_match.has_value()
+        ? entity_tag_list_matches(if_none_match.value(), entity_tag)
+        : if_modified_since.has_value() && if_modified_since.value() == last_modified;
+    if (is_unchanged) {
+        StringBuilder builder;
+        begin_response_header(builder, 304, "Not Modified");
+        append_validators(builder);
+        builder.append("\r\n");
+        queue_output(builder.to_byte_buffer());
+        log_response(304, request);
+        return;
+    }
+
+    off_t size = st.st_size;
+    ByteRange range;
+    auto range_header = header_value(request, "Range");
+    auto if_range = header_value(request, "If-Range");
+    // A range of a file that has changed since the client got the rest of it would be no use to it.
+    if (range_header.has_value() && (!if_range.has_value() || if_range.value() == entity_tag || if_range.value() == last_modified))
+        range = parse_byte_range(range_header.value(), size);
+
+    if (range.kind == ByteRange::Kind::Unsatisfiable) {
+        StringBuilder builder;
+        begin_response_header(builder, 416, "Range Not Satisfiable");
+        builder.appendf("Content-Range: bytes */%llu\r\n", (u64)size);
+        builder.append("Content-Length: 0\r\n");
+        builder.append("\r\n");
+        queue_output(builder.to_byte_buffer());
+        log_response(416, request);
+        return;
+    }
+    if (range.kind == ByteRange::Kind::Ignored)
+        range = { ByteRange::Kind::Ignored, 0, size };
+    bool is_partial = range.kind == ByteRange::Kind::Satisfiable;
+    bool should_send_body = request.method() != HTTP::HttpRequest::Method::HEAD && range.length;
+
+    // Small files come out of memory, and go out along with the header. Anything bigger is moved from the
+    // file into the socket by the kernel, without passing through our memory.
+    ByteBuffer data;
+    RefPtr<Core::File> file;
+    if (should_send_body) {
+        if (size <= (off_t)FileCache::max_file_size) {
+            data = FileCache::the().contents(real_path, st);
+            if ((off_t)data.size() < range.start + range.length) {
+                send_error_response(500, "Internal server error", request);
+                return;
+            }
+        } else {
+            file = Core::File::construct(real_path);
+            if (!file->open(Core::File::ReadOnly)) {
+                send_error_response(404, "Not found, bro!", request);
+                return;
+            }
+        }
+    }
+
+    unsigned code = is_partial ? 206 : 200;
+    StringBuilder builder;
+    begin_response_header(builder, code, is_partial ? "Partial Content" : "OK");
+    builder.appendf("Content-Type: %s\r\n", guess_content_type(real_path));
+    builder.appendf("Content-Length: %llu\r\n", (u64)range.length);
+    builder.append("Accept-Ranges: bytes\r\n");
+    if (is_partial)
+        builder.appendf("Content-Range: bytes %llu-%llu/%llu\r\n", (u64)range.start, (u64)(range.start + range.length - 1), (u64)size);
+    append_validators(builder);
+    builder.append("\r\n");
+
+    auto header = builder.to_byte_buffer();
+    if (!data.is_null())
+        header.append(data.data() + range.start, range.length);
+    queue_output(move(header));
+    if (file)
+        queue_file_output(file.release_nonnull(), range.start, range.length);
+
+    log_response(code, request);
 }
 
-void Client::send_response(StringView response, const HTTP::HttpRequest& request)
+void Client::begin_response_header(StringBuilder& builder, unsigned code, const StringView& reason)
 {
-    StringBuilder builder;
-    builder.append("HTTP/1.0 200 OK\r\n");
+    builder.appendf("HTTP/1.1 %u ", code);
+    builder.append(reason);
+    builder.append("\r\n");
     builder.append("Server: WebServer (SerenityOS)\r\n");
-    builder.append("Content-Type: text/html\r\n");
+    builder.appendf("Date: %s\r\n", http_date(time(nullptr)).characters());
+    builder.append(m_should_close_after_output ? "Connection: close\r\n" : "Connection: keep-alive\r\n");
+}
+
+void Client::send_response(unsigned code, const StringView& reason, const StringView& content_type, const StringView& body, const HTTP::HttpRequest& request)
+{
+    StringBuilder builder;
+    begin_response_header(builder, code, reason);
+    builder.append("Content-Type: ");
+    builder.append(content_type);
     builder.append("\r\n");
+    builder.appendf("Content-Length: %zu\r\n", body.length());
+    builder.append("\r\n");
+    if (request.method() != HTTP::HttpRequest::Method::HEAD)
+        builder.append(body);
+    queue_output(builder.to_byte_buffer());
 
-    m_socket->write(builder.to_string());
-    m_socket->write(response);
+    log_response(code, request);
+}
 
-    log_response(200, request);
+void Client::queue_output(ByteBuffer data)
+{
+    if (data.is_empty())
+        return;
+    size_t size = data.size();
+    m_output.append({ move(data), nullptr, 0, size });
+}
+
+void Client::queue_file_output(NonnullRefPtr<Core::File> file, off_t offset, size_t size)
+{
+    m_output.append({ {}, move(file), offset, size });
+}
+
+void Client::set_corked(bool corked)
+{
+    if (m_is_corked == corked)
+        return;
+    m_is_corked = corked;
+    int value = corked;
+    setsockopt(m_socket->fd(), IPPROTO_TCP, TCP_CORK, &value, sizeof(value));
+}
+
+void Client::flush_output()
+{
+    // Hold a header back so it goes out together with the start of the file that follows it.
+    if (m_output.size() > 1)
+        set_corked(true);
+
+    while (!m_output.is_empty()) {
+        auto& part = m_output.first();
+        ssize_t nwritten;
+        if (part.file) {
+            nwritten = sendfile(m_socket->fd(), part.file->fd(), &part.offset, part.size);
+            if (nwritten < 0 && errno != EAGAIN)
+                perror("sendfile");
+        } else {
+            nwritten = write(m_socket->fd(), part.data.data() + part.offset, part.size);
+            if (nwritten > 0)
+                part.offset += nwritten;
+        }
+
+        if (nwritten < 0 && errno == EAGAIN) {
+            if (!m_write_notifier) {
+                m_write_notifier = Core::Notifier::construct(m_socket->fd(), Core::Notifier::Write, this);
+                m_write_notifier->on_ready_to_write = [this] {
+                    flush_output();
+                    if (m_output.is_empty())
+                        handle_buffered_requests();
+                };
+            }
+            m_write_notifier->set_enabled(true);
+            return;
+        }
+        // Either the client has gone away, or the file has become shorter than it was.
+        if (nwritten <= 0) {
+            die();
+            return;
+        }
+
+        m_idle_timer->restart(keep_alive_timeout_ms);
+        part.size -= nwritten;
+        if (!part.size)
+            m_output.take_first();
+    }
+
+    if (m_write_notifier)
+        m_write_notifier->set_enabled(false);
+    set_corked(false);
 }
 
 void Client::send_redirect(StringView redirect_path, const HTTP::HttpRequest& request)
 {
     StringBuilder builder;
-    builder.append("HTTP/1.0 301 Moved Permanently\r\n");
+    begin_response_header(builder, 301, "Moved Permanently");
     builder.append("Location: ");
     builder.append(redirect_path);
     builder.append("\r\n");
+    builder.append("Content-Length: 0\r\n");
     builder.append("\r\n");
 
-    m_socket->write(builder.to_string());
+    queue_output(builder.to_byte_buffer());
 
     log_response(301, request);
 }
@@ -200,22 +586,17 @@ void Client::handle_directory_listing(const String& requested_path, const String
     builder.append("</body>\n");
     builder.append("</html>\n");
 
-    send_response(builder.to_string(), request);
+    send_response(200, "OK", "text/html", builder.to_string(), request);
 }
 
 void Client::send_error_response(unsigned code, const StringView& message, const HTTP::HttpRequest& request)
 {
     StringBuilder builder;
-    builder.appendf("HTTP/1.0 %u ", code);
-    builder.append(message);
-    builder.append("\r\n\r\n");
     builder.append("<!DOCTYPE html><html><body><h1>");
     builder.appendf("%u ", code);
     builder.append(message);
     builder.append("</h1></body></html>");
-    m_socket->write(builder.to_string());
-
-    log_response(code, request);
+    send_response(code, message, "text/html", builder.to_string(), request);
 }
 
 void Client::log_response(unsigned code, const HTTP::HttpRequest& request)
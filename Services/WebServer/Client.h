@@ -26,29 +26,69 @@
 
 #pragma once
 
+#include <AK/ByteBuffer.h>
+#include <AK/Vector.h>
+#include <LibCore/Forward.h>
 #include <LibCore/Object.h>
 #include <LibCore/TCPSocket.h>
 #include <LibHTTP/Forward.h>
 
 namespace WebServer {
 
+// One connection, which may carry any number of requests one after another. Nothing here blocks: requests are
+// handled as they arrive, and responses go out as fast as the connection takes them.
 class Client final : public Core::Object {
     C_OBJECT(Client);
 public:
+    virtual ~Client() override;
+
     void start();
 
 private:
     Client(NonnullRefPtr<Core::TCPSocket>, Core::Object* parent);
 
-    void handle_request(ByteBuffer);
-    void send_response(StringView, const HTTP::HttpRequest&);
+    // How long a connection may sit idle between requests before we close it.
+    static constexpr int keep_alive_timeout_ms = 15000;
+    // How much of a request we take in without seeing the end of its header.
+    static constexpr size_t max_request_header_size = 64 * KB;
+
+    void did_become_readable();
+    void handle_buffered_requests();
+    void handle_request(const ByteBuffer&);
+    void serve_file(const String& real_path, const HTTP::HttpRequest&);
+    void send_response(unsigned code, const StringView& reason, const StringView& content_type, const StringView& body, const HTTP::HttpRequest&);
     void send_redirect(StringView redirect, const HTTP::HttpRequest& request);
     void send_error_response(unsigned code, const StringView& message, const HTTP::HttpRequest&);
+    void handle_directory_listing(const String& requested_path, const String& real_path, const HTTP::HttpRequest&);
     void die();
     void log_response(unsigned code, const HTTP::HttpRequest&);
-    void handle_directory_listing(const String& requested_path, const String& real_path, const HTTP::HttpRequest&);
+
+    // Starts a response header with the status line and the headers that every response has.
+    void begin_response_header(StringBuilder&, unsigned code, const StringView& reason);
+
+    void queue_output(ByteBuffer);
+    void queue_file_output(NonnullRefPtr<Core::File>, off_t offset, size_t size);
+    void flush_output();
+    void set_corked(bool);
+
+    // What's left to send of the responses so far, in order: pieces of memory, and ranges of files that go out
+    // through sendfile().
+    struct OutputPart {
+        ByteBuffer data;
+        RefPtr<Core::File> file;
+        off_t offset { 0 };
+        size_t size { 0 };
+    };
 
     NonnullRefPtr<Core::TCPSocket> m_socket;
+    RefPtr<Core::Notifier> m_write_notifier;
+    RefPtr<Core::Timer> m_idle_timer;
+    // What has arrived of requests we haven't handled yet.
+    ByteBuffer m_request_buffer;
+    Vector<OutputPart> m_output;
+    bool m_should_close_after_output { false };
+    bool m_is_corked { false };
+    bool m_is_dead { false };
 };
 
 }
@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "FileCache.h"
+#include <LibCore/File.h>
+
+namespace WebServer {
+
+FileCache& FileCache::the()
+{
+    static FileCache* s_the;
+    if (!s_the)
+        s_the = new FileCache;
+    return *s_the;
+}
+
+ByteBuffer FileCache::contents(const String& path, const struct stat& st)
+{
+    auto it = m_entries.find(path);
+    if (it != m_entries.end()) {
+        auto& entry = it->value;
+        if (entry.inode == st.st_ino && entry.size == st.st_size && entry.modification_time == st.st_mtime) {
+            entry.last_use = ++m_use_counter;
+            return entry.data;
+        }
+        m_total_size -= entry.data.size();
+        m_entries.remove(it);
+    }
+
+    auto file = Core::File::construct(path);
+    if (!file->open(Core::IODevice::ReadOnly))
+        return {};
+    auto data = file->read_all();
+    // The file is changing under us, so it's not worth keeping.
+    if ((off_t)data.size() != st.st_size)
+        return data;
+    if (data.size() > max_file_size)
+        return data;
+
+    evict_until_total_size_is_at_most(max_total_size - data.size());
+    m_entries.set(path, { st.st_ino, st.st_size, st.st_mtime, data, ++m_use_counter });
+    m_total_size += data.size();
+    return data;
+}
+
+void FileCache::evict_until_total_size_is_at_most(size_t size)
+{
+    while (m_total_size > size) {
+        auto least_recently_used = m_entries.begin();
+        for (auto it = m_entries.begin(); it != m_entries.end(); ++it) {
+            if (it->value.last_use < least_recently_used->value.last_use)
+                least_recently_used = it;
+        }
+        m_total_size -= least_recently_used->value.data.size();
+        m_entries.remove(least_recently_used);
+    }
+}
+
+}
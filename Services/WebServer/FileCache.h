@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/ByteBuffer.h>
+#include <AK/HashMap.h>
+#include <AK/String.h>
+#include <sys/stat.h>
+
+namespace WebServer {
+
+// Keeps the contents of small files that were served recently, so serving them again doesn't need to read them.
+// An entry is only used while the file's inode, size and modification time are still what they were.
+class FileCache {
+public:
+    static FileCache& the();
+
+    static constexpr size_t max_file_size = 64 * KB;
+    static constexpr size_t max_total_size = 4 * MB;
+
+    // Returns the contents of the file at `path`, which `st` describes, or a null buffer if it can't be read.
+    ByteBuffer contents(const String& path, const struct stat& st);
+
+private:
+    struct Entry {
+        ino_t inode { 0 };
+        off_t size { 0 };
+        time_t modification_time { 0 };
+        ByteBuffer data;
+        u64 last_use { 0 };
+    };
+
+    void evict_until_total_size_is_at_most(size_t);
+
+    HashMap<String, Entry> m_entries;
+    size_t m_total_size { 0 };
+    u64 m_use_counter { 0 };
+};
+
+}
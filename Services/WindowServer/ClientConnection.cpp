@@ -495,6 +495,7 @@ void ClientConnection::post_paint_message(Window& window, bool ignore_occlusion)
     if (window.is_minimized() || (!ignore_occlusion && window.is_occluded()))
         return;
 
+    window.did_request_paint();
     post_message(Messages::WindowClient::Paint(window.window_id(), window.size(), rect_set.rects()));
 }
 
@@ -521,6 +522,9 @@ void ClientConnection::handle(const Messages::WindowServer::DidFinishPainting& m
     auto& window = *(*it).value;
     for (auto& rect : message.rects())
         window.invalidate(rect);
+    auto paint_time = window.did_finish_paint();
+    if (paint_time.has_value())
+        Compositor::the().did_finish_client_paint(window, paint_time.value());
 
     WindowSwitcher::the().refresh_if_needed();
 }
@@ -547,12 +551,32 @@ OwnPtr<Messages::WindowServer::SetWindowBackingStoreResponse> ClientConnection::
         window.set_backing_store(move(backing_store));
     }
 
-    if (message.flush_immediately())
-        window.invalidate();
+    if (!message.dirty_rects().is_empty()) {
+        for (auto& rect : message.dirty_rects())
+            window.invalidate(rect);
+        auto paint_time = window.did_finish_paint();
+        if (paint_time.has_value())
+            Compositor::the().did_finish_client_paint(window, paint_time.value());
+        WindowSwitcher::the().refresh_if_needed();
+    }
 
     return make<Messages::WindowServer::SetWindowBackingStoreResponse>();
 }
 
+OwnPtr<Messages::WindowServer::GetCompositorStatisticsResponse> ClientConnection::handle(const Messages::WindowServer::GetCompositorStatistics&)
+{
+    auto& statistics = Compositor::the().statistics();
+    return make<Messages::WindowServer::GetCompositorStatisticsResponse>(
+        statistics.frames_per_second,
+        statistics.last_compose_time,
+        statistics.average_compose_time,
+        statistics.dirty_rect_count,
+        statistics.flushed_bytes,
+        statistics.occluded_window_count,
+        statistics.slowest_client_paint_time,
+        statistics.slowest_client_paint_title);
+}
+
 OwnPtr<Messages::WindowServer::SetGlobalCursorTrackingResponse> ClientConnection::handle(const Messages::WindowServer::SetGlobalCursorTracking& message)
 {
     int window_id = message.window_id();
@@ -33,12 +33,21 @@
 #include "WindowManager.h"
 #include <AK/Memory.h>
 #include <LibCore/Timer.h>
+#include <LibGfx/BlendKernels.h>
 #include <LibGfx/Font.h>
 #include <LibGfx/Painter.h>
 #include <LibThread/BackgroundAction.h>
+#include <time.h>
 
 namespace WindowServer {
 
+static u64 monotonic_microseconds()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (u64)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
 Compositor& Compositor::the()
 {
     static Compositor s_the;
@@ -58,25 +67,47 @@ WallpaperMode mode_to_enum(const String& name)
     return WallpaperMode::Simple;
 }
 
+// Paints the part of the desktop background in `rect`: the background color, and the wallpaper laid out
+// for `mode` on a screen of `screen_size`. This may run on the background thread.
+static void paint_background(Gfx::Painter& painter, const Gfx::Rect& rect, Color background_color, const Gfx::Bitmap* wallpaper, WallpaperMode mode, const Gfx::Size& screen_size)
+{
+    // FIXME: If the wallpaper is opaque, no need to fill with color!
+    painter.fill_rect(rect, background_color);
+    if (!wallpaper)
+        return;
+    if (mode == WallpaperMode::Simple) {
+        painter.blit(rect.location(), *wallpaper, rect);
+    } else if (mode == WallpaperMode::Center) {
+        Gfx::Point offset { screen_size.width() / 2 - wallpaper->size().width() / 2,
+            screen_size.height() / 2 - wallpaper->size().height() / 2 };
+        painter.blit_offset(rect.location(), *wallpaper, rect, offset);
+    } else if (mode == WallpaperMode::Tile) {
+        painter.draw_tiled_bitmap(rect, *wallpaper);
+    } else if (mode == WallpaperMode::Scaled) {
+        float hscale = (float)wallpaper->size().width() / (float)screen_size.width();
+        float vscale = (float)wallpaper->size().height() / (float)screen_size.height();
+
+        painter.blit_scaled(rect, *wallpaper, rect, hscale, vscale);
+    } else {
+        ASSERT_NOT_REACHED();
+    }
+}
+
 Compositor::Compositor()
 {
-    m_display_link_notify_timer = add<Core::Timer>(
-        1000 / 60, [this] {
-            notify_display_links();
+    m_frame_timer = add<Core::Timer>(
+        refresh_interval, [this] {
+            on_frame_tick();
         });
-    m_display_link_notify_timer->stop();
-
-    m_compose_timer = Core::Timer::create_single_shot(
-        1000 / 60,
-        [this] {
-            compose();
-        },
-        this);
+    m_frame_timer->stop();
 
     m_immediate_compose_timer = Core::Timer::create_single_shot(
         0,
         [this] {
             compose();
+            // Anything invalidated from here on waits for the next refresh.
+            if (!m_frame_timer->is_active())
+                m_frame_timer->start();
         },
         this);
 
@@ -89,7 +120,13 @@ void Compositor::init_bitmaps()
     auto& screen = Screen::the();
     auto size = screen.size();
 
-    m_front_bitmap = Gfx::Bitmap::create_wrapper(Gfx::BitmapFormat::RGB32, size, screen.pitch(), screen.scanline(0));
+    if (screen.bpp() == 16) {
+        // An RGB565 framebuffer can't be painted into directly. The front buffer lives in memory instead,
+        // and update_screen() converts whatever changes in it.
+        m_front_bitmap = Gfx::Bitmap::create(Gfx::BitmapFormat::RGB32, size);
+    } else {
+        m_front_bitmap = Gfx::Bitmap::create_wrapper(Gfx::BitmapFormat::RGB32, size, screen.pitch(), screen.scanline(0));
+    }
 
     if (m_screen_can_set_buffer)
         m_back_bitmap = Gfx::Bitmap::create_wrapper(Gfx::BitmapFormat::RGB32, size, screen.pitch(), screen.scanline(size.height()));
@@ -100,6 +137,10 @@ void Compositor::init_bitmaps()
     m_back_painter = make<Gfx::Painter>(*m_back_bitmap);
 
     m_buffers_are_flipped = false;
+    m_last_frame_dirty_rects.clear();
+    invalidate_wallpaper_cache();
+    // The saved pixels belong to the old framebuffer; the next composition draws the cursor afresh.
+    m_last_cursor_rect = {};
 
     invalidate();
 }
@@ -109,7 +150,9 @@ void Compositor::compose()
     auto& wm = WindowManager::the();
     if (m_wallpaper_mode == WallpaperMode::Unchecked)
         m_wallpaper_mode = mode_to_enum(wm.config()->read_entry("Background", "Mode", "simple"));
-    auto& ws = Screen::the();
+
+    if (m_occlusions_dirty)
+        recompute_occlusions();
 
     auto dirty_rects = move(m_dirty_rects);
 
@@ -118,62 +161,57 @@ void Compositor::compose()
         return;
     }
 
+    u64 compose_start = monotonic_microseconds();
+
     dirty_rects.add(Gfx::Rect::intersection(m_last_geometry_label_rect, Screen::the().rect()));
-    dirty_rects.add(Gfx::Rect::intersection(m_last_cursor_rect, Screen::the().rect()));
+    dirty_rects.add(Gfx::Rect::intersection(m_last_statistics_rect, Screen::the().rect()));
     dirty_rects.add(Gfx::Rect::intersection(m_last_dnd_rect, Screen::the().rect()));
-    dirty_rects.add(Gfx::Rect::intersection(current_cursor_rect(), Screen::the().rect()));
 
-    auto any_dirty_rect_intersects_window = [&dirty_rects](const Window& window) {
-        auto window_frame_rect = window.frame().rect();
-        for (auto& dirty_rect : dirty_rects.rects()) {
-            if (dirty_rect.intersects(window_frame_rect))
-                return true;
-        }
-        return false;
-    };
-
-    Color background_color = wm.palette().desktop_background();
-    String background_color_entry = wm.config()->read_entry("Background", "Color", "");
-    if (!background_color_entry.is_empty()) {
-        background_color = Color::from_string(background_color_entry).value_or(background_color);
+    if (m_screen_can_set_buffer) {
+        // The back buffer still holds the frame before last, so whatever changed in the last frame has
+        // to be painted into it again, on top of what changed since. That's what saves copying the
+        // changes back from the front buffer after every flip.
+        auto this_frame_dirty_rects = dirty_rects.rects();
+        for (auto& rect : m_last_frame_dirty_rects)
+            dirty_rects.add(rect);
+        m_last_frame_dirty_rects = move(this_frame_dirty_rects);
     }
 
-    // Paint the wallpaper.
-    for (auto& dirty_rect : dirty_rects.rects()) {
-        if (any_opaque_window_contains_rect(dirty_rect))
-            continue;
-        // FIXME: If the wallpaper is opaque, no need to fill with color!
-        m_back_painter->fill_rect(dirty_rect, background_color);
-        if (m_wallpaper) {
-            if (m_wallpaper_mode == WallpaperMode::Simple) {
-                m_back_painter->blit(dirty_rect.location(), *m_wallpaper, dirty_rect);
-            } else if (m_wallpaper_mode == WallpaperMode::Center) {
-                Gfx::Point offset { ws.size().width() / 2 - m_wallpaper->size().width() / 2,
-                    ws.size().height() / 2 - m_wallpaper->size().height() / 2 };
-                m_back_painter->blit_offset(dirty_rect.location(), *m_wallpaper,
-                    dirty_rect, offset);
-            } else if (m_wallpaper_mode == WallpaperMode::Tile) {
-                m_back_painter->draw_tiled_bitmap(dirty_rect, *m_wallpaper);
-            } else if (m_wallpaper_mode == WallpaperMode::Scaled) {
-                float hscale = (float)m_wallpaper->size().width() / (float)ws.size().width();
-                float vscale = (float)m_wallpaper->size().height() / (float)ws.size().height();
-
-                m_back_painter->blit_scaled(dirty_rect, *m_wallpaper, dirty_rect, hscale, vscale);
-            } else {
-                ASSERT_NOT_REACHED();
+    // Calls `callback` with each non-empty intersection of a dirty rect with one of `visible_rects`.
+    // Both sets are disjoint, so every damaged pixel that can be seen is visited exactly once.
+    auto for_each_visible_dirty_rect = [&dirty_rects](const auto& visible_rects, auto callback) {
+        for (auto& visible_rect : visible_rects) {
+            for (auto& dirty_rect : dirty_rects.rects()) {
+                auto rect = dirty_rect.intersected(visible_rect);
+                if (!rect.is_empty())
+                    callback(rect);
             }
         }
-    }
+    };
+
+    // Paint the wallpaper. Until the background has been rendered into the cache, it's painted directly.
+    if (!m_wallpaper_cache)
+        render_wallpaper_cache();
+    Optional<Color> background_color;
+    for_each_visible_dirty_rect(m_wallpaper_visible_rects, [&](const Gfx::Rect& dirty_rect) {
+        if (m_wallpaper_cache) {
+            m_back_painter->blit(dirty_rect.location(), *m_wallpaper_cache, dirty_rect);
+            return;
+        }
+        if (!background_color.has_value())
+            background_color = this->background_color();
+        paint_background(*m_back_painter, dirty_rect, background_color.value(), m_wallpaper, m_wallpaper_mode, Screen::the().size());
+    });
 
     auto compose_window = [&](Window& window) -> IterationDecision {
-        if (!any_dirty_rect_intersects_window(window))
-            return IterationDecision::Continue;
         Gfx::PainterStateSaver saver(*m_back_painter);
         m_back_painter->add_clip_rect(window.frame().rect());
         RefPtr<Gfx::Bitmap> backing_store = window.backing_store();
-        for (auto& dirty_rect : dirty_rects.rects()) {
-            if (!window.is_fullscreen() && any_opaque_window_above_this_one_contains_rect(window, dirty_rect))
-                continue;
+        // A fullscreen window is composited on its own, so nothing in front of it can hide any of it.
+        Vector<Gfx::Rect, 4> fullscreen_rects;
+        if (window.is_fullscreen())
+            fullscreen_rects.append(window.frame().rect());
+        for_each_visible_dirty_rect(window.is_fullscreen() ? fullscreen_rects : window.visible_rects(), [&](const Gfx::Rect& dirty_rect) {
             Gfx::PainterStateSaver saver(*m_back_painter);
             m_back_painter->add_clip_rect(dirty_rect);
             if (!backing_store)
@@ -181,7 +219,7 @@ void Compositor::compose()
             if (!window.is_fullscreen())
                 window.frame().paint(*m_back_painter);
             if (!backing_store)
-                continue;
+                return;
 
             // Decide where we would paint this window's backing store.
             // This is subtly different from widow.rect(), because window
@@ -222,13 +260,13 @@ void Compositor::compose()
                                                               .translated(-backing_rect.location());
 
             if (dirty_rect_in_backing_coordinates.is_empty())
-                continue;
+                return;
             auto dst = backing_rect.location().translated(dirty_rect_in_backing_coordinates.location());
 
             m_back_painter->blit(dst, *backing_store, dirty_rect_in_backing_coordinates, window.opacity());
             for (auto background_rect : window.rect().shatter(backing_rect))
                 m_back_painter->fill_rect(background_rect, wm.palette().window());
-        }
+        });
         return IterationDecision::Continue;
     };
 
@@ -245,53 +283,112 @@ void Compositor::compose()
 
     run_animations();
 
-    draw_cursor();
+    if (!m_show_statistics.has_value())
+        m_show_statistics = wm.config()->read_bool_entry("Compositor", "ShowStatistics", false);
+    if (m_show_statistics.value())
+        draw_statistics();
+    else
+        m_last_statistics_rect = {};
+
+    draw_dnd();
+
+    // The cursor isn't part of the composited frame. Lift it off the front buffer so the new frame
+    // goes underneath it, then put it back on top.
+    remove_cursor();
 
     if (m_flash_flush) {
-        for (auto& rect : dirty_rects.rects())
+        for (auto& rect : dirty_rects.rects()) {
             m_front_painter->fill_rect(rect, Color::Yellow);
+            update_screen(rect);
+        }
     }
 
-    if (m_screen_can_set_buffer)
+    if (m_screen_can_set_buffer) {
         flip_buffers();
+    } else {
+        for (auto& r : dirty_rects.rects())
+            flush(r);
+    }
 
-    for (auto& r : dirty_rects.rects())
-        flush(r);
+    draw_cursor();
+
+    u64 compose_end = monotonic_microseconds();
+    m_statistics.last_compose_time = compose_end - compose_start;
+    m_statistics.average_compose_time = m_statistics.average_compose_time ? (m_statistics.average_compose_time * 15 + m_statistics.last_compose_time) / 16 : m_statistics.last_compose_time;
+    m_statistics.dirty_rect_count = dirty_rects.size();
+    u64 flushed_pixels = 0;
+    for (auto& rect : dirty_rects.rects())
+        flushed_pixels += rect.width() * rect.height();
+    m_statistics.flushed_bytes = flushed_pixels * Screen::the().bpp() / 8;
+    ++m_frames_this_second;
+    update_statistics_for_second(compose_end);
 }
 
-void Compositor::flush(const Gfx::Rect& a_rect)
+void Compositor::update_statistics_for_second(u64 now)
 {
-    auto rect = Gfx::Rect::intersection(a_rect, Screen::the().rect());
+    u64 elapsed = now - m_statistics_second_start;
+    if (elapsed < 1000000)
+        return;
+    // If the compositor has been idle for longer than that, there's nothing to report for the last second.
+    bool was_idle = elapsed >= 2000000;
+    m_statistics.frames_per_second = was_idle ? 0 : m_frames_this_second;
+    m_statistics.slowest_client_paint_time = was_idle ? 0 : m_slowest_client_paint_time_this_second;
+    m_statistics.slowest_client_paint_title = was_idle ? String() : move(m_slowest_client_paint_title_this_second);
+    m_frames_this_second = 0;
+    m_slowest_client_paint_time_this_second = 0;
+    m_slowest_client_paint_title_this_second = {};
+    m_statistics_second_start = now;
+}
 
-    Gfx::RGBA32* front_ptr = m_front_bitmap->scanline(rect.y()) + rect.x();
-    Gfx::RGBA32* back_ptr = m_back_bitmap->scanline(rect.y()) + rect.x();
-    size_t pitch = m_back_bitmap->pitch();
+const Compositor::Statistics& Compositor::statistics()
+{
+    update_statistics_for_second(monotonic_microseconds());
+    return m_statistics;
+}
 
-    // NOTE: The meaning of a flush depends on whether we can flip buffers or not.
-    //
-    //       If flipping is supported, flushing means that we've flipped, and now we
-    //       copy the changed bits from the front buffer to the back buffer, to keep
-    //       them in sync.
-    //
-    //       If flipping is not supported, flushing means that we copy the changed
-    //       rects from the backing bitmap to the display framebuffer.
+void Compositor::did_finish_client_paint(const Window& window, u32 milliseconds)
+{
+    if (milliseconds < m_slowest_client_paint_time_this_second)
+        return;
+    m_slowest_client_paint_time_this_second = milliseconds;
+    m_slowest_client_paint_title_this_second = window.title();
+}
 
-    Gfx::RGBA32* to_ptr;
-    const Gfx::RGBA32* from_ptr;
+void Compositor::toggle_statistics_overlay()
+{
+    m_show_statistics = !m_show_statistics.value_or(false);
+    invalidate(m_last_statistics_rect);
+    if (m_show_statistics.value())
+        invalidate();
+}
 
-    if (m_screen_can_set_buffer) {
-        to_ptr = back_ptr;
-        from_ptr = front_ptr;
-    } else {
-        to_ptr = front_ptr;
-        from_ptr = back_ptr;
-    }
+void Compositor::flush(const Gfx::Rect& a_rect)
+{
+    auto rect = Gfx::Rect::intersection(a_rect, Screen::the().rect());
+
+    // NOTE: Flushing is only needed when we can't flip buffers; it copies the changed
+    //       rects from the backing bitmap to the display framebuffer.
+    ASSERT(!m_screen_can_set_buffer);
+    Gfx::RGBA32* to_ptr = m_front_bitmap->scanline(rect.y()) + rect.x();
+    const Gfx::RGBA32* from_ptr = m_back_bitmap->scanline(rect.y()) + rect.x();
+    size_t pitch = m_back_bitmap->pitch();
 
     for (int y = 0; y < rect.height(); ++y) {
         fast_u32_copy(to_ptr, from_ptr, rect.width());
         from_ptr = (const Gfx::RGBA32*)((const u8*)from_ptr + pitch);
         to_ptr = (Gfx::RGBA32*)((u8*)to_ptr + pitch);
     }
+
+    update_screen(rect);
+}
+
+void Compositor::update_screen(const Gfx::Rect& rect)
+{
+    auto& screen = Screen::the();
+    if (screen.bpp() != 16)
+        return;
+    for (int y = rect.top(); y <= rect.bottom(); ++y)
+        Gfx::convert_row_to_rgb565(screen.scanline_rgb565(y) + rect.x(), m_front_bitmap->scanline(y) + rect.x(), rect.width());
 }
 
 void Compositor::invalidate()
@@ -307,14 +404,33 @@ void Compositor::invalidate(const Gfx::Rect& a_rect)
         return;
 
     m_dirty_rects.add(rect);
+    schedule_compose();
+}
 
-    // We delay composition by a timer interval, but to not affect latency too
-    // much, if a pending compose is not already scheduled, we also schedule an
-    // immediate compose the next spin of the event loop.
-    if (!m_compose_timer->is_active()) {
-        m_compose_timer->start();
-        m_immediate_compose_timer->start();
+void Compositor::schedule_compose()
+{
+    // While frames are being produced, all invalidations are coalesced into one composition on the
+    // next refresh tick. When the screen has been idle, compose on the next spin of the event loop
+    // instead, so a single change (like a keypress) doesn't have to wait for the tick.
+    if (m_frame_timer->is_active() || m_immediate_compose_timer->is_active())
+        return;
+    m_immediate_compose_timer->start();
+}
+
+// This is the compositor's frame clock: display links are told to render and damage is composited at
+// the same steady rate. The clock stops once a tick finds nothing to do.
+void Compositor::on_frame_tick()
+{
+    if (m_display_link_count)
+        notify_display_links();
+
+    if (!m_dirty_rects.is_empty() || m_occlusions_dirty) {
+        compose();
+        return;
     }
+
+    if (!m_display_link_count)
+        m_frame_timer->stop();
 }
 
 bool Compositor::set_background_color(const String& background_color)
@@ -323,8 +439,10 @@ bool Compositor::set_background_color(const String& background_color)
     wm.config()->write_entry("Background", "Color", background_color);
     bool ret_val = wm.config()->sync();
 
-    if (ret_val)
+    if (ret_val) {
+        invalidate_wallpaper_cache();
         Compositor::invalidate();
+    }
 
     return ret_val;
 }
@@ -337,6 +455,7 @@ bool Compositor::set_wallpaper_mode(const String& mode)
 
     if (ret_val) {
         m_wallpaper_mode = mode_to_enum(mode);
+        invalidate_wallpaper_cache();
         Compositor::invalidate();
     }
 
@@ -353,12 +472,59 @@ bool Compositor::set_wallpaper(const String& path, Function<void(bool)>&& callba
         [this, path, callback = move(callback)](RefPtr<Gfx::Bitmap> bitmap) {
             m_wallpaper_path = path;
             m_wallpaper = move(bitmap);
+            invalidate_wallpaper_cache();
             invalidate();
             callback(true);
         });
     return true;
 }
 
+Color Compositor::background_color() const
+{
+    auto& wm = WindowManager::the();
+    Color background_color = wm.palette().desktop_background();
+    String background_color_entry = wm.config()->read_entry("Background", "Color", "");
+    if (!background_color_entry.is_empty()) {
+        background_color = Color::from_string(background_color_entry).value_or(background_color);
+    }
+    return background_color;
+}
+
+void Compositor::invalidate_wallpaper_cache()
+{
+    m_wallpaper_cache = nullptr;
+    m_wallpaper_cache_pending = false;
+    // A rendering that's still in progress is now out of date, and gets dropped when it completes.
+    ++m_wallpaper_cache_generation;
+}
+
+// Scaling (or tiling) the wallpaper is the slow part of painting the background, so it's done once for
+// the whole screen, on the background thread, whenever the wallpaper, mode, color or resolution changes.
+void Compositor::render_wallpaper_cache()
+{
+    if (m_wallpaper_cache || m_wallpaper_cache_pending)
+        return;
+    m_wallpaper_cache_pending = true;
+    auto generation = m_wallpaper_cache_generation;
+    LibThread::BackgroundAction<RefPtr<Gfx::Bitmap>>::create(
+        [wallpaper = m_wallpaper, mode = m_wallpaper_mode, background_color = background_color(), screen_size = Screen::the().size()] {
+            auto bitmap = Gfx::Bitmap::create(Gfx::BitmapFormat::RGB32, screen_size);
+            if (!bitmap)
+                return bitmap;
+            Gfx::Painter painter(*bitmap);
+            paint_background(painter, bitmap->rect(), background_color, wallpaper, mode, screen_size);
+            return bitmap;
+        },
+
+        [this, generation](RefPtr<Gfx::Bitmap> bitmap) {
+            if (generation != m_wallpaper_cache_generation)
+                return;
+            m_wallpaper_cache_pending = false;
+            // It's the same picture that has been painted so far, so nothing needs repainting.
+            m_wallpaper_cache = move(bitmap);
+        });
+}
+
 void Compositor::flip_buffers()
 {
     ASSERT(m_screen_can_set_buffer);
@@ -432,7 +598,11 @@ void Compositor::invalidate_cursor()
     auto& wm = WindowManager::the();
     if (wm.dnd_client())
         invalidate(wm.dnd_rect());
-    invalidate(current_cursor_rect());
+
+    // Only the pixels under the cursor change, so there's no need to go through the window stack:
+    // put back what was under it and draw it again at its new location, right away.
+    remove_cursor();
+    draw_cursor();
 }
 
 void Compositor::draw_geometry_label()
@@ -457,12 +627,80 @@ void Compositor::draw_geometry_label()
     m_last_geometry_label_rect = geometry_label_rect;
 }
 
-void Compositor::draw_cursor()
+void Compositor::draw_statistics()
 {
+    // This shows the previous pass, since the current one isn't over yet. It's only redrawn when
+    // something else on screen changes, so it doesn't keep the compositor busy by itself.
     auto& wm = WindowManager::the();
-    Gfx::Rect cursor_rect = current_cursor_rect();
-    m_back_painter->blit(cursor_rect.location(), wm.active_cursor().bitmap(), wm.active_cursor().rect());
+    auto& statistics = m_statistics;
+    Vector<String, 4> lines;
+    lines.append(String::format("Compose: %llu.%02llu ms (avg %llu.%02llu ms), %u fps",
+        statistics.last_compose_time / 1000, (statistics.last_compose_time % 1000) / 10,
+        statistics.average_compose_time / 1000, (statistics.average_compose_time % 1000) / 10,
+        statistics.frames_per_second));
+    lines.append(String::format("Dirty rects: %u, %llu KB flushed", statistics.dirty_rect_count, statistics.flushed_bytes / KB));
+    lines.append(String::format("Occluded windows: %u", statistics.occluded_window_count));
+    if (statistics.slowest_client_paint_title.is_null())
+        lines.append("Slowest client paint: -");
+    else
+        lines.append(String::format("Slowest client paint: %u ms (%s)", statistics.slowest_client_paint_time, statistics.slowest_client_paint_title.characters()));
+
+    int line_height = wm.font().glyph_height() + 4;
+    int width = 0;
+    for (auto& line : lines)
+        width = max(width, wm.font().width(line));
+    Gfx::Rect rect { 0, 0, width + 16, (int)lines.size() * line_height + 8 };
+    rect.set_location({ Screen::the().width() - rect.width() - 8, wm.menubar_rect().bottom() + 8 });
+    m_back_painter->fill_rect(rect, Color(Color::Black).with_alpha(192));
+    Gfx::Rect line_rect { rect.x() + 8, rect.y() + 4, width, line_height };
+    for (auto& line : lines) {
+        m_back_painter->draw_text(line_rect, line, Gfx::TextAlignment::CenterLeft, Color::White);
+        line_rect.move_by(0, line_height);
+    }
+    m_last_statistics_rect = rect;
+}
 
+static void copy_bitmap_rect(Gfx::Bitmap& to, const Gfx::Point& to_location, const Gfx::Bitmap& from, const Gfx::Rect& from_rect)
+{
+    for (int y = 0; y < from_rect.height(); ++y)
+        fast_u32_copy(to.scanline(to_location.y() + y) + to_location.x(), from.scanline(from_rect.y() + y) + from_rect.x(), from_rect.width());
+}
+
+void Compositor::draw_cursor()
+{
+    auto& cursor = WindowManager::the().active_cursor();
+    auto cursor_rect = current_cursor_rect();
+    auto covered_rect = cursor_rect.intersected(Screen::the().rect());
+    if (covered_rect.is_empty()) {
+        m_last_cursor_rect = {};
+        return;
+    }
+
+    if (!m_cursor_saved_under || m_cursor_saved_under->width() < covered_rect.width() || m_cursor_saved_under->height() < covered_rect.height()) {
+        Gfx::Size size { covered_rect.width(), covered_rect.height() };
+        if (m_cursor_saved_under)
+            size = { max(size.width(), m_cursor_saved_under->width()), max(size.height(), m_cursor_saved_under->height()) };
+        m_cursor_saved_under = Gfx::Bitmap::create(Gfx::BitmapFormat::RGB32, size);
+    }
+
+    copy_bitmap_rect(*m_cursor_saved_under, {}, *m_front_bitmap, covered_rect);
+    m_front_painter->blit(cursor_rect.location(), cursor.bitmap(), cursor.rect());
+    update_screen(covered_rect);
+    m_last_cursor_rect = covered_rect;
+}
+
+void Compositor::remove_cursor()
+{
+    if (m_last_cursor_rect.is_empty())
+        return;
+    copy_bitmap_rect(*m_front_bitmap, m_last_cursor_rect.location(), *m_cursor_saved_under, { {}, m_last_cursor_rect.size() });
+    update_screen(m_last_cursor_rect);
+    m_last_cursor_rect = {};
+}
+
+void Compositor::draw_dnd()
+{
+    auto& wm = WindowManager::the();
     if (wm.dnd_client()) {
         auto dnd_rect = wm.dnd_rect();
         m_back_painter->fill_rect(dnd_rect, wm.palette().selection().with_alpha(200));
@@ -479,7 +717,6 @@ void Compositor::draw_cursor()
     } else {
         m_last_dnd_rect = {};
     }
-    m_last_cursor_rect = cursor_rect;
 }
 
 void Compositor::notify_display_links()
@@ -492,83 +729,78 @@ void Compositor::notify_display_links()
 void Compositor::increment_display_link_count(Badge<ClientConnection>)
 {
     ++m_display_link_count;
-    if (m_display_link_count == 1)
-        m_display_link_notify_timer->start();
+    if (!m_frame_timer->is_active())
+        m_frame_timer->start();
 }
 
 void Compositor::decrement_display_link_count(Badge<ClientConnection>)
 {
     ASSERT(m_display_link_count);
     --m_display_link_count;
-    if (!m_display_link_count)
-        m_display_link_notify_timer->stop();
 }
 
-bool Compositor::any_opaque_window_contains_rect(const Gfx::Rect& rect)
+static bool window_is_opaque(const Window& window)
 {
-    bool found_containing_window = false;
-    WindowManager::the().for_each_visible_window_from_back_to_front([&](Window& window) {
-        if (window.is_minimized())
-            return IterationDecision::Continue;
-        if (window.opacity() < 1.0f)
-            return IterationDecision::Continue;
-        if (window.has_alpha_channel()) {
-            // FIXME: Just because the window has an alpha channel doesn't mean it's not opaque.
-            //        Maybe there's some way we could know this?
-            return IterationDecision::Continue;
-        }
-        if (window.frame().rect().contains(rect)) {
-            found_containing_window = true;
-            return IterationDecision::Break;
-        }
-        return IterationDecision::Continue;
-    });
-    return found_containing_window;
-};
-
+    // FIXME: Just because the window has an alpha channel doesn't mean it's not opaque.
+    //        Maybe there's some way we could know this?
+    return window.opacity() >= 1.0f && !window.has_alpha_channel();
+}
 
-bool Compositor::any_opaque_window_above_this_one_contains_rect(const Window& a_window, const Gfx::Rect& rect)
+void Compositor::invalidate_occlusions()
 {
-    bool found_containing_window = false;
-    bool checking = false;
-    WindowManager::the().for_each_visible_window_from_back_to_front([&](Window& window) {
-        if (&window == &a_window) {
-            checking = true;
-            return IterationDecision::Continue;
-        }
-        if (!checking)
-            return IterationDecision::Continue;
-        if (!window.is_visible())
-            return IterationDecision::Continue;
-        if (window.is_minimized())
-            return IterationDecision::Continue;
-        if (window.opacity() < 1.0f)
-            return IterationDecision::Continue;
-        if (window.has_alpha_channel())
-            return IterationDecision::Continue;
-        if (window.frame().rect().contains(rect)) {
-            found_containing_window = true;
-            return IterationDecision::Break;
-        }
-        return IterationDecision::Continue;
-    });
-    return found_containing_window;
-};
+    m_occlusions_dirty = true;
+    schedule_compose();
+}
 
+// Walks the windows from front to back, carving each window's frame up into the pieces that
+// no opaque window in front of it covers. Whatever is left of the screen shows the wallpaper.
 void Compositor::recompute_occlusions()
 {
     auto& wm = WindowManager::the();
-    wm.for_each_visible_window_from_back_to_front([&](Window& window) {
-        if (wm.m_switcher.is_visible()) {
-            window.set_occluded(false);
-        } else {
-            if (any_opaque_window_above_this_one_contains_rect(window, window.frame().rect()))
-                window.set_occluded(true);
-            else
-                window.set_occluded(false);
+    m_occlusions_dirty = false;
+
+    Vector<Gfx::Rect, 32> opaque_rects;
+    auto subtract_opaque_rects = [&](Vector<Gfx::Rect, 4>& rects) {
+        for (auto& opaque_rect : opaque_rects) {
+            for (size_t i = 0; i < rects.size();) {
+                if (!rects[i].intersects(opaque_rect)) {
+                    ++i;
+                    continue;
+                }
+                auto pieces = rects[i].shatter(opaque_rect);
+                rects.remove(i);
+                for (auto& piece : pieces)
+                    rects.append(piece);
+                // The pieces went to the end and don't intersect this opaque rect, so index i is next as is.
+            }
+            if (rects.is_empty())
+                return;
         }
+    };
+
+    auto screen_rect = Screen::the().rect();
+    u32 occluded_window_count = 0;
+    wm.for_each_visible_window_from_front_to_back([&](Window& window) {
+        Vector<Gfx::Rect, 4> visible_rects;
+        auto frame_rect = window.frame().rect().intersected(screen_rect);
+        if (!frame_rect.is_empty()) {
+            visible_rects.append(frame_rect);
+            subtract_opaque_rects(visible_rects);
+        }
+        window.set_occluded(!wm.m_switcher.is_visible() && visible_rects.is_empty());
+        if (visible_rects.is_empty())
+            ++occluded_window_count;
+        window.set_visible_rects(move(visible_rects));
+        if (window_is_opaque(window) && !frame_rect.is_empty())
+            opaque_rects.append(frame_rect);
         return IterationDecision::Continue;
     });
+
+    Vector<Gfx::Rect, 4> wallpaper_visible_rects;
+    wallpaper_visible_rects.append(screen_rect);
+    subtract_opaque_rects(wallpaper_visible_rects);
+    m_wallpaper_visible_rects = move(wallpaper_visible_rects);
+    m_statistics.occluded_window_count = occluded_window_count;
 }
 
 }
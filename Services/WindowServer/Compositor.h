@@ -26,6 +26,7 @@
 
 #pragma once
 
+#include <AK/Optional.h>
 #include <AK/OwnPtr.h>
 #include <AK/RefPtr.h>
 #include <LibCore/Object.h>
@@ -70,22 +71,56 @@ public:
     void increment_display_link_count(Badge<ClientConnection>);
     void decrement_display_link_count(Badge<ClientConnection>);
 
-    void recompute_occlusions();
+    // Window geometry, stacking or visibility changed, so which parts of which windows are visible needs to be
+    // worked out again before the next composition.
+    void invalidate_occlusions();
+
+    struct Statistics {
+        u32 frames_per_second { 0 };
+        // Microseconds spent in the last compose pass, and a running average.
+        u64 last_compose_time { 0 };
+        u64 average_compose_time { 0 };
+        u32 dirty_rect_count { 0 };
+        // How much of the screen the last compose pass changed.
+        u64 flushed_bytes { 0 };
+        u32 occluded_window_count { 0 };
+        // The longest a client took to answer a paint request during the last second, in milliseconds.
+        u32 slowest_client_paint_time { 0 };
+        String slowest_client_paint_title;
+    };
+    const Statistics& statistics();
+    void did_finish_client_paint(const Window&, u32 milliseconds);
+
+    // The statistics overlay starts out as configured by ShowStatistics in the [Compositor] section of WindowServer.ini.
+    void toggle_statistics_overlay();
 
 private:
     Compositor();
     void init_bitmaps();
     void flip_buffers();
     void flush(const Gfx::Rect&);
+    // Copies a changed part of the front buffer to the screen, if the framebuffer isn't the front buffer itself.
+    void update_screen(const Gfx::Rect&);
     void draw_cursor();
+    void remove_cursor();
+    void draw_dnd();
     void draw_geometry_label();
     void draw_menubar();
     void run_animations();
+    void draw_statistics();
+    void update_statistics_for_second(u64 now);
     void notify_display_links();
-    bool any_opaque_window_contains_rect(const Gfx::Rect&);
-    bool any_opaque_window_above_this_one_contains_rect(const Window&, const Gfx::Rect&);
+    void recompute_occlusions();
+    Color background_color() const;
+    void invalidate_wallpaper_cache();
+    void render_wallpaper_cache();
+    void schedule_compose();
+    void on_frame_tick();
+
+    // There's no vertical blank interrupt to go by, so frames are paced by a timer at the usual refresh rate.
+    static constexpr int refresh_interval = 1000 / 60;
 
-    RefPtr<Core::Timer> m_compose_timer;
+    RefPtr<Core::Timer> m_frame_timer;
     RefPtr<Core::Timer> m_immediate_compose_timer;
     bool m_flash_flush { false };
     bool m_buffers_are_flipped { false };
@@ -97,16 +132,37 @@ private:
     OwnPtr<Gfx::Painter> m_front_painter;
 
     Gfx::DisjointRectSet m_dirty_rects;
+    // What the last composition changed, which the back buffer is missing after a flip.
+    Vector<Gfx::Rect, 32> m_last_frame_dirty_rects;
 
+    // The cursor is drawn straight onto the front buffer, after the frame is presented. What it covers is
+    // kept aside, so moving it only needs those pixels put back rather than a recomposition.
+    RefPtr<Gfx::Bitmap> m_cursor_saved_under;
     Gfx::Rect m_last_cursor_rect;
     Gfx::Rect m_last_dnd_rect;
     Gfx::Rect m_last_geometry_label_rect;
+    Gfx::Rect m_last_statistics_rect;
+
+    bool m_occlusions_dirty { true };
+    // The parts of the screen that aren't covered by any opaque window, where the wallpaper shows.
+    Vector<Gfx::Rect, 4> m_wallpaper_visible_rects;
+
+    Optional<bool> m_show_statistics;
+    Statistics m_statistics;
+    // Frame rate and client paint times are collected over a second at a time.
+    u64 m_statistics_second_start { 0 };
+    u32 m_frames_this_second { 0 };
+    u32 m_slowest_client_paint_time_this_second { 0 };
+    String m_slowest_client_paint_title_this_second;
 
     String m_wallpaper_path;
     WallpaperMode m_wallpaper_mode { WallpaperMode::Unchecked };
     RefPtr<Gfx::Bitmap> m_wallpaper;
+    // The whole desktop background at screen size, so recompositing any part of it is a plain copy.
+    RefPtr<Gfx::Bitmap> m_wallpaper_cache;
+    bool m_wallpaper_cache_pending { false };
+    u32 m_wallpaper_cache_generation { 0 };
 
-    RefPtr<Core::Timer> m_display_link_notify_timer;
     size_t m_display_link_count { 0 };
 };
 
@@ -33,6 +33,11 @@ Cursor::Cursor(NonnullRefPtr<Gfx::Bitmap>&& bitmap, const Gfx::Point& hotspot)
     : m_bitmap(move(bitmap))
     , m_hotspot(hotspot)
 {
+    // The cursor is blended onto the screen every time it moves, which is cheaper from premultiplied pixels.
+    if (m_bitmap->format() == Gfx::BitmapFormat::RGBA32) {
+        if (auto premultiplied_bitmap = m_bitmap->to_premultiplied())
+            m_bitmap = move(premultiplied_bitmap);
+    }
 }
 
 Cursor::~Cursor()
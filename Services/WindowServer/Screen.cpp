@@ -70,24 +70,24 @@ Screen::~Screen()
 
 bool Screen::set_resolution(int width, int height)
 {
-    FBResolution resolution { 0, (unsigned)width, (unsigned)height };
+    FBResolution resolution { 0, (unsigned)width, (unsigned)height, 0 };
     int rc = fb_set_resolution(m_framebuffer_fd, &resolution);
 #ifdef WSSCREEN_DEBUG
     dbg() << "fb_set_resolution() - return code " << rc;
 #endif
     if (rc == 0) {
-        on_change_resolution(resolution.pitch, resolution.width, resolution.height);
+        on_change_resolution(resolution.pitch, resolution.width, resolution.height, resolution.bpp);
         return true;
     }
     if (rc == -1) {
         dbg() << "Invalid resolution " << width << "x" << height;
-        on_change_resolution(resolution.pitch, resolution.width, resolution.height);
+        on_change_resolution(resolution.pitch, resolution.width, resolution.height, resolution.bpp);
         return false;
     }
     ASSERT_NOT_REACHED();
 }
 
-void Screen::on_change_resolution(int pitch, int width, int height)
+void Screen::on_change_resolution(int pitch, int width, int height, int bpp)
 {
     if (m_framebuffer) {
         size_t previous_size_in_bytes = m_size_in_bytes;
@@ -105,6 +105,18 @@ void Screen::on_change_resolution(int pitch, int width, int height)
     m_width = width;
     m_height = height;
 
+    // Low-bandwidth modes (like a 16-bit framebuffer handed over by the bootloader) are driven through
+    // an RGB565 conversion. Anything else is assumed to be 32-bit.
+    if (bpp == 16) {
+        m_bpp = 16;
+        // The conversion happens as pixels are copied to the screen, so there's no second buffer to flip to.
+        m_can_set_buffer = false;
+    } else {
+        if (bpp != 32)
+            dbg() << "Screen: Unsupported framebuffer depth " << bpp << ", treating it as 32 bpp";
+        m_bpp = 32;
+    }
+
     m_cursor_location.constrain(rect());
 }
 
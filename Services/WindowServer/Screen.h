@@ -49,6 +49,10 @@ public:
     size_t pitch() const { return m_pitch; }
     Gfx::RGBA32* scanline(int y);
 
+    // Either 32, or 16 for an RGB565 framebuffer, which only the compositor's final copy to the screen deals with.
+    int bpp() const { return m_bpp; }
+    u16* scanline_rgb565(int y);
+
     static Screen& the();
 
     Gfx::Size size() const { return { width(), height() }; }
@@ -61,7 +65,7 @@ public:
     void on_receive_keyboard_data(::KeyEvent);
 
 private:
-    void on_change_resolution(int pitch, int width, int height);
+    void on_change_resolution(int pitch, int width, int height, int bpp);
 
     size_t m_size_in_bytes;
 
@@ -71,6 +75,7 @@ private:
     int m_pitch { 0 };
     int m_width { 0 };
     int m_height { 0 };
+    int m_bpp { 32 };
     int m_framebuffer_fd { -1 };
 
     Gfx::Point m_cursor_location;
@@ -83,4 +88,9 @@ inline Gfx::RGBA32* Screen::scanline(int y)
     return reinterpret_cast<Gfx::RGBA32*>(((u8*)m_framebuffer) + (y * m_pitch));
 }
 
+inline u16* Screen::scanline_rgb565(int y)
+{
+    return reinterpret_cast<u16*>(((u8*)m_framebuffer) + (y * m_pitch));
+}
+
 }
@@ -219,6 +219,7 @@ void Window::set_minimized(bool minimized)
     if (!minimized)
         request_update({ {}, size() });
     invalidate();
+    Compositor::the().invalidate_occlusions();
     WindowManager::the().notify_minimization_state_changed(*this);
 }
 
@@ -345,6 +346,7 @@ void Window::set_visible(bool b)
         return;
     m_visible = b;
     invalidate();
+    Compositor::the().invalidate_occlusions();
 }
 
 void Window::invalidate()
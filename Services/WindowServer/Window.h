@@ -29,6 +29,7 @@
 #include <AK/InlineLinkedList.h>
 #include <AK/String.h>
 #include <AK/WeakPtr.h>
+#include <LibCore/ElapsedTimer.h>
 #include <LibCore/Object.h>
 #include <LibGfx/Bitmap.h>
 #include <LibGfx/DisjointRectSet.h>
@@ -97,6 +98,11 @@ public:
     bool is_occluded() const { return m_occluded; }
     void set_occluded(bool);
 
+    // The parts of the frame that aren't hidden behind opaque windows in front of it, as of the last time the
+    // compositor recomputed occlusions. Only these parts get composited.
+    const Vector<Gfx::Rect, 4>& visible_rects() const { return m_visible_rects; }
+    void set_visible_rects(Vector<Gfx::Rect, 4>&& rects) { m_visible_rects = move(rects); }
+
     bool is_movable() const
     {
         return m_type == WindowType::Normal;
@@ -204,6 +210,21 @@ public:
     void request_update(const Gfx::Rect&, bool ignore_occlusion = false);
     Gfx::DisjointRectSet take_pending_paint_rects() { return move(m_pending_paint_rects); }
 
+    // Measures how long the client takes to answer paint requests, from the first one it hasn't answered yet.
+    void did_request_paint()
+    {
+        if (!m_paint_request_timer.is_valid())
+            m_paint_request_timer.start();
+    }
+    Optional<int> did_finish_paint()
+    {
+        if (!m_paint_request_timer.is_valid())
+            return {};
+        int elapsed = m_paint_request_timer.elapsed();
+        m_paint_request_timer = {};
+        return elapsed;
+    }
+
     bool in_minimize_animation() const { return m_minimize_animation_step != -1; }
 
     int minimize_animation_index() const { return m_minimize_animation_step; }
@@ -266,6 +287,7 @@ private:
     WindowTileType m_tiled { WindowTileType::None };
     Gfx::Rect m_untiled_rect;
     bool m_occluded { false };
+    Vector<Gfx::Rect, 4> m_visible_rects;
     RefPtr<Gfx::Bitmap> m_backing_store;
     RefPtr<Gfx::Bitmap> m_last_backing_store;
     int m_window_id { -1 };
@@ -278,6 +300,7 @@ private:
     WindowFrame m_frame;
     unsigned m_wm_event_mask { 0 };
     Gfx::DisjointRectSet m_pending_paint_rects;
+    Core::ElapsedTimer m_paint_request_timer;
     Gfx::Rect m_unmaximized_rect;
     Gfx::Rect m_rect_in_menubar;
     RefPtr<Menu> m_window_menu;
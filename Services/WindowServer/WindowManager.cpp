@@ -186,7 +186,7 @@ void WindowManager::add_window(Window& window)
     if (m_switcher.is_visible() && window.type() != WindowType::WindowSwitcher)
         m_switcher.refresh();
 
-    Compositor::the().recompute_occlusions();
+    Compositor::the().invalidate_occlusions();
 
     if (window.listens_to_wm_events()) {
         for_each_window([&](Window& other_window) {
@@ -211,7 +211,7 @@ void WindowManager::move_to_front_and_make_active(Window& window)
     m_windows_in_order.remove(&window);
     m_windows_in_order.append(&window);
 
-    Compositor::the().recompute_occlusions();
+    Compositor::the().invalidate_occlusions();
 
     set_active_window(&window);
 
@@ -236,7 +236,7 @@ void WindowManager::remove_window(Window& window)
     if (m_switcher.is_visible() && window.type() != WindowType::WindowSwitcher)
         m_switcher.refresh();
 
-    Compositor::the().recompute_occlusions();
+    Compositor::the().invalidate_occlusions();
 
     for_each_window_listening_to_wm_events([&window](Window& listener) {
         if (!(listener.wm_event_mask() & WMEventMask::WindowRemovals))
@@ -330,7 +330,7 @@ void WindowManager::notify_rect_changed(Window& window, const Gfx::Rect& old_rec
     if (m_switcher.is_visible() && window.type() != WindowType::WindowSwitcher)
         m_switcher.refresh();
 
-    Compositor::the().recompute_occlusions();
+    Compositor::the().invalidate_occlusions();
 
     tell_wm_listeners_window_rect_changed(window);
 
@@ -339,7 +339,7 @@ void WindowManager::notify_rect_changed(Window& window, const Gfx::Rect& old_rec
 
 void WindowManager::notify_opacity_changed(Window&)
 {
-    Compositor::the().recompute_occlusions();
+    Compositor::the().invalidate_occlusions();
 }
 
 void WindowManager::notify_minimization_state_changed(Window& window)
@@ -947,6 +947,12 @@ void WindowManager::event(Core::Event& event)
             return;
         }
 
+        if (key_event.type() == Event::KeyDown && key_event.modifiers() == (Mod_Ctrl | Mod_Logo) && key_event.key() == Key_P) {
+            m_moved_or_resized_since_logo_keydown = true;
+            Compositor::the().toggle_statistics_overlay();
+            return;
+        }
+
         if (key_event.type() == Event::KeyDown && ((key_event.modifiers() == Mod_Logo && key_event.key() == Key_Tab) || (key_event.modifiers() == (Mod_Logo | Mod_Shift) && key_event.key() == Key_Tab)))
             m_switcher.show();
         if (m_switcher.is_visible()) {
@@ -1013,6 +1019,8 @@ void WindowManager::set_highlight_window(Window* window)
     m_highlight_window = window ? window->make_weak_ptr() : nullptr;
     if (m_highlight_window)
         m_highlight_window->invalidate();
+    // The highlighted window is drawn on top of the others of its type.
+    Compositor::the().invalidate_occlusions();
 }
 
 static bool window_type_can_become_active(WindowType type)
@@ -46,9 +46,11 @@
 #include <string.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
+#include <sys/times.h>
 #include <sys/utsname.h>
 #include <sys/wait.h>
 #include <termios.h>
+#include <time.h>
 #include <unistd.h>
 
 // FIXME: We do not expand variables inside strings
@@ -733,6 +735,12 @@ int Shell::builtin_pushd(int argc, const char** argv)
     return 0;
 }
 
+int Shell::builtin_rehash(int, const char**)
+{
+    cache_path();
+    return 0;
+}
+
 int Shell::builtin_pwd(int, const char**)
 {
     print_path(cwd);
@@ -753,6 +761,10 @@ int Shell::builtin_time(int argc, const char** argv)
     StringBuilder builder;
     builder.join(' ', args);
 
+    auto ticks_to_ms = [](clock_t ticks) { return (int)(ticks * 1000 / CLOCKS_PER_SEC); };
+
+    struct tms times_before;
+    times(&times_before);
     Core::ElapsedTimer timer;
     timer.start();
     auto exit_code = run_command(builder.string_view());
@@ -760,7 +772,14 @@ int Shell::builtin_time(int argc, const char** argv)
         printf("Shell: Incomplete command: %s\n", builder.to_string().characters());
         exit_code = 1;
     }
-    printf("Time: %d ms\n", timer.elapsed());
+    int real_ms = timer.elapsed();
+    struct tms times_after;
+    times(&times_after);
+
+    // The command's processes have all been waited for by now, so their time is in the children's part.
+    auto user_ticks = (times_after.tms_utime - times_before.tms_utime) + (times_after.tms_cutime - times_before.tms_cutime);
+    auto system_ticks = (times_after.tms_stime - times_before.tms_stime) + (times_after.tms_cstime - times_before.tms_cstime);
+    printf("Time: %d ms (user: %d ms, system: %d ms)\n", real_ms, ticks_to_ms(user_ticks), ticks_to_ms(system_ticks));
     return exit_code.value();
 }
 
@@ -801,8 +820,11 @@ int Shell::builtin_unset(int argc, const char** argv)
     if (!parser.parse(argc, const_cast<char**>(argv), false))
         return 1;
 
-    for (auto& value : vars)
+    for (auto& value : vars) {
         unsetenv(value);
+        if (StringView(value) == "PATH")
+            cache_path();
+    }
 
     return 0;
 }
@@ -1262,6 +1284,8 @@ ExitCodeOrContinuationRequest Shell::run_command(const StringView& cmd)
             if (run_builtin(argv.size() - 1, argv.data(), retval))
                 return retval;
 
+            auto program_path = cached_program_path(argv[0]);
+
             pid_t child = fork();
             if (!child) {
                 setpgid(0, 0);
@@ -1280,7 +1304,12 @@ ExitCodeOrContinuationRequest Shell::run_command(const StringView& cmd)
 
                 fds.collect();
 
-                int rc = execvp(argv[0], const_cast<char* const*>(argv.data()));
+                int rc = -1;
+                if (!program_path.is_null())
+                    rc = execv(program_path.characters(), const_cast<char* const*>(argv.data()));
+                // The program might have moved since we looked at PATH; have another look.
+                if (rc < 0)
+                    rc = execvp(argv[0], const_cast<char* const*>(argv.data()));
                 if (rc < 0) {
                     if (errno == ENOENT) {
                         int shebang_fd = open(argv[0], O_RDONLY);
@@ -1456,6 +1485,7 @@ void Shell::cache_path()
 {
     if (!cached_path.is_empty())
         cached_path.clear_with_capacity();
+    cached_program_paths.clear();
 
     String path = getenv("PATH");
     if (path.is_empty())
@@ -1467,8 +1497,12 @@ void Shell::cache_path()
         while (programs.has_next()) {
             auto program = programs.next_path();
             String program_path = String::format("%s/%s", directory.characters(), program.characters());
-            if (access(program_path.characters(), X_OK) == 0)
+            if (access(program_path.characters(), X_OK) == 0) {
                 cached_path.append(escape_token(program.characters()));
+                // Like execvp(), the first directory in PATH that has the program wins.
+                if (!cached_program_paths.contains(program))
+                    cached_program_paths.set(program, move(program_path));
+            }
         }
     }
 
@@ -1479,6 +1513,16 @@ void Shell::cache_path()
     quick_sort(cached_path);
 }
 
+String Shell::cached_program_path(const char* program) const
+{
+    if (strchr(program, '/'))
+        return {};
+    auto it = cached_program_paths.find(program);
+    if (it == cached_program_paths.end())
+        return {};
+    return it->value;
+}
+
 void Shell::highlight(Line::Editor& editor) const
 {
     StringBuilder builder;
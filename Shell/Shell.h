@@ -82,6 +82,7 @@ using ContinuationRequest = ExitCodeOrContinuationRequest::ContinuationRequest;
     __ENUMERATE_SHELL_BUILTIN(dirs)    \
     __ENUMERATE_SHELL_BUILTIN(pushd)   \
     __ENUMERATE_SHELL_BUILTIN(popd)    \
+    __ENUMERATE_SHELL_BUILTIN(rehash)  \
     __ENUMERATE_SHELL_BUILTIN(time)    \
     __ENUMERATE_SHELL_BUILTIN(jobs)    \
     __ENUMERATE_SHELL_BUILTIN(disown)  \
@@ -150,6 +151,8 @@ public:
     CircularQueue<String, 8> cd_history; // FIXME: have a configurable cd history length
     HashMap<u64, OwnPtr<Job>> jobs;
     Vector<String, 256> cached_path;
+    // Where each program in PATH lives, so running it doesn't have to try every PATH directory first.
+    HashMap<String, String> cached_program_paths;
 
     enum ShellEventType {
         ReadLine,
@@ -169,6 +172,7 @@ private:
     };
 
     void cache_path();
+    String cached_program_path(const char* program) const;
     void stop_all_jobs();
 
     IterationDecision wait_for_pid(const SpawnedProcess&, bool is_first_command_in_chain, int& return_value);
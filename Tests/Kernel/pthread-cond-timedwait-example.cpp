@@ -29,8 +29,7 @@ void* run_worker(void* args)
         int rc = pthread_cond_timedwait(&worker->cond, &worker->lock, &time_to_wait);
 
         // Validate return code is always timed out.
-        assert(rc == -1);
-        assert(errno == ETIMEDOUT);
+        assert(rc == ETIMEDOUT);
 
         worker->count++;
         printf("Increase worker[%s] count to [%d]\n", worker->name, worker->count);
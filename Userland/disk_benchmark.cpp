@@ -44,7 +44,7 @@ struct Result {
 
 Result average_result(const Vector<Result>& results)
 {
-    Result average;
+    Result average { 0, 0 };
 
     for (auto& res : results) {
         average.write_bps += res.write_bps;
@@ -59,11 +59,14 @@ Result average_result(const Vector<Result>& results)
 
 void exit_with_usage(int rc)
 {
-    fprintf(stderr, "Usage: disk_benchmark [-h] [-d directory] [-t time_per_benchmark] [-f file_size1,file_size2,...] [-b block_size1,block_size2,...]\n");
+    fprintf(stderr, "Usage: disk_benchmark [-h] [-c] [-s] [-d directory] [-t time_per_benchmark] [-f file_size1,file_size2,...] [-b block_size1,block_size2,...]\n");
+    fprintf(stderr, "  -c  go through the caches instead of using O_DIRECT\n");
+    fprintf(stderr, "  -s  run both ways and report how much faster cached (readahead) reads are\n");
     exit(rc);
 }
 
 Result benchmark(const String& filename, int file_size, int block_size, ByteBuffer& buffer, bool allow_cache);
+Result run_benchmarks(const String& filename, int file_size, int block_size, int time_per_benchmark, bool allow_cache);
 
 int main(int argc, char** argv)
 {
@@ -72,9 +75,10 @@ int main(int argc, char** argv)
     Vector<int> file_sizes;
     Vector<int> block_sizes;
     bool allow_cache = false;
+    bool compare = false;
 
     int opt;
-    while ((opt = getopt(argc, argv, "chd:t:f:b:")) != -1) {
+    while ((opt = getopt(argc, argv, "chsd:t:f:b:")) != -1) {
         switch (opt) {
         case 'h':
             exit_with_usage(0);
@@ -82,6 +86,9 @@ int main(int argc, char** argv)
         case 'c':
             allow_cache = true;
             break;
+        case 's':
+            compare = true;
+            break;
         case 'd':
             directory = strdup(optarg);
             break;
@@ -115,23 +122,15 @@ int main(int argc, char** argv)
             if (block_size > file_size)
                 continue;
 
-            auto buffer = ByteBuffer::create_uninitialized(block_size);
-
-            Vector<Result> results;
-
-            printf("Running: file_size=%d block_size=%d\n", file_size, block_size);
-            Core::ElapsedTimer timer;
-            timer.start();
-            while (timer.elapsed() < time_per_benchmark * 1000) {
-                printf(".");
-                fflush(stdout);
-                results.append(benchmark(filename, file_size, block_size, buffer, allow_cache));
-                usleep(100);
+            if (!compare) {
+                run_benchmarks(filename, file_size, block_size, time_per_benchmark, allow_cache);
+                continue;
             }
-            auto average = average_result(results);
-            printf("\nFinished: runs=%zu time=%dms write_bps=%llu read_bps=%llu\n", results.size(), timer.elapsed(), average.write_bps, average.read_bps);
 
-            sleep(1);
+            auto direct = run_benchmarks(filename, file_size, block_size, time_per_benchmark, false);
+            auto cached = run_benchmarks(filename, file_size, block_size, time_per_benchmark, true);
+            if (direct.read_bps)
+                printf("Read speedup with caching and readahead: %llu.%02llux\n", cached.read_bps / direct.read_bps, (cached.read_bps * 100 / direct.read_bps) % 100);
         }
     }
 
@@ -141,6 +140,28 @@ int main(int argc, char** argv)
     }
 }
 
+Result run_benchmarks(const String& filename, int file_size, int block_size, int time_per_benchmark, bool allow_cache)
+{
+    auto buffer = ByteBuffer::create_uninitialized(block_size);
+
+    Vector<Result> results;
+
+    printf("Running: file_size=%d block_size=%d cache=%s\n", file_size, block_size, allow_cache ? "yes" : "no");
+    Core::ElapsedTimer timer;
+    timer.start();
+    while (timer.elapsed() < time_per_benchmark * 1000) {
+        printf(".");
+        fflush(stdout);
+        results.append(benchmark(filename, file_size, block_size, buffer, allow_cache));
+        usleep(100);
+    }
+    auto average = average_result(results);
+    printf("\nFinished: runs=%zu time=%dms write_bps=%llu read_bps=%llu\n", results.size(), timer.elapsed(), average.write_bps, average.read_bps);
+
+    sleep(1);
+    return average;
+}
+
 Result benchmark(const String& filename, int file_size, int block_size, ByteBuffer& buffer, bool allow_cache)
 {
     int flags = O_CREAT | O_TRUNC | O_RDWR;
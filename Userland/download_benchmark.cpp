@@ -0,0 +1,312 @@
+/*
+ * Copyright (c) 2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/QuickSort.h>
+#include <AK/URL.h>
+#include <AK/Vector.h>
+#include <LibCore/ArgsParser.h>
+#include <LibCore/ElapsedTimer.h>
+#include <LibCore/EventLoop.h>
+#include <LibCore/Object.h>
+#include <LibCore/TCPSocket.h>
+#include <LibGemini/GeminiRequest.h>
+#include <LibGemini/GeminiResponse.h>
+#include <LibHTTP/HttpJob.h>
+#include <LibHTTP/HttpRequest.h>
+#include <LibHTTP/HttpsJob.h>
+#include <LibProtocol/Client.h>
+#include <LibProtocol/Download.h>
+#include <LibTLS/TLSv12.h>
+#include <stdio.h>
+#include <time.h>
+
+// Downloads a URL over and over, with a number of downloads going at once, and reports the throughput and how long
+// the downloads took. By default the downloads go through ProtocolServer like everybody else's. With --direct, they're
+// made in this process with LibHTTP and LibTLS (or LibGemini), which leaves IPC out of the measurement.
+
+static u64 now_in_microseconds()
+{
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (u64)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+class Benchmark final : public Core::Object {
+    C_OBJECT(Benchmark)
+public:
+    struct Options {
+        URL url;
+        int connection_count { 8 };
+        int request_count { 1000 };
+        bool keep_alive { false };
+        bool direct { false };
+    };
+
+    void start()
+    {
+        m_timer.start();
+        m_slots.resize(min(m_options.connection_count, m_options.request_count));
+        for (auto& slot : m_slots)
+            start_download(slot);
+        if (m_slots.is_empty())
+            Core::EventLoop::current().quit(0);
+    }
+
+    void print_results();
+
+private:
+    // One download at a time; when it's done, the next one is started in its place.
+    struct Slot {
+        RefPtr<Protocol::Download> download;
+        RefPtr<Core::NetworkJob> job;
+        // Kept between downloads in direct mode with --keep-alive.
+        RefPtr<Core::TCPSocket> tcp_socket;
+        RefPtr<TLS::TLSv12> tls_socket;
+        u64 start_time { 0 };
+        bool is_busy { false };
+    };
+
+    explicit Benchmark(const Options& options)
+        : m_options(options)
+    {
+        if (!m_options.direct)
+            m_protocol_client = Protocol::Client::construct();
+    }
+
+    void start_download(Slot&);
+    void start_through_protocol_server(Slot&);
+    void start_direct(Slot&);
+    void did_receive_headers(Slot&);
+    void did_finish_download(Slot&, bool success, size_t size);
+    void start_next_download_later(Slot&);
+
+    Options m_options;
+    RefPtr<Protocol::Client> m_protocol_client;
+    Vector<Slot> m_slots;
+    Core::ElapsedTimer m_timer;
+    int m_started { 0 };
+    int m_completed { 0 };
+    int m_failed { 0 };
+    u64 m_bytes { 0 };
+    // In microseconds, from starting a download to having all of it, and to having its headers.
+    Vector<u64> m_latencies;
+    Vector<u64> m_header_latencies;
+};
+
+void Benchmark::start_download(Slot& slot)
+{
+    if (m_started == m_options.request_count) {
+        slot.is_busy = false;
+        for (auto& other_slot : m_slots) {
+            if (other_slot.is_busy)
+                return;
+        }
+        Core::EventLoop::current().quit(0);
+        return;
+    }
+    ++m_started;
+    slot.is_busy = true;
+    slot.start_time = now_in_microseconds();
+    if (m_options.direct)
+        start_direct(slot);
+    else
+        start_through_protocol_server(slot);
+}
+
+void Benchmark::start_through_protocol_server(Slot& slot)
+{
+    // ProtocolServer keeps connections open by itself, so without --keep-alive the server is asked to close them.
+    HashMap<String, String> request_headers;
+    if (!m_options.keep_alive && m_options.url.protocol() != "gemini")
+        request_headers.set("Connection", "close");
+    slot.download = m_protocol_client->start_download(m_options.url.to_string(), request_headers);
+    if (!slot.download) {
+        did_finish_download(slot, false, 0);
+        return;
+    }
+    auto size = make<size_t>(0);
+    slot.download->on_headers_received = [this, &slot](auto&) {
+        did_receive_headers(slot);
+    };
+    slot.download->on_data = [size = size.ptr()](auto& data) {
+        *size += data.size();
+    };
+    slot.download->on_finish = [this, &slot, size = move(size)](bool success, auto&, auto&) {
+        did_finish_download(slot, success, *size);
+    };
+}
+
+void Benchmark::start_direct(Slot& slot)
+{
+    auto& url = m_options.url;
+    if (url.protocol() == "gemini") {
+        Gemini::GeminiRequest request;
+        request.set_url(url);
+        slot.job = request.schedule();
+        slot.job->on_finish = [this, &slot](bool success) {
+            auto* response = slot.job->response();
+            did_finish_download(slot, success, response ? response->payload().size() : 0);
+        };
+        return;
+    }
+
+    HTTP::HttpRequest request;
+    request.set_method(HTTP::HttpRequest::Method::GET);
+    request.set_url(url);
+    HashMap<String, String> request_headers;
+    request_headers.set("Connection", m_options.keep_alive ? "keep-alive" : "close");
+    request.set_headers(request_headers);
+
+    RefPtr<HTTP::Job> job;
+    if (url.protocol() == "https") {
+        if (!slot.tls_socket || !slot.tls_socket->is_established())
+            slot.tls_socket = TLS::TLSv12::construct(nullptr);
+        auto https_job = HTTP::HttpsJob::construct(request);
+        https_job->start(*slot.tls_socket);
+        job = move(https_job);
+    } else {
+        if (!slot.tcp_socket || !slot.tcp_socket->is_connected() || slot.tcp_socket->eof())
+            slot.tcp_socket = Core::TCPSocket::construct(nullptr);
+        auto http_job = HTTP::HttpJob::construct(request);
+        http_job->start(*slot.tcp_socket);
+        job = move(http_job);
+    }
+
+    auto size = make<size_t>(0);
+    job->on_headers_received = [this, &slot](auto&) {
+        did_receive_headers(slot);
+    };
+    job->on_body_data = [size = size.ptr()](auto& data) {
+        *size += data.size();
+    };
+    job->on_finish = [this, &slot, size = move(size)](bool success) {
+        did_finish_download(slot, success, *size);
+    };
+    // The job lets go of the connection only after it has finished, so that's when the next download can have it.
+    job->on_socket_released = [this, &slot](bool can_reuse_connection) {
+        if (!m_options.keep_alive || !can_reuse_connection) {
+            if (slot.tcp_socket)
+                slot.tcp_socket->close();
+            if (slot.tls_socket)
+                slot.tls_socket->close();
+            slot.tcp_socket = nullptr;
+            slot.tls_socket = nullptr;
+        }
+        start_next_download_later(slot);
+    };
+    slot.job = move(job);
+}
+
+void Benchmark::did_receive_headers(Slot& slot)
+{
+    m_header_latencies.append(now_in_microseconds() - slot.start_time);
+}
+
+void Benchmark::did_finish_download(Slot& slot, bool success, size_t size)
+{
+    if (success) {
+        ++m_completed;
+        m_bytes += size;
+        m_latencies.append(now_in_microseconds() - slot.start_time);
+    } else {
+        ++m_failed;
+    }
+    // HTTP jobs we made ourselves carry on from on_socket_released, whether they succeeded or not.
+    if (m_options.direct && m_options.url.protocol() != "gemini")
+        return;
+    start_next_download_later(slot);
+}
+
+void Benchmark::start_next_download_later(Slot& slot)
+{
+    // We're called back from the download or job that just finished, which shouldn't go away under itself.
+    deferred_invoke([this, &slot](auto&) {
+        slot.download = nullptr;
+        slot.job = nullptr;
+        start_download(slot);
+    });
+}
+
+static void print_latencies(const char* title, Vector<u64>& latencies)
+{
+    if (latencies.is_empty())
+        return;
+    quick_sort(latencies);
+    u64 total = 0;
+    for (auto latency : latencies)
+        total += latency;
+    auto percentile = [&](size_t percent) {
+        return latencies[min(latencies.size() - 1, latencies.size() * percent / 100)];
+    };
+    auto print_milliseconds = [](const char* name, u64 microseconds) {
+        printf(" %s %llu.%03llu", name, microseconds / 1000, microseconds % 1000);
+    };
+    printf("%s (ms):", title);
+    print_milliseconds("min", latencies.first());
+    print_milliseconds("avg", total / latencies.size());
+    print_milliseconds("50%", percentile(50));
+    print_milliseconds("90%", percentile(90));
+    print_milliseconds("99%", percentile(99));
+    print_milliseconds("max", latencies.last());
+    printf("\n");
+}
+
+void Benchmark::print_results()
+{
+    int elapsed_ms = max(m_timer.elapsed(), 1);
+    printf("%d downloads completed, %d failed, in %d.%03d seconds\n", m_completed, m_failed, elapsed_ms / 1000, elapsed_ms % 1000);
+    printf("%llu downloads/second, %llu KiB/second\n", (u64)m_completed * 1000 / elapsed_ms, m_bytes * 1000 / elapsed_ms / KB);
+    print_latencies("Latency", m_latencies);
+    print_latencies("Time to headers", m_header_latencies);
+}
+
+int main(int argc, char** argv)
+{
+    Benchmark::Options options;
+    const char* url_string = nullptr;
+
+    Core::ArgsParser args_parser;
+    args_parser.add_option(options.connection_count, "Number of downloads to have going at once", "connections", 'c', "count");
+    args_parser.add_option(options.request_count, "Number of downloads to make", "requests", 'n', "count");
+    args_parser.add_option(options.keep_alive, "Keep connections open between downloads", "keep-alive", 'k');
+    args_parser.add_option(options.direct, "Download in this process rather than through ProtocolServer", "direct", 'd');
+    args_parser.add_positional_argument(url_string, "URL to download (http, https or gemini)", "url");
+    args_parser.parse(argc, argv);
+
+    options.url = URL(url_string);
+    auto protocol = options.url.protocol();
+    if (!options.url.is_valid() || (protocol != "http" && protocol != "https" && protocol != "gemini")) {
+        fprintf(stderr, "'%s' is not a valid http, https or gemini URL\n", url_string);
+        return 1;
+    }
+
+    Core::EventLoop loop;
+    auto benchmark = Benchmark::construct(options);
+    benchmark->start();
+    loop.exec();
+    benchmark->print_results();
+    return 0;
+}
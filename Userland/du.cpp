@@ -56,7 +56,7 @@ struct DuOption {
 };
 
 static int parse_args(int argc, char** argv, Vector<String>& files, DuOption& du_option, int& max_depth);
-static int print_space_usage(const String& path, const DuOption& du_option, int max_depth);
+static int print_space_usage(const String& path, const DuOption& du_option, int max_depth, const struct stat* known_stat = nullptr);
 
 int main(int argc, char** argv)
 {
@@ -141,10 +141,12 @@ int parse_args(int argc, char** argv, Vector<String>& files, DuOption& du_option
     return 0;
 }
 
-int print_space_usage(const String& path, const DuOption& du_option, int max_depth)
+int print_space_usage(const String& path, const DuOption& du_option, int max_depth, const struct stat* known_stat)
 {
     struct stat path_stat;
-    if (lstat(path.characters(), &path_stat) < 0) {
+    if (known_stat) {
+        path_stat = *known_stat;
+    } else if (lstat(path.characters(), &path_stat) < 0) {
         perror("lstat");
         return 1;
     }
@@ -156,9 +158,14 @@ int print_space_usage(const String& path, const DuOption& du_option, int max_dep
             return 1;
         }
         while (di.has_next()) {
-            const auto child_path = di.next_full_path();
-            if (du_option.all || Core::File::is_directory(child_path)) {
-                if (print_space_usage(child_path, du_option, max_depth))
+            const auto child_name = di.next_path();
+            struct stat child_stat;
+            if (fstatat(di.fd(), child_name.characters(), &child_stat, AT_SYMLINK_NOFOLLOW) < 0) {
+                perror("fstatat");
+                return 1;
+            }
+            if (du_option.all || S_ISDIR(child_stat.st_mode)) {
+                if (print_space_usage(String::format("%s/%s", path.characters(), child_name.characters()), du_option, max_depth, &child_stat))
                     return 1;
             }
         }
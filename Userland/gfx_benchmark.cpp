@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) 2018-2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/StringView.h>
+#include <AK/Vector.h>
+#include <LibCore/ArgsParser.h>
+#include <LibGfx/BlendKernels.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+static constexpr size_t widths[] = { 16, 64, 256, 1024, 1920 };
+static constexpr size_t max_width = 1920;
+static constexpr size_t pixels_per_run = 16 * MB;
+
+static Gfx::RGBA32* s_source;
+static Gfx::RGBA32* s_row;
+static Gfx::RGBA32* s_destination;
+
+// Every kernel processes a row of `width` pixels with a mix of opaque, translucent and transparent
+// alpha values, blending them over an opaque row or converting them into it.
+using Variant = void (*)(Gfx::RGBA32* destination, const Gfx::RGBA32* source, size_t width);
+
+struct Benchmark {
+    const char* name;
+    Variant generic;
+    Variant sse2;
+};
+
+// What Painter::draw_scaled_bitmap() does for a translucent source: gather a row at 1.5x, then blend it.
+template<void (*blend)(Gfx::RGBA32*, const Gfx::RGBA32*, size_t)>
+static void scale_and_blend(Gfx::RGBA32* destination, const Gfx::RGBA32* source, size_t width)
+{
+    const int hscale = (2 << 16) / 3;
+    int scaled_x = 0;
+    for (size_t i = 0; i < width; ++i) {
+        s_row[i] = source[scaled_x >> 16];
+        scaled_x += hscale;
+    }
+    blend(destination, s_row, width);
+}
+
+#if ARCH(I386)
+static const Benchmark benchmarks[] = {
+    { "blend", Gfx::BlendKernels::blend_row_generic, Gfx::BlendKernels::blend_row_sse2 },
+    { "opacity", [](Gfx::RGBA32* d, const Gfx::RGBA32* s, size_t n) { Gfx::BlendKernels::blend_row_with_opacity_generic(d, s, n, 0xc0, true); }, [](Gfx::RGBA32* d, const Gfx::RGBA32* s, size_t n) { Gfx::BlendKernels::blend_row_with_opacity_sse2(d, s, n, 0xc0, true); } },
+    { "opacity-rgb", [](Gfx::RGBA32* d, const Gfx::RGBA32* s, size_t n) { Gfx::BlendKernels::blend_row_with_opacity_generic(d, s, n, 0xc0, false); }, [](Gfx::RGBA32* d, const Gfx::RGBA32* s, size_t n) { Gfx::BlendKernels::blend_row_with_opacity_sse2(d, s, n, 0xc0, false); } },
+    { "scaled", scale_and_blend<Gfx::BlendKernels::blend_row_generic>, scale_and_blend<Gfx::BlendKernels::blend_row_sse2> },
+    { "premultiplied", Gfx::BlendKernels::blend_row_premultiplied_generic, Gfx::BlendKernels::blend_row_premultiplied_sse2 },
+    { "premultiply", Gfx::BlendKernels::premultiply_row_generic, Gfx::BlendKernels::premultiply_row_sse2 },
+    { "rgb565", [](Gfx::RGBA32* d, const Gfx::RGBA32* s, size_t n) { Gfx::BlendKernels::convert_row_to_rgb565_generic((u16*)d, s, n); }, [](Gfx::RGBA32* d, const Gfx::RGBA32* s, size_t n) { Gfx::BlendKernels::convert_row_to_rgb565_sse2((u16*)d, s, n); } },
+};
+#endif
+
+static u64 now_ns()
+{
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (u64)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+static u64 pixels_per_second(Variant variant, size_t width)
+{
+    size_t iterations = max(pixels_per_run / width, (size_t)1000);
+    u64 start = now_ns();
+    for (size_t i = 0; i < iterations; ++i)
+        variant(s_destination, s_source, width);
+    u64 elapsed = max(now_ns() - start, (u64)1);
+    return (u64)width * iterations * 1000000000 / elapsed;
+}
+
+int main(int argc, char** argv)
+{
+    Vector<const char*> kernel_names;
+
+    Core::ArgsParser args_parser;
+    args_parser.add_positional_argument(kernel_names, "Kernels to benchmark (all of them by default)", "kernels", Core::ArgsParser::Required::No);
+    args_parser.parse(argc, argv);
+
+#if ARCH(I386)
+    if (!Gfx::BlendKernels::cpu_supports_sse2()) {
+        fprintf(stderr, "This CPU does not support SSE2\n");
+        return 1;
+    }
+
+    s_source = (Gfx::RGBA32*)malloc(max_width * sizeof(Gfx::RGBA32));
+    s_row = (Gfx::RGBA32*)malloc(max_width * sizeof(Gfx::RGBA32));
+    s_destination = (Gfx::RGBA32*)malloc(max_width * sizeof(Gfx::RGBA32));
+    for (size_t i = 0; i < max_width; ++i) {
+        // A quarter each of opaque and transparent pixels, the rest translucent, like a typical shadow or icon.
+        u32 alpha = i % 4 == 0 ? 0xff : i % 4 == 1 ? 0 : (i * 37) & 0xff;
+        s_source[i] = (alpha << 24) | ((i * 2654435761u) & 0xffffff);
+        s_destination[i] = 0xff000000 | (i * 40503u & 0xffffff);
+    }
+
+    printf("kernel       width  generic MP/s     sse2 MP/s  speedup\n");
+    for (auto& benchmark : benchmarks) {
+        bool selected = kernel_names.is_empty();
+        for (auto* name : kernel_names)
+            selected |= StringView(name) == benchmark.name;
+        if (!selected)
+            continue;
+        for (size_t width : widths) {
+            u64 generic = pixels_per_second(benchmark.generic, width);
+            u64 sse2 = pixels_per_second(benchmark.sse2, width);
+            printf("%-11s %6zu  %12llu  %12llu  %4llu.%02llux\n", benchmark.name, width, generic / 1000000, sse2 / 1000000, sse2 / generic, sse2 * 100 / generic % 100);
+        }
+    }
+    return 0;
+#else
+    fprintf(stderr, "The SSE2 kernels are only built for i386\n");
+    return 1;
+#endif
+}
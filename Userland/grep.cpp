@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) 2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/String.h>
+#include <AK/Vector.h>
+#include <LibCore/ArgsParser.h>
+#include <LibRegex/Pattern.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+int main(int argc, char** argv)
+{
+    if (pledge("stdio rpath", nullptr) < 0) {
+        perror("pledge");
+        return 2;
+    }
+
+    const char* pattern_source = nullptr;
+    Vector<const char*> files;
+    bool ignore_case = false;
+    bool invert_match = false;
+    bool print_line_numbers = false;
+    bool count_only = false;
+
+    Core::ArgsParser args_parser;
+    args_parser.add_option(ignore_case, "Ignore case distinctions", "ignore-case", 'i');
+    args_parser.add_option(invert_match, "Select non-matching lines", "invert-match", 'v');
+    args_parser.add_option(print_line_numbers, "Prefix each line with its line number", "line-number", 'n');
+    args_parser.add_option(count_only, "Only print the number of selected lines", "count", 'c');
+    args_parser.add_positional_argument(pattern_source, "Regular expression to search for", "pattern");
+    args_parser.add_positional_argument(files, "Files to search", "file", Core::ArgsParser::Required::No);
+    args_parser.parse(argc, argv);
+
+    auto pattern = Regex::Pattern::create(pattern_source, ignore_case ? Regex::CaseInsensitive : Regex::NoFlags);
+    if (!pattern->is_valid()) {
+        fprintf(stderr, "grep: %s\n", pattern->error().characters());
+        return 2;
+    }
+
+    Vector<FILE*> file_pointers;
+    Vector<const char*> file_names;
+    bool had_error = false;
+    if (!files.is_empty()) {
+        for (auto& file : files) {
+            FILE* file_pointer = fopen(file, "r");
+            if (!file_pointer) {
+                perror(file);
+                had_error = true;
+                continue;
+            }
+            file_pointers.append(file_pointer);
+            file_names.append(file);
+        }
+    } else {
+        file_pointers.append(stdin);
+        file_names.append("(standard input)");
+    }
+
+    bool print_file_names = files.size() > 1;
+    bool found_any = false;
+    char* line = nullptr;
+    size_t line_capacity = 0;
+    for (size_t i = 0; i < file_pointers.size(); ++i) {
+        size_t line_number = 0;
+        size_t selected_count = 0;
+        ssize_t line_length;
+        while ((line_length = getline(&line, &line_capacity, file_pointers[i])) >= 0) {
+            ++line_number;
+            StringView text(line, line_length);
+            if (text.ends_with('\n'))
+                text = text.substring_view(0, text.length() - 1);
+            if (pattern->has_match(text) == invert_match)
+                continue;
+            ++selected_count;
+            if (count_only)
+                continue;
+            if (print_file_names)
+                printf("%s:", file_names[i]);
+            if (print_line_numbers)
+                printf("%zu:", line_number);
+            fwrite(text.characters_without_null_termination(), 1, text.length(), stdout);
+            putchar('\n');
+        }
+        if (count_only) {
+            if (print_file_names)
+                printf("%s:", file_names[i]);
+            printf("%zu\n", selected_count);
+        }
+        if (selected_count)
+            found_any = true;
+        if (file_pointers[i] != stdin)
+            fclose(file_pointers[i]);
+    }
+    free(line);
+
+    if (had_error)
+        return 2;
+    return found_any ? 0 : 1;
+}
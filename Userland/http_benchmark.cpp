@@ -0,0 +1,233 @@
+/*
+ * Copyright (c) 2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/ByteBuffer.h>
+#include <AK/String.h>
+#include <AK/StringView.h>
+#include <AK/Vector.h>
+#include <LibCore/ArgsParser.h>
+#include <LibCore/ElapsedTimer.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// Measures how many requests per second an HTTP server answers, with a number of connections each asking for
+// the same resource over and over, one request at a time.
+
+struct Connection {
+    int fd { -1 };
+    // The response header, until all of it is in.
+    ByteBuffer header;
+    bool has_header { false };
+    size_t content_length { 0 };
+    size_t body_received { 0 };
+    bool server_closes { false };
+};
+
+static sockaddr_in s_address;
+static ByteBuffer s_request;
+static int s_requests_to_start { 0 };
+static int s_completed { 0 };
+static int s_failed { 0 };
+static u64 s_body_bytes { 0 };
+static bool s_keep_alive { false };
+
+static bool send_request(Connection& connection)
+{
+    if (connection.fd < 0) {
+        connection.fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (connection.fd < 0) {
+            perror("socket");
+            return false;
+        }
+        if (connect(connection.fd, (const sockaddr*)&s_address, sizeof(s_address)) < 0) {
+            perror("connect");
+            close(connection.fd);
+            connection.fd = -1;
+            return false;
+        }
+    }
+    connection.header.clear();
+    connection.has_header = false;
+    connection.content_length = 0;
+    connection.body_received = 0;
+    connection.server_closes = false;
+    --s_requests_to_start;
+    if (write(connection.fd, s_request.data(), s_request.size()) != (ssize_t)s_request.size()) {
+        perror("write");
+        return false;
+    }
+    return true;
+}
+
+static void close_connection(Connection& connection)
+{
+    close(connection.fd);
+    connection.fd = -1;
+}
+
+// Picks out what we need from a response header: how long the body is, and whether the connection ends with it.
+static void parse_header(Connection& connection, const StringView& header)
+{
+    for (auto& line : header.lines()) {
+        auto colon = line.find_first_of(':');
+        if (!colon.has_value())
+            continue;
+        auto name = line.substring_view(0, colon.value());
+        auto value = String(line.substring_view(colon.value() + 1, line.length() - colon.value() - 1)).trim_whitespace();
+        if (name.equals_ignoring_case("Content-Length")) {
+            bool ok;
+            connection.content_length = value.to_uint(ok);
+        } else if (name.equals_ignoring_case("Connection")) {
+            connection.server_closes = value.equals_ignoring_case("close");
+        }
+    }
+}
+
+// Returns false once the connection is done with, for whatever reason.
+static bool did_receive(Connection& connection, const u8* data, size_t size)
+{
+    if (!connection.has_header) {
+        connection.header.append(data, size);
+        auto text = StringView(connection.header.data(), connection.header.size());
+        auto end = String(text).index_of("\r\n\r\n");
+        if (!end.has_value())
+            return true;
+        connection.has_header = true;
+        parse_header(connection, text.substring_view(0, end.value()));
+        connection.body_received = connection.header.size() - end.value() - 4;
+    } else {
+        connection.body_received += size;
+    }
+
+    if (connection.body_received < connection.content_length)
+        return true;
+
+    ++s_completed;
+    s_body_bytes += connection.content_length;
+    if (!s_keep_alive || connection.server_closes)
+        close_connection(connection);
+    if (s_requests_to_start <= 0)
+        return false;
+    if (!send_request(connection)) {
+        ++s_failed;
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    int connection_count = 8;
+    int request_count = 10000;
+    bool keep_alive = false;
+    const char* host = nullptr;
+    int port = 80;
+    const char* path = "/";
+
+    Core::ArgsParser args_parser;
+    args_parser.add_option(connection_count, "Number of connections to use at once", "connections", 'c', "count");
+    args_parser.add_option(request_count, "Number of requests to make", "requests", 'n', "count");
+    args_parser.add_option(keep_alive, "Keep connections open between requests", "keep-alive", 'k');
+    args_parser.add_positional_argument(host, "IPv4 address of the server", "address");
+    args_parser.add_positional_argument(port, "Port of the server", "port");
+    args_parser.add_positional_argument(path, "Path to ask for", "path", Core::ArgsParser::Required::No);
+    args_parser.parse(argc, argv);
+
+    memset(&s_address, 0, sizeof(s_address));
+    s_address.sin_family = AF_INET;
+    s_address.sin_port = htons(port);
+    if (inet_pton(AF_INET, host, &s_address.sin_addr) <= 0) {
+        fprintf(stderr, "Invalid address: %s\n", host);
+        return 1;
+    }
+
+    s_keep_alive = keep_alive;
+    s_requests_to_start = request_count;
+    s_request = String::format("GET %s HTTP/1.1\r\nHost: %s\r\nConnection: %s\r\n\r\n", path, host, keep_alive ? "keep-alive" : "close").to_byte_buffer();
+
+    Vector<Connection> connections;
+    connections.resize(min(connection_count, request_count));
+
+    Core::ElapsedTimer timer;
+    timer.start();
+
+    for (auto& connection : connections) {
+        if (!send_request(connection)) {
+            ++s_failed;
+            close_connection(connection);
+        }
+    }
+
+    Vector<pollfd> poll_fds;
+    Vector<Connection*> polled_connections;
+    auto buffer = ByteBuffer::create_uninitialized(64 * KB);
+    for (;;) {
+        poll_fds.clear();
+        polled_connections.clear();
+        for (auto& connection : connections) {
+            if (connection.fd < 0)
+                continue;
+            poll_fds.append({ connection.fd, POLLIN, 0 });
+            polled_connections.append(&connection);
+        }
+        if (poll_fds.is_empty())
+            break;
+
+        if (poll(poll_fds.data(), poll_fds.size(), -1) < 0) {
+            perror("poll");
+            return 1;
+        }
+
+        for (size_t i = 0; i < poll_fds.size(); ++i) {
+            if (!poll_fds[i].revents)
+                continue;
+            auto& connection = *polled_connections[i];
+            ssize_t nread = read(connection.fd, buffer.data(), buffer.size());
+            if (nread <= 0) {
+                // The server closed the connection before the response was complete.
+                ++s_failed;
+                close_connection(connection);
+                if (s_requests_to_start > 0 && !send_request(connection)) {
+                    ++s_failed;
+                    close_connection(connection);
+                }
+                continue;
+            }
+            if (!did_receive(connection, buffer.data(), nread) && connection.fd >= 0)
+                close_connection(connection);
+        }
+    }
+
+    int elapsed_ms = max(timer.elapsed(), 1);
+    printf("%d requests completed, %d failed, in %d.%03d seconds\n", s_completed, s_failed, elapsed_ms / 1000, elapsed_ms % 1000);
+    printf("%llu requests/second, %llu KiB/second\n", (u64)s_completed * 1000 / elapsed_ms, s_body_bytes * 1000 / elapsed_ms / KB);
+    return 0;
+}
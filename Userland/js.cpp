@@ -26,10 +26,12 @@
 
 #include <AK/ByteBuffer.h>
 #include <AK/NonnullOwnPtr.h>
+#include <AK/QuickSort.h>
 #include <AK/StringBuilder.h>
 #include <LibCore/ArgsParser.h>
 #include <LibCore/File.h>
 #include <LibJS/AST.h>
+#include <LibJS/Bytecode/Executable.h>
 #include <LibJS/Console.h>
 #include <LibJS/Interpreter.h>
 #include <LibJS/Parser.h>
@@ -41,10 +43,13 @@
 #include <LibJS/Runtime/Object.h>
 #include <LibJS/Runtime/PrimitiveString.h>
 #include <LibJS/Runtime/Shape.h>
+#include <LibJS/Runtime/TypedArray.h>
 #include <LibJS/Runtime/Value.h>
+#include <LibJS/ScriptCache.h>
 #include <LibLine/Editor.h>
 #include <signal.h>
 #include <stdio.h>
+#include <time.h>
 
 Vector<String> repl_statements;
 
@@ -65,7 +70,10 @@ private:
 };
 
 static bool s_dump_ast = false;
+static bool s_run_bytecode = false;
+static bool s_dump_bytecode = false;
 static bool s_print_last_result = false;
+static OwnPtr<JS::ScriptCache> s_script_cache;
 static RefPtr<Line::Editor> s_editor;
 static int s_repl_line_level = 0;
 static bool s_fail_repl = false;
@@ -206,6 +214,18 @@ static void print_object(JS::Object& object, HashTable<JS::Object*>& seen_object
     fputs(" }", stdout);
 }
 
+static void print_typed_array(JS::Object& object, HashTable<JS::Object*>& seen_objects)
+{
+    auto& typed_array = static_cast<JS::TypedArrayBase&>(object);
+    printf("\033[34;1m%s\033[0m [ ", typed_array.class_name());
+    for (u32 i = 0; i < typed_array.array_length(); ++i) {
+        if (i != 0)
+            fputs(", ", stdout);
+        print_value(typed_array.get_by_index(i), seen_objects);
+    }
+    fputs(" ]", stdout);
+}
+
 static void print_function(const JS::Object& function, HashTable<JS::Object*>&)
 {
     printf("\033[34;1m[%s]\033[0m", function.class_name());
@@ -252,6 +272,8 @@ void print_value(JS::Value value, HashTable<JS::Object*>& seen_objects)
             return print_date(object, seen_objects);
         if (object.is_error())
             return print_error(object, seen_objects);
+        if (object.is_typed_array())
+            return print_typed_array(object, seen_objects);
         return print_object(object, seen_objects);
     }
 
@@ -325,7 +347,11 @@ bool write_to_file(const StringView& path)
 
 bool parse_and_run(JS::Interpreter& interpreter, const StringView& source)
 {
-    auto parser = JS::Parser(JS::Lexer(source));
+    auto lexer = JS::Lexer(source);
+    if (s_script_cache)
+        lexer = JS::Lexer(source, s_script_cache->tokens_for(source, lexer));
+    auto parser = JS::Parser(lexer);
+    parser.set_lazy_function_bodies(true);
     auto program = parser.parse_program();
 
     if (s_dump_ast)
@@ -338,6 +364,8 @@ bool parse_and_run(JS::Interpreter& interpreter, const StringView& source)
             printf("%s\n", hint.characters());
         interpreter.throw_exception<JS::SyntaxError>(error.to_string());
     } else {
+        if (s_dump_bytecode)
+            program->bytecode().dump();
         interpreter.run(*program);
     }
 
@@ -528,24 +556,89 @@ public:
     }
 };
 
+static double elapsed_ms(const struct timespec& start, const struct timespec& end)
+{
+    return (end.tv_sec - start.tv_sec) * 1000.0 + (end.tv_nsec - start.tv_nsec) / 1000000.0;
+}
+
+// Runs the script in a fresh interpreter each time, so every run starts from the same heap.
+// The first run is a warm-up and isn't counted.
+static bool run_benchmark(const char* script_path, const StringView& source, int runs, bool test_mode)
+{
+    Vector<double> run_times;
+    Vector<JS::HeapStatistics> run_statistics;
+
+    for (int i = 0; i <= runs; ++i) {
+        auto interpreter = JS::Interpreter::create<JS::GlobalObject>();
+        ReplConsoleClient console_client(interpreter->console());
+        interpreter->console().set_client(console_client);
+        interpreter->set_bytecode_enabled(s_run_bytecode);
+        if (test_mode)
+            enable_test_mode(*interpreter);
+
+        struct timespec start_time;
+        clock_gettime(CLOCK_MONOTONIC, &start_time);
+        if (!parse_and_run(*interpreter, source))
+            return false;
+        struct timespec end_time;
+        clock_gettime(CLOCK_MONOTONIC, &end_time);
+
+        if (i == 0)
+            continue;
+        run_times.append(elapsed_ms(start_time, end_time));
+        run_statistics.append(interpreter->heap().statistics());
+    }
+
+    auto sorted_times = run_times;
+    quick_sort(sorted_times.begin(), sorted_times.end(), [](double a, double b) { return a < b; });
+
+    double cells = 0;
+    double bytes = 0;
+    double collections = 0;
+    double total_pause_ms = 0;
+    double max_pause_ms = 0;
+    for (auto& statistics : run_statistics) {
+        cells += statistics.allocated_cells;
+        bytes += statistics.allocated_bytes;
+        collections += statistics.collection_count;
+        total_pause_ms += statistics.total_pause_ms;
+        max_pause_ms = max(max_pause_ms, statistics.max_pause_ms);
+    }
+
+    printf("%s (%d runs)\n", script_path, runs);
+    printf("    time:  min %.2f ms, median %.2f ms, max %.2f ms\n", sorted_times.first(), sorted_times[sorted_times.size() / 2], sorted_times.last());
+    printf("    alloc: %.0f cells, %.2f MiB per run\n", cells / runs, bytes / runs / MB);
+    printf("    gc:    %.1f collections, %.2f ms paused per run, %.2f ms longest pause\n", collections / runs, total_pause_ms / runs, max_pause_ms);
+    return true;
+}
+
 int main(int argc, char** argv)
 {
     bool gc_on_every_allocation = false;
     bool disable_syntax_highlight = false;
     bool test_mode = false;
+    int benchmark_runs = 0;
     const char* script_path = nullptr;
+    const char* script_cache_directory = nullptr;
 
     Core::ArgsParser args_parser;
     args_parser.add_option(s_dump_ast, "Dump the AST", "dump-ast", 'A');
+    args_parser.add_option(s_run_bytecode, "Run scripts with the bytecode interpreter", "bytecode", 'b');
+    args_parser.add_option(s_dump_bytecode, "Dump the generated bytecode", "dump-bytecode", 'd');
     args_parser.add_option(s_print_last_result, "Print last result", "print-last-result", 'l');
     args_parser.add_option(gc_on_every_allocation, "GC on every allocation", "gc-on-every-allocation", 'g');
     args_parser.add_option(disable_syntax_highlight, "Disable live syntax highlighting", "no-syntax-highlight", 's');
     args_parser.add_option(test_mode, "Run the interpreter with added functionality for the test harness", "test-mode", 't');
+    args_parser.add_option(benchmark_runs, "Run the script this many times and print timing and heap statistics", "benchmark", 'B', "runs");
+    args_parser.add_option(script_cache_directory, "Cache the tokens of scripts in a directory", "script-cache", 'c', "directory");
     args_parser.add_positional_argument(script_path, "Path to script file", "script", Core::ArgsParser::Required::No);
     args_parser.parse(argc, argv);
 
     bool syntax_highlight = !disable_syntax_highlight;
 
+    if (script_cache_directory)
+        s_script_cache = make<JS::ScriptCache>(script_cache_directory);
+
     OwnPtr<JS::Interpreter> interpreter;
 
     interrupt_interpreter = [&] {
@@ -559,6 +652,7 @@ int main(int argc, char** argv)
         ReplConsoleClient console_client(interpreter->console());
         interpreter->console().set_client(console_client);
         interpreter->heap().set_should_collect_on_every_allocation(gc_on_every_allocation);
+        interpreter->set_bytecode_enabled(s_run_bytecode);
         if (test_mode)
             enable_test_mode(*interpreter);
 
@@ -839,6 +933,7 @@ int main(int argc, char** argv)
         ReplConsoleClient console_client(interpreter->console());
         interpreter->console().set_client(console_client);
         interpreter->heap().set_should_collect_on_every_allocation(gc_on_every_allocation);
+        interpreter->set_bytecode_enabled(s_run_bytecode);
         if (test_mode)
             enable_test_mode(*interpreter);
 
@@ -860,8 +955,12 @@ int main(int argc, char** argv)
             source = file_contents;
         }
 
-        if (!parse_and_run(*interpreter, source))
+        if (benchmark_runs > 0) {
+            if (!run_benchmark(script_path, source, benchmark_runs, test_mode))
+                return 1;
+        } else if (!parse_and_run(*interpreter, source)) {
             return 1;
+        }
     }
 
     return 0;
@@ -353,9 +353,9 @@ int do_file_system_object_long(const char* path)
         builder.append(metadata.name);
         metadata.path = builder.to_string();
         ASSERT(!metadata.path.is_null());
-        int rc = lstat(metadata.path.characters(), &metadata.stat);
+        int rc = fstatat(di.fd(), metadata.name.characters(), &metadata.stat, AT_SYMLINK_NOFOLLOW);
         if (rc < 0) {
-            perror("lstat");
+            perror("fstatat");
             memset(&metadata.stat, 0, sizeof(metadata.stat));
         }
         files.append(move(metadata));
@@ -380,10 +380,11 @@ int do_file_system_object_long(const char* path)
     return 0;
 }
 
-bool print_filesystem_object_short(const char* path, const char* name, size_t* nprinted)
+bool print_filesystem_object_short(const char* path, const char* name, size_t* nprinted, int dirfd = AT_FDCWD)
 {
+    // Entries of a directory being listed are looked up relative to it, instead of resolving their full path again.
     struct stat st;
-    int rc = lstat(path, &st);
+    int rc = dirfd == AT_FDCWD ? lstat(path, &st) : fstatat(dirfd, name, &st, AT_SYMLINK_NOFOLLOW);
     if (rc == -1) {
         printf("lstat(%s) failed: %s\n", path, strerror(errno));
         return false;
@@ -427,7 +428,7 @@ int do_file_system_object_short(const char* path)
         builder.append(path);
         builder.append('/');
         builder.append(name);
-        if (!print_filesystem_object_short(builder.to_string().characters(), name.characters(), &nprinted))
+        if (!print_filesystem_object_short(builder.to_string().characters(), name.characters(), &nprinted, di.fd()))
             return 2;
         int offset = 0;
         if (terminal_columns > longest_name)
@@ -78,12 +78,13 @@ int main(int argc, char** argv)
         previous_downloaded_size = downloaded_size;
         prev_time = current_time;
     };
-    download->on_finish = [&](bool success, auto& payload, auto, auto&) {
+    download->on_data = [&](auto& data) {
+        write(STDOUT_FILENO, data.data(), data.size());
+    };
+    download->on_finish = [&](bool success, auto&, auto&) {
         fprintf(stderr, "\033]9;-1;\033\\");
         fprintf(stderr, "\n");
-        if (success)
-            write(STDOUT_FILENO, payload.data(), payload.size());
-        else
+        if (!success)
             fprintf(stderr, "Download failed :(\n");
         loop.quit(0);
     };
@@ -24,11 +24,115 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <AK/HashMap.h>
+#include <AK/JsonArray.h>
+#include <AK/JsonObject.h>
+#include <AK/JsonValue.h>
 #include <LibCore/ArgsParser.h>
+#include <LibCore/File.h>
 #include <serenity.h>
+#include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
+
+static volatile bool g_should_stop;
+
+static int parse_counter_event(const char* name)
+{
+    static const char* names[PERF_COUNTER_EVENT_COUNT] = { "cycles", "instructions", "cache-misses", "branch-misses" };
+    for (int i = 0; i < PERF_COUNTER_EVENT_COUNT; ++i) {
+        if (!strcmp(name, names[i]))
+            return i;
+    }
+    return -1;
+}
+
+static bool enable_counter_sampling(pid_t pid, const char* event_name, unsigned period)
+{
+    int event = parse_counter_event(event_name);
+    if (event < 0) {
+        fprintf(stderr, "Unknown event '%s', expected cycles, instructions, cache-misses or branch-misses.\n", event_name);
+        return false;
+    }
+    if (perf_counters_sample(pid, event, period) < 0) {
+        perror("perf_counters_sample");
+        return false;
+    }
+    return true;
+}
+
+static int profile_all_processes(const char* output_path)
+{
+    FILE* output = fopen(output_path, "w");
+    if (!output) {
+        perror("fopen");
+        return 1;
+    }
+
+    signal(SIGINT, [](int) { g_should_stop = true; });
+
+    if (profiling_enable(-1) < 0) {
+        perror("profiling_enable");
+        return 1;
+    }
+
+    fprintf(stderr, "Profiling all processes into %s, press ^C to stop.\n", output_path);
+
+    HashMap<pid_t, String> executables;
+    u64 lost_samples = 0;
+    bool is_first_event = true;
+
+    // The kernel hands out each sample only once through /proc/profile_stream,
+    // so we keep draining it while the profile runs to stay ahead of the ring buffer.
+    auto drain_samples = [&] {
+        auto file = Core::File::construct("/proc/profile_stream");
+        if (!file->open(Core::IODevice::ReadOnly)) {
+            fprintf(stderr, "Error: %s\n", file->error_string());
+            return;
+        }
+        auto json = JsonValue::from_string(file->read_all());
+        if (!json.is_object())
+            return;
+        auto& object = json.as_object();
+        object.get("processes").as_array().for_each([&](auto& value) {
+            auto& process = value.as_object();
+            executables.set(process.get("pid").to_i32(), process.get("executable").to_string());
+        });
+        object.get("events").as_array().for_each([&](auto& value) {
+            if (!is_first_event)
+                fputc(',', output);
+            is_first_event = false;
+            fputs(value.to_string().characters(), output);
+        });
+        lost_samples = object.get("lost_samples").to_number<u64>();
+    };
+
+    fputs("{\"pid\":-1,\"executable\":\"\",\"events\":[", output);
+    while (!g_should_stop) {
+        usleep(250000);
+        drain_samples();
+    }
+
+    if (profiling_disable(-1) < 0)
+        perror("profiling_disable");
+    drain_samples();
+
+    JsonArray processes;
+    for (auto& it : executables) {
+        JsonObject process;
+        process.set("pid", it.key);
+        process.set("executable", it.value);
+        processes.append(move(process));
+    }
+    fprintf(output, "],\"processes\":%s}", processes.to_string().characters());
+    fclose(output);
+
+    if (lost_samples)
+        fprintf(stderr, "Lost %llu samples, the ring buffer overflowed.\n", lost_samples);
+    return 0;
+}
 
 int main(int argc, char** argv)
 {
@@ -36,34 +140,47 @@ int main(int argc, char** argv)
 
     const char* pid_argument = nullptr;
     const char* cmd_argument = nullptr;
+    const char* output_path = "/tmp/profile.json";
+    const char* event_name = nullptr;
+    int period = 100000;
+    bool all_processes = false;
     bool enable = false;
     bool disable = false;
 
     args_parser.add_option(pid_argument, "Target PID", nullptr, 'p', "PID");
+    args_parser.add_option(all_processes, "Profile all processes", nullptr, 'a');
+    args_parser.add_option(output_path, "Output file for -a", nullptr, 'o', "path");
     args_parser.add_option(enable, "Enable", nullptr, 'e');
     args_parser.add_option(disable, "Disable", nullptr, 'd');
     args_parser.add_option(cmd_argument, "Command", nullptr, 'c', "command");
+    args_parser.add_option(event_name, "Sample on a performance counter instead of the timer", "event", 'E', "cycles|instructions|cache-misses|branch-misses");
+    args_parser.add_option(period, "Number of events between samples with -E", "period", 'P', "count");
 
     args_parser.parse(argc, argv);
 
-    if (!pid_argument && !cmd_argument) {
+    if (!pid_argument && !cmd_argument && !all_processes) {
         args_parser.print_usage(stdout, argv[0]);
         return 0;
     }
 
-    if (pid_argument) {
+    if (all_processes && !enable && !disable)
+        return profile_all_processes(output_path);
+
+    if (pid_argument || all_processes) {
         if (!(enable ^ disable)) {
             fprintf(stderr, "-p <PID> requires -e xor -d.\n");
             return 1;
         }
 
-        pid_t pid = atoi(pid_argument);
+        pid_t pid = all_processes ? -1 : atoi(pid_argument);
 
         if (enable) {
             if (profiling_enable(pid) < 0) {
                 perror("profiling_enable");
                 return 1;
             }
+            if (event_name && !enable_counter_sampling(pid, event_name, period))
+                return 1;
             return 0;
         }
 
@@ -71,6 +188,8 @@ int main(int argc, char** argv)
             perror("profiling_disable");
             return 1;
         }
+        if (event_name)
+            perf_counters_disable(pid);
 
         return 0;
     }
@@ -85,6 +204,8 @@ int main(int argc, char** argv)
 
     dbg() << "Enabling profiling for PID " << getpid();
     profiling_enable(getpid());
+    if (event_name && !enable_counter_sampling(getpid(), event_name, period))
+        return 1;
     if (execvp(cmd_argv[0], const_cast<char**>(cmd_argv.data())) < 0) {
         perror("execv");
         return 1;
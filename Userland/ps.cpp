@@ -50,6 +50,11 @@ int main(int argc, char** argv)
         return 1;
     }
 
+    if (unveil("/proc/all.bin", "r") < 0) {
+        perror("unveil");
+        return 1;
+    }
+
     if (unveil("/etc/passwd", "r") < 0) {
         perror("unveil");
         return 1;
@@ -25,9 +25,15 @@
  */
 
 #include <AK/Assertions.h>
+#include <AK/JsonArray.h>
+#include <AK/JsonObject.h>
+#include <AK/JsonValue.h>
 #include <AK/LogStream.h>
+#include <AK/QuickSort.h>
+#include <AK/String.h>
 #include <AK/Types.h>
 #include <Kernel/Syscall.h>
+#include <LibCore/File.h>
 #include <LibC/sys/arch/i386/regs.h>
 #include <signal.h>
 #include <stdio.h>
@@ -39,11 +45,126 @@
 
 static int usage()
 {
-    printf("usage: strace [-p pid] [command...]\n");
+    printf("usage: strace [-c] [-p pid] [command...]\n");
     return 1;
 }
 
 static int g_pid = -1;
+static volatile bool g_summary_done;
+
+static bool set_syscall_accounting(pid_t pid, bool enabled)
+{
+    auto file = Core::File::construct(String::format("/proc/%d/syscalls", pid));
+    if (!file->open(Core::IODevice::WriteOnly)) {
+        fprintf(stderr, "Error: %s\n", file->error_string());
+        return false;
+    }
+    file->write(enabled ? "1" : "0");
+    return true;
+}
+
+static void print_summary(pid_t pid)
+{
+    auto file = Core::File::construct(String::format("/proc/%d/syscalls", pid));
+    if (!file->open(Core::IODevice::ReadOnly)) {
+        fprintf(stderr, "Error: %s\n", file->error_string());
+        return;
+    }
+    auto json = JsonValue::from_string(file->read_all());
+    if (!json.is_object())
+        return;
+
+    Vector<JsonObject> entries;
+    u64 total_ns = 0;
+    json.as_object().get("syscalls").as_array().for_each([&](auto& value) {
+        entries.append(value.as_object());
+        total_ns += value.as_object().get("total_ns").template to_number<u64>();
+    });
+    quick_sort(entries.begin(), entries.end(), [](auto& a, auto& b) {
+        return a.get("total_ns").template to_number<u64>() > b.get("total_ns").template to_number<u64>();
+    });
+
+    fprintf(stderr, "%% time     seconds  usecs/call    max usecs     calls    errors syscall\n");
+    fprintf(stderr, "------ ----------- ----------- ------------ --------- --------- ----------------\n");
+    u32 total_calls = 0;
+    u32 total_errors = 0;
+    for (auto& entry : entries) {
+        u64 entry_ns = entry.get("total_ns").to_number<u64>();
+        u32 calls = entry.get("count").to_u32();
+        u32 errors = 0;
+        entry.get("errors").as_object().for_each_member([&](auto&, auto& value) { errors += value.to_u32(); });
+        total_calls += calls;
+        total_errors += errors;
+        fprintf(stderr, "%6.2f %11.6f %11llu %12llu %9u %9u %s\n",
+            total_ns ? (double)entry_ns * 100 / total_ns : 0.0,
+            (double)entry_ns / 1'000'000'000,
+            entry_ns / 1000 / (calls ? calls : 1),
+            entry.get("max_ns").to_number<u64>() / 1000,
+            calls,
+            errors,
+            entry.get("name").to_string().characters());
+    }
+    fprintf(stderr, "------ ----------- ----------- ------------ --------- --------- ----------------\n");
+    fprintf(stderr, "100.00 %11.6f %11s %12s %9u %9u total\n", (double)total_ns / 1'000'000'000, "", "", total_calls, total_errors);
+
+    fprintf(stderr, "\nLatency histograms (calls taking less than the given time) and errors:\n");
+    for (auto& entry : entries) {
+        StringBuilder builder;
+        builder.appendf("%-16s", entry.get("name").to_string().characters());
+        auto& histogram = entry.get("latency_histogram").as_array();
+        for (int i = 0; i < histogram.size(); ++i) {
+            u32 count = histogram.at(i).to_u32();
+            if (!count)
+                continue;
+            if (i == histogram.size() - 1)
+                builder.appendf(" >=%uus:%u", 1u << (i - 1), count);
+            else
+                builder.appendf(" <%uus:%u", 1u << i, count);
+        }
+        entry.get("errors").as_object().for_each_member([&](auto& key, auto& value) {
+            bool ok;
+            int error = key.to_int(ok);
+            builder.appendf(" %s:%u", ok ? strerror(error) : key.characters(), value.to_u32());
+        });
+        fprintf(stderr, "%s\n", builder.to_string().characters());
+    }
+}
+
+static int summarize(int argc, char** argv)
+{
+    signal(SIGINT, [](int) { g_summary_done = true; });
+    signal(SIGCHLD, [](int) { g_summary_done = true; });
+
+    pid_t pid;
+    if (argc == 2 && !strcmp(argv[0], "-p")) {
+        pid = atoi(argv[1]);
+        if (!set_syscall_accounting(pid, true))
+            return 1;
+        fprintf(stderr, "Counting syscalls of PID %d, press ^C to stop.\n", pid);
+    } else if (argc > 0) {
+        pid = fork();
+        if (!pid) {
+            if (!set_syscall_accounting(getpid(), true))
+                exit(1);
+            execvp(argv[0], argv);
+            perror("execvp");
+            exit(1);
+        }
+    } else {
+        return usage();
+    }
+
+    // An exited child stays around as a zombie until we wait for it, so its numbers can still be read.
+    while (!g_summary_done)
+        usleep(100000);
+
+    print_summary(pid);
+    if (argc == 2 && !strcmp(argv[0], "-p"))
+        set_syscall_accounting(pid, false);
+    else
+        waitpid(pid, nullptr, 0);
+    return 0;
+}
 
 static void handle_sigint(int)
 {
@@ -60,6 +181,9 @@ int main(int argc, char** argv)
     if (argc == 1)
         return usage();
 
+    if (!strcmp(argv[1], "-c"))
+        return summarize(argc - 2, argv + 2);
+
     bool spawned_new_process = false;
 
     if (!strcmp(argv[1], "-p")) {
@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) 2018-2020, Andreas Kling <kling@serenityos.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/StringView.h>
+#include <AK/Vector.h>
+#include <LibCore/ArgsParser.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Both variants of each function are exported from LibC under these names; memcpy() and
+// friends use the SSE2 ones if the CPU has SSE2.
+extern "C" {
+void* __memcpy_generic(void*, const void*, size_t);
+void* __memcpy_sse2(void*, const void*, size_t);
+void* __memmove_generic(void*, const void*, size_t);
+void* __memmove_sse2(void*, const void*, size_t);
+void* __memset_generic(void*, int, size_t);
+void* __memset_sse2(void*, int, size_t);
+void* __memchr_generic(const void*, int, size_t);
+void* __memchr_sse2(const void*, int, size_t);
+size_t __strlen_generic(const char*);
+size_t __strlen_sse2(const char*);
+int __strcmp_generic(const char*, const char*);
+int __strcmp_sse2(const char*, const char*);
+}
+
+static constexpr size_t sizes[] = { 8, 32, 128, 512, 4 * KB, 64 * KB, 1 * MB };
+static constexpr size_t alignments[] = { 0, 1, 7, 15 };
+static constexpr size_t max_size = 1 * MB;
+static constexpr size_t bytes_per_run = 64 * MB;
+
+static u8* s_source;
+static u8* s_destination;
+
+// Every function gets a source and a destination that start `alignment` bytes past a 64-byte boundary,
+// and are `size` bytes long. The strings are made of 'a's, so the whole length has to be scanned.
+using Variant = void (*)(u8* destination, const u8* source, size_t size);
+
+struct Benchmark {
+    const char* name;
+    Variant generic;
+    Variant sse2;
+};
+
+static volatile size_t s_sink;
+
+static const Benchmark benchmarks[] = {
+    { "memcpy", [](u8* d, const u8* s, size_t n) { __memcpy_generic(d, s, n); }, [](u8* d, const u8* s, size_t n) { __memcpy_sse2(d, s, n); } },
+    { "memmove", [](u8* d, const u8* s, size_t n) { __memmove_generic(d + 1, d, n - 1); (void)s; }, [](u8* d, const u8* s, size_t n) { __memmove_sse2(d + 1, d, n - 1); (void)s; } },
+    { "memset", [](u8* d, const u8*, size_t n) { __memset_generic(d, 0x55, n); }, [](u8* d, const u8*, size_t n) { __memset_sse2(d, 0x55, n); } },
+    { "memchr", [](u8*, const u8* s, size_t n) { s_sink = (FlatPtr)__memchr_generic(s, 'b', n); }, [](u8*, const u8* s, size_t n) { s_sink = (FlatPtr)__memchr_sse2(s, 'b', n); } },
+    { "strlen", [](u8*, const u8* s, size_t) { s_sink = __strlen_generic((const char*)s); }, [](u8*, const u8* s, size_t) { s_sink = __strlen_sse2((const char*)s); } },
+    { "strcmp", [](u8* d, const u8* s, size_t) { s_sink = __strcmp_generic((const char*)d, (const char*)s); }, [](u8* d, const u8* s, size_t) { s_sink = __strcmp_sse2((const char*)d, (const char*)s); } },
+};
+
+static u64 now_ns()
+{
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (u64)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+static u64 bytes_per_second(Variant variant, size_t size, size_t alignment)
+{
+    u8* destination = s_destination + alignment;
+    u8* source = s_source + alignment;
+    memset(source, 'a', size);
+    memset(destination, 'a', size);
+    source[size - 1] = 0;
+    destination[size - 1] = 0;
+
+    size_t iterations = max(bytes_per_run / size, (size_t)1000);
+    u64 start = now_ns();
+    for (size_t i = 0; i < iterations; ++i)
+        variant(destination, source, size);
+    u64 elapsed = max(now_ns() - start, (u64)1);
+    return (u64)size * iterations * 1000000000 / elapsed;
+}
+
+int main(int argc, char** argv)
+{
+    Vector<const char*> function_names;
+
+    Core::ArgsParser args_parser;
+    args_parser.add_positional_argument(function_names, "Functions to benchmark (all of them by default)", "functions", Core::ArgsParser::Required::No);
+    args_parser.parse(argc, argv);
+
+    // Two extra cache lines: one to align the start, one so that every alignment still fits the biggest size.
+    auto align = [](void* ptr) { return (u8*)(((FlatPtr)ptr + 63) & ~(FlatPtr)63); };
+    s_source = align(malloc(max_size + 128));
+    s_destination = align(malloc(max_size + 128));
+
+    printf("function     size  align  generic MB/s     sse2 MB/s  speedup\n");
+    for (auto& benchmark : benchmarks) {
+        bool selected = function_names.is_empty();
+        for (auto* name : function_names)
+            selected |= StringView(name) == benchmark.name;
+        if (!selected)
+            continue;
+        for (size_t size : sizes) {
+            for (size_t alignment : alignments) {
+                u64 generic = bytes_per_second(benchmark.generic, size, alignment);
+                u64 sse2 = bytes_per_second(benchmark.sse2, size, alignment);
+                printf("%-8s %8zu  %5zu  %12llu  %12llu  %4llu.%02llux\n", benchmark.name, size, alignment, generic / MB, sse2 / MB, sse2 / generic, sse2 * 100 / generic % 100);
+            }
+        }
+    }
+    return 0;
+}
@@ -36,6 +36,9 @@
 #if !defined __ENUMERATE_SYSCALL
 #    define __ENUMERATE_SYSCALL(x) SC_##x,
 #endif
+#if !defined __ENUMERATE_UNLOCKED_SYSCALL
+#    define __ENUMERATE_UNLOCKED_SYSCALL(x) SC_##x,
+#endif
 #if !defined __ENUMERATE_REMOVED_SYSCALL
 #    define __ENUMERATE_REMOVED_SYSCALL(x)
 #endif
@@ -86,6 +86,7 @@ struct Traits<PidAndTid> : public GenericTraits<PidAndTid> {
 
 struct Snapshot {
     HashMap<PidAndTid, ThreadData> map;
+    Vector<Core::ProcessorStatistics> processors;
     u32 sum_times_scheduled { 0 };
 };
 
@@ -93,7 +94,7 @@ static Snapshot get_snapshot()
 {
     Snapshot snapshot;
 
-    auto all_processes = Core::ProcessStatisticsReader::get_all();
+    auto all_processes = Core::ProcessStatisticsReader::get_all(&snapshot.processors);
 
     for (auto& it : all_processes) {
         auto& stats = it.value;
@@ -143,6 +144,11 @@ int main(int, char**)
         return 1;
     }
 
+    if (unveil("/proc/all.bin", "r") < 0) {
+        perror("unveil");
+        return 1;
+    }
+
     if (unveil("/etc/passwd", "r") < 0) {
         perror("unveil");
         return 1;
@@ -158,6 +164,16 @@ int main(int, char**)
         auto sum_diff = current.sum_times_scheduled - prev.sum_times_scheduled;
 
         printf("\033[3J\033[H\033[2J");
+        for (size_t i = 0; i < current.processors.size(); ++i) {
+            auto& processor = current.processors[i];
+            if (!processor.online || i >= prev.processors.size())
+                continue;
+            u32 busy_diff = processor.busy_ticks - prev.processors[i].busy_ticks;
+            u32 total_diff = busy_diff + (processor.idle_ticks - prev.processors[i].idle_ticks);
+            u32 busy_permille = total_diff ? (busy_diff * 1000) / total_diff : 0;
+            printf("CPU%u: %3u.%1u%%  ", processor.id, busy_permille / 10, busy_permille % 10);
+        }
+        printf("\n");
         printf("\033[47;30m%6s %3s %3s  %-8s  %-10s  %6s  %6s  %4s  %s\033[K\033[0m\n",
             "PID",
             "TID",
@@ -24,6 +24,8 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <AK/ByteBuffer.h>
+#include <LibCompress/Inflate.h>
 #include <LibCore/ArgsParser.h>
 #include <LibCore/File.h>
 #include <string.h>
@@ -68,15 +70,30 @@ bool find_next_central_directory(off_t file_size, Core::File& file, off_t curren
 
 bool unpack_file_for_central_directory_index(off_t central_directory_index, Core::File& file)
 {
+    enum CompressionMethod {
+        Stored = 0,
+        Deflated = 8,
+    };
+
+    // The sizes are taken from the central directory, since the local file header leaves them zeroed
+    // when the archiver streamed the file out and wrote them into a data descriptor behind the contents.
     u8 buffer[4];
-    if (!seek_and_read(buffer, file, central_directory_index + 42, 4))
+    if (!seek_and_read(buffer, file, central_directory_index + 10, 2))
         return false;
-    off_t local_file_header_index = buffer[3] << 24 | buffer[2] << 16 | buffer[1] << 8 | buffer[0];
+    u16 compression_method = buffer[1] << 8 | buffer[0];
 
-    if (!seek_and_read(buffer, file, local_file_header_index + 18, 4))
+    if (!seek_and_read(buffer, file, central_directory_index + 20, 4))
         return false;
     off_t compressed_file_size = buffer[3] << 24 | buffer[2] << 16 | buffer[1] << 8 | buffer[0];
 
+    if (!seek_and_read(buffer, file, central_directory_index + 24, 4))
+        return false;
+    off_t uncompressed_file_size = buffer[3] << 24 | buffer[2] << 16 | buffer[1] << 8 | buffer[0];
+
+    if (!seek_and_read(buffer, file, central_directory_index + 42, 4))
+        return false;
+    off_t local_file_header_index = buffer[3] << 24 | buffer[2] << 16 | buffer[1] << 8 | buffer[0];
+
     if (!seek_and_read(buffer, file, local_file_header_index + 26, 2))
         return false;
     off_t file_name_length = buffer[1] << 8 | buffer[0];
@@ -85,12 +102,16 @@ bool unpack_file_for_central_directory_index(off_t central_directory_index, Core
         return false;
     off_t extra_field_length = buffer[1] << 8 | buffer[0];
 
-    if (!seek_and_read(buffer, file, local_file_header_index + 30, file_name_length))
-        return false;
     char file_name[file_name_length + 1];
-    memcpy(file_name, buffer, file_name_length);
+    if (!seek_and_read((u8*)file_name, file, local_file_header_index + 30, file_name_length))
+        return false;
     file_name[file_name_length] = '\0';
 
+    if (compression_method != CompressionMethod::Stored && compression_method != CompressionMethod::Deflated) {
+        fprintf(stderr, "Can't extract %s: unsupported compression method %u\n", file_name, compression_method);
+        return false;
+    }
+
     auto new_file = Core::File::construct(String { file_name });
     if (!new_file->open(Core::IODevice::WriteOnly)) {
         fprintf(stderr, "Can't write file %s: %s\n", file_name, file.error_string());
@@ -98,12 +119,21 @@ bool unpack_file_for_central_directory_index(off_t central_directory_index, Core
     }
 
     printf(" extracting: %s\n", file_name);
-    u8 raw_file_contents[compressed_file_size];
-    if (!seek_and_read(raw_file_contents, file, local_file_header_index + 30 + file_name_length + extra_field_length, compressed_file_size))
+    auto raw_file_contents = ByteBuffer::create_uninitialized(compressed_file_size);
+    if (!seek_and_read(raw_file_contents.data(), file, local_file_header_index + 30 + file_name_length + extra_field_length, compressed_file_size))
         return false;
 
-    // FIXME: Try to uncompress data here. We're just ignoring it as no decompression methods are implemented yet.
-    if (!new_file->write(raw_file_contents, compressed_file_size)) {
+    auto file_contents = raw_file_contents;
+    if (compression_method == CompressionMethod::Deflated) {
+        file_contents = ByteBuffer::create_uninitialized(uncompressed_file_size);
+        Compress::Inflater inflater(raw_file_contents.data(), raw_file_contents.size());
+        if (inflater.read(file_contents.data(), file_contents.size()) != file_contents.size() || inflater.has_error()) {
+            fprintf(stderr, "Can't decompress %s: corrupt data\n", file_name);
+            return false;
+        }
+    }
+
+    if (!new_file->write(file_contents.data(), file_contents.size())) {
         fprintf(stderr, "Can't write file contents in %s: %s\n", file_name, new_file->error_string());
         return false;
     }